@@ -0,0 +1,80 @@
+/// @brief benchmarks for basis function evaluation and element transformations
+/// @author Gianni Absillis (gabsill@ncsu.edu)
+#include "bench_common.hpp"
+#include "iceicle/basis/lagrange.hpp"
+#include "iceicle/basis/legendre.hpp"
+#include <array>
+
+using namespace iceicle;
+using namespace iceicle::bench;
+
+/// @brief a point inside both the reference hypercube and simplex
+template<int ndim>
+static auto interior_point() -> std::array<T, ndim> {
+    std::array<T, ndim> xi;
+    for(int idim = 0; idim < ndim; ++idim) xi[idim] = 0.1 + 0.05 * idim;
+    return xi;
+}
+
+template<class BasisT, int ndim>
+static void BM_eval_basis(benchmark::State& state) {
+    BasisT basis{};
+    std::array<T, ndim> xi = interior_point<ndim>();
+    std::vector<T> bi(basis.nbasis());
+    for(auto _ : state) {
+        basis.evalBasis(xi.data(), bi.data());
+        benchmark::DoNotOptimize(bi.data());
+        benchmark::ClobberMemory();
+    }
+    state.counters["dofs/s"] = per_second(basis.nbasis());
+}
+
+template<class BasisT, int ndim>
+static void BM_eval_grad_basis(benchmark::State& state) {
+    BasisT basis{};
+    std::array<T, ndim> xi = interior_point<ndim>();
+    std::vector<T> dbi(basis.nbasis() * ndim);
+    for(auto _ : state) {
+        basis.evalGradBasis(xi.data(), dbi.data());
+        benchmark::DoNotOptimize(dbi.data());
+        benchmark::ClobberMemory();
+    }
+    state.counters["dofs/s"] = per_second(basis.nbasis());
+}
+
+#define ICEICLE_BENCH_BASIS(BASIS, NDIM, PN) \
+    BENCHMARK(BM_eval_basis<BASIS<T, IDX, NDIM, PN>, NDIM>)->Name("eval_basis/" #BASIS "/ndim:" #NDIM "/p:" #PN); \
+    BENCHMARK(BM_eval_grad_basis<BASIS<T, IDX, NDIM, PN>, NDIM>)->Name("eval_grad_basis/" #BASIS "/ndim:" #NDIM "/p:" #PN);
+
+#define ICEICLE_BENCH_BASIS_ORDERS(BASIS, NDIM) \
+    ICEICLE_BENCH_BASIS(BASIS, NDIM, 1) \
+    ICEICLE_BENCH_BASIS(BASIS, NDIM, 2) \
+    ICEICLE_BENCH_BASIS(BASIS, NDIM, 3) \
+    ICEICLE_BENCH_BASIS(BASIS, NDIM, 4)
+
+ICEICLE_BENCH_BASIS_ORDERS(HypercubeLagrangeBasis, 2)
+ICEICLE_BENCH_BASIS_ORDERS(HypercubeLagrangeBasis, 3)
+ICEICLE_BENCH_BASIS_ORDERS(SimplexLagrangeBasis, 2)
+ICEICLE_BENCH_BASIS_ORDERS(SimplexLagrangeBasis, 3)
+ICEICLE_BENCH_BASIS_ORDERS(HypercubeLegendreBasis, 2)
+ICEICLE_BENCH_BASIS_ORDERS(HypercubeLegendreBasis, 3)
+
+/// @brief the transformation jacobian at every quadrature point of a mesh
+/// range(0): the number of elements in each direction, range(1): the geometric order
+template<int ndim>
+static void BM_transformation_jacobian(benchmark::State& state) {
+    dg_problem<ndim, 2, burgers_physics> problem{(IDX) state.range(0), (int) state.range(1)};
+    std::size_t nqp = 0;
+    for(const auto& el : problem.fespace.elements) nqp += el.nQP();
+    for(auto _ : state) {
+        for(const auto& el : problem.fespace.elements) {
+            for(int iqp = 0; iqp < el.nQP(); ++iqp) {
+                auto J = el.jacobian(el.quadrule->getPoint(iqp).abscisse);
+                benchmark::DoNotOptimize(J);
+            }
+        }
+    }
+    state.counters["qp/s"] = per_second(nqp);
+}
+BENCHMARK(BM_transformation_jacobian<2>)->ArgsProduct({{16, 64}, {1, 2, 3}});
+BENCHMARK(BM_transformation_jacobian<3>)->ArgsProduct({{4, 16}, {1, 2}});
@@ -0,0 +1,177 @@
+/// @brief shared problem setup for the kernel benchmarks
+/// @author Gianni Absillis (gabsill@ncsu.edu)
+#pragma once
+#include "iceicle/build_config.hpp"
+#include "iceicle/disc/burgers.hpp"
+#include "iceicle/disc/conservation_law.hpp"
+#include "iceicle/disc/kernel_work.hpp"
+#include "iceicle/disc/navier_stokes.hpp"
+#include "iceicle/disc/projection.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fe_function/layout_right.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/linear_form_solver.hpp"
+#include "iceicle/mesh/mesh.hpp"
+#include "iceicle/mesh/mesh_cache.hpp"
+#include "iceicle/tmp_utils.hpp"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <numbers>
+#include <utility>
+#include <vector>
+
+namespace iceicle::bench {
+
+    using T = build_config::T;
+    using IDX = build_config::IDX;
+
+    /// @brief the benchmark counter of the entities (i.e degrees of freedom) processed per second
+    /// @param n the number of entities processed by one iteration
+    inline auto per_second(double n) -> benchmark::Counter {
+        return benchmark::Counter(n, benchmark::Counter::kIsIterationInvariantRate);
+    }
+
+    /// @brief set the achieved GFLOP/s and GB/s counters from the analytic work of one iteration
+    inline void roofline_counters(benchmark::State& state, kernel_work work) {
+        state.counters["GFLOP/s"] = per_second(work.flops * 1e-9);
+        state.counters["GB/s"] = per_second(work.bytes * 1e-9);
+    }
+
+    /// @brief viscous Burgers equation with advection and nonlinear advection in every direction
+    template<int ndim>
+    struct burgers_physics {
+        BurgersCoefficients<T, ndim> coeffs{};
+
+        burgers_physics() {
+            coeffs.mu = 0.01;
+            for(int idim = 0; idim < ndim; ++idim) {
+                coeffs.a[idim] = 0.5;
+                coeffs.b[idim] = 1.0;
+            }
+        }
+
+        auto make_disc() {
+            ConservationLawDDG disc{BurgersFlux{coeffs}, BurgersUpwind{coeffs}, BurgersDiffusionFlux{coeffs}};
+            disc.field_names = std::vector<std::string>{"u"};
+            return disc;
+        }
+
+        /// @brief a smooth field so the nonlinear terms are active
+        template<int neq>
+        static void state(const T* x, T* u) {
+            u[0] = 1.0;
+            for(int idim = 0; idim < ndim; ++idim) u[0] += 0.5 * std::sin(2 * std::numbers::pi * x[idim]);
+        }
+    };
+
+    /// @brief compressible Navier-Stokes equations with constant viscosity
+    template<int ndim>
+    struct ns_physics {
+        navier_stokes::Physics<T, ndim, navier_stokes::CaloricallyPerfectEoS<T, ndim>> physics{
+            navier_stokes::ReferenceParameters<T>{},
+            navier_stokes::CaloricallyPerfectEoS<T, ndim>{},
+            navier_stokes::constant_viscosity<T>{0.01}
+        };
+
+        auto make_disc() {
+            ConservationLawDDG disc{navier_stokes::Flux{physics, std::true_type{}},
+                navier_stokes::VanLeer{physics}, navier_stokes::DiffusionFlux{physics, std::true_type{}}};
+            disc.field_names = std::vector<std::string>{"rho"};
+            for(int idim = 0; idim < ndim; ++idim) disc.field_names.push_back("rhou" + std::to_string(idim));
+            disc.field_names.push_back("rhoe");
+            return disc;
+        }
+
+        /// @brief a perturbed uniform flow
+        template<int neq>
+        static void state(const T* x, T* u) {
+            T pert = 0.0;
+            for(int idim = 0; idim < ndim; ++idim) pert += 0.05 * std::sin(2 * std::numbers::pi * x[idim]);
+            u[0] = 1.0 + pert;
+            for(int idim = 0; idim < ndim; ++idim) u[1 + idim] = 0.3 * (1.0 + pert);
+            u[ndim + 1] = 2.5 + pert;
+        }
+    };
+
+    /**
+     * @brief the finite element space on the cached uniform periodic mesh of [0, 1]^ndim
+     * built once per process for each mesh size and order (like the SharedFESpaceTest fixtures),
+     * so repeated runs of a benchmark only set up the solution
+     *
+     * The spaces are shared by every benchmark with the same configuration and must not be modified
+     *
+     * @tparam ndim the number of dimensions
+     * @tparam Pn the polynomial order of the basis
+     * @param nelem the number of elements in each direction
+     * @param geo_order the polynomial order of the mesh
+     */
+    template<int ndim, int Pn>
+    auto shared_fespace(IDX nelem, int geo_order) -> FESpace<T, IDX, ndim>& {
+        static std::map<std::pair<IDX, int>, std::unique_ptr<FESpace<T, IDX, ndim>>> spaces{};
+        std::unique_ptr<FESpace<T, IDX, ndim>>& fespace = spaces[{nelem, geo_order}];
+        if(!fespace) {
+            AbstractMesh<T, IDX, ndim>& mesh = MeshCache<T, IDX, ndim>::instance()
+                .get(uniform_mesh_desc<T, IDX, ndim>::periodic_box(nelem, geo_order));
+            fespace = std::make_unique<FESpace<T, IDX, ndim>>(&mesh, FESPACE_ENUMS::LAGRANGE,
+                    FESPACE_ENUMS::GAUSS_LEGENDRE, tmp::compile_int<Pn>{});
+        }
+        return *fespace;
+    }
+
+    /**
+     * @brief a discontinuous Galerkin problem on a uniform periodic mesh of [0, 1]^ndim
+     * with the solution and residual storage
+     *
+     * @tparam ndim the number of dimensions
+     * @tparam Pn the polynomial order of the basis
+     * @tparam PhysicsT the physics (burgers_physics or ns_physics)
+     */
+    template<int ndim, int Pn, template<int> class PhysicsT>
+    struct dg_problem {
+        /// @brief the shared finite element space and its mesh from the MeshCache 
+        /// (not modified by the benchmarks, see shared_fespace)
+        FESpace<T, IDX, ndim>& fespace;
+        AbstractMesh<T, IDX, ndim>* mesh;
+        PhysicsT<ndim> physics{};
+        using disc_type = decltype(std::declval<PhysicsT<ndim>&>().make_disc());
+        disc_type disc;
+        static constexpr int neq = disc_type::nv_comp;
+        std::vector<T> u_data;
+        std::vector<T> res_data;
+
+        /// @param nelem the number of elements in each direction
+        /// @param geo_order the polynomial order of the mesh
+        dg_problem(IDX nelem, int geo_order = 1)
+        : fespace{shared_fespace<ndim, Pn>(nelem, geo_order)}, mesh{fespace.meshptr},
+          disc{physics.make_disc()}
+        {
+            fe_layout_right layout{fespace.dg_map, tmp::to_size<neq>{}};
+            u_data.resize(layout.size());
+            res_data.resize(layout.size());
+            fespan u_span{u_data.data(), layout};
+
+            // L2 projection of the state
+            Projection<T, IDX, ndim, neq> projection{ProjectionFunction<T, ndim, neq>{
+                [](const T* x, T* out){ PhysicsT<ndim>::template state<neq>(x, out); }}};
+            solvers::LinearFormSolver projection_solver{fespace, projection};
+            projection_solver.solve(u_span);
+        }
+
+        dg_problem(const dg_problem&) = delete;
+        dg_problem& operator=(const dg_problem&) = delete;
+
+        /// @brief the layout of the solution and residual
+        auto layout() const { return fe_layout_right{fespace.dg_map, tmp::to_size<neq>{}}; }
+
+        /// @brief view of the solution
+        auto u() { return fespan{u_data.data(), layout()}; }
+
+        /// @brief view of the residual
+        auto res() { return fespan{res_data.data(), layout()}; }
+
+        /// @brief the number of degrees of freedom (including vector components)
+        auto ndof() const -> double { return u_data.size(); }
+    };
+}
@@ -0,0 +1,27 @@
+/// @brief entry point for the kernel benchmarks
+/// initializes MPI and PETSc around the google benchmark runner
+/// @author Gianni Absillis (gabsill@ncsu.edu)
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include <benchmark/benchmark.h>
+#ifdef ICEICLE_USE_PETSC
+#include <petscsys.h>
+#endif
+
+int main(int argc, char** argv) {
+    iceicle::mpi::init_funneled(&argc, &argv);
+#ifdef ICEICLE_USE_PETSC
+    PetscInitialize(&argc, &argv, nullptr, nullptr);
+#endif
+    benchmark::Initialize(&argc, argv);
+    if(!benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        benchmark::RunSpecifiedBenchmarks();
+    }
+    benchmark::Shutdown();
+#ifdef ICEICLE_USE_PETSC
+    PetscFinalize();
+#endif
+#ifdef ICEICLE_USE_MPI
+    MPI_Finalize();
+#endif
+    return 0;
+}
@@ -0,0 +1,156 @@
+/// @brief benchmarks for the discretization integrals, residual and jacobian assembly
+/// @author Gianni Absillis (gabsill@ncsu.edu)
+#include "bench_common.hpp"
+#include "iceicle/form_residual.hpp"
+#include "iceicle/residual_workspace.hpp"
+#ifdef ICEICLE_USE_PETSC
+#include "iceicle/form_petsc_jacobian.hpp"
+#include <petscmat.h>
+#endif
+
+using namespace iceicle;
+using namespace iceicle::bench;
+
+/// @brief the domain integral of every element
+/// range(0): the number of elements in each direction
+template<int ndim, int Pn, template<int> class PhysicsT>
+static void BM_domain_integral(benchmark::State& state) {
+    dg_problem<ndim, Pn, PhysicsT> problem{(IDX) state.range(0)};
+    auto u = problem.u();
+    auto res = problem.res();
+    std::size_t max_size = problem.fespace.dg_map.max_el_size_reqirement(problem.neq);
+    std::vector<T> u_el_data(max_size), res_el_data(max_size);
+    for(auto _ : state) {
+        for(const auto& el : problem.fespace.elements) {
+            dofspan u_el{u_el_data.data(), u.create_element_layout(el.elidx)};
+            dofspan res_el{res_el_data.data(), res.create_element_layout(el.elidx)};
+            extract_elspan(el.elidx, u, u_el);
+            res_el = 0;
+            problem.disc.domain_integral(el, u_el, res_el);
+            benchmark::DoNotOptimize(res_el_data.data());
+        }
+    }
+    state.counters["dofs/s"] = per_second(problem.ndof());
+    roofline_counters(state, domain_work<T, ndim>(problem.disc, problem.fespace.elements));
+}
+
+/// @brief the trace integral of every interior trace
+/// range(0): the number of elements in each direction
+template<int ndim, int Pn, template<int> class PhysicsT>
+static void BM_trace_integral(benchmark::State& state) {
+    dg_problem<ndim, Pn, PhysicsT> problem{(IDX) state.range(0)};
+    auto u = problem.u();
+    auto res = problem.res();
+    std::size_t max_size = problem.fespace.dg_map.max_el_size_reqirement(problem.neq);
+    std::vector<T> uL_data(max_size), uR_data(max_size), resL_data(max_size), resR_data(max_size);
+    for(auto _ : state) {
+        for(const auto& trace : problem.fespace.get_interior_traces()) {
+            dofspan uL{uL_data.data(), u.create_element_layout(trace.elL.elidx)};
+            dofspan uR{uR_data.data(), u.create_element_layout(trace.elR.elidx)};
+            dofspan resL{resL_data.data(), res.create_element_layout(trace.elL.elidx)};
+            dofspan resR{resR_data.data(), res.create_element_layout(trace.elR.elidx)};
+            extract_elspan(trace.elL.elidx, u, uL);
+            extract_elspan(trace.elR.elidx, u, uR);
+            resL = 0;
+            resR = 0;
+            problem.disc.trace_integral(trace, problem.fespace.meshptr->coord, uL, uR, resL, resR);
+            benchmark::DoNotOptimize(resL_data.data());
+            benchmark::DoNotOptimize(resR_data.data());
+        }
+    }
+    state.counters["dofs/s"] = per_second(problem.ndof());
+    roofline_counters(state, trace_work<T, ndim>(problem.disc, problem.fespace.get_interior_traces(), false));
+}
+
+/// @brief the full residual with a persistent workspace
+/// range(0): the number of elements in each direction
+/// @tparam element_centric use the element-centric traversal (see ResidualWorkspace::enable_element_centric)
+template<int ndim, int Pn, template<int> class PhysicsT, bool element_centric = false>
+static void BM_form_residual(benchmark::State& state) {
+    dg_problem<ndim, Pn, PhysicsT> problem{(IDX) state.range(0)};
+    solvers::ResidualWorkspace<T, IDX> workspace{problem.fespace, problem.neq};
+    if(element_centric) workspace.enable_element_centric(problem.fespace, problem.neq);
+    for(auto _ : state) {
+        solvers::form_residual(problem.fespace, problem.disc, problem.u(), problem.res(), workspace);
+        benchmark::DoNotOptimize(problem.res_data.data());
+    }
+    state.counters["dofs/s"] = per_second(problem.ndof());
+    roofline_counters(state, trace_work<T, ndim>(problem.disc, problem.fespace.get_boundary_traces(), true)
+            + trace_work<T, ndim>(problem.disc, problem.fespace.get_interior_traces(), false)
+            + domain_work<T, ndim>(problem.disc, problem.fespace.elements));
+}
+
+/// @brief gather and scatter the element local data of every element
+/// range(0): the number of elements in each direction
+template<int ndim, int Pn, template<int> class PhysicsT>
+static void BM_extract_scatter_elspan(benchmark::State& state) {
+    dg_problem<ndim, Pn, PhysicsT> problem{(IDX) state.range(0)};
+    auto u = problem.u();
+    auto res = problem.res();
+    std::vector<T> el_data(problem.fespace.dg_map.max_el_size_reqirement(problem.neq));
+    for(auto _ : state) {
+        for(const auto& el : problem.fespace.elements) {
+            dofspan u_el{el_data.data(), u.create_element_layout(el.elidx)};
+            extract_elspan(el.elidx, u, u_el);
+            scatter_elspan(el.elidx, 1.0, u_el, 0.0, res);
+        }
+        benchmark::DoNotOptimize(problem.res_data.data());
+    }
+    state.counters["dofs/s"] = per_second(problem.ndof());
+    kernel_work work{};
+    for(const auto& el : problem.fespace.elements) {
+        std::size_t n = el.nbasis() * problem.neq;
+        work += kernel_model::extract_elspan(n, sizeof(T)) + kernel_model::scatter_elspan(n, sizeof(T));
+    }
+    roofline_counters(state, work);
+}
+
+#ifdef ICEICLE_USE_PETSC
+/// @brief the finite difference jacobian assembled into a petsc matrix
+/// range(0): the number of elements in each direction
+template<int ndim, int Pn, template<int> class PhysicsT>
+static void BM_fd_jacobian(benchmark::State& state) {
+    dg_problem<ndim, Pn, PhysicsT> problem{(IDX) state.range(0)};
+    PetscInt local_size = problem.u_data.size();
+    Mat jac;
+    MatCreate(PETSC_COMM_WORLD, &jac);
+    MatSetSizes(jac, local_size, local_size, PETSC_DETERMINE, PETSC_DETERMINE);
+    MatSetBlockSize(jac, problem.neq);
+    MatSetFromOptions(jac);
+    solvers::preallocate_petsc_jacobian(problem.fespace, problem.neq, jac);
+    for(auto _ : state) {
+        MatZeroEntries(jac);
+        solvers::form_petsc_jacobian_fd(problem.fespace, problem.disc, problem.u(), problem.res(), jac);
+    }
+    MatDestroy(&jac);
+    state.counters["dofs/s"] = per_second(problem.ndof());
+}
+#define ICEICLE_BENCH_FD_JACOBIAN(NDIM, PN, PHYSICS, ...) \
+    BENCHMARK(BM_fd_jacobian<NDIM, PN, PHYSICS>)->Name("fd_jacobian/" #PHYSICS "/ndim:" #NDIM "/p:" #PN)->Arg(__VA_ARGS__)
+#else
+#define ICEICLE_BENCH_FD_JACOBIAN(NDIM, PN, PHYSICS, ...)
+#endif
+
+/// @brief register the assembly benchmarks for one physics, dimension, order, and mesh size
+#define ICEICLE_BENCH_ASSEMBLY(NDIM, PN, PHYSICS, NELEM) \
+    BENCHMARK(BM_domain_integral<NDIM, PN, PHYSICS>)->Name("domain_integral/" #PHYSICS "/ndim:" #NDIM "/p:" #PN)->Arg(NELEM); \
+    BENCHMARK(BM_trace_integral<NDIM, PN, PHYSICS>)->Name("trace_integral/" #PHYSICS "/ndim:" #NDIM "/p:" #PN)->Arg(NELEM); \
+    BENCHMARK(BM_form_residual<NDIM, PN, PHYSICS>)->Name("form_residual/" #PHYSICS "/ndim:" #NDIM "/p:" #PN)->Arg(NELEM); \
+    BENCHMARK(BM_form_residual<NDIM, PN, PHYSICS, true>)->Name("form_residual_element_centric/" #PHYSICS "/ndim:" #NDIM "/p:" #PN)->Arg(NELEM); \
+    BENCHMARK(BM_extract_scatter_elspan<NDIM, PN, PHYSICS>)->Name("extract_scatter_elspan/" #PHYSICS "/ndim:" #NDIM "/p:" #PN)->Arg(NELEM);
+
+ICEICLE_BENCH_ASSEMBLY(2, 1, burgers_physics, 64)
+ICEICLE_BENCH_ASSEMBLY(2, 2, burgers_physics, 32)
+ICEICLE_BENCH_ASSEMBLY(2, 3, burgers_physics, 32)
+ICEICLE_BENCH_ASSEMBLY(3, 1, burgers_physics, 16)
+ICEICLE_BENCH_ASSEMBLY(3, 2, burgers_physics, 8)
+ICEICLE_BENCH_ASSEMBLY(2, 1, ns_physics, 64)
+ICEICLE_BENCH_ASSEMBLY(2, 2, ns_physics, 32)
+ICEICLE_BENCH_ASSEMBLY(2, 3, ns_physics, 32)
+ICEICLE_BENCH_ASSEMBLY(3, 1, ns_physics, 16)
+ICEICLE_BENCH_ASSEMBLY(3, 2, ns_physics, 8)
+
+ICEICLE_BENCH_FD_JACOBIAN(2, 1, burgers_physics, 16);
+ICEICLE_BENCH_FD_JACOBIAN(2, 2, burgers_physics, 8);
+ICEICLE_BENCH_FD_JACOBIAN(2, 1, ns_physics, 8);
+ICEICLE_BENCH_FD_JACOBIAN(2, 2, ns_physics, 4);
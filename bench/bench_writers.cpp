@@ -0,0 +1,53 @@
+/// @brief benchmarks for the solution writers
+/// @author Gianni Absillis (gabsill@ncsu.edu)
+#include "bench_common.hpp"
+#include "iceicle/dat_writer.hpp"
+#include "iceicle/pvd_writer.hpp"
+#include <filesystem>
+
+using namespace iceicle;
+using namespace iceicle::bench;
+
+/// @brief the directory the benchmark output is written to (removed after each benchmark)
+static auto bench_output_directory() -> std::filesystem::path {
+    return std::filesystem::temp_directory_path() / "iceicle_bench";
+}
+
+/// @brief write the solution to vtu files
+/// range(0): the number of elements in each direction, range(1): the io::vtu_format
+template<int ndim, int Pn>
+static void BM_write_vtu(benchmark::State& state) {
+    dg_problem<ndim, Pn, ns_physics> problem{(IDX) state.range(0)};
+    auto u = problem.u();
+    io::PVDWriter<T, IDX, ndim> writer{};
+    writer.register_fespace(problem.fespace);
+    writer.register_fields(u, problem.disc.field_names);
+    writer.data_directory = bench_output_directory();
+    writer.collection_name = "bench";
+    writer.format = static_cast<io::vtu_format>(state.range(1));
+    // overwrite the same output so the file count does not grow with the iterations
+    for(auto _ : state) writer.write_vtu(0, 0.0);
+    std::filesystem::remove_all(bench_output_directory());
+    state.counters["dofs/s"] = per_second(problem.ndof());
+}
+BENCHMARK(BM_write_vtu<2, 1>)->Name("write_vtu/ndim:2/p:1")->ArgsProduct({{64},
+        {(int) io::vtu_format::ascii, (int) io::vtu_format::base64, (int) io::vtu_format::raw}});
+BENCHMARK(BM_write_vtu<2, 3>)->Name("write_vtu/ndim:2/p:3")->ArgsProduct({{32},
+        {(int) io::vtu_format::ascii, (int) io::vtu_format::base64, (int) io::vtu_format::raw}});
+
+/// @brief write the solution of a 1D problem to dat files
+/// range(0): the number of elements
+template<int Pn>
+static void BM_write_dat(benchmark::State& state) {
+    dg_problem<1, Pn, burgers_physics> problem{(IDX) state.range(0)};
+    auto u = problem.u();
+    io::DatWriter<T, IDX, 1> writer{problem.fespace};
+    writer.register_fields(u, problem.disc.field_names);
+    writer.data_directory = bench_output_directory();
+    writer.collection_name = "bench";
+    // overwrite the same output so the file count does not grow with the iterations
+    for(auto _ : state) writer.write_dat(0, 0.0);
+    std::filesystem::remove_all(bench_output_directory());
+    state.counters["dofs/s"] = per_second(problem.ndof());
+}
+BENCHMARK(BM_write_dat<2>)->Name("write_dat/ndim:1/p:2")->Arg(1024);
@@ -0,0 +1,172 @@
+"""
+Compare benchmark results against a stored baseline and fail on regressions.
+
+Reads the JSON written by iceicle_bench (--benchmark_out, Google Benchmark format)
+or by scaling_bench (--json) and compares each metric to the baseline:
+
+* Google Benchmark entries use the dofs/s (or qp/s) throughput counter when present
+  (higher is better) and the real time otherwise (lower is better).
+  With repetitions only the median aggregate is compared.
+* scaling_bench phases use dofs/s/core (higher is better).
+
+The baseline is a JSON file
+
+    {
+      "tolerance": 0.10,
+      "metrics": {
+        "bench/form_residual/ns/ndim:2/p:2/64": {"value": 1.2e7, "higher_is_better": true},
+        "scaling/ns2d/weak/p2/n1/residual": {"value": 3.4e6, "higher_is_better": true, "tolerance": 0.2}
+      }
+    }
+
+where a per-metric tolerance overrides the global one.
+Record or refresh a baseline with --update (the tolerances already in the file are kept).
+
+Usage:
+    perf_compare.py --baseline base.json [--tolerance 0.1] [--update] [--run CMD...] results.json ...
+
+With --run the command is executed first (the result files are removed beforehand so stale results are not compared).
+
+Exit codes: 0 no regressions, 1 regression or missing metric with --strict, 2 the run failed,
+77 no baseline exists (reported to CTest as skipped)
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+SKIP_RETURN_CODE = 77
+
+counter_names = ["dofs/s", "qp/s"]
+
+
+def gbench_metrics(data):
+    """the metrics of a Google Benchmark result file"""
+    metrics = {}
+    have_median = any(b.get("aggregate_name") == "median" for b in data["benchmarks"])
+    for b in data["benchmarks"]:
+        if have_median:
+            if b.get("aggregate_name") != "median":
+                continue
+            name = b.get("run_name", b["name"])
+        else:
+            if b.get("run_type") == "aggregate":
+                continue
+            name = b["name"]
+        key = "bench/" + name
+        for counter in counter_names:
+            if counter in b:
+                metrics[key] = (b[counter], True)
+                break
+        else:
+            metrics[key] = (b["real_time"], False)
+    return metrics
+
+
+def scaling_metrics(data):
+    """the metrics of a scaling_bench result file"""
+    metrics = {}
+    for phase in data["phases"]:
+        key = "scaling/{}/{}/p{}/n{}/{}".format(data["problem"], data["mode"],
+                                               data["order"], data["nrank"], phase["phase"])
+        metrics[key] = (phase["dofs_per_s_per_core"], True)
+    return metrics
+
+
+def read_metrics(filename):
+    with open(filename) as f:
+        data = json.load(f)
+    if "benchmarks" in data:
+        return gbench_metrics(data)
+    if "phases" in data:
+        return scaling_metrics(data)
+    raise ValueError("unrecognized result format")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="compare benchmark results against a baseline")
+    parser.add_argument("results", nargs="+", help="the result JSON files")
+    parser.add_argument("--baseline", required=True, help="the baseline JSON file")
+    parser.add_argument("--tolerance", type=float, default=None,
+                        help="the relative tolerance band (overrides the baseline file)")
+    parser.add_argument("--update", action="store_true",
+                        help="write the measured values into the baseline instead of comparing")
+    parser.add_argument("--strict", action="store_true",
+                        help="fail when a baseline metric is missing from the results")
+    parser.add_argument("--run", nargs=argparse.REMAINDER,
+                        help="the command that produces the result files (must be last)")
+    args = parser.parse_args()
+
+    if not args.update and not os.path.exists(args.baseline):
+        print("no baseline at {} (record one with --update), skipping".format(args.baseline))
+        return SKIP_RETURN_CODE
+
+    if args.run:
+        for filename in args.results:
+            if os.path.exists(filename):
+                os.remove(filename)
+        if subprocess.run(args.run).returncode != 0:
+            print("benchmark command failed: " + " ".join(args.run))
+            return 2
+
+    measured = {}
+    for filename in args.results:
+        try:
+            measured.update(read_metrics(filename))
+        except (OSError, ValueError, KeyError) as err:
+            print("could not read the results in {}: {}".format(filename, err))
+            return 2
+
+    baseline = {"tolerance": 0.10, "metrics": {}}
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+    tolerance = args.tolerance if args.tolerance is not None else baseline.get("tolerance", 0.10)
+
+    if args.update:
+        for key, (value, higher_is_better) in measured.items():
+            entry = baseline["metrics"].setdefault(key, {})
+            entry["value"] = value
+            entry["higher_is_better"] = higher_is_better
+        baseline["tolerance"] = tolerance
+        with open(args.baseline, "w") as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+        print("updated {} metrics in {}".format(len(measured), args.baseline))
+        return 0
+
+    nregress = 0
+    nmissing = 0
+    width = max([len(key) for key in baseline["metrics"]] + [6])
+    print("{:<{}}  {:>12}  {:>12}  {:>8}  {:>6}".format("metric", width, "baseline", "measured", "change", "tol"))
+    for key, entry in sorted(baseline["metrics"].items()):
+        tol = entry.get("tolerance", tolerance)
+        if key not in measured:
+            nmissing += 1
+            print("{:<{}}  {:>12.4e}  {:>12}  {:>8}  {:>6.2f}  MISSING".format(key, width, entry["value"], "-", "-", tol))
+            continue
+        value, _ = measured[key]
+        base = entry["value"]
+        change = (value - base) / base if base != 0 else 0.0
+        # a positive gain is an improvement whichever direction is better
+        gain = change if entry.get("higher_is_better", True) else -change
+        status = ""
+        if gain < -tol:
+            status = "REGRESSION"
+            nregress += 1
+        elif gain > tol:
+            status = "improved (consider --update)"
+        print("{:<{}}  {:>12.4e}  {:>12.4e}  {:>+7.1%}  {:>6.2f}  {}".format(key, width, base, value, change, tol, status))
+
+    if nregress > 0:
+        print("{} regressions beyond the tolerance band".format(nregress))
+        return 1
+    if nmissing > 0 and args.strict:
+        print("{} baseline metrics are missing from the results".format(nmissing))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,20 @@
+R"(
+#version 330 core
+
+in float field_value;
+
+// the range of the colormap
+uniform float umin;
+uniform float umax;
+
+out vec3 color;
+
+void main() {
+    // cool to warm diverging colormap
+    float t = clamp((field_value - umin) / max(umax - umin, 1e-30), 0.0, 1.0);
+    vec3 cool = vec3(0.230, 0.299, 0.754);
+    vec3 mid = vec3(0.865, 0.865, 0.865);
+    vec3 warm = vec3(0.706, 0.016, 0.150);
+    color = (t < 0.5) ? mix(cool, mid, 2.0 * t) : mix(mid, warm, 2.0 * t - 1.0);
+}
+)"
@@ -0,0 +1,48 @@
+R"(
+#version 330 core
+
+// evaluates a finite element field at the vertices of a subdivided reference patch
+// one instance per element, gl_VertexID indexes the patch vertex
+
+// the basis functions at each patch vertex [nvert x nbasis]
+uniform samplerBuffer basis_table;
+
+// the physical coordinates of each patch vertex of each element [nelem x nvert] (rg)
+uniform samplerBuffer vertex_coords;
+
+// the coefficients of the field for each element [nelem x nbasis]
+uniform samplerBuffer coefficients;
+
+uniform int nbasis;
+uniform int nvert;
+
+uniform vec3 xmin;
+uniform vec3 xmax;
+
+out float field_value;
+
+void main() {
+    float u = 0.0;
+    int ibasis_table = gl_VertexID * nbasis;
+    int icoeff = gl_InstanceID * nbasis;
+    for(int ibasis = 0; ibasis < nbasis; ++ibasis){
+        u += texelFetch(coefficients, icoeff + ibasis).r
+            * texelFetch(basis_table, ibasis_table + ibasis).r;
+    }
+    field_value = u;
+
+    vec3 model_pos = vec3(texelFetch(vertex_coords, gl_InstanceID * nvert + gl_VertexID).rg, 0.0);
+
+    // scale into the viewport (same as bounding_box_scale.vert)
+    vec3 size = xmax - xmin;
+    float size_max = max(max(size[0], size[1]), size[2]);
+    vec3 t = 2 * (model_pos - xmin) / size_max - 1;
+    vec3 normpos = (1 - size / size_max) + t;
+
+    const float BORDER = 0.1;
+    const float VIEWPORT_SIZE = 2.0 - 2 * BORDER;
+    const float VIEWPORT_HALF = 1.0 - BORDER;
+    vec3 t2 = (normpos + 1.0) / 2;
+    gl_Position = vec4(-VIEWPORT_HALF + t2 * VIEWPORT_SIZE, 1.0);
+}
+)"
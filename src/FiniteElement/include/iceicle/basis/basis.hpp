@@ -68,6 +68,49 @@
             throw std::logic_error("Not Implemented");
         };
 
+        /**
+         * @brief evaluate the basis functions at a batch of points
+         * (one virtual call for all the points, implementations override this with a devirtualized loop)
+         *
+         * @param [in] npts the number of points
+         * @param [in] xi the points in the reference domain [size = [npts][ndim]]
+         * @param [out] B the values of the basis functions at each point [size = [npts][nbasis]]
+         */
+        virtual
+        void evalBasisBatch(int npts, const T *xi, T *B) const {
+            const int nb = nbasis();
+            for(int ipt = 0; ipt < npts; ++ipt) evalBasis(xi + ipt * ndim, B + ipt * nb);
+        }
+
+        /**
+         * @brief evaluate the first derivatives of the basis functions at a batch of points
+         *
+         * @param [in] npts the number of points
+         * @param [in] xi the points in the reference domain [size = [npts][ndim]]
+         * @param [out] dB the derivatives at each point, in the layout of evalGradBasis 
+         *                 [size = [npts][nbasis][ndim]]
+         */
+        virtual
+        void evalGradBasisBatch(int npts, const T *xi, T *dB) const {
+            const int nb = nbasis();
+            for(int ipt = 0; ipt < npts; ++ipt) evalGradBasis(xi + ipt * ndim, dB + ipt * nb * ndim);
+        }
+
+        /**
+         * @brief evaluate the hessians of the basis functions at a batch of points
+         *
+         * @param [in] npts the number of points
+         * @param [in] xi the points in the reference domain [size = [npts][ndim]]
+         * @param [out] H the hessians at each point, in the layout of evalHessBasis 
+         *                [size = [npts][nbasis][ndim][ndim]]
+         */
+        virtual
+        void evalHessBasisBatch(int npts, const T *xi, T *H) const {
+            const int nb = nbasis();
+            for(int ipt = 0; ipt < npts; ++ipt) 
+                evalHessBasis(xi + ipt * ndim, H + ipt * nb * ndim * ndim);
+        }
+
         /**
          * @brief Tell if a basis is orthonormal (L2 inner product B_i \otimes B_j is diagonal) or not
          * 
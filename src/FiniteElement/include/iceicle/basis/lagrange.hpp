@@ -77,6 +77,40 @@ namespace iceicle {
             }
         }
 
+        // batches call the transformation directly instead of through the virtual single point evaluations
+
+        void evalBasisBatch(int npts, const T *xi, T *B) const override {
+            const int nb = transform.nnodes();
+            for(int ipt = 0; ipt < npts; ++ipt){
+                for(int inode = 0; inode < nb; ++inode)
+                    B[ipt * nb + inode] = transform.shp(xi + ipt * ndim, inode);
+            }
+        }
+
+        void evalGradBasisBatch(int npts, const T *xi, T *dB) const override {
+            const int nb = transform.nnodes();
+            for(int ipt = 0; ipt < npts; ++ipt){
+                for(int inode = 0; inode < nb; ++inode){
+                    for(int jderiv = 0; jderiv < ndim; ++jderiv)
+                        dB[(ipt * nb + inode) * ndim + jderiv] = transform.dshp(xi + ipt * ndim, inode, jderiv);
+                }
+            }
+        }
+
+        void evalHessBasisBatch(int npts, const T *xi, T *H) const override {
+            const int nb = transform.nnodes();
+            for(int ipt = 0; ipt < npts; ++ipt){
+                for(int inode = 0; inode < nb; ++inode){
+                    for(int ideriv = 0; ideriv < ndim; ++ideriv){
+                        for(int jderiv = 0; jderiv < ndim; ++jderiv){
+                            H[((ipt * nb + inode) * ndim + ideriv) * ndim + jderiv] 
+                                = transform.dshp2(xi + ipt * ndim, inode, ideriv, jderiv);
+                        }
+                    }
+                }
+            }
+        }
+
         bool isOrthonormal() const override { return false; }
 
         bool isNodal() const override { return true; }
@@ -85,11 +119,22 @@ namespace iceicle {
     };
 
 
-    template<typename T, typename IDX, int ndim, int Pn>
+    /**
+     * @brief Lagrange Basis functions on hypercube elements
+     * as the tensor product of 1D Lagrange interpolations
+     *
+     * @tparam T the floating point type
+     * @tparam IDX the index type
+     * @tparam ndim the number of dimensions
+     * @tparam Pn the polynomial order
+     * @tparam Basis1DType the 1D interpolation (uniform nodes by default, 
+     *         GaussLobattoLagrangeInterpolation for collocation on Gauss-Lobatto quadrature)
+     */
+    template<typename T, typename IDX, int ndim, int Pn, 
+        class Basis1DType = UniformLagrangeInterpolation<T, Pn>>
     class HypercubeLagrangeBasis final: public Basis<T, ndim> {
 
-        static inline UniformLagrangeInterpolation<T, Pn> lagrange_1d;
-        using Basis1DType = decltype(lagrange_1d);
+        static inline Basis1DType lagrange_1d;
         static inline QTypeProduct<T, ndim, Basis1DType::nbasis> tensor_prod;
         using TensorProdType = decltype(tensor_prod);
 
@@ -123,6 +168,20 @@ namespace iceicle {
             (void) tensor_prod.fill_hess(lagrange_1d, xi, HessianData);
         }
 
+        void evalBasisBatch(int npts, const T *xi, T *B) const override {
+            tensor_prod.fill_shp_batch(lagrange_1d, npts, xi, B);
+        }
+
+        void evalGradBasisBatch(int npts, const T *xi, T *dB) const override {
+            tensor_prod.fill_deriv_batch(lagrange_1d, npts, xi, dB);
+        }
+
+        void evalHessBasisBatch(int npts, const T *xi, T *H) const override {
+            constexpr int hess_size = TensorProdType::nvalues * ndim * ndim;
+            for(int ipt = 0; ipt < npts; ++ipt)
+                (void) tensor_prod.fill_hess(lagrange_1d, xi + ipt * ndim, H + ipt * hess_size);
+        }
+
         bool isOrthonormal() const override { return false; }
 
         bool isNodal() const override { return true; }
@@ -4,6 +4,7 @@
  */
 #pragma once
 #include "Numtool/polydefs/LagrangePoly.hpp"
+#include "iceicle/quadrature/quadrules_1d.hpp"
 #include <Numtool/fixed_size_tensor.hpp>
 
 namespace iceicle {
@@ -74,7 +75,7 @@ namespace iceicle {
         * @param xi the point to evaluate at 
         * @return an array of all the evaluations
         */
-        Tensor<T, Pn + 1> eval_all(T xi) const {
+        constexpr Tensor<T, Pn + 1> eval_all(T xi) const {
             Tensor<T, Pn + 1> Nj{};
 
             // finite volume case
@@ -122,7 +123,7 @@ namespace iceicle {
         * @param xi the point to evaluate at 
         * @return an array of all the evaluations
         */
-        void deriv_all(
+        constexpr void deriv_all(
             T xi,
             Tensor<T, Pn+1> &Nj,
             Tensor<T, Pn+1> &dNj
@@ -210,4 +211,117 @@ namespace iceicle {
             }
         }
     };
+
+    /**
+     * @brief Interpolation of the Pn + 1 Gauss-Lobatto-Legendre points on [-1, 1]
+     * ordered from -1 to 1
+     *
+     * On the matching GaussLobattoQuadrature the basis is collocated 
+     * (the basis functions are the identity at the quadrature points)
+     * which gives the diagonal norm summation by parts operators of DG-SEM
+     *
+     * The polynomials are evaluated in product form l_j(x) = w_j prod_{k != j}(x - x_k)
+     * with the derivatives accumulated by the product rule 
+     * so the evaluations are exact at the nodes (no division by x - x_j)
+     */
+    template<typename T, int Pn>
+    struct GaussLobattoLagrangeInterpolation {
+        template<typename T1, std::size_t... sizes>
+        using Tensor = NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T1, sizes...>;
+
+        /// @brief value type tag
+        using value_type = T;
+
+        /// @brief the number of basis functions generated by this interpolation
+        static constexpr int nbasis = Pn + 1;
+
+        /// the Gauss-Lobatto points (the cell center for Pn = 0) from the compile time table
+        static constexpr Tensor<T, Pn + 1> xi_nodes = []{
+            Tensor<T, Pn + 1> ret = {};
+            if constexpr (Pn == 0) {
+                ret[0] = 0.0;
+            } else {
+                for(int j = 0; j < Pn + 1; ++j) ret[j] = gauss_lobatto_table<T, Pn + 1>.points[j];
+            }
+            return ret;
+        }();
+
+        /// the barycentric weights
+        static constexpr Tensor<T, Pn + 1> wj = []{
+            Tensor<T, Pn + 1> ret;
+            for(int j = 0; j < Pn + 1; ++j){
+                ret[j] = 1.0;
+                for(int k = 0; k < Pn + 1; ++k) if(k != j) {
+                    ret[j] *= (xi_nodes[j] - xi_nodes[k]);
+                }
+                ret[j] = 1.0 / ret[j];
+            }
+            return ret;
+        }();
+
+        /**
+        * @brief Evaluate every interpolating polynomial at the given point 
+        * @param xi the point to evaluate at 
+        * @return an array of all the evaluations
+        */
+        constexpr Tensor<T, Pn + 1> eval_all(T xi) const {
+            Tensor<T, Pn + 1> Nj{};
+            for(int j = 0; j < Pn + 1; ++j){
+                T l = wj[j];
+                for(int k = 0; k < Pn + 1; ++k) if(k != j) l *= (xi - xi_nodes[k]);
+                Nj[j] = l;
+            }
+            return Nj;
+        }
+
+        /**
+        * @brief Get the value and derivative of 
+        * every interpolating polynomial at the given point 
+        * @param xi the point to evaluate at 
+        * @param [out] Nj the basis function evaluations
+        * @param [out] dNj the derivative evaluations
+        */
+        constexpr void deriv_all(
+            T xi,
+            Tensor<T, Pn+1> &Nj,
+            Tensor<T, Pn+1> &dNj
+        ) const {
+            for(int j = 0; j < Pn + 1; ++j){
+                T l = wj[j], dl = 0;
+                for(int k = 0; k < Pn + 1; ++k) if(k != j) {
+                    dl = dl * (xi - xi_nodes[k]) + l;
+                    l *= (xi - xi_nodes[k]);
+                }
+                Nj[j] = l;
+                dNj[j] = dl;
+            }
+        }
+
+        /**
+         * @brief get the value, derivative, and second derivative 
+         * of every interpolating polynomial at the given point
+         * @param xi the point to evaluate at 
+         * @param [out] Nj the basis function evaluations
+         * @param [out] dNj the derivative evaluations
+         * @param [out] d2Nj the second derivative evaluations
+         */
+        void d2_all(
+            T xi,
+            Tensor<T, Pn+1> &Nj,
+            Tensor<T, Pn+1> &dNj,
+            Tensor<T, Pn+1> &d2Nj
+        ) const {
+            for(int j = 0; j < Pn + 1; ++j){
+                T l = wj[j], dl = 0, d2l = 0;
+                for(int k = 0; k < Pn + 1; ++k) if(k != j) {
+                    d2l = d2l * (xi - xi_nodes[k]) + 2 * dl;
+                    dl = dl * (xi - xi_nodes[k]) + l;
+                    l *= (xi - xi_nodes[k]);
+                }
+                Nj[j] = l;
+                dNj[j] = dl;
+                d2Nj[j] = d2l;
+            }
+        }
+    };
 }
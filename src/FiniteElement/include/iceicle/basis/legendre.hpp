@@ -319,7 +319,22 @@ namespace iceicle {
             (void) tensor_prod.fill_hess(basis_1d, xi, HessianData);
         }
 
-        bool isOrthonormal() const override { return false; }
+        void evalBasisBatch(int npts, const T *xi, T *B) const override {
+            tensor_prod.fill_shp_batch(basis_1d, npts, xi, B);
+        }
+
+        void evalGradBasisBatch(int npts, const T *xi, T *dB) const override {
+            tensor_prod.fill_deriv_batch(basis_1d, npts, xi, dB);
+        }
+
+        void evalHessBasisBatch(int npts, const T *xi, T *H) const override {
+            constexpr int hess_size = TensorProdType::nvalues * ndim * ndim;
+            for(int ipt = 0; ipt < npts; ++ipt)
+                (void) tensor_prod.fill_hess(basis_1d, xi + ipt * ndim, H + ipt * hess_size);
+        }
+
+        /// @brief the tensor product Legendre polynomials are L2 orthogonal on the reference hypercube
+        bool isOrthonormal() const override { return true; }
 
         bool isNodal() const override { return true; }
 
@@ -0,0 +1,475 @@
+/**
+ * @brief sum factorization for tensor product bases on tensor product quadrature rules
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include <Numtool/integer_utils.hpp>
+#include <iceicle/quadrature/quadrules_1d.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace iceicle {
+
+    namespace impl {
+        /**
+         * @brief contract dimension idim of a row major tensor with a 1D operator
+         * with compile time extents (see SumFactorization::contract)
+         * out[o, a, i] = sum_b op[a, b] in[o, b, i] (or op[b, a] if transpose)
+         *
+         * @param op the 1D operator [nqp_1d x nbasis_1d]
+         * @param in the input tensor
+         * @param [out] out the output tensor
+         */
+        template<class T, int nbasis_1d, int nqp_1d, int ndim, int idim, bool transpose>
+        constexpr auto contract_fixed(const T* op, const T* in, T* out) noexcept -> void {
+            constexpr int nin = transpose ? nqp_1d : nbasis_1d;
+            constexpr int nout = transpose ? nbasis_1d : nqp_1d;
+            constexpr int nouter = MATH::power_T<nout, idim>::value;
+            constexpr int ninner = MATH::power_T<nin, ndim - idim - 1>::value;
+            for(int io = 0; io < nouter; ++io){
+                for(int a = 0; a < nout; ++a){
+                    for(int i = 0; i < ninner; ++i){
+                        T acc = 0;
+                        for(int b = 0; b < nin; ++b){
+                            T opab = transpose ? op[b * nbasis_1d + a] : op[a * nbasis_1d + b];
+                            acc += opab * in[(io * nin + b) * ninner + i];
+                        }
+                        out[(io * nout + a) * ninner + i] = acc;
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief apply a 1D operator in every dimension of a row major tensor with the number of dimensions at runtime
+     * out = (op x op x ... x op) in (or op^T in every dimension if transpose)
+     *
+     * @param ndim the number of dimensions
+     * @param op the 1D operator [nrow x ncol] (row major)
+     * @param nrow the number of rows of op
+     * @param ncol the number of columns of op
+     * @param transpose if true apply op^T
+     * @param in the input tensor [ncol^ndim] ([nrow^ndim] if transpose)
+     * @param [out] out the output tensor [nrow^ndim] ([ncol^ndim] if transpose), must not overlap in
+     * @param scratch storage of at least 2 * max(nrow, ncol)^ndim
+     */
+    template<class T>
+    auto kronecker_apply(int ndim, const T* op, int nrow, int ncol, bool transpose,
+            const T* in, T* out, T* scratch) noexcept -> void
+    {
+        const int nin = transpose ? nrow : ncol;
+        const int nout = transpose ? ncol : nrow;
+        int half = 1, ninner = 1, nouter = 1;
+        for(int idim = 0; idim < ndim; ++idim) half *= std::max(nrow, ncol);
+        for(int idim = 1; idim < ndim; ++idim) ninner *= nin;
+        const T* src = in;
+        for(int idim = 0; idim < ndim; ++idim){
+            T* dst = (idim == ndim - 1) ? out : scratch + (idim % 2) * half;
+            for(int io = 0; io < nouter; ++io){
+                for(int a = 0; a < nout; ++a){
+                    for(int i = 0; i < ninner; ++i){
+                        T acc = 0;
+                        for(int b = 0; b < nin; ++b){
+                            T opab = transpose ? op[b * ncol + a] : op[a * ncol + b];
+                            acc += opab * src[(io * nin + b) * ninner + i];
+                        }
+                        dst[(io * nout + a) * ninner + i] = acc;
+                    }
+                }
+            }
+            src = dst;
+            nouter *= nout;
+            if(idim + 1 < ndim) ninner /= nin;
+        }
+    }
+
+    /**
+     * @brief compile time 1D basis function tables at the points of a 1D quadrature rule
+     * with fixed extent sum factorization kernels
+     *
+     * The layout is the same as SumFactorization, but all the trip counts are compile time constants
+     * so the contractions can be fully unrolled and the intermediate tensors live on the stack
+     *
+     * @tparam T the floating point type
+     * @tparam nbasis_1d the number of 1D basis functions
+     * @tparam nqp_1d the number of 1D quadrature points
+     */
+    template<class T, int nbasis_1d, int nqp_1d>
+    struct SumFactorizationTables {
+
+        /// @brief the number of 1D basis functions
+        static constexpr int n_basis_1d = nbasis_1d;
+
+        /// @brief the number of 1D quadrature points
+        static constexpr int n_qp_1d = nqp_1d;
+
+        /// @brief the 1D basis functions at the 1D quadrature points [nqp_1d x nbasis_1d]
+        std::array<T, nqp_1d * nbasis_1d> interp_1d{};
+
+        /// @brief the 1D basis function derivatives at the 1D quadrature points [nqp_1d x nbasis_1d]
+        std::array<T, nqp_1d * nbasis_1d> deriv_1d{};
+
+        /// @brief the 1D quadrature weights [nqp_1d]
+        std::array<T, nqp_1d> weights_1d{};
+
+        private:
+
+        /// @brief apply the contractions from dimension idim on, alternating between the scratch buffers
+        template<int ndim, int idim, bool transpose, class Buffer>
+        constexpr auto contract_from(int ideriv, const T* in, T* out, Buffer& buf) const noexcept -> void {
+            const T* op = (idim == ideriv) ? deriv_1d.data() : interp_1d.data();
+            if constexpr (idim == ndim - 1) {
+                impl::contract_fixed<T, nbasis_1d, nqp_1d, ndim, idim, transpose>(op, in, out);
+            } else {
+                T* dst = buf[idim % 2].data();
+                impl::contract_fixed<T, nbasis_1d, nqp_1d, ndim, idim, transpose>(op, in, dst);
+                contract_from<ndim, idim + 1, transpose>(ideriv, dst, out, buf);
+            }
+        }
+
+        public:
+
+        /// @brief the number of basis functions of the tensor product
+        template<int ndim>
+        static constexpr int nbasis = MATH::power_T<nbasis_1d, ndim>::value;
+
+        /// @brief the number of quadrature points of the tensor product
+        template<int ndim>
+        static constexpr int nqp = MATH::power_T<nqp_1d, ndim>::value;
+
+        /**
+         * @brief evaluate at all quadrature points (see SumFactorization::apply)
+         * @param ideriv the dimension to differentiate in (-1 for values)
+         * @param in the coefficients for each basis function [nbasis<ndim>]
+         * @param [out] out the values at each quadrature point [nqp<ndim>]
+         */
+        template<int ndim>
+        constexpr auto apply(int ideriv, const T* in, T* out) const noexcept -> void {
+            std::array<std::array<T, MATH::power_T<std::max(nbasis_1d, nqp_1d), ndim>::value>, 2> buf;
+            contract_from<ndim, 0, false>(ideriv, in, out, buf);
+        }
+
+        /**
+         * @brief integrate against the basis functions or derivatives (see SumFactorization::apply_transpose)
+         * @param ideriv the dimension of the derivative of the test function (-1 for values)
+         * @param in the values at each quadrature point [nqp<ndim>]
+         * @param [in/out] out the integrals are added to this [nbasis<ndim>]
+         */
+        template<int ndim>
+        constexpr auto apply_transpose(int ideriv, const T* in, T* out) const noexcept -> void {
+            std::array<std::array<T, MATH::power_T<std::max(nbasis_1d, nqp_1d), ndim>::value>, 2> buf;
+            std::array<T, nbasis<ndim>> result;
+            contract_from<ndim, 0, true>(ideriv, in, result.data(), buf);
+            for(int ibasis = 0; ibasis < nbasis<ndim>; ++ibasis) out[ibasis] += result[ibasis];
+        }
+    };
+
+    /**
+     * @brief tabulate a 1D basis at the points of a compile time 1D quadrature table
+     * @param basis_1d the 1D basis (constexpr eval_all and deriv_all)
+     * @param quadrule the 1D quadrature points and weights
+     */
+    template<class Basis1D, class T, int nqp_1d>
+    constexpr auto make_sum_factorization_tables(
+        const Basis1D& basis_1d,
+        const impl::quadrule_1d_table<T, nqp_1d>& quadrule
+    ) -> SumFactorizationTables<T, Basis1D::nbasis, nqp_1d> {
+        SumFactorizationTables<T, Basis1D::nbasis, nqp_1d> tables{};
+        for(int iqp = 0; iqp < nqp_1d; ++iqp){
+            T xi = quadrule.points[iqp];
+            tables.weights_1d[iqp] = quadrule.weights[iqp];
+            auto Nj = basis_1d.eval_all(xi);
+            auto dNj = basis_1d.eval_all(xi);
+            basis_1d.deriv_all(xi, Nj, dNj);
+            for(int ibasis = 0; ibasis < Basis1D::nbasis; ++ibasis){
+                tables.interp_1d[iqp * Basis1D::nbasis + ibasis] = Nj[ibasis];
+                tables.deriv_1d[iqp * Basis1D::nbasis + ibasis] = dNj[ibasis];
+            }
+        }
+        return tables;
+    }
+
+    /// @brief the 1D basis tables at the Gauss Legendre points baked at compile time
+    template<class Basis1D, int nqp_1d>
+    inline constexpr auto gauss_legendre_sum_factorization_tables = make_sum_factorization_tables(
+            Basis1D{}, gauss_legendre_table<typename Basis1D::value_type, nqp_1d>);
+
+    /// @brief the 1D basis tables at the Gauss Lobatto points baked at compile time
+    template<class Basis1D, int nqp_1d>
+    inline constexpr auto gauss_lobatto_sum_factorization_tables = make_sum_factorization_tables(
+            Basis1D{}, gauss_lobatto_table<typename Basis1D::value_type, nqp_1d>);
+
+    /**
+     * @brief 1D basis function tables for evaluating tensor product bases
+     * at tensor product quadrature points by successive 1D contractions
+     *
+     * Both the basis functions and the quadrature points are ordered with
+     * the first dimension as the slowest index (see QTypeProduct and HypercubeGaussLegendre)
+     *
+     * Applying an operator to all quadrature points costs O(ndim * n^{ndim+1})
+     * instead of O(n^{2 ndim}) for the full nbasis x nqp tables
+     *
+     * @tparam T the floating point type
+     * @tparam ndim the number of dimensions
+     */
+    template<class T, int ndim>
+    struct SumFactorization {
+
+        /// @brief the number of 1D basis functions
+        int nbasis_1d;
+
+        /// @brief the number of 1D quadrature points
+        int nqp_1d;
+
+        /// @brief the 1D basis functions at the 1D quadrature points [nqp_1d x nbasis_1d]
+        std::vector<T> interp_1d;
+
+        /// @brief the 1D basis function derivatives at the 1D quadrature points [nqp_1d x nbasis_1d]
+        std::vector<T> deriv_1d;
+
+        /// @brief the 1D quadrature weights [nqp_1d]
+        std::vector<T> weights_1d;
+
+        /**
+         * @brief construct the 1D tables
+         * @param basis_1d the 1D basis (provides nbasis, eval_all, and deriv_all)
+         * @param quadrule_1d the 1D quadrature rule
+         */
+        template<class Basis1D, class Quadrature1D>
+        SumFactorization(const Basis1D& basis_1d, const Quadrature1D& quadrule_1d)
+        : nbasis_1d{Basis1D::nbasis}, nqp_1d{quadrule_1d.npoints()},
+          interp_1d(nbasis_1d * nqp_1d), deriv_1d(nbasis_1d * nqp_1d), weights_1d(nqp_1d)
+        {
+            for(int iqp = 0; iqp < nqp_1d; ++iqp){
+                T xi = quadrule_1d[iqp].abscisse[0];
+                weights_1d[iqp] = quadrule_1d[iqp].weight;
+                auto Nj = basis_1d.eval_all(xi);
+                auto dNj = basis_1d.eval_all(xi);
+                basis_1d.deriv_all(xi, Nj, dNj);
+                for(int ibasis = 0; ibasis < nbasis_1d; ++ibasis){
+                    interp_1d[iqp * nbasis_1d + ibasis] = Nj[ibasis];
+                    deriv_1d[iqp * nbasis_1d + ibasis] = dNj[ibasis];
+                }
+            }
+        }
+
+        /**
+         * @brief copy the compile time 1D tables
+         * @param tables the tables from make_sum_factorization_tables
+         */
+        template<int nb, int nq>
+        SumFactorization(const SumFactorizationTables<T, nb, nq>& tables)
+        : nbasis_1d{nb}, nqp_1d{nq},
+          interp_1d(tables.interp_1d.begin(), tables.interp_1d.end()),
+          deriv_1d(tables.deriv_1d.begin(), tables.deriv_1d.end()),
+          weights_1d(tables.weights_1d.begin(), tables.weights_1d.end())
+        {}
+
+        /// @brief the number of basis functions of the tensor product
+        auto nbasis() const noexcept -> int {
+            int n = 1;
+            for(int idim = 0; idim < ndim; ++idim) n *= nbasis_1d;
+            return n;
+        }
+
+        /// @brief the number of quadrature points of the tensor product
+        auto nqp() const noexcept -> int {
+            int n = 1;
+            for(int idim = 0; idim < ndim; ++idim) n *= nqp_1d;
+            return n;
+        }
+
+        /// @brief if the basis is the identity at the quadrature points (i.e Lagrange on Gauss-Lobatto nodes)
+        /// then deriv_1d is the 1D differentiation matrix at the nodes
+        auto collocated() const noexcept -> bool {
+            if(nqp_1d != nbasis_1d) return false;
+            for(int iqp = 0; iqp < nqp_1d; ++iqp){
+                for(int ibasis = 0; ibasis < nbasis_1d; ++ibasis){
+                    T delta = (iqp == ibasis) ? 1.0 : 0.0;
+                    if(std::abs(interp_1d[iqp * nbasis_1d + ibasis] - delta) > 1e-12) return false;
+                }
+            }
+            return true;
+        }
+
+        /// @brief the scratch size required for apply() and apply_transpose()
+        auto scratch_size() const noexcept -> int {
+            int n = 1;
+            for(int idim = 0; idim < ndim; ++idim) n *= std::max(nbasis_1d, nqp_1d);
+            return 2 * n;
+        }
+
+        private:
+
+        /**
+         * @brief contract one dimension of a row major tensor with a 1D operator
+         * out[o, a, i] = sum_b op[a, b] in[o, b, i] (or op[b, a] if transpose)
+         *
+         * @param op the 1D operator [nqp_1d x nbasis_1d]
+         * @param transpose if true apply op^T (quadrature points to basis)
+         * @param idim the dimension to contract
+         * @param [in/out] shape the shape of the tensor (updated to the output shape)
+         * @param in the input tensor
+         * @param [out] out the output tensor
+         */
+        auto contract(const T* op, bool transpose, int idim,
+                std::array<int, ndim>& shape, const T* in, T* out) const noexcept -> void
+        {
+            int nouter = 1, ninner = 1;
+            for(int jdim = 0; jdim < idim; ++jdim) nouter *= shape[jdim];
+            for(int jdim = idim + 1; jdim < ndim; ++jdim) ninner *= shape[jdim];
+            const int nin = shape[idim];
+            const int nout = transpose ? nbasis_1d : nqp_1d;
+            std::fill_n(out, nouter * nout * ninner, 0.0);
+            for(int io = 0; io < nouter; ++io){
+                const T* in_o = in + io * nin * ninner;
+                T* out_o = out + io * nout * ninner;
+                for(int a = 0; a < nout; ++a){
+                    for(int b = 0; b < nin; ++b){
+                        T opab = transpose ? op[b * nbasis_1d + a] : op[a * nbasis_1d + b];
+                        for(int i = 0; i < ninner; ++i) out_o[a * ninner + i] += opab * in_o[b * ninner + i];
+                    }
+                }
+            }
+            shape[idim] = nout;
+        }
+
+        /// @brief select the 1D operator for each dimension
+        auto select_ops(int ideriv) const noexcept -> std::array<const T*, ndim> {
+            std::array<const T*, ndim> ops;
+            for(int idim = 0; idim < ndim; ++idim)
+                ops[idim] = (idim == ideriv) ? deriv_1d.data() : interp_1d.data();
+            return ops;
+        }
+
+        public:
+
+        /**
+         * @brief evaluate at all quadrature points
+         * out = (op_0 x op_1 x ... ) in
+         * @param ideriv the dimension to differentiate in (-1 for values)
+         * @param in the coefficients for each basis function [nbasis]
+         * @param [out] out the values at each quadrature point [nqp]
+         * @param scratch storage of at least scratch_size()
+         */
+        auto apply(int ideriv, const T* in, T* out, T* scratch) const noexcept -> void {
+            std::array<const T*, ndim> ops = select_ops(ideriv);
+            std::array<int, ndim> shape;
+            shape.fill(nbasis_1d);
+            const int half = scratch_size() / 2;
+            const T* src = in;
+            for(int idim = 0; idim < ndim; ++idim){
+                T* dst = (idim == ndim - 1) ? out : scratch + (idim % 2) * half;
+                contract(ops[idim], false, idim, shape, src, dst);
+                src = dst;
+            }
+        }
+
+        /**
+         * @brief the transpose of apply: integrate against the basis functions (or derivatives)
+         * out += (op_0 x op_1 x ... )^T in
+         * @param ideriv the dimension of the derivative of the test function (-1 for values)
+         * @param in the values at each quadrature point [nqp]
+         * @param [in/out] out the integrals for each basis function [nbasis]
+         * @param scratch storage of at least scratch_size() + nbasis()
+         */
+        auto apply_transpose(int ideriv, const T* in, T* out, T* scratch) const noexcept -> void {
+            std::array<const T*, ndim> ops = select_ops(ideriv);
+            std::array<int, ndim> shape;
+            shape.fill(nqp_1d);
+            const int half = scratch_size() / 2;
+            T* result = scratch + 2 * half;
+            const T* src = in;
+            for(int idim = 0; idim < ndim; ++idim){
+                T* dst = (idim == ndim - 1) ? result : scratch + (idim % 2) * half;
+                contract(ops[idim], true, idim, shape, src, dst);
+                src = dst;
+            }
+            const int nb = nbasis();
+            for(int ibasis = 0; ibasis < nb; ++ibasis) out[ibasis] += result[ibasis];
+        }
+    };
+
+    /**
+     * @brief view of the 1D tables of a SumFactorization with the extents known at compile time
+     * so the contractions use the fixed extent kernels (impl::contract_fixed)
+     *
+     * Same interface as SumFactorization for apply() and apply_transpose()
+     *
+     * @tparam T the floating point type
+     * @tparam ndim the number of dimensions
+     * @tparam nbasis_1d the number of 1D basis functions (must match sf.nbasis_1d)
+     * @tparam nqp_1d the number of 1D quadrature points (must match sf.nqp_1d)
+     */
+    template<class T, int ndim, int nbasis_1d, int nqp_1d>
+    struct FixedExtentSumFactorization {
+
+        /// @brief the 1D basis functions at the 1D quadrature points [nqp_1d x nbasis_1d]
+        const T* interp_1d;
+
+        /// @brief the 1D basis function derivatives at the 1D quadrature points [nqp_1d x nbasis_1d]
+        const T* deriv_1d;
+
+        /// @brief the 1D quadrature weights [nqp_1d]
+        const T* weights_1d;
+
+        /// @brief view the tables of a runtime sum factorization 
+        explicit FixedExtentSumFactorization(const SumFactorization<T, ndim>& sf) noexcept
+        : interp_1d{sf.interp_1d.data()}, deriv_1d{sf.deriv_1d.data()}, weights_1d{sf.weights_1d.data()}
+        {}
+
+        /// @brief the number of basis functions of the tensor product
+        static constexpr auto nbasis() noexcept -> int { return MATH::power_T<nbasis_1d, ndim>::value; }
+
+        /// @brief the number of quadrature points of the tensor product
+        static constexpr auto nqp() noexcept -> int { return MATH::power_T<nqp_1d, ndim>::value; }
+
+        /// @brief the scratch size required for apply() and apply_transpose()
+        static constexpr auto scratch_size() noexcept -> int 
+        { return 2 * MATH::power_T<std::max(nbasis_1d, nqp_1d), ndim>::value; }
+
+        private:
+
+        /// @brief apply the contractions from dimension idim on, alternating between the scratch halves
+        template<int idim, bool transpose>
+        auto contract_from(int ideriv, const T* in, T* out, T* scratch) const noexcept -> void {
+            const T* op = (idim == ideriv) ? deriv_1d : interp_1d;
+            if constexpr (idim == ndim - 1) {
+                impl::contract_fixed<T, nbasis_1d, nqp_1d, ndim, idim, transpose>(op, in, out);
+            } else {
+                T* dst = scratch + (idim % 2) * (scratch_size() / 2);
+                impl::contract_fixed<T, nbasis_1d, nqp_1d, ndim, idim, transpose>(op, in, dst);
+                contract_from<idim + 1, transpose>(ideriv, dst, out, scratch);
+            }
+        }
+
+        public:
+
+        /**
+         * @brief evaluate at all quadrature points (see SumFactorization::apply)
+         * @param ideriv the dimension to differentiate in (-1 for values)
+         * @param in the coefficients for each basis function [nbasis]
+         * @param [out] out the values at each quadrature point [nqp]
+         * @param scratch storage of at least scratch_size()
+         */
+        auto apply(int ideriv, const T* in, T* out, T* scratch) const noexcept -> void {
+            contract_from<0, false>(ideriv, in, out, scratch);
+        }
+
+        /**
+         * @brief integrate against the basis functions or derivatives (see SumFactorization::apply_transpose)
+         * @param ideriv the dimension of the derivative of the test function (-1 for values)
+         * @param in the values at each quadrature point [nqp]
+         * @param [in/out] out the integrals for each basis function [nbasis]
+         * @param scratch storage of at least scratch_size() + nbasis()
+         */
+        auto apply_transpose(int ideriv, const T* in, T* out, T* scratch) const noexcept -> void {
+            T* result = scratch + scratch_size();
+            contract_from<0, true>(ideriv, in, result, scratch);
+            for(int ibasis = 0; ibasis < nbasis(); ++ibasis) out[ibasis] += result[ibasis];
+        }
+    };
+}
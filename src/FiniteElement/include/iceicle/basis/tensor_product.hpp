@@ -15,6 +15,7 @@
 #include <stdexcept>
 #include <string>
 #include <sstream>
+#include <vector>
 
 namespace iceicle{
 
@@ -547,6 +548,97 @@ namespace iceicle{
             }
         }
 
+        /**
+        * @brief fill the shape functions at a batch of points
+        *
+        * The 1d basis is tabulated at all the points first [idim][ibasis][ipt]
+        * then each tensor product value is the product over the dimensions 
+        * with the loop over points innermost (contiguous so it can vectorize)
+        *
+        * @param [in] basis_1d the 1d basis functions
+        * @param [in] npts the number of points
+        * @param [in] xi the points in the reference domain [npts][ndim]
+        * @param [out] B the shape function evaluations [npts][nvalues]
+        */
+        void fill_shp_batch(
+            const basis_C1 auto &basis_1d,
+            int npts,
+            const T *xi,
+            T *B
+        ) const {
+            if constexpr(ndim == 0){
+                std::fill_n(B, npts, 1.0);
+            } else {
+                std::vector<T> evals(ndim * nbasis_1d * npts);
+                for(int ipt = 0; ipt < npts; ++ipt){
+                    for(int idim = 0; idim < ndim; ++idim){
+                        Tensor<T, nbasis_1d> Nj = basis_1d.eval_all(xi[ipt * ndim + idim]);
+                        for(int ibasis = 0; ibasis < nbasis_1d; ++ibasis)
+                            evals[(idim * nbasis_1d + ibasis) * npts + ipt] = Nj[ibasis];
+                    }
+                }
+
+                std::vector<T> prod(npts);
+                for(int ival = 0; ival < nvalues; ++ival){
+                    const T *e0 = evals.data() + ijk_poin[ival][0] * npts;
+                    std::copy_n(e0, npts, prod.data());
+                    for(int idim = 1; idim < ndim; ++idim){
+                        const T *e = evals.data() + (idim * nbasis_1d + ijk_poin[ival][idim]) * npts;
+                        for(int ipt = 0; ipt < npts; ++ipt) prod[ipt] *= e[ipt];
+                    }
+                    for(int ipt = 0; ipt < npts; ++ipt) B[ipt * nvalues + ival] = prod[ipt];
+                }
+            }
+        }
+
+        /**
+        * @brief fill the derivatives of the shape functions at a batch of points 
+        * (see fill_shp_batch)
+        *
+        * @param [in] basis_1d the 1d basis functions
+        * @param [in] npts the number of points
+        * @param [in] xi the points in the reference domain [npts][ndim]
+        * @param [out] dB the derivatives [npts][nvalues][ndim]
+        */
+        void fill_deriv_batch(
+            const basis_C1 auto &basis_1d,
+            int npts,
+            const T *xi,
+            T *dB
+        ) const {
+            if constexpr(ndim == 0){
+                std::fill_n(dB, npts, 0.0);
+            } else {
+                // [idim][ibasis][ipt]
+                std::vector<T> evals(ndim * nbasis_1d * npts);
+                std::vector<T> derivs(ndim * nbasis_1d * npts);
+                for(int ipt = 0; ipt < npts; ++ipt){
+                    for(int idim = 0; idim < ndim; ++idim){
+                        Tensor<T, nbasis_1d> Nj, dNj;
+                        basis_1d.deriv_all(xi[ipt * ndim + idim], Nj, dNj);
+                        for(int ibasis = 0; ibasis < nbasis_1d; ++ibasis){
+                            evals[(idim * nbasis_1d + ibasis) * npts + ipt] = Nj[ibasis];
+                            derivs[(idim * nbasis_1d + ibasis) * npts + ipt] = dNj[ibasis];
+                        }
+                    }
+                }
+
+                std::vector<T> prod(npts);
+                for(int ival = 0; ival < nvalues; ++ival){
+                    for(int jdim = 0; jdim < ndim; ++jdim){
+                        std::fill(prod.begin(), prod.end(), 1.0);
+                        for(int idim = 0; idim < ndim; ++idim){
+                            const std::vector<T>& tab = (idim == jdim) ? derivs : evals;
+                            const T *e = tab.data() + (idim * nbasis_1d + ijk_poin[ival][idim]) * npts;
+                            for(int ipt = 0; ipt < npts; ++ipt) prod[ipt] *= e[ipt];
+                        }
+                        for(int ipt = 0; ipt < npts; ++ipt) 
+                            dB[(ipt * nvalues + ival) * ndim + jdim] = prod[ipt];
+                    }
+                }
+            }
+        }
+
         /**
         * @brief fill the provided 1d array with the hessian of each basis function 
         * \frac{ d^2Bi }{ dx_j dx_k}
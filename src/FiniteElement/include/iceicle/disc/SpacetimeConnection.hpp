@@ -4,11 +4,15 @@
 #include "iceicle/element/TraceSpace.hpp"
 #include "iceicle/fe_function/fespan.hpp"
 #include "iceicle/fespace/fespace.hpp"
+#include "iceicle/fespace/point_location.hpp"
+#include "iceicle/anomaly_log.hpp"
 #include "iceicle/geometry/face.hpp"
 #include "iceicle/mesh/mesh.hpp"
 #include "iceicle/algo.hpp"
 #include <map>
 #include <list>
+#include <unordered_map>
+#include <vector>
 
 namespace iceicle {
 
@@ -186,4 +190,170 @@ namespace iceicle {
         }
     };
 
+    /**
+     * @brief the past slab solution at the quadrature points of a SPACETIME_PAST trace
+     * of the current slab
+     */
+    template<class T>
+    struct spacetime_past_trace {
+        /// @brief the polynomial order of the past element
+        int order;
+
+        /// @brief the past solution (nqp x nv)
+        std::vector<T> u{};
+
+        /// @brief the past solution physical gradient (nqp x nv x ndim)
+        std::vector<T> gradu{};
+
+        /// @brief the past solution physical hessian (nqp x nv x ndim x ndim)
+        std::vector<T> hessu{};
+    };
+
+    /**
+     * @brief streams spacetime slabs: keeps only the data of the previous slab 
+     * that the SPACETIME_PAST boundary of the current slab needs
+     *
+     * advance() evaluates the past slab solution (values, gradients, and hessians)
+     * at the quadrature points of each SPACETIME_PAST trace of the current slab.
+     * After advance() the past slab (mesh, fespace, and solution) can be released,
+     * so memory stays bounded for long spacetime runs.
+     *
+     * The connection (the past element and reference point for each current quadrature point)
+     * is found from compute_st_node_connectivity. When identical_slabs is set 
+     * (every slab is the same spatial mesh shifted in time) it is computed once and reused.
+     *
+     * Use as the ST_Info of ConservationLawDDG 
+     * and call disc.spacetime_info.advance() before solving each slab
+     *
+     * @tparam T the real value type
+     * @tparam IDX the index type
+     * @tparam ndim the number of dimensions (including time as the last dimension)
+     */
+    template<class T, class IDX, int ndim>
+    class SpacetimeSlabStream {
+        using Point = MATH::GEOMETRY::Point<T, ndim>;
+
+        /// @brief the past element and reference points for a SPACETIME_PAST trace
+        struct connection {
+            IDX facidx;
+            IDX past_elidx;
+            std::vector<Point> xi_past;
+        };
+
+        std::vector<connection> connections{};
+        bool connected = false;
+
+        /// @brief the past data keyed by the current trace index
+        std::unordered_map<IDX, spacetime_past_trace<T>> past_traces{};
+
+        /// @brief find the past element and reference point for every SPACETIME_PAST quadrature point
+        auto connect(FESpace<T, IDX, ndim>& fespace_past, FESpace<T, IDX, ndim>& fespace_current) -> void {
+            std::map<IDX, IDX> curr_to_past_nodes = compute_st_node_connectivity(
+                    *fespace_past.meshptr, *fespace_current.meshptr);
+            connections.clear();
+
+            std::vector<IDX> past_bface_idxs{};
+            for(std::size_t ibface = fespace_past.bdy_trace_start; ibface < fespace_past.bdy_trace_end; ++ibface){
+                if(fespace_past.traces[ibface].face->bctype == BOUNDARY_CONDITIONS::SPACETIME_FUTURE)
+                    past_bface_idxs.push_back(ibface);
+            }
+
+            for(const TraceSpace<T, IDX, ndim>& trace : fespace_current.get_boundary_traces()){
+                if(trace.face->bctype != BOUNDARY_CONDITIONS::SPACETIME_PAST) continue;
+                std::vector<IDX> past_nodes{};
+                for(IDX inode : trace.face->nodes_span()){
+                    auto it = curr_to_past_nodes.find(inode);
+                    if(it != curr_to_past_nodes.end()) past_nodes.push_back(it->second);
+                }
+
+                bool found = false;
+                for(IDX ibface_past : past_bface_idxs){
+                    const TraceSpace<T, IDX, ndim>& past_trace = fespace_past.traces[ibface_past];
+                    if(!util::eqset(std::span<const IDX>{past_nodes}, past_trace.face->nodes_span())) continue;
+
+                    connection conn{trace.facidx, past_trace.elL.elidx, std::vector<Point>(trace.nQP())};
+                    for(int iqp = 0; iqp < trace.nQP(); ++iqp){
+                        Point phys_pt;
+                        trace.face->transform(trace.getQP(iqp).abscisse, fespace_current.meshptr->coord, phys_pt);
+                        std::optional<Point> xi = inverse_transform(past_trace.elL, phys_pt, (T) 1e-10, 50);
+                        if(!xi) {
+                            util::AnomalyLog::log_anomaly(util::Anomaly{"spacetime past quadrature point not found in the past element", 
+                                    util::general_anomaly_tag{}});
+                            xi = past_trace.elL.trans->centroid_ref();
+                        }
+                        conn.xi_past[iqp] = xi.value();
+                    }
+                    connections.push_back(std::move(conn));
+                    found = true;
+                    break;
+                }
+                if(!found) util::AnomalyLog::log_anomaly(util::Anomaly{"no past slab face found for SPACETIME_PAST face " 
+                        + std::to_string(trace.facidx), util::general_anomaly_tag{}});
+            }
+            connected = true;
+        }
+
+        public:
+
+        /// @brief set if every slab has the same spatial mesh (the connection is only computed once)
+        bool identical_slabs = false;
+
+        SpacetimeSlabStream() = default;
+
+        SpacetimeSlabStream(bool identical_slabs) : identical_slabs{identical_slabs} {}
+
+        /**
+         * @brief store the past slab data for the SPACETIME_PAST boundary of the current slab
+         * the past slab is not referenced after this call
+         *
+         * @param fespace_past the finite element space of the past slab
+         * @param u_past the solution on the past slab
+         * @param fespace_current the finite element space of the current slab
+         */
+        template<class LayoutPolicy, class AccessorPolicy>
+        auto advance(
+            FESpace<T, IDX, ndim>& fespace_past,
+            fespan<T, LayoutPolicy, AccessorPolicy> u_past,
+            FESpace<T, IDX, ndim>& fespace_current
+        ) -> void {
+            if(!connected || !identical_slabs) connect(fespace_past, fespace_current);
+
+            const std::size_t nv = u_past.nv();
+            past_traces.clear();
+            for(const connection& conn : connections){
+                const FiniteElement<T, IDX, ndim>& el = fespace_past.elements[conn.past_elidx];
+                const std::size_t nqp = conn.xi_past.size();
+                spacetime_past_trace<T> past{el.basis->getPolynomialOrder(),
+                    std::vector<T>(nqp * nv, 0.0), std::vector<T>(nqp * nv * ndim, 0.0),
+                    std::vector<T>(nqp * nv * ndim * ndim, 0.0)};
+
+                std::vector<T> basis(el.nbasis()), grad_data(el.nbasis() * ndim), 
+                    hess_data(el.nbasis() * ndim * ndim);
+                for(std::size_t iqp = 0; iqp < nqp; ++iqp){
+                    const Point& xi = conn.xi_past[iqp];
+                    el.eval_basis(xi, basis.data());
+                    auto grad = el.eval_phys_grad_basis(xi, grad_data.data());
+                    auto hess = el.eval_phys_hess_basis(xi, hess_data.data());
+                    for(std::size_t ibasis = 0; ibasis < el.nbasis(); ++ibasis){
+                        for(std::size_t iv = 0; iv < nv; ++iv){
+                            T coeff = u_past[conn.past_elidx, ibasis, iv];
+                            past.u[iqp * nv + iv] += coeff * basis[ibasis];
+                            for(int idim = 0; idim < ndim; ++idim){
+                                past.gradu[(iqp * nv + iv) * ndim + idim] += coeff * grad[ibasis, idim];
+                                for(int jdim = 0; jdim < ndim; ++jdim)
+                                    { past.hessu[((iqp * nv + iv) * ndim + idim) * ndim + jdim] += coeff * hess[ibasis, idim, jdim]; }
+                            }
+                        }
+                    }
+                }
+                past_traces[conn.facidx] = std::move(past);
+            }
+        }
+
+        /// @brief the past slab data for the current trace with index facidx (nullptr if not connected)
+        [[nodiscard]] auto past_trace(IDX facidx) const -> const spacetime_past_trace<T>* {
+            auto it = past_traces.find(facidx);
+            return (it == past_traces.end()) ? nullptr : &(it->second);
+        }
+    };
 }
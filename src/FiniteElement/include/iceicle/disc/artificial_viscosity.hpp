@@ -0,0 +1,251 @@
+/// @brief sensor based artificial viscosity for shock capturing
+/// @author Gianni Absillis (gabsill@ncsu.edu)
+#pragma once
+#include "Numtool/point.hpp"
+#include "iceicle/element/finite_element.hpp"
+#include "iceicle/fe_definitions.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/thread_utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <numbers>
+#include <vector>
+
+namespace iceicle {
+
+    /**
+     * @brief Laplacian artificial viscosity driven by the modal smoothness sensor
+     * of Persson and Peraire (2006)
+     *
+     * The sensor of each element is
+     *   S_e = log10( ||u - u_{p-1}||^2 / ||u||^2 )
+     * for one vector component of the solution, where u_{p-1} is the truncation
+     * to the Legendre modes of order p - 1 on the reference hypercube
+     * (so any basis can be used, the modes are found by quadrature).
+     * The element viscosity ramps from 0 to eps_max = eps0 * h / p
+     * over s0 - kappa < S_e < s0 + kappa, with s0 = s0_offset - 4 log10(p)
+     * and h the element volume to the power 1 / ndim.
+     *
+     * The element values are made C0 by taking the maximum over the elements around each node (cg_dof_map)
+     * and interpolating with the element transformation shape functions.
+     * update() tabulates the viscosity at the element and trace quadrature points
+     * so the residual and jacobian only look up the cached values.
+     * The viscosity is frozen between updates (so it is lagged in the jacobian).
+     *
+     * NOTE: simplex elements get no viscosity,
+     * and the nodal maximum is over the elements on this process
+     *
+     * @tparam T the real value type
+     * @tparam ndim the number of dimensions
+     */
+    template<class T, int ndim>
+    struct ArtificialViscosity {
+
+        using Point = MATH::GEOMETRY::Point<T, ndim>;
+
+        // ==============
+        // = Parameters =
+        // ==============
+
+        /// @brief the viscosity scale (velocity units), 0 disables the artificial viscosity
+        T eps0 = 0.0;
+
+        /// @brief the half width of the sensor ramp
+        T kappa = 1.0;
+
+        /// @brief shift of the sensor ramp center from -4 log10(p)
+        T s0_offset = 0.0;
+
+        /// @brief the vector component the sensor is computed for
+        int sensor_component = 0;
+
+        // =================
+        // = Cached Fields =
+        // =================
+
+        /// @brief the sensor of each element
+        std::vector<T> sensor{};
+
+        /// @brief the viscosity of each element
+        std::vector<T> el_viscosity{};
+
+        /// @brief the C0 viscosity at each mesh node
+        std::vector<T> node_viscosity{};
+
+        private:
+
+        /// @brief the start of the quadrature point values of each element and trace
+        std::vector<std::size_t> el_offsets{0}, trace_offsets{0};
+
+        /// @brief the viscosity at the element and trace quadrature points
+        std::vector<T> el_qp_viscosity{}, trace_qp_viscosity{};
+
+        public:
+
+        /// @brief if the viscosity has been computed and is used in the residual
+        [[nodiscard]] auto active() const noexcept -> bool
+        { return eps0 > 0.0 && el_offsets.size() > 1; }
+
+        /// @brief the viscosity at quadrature point iqp of element iel
+        [[nodiscard]] auto element_qp(std::size_t iel, int iqp) const noexcept -> T
+        { return el_qp_viscosity[el_offsets[iel] + iqp]; }
+
+        /// @brief the viscosity at quadrature point iqp of trace itrace
+        [[nodiscard]] auto trace_qp(std::size_t itrace, int iqp) const noexcept -> T
+        { return trace_qp_viscosity[trace_offsets[itrace] + iqp]; }
+
+        /**
+         * @brief the modal smoothness sensor of one element
+         * @param el the element
+         * @param u the solution
+         * @return S_e or the lowest value for order 0 or simplex elements
+         */
+        template<class IDX, class LayoutPolicy, class AccessorPolicy>
+        auto element_sensor(
+            const FiniteElement<T, IDX, ndim>& el,
+            fespan<T, LayoutPolicy, AccessorPolicy> u
+        ) const -> T {
+            int order = el.basis->getPolynomialOrder();
+            if(order == 0 || el.trans->domain_type != DOMAIN_TYPE::HYPERCUBE)
+                return std::numeric_limits<T>::lowest();
+
+            int nb1d = order + 1;
+            int nqp = el.nQP();
+
+            // weighted solution and 1D legendre polynomials at the quadrature points [iqp][idim][k]
+            std::vector<T> wu(nqp);
+            std::vector<T> leg(nqp * ndim * nb1d);
+            T e_total = 0;
+            for(int iqp = 0; iqp < nqp; ++iqp){
+                const QuadraturePoint<T, ndim> quadpt = el.getQP(iqp);
+                T uqp = 0;
+                for(int idof = 0; idof < el.nbasis(); ++idof)
+                    { uqp += u[el.elidx, idof, sensor_component] * el.basis_qp(iqp, idof); }
+                wu[iqp] = quadpt.weight * uqp;
+                e_total += wu[iqp] * uqp;
+                for(int idim = 0; idim < ndim; ++idim){
+                    T xi = quadpt.abscisse[idim];
+                    T* Pk = leg.data() + (iqp * ndim + idim) * nb1d;
+                    Pk[0] = 1.0;
+                    if(nb1d > 1) Pk[1] = xi;
+                    for(int k = 1; k + 1 < nb1d; ++k)
+                        { Pk[k + 1] = ((2 * k + 1) * xi * Pk[k] - k * Pk[k - 1]) / (k + 1); }
+                }
+            }
+            if(e_total <= 0.0) return std::numeric_limits<T>::lowest();
+
+            // energy in the modes with a 1D index of p in any direction
+            T e_top = 0;
+            int nmode = 1;
+            for(int idim = 0; idim < ndim; ++idim) nmode *= nb1d;
+            for(int imode = 0; imode < nmode; ++imode){
+                int ijk[ndim];
+                for(int idim = ndim - 1, rem = imode; idim >= 0; --idim){
+                    ijk[idim] = rem % nb1d;
+                    rem /= nb1d;
+                }
+                if(*std::max_element(ijk, ijk + ndim) != order) continue;
+
+                T coeff = 0, norm = 1;
+                for(int iqp = 0; iqp < nqp; ++iqp){
+                    T Lk = wu[iqp];
+                    for(int idim = 0; idim < ndim; ++idim)
+                        { Lk *= leg[(iqp * ndim + idim) * nb1d + ijk[idim]]; }
+                    coeff += Lk;
+                }
+                for(int idim = 0; idim < ndim; ++idim) norm *= 2.0 / (2 * ijk[idim] + 1);
+                e_top += coeff * coeff / norm;
+            }
+            return std::log10(std::max(e_top / e_total, std::numeric_limits<T>::min()));
+        }
+
+        /**
+         * @brief compute the sensor and viscosity for the current solution
+         * and tabulate it at the quadrature points
+         * call once per timestep or nonlinear iteration
+         *
+         * @param fespace the finite element space
+         * @param u the solution
+         */
+        template<class FESpaceT, class LayoutPolicy, class AccessorPolicy>
+        auto update(FESpaceT& fespace, fespan<T, LayoutPolicy, AccessorPolicy> u) -> void {
+            if(eps0 <= 0.0) return;
+            std::size_t nel = fespace.elements.size();
+            sensor.resize(nel);
+            el_viscosity.resize(nel);
+
+            // element sensor and viscosity
+            util::parallel_for(nel, [&](std::size_t iel){
+                const auto& el = fespace.elements[iel];
+                int order = el.basis->getPolynomialOrder();
+                sensor[iel] = element_sensor(el, u);
+                if(order == 0){
+                    el_viscosity[iel] = 0.0;
+                    return;
+                }
+                T vol = 0;
+                QPGeometry qp_geo{el};
+                for(int iqp = 0; iqp < el.nQP(); ++iqp) vol += qp_geo[iqp].dvol;
+                T h = std::pow(std::abs(vol), 1.0 / ndim);
+                T eps_max = eps0 * h / order;
+                T s0 = s0_offset - 4.0 * std::log10((T) order);
+                if(sensor[iel] < s0 - kappa) el_viscosity[iel] = 0.0;
+                else if(sensor[iel] > s0 + kappa) el_viscosity[iel] = eps_max;
+                else el_viscosity[iel] = 0.5 * eps_max
+                    * (1.0 + std::sin(std::numbers::pi_v<T> * (sensor[iel] - s0) / (2.0 * kappa)));
+            });
+
+            // C0 field: maximum at the nodes
+            const auto& cg_map = fespace.cg_map;
+            node_viscosity.assign(cg_map.size(), 0.0);
+            for(std::size_t iel = 0; iel < nel; ++iel){
+                for(std::size_t inode = 0; inode < cg_map.ndof_el(iel); ++inode){
+                    T& nu = node_viscosity[cg_map[iel, inode]];
+                    nu = std::max(nu, el_viscosity[iel]);
+                }
+            }
+
+            // tabulate at the quadrature points
+            el_offsets.assign(1, 0);
+            for(const auto& el : fespace.elements) el_offsets.push_back(el_offsets.back() + el.nQP());
+            trace_offsets.assign(1, 0);
+            for(const auto& trace : fespace.traces) trace_offsets.push_back(trace_offsets.back() + trace.nQP());
+            el_qp_viscosity.resize(el_offsets.back());
+            trace_qp_viscosity.resize(trace_offsets.back());
+
+            util::parallel_for(nel, [&](std::size_t iel){
+                const auto& el = fespace.elements[iel];
+                std::vector<Point> el_nu = element_node_values(el, cg_map);
+                for(int iqp = 0; iqp < el.nQP(); ++iqp){
+                    el_qp_viscosity[el_offsets[iel] + iqp] =
+                        el.trans->transform(el_nu, el.getQP(iqp).abscisse)[0];
+                }
+            });
+            util::parallel_for(fespace.traces.size(), [&](std::size_t itrace){
+                const auto& trace = fespace.traces[itrace];
+                std::vector<Point> el_nu = element_node_values(trace.elL, cg_map);
+                for(int iqp = 0; iqp < trace.nQP(); ++iqp){
+                    trace_qp_viscosity[trace_offsets[itrace] + iqp] =
+                        trace.elL.trans->transform(el_nu, trace.xiL_qp(iqp))[0];
+                }
+            });
+        }
+
+        private:
+
+        /// @brief the nodal viscosity of an element as the first coordinate of points
+        /// the transformation is linear in the node coordinates so transforming these points interpolates the viscosity
+        template<class IDX, class CGMapT>
+        auto element_node_values(const FiniteElement<T, IDX, ndim>& el, const CGMapT& cg_map) const
+        -> std::vector<Point> {
+            std::vector<Point> el_nu(el.trans->nnode);
+            for(int inode = 0; inode < el.trans->nnode; ++inode){
+                for(int idim = 0; idim < ndim; ++idim) el_nu[inode][idim] = 0.0;
+                el_nu[inode][0] = node_viscosity[cg_map[el.elidx, inode]];
+            }
+            return el_nu;
+        }
+    };
+}
@@ -3,6 +3,7 @@
 #pragma once
 #include "Numtool/tmp_flow_control.hpp"
 #include "iceicle/anomaly_log.hpp"
+#include "iceicle/lua_utils.hpp"
 #include <functional>
 #include <utility>
 #include <vector>
@@ -78,7 +79,14 @@ namespace iceicle {
             sol::table dirichlet_tbl = dirichlet_opt.value();
             for(int itbl = 1; itbl <= dirichlet_tbl.size(); ++itbl){
 
-                // check for value first
+                // check for compiled expressions of the coordinates first
+                // a string (for all equations) or a table of strings and values (one per equation)
+                if(auto expr_func = util::lua_get_expression_function<value_type>(dirichlet_tbl[itbl], neq, ndim)){
+                    disc.dirichlet_callbacks.push_back(expr_func.value());
+                    continue;
+                }
+
+                // check for value
                 // all equations get set to this value
                 sol::optional<value_type> dirichlet_val = dirichlet_tbl[itbl];
                 if(dirichlet_val){
@@ -168,7 +176,14 @@ namespace iceicle {
             sol::table neumann_tbl = neumann_opt.value();
             for(int itbl = 1; itbl <= neumann_tbl.size(); ++itbl){
 
-                // check for value first
+                // check for compiled expressions of the coordinates first
+                // a string (for all equations) or a table of strings and values (one per equation)
+                if(auto expr_func = util::lua_get_expression_function<value_type>(neumann_tbl[itbl], neq, ndim)){
+                    disc.neumann_callbacks.push_back(expr_func.value());
+                    continue;
+                }
+
+                // check for value
                 // all equations get set to this value
                 sol::optional<value_type> neumann_val = neumann_tbl[itbl];
                 if(neumann_val){
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include "iceicle/dual_number.hpp"
 #include "iceicle/linalg/linalg_utils.hpp"
 #include "Numtool/MathUtils.hpp"
 #include "Numtool/fixed_size_tensor.hpp"
@@ -57,27 +58,33 @@ namespace iceicle {
         /// @brief the number of dimensions
         static constexpr int ndim = _ndim;
 
+        /// @brief the floating point operations of one flux evaluation (see kernel_work.hpp)
+        static constexpr double flops_per_eval = 8.0 * ndim + 2.0;
+
         BurgersCoefficients<T, ndim>& coeffs;
 
         mutable T lambda_max = 0.0;
 
         /**
          * @brief compute the flux 
+         * @tparam U the state number type (T or a dual number of T) 
          * @param u the value of the solution
          * @param gradu the gradient of the solution 
          * @return the burgers flux function given the value and gradient of u 
          * F = au + 0.5*buu - mu * gradu
          */
+        template<class U>
         inline constexpr
         auto operator()(
-            std::array<T, nv_comp> u,
+            std::array<U, nv_comp> u,
             linalg::in_tensor auto gradu
-        ) const noexcept -> Tensor<T, nv_comp, ndim> 
+        ) const noexcept -> Tensor<U, nv_comp, ndim> 
         {
-            Tensor<T, nv_comp, ndim> flux{};
-            T lambda_norm = 0;
+            using std::sqrt;
+            Tensor<U, nv_comp, ndim> flux{};
+            U lambda_norm = 0;
             for(int idim = 0; idim < ndim; ++idim){
-                T lambda = 
+                U lambda = 
                     coeffs.a[idim]          // linear advection wavespeed
                     + 0.5 * coeffs.b[idim] * u[0];// nonlinear advection wavespeed
                 lambda_norm += lambda * lambda;
@@ -85,8 +92,33 @@ namespace iceicle {
                     lambda * u[0]                  // advection
                     - coeffs.mu * gradu[0, idim];  // diffusion
             }
-            lambda_norm = std::sqrt(lambda_norm);
-            lambda_max = std::max(lambda_max, lambda_norm);
+            lambda_norm = sqrt(lambda_norm);
+            lambda_max = std::max(lambda_max, (T) util::primal(lambda_norm));
+            return flux;
+        }
+
+        /**
+         * @brief the two point entropy conservative flux (for the entropy u^2 / 2) in a direction
+         * for flux differencing (without the diffusion)
+         * F# . n = sum_j n_j (a_j {u} + b_j (uL^2 + uL uR + uR^2) / 6)
+         *
+         * @param uL the first state 
+         * @param uR the second state 
+         * @param n the direction (not normalized)
+         * @return the two point flux in the direction n
+         */
+        inline constexpr
+        auto two_point_flux(
+            std::array<T, nv_comp> uL,
+            std::array<T, nv_comp> uR,
+            Tensor<T, ndim> n
+        ) const noexcept -> std::array<T, nv_comp> 
+        {
+            T u_avg = 0.5 * (uL[0] + uR[0]);
+            T uu_avg = (uL[0] * uL[0] + uL[0] * uR[0] + uR[0] * uR[0]) / 6.0;
+            std::array<T, nv_comp> flux{0};
+            for(int idim = 0; idim < ndim; ++idim)
+                { flux[0] += n[idim] * (coeffs.a[idim] * u_avg + coeffs.b[idim] * uu_avg); }
             return flux;
         }
 
@@ -106,6 +138,32 @@ namespace iceicle {
             aref = lambda_max;
             return (reference_length * cfl) / (coeffs.mu / reference_length + aref);
         }
+
+        /**
+         * @brief the maximum wavespeed at a state (the same wavespeed that is tracked by lambda_max)
+         * @param u the value of the solution
+         */
+        inline constexpr
+        auto wavespeed(std::array<T, nv_comp> u) const noexcept -> T {
+            T lambda_norm = 0;
+            for(int idim = 0; idim < ndim; ++idim){
+                T lambda = coeffs.a[idim] + 0.5 * coeffs.b[idim] * u[0];
+                lambda_norm += lambda * lambda;
+            }
+            return std::sqrt(lambda_norm);
+        }
+
+        /**
+         * @brief get the timestep from cfl for a given wavespeed (i.e the maximum over an element)
+         * @param cfl the cfl condition 
+         * @param reference_length the size to use for the length of the cfl condition 
+         * @param lambda the wavespeed
+         * @return the timestep based on the cfl condition
+         */
+        inline constexpr
+        auto dt_from_cfl(T cfl, T reference_length, T lambda) const noexcept -> T {
+            return (reference_length * cfl) / (coeffs.mu / reference_length + lambda);
+        }
     };
     template<class T, int ndim>
     BurgersFlux(BurgersCoefficients<T, ndim>) -> BurgersFlux<T, ndim>;
@@ -124,21 +182,26 @@ namespace iceicle {
         /// @brief the number of vector components
         static constexpr std::size_t nv_comp = 1;
 
+        /// @brief the floating point operations of one flux evaluation (see kernel_work.hpp)
+        static constexpr double flops_per_eval = 10.0 * ndim + 3.0;
+
         BurgersCoefficients<T, ndim>& coeffs;
 
         /**
          * @brief compute the convective numerical flux normal to the interface
          * F dot n
+         * @tparam U the state number type (T or a dual number of T) 
          * @param uL the value of the solution at interface for the left element
          * @param uR the value of the solution at interface for the right element
          * @return the upwind convective normal flux for burgers equation
          */
+        template<class U>
         inline constexpr
         auto operator()(
-            std::array<T, nv_comp> uL,
-            std::array<T, nv_comp> uR,
+            std::array<U, nv_comp> uL,
+            std::array<U, nv_comp> uR,
             Tensor<T, ndim> unit_normal
-        ) const noexcept -> std::array<T, nv_comp>
+        ) const noexcept -> std::array<U, nv_comp>
         {
 //            T lambdaL = 0;
 //            T lambdaR = 0;
@@ -151,15 +214,15 @@ namespace iceicle {
 //            T lambda_r_plus = 0.5 * (lambdaR - std::abs(lambdaR));
 //            T fadvn = uL[0] * lambda_l_plus + uR[0] * lambda_r_plus;
 //            return std::array<T, nv_comp>{fadvn};
-            T u_avg = 0.5 * (uL[0] + uR[0]);
-            T P = 0;
+            U u_avg = 0.5 * (uL[0] + uR[0]);
+            U P = 0;
             for(int idim = 0; idim < ndim; ++idim){
                 P += unit_normal[idim] * (coeffs.a[idim] + 0.5 * coeffs.b[idim] * u_avg);
             }
 
-            T u_upwind = (P > 0) ? uL[0] : uR[0];
+            U u_upwind = (P > 0) ? uL[0] : uR[0];
 
-            std::array<T, nv_comp> fadvn = {0};
+            std::array<U, nv_comp> fadvn = {0};
             for(int idim = 0; idim < ndim; ++idim){
                 fadvn[0] += unit_normal[idim] * (coeffs.a[idim] + 0.5 * coeffs.b[idim] * u_upwind);
             }
@@ -167,6 +230,41 @@ namespace iceicle {
 
             return fadvn;
         }
+
+        /**
+         * @brief compute the upwind normal flux at many points
+         * from structure of arrays data [component x point]
+         * the upwind choice is a select so the loop over points vectorizes
+         *
+         * @param uL the left states
+         * @param uR the right states
+         * @param unit_normals the unit normal vectors
+         * @param [out] fadvn the upwind convective normal fluxes
+         */
+        auto batch(
+            std::mdspan<const T, std::extents<int, nv_comp, std::dynamic_extent>> uL,
+            std::mdspan<const T, std::extents<int, nv_comp, std::dynamic_extent>> uR,
+            std::mdspan<const T, std::extents<int, ndim, std::dynamic_extent>> unit_normals,
+            std::mdspan<T, std::extents<int, nv_comp, std::dynamic_extent>> fadvn
+        ) const noexcept -> void
+        {
+            const int npoint = uL.extent(1);
+            for(int ipoint = 0; ipoint < npoint; ++ipoint){
+                T u_avg = 0.5 * (uL[0, ipoint] + uR[0, ipoint]);
+                T P = 0;
+                for(int idim = 0; idim < ndim; ++idim){
+                    P += unit_normals[idim, ipoint] * (coeffs.a[idim] + 0.5 * coeffs.b[idim] * u_avg);
+                }
+
+                T u_upwind = (P > 0) ? uL[0, ipoint] : uR[0, ipoint];
+
+                T f = 0;
+                for(int idim = 0; idim < ndim; ++idim){
+                    f += unit_normals[idim, ipoint] * (coeffs.a[idim] + 0.5 * coeffs.b[idim] * u_upwind);
+                }
+                fadvn[0, ipoint] = f * u_upwind;
+            }
+        }
     };
     template<class T, int ndim>
     BurgersUpwind(BurgersCoefficients<T, ndim>) -> BurgersUpwind<T, ndim>;
@@ -192,31 +290,36 @@ namespace iceicle {
         static constexpr 
         auto neq() -> std::size_t { return nv_comp; }
 
+        /// @brief the floating point operations of one flux evaluation (see kernel_work.hpp)
+        static constexpr double flops_per_eval = 3.0 * ndim;
+
         BurgersCoefficients<T, ndim>& coeffs;
 
 
         /**
          * @brief compute the diffusive flux normal to the interface
          * F dot n
+         * @tparam U the state number type (T or a dual number of T) 
          * @param u the single valued solution at the interface 
          * @param gradu the single valued gradient at the interface 
          * @param unit normal the unit normal
          * @return the diffusive normal flux for burgers equation
          */
+        template<class U>
         inline constexpr
         auto operator()(
-            std::array<T, nv_comp> u,
+            std::array<U, nv_comp> u,
             linalg::in_tensor auto gradu,
             Tensor<T, ndim> unit_normal
-        ) const noexcept -> std::array<T, nv_comp>
+        ) const noexcept -> std::array<U, nv_comp>
         {
             using namespace MATH::MATRIX_T;
             // calculate the flux weighted by the quadrature and face metric
-            T fvisc = 0;
+            U fvisc = 0;
             for(int idim = 0; idim < ndim; ++idim){
                 fvisc += coeffs.mu * gradu[0, idim] * unit_normal[idim];
             }
-            return std::array<T, nv_comp>{fvisc};
+            return std::array<U, nv_comp>{fvisc};
         }
 
         /// @brief compute the diffusive flux normal to the interface 
@@ -295,16 +398,17 @@ namespace iceicle {
          * F = u
          *
          */
+        template<class U>
         inline constexpr
         auto operator()(
-            std::array<T, nv_comp> u,
+            std::array<U, nv_comp> u,
             linalg::in_tensor auto gradu
-        ) const noexcept -> Tensor<T, nv_comp, ndim> 
+        ) const noexcept -> Tensor<U, nv_comp, ndim> 
         {
-            Tensor<T, nv_comp, ndim> flux{};
-            T lambda_norm = 0;
+            Tensor<U, nv_comp, ndim> flux{};
+            U lambda_norm = 0;
             for(int idim = 0; idim < ndim_space; ++idim){
-                T lambda = 
+                U lambda = 
                     coeffs.a[idim]          // linear advection wavespeed
                     + 0.5 * coeffs.b[idim] * u[0];// nonlinear advection wavespeed
                 lambda_norm += lambda * lambda;
@@ -314,7 +418,7 @@ namespace iceicle {
             }
             flux[0][idim_time] = u[0];
             lambda_norm += SQUARED(u[0]);
-            lambda_max = std::max(lambda_max, lambda_norm);
+            lambda_max = std::max(lambda_max, (T) util::primal(lambda_norm));
             return flux;
         }
 
@@ -366,26 +470,27 @@ namespace iceicle {
          * @param uR the value of the scalar solution at interface for the right element
          * @return the upwind convective normal flux for burgers equation
          */
+        template<class U>
         inline constexpr
         auto operator()(
-            std::array<T, nv_comp> uL,
-            std::array<T, nv_comp> uR,
+            std::array<U, nv_comp> uL,
+            std::array<U, nv_comp> uR,
             Tensor<T, ndim> unit_normal
-        ) const noexcept -> std::array<T, nv_comp> 
+        ) const noexcept -> std::array<U, nv_comp> 
         {
             // Dolejsi, Feistaur Discontinuous Galerkin Method pp. 121
             //
             // TODO: increase efficiency by computing p from lambdaL + lambdaR
-            T u_avg = 0.5 * (uL[0] + uR[0]);
-            T P = 0;
+            U u_avg = 0.5 * (uL[0] + uR[0]);
+            U P = 0;
             for(int idim = 0; idim < ndim_space; ++idim){
                 P += unit_normal[idim] * (coeffs.a[idim] + 0.5 * coeffs.b[idim] * u_avg);
             }
             P += unit_normal[idim_time];
 
-            T u_upwind = (P > 0) ? uL[0] : uR[0];
+            U u_upwind = (P > 0) ? uL[0] : uR[0];
 
-            std::array<T, nv_comp> fadvn = {0};
+            std::array<U, nv_comp> fadvn = {0};
             for(int idim = 0; idim < ndim_space; ++idim){
                 fadvn[0] += unit_normal[idim] * (coeffs.a[idim] + 0.5 * coeffs.b[idim] * u_upwind);
             }
@@ -444,20 +549,21 @@ namespace iceicle {
          * @param unit normal the unit normal
          * @return the diffusive normal flux for burgers equation
          */
+        template<class U>
         inline constexpr
         auto operator()(
-            std::array<T, nv_comp> u,
+            std::array<U, nv_comp> u,
             linalg::in_tensor auto gradu,
             Tensor<T, ndim> unit_normal
-        ) const noexcept -> std::array<T, nv_comp>
+        ) const noexcept -> std::array<U, nv_comp>
         {
             using namespace MATH::MATRIX_T;
             // calculate the flux weighted by the quadrature and face metric
-            T fvisc = 0;
+            U fvisc = 0;
             for(int idim = 0; idim < ndim_space; ++idim){
                 fvisc += coeffs.mu * gradu[0, idim] * unit_normal[idim];
             }
-            return std::array<T, nv_comp>{fvisc};
+            return std::array<U, nv_comp>{fvisc};
         }
 
         /// @brief compute the diffusive flux normal to the interface 
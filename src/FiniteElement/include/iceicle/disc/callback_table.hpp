@@ -0,0 +1,94 @@
+/// @brief tabulation of user callbacks at quadrature points
+/// @author Gianni Absillis (gabsill@ncsu.edu)
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace iceicle {
+
+    /**
+     * @brief memoizes a callback f(x, out) (i.e a Lua boundary condition or source term)
+     * at the quadrature points of a set of entities (elements or traces)
+     *
+     * The first evaluation at a quadrature point calls f and stores the point and the values,
+     * later evaluations at the same point reuse the values.
+     * If the point has moved (i.e the mesh nodes were moved by MDG) f is called again.
+     * Only valid for callbacks that depend on the position alone.
+     *
+     * Each entry is only written by the evaluation of its own entity,
+     * so entities may be evaluated concurrently
+     *
+     * @tparam T the real value type
+     * @tparam ndim the number of dimensions of the points
+     * @tparam nout the number of output values
+     */
+    template<class T, int ndim, int nout>
+    class callback_table {
+
+        /// @brief the start of the entries of each entity (size = nentity + 1)
+        std::vector<std::size_t> offsets{0};
+
+        /// @brief the points the values were evaluated at (npoint x ndim)
+        std::vector<T> points{};
+
+        /// @brief the tabulated values (npoint x nout)
+        std::vector<T> values{};
+
+        /// @brief if the entry has been evaluated
+        std::vector<unsigned char> valid{};
+
+        public:
+
+        /// @brief if the table has been sized (otherwise eval calls through)
+        [[nodiscard]] auto enabled() const noexcept -> bool { return offsets.size() > 1; }
+
+        /**
+         * @brief size the table for the given entities
+         * @param nqp the number of quadrature points of each entity
+         */
+        template<class R>
+        auto resize(const R& nqp) -> void {
+            offsets.assign(1, 0);
+            for(auto n : nqp) offsets.push_back(offsets.back() + n);
+            points.assign(offsets.back() * ndim, 0.0);
+            values.assign(offsets.back() * nout, 0.0);
+            valid.assign(offsets.back(), 0);
+        }
+
+        /// @brief remove all the entries (eval calls through)
+        auto clear() -> void {
+            offsets.assign(1, 0);
+            points.clear();
+            values.clear();
+            valid.clear();
+        }
+
+        /**
+         * @brief evaluate the callback at quadrature point iqp of entity ientity
+         * @param f the callback f(x, out)
+         * @param ientity the entity index
+         * @param iqp the quadrature point index in the entity
+         * @param x the physical point (size = ndim)
+         * @param [out] out the values (size = nout)
+         */
+        template<class F>
+        auto eval(F&& f, std::size_t ientity, std::size_t iqp, const T* x, T* out) -> void {
+            if(ientity + 1 >= offsets.size() || offsets[ientity] + iqp >= offsets[ientity + 1]) {
+                f(x, out);
+                return;
+            }
+            std::size_t ientry = offsets[ientity] + iqp;
+            T* point = points.data() + ientry * ndim;
+            T* value = values.data() + ientry * nout;
+            if(valid[ientry] && std::equal(x, x + ndim, point)) {
+                std::copy_n(value, nout, out);
+                return;
+            }
+            f(x, out);
+            std::copy_n(x, ndim, point);
+            std::copy_n(out, nout, value);
+            valid[ientry] = 1;
+        }
+    };
+}
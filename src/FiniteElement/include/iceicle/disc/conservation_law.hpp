@@ -2,12 +2,20 @@
 
 #include "Numtool/fixed_size_tensor.hpp"
 #include "Numtool/point.hpp"
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/bitset.hpp"
+#include "iceicle/disc/artificial_viscosity.hpp"
+#include "iceicle/disc/callback_table.hpp"
+#include "iceicle/dual_number.hpp"
 #include "iceicle/element/finite_element.hpp"
 #include "iceicle/fd_utils.hpp"
 #include "iceicle/fe_function/fespan.hpp"
 #include "iceicle/geometry/face.hpp"
 #include "iceicle/mesh/mesh.hpp"
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstddef>
 #include <limits>
 #include <string>
 #include <type_traits>
@@ -89,6 +97,217 @@ namespace iceicle {
                 NUMTOOL::TENSOR::FIXED_SIZE::Tensor<typename FluxT::value_type, FluxT::nv_comp, FluxT::ndim, FluxT::nv_comp, FluxT::ndim>>;
     };
 
+    /// @brief the physical flux can be evaluated with dual number states 
+    /// to compute exact flux jacobians with forward mode automatic differentiation
+    template<class FluxT, int nlane>
+    concept dual_physical_flux = requires(
+        FluxT flux,
+        std::array<util::Dual<typename FluxT::value_type, nlane>, FluxT::nv_comp> u,
+        std::mdspan<util::Dual<typename FluxT::value_type, nlane>, std::extents<int, FluxT::nv_comp, FluxT::ndim>> gradu
+    ) {
+        { flux(u, gradu) } -> std::same_as<NUMTOOL::TENSOR::FIXED_SIZE::Tensor<
+            util::Dual<typename FluxT::value_type, nlane>, FluxT::nv_comp, FluxT::ndim>>;
+    };
+
+    /// @brief the convective numerical flux can be evaluated with dual number states
+    template<class FluxT, int nlane>
+    concept dual_convective_numerical_flux = requires(
+        FluxT flux,
+        std::array<util::Dual<typename FluxT::value_type, nlane>, FluxT::nv_comp> uL,
+        std::array<util::Dual<typename FluxT::value_type, nlane>, FluxT::nv_comp> uR,
+        NUMTOOL::TENSOR::FIXED_SIZE::Tensor< typename FluxT::value_type, FluxT::ndim > unit_normal
+    ) {
+        { flux(uL, uR, unit_normal) } -> std::same_as<
+            std::array<util::Dual<typename FluxT::value_type, nlane>, FluxT::nv_comp>>;
+    };
+
+    /// @brief the diffusive flux can be evaluated with dual number states
+    template<class FluxT, int nlane>
+    concept dual_diffusion_flux = requires(
+        FluxT flux,
+        std::array<util::Dual<typename FluxT::value_type, nlane>, FluxT::nv_comp> u,
+        std::mdspan<util::Dual<typename FluxT::value_type, nlane>, std::extents<int, FluxT::nv_comp, FluxT::ndim>> gradu,
+        NUMTOOL::TENSOR::FIXED_SIZE::Tensor< typename FluxT::value_type, FluxT::ndim > unit_normal
+    ) {
+        { flux(u, gradu, unit_normal) } -> std::same_as<
+            std::array<util::Dual<typename FluxT::value_type, nlane>, FluxT::nv_comp>>;
+    };
+
+    /// @brief the physical flux declares which components each equation depends on:
+    /// bit jeq of component_coupling[ieq] is set if the flux of equation ieq 
+    /// depends on component jeq or its gradient
+    template<class FluxT>
+    concept coupled_physical_flux = requires {
+        { FluxT::component_coupling } -> std::convertible_to<
+            std::array<bitset<FluxT::nv_comp>, FluxT::nv_comp>>;
+    };
+
+    /// @brief the component coupling of the physical flux (dense if the flux does not declare one)
+    /// the jacobians of the physical flux skip the entries that are structurally zero
+    template<class FluxT>
+    inline constexpr std::array<bitset<FluxT::nv_comp>, FluxT::nv_comp> physical_flux_coupling = []()
+    -> std::array<bitset<FluxT::nv_comp>, FluxT::nv_comp> {
+        if constexpr (coupled_physical_flux<FluxT>) {
+            return FluxT::component_coupling;
+        } else {
+            std::array<bitset<FluxT::nv_comp>, FluxT::nv_comp> dense{};
+            for(bitset<FluxT::nv_comp>& row : dense) row = bitset<FluxT::nv_comp>{~0ull};
+            return dense;
+        }
+    }();
+
+    /// @brief structure of arrays view of quadrature point data [component x point]
+    template<class T, std::size_t ncomp>
+    using soa_span = std::mdspan<T, std::extents<int, ncomp, std::dynamic_extent>>;
+
+    /// @brief the convective numerical flux can be evaluated for many points at once
+    /// from structure of arrays data so that the loop over points can vectorize
+    template<class FluxT>
+    concept batched_convective_numerical_flux = requires(
+        const FluxT& flux,
+        soa_span<const typename FluxT::value_type, FluxT::nv_comp> uL,
+        soa_span<const typename FluxT::value_type, FluxT::nv_comp> uR,
+        soa_span<const typename FluxT::value_type, FluxT::ndim> unit_normals,
+        soa_span<typename FluxT::value_type, FluxT::nv_comp> fadvn
+    ) {
+        { flux.batch(uL, uR, unit_normals, fadvn) } -> std::same_as<void>;
+    };
+
+    /**
+     * @brief evaluate a convective numerical flux at a batch of points
+     * uses the batch() interface if the flux provides one and evaluates pointwise otherwise
+     *
+     * @param flux the convective numerical flux
+     * @param uL the left states [nv_comp x npoint]
+     * @param uR the right states [nv_comp x npoint]
+     * @param unit_normals the unit normal vectors [ndim x npoint]
+     * @param [out] fadvn the normal fluxes [nv_comp x npoint]
+     */
+    template<convective_numerical_flux CFlux>
+    inline constexpr
+    auto conv_nflux_batch(
+        const CFlux& flux,
+        soa_span<const typename CFlux::value_type, CFlux::nv_comp> uL,
+        soa_span<const typename CFlux::value_type, CFlux::nv_comp> uR,
+        soa_span<const typename CFlux::value_type, CFlux::ndim> unit_normals,
+        soa_span<typename CFlux::value_type, CFlux::nv_comp> fadvn
+    ) -> void {
+        using T = typename CFlux::value_type;
+        static constexpr int neq = CFlux::nv_comp;
+        static constexpr int ndim = CFlux::ndim;
+        if constexpr (batched_convective_numerical_flux<CFlux>) {
+            flux.batch(uL, uR, unit_normals, fadvn);
+        } else {
+            for(int ipoint = 0; ipoint < uL.extent(1); ++ipoint){
+                std::array<T, neq> uL_pt, uR_pt;
+                NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, ndim> unit_normal;
+                for(int ieq = 0; ieq < neq; ++ieq){
+                    uL_pt[ieq] = uL[ieq, ipoint];
+                    uR_pt[ieq] = uR[ieq, ipoint];
+                }
+                for(int idim = 0; idim < ndim; ++idim)
+                    unit_normal[idim] = unit_normals[idim, ipoint];
+                std::array<T, neq> fadvn_pt = flux(uL_pt, uR_pt, unit_normal);
+                for(int ieq = 0; ieq < neq; ++ieq)
+                    fadvn[ieq, ipoint] = fadvn_pt[ieq];
+            }
+        }
+    }
+
+    /// @brief the physical flux can be evaluated for many points at once 
+    /// from structure of arrays data so that the thermodynamic state (or similar) 
+    /// is computed once per point and the loop over points can vectorize
+    ///
+    /// flux.batch(u, gradu, flux_out) with gradients and fluxes [ieq * ndim + jdim x npoint]
+    /// returns the maximum wavespeed over the points
+    template<class FluxT>
+    concept batched_physical_flux = requires(
+        const FluxT& flux,
+        soa_span<const typename FluxT::value_type, FluxT::nv_comp> u,
+        soa_span<const typename FluxT::value_type, FluxT::nv_comp * FluxT::ndim> gradu,
+        soa_span<typename FluxT::value_type, FluxT::nv_comp * FluxT::ndim> flux_out
+    ) {
+        { flux.batch(u, gradu, flux_out) } -> std::convertible_to<typename FluxT::value_type>;
+    };
+
+    /// @brief the physical flux provides the maximum wavespeed at a state
+    /// and the timestep for a given wavespeed (for element local CFL timesteps)
+    template<class FluxT>
+    concept wavespeed_physical_flux = requires(
+        const FluxT& flux,
+        std::array<typename FluxT::value_type, FluxT::nv_comp> u,
+        typename FluxT::value_type scalar
+    ) {
+        { flux.wavespeed(u) } -> std::convertible_to<typename FluxT::value_type>;
+        { flux.dt_from_cfl(scalar, scalar, scalar) } -> std::convertible_to<typename FluxT::value_type>;
+    };
+
+    /// @brief the physical flux provides a symmetric two point flux F#(uL, uR) . n 
+    /// consistent with the inviscid flux (i.e entropy conservative) for flux differencing
+    template<class FluxT>
+    concept two_point_physical_flux = requires(
+        const FluxT& flux,
+        std::array<typename FluxT::value_type, FluxT::nv_comp> uL,
+        std::array<typename FluxT::value_type, FluxT::nv_comp> uR,
+        NUMTOOL::TENSOR::FIXED_SIZE::Tensor< typename FluxT::value_type, FluxT::ndim > direction
+    ) {
+        { flux.two_point_flux(uL, uR, direction) } -> std::same_as<std::array<typename FluxT::value_type, FluxT::nv_comp>>;
+    };
+
+    /// @brief the two point flux can be evaluated for many pairs of states at once
+    /// from structure of arrays data so that the loop over pairs can vectorize
+    template<class FluxT>
+    concept batched_two_point_physical_flux = requires(
+        const FluxT& flux,
+        soa_span<const typename FluxT::value_type, FluxT::nv_comp> uL,
+        soa_span<const typename FluxT::value_type, FluxT::nv_comp> uR,
+        soa_span<const typename FluxT::value_type, FluxT::ndim> directions,
+        soa_span<typename FluxT::value_type, FluxT::nv_comp> flux_out
+    ) {
+        { flux.two_point_flux_batch(uL, uR, directions, flux_out) } -> std::same_as<void>;
+    };
+
+    /**
+     * @brief evaluate a two point flux for a batch of pairs of states
+     * uses the two_point_flux_batch() interface if the flux provides one and evaluates pointwise otherwise
+     *
+     * @param flux the physical flux
+     * @param uL the first states [nv_comp x npoint]
+     * @param uR the second states [nv_comp x npoint]
+     * @param directions the directions [ndim x npoint]
+     * @param [out] flux_out the two point fluxes [nv_comp x npoint]
+     */
+    template<two_point_physical_flux PFlux>
+    inline constexpr
+    auto two_point_flux_batch(
+        const PFlux& flux,
+        soa_span<const typename PFlux::value_type, PFlux::nv_comp> uL,
+        soa_span<const typename PFlux::value_type, PFlux::nv_comp> uR,
+        soa_span<const typename PFlux::value_type, PFlux::ndim> directions,
+        soa_span<typename PFlux::value_type, PFlux::nv_comp> flux_out
+    ) -> void {
+        using T = typename PFlux::value_type;
+        static constexpr int neq = PFlux::nv_comp;
+        static constexpr int ndim = PFlux::ndim;
+        if constexpr (batched_two_point_physical_flux<PFlux>) {
+            flux.two_point_flux_batch(uL, uR, directions, flux_out);
+        } else {
+            for(int ipoint = 0; ipoint < uL.extent(1); ++ipoint){
+                std::array<T, neq> uL_pt, uR_pt;
+                NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, ndim> direction;
+                for(int ieq = 0; ieq < neq; ++ieq){
+                    uL_pt[ieq] = uL[ieq, ipoint];
+                    uR_pt[ieq] = uR[ieq, ipoint];
+                }
+                for(int idim = 0; idim < ndim; ++idim)
+                    direction[idim] = directions[idim, ipoint];
+                std::array<T, neq> f_pt = flux.two_point_flux(uL_pt, uR_pt, direction);
+                for(int ieq = 0; ieq < neq; ++ieq)
+                    flux_out[ieq, ipoint] = f_pt[ieq];
+            }
+        }
+    }
+
     template<
         typename T,
         int ndim,
@@ -142,6 +361,28 @@ namespace iceicle {
         /// Default: Standard DDG (sigma = 0)
         T sigma_ic = 0.0;
 
+        /// @brief the minimum number of 1D basis functions to use the sum factorized domain integral 
+        /// on tensor product elements (the full basis tables are cheaper at low order)
+        int sum_factorization_min_nbasis_1d = 4;
+
+        /// @brief use the entropy stable flux differencing domain integral 
+        /// on elements where the Lagrange basis is collocated with Gauss-Lobatto quadrature
+        /// (requires a physical flux with two_point_flux(), see domain_integral_flux_differencing)
+        bool flux_differencing = false;
+
+        /// @brief record the maximum wavespeed over the quadrature points of each element in element_wavespeeds
+        /// during the domain integral (requires a physical flux that satisfies wavespeed_physical_flux)
+        bool track_element_wavespeeds = false;
+
+        /// @brief the maximum wavespeed of each element from the last domain integral 
+        /// (indexed by element, only written if track_element_wavespeeds and large enough, 
+        /// each element is only touched by the thread computing its domain integral)
+        mutable std::vector<T> element_wavespeeds{};
+
+        /// @brief shock capturing artificial viscosity (disabled by default)
+        /// the viscosity is cached and only recomputed by update_cached_state()
+        ArtificialViscosity<T, ndim> artificial_viscosity;
+
         /// @brief dirichlet value for each bcflag index
         /// as a function callback 
         /// This function will take the physical domain point (size = ndim)
@@ -159,6 +400,10 @@ namespace iceicle {
         /// and outputs the source (size = neq) in the second argument
         std::optional< std::function<void(const T*, T*)> > user_source = std::nullopt;
 
+        /// @brief tabulated dirichlet, neumann, and source callback values at the quadrature points 
+        /// (keyed by trace and element index), see tabulate_callbacks()
+        callback_table<T, ndim, nv_comp> dirichlet_table, neumann_table, source_table;
+
         /// @brief utility for SPACETIME_PAST boundary condition
         ST_Info spacetime_info;
 
@@ -186,7 +431,7 @@ namespace iceicle {
          * @param diffusive_numflux the numerical flux for the diffusive portion
          *
          * @param spacetime_info is the class that defines the SPACETIME_PAST connection
-         * see iceicle::SpacetimeConnection
+         * see iceicle::SpacetimeSlabStream
          */
         constexpr ConservationLawDDG(
             PFlux&& physical_flux,
@@ -218,6 +463,43 @@ namespace iceicle {
             diff_flux{diffusive_flux} {}
 
 
+        /**
+         * @brief tabulate the dirichlet, neumann, and source callbacks at the quadrature points of fespace
+         * so each callback (i.e a Lua function) is only called once per quadrature point 
+         * instead of every residual evaluation.
+         * The values are stored on the first evaluation and recomputed at quadrature points that move
+         *
+         * NOTE: the callbacks must only depend on the position (time is a coordinate in spacetime)
+         * @param fespace the finite element space the residual is evaluated on
+         */
+        template<class FESpaceT>
+        auto tabulate_callbacks(FESpaceT& fespace) -> void {
+            std::vector<int> trace_nqp(fespace.traces.size(), 0);
+            for(const auto& trace : fespace.get_boundary_traces()) trace_nqp[trace.facidx] = trace.nQP();
+            dirichlet_table.resize(trace_nqp);
+            neumann_table.resize(trace_nqp);
+            if(user_source){
+                std::vector<int> el_nqp(fespace.elements.size());
+                for(const auto& el : fespace.elements) el_nqp[el.elidx] = el.nQP();
+                source_table.resize(el_nqp);
+            }
+        }
+
+        /**
+         * @brief recompute the solution dependent data that is cached between residual evaluations 
+         * (the artificial viscosity)
+         * called by the solvers once per timestep or nonlinear iteration
+         *
+         * @param fespace the finite element space 
+         * @param u the current solution
+         * @return true if any cached data was recomputed
+         */
+        template<class FESpaceT, class LayoutPolicy, class AccessorPolicy>
+        auto update_cached_state(FESpaceT& fespace, fespan<T, LayoutPolicy, AccessorPolicy> u) -> bool {
+            artificial_viscosity.update(fespace, u);
+            return artificial_viscosity.active();
+        }
+
         // ============================
         // = Discretization Interface =
         // ============================
@@ -237,150 +519,113 @@ namespace iceicle {
             return phys_flux.dt_from_cfl(cfl, reference_length);
         }
 
-        // =============
-        // = Integrals =
-        // =============
-
-        template<class IDX>
-        auto domain_integral(
-            const FiniteElement<T, IDX, ndim> &el,
-            elspan auto unkel,
-            elspan auto res
-        ) const -> void {
-            static constexpr int neq = decltype(unkel)::static_extent();
-            static_assert(neq == PFlux::nv_comp, "Number of equations must match.");
-            using namespace NUMTOOL::TENSOR::FIXED_SIZE;
-
-            // basis function scratch space
-            std::vector<T> dbdx_data(el.nbasis() * ndim);
-
-            // solution scratch space
-            std::array<T, neq> u;
-            std::array<T, neq * ndim> gradu_data;
-
-            // loop over the quadrature points
-            for(int iqp = 0; iqp < el.nQP(); ++iqp){
-                const QuadraturePoint<T, ndim> &quadpt = el.getQP(iqp);
-
-                // calculate the jacobian determinant 
-                auto J = el.jacobian(quadpt.abscisse);
-                T detJ = NUMTOOL::TENSOR::FIXED_SIZE::determinant(J);
-                // prevent duplicate contribution of overlapping range in transformation
-                // this occurs in concave elements
-                detJ = std::max((T) 0.0, detJ); 
-
-                // get the basis functions and gradients in the physical domain
-                auto bi = el.eval_basis_qp(iqp);
-                auto gradxBi = el.eval_phys_grad_basis(quadpt.abscisse, J,
-                        el.eval_grad_basis_qp(iqp), dbdx_data.data());
-
-                // construct the solution U at the quadrature point 
-                std::ranges::fill(u, 0.0);
-                for(int ibasis = 0; ibasis < el.nbasis(); ++ibasis){
-                    for(int ieq = 0; ieq < neq; ++ieq){
-                        u[ieq] += unkel[ibasis, ieq] * bi[ibasis];
-                    }
-                }
-
-                // construct the gradient of u 
-                auto gradu = unkel.contract_mdspan(gradxBi, gradu_data.data());
-
-                // compute the flux  and scatter to the residual
-                Tensor<T, neq, ndim> flux = phys_flux(u, gradu);
-
-                // loop over the test functions and construct the residual
-                for(int itest = 0; itest < el.nbasis(); ++itest){
-                    for(int ieq = 0; ieq < neq; ++ieq){
-                        for(int jdim = 0; jdim < ndim; ++jdim){
-                            res[itest, ieq] += flux[ieq][jdim] * gradxBi[itest, jdim] * detJ * quadpt.weight;
-                        }
-                    }
-                }
+        /**
+         * @brief get the timestep from cfl for a given wavespeed (i.e from element_wavespeeds)
+         * @param cfl the cfl condition 
+         * @param reference_length the size to use for the length of the cfl condition 
+         * @param wavespeed the wavespeed
+         * @return the timestep based on the cfl condition
+         */
+        T dt_from_cfl(T cfl, T reference_length, T wavespeed) requires wavespeed_physical_flux<PFlux> {
+            return phys_flux.dt_from_cfl(cfl, reference_length, wavespeed);
+        }
 
-                // if a source term has been defined, add it in
-                if(user_source){
-                    auto phys_pt = el.transform(quadpt.abscisse);
+        /// @brief if the element wavespeeds are recorded for element iel 
+        inline auto tracking_wavespeed(std::size_t iel) const noexcept -> bool {
+            if constexpr (wavespeed_physical_flux<PFlux>)
+                return track_element_wavespeeds && iel < element_wavespeeds.size();
+            else return false;
+        }
 
-                    auto& source_fcn = user_source.value();
-                    std::array<T, neq> source;
-                    source_fcn(phys_pt.data(), source.data());
-                    for(int itest = 0; itest < el.nbasis(); ++itest){
-                        for(int ieq = 0; ieq < neq; ++ieq) {
-                            res[itest, ieq] -= source[ieq] * bi[itest] * detJ * quadpt.weight;
-                        }
-                    }
-                }
+        /// @brief add the wavespeed at state u to the maximum for element iel (see track_element_wavespeeds)
+        template<std::size_t neq>
+        inline auto record_wavespeed(std::size_t iel, const std::array<T, neq>& u) const -> void {
+            if constexpr (wavespeed_physical_flux<PFlux>) {
+                if(tracking_wavespeed(iel))
+                    element_wavespeeds[iel] = std::max(element_wavespeeds[iel], (T) phys_flux.wavespeed(u));
             }
         }
 
-        template<class IDX>
-        auto domain_integral_jacobian(
-            const FiniteElement<T, IDX, ndim>& el,
-            elspan auto unkel,
-            linalg::out_matrix auto dfdu
-        ) {
-            static constexpr int neq = decltype(unkel)::static_extent();
-            static_assert(neq == PFlux::nv_comp, "Number of equations must match.");
-            using namespace NUMTOOL::TENSOR::FIXED_SIZE;
-            // basis function scratch space
-            std::vector<T> dbdx_data(el.nbasis() * ndim);
-
-            // solution scratch space
-            std::array<T, neq> u;
-            std::array<T, neq * ndim> gradu_data;
-
-            // get the degree of freedom layout for the element 
-            auto el_layout = unkel.get_layout();
-
-            // loop over the quadrature points
-            for(int iqp = 0; iqp < el.nQP(); ++iqp){
-                const QuadraturePoint<T, ndim> &quadpt = el.getQP(iqp);
-
-                // calculate the jacobian determinant 
-                auto J = el.jacobian(quadpt.abscisse);
-                T detJ = NUMTOOL::TENSOR::FIXED_SIZE::determinant(J);
-                // prevent duplicate contribution of overlapping range in transformation
-                // this occurs in concave elements
-                detJ = std::max((T) 0.0, detJ); 
+        /// @brief add a known wavespeed (i.e the maximum over a batch of points) 
+        /// to the maximum for element iel (see track_element_wavespeeds)
+        inline auto record_wavespeed_value(std::size_t iel, T lambda) const -> void {
+            if(tracking_wavespeed(iel))
+                element_wavespeeds[iel] = std::max(element_wavespeeds[iel], lambda);
+        }
 
-                // get the basis functions and gradients in the physical domain
-                auto bi = el.eval_basis_qp(iqp);
-                auto gradxBi = el.eval_phys_grad_basis(quadpt.abscisse, J,
-                        el.eval_grad_basis_qp(iqp), dbdx_data.data());
+        // ========================
+        // = Flux Linearizations  =
+        // ========================
 
-                // construct the solution U at the quadrature point 
-                std::ranges::fill(u, 0.0);
-                for(int ibasis = 0; ibasis < el.nbasis(); ++ibasis){
-                    for(int ieq = 0; ieq < neq; ++ieq){
-                        u[ieq] += unkel[ibasis, ieq] * bi[ibasis];
+        /**
+         * @brief compute the pointwise jacobian of the physical flux 
+         * with forward mode automatic differentiation if the flux supports dual numbers 
+         * otherwise with finite differences
+         *
+         * @param u the state
+         * @param gradu the state gradient 
+         * @param [out] dflux_du the jacobian wrt u [ieq, idim, jeq]
+         * @param [out] dflux_dgradu the jacobian wrt gradu [ieq, idim, jeq, jdim]
+         */
+        auto phys_flux_jacobian(
+            std::array<T, nv_comp> u,
+            linalg::in_tensor auto gradu,
+            NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, nv_comp, ndim, nv_comp>& dflux_du,
+            NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, nv_comp, ndim, nv_comp, ndim>& dflux_dgradu
+        ) const -> void {
+            using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+            static constexpr int neq = nv_comp;
+            static constexpr int nlane = neq * (ndim + 1);
+            if constexpr (dual_physical_flux<PFlux, nlane>) {
+                using Dual = util::Dual<T, nlane>;
+                // lanes: u then gradu (component major)
+                std::array<Dual, neq> u_d;
+                std::array<Dual, neq * ndim> gradu_d_data;
+                std::mdspan<Dual, std::extents<int, neq, ndim>> gradu_d{gradu_d_data.data()};
+                for(int jeq = 0; jeq < neq; ++jeq){
+                    u_d[jeq] = Dual{u[jeq], jeq};
+                    for(int jdim = 0; jdim < ndim; ++jdim)
+                        { gradu_d[jeq, jdim] = Dual{gradu[jeq, jdim], neq + jeq * ndim + jdim}; }
+                }
+                Tensor<Dual, neq, ndim> flux_d = phys_flux(u_d, gradu_d);
+                for(int ieq = 0; ieq < neq; ++ieq){
+                    for(int idim = 0; idim < ndim; ++idim){
+                        for(int jeq = 0; jeq < neq; ++jeq){
+                            dflux_du[ieq, idim, jeq] = flux_d[ieq][idim].grad[jeq];
+                            for(int jdim = 0; jdim < ndim; ++jdim){
+                                dflux_dgradu[ieq, idim, jeq, jdim] = 
+                                    flux_d[ieq][idim].grad[neq + jeq * ndim + jdim];
+                            }
+                        }
                     }
                 }
-
-                // construct the gradient of u 
-                auto gradu = unkel.contract_mdspan(gradxBi, gradu_data.data());
-
-                // compute the jacobian of the physical flux 
-                // with respect to field variables
-                // and gradients
+            } else {
                 Tensor<T, neq, ndim> flux = phys_flux(u, gradu);
                 T epsilon = scale_fd_epsilon(
                     std::sqrt(std::numeric_limits<T>::epsilon()),
                     frobenius(flux)
                 );
-
-                Tensor<T, neq, ndim, neq> dflux_du;
-                Tensor<T, neq, ndim, neq, ndim> dflux_dgradu;
+                // components no equation depends on are not perturbed
+                bitset<neq> dependent{};
+                for(const bitset<neq>& row : physical_flux_coupling<PFlux>) dependent |= row;
                 for(int jeq = 0; jeq < neq; ++jeq){
+                    if(!dependent[jeq]) {
+                        for(int ieq = 0; ieq < neq; ++ieq){
+                            for(int idim = 0; idim < ndim; ++idim){
+                                dflux_du[ieq, idim, jeq] = 0;
+                                for(int jdim = 0; jdim < ndim; ++jdim) dflux_dgradu[ieq, idim, jeq, jdim] = 0;
+                            }
+                        }
+                        continue;
+                    }
 
                     // peturb u
                     T u_old = u[jeq];
                     u[jeq] += epsilon;
                     Tensor<T, neq, ndim> flux_p = phys_flux(u, gradu);
-                    Tensor<T, neq, ndim> diff = (flux_p - flux) / epsilon;
                     for(int ieq = 0; ieq < neq; ++ieq){
                         for(int idim = 0; idim < ndim; ++idim){
-                            dflux_du[ieq, idim, jeq] =
-                                diff[ieq, idim];
+                            dflux_du[ieq, idim, jeq] = (flux_p[ieq][idim] - flux[ieq][idim]) / epsilon;
                         }
                     }
                     u[jeq] = u_old;
@@ -389,74 +634,1188 @@ namespace iceicle {
                     for(int jdim = 0; jdim < ndim; ++jdim){
                         T gradu_old = gradu[jeq, jdim];
                         gradu[jeq, jdim] += epsilon;
-                    
                         Tensor<T, neq, ndim> flux_p = phys_flux(u, gradu);
-                        Tensor<T, neq, ndim> diff = (flux_p - flux) / epsilon;
                         for(int ieq = 0; ieq < neq; ++ieq){
                             for(int idim = 0; idim < ndim; ++idim){
-                                dflux_dgradu[ieq, idim, jeq, jdim] =
-                                    diff[ieq, idim];
+                                dflux_dgradu[ieq, idim, jeq, jdim] = 
+                                    (flux_p[ieq][idim] - flux[ieq][idim]) / epsilon;
                             }
                         }
                         gradu[jeq, jdim] = gradu_old;
                     }
                 }
-                
-                // loop over the test functions and construct the jacobian
-                for(int itest = 0; itest < el.nbasis(); ++itest){
-                    for(int ieq = 0; ieq < neq; ++ieq){
-                        for(int idim = 0; idim < ndim; ++idim){
-                            for(int jdof = 0; jdof < el.nbasis(); ++jdof){
-                                for(int jeq = 0; jeq < neq; ++jeq){
-                                    // one-dimensional jacobian indices
-                                    auto ijac = el_layout[itest, ieq];
-                                    auto jjac = el_layout[jdof, jeq];
-                                    dfdu[ijac, jjac] += 
-                                        dflux_du[ieq, idim, jeq] * bi[jdof] 
-                                        * gradxBi[itest, idim] * detJ * quadpt.weight;
-                                    for(int jdim = 0; jdim < ndim; ++jdim){
-                                        dfdu[ijac, jjac] += 
-                                            dflux_dgradu[ieq, idim, jeq, jdim] * gradxBi[jdof, jdim] 
-                                            * gradxBi[itest, idim] * detJ * quadpt.weight;
-                                    }
-                                }
-                            }
-                        }
+            }
+        }
+
+        /**
+         * @brief compute the pointwise jacobian of the convective numerical flux
+         * with forward mode automatic differentiation if the flux supports dual numbers 
+         * otherwise with finite differences
+         *
+         * @param uL the left state
+         * @param uR the right state
+         * @param unit_normal the unit normal vector
+         * @param [out] dfadv_duL the jacobian wrt the left state [ieq, jeq]
+         * @param [out] dfadv_duR the jacobian wrt the right state [ieq, jeq]
+         */
+        auto conv_nflux_jacobian(
+            std::array<T, nv_comp> uL,
+            std::array<T, nv_comp> uR,
+            const NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, ndim>& unit_normal,
+            NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, nv_comp, nv_comp>& dfadv_duL,
+            NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, nv_comp, nv_comp>& dfadv_duR
+        ) const -> void {
+            static constexpr int neq = nv_comp;
+            static constexpr int nlane = 2 * neq;
+            if constexpr (dual_convective_numerical_flux<CFlux, nlane>) {
+                using Dual = util::Dual<T, nlane>;
+                // lanes: uL then uR
+                std::array<Dual, neq> uL_d, uR_d;
+                for(int jeq = 0; jeq < neq; ++jeq){
+                    uL_d[jeq] = Dual{uL[jeq], jeq};
+                    uR_d[jeq] = Dual{uR[jeq], neq + jeq};
+                }
+                std::array<Dual, neq> fadvn_d = conv_nflux(uL_d, uR_d, unit_normal);
+                for(int ieq = 0; ieq < neq; ++ieq){
+                    for(int jeq = 0; jeq < neq; ++jeq){
+                        dfadv_duL[ieq, jeq] = fadvn_d[ieq].grad[jeq];
+                        dfadv_duR[ieq, jeq] = fadvn_d[ieq].grad[neq + jeq];
                     }
                 }
-
-                // source has no dependence on U 
-                // therefore no contribution to 
-                // jacobian
+            } else {
+                std::array<T, neq> fadvn = conv_nflux(uL, uR, unit_normal);
+                T flux_norm = 0;
+                for(int ieq = 0; ieq < neq; ++ieq) flux_norm += fadvn[ieq] * fadvn[ieq];
+                T epsilon = scale_fd_epsilon(
+                    std::sqrt(std::numeric_limits<T>::epsilon()),
+                    std::sqrt(flux_norm)
+                );
+                for(int jeq = 0; jeq < neq; ++jeq){
+                    T u_old = uL[jeq];
+                    uL[jeq] += epsilon;
+                    std::array<T, neq> fadvn_p = conv_nflux(uL, uR, unit_normal);
+                    for(int ieq = 0; ieq < neq; ++ieq)
+                        { dfadv_duL[ieq, jeq] = (fadvn_p[ieq] - fadvn[ieq]) / epsilon; }
+                    uL[jeq] = u_old;
+
+                    u_old = uR[jeq];
+                    uR[jeq] += epsilon;
+                    fadvn_p = conv_nflux(uL, uR, unit_normal);
+                    for(int ieq = 0; ieq < neq; ++ieq)
+                        { dfadv_duR[ieq, jeq] = (fadvn_p[ieq] - fadvn[ieq]) / epsilon; }
+                    uR[jeq] = u_old;
+                }
             }
         }
 
-        template<class IDX, class ULayoutPolicy, class UAccessorPolicy, class ResLayoutPolicy>
-        void trace_integral(
-            const TraceSpace<T, IDX, ndim> &trace,
-            NodeArray<T, ndim> &coord,
-            dofspan<T, ULayoutPolicy, UAccessorPolicy> unkelL,
-            dofspan<T, ULayoutPolicy, UAccessorPolicy> unkelR,
-            dofspan<T, ResLayoutPolicy> resL,
-            dofspan<T, ResLayoutPolicy> resR
-        ) const requires ( 
-            elspan<decltype(unkelL)> && 
-            elspan<decltype(unkelR)> && 
-            elspan<decltype(resL)> && 
-            elspan<decltype(resL)>
-        ) {
+        /**
+         * @brief compute the pointwise jacobian of the diffusive normal flux
+         * with forward mode automatic differentiation if the flux supports dual numbers 
+         * otherwise with finite differences
+         *
+         * @param u the single valued state 
+         * @param gradu the single valued gradient
+         * @param unit_normal the unit normal vector
+         * @param [out] dfvisc_du the jacobian wrt the state [ieq, jeq]
+         * @param [out] dfvisc_dgrad the jacobian wrt the gradient [ieq, jeq, jdim]
+         */
+        auto diff_flux_jacobian(
+            std::array<T, nv_comp> u,
+            linalg::in_tensor auto gradu,
+            const NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, ndim>& unit_normal,
+            NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, nv_comp, nv_comp>& dfvisc_du,
+            NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, nv_comp, nv_comp, ndim>& dfvisc_dgrad
+        ) const -> void {
             static constexpr int neq = nv_comp;
-            static_assert(neq == decltype(unkelL)::static_extent(), "Number of equations must match.");
-            static_assert(neq == decltype(unkelR)::static_extent(), "Number of equations must match.");
-            using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+            static constexpr int nlane = neq * (ndim + 1);
+            if constexpr (dual_diffusion_flux<DiffusiveFlux, nlane>) {
+                using Dual = util::Dual<T, nlane>;
+                // lanes: u then gradu (component major)
+                std::array<Dual, neq> u_d;
+                std::array<Dual, neq * ndim> gradu_d_data;
+                std::mdspan<Dual, std::extents<int, neq, ndim>> gradu_d{gradu_d_data.data()};
+                for(int jeq = 0; jeq < neq; ++jeq){
+                    u_d[jeq] = Dual{u[jeq], jeq};
+                    for(int jdim = 0; jdim < ndim; ++jdim)
+                        { gradu_d[jeq, jdim] = Dual{gradu[jeq, jdim], neq + jeq * ndim + jdim}; }
+                }
+                std::array<Dual, neq> fviscn_d = diff_flux(u_d, gradu_d, unit_normal);
+                for(int ieq = 0; ieq < neq; ++ieq){
+                    for(int jeq = 0; jeq < neq; ++jeq){
+                        dfvisc_du[ieq, jeq] = fviscn_d[ieq].grad[jeq];
+                        for(int jdim = 0; jdim < ndim; ++jdim)
+                            { dfvisc_dgrad[ieq, jeq, jdim] = fviscn_d[ieq].grad[neq + jeq * ndim + jdim]; }
+                    }
+                }
+            } else {
+                std::array<T, neq> fviscn = diff_flux(u, gradu, unit_normal);
+                T flux_norm = 0;
+                for(int ieq = 0; ieq < neq; ++ieq) flux_norm += fviscn[ieq] * fviscn[ieq];
+                T epsilon = scale_fd_epsilon(
+                    std::sqrt(std::numeric_limits<T>::epsilon()),
+                    std::sqrt(flux_norm)
+                );
+                for(int jeq = 0; jeq < neq; ++jeq){
+                    T u_old = u[jeq];
+                    u[jeq] += epsilon;
+                    std::array<T, neq> fviscn_p = diff_flux(u, gradu, unit_normal);
+                    for(int ieq = 0; ieq < neq; ++ieq)
+                        { dfvisc_du[ieq, jeq] = (fviscn_p[ieq] - fviscn[ieq]) / epsilon; }
+                    u[jeq] = u_old;
+
+                    for(int jdim = 0; jdim < ndim; ++jdim){
+                        T grad_old = gradu[jeq, jdim];
+                        gradu[jeq, jdim] += epsilon;
+                        fviscn_p = diff_flux(u, gradu, unit_normal);
+                        for(int ieq = 0; ieq < neq; ++ieq)
+                            { dfvisc_dgrad[ieq, jeq, jdim] = (fviscn_p[ieq] - fviscn[ieq]) / epsilon; }
+                        gradu[jeq, jdim] = grad_old;
+                    }
+                }
+            }
+        }
+
+        // =============
+        // = Integrals =
+        // =============
+
+        /**
+         * @brief the domain integral by sum factorization on tensor product elements
+         * The solution and reference gradients at the quadrature points are found with 
+         * successive 1D contractions, the flux is pulled back to the reference domain 
+         * at each quadrature point, and the test function loop is the transposed contraction
+         *
+         * @param sf the 1D tables (SumFactorization or FixedExtentSumFactorization for compile time extents)
+         */
+        template<class IDX, class SumFactT, class TransT = void>
+        auto domain_integral_sum_factorized(
+            const FiniteElement<T, IDX, ndim> &el,
+            const SumFactT& sf,
+            elspan auto unkel,
+            elspan auto res,
+            std::type_identity<TransT> = {}
+        ) const -> void {
+            static constexpr int neq = decltype(unkel)::static_extent();
+            using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+
+            const int nbasis = sf.nbasis();
+            const int nqp = sf.nqp();
+
+            // storage layout: coefficients [ieq][ibasis], values [ieq][iqp]
+            // reference gradients and pulled back fluxes [ieq][idim][iqp]
+            std::vector<T> coeff(neq * nbasis);
+            std::vector<T> uqp(neq * nqp);
+            std::vector<T> grad_ref(neq * ndim * nqp);
+            std::vector<T> resl(neq * nbasis, 0.0);
+            std::vector<T> scratch(sf.scratch_size() + nbasis);
+
+            for(int ibasis = 0; ibasis < nbasis; ++ibasis){
+                for(int ieq = 0; ieq < neq; ++ieq)
+                    { coeff[ieq * nbasis + ibasis] = unkel[ibasis, ieq]; }
+            }
+
+            // interpolate the solution and reference gradients to the quadrature points
+            for(int ieq = 0; ieq < neq; ++ieq){
+                sf.apply(-1, coeff.data() + ieq * nbasis, uqp.data() + ieq * nqp, scratch.data());
+                for(int idim = 0; idim < ndim; ++idim){
+                    sf.apply(idim, coeff.data() + ieq * nbasis,
+                        grad_ref.data() + (ieq * ndim + idim) * nqp, scratch.data());
+                }
+            }
+
+            // the source term weighted at each quadrature point
+            std::vector<T> source_qp{};
+            if(user_source) source_qp.resize(neq * nqp);
+
+            // the pulled back fluxes overwrite the reference gradients 
+            // once they have been used at a quadrature point
+            std::array<T, neq> u;
+            std::array<T, neq * ndim> gradu_data;
+            std::mdspan<T, std::extents<int, neq, ndim>> gradu{gradu_data.data()};
+            QPGeometry<T, IDX, ndim, TransT> qp_geo{el};
+
+            // physical gradient: du/dx_j = du/dxi_k J^{-1}_{kj}
+            auto phys_gradient = [&](int iqp, const auto& Jinv){
+                for(int ieq = 0; ieq < neq; ++ieq){
+                    u[ieq] = uqp[ieq * nqp + iqp];
+                    for(int jdim = 0; jdim < ndim; ++jdim){
+                        T sum = 0;
+                        for(int kdim = 0; kdim < ndim; ++kdim)
+                            { sum += grad_ref[(ieq * ndim + kdim) * nqp + iqp] * Jinv[kdim][jdim]; }
+                        gradu[ieq, jdim] = sum;
+                    }
+                }
+            };
+
+            // batched physical fluxes: the fluxes of all the quadrature points in one call [ieq * ndim + jdim][iqp]
+            std::vector<T> flux_qp{};
+            if constexpr (batched_physical_flux<PFlux> && neq == PFlux::nv_comp) {
+                std::vector<T> gradu_qp(neq * ndim * nqp);
+                flux_qp.resize(neq * ndim * nqp);
+                for(int iqp = 0; iqp < nqp; ++iqp){
+                    phys_gradient(iqp, qp_geo[iqp].Jinv);
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        for(int jdim = 0; jdim < ndim; ++jdim)
+                            { gradu_qp[(ieq * ndim + jdim) * nqp + iqp] = gradu[ieq, jdim]; }
+                    }
+                }
+                T lambda = phys_flux.batch(
+                    soa_span<const T, neq>{uqp.data(), nqp},
+                    soa_span<const T, neq * ndim>{gradu_qp.data(), nqp},
+                    soa_span<T, neq * ndim>{flux_qp.data(), nqp});
+                record_wavespeed_value(el.elidx, lambda);
+            }
+
+            for(int iqp = 0; iqp < nqp; ++iqp){
+                // inverse jacobian and integration measure (cached, affine, or computed)
+                auto [Jinv, dvol] = qp_geo[iqp];
+
+                Tensor<T, neq, ndim> flux;
+                if constexpr (batched_physical_flux<PFlux> && neq == PFlux::nv_comp) {
+                    if(artificial_viscosity.active()) phys_gradient(iqp, Jinv);
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        for(int jdim = 0; jdim < ndim; ++jdim)
+                            { flux[ieq][jdim] = flux_qp[(ieq * ndim + jdim) * nqp + iqp]; }
+                    }
+                } else {
+                    phys_gradient(iqp, Jinv);
+                    flux = phys_flux(u, gradu);
+                    record_wavespeed(el.elidx, u);
+                }
+                if(artificial_viscosity.active()){
+                    T eps = artificial_viscosity.element_qp(el.elidx, iqp);
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        for(int jdim = 0; jdim < ndim; ++jdim) flux[ieq][jdim] -= eps * gradu[ieq, jdim];
+                    }
+                }
+
+                // pull back: G_k = J^{-1}_{kj} F_j dvol
+                for(int ieq = 0; ieq < neq; ++ieq){
+                    for(int kdim = 0; kdim < ndim; ++kdim){
+                        T sum = 0;
+                        for(int jdim = 0; jdim < ndim; ++jdim)
+                            { sum += Jinv[kdim][jdim] * flux[ieq][jdim]; }
+                        grad_ref[(ieq * ndim + kdim) * nqp + iqp] = sum * dvol;
+                    }
+                }
+
+                if(user_source){
+                    auto phys_pt = qp_geo.phys_pt(iqp);
+                    auto& source_fcn = user_source.value();
+                    std::array<T, neq> source;
+                    source_table.eval(source_fcn, el.elidx, iqp, phys_pt.data(), source.data());
+                    for(int ieq = 0; ieq < neq; ++ieq)
+                        { source_qp[ieq * nqp + iqp] = -source[ieq] * dvol; }
+                }
+            }
+
+            // test function loop as transposed contractions
+            for(int ieq = 0; ieq < neq; ++ieq){
+                for(int idim = 0; idim < ndim; ++idim){
+                    sf.apply_transpose(idim, grad_ref.data() + (ieq * ndim + idim) * nqp,
+                        resl.data() + ieq * nbasis, scratch.data());
+                }
+                if(user_source){
+                    sf.apply_transpose(-1, source_qp.data() + ieq * nqp,
+                        resl.data() + ieq * nbasis, scratch.data());
+                }
+            }
+
+            for(int ibasis = 0; ibasis < nbasis; ++ibasis){
+                for(int ieq = 0; ieq < neq; ++ieq)
+                    { res[ibasis, ieq] += resl[ieq * nbasis + ibasis]; }
+            }
+        }
+
+        /**
+         * @brief the entropy stable flux differencing domain integral (DG-SEM) 
+         * on tensor product elements where the Lagrange basis is collocated 
+         * with the Gauss-Lobatto quadrature points (SumFactorization::collocated())
+         *
+         * With the 1D differentiation matrix D (deriv_1d), the weight W_i of node i,
+         * and the contravariant metric terms Ja^k_i = det(J) J^{-1}_{k:} at node i,
+         * the inviscid part is the weak form rewritten with the summation by parts property of D
+         * and the two point flux F# in the volume terms
+         *
+         *   res_i = sum_k B^k_i W^k_i Ja^k_i . F(u_i)
+         *         - W_i sum_k sum_m 2 D_{i m} F#(u_i, u_m) . (Ja^k_i + Ja^k_m) / 2
+         *
+         * where m are the nodes on the line through i in direction k,
+         * B^k_i is -1 at the first and 1 at the last node of the line (0 otherwise),
+         * and W^k_i is the product of the weights in the other directions.
+         * For the central flux F# = (F(uL) + F(uR)) / 2 on affine elements this is the standard domain integral.
+         *
+         * F# is symmetric so each pair of nodes on a line is evaluated once
+         * and the pairs of all the lines in a direction are one structure of arrays batch (two_point_flux_batch).
+         * The viscous part F(u, grad u) - F(u, 0), the artificial viscosity, and the source use the weak form.
+         *
+         * NOTE: the jacobian is of the standard domain integral
+         */
+        template<class IDX, class TransT = void>
+        auto domain_integral_flux_differencing(
+            const FiniteElement<T, IDX, ndim> &el,
+            const SumFactorization<T, ndim>& sf,
+            elspan auto unkel,
+            elspan auto res,
+            std::type_identity<TransT> = {}
+        ) const -> void {
+            static constexpr int neq = decltype(unkel)::static_extent();
+            using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+
+            const int n1d = sf.nbasis_1d;
+            const int nnode = sf.nbasis();
+            const T* D = sf.deriv_1d.data();
+
+            // storage layout: node values [ieq][inode], reference gradients and pulled back viscous fluxes 
+            // [ieq][kdim][inode], metric terms [kdim][jdim][inode]
+            std::vector<T> unode(neq * nnode);
+            std::vector<T> grad_ref(neq * ndim * nnode);
+            std::vector<T> metric(ndim * ndim * nnode);
+            std::vector<T> wnode(nnode);
+            std::vector<T> resl(neq * nnode, 0.0);
+            std::vector<T> scratch(sf.scratch_size() + nnode);
+
+            for(int inode = 0; inode < nnode; ++inode){
+                for(int ieq = 0; ieq < neq; ++ieq)
+                    { unode[ieq * nnode + inode] = unkel[inode, ieq]; }
+            }
+            for(int ieq = 0; ieq < neq; ++ieq){
+                for(int idim = 0; idim < ndim; ++idim){
+                    sf.apply(idim, unode.data() + ieq * nnode,
+                        grad_ref.data() + (ieq * ndim + idim) * nnode, scratch.data());
+                }
+            }
+
+            // pointwise terms: surface terms of the SBP operator, viscous fluxes, and source
+            bool viscous = false;
+            std::array<T, neq> u;
+            std::array<T, neq * ndim> gradu_data, gradu_zero_data{};
+            std::mdspan<T, std::extents<int, neq, ndim>> gradu{gradu_data.data()};
+            std::mdspan<T, std::extents<int, neq, ndim>> gradu_zero{gradu_zero_data.data()};
+            QPGeometry<T, IDX, ndim, TransT> qp_geo{el};
+            for(int inode = 0; inode < nnode; ++inode){
+                auto [Jinv, dvol] = qp_geo[inode];
+                wnode[inode] = el.getQP(inode).weight;
+                T detJ = dvol / wnode[inode];
+                for(int kdim = 0; kdim < ndim; ++kdim){
+                    for(int jdim = 0; jdim < ndim; ++jdim)
+                        { metric[(kdim * ndim + jdim) * nnode + inode] = detJ * Jinv[kdim][jdim]; }
+                }
+
+                for(int ieq = 0; ieq < neq; ++ieq){
+                    u[ieq] = unode[ieq * nnode + inode];
+                    for(int jdim = 0; jdim < ndim; ++jdim){
+                        T sum = 0;
+                        for(int kdim = 0; kdim < ndim; ++kdim)
+                            { sum += grad_ref[(ieq * ndim + kdim) * nnode + inode] * Jinv[kdim][jdim]; }
+                        gradu[ieq, jdim] = sum;
+                    }
+                }
+
+                Tensor<T, neq, ndim> flux_inviscid = phys_flux(u, gradu_zero);
+                record_wavespeed(el.elidx, u);
+                Tensor<T, neq, ndim> flux_viscous = phys_flux(u, gradu);
+                for(int ieq = 0; ieq < neq; ++ieq){
+                    for(int jdim = 0; jdim < ndim; ++jdim) flux_viscous[ieq][jdim] -= flux_inviscid[ieq][jdim];
+                }
+                if(artificial_viscosity.active()){
+                    T eps = artificial_viscosity.element_qp(el.elidx, inode);
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        for(int jdim = 0; jdim < ndim; ++jdim) flux_viscous[ieq][jdim] -= eps * gradu[ieq, jdim];
+                    }
+                }
+
+                // the 1D indices of the node (first dimension slowest)
+                int ijk[ndim];
+                for(int idim = ndim - 1, rem = inode; idim >= 0; --idim){
+                    ijk[idim] = rem % n1d;
+                    rem /= n1d;
+                }
+
+                for(int kdim = 0; kdim < ndim; ++kdim){
+                    // SBP boundary matrix B^k and the m = i term of the two point sum (F#(u, u) = F(u))
+                    int i1d = ijk[kdim];
+                    T sign = (i1d == n1d - 1) ? 1.0 : ((i1d == 0) ? -1.0 : 0.0);
+                    T wk = sign * wnode[inode] / sf.weights_1d[i1d] - 2.0 * wnode[inode] * D[i1d * n1d + i1d];
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        T fk = 0, gk = 0;
+                        for(int jdim = 0; jdim < ndim; ++jdim){
+                            fk += metric[(kdim * ndim + jdim) * nnode + inode] * flux_inviscid[ieq][jdim];
+                            gk += Jinv[kdim][jdim] * flux_viscous[ieq][jdim];
+                        }
+                        resl[ieq * nnode + inode] += wk * fk;
+
+                        // pull back the viscous flux (overwrites the used reference gradient)
+                        grad_ref[(ieq * ndim + kdim) * nnode + inode] = gk * dvol;
+                        viscous = viscous || (gk != 0.0);
+                    }
+                }
+
+                // the test functions are collocated 
+                if(user_source){
+                    auto phys_pt = qp_geo.phys_pt(inode);
+                    auto& source_fcn = user_source.value();
+                    std::array<T, neq> source;
+                    source_table.eval(source_fcn, el.elidx, inode, phys_pt.data(), source.data());
+                    for(int ieq = 0; ieq < neq; ++ieq)
+                        { resl[ieq * nnode + inode] -= source[ieq] * dvol; }
+                }
+            }
+
+            // two point fluxes: each pair a < b on every line in a direction
+            const int nline = nnode / n1d;
+            const int npair = nline * n1d * (n1d - 1) / 2;
+            std::vector<T> uL_data(neq * npair), uR_data(neq * npair), dir_data(ndim * npair), f_data(neq * npair);
+            std::vector<int> pair_nodes(2 * npair), pair_1d(2 * npair);
+            soa_span<T, neq> uL{uL_data.data(), npair}, uR{uR_data.data(), npair}, f{f_data.data(), npair};
+            soa_span<T, ndim> dir{dir_data.data(), npair};
+            for(int kdim = 0; kdim < ndim; ++kdim){
+                int stride = 1;
+                for(int idim = kdim + 1; idim < ndim; ++idim) stride *= n1d;
+
+                int ipair = 0;
+                for(int iline = 0; iline < nline; ++iline){
+                    // the first node of the line
+                    int base = (iline / stride) * n1d * stride + iline % stride;
+                    for(int a = 0; a < n1d; ++a){
+                        for(int b = a + 1; b < n1d; ++b, ++ipair){
+                            int inodeL = base + a * stride, inodeR = base + b * stride;
+                            pair_nodes[2 * ipair] = inodeL;
+                            pair_nodes[2 * ipair + 1] = inodeR;
+                            pair_1d[2 * ipair] = a;
+                            pair_1d[2 * ipair + 1] = b;
+                            for(int ieq = 0; ieq < neq; ++ieq){
+                                uL[ieq, ipair] = unode[ieq * nnode + inodeL];
+                                uR[ieq, ipair] = unode[ieq * nnode + inodeR];
+                            }
+                            for(int jdim = 0; jdim < ndim; ++jdim){
+                                const T* Ja = metric.data() + (kdim * ndim + jdim) * nnode;
+                                dir[jdim, ipair] = 0.5 * (Ja[inodeL] + Ja[inodeR]);
+                            }
+                        }
+                    }
+                }
+
+                two_point_flux_batch(phys_flux, 
+                    soa_span<const T, neq>{uL_data.data(), npair},
+                    soa_span<const T, neq>{uR_data.data(), npair},
+                    soa_span<const T, ndim>{dir_data.data(), npair}, f);
+
+                for(ipair = 0; ipair < npair; ++ipair){
+                    int inodeL = pair_nodes[2 * ipair], inodeR = pair_nodes[2 * ipair + 1];
+                    int a = pair_1d[2 * ipair], b = pair_1d[2 * ipair + 1];
+                    T coeffL = 2.0 * wnode[inodeL] * D[a * n1d + b];
+                    T coeffR = 2.0 * wnode[inodeR] * D[b * n1d + a];
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        resl[ieq * nnode + inodeL] -= coeffL * f[ieq, ipair];
+                        resl[ieq * nnode + inodeR] -= coeffR * f[ieq, ipair];
+                    }
+                }
+            }
+
+            // viscous test function loop as transposed contractions
+            if(viscous){
+                for(int ieq = 0; ieq < neq; ++ieq){
+                    for(int kdim = 0; kdim < ndim; ++kdim){
+                        sf.apply_transpose(kdim, grad_ref.data() + (ieq * ndim + kdim) * nnode,
+                            resl.data() + ieq * nnode, scratch.data());
+                    }
+                }
+            }
+
+            for(int inode = 0; inode < nnode; ++inode){
+                for(int ieq = 0; ieq < neq; ++ieq)
+                    { res[inode, ieq] += resl[ieq * nnode + inode]; }
+            }
+        }
+
+        /**
+         * @brief the domain integral with compile time numbers of basis functions and quadrature points
+         * (the elements of a batch in the kernel registry, see dispatch_fixed_element_sizes)
+         *
+         * Same as the generic domain integral, but the element solution and residual 
+         * are copied to fixed size arrays so every loop has a compile time trip count
+         * and the solution and gradient at a quadrature point are accumulated in registers
+         *
+         * @tparam SizesT the fixed_element_sizes (must match el.nbasis() and el.nQP())
+         */
+        template<class SizesT, class IDX, class TransT = void>
+        auto domain_integral_fixed(
+            const FiniteElement<T, IDX, ndim> &el,
+            elspan auto unkel,
+            elspan auto res,
+            std::type_identity<TransT> = {}
+        ) const -> void {
+            static constexpr int neq = decltype(unkel)::static_extent();
+            static constexpr int nbasis = SizesT::nbasis;
+            static constexpr int nqp = SizesT::nqp;
+            using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+
+            // storage layout: coefficients and residual [ibasis][ieq], physical gradients [ibasis][idim]
+            std::array<T, nbasis * neq> coeff;
+            std::array<T, nbasis * neq> resl{};
+            std::array<T, nbasis * ndim> gradx;
+            for(int ibasis = 0; ibasis < nbasis; ++ibasis){
+                for(int ieq = 0; ieq < neq; ++ieq)
+                    { coeff[ibasis * neq + ieq] = unkel[ibasis, ieq]; }
+            }
+
+            std::array<T, neq> u;
+            std::array<T, neq * ndim> gradu_data;
+            std::mdspan<T, std::extents<int, neq, ndim>> gradu{gradu_data.data()};
+            QPGeometry<T, IDX, ndim, TransT> qp_geo{el};
+            for(int iqp = 0; iqp < nqp; ++iqp){
+                // inverse jacobian and integration measure (cached, affine, or computed)
+                auto [Jinv, dvol] = qp_geo[iqp];
+                auto bi = el.eval_basis_qp(iqp);
+                auto grad_ref = el.eval_grad_basis_qp(iqp);
+
+                // physical gradients of the basis functions: dB/dx_j = dB/dxi_k J^{-1}_{kj}
+                for(int ibasis = 0; ibasis < nbasis; ++ibasis){
+                    for(int jdim = 0; jdim < ndim; ++jdim){
+                        T sum = 0;
+                        for(int kdim = 0; kdim < ndim; ++kdim) sum += grad_ref[ibasis, kdim] * Jinv[kdim][jdim];
+                        gradx[ibasis * ndim + jdim] = sum;
+                    }
+                }
+
+                // the solution and gradient at the quadrature point
+                u.fill(0.0);
+                gradu_data.fill(0.0);
+                for(int ibasis = 0; ibasis < nbasis; ++ibasis){
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        T c = coeff[ibasis * neq + ieq];
+                        u[ieq] += c * bi[ibasis];
+                        for(int jdim = 0; jdim < ndim; ++jdim) gradu_data[ieq * ndim + jdim] += c * gradx[ibasis * ndim + jdim];
+                    }
+                }
+
+                Tensor<T, neq, ndim> flux = phys_flux(u, gradu);
+                record_wavespeed(el.elidx, u);
+                if(artificial_viscosity.active()){
+                    T eps = artificial_viscosity.element_qp(el.elidx, iqp);
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        for(int jdim = 0; jdim < ndim; ++jdim) flux[ieq][jdim] -= eps * gradu[ieq, jdim];
+                    }
+                }
+                for(int ieq = 0; ieq < neq; ++ieq){
+                    for(int jdim = 0; jdim < ndim; ++jdim) flux[ieq][jdim] *= dvol;
+                }
+
+                // test function loop
+                for(int itest = 0; itest < nbasis; ++itest){
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        T sum = 0;
+                        for(int jdim = 0; jdim < ndim; ++jdim) sum += flux[ieq][jdim] * gradx[itest * ndim + jdim];
+                        resl[itest * neq + ieq] += sum;
+                    }
+                }
+
+                if(user_source){
+                    auto phys_pt = qp_geo.phys_pt(iqp);
+                    auto& source_fcn = user_source.value();
+                    std::array<T, neq> source;
+                    source_table.eval(source_fcn, el.elidx, iqp, phys_pt.data(), source.data());
+                    for(int itest = 0; itest < nbasis; ++itest){
+                        for(int ieq = 0; ieq < neq; ++ieq)
+                            { resl[itest * neq + ieq] -= source[ieq] * bi[itest] * dvol; }
+                    }
+                }
+            }
+
+            for(int ibasis = 0; ibasis < nbasis; ++ibasis){
+                for(int ieq = 0; ieq < neq; ++ieq)
+                    { res[ibasis, ieq] += resl[ibasis * neq + ieq]; }
+            }
+        }
+
+        /**
+         * @brief the domain integral over an element
+         * @tparam TransT the concrete transformation type of the element (or void)
+         *         to inline the transformation for batched assembly (see FESpace::dispatch_element_batch)
+         * @tparam SizesT the compile time element sizes of the batch (or void) 
+         *         for the specialized kernels (see FESpace::dispatch_element_kernel)
+         */
+        template<class IDX, class TransT = void, class SizesT = void>
+        auto domain_integral(
+            const FiniteElement<T, IDX, ndim> &el,
+            elspan auto unkel,
+            elspan auto res,
+            std::type_identity<TransT> trans_tag = {},
+            std::type_identity<SizesT> = {}
+        ) const -> void {
+            static constexpr int neq = decltype(unkel)::static_extent();
+            static_assert(neq == PFlux::nv_comp, "Number of equations must match.");
+            using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+            if(tracking_wavespeed(el.elidx)) element_wavespeeds[el.elidx] = 0;
+
+            // entropy stable flux differencing on collocated Gauss-Lobatto elements
+            if constexpr (two_point_physical_flux<PFlux>) {
+                if(flux_differencing && el.sum_fact != nullptr && el.sum_fact->collocated()){
+                    domain_integral_flux_differencing(el, *el.sum_fact, unkel, res, trans_tag);
+                    return;
+                }
+            }
+
+            // tensor product elements at high order
+            if(el.sum_fact != nullptr && el.sum_fact->nbasis_1d >= sum_factorization_min_nbasis_1d){
+                if constexpr (!std::is_void_v<SizesT>) {
+                    if constexpr (SizesT::domain_type == DOMAIN_TYPE::HYPERCUBE) {
+                        if(el.sum_fact->nbasis_1d == SizesT::nbasis_1d && el.sum_fact->nqp_1d == SizesT::nqp_1d){
+                            domain_integral_sum_factorized(el, 
+                                FixedExtentSumFactorization<T, ndim, SizesT::nbasis_1d, SizesT::nqp_1d>{*el.sum_fact},
+                                unkel, res, trans_tag);
+                            return;
+                        }
+                    }
+                }
+                domain_integral_sum_factorized(el, *el.sum_fact, unkel, res, trans_tag);
+                return;
+            }
+
+            // specialized kernel for the element sizes of the batch
+            if constexpr (!std::is_void_v<SizesT>) {
+                if(el.nbasis() == SizesT::nbasis && el.nQP() == SizesT::nqp){
+                    domain_integral_fixed<SizesT>(el, unkel, res, trans_tag);
+                    return;
+                }
+            }
+
+            // basis function scratch space
+            std::vector<T> dbdx_data(el.nbasis() * ndim);
+
+            // solution scratch space
+            std::array<T, neq> u;
+            std::array<T, neq * ndim> gradu_data;
+
+            // loop over the quadrature points
+            QPGeometry<T, IDX, ndim, TransT> qp_geo{el};
+            for(int iqp = 0; iqp < el.nQP(); ++iqp){
+                // inverse jacobian and integration measure (cached, affine, or computed)
+                auto [Jinv, dvol] = qp_geo[iqp];
+
+                // get the basis functions and gradients in the physical domain
+                auto bi = el.eval_basis_qp(iqp);
+                auto gradxBi = el.eval_phys_grad_basis_jinv(Jinv,
+                        el.eval_grad_basis_qp(iqp), dbdx_data.data());
+
+                // construct the solution U at the quadrature point 
+                std::ranges::fill(u, 0.0);
+                for(int ibasis = 0; ibasis < el.nbasis(); ++ibasis){
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        u[ieq] += unkel[ibasis, ieq] * bi[ibasis];
+                    }
+                }
+
+                // construct the gradient of u 
+                auto gradu = unkel.contract_mdspan(gradxBi, gradu_data.data());
+
+                // compute the flux  and scatter to the residual
+                Tensor<T, neq, ndim> flux = phys_flux(u, gradu);
+                record_wavespeed(el.elidx, u);
+                if(artificial_viscosity.active()){
+                    T eps = artificial_viscosity.element_qp(el.elidx, iqp);
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        for(int jdim = 0; jdim < ndim; ++jdim) flux[ieq][jdim] -= eps * gradu[ieq, jdim];
+                    }
+                }
+
+                // loop over the test functions and construct the residual
+                for(int itest = 0; itest < el.nbasis(); ++itest){
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        for(int jdim = 0; jdim < ndim; ++jdim){
+                            res[itest, ieq] += flux[ieq][jdim] * gradxBi[itest, jdim] * dvol;
+                        }
+                    }
+                }
+
+                // if a source term has been defined, add it in
+                if(user_source){
+                    auto phys_pt = qp_geo.phys_pt(iqp);
+
+                    auto& source_fcn = user_source.value();
+                    std::array<T, neq> source;
+                    source_table.eval(source_fcn, el.elidx, iqp, phys_pt.data(), source.data());
+                    for(int itest = 0; itest < el.nbasis(); ++itest){
+                        for(int ieq = 0; ieq < neq; ++ieq) {
+                            res[itest, ieq] -= source[ieq] * bi[itest] * dvol;
+                        }
+                    }
+                }
+            }
+        }
+
+        template<class IDX, class TransT = void>
+        auto domain_integral_jacobian(
+            const FiniteElement<T, IDX, ndim>& el,
+            elspan auto unkel,
+            linalg::out_matrix auto dfdu,
+            std::type_identity<TransT> = {}
+        ) {
+            static constexpr int neq = decltype(unkel)::static_extent();
+            static_assert(neq == PFlux::nv_comp, "Number of equations must match.");
+            using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+            // basis function scratch space
+            std::vector<T> dbdx_data(el.nbasis() * ndim);
+
+            // solution scratch space
+            std::array<T, neq> u;
+            std::array<T, neq * ndim> gradu_data;
+
+            // get the degree of freedom layout for the element 
+            auto el_layout = unkel.get_layout();
+
+            // loop over the quadrature points
+            QPGeometry<T, IDX, ndim, TransT> qp_geo{el};
+            for(int iqp = 0; iqp < el.nQP(); ++iqp){
+                // inverse jacobian and integration measure (cached, affine, or computed)
+                auto [Jinv, dvol] = qp_geo[iqp];
+
+                // get the basis functions and gradients in the physical domain
+                auto bi = el.eval_basis_qp(iqp);
+                auto gradxBi = el.eval_phys_grad_basis_jinv(Jinv,
+                        el.eval_grad_basis_qp(iqp), dbdx_data.data());
+
+                // construct the solution U at the quadrature point 
+                std::ranges::fill(u, 0.0);
+                for(int ibasis = 0; ibasis < el.nbasis(); ++ibasis){
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        u[ieq] += unkel[ibasis, ieq] * bi[ibasis];
+                    }
+                }
+
+                // construct the gradient of u 
+                auto gradu = unkel.contract_mdspan(gradxBi, gradu_data.data());
+
+                // compute the jacobian of the physical flux 
+                // with respect to field variables
+                // and gradients
+                Tensor<T, neq, ndim, neq> dflux_du;
+                Tensor<T, neq, ndim, neq, ndim> dflux_dgradu;
+                phys_flux_jacobian(u, gradu, dflux_du, dflux_dgradu);
+                if(artificial_viscosity.active()){
+                    T eps = artificial_viscosity.element_qp(el.elidx, iqp);
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        for(int jdim = 0; jdim < ndim; ++jdim) dflux_dgradu[ieq, jdim, ieq, jdim] -= eps;
+                    }
+                }
+                
+                // loop over the test functions and construct the jacobian
+                // (skipping the structurally zero component couplings of the physical flux)
+                for(int itest = 0; itest < el.nbasis(); ++itest){
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        const bitset<neq> coupling = physical_flux_coupling<PFlux>[ieq];
+                        for(int idim = 0; idim < ndim; ++idim){
+                            for(int jdof = 0; jdof < el.nbasis(); ++jdof){
+                                for(int jeq = 0; jeq < neq; ++jeq){
+                                    if(!coupling[jeq]) continue;
+                                    // one-dimensional jacobian indices
+                                    auto ijac = el_layout[itest, ieq];
+                                    auto jjac = el_layout[jdof, jeq];
+                                    dfdu[ijac, jjac] += 
+                                        dflux_du[ieq, idim, jeq] * bi[jdof] 
+                                        * gradxBi[itest, idim] * dvol;
+                                    for(int jdim = 0; jdim < ndim; ++jdim){
+                                        dfdu[ijac, jjac] += 
+                                            dflux_dgradu[ieq, idim, jeq, jdim] * gradxBi[jdof, jdim] 
+                                            * gradxBi[itest, idim] * dvol;
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+
+                // source has no dependence on U 
+                // therefore no contribution to 
+                // jacobian
+            }
+        }
+
+        template<class IDX, class ULayoutPolicy, class UAccessorPolicy, class ResLayoutPolicy>
+        void trace_integral(
+            const TraceSpace<T, IDX, ndim> &trace,
+            NodeArray<T, ndim> &coord,
+            dofspan<T, ULayoutPolicy, UAccessorPolicy> unkelL,
+            dofspan<T, ULayoutPolicy, UAccessorPolicy> unkelR,
+            dofspan<T, ResLayoutPolicy> resL,
+            dofspan<T, ResLayoutPolicy> resR
+        ) const requires ( 
+            elspan<decltype(unkelL)> && 
+            elspan<decltype(unkelR)> && 
+            elspan<decltype(resL)> && 
+            elspan<decltype(resL)>
+        ) {
+            trace_integral_impl(trace, coord, unkelL, unkelR, resL, resR, nullptr);
+        }
+
+        /**
+         * @brief the trace integral and the interface conservation residual of an interior trace
+         * from one reconstruction of the interface states and gradients
+         *
+         * Adds the same contributions to resL and resR as trace_integral
+         * and to ic_res as interface_conservation
+         * (the quadrature point geometry, states, and basis gradients are only evaluated once)
+         *
+         * @param [in] trace the interior trace to integrate over
+         * @param [in] coord the global node coordinates array
+         * @param [in] unkelL the left element basis coefficients
+         * @param [in] unkelR the right element basis coefficients
+         * @param [out] resL the left element residual (added to)
+         * @param [out] resR the right element residual (added to)
+         * @param [out] ic_res the interface conservation residual of the trace (added to)
+         */
+        template<class IDX, class ULayoutPolicy, class UAccessorPolicy, class ResLayoutPolicy>
+        void trace_integral_interface_conservation(
+            const TraceSpace<T, IDX, ndim> &trace,
+            NodeArray<T, ndim> &coord,
+            dofspan<T, ULayoutPolicy, UAccessorPolicy> unkelL,
+            dofspan<T, ULayoutPolicy, UAccessorPolicy> unkelR,
+            dofspan<T, ResLayoutPolicy> resL,
+            dofspan<T, ResLayoutPolicy> resR,
+            facspan auto ic_res
+        ) const requires ( 
+            elspan<decltype(unkelL)> && 
+            elspan<decltype(unkelR)> && 
+            elspan<decltype(resL)> && 
+            elspan<decltype(resL)>
+        ) {
+            trace_integral_impl(trace, coord, unkelL, unkelR, resL, resR, ic_res);
+        }
+
+        /// @brief the trace integral, also adding the interface conservation residual to ic_res
+        /// unless it is nullptr
+        template<class IDX, class ULayoutPolicy, class UAccessorPolicy, class ResLayoutPolicy, class ICResType>
+        void trace_integral_impl(
+            const TraceSpace<T, IDX, ndim> &trace,
+            NodeArray<T, ndim> &coord,
+            dofspan<T, ULayoutPolicy, UAccessorPolicy> unkelL,
+            dofspan<T, ULayoutPolicy, UAccessorPolicy> unkelR,
+            dofspan<T, ResLayoutPolicy> resL,
+            dofspan<T, ResLayoutPolicy> resR,
+            ICResType ic_res
+        ) const {
+            static constexpr bool with_ic = !std::is_same_v<ICResType, std::nullptr_t>;
+            static constexpr int neq = nv_comp;
+            static_assert(neq == decltype(unkelL)::static_extent(), "Number of equations must match.");
+            static_assert(neq == decltype(unkelR)::static_extent(), "Number of equations must match.");
+            using namespace NUMTOOL::TENSOR::FIXED_SIZE;
             using FiniteElement = FiniteElement<T, IDX, ndim>;
 
             // calculate the centroids of the left and right elements
             // in the physical domain
             const FiniteElement &elL = trace.elL;
             const FiniteElement &elR = trace.elR;
-            auto centroidL = elL.centroid();
-            auto centroidR = elR.centroid();
+            // the DDG interface data is read from the cache when it is up to date
+            const bool ddg_cached = trace.has_ddg_factors();
+            MATH::GEOMETRY::Point<T, ndim> centroidL{}, centroidR{};
+            if(!ddg_cached){
+                centroidL = elL.centroid();
+                centroidR = trace.centroid_r();
+            }
+
+            // Basis function scratch space 
+            PhysDomainEvalStorage storageL{elL};
+            PhysDomainEvalStorage storageR{elR};
+
+            // solution scratch space 
+            std::array<T, neq> uL;
+            std::array<T, neq> uR;
+            std::array<T, neq * ndim> graduL_data;
+            std::array<T, neq * ndim> graduR_data;
+            std::array<T, neq * ndim> grad_ddg_data;
+            std::array<T, neq * ndim * ndim> hessuL_data;
+            std::array<T, neq * ndim * ndim> hessuR_data;
+
+            // trace basis scratch space for the interface conservation
+            std::vector<T> bitrace{};
+            if constexpr (with_ic) bitrace.resize(trace.nbasis_trace());
+
+            // HACK (as in interface_conservation): disable diffusion IC for linear polynomials 
+            const bool ic_zero_gradient = elL.basis->getPolynomialOrder() == 1 && elR.basis->getPolynomialOrder() == 1;
+            std::array<T, neq * ndim> gradu_zero_data{};
+            std::mdspan<T, std::extents<int, neq, ndim>> gradu_zero{gradu_zero_data.data()};
+
+            // structure of arrays storage for the quadrature point data [component x quadrature point]
+            // so the convective numerical flux is evaluated for the whole trace in one batch
+            const int nqp = trace.nQP();
+            std::vector<T> soa_data((3 * neq + 2 * ndim + 1) * nqp);
+            T *uL_soa_ptr = soa_data.data();
+            T *uR_soa_ptr = uL_soa_ptr + neq * nqp;
+            T *fadvn_soa_ptr = uR_soa_ptr + neq * nqp;
+            T *normal_soa_ptr = fadvn_soa_ptr + neq * nqp;
+            T *phys_pt_soa_ptr = normal_soa_ptr + ndim * nqp;
+            T *dsurf_ptr = phys_pt_soa_ptr + ndim * nqp;
+            soa_span<T, neq> uL_soa{uL_soa_ptr, nqp};
+            soa_span<T, neq> uR_soa{uR_soa_ptr, nqp};
+            soa_span<T, neq> fadvn_soa{fadvn_soa_ptr, nqp};
+            soa_span<T, ndim> normal_soa{normal_soa_ptr, nqp};
+            soa_span<T, ndim> phys_pt_soa{phys_pt_soa_ptr, nqp};
+
+            // gather the geometry and interface states at each quadrature point
+            const bool geo_cached = trace.has_geometric_factors();
+            for(int iqp = 0; iqp < nqp; ++iqp){
+                const QuadraturePoint<T, ndim - 1> &quadpt = trace.getQP(iqp);
+
+                // get the unit normal, surface measure, and physical point (cached if available)
+                Tensor<T, ndim> unit_normal;
+                T dsurf;
+                MATH::GEOMETRY::Point<T, ndim> phys_pt;
+                if(geo_cached){
+                    unit_normal = trace.geo_factors->unit_normal(trace.facidx, iqp);
+                    dsurf = trace.geo_factors->dsurf(trace.facidx, iqp);
+                    phys_pt = trace.geo_factors->trace_phys_pt(trace.facidx, iqp);
+                } else {
+                    // calculate the riemannian metric tensor root
+                    auto Jfac = trace.face->Jacobian(coord, quadpt.abscisse);
+                    T sqrtg = trace.face->rootRiemannMetric(Jfac, quadpt.abscisse);
+                    dsurf = quadpt.weight * sqrtg;
+
+                    // calculate the normal vector 
+                    auto normal = calc_ortho(Jfac);
+                    unit_normal = normalize(normal);
+
+                    trace.face->transform(quadpt.abscisse, coord, phys_pt);
+                }
+                for(int idim = 0; idim < ndim; ++idim){
+                    normal_soa[idim, iqp] = unit_normal[idim];
+                    phys_pt_soa[idim, iqp] = phys_pt[idim];
+                }
+                dsurf_ptr[iqp] = dsurf;
+
+                // construct the solution on the left and right
+                auto biL = trace.qp_evals_l[iqp].bi_span;
+                auto biR = trace.qp_evals_r[iqp].bi_span;
+                for(int ieq = 0; ieq < neq; ++ieq){
+                    T uL_eq = 0, uR_eq = 0;
+                    for(int ibasis = 0; ibasis < elL.nbasis(); ++ibasis)
+                        { uL_eq += unkelL[ibasis, ieq] * biL[ibasis]; }
+                    for(int ibasis = 0; ibasis < elR.nbasis(); ++ibasis)
+                        { uR_eq += unkelR[ibasis, ieq] * biR[ibasis]; }
+                    uL_soa[ieq, iqp] = uL_eq;
+                    uR_soa[ieq, iqp] = uR_eq;
+                }
+            }
+
+            // compute convective fluxes for all the quadrature points
+            conv_nflux_batch(conv_nflux,
+                soa_span<const T, neq>{uL_soa_ptr, nqp},
+                soa_span<const T, neq>{uR_soa_ptr, nqp},
+                soa_span<const T, ndim>{normal_soa_ptr, nqp},
+                fadvn_soa);
+
+            // loop over the quadrature points
+            for(int iqp = 0; iqp < nqp; ++iqp){
+                const QuadraturePoint<T, ndim - 1> &quadpt = trace.getQP(iqp);
+
+                // unpack the gathered quadrature point data
+                Tensor<T, ndim> unit_normal;
+                MATH::GEOMETRY::Point<T, ndim> phys_pt;
+                for(int idim = 0; idim < ndim; ++idim){
+                    unit_normal[idim] = normal_soa[idim, iqp];
+                    phys_pt[idim] = phys_pt_soa[idim, iqp];
+                }
+                T dsurf = dsurf_ptr[iqp];
+                std::array<T, neq> fadvn;
+                for(int ieq = 0; ieq < neq; ++ieq){
+                    uL[ieq] = uL_soa[ieq, iqp];
+                    uR[ieq] = uR_soa[ieq, iqp];
+                    fadvn[ieq] = fadvn_soa[ieq, iqp];
+                }
+
+                // get the basis functions, derivatives, and hessians
+                // (derivatives are wrt the physical domain)
+                auto biL = trace.qp_evals_l[iqp].bi_span;
+                auto biR = trace.qp_evals_r[iqp].bi_span;
+                auto xiL = trace.xiL_qp(iqp);
+                auto xiR = trace.xiR_qp(iqp);
+                typename DDGTraceFactors<T, IDX, ndim>::grad_span_t gradBiL, gradBiR;
+                typename DDGTraceFactors<T, IDX, ndim>::hess_span_t hessBiL, hessBiR;
+                if(ddg_cached){
+                    gradBiL = trace.ddg_factors->grad_basis_l(trace, iqp);
+                    gradBiR = trace.ddg_factors->grad_basis_r(trace, iqp);
+                    hessBiL = trace.ddg_factors->hess_basis_l(trace, iqp);
+                    hessBiR = trace.ddg_factors->hess_basis_r(trace, iqp);
+                } else {
+                    PhysDomainEval evalL{storageL, elL, xiL, trace.qp_evals_l[iqp],
+                        trace.jacobian_l_qp(iqp), trace.hessian_l_qp(iqp)};
+                    PhysDomainEval evalR{storageR, elR, xiR, trace.qp_evals_r[iqp],
+                        trace.jacobian_r_qp(iqp), trace.hessian_r_qp(iqp)};
+                    gradBiL = evalL.phys_grad_basis;
+                    gradBiR = evalR.phys_grad_basis;
+                    hessBiL = evalL.phys_hess_basis;
+                    hessBiR = evalR.phys_hess_basis;
+                }
+
+                // get the solution gradient and hessians
+                auto graduL = unkelL.contract_mdspan(gradBiL, graduL_data.data());
+                auto graduR = unkelR.contract_mdspan(gradBiR, graduR_data.data());
+                auto hessuL = unkelL.contract_mdspan(hessBiL, hessuL_data.data());
+                auto hessuR = unkelR.contract_mdspan(hessBiR, hessuR_data.data());
+
+                // the interface conservation from the same states and gradients
+                if constexpr (with_ic) {
+                    Tensor<T, neq, ndim> fluxL = (ic_zero_gradient) ? phys_flux(uL, gradu_zero) : phys_flux(uL, graduL);
+                    Tensor<T, neq, ndim> fluxR = (ic_zero_gradient) ? phys_flux(uR, gradu_zero) : phys_flux(uR, graduR);
+                    trace.eval_trace_basis_qp(iqp, bitrace.data());
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        T jumpflux = 0;
+                        for(int idim = 0; idim < ndim; ++idim)
+                            { jumpflux += (fluxR[ieq][idim] - fluxL[ieq][idim]) * unit_normal[idim]; }
+                        T ic_qp = jumpflux * dsurf;
+                        for(int itest = 0; itest < trace.nbasis_trace(); ++itest)
+                            { ic_res[itest, ieq] -= ic_qp * bitrace[itest]; }
+                    }
+                }
+
+                // compute a single valued gradient using DDG or IP 
+
+                // calculate the DDG distance
+                T h_ddg = (ddg_cached) ? trace.ddg_factors->h_ddg(trace.facidx, iqp)
+                    : ddg_interface_distance<T, ndim>(unit_normal, phys_pt, centroidL, centroidR);
+                
+                int order = std::max(
+                    elL.basis->getPolynomialOrder(),
+                    elR.basis->getPolynomialOrder()
+                );
+                // Danis and Yan reccomended for NS
+                T beta0 = std::pow(order + 1, 2);
+                T beta1 = 1 / std::max((T) (2 * order * (order + 1)), 1.0);
+
+                // switch to interior penalty if set
+                if(interior_penalty) beta1 = 0.0;
+
+                std::mdspan<T, std::extents<int, neq, ndim>> grad_ddg{grad_ddg_data.data()};
+                for(int ieq = 0; ieq < neq; ++ieq){
+                    // construct the DDG derivatives
+                    T jumpu = uR[ieq] - uL[ieq];
+                    for(int idim = 0; idim < ndim; ++idim){
+                        grad_ddg[ieq, idim] = beta0 * jumpu / h_ddg * unit_normal[idim]
+                            + 0.5 * (graduL[ieq, idim] + graduR[ieq, idim]);
+                        T hessTerm = 0;
+                        for(int jdim = 0; jdim < ndim; ++jdim){
+                            hessTerm += (hessuR[ieq, jdim, idim] - hessuL[ieq, jdim, idim])
+                                * unit_normal[jdim];
+                        }
+                        grad_ddg[ieq, idim] += beta1 * h_ddg * hessTerm;
+                    }
+                }
+
+                // construct the viscous fluxes 
+                std::array<T, neq> uavg;
+                for(int ieq = 0; ieq < neq; ++ieq) uavg[ieq] = 0.5 * (uL[ieq] + uR[ieq]);
+
+                std::array<T, neq> fviscn = diff_flux(uavg, grad_ddg, unit_normal);
+                if(artificial_viscosity.active()){
+                    T eps = artificial_viscosity.trace_qp(trace.facidx, iqp);
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        for(int idim = 0; idim < ndim; ++idim)
+                            { fviscn[ieq] += eps * grad_ddg[ieq, idim] * unit_normal[idim]; }
+                    }
+                }
+
+                // scale by weight and face metric tensor
+                for(int ieq = 0; ieq < neq; ++ieq){
+                    fadvn[ieq] *= dsurf;
+                    fviscn[ieq] *= dsurf;
+                }
+
+                // scatter contribution 
+                for(int itest = 0; itest < elL.nbasis(); ++itest){
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        resL[itest, ieq] += (fviscn[ieq] - fadvn[ieq]) * biL[itest];
+                    }
+                }
+                for(int itest = 0; itest < elR.nbasis(); ++itest){
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        resR[itest, ieq] -= (fviscn[ieq] - fadvn[ieq]) * biR[itest];
+                    }
+                }
+
+                // if applicable: apply the interface correction 
+                if constexpr (computes_homogeneity_tensor<DiffusiveFlux>) {
+                    if(sigma_ic != 0.0){
+                        auto Gtensor = diff_flux.homogeneity_tensor(uavg);
+
+                        for(int itest = 0; itest < elL.nbasis(); ++itest){
+
+                            for(int ieq = 0; ieq < neq; ++ieq){
+                                for(int kdim = 0; kdim < ndim; ++kdim){
+                                    for(int req = 0; req < neq; ++req){
+                                        T jumpu_r = uR[req] - uL[req];
+                                        for(int sdim = 0; sdim < ndim; ++sdim){
+                                            
+                                            T ic_contrib = 
+                                                sigma_ic * Gtensor[ieq][kdim][req][sdim] * unit_normal[kdim]
+                                                * jumpu_r * dsurf;
+                                            resL[itest, ieq] -= 
+                                                ic_contrib
+                                                * 0.5 * gradBiL[itest, sdim]; // 0.5 comes from average operator
+                                            resR[itest, ieq] -= 
+                                                ic_contrib
+                                                * 0.5 * gradBiR[itest, sdim];
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+
+        /**
+         * @brief calculate the jacobian of the trace integral with respect to the 
+         * basis coefficients of the left and right elements
+         *
+         * The numerical fluxes are linearized pointwise at each quadrature point 
+         * (by finite difference of the flux functions) 
+         * and chained exactly through the DDG gradient and the basis functions
+         *
+         * The jacobians are indexed [test index, trial index] with the element compact layouts
+         * and are added to
+         *
+         * @param [in] trace the trace to integrate over 
+         * @param [in] coord the global node coordinates array
+         * @param [in] unkelL the left element basis coefficients 
+         * @param [in] unkelR the right element basis coefficients 
+         * @param [out] jacLL derivative of the left residual wrt the left coefficients
+         * @param [out] jacLR derivative of the left residual wrt the right coefficients
+         * @param [out] jacRL derivative of the right residual wrt the left coefficients
+         * @param [out] jacRR derivative of the right residual wrt the right coefficients
+         */
+        template<class IDX, class ULayoutPolicy, class UAccessorPolicy>
+        void trace_integral_jacobian(
+            const TraceSpace<T, IDX, ndim> &trace,
+            NodeArray<T, ndim> &coord,
+            dofspan<T, ULayoutPolicy, UAccessorPolicy> unkelL,
+            dofspan<T, ULayoutPolicy, UAccessorPolicy> unkelR,
+            linalg::out_matrix auto jacLL,
+            linalg::out_matrix auto jacLR,
+            linalg::out_matrix auto jacRL,
+            linalg::out_matrix auto jacRR
+        ) const requires ( 
+            elspan<decltype(unkelL)> && 
+            elspan<decltype(unkelR)>
+        ) {
+            static constexpr int neq = nv_comp;
+            static_assert(neq == decltype(unkelL)::static_extent(), "Number of equations must match.");
+            static_assert(neq == decltype(unkelR)::static_extent(), "Number of equations must match.");
+            using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+            using FiniteElement = FiniteElement<T, IDX, ndim>;
+
+            const FiniteElement &elL = trace.elL;
+            const FiniteElement &elR = trace.elR;
+            // the DDG interface data is read from the cache when it is up to date
+            const bool ddg_cached = trace.has_ddg_factors();
+            MATH::GEOMETRY::Point<T, ndim> centroidL{}, centroidR{};
+            if(!ddg_cached){
+                centroidL = elL.centroid();
+                centroidR = trace.centroid_r();
+            }
+            auto layoutL = unkelL.get_layout();
+            auto layoutR = unkelR.get_layout();
 
             // Basis function scratch space 
             PhysDomainEvalStorage storageL{elL};
@@ -471,14 +1830,13 @@ namespace iceicle {
             std::array<T, neq * ndim * ndim> hessuL_data;
             std::array<T, neq * ndim * ndim> hessuR_data;
 
-
-            // loop over the quadrature points 
             for(int iqp = 0; iqp < trace.nQP(); ++iqp){
                 const QuadraturePoint<T, ndim - 1> &quadpt = trace.getQP(iqp);
 
                 // calculate the riemannian metric tensor root
                 auto Jfac = trace.face->Jacobian(coord, quadpt.abscisse);
                 T sqrtg = trace.face->rootRiemannMetric(Jfac, quadpt.abscisse);
+                T wsqrtg = quadpt.weight * sqrtg;
 
                 // calculate the normal vector 
                 auto normal = calc_ortho(Jfac);
@@ -488,10 +1846,25 @@ namespace iceicle {
                 // (derivatives are wrt the physical domain)
                 auto biL = trace.qp_evals_l[iqp].bi_span;
                 auto biR = trace.qp_evals_r[iqp].bi_span;
-                auto xiL = trace.transform_xiL(quadpt.abscisse);
-                auto xiR = trace.transform_xiR(quadpt.abscisse);
-                PhysDomainEval evalL{storageL, elL, xiL, trace.qp_evals_l[iqp]};
-                PhysDomainEval evalR{storageR, elR, xiR, trace.qp_evals_r[iqp]};
+                auto xiL = trace.xiL_qp(iqp);
+                auto xiR = trace.xiR_qp(iqp);
+                typename DDGTraceFactors<T, IDX, ndim>::grad_span_t gradBiL, gradBiR;
+                typename DDGTraceFactors<T, IDX, ndim>::hess_span_t hessBiL, hessBiR;
+                if(ddg_cached){
+                    gradBiL = trace.ddg_factors->grad_basis_l(trace, iqp);
+                    gradBiR = trace.ddg_factors->grad_basis_r(trace, iqp);
+                    hessBiL = trace.ddg_factors->hess_basis_l(trace, iqp);
+                    hessBiR = trace.ddg_factors->hess_basis_r(trace, iqp);
+                } else {
+                    PhysDomainEval evalL{storageL, elL, xiL, trace.qp_evals_l[iqp],
+                        trace.jacobian_l_qp(iqp), trace.hessian_l_qp(iqp)};
+                    PhysDomainEval evalR{storageR, elR, xiR, trace.qp_evals_r[iqp],
+                        trace.jacobian_r_qp(iqp), trace.hessian_r_qp(iqp)};
+                    gradBiL = evalL.phys_grad_basis;
+                    gradBiR = evalR.phys_grad_basis;
+                    hessBiL = evalL.phys_hess_basis;
+                    hessBiR = evalR.phys_hess_basis;
+                }
 
                 // construct the solution on the left and right
                 std::ranges::fill(uL, 0.0);
@@ -504,42 +1877,30 @@ namespace iceicle {
                 }
 
                 // get the solution gradient and hessians
-                auto graduL = unkelL.contract_mdspan(evalL.phys_grad_basis, graduL_data.data());
-                auto graduR = unkelR.contract_mdspan(evalR.phys_grad_basis, graduR_data.data());
-                auto hessuL = unkelL.contract_mdspan(evalL.phys_hess_basis, hessuL_data.data());
-                auto hessuR = unkelR.contract_mdspan(evalR.phys_hess_basis, hessuR_data.data());
-
-                // compute convective fluxes
-                std::array<T, neq> fadvn = conv_nflux(uL, uR, unit_normal);
-
-                // compute a single valued gradient using DDG or IP 
-
-                // calculate the DDG distance
-                MATH::GEOMETRY::Point<T, ndim> phys_pt;
-                trace.face->transform(quadpt.abscisse, coord, phys_pt);
-                T h_ddg = 0;
-                for(int idim = 0; idim < ndim; ++idim){
-                    h_ddg += unit_normal[idim] * (
-                        (phys_pt[idim] - centroidL[idim])
-                        + (centroidR[idim] - phys_pt[idim])
-                    );
+                auto graduL = unkelL.contract_mdspan(gradBiL, graduL_data.data());
+                auto graduR = unkelR.contract_mdspan(gradBiR, graduR_data.data());
+                auto hessuL = unkelL.contract_mdspan(hessBiL, hessuL_data.data());
+                auto hessuR = unkelR.contract_mdspan(hessBiR, hessuR_data.data());
+
+                // calculate the DDG distance and coefficients (same as trace_integral)
+                T h_ddg;
+                if(ddg_cached) {
+                    h_ddg = trace.ddg_factors->h_ddg(trace.facidx, iqp);
+                } else {
+                    MATH::GEOMETRY::Point<T, ndim> phys_pt;
+                    trace.face->transform(quadpt.abscisse, coord, phys_pt);
+                    h_ddg = ddg_interface_distance<T, ndim>(unit_normal, phys_pt, centroidL, centroidR);
                 }
-                h_ddg = std::copysign(std::max(std::abs(h_ddg), std::numeric_limits<T>::epsilon()), h_ddg);
-                
                 int order = std::max(
                     elL.basis->getPolynomialOrder(),
                     elR.basis->getPolynomialOrder()
                 );
-                // Danis and Yan reccomended for NS
                 T beta0 = std::pow(order + 1, 2);
                 T beta1 = 1 / std::max((T) (2 * order * (order + 1)), 1.0);
-
-                // switch to interior penalty if set
                 if(interior_penalty) beta1 = 0.0;
 
                 std::mdspan<T, std::extents<int, neq, ndim>> grad_ddg{grad_ddg_data.data()};
                 for(int ieq = 0; ieq < neq; ++ieq){
-                    // construct the DDG derivatives
                     T jumpu = uR[ieq] - uL[ieq];
                     for(int idim = 0; idim < ndim; ++idim){
                         grad_ddg[ieq, idim] = beta0 * jumpu / h_ddg * unit_normal[idim]
@@ -552,66 +1913,126 @@ namespace iceicle {
                         grad_ddg[ieq, idim] += beta1 * h_ddg * hessTerm;
                     }
                 }
-
-                // construct the viscous fluxes 
                 std::array<T, neq> uavg;
                 for(int ieq = 0; ieq < neq; ++ieq) uavg[ieq] = 0.5 * (uL[ieq] + uR[ieq]);
 
-                std::array<T, neq> fviscn = diff_flux(uavg, grad_ddg, unit_normal);
-
-                // scale by weight and face metric tensor
-                for(int ieq = 0; ieq < neq; ++ieq){
-                    fadvn[ieq] *= quadpt.weight * sqrtg;
-                    fviscn[ieq] *= quadpt.weight * sqrtg;
-                }
-
-                // scatter contribution 
-                for(int itest = 0; itest < elL.nbasis(); ++itest){
-                    for(int ieq = 0; ieq < neq; ++ieq){
-                        resL[itest, ieq] += (fviscn[ieq] - fadvn[ieq]) * biL[itest];
-                    }
-                }
-                for(int itest = 0; itest < elR.nbasis(); ++itest){
+                // linearize the fluxes wrt the pointwise states and the DDG gradient
+                Tensor<T, neq, neq> dfadv_duL, dfadv_duR, dfvisc_du;
+                Tensor<T, neq, neq, ndim> dfvisc_dgrad;
+                conv_nflux_jacobian(uL, uR, unit_normal, dfadv_duL, dfadv_duR);
+                diff_flux_jacobian(uavg, grad_ddg, unit_normal, dfvisc_du, dfvisc_dgrad);
+                if(artificial_viscosity.active()){
+                    T eps = artificial_viscosity.trace_qp(trace.facidx, iqp);
                     for(int ieq = 0; ieq < neq; ++ieq){
-                        resR[itest, ieq] -= (fviscn[ieq] - fadvn[ieq]) * biR[itest];
+                        for(int idim = 0; idim < ndim; ++idim) dfvisc_dgrad[ieq, ieq, idim] += eps * unit_normal[idim];
                     }
                 }
-
-                // if applicable: apply the interface correction 
+                T unorm = 0;
+                for(int ieq = 0; ieq < neq; ++ieq) unorm += uavg[ieq] * uavg[ieq];
+                T epsilon = scale_fd_epsilon(std::sqrt(std::numeric_limits<T>::epsilon()), std::sqrt(unorm));
+
+                // linearize the interface correction 
+                // C[ieq, sdim] = G(uavg)[ieq][kdim][req][sdim] * n[kdim] * jump(u)[req]
+                // dC_du: wrt the jump (A) and wrt the average through G (B)
+                bool use_ic = false;
+                Tensor<T, neq, ndim, neq> ic_A, ic_B;
                 if constexpr (computes_homogeneity_tensor<DiffusiveFlux>) {
-                    auto gradBiL = evalL.phys_grad_basis;
-                    auto gradBiR = evalR.phys_grad_basis;
                     if(sigma_ic != 0.0){
-                        auto Gtensor = diff_flux.homogeneity_tensor(uavg);
-
-                        for(int itest = 0; itest < elL.nbasis(); ++itest){
-
+                        use_ic = true;
+                        auto ic_flux = [&](const auto& Gtensor){
+                            Tensor<T, neq, ndim> C;
                             for(int ieq = 0; ieq < neq; ++ieq){
-                                for(int kdim = 0; kdim < ndim; ++kdim){
-                                    for(int req = 0; req < neq; ++req){
-                                        T jumpu_r = uR[req] - uL[req];
-                                        for(int sdim = 0; sdim < ndim; ++sdim){
-                                            
-                                            T ic_contrib = 
-                                                sigma_ic * Gtensor[ieq][kdim][req][sdim] * unit_normal[kdim]
-                                                * jumpu_r * quadpt.weight * sqrtg;
-                                            resL[itest, ieq] -= 
-                                                ic_contrib
-                                                * 0.5 * gradBiL[itest, sdim]; // 0.5 comes from average operator
-                                            resR[itest, ieq] -= 
-                                                ic_contrib
-                                                * 0.5 * gradBiR[itest, sdim];
+                                for(int sdim = 0; sdim < ndim; ++sdim){
+                                    C[ieq, sdim] = 0;
+                                    for(int kdim = 0; kdim < ndim; ++kdim){
+                                        for(int req = 0; req < neq; ++req){
+                                            C[ieq, sdim] += Gtensor[ieq][kdim][req][sdim]
+                                                * unit_normal[kdim] * (uR[req] - uL[req]);
                                         }
                                     }
                                 }
                             }
+                            return C;
+                        };
+                        auto Gtensor = diff_flux.homogeneity_tensor(uavg);
+                        Tensor<T, neq, ndim> C = ic_flux(Gtensor);
+                        for(int jeq = 0; jeq < neq; ++jeq){
+                            T u_old = uavg[jeq];
+                            uavg[jeq] += epsilon;
+                            Tensor<T, neq, ndim> Cp = ic_flux(diff_flux.homogeneity_tensor(uavg));
+                            uavg[jeq] = u_old;
+                            for(int ieq = 0; ieq < neq; ++ieq){
+                                for(int sdim = 0; sdim < ndim; ++sdim){
+                                    ic_B[ieq, sdim, jeq] = (Cp[ieq, sdim] - C[ieq, sdim]) / epsilon;
+                                    ic_A[ieq, sdim, jeq] = 0;
+                                    for(int kdim = 0; kdim < ndim; ++kdim){
+                                        ic_A[ieq, sdim, jeq] += Gtensor[ieq][kdim][jeq][sdim] * unit_normal[kdim];
+                                    }
+                                }
+                            }
                         }
                     }
                 }
+
+                // add the contributions of the trial functions on one side
+                // jump_sign is the sign of the trial side in jump(u) = uR - uL
+                auto add_trial_side = [&](
+                    const FiniteElement& el_trial, auto bi_trial, auto gradbi_trial, auto hessbi_trial,
+                    auto layout_trial, T jump_sign, const auto& dfadv_du,
+                    auto jac_left, auto jac_right
+                ) {
+                    std::array<T, ndim> dgrad_ddg;
+                    std::array<T, neq> dflux;
+                    for(int jdof = 0; jdof < el_trial.nbasis(); ++jdof){
+                        // derivative of the DDG gradient wrt this trial function
+                        for(int idim = 0; idim < ndim; ++idim){
+                            dgrad_ddg[idim] = jump_sign * beta0 * bi_trial[jdof] / h_ddg * unit_normal[idim]
+                                + 0.5 * gradbi_trial[jdof, idim];
+                            T hessTerm = 0;
+                            for(int kdim = 0; kdim < ndim; ++kdim)
+                                { hessTerm += hessbi_trial[jdof, kdim, idim] * unit_normal[kdim]; }
+                            dgrad_ddg[idim] += jump_sign * beta1 * h_ddg * hessTerm;
+                        }
+                        for(int jeq = 0; jeq < neq; ++jeq){
+                            auto jjac = layout_trial[jdof, jeq];
+                            for(int ieq = 0; ieq < neq; ++ieq){
+                                dflux[ieq] = (dfvisc_du[ieq, jeq] * 0.5 - dfadv_du[ieq, jeq]) * bi_trial[jdof];
+                                for(int idim = 0; idim < ndim; ++idim)
+                                    { dflux[ieq] += dfvisc_dgrad[ieq, jeq, idim] * dgrad_ddg[idim]; }
+                                dflux[ieq] *= wsqrtg;
+                            }
+                            for(int itest = 0; itest < elL.nbasis(); ++itest){
+                                for(int ieq = 0; ieq < neq; ++ieq)
+                                    { jac_left[layoutL[itest, ieq], jjac] += dflux[ieq] * biL[itest]; }
+                            }
+                            for(int itest = 0; itest < elR.nbasis(); ++itest){
+                                for(int ieq = 0; ieq < neq; ++ieq)
+                                    { jac_right[layoutR[itest, ieq], jjac] -= dflux[ieq] * biR[itest]; }
+                            }
+
+                            if(use_ic){
+                                for(int ieq = 0; ieq < neq; ++ieq){
+                                    for(int sdim = 0; sdim < ndim; ++sdim){
+                                        T dC = (jump_sign * ic_A[ieq, sdim, jeq] + 0.5 * ic_B[ieq, sdim, jeq])
+                                            * bi_trial[jdof] * sigma_ic * wsqrtg * 0.5;
+                                        for(int itest = 0; itest < elL.nbasis(); ++itest)
+                                            { jac_left[layoutL[itest, ieq], jjac] -= dC * gradBiL[itest, sdim]; }
+                                        for(int itest = 0; itest < elR.nbasis(); ++itest)
+                                            { jac_right[layoutR[itest, ieq], jjac] -= dC * gradBiR[itest, sdim]; }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                };
+
+                add_trial_side(elL, biL, gradBiL, hessBiL,
+                        layoutL, -1.0, dfadv_duL, jacLL, jacRL);
+                add_trial_side(elR, biR, gradBiR, hessBiR,
+                        layoutR, 1.0, dfadv_duR, jacLR, jacRR);
             }
         }
 
-
         /**
          * @brief calculate the weak form for a boundary condition 
          *        NOTE: Left is the interior element
@@ -639,6 +2060,33 @@ namespace iceicle {
             elspan<decltype(unkelL)> &&
             elspan<decltype(unkelR)> &&
             elspan<decltype(resL)> 
+        ) {
+            dispatch_bctype(trace.face->bctype, [&](auto tag){
+                boundaryIntegral(tag, trace, coord, unkelL, unkelR, resL);
+            });
+        }
+
+        /**
+         * @brief calculate the weak form for a boundary condition 
+         * with the boundary condition type known at compile time 
+         * so that loops over traces sorted by boundary condition do not branch per trace
+         * (see ResidualWorkspace::physical_bdy_groups)
+         *
+         * @param bc the boundary condition of trace (must match trace.face->bctype)
+         * see boundaryIntegral for the other parameters
+         */
+        template<BOUNDARY_CONDITIONS bc, class IDX, class ULayoutPolicy, class UAccessorPolicy, class ResLayoutPolicy>
+        void boundaryIntegral(
+            bc_tag<bc>,
+            const TraceSpace<T, IDX, ndim> &trace,
+            NodeArray<T, ndim> &coord,
+            dofspan<T, ULayoutPolicy, UAccessorPolicy> unkelL,
+            dofspan<T, ULayoutPolicy, UAccessorPolicy> unkelR,
+            dofspan<T, ResLayoutPolicy> resL
+        ) const requires(
+            elspan<decltype(unkelL)> &&
+            elspan<decltype(unkelR)> &&
+            elspan<decltype(resL)> 
         ) {
             using namespace NUMTOOL::TENSOR::FIXED_SIZE;
             using FiniteElement = FiniteElement<T, IDX, ndim>;
@@ -660,7 +2108,7 @@ namespace iceicle {
 
             // switch over special cases of boundary condition implementations 
             // that can have increased efficiency when coded separately
-            switch(trace.face->bctype){
+            switch(bc){
                 case BOUNDARY_CONDITIONS::DIRICHLET: 
                 {
                     // see Huang, Chen, Li, Yan 2016
@@ -697,7 +2145,7 @@ namespace iceicle {
 
                         // Get the values at the boundary 
                         std::array<T, nv_comp> dirichlet_vals{};
-                        dirichlet_callbacks[trace.face->bcflag](phys_pt.data(), dirichlet_vals.data());
+                        dirichlet_table.eval(dirichlet_callbacks[trace.face->bcflag], trace.facidx, iqp, phys_pt.data(), dirichlet_vals.data());
 
                         // compute convective fluxes
                         std::array<T, neq> fadvn = conv_nflux(uL, dirichlet_vals, unit_normal);
@@ -809,7 +2257,7 @@ namespace iceicle {
 
                         // Get the values at the boundary 
                         std::array<T, nv_comp> neumann_vals{};
-                        neumann_callbacks[trace.face->bcflag](phys_pt.data(), neumann_vals.data());
+                        neumann_table.eval(neumann_callbacks[trace.face->bcflag], trace.facidx, iqp, phys_pt.data(), neumann_vals.data());
                         // flux contribution weighted by quadrature and face metric 
                         // Li and Tang 2017 sec 9.1.1
                         std::array<T, nv_comp> fviscn = diff_flux.neumann_flux(neumann_vals);
@@ -837,32 +2285,28 @@ namespace iceicle {
                     static_assert(neq == decltype(unkelR)::static_extent(), "Number of equations must match.");
                     using namespace NUMTOOL::TENSOR::FIXED_SIZE;
 
-                    // Get the info from the connection
-                    TraceSpace<T, IDX, ndim>& trace_past = spacetime_info.connection_traces[trace.facidx];
-                    std::vector<T> unker_past_data{trace_past.elL.nbasis() * neq};
-                    auto uR_layout = spacetime_info.u_past.create_element_layout(trace_past.elR.elidx);
-                    dofspan unkel_past{unker_past_data, uR_layout};
-                    extract_elspan(trace_past.elR.elidx, spacetime_info.u_past, unkel_past);
-                    AbstractMesh<T, IDX, ndim>* mesh_past = spacetime_info.fespace_past.meshptr;
+                    // Get the past slab data from the connection
+                    const auto* past = spacetime_info.past_trace(trace.facidx);
+                    if(past == nullptr) {
+                        util::AnomalyLog::log_anomaly(util::Anomaly{"SPACETIME_PAST trace not connected to a past slab",
+                                util::general_anomaly_tag{}});
+                        break;
+                    }
 
-                    // calculate the centroids of the left and right elements
+                    // calculate the centroid of the left element
                     // in the physical domain
                     const FiniteElement &elL = trace.elL;
-                    const FiniteElement &elR = trace_past.elR;
                     auto centroidL = elL.geo_el->centroid(coord);
 
                     // Basis function scratch space 
                     PhysDomainEvalStorage storageL{elL};
-                    PhysDomainEvalStorage storageR{elR};
 
                     // solution scratch space 
                     std::array<T, neq> uL;
                     std::array<T, neq> uR;
                     std::array<T, neq * ndim> graduL_data;
-                    std::array<T, neq * ndim> graduR_data;
                     std::array<T, neq * ndim> grad_ddg_data;
                     std::array<T, neq * ndim * ndim> hessuL_data;
-                    std::array<T, neq * ndim * ndim> hessuR_data;
 
 
                     // loop over the quadrature points 
@@ -880,27 +2324,23 @@ namespace iceicle {
                         // get the basis functions, derivatives, and hessians
                         // (derivatives are wrt the physical domain)
                         auto biL = trace.qp_evals_l[iqp].bi_span;
-                        auto biR = trace.qp_evals_r[iqp].bi_span;
-                        auto xiL = trace.transform_xiL(quadpt.abscisse);
-                        auto xiR = trace.transform_xiR(quadpt.abscisse);
-                        PhysDomainEval evalL{storageL, elL, xiL, trace.qp_evals_l[iqp]};
-                        PhysDomainEval evalR{storageR, elR, xiR, trace.qp_evals_r[iqp]};
+                        auto xiL = trace.xiL_qp(iqp);
+                        PhysDomainEval evalL{storageL, elL, xiL, trace.qp_evals_l[iqp],
+                            trace.jacobian_l_qp(iqp), trace.hessian_l_qp(iqp)};
 
-                        // construct the solution on the left and right
+                        // construct the solution on the left and the past slab solution
                         std::ranges::fill(uL, 0.0);
-                        std::ranges::fill(uR, 0.0);
                         for(int ieq = 0; ieq < neq; ++ieq){
                             for(int ibasis = 0; ibasis < elL.nbasis(); ++ibasis)
                                 { uL[ieq] += unkelL[ibasis, ieq] * biL[ibasis]; }
-                            for(int ibasis = 0; ibasis < elR.nbasis(); ++ibasis)
-                                { uR[ieq] += unkel_past[ibasis, ieq] * biR[ibasis]; }
+                            uR[ieq] = past->u[iqp * neq + ieq];
                         }
 
                         // get the solution gradient and hessians
                         auto graduL = unkelL.contract_mdspan(evalL.phys_grad_basis, graduL_data.data());
-                        auto graduR = unkelR.contract_mdspan(evalR.phys_grad_basis, graduR_data.data());
                         auto hessuL = unkelL.contract_mdspan(evalL.phys_hess_basis, hessuL_data.data());
-                        auto hessuR = unkelR.contract_mdspan(evalR.phys_hess_basis, hessuR_data.data());
+                        std::mdspan<const T, std::extents<int, neq, ndim>> graduR{past->gradu.data() + iqp * neq * ndim};
+                        std::mdspan<const T, std::extents<int, neq, ndim, ndim>> hessuR{past->hessu.data() + iqp * neq * ndim * ndim};
 
                         // compute convective fluxes
                         std::array<T, neq> fadvn = conv_nflux(uL, uR, unit_normal);
@@ -920,7 +2360,7 @@ namespace iceicle {
                         
                         int order = std::max(
                             elL.basis->getPolynomialOrder(),
-                            elR.basis->getPolynomialOrder()
+                            past->order
                         );
                         // Danis and Yan reccomended for NS
                         T beta0 = std::pow(order + 1, 2);
@@ -1040,22 +2480,198 @@ namespace iceicle {
                 }
                 break;
 
-                default:
-                // === General BC Case ===
-                // We construct the interior state uL 
-                // and the gradients of the interior state graduL 
-                // and pass this to the PDE implementation to give 
-                // uR and graduR
-                // otherwise
-                // assume essential
-                if constexpr (implements_bcs<PFlux>){
-                    // loop over quadrature points 
+                default:
+                // === General BC Case ===
+                // We construct the interior state uL 
+                // and the gradients of the interior state graduL 
+                // and pass this to the PDE implementation to give 
+                // uR and graduR
+                // otherwise
+                // assume essential
+                if constexpr (implements_bcs<PFlux>){
+                    // loop over quadrature points 
+                    for(int iqp = 0; iqp < trace.nQP(); ++iqp){
+                        const QuadraturePoint<T, ndim - 1> &quadpt = trace.getQP(iqp);
+
+                        // calculate the jacobian and riemannian metric root det
+                        auto Jfac = trace.face->Jacobian(coord, quadpt.abscisse);
+                        T sqrtg = trace.face->rootRiemannMetric(Jfac, quadpt.abscisse);
+
+                        // calculate the normal vector 
+                        auto normal = calc_ortho(Jfac);
+                        auto unit_normal = normalize(normal);
+
+                        // calculate the physical domain position
+                        MATH::GEOMETRY::Point<T, ndim> phys_pt;
+                        trace.face->transform(quadpt.abscisse, coord, phys_pt);
+
+                        // get the function values
+                        auto biL = trace.qp_evals_l[iqp].bi_span;
+
+                        // construct the solution on the left
+                        std::ranges::fill(uL, 0.0);
+                        for(int ieq = 0; ieq < neq; ++ieq){
+                            for(int ibasis = 0; ibasis < elL.nbasis(); ++ibasis)
+                                { uL[ieq] += unkelL[ibasis, ieq] * biL[ibasis]; }
+                        }
+
+                        // get the gradients the physical domain
+                        auto gradBiL = trace.eval_phys_grad_basis_l_qp(iqp, gradbL_data.data());
+                        auto graduL = unkelL.contract_mdspan(gradBiL, graduL_data.data());
+
+                        // get the uR and graduR from the interior information
+                        // uL is also modifiable
+                        auto [uR, graduR] = phys_flux.apply_bc(
+                                uL, graduL, unit_normal,
+                                bc, trace.face->bcflag);
+
+                        // construct the DDG derivatives
+                        int order = 
+                            elL.basis->getPolynomialOrder();
+                        // Danis and Yan reccomended for NS
+                        T beta0 = std::pow(order + 1, 2);
+                        T beta1 = 1 / std::max((T) (2 * order * (order + 1)), 1.0);
+
+                        // switch to interior penalty if set
+                        if(interior_penalty) beta1 = 0.0;
+
+                        // calculate the DDG distance
+                        T h_ddg = 0; // uses distance to quadpt on boundary face
+                        for(int idim = 0; idim < ndim; ++idim){
+                            h_ddg += std::abs(unit_normal[idim] * 
+                                (phys_pt[idim] - centroidL[idim])
+                            );
+                        }
+                        h_ddg = std::copysign(std::max(std::abs(h_ddg)
+                                    , std::numeric_limits<T>::epsilon()), h_ddg);
+                        std::mdspan<T, std::extents<int, neq, ndim>> 
+                            grad_ddg{grad_ddg_data.data()};
+
+                        for(int ieq = 0; ieq < neq; ++ieq){
+                            // construct the DDG derivatives
+                            T jumpu = uR[ieq] - uL[ieq];
+                            for(int idim = 0; idim < ndim; ++idim){
+                                grad_ddg[ieq, idim] = beta0 * jumpu / h_ddg * unit_normal[idim]
+                                    + (graduL[ieq, idim]);
+                            }
+                        }
+
+                        // compute convective fluxes
+                        std::array<T, neq> fadvn = conv_nflux(uL, uR, unit_normal);
+
+                        // construct the viscous fluxes 
+                        std::array<T, neq> uavg;
+                        for(int ieq = 0; ieq < neq; ++ieq) uavg[ieq] = 0.5 * (uL[ieq] + uR[ieq]);
+                        std::array<T, neq> fviscn = diff_flux(uavg, grad_ddg, unit_normal);
+
+                        // scale by weight and face metric tensor
+                        for(int ieq = 0; ieq < neq; ++ieq){
+                            fadvn[ieq] *= quadpt.weight * sqrtg;
+                            fviscn[ieq] *= quadpt.weight * sqrtg;
+                        }
+
+                        // scatter contribution 
+                        for(int itest = 0; itest < elL.nbasis(); ++itest){
+                            for(int ieq = 0; ieq < neq; ++ieq){
+                                resL[itest, ieq] += (fviscn[ieq] - fadvn[ieq]) * biL[itest];
+                            }
+                        }
+
+                        // if applicable: apply the interface correction 
+                        if constexpr (computes_homogeneity_tensor<DiffusiveFlux>) {
+                            if(sigma_ic != 0.0){
+
+                                std::array<T, neq> interface_correction;
+                                auto Gtensor = diff_flux.homogeneity_tensor(uavg);
+
+                                T average_gradv[ndim];
+                                for(int itest = 0; itest < elL.nbasis(); ++itest){
+                                    // get the average test function gradient
+                                    for(int idim = 0; idim < ndim; ++idim){
+                                        average_gradv[idim] = gradBiL[itest, idim];
+                                    }
+
+                                    std::ranges::fill(interface_correction, 0);
+                                    for(int ieq = 0; ieq < neq; ++ieq){
+                                        for(int kdim = 0; kdim < ndim; ++kdim){
+                                            for(int req = 0; req < neq; ++req){
+                                                T jumpu_r = uR[req] - uL[req];
+                                                for(int sdim = 0; sdim < ndim; ++sdim){
+                                                    resL[itest, ieq] -= 
+                                                        Gtensor[ieq][kdim][req][sdim] * unit_normal[kdim] 
+                                                        * average_gradv[sdim] * jumpu_r
+                                                        * quadpt.weight * sqrtg;
+                                                }
+                                            }
+                                        }
+                                    }
+
+                                }
+                            }
+                        }
+                    }
+                }
+                break;
+            }
+        }
+
+        /**
+         * @brief calculate the jacobian of the boundary integral with respect to the 
+         * interior element basis coefficients
+         *
+         * The numerical fluxes are linearized pointwise at each quadrature point 
+         * (by finite difference of the flux functions) 
+         * and chained exactly through the DDG gradient and the basis functions
+         *
+         * NOTE: Left is the interior element
+         *
+         * @param [in] trace the trace to integrate over 
+         * @param [in] coord the global node coordinates array
+         * @param [in] unkelL the interior element basis coefficients 
+         * @param [in] unkelR is the same as uL unless this is a periodic boundary
+         * @param [out] jacL derivative of the interior residual wrt the interior coefficients
+         *                   indexed [test index, trial index] with the element compact layout (added to)
+         * @return true if the jacobian was computed, 
+         *         false if this boundary condition type does not implement an analytic jacobian
+         *         (the caller should fall back to finite differences of boundaryIntegral)
+         */
+        template<class IDX, class ULayoutPolicy, class UAccessorPolicy>
+        auto boundary_integral_jacobian(
+            const TraceSpace<T, IDX, ndim> &trace,
+            NodeArray<T, ndim> &coord,
+            dofspan<T, ULayoutPolicy, UAccessorPolicy> unkelL,
+            dofspan<T, ULayoutPolicy, UAccessorPolicy> unkelR,
+            linalg::out_matrix auto jacL
+        ) const -> bool requires(
+            elspan<decltype(unkelL)> &&
+            elspan<decltype(unkelR)>
+        ) {
+            using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+            using FiniteElement = FiniteElement<T, IDX, ndim>;
+            const FiniteElement &elL = trace.elL;
+            auto layoutL = unkelL.get_layout();
+
+            static constexpr int neq = nv_comp;
+
+            // Basis function scratch space 
+            std::vector<T> gradbL_data(elL.nbasis() * ndim);
+
+            // solution scratch space 
+            std::array<T, neq> uL;
+            std::array<T, neq * ndim> graduL_data;
+            std::array<T, neq * ndim> grad_ddg_data;
+            auto centroidL = elL.centroid();
+
+            switch(trace.face->bctype){
+                case BOUNDARY_CONDITIONS::DIRICHLET: 
+                {
                     for(int iqp = 0; iqp < trace.nQP(); ++iqp){
                         const QuadraturePoint<T, ndim - 1> &quadpt = trace.getQP(iqp);
 
                         // calculate the jacobian and riemannian metric root det
                         auto Jfac = trace.face->Jacobian(coord, quadpt.abscisse);
                         T sqrtg = trace.face->rootRiemannMetric(Jfac, quadpt.abscisse);
+                        T wsqrtg = quadpt.weight * sqrtg;
 
                         // calculate the normal vector 
                         auto normal = calc_ortho(Jfac);
@@ -1065,113 +2681,240 @@ namespace iceicle {
                         MATH::GEOMETRY::Point<T, ndim> phys_pt;
                         trace.face->transform(quadpt.abscisse, coord, phys_pt);
 
-                        // get the function values
+                        // get the basis functions and gradients in the physical domain
                         auto biL = trace.qp_evals_l[iqp].bi_span;
+                        auto gradBiL = trace.eval_phys_grad_basis_l_qp(iqp, gradbL_data.data());
+                        auto graduL = unkelL.contract_mdspan(gradBiL, graduL_data.data());
 
-                        // construct the solution on the left
                         std::ranges::fill(uL, 0.0);
                         for(int ieq = 0; ieq < neq; ++ieq){
                             for(int ibasis = 0; ibasis < elL.nbasis(); ++ibasis)
                                 { uL[ieq] += unkelL[ibasis, ieq] * biL[ibasis]; }
                         }
 
-                        // get the gradients the physical domain
-                        auto gradBiL = trace.eval_phys_grad_basis_l_qp(iqp, gradbL_data.data());
-                        auto graduL = unkelL.contract_mdspan(gradBiL, graduL_data.data());
-
-                        // get the uR and graduR from the interior information
-                        // uL is also modifiable
-                        auto [uR, graduR] = phys_flux.apply_bc(
-                                uL, graduL, unit_normal,
-                                trace.face->bctype, trace.face->bcflag);
-
-                        // construct the DDG derivatives
-                        int order = 
-                            elL.basis->getPolynomialOrder();
-                        // Danis and Yan reccomended for NS
-                        T beta0 = std::pow(order + 1, 2);
-                        T beta1 = 1 / std::max((T) (2 * order * (order + 1)), 1.0);
-
-                        // switch to interior penalty if set
-                        if(interior_penalty) beta1 = 0.0;
+                        // Get the values at the boundary 
+                        std::array<T, nv_comp> dirichlet_vals{};
+                        dirichlet_table.eval(dirichlet_callbacks[trace.face->bcflag], trace.facidx, iqp, phys_pt.data(), dirichlet_vals.data());
 
-                        // calculate the DDG distance
-                        T h_ddg = 0; // uses distance to quadpt on boundary face
+                        // calculate the DDG distance and coefficients (same as boundaryIntegral)
+                        T h_ddg = 0;
                         for(int idim = 0; idim < ndim; ++idim){
                             h_ddg += std::abs(unit_normal[idim] * 
                                 (phys_pt[idim] - centroidL[idim])
                             );
                         }
-                        h_ddg = std::copysign(std::max(std::abs(h_ddg)
-                                    , std::numeric_limits<T>::epsilon()), h_ddg);
-                        std::mdspan<T, std::extents<int, neq, ndim>> 
-                            grad_ddg{grad_ddg_data.data()};
+                        h_ddg = std::copysign(std::max(std::abs(h_ddg), std::numeric_limits<T>::epsilon()), h_ddg);
+                        int order = elL.basis->getPolynomialOrder();
+                        T beta0 = std::pow(order + 1, 2);
 
+                        std::mdspan<T, std::extents<int, neq, ndim>> grad_ddg{grad_ddg_data.data()};
                         for(int ieq = 0; ieq < neq; ++ieq){
-                            // construct the DDG derivatives
-                            T jumpu = uR[ieq] - uL[ieq];
+                            T jumpu = dirichlet_vals[ieq] - uL[ieq];
                             for(int idim = 0; idim < ndim; ++idim){
                                 grad_ddg[ieq, idim] = beta0 * jumpu / h_ddg * unit_normal[idim]
                                     + (graduL[ieq, idim]);
                             }
                         }
-
-                        // compute convective fluxes
-                        std::array<T, neq> fadvn = conv_nflux(uL, uR, unit_normal);
-
-                        // construct the viscous fluxes 
                         std::array<T, neq> uavg;
-                        for(int ieq = 0; ieq < neq; ++ieq) uavg[ieq] = 0.5 * (uL[ieq] + uR[ieq]);
-                        std::array<T, neq> fviscn = diff_flux(uavg, grad_ddg, unit_normal);
-
-                        // scale by weight and face metric tensor
-                        for(int ieq = 0; ieq < neq; ++ieq){
-                            fadvn[ieq] *= quadpt.weight * sqrtg;
-                            fviscn[ieq] *= quadpt.weight * sqrtg;
-                        }
+                        for(int ieq = 0; ieq < neq; ++ieq) uavg[ieq] = 0.5 * (uL[ieq] + dirichlet_vals[ieq]);
 
-                        // scatter contribution 
-                        for(int itest = 0; itest < elL.nbasis(); ++itest){
-                            for(int ieq = 0; ieq < neq; ++ieq){
-                                resL[itest, ieq] += (fviscn[ieq] - fadvn[ieq]) * biL[itest];
+                        // linearize the fluxes wrt the interior state and the DDG gradient
+                        // (the exterior dirichlet state is constant)
+                        Tensor<T, neq, neq> dfadv_duL, dfadv_duR, dfvisc_du;
+                        Tensor<T, neq, neq, ndim> dfvisc_dgrad;
+                        conv_nflux_jacobian(uL, dirichlet_vals, unit_normal, dfadv_duL, dfadv_duR);
+                        diff_flux_jacobian(uavg, grad_ddg, unit_normal, dfvisc_du, dfvisc_dgrad);
+                        T unorm = 0;
+                        for(int ieq = 0; ieq < neq; ++ieq) unorm += uavg[ieq] * uavg[ieq];
+                        T epsilon = scale_fd_epsilon(std::sqrt(std::numeric_limits<T>::epsilon()), std::sqrt(unorm));
+
+                        std::array<T, ndim> dgrad_ddg;
+                        std::array<T, neq> dflux;
+                        for(int jdof = 0; jdof < elL.nbasis(); ++jdof){
+                            for(int idim = 0; idim < ndim; ++idim){
+                                dgrad_ddg[idim] = -beta0 * biL[jdof] / h_ddg * unit_normal[idim]
+                                    + gradBiL[jdof, idim];
+                            }
+                            for(int jeq = 0; jeq < neq; ++jeq){
+                                auto jjac = layoutL[jdof, jeq];
+                                for(int ieq = 0; ieq < neq; ++ieq){
+                                    dflux[ieq] = (dfvisc_du[ieq, jeq] * 0.5 - dfadv_duL[ieq, jeq]) * biL[jdof];
+                                    for(int idim = 0; idim < ndim; ++idim)
+                                        { dflux[ieq] += dfvisc_dgrad[ieq, jeq, idim] * dgrad_ddg[idim]; }
+                                    dflux[ieq] *= wsqrtg;
+                                }
+                                for(int itest = 0; itest < elL.nbasis(); ++itest){
+                                    for(int ieq = 0; ieq < neq; ++ieq)
+                                        { jacL[layoutL[itest, ieq], jjac] += dflux[ieq] * biL[itest]; }
+                                }
                             }
                         }
 
-                        // if applicable: apply the interface correction 
+                        // if applicable: linearize the interface correction 
                         if constexpr (computes_homogeneity_tensor<DiffusiveFlux>) {
                             if(sigma_ic != 0.0){
-
-                                std::array<T, neq> interface_correction;
-                                auto Gtensor = diff_flux.homogeneity_tensor(uavg);
-
-                                T average_gradv[ndim];
-                                for(int itest = 0; itest < elL.nbasis(); ++itest){
-                                    // get the average test function gradient
-                                    for(int idim = 0; idim < ndim; ++idim){
-                                        average_gradv[idim] = gradBiL[itest, idim];
+                                // C[ieq, sdim] = G(uavg)[ieq][kdim][req][sdim] * n[kdim] * (g - uL)[req]
+                                auto ic_flux = [&](const auto& Gtensor){
+                                    Tensor<T, neq, ndim> C;
+                                    for(int ieq = 0; ieq < neq; ++ieq){
+                                        for(int sdim = 0; sdim < ndim; ++sdim){
+                                            C[ieq, sdim] = 0;
+                                            for(int kdim = 0; kdim < ndim; ++kdim){
+                                                for(int req = 0; req < neq; ++req){
+                                                    C[ieq, sdim] += Gtensor[ieq][kdim][req][sdim]
+                                                        * unit_normal[kdim] * (dirichlet_vals[req] - uL[req]);
+                                                }
+                                            }
+                                        }
                                     }
-
-                                    std::ranges::fill(interface_correction, 0);
+                                    return C;
+                                };
+                                auto Gtensor = diff_flux.homogeneity_tensor(uavg);
+                                Tensor<T, neq, ndim> C = ic_flux(Gtensor);
+                                for(int jeq = 0; jeq < neq; ++jeq){
+                                    T u_old = uavg[jeq];
+                                    uavg[jeq] += epsilon;
+                                    Tensor<T, neq, ndim> Cp = ic_flux(diff_flux.homogeneity_tensor(uavg));
+                                    uavg[jeq] = u_old;
                                     for(int ieq = 0; ieq < neq; ++ieq){
-                                        for(int kdim = 0; kdim < ndim; ++kdim){
-                                            for(int req = 0; req < neq; ++req){
-                                                T jumpu_r = uR[req] - uL[req];
-                                                for(int sdim = 0; sdim < ndim; ++sdim){
-                                                    resL[itest, ieq] -= 
-                                                        Gtensor[ieq][kdim][req][sdim] * unit_normal[kdim] 
-                                                        * average_gradv[sdim] * jumpu_r
-                                                        * quadpt.weight * sqrtg;
+                                        for(int sdim = 0; sdim < ndim; ++sdim){
+                                            T dC_du = 0.5 * (Cp[ieq, sdim] - C[ieq, sdim]) / epsilon;
+                                            for(int kdim = 0; kdim < ndim; ++kdim)
+                                                { dC_du -= Gtensor[ieq][kdim][jeq][sdim] * unit_normal[kdim]; }
+                                            for(int jdof = 0; jdof < elL.nbasis(); ++jdof){
+                                                auto jjac = layoutL[jdof, jeq];
+                                                for(int itest = 0; itest < elL.nbasis(); ++itest){
+                                                    jacL[layoutL[itest, ieq], jjac] -= sigma_ic * dC_du
+                                                        * biL[jdof] * gradBiL[itest, sdim] * wsqrtg;
                                                 }
                                             }
                                         }
                                     }
+                                }
+                            }
+                        }
+                    }
+                }
+                return true;
+
+                // the neumann flux does not depend on the solution
+                case BOUNDARY_CONDITIONS::NEUMANN:
+                return true;
+
+                // the past slab state is frozen data (precomputed once per slab)
+                // so only the interior state is linearized
+                case BOUNDARY_CONDITIONS::SPACETIME_PAST:
+                if constexpr(!std::same_as<ST_Info, std::false_type>){
+                    const auto* past = spacetime_info.past_trace(trace.facidx);
+                    if(past == nullptr) return false;
+
+                    // same centroid and DDG coefficients as boundaryIntegral
+                    auto centroid_geo = elL.geo_el->centroid(coord);
+                    int order = std::max(elL.basis->getPolynomialOrder(), past->order);
+                    T beta0 = std::pow(order + 1, 2);
+                    T beta1 = 1 / std::max((T) (2 * order * (order + 1)), 1.0);
+                    if(interior_penalty) beta1 = 0.0;
+
+                    PhysDomainEvalStorage storageL{elL};
+                    std::array<T, neq> uR;
+                    std::array<T, neq * ndim * ndim> hessuL_data;
+
+                    for(int iqp = 0; iqp < trace.nQP(); ++iqp){
+                        const QuadraturePoint<T, ndim - 1> &quadpt = trace.getQP(iqp);
+
+                        // calculate the jacobian and riemannian metric root det
+                        auto Jfac = trace.face->Jacobian(coord, quadpt.abscisse);
+                        T sqrtg = trace.face->rootRiemannMetric(Jfac, quadpt.abscisse);
+                        T wsqrtg = quadpt.weight * sqrtg;
+
+                        // calculate the normal vector
+                        auto normal = calc_ortho(Jfac);
+                        auto unit_normal = normalize(normal);
+
+                        // get the basis functions, derivatives, and hessians in the physical domain
+                        auto biL = trace.qp_evals_l[iqp].bi_span;
+                        auto xiL = trace.xiL_qp(iqp);
+                        PhysDomainEval evalL{storageL, elL, xiL, trace.qp_evals_l[iqp],
+                            trace.jacobian_l_qp(iqp), trace.hessian_l_qp(iqp)};
+                        auto gradBiL = evalL.phys_grad_basis;
+                        auto hessBiL = evalL.phys_hess_basis;
 
+                        std::ranges::fill(uL, 0.0);
+                        for(int ieq = 0; ieq < neq; ++ieq){
+                            for(int ibasis = 0; ibasis < elL.nbasis(); ++ibasis)
+                                { uL[ieq] += unkelL[ibasis, ieq] * biL[ibasis]; }
+                            uR[ieq] = past->u[iqp * neq + ieq];
+                        }
+                        auto graduL = unkelL.contract_mdspan(gradBiL, graduL_data.data());
+                        auto hessuL = unkelL.contract_mdspan(hessBiL, hessuL_data.data());
+                        std::mdspan<const T, std::extents<int, neq, ndim>> graduR{past->gradu.data() + iqp * neq * ndim};
+                        std::mdspan<const T, std::extents<int, neq, ndim, ndim>> hessuR{past->hessu.data() + iqp * neq * ndim * ndim};
+
+                        // calculate the DDG distance
+                        MATH::GEOMETRY::Point<T, ndim> phys_pt;
+                        trace.face->transform(quadpt.abscisse, coord, phys_pt);
+                        T h_ddg = 0;
+                        for(int idim = 0; idim < ndim; ++idim)
+                            { h_ddg += unit_normal[idim] * (2 * (phys_pt[idim] - centroid_geo[idim])); }
+                        h_ddg = std::copysign(std::max(std::abs(h_ddg), std::numeric_limits<T>::epsilon()), h_ddg);
+
+                        std::mdspan<T, std::extents<int, neq, ndim>> grad_ddg{grad_ddg_data.data()};
+                        for(int ieq = 0; ieq < neq; ++ieq){
+                            T jumpu = uR[ieq] - uL[ieq];
+                            for(int idim = 0; idim < ndim; ++idim){
+                                grad_ddg[ieq, idim] = beta0 * jumpu / h_ddg * unit_normal[idim]
+                                    + 0.5 * (graduL[ieq, idim] + graduR[ieq, idim]);
+                                T hessTerm = 0;
+                                for(int jdim = 0; jdim < ndim; ++jdim){
+                                    hessTerm += (hessuR[ieq, jdim, idim] - hessuL[ieq, jdim, idim])
+                                        * unit_normal[jdim];
+                                }
+                                grad_ddg[ieq, idim] += beta1 * h_ddg * hessTerm;
+                            }
+                        }
+                        std::array<T, neq> uavg;
+                        for(int ieq = 0; ieq < neq; ++ieq) uavg[ieq] = 0.5 * (uL[ieq] + uR[ieq]);
+
+                        // linearize the fluxes wrt the interior state and the DDG gradient
+                        Tensor<T, neq, neq> dfadv_duL, dfadv_duR, dfvisc_du;
+                        Tensor<T, neq, neq, ndim> dfvisc_dgrad;
+                        conv_nflux_jacobian(uL, uR, unit_normal, dfadv_duL, dfadv_duR);
+                        diff_flux_jacobian(uavg, grad_ddg, unit_normal, dfvisc_du, dfvisc_dgrad);
+
+                        std::array<T, ndim> dgrad_ddg;
+                        std::array<T, neq> dflux;
+                        for(int jdof = 0; jdof < elL.nbasis(); ++jdof){
+                            // derivative of the DDG gradient wrt this trial function (interior side of the jump)
+                            for(int idim = 0; idim < ndim; ++idim){
+                                dgrad_ddg[idim] = -beta0 * biL[jdof] / h_ddg * unit_normal[idim]
+                                    + 0.5 * gradBiL[jdof, idim];
+                                T hessTerm = 0;
+                                for(int kdim = 0; kdim < ndim; ++kdim)
+                                    { hessTerm += hessBiL[jdof, kdim, idim] * unit_normal[kdim]; }
+                                dgrad_ddg[idim] -= beta1 * h_ddg * hessTerm;
+                            }
+                            for(int jeq = 0; jeq < neq; ++jeq){
+                                auto jjac = layoutL[jdof, jeq];
+                                for(int ieq = 0; ieq < neq; ++ieq){
+                                    dflux[ieq] = (dfvisc_du[ieq, jeq] * 0.5 - dfadv_duL[ieq, jeq]) * biL[jdof];
+                                    for(int idim = 0; idim < ndim; ++idim)
+                                        { dflux[ieq] += dfvisc_dgrad[ieq, jeq, idim] * dgrad_ddg[idim]; }
+                                    dflux[ieq] *= wsqrtg;
+                                }
+                                for(int itest = 0; itest < elL.nbasis(); ++itest){
+                                    for(int ieq = 0; ieq < neq; ++ieq)
+                                        { jacL[layoutL[itest, ieq], jjac] += dflux[ieq] * biL[itest]; }
                                 }
                             }
                         }
                     }
+                    return true;
+                } else {
+                    return false;
                 }
-                break;
+
+                default:
+                return false;
             }
         }
 
@@ -1248,7 +2991,7 @@ namespace iceicle {
                                 trace.face->transform(quadpt.abscisse, coord, phys_pt);
 
                                 // Get the values at the boundary 
-                                dirichlet_callbacks[trace.face->bcflag](phys_pt.data(), uR.data());
+                                dirichlet_table.eval(dirichlet_callbacks[trace.face->bcflag], trace.facidx, iqp, phys_pt.data(), uR.data());
 
                             } break;
                         default:
@@ -1286,6 +3029,195 @@ namespace iceicle {
                 }
             }
         }
+
+        /**
+         * @brief the exact derivatives of interface_conservation with respect to the coordinates of a node
+         *
+         * The interface conservation residual is 
+         *   r_{t,e} = -\sum_{qp} w b_t (F(u_R, \nabla u_R) - F(u_L, \nabla u_L))_{e,d} \nu_d 
+         * where \nu = \sqrt{g} \hat{n} is the area weighted normal (calc_ortho of the face jacobian).
+         * The node coordinates enter through \nu (nodes of the face)
+         * and through the physical solution gradients (nodes of the left and right element)
+         * with d(\partial \phi / \partial x_d) / dx_{n,k} = -(\partial N_n / \partial x_d)(\partial \phi / \partial x_k)
+         * where N_n is the geometric shape function of the node.
+         *
+         * The shape function gradients are the tangents of the (linear in the coordinates) 
+         * face and element transformation jacobians, so this holds for any transformation order
+         *
+         * @param trace the trace (interior traces only)
+         * @param coord the node coordinates (restored before returning)
+         * @param unkelL the left element solution coefficients
+         * @param unkelR the right element solution coefficients
+         * @param inode the global index of the node to differentiate with respect to
+         * @param [out] dres_dx the derivatives [itest * neq + ieq, idim] (overwritten)
+         * @return false if not computed analytically (boundary traces depend on the boundary condition callbacks)
+         */
+        template<class IDX>
+        auto interface_conservation_shape_jacobian(
+            const TraceSpace<T, IDX, ndim>& trace,
+            NodeArray<T, ndim>& coord,
+            elspan auto unkelL,
+            elspan auto unkelR,
+            IDX inode,
+            linalg::out_matrix auto dres_dx
+        ) const -> bool {
+            static constexpr int neq = nv_comp;
+            using namespace MATH::MATRIX_T;
+            using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+            using FiniteElement = FiniteElement<T, IDX, ndim>;
+            using Point = MATH::GEOMETRY::Point<T, ndim>;
+
+            if(trace.face->bctype != BOUNDARY_CONDITIONS::INTERIOR) return false;
+
+            const FiniteElement &elL = trace.elL;
+            const FiniteElement &elR = trace.elR;
+
+            for(std::size_t irow = 0; irow < dres_dx.extent(0); ++irow)
+                for(int idim = 0; idim < ndim; ++idim) dres_dx[irow, idim] = 0.0;
+
+            // local indices of the node in the face and elements (-1 if not present)
+            auto local_index = [inode](auto&& nodes) -> int {
+                auto it = std::ranges::find(nodes, inode);
+                return (it == std::ranges::end(nodes)) ? -1 : (int) std::ranges::distance(std::ranges::begin(nodes), it);
+            };
+            bool on_face = local_index(trace.face->nodes_span()) >= 0;
+            int inodeL = local_index(elL.inodes);
+            int inodeR = local_index(elR.inodes);
+            if(!on_face && inodeL < 0 && inodeR < 0) return true;
+
+            // HACK: disable diffusion IC for linear polynomials (matches interface_conservation)
+            bool use_gradients = !(elL.basis->getPolynomialOrder() == 1 && elR.basis->getPolynomialOrder() == 1);
+
+            // Basis function scratch space 
+            std::vector<T> bitrace(trace.nbasis_trace());
+            std::vector<T> gradbL_data(elL.nbasis() * ndim);
+            std::vector<T> gradbR_data(elR.nbasis() * ndim);
+
+            // tangent of the element coordinates (unit first coordinate of the node)
+            auto tangent_coord = [](const FiniteElement& el, int inode_local){
+                std::vector<Point> tangent(el.coord_el.size());
+                for(Point& pt : tangent) for(int idim = 0; idim < ndim; ++idim) pt[idim] = 0.0;
+                tangent[inode_local][0] = 1.0;
+                return tangent;
+            };
+            std::vector<Point> tangentL = (inodeL >= 0) ? tangent_coord(elL, inodeL) : std::vector<Point>{};
+            std::vector<Point> tangentR = (inodeR >= 0) ? tangent_coord(elR, inodeR) : std::vector<Point>{};
+
+            // solution scratch space 
+            std::array<T, neq> uL;
+            std::array<T, neq> uR;
+            std::array<T, neq * ndim> graduL_data;
+            std::array<T, neq * ndim> graduR_data;
+            Tensor<T, neq, ndim, neq> dflux_du;
+            Tensor<T, neq, ndim, neq, ndim> dfluxL_dgradu, dfluxR_dgradu;
+
+            for(int iqp = 0; iqp < trace.nQP(); ++iqp){
+                const QuadraturePoint<T, ndim - 1> &quadpt = trace.getQP(iqp);
+
+                // the area weighted normal
+                auto Jfac = trace.face->Jacobian(coord, quadpt.abscisse);
+                auto normal = calc_ortho(Jfac);
+
+                // derivatives of the area weighted normal wrt each coordinate of the node
+                // calc_ortho is multilinear in the columns of the face jacobian
+                Tensor<T, ndim, ndim> dnormal{};
+                if(on_face){
+                    for(int kdim = 0; kdim < ndim; ++kdim){
+                        T old_val = coord[inode][kdim];
+                        coord[inode][kdim] += 1.0;
+                        auto Jfac_p = trace.face->Jacobian(coord, quadpt.abscisse);
+                        coord[inode][kdim] = old_val;
+                        for(int icol = 0; icol < ndim - 1; ++icol){
+                            auto Jcol = Jfac;
+                            for(int idim = 0; idim < ndim; ++idim)
+                                { Jcol[idim][icol] = Jfac_p[idim][icol] - Jfac[idim][icol]; }
+                            auto dnormal_col = calc_ortho(Jcol);
+                            for(int idim = 0; idim < ndim; ++idim) dnormal[kdim][idim] += dnormal_col[idim];
+                        }
+                    }
+                }
+
+                // get the basis functions and physical gradients
+                auto biL = trace.eval_basis_l_qp(iqp);
+                auto biR = trace.eval_basis_r_qp(iqp);
+                trace.eval_trace_basis_qp(iqp, bitrace.data());
+                auto gradBiL = trace.eval_phys_grad_basis_l_qp(iqp, gradbL_data.data());
+                auto gradBiR = trace.eval_phys_grad_basis_r_qp(iqp, gradbR_data.data());
+
+                // construct the solution on the left and right
+                std::ranges::fill(uL, 0.0);
+                std::ranges::fill(uR, 0.0);
+                for(int ieq = 0; ieq < neq; ++ieq){
+                    for(int ibasis = 0; ibasis < elL.nbasis(); ++ibasis)
+                        { uL[ieq] += unkelL[ibasis, ieq] * biL[ibasis]; }
+                    for(int ibasis = 0; ibasis < elR.nbasis(); ++ibasis)
+                        { uR[ieq] += unkelR[ibasis, ieq] * biR[ibasis]; }
+                }
+                auto graduL = unkelL.contract_mdspan(gradBiL, graduL_data.data());
+                auto graduR = unkelR.contract_mdspan(gradBiR, graduR_data.data());
+                if(!use_gradients){
+                    std::ranges::fill(graduL_data, 0.0);
+                    std::ranges::fill(graduR_data, 0.0);
+                }
+
+                Tensor<T, neq, ndim> fluxL = phys_flux(uL, graduL);
+                Tensor<T, neq, ndim> fluxR = phys_flux(uR, graduR);
+
+                // derivative of the physical gradient of the state wrt the node coordinates
+                // dflux[kdim][ieq][idim] = dF / d grad u : d grad u / dx_{node, kdim}
+                auto dflux_dx = [&](const FiniteElement& el, std::vector<Point>& tangent,
+                        auto gradu, auto& dflux_dgradu, const Point& xi){
+                    // reference gradient of the geometric shape function of the node
+                    auto dJ = el.trans->jacobian(tangent, xi);
+                    auto Jinv = FiniteElement::inverse_jacobian(el.jacobian(xi));
+                    std::array<T, ndim> dNdx{};
+                    for(int idim = 0; idim < ndim; ++idim)
+                        for(int jdim = 0; jdim < ndim; ++jdim) dNdx[idim] += dJ[0][jdim] * Jinv[jdim][idim];
+
+                    Tensor<T, ndim, neq, ndim> dflux{};
+                    for(int kdim = 0; kdim < ndim; ++kdim){
+                        for(int ieq = 0; ieq < neq; ++ieq){
+                            for(int idim = 0; idim < ndim; ++idim){
+                                for(int jeq = 0; jeq < neq; ++jeq){
+                                    if(!physical_flux_coupling<PFlux>[ieq][jeq]) continue;
+                                    for(int jdim = 0; jdim < ndim; ++jdim){
+                                        dflux[kdim][ieq][idim] -= dflux_dgradu[ieq, idim, jeq, jdim]
+                                            * dNdx[jdim] * gradu[jeq, kdim];
+                                    }
+                                }
+                            }
+                        }
+                    }
+                    return dflux;
+                };
+                Tensor<T, ndim, neq, ndim> dfluxL{}, dfluxR{};
+                if(use_gradients && inodeL >= 0){
+                    Point xiL = trace.xiL_qp(iqp);
+                    phys_flux_jacobian(uL, graduL, dflux_du, dfluxL_dgradu);
+                    dfluxL = dflux_dx(elL, tangentL, graduL, dfluxL_dgradu, xiL);
+                }
+                if(use_gradients && inodeR >= 0){
+                    Point xiR = trace.xiR_qp(iqp);
+                    phys_flux_jacobian(uR, graduR, dflux_du, dfluxR_dgradu);
+                    dfluxR = dflux_dx(elR, tangentR, graduR, dfluxR_dgradu, xiR);
+                }
+
+                // scatter
+                for(int kdim = 0; kdim < ndim; ++kdim){
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        T djump = 0.0;
+                        for(int idim = 0; idim < ndim; ++idim){
+                            djump += (fluxR[ieq][idim] - fluxL[ieq][idim]) * dnormal[kdim][idim]
+                                + (dfluxR[kdim][ieq][idim] - dfluxL[kdim][ieq][idim]) * normal[idim];
+                        }
+                        for(int itest = 0; itest < trace.nbasis_trace(); ++itest){
+                            dres_dx[itest * neq + ieq, kdim] -= djump * quadpt.weight * bitrace[itest];
+                        }
+                    }
+                }
+            }
+            return true;
+        }
     };
 
     // Deduction Guides
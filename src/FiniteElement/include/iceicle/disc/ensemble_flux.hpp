@@ -0,0 +1,319 @@
+/// @file ensemble_flux.hpp
+/// @author Gianni Absillis (gabsill@ncsu.edu)
+///
+/// @brief fluxes for an ensemble of independent solutions stored as the vector components of one solution
+///
+/// The nens members are interleaved in the components: component ieq of member imember is at
+/// ieq * nens + imember, so with fe_layout_right the data is [element][dof][component][member]
+/// and the unknowns of all the members at a basis function are contiguous.
+/// A ConservationLawDDG of the ensemble fluxes evaluates the residuals of all the members
+/// in one pass over the geometry, quadrature, and basis evaluations,
+/// and the contractions with the basis functions run over the members in the innermost (contiguous) loop.
+/// Each member has its own flux objects so members can differ in their physical parameters.
+
+#pragma once
+
+#include "Numtool/fixed_size_tensor.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/linalg/linalg_utils.hpp"
+#include <mdspan/mdspan.hpp>
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace iceicle {
+
+    namespace impl {
+        /// @brief the state of member imember from the ensemble state
+        template<int nens, class U, std::size_t nv_member>
+        inline constexpr
+        auto ensemble_member_state(const auto& u, int imember) noexcept -> std::array<U, nv_member> {
+            std::array<U, nv_member> u_member;
+            for(std::size_t ieq = 0; ieq < nv_member; ++ieq) u_member[ieq] = u[ieq * nens + imember];
+            return u_member;
+        }
+
+        /// @brief copy the gradient of member imember from the ensemble gradient
+        template<int nens, std::size_t nv_member, int ndim>
+        inline constexpr
+        auto ensemble_member_gradient(linalg::in_tensor auto gradu, int imember, auto grad_member) noexcept -> void {
+            for(std::size_t ieq = 0; ieq < nv_member; ++ieq){
+                for(int idim = 0; idim < ndim; ++idim)
+                    { grad_member[ieq, idim] = gradu[ieq * nens + imember, idim]; }
+            }
+        }
+    }
+
+    /**
+     * @brief the physical flux of an ensemble of nens independent members
+     * @tparam Flux the physical flux of a member
+     * @tparam nens the number of members
+     */
+    template<class Flux, int nens>
+    struct EnsemblePhysicalFlux {
+        private:
+        template<class T2, std::size_t... sizes>
+        using Tensor = NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T2, sizes...>;
+
+        public:
+
+        /// @brief the real number type
+        using value_type = typename Flux::value_type;
+        using T = value_type;
+
+        /// @brief the number of dimensions
+        static constexpr int ndim = Flux::ndim;
+
+        /// @brief the number of members
+        static constexpr int nmember = nens;
+
+        /// @brief the number of vector components of each member
+        static constexpr std::size_t nv_member = Flux::nv_comp;
+
+        /// @brief the number of vector components
+        static constexpr std::size_t nv_comp = nv_member * nens;
+
+        /// @brief the flux of each member
+        std::array<Flux, nens> members;
+
+        /**
+         * @brief compute the flux of every member
+         * @param u the interleaved state of all the members
+         * @param gradu the interleaved gradients of all the members
+         */
+        template<class U>
+        inline constexpr
+        auto operator()(
+            std::array<U, nv_comp> u,
+            linalg::in_tensor auto gradu
+        ) const noexcept -> Tensor<U, nv_comp, ndim> {
+            Tensor<U, nv_comp, ndim> flux{};
+            std::array<U, nv_member * ndim> grad_member_data;
+            std::mdspan<U, std::extents<int, nv_member, ndim>> grad_member{grad_member_data.data()};
+            for(int imember = 0; imember < nens; ++imember){
+                std::array<U, nv_member> u_member = impl::ensemble_member_state<nens, U, nv_member>(u, imember);
+                impl::ensemble_member_gradient<nens, nv_member, ndim>(gradu, imember, grad_member);
+                Tensor<U, nv_member, ndim> flux_member = members[imember](u_member, grad_member);
+                for(std::size_t ieq = 0; ieq < nv_member; ++ieq){
+                    for(int idim = 0; idim < ndim; ++idim)
+                        { flux[ieq * nens + imember][idim] = flux_member[ieq][idim]; }
+                }
+            }
+            return flux;
+        }
+
+        /// @brief the timestep from the cfl condition: the smallest over the members
+        inline constexpr
+        auto dt_from_cfl(T cfl, T reference_length) const noexcept -> T {
+            T dt = std::numeric_limits<T>::max();
+            for(const Flux& member : members) dt = std::min(dt, member.dt_from_cfl(cfl, reference_length));
+            return dt;
+        }
+    };
+
+    /**
+     * @brief the convective numerical flux of an ensemble of nens independent members
+     * @tparam ConvectiveFlux the convective numerical flux of a member
+     * @tparam nens the number of members
+     */
+    template<class ConvectiveFlux, int nens>
+    struct EnsembleConvectiveFlux {
+        /// @brief the real number type
+        using value_type = typename ConvectiveFlux::value_type;
+
+        /// @brief the number of dimensions
+        static constexpr int ndim = ConvectiveFlux::ndim;
+
+        /// @brief the number of members
+        static constexpr int nmember = nens;
+
+        /// @brief the number of vector components of each member
+        static constexpr std::size_t nv_member = ConvectiveFlux::nv_comp;
+
+        /// @brief the number of vector components
+        static constexpr std::size_t nv_comp = nv_member * nens;
+
+        /// @brief the numerical flux of each member
+        std::array<ConvectiveFlux, nens> members;
+
+        /// @brief the normal numerical flux of every member
+        template<class U>
+        inline constexpr
+        auto operator()(
+            std::array<U, nv_comp> uL,
+            std::array<U, nv_comp> uR,
+            const auto& unit_normal
+        ) const noexcept -> std::array<U, nv_comp> {
+            std::array<U, nv_comp> fadvn;
+            for(int imember = 0; imember < nens; ++imember){
+                std::array<U, nv_member> fadvn_member = members[imember](
+                    impl::ensemble_member_state<nens, U, nv_member>(uL, imember),
+                    impl::ensemble_member_state<nens, U, nv_member>(uR, imember),
+                    unit_normal);
+                for(std::size_t ieq = 0; ieq < nv_member; ++ieq) fadvn[ieq * nens + imember] = fadvn_member[ieq];
+            }
+            return fadvn;
+        }
+    };
+
+    /**
+     * @brief the diffusive numerical flux of an ensemble of nens independent members
+     * @tparam DiffusiveFlux the diffusive flux of a member
+     * @tparam nens the number of members
+     */
+    template<class DiffusiveFlux, int nens>
+    struct EnsembleDiffusiveFlux {
+        private:
+        template<class T2, std::size_t... sizes>
+        using Tensor = NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T2, sizes...>;
+
+        public:
+
+        /// @brief the real number type
+        using value_type = typename DiffusiveFlux::value_type;
+        using T = value_type;
+
+        /// @brief the number of dimensions
+        static constexpr int ndim = DiffusiveFlux::ndim;
+
+        /// @brief the number of members
+        static constexpr int nmember = nens;
+
+        /// @brief the number of vector components of each member
+        static constexpr std::size_t nv_member = DiffusiveFlux::nv_comp;
+
+        /// @brief the number of vector components
+        static constexpr std::size_t nv_comp = nv_member * nens;
+
+        /// @brief the diffusive flux of each member
+        std::array<DiffusiveFlux, nens> members;
+
+        /// @brief the normal diffusive flux of every member
+        template<class U>
+        inline constexpr
+        auto operator()(
+            std::array<U, nv_comp> u,
+            linalg::in_tensor auto gradu,
+            const auto& unit_normal
+        ) const noexcept -> std::array<U, nv_comp> {
+            std::array<U, nv_comp> fviscn;
+            std::array<U, nv_member * ndim> grad_member_data;
+            std::mdspan<U, std::extents<int, nv_member, ndim>> grad_member{grad_member_data.data()};
+            for(int imember = 0; imember < nens; ++imember){
+                impl::ensemble_member_gradient<nens, nv_member, ndim>(gradu, imember, grad_member);
+                std::array<U, nv_member> fviscn_member = members[imember](
+                    impl::ensemble_member_state<nens, U, nv_member>(u, imember), grad_member, unit_normal);
+                for(std::size_t ieq = 0; ieq < nv_member; ++ieq) fviscn[ieq * nens + imember] = fviscn_member[ieq];
+            }
+            return fviscn;
+        }
+
+        /// @brief the diffusive flux of every member given the prescribed normal gradients
+        inline constexpr
+        auto neumann_flux(
+            std::array<T, nv_comp> gradn
+        ) const noexcept -> std::array<T, nv_comp> {
+            std::array<T, nv_comp> fviscn;
+            for(int imember = 0; imember < nens; ++imember){
+                std::array<T, nv_member> fviscn_member = members[imember].neumann_flux(
+                    impl::ensemble_member_state<nens, T, nv_member>(gradn, imember));
+                for(std::size_t ieq = 0; ieq < nv_member; ++ieq) fviscn[ieq * nens + imember] = fviscn_member[ieq];
+            }
+            return fviscn;
+        }
+
+        /// @brief the homogeneity tensor: block diagonal in the members
+        inline constexpr
+        auto homogeneity_tensor(
+            std::array<T, nv_comp> u
+        ) const noexcept -> Tensor<T, nv_comp, ndim, nv_comp, ndim>
+        requires requires(const DiffusiveFlux& flux, std::array<T, nv_member> u_member) {
+            flux.homogeneity_tensor(u_member);
+        }
+        {
+            Tensor<T, nv_comp, ndim, nv_comp, ndim> G{};
+            for(int imember = 0; imember < nens; ++imember){
+                auto G_member = members[imember].homogeneity_tensor(
+                    impl::ensemble_member_state<nens, T, nv_member>(u, imember));
+                for(std::size_t ieq = 0; ieq < nv_member; ++ieq){
+                    for(int idim = 0; idim < ndim; ++idim){
+                        for(std::size_t jeq = 0; jeq < nv_member; ++jeq){
+                            for(int jdim = 0; jdim < ndim; ++jdim){
+                                G[ieq * nens + imember][idim][jeq * nens + imember][jdim]
+                                    = G_member[ieq][idim][jeq][jdim];
+                            }
+                        }
+                    }
+                }
+            }
+            return G;
+        }
+    };
+
+    /**
+     * @brief combine a function of the coordinates for each member (i.e dirichlet values or initial conditions)
+     * into the function for the interleaved ensemble components
+     *
+     * @tparam nv_member the number of vector components of each member
+     * @param member_functions f(x, out) for each member
+     * @return f(x, out) for all the members
+     */
+    template<int nv_member, class T, std::size_t nens>
+    auto interleave_member_functions(
+        std::array<std::function<void(const T*, T*)>, nens> member_functions
+    ) -> std::function<void(const T*, T*)> {
+        return [member_functions](const T* x, T* out){
+            std::array<T, nv_member> out_member;
+            for(std::size_t imember = 0; imember < nens; ++imember){
+                member_functions[imember](x, out_member.data());
+                for(int ieq = 0; ieq < nv_member; ++ieq) out[ieq * nens + imember] = out_member[ieq];
+            }
+        };
+    }
+
+    /**
+     * @brief copy the solution of one member out of the ensemble solution
+     * @param u_ensemble the ensemble solution (nv = nv of u_member * nens)
+     * @param nens the number of members
+     * @param imember the member to extract
+     * @param [out] u_member the member solution (same dof map as the ensemble)
+     */
+    template<class T, class EnsLayoutPolicy, class EnsAccessorPolicy, class MemberLayoutPolicy>
+    auto extract_ensemble_member(
+        fespan<T, EnsLayoutPolicy, EnsAccessorPolicy> u_ensemble,
+        std::size_t nens,
+        std::size_t imember,
+        fespan<T, MemberLayoutPolicy> u_member
+    ) -> void {
+        for(std::size_t iel = 0; iel < u_member.nelem(); ++iel){
+            for(std::size_t idof = 0; idof < u_member.ndof(iel); ++idof){
+                for(std::size_t iv = 0; iv < u_member.nv(); ++iv)
+                    { u_member[iel, idof, iv] = u_ensemble[iel, idof, iv * nens + imember]; }
+            }
+        }
+    }
+
+    /**
+     * @brief copy the solution of one member into the ensemble solution
+     * @param u_member the member solution (same dof map as the ensemble)
+     * @param nens the number of members
+     * @param imember the member to set
+     * @param [out] u_ensemble the ensemble solution (nv = nv of u_member * nens)
+     */
+    template<class T, class MemberLayoutPolicy, class MemberAccessorPolicy, class EnsLayoutPolicy>
+    auto insert_ensemble_member(
+        fespan<T, MemberLayoutPolicy, MemberAccessorPolicy> u_member,
+        std::size_t nens,
+        std::size_t imember,
+        fespan<T, EnsLayoutPolicy> u_ensemble
+    ) -> void {
+        for(std::size_t iel = 0; iel < u_member.nelem(); ++iel){
+            for(std::size_t idof = 0; idof < u_member.ndof(iel); ++idof){
+                for(std::size_t iv = 0; iv < u_member.nv(); ++iv)
+                    { u_ensemble[iel, idof, iv * nens + imember] = u_member[iel, idof, iv]; }
+            }
+        }
+    }
+}
@@ -0,0 +1,205 @@
+/**
+ * @brief calculate the L2, L-infinity, and H1 seminorm errors of a solution
+ * for all components in one threaded pass with reproducible reductions
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+
+#include "iceicle/element/finite_element.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/reproducible_sum.hpp"
+#include "iceicle/thread_utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <iceicle/fespace/fespace.hpp>
+#include <span>
+#include <vector>
+
+namespace iceicle {
+
+    /**
+     * @brief exact solution evaluated at a batch of points
+     * f(npoin, x, u, gradu)
+     * where:
+     * npoin - the number of points
+     * x - the physical domain coordinates [size = npoin * ndim] (point major)
+     * u - the values at each point [size = npoin * ncomp] (point major)
+     * gradu - the gradients at each point [size = npoin * ncomp * ndim] (point major, then component)
+     *   or nullptr when the gradients are not required
+     */
+    template<class T>
+    using batched_exact_solution = std::function<void(int, const T*, T*, T*)>;
+
+    /// @brief the error norms for each component of a solution
+    template<class T>
+    struct ErrorNorms {
+        /// @brief the L2 norm of the error for each component
+        std::vector<T> l2;
+
+        /// @brief the maximum error at the quadrature points for each component
+        std::vector<T> linf;
+
+        /// @brief the H1 seminorm of the error (L2 norm of the error gradient) for each component
+        /// (zero if not computed)
+        std::vector<T> h1_semi;
+
+        /// @brief the L2 norm of the error over all components
+        [[nodiscard]] auto l2_total() const -> T {
+            T sum = 0;
+            for(T e : l2) sum += e * e;
+            return std::sqrt(sum);
+        }
+
+        /// @brief the maximum error over all components
+        [[nodiscard]] auto linf_total() const -> T {
+            return linf.empty() ? (T) 0 : std::ranges::max(linf);
+        }
+
+        /// @brief the H1 seminorm of the error over all components
+        [[nodiscard]] auto h1_semi_total() const -> T {
+            T sum = 0;
+            for(T e : h1_semi) sum += e * e;
+            return std::sqrt(sum);
+        }
+    };
+
+    /**
+     * @brief compute the L2, L-infinity (at the quadrature points), and H1 seminorm errors
+     * of every component in a single pass over the elements
+     *
+     * The element loop is threaded and the contributions of all threads and ranks are combined
+     * so every rank gets the global norms.
+     * The squared errors are summed with util::reduction_sum so the norms do not depend
+     * on the number of threads or ranks.
+     * The exact solution is evaluated once per element for all the quadrature points
+     *
+     * @param exact_sol the exact solution (see batched_exact_solution)
+     * @param fespace the finite element space
+     * @param u the finite element solution coefficients
+     * @param compute_h1 compute the H1 seminorm (requires the exact gradients)
+     * @param exact_thread_safe if the exact solution may be called concurrently
+     *   otherwise (i.e if it calls into lua) the calls are serialized and all other work is threaded
+     */
+    template<class T, class IDX, int ndim, class uLayoutPolicy, class uAccessorPolicy>
+    auto error_norms(
+        const batched_exact_solution<T>& exact_sol,
+        FESpace<T, IDX, ndim>& fespace,
+        fespan<T, uLayoutPolicy, uAccessorPolicy> u,
+        bool compute_h1 = true,
+        bool exact_thread_safe = false
+    ) -> ErrorNorms<T> {
+        using Element = FiniteElement<T, IDX, ndim>;
+        const int nv = u.nv();
+
+        // for each component: the squared L2 error and squared H1 seminorm error sums, and the max error
+        std::vector<std::vector<util::reduction_sum<T>>> partial_sums(util::max_threads(),
+                std::vector<util::reduction_sum<T>>(2 * nv));
+        std::vector<std::vector<T>> partial_max(util::max_threads(), std::vector<T>(nv, 0.0));
+
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp parallel
+#endif
+        {
+            std::vector<util::reduction_sum<T>>& local_sums = partial_sums[util::thread_num()];
+            std::vector<T>& local_max = partial_max[util::thread_num()];
+
+            // scratch space sized on the first use for the largest element
+            std::vector<T> x{}, uex{}, gradex{}, dbdx_data{};
+            std::vector<T> uqp(nv), graduqp(nv * ndim);
+
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp for schedule(static)
+#endif
+            for(std::size_t iel = 0; iel < fespace.elements.size(); ++iel){
+                const Element& el = fespace.elements[iel];
+                const int nqp = el.nQP();
+                QPGeometry<T, IDX, ndim> qp_geo{el};
+
+                // gather the physical quadrature points
+                x.resize(nqp * ndim);
+                uex.resize(nqp * nv);
+                if(compute_h1) gradex.resize(nqp * nv * ndim);
+                dbdx_data.resize(el.nbasis() * ndim);
+                for(int iqp = 0; iqp < nqp; ++iqp){
+                    auto phys_pt = qp_geo.phys_pt(iqp);
+                    for(int idim = 0; idim < ndim; ++idim) x[iqp * ndim + idim] = phys_pt[idim];
+                }
+
+                // evaluate the exact solution for the whole element
+                T* gradex_ptr = compute_h1 ? gradex.data() : nullptr;
+                if(exact_thread_safe){
+                    exact_sol(nqp, x.data(), uex.data(), gradex_ptr);
+                } else {
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp critical(iceicle_exact_sol)
+#endif
+                    exact_sol(nqp, x.data(), uex.data(), gradex_ptr);
+                }
+
+                for(int iqp = 0; iqp < nqp; ++iqp){
+                    auto [Jinv, dvol] = qp_geo[iqp];
+
+                    // construct the solution at the quadrature point
+                    auto bi = el.eval_basis_qp(iqp);
+                    std::ranges::fill(uqp, 0.0);
+                    for(int ibasis = 0; ibasis < el.nbasis(); ++ibasis){
+                        for(int iv = 0; iv < nv; ++iv)
+                            uqp[iv] += bi[ibasis] * u[el.elidx, ibasis, iv];
+                    }
+
+                    for(int iv = 0; iv < nv; ++iv){
+                        T err = std::abs(uqp[iv] - uex[iqp * nv + iv]);
+                        local_sums[2 * iv] += err * err * dvol;
+                        local_max[iv] = std::max(local_max[iv], err);
+                    }
+
+                    if(compute_h1){
+                        // construct the solution gradient in the physical domain
+                        auto gradxBi = el.eval_phys_grad_basis_jinv(Jinv,
+                                el.eval_grad_basis_qp(iqp), dbdx_data.data());
+                        std::ranges::fill(graduqp, 0.0);
+                        for(int ibasis = 0; ibasis < el.nbasis(); ++ibasis){
+                            for(int iv = 0; iv < nv; ++iv){
+                                for(int idim = 0; idim < ndim; ++idim)
+                                    graduqp[iv * ndim + idim] += gradxBi[ibasis, idim] * u[el.elidx, ibasis, iv];
+                            }
+                        }
+                        for(int iv = 0; iv < nv; ++iv){
+                            T sum = 0;
+                            for(int idim = 0; idim < ndim; ++idim){
+                                T err = graduqp[iv * ndim + idim] - gradex[(iqp * nv + iv) * ndim + idim];
+                                sum += err * err;
+                            }
+                            local_sums[2 * iv + 1] += sum * dvol;
+                        }
+                    }
+                }
+            }
+        }
+
+        // combine the threads then the ranks
+        std::vector<util::reduction_sum<T>> sums(2 * nv);
+        std::vector<T> maxima(nv, 0.0);
+        for(std::size_t ithread = 0; ithread < partial_sums.size(); ++ithread){
+            for(int iv = 0; iv < nv; ++iv){
+                sums[2 * iv] += partial_sums[ithread][2 * iv];
+                sums[2 * iv + 1] += partial_sums[ithread][2 * iv + 1];
+                maxima[iv] = std::max(maxima[iv], partial_max[ithread][iv]);
+            }
+        }
+        mpi::reduction_request max_request = mpi::iallreduce_max(std::span<T>{maxima});
+        mpi::allreduce_sums(std::span{sums});
+        max_request.wait();
+
+        ErrorNorms<T> norms{std::vector<T>(nv), std::vector<T>(nv), std::vector<T>(nv)};
+        for(int iv = 0; iv < nv; ++iv){
+            norms.l2[iv] = std::sqrt(sums[2 * iv].value());
+            norms.h1_semi[iv] = std::sqrt(sums[2 * iv + 1].value());
+            norms.linf[iv] = maxima[iv];
+        }
+        return norms;
+    }
+}
@@ -0,0 +1,330 @@
+/**
+ * @file hdg_diffusion.hpp
+ * @brief hybridizable discontinuous Galerkin (HDG) discretization of the diffusion equation
+ *
+ * -div(mu grad u) = f
+ *
+ * The element unknowns u_K only couple to the trace unknowns lambda on the faces of K
+ * (symmetric interior penalty hybridization):
+ *
+ * a_K(u, lambda; v, m) = (mu grad u, grad v)_K
+ *     - <mu grad u . n, v - m>_dK - <mu grad v . n, u - lambda>_dK
+ *     + <tau (u - lambda), v - m>_dK
+ *
+ * Summing a_K over the elements and testing with m gives the continuity of the numerical flux,
+ * so the element unknowns can be eliminated element by element (see HDGSolver)
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "Numtool/fixed_size_tensor.hpp"
+#include "iceicle/element/TraceSpace.hpp"
+#include "iceicle/element/finite_element.hpp"
+#include "iceicle/geometry/face.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+namespace iceicle {
+
+    /**
+     * @brief the basis of the HDG trace unknowns on a trace and the face geometry at the quadrature points
+     *
+     * The trace basis of the TraceSpace follows the geometry order (it describes the face shape)
+     * so the hybrid unknowns get their own basis: the restriction of the element basis to the face
+     * (from the side with more basis functions), orthonormalized in the L2 inner product of the face.
+     * The restriction of a polynomial space is a polynomial space on the face
+     * so the redundant functions are dropped by the rank test of the Gram Schmidt process
+     *
+     * @tparam T the real number type
+     * @tparam ndim the number of dimensions
+     */
+    template<class T, int ndim>
+    struct HDGTraceBasis {
+        /// @brief the number of quadrature points
+        int nqp = 0;
+
+        /// @brief the number of trace basis functions
+        int nbasis = 0;
+
+        /// @brief the quadrature weight times the surface measure at each quadrature point [nqp]
+        std::vector<T> dsurf{};
+
+        /// @brief the unit normal (pointing out of the left element) [nqp x ndim]
+        std::vector<T> normal{};
+
+        /// @brief the physical domain quadrature points [nqp x ndim]
+        std::vector<T> phys_pt{};
+
+        /// @brief the trace basis functions at each quadrature point [nqp x nbasis]
+        std::vector<T> psi{};
+
+        HDGTraceBasis() = default;
+
+        /**
+         * @brief build the orthonormal trace basis
+         * @param trace the trace
+         * @param coord the node coordinates
+         * @param rank_tol relative norm below which a restricted basis function is considered dependent
+         */
+        template<class IDX>
+        HDGTraceBasis(const TraceSpace<T, IDX, ndim>& trace, NodeArray<T, ndim>& coord, T rank_tol = 1e-10)
+        : nqp{trace.nQP()}, dsurf(trace.nQP()), normal(trace.nQP() * ndim), phys_pt(trace.nQP() * ndim) {
+            using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+            const bool geo_cached = trace.has_geometric_factors();
+            for(int iqp = 0; iqp < nqp; ++iqp){
+                const QuadraturePoint<T, ndim - 1> &quadpt = trace.getQP(iqp);
+                Tensor<T, ndim> unit_normal;
+                MATH::GEOMETRY::Point<T, ndim> x;
+                if(geo_cached){
+                    unit_normal = trace.geo_factors->unit_normal(trace.facidx, iqp);
+                    dsurf[iqp] = trace.geo_factors->dsurf(trace.facidx, iqp);
+                    x = trace.geo_factors->trace_phys_pt(trace.facidx, iqp);
+                } else {
+                    auto Jfac = trace.face->Jacobian(coord, quadpt.abscisse);
+                    dsurf[iqp] = quadpt.weight * trace.face->rootRiemannMetric(Jfac, quadpt.abscisse);
+                    unit_normal = normalize(calc_ortho(Jfac));
+                    trace.face->transform(quadpt.abscisse, coord, x);
+                }
+                for(int idim = 0; idim < ndim; ++idim){
+                    normal[iqp * ndim + idim] = unit_normal[idim];
+                    phys_pt[iqp * ndim + idim] = x[idim];
+                }
+            }
+
+            // restriction of the richer element basis
+            const bool use_right = trace.face->bctype == BOUNDARY_CONDITIONS::INTERIOR
+                && trace.nbasisR() > trace.nbasisL();
+            const int ncandidate = use_right ? trace.nbasisR() : trace.nbasisL();
+            auto inner = [&](const T* a, const T* b){
+                T sum = 0;
+                for(int iqp = 0; iqp < nqp; ++iqp) sum += dsurf[iqp] * a[iqp] * b[iqp];
+                return sum;
+            };
+
+            // modified Gram Schmidt (two passes) on the values at the quadrature points
+            std::vector<T> accepted{};
+            std::vector<T> v(nqp);
+            for(int icand = 0; icand < ncandidate; ++icand){
+                for(int iqp = 0; iqp < nqp; ++iqp){
+                    v[iqp] = use_right ? trace.eval_basis_r_qp(iqp)[icand] : trace.eval_basis_l_qp(iqp)[icand];
+                }
+                T norm0 = std::sqrt(inner(v.data(), v.data()));
+                if(norm0 == 0) continue;
+                for(int ipass = 0; ipass < 2; ++ipass){
+                    for(int ib = 0; ib < nbasis; ++ib){
+                        const T* psi_b = accepted.data() + ib * nqp;
+                        T c = inner(v.data(), psi_b);
+                        for(int iqp = 0; iqp < nqp; ++iqp) v[iqp] -= c * psi_b[iqp];
+                    }
+                }
+                T norm = std::sqrt(inner(v.data(), v.data()));
+                if(norm <= rank_tol * norm0) continue;
+                for(int iqp = 0; iqp < nqp; ++iqp) accepted.push_back(v[iqp] / norm);
+                ++nbasis;
+            }
+
+            // transpose to [nqp x nbasis]
+            psi.resize(nqp * nbasis);
+            for(int ib = 0; ib < nbasis; ++ib){
+                for(int iqp = 0; iqp < nqp; ++iqp) psi[iqp * nbasis + ib] = accepted[ib * nqp + iqp];
+            }
+        }
+
+        /// @brief the value of trace basis function ibasis at quadrature point iqp
+        [[nodiscard]] auto operator[](int iqp, int ibasis) const noexcept -> T
+        { return psi[iqp * nbasis + ibasis]; }
+
+        /// @brief the measure of the face
+        [[nodiscard]] auto measure() const noexcept -> T {
+            T sum = 0;
+            for(T ds : dsurf) sum += ds;
+            return sum;
+        }
+    };
+
+    /**
+     * @brief HDG discretization of -div(mu grad u) = f
+     *
+     * Provides the element matrices of the hybridized form,
+     * all matrices are row major:
+     * A: element-element [nbasis x nbasis]
+     * B: element-trace [nbasis x ntrace_dof of the element]
+     * C: trace-trace [ntrace_dof x ntrace_dof of the element]
+     *
+     * Boundary conditions: DIRICHLET (u = g, the trace unknowns are set to the projection of g)
+     * and NEUMANN (grad u . n = g), both with the bcflag as the index into the callbacks
+     *
+     * @tparam T the real number type
+     * @tparam ndim the number of dimensions
+     */
+    template<class T, int ndim>
+    struct HDGDiffusion {
+        using value_type = T;
+
+        /// @brief the number of vector components
+        static constexpr int nv_comp = 1;
+
+        /// @brief the number of dimensions
+        static constexpr int dimensionality = ndim;
+
+        /// @brief the diffusion coefficient (positive)
+        T mu = 1.0;
+
+        /// @brief the scaling of the stabilization tau (see stabilization())
+        T penalty = 2.0;
+
+        /// @brief the source term f(x, out) (no source if empty)
+        std::function<void(const T*, T*)> source{};
+
+        /// @brief the dirichlet values u(x, out) for each bcflag
+        std::vector< std::function<void(const T*, T*)> > dirichlet_callbacks{};
+
+        /// @brief the outward normal derivatives grad u . n (x, out) for each bcflag
+        std::vector< std::function<void(const T*, T*)> > neumann_callbacks{};
+
+        /**
+         * @brief the stabilization on the faces of an element
+         * tau = penalty * mu * (p + 1)(p + ndim) / ndim * |dK| / |K|
+         * (the trace inverse inequality bound that keeps A of each element positive definite)
+         * @param el the element
+         * @param bdy_measure the measure of the boundary of the element |dK|
+         */
+        template<class IDX>
+        [[nodiscard]] auto stabilization(const FiniteElement<T, IDX, ndim>& el, T bdy_measure) const -> T {
+            T volume = 0;
+            for(int ig = 0; ig < el.nQP(); ++ig){
+                const QuadraturePoint<T, ndim> quadpt = el.getQP(ig);
+                volume += quadpt.weight * NUMTOOL::TENSOR::FIXED_SIZE::determinant(el.jacobian(quadpt.abscisse));
+            }
+            int order = el.basis->getPolynomialOrder();
+            return penalty * mu * (order + 1) * (order + ndim) / ndim * bdy_measure / volume;
+        }
+
+        /**
+         * @brief the volume terms of an element
+         * @param el the element
+         * @param [out] A the element-element matrix (added to)
+         * @param [out] F the source term (added to)
+         */
+        template<class IDX>
+        auto domain_operator(const FiniteElement<T, IDX, ndim>& el, T* A, T* F) const -> void {
+            const int nbasis = el.nbasis();
+            std::vector<T> grad_data(nbasis * ndim);
+            for(int ig = 0; ig < el.nQP(); ++ig){
+                const QuadraturePoint<T, ndim> quadpt = el.getQP(ig);
+                auto J = el.jacobian(quadpt.abscisse);
+                T dvol = quadpt.weight * NUMTOOL::TENSOR::FIXED_SIZE::determinant(J);
+                auto gradb = el.eval_phys_grad_basis(quadpt.abscisse, J, el.eval_grad_basis_qp(ig), grad_data.data());
+                for(int ibasis = 0; ibasis < nbasis; ++ibasis){
+                    for(int jbasis = 0; jbasis < nbasis; ++jbasis){
+                        T dot = 0;
+                        for(int idim = 0; idim < ndim; ++idim) dot += gradb[ibasis, idim] * gradb[jbasis, idim];
+                        A[ibasis * nbasis + jbasis] += dvol * mu * dot;
+                    }
+                }
+                if(source){
+                    MATH::GEOMETRY::Point<T, ndim> x = el.transform(quadpt.abscisse);
+                    T f;
+                    source(x, &f);
+                    auto bi = el.eval_basis_qp(ig);
+                    for(int ibasis = 0; ibasis < nbasis; ++ibasis) F[ibasis] += dvol * f * bi[ibasis];
+                }
+            }
+        }
+
+        /**
+         * @brief the face terms of an element on one side of a trace
+         * @param trace the trace
+         * @param right true for the right element of the trace (the normal is flipped)
+         * @param tbasis the HDG trace basis of the trace
+         * @param tau the stabilization of the element
+         * @param [out] A the element-element matrix (added to)
+         * @param [out] B the element-trace matrix (added to)
+         * @param ldb the number of columns of B
+         * @param [out] C the trace-trace matrix (added to)
+         * @param ldc the number of columns of C
+         * @param offset the index of the first trace dof of this trace in the element trace dofs
+         */
+        template<class IDX>
+        auto trace_operator(
+            const TraceSpace<T, IDX, ndim>& trace,
+            bool right,
+            const HDGTraceBasis<T, ndim>& tbasis,
+            T tau,
+            T* A, T* B, int ldb, T* C, int ldc, int offset
+        ) const -> void {
+            const int nbasis = right ? trace.nbasisR() : trace.nbasisL();
+            const int ntbasis = tbasis.nbasis;
+            const T sign = right ? -1.0 : 1.0;
+            std::vector<T> grad_data(nbasis * ndim);
+            std::vector<T> dn(nbasis);
+            for(int iqp = 0; iqp < tbasis.nqp; ++iqp){
+                const T ds = tbasis.dsurf[iqp];
+                auto bi = right ? trace.eval_basis_r_qp(iqp) : trace.eval_basis_l_qp(iqp);
+                auto gradb = right ? trace.eval_phys_grad_basis_r_qp(iqp, grad_data.data())
+                    : trace.eval_phys_grad_basis_l_qp(iqp, grad_data.data());
+
+                // the diffusive flux of each basis function through the face
+                for(int ibasis = 0; ibasis < nbasis; ++ibasis){
+                    T dot = 0;
+                    for(int idim = 0; idim < ndim; ++idim)
+                        { dot += gradb[ibasis, idim] * tbasis.normal[iqp * ndim + idim]; }
+                    dn[ibasis] = sign * mu * dot;
+                }
+
+                for(int ibasis = 0; ibasis < nbasis; ++ibasis){
+                    for(int jbasis = 0; jbasis < nbasis; ++jbasis){
+                        A[ibasis * nbasis + jbasis] += ds * (tau * bi[ibasis] * bi[jbasis]
+                            - dn[jbasis] * bi[ibasis] - dn[ibasis] * bi[jbasis]);
+                    }
+                    for(int jt = 0; jt < ntbasis; ++jt){
+                        B[ibasis * ldb + offset + jt] += ds * (dn[ibasis] - tau * bi[ibasis]) * tbasis[iqp, jt];
+                    }
+                }
+                for(int it = 0; it < ntbasis; ++it){
+                    for(int jt = 0; jt < ntbasis; ++jt){
+                        C[(offset + it) * ldc + offset + jt] += ds * tau * tbasis[iqp, it] * tbasis[iqp, jt];
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief the trace unknowns on a dirichlet face: the L2 projection of the dirichlet value
+         * (the trace basis is orthonormal so no solve is needed)
+         * @param trace the boundary trace
+         * @param tbasis the HDG trace basis of the trace
+         * @param [out] lambda the trace unknowns [tbasis.nbasis]
+         */
+        template<class IDX>
+        auto dirichlet_values(const TraceSpace<T, IDX, ndim>& trace,
+                const HDGTraceBasis<T, ndim>& tbasis, T* lambda) const -> void {
+            std::fill_n(lambda, tbasis.nbasis, 0.0);
+            const auto& g = dirichlet_callbacks[trace.face->bcflag];
+            for(int iqp = 0; iqp < tbasis.nqp; ++iqp){
+                T gval;
+                g(tbasis.phys_pt.data() + iqp * ndim, &gval);
+                for(int it = 0; it < tbasis.nbasis; ++it) lambda[it] += tbasis.dsurf[iqp] * gval * tbasis[iqp, it];
+            }
+        }
+
+        /**
+         * @brief the flux on a neumann face tested with the trace basis: <mu g, m>
+         * @param trace the boundary trace
+         * @param tbasis the HDG trace basis of the trace
+         * @param [out] rhs the contributions to the trace equations (added to) [tbasis.nbasis]
+         */
+        template<class IDX>
+        auto neumann_rhs(const TraceSpace<T, IDX, ndim>& trace,
+                const HDGTraceBasis<T, ndim>& tbasis, T* rhs) const -> void {
+            const auto& g = neumann_callbacks[trace.face->bcflag];
+            for(int iqp = 0; iqp < tbasis.nqp; ++iqp){
+                T gval;
+                g(tbasis.phys_pt.data() + iqp * ndim, &gval);
+                for(int it = 0; it < tbasis.nbasis; ++it) rhs[it] += tbasis.dsurf[iqp] * mu * gval * tbasis[iqp, it];
+            }
+        }
+    };
+}
@@ -0,0 +1,203 @@
+/**
+ * @brief analytic floating point operation and memory traffic models of the discretization kernels
+ * for roofline analysis (achieved GFLOP/s and GB/s, see Profiler::add_work)
+ *
+ * The counts follow the quadrature loops of the dense (non sum-factorized) kernels:
+ * a multiply-add is 2 flops and physics dependent flux costs come from flux_flops().
+ * The bytes are the compulsory traffic of the element-unique data
+ * (solution and residual coefficients, cached geometric factors at the quadrature points);
+ * the reference basis tables are shared between elements and assumed to stay in cache.
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <ranges>
+#include <type_traits>
+
+namespace iceicle {
+
+    /// @brief the analytic floating point operations and bytes moved by a kernel
+    struct kernel_work {
+        double flops = 0.0;
+        double bytes = 0.0;
+
+        auto operator+=(const kernel_work& other) noexcept -> kernel_work& {
+            flops += other.flops;
+            bytes += other.bytes;
+            return *this;
+        }
+
+        friend auto operator+(kernel_work a, const kernel_work& b) noexcept -> kernel_work { return a += b; }
+
+        friend auto operator*(double n, const kernel_work& a) noexcept -> kernel_work
+        { return kernel_work{n * a.flops, n * a.bytes}; }
+
+        /// @brief the arithmetic intensity in flops per byte
+        [[nodiscard]] auto intensity() const noexcept -> double
+        { return (bytes > 0.0) ? flops / bytes : 0.0; }
+    };
+
+    /// @brief a flux that states the floating point operations of one evaluation
+    template<class FluxT>
+    concept counts_flops = requires { { FluxT::flops_per_eval } -> std::convertible_to<double>; };
+
+    /**
+     * @brief the floating point operations of one flux evaluation at a point
+     * the flops_per_eval of the flux if it has one,
+     * otherwise an estimate of 4 flops per component and direction
+     */
+    template<class FluxT>
+    constexpr auto flux_flops(int neq, int ndim) noexcept -> double {
+        if constexpr (counts_flops<FluxT>) return FluxT::flops_per_eval;
+        else return 4.0 * neq * ndim;
+    }
+
+    namespace kernel_model {
+
+        /**
+         * @brief the domain integral of an element
+         * @param nbasis the number of basis functions
+         * @param nqp the number of quadrature points
+         * @param neq the number of equations
+         * @param ndim the number of dimensions
+         * @param phys_flux_flops the flops of the physical flux at a point
+         * @param value_bytes the size of a floating point value
+         */
+        constexpr auto domain_integral(std::size_t nbasis, std::size_t nqp, int neq, int ndim,
+                double phys_flux_flops, std::size_t value_bytes) noexcept -> kernel_work {
+            double nb = nbasis, nq = nqp;
+            double per_qp =
+                2.0 * nb * ndim * ndim            // physical basis gradients
+                + 2.0 * nb * neq * (1 + ndim)     // solution and gradient
+                + phys_flux_flops
+                + 3.0 * nb * neq * ndim;          // test function gradients times the flux and measure
+            return kernel_work{
+                .flops = nq * per_qp,
+                // the coefficients in, the residual in and out, the inverse jacobian and measure
+                .bytes = (double) value_bytes * (3.0 * nb * neq + nq * (ndim * ndim + 1))
+            };
+        }
+
+        /**
+         * @brief the trace integral of an interior (or parallel) trace with the DDG diffusive flux
+         * @param nbasisL the number of basis functions of the left element
+         * @param nbasisR the number of basis functions of the right element (0 for a boundary)
+         * @param nqp the number of quadrature points
+         * @param neq the number of equations
+         * @param ndim the number of dimensions
+         * @param numflux_flops the flops of the convective numerical flux at a point
+         * @param diff_flux_flops the flops of the diffusive flux at a point
+         * @param value_bytes the size of a floating point value
+         */
+        constexpr auto trace_integral(std::size_t nbasisL, std::size_t nbasisR, std::size_t nqp, int neq, int ndim,
+                double numflux_flops, double diff_flux_flops, std::size_t value_bytes) noexcept -> kernel_work {
+            double nb = nbasisL + nbasisR, nq = nqp;
+            double per_qp =
+                2.0 * nb * ndim * ndim                    // physical basis gradients
+                + 2.0 * nb * neq * (1 + ndim + ndim * ndim) // solution, gradient, and hessian on each side
+                + numflux_flops + diff_flux_flops
+                + 2.0 * nb * neq * (1 + ndim);            // test function values and gradients
+            return kernel_work{
+                .flops = nq * per_qp,
+                // the coefficients in, the residual in and out,
+                // the normal, measure, and inverse jacobians of each side
+                .bytes = (double) value_bytes * (3.0 * nb * neq + nq * (ndim + 1 + 2 * ndim * ndim))
+            };
+        }
+
+        /**
+         * @brief gather the element local data of n values (extract_elspan)
+         * @param n the number of values (ndof * nv)
+         * @param value_bytes the size of a floating point value
+         */
+        constexpr auto extract_elspan(std::size_t n, std::size_t value_bytes) noexcept -> kernel_work
+        { return kernel_work{.flops = 0.0, .bytes = 2.0 * n * value_bytes}; }
+
+        /**
+         * @brief scatter y = alpha * x + beta * y of n values (scatter_elspan)
+         * @param n the number of values (ndof * nv)
+         * @param value_bytes the size of a floating point value
+         */
+        constexpr auto scatter_elspan(std::size_t n, std::size_t value_bytes) noexcept -> kernel_work
+        { return kernel_work{.flops = 3.0 * n, .bytes = 3.0 * n * value_bytes}; }
+
+        /**
+         * @brief apply dense element inverse mass matrices out = alpha M^{-1} res + beta out
+         * @param nmatrix_entries the total number of inverse mass matrix entries (sum of nbasis^2)
+         * @param n the total number of values (ndof * nv)
+         * @param nv the number of vector components
+         * @param beta_nonzero if out is read (beta != 0)
+         * @param value_bytes the size of a floating point value
+         */
+        constexpr auto inverse_mass(std::size_t nmatrix_entries, std::size_t n, std::size_t nv,
+                bool beta_nonzero, std::size_t value_bytes) noexcept -> kernel_work {
+            return kernel_work{
+                .flops = 2.0 * nmatrix_entries * nv + (beta_nonzero ? 3.0 : 1.0) * n,
+                .bytes = (double) value_bytes * (nmatrix_entries + (beta_nonzero ? 3.0 : 2.0) * n)
+            };
+        }
+    }
+
+    /// @brief the flops of the physical, convective numerical, and diffusive fluxes of a discretization
+    template<class disc_class>
+    constexpr auto disc_flux_flops(const disc_class& disc, int ndim) noexcept -> std::array<double, 3> {
+        constexpr int neq = disc_class::nv_comp;
+        if constexpr (requires { disc.phys_flux; disc.conv_nflux; disc.diff_flux; }) {
+            return {
+                flux_flops<std::remove_cvref_t<decltype(disc.phys_flux)>>(neq, ndim),
+                flux_flops<std::remove_cvref_t<decltype(disc.conv_nflux)>>(neq, ndim),
+                flux_flops<std::remove_cvref_t<decltype(disc.diff_flux)>>(neq, ndim)
+            };
+        } else {
+            return {4.0 * neq * ndim, 4.0 * neq * ndim, 4.0 * neq * ndim};
+        }
+    }
+
+    /**
+     * @brief the work of the domain integrals of a set of elements
+     * including the gather of the solution and scatter of the residual
+     * @tparam T the floating point type
+     * @tparam ndim the number of dimensions
+     * @param elements a range of the elements (FiniteElement)
+     */
+    template<class T, int ndim, class disc_class, std::ranges::input_range R>
+    auto domain_work(const disc_class& disc, R&& elements) -> kernel_work {
+        constexpr int neq = disc_class::nv_comp;
+        auto [phys_flops, numflux_flops, diff_flops] = disc_flux_flops(disc, ndim);
+        kernel_work work{};
+        for(const auto& el : elements){
+            std::size_t n = el.nbasis() * neq;
+            work += kernel_model::domain_integral(el.nbasis(), el.nQP(), neq, ndim, phys_flops, sizeof(T));
+            work += kernel_model::extract_elspan(n, sizeof(T));
+            work += kernel_model::scatter_elspan(n, sizeof(T));
+        }
+        return work;
+    }
+
+    /**
+     * @brief the work of the trace integrals of a set of traces
+     * including the gather of the solutions and scatter of the residuals
+     * @tparam T the floating point type
+     * @tparam ndim the number of dimensions
+     * @param traces a range of the traces (TraceSpace)
+     * @param one_sided only one side is gathered and scattered (boundary and parallel traces)
+     */
+    template<class T, int ndim, class disc_class, std::ranges::input_range R>
+    auto trace_work(const disc_class& disc, R&& traces, bool one_sided) -> kernel_work {
+        constexpr int neq = disc_class::nv_comp;
+        auto [phys_flops, numflux_flops, diff_flops] = disc_flux_flops(disc, ndim);
+        kernel_work work{};
+        for(const auto& trace : traces){
+            std::size_t nbL = trace.elL.nbasis(), nbR = trace.elR.nbasis();
+            std::size_t nlocal = (one_sided ? nbL : nbL + nbR) * neq;
+            work += kernel_model::trace_integral(nbL, nbR, trace.nQP(), neq, ndim,
+                    numflux_flops, diff_flops, sizeof(T));
+            work += kernel_model::extract_elspan(nlocal, sizeof(T));
+            work += kernel_model::scatter_elspan(nlocal, sizeof(T));
+        }
+        return work;
+    }
+}
@@ -10,7 +10,10 @@
 #include "iceicle/fe_function/fespan.hpp"
 #include "iceicle/iceicle_mpi_utils.hpp"
 #include "iceicle/quadrature/QuadratureRule.hpp"
+#include "iceicle/reproducible_sum.hpp"
+#include "iceicle/thread_utils.hpp"
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <iceicle/fespace/fespace.hpp>
 #include <functional>
@@ -33,6 +36,9 @@ namespace iceicle {
      * @param fespace the finite element space
      * @param coord the node coordinate array 
      * @param fedata the finite element solution coefficients
+     * @return the l2 error over all processes
+     *   (the squared error is summed with util::reduction_sum so it does not depend
+     *   on the number of threads or processes)
      */
     template<
         class T,
@@ -49,48 +55,68 @@ namespace iceicle {
         using Element = FiniteElement<T, IDX, ndim>;
         using Point = MATH::GEOMETRY::Point<T, ndim>;
 
-        std::vector<T> l2_eq(fedata.nv(), 0.0);
-        // reserve data
-        std::vector<T> feval(fedata.nv());
-        std::vector<T> u(fedata.nv());
-
-        // loop over quadrature points
-        for(const Element &el : fespace.elements) {
-            for(int iqp = 0; iqp < el.nQP(); ++iqp) {
-                // convert the quadrature point to the physical domain
-                const QuadraturePoint<T, ndim> quadpt = el.getQP(iqp);
-                Point phys_pt = el.transform(quadpt.abscisse);
+        std::vector<util::reduction_sum<T>> l2_sums(util::max_threads());
+
+        // threaded over elements
+        // NOTE: the exact solution may not be thread safe (i.e if it calls into lua)
+        // so all other work is threaded and exact_sol calls are serialized
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp parallel
+#endif
+        {
+            util::reduction_sum<T>& l2_sum = l2_sums[util::thread_num()];
+
+            // reserve data
+            std::vector<T> feval(fedata.nv());
+            std::vector<T> u(fedata.nv());
+
+            // loop over quadrature points
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp for schedule(static)
+#endif
+            for(std::size_t iel = 0; iel < fespace.elements.size(); ++iel) {
+                const Element &el = fespace.elements[iel];
+                for(int iqp = 0; iqp < el.nQP(); ++iqp) {
+                    // convert the quadrature point to the physical domain
+                    const QuadraturePoint<T, ndim> quadpt = el.getQP(iqp);
+                    Point phys_pt = el.transform(quadpt.abscisse);
 
-                // calculate the jacobian determinant
-                auto J = el.jacobian(quadpt.abscisse);
-                T detJ = NUMTOOL::TENSOR::FIXED_SIZE::determinant(J);
+                    // calculate the jacobian determinant
+                    auto J = el.jacobian(quadpt.abscisse);
+                    T detJ = NUMTOOL::TENSOR::FIXED_SIZE::determinant(J);
 
-                // evaluate the function at the point in the physical domain
-                exact_sol(phys_pt.data(), feval.data());
+                    // evaluate the function at the point in the physical domain
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp critical(iceicle_exact_sol)
+#endif
+                    exact_sol(phys_pt.data(), feval.data());
 
-                // evaluate the basis functions
-                auto bi = el.eval_basis_qp(iqp);
+                    // evaluate the basis functions
+                    auto bi = el.eval_basis_qp(iqp);
 
-                // construct the solution
-                std::fill(u.begin(), u.end(), 0.0);
-                for(IDX ibasis = 0; ibasis < el.nbasis(); ++ibasis){
-                    for(IDX iv = 0; iv < fedata.nv(); ++iv){
-                        u[iv] += bi[ibasis] * fedata[el.elidx, ibasis, iv];
+                    // construct the solution
+                    std::fill(u.begin(), u.end(), 0.0);
+                    for(IDX ibasis = 0; ibasis < el.nbasis(); ++ibasis){
+                        for(IDX iv = 0; iv < fedata.nv(); ++iv){
+                            u[iv] += bi[ibasis] * fedata[el.elidx, ibasis, iv];
+                        }
                     }
-                }
 
-                // add the contribution of the squared error
-                // NOTE: use a safegaurded jacobian for inverted elements
-                for(IDX ieq = 0; ieq < fedata.nv(); ieq++){
-                    l2_eq[ieq] += std::pow(u[ieq] - feval[ieq], 2) * quadpt.weight 
-                        * std::abs(detJ);
+                    // add the contribution of the squared error
+                    // NOTE: use a safegaurded jacobian for inverted elements
+                    for(IDX ieq = 0; ieq < fedata.nv(); ieq++){
+                        l2_sum += std::pow(u[ieq] - feval[ieq], 2) * quadpt.weight
+                            * std::abs(detJ);
+                    }
                 }
             }
         }
 
-        T l2_sum = 0;
-        for(int ieq = 0; ieq < fedata.nv(); ++ieq){ l2_sum += l2_eq[ieq]; }
-        return std::sqrt(l2_sum);
+        // combine the threads then the processes
+        std::array<util::reduction_sum<T>, 1> l2_sum{};
+        for(const auto& thread_sum : l2_sums) l2_sum[0] += thread_sum;
+        mpi::allreduce_sums(std::span{l2_sum});
+        return std::sqrt(l2_sum[0].value());
     }
 
     /**
@@ -126,47 +152,61 @@ namespace iceicle {
         using Point = MATH::GEOMETRY::Point<T, ndim>;
        
         auto coord = fespace.meshptr->coord;
-        std::vector<T> l1_eq(fedata.nv(), 0.0);
-        // reserve data
-        std::vector<T> feval(fedata.nv());
-        std::vector<T> u(fedata.nv());
+        T l1_sum = 0;
 
-        // loop over quadrature points
-        for(const Element &el : fespace.elements) {
-            for(int iqp = 0; iqp < el.nQP(); ++iqp) {
-                // convert the quadrature point to the physical domain
-                const QuadraturePoint<T, ndim> quadpt = el.getQP(iqp);
-                Point phys_pt = el.transform(quadpt.abscisse);
+        // threaded over elements
+        // NOTE: the exact solution may not be thread safe (i.e if it calls into lua)
+        // so all other work is threaded and exact_sol calls are serialized
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp parallel reduction(+:l1_sum)
+#endif
+        {
+            // reserve data
+            std::vector<T> feval(fedata.nv());
+            std::vector<T> u(fedata.nv());
+
+            // loop over quadrature points
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp for schedule(static)
+#endif
+            for(std::size_t iel = 0; iel < fespace.elements.size(); ++iel) {
+                const Element &el = fespace.elements[iel];
+                for(int iqp = 0; iqp < el.nQP(); ++iqp) {
+                    // convert the quadrature point to the physical domain
+                    const QuadraturePoint<T, ndim> quadpt = el.getQP(iqp);
+                    Point phys_pt = el.transform(quadpt.abscisse);
 
-                // calculate the jacobian determinant
-                auto J = el.jacobian(quadpt.abscisse);
-                T detJ = NUMTOOL::TENSOR::FIXED_SIZE::determinant(J);
+                    // calculate the jacobian determinant
+                    auto J = el.jacobian(quadpt.abscisse);
+                    T detJ = NUMTOOL::TENSOR::FIXED_SIZE::determinant(J);
 
-                // evaluate the function at the point in the physical domain
-                exact_sol(phys_pt.data(), feval.data());
+                    // evaluate the function at the point in the physical domain
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp critical(iceicle_exact_sol)
+#endif
+                    exact_sol(phys_pt.data(), feval.data());
 
-                // evaluate the basis functions
-                auto bi = el.eval_basis_qp(iqp);
+                    // evaluate the basis functions
+                    auto bi = el.eval_basis_qp(iqp);
 
-                // construct the solution
-                std::fill(u.begin(), u.end(), 0.0);
-                for(IDX ibasis = 0; ibasis < el.nbasis(); ++ibasis){
-                    for(IDX iv = 0; iv < fedata.nv(); ++iv){
-                        u[iv] += bi[ibasis] * fedata[el.elidx, ibasis, iv];
+                    // construct the solution
+                    std::fill(u.begin(), u.end(), 0.0);
+                    for(IDX ibasis = 0; ibasis < el.nbasis(); ++ibasis){
+                        for(IDX iv = 0; iv < fedata.nv(); ++iv){
+                            u[iv] += bi[ibasis] * fedata[el.elidx, ibasis, iv];
+                        }
                     }
-                }
 
-                // add the contribution of the squared error
-                // NOTE: use a safegaurded jacobian for inverted elements
-                for(IDX ieq = 0; ieq < fedata.nv(); ieq++){
-                    l1_eq[ieq] += std::abs(u[ieq] - feval[ieq]) * quadpt.weight
-                        * std::abs(detJ);
+                    // add the contribution of the absolute error
+                    // NOTE: use a safegaurded jacobian for inverted elements
+                    for(IDX ieq = 0; ieq < fedata.nv(); ieq++){
+                        l1_sum += std::abs(u[ieq] - feval[ieq]) * quadpt.weight
+                            * std::abs(detJ);
+                    }
                 }
             }
         }
 
-        T l1_sum = 0;
-        for(int ieq = 0; ieq < fedata.nv(); ++ieq){ l1_sum += l1_eq[ieq]; }
         return l1_sum;
     }
 
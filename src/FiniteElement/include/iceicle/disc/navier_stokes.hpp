@@ -1,10 +1,18 @@
 #pragma once
 #include "Numtool/MathUtils.hpp"
 #include "iceicle/anomaly_log.hpp"
+#include "iceicle/bitset.hpp"
+#include "iceicle/dual_number.hpp"
 #include "iceicle/geometry/face.hpp"
 #include <Numtool/fixed_size_tensor.hpp>
 #include <iceicle/linalg/linalg_utils.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <functional>
+#include <limits>
+#include <span>
+#include <vector>
 
 namespace iceicle {
     namespace navier_stokes {
@@ -90,6 +98,73 @@ namespace iceicle {
             }
         };
 
+        /**
+         * @brief the thermodynamic states of a block of points in structure of arrays form
+         * so that the state computation of many quadrature points can vectorize 
+         * and be shared between the fluxes evaluated at those points
+         *
+         * @tparam block_size the maximum number of points in the block
+         */
+        template<class real, int ndim, int block_size = 32>
+        struct ThermodynamicStateBlock {
+            static constexpr int capacity = block_size;
+            using Values = std::array<real, block_size>;
+
+            /// @brief the number of points in the block
+            int npoint = 0;
+
+            /// @brief the members of ThermodynamicState for each point
+            Values rho;
+            std::array<Values, ndim> momentum;
+            Values rhoE;
+            Values gamma;
+            Values cp;
+            std::array<Values, ndim> velocity;
+            Values T;
+            Values vv;
+            Values p;
+            Values csound;
+            Values e;
+            Values E;
+            Values H;
+
+            /// @brief the thermodynamic state at a point in the block
+            [[nodiscard]] inline constexpr
+            auto state(int ipoint) const noexcept -> ThermodynamicState<real, ndim> {
+                ThermodynamicState<real, ndim> out{
+                    .rho = rho[ipoint], .momentum{}, .rhoE = rhoE[ipoint],
+                    .gamma = gamma[ipoint], .cp = cp[ipoint], .velocity{},
+                    .T = T[ipoint], .vv = vv[ipoint], .p = p[ipoint],
+                    .csound = csound[ipoint], .e = e[ipoint], .E = E[ipoint], .H = H[ipoint]
+                };
+                for(int idim = 0; idim < ndim; ++idim){
+                    out.momentum[idim] = momentum[idim][ipoint];
+                    out.velocity[idim] = velocity[idim][ipoint];
+                }
+                return out;
+            }
+
+            /// @brief set the thermodynamic state at a point in the block
+            inline constexpr
+            auto set_state(int ipoint, const ThermodynamicState<real, ndim>& state) noexcept -> void {
+                rho[ipoint] = state.rho;
+                rhoE[ipoint] = state.rhoE;
+                gamma[ipoint] = state.gamma;
+                cp[ipoint] = state.cp;
+                T[ipoint] = state.T;
+                vv[ipoint] = state.vv;
+                p[ipoint] = state.p;
+                csound[ipoint] = state.csound;
+                e[ipoint] = state.e;
+                E[ipoint] = state.E;
+                H[ipoint] = state.H;
+                for(int idim = 0; idim < ndim; ++idim){
+                    momentum[idim][ipoint] = state.momentum[idim];
+                    velocity[idim][ipoint] = state.velocity[idim];
+                }
+            }
+        };
+
         /// @brief the gradients of flow state quantities
         template< class T, int ndim >
         struct FlowStateGradients {
@@ -223,6 +298,15 @@ namespace iceicle {
             {std::invoke(visc, T)} -> std::same_as<typename visc_fcn::real_t>;
         };
 
+        /// @brief viscosity functions that can evaluate many temperatures at once
+        /// visc.batch(temps, mus) so the loop over points can vectorize
+        template<class visc_fcn>
+        concept batched_viscosity_fcn = is_viscosity_fcn<visc_fcn> &&
+        requires(const visc_fcn visc, std::span<const typename visc_fcn::real_t> temps,
+                std::span<typename visc_fcn::real_t> mus) {
+            { visc.batch(temps, mus) } -> std::same_as<void>;
+        };
+
         /// @brief viscosity function that just returns the value given
         template< class real >
         struct constant_viscosity {
@@ -234,6 +318,10 @@ namespace iceicle {
             -> real {
                 return mu;
             }
+
+            /// @brief evaluate the viscosity at each temperature
+            auto batch(std::span<const real> temps, std::span<real> mus) const noexcept -> void
+            { std::ranges::fill(mus.first(temps.size()), mu); }
         };
 
         /// @brief Dimensional form of Sutherlands Law for temperature dependence of viscosity
@@ -253,7 +341,14 @@ namespace iceicle {
             [[nodiscard]] inline constexpr
             auto operator()(real temp) const noexcept
             -> real {
-                return mu_0 * std::pow(temp / T_0, 1.5) * (T_0 + T_s) / (temp + T_s);
+                // (T / T_0)^1.5 without the call to pow
+                real theta = temp / T_0;
+                return mu_0 * theta * std::sqrt(theta) * (T_0 + T_s) / (temp + T_s);
+            }
+
+            /// @brief evaluate the viscosity at each temperature
+            auto batch(std::span<const real> temps, std::span<real> mus) const noexcept -> void {
+                for(std::size_t i = 0; i < temps.size(); ++i) mus[i] = (*this)(temps[i]);
             }
         };
 
@@ -284,9 +379,148 @@ namespace iceicle {
             [[nodiscard]] inline constexpr
             auto operator()(real That) const noexcept
             -> real {
-                return mu_ratio * std::pow(That / T_0_ratio, 1.5)
+                // (That / T_0_ratio)^1.5 without the call to pow
+                real theta = That / T_0_ratio;
+                return mu_ratio * theta * std::sqrt(theta)
                     * (T_0_ratio + T_s_ratio) / (That + T_s_ratio);
             }
+
+            /// @brief evaluate the viscosity at each temperature
+            auto batch(std::span<const real> temps, std::span<real> mus) const noexcept -> void {
+                for(std::size_t i = 0; i < temps.size(); ++i) mus[i] = (*this)(temps[i]);
+            }
+        };
+
+        /**
+         * @brief a tabulated viscosity law with a guaranteed relative error
+         * to replace the transcendental functions of a viscosity law (i.e Sutherlands) 
+         * with a table lookup and a cubic polynomial
+         *
+         * [T_min, T_max] is split into uniform intervals and on each interval
+         * the law is replaced by the cubic through the 4 nearest nodes.
+         * On construction the interpolant is compared to the law at nsample_check points
+         * in every interval and the intervals are halved until the relative error 
+         * at all the check points is below rel_tol (max_rel_error is the achieved value).
+         * Outside of [T_min, T_max] the law is evaluated directly
+         *
+         * @tparam real the real number type
+         */
+        template< class real >
+        struct TabulatedViscosity {
+            using real_t = real;
+
+            /// @brief the number of points checked against the law in each interval
+            static constexpr int nsample_check = 8;
+
+            /// @brief the law used outside the table range
+            std::function<real(real)> law;
+
+            /// @brief the temperature range of the table
+            real T_min, T_max;
+
+            /// @brief the reciprocal of the interval size
+            real h_inv = 1.0;
+
+            /// @brief the cubic coefficients in the local coordinate t in [0, 1) for each interval
+            /// mu = c[0] + t * (c[1] + t * (c[2] + t * c[3]))
+            std::vector<std::array<real, 4>> coeffs{};
+
+            /// @brief the largest relative error at the check points
+            real max_rel_error = 0.0;
+
+            /**
+             * @brief tabulate a viscosity law 
+             * @param visc the viscosity law
+             * @param T_min the minimum temperature of the table
+             * @param T_max the maximum temperature of the table
+             * @param rel_tol the relative error bound to satisfy at the check points
+             * @param max_intervals the limit on the number of intervals
+             *  (an anomaly is logged if rel_tol is not reached within this limit)
+             */
+            template<is_viscosity_fcn visc_fcn>
+            TabulatedViscosity(visc_fcn visc, real T_min, real T_max, 
+                    real rel_tol = 1e-10, int max_intervals = 1 << 16)
+            : law{visc}, T_min{T_min}, T_max{T_max}
+            {
+                for(int nint = 16; ; nint *= 2){
+                    tabulate(nint);
+                    max_rel_error = 0.0;
+                    for(int iint = 0; iint < nint; ++iint){
+                        for(int isample = 0; isample < nsample_check; ++isample){
+                            real temp = T_min + (iint + (isample + 0.5) / nsample_check) / h_inv;
+                            real mu_exact = law(temp);
+                            max_rel_error = std::max(max_rel_error, 
+                                    std::abs((*this)(temp) - mu_exact) / std::abs(mu_exact));
+                        }
+                    }
+                    if(max_rel_error <= rel_tol) break;
+                    if(2 * nint > max_intervals) {
+                        util::AnomalyLog::log_anomaly(util::Anomaly{"Tabulated viscosity did not reach the "
+                            "requested tolerance within the maximum number of intervals", util::general_anomaly_tag{}});
+                        break;
+                    }
+                }
+            }
+
+            [[nodiscard]] inline 
+            auto operator()(real temp) const noexcept -> real {
+                if(!(temp >= T_min && temp <= T_max)) return law(temp);
+                return eval_table(temp);
+            }
+
+            /// @brief evaluate the viscosity at each temperature 
+            /// (the table lookups are branch free, and out of range temperatures are corrected after)
+            auto batch(std::span<const real> temps, std::span<real> mus) const noexcept -> void {
+                bool any_out_of_range = false;
+                for(std::size_t i = 0; i < temps.size(); ++i){
+                    real temp = std::clamp(temps[i], T_min, T_max);
+                    any_out_of_range = any_out_of_range || (temp != temps[i]);
+                    mus[i] = eval_table(temp);
+                }
+                if(any_out_of_range){
+                    for(std::size_t i = 0; i < temps.size(); ++i)
+                        if(!(temps[i] >= T_min && temps[i] <= T_max)) mus[i] = law(temps[i]);
+                }
+            }
+
+            private:
+
+            /// @brief evaluate the table for a temperature in [T_min, T_max]
+            [[nodiscard]] inline 
+            auto eval_table(real temp) const noexcept -> real {
+                real x = (temp - T_min) * h_inv;
+                int iint = std::min((int) x, (int) coeffs.size() - 1);
+                real t = x - iint;
+                const std::array<real, 4>& c = coeffs[iint];
+                return c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+            }
+
+            /// @brief build the cubic coefficients for nint intervals
+            auto tabulate(int nint) -> void {
+                real h = (T_max - T_min) / nint;
+                h_inv = 1.0 / h;
+                std::vector<real> node_mu(nint + 1);
+                for(int inode = 0; inode <= nint; ++inode) node_mu[inode] = law(T_min + inode * h);
+
+                coeffs.resize(nint);
+                for(int iint = 0; iint < nint; ++iint){
+                    // the 4 nearest nodes, shifted inward at the ends of the table
+                    int ifirst = std::clamp(iint - 1, 0, nint - 3);
+                    real s = iint - ifirst; // local coordinate of the interval start in the stencil
+                    const real* f = node_mu.data() + ifirst;
+
+                    // newton form in the stencil coordinate x = s + t at nodes 0, 1, 2, 3
+                    real d1 = f[1] - f[0];
+                    real d2 = (f[2] - 2 * f[1] + f[0]) / 2;
+                    real d3 = (f[3] - 3 * f[2] + 3 * f[1] - f[0]) / 6;
+                    // p(x) = f0 + d1 x + d2 x (x - 1) + d3 x (x - 1) (x - 2) expanded about x = s
+                    real a0 = f[0] + d1 * s + d2 * s * (s - 1) + d3 * s * (s - 1) * (s - 2);
+                    real a1 = d1 + d2 * (2 * s - 1) + d3 * (3 * s * s - 6 * s + 2);
+                    real a2 = d2 + d3 * (3 * s - 3);
+                    real a3 = d3;
+                    coeffs[iint] = std::array<real, 4>{a0, a1, a2, a3};
+                }
+            }
         };
 
         /// @brief a type is an equation of state if it 
@@ -391,48 +625,52 @@ namespace iceicle {
             /// @brief given a state vector of a given variable set 
             /// compute the dimensionless thermodynamic quantities
             /// @tparam variable_set which variable set is stored in the u array 
+            /// @tparam U the state number type (real or a dual number of real)
             /// @param u the dimensionless state vector of the given variable set 
             /// @param ref the reference parameters
             /// @param nondim reference dimensionless parameters
-            template<VARSET variable_set>
+            template<VARSET variable_set, class U>
             [[nodiscard]] inline constexpr
             auto calc_thermo_state(
-                const std::array<real, nv_comp> u,
+                const std::array<U, nv_comp> u,
                 const ReferenceParameters<real> ref,
                 const Nondimensionalization<real> nondim
-            ) const noexcept -> ThermodynamicState<real, ndim>
+            ) const noexcept -> ThermodynamicState<U, ndim>
             {
+                using std::max;
+                using std::sqrt;
+                using StateVector = NUMTOOL::TENSOR::FIXED_SIZE::Tensor<U, ndim>;
                 if constexpr(variable_set == VARSET::CONSERVATIVE) {
                     static constexpr int irho = 0;
                     static constexpr int irhou = 1;
                     static constexpr int irhoe = ndim + 1;
 
-                    real rho = std::max(MIN_DENSITY, u[0]);
-                    Vector momentum, velocity;
-                    real vv = 0;
+                    U rho = max(MIN_DENSITY, u[0]);
+                    StateVector momentum, velocity;
+                    U vv = 0;
                     for(int idim = 0; idim < ndim; ++idim) {
                         momentum[idim] = u[irhou + idim];
                         velocity[idim] = u[irhou + idim] / rho;
                         vv += velocity[idim] * velocity[idim];
                     }
-                    real rhoE = u[irhoe];
+                    U rhoE = u[irhoe];
                     real cp = (gamma) / (gamma - 1) * Rgas;
 
                     // temperature coefficient
                     real T_coeff = cp * ref.T * ref.rho / ref.p;
 
-                    real E = rhoE / rho;
-                    real e = E - 0.5 * nondim.e_coeff * vv;
+                    U E = rhoE / rho;
+                    U e = E - 0.5 * nondim.e_coeff * vv;
 
-                    real p = std::max(MIN_PRESSURE, 
+                    U p = max(MIN_PRESSURE, 
                             (gamma - 1) / (nondim.e_coeff * nondim.Eu) * rho * e);
 
-                    real T = p / rho * gamma / (gamma - 1) / T_coeff;
+                    U T = p / rho * gamma / (gamma - 1) / T_coeff;
 
-                    real csound = sqrt((gamma * nondim.Eu * p) / rho);
+                    U csound = sqrt((gamma * nondim.Eu * p) / rho);
 
-                    real H = E + p / rho;
-                    return ThermodynamicState<real, ndim>{
+                    U H = E + p / rho;
+                    return ThermodynamicState<U, ndim>{
                         .rho = rho,
                         .momentum = momentum,
                         .rhoE = rhoE,
@@ -452,28 +690,28 @@ namespace iceicle {
                     static constexpr int iu = 1;
                     static constexpr int iT = ndim + 1;
 
-                    real rho = std::max(MIN_DENSITY, u[irho]);
-                    Vector momentum, velocity;
-                    real vv = 0;
+                    U rho = max(MIN_DENSITY, u[irho]);
+                    StateVector momentum, velocity;
+                    U vv = 0;
                     for(int idim = 0; idim < ndim; ++idim) {
                         velocity[idim] = u[iu + idim];
                         momentum[idim] = u[iu + idim] * rho;
                         vv += velocity[idim] * velocity[idim];
                     }
-                    real T = u[iT];
+                    U T = u[iT];
                     real cp = (gamma) / (gamma - 1) * Rgas;
 
                     // temperature coefficient
                     real T_coeff = cp * ref.T * ref.rho / ref.p;
-                    real p = std::max(MIN_PRESSURE, 
+                    U p = max(MIN_PRESSURE, 
                             rho * (gamma - 1) / gamma * T_coeff * T);
-                    real e = p * nondim.e_coeff * nondim.Eu / (gamma - 1) / rho;
-                    real E = e + 0.5 * nondim.e_coeff * vv;
-                    real rhoE = rho * E;
-                    real csound = sqrt((gamma * nondim.Eu * p) / rho);
-                    real H = E + p / rho;
+                    U e = p * nondim.e_coeff * nondim.Eu / (gamma - 1) / rho;
+                    U E = e + 0.5 * nondim.e_coeff * vv;
+                    U rhoE = rho * E;
+                    U csound = sqrt((gamma * nondim.Eu * p) / rho);
+                    U H = E + p / rho;
 
-                    return ThermodynamicState<real, ndim>{
+                    return ThermodynamicState<U, ndim>{
                         .rho = rho,
                         .momentum = momentum,
                         .rhoE = rhoE,
@@ -493,27 +731,27 @@ namespace iceicle {
                     static constexpr int iu = 1;
                     static constexpr int ip = ndim + 1;
 
-                    real rho = std::max(MIN_DENSITY, u[irho]);
-                    real p = std::max(MIN_PRESSURE, u[ip]);
+                    U rho = max(MIN_DENSITY, u[irho]);
+                    U p = max(MIN_PRESSURE, u[ip]);
                     real cp = (gamma) / (gamma - 1) * Rgas;
                     // temperature coefficient
                     real T_coeff = cp * ref.T * ref.rho / ref.p;
-                    real T = p / rho * gamma / (gamma - 1) / T_coeff;
+                    U T = p / rho * gamma / (gamma - 1) / T_coeff;
 
-                    Vector momentum, velocity;
-                    real vv = 0;
+                    StateVector momentum, velocity;
+                    U vv = 0;
                     for(int idim = 0; idim < ndim; ++idim) {
                         velocity[idim] = u[iu + idim];
                         momentum[idim] = u[iu + idim] * rho;
                         vv += velocity[idim] * velocity[idim];
                     }
-                    real e = p * nondim.e_coeff * nondim.Eu / (gamma - 1) / rho;
-                    real E = e + 0.5 * nondim.e_coeff * vv;
-                    real rhoE = rho * E;
-                    real csound = sqrt((gamma * nondim.Eu * p) / rho);
-                    real H = E + p / rho;
+                    U e = p * nondim.e_coeff * nondim.Eu / (gamma - 1) / rho;
+                    U E = e + 0.5 * nondim.e_coeff * vv;
+                    U rhoE = rho * E;
+                    U csound = sqrt((gamma * nondim.Eu * p) / rho);
+                    U H = E + p / rho;
 
-                    return ThermodynamicState<real, ndim>{
+                    return ThermodynamicState<U, ndim>{
                         .rho = rho,
                         .momentum = momentum,
                         .rhoE = rhoE,
@@ -533,30 +771,120 @@ namespace iceicle {
             }
 
 
+            /**
+             * @brief compute the thermodynamic states of a block of points
+             * from structure of arrays state vectors [component x point]
+             *
+             * Same quantities as calc_thermo_state, but the loop over points is branch free
+             * and the reciprocal of the density is computed once per point so it can vectorize
+             *
+             * @tparam variable_set which variable set is stored in the u array 
+             * @param u the dimensionless state vectors of the given variable set
+             * @param ipoint_begin the first point of u in the block 
+             *   (the block holds min(capacity, u.extent(1) - ipoint_begin) points)
+             * @param ref the reference parameters
+             * @param nondim reference dimensionless parameters
+             * @param [out] block the thermodynamic states
+             */
+            template<VARSET variable_set, int block_size>
+            inline constexpr
+            auto calc_thermo_state_block(
+                std::mdspan<const real, std::extents<int, nv_comp, std::dynamic_extent>> u,
+                int ipoint_begin,
+                const ReferenceParameters<real> ref,
+                const Nondimensionalization<real> nondim,
+                ThermodynamicStateBlock<real, ndim, block_size>& block
+            ) const noexcept -> void {
+                const int npoint = std::min(block_size, (int) u.extent(1) - ipoint_begin);
+                block.npoint = npoint;
+
+                const real cp = (gamma) / (gamma - 1) * Rgas;
+                // temperature coefficient
+                const real T_coeff = cp * ref.T * ref.rho / ref.p;
+                // p = p_coeff * rho * e
+                const real p_coeff = (gamma - 1) / (nondim.e_coeff * nondim.Eu);
+                const real T_from_p = gamma / (gamma - 1) / T_coeff;
+                const real c_coeff = gamma * nondim.Eu;
+
+                for(int i = 0; i < npoint; ++i){
+                    const int ipoint = ipoint_begin + i;
+                    real rho = std::max(MIN_DENSITY, u[0, ipoint]);
+                    real rho_inv = 1.0 / rho;
+                    real vv = 0;
+                    real p, E, T;
+                    if constexpr(variable_set == VARSET::CONSERVATIVE) {
+                        for(int idim = 0; idim < ndim; ++idim){
+                            real momentum = u[1 + idim, ipoint];
+                            real velocity = momentum * rho_inv;
+                            block.momentum[idim][i] = momentum;
+                            block.velocity[idim][i] = velocity;
+                            vv += velocity * velocity;
+                        }
+                        real rhoE = u[ndim + 1, ipoint];
+                        E = rhoE * rho_inv;
+                        real e = E - 0.5 * nondim.e_coeff * vv;
+                        p = std::max(MIN_PRESSURE, p_coeff * rho * e);
+                        T = p * rho_inv * T_from_p;
+                        block.rhoE[i] = rhoE;
+                        block.e[i] = e;
+                    } else {
+                        for(int idim = 0; idim < ndim; ++idim){
+                            real velocity = u[1 + idim, ipoint];
+                            block.momentum[idim][i] = velocity * rho;
+                            block.velocity[idim][i] = velocity;
+                            vv += velocity * velocity;
+                        }
+                        if constexpr (variable_set == VARSET::RHO_U_T) {
+                            T = u[ndim + 1, ipoint];
+                            p = std::max(MIN_PRESSURE, rho / T_from_p * T);
+                        } else { // variable_set == VARSET::RHO_U_P
+                            p = std::max(MIN_PRESSURE, u[ndim + 1, ipoint]);
+                            T = p * rho_inv * T_from_p;
+                        }
+                        real e = p * rho_inv / p_coeff;
+                        E = e + 0.5 * nondim.e_coeff * vv;
+                        block.rhoE[i] = rho * E;
+                        block.e[i] = e;
+                    }
+                    block.rho[i] = rho;
+                    block.gamma[i] = gamma;
+                    block.cp[i] = cp;
+                    block.T[i] = T;
+                    block.vv[i] = vv;
+                    block.p[i] = p;
+                    block.csound[i] = std::sqrt(c_coeff * p * rho_inv);
+                    block.E[i] = E;
+                    block.H[i] = E + p * rho_inv;
+                }
+            }
+
             /// @brief given a state vector of a given variable set 
             /// compute the dimensionless thermodynamic quantities
             /// @tparam variable_set which variable set is stored in the u array 
+            /// @tparam U the state number type (real or a dual number of real)
             /// @param state the thermodynamic state
             /// @param gradu the dimensionless state vector gradients of the given variable set 
             // NOTE: the output gradients will be with respect to the same coordinates as gradu 
             //
             /// @param ref the reference parameters
             /// @param nondim reference dimensionless parameters
-            template<VARSET variable_set>
+            template<VARSET variable_set, class U>
             [[nodiscard]] inline constexpr
             auto calc_state_gradients(
-                const ThermodynamicState<real, ndim> state,
+                const ThermodynamicState<U, ndim> state,
                 const linalg::in_tensor auto gradu,
                 const ReferenceParameters<real> ref,
                 const Nondimensionalization<real> nondim
-            ) const noexcept -> FlowStateGradients<real, ndim>
+            ) const noexcept -> FlowStateGradients<U, ndim>
             {
+                using StateVector = NUMTOOL::TENSOR::FIXED_SIZE::Tensor<U, ndim>;
+                using StateTensor = NUMTOOL::TENSOR::FIXED_SIZE::Tensor<U, ndim, ndim>;
                 if constexpr(variable_set == VARSET::CONSERVATIVE){
                     static constexpr int irho = 0;
                     static constexpr int irhou = 1;
                     static constexpr int irhoe = ndim + 1;
 
-                    Tensor grad_vel;
+                    StateTensor grad_vel;
 
                     // calculate velocity gradients
                     for(int idim = 0; idim < ndim; ++idim){
@@ -566,16 +894,16 @@ namespace iceicle {
                         }
                     }
 
-                    Vector grad_E;
+                    StateVector grad_E;
                     for(int jdim = 0; jdim < ndim; ++jdim){
                         grad_E[jdim] = (
                             gradu[irhoe, jdim] - state.E * gradu[irho, jdim]
                         ) / state.rho;
                     }
 
-//                     real T_coeff = state.cp * ref.T * ref.rho / ref.p;
+//                     U T_coeff = state.cp * ref.T * ref.rho / ref.p;
 //                    // calculate temperature gradient 
-//                    Vector grad_temp;
+//                    StateVector grad_temp;
 //                    for(int jdim = 0; jdim < ndim; ++jdim){
 //                        real mult = (state.gamma / T_coeff / nondim.Eu); 
 //                        grad_temp[jdim] = 
@@ -584,12 +912,12 @@ namespace iceicle {
 //                            grad_temp[jdim] += mult * state.velocity[kdim] * grad_vel[kdim, jdim];
 //                        }
 //                    }
-                    return FlowStateGradients<real, ndim>{grad_vel, grad_E};
+                    return FlowStateGradients<U, ndim>{grad_vel, grad_E};
                 } else if constexpr (variable_set == VARSET::RHO_U_T) {
                     static constexpr int irho = 0;
                     static constexpr int iu = 1;
                     static constexpr int iT = ndim + 1;
-                    Tensor grad_vel;
+                    StateTensor grad_vel;
                     for(int idim = 0; idim < ndim; ++idim){
                         for(int jdim = 0; jdim < ndim; ++jdim){
                             grad_vel[idim][jdim] = gradu[iu + idim, jdim];
@@ -597,14 +925,14 @@ namespace iceicle {
                     }
 
                     // calculate temperature gradient 
-                    Vector grad_temp;
+                    StateVector grad_temp;
                     for(int jdim = 0; jdim < ndim; ++jdim){
                         grad_temp[jdim] = gradu[iT, jdim];
                     }
 
                     // calculate the total energy gradient
-                    real T_coeff = state.cp * ref.T * ref.rho / ref.p;
-                    Vector grad_E;
+                    U T_coeff = state.cp * ref.T * ref.rho / ref.p;
+                    StateVector grad_E;
                     for(int jdim = 0; jdim < ndim; ++jdim){
                         grad_E[jdim] = grad_temp[jdim] * T_coeff * nondim.Eu / state.gamma;
                         for(int kdim = 0; kdim < ndim; ++kdim){
@@ -612,20 +940,20 @@ namespace iceicle {
                         }
                         grad_E *= nondim.e_coeff * state.rho;
                     }
-                    return FlowStateGradients<real, ndim>{grad_vel, grad_E};
+                    return FlowStateGradients<U, ndim>{grad_vel, grad_E};
                 } else { // variable_set = VARSET::RHO_U_P
                     static constexpr int irho = 0;
                     static constexpr int iu = 1;
                     static constexpr int ip = ndim + 1;
-                    Tensor grad_vel;
+                    StateTensor grad_vel;
                     for(int idim = 0; idim < ndim; ++idim){
                         for(int jdim = 0; jdim < ndim; ++jdim){
                             grad_vel[idim][jdim] = gradu[iu + idim, jdim];
                         }
                     }
 
-                    real T_coeff = state.cp * ref.T * ref.rho / ref.p;
-                    Vector grad_temp;
+                    U T_coeff = state.cp * ref.T * ref.rho / ref.p;
+                    StateVector grad_temp;
                     for(int jdim = 0; jdim < ndim; ++jdim){
                         // quotient rule
                         grad_temp[jdim] = (gradu[ip, jdim] * state.rho - gradu[irho] * state.p)
@@ -633,7 +961,7 @@ namespace iceicle {
                     }
 
                     // calculate the total energy gradient
-                    Vector grad_E;
+                    StateVector grad_E;
                     for(int jdim = 0; jdim < ndim; ++jdim){
                         grad_E[jdim] = grad_temp[jdim] * T_coeff * nondim.Eu / state.gamma;
                         for(int kdim = 0; kdim < ndim; ++kdim){
@@ -641,7 +969,7 @@ namespace iceicle {
                         }
                         grad_E *= nondim.e_coeff * state.rho;
                     }
-                    return FlowStateGradients<real, ndim>{grad_vel, grad_E};
+                    return FlowStateGradients<U, ndim>{grad_vel, grad_E};
                 }
             }
         };
@@ -661,6 +989,9 @@ namespace iceicle {
             /// @brief number of variables
             static constexpr int nv_comp = ndim + 2;
 
+            /// @brief the variable set of the solution
+            static constexpr VARSET variable_set = varset;
+
             /// @brief Prandtl number 
             const real Pr;
 
@@ -670,6 +1001,10 @@ namespace iceicle {
             /// @brief viscosity function
             const std::function<real(real)> viscosity;
 
+            /// @brief viscosity function for many temperatures at once: viscosity_batch(temps, mus)
+            /// (uses the batch() of the viscosity law if it has one, see batched_viscosity_fcn)
+            const std::function<void(std::span<const real>, std::span<real>)> viscosity_batch;
+
             /// @brief the nondimensionalization
             const Nondimensionalization<real> nondim;
 
@@ -688,25 +1023,66 @@ namespace iceicle {
                 EoS eos,          /// @param the equation of state
                 is_viscosity_fcn auto viscosity, /// @param the viscosity function
                 real Pr = 0.72       /// @param Prandtl number
-            ) : Pr{Pr}, ref{ref}, viscosity{viscosity},
+            ) : Pr{Pr}, ref{ref}, viscosity{viscosity}, 
+                viscosity_batch{make_viscosity_batch(viscosity)},
                 nondim{create_nondim(ref)}, eos{eos}
             {}
 
+            /// @brief the batched evaluation of a viscosity law
+            template<is_viscosity_fcn visc_fcn>
+            static auto make_viscosity_batch(visc_fcn visc)
+            -> std::function<void(std::span<const real>, std::span<real>)> {
+                if constexpr (batched_viscosity_fcn<visc_fcn>) {
+                    return [visc](std::span<const real> temps, std::span<real> mus){ visc.batch(temps, mus); };
+                } else {
+                    return [visc](std::span<const real> temps, std::span<real> mus){
+                        for(std::size_t i = 0; i < temps.size(); ++i) mus[i] = visc(temps[i]);
+                    };
+                }
+            }
+
+            /// @brief evaluate the viscosity law at a temperature
+            /// for a dual number temperature the derivative of the law is 
+            /// a central difference of the (type erased, real valued) law
+            /// @tparam U the state number type (real or a dual number of real)
+            /// @param temp the temperature
+            template<class U>
+            [[nodiscard]] inline
+            auto calc_viscosity(const U& temp) const -> U {
+                if constexpr (util::is_dual_v<U>) {
+                    real t = util::primal(temp);
+                    real h = std::cbrt(std::numeric_limits<real>::epsilon()) * std::max((real) 1, std::abs(t));
+                    real dmu = (viscosity(t + h) - viscosity(t - h)) / (2 * h);
+                    return util::chain(temp, viscosity(t), dmu);
+                } else {
+                    return viscosity(temp);
+                }
+            }
+
             /// @brief calculate the nondimensional shear stress 
             /// given the thermodynamic state and flow gradients 
             /// @param state the thermodynamic stae 
             /// @param grads the flow state gradients
+            template<class U>
             [[nodiscard]] inline constexpr 
             auto calc_shear_stress(
-                    ThermodynamicState<real, ndim>& state, FlowStateGradients<real, ndim>& grads)
-            const noexcept -> Tensor {
-                // get the viscosity
-                real mu = viscosity(state.T);
+                    ThermodynamicState<U, ndim>& state, FlowStateGradients<U, ndim>& grads)
+            const noexcept -> NUMTOOL::TENSOR::FIXED_SIZE::Tensor<U, ndim, ndim>
+            { return calc_shear_stress(grads, calc_viscosity(state.T)); }
 
+            /// @brief calculate the nondimensional shear stress 
+            /// given the flow gradients and the viscosity (i.e shared with the heat flux)
+            /// @tparam U the state number type (real or a dual number of real)
+            /// @param grads the flow state gradients
+            /// @param mu the viscosity at the state
+            template<class U>
+            [[nodiscard]] inline constexpr 
+            auto calc_shear_stress(const FlowStateGradients<U, ndim>& grads, U mu)
+            const noexcept -> NUMTOOL::TENSOR::FIXED_SIZE::Tensor<U, ndim, ndim> {
                 const auto& dudx = grads.velocity_gradient;
 
-                Tensor tau;
-                real dukduk = 0;
+                NUMTOOL::TENSOR::FIXED_SIZE::Tensor<U, ndim, ndim> tau;
+                U dukduk = 0;
                 for(int k = 0; k < ndim; ++k){
                     dukduk += dudx[k, k];
                 }
@@ -726,15 +1102,28 @@ namespace iceicle {
             /// given the thermodynamic state and flow gradients 
             /// @param state the thermodynamic state 
             /// @param grads the flow state gradients
+            template<class U>
             [[nodiscard]] inline constexpr 
             auto calc_heat_flux(
-                    ThermodynamicState<real, ndim>& state, FlowStateGradients<real, ndim>& grads)
-            const noexcept -> Vector {
-                real mu = viscosity(state.T);
+                    ThermodynamicState<U, ndim>& state, FlowStateGradients<U, ndim>& grads)
+            const noexcept -> NUMTOOL::TENSOR::FIXED_SIZE::Tensor<U, ndim>
+            { return calc_heat_flux(state, grads, calc_viscosity(state.T)); }
+
+            /// @brief calculate the nondimensional heat flux
+            /// given the thermodynamic state, flow gradients, and the viscosity
+            /// @tparam U the state number type (real or a dual number of real)
+            /// @param state the thermodynamic state 
+            /// @param grads the flow state gradients
+            /// @param mu the viscosity at the state
+            template<class U>
+            [[nodiscard]] inline constexpr 
+            auto calc_heat_flux(const ThermodynamicState<U, ndim>& state,
+                    const FlowStateGradients<U, ndim>& grads, U mu)
+            const noexcept -> NUMTOOL::TENSOR::FIXED_SIZE::Tensor<U, ndim> {
                 const auto& dudx = grads.velocity_gradient;
                 const auto& dEdx = grads.E_gradient;
 
-                Vector q;
+                NUMTOOL::TENSOR::FIXED_SIZE::Tensor<U, ndim> q;
                 for(int jdim = 0; jdim < ndim; ++jdim){
                     q[jdim] = dEdx[jdim] / nondim.e_coeff;
                     for(int kdim = 0; kdim < ndim; ++kdim){
@@ -747,13 +1136,37 @@ namespace iceicle {
 
             // @brief given a state vector in the native variable set (varset)
             // get the thermodynamic state from the EoS
+            // @tparam U the state number type (real or a dual number of real)
             // @param u the state vector 
             // @return the thermodynamic state
+            template<class U>
             [[nodiscard]] inline constexpr 
-            auto calc_thermo_state(std::array<real, nv_comp> u)
-            const noexcept -> ThermodynamicState<real, ndim>
+            auto calc_thermo_state(std::array<U, nv_comp> u)
+            const noexcept -> ThermodynamicState<U, ndim>
             { return eos.template calc_thermo_state<varset>(u, ref, nondim); }
 
+            /// @brief compute the thermodynamic states for a block of native variable set state vectors 
+            /// [component x point] starting at ipoint_begin 
+            /// (vectorized if the EoS provides calc_thermo_state_block)
+            template<int block_size>
+            inline constexpr
+            auto calc_thermo_state_block(
+                std::mdspan<const real, std::extents<int, nv_comp, std::dynamic_extent>> u,
+                int ipoint_begin,
+                ThermodynamicStateBlock<real, ndim, block_size>& block
+            ) const noexcept -> void {
+                if constexpr (requires{ eos.template calc_thermo_state_block<varset>(u, ipoint_begin, ref, nondim, block); }) {
+                    eos.template calc_thermo_state_block<varset>(u, ipoint_begin, ref, nondim, block);
+                } else {
+                    block.npoint = std::min(block_size, (int) u.extent(1) - ipoint_begin);
+                    for(int i = 0; i < block.npoint; ++i){
+                        std::array<real, nv_comp> upt;
+                        for(int ieq = 0; ieq < nv_comp; ++ieq) upt[ieq] = u[ieq, ipoint_begin + i];
+                        block.set_state(i, calc_thermo_state(upt));
+                    }
+                }
+            }
+
             // @brief given a thermodynamic state and native variable set gradients
             // get the flow state gradients 
             // @param state the thermodynamic state
@@ -761,11 +1174,12 @@ namespace iceicle {
             // NOTE: gradients are wrt same coordinates as gradu
             //
             // @return the thermodynamic state
+            template<class U>
             [[nodiscard]] inline constexpr 
             auto calc_thermo_state_gradients(
-                ThermodynamicState<real, ndim> state,
+                ThermodynamicState<U, ndim> state,
                 linalg::in_tensor auto gradu
-            ) const noexcept -> FlowStateGradients<real, ndim>
+            ) const noexcept -> FlowStateGradients<U, ndim>
             { return eos.template calc_state_gradients<varset>(state, gradu, ref, nondim); }
         };
 
@@ -788,25 +1202,30 @@ namespace iceicle {
 
             Physics<T, ndim, EoS, varset> physics;
 
+            /// @brief the Van Leer flux normal to the interface
+            /// @tparam U the state number type (T or a dual number of T)
+            template<class U>
             inline constexpr
             auto operator()(
-                std::array<T, nv_comp> uL,
-                std::array<T, nv_comp> uR,
+                std::array<U, nv_comp> uL,
+                std::array<U, nv_comp> uR,
                 Vector unit_normal
-            ) const noexcept -> std::array<T, neq> {
-                using namespace NUMTOOL::TENSOR::FIXED_SIZE;
-                ThermodynamicState<T, ndim> stateL = physics.calc_thermo_state(uL);
-                ThermodynamicState<T, ndim> stateR = physics.calc_thermo_state(uR);
+            ) const noexcept -> std::array<U, neq> {
+                ThermodynamicState<U, ndim> stateL = physics.calc_thermo_state(uL);
+                ThermodynamicState<U, ndim> stateR = physics.calc_thermo_state(uR);
 
                 // normal velocity 
-                T vnormalL = dot(stateL.velocity, unit_normal);
-                T vnormalR = dot(stateR.velocity, unit_normal);
+                U vnormalL = 0, vnormalR = 0;
+                for(int idim = 0; idim < ndim; ++idim){
+                    vnormalL += stateL.velocity[idim] * unit_normal[idim];
+                    vnormalR += stateR.velocity[idim] * unit_normal[idim];
+                }
 
                 // normal mach numbers 
-                T machL = vnormalL / stateL.csound;
-                T machR = vnormalR / stateR.csound;
+                U machL = vnormalL / stateL.csound;
+                U machR = vnormalR / stateR.csound;
 
-                std::array<T, neq> flux;
+                std::array<U, neq> flux;
 
                 // compute positive fluxes and add contribution
                 if(machL > 1){
@@ -820,7 +1239,7 @@ namespace iceicle {
                 } else if(machL < -1) {
                     std::ranges::fill(flux, 0);
                 } else {
-                    T fmL = stateL.rho * stateL.csound * SQUARED(machL + 1) / 4.0;
+                    U fmL = stateL.rho * stateL.csound * SQUARED(machL + 1) / 4.0;
                     flux[0] = fmL;
                     for(int idim = 0; idim < ndim; ++idim){
                         flux[1 + idim] = fmL * (
@@ -844,7 +1263,7 @@ namespace iceicle {
                     flux[ndim + 1] += vnormalR * (stateR.rhoE 
                             + physics.nondim.Eu * physics.nondim.e_coeff * stateR.p);
                 } else if (machR <= 1) {
-                    T fmR = -stateR.rho * stateR.csound * SQUARED(machR - 1) / 4.0;
+                    U fmR = -stateR.rho * stateR.csound * SQUARED(machR - 1) / 4.0;
                     flux[0] += fmR;
                     for(int idim = 0; idim < ndim; ++idim){
                         flux[1 + idim] += fmR * (
@@ -861,10 +1280,410 @@ namespace iceicle {
                 
                 return flux;
             }
+
+            /**
+             * @brief compute the Van Leer flux at many points
+             * from structure of arrays data [component x point]
+             *
+             * The thermodynamic states are computed for blocks of points (calc_thermo_state_block)
+             * and the branches on the normal mach numbers are replaced by 0/1 masks
+             * on the supersonic and subsonic splittings so the loop over points is branch free
+             *
+             * @param uL the left states
+             * @param uR the right states
+             * @param unit_normals the unit normal vectors
+             * @param [out] fadvn the normal fluxes
+             */
+            auto batch(
+                std::mdspan<const T, std::extents<int, nv_comp, std::dynamic_extent>> uL,
+                std::mdspan<const T, std::extents<int, nv_comp, std::dynamic_extent>> uR,
+                std::mdspan<const T, std::extents<int, ndim, std::dynamic_extent>> unit_normals,
+                std::mdspan<T, std::extents<int, neq, std::dynamic_extent>> fadvn
+            ) const noexcept -> void {
+                const int npoint = uL.extent(1);
+                const T Eu = physics.nondim.Eu;
+                const T e_coeff = physics.nondim.e_coeff;
+                ThermodynamicStateBlock<T, ndim> stateL, stateR;
+                for(int iblock = 0; iblock < npoint; iblock += stateL.capacity){
+                    physics.calc_thermo_state_block(uL, iblock, stateL);
+                    physics.calc_thermo_state_block(uR, iblock, stateR);
+                    for(int i = 0; i < stateL.npoint; ++i){
+                        const int ipoint = iblock + i;
+                        T vnormalL = 0, vnormalR = 0;
+                        for(int idim = 0; idim < ndim; ++idim){
+                            vnormalL += stateL.velocity[idim][i] * unit_normals[idim, ipoint];
+                            vnormalR += stateR.velocity[idim][i] * unit_normals[idim, ipoint];
+                        }
+                        T machL = vnormalL / stateL.csound[i];
+                        T machR = vnormalR / stateR.csound[i];
+
+                        // same regions as operator()
+                        T supL = (machL > 1) ? 1.0 : 0.0;
+                        T subL = (machL > 1 || machL < -1) ? 0.0 : 1.0;
+                        T supR = (machR < -1) ? 1.0 : 0.0;
+                        T subR = (machR < -1 || !(machR <= 1)) ? 0.0 : 1.0;
+
+                        T fmL = stateL.rho[i] * stateL.csound[i] * SQUARED(machL + 1) / 4.0;
+                        T fmR = -stateR.rho[i] * stateR.csound[i] * SQUARED(machR - 1) / 4.0;
+
+                        fadvn[0, ipoint] = supL * stateL.rho[i] * vnormalL + subL * fmL
+                            + supR * stateR.rho[i] * vnormalR + subR * fmR;
+                        for(int idim = 0; idim < ndim; ++idim){
+                            const T n = unit_normals[idim, ipoint];
+                            fadvn[1 + idim, ipoint] =
+                                supL * (stateL.momentum[idim][i] * vnormalL + Eu * stateL.p[i] * n)
+                                + subL * fmL * (stateL.velocity[idim][i]
+                                    + n * (-vnormalL + 2 * stateL.csound[i]) / stateL.gamma[i])
+                                + supR * (stateR.momentum[idim][i] * vnormalR + Eu * stateR.p[i] * n)
+                                + subR * fmR * (stateR.velocity[idim][i]
+                                    + n * (-vnormalR - 2 * stateR.csound[i]) / stateR.gamma[i]);
+                        }
+                        fadvn[ndim + 1, ipoint] =
+                            supL * vnormalL * (stateL.rhoE[i] + Eu * e_coeff * stateL.p[i])
+                            + subL * fmL * ( (stateL.vv[i] - SQUARED(vnormalL)) / 2
+                                + SQUARED( (stateL.gamma[i] - 1) * vnormalL + 2 * stateL.csound[i])
+                                / (2 * (SQUARED(stateL.gamma[i]) - 1)) )
+                            + supR * vnormalR * (stateR.rhoE[i] + Eu * e_coeff * stateR.p[i])
+                            + subR * fmR * ( (stateR.vv[i] - SQUARED(vnormalR)) / 2
+                                + SQUARED( (stateR.gamma[i] - 1) * vnormalR - 2 * stateR.csound[i])
+                                / (2 * (SQUARED(stateR.gamma[i]) - 1)) );
+                    }
+                }
+            }
         };
         template< class T, int _ndim, is_eos EoS, VARSET varset>
         VanLeer(Physics<T, _ndim, EoS, varset>) -> VanLeer<T, _ndim, EoS, varset>;
 
+        /**
+         * @brief the inviscid flux in the normal direction from a thermodynamic state 
+         * F(u) . n for the pressure Eu * p and the energy flux scaled by e_coeff (as in Flux)
+         */
+        template<class T, int ndim, class VecT>
+        inline constexpr
+        auto normal_inviscid_flux(
+            const ThermodynamicState<T, ndim>& state,
+            const VecT& unit_normal,
+            T vnormal,
+            T Eu,
+            T e_coeff
+        ) noexcept -> std::array<T, ndim + 2> {
+            std::array<T, ndim + 2> flux;
+            flux[0] = state.rho * vnormal;
+            for(int idim = 0; idim < ndim; ++idim)
+                flux[1 + idim] = state.momentum[idim] * vnormal + Eu * state.p * unit_normal[idim];
+            flux[ndim + 1] = vnormal * (state.rhoE + Eu * e_coeff * state.p);
+            return flux;
+        }
+
+        /**
+         * @brief HLLC approximate Riemann solver (Toro, Spruce, and Speares 1994)
+         * with the wavespeed estimates of Einfeldt (1988) from the Roe averages
+         *
+         * In terms of the pressure P = Eu * p and the scaled energy rhoE / e_coeff 
+         * the dimensionless equations are the standard Euler equations with the energy flux scaled by e_coeff.
+         * The four candidate fluxes are all computed and selected with 0/1 masks
+         * so the batched loop over points is branch free
+         */
+        template< class T, int _ndim, is_eos EoS, VARSET varset>
+        struct HLLC {
+
+            static constexpr int ndim = _ndim;
+            using value_type = T;
+
+            using Vector = NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, ndim>;
+
+            /// @brief number of variables
+            static constexpr int nv_comp = ndim + 2;
+            static constexpr int neq = nv_comp;
+
+            Physics<T, ndim, EoS, varset> physics;
+
+            /// @brief the HLLC flux from thermodynamic states
+            inline constexpr
+            auto flux_states(
+                const ThermodynamicState<T, ndim>& stateL,
+                const ThermodynamicState<T, ndim>& stateR,
+                const Vector& unit_normal
+            ) const noexcept -> std::array<T, neq> {
+                const T Eu = physics.nondim.Eu;
+                const T e_coeff = physics.nondim.e_coeff;
+                static constexpr T tiny = 1e-30;
+
+                T vnL = 0, vnR = 0;
+                for(int idim = 0; idim < ndim; ++idim){
+                    vnL += stateL.velocity[idim] * unit_normal[idim];
+                    vnR += stateR.velocity[idim] * unit_normal[idim];
+                }
+                const T PL = Eu * stateL.p, PR = Eu * stateR.p;
+
+                // Roe averages for the wavespeed estimates
+                const T sqrt_rhoL = std::sqrt(stateL.rho), sqrt_rhoR = std::sqrt(stateR.rho);
+                const T wL = sqrt_rhoL / (sqrt_rhoL + sqrt_rhoR), wR = 1 - wL;
+                T vv_roe = 0, vn_roe = 0;
+                for(int idim = 0; idim < ndim; ++idim){
+                    T v = wL * stateL.velocity[idim] + wR * stateR.velocity[idim];
+                    vv_roe += v * v;
+                    vn_roe += v * unit_normal[idim];
+                }
+                // enthalpy with the scaled energy and pressure
+                const T HL = stateL.E / e_coeff + PL / stateL.rho, HR = stateR.E / e_coeff + PR / stateR.rho;
+                const T H_roe = wL * HL + wR * HR;
+                const T gamma = 0.5 * (stateL.gamma + stateR.gamma);
+                const T c_roe = std::sqrt(std::max(tiny, (gamma - 1) * (H_roe - 0.5 * vv_roe)));
+
+                const T SL = std::min(vnL - stateL.csound, vn_roe - c_roe);
+                const T SR = std::max(vnR + stateR.csound, vn_roe + c_roe);
+                const T mL = stateL.rho * (SL - vnL); // < 0
+                const T mR = stateR.rho * (SR - vnR); // > 0
+                const T Sstar = (PR - PL + mL * vnL - mR * vnR) / (mL - mR);
+
+                // the region masks (exactly one is 1)
+                const T fL = (SL >= 0) ? 1.0 : 0.0;
+                const T fsL = (SL < 0 && Sstar >= 0) ? 1.0 : 0.0;
+                const T fsR = (Sstar < 0 && SR > 0) ? 1.0 : 0.0;
+                const T fR = 1.0 - fL - fsL - fsR;
+
+                std::array<T, neq> FL = normal_inviscid_flux(stateL, unit_normal, vnL, Eu, e_coeff);
+                std::array<T, neq> FR = normal_inviscid_flux(stateR, unit_normal, vnR, Eu, e_coeff);
+
+                // star region fluxes F*K = FK + SK (U*K - UK) with protected denominators SK - S*
+                auto safe = [](T d){ return (std::abs(d) < tiny) ? std::copysign(tiny, d) : d; };
+                const T coeffL = mL / safe(SL - Sstar);
+                const T coeffR = mR / safe(SR - Sstar);
+                const T EL = stateL.rhoE / (stateL.rho * e_coeff), ER = stateR.rhoE / (stateR.rho * e_coeff);
+                const T EstarL = EL + (Sstar - vnL) * (Sstar + PL / mL);
+                const T EstarR = ER + (Sstar - vnR) * (Sstar + PR / mR);
+
+                std::array<T, neq> flux;
+                flux[0] = fL * FL[0] + fR * FR[0]
+                    + fsL * (FL[0] + SL * (coeffL - stateL.rho))
+                    + fsR * (FR[0] + SR * (coeffR - stateR.rho));
+                for(int idim = 0; idim < ndim; ++idim){
+                    T ustarL = coeffL * (stateL.velocity[idim] + (Sstar - vnL) * unit_normal[idim]);
+                    T ustarR = coeffR * (stateR.velocity[idim] + (Sstar - vnR) * unit_normal[idim]);
+                    flux[1 + idim] = fL * FL[1 + idim] + fR * FR[1 + idim]
+                        + fsL * (FL[1 + idim] + SL * (ustarL - stateL.momentum[idim]))
+                        + fsR * (FR[1 + idim] + SR * (ustarR - stateR.momentum[idim]));
+                }
+                flux[ndim + 1] = fL * FL[ndim + 1] + fR * FR[ndim + 1]
+                    + fsL * (FL[ndim + 1] + SL * (e_coeff * coeffL * EstarL - stateL.rhoE))
+                    + fsR * (FR[ndim + 1] + SR * (e_coeff * coeffR * EstarR - stateR.rhoE));
+                return flux;
+            }
+
+            inline constexpr
+            auto operator()(
+                std::array<T, nv_comp> uL,
+                std::array<T, nv_comp> uR,
+                Vector unit_normal
+            ) const noexcept -> std::array<T, neq> {
+                return flux_states(physics.calc_thermo_state(uL), physics.calc_thermo_state(uR), unit_normal);
+            }
+
+            /**
+             * @brief compute the HLLC flux at many points
+             * from structure of arrays data [component x point]
+             * with the thermodynamic states computed for blocks of points
+             *
+             * @param uL the left states
+             * @param uR the right states
+             * @param unit_normals the unit normal vectors
+             * @param [out] fadvn the normal fluxes
+             */
+            auto batch(
+                std::mdspan<const T, std::extents<int, nv_comp, std::dynamic_extent>> uL,
+                std::mdspan<const T, std::extents<int, nv_comp, std::dynamic_extent>> uR,
+                std::mdspan<const T, std::extents<int, ndim, std::dynamic_extent>> unit_normals,
+                std::mdspan<T, std::extents<int, neq, std::dynamic_extent>> fadvn
+            ) const noexcept -> void {
+                const int npoint = uL.extent(1);
+                ThermodynamicStateBlock<T, ndim> stateL, stateR;
+                for(int iblock = 0; iblock < npoint; iblock += stateL.capacity){
+                    physics.calc_thermo_state_block(uL, iblock, stateL);
+                    physics.calc_thermo_state_block(uR, iblock, stateR);
+                    for(int i = 0; i < stateL.npoint; ++i){
+                        Vector unit_normal;
+                        for(int idim = 0; idim < ndim; ++idim) unit_normal[idim] = unit_normals[idim, iblock + i];
+                        std::array<T, neq> f = flux_states(stateL.state(i), stateR.state(i), unit_normal);
+                        for(int ieq = 0; ieq < neq; ++ieq) fadvn[ieq, iblock + i] = f[ieq];
+                    }
+                }
+            }
+        };
+        template< class T, int _ndim, is_eos EoS, VARSET varset>
+        HLLC(Physics<T, _ndim, EoS, varset>) -> HLLC<T, _ndim, EoS, varset>;
+
+        /**
+         * @brief Roe approximate Riemann solver (Roe 1981)
+         * with the Harten (1983) entropy fix on the acoustic waves
+         *
+         * F = (F(uL) + F(uR)) / 2 - 1/2 sum_k |lambda_k| alpha_k r_k 
+         * for the pressure P = Eu * p and the scaled energy rhoE / e_coeff (see HLLC).
+         * The entropy fix replaces |lambda| by (lambda^2 + delta^2) / (2 delta) for |lambda| < delta
+         * where delta = entropy_fix * c_roe, computed with a select so the batched loop is branch free
+         */
+        template< class T, int _ndim, is_eos EoS, VARSET varset>
+        struct Roe {
+
+            static constexpr int ndim = _ndim;
+            using value_type = T;
+
+            using Vector = NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, ndim>;
+
+            /// @brief number of variables
+            static constexpr int nv_comp = ndim + 2;
+            static constexpr int neq = nv_comp;
+
+            Physics<T, ndim, EoS, varset> physics;
+
+            /// @brief the entropy fix width as a fraction of the Roe averaged speed of sound
+            T entropy_fix = 0.1;
+
+            /// @brief the Roe flux from thermodynamic states
+            inline constexpr
+            auto flux_states(
+                const ThermodynamicState<T, ndim>& stateL,
+                const ThermodynamicState<T, ndim>& stateR,
+                const Vector& unit_normal
+            ) const noexcept -> std::array<T, neq> {
+                const T Eu = physics.nondim.Eu;
+                const T e_coeff = physics.nondim.e_coeff;
+                static constexpr T tiny = 1e-30;
+
+                T vnL = 0, vnR = 0;
+                for(int idim = 0; idim < ndim; ++idim){
+                    vnL += stateL.velocity[idim] * unit_normal[idim];
+                    vnR += stateR.velocity[idim] * unit_normal[idim];
+                }
+                const T PL = Eu * stateL.p, PR = Eu * stateR.p;
+
+                // Roe averages
+                const T sqrt_rhoL = std::sqrt(stateL.rho), sqrt_rhoR = std::sqrt(stateR.rho);
+                const T wL = sqrt_rhoL / (sqrt_rhoL + sqrt_rhoR), wR = 1 - wL;
+                const T rho_roe = sqrt_rhoL * sqrt_rhoR;
+                Vector v_roe;
+                T vv_roe = 0, vn_roe = 0;
+                for(int idim = 0; idim < ndim; ++idim){
+                    v_roe[idim] = wL * stateL.velocity[idim] + wR * stateR.velocity[idim];
+                    vv_roe += v_roe[idim] * v_roe[idim];
+                    vn_roe += v_roe[idim] * unit_normal[idim];
+                }
+                // enthalpy with the scaled energy and pressure
+                const T HL = stateL.E / e_coeff + PL / stateL.rho, HR = stateR.E / e_coeff + PR / stateR.rho;
+                const T H_roe = wL * HL + wR * HR;
+                const T gamma = 0.5 * (stateL.gamma + stateR.gamma);
+                const T c2_roe = std::max(tiny, (gamma - 1) * (H_roe - 0.5 * vv_roe));
+                const T c_roe = std::sqrt(c2_roe);
+
+                // wave strengths
+                const T drho = stateR.rho - stateL.rho;
+                const T dP = PR - PL;
+                const T dvn = vnR - vnL;
+                const T alpha1 = (dP - rho_roe * c_roe * dvn) / (2 * c2_roe);
+                const T alpha2 = drho - dP / c2_roe;
+                const T alpha3 = (dP + rho_roe * c_roe * dvn) / (2 * c2_roe);
+
+                // eigenvalue magnitudes with the entropy fix on the acoustic waves
+                const T delta = std::max(tiny, entropy_fix * c_roe);
+                auto fix = [delta](T lambda){
+                    T a = std::abs(lambda);
+                    return (a < delta) ? (lambda * lambda + delta * delta) / (2 * delta) : a;
+                };
+                const T l1 = fix(vn_roe - c_roe);
+                const T l2 = std::abs(vn_roe);
+                const T l3 = fix(vn_roe + c_roe);
+
+                std::array<T, neq> FL = normal_inviscid_flux(stateL, unit_normal, vnL, Eu, e_coeff);
+                std::array<T, neq> FR = normal_inviscid_flux(stateR, unit_normal, vnR, Eu, e_coeff);
+
+                // dissipation sum_k |lambda_k| alpha_k r_k (with the shear waves in the momentum terms)
+                T vdv = 0; // v_roe . (dv - dvn n)
+                Vector dv_tangent;
+                for(int idim = 0; idim < ndim; ++idim){
+                    dv_tangent[idim] = (stateR.velocity[idim] - stateL.velocity[idim]) - dvn * unit_normal[idim];
+                    vdv += v_roe[idim] * dv_tangent[idim];
+                }
+                std::array<T, neq> diss;
+                diss[0] = l1 * alpha1 + l2 * alpha2 + l3 * alpha3;
+                for(int idim = 0; idim < ndim; ++idim){
+                    diss[1 + idim] = l1 * alpha1 * (v_roe[idim] - c_roe * unit_normal[idim])
+                        + l2 * (alpha2 * v_roe[idim] + rho_roe * dv_tangent[idim])
+                        + l3 * alpha3 * (v_roe[idim] + c_roe * unit_normal[idim]);
+                }
+                diss[ndim + 1] = e_coeff * (
+                    l1 * alpha1 * (H_roe - vn_roe * c_roe)
+                    + l2 * (alpha2 * 0.5 * vv_roe + rho_roe * vdv)
+                    + l3 * alpha3 * (H_roe + vn_roe * c_roe));
+
+                std::array<T, neq> flux;
+                for(int ieq = 0; ieq < neq; ++ieq) flux[ieq] = 0.5 * (FL[ieq] + FR[ieq] - diss[ieq]);
+                return flux;
+            }
+
+            inline constexpr
+            auto operator()(
+                std::array<T, nv_comp> uL,
+                std::array<T, nv_comp> uR,
+                Vector unit_normal
+            ) const noexcept -> std::array<T, neq> {
+                return flux_states(physics.calc_thermo_state(uL), physics.calc_thermo_state(uR), unit_normal);
+            }
+
+            /**
+             * @brief compute the Roe flux at many points
+             * from structure of arrays data [component x point]
+             * with the thermodynamic states computed for blocks of points
+             *
+             * @param uL the left states
+             * @param uR the right states
+             * @param unit_normals the unit normal vectors
+             * @param [out] fadvn the normal fluxes
+             */
+            auto batch(
+                std::mdspan<const T, std::extents<int, nv_comp, std::dynamic_extent>> uL,
+                std::mdspan<const T, std::extents<int, nv_comp, std::dynamic_extent>> uR,
+                std::mdspan<const T, std::extents<int, ndim, std::dynamic_extent>> unit_normals,
+                std::mdspan<T, std::extents<int, neq, std::dynamic_extent>> fadvn
+            ) const noexcept -> void {
+                const int npoint = uL.extent(1);
+                ThermodynamicStateBlock<T, ndim> stateL, stateR;
+                for(int iblock = 0; iblock < npoint; iblock += stateL.capacity){
+                    physics.calc_thermo_state_block(uL, iblock, stateL);
+                    physics.calc_thermo_state_block(uR, iblock, stateR);
+                    for(int i = 0; i < stateL.npoint; ++i){
+                        Vector unit_normal;
+                        for(int idim = 0; idim < ndim; ++idim) unit_normal[idim] = unit_normals[idim, iblock + i];
+                        std::array<T, neq> f = flux_states(stateL.state(i), stateR.state(i), unit_normal);
+                        for(int ieq = 0; ieq < neq; ++ieq) fadvn[ieq, iblock + i] = f[ieq];
+                    }
+                }
+            }
+        };
+        template< class T, int _ndim, is_eos EoS, VARSET varset>
+        Roe(Physics<T, _ndim, EoS, varset>) -> Roe<T, _ndim, EoS, varset>;
+
+        /// @brief the two point entropy conservative fluxes for flux differencing
+        enum class TWO_POINT_FLUX {
+            ISMAIL_ROE,    /// @brief Ismail and Roe (2009)
+            CHANDRASHEKAR, /// @brief Chandrashekar (2013) also kinetic energy preserving
+        };
+
+        /**
+         * @brief the logarithmic mean (a - b) / (ln a - ln b) of two positive numbers 
+         * with the series expansion of Ismail and Roe (2009) near a = b
+         */
+        template<class real>
+        inline constexpr
+        auto logarithmic_mean(real a, real b) noexcept -> real {
+            real zeta = a / b;
+            real f = (zeta - 1) / (zeta + 1);
+            real u = f * f;
+            real F = (u < 1.0e-2) 
+                ? 1.0 + u / 3.0 + u * u / 5.0 + u * u * u / 7.0
+                : std::log(zeta) / (2.0 * f);
+            return (a + b) / (2.0 * F);
+        }
+
         // @brief the physical flux for navier stokes equations
         // @tparam T the real number type
         // @tparam _ndim the number of dimensions 
@@ -898,6 +1717,19 @@ namespace iceicle {
             /// @brief index of energy density equation
             static constexpr int irhoe = ndim + 1;
 
+            /// @brief the components each equation depends on (see coupled_physical_flux)
+            /// in conservative variables the mass flux is the momentum (no viscous part)
+            /// the momentum and energy fluxes depend on every component through the pressure
+            static constexpr std::array<bitset<nv_comp>, nv_comp> component_coupling = []{
+                std::array<bitset<nv_comp>, nv_comp> coupling{};
+                for(bitset<nv_comp>& row : coupling) row = bitset<nv_comp>{~0ull};
+                if constexpr (varset == VARSET::CONSERVATIVE) {
+                    coupling[irho] = bitset<nv_comp>{};
+                    for(int idim = 0; idim < ndim; ++idim) coupling[irho][irhou + idim] = true;
+                }
+                return coupling;
+            }();
+
             /// @brief the physics implementation
             Physics<real, ndim, EoS, varset> physics;
 
@@ -912,24 +1744,31 @@ namespace iceicle {
 
             mutable real visc_max = 0.0;
 
+            /// @brief the entropy conservative flux used by two_point_flux()
+            TWO_POINT_FLUX two_point_type = TWO_POINT_FLUX::CHANDRASHEKAR;
+
+            /// @brief the physical flux
+            /// @tparam U the state number type (real or a dual number of real)
+            /// @param u the state 
+            /// @param gradu the state gradients
+            template<class U>
             inline constexpr 
             auto operator()(
-                std::array<real, nv_comp> u,
+                std::array<U, nv_comp> u,
                 linalg::in_tensor auto gradu
-            ) const noexcept -> Tensor<real, neq, ndim> {
+            ) const noexcept -> Tensor<U, neq, ndim> {
+                using std::sqrt;
 
-                ThermodynamicState<real, ndim> state = physics.calc_thermo_state(u);
+                ThermodynamicState<U, ndim> state = physics.calc_thermo_state(u);
 
                 // nondimensional quantities
                 real Re = physics.nondim.Re;
                 real e_coeff = physics.nondim.e_coeff;
-                real gamma = state.gamma;
                 real Eu = physics.nondim.Eu;
-                real Pr = physics.Pr;
 
-                lambda_max = state.csound + std::sqrt(state.vv);
+                lambda_max = std::max(lambda_max, (real) util::primal(state.csound + sqrt(state.vv)));
 
-                Tensor<real, neq, ndim> flux;
+                Tensor<U, neq, ndim> flux;
                 // loop over the flux direction j
                 for(int jdim = 0; jdim < ndim; ++jdim) {
                     flux[irho][jdim] = state.momentum[jdim];
@@ -941,21 +1780,21 @@ namespace iceicle {
 
                 if(full_ns) {
                     // get gradients of state
-                    FlowStateGradients<real, ndim> state_grads{physics.calc_thermo_state_gradients(state, gradu)};
+                    FlowStateGradients<U, ndim> state_grads{physics.calc_thermo_state_gradients(state, gradu)};
 
-                    // get the temperature coefficient
-                    real T_coeff = state.cp * physics.ref.T * physics.ref.rho / physics.ref.p;
+                    // the viscosity is shared by the shear stress and heat flux
+                    U mu = physics.calc_viscosity(state.T);
 
                     // get the shear stress
-                    Tensor tau = physics.calc_shear_stress(state, state_grads);
+                    Tensor<U, ndim, ndim> tau = physics.calc_shear_stress(state_grads, mu);
 
                     // get the heat flux 
-                    Vector q = physics.calc_heat_flux(state, state_grads);
+                    Tensor<U, ndim> q = physics.calc_heat_flux(state, state_grads, mu);
 
 
                     // subtract viscous fluxes
                     for(int jdim = 0; jdim < ndim; ++jdim){
-                        real energy_flux = q[jdim];
+                        U energy_flux = q[jdim];
                         for(int idim = 0; idim < ndim; ++idim){
                             flux[irhou + idim][jdim] -= tau[idim][jdim] / Re;
                             energy_flux += state.velocity[idim] * tau[idim][jdim];
@@ -964,14 +1803,93 @@ namespace iceicle {
                         flux[irhoe][jdim] -= energy_flux;
                     }
 
-                    real mu = physics.viscosity(state.T);
-                    visc_max = std::max(visc_max, mu);
-                    gamma_max = std::max(gamma_max, state.gamma);
+                    visc_max = std::max(visc_max, (real) util::primal(mu));
+                    gamma_max = std::max(gamma_max, (real) util::primal(state.gamma));
                 }
                 
                 return flux;
             }
 
+            /**
+             * @brief compute the physical flux at many points 
+             * from structure of arrays data [component x point]
+             *
+             * The thermodynamic states are computed once per block of points (calc_thermo_state_block)
+             * and shared by the convective flux, the viscous flux, and the wavespeed.
+             * The viscosity is evaluated for the whole block (Physics::viscosity_batch).
+             * The convective flux loop over points is branch free so it can vectorize
+             *
+             * @param u the states [nv_comp x npoint]
+             * @param gradu the state gradients [ieq * ndim + jdim x npoint]
+             * @param [out] flux the fluxes [ieq * ndim + jdim x npoint]
+             * @return the maximum wavespeed |v| + c over the points
+             */
+            auto batch(
+                std::mdspan<const real, std::extents<int, nv_comp, std::dynamic_extent>> u,
+                std::mdspan<const real, std::extents<int, nv_comp * ndim, std::dynamic_extent>> gradu,
+                std::mdspan<real, std::extents<int, nv_comp * ndim, std::dynamic_extent>> flux
+            ) const -> real {
+                const int npoint = u.extent(1);
+                const real Re = physics.nondim.Re;
+                const real e_coeff = physics.nondim.e_coeff;
+                const real Eu = physics.nondim.Eu;
+                real lambda_batch = 0.0;
+                ThermodynamicStateBlock<real, ndim> state;
+                for(int iblock = 0; iblock < npoint; iblock += state.capacity){
+                    physics.calc_thermo_state_block(u, iblock, state);
+
+                    // convective fluxes and wavespeeds
+                    for(int i = 0; i < state.npoint; ++i){
+                        const int ipoint = iblock + i;
+                        lambda_batch = std::max(lambda_batch, state.csound[i] + std::sqrt(state.vv[i]));
+                        for(int jdim = 0; jdim < ndim; ++jdim) {
+                            flux[irho * ndim + jdim, ipoint] = state.momentum[jdim][i];
+                            for(int idim = 0; idim < ndim; ++idim)
+                                flux[(irhou + idim) * ndim + jdim, ipoint] 
+                                    = state.momentum[idim][i] * state.velocity[jdim][i];
+                            flux[(irhou + jdim) * ndim + jdim, ipoint] += Eu * state.p[i];
+                            flux[irhoe * ndim + jdim, ipoint] = state.velocity[jdim][i] 
+                                * (state.rhoE[i] + Eu * e_coeff * state.p[i]);
+                        }
+                    }
+
+                    if(full_ns) {
+                        // viscosity of the whole block
+                        std::array<real, ThermodynamicStateBlock<real, ndim>::capacity> mu_block;
+                        physics.viscosity_batch(std::span<const real>{state.T.data(), (std::size_t) state.npoint},
+                                std::span<real>{mu_block.data(), (std::size_t) state.npoint});
+
+                        // viscous fluxes with the shared state
+                        for(int i = 0; i < state.npoint; ++i){
+                            const int ipoint = iblock + i;
+                            ThermodynamicState<real, ndim> state_pt = state.state(i);
+                            std::array<real, neq * ndim> gradu_data;
+                            for(int k = 0; k < neq * ndim; ++k) gradu_data[k] = gradu[k, ipoint];
+                            std::mdspan<const real, std::extents<int, neq, ndim>> gradu_pt{gradu_data.data()};
+                            FlowStateGradients<real, ndim> state_grads{
+                                physics.calc_thermo_state_gradients(state_pt, gradu_pt)};
+
+                            real mu = mu_block[i];
+                            Tensor<real, ndim, ndim> tau = physics.calc_shear_stress(state_grads, mu);
+                            Vector q = physics.calc_heat_flux(state_pt, state_grads, mu);
+                            for(int jdim = 0; jdim < ndim; ++jdim){
+                                real energy_flux = q[jdim];
+                                for(int idim = 0; idim < ndim; ++idim){
+                                    flux[(irhou + idim) * ndim + jdim, ipoint] -= tau[idim][jdim] / Re;
+                                    energy_flux += state_pt.velocity[idim] * tau[idim][jdim];
+                                }
+                                energy_flux *= e_coeff / Re;
+                                flux[irhoe * ndim + jdim, ipoint] -= energy_flux;
+                            }
+                            visc_max = std::max(visc_max, mu);
+                            gamma_max = std::max(gamma_max, state_pt.gamma);
+                        }
+                    }
+                }
+                lambda_max = std::max(lambda_max, lambda_batch);
+                return lambda_batch;
+            }
+
             inline constexpr 
             auto apply_bc(
                 std::array<real, neq> &uL,
@@ -1188,6 +2106,124 @@ ns_wall_bc_tag:
                 return std::pair{uR, graduR};
             }
 
+            /**
+             * @brief the two point entropy conservative flux in a direction for flux differencing
+             * F#(uL, uR) . n for the inviscid part of the flux
+             * F#(u, u) . n = F(u, 0) . n and F# is symmetric in uL and uR
+             *
+             * The fluxes are in terms of the pressure Eu * p 
+             * and the energy flux is scaled by e_coeff to match operator()
+             *
+             * @param uL the first state 
+             * @param uR the second state 
+             * @param n the direction (not normalized, i.e the averaged contravariant metric terms)
+             * @return the two point flux in the direction n
+             */
+            inline constexpr
+            auto two_point_flux(
+                std::array<real, nv_comp> uL,
+                std::array<real, nv_comp> uR,
+                Vector n
+            ) const noexcept -> std::array<real, neq> {
+                ThermodynamicState<real, ndim> stateL = physics.calc_thermo_state(uL);
+                ThermodynamicState<real, ndim> stateR = physics.calc_thermo_state(uR);
+                return two_point_flux_states(stateL, stateR, n);
+            }
+
+            /**
+             * @brief compute the two point flux for many pairs of states
+             * from structure of arrays data [component x point]
+             *
+             * @param uL the first states
+             * @param uR the second states
+             * @param directions the directions
+             * @param [out] flux the two point fluxes
+             */
+            auto two_point_flux_batch(
+                std::mdspan<const real, std::extents<int, nv_comp, std::dynamic_extent>> uL,
+                std::mdspan<const real, std::extents<int, nv_comp, std::dynamic_extent>> uR,
+                std::mdspan<const real, std::extents<int, ndim, std::dynamic_extent>> directions,
+                std::mdspan<real, std::extents<int, neq, std::dynamic_extent>> flux
+            ) const noexcept -> void {
+                const int npoint = uL.extent(1);
+                ThermodynamicStateBlock<real, ndim> stateL, stateR;
+                for(int iblock = 0; iblock < npoint; iblock += stateL.capacity){
+                    physics.calc_thermo_state_block(uL, iblock, stateL);
+                    physics.calc_thermo_state_block(uR, iblock, stateR);
+                    for(int i = 0; i < stateL.npoint; ++i){
+                        Vector n;
+                        for(int idim = 0; idim < ndim; ++idim) n[idim] = directions[idim, iblock + i];
+                        std::array<real, neq> f = two_point_flux_states(stateL.state(i), stateR.state(i), n);
+                        for(int ieq = 0; ieq < neq; ++ieq) flux[ieq, iblock + i] = f[ieq];
+                    }
+                }
+            }
+
+            /// @brief the two point flux from the thermodynamic states
+            inline constexpr
+            auto two_point_flux_states(
+                const ThermodynamicState<real, ndim>& stateL,
+                const ThermodynamicState<real, ndim>& stateR,
+                const Vector& n
+            ) const noexcept -> std::array<real, neq> {
+                const real Eu = physics.nondim.Eu;
+                const real e_coeff = physics.nondim.e_coeff;
+                const real gamma = 0.5 * (stateL.gamma + stateR.gamma);
+                const real pL = Eu * stateL.p;
+                const real pR = Eu * stateR.p;
+
+                std::array<real, neq> flux;
+                if(two_point_type == TWO_POINT_FLUX::ISMAIL_ROE){
+                    // parameter vector z = sqrt(rho / p) (1, v, p)
+                    real z1L = std::sqrt(stateL.rho / pL), z1R = std::sqrt(stateR.rho / pR);
+                    real z4L = std::sqrt(stateL.rho * pL), z4R = std::sqrt(stateR.rho * pR);
+                    real z1_avg = 0.5 * (z1L + z1R);
+                    real z4_avg = 0.5 * (z4L + z4R);
+                    real z1_ln = logarithmic_mean(z1L, z1R);
+                    real z4_ln = logarithmic_mean(z4L, z4R);
+
+                    real rho_hat = z1_avg * z4_ln;
+                    real p1_hat = z4_avg / z1_avg;
+                    real p2_hat = (gamma + 1) / (2 * gamma) * z4_ln / z1_ln
+                        + (gamma - 1) / (2 * gamma) * z4_avg / z1_avg;
+                    Vector v_hat;
+                    real vn = 0, vv = 0;
+                    for(int idim = 0; idim < ndim; ++idim){
+                        v_hat[idim] = 0.5 * (z1L * stateL.velocity[idim] + z1R * stateR.velocity[idim]) / z1_avg;
+                        vn += v_hat[idim] * n[idim];
+                        vv += v_hat[idim] * v_hat[idim];
+                    }
+                    real H_hat = gamma * p2_hat / ((gamma - 1) * rho_hat) + 0.5 * vv;
+
+                    flux[irho] = rho_hat * vn;
+                    for(int idim = 0; idim < ndim; ++idim)
+                        flux[irhou + idim] = flux[irho] * v_hat[idim] + p1_hat * n[idim];
+                    flux[irhoe] = e_coeff * flux[irho] * H_hat;
+                } else {
+                    // inverse temperature beta = rho / 2p
+                    real betaL = 0.5 * stateL.rho / pL, betaR = 0.5 * stateR.rho / pR;
+                    real rho_ln = logarithmic_mean(stateL.rho, stateR.rho);
+                    real beta_ln = logarithmic_mean(betaL, betaR);
+                    real p_hat = 0.5 * (stateL.rho + stateR.rho) / (betaL + betaR);
+                    real vv_avg = 0.5 * (stateL.vv + stateR.vv);
+                    Vector v_avg;
+                    real vn = 0;
+                    for(int idim = 0; idim < ndim; ++idim){
+                        v_avg[idim] = 0.5 * (stateL.velocity[idim] + stateR.velocity[idim]);
+                        vn += v_avg[idim] * n[idim];
+                    }
+
+                    flux[irho] = rho_ln * vn;
+                    real energy_flux = flux[irho] * 0.5 * (1.0 / ((gamma - 1) * beta_ln) - vv_avg);
+                    for(int idim = 0; idim < ndim; ++idim){
+                        flux[irhou + idim] = flux[irho] * v_avg[idim] + p_hat * n[idim];
+                        energy_flux += flux[irhou + idim] * v_avg[idim];
+                    }
+                    flux[irhoe] = e_coeff * energy_flux;
+                }
+                return flux;
+            }
+
             inline constexpr 
             auto dt_from_cfl(real cfl, real reference_length) const noexcept -> real {
                 real dt = (reference_length * cfl) / lambda_max;
@@ -1201,6 +2237,28 @@ ns_wall_bc_tag:
                 visc_max = 0;
                 return dt;
             }
+
+            /// @brief the maximum wavespeed at a state |v| + c
+            inline constexpr
+            auto wavespeed(std::array<real, nv_comp> u) const noexcept -> real {
+                ThermodynamicState<real, ndim> state = physics.calc_thermo_state(u);
+                return state.csound + std::sqrt(state.vv);
+            }
+
+            /**
+             * @brief get the timestep from cfl for a given wavespeed (i.e the maximum over an element)
+             * the viscous limit uses the maximum viscosity seen so far (this does not reset the maximums)
+             * @param cfl the cfl condition 
+             * @param reference_length the size to use for the length of the cfl condition 
+             * @param lambda the wavespeed
+             */
+            inline constexpr 
+            auto dt_from_cfl(real cfl, real reference_length, real lambda) const noexcept -> real {
+                real dt = (reference_length * cfl) / lambda;
+                if(full_ns && visc_max > 0)
+                    dt = std::min(dt, SQUARED(reference_length) * cfl / visc_max);
+                return dt;
+            }
         };
         template< class T, int _ndim, is_eos EoS, VARSET varset>
         Flux(Physics<T, _ndim, EoS, varset>) -> Flux<T, _ndim, EoS, varset>;
@@ -1238,45 +2296,43 @@ ns_wall_bc_tag:
             /// set to false to restrict to Euler equations (inviscid)
             std::integral_constant<bool, full_ns> full_ns_arg;
 
+            /// @brief the diffusive flux normal to the interface
+            /// @tparam U the state number type (real or a dual number of real)
+            /// @param u the single valued state at the interface
+            /// @param gradu the single valued state gradients at the interface
+            /// @param unit_normal the unit normal vector
+            template<class U>
             inline constexpr
             auto operator()(
-                std::array<real, nv_comp> u,
+                std::array<U, nv_comp> u,
                 linalg::in_tensor auto gradu,
                 Tensor<real, ndim> unit_normal
-            ) const noexcept -> std::array<real, neq>
+            ) const noexcept -> std::array<U, neq>
             {
-                std::array<real, neq> flux;
+                std::array<U, neq> flux;
                 std::ranges::fill(flux, 0.0);
 
                 if(full_ns) {
 //
                     // compute the state
-                    ThermodynamicState<real, ndim> state = physics.calc_thermo_state(u);
+                    ThermodynamicState<U, ndim> state = physics.calc_thermo_state(u);
 
                     // nondimensional quantities
                     real Re = physics.nondim.Re;
                     real e_coeff = physics.nondim.e_coeff;
-                    real gamma = state.gamma;
-                    real Eu = physics.nondim.Eu;
-                    real Pr = physics.Pr;
 
                     // get gradients of state
-                    FlowStateGradients<real, ndim> state_grads{physics.calc_thermo_state_gradients(state, gradu)};
+                    FlowStateGradients<U, ndim> state_grads{physics.calc_thermo_state_gradients(state, gradu)};
 
-                    // get the temperature coefficient
-                    real T_coeff = state.cp * physics.ref.T * physics.ref.rho / physics.ref.p;
+                    // the viscosity is shared by the shear stress and energy flux
+                    U mu = physics.calc_viscosity(state.T);
 
                     // get the shear stress
-                    Tensor tau = physics.calc_shear_stress(state, state_grads);
-
-                    // get the heat flux 
-                    Vector q = physics.calc_heat_flux(state, state_grads);
+                    Tensor<U, ndim, ndim> tau = physics.calc_shear_stress(state_grads, mu);
 
                     // contribution of viscous fluxes
                     for(int jdim = 0; jdim < ndim; ++jdim){
-                        real energy_flux = q[jdim] * unit_normal[jdim];
-                        real mu = physics.viscosity(state.T);
-                        energy_flux = mu * state.gamma / physics.Pr * state_grads.E_gradient[jdim] * unit_normal[jdim];
+                        U energy_flux = mu * state.gamma / physics.Pr * state_grads.E_gradient[jdim] * unit_normal[jdim];
                         for(int idim = 0; idim < ndim; ++idim){
                             flux[irhou + idim] += tau[idim][jdim] / Re * unit_normal[jdim];
                             energy_flux += state.velocity[idim] * tau[idim][jdim] * unit_normal[jdim];
@@ -0,0 +1,252 @@
+/// @brief positivity preserving scaling limiter for the compressible Navier-Stokes equations
+/// @author Gianni Absillis (gabsill@ncsu.edu)
+#pragma once
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/disc/navier_stokes.hpp"
+#include "iceicle/element/finite_element.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/thread_utils.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace iceicle::navier_stokes {
+
+    /**
+     * @brief the scaling limiter of Zhang and Shu (2010) for positive density and pressure
+     * of a solution in conservative variables [rho, rho u, rho E]
+     *
+     * Each element is checked at its quadrature points with the tabulated basis functions.
+     * Only elements with a density or pressure below eps at a quadrature point are limited,
+     * by contracting the solution towards the element average:
+     *   u <- ubar + theta (u - ubar)
+     * first on the density (theta_rho), then on all the components (theta_p, from the exact root
+     * of the quadratic in theta for the pressure) so the density and pressure at the quadrature points are at least
+     * eps (or the average value if that is smaller).
+     * The element average is conserved.
+     *
+     * The coefficients are contracted directly so the basis must represent constants
+     * with equal coefficients (i.e the partition of unity of Lagrange bases).
+     * Elements with a non-positive average density or pressure can not be limited and are counted in nfailed.
+     *
+     * NOTE: the checks are at the element quadrature points only (not the trace quadrature points)
+     *
+     * @tparam T the real value type
+     * @tparam IDX the index type
+     * @tparam ndim the number of dimensions
+     */
+    template<class T, class IDX, int ndim>
+    class PositivityLimiter {
+        public:
+
+        /// @brief the number of vector components
+        static constexpr int nv_comp = ndim + 2;
+
+        private:
+
+        static constexpr int irho = 0;
+        static constexpr int irhou = 1;
+        static constexpr int irhoe = ndim + 1;
+
+        FESpace<T, IDX, ndim>* fespace;
+
+        /// @brief the dimensionless energy coefficient: rho e = rho E - 0.5 e_coeff |rho u|^2 / rho
+        T e_coeff;
+
+        /// @brief the dimensionless pressure from the internal energy: p = p_coeff * rho e
+        T p_coeff;
+
+        /// @brief per thread storage of the element coefficients and quadrature point values
+        std::vector<T> work{};
+
+        /// @brief the per thread storage size
+        std::size_t work_size = 0;
+
+        /// @brief the internal energy density rho e of a conservative state
+        auto internal_energy(const T* u) const noexcept -> T {
+            T mm = 0;
+            for(int idim = 0; idim < ndim; ++idim) mm += u[irhou + idim] * u[irhou + idim];
+            return u[irhoe] - 0.5 * e_coeff * mm / u[irho];
+        }
+
+        public:
+
+        /// @brief the lower bound for the density and pressure
+        T eps = 1e-13;
+
+        /// @brief the number of elements limited in the last call
+        IDX nlimited = 0;
+
+        /// @brief the number of elements that could not be limited in the last call
+        IDX nfailed = 0;
+
+        /**
+         * @brief construct the limiter
+         * @param fespace the finite element space
+         * @param gamma the ratio of specific heats
+         * @param nondim the nondimensionalization of the Navier-Stokes equations
+         */
+        PositivityLimiter(FESpace<T, IDX, ndim>& fespace, T gamma, const Nondimensionalization<T>& nondim)
+        : fespace{&fespace}, e_coeff{nondim.e_coeff}, p_coeff{(gamma - 1) / (nondim.e_coeff * nondim.Eu)}
+        {
+            std::size_t max_nbasis = 0, max_nqp = 0;
+            bool partition_of_unity = true;
+            for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+                max_nbasis = std::max(max_nbasis, (std::size_t) el.nbasis());
+                max_nqp = std::max(max_nqp, (std::size_t) el.nQP());
+                for(int iqp = 0; iqp < el.nQP(); ++iqp){
+                    T sum = 0;
+                    for(int ibasis = 0; ibasis < el.nbasis(); ++ibasis) sum += el.basis_qp(iqp, ibasis);
+                    partition_of_unity = partition_of_unity && std::abs(sum - 1.0) < 1e-10;
+                }
+            }
+            if(!partition_of_unity) util::AnomalyLog::log_anomaly(util::Anomaly{
+                "The positivity limiter requires a basis that is a partition of unity (i.e Lagrange)",
+                util::general_anomaly_tag{}});
+            work_size = (max_nbasis + max_nqp + 1) * nv_comp;
+            work.resize(work_size * util::max_threads());
+        }
+
+        /**
+         * @brief check and limit one element
+         * @param el the element
+         * @param [in/out] u_el the element coefficients [nbasis x nv_comp]
+         * @param uqp storage for the quadrature point values [nqp x nv_comp]
+         * @param ubar storage for the element average [nv_comp]
+         * @return 0 if the element was not limited, 1 if it was, -1 if it could not be limited
+         */
+        auto limit_element(const FiniteElement<T, IDX, ndim>& el, T* u_el, T* uqp, T* ubar) const -> int {
+            const int nbasis = el.nbasis();
+            const int nqp = el.nQP();
+
+            // the values at the quadrature points from the tabulated basis functions
+            T rho_min = std::numeric_limits<T>::max();
+            bool flagged = false;
+            for(int iqp = 0; iqp < nqp; ++iqp){
+                T* uq = uqp + iqp * nv_comp;
+                std::array<T, nv_comp> acc{};
+                auto bi = el.eval_basis_qp(iqp);
+                for(int ibasis = 0; ibasis < nbasis; ++ibasis){
+                    for(int iv = 0; iv < nv_comp; ++iv) acc[iv] += bi[ibasis] * u_el[ibasis * nv_comp + iv];
+                }
+                std::copy_n(acc.data(), nv_comp, uq);
+                rho_min = std::min(rho_min, uq[irho]);
+                flagged = flagged || !(uq[irho] >= eps) || !(p_coeff * internal_energy(uq) >= eps);
+            }
+            if(!flagged) return 0;
+
+            // the element average
+            QPGeometry geo{el};
+            std::fill_n(ubar, nv_comp, 0.0);
+            T vol = 0;
+            for(int iqp = 0; iqp < nqp; ++iqp){
+                T dvol = geo[iqp].dvol;
+                vol += dvol;
+                for(int iv = 0; iv < nv_comp; ++iv) ubar[iv] += dvol * uqp[iqp * nv_comp + iv];
+            }
+            for(int iv = 0; iv < nv_comp; ++iv) ubar[iv] /= vol;
+            T pbar = (ubar[irho] > 0) ? p_coeff * internal_energy(ubar) : 0.0;
+            if(!(ubar[irho] > 0) || !(pbar > 0)) return -1;
+            const T eps_el = std::min({eps, ubar[irho], pbar});
+
+            // contract the density
+            if(rho_min < eps_el){
+                T theta = std::min((T) 1.0, (ubar[irho] - eps_el) / (ubar[irho] - rho_min));
+                for(int iqp = 0; iqp < nqp; ++iqp)
+                    { uqp[iqp * nv_comp + irho] = ubar[irho] + theta * (uqp[iqp * nv_comp + irho] - ubar[irho]); }
+                for(int ibasis = 0; ibasis < nbasis; ++ibasis)
+                    { u_el[ibasis * nv_comp + irho] = ubar[irho] + theta * (u_el[ibasis * nv_comp + irho] - ubar[irho]); }
+            }
+
+            // contract all components for the pressure
+            // rho * rho e(s) - eps_e * rho(s) is quadratic in s along ubar + s (uq - ubar)
+            const T eps_e = eps_el / p_coeff;
+            T mbar_sq = 0;
+            for(int idim = 0; idim < ndim; ++idim) mbar_sq += ubar[irhou + idim] * ubar[irhou + idim];
+            const T c = ubar[irho] * ubar[irhoe] - 0.5 * e_coeff * mbar_sq - eps_e * ubar[irho];
+            T theta = 1.0;
+            for(int iqp = 0; iqp < nqp; ++iqp){
+                const T* uq = uqp + iqp * nv_comp;
+                if(p_coeff * internal_energy(uq) >= eps_el) continue;
+                T drho = uq[irho] - ubar[irho];
+                T dE = uq[irhoe] - ubar[irhoe];
+                T dm_sq = 0, mdm = 0;
+                for(int idim = 0; idim < ndim; ++idim){
+                    T dm = uq[irhou + idim] - ubar[irhou + idim];
+                    dm_sq += dm * dm;
+                    mdm += ubar[irhou + idim] * dm;
+                }
+                T a = drho * dE - 0.5 * e_coeff * dm_sq;
+                T b = ubar[irho] * dE + drho * ubar[irhoe] - e_coeff * mdm - eps_e * drho;
+
+                // the smallest root in (0, 1) (the quadratic is positive at 0 and negative at 1)
+                T s = 0;
+                if(std::abs(a) < std::numeric_limits<T>::epsilon() * std::abs(b)){
+                    s = -c / b;
+                } else {
+                    T disc = std::sqrt(std::max((T) 0.0, b * b - 4 * a * c));
+                    T s1 = (-b - disc) / (2 * a), s2 = (-b + disc) / (2 * a);
+                    s = 1.0;
+                    if(s1 >= 0) s = std::min(s, s1);
+                    if(s2 >= 0) s = std::min(s, s2);
+                }
+                theta = std::min(theta, std::clamp(s, (T) 0.0, (T) 1.0));
+            }
+            if(theta < 1.0){
+                for(int ibasis = 0; ibasis < nbasis; ++ibasis){
+                    for(int iv = 0; iv < nv_comp; ++iv){
+                        T& ui = u_el[ibasis * nv_comp + iv];
+                        ui = ubar[iv] + theta * (ui - ubar[iv]);
+                    }
+                }
+            }
+            return 1;
+        }
+
+        /**
+         * @brief limit the solution in place, only writing to the elements that are limited
+         * @param u the solution in conservative variables
+         * @return the number of elements limited
+         */
+        template<class LayoutPolicy, class AccessorPolicy>
+        auto operator()(fespan<T, LayoutPolicy, AccessorPolicy> u) -> IDX {
+            if(work.size() < work_size * util::max_threads()) work.resize(work_size * util::max_threads());
+            std::array<IDX, 2> counts = util::parallel_sums<2, IDX>(fespace->elements.size(),
+                [&](std::size_t iel, std::array<IDX, 2>& counts){
+                    const FiniteElement<T, IDX, ndim>& el = fespace->elements[iel];
+                    T* u_el = work.data() + util::thread_num() * work_size;
+                    T* uqp = u_el + el.nbasis() * nv_comp;
+                    T* ubar = uqp + el.nQP() * nv_comp;
+                    for(int ibasis = 0; ibasis < el.nbasis(); ++ibasis){
+                        for(int iv = 0; iv < nv_comp; ++iv) u_el[ibasis * nv_comp + iv] = u[iel, ibasis, iv];
+                    }
+                    int status = limit_element(el, u_el, uqp, ubar);
+                    if(status == 1){
+                        for(int ibasis = 0; ibasis < el.nbasis(); ++ibasis){
+                            for(int iv = 0; iv < nv_comp; ++iv) u[iel, ibasis, iv] = u_el[ibasis * nv_comp + iv];
+                        }
+                        counts[0] += 1;
+                    } else if(status == -1) {
+                        counts[1] += 1;
+                    }
+                });
+            nlimited = counts[0];
+            nfailed = counts[1];
+            return nlimited;
+        }
+
+        /// @brief limit a solution in the dg layout of the finite element space
+        auto limit(std::span<T> u_data) -> IDX {
+            fe_layout_right layout{fespace->dg_map, std::integral_constant<std::size_t, nv_comp>{}};
+            return (*this)(fespan{u_data.data(), layout});
+        }
+    };
+
+    template<class T, class IDX, int ndim>
+    PositivityLimiter(FESpace<T, IDX, ndim>&, T, const Nondimensionalization<T>&) -> PositivityLimiter<T, IDX, ndim>;
+}
@@ -7,10 +7,13 @@
 #pragma once
 #include "Numtool/fixed_size_tensor.hpp"
 #include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/thread_utils.hpp"
+#include <cstddef>
 #include <functional>
 #include <iceicle/element/finite_element.hpp>
 #include <iceicle/fe_function/fe_function.hpp>
 #include <Numtool/matrixT.hpp>
+#include <vector>
 namespace iceicle {
     
     /**
@@ -24,6 +27,15 @@ namespace iceicle {
     template<typename T, int ndim, int neq>
     using ProjectionFunction = std::function<void(const T[ndim], T[neq])>;
 
+    /**
+     * @brief batched function to project to
+     * takes in the number of points, the points in the physical domain [npoint x ndim]
+     * and returns the values [npoint x neq] in the last argument
+     * @tparam T the floating point type
+     */
+    template<typename T>
+    using ProjectionBatchFunction = std::function<void(std::size_t, const T*, T*)>;
+
 
     template<typename T, typename IDX, int ndim, int neq>
     class Projection {
@@ -31,14 +43,90 @@ namespace iceicle {
     
         ProjectionFunction<T, ndim , neq> func;
 
+        ProjectionBatchFunction<T> batch_func{};
+
         public:
 
         /// @brief the number of vector components
         static constexpr int nv_comp = neq;
 
+        /// @brief func can be called concurrently from multiple threads
+        /// (i.e false for functions that call into a lua state)
+        bool thread_safe = true;
+
         Projection(ProjectionFunction<T, ndim, neq> func) 
         : func{func} {}
 
+        /**
+         * @brief project a batched function 
+         * @param batch_func the function evaluated at many points in one call
+         */
+        Projection(ProjectionBatchFunction<T> batch_func)
+        : batch_func{batch_func} {}
+
+        /**
+         * @brief evaluate the function at a batch of points 
+         * with one call of the batched function, 
+         * otherwise one call per point (distributed over threads if thread_safe)
+         * @param npoint the number of points
+         * @param x the points in the physical domain [npoint x ndim]
+         * @param [out] f the function values [npoint x neq]
+         */
+        void eval_points(std::size_t npoint, const T* x, T* f) const {
+            if(batch_func) {
+                batch_func(npoint, x, f);
+            } else if(thread_safe) {
+                util::parallel_for(npoint, [&](std::size_t ipoint){ func(x + ipoint * ndim, f + ipoint * neq); });
+            } else {
+                for(std::size_t ipoint = 0; ipoint < npoint; ++ipoint)
+                    { func(x + ipoint * ndim, f + ipoint * neq); }
+            }
+        }
+
+        /**
+         * @brief the physical location of each quadrature point of an element
+         * (from the geometric factors if they are cached)
+         * @param el the element
+         * @param [out] x the points [el.nQP() x ndim]
+         */
+        void quadrature_points(const FiniteElement<T, IDX, ndim> &el, T* x) const {
+            for(int ig = 0; ig < el.nQP(); ++ig){
+                Point phys_pt = (el.has_geometric_factors()) ? el.geo_factors->element_phys_pt(el.elidx, ig)
+                    : el.transform(el.getQP(ig).abscisse);
+                for(int idim = 0; idim < ndim; ++idim) x[ig * ndim + idim] = phys_pt[idim];
+            }
+        }
+
+        /**
+         * @brief Integral over the element domain of the weak form of u = f(x)
+         *        /int f(x) v dx
+         * with the function already evaluated at the quadrature points (see quadrature_points)
+         * @param el the element
+         * @param f the function values at the quadrature points [el.nQP() x neq]
+         * @param res the residual function (WARNING: MUST BE ZEROED OUT)
+         */
+        void domain_integral(
+            const FiniteElement<T, IDX, ndim> &el,
+            const T* f,
+            elspan auto res
+        ) const {
+            for(int ig = 0; ig < el.nQP(); ++ig){
+                T dvol;
+                if(el.has_geometric_factors()){
+                    dvol = el.geo_factors->dvol(el.elidx, ig);
+                } else {
+                    const QuadraturePoint<T, ndim> quadpt = el.getQP(ig);
+                    auto J = el.jacobian(quadpt.abscisse);
+                    dvol = quadpt.weight * NUMTOOL::TENSOR::FIXED_SIZE::determinant(J);
+                }
+                for(std::size_t b = 0; b < el.nbasis(); b++){
+                    T bdvol = el.basis_qp(ig, b) * dvol;
+                    for(std::size_t eq = 0; eq < neq; eq++)
+                        { res[b, eq] += f[ig * neq + eq] * bdvol; }
+                }
+            }
+        }
+
         /**
          * @brief Integral over the element domains formed by 
          *        the weak form of u = f(x)
@@ -84,29 +172,14 @@ namespace iceicle {
             const FiniteElement<T, IDX, ndim> &el,
             elspan auto res
         ) {
-            T detJ; // TODO: put back in loop after debuggin for clarity
-            for(int ig = 0; ig < el.nQP(); ++ig){ // loop over the quadrature points
-                
-                // convert the quadrature point to the physical domain
-                const QuadraturePoint<T, ndim> quadpt = el.getQP(ig);
-                Point phys_pt = el.transform(quadpt.abscisse);
-
-                // calculate the jacobian determinant
-                auto J = el.jacobian(quadpt.abscisse);
-                detJ = NUMTOOL::TENSOR::FIXED_SIZE::determinant(J);
-
-                // evaluate the function at the point in the physical domain
-                T feval[neq];
-                func(phys_pt, feval);
-
-                // loop over the equations and test functions and construct the residual
-                for(std::size_t b = 0; b < el.nbasis(); b++){
-                    for(std::size_t eq = 0; eq < neq; eq++){
-                        res[b, eq] += feval[eq] * quadpt.weight * el.basis_qp(ig, b) * detJ;
-                    }          
-                }
+            std::vector<T> x(el.nQP() * ndim), f(el.nQP() * neq);
+            quadrature_points(el, x.data());
+            if(batch_func) {
+                batch_func(el.nQP(), x.data(), f.data());
+            } else {
+                for(int ig = 0; ig < el.nQP(); ++ig) func(x.data() + ig * ndim, f.data() + ig * neq);
             }
-            
+            domain_integral(el, f.data(), res);
         }
     };
 }
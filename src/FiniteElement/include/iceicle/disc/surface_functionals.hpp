@@ -0,0 +1,176 @@
+/**
+ * @brief integrated surface quantities of the Navier-Stokes equations (forces and heat flux)
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/disc/navier_stokes.hpp"
+#include "iceicle/element/finite_element.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/geometry/face.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/reproducible_sum.hpp"
+#include <Numtool/fixed_size_tensor.hpp>
+#include <array>
+#include <mdspan/mdspan.hpp>
+#include <string>
+#include <vector>
+
+namespace iceicle::navier_stokes {
+
+    /**
+     * @brief the integrals over a set of boundary faces of the force on the boundary and the heat flux
+     *
+     * The normal is the outward normal of the fluid domain (pointing into the body for a wall)
+     * so these are the (nondimensional) force exerted by the fluid and the energy conducted out of the fluid
+     */
+    template<class T, int ndim>
+    struct SurfaceFunctionals {
+        /// @brief the number of values
+        static constexpr std::size_t nvalue = 2 * ndim + 2;
+
+        /// @brief the pressure force Eu * int p n dS
+        std::array<T, ndim> pressure_force{};
+
+        /// @brief the viscous force -1 / Re int tau n dS
+        std::array<T, ndim> viscous_force{};
+
+        /// @brief the conducted energy -e_coeff / Re int q . n dS (q is the temperature gradient term of the energy flux)
+        T heat_flux = 0;
+
+        /// @brief the area of the faces
+        T area = 0;
+
+        /// @brief pack the values in the order of value_names()
+        auto values() const -> std::array<T, nvalue> {
+            std::array<T, nvalue> vals;
+            for(int idim = 0; idim < ndim; ++idim){
+                vals[idim] = pressure_force[idim];
+                vals[ndim + idim] = viscous_force[idim];
+            }
+            vals[2 * ndim] = heat_flux;
+            vals[2 * ndim + 1] = area;
+            return vals;
+        }
+
+        /// @brief the names of the values
+        static auto value_names() -> std::vector<std::string> {
+            static constexpr char dir[] = "xyz";
+            std::vector<std::string> names{};
+            for(int idim = 0; idim < ndim; ++idim) names.push_back(std::string{"Fp_"} + dir[idim]);
+            for(int idim = 0; idim < ndim; ++idim) names.push_back(std::string{"Fv_"} + dir[idim]);
+            names.push_back("Q");
+            names.push_back("area");
+            return names;
+        }
+    };
+
+    /**
+     * @brief integrate the surface functionals over the boundary faces with the given bcflag
+     *
+     * Uses the state of the left (interior) element and the cached geometric factors of the traces when valid.
+     * The viscous terms use Physics::calc_shear_stress and Physics::calc_heat_flux
+     * and are zero for the Euler flux.
+     * All the values are summed over processes in a single reduction (collective)
+     * with util::reduction_sum so they do not depend on the number of processes.
+     *
+     * @param fespace the finite element space
+     * @param flux the physical flux of the discretization (provides the physics)
+     * @param u the solution
+     * @param bcflag the boundary condition flag of the faces to integrate over
+     * @return the integrated values on all processes
+     */
+    template<class T, class IDX, int ndim, class FluxT, class uLayoutPolicy, class uAccessorPolicy>
+    auto integrate_surface_functionals(
+        FESpace<T, IDX, ndim>& fespace,
+        const FluxT& flux,
+        fespan<T, uLayoutPolicy, uAccessorPolicy> u,
+        int bcflag
+    ) -> SurfaceFunctionals<T, ndim> {
+        using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+        static constexpr int neq = FluxT::nv_comp;
+        static constexpr bool full_ns = decltype(flux.full_ns_arg)::value;
+        const auto& physics = flux.physics;
+        const T Re = physics.nondim.Re;
+        const T Eu = physics.nondim.Eu;
+        const T e_coeff = physics.nondim.e_coeff;
+
+        std::array<util::reduction_sum<T>, SurfaceFunctionals<T, ndim>::nvalue> local{};
+        std::vector<T> u_data(fespace.dg_map.max_el_size_reqirement(neq));
+        std::vector<T> grad_data{};
+
+        for(const auto& trace : fespace.get_boundary_traces()){
+            if(trace.face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) continue;
+            if(trace.face->bcflag != bcflag) continue;
+            const FiniteElement<T, IDX, ndim>& elL = trace.elL;
+            dofspan uL{u_data.data(), u.create_element_layout(elL.elidx)};
+            extract_elspan(elL.elidx, u, uL);
+            grad_data.resize(elL.nbasis() * ndim);
+
+            const bool geo_cached = trace.has_geometric_factors();
+            for(int iqp = 0; iqp < trace.nQP(); ++iqp){
+                const auto& quadpt = trace.getQP(iqp);
+                Tensor<T, ndim> unit_normal;
+                T dsurf;
+                if(geo_cached){
+                    unit_normal = trace.geo_factors->unit_normal(trace.facidx, iqp);
+                    dsurf = trace.geo_factors->dsurf(trace.facidx, iqp);
+                } else {
+                    auto Jfac = trace.face->Jacobian(fespace.meshptr->coord, quadpt.abscisse);
+                    dsurf = quadpt.weight * trace.face->rootRiemannMetric(Jfac, quadpt.abscisse);
+                    unit_normal = normalize(calc_ortho(Jfac));
+                }
+
+                // the interior state
+                auto bi = trace.qp_evals_l[iqp].bi_span;
+                std::array<T, neq> uq{};
+                for(int ieq = 0; ieq < neq; ++ieq){
+                    for(int ibasis = 0; ibasis < elL.nbasis(); ++ibasis)
+                        { uq[ieq] += uL[ibasis, ieq] * bi[ibasis]; }
+                }
+                ThermodynamicState<T, ndim> state = physics.calc_thermo_state(uq);
+
+                for(int idim = 0; idim < ndim; ++idim)
+                    { local[idim] += Eu * state.p * unit_normal[idim] * dsurf; }
+
+                if constexpr (full_ns) {
+                    // the interior state gradient wrt the physical domain
+                    trace.eval_phys_grad_basis_l_qp(iqp, grad_data.data());
+                    std::array<T, neq * ndim> gradu_data{};
+                    for(int ieq = 0; ieq < neq; ++ieq){
+                        for(int ibasis = 0; ibasis < elL.nbasis(); ++ibasis){
+                            for(int idim = 0; idim < ndim; ++idim)
+                                { gradu_data[ieq * ndim + idim] += uL[ibasis, ieq] * grad_data[ibasis * ndim + idim]; }
+                        }
+                    }
+                    std::mdspan<const T, std::extents<int, neq, ndim>> gradu{gradu_data.data()};
+                    FlowStateGradients<T, ndim> grads{physics.calc_thermo_state_gradients(state, gradu)};
+
+                    // the viscosity is shared by the shear stress and heat flux
+                    T mu = physics.viscosity(state.T);
+                    auto tau = physics.calc_shear_stress(grads, mu);
+                    auto q = physics.calc_heat_flux(state, grads, mu);
+                    T qn = 0;
+                    for(int idim = 0; idim < ndim; ++idim){
+                        T taun = 0;
+                        for(int jdim = 0; jdim < ndim; ++jdim) taun += tau[idim][jdim] * unit_normal[jdim];
+                        local[ndim + idim] -= taun / Re * dsurf;
+                        qn += q[idim] * unit_normal[idim];
+                    }
+                    local[2 * ndim] -= e_coeff / Re * qn * dsurf;
+                }
+                local[2 * ndim + 1] += dsurf;
+            }
+        }
+
+        mpi::allreduce_sums(std::span{local});
+        SurfaceFunctionals<T, ndim> result{};
+        for(int idim = 0; idim < ndim; ++idim){
+            result.pressure_force[idim] = local[idim].value();
+            result.viscous_force[idim] = local[ndim + idim].value();
+        }
+        result.heat_flux = local[2 * ndim].value();
+        result.area = local[2 * ndim + 1].value();
+        return result;
+    }
+}
@@ -8,6 +8,7 @@
 #include "Numtool/point.hpp"
 #include "iceicle/geometry/geo_element.hpp"
 #include "iceicle/quadrature/QuadratureRule.hpp"
+#include <iceicle/element/ddg_trace_factors.hpp>
 #include <iceicle/element/finite_element.hpp>
 
 #include <iceicle/geometry/face.hpp>
@@ -94,8 +95,27 @@ public:
   std::span<const Eval_t> qp_evals_l;
   /// @brief the precomputed basis functions on the right 
   std::span<const Eval_t> qp_evals_r;
+  /// @brief the quadrature points mapped to the left element reference domain
+  /// (shared by the traces with the same ReferenceTraceSpace, empty to transform the points on the fly)
+  std::span<const DomainPoint> qp_xi_l;
+  /// @brief the quadrature points mapped to the right element reference domain
+  std::span<const DomainPoint> qp_xi_r;
+  /// @brief the nodal geometry shape functions of the left element at the quadrature points
+  /// (shared by the traces with the same ReferenceTraceSpace, empty to evaluate the transformation directly)
+  std::span<const Eval_t> geo_evals_l{};
+  /// @brief the nodal geometry shape functions of the right element at the quadrature points
+  std::span<const Eval_t> geo_evals_r{};
   /// @brief the index of this face in the container used to organize faces
   const IDX facidx;
+  /// @brief the cached geometric factors at the quadrature points 
+  /// nullptr if the owning FESpace has not enabled the cache
+  const GeometricFactors<T, IDX, ndim> *geo_factors = nullptr;
+  /// @brief the cached DDG interface data at the quadrature points 
+  /// nullptr if the owning FESpace has not enabled the cache
+  const DDGTraceFactors<T, IDX, ndim> *ddg_factors = nullptr;
+  /// @brief the translation from the right element to the face 
+  /// (x_face = x_right + offset_r) nonzero only for faces joining elements across a periodic boundary
+  DomainPoint offset_r{};
 
   // ================
   // = Constructors =
@@ -112,6 +132,8 @@ public:
    * @param qp_evals_l the precomputed basis functions at quadrature points on the left
    * @param qp_evals_r the precomputed basis functions at quadrature points on the right 
    * @param facidx the index of this face in the container
+   * @param qp_xi_l the quadrature points in the left element reference domain (optional)
+   * @param qp_xi_r the quadrature points in the right element reference domain (optional)
    */
   TraceSpace(
       const FaceType *facptr,
@@ -121,10 +143,12 @@ public:
       const QuadratureType *quadruleptr,
       std::span<const Eval_t> qp_evals_l,
       std::span<const Eval_t> qp_evals_r,
-      IDX facidx
+      IDX facidx,
+      std::span<const DomainPoint> qp_xi_l = {},
+      std::span<const DomainPoint> qp_xi_r = {}
   ) : face(facptr), elL(*elLptr), elR(*elRptr), trace_basis(*trace_basisptr),
       quadrule(*quadruleptr), qp_evals_l(qp_evals_l), qp_evals_r(qp_evals_r),
-      facidx(facidx) 
+      qp_xi_l(qp_xi_l), qp_xi_r(qp_xi_r), facidx(facidx) 
   {
     // TODO: can't do assertion because we call from make_bdy_trace_space
  //   assert((facptr->bctype == BOUNDARY_CONDITIONS::INTERIOR) 
@@ -143,6 +167,8 @@ public:
    * @param quadruleptr pointer to the trace quadrature rule
    * @param qp_evals_ptr pointer to the quadrature evaluations
    * @param facidx the index of this face in the container
+   * @param qp_xi_l the quadrature points in the left element reference domain (optional)
+   * @param qp_xi_r the quadrature points in the right element reference domain (optional)
    */
   static constexpr TraceSpace<T, IDX, ndim> make_bdy_trace_space(
       const FaceType *facptr,
@@ -151,12 +177,22 @@ public:
       const QuadratureType *quadruleptr,
       std::span<const Eval_t> qp_evals_l,
       std::span<const Eval_t> qp_evals_r,
-      IDX facidx
+      IDX facidx,
+      std::span<const DomainPoint> qp_xi_l = {},
+      std::span<const DomainPoint> qp_xi_r = {}
   ) {
     assert((facptr->bctype != BOUNDARY_CONDITIONS::INTERIOR) 
         && "The given face is not a boundary face->");
     return TraceSpace(facptr, elLptr, elLptr, trace_basisptr, quadruleptr,
-        qp_evals_l, qp_evals_r , facidx);
+        qp_evals_l, qp_evals_r , facidx, qp_xi_l, qp_xi_r);
+  }
+
+  /// @brief the centroid of the right element in the frame of the face 
+  /// (the physical centroid translated by offset_r)
+  auto centroid_r() const -> DomainPoint {
+    DomainPoint centroid = elR.centroid();
+    for(int idim = 0; idim < ndim; ++idim) centroid[idim] += offset_r[idim];
+    return centroid;
   }
 
   // =============================
@@ -396,9 +432,8 @@ public:
       int qidx,
       T *grad_data
   ) const {
-    DomainPoint xi{};
-    face->transform_xiL(quadrule[qidx].abscisse, xi);
-    auto el_jac = elL.jacobian(xi);
+    DomainPoint xi = xiL_qp(qidx);
+    auto el_jac = jacobian_l_qp(qidx);
     return elL.eval_phys_grad_basis(xi, el_jac, qp_evals_l[qidx].grad_bi_span, grad_data);
   }
 
@@ -422,9 +457,8 @@ public:
       int qidx,
       T *grad_data
   ) const {
-    DomainPoint xi{};
-    face->transform_xiR(quadrule[qidx].abscisse, xi);
-    auto el_jac = elR.jacobian(xi);
+    DomainPoint xi = xiR_qp(qidx);
+    auto el_jac = jacobian_r_qp(qidx);
     return elR.eval_phys_grad_basis(xi, el_jac, qp_evals_r[qidx].grad_bi_span, grad_data);
   }
 
@@ -549,6 +583,18 @@ public:
   // = Geometric Operations =
   // ========================
 
+  /// @brief check if the cached geometric factors exist and are up to date 
+  /// with the mesh for this trace
+  auto has_geometric_factors() const noexcept -> bool {
+    return geo_factors != nullptr && geo_factors->trace_valid(*this);
+  }
+
+  /// @brief check if the cached DDG interface data exist and are up to date 
+  /// with the mesh for this trace
+  auto has_ddg_factors() const noexcept -> bool {
+    return ddg_factors != nullptr && ddg_factors->trace_valid(*this);
+  }
+
   /// @brief transform froom the face reference domain to the physical domain 
   /// @param s the face reference domain point 
   /// @param coord the node coordinates
@@ -582,6 +628,50 @@ public:
     face->transform_xiR(s, xiR);
     return xiR;
   }
+
+  /// @brief the quadrature point qidx in the reference domain of the left element
+  /// looked up in the shared table if there is one
+  inline DomainPoint xiL_qp(int qidx) const
+  {
+    if(!qp_xi_l.empty()) return qp_xi_l[qidx];
+    return transform_xiL(quadrule[qidx].abscisse);
+  }
+
+  /// @brief the quadrature point qidx in the reference domain of the right element
+  /// looked up in the shared table if there is one
+  inline DomainPoint xiR_qp(int qidx) const
+  {
+    if(!qp_xi_r.empty()) return qp_xi_r[qidx];
+    return transform_xiR(quadrule[qidx].abscisse);
+  }
+
+  /// @brief the jacobian of the left element transformation at the quadrature point qidx
+  /// (uses the tabulated geometry shape functions if available)
+  auto jacobian_l_qp(int qidx) const -> FEType::JacobianType {
+    if(!geo_evals_l.empty()) return nodal_jacobian<T, ndim>(elL.coord_el, geo_evals_l[qidx]);
+    return elL.jacobian(xiL_qp(qidx));
+  }
+
+  /// @brief the jacobian of the right element transformation at the quadrature point qidx
+  /// (uses the tabulated geometry shape functions if available)
+  auto jacobian_r_qp(int qidx) const -> FEType::JacobianType {
+    if(!geo_evals_r.empty()) return nodal_jacobian<T, ndim>(elR.coord_el, geo_evals_r[qidx]);
+    return elR.jacobian(xiR_qp(qidx));
+  }
+
+  /// @brief the hessian of the left element transformation at the quadrature point qidx
+  /// (uses the tabulated geometry shape functions if available)
+  auto hessian_l_qp(int qidx) const -> FEType::HessianType {
+    if(!geo_evals_l.empty()) return nodal_hessian<T, ndim>(elL.coord_el, geo_evals_l[qidx]);
+    return elL.hessian(xiL_qp(qidx));
+  }
+
+  /// @brief the hessian of the right element transformation at the quadrature point qidx
+  /// (uses the tabulated geometry shape functions if available)
+  auto hessian_r_qp(int qidx) const -> FEType::HessianType {
+    if(!geo_evals_r.empty()) return nodal_hessian<T, ndim>(elR.coord_el, geo_evals_r[qidx]);
+    return elR.hessian(xiR_qp(qidx));
+  }
 };
 
 }
@@ -0,0 +1,248 @@
+/**
+ * @brief cache of the interface data of the DDG viscous flux at the quadrature points of the interior traces
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "Numtool/fixed_size_tensor.hpp"
+#include "Numtool/point.hpp"
+#include <iceicle/element/finite_element.hpp>
+#include <iceicle/fe_definitions.hpp>
+#include <iceicle/mesh/mesh.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include <mdspan/mdspan.hpp>
+
+namespace iceicle {
+
+    /**
+     * @brief the DDG interface length scale: the normal distance between the two element centroids through the face point
+     * (bounded away from zero with the sign kept)
+     *
+     * @param unit_normal the unit normal of the face
+     * @param phys_pt the physical location of the quadrature point
+     * @param centroidL the centroid of the left element
+     * @param centroidR the centroid of the right element (with the periodic offset)
+     */
+    template<class T, int ndim>
+    inline auto ddg_interface_distance(
+        const auto& unit_normal,
+        const auto& phys_pt,
+        const auto& centroidL,
+        const auto& centroidR
+    ) -> T {
+        T h_ddg = 0;
+        for(int idim = 0; idim < ndim; ++idim){
+            h_ddg += unit_normal[idim] * (
+                (phys_pt[idim] - centroidL[idim])
+                + (centroidR[idim] - phys_pt[idim])
+            );
+        }
+        return std::copysign(std::max(std::abs(h_ddg), std::numeric_limits<T>::epsilon()), h_ddg);
+    }
+
+    /**
+     * @brief per quadrature point data of the DDG viscous flux on the interior traces of a finite element space
+     *
+     * For every quadrature point this stores the interface length scale (ddg_interface_distance)
+     * and the gradients and hessians of the left and right basis functions wrt the physical domain.
+     * These only depend on the geometry so are computed once per mesh version
+     * instead of every trace integral.
+     *
+     * Each trace records the AbstractMesh::element_coord_version of both its elements
+     * so update() only recomputes the traces of elements moved by AbstractMesh::update_node().
+     * Out of date traces report invalid and the caller should compute directly.
+     *
+     * NOTE: boundary traces (including parallel communication traces) are never cached
+     *
+     * @tparam T the floating point type
+     * @tparam IDX the index type
+     * @tparam ndim the number of dimensions
+     */
+    template<class T, class IDX, int ndim>
+    class DDGTraceFactors {
+        public:
+
+        /// @brief view of the basis gradients [ibasis, idim]
+        using grad_span_t = std::mdspan<const T, std::extents<int, std::dynamic_extent, ndim>>;
+
+        /// @brief view of the basis hessians [ibasis, idim, jdim]
+        using hess_span_t = std::mdspan<const T, std::extents<int, std::dynamic_extent, ndim, ndim>>;
+
+        private:
+
+        /// @brief the version for entries that are never valid
+        static constexpr std::size_t never_valid = std::numeric_limits<std::size_t>::max();
+
+        /// @brief the mesh to check versions against
+        /// (non-const because the face geometry interface takes mutable node coordinates)
+        AbstractMesh<T, IDX, ndim>* meshptr = nullptr;
+
+        /// @brief offsets of each trace into h_data (size ntrace + 1)
+        std::vector<std::size_t> qp_offsets{0};
+
+        /// @brief offsets of each trace (in basis functions) into grad_data and hess_data (size ntrace + 1)
+        /// each quadrature point stores the left then the right basis functions
+        std::vector<std::size_t> basis_offsets{0};
+
+        /// @brief the DDG interface length scale at each quadrature point
+        std::vector<T> h_data{};
+
+        /// @brief the physical basis gradients (ndim per basis function)
+        std::vector<T> grad_data{};
+
+        /// @brief the physical basis hessians (ndim * ndim per basis function)
+        std::vector<T> hess_data{};
+
+        /// @brief the versions of the left and right element each trace was computed at
+        std::vector<std::size_t> versions_l{}, versions_r{};
+
+        /// @brief compute the data for the given interior trace
+        template<class TraceType>
+        auto compute_trace(const TraceType& trace, PhysDomainEvalStorage<T, ndim>& storageL,
+                PhysDomainEvalStorage<T, ndim>& storageR) -> void {
+            using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+            const int nbL = trace.elL.nbasis(), nbR = trace.elR.nbasis();
+            auto centroidL = trace.elL.centroid();
+            auto centroidR = trace.centroid_r();
+            const bool geo_cached = trace.has_geometric_factors();
+            for(int iqp = 0; iqp < trace.nQP(); ++iqp){
+                Tensor<T, ndim> unit_normal;
+                MATH::GEOMETRY::Point<T, ndim> phys_pt;
+                if(geo_cached){
+                    unit_normal = trace.geo_factors->unit_normal(trace.facidx, iqp);
+                    phys_pt = trace.geo_factors->trace_phys_pt(trace.facidx, iqp);
+                } else {
+                    const auto& quadpt = trace.getQP(iqp);
+                    unit_normal = normalize(calc_ortho(trace.face->Jacobian(meshptr->coord, quadpt.abscisse)));
+                    trace.face->transform(quadpt.abscisse, meshptr->coord, phys_pt);
+                }
+                h_data[qp_offsets[trace.facidx] + iqp] = ddg_interface_distance<T, ndim>(unit_normal, phys_pt, centroidL, centroidR);
+
+                PhysDomainEval evalL{storageL, trace.elL, trace.xiL_qp(iqp), trace.qp_evals_l[iqp],
+                    trace.jacobian_l_qp(iqp), trace.hessian_l_qp(iqp)};
+                PhysDomainEval evalR{storageR, trace.elR, trace.xiR_qp(iqp), trace.qp_evals_r[iqp],
+                    trace.jacobian_r_qp(iqp), trace.hessian_r_qp(iqp)};
+                std::size_t ibasis = basis_offsets[trace.facidx] + iqp * (nbL + nbR);
+                std::copy_n(storageL.gradient_storage.data(), nbL * ndim, grad_data.data() + ibasis * ndim);
+                std::copy_n(storageR.gradient_storage.data(), nbR * ndim, grad_data.data() + (ibasis + nbL) * ndim);
+                std::copy_n(storageL.hessian_storage.data(), nbL * ndim * ndim, hess_data.data() + ibasis * ndim * ndim);
+                std::copy_n(storageR.hessian_storage.data(), nbR * ndim * ndim,
+                        hess_data.data() + (ibasis + nbL) * ndim * ndim);
+            }
+            versions_l[trace.facidx] = meshptr->element_coord_version(trace.elL.elidx);
+            versions_r[trace.facidx] = meshptr->element_coord_version(trace.elR.elidx);
+        }
+
+        /// @brief compute each trace in [begin, end) that is out of date
+        template<class TraceType>
+        auto compute_range(const std::vector<TraceType>& traces, std::size_t begin, std::size_t end) -> void {
+            for(std::size_t itrace = begin; itrace < end; ++itrace){
+                const TraceType& trace = traces[itrace];
+                if(trace_valid(trace)) continue;
+                PhysDomainEvalStorage storageL{trace.elL};
+                PhysDomainEvalStorage storageR{trace.elR};
+                compute_trace(trace, storageL, storageR);
+            }
+        }
+
+        public:
+
+        DDGTraceFactors() = default;
+
+        /**
+         * @brief build the DDG data for the interior traces
+         * @param mesh the mesh the traces are defined on
+         * @param traces the traces (indexed by facidx)
+         * @param interior_begin the index of the first interior trace
+         * @param interior_end one past the index of the last interior trace
+         */
+        template<class TraceType>
+        DDGTraceFactors(
+            AbstractMesh<T, IDX, ndim>& mesh,
+            const std::vector<TraceType>& traces,
+            std::size_t interior_begin,
+            std::size_t interior_end
+        ) : meshptr{&mesh} {
+            qp_offsets.assign(traces.size() + 1, 0);
+            basis_offsets.assign(traces.size() + 1, 0);
+            for(std::size_t itrace = interior_begin; itrace < interior_end; ++itrace){
+                const TraceType& trace = traces[itrace];
+                qp_offsets[itrace + 1] = trace.nQP();
+                basis_offsets[itrace + 1] = trace.nQP() * (trace.elL.nbasis() + trace.elR.nbasis());
+            }
+            for(std::size_t itrace = 0; itrace < traces.size(); ++itrace){
+                qp_offsets[itrace + 1] += qp_offsets[itrace];
+                basis_offsets[itrace + 1] += basis_offsets[itrace];
+            }
+            h_data.resize(qp_offsets.back());
+            grad_data.resize(basis_offsets.back() * ndim);
+            hess_data.resize(basis_offsets.back() * ndim * ndim);
+            versions_l.assign(traces.size(), never_valid);
+            versions_r.assign(traces.size(), never_valid);
+            compute_range(traces, interior_begin, interior_end);
+        }
+
+        /**
+         * @brief recompute only the traces that are out of date with the mesh
+         * @param traces the traces this was built with
+         * @param interior_begin the index of the first interior trace
+         * @param interior_end one past the index of the last interior trace
+         */
+        template<class TraceType>
+        auto update(const std::vector<TraceType>& traces, std::size_t interior_begin, std::size_t interior_end) -> void {
+            compute_range(traces, interior_begin, interior_end);
+        }
+
+        /// @brief check if the cached data for the given trace is up to date
+        template<class TraceType>
+        auto trace_valid(const TraceType& trace) const noexcept -> bool {
+            return versions_l[trace.facidx] != never_valid
+                && versions_l[trace.facidx] == meshptr->element_coord_version(trace.elL.elidx)
+                && versions_r[trace.facidx] == meshptr->element_coord_version(trace.elR.elidx);
+        }
+
+        /// @brief the DDG interface length scale at the given quadrature point of a trace
+        auto h_ddg(IDX itrace, int iqp) const noexcept -> T
+        { return h_data[qp_offsets[itrace] + iqp]; }
+
+        /// @brief the physical gradients of the left basis functions at the given quadrature point of a trace
+        template<class TraceType>
+        auto grad_basis_l(const TraceType& trace, int iqp) const -> grad_span_t {
+            std::size_t ibasis = basis_offsets[trace.facidx] + iqp * (trace.elL.nbasis() + trace.elR.nbasis());
+            return grad_span_t{grad_data.data() + ibasis * ndim, trace.elL.nbasis()};
+        }
+
+        /// @brief the physical gradients of the right basis functions at the given quadrature point of a trace
+        template<class TraceType>
+        auto grad_basis_r(const TraceType& trace, int iqp) const -> grad_span_t {
+            std::size_t ibasis = basis_offsets[trace.facidx] + iqp * (trace.elL.nbasis() + trace.elR.nbasis())
+                + trace.elL.nbasis();
+            return grad_span_t{grad_data.data() + ibasis * ndim, trace.elR.nbasis()};
+        }
+
+        /// @brief the physical hessians of the left basis functions at the given quadrature point of a trace
+        template<class TraceType>
+        auto hess_basis_l(const TraceType& trace, int iqp) const -> hess_span_t {
+            std::size_t ibasis = basis_offsets[trace.facidx] + iqp * (trace.elL.nbasis() + trace.elR.nbasis());
+            return hess_span_t{hess_data.data() + ibasis * ndim * ndim, trace.elL.nbasis()};
+        }
+
+        /// @brief the physical hessians of the right basis functions at the given quadrature point of a trace
+        template<class TraceType>
+        auto hess_basis_r(const TraceType& trace, int iqp) const -> hess_span_t {
+            std::size_t ibasis = basis_offsets[trace.facidx] + iqp * (trace.elL.nbasis() + trace.elR.nbasis())
+                + trace.elL.nbasis();
+            return hess_span_t{hess_data.data() + ibasis * ndim * ndim, trace.elR.nbasis()};
+        }
+
+        /// @brief the bytes allocated
+        [[nodiscard]] auto memory_bytes() const noexcept -> std::size_t {
+            return (qp_offsets.capacity() + basis_offsets.capacity() + versions_l.capacity() + versions_r.capacity())
+                * sizeof(std::size_t) + (h_data.capacity() + grad_data.capacity() + hess_data.capacity()) * sizeof(T);
+        }
+    };
+}
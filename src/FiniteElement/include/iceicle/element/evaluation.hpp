@@ -4,7 +4,15 @@
 #pragma once
 #include "iceicle/quadrature/QuadratureRule.hpp"
 #include "mdspan/mdspan.hpp"
+#include "Numtool/fixed_size_tensor.hpp"
 #include <iceicle/basis/basis.hpp>
+#include <iceicle/linalg/linalg_utils.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <vector>
 
 namespace iceicle {
 
@@ -88,8 +96,264 @@ namespace iceicle {
             basis.evalGradBasis(reference_domain_pt, grad_bi.data());
             basis.evalHessBasis(reference_domain_pt, hess_bi.data());
         }
+
+        // @brief Construct a Basis Evaluation that views externally owned storage
+        //
+        // @param basis the basis functions to evaluate
+        // @param reference_domain_pt the point in the reference domain to evaluate at
+        // @param bi_data storage for the basis functions [size = nbasis]
+        // @param grad_data storage for the gradients [size = nbasis * ndim]
+        // @param hess_data storage for the hessians [size = nbasis * ndim * ndim]
+        BasisEvaluation(
+            const Basis<real, ndim>& basis,
+            const Point& reference_domain_pt,
+            real* bi_data,
+            real* grad_data,
+            real* hess_data
+        ) : bi{}, grad_bi{}, hess_bi{},
+            bi_span{bi_data, (std::size_t) basis.nbasis()},
+            grad_bi_span{grad_data, basis.nbasis()},
+            hess_bi_span{hess_data, basis.nbasis()}
+        {
+            basis.evalBasis(reference_domain_pt, bi_data);
+            basis.evalGradBasis(reference_domain_pt, grad_data);
+            basis.evalHessBasis(reference_domain_pt, hess_data);
+        }
+
+        // @brief Construct a view of externally owned storage that is already filled 
+        // (i.e by the batched evaluations of the basis)
+        //
+        // @param basis the basis functions that were evaluated
+        // @param bi_data the basis functions [size = nbasis]
+        // @param grad_data the gradients [size = nbasis * ndim]
+        // @param hess_data the hessians [size = nbasis * ndim * ndim]
+        BasisEvaluation(
+            const Basis<real, ndim>& basis,
+            real* bi_data,
+            real* grad_data,
+            real* hess_data
+        ) : bi{}, grad_bi{}, hess_bi{},
+            bi_span{bi_data, (std::size_t) basis.nbasis()},
+            grad_bi_span{grad_data, basis.nbasis()},
+            hess_bi_span{hess_data, basis.nbasis()}
+        {}
+    };
+
+    /// @brief basis functions, gradients, and hessians evaluated at a set of reference domain points
+    /// stored in one contiguous, 64 byte aligned array
+    ///
+    /// The array holds all the basis function values, then all the gradients, then all the hessians.
+    /// Each point's block is padded to the alignment so that every block starts aligned.
+    /// The BasisEvaluation views into the table can be used as a contiguous range (i.e for std::span)
+    ///
+    /// @tparam real the real number type
+    /// @tparam ndim the number of dimensions
+    template<class real, int ndim>
+    class BasisEvaluationTable {
+        public:
+
+        /// @brief the alignment in bytes of the table and each block
+        static constexpr std::size_t alignment = 64;
+
+        private:
+
+        struct aligned_delete {
+            void operator()(real* ptr) const noexcept 
+            { ::operator delete[](ptr, std::align_val_t{alignment}); }
+        };
+
+        /// @brief round a number of reals up to the alignment
+        static constexpr auto padded(std::size_t n) noexcept -> std::size_t {
+            constexpr std::size_t nalign = std::max(alignment / sizeof(real), (std::size_t) 1);
+            return ((n + nalign - 1) / nalign) * nalign;
+        }
+
+        /// @brief the table storage
+        std::unique_ptr<real[], aligned_delete> storage{};
+
+        /// @brief the views into the storage for each point
+        std::vector<BasisEvaluation<real, ndim>> evals{};
+
+        /// @brief the number of points
+        std::size_t npoin = 0;
+
+        /// @brief the padded size of each block
+        std::size_t stride_bi = 0, stride_grad = 0, stride_hess = 0;
+
+        public:
+
+        using Point = MATH::GEOMETRY::Point<real, ndim>;
+
+        BasisEvaluationTable() = default;
+
+        /// @brief evaluate the basis at each of the given points
+        /// @param basis the basis functions 
+        /// @param points the reference domain points
+        BasisEvaluationTable(const Basis<real, ndim>& basis, std::span<const Point> points)
+        : npoin{points.size()}, stride_bi{padded(basis.nbasis())}, stride_grad{padded(basis.nbasis() * ndim)},
+          stride_hess{padded(basis.nbasis() * ndim * ndim)}
+        {
+            const std::size_t total = npoin * (stride_bi + stride_grad + stride_hess);
+            storage.reset(static_cast<real*>(::operator new[](
+                std::max(total, (std::size_t) 1) * sizeof(real), std::align_val_t{alignment})));
+            std::fill_n(storage.get(), total, 0.0);
+
+            // evaluate all the points with the batched evaluations 
+            // then copy into the padded blocks
+            const int nb = basis.nbasis();
+            std::vector<real> xi(npoin * ndim);
+            for(std::size_t ipoin = 0; ipoin < npoin; ++ipoin)
+                std::copy_n(points[ipoin].data(), ndim, xi.data() + ipoin * ndim);
+            std::vector<real> batch(npoin * nb * ndim * ndim);
+            auto scatter = [&](std::size_t block_size, std::size_t stride, real* dest){
+                for(std::size_t ipoin = 0; ipoin < npoin; ++ipoin)
+                    std::copy_n(batch.data() + ipoin * block_size, block_size, dest + ipoin * stride);
+            };
+            basis.evalBasisBatch(npoin, xi.data(), batch.data());
+            scatter(nb, stride_bi, bi_data());
+            basis.evalGradBasisBatch(npoin, xi.data(), batch.data());
+            scatter(nb * ndim, stride_grad, grad_data());
+            basis.evalHessBasisBatch(npoin, xi.data(), batch.data());
+            scatter(nb * ndim * ndim, stride_hess, hess_data());
+
+            evals.reserve(npoin);
+            for(std::size_t ipoin = 0; ipoin < npoin; ++ipoin){
+                evals.emplace_back(basis,
+                    bi_data() + ipoin * stride_bi,
+                    grad_data() + ipoin * stride_grad,
+                    hess_data() + ipoin * stride_hess);
+            }
+        }
+
+        /// @brief evaluate the basis at each of the quadrature points
+        /// @param basis the basis functions 
+        /// @param quadrule the quadrature rule
+        template<class IDX>
+        BasisEvaluationTable(const Basis<real, ndim>& basis, const QuadratureRule<real, IDX, ndim>& quadrule)
+        : BasisEvaluationTable(basis, [&]{
+            std::vector<Point> points(quadrule.npoints());
+            for(int iqp = 0; iqp < quadrule.npoints(); ++iqp) points[iqp] = quadrule.getPoint(iqp).abscisse;
+            return points;
+        }()) {}
+
+        /// @brief the basis function values for all points [npoin][stride_bi]
+        auto bi_data() const noexcept -> real* { return storage.get(); }
+
+        /// @brief the gradients for all points [npoin][stride_grad]
+        auto grad_data() const noexcept -> real* { return storage.get() + npoin * stride_bi; }
+
+        /// @brief the hessians for all points [npoin][stride_hess]
+        auto hess_data() const noexcept -> real* 
+        { return storage.get() + npoin * (stride_bi + stride_grad); }
+
+        /// @brief the distance between subsequent points in the gradient array
+        auto grad_stride() const noexcept -> std::size_t { return stride_grad; }
+
+        /// @brief the bytes allocated for the table and the views
+        auto memory_bytes() const noexcept -> std::size_t {
+            return npoin * (stride_bi + stride_grad + stride_hess) * sizeof(real)
+                + evals.capacity() * sizeof(BasisEvaluation<real, ndim>);
+        }
+
+        // === contiguous range of evaluations ===
+        auto size() const noexcept -> std::size_t { return evals.size(); }
+        auto data() const noexcept -> const BasisEvaluation<real, ndim>* { return evals.data(); }
+        auto begin() const noexcept -> const BasisEvaluation<real, ndim>* { return evals.data(); }
+        auto end() const noexcept -> const BasisEvaluation<real, ndim>* { return evals.data() + evals.size(); }
+        auto operator[](std::size_t ipoin) const noexcept -> const BasisEvaluation<real, ndim>& 
+        { return evals[ipoin]; }
     };
 
+    /// @brief the physical gradients of all the basis functions at a point 
+    /// as a single product with the inverse of the element transformation jacobian
+    ///
+    /// dBi/dx_j = dBi/dxi_k J^{-1}_{kj}
+    ///
+    /// @param grad_bi the reference domain gradients [nbasis x ndim]
+    /// @param Jinv the inverse of the transformation jacobian
+    /// @param [out] dbdx the physical domain gradients [nbasis x ndim]
+    template<class real, int ndim>
+    inline auto apply_inverse_jacobian(
+        linalg::in_tensor auto grad_bi,
+        const NUMTOOL::TENSOR::FIXED_SIZE::Tensor<real, ndim, ndim>& Jinv,
+        real* dbdx
+    ) noexcept -> std::mdspan<real, std::extents<int, std::dynamic_extent, ndim>> {
+        const int nbasis = grad_bi.extent(0);
+        std::mdspan<real, std::extents<int, std::dynamic_extent, ndim>> gbasis{dbdx, nbasis};
+        for(int i = 0; i < nbasis; ++i){
+            for(int j = 0; j < ndim; ++j){
+                real sum = 0;
+                for(int k = 0; k < ndim; ++k) sum += grad_bi[i, k] * Jinv[k][j];
+                gbasis[i, j] = sum;
+            }
+        }
+        return gbasis;
+    }
+
+    // ===================================
+    // = Tabulated Nodal Transformations =
+    // ===================================
+    // x(xi) = sum_i x_i N_i(xi) with the nodal geometry shape functions N_i
+    // evaluated ahead of time (i.e at the quadrature points)
+    // the shape functions must be in the node order of the element transformation
+
+    /// @brief the physical point x = sum_i x_i N_i
+    /// @param el_coord the coordinates of the element nodes
+    /// @param geo_eval the geometry shape functions evaluated at the reference domain point
+    template<class real, int ndim>
+    inline auto nodal_transform(
+        std::span<const MATH::GEOMETRY::Point<real, ndim>> el_coord,
+        const BasisEvaluation<real, ndim>& geo_eval
+    ) noexcept -> MATH::GEOMETRY::Point<real, ndim> {
+        MATH::GEOMETRY::Point<real, ndim> x;
+        std::ranges::fill(x, 0.0);
+        for(std::size_t inode = 0; inode < el_coord.size(); ++inode){
+            for(int idim = 0; idim < ndim; ++idim)
+                { x[idim] += geo_eval.bi_span[inode] * el_coord[inode][idim]; }
+        }
+        return x;
+    }
+
+    /// @brief the transformation jacobian J_ij = sum_n x_{n,i} dN_n/dxi_j
+    /// @param el_coord the coordinates of the element nodes
+    /// @param geo_eval the geometry shape functions evaluated at the reference domain point
+    template<class real, int ndim>
+    inline auto nodal_jacobian(
+        std::span<const MATH::GEOMETRY::Point<real, ndim>> el_coord,
+        const BasisEvaluation<real, ndim>& geo_eval
+    ) noexcept -> NUMTOOL::TENSOR::FIXED_SIZE::Tensor<real, ndim, ndim> {
+        NUMTOOL::TENSOR::FIXED_SIZE::Tensor<real, ndim, ndim> J;
+        J = 0;
+        for(std::size_t inode = 0; inode < el_coord.size(); ++inode){
+            for(int idim = 0; idim < ndim; ++idim){
+                for(int jdim = 0; jdim < ndim; ++jdim)
+                    { J[idim][jdim] += geo_eval.grad_bi_span[inode, jdim] * el_coord[inode][idim]; }
+            }
+        }
+        return J;
+    }
+
+    /// @brief the transformation hessian H_kij = sum_n x_{n,k} d^2N_n/dxi_i dxi_j
+    /// @param el_coord the coordinates of the element nodes
+    /// @param geo_eval the geometry shape functions evaluated at the reference domain point
+    template<class real, int ndim>
+    inline auto nodal_hessian(
+        std::span<const MATH::GEOMETRY::Point<real, ndim>> el_coord,
+        const BasisEvaluation<real, ndim>& geo_eval
+    ) noexcept -> NUMTOOL::TENSOR::FIXED_SIZE::Tensor<real, ndim, ndim, ndim> {
+        NUMTOOL::TENSOR::FIXED_SIZE::Tensor<real, ndim, ndim, ndim> hess;
+        hess = 0;
+        for(std::size_t inode = 0; inode < el_coord.size(); ++inode){
+            for(int kdim = 0; kdim < ndim; ++kdim){
+                for(int idim = 0; idim < ndim; ++idim){
+                    for(int jdim = 0; jdim < ndim; ++jdim)
+                        { hess[kdim][idim][jdim] += geo_eval.hess_bi_span[inode, idim, jdim] * el_coord[inode][kdim]; }
+                }
+            }
+        }
+        return hess;
+    }
+
     template<class T, int ndim>
     BasisEvaluation(
         const Basis<T, ndim>&,
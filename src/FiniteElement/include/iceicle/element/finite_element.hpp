@@ -11,11 +11,17 @@
 #include <Numtool/matrix/dense_matrix.hpp>
 #include <Numtool/matrixT.hpp>
 #include <iceicle/basis/basis.hpp>
+#include <iceicle/basis/sum_factorization.hpp>
 #include <iceicle/element/evaluation.hpp>
+#include <iceicle/element/geometric_factors.hpp>
 #include <iceicle/geometry/geo_element.hpp>
 #include <iceicle/quadrature/QuadratureRule.hpp>
 #include <iceicle/linalg/linalg_utils.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <span>
+#include <type_traits>
 #include <vector>
 
 #include <mdspan/mdspan.hpp>
@@ -45,14 +51,16 @@ public:
                QuadratureRule<T, IDX, ndim> *quadruleptr)
       : data{static_cast<std::size_t>(quadruleptr->npoints())}, basis(basisptr),
         quadrule(quadruleptr) {
-    // call eval basis for each quadrature point and prestore
-    for (int igauss = 0; igauss < quadrule->npoints(); ++igauss) {
-      std::vector<T> &eval_vec = data[igauss];
-      eval_vec.resize(basis->nbasis());
-      basis->evalBasis(quadrule->getPoint(igauss).abscisse, eval_vec.data());
-    }
-
-    // TODO: gradient of basis (make a DenseMatrix class)
+    // evaluate the basis at all the quadrature points in one batch and prestore
+    const int nqp = quadrule->npoints(), nb = basis->nbasis();
+    std::vector<T> xi(nqp * ndim), batch(nqp * nb);
+    for (int igauss = 0; igauss < nqp; ++igauss)
+      std::copy_n(quadrule->getPoint(igauss).abscisse.data(), ndim, xi.data() + igauss * ndim);
+    basis->evalBasisBatch(nqp, xi.data(), batch.data());
+    for (int igauss = 0; igauss < nqp; ++igauss)
+      data[igauss].assign(batch.begin() + igauss * nb, batch.begin() + (igauss + 1) * nb);
+
+    // NOTE: see BasisEvaluationTable for gradients and hessians at quadrature points
   }
 
   FEEvaluation(Basis<T, ndim> &basis,
@@ -124,6 +132,37 @@ struct FiniteElement {
   /** @brief the element index in the mesh */
   const IDX elidx;
 
+  /** @brief the transformation was affine at FESpace construction 
+   * (order 1 simplices, or order 1 hypercubes with parallelepiped nodes)
+   * use is_affine() which also accounts for nodes that have moved since
+   * (next to elidx to fill its padding)
+   */
+  bool affine = false;
+
+  /** @brief the 1D tables for sum factorization 
+   * nullptr if the basis and quadrature are not tensor products 
+   * (shared with the reference element like qp_evals)
+   */
+  const SumFactorization<T, ndim> *sum_fact = nullptr;
+
+  /** @brief the cached geometric factors at the quadrature points 
+   * nullptr if the owning FESpace has not enabled the cache
+   * (check GeometricFactors::element_valid before use)
+   */
+  const GeometricFactors<T, IDX, ndim> *geo_factors = nullptr;
+
+  /** @brief the reference domain mass matrix [nbasis x nbasis] (row major)
+   * shared with the reference element 
+   * the mass matrix of an affine element is this scaled by detJ
+   */
+  std::span<const T> ref_mass{};
+
+  /** @brief the nodal geometry shape functions evaluated at the quadrature points
+   * shared with the reference element (empty to evaluate the transformation directly)
+   * so the transformation at a quadrature point is a contraction with the node coordinates
+   */
+  std::span<const Eval_t> geo_qp_evals{};
+
   // =============================
   // = Basis Function Operations =
   // =============================
@@ -223,38 +262,43 @@ struct FiniteElement {
     linalg::in_tensor auto grad_bi, 
     T *dBidxj
   ) const {
-    using namespace NUMTOOL::TENSOR::FIXED_SIZE;
-
-    // pull nbasis to variable so its more likely to be put in register
-    int ndof = nbasis();
-
-    //  fill with zero
-    std::fill_n(dBidxj, ndof * ndim, 0.0);
+    return eval_phys_grad_basis_jinv(inverse_jacobian(J), grad_bi, dBidxj);
+  }
 
-    // the inverse of J = adj(J) / det(J)
+  /**
+   * @brief the inverse of the transformation jacobian 
+   * J^{-1} = adj(J) / det(J) (protected from division by zero)
+   * @param J the jacobian of the element transformation
+   */
+  static auto inverse_jacobian(const JacobianType &J) noexcept -> JacobianType {
+    using namespace NUMTOOL::TENSOR::FIXED_SIZE;
     auto adjJ = adjugate(J);
-    auto detJ = determinant(J);
+    T detJ = determinant(J);
     detJ = (detJ == 0.0) ? 1.0 : detJ; // protect from div by zero
-
-    std::extents<int, std::dynamic_extent, ndim> extents(
-        ndof);
-    std::mdspan gbasis{dBidxj, extents};
-    // dBidxj =  Jadj_{jk} * dBidxk
-    for (int i = 0; i < ndof; ++i) {
-      for (int j = 0; j < ndim; ++j) {
-        // gbasis[i, j] = 0.0;
-        for (int k = 0; k < ndim; ++k) {
-          gbasis[i, j] += grad_bi[i, k] * adjJ[k][j];
-        }
-      }
-    }
-
-    // multiply though by the determinant
-    for (int i = 0; i < ndof * ndim; ++i) {
-      dBidxj[i] /= detJ;
+    JacobianType Jinv;
+    for (int k = 0; k < ndim; ++k) {
+      for (int j = 0; j < ndim; ++j) Jinv[k][j] = adjJ[k][j] / detJ;
     }
+    return Jinv;
+  }
 
-    return gbasis;
+  /**
+   * @brief evaluate the first derivatives of the basis functions
+   *        with respect to physical domain coordinates 
+   *        given the inverse of the transformation jacobian 
+   *        (i.e precomputed or shared between quantities at a quadrature point)
+   *
+   * @param [in] Jinv the inverse of the jacobian of the element transformation
+   * @param [in] grad_bi view over the reference gradients of the basis functions
+   * @param [out] dBidxj storage for the physical gradients [size = nbasis * ndim]
+   * @return an mdspan view of dBidxj \frac{dB_i}{dx_j} [nbasis : i][ndim : j]
+   */
+  auto eval_phys_grad_basis_jinv(
+    const JacobianType &Jinv,
+    linalg::in_tensor auto grad_bi, 
+    T *dBidxj
+  ) const noexcept {
+    return apply_inverse_jacobian<T, ndim>(grad_bi, Jinv, dBidxj);
   }
 
   /** Calculates the gradient wrt reference domain: \overload */
@@ -428,6 +472,60 @@ struct FiniteElement {
   // = Geometric Operations =
   // ========================
 
+  /// @brief check if the cached geometric factors exist and are up to date 
+  /// with the mesh for this element
+  auto has_geometric_factors() const noexcept -> bool {
+    return geo_factors != nullptr && geo_factors->element_valid(elidx);
+  }
+
+  /**
+   * @brief check if an element transformation is affine (has a constant jacobian)
+   * order 1 simplices are always affine, 
+   * order 1 hypercubes are affine if the nodes form a parallelepiped 
+   * (each vertex is the first vertex plus the sum of its edge vectors)
+   *
+   * @param trans the element transformation 
+   * @param coord_el the node coordinates of the element
+   */
+  static auto affine_transformation(
+    const ElementTransformation<T, IDX, ndim> *trans,
+    std::span<const Point> coord_el
+  ) noexcept -> bool {
+    if(trans->order != 1) return false;
+    switch(trans->domain_type){
+      case DOMAIN_TYPE::SIMPLEX:
+        return true;
+      case DOMAIN_TYPE::HYPERCUBE: {
+        // order 1 hypercube nodes are in binary tensor product ordering
+        T scale = 0;
+        for(std::size_t inode = 1; inode < coord_el.size(); ++inode){
+          for(int idim = 0; idim < ndim; ++idim)
+            { scale = std::max(scale, std::abs(coord_el[inode][idim] - coord_el[0][idim])); }
+        }
+        T tol = 1e3 * std::numeric_limits<T>::epsilon() * scale;
+        for(std::size_t inode = 1; inode < coord_el.size(); ++inode){
+          for(int idim = 0; idim < ndim; ++idim){
+            T x = coord_el[0][idim];
+            for(int ibit = 0; ibit < ndim; ++ibit){
+              if(inode & (1 << ibit)) x += coord_el[1 << ibit][idim] - coord_el[0][idim];
+            }
+            if(std::abs(x - coord_el[inode][idim]) > tol) return false;
+          }
+        }
+        return true;
+      }
+      default:
+        return false;
+    }
+  }
+
+  /// @brief check if the transformation of this element is currently affine
+  /// so the jacobian can be evaluated once for all quadrature points
+  auto is_affine() const noexcept -> bool {
+    return affine && (trans->domain_type == DOMAIN_TYPE::SIMPLEX 
+        || affine_transformation(trans, coord_el));
+  }
+
   /**
    * @brief transform from the reference domain to the physical domain
    * @param [in] pt_ref the point in the refernce domain
@@ -455,6 +553,30 @@ struct FiniteElement {
     return trans->hessian(coord_el, pt_ref);
   }
 
+  /// @brief transform the given quadrature point to the physical domain
+  /// (uses the tabulated geometry shape functions if available)
+  /// @param iqp the quadrature point index
+  auto transform_qp(int iqp) const -> Point {
+    if(!geo_qp_evals.empty()) return nodal_transform<T, ndim>(coord_el, geo_qp_evals[iqp]);
+    return transform(getQP(iqp).abscisse);
+  }
+
+  /// @brief the Jacobian of the transformation at the given quadrature point
+  /// (uses the tabulated geometry shape functions if available)
+  /// @param iqp the quadrature point index
+  auto jacobian_qp(int iqp) const -> JacobianType {
+    if(!geo_qp_evals.empty()) return nodal_jacobian<T, ndim>(coord_el, geo_qp_evals[iqp]);
+    return jacobian(getQP(iqp).abscisse);
+  }
+
+  /// @brief the Hessian of the transformation at the given quadrature point
+  /// (uses the tabulated geometry shape functions if available)
+  /// @param iqp the quadrature point index
+  auto hessian_qp(int iqp) const -> HessianType {
+    if(!geo_qp_evals.empty()) return nodal_hessian<T, ndim>(coord_el, geo_qp_evals[iqp]);
+    return hessian(getQP(iqp).abscisse);
+  }
+
   inline constexpr
   auto centroid() const -> Point
   {
@@ -535,8 +657,30 @@ struct PhysDomainEval {
       const FiniteElement<T, IDX, ndim>& el, 
       const Point& pt,
       const BasisEvaluation<T, ndim>& ref_evals
+  ) : PhysDomainEval{storage, el, pt, ref_evals, el.jacobian(pt), el.hessian(pt)}
+  {}
+
+  /** 
+   * @brief compute the evaluation given the transformation jacobian and hessian at the point
+   * (i.e from tabulated geometry shape functions)
+   *
+   * @param el the FiniteElement to compute for 
+   * @param pt the point in the reference domain 
+   * @param ref_evals the evaluations of basis functions and derivatives
+   * wrt the reference domain at pt
+   * @param jac the jacobian of the element transformation at pt
+   * @param hess the hessian of the element transformation at pt
+   */
+  template<class IDX>
+  PhysDomainEval(
+      PhysDomainEvalStorage<T, ndim>& storage,
+      const FiniteElement<T, IDX, ndim>& el, 
+      const Point& pt,
+      const BasisEvaluation<T, ndim>& ref_evals,
+      const JacobianType& jac,
+      const HessianType& hess
   ) : storage{storage},
-      jac{el.jacobian(pt)}, hess{el.hessian(pt)}, 
+      jac{jac}, hess{hess}, 
       phys_grad_basis{storage.gradient_storage.data(), el.nbasis()},
       phys_hess_basis{storage.hessian_storage.data(), el.nbasis()}
   {
@@ -576,6 +720,94 @@ PhysDomainEval(
     const FiniteElement<T, IDX, ndim>&,
     const typename PhysDomainEval<T, ndim>::Point&)
   -> PhysDomainEval<T, ndim>;
+template<class T, class IDX, int ndim>
+PhysDomainEval(
+    PhysDomainEvalStorage<T, ndim>&,
+    const FiniteElement<T, IDX, ndim>&,
+    const typename PhysDomainEval<T, ndim>::Point&,
+    const BasisEvaluation<T, ndim>&,
+    const typename PhysDomainEval<T, ndim>::JacobianType&,
+    const typename PhysDomainEval<T, ndim>::HessianType&) 
+  -> PhysDomainEval<T, ndim>;
+
+/**
+ * @brief the inverse jacobian and integration measure max(0, detJ) * weight
+ * at the quadrature points of an element from the cheapest available source
+ *
+ * - the geometric factor cache if it is up to date 
+ * - the constant jacobian of affine elements (evaluated once)
+ * - direct evaluation of the jacobian at each quadrature point
+ *
+ * @tparam TransT the concrete transformation type of the element 
+ * (i.e transformations::hypercube) so the jacobian can be inlined 
+ * or void to use the ElementTransformation of the element
+ */
+template<class T, class IDX, int ndim, class TransT = void>
+class QPGeometry {
+  public:
+  using Point = MATH::GEOMETRY::Point<T, ndim>;
+  using JacobianType = NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, ndim, ndim>;
+
+  /// @brief the geometric quantities at a quadrature point
+  struct value_type {
+    JacobianType Jinv;
+    T dvol;
+  };
+
+  private:
+  const FiniteElement<T, IDX, ndim>& el;
+  bool cached;
+  bool affine;
+  JacobianType Jinv_affine{};
+  T detJ_affine = 0;
+
+  /// @brief the jacobian of the element transformation at a quadrature point
+  /// (the tabulated geometry shape functions are cheaper than either evaluation of the transformation)
+  auto jacobian(int iqp) const -> JacobianType {
+    if(!el.geo_qp_evals.empty()) return el.jacobian_qp(iqp);
+    else if constexpr (std::is_void_v<TransT>) return el.jacobian(el.getQP(iqp).abscisse);
+    else return TransT::jacobian(el.coord_el, el.getQP(iqp).abscisse);
+  }
+
+  public:
+  QPGeometry(const FiniteElement<T, IDX, ndim>& el)
+  : el{el}, cached{el.has_geometric_factors()}, affine{!cached && el.is_affine()}
+  {
+    if(affine){
+      JacobianType J = jacobian(0);
+      Jinv_affine = FiniteElement<T, IDX, ndim>::inverse_jacobian(J);
+      // prevent duplicate contribution of overlapping range in transformation
+      detJ_affine = std::max((T) 0.0, NUMTOOL::TENSOR::FIXED_SIZE::determinant(J));
+    }
+  }
+
+  /// @brief get the inverse jacobian and integration measure at the given quadrature point
+  auto operator[](int iqp) const -> value_type {
+    if(cached){
+      return value_type{el.geo_factors->inverse_jacobian(el.elidx, iqp),
+        el.geo_factors->dvol(el.elidx, iqp)};
+    } else if(affine) {
+      return value_type{Jinv_affine, detJ_affine * el.getQP(iqp).weight};
+    } else {
+      JacobianType J = jacobian(iqp);
+      // prevent duplicate contribution of overlapping range in transformation
+      // this occurs in concave elements
+      return value_type{FiniteElement<T, IDX, ndim>::inverse_jacobian(J),
+        std::max((T) 0.0, NUMTOOL::TENSOR::FIXED_SIZE::determinant(J)) * el.getQP(iqp).weight};
+    }
+  }
+
+  /// @brief get the physical location of the given quadrature point
+  auto phys_pt(int iqp) const -> Point {
+    if(cached) return el.geo_factors->element_phys_pt(el.elidx, iqp);
+    else if(!el.geo_qp_evals.empty()) return el.transform_qp(iqp);
+    else if constexpr (std::is_void_v<TransT>) return el.transform(el.getQP(iqp).abscisse);
+    else return TransT::transform(el.coord_el, el.getQP(iqp).abscisse);
+  }
+};
+
+template<class T, class IDX, int ndim>
+QPGeometry(const FiniteElement<T, IDX, ndim>&) -> QPGeometry<T, IDX, ndim>;
 
 /**
  * @brief calculate the mass matrix for an element 
@@ -590,11 +822,24 @@ MATH::MATRIX::DenseMatrix<T> calculate_mass_matrix(
   MATH::MATRIX::DenseMatrix<T> mass(el.nbasis(), el.nbasis());
   mass = 0;
 
+  // affine elements: scale the reference mass matrix by the constant detJ
+  if(!el.ref_mass.empty() && el.is_affine()){
+    auto J = el.jacobian(el.getQP(0).abscisse);
+    T detJ = NUMTOOL::TENSOR::FIXED_SIZE::determinant(J);
+    int nbasis = el.nbasis();
+    for(int ibasis = 0; ibasis < nbasis; ++ibasis){
+      for(int jbasis = 0; jbasis < nbasis; ++jbasis){
+        mass[ibasis][jbasis] = el.ref_mass[ibasis * nbasis + jbasis] * detJ;
+      }
+    }
+    return mass;
+  }
+
   for(int ig = 0; ig < el.nQP(); ++ig){
     const QuadraturePoint<T, ndim> quadpt = el.getQP(ig);
 
     // calculate the jacobian determinant
-    auto J = el.jacobian(quadpt.abscisse);
+    auto J = el.jacobian_qp(ig);
     T detJ = NUMTOOL::TENSOR::FIXED_SIZE::determinant(J);
 
     // integrate Bi * Bj
@@ -610,4 +855,34 @@ MATH::MATRIX::DenseMatrix<T> calculate_mass_matrix(
   return mass;
 }
 
+/**
+ * @brief if the mass matrix of an element is diagonal:
+ * an orthonormal basis (diagonal reference mass matrix) on an affine element
+ * @param el the element
+ */
+template<class T, class IDX, int ndim>
+auto has_diagonal_mass(const FiniteElement<T, IDX, ndim> &el) -> bool {
+  return el.basis->isOrthonormal() && !el.ref_mass.empty() && el.is_affine();
+}
+
+/**
+ * @brief calculate the inverse of a diagonal mass matrix (see has_diagonal_mass)
+ * 1 / (detJ * M_ref,ii) without forming the mass matrix
+ * @param el the element
+ * @param [out] minv_diag the diagonal of the inverse mass matrix [nbasis]
+ * @return false if the mass matrix is singular (minv_diag is then unspecified)
+ */
+template<class T, class IDX, int ndim>
+auto calculate_inverse_diagonal_mass(const FiniteElement<T, IDX, ndim> &el, T* minv_diag) -> bool {
+  auto J = el.jacobian(el.getQP(0).abscisse);
+  T detJ = NUMTOOL::TENSOR::FIXED_SIZE::determinant(J);
+  int nbasis = el.nbasis();
+  for(int ibasis = 0; ibasis < nbasis; ++ibasis){
+    T mii = el.ref_mass[ibasis * nbasis + ibasis] * detJ;
+    if(mii == 0) return false;
+    minv_diag[ibasis] = 1.0 / mii;
+  }
+  return true;
+}
+
 } // namespace ELEMENT
@@ -0,0 +1,311 @@
+/**
+ * @brief cache of the geometric factors at the quadrature points of a finite element space
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "Numtool/fixed_size_tensor.hpp"
+#include "Numtool/point.hpp"
+#include <iceicle/fe_definitions.hpp>
+#include <iceicle/mesh/mesh.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace iceicle {
+
+    /**
+     * @brief per quadrature point geometric factors for all the elements and traces
+     * of a finite element space
+     *
+     * Elements store the inverse jacobian, the integration measure detJ * weight,
+     * and the physical quadrature point.
+     * Traces store the unit normal, the integration measure sqrt(g) * weight,
+     * and the physical quadrature point.
+     *
+     * Each entry records the AbstractMesh::element_coord_version it was computed at
+     * so that only the elements (and the traces of those elements)
+     * touched by AbstractMesh::update_node() need to be recomputed by update().
+     * Entries that are out of date report invalid and the caller should compute directly.
+     *
+     * In compact mode affine elements store a single inverse jacobian for all their quadrature points
+     * (an element that stops being affine when nodes move gets the full storage in update())
+     *
+     * NOTE: parallel communication traces are never cached
+     *
+     * @tparam T the floating point type
+     * @tparam IDX the index type
+     * @tparam ndim the number of dimensions
+     */
+    template<class T, class IDX, int ndim>
+    class GeometricFactors {
+        public:
+
+        using Point = MATH::GEOMETRY::Point<T, ndim>;
+        using JacobianType = NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, ndim, ndim>;
+        using NormalType = NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, ndim>;
+
+        private:
+
+        /// @brief the version for entries that are never valid
+        static constexpr std::size_t never_valid = std::numeric_limits<std::size_t>::max();
+
+        /// @brief the mesh to check versions against
+        /// (non-const because the face geometry interface takes mutable node coordinates)
+        AbstractMesh<T, IDX, ndim>* meshptr = nullptr;
+
+        // ================
+        // = Element Data =
+        // ================
+
+        /// @brief offsets of each element into the quadrature point data (size nelem + 1)
+        std::vector<std::size_t> el_offsets{0};
+
+        /// @brief store one inverse jacobian for affine elements
+        bool compact = false;
+
+        /// @brief offsets of each element into el_jinv (size nelem + 1)
+        /// an element with a single entry uses it for all quadrature points
+        std::vector<std::size_t> el_jinv_offsets{0};
+
+        /// @brief the inverse of the transformation jacobian at each quadrature point
+        std::vector<JacobianType> el_jinv{};
+
+        /// @brief max(0, detJ) * weight at each quadrature point
+        std::vector<T> el_dvol{};
+
+        /// @brief the physical location of each quadrature point
+        std::vector<Point> el_phys_pts{};
+
+        /// @brief the element coord version each element was computed at
+        std::vector<std::size_t> el_versions{};
+
+        // ==============
+        // = Trace Data =
+        // ==============
+
+        /// @brief offsets of each trace into the quadrature point data (size ntrace + 1)
+        std::vector<std::size_t> trace_offsets{0};
+
+        /// @brief the unit normal vector at each quadrature point
+        std::vector<NormalType> trace_normals{};
+
+        /// @brief sqrt(g) * weight at each quadrature point
+        std::vector<T> trace_dsurf{};
+
+        /// @brief the physical location of each quadrature point
+        std::vector<Point> trace_phys_pts{};
+
+        /// @brief the version of the left element each trace was computed at
+        std::vector<std::size_t> trace_versions{};
+
+        /// @brief the version an element should have to be valid
+        auto current_element_version(IDX iel) const noexcept -> std::size_t {
+            return meshptr->element_coord_version(iel);
+        }
+
+        /// @brief the version a trace should have to be valid
+        template<class TraceType>
+        auto current_trace_version(const TraceType& trace) const noexcept -> std::size_t {
+            // all the face nodes belong to the left element
+            return current_element_version(trace.elL.elidx);
+        }
+
+        /// @brief the number of inverse jacobians to store for an element
+        template<class ElementType>
+        auto njinv(const ElementType& el) const -> std::size_t {
+            return (compact && el.is_affine()) ? std::min(el.nQP(), 1) : el.nQP();
+        }
+
+        /// @brief size the element storage for the given elements
+        template<class ElementType>
+        auto layout_elements(const std::vector<ElementType>& elements) -> void {
+            el_offsets.assign(elements.size() + 1, 0);
+            el_jinv_offsets.assign(elements.size() + 1, 0);
+            for(const ElementType& el : elements){
+                el_offsets[el.elidx + 1] = el.nQP();
+                el_jinv_offsets[el.elidx + 1] = njinv(el);
+            }
+            for(std::size_t iel = 0; iel < elements.size(); ++iel){
+                el_offsets[iel + 1] += el_offsets[iel];
+                el_jinv_offsets[iel + 1] += el_jinv_offsets[iel];
+            }
+            el_jinv.assign(el_jinv_offsets.back(), JacobianType{});
+            el_jinv.shrink_to_fit();
+            el_dvol.resize(el_offsets.back());
+            el_phys_pts.resize(el_offsets.back());
+            el_versions.assign(elements.size(), never_valid);
+        }
+
+        /// @brief compute the geometric factors for the given element
+        template<class ElementType>
+        auto compute_element(const ElementType& el) -> void {
+            using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+            std::size_t offset = el_offsets[el.elidx];
+            std::size_t jinv_offset = el_jinv_offsets[el.elidx];
+            int nj = el_jinv_offsets[el.elidx + 1] - jinv_offset;
+            for(int iqp = 0; iqp < el.nQP(); ++iqp){
+                const auto& quadpt = el.getQP(iqp);
+                JacobianType J = el.jacobian_qp(iqp);
+                if(iqp < nj) el_jinv[jinv_offset + iqp] = ElementType::inverse_jacobian(J);
+                // prevent duplicate contribution of overlapping range in transformation
+                el_dvol[offset + iqp] = std::max((T) 0.0, determinant(J)) * quadpt.weight;
+                el_phys_pts[offset + iqp] = el.transform_qp(iqp);
+            }
+            el_versions[el.elidx] = current_element_version(el.elidx);
+        }
+
+        /// @brief compute the geometric factors for the given trace
+        template<class TraceType>
+        auto compute_trace(const TraceType& trace) -> void {
+            using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+            if(trace.face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM){
+                trace_versions[trace.facidx] = never_valid;
+                return;
+            }
+            std::size_t offset = trace_offsets[trace.facidx];
+
+            // use the type specific face transformation from the face table when available
+            const FaceTable<T, IDX, ndim>& ftable = meshptr->face_table;
+            const bool use_table = (std::size_t) trace.facidx < ftable.nfac()
+                && (std::size_t) trace.facidx < meshptr->faces.size()
+                && meshptr->faces[trace.facidx].get() == trace.face
+                && ftable.transformation(trace.facidx) != nullptr;
+            for(int iqp = 0; iqp < trace.nQP(); ++iqp){
+                const auto& quadpt = trace.getQP(iqp);
+                auto Jfac = (use_table)
+                    ? ftable.jacobian(trace.facidx, meshptr->coord, quadpt.abscisse)
+                    : trace.face->Jacobian(meshptr->coord, quadpt.abscisse);
+                T sqrtg = trace.face->rootRiemannMetric(Jfac, quadpt.abscisse);
+                trace_normals[offset + iqp] = normalize(calc_ortho(Jfac));
+                trace_dsurf[offset + iqp] = sqrtg * quadpt.weight;
+                if(use_table) {
+                    ftable.transform(trace.facidx, quadpt.abscisse, meshptr->coord, trace_phys_pts[offset + iqp]);
+                } else {
+                    trace.face->transform(quadpt.abscisse, meshptr->coord, trace_phys_pts[offset + iqp]);
+                }
+            }
+            trace_versions[trace.facidx] = current_trace_version(trace);
+        }
+
+        public:
+
+        GeometricFactors() = default;
+
+        /**
+         * @brief build the geometric factors for all elements and traces
+         * @param mesh the mesh the elements and traces are defined on
+         * @param elements the elements (indexed by elidx)
+         * @param traces the traces (indexed by facidx)
+         * @param compact store a single inverse jacobian for affine elements
+         */
+        template<class ElementType, class TraceType>
+        GeometricFactors(
+            AbstractMesh<T, IDX, ndim>& mesh,
+            const std::vector<ElementType>& elements,
+            const std::vector<TraceType>& traces,
+            bool compact = false
+        ) : meshptr{&mesh}, compact{compact} {
+            layout_elements(elements);
+
+            trace_offsets.resize(traces.size() + 1);
+            for(const TraceType& trace : traces)
+                { trace_offsets[trace.facidx + 1] = trace.nQP(); }
+            for(std::size_t itrace = 0; itrace < traces.size(); ++itrace)
+                { trace_offsets[itrace + 1] += trace_offsets[itrace]; }
+            trace_normals.resize(trace_offsets.back());
+            trace_dsurf.resize(trace_offsets.back());
+            trace_phys_pts.resize(trace_offsets.back());
+            trace_versions.resize(traces.size());
+
+            for(const ElementType& el : elements) compute_element(el);
+            for(const TraceType& trace : traces) compute_trace(trace);
+        }
+
+        /**
+         * @brief recompute only the entries that are out of date with the mesh
+         * @param elements the elements this was built with
+         * @param traces the traces this was built with
+         */
+        template<class ElementType, class TraceType>
+        auto update(
+            const std::vector<ElementType>& elements,
+            const std::vector<TraceType>& traces
+        ) -> void {
+            // elements that moved out of affine need the inverse jacobian at every quadrature point
+            if(compact){
+                bool relayout = false;
+                for(const ElementType& el : elements){
+                    if(!element_valid(el.elidx) && 
+                        (std::size_t) njinv(el) > el_jinv_offsets[el.elidx + 1] - el_jinv_offsets[el.elidx])
+                        { relayout = true; }
+                }
+                if(relayout) layout_elements(elements);
+            }
+            for(const ElementType& el : elements){
+                if(!element_valid(el.elidx)) compute_element(el);
+            }
+            for(const TraceType& trace : traces){
+                if(trace.face->bctype != BOUNDARY_CONDITIONS::PARALLEL_COM && !trace_valid(trace))
+                    compute_trace(trace);
+            }
+        }
+
+        /// @brief check if the cached data for the given element is up to date
+        /// @param iel the element index
+        auto element_valid(IDX iel) const noexcept -> bool {
+            return el_versions[iel] == current_element_version(iel);
+        }
+
+        /// @brief check if the cached data for the given trace is up to date
+        /// @param trace the trace
+        template<class TraceType>
+        auto trace_valid(const TraceType& trace) const noexcept -> bool {
+            return trace_versions[trace.facidx] != never_valid 
+                && trace_versions[trace.facidx] == current_trace_version(trace);
+        }
+
+        /// @brief the inverse jacobian at the given quadrature point of an element
+        auto inverse_jacobian(IDX iel, int iqp) const noexcept -> const JacobianType& {
+            std::size_t begin = el_jinv_offsets[iel];
+            return el_jinv[(el_jinv_offsets[iel + 1] - begin == 1) ? begin : begin + iqp];
+        }
+
+        /// @brief if affine elements store a single inverse jacobian
+        [[nodiscard]] auto is_compact() const noexcept -> bool { return compact; }
+
+        /// @brief the bytes allocated for the element data
+        [[nodiscard]] auto element_memory_bytes() const noexcept -> std::size_t {
+            return (el_offsets.capacity() + el_jinv_offsets.capacity() + el_versions.capacity()) * sizeof(std::size_t)
+                + el_jinv.capacity() * sizeof(JacobianType) + el_dvol.capacity() * sizeof(T)
+                + el_phys_pts.capacity() * sizeof(Point);
+        }
+
+        /// @brief the bytes allocated for the trace data
+        [[nodiscard]] auto trace_memory_bytes() const noexcept -> std::size_t {
+            return (trace_offsets.capacity() + trace_versions.capacity()) * sizeof(std::size_t)
+                + trace_normals.capacity() * sizeof(NormalType) + trace_dsurf.capacity() * sizeof(T)
+                + trace_phys_pts.capacity() * sizeof(Point);
+        }
+
+        /// @brief max(0, detJ) * weight at the given quadrature point of an element
+        auto dvol(IDX iel, int iqp) const noexcept -> T
+        { return el_dvol[el_offsets[iel] + iqp]; }
+
+        /// @brief the physical location of the given quadrature point of an element
+        auto element_phys_pt(IDX iel, int iqp) const noexcept -> const Point&
+        { return el_phys_pts[el_offsets[iel] + iqp]; }
+
+        /// @brief the unit normal at the given quadrature point of a trace
+        auto unit_normal(IDX itrace, int iqp) const noexcept -> const NormalType&
+        { return trace_normals[trace_offsets[itrace] + iqp]; }
+
+        /// @brief sqrt(g) * weight at the given quadrature point of a trace
+        auto dsurf(IDX itrace, int iqp) const noexcept -> T
+        { return trace_dsurf[trace_offsets[itrace] + iqp]; }
+
+        /// @brief the physical location of the given quadrature point of a trace
+        auto trace_phys_pt(IDX itrace, int iqp) const noexcept -> const Point&
+        { return trace_phys_pts[trace_offsets[itrace] + iqp]; }
+    };
+}
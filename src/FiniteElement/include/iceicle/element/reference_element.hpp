@@ -5,6 +5,8 @@
 #pragma once
 #include "iceicle/basis/lagrange.hpp"
 #include "iceicle/basis/legendre.hpp"
+#include "iceicle/basis/sum_factorization.hpp"
+#include "iceicle/build_config.hpp"
 #include "iceicle/fe_definitions.hpp"
 #include "iceicle/geometry/face.hpp"
 #include "iceicle/geometry/geo_element.hpp"
@@ -15,7 +17,9 @@
 #include <iceicle/element/TraceSpace.hpp>
 #include <iceicle/tmp_utils.hpp>
 #include <Numtool/tmp_flow_control.hpp>
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 namespace iceicle {
     namespace FESPACE_ENUMS {
@@ -31,10 +35,88 @@ namespace iceicle {
             /// Gauss Legendre Quadrature rules and tensor extensions thereof
             /// uses Grundmann Moller for Simplex type elements
             GAUSS_LEGENDRE,
+            /// Gauss Lobatto Legendre tensor product rules with basis order + 1 points in 1D
+            /// the Lagrange basis uses the Gauss Lobatto nodes so it is collocated (DG-SEM)
+            /// falls back to Grundmann Moller for Simplex type elements
+            GAUSS_LOBATTO,
+            /// Fully symmetric simplex rules with positive weights (SymmetricSimplexQuadrature)
+            /// of the degree the Gauss Legendre rule with the same number of 1D points integrates on hypercubes
+            /// (or the smallest tabulated rule of higher degree)
+            /// falls back to Grundmann Moller if no sufficient rule is tabulated (Gauss Legendre on hypercubes)
+            SYMMETRIC,
             N_QUADRATURE_TYPES
         };
     }
 
+    /// @brief the largest number of 1D quadrature points a quadrature shift can add to the exact rule
+    static constexpr int MAX_QUADRATURE_SHIFT = 4;
+
+    /// @brief the largest number of 1D quadrature points of the element and trace rules
+    static constexpr int MAX_QUADRATURE_NQP = build_config::FESPACE_BUILD_PN + MAX_DYNAMIC_ORDER + MAX_QUADRATURE_SHIFT;
+
+    /**
+     * @brief the number of 1D quadrature points of the element and trace rules 
+     * (the order of the Grundmann Moller rule on simplices)
+     *
+     * The exact rule has geometry_order + basis_order points.
+     * A positive quadrature_shift adds points to over-integrate nonlinear fluxes,
+     * a negative shift removes the points added for the geometry (reduced quadrature).
+     * At least basis_order + 1 points are kept so the mass matrix stays exact on affine elements.
+     * Gauss Lobatto rules are collocated with the Lagrange nodes and are not shifted.
+     *
+     * @param qtype the quadrature type
+     * @param basis_order the polynomial order of the basis 
+     * @param geometry_order the polynomial order of the transformation
+     * @param quadrature_shift the number of points to add (or remove) from the exact rule
+     */
+    inline constexpr
+    auto quadrature_npoints_1d(FESPACE_ENUMS::FESPACE_QUADRATURE qtype, int basis_order,
+            int geometry_order, int quadrature_shift = 0) noexcept -> int {
+        if(qtype == FESPACE_ENUMS::GAUSS_LOBATTO) return std::max(basis_order + 1, 2);
+        int shift = std::min(quadrature_shift, MAX_QUADRATURE_SHIFT);
+        return std::clamp(geometry_order + basis_order + shift, std::max(basis_order + 1, 1), MAX_QUADRATURE_NQP);
+    }
+
+    /// @brief the quadrature shift that is actually applied (see quadrature_npoints_1d)
+    /// so type keys of the same rule compare equal
+    inline constexpr
+    auto effective_quadrature_shift(FESPACE_ENUMS::FESPACE_QUADRATURE qtype, int basis_order,
+            int geometry_order, int quadrature_shift) noexcept -> int {
+        if(qtype == FESPACE_ENUMS::GAUSS_LOBATTO) return 0;
+        return quadrature_npoints_1d(qtype, basis_order, geometry_order, quadrature_shift)
+            - (geometry_order + basis_order);
+    }
+
+    /**
+     * @brief tabulate the nodal geometry shape functions of an element transformation at reference domain points
+     * These are in the node order of the transformation (see nodal_jacobian)
+     *
+     * Only hypercube transformations are tabulated (the simplex transformations are affine)
+     *
+     * @param domain_type the domain type of the transformation
+     * @param geometry_order the polynomial order of the transformation
+     * @param points the reference domain points (a QuadratureRule or a span of points)
+     * @return the evaluations or an empty table if the transformation is not tabulated
+     */
+    template<typename T, typename IDX, int ndim, class PointsT>
+    auto tabulate_geometry(DOMAIN_TYPE domain_type, int geometry_order, const PointsT& points)
+    -> BasisEvaluationTable<T, ndim> {
+        BasisEvaluationTable<T, ndim> geo_evals{};
+        if(domain_type == DOMAIN_TYPE::HYPERCUBE) {
+            NUMTOOL::TMP::invoke_at_index(
+                NUMTOOL::TMP::make_range_sequence<int, 1, MAX_DYNAMIC_ORDER>{},
+                geometry_order,
+                [&]<int geo_order>{
+                    // the same uniform nodes as transformations::hypercube
+                    geo_evals = BasisEvaluationTable<T, ndim>{
+                        HypercubeLagrangeBasis<T, IDX, ndim, geo_order>{}, points};
+                    return 0;
+                }
+            );
+        }
+        return geo_evals;
+    }
+
     template<typename T, typename IDX, int ndim>
     class ReferenceElement {
         using BasisType = Basis<T, ndim>;
@@ -44,7 +126,35 @@ namespace iceicle {
         public:
         std::unique_ptr<BasisType> basis;
         std::unique_ptr<QuadratureType> quadrule;
-        std::vector<BasisEvaluation<T, ndim>> evals;
+        BasisEvaluationTable<T, ndim> evals;
+
+        /// @brief 1D tables for sum factorization (nullptr if the basis or quadrature is not a tensor product)
+        std::unique_ptr<SumFactorization<T, ndim>> sum_fact;
+
+        /// @brief the reference domain mass matrix [nbasis x nbasis] (row major)
+        std::vector<T> ref_mass;
+
+        /// @brief the nodal geometry shape functions at the quadrature points 
+        /// (empty if the geometry is not tabulated, see tabulate_geometry)
+        BasisEvaluationTable<T, ndim> geo_evals;
+
+        private:
+
+        /// @brief integrate the products of basis functions over the reference domain
+        auto compute_ref_mass() -> void {
+            int nbasis = basis->nbasis();
+            ref_mass.assign(nbasis * nbasis, 0.0);
+            for(int iqp = 0; iqp < quadrule->npoints(); ++iqp){
+                T weight = (*quadrule)[iqp].weight;
+                auto bi = evals[iqp].bi_span;
+                for(int ibasis = 0; ibasis < nbasis; ++ibasis){
+                    for(int jbasis = 0; jbasis < nbasis; ++jbasis)
+                        { ref_mass[ibasis * nbasis + jbasis] += bi[ibasis] * bi[jbasis] * weight; }
+                }
+            }
+        }
+
+        public:
 
         ReferenceElement() = default;
 
@@ -54,16 +164,23 @@ namespace iceicle {
             int geometry_order,
             FESPACE_ENUMS::FESPACE_BASIS_TYPE basis_type,
             FESPACE_ENUMS::FESPACE_QUADRATURE quadrature_type,
-            tmp::compile_int<basis_order> basis_order_arg
+            tmp::compile_int<basis_order> basis_order_arg,
+            int quadrature_shift = 0
         ) {
             using namespace FESPACE_ENUMS;
+            const int nqp_1d = quadrature_npoints_1d(quadrature_type, basis_order, geometry_order, quadrature_shift);
             switch(domain_type){
                 case DOMAIN_TYPE::HYPERCUBE: {
                     // construct the basis 
                     switch(basis_type){
                         case LAGRANGE:
-                            basis = std::make_unique<HypercubeLagrangeBasis<
-                                T, IDX, ndim, basis_order>>();
+                            if(quadrature_type == GAUSS_LOBATTO){
+                                basis = std::make_unique<HypercubeLagrangeBasis<T, IDX, ndim, basis_order,
+                                    GaussLobattoLagrangeInterpolation<T, basis_order>>>();
+                            } else {
+                                basis = std::make_unique<HypercubeLagrangeBasis<
+                                    T, IDX, ndim, basis_order>>();
+                            }
                             break;
                         case LEGENDRE:
                             basis = std::make_unique<HypercubeLegendreBasis<
@@ -74,29 +191,40 @@ namespace iceicle {
                     }
 
                     // construct the quadrature rule
-                    auto el_order_dispatch = [&]<int geo_order>{
-                        switch(quadrature_type){
-                            // number of quadrature points in 1D
-                            static constexpr int nqp = geo_order + basis_order;
-                            case FESPACE_ENUMS::GAUSS_LEGENDRE:
-                                quadrule = std::make_unique<HypercubeGaussLegendre<T, IDX, ndim, nqp>>();
-                                break;
-                            default:
-                                break;
+                    if(quadrature_type == GAUSS_LOBATTO) {
+                        // the Lagrange nodes are the quadrature points
+                        static constexpr int nqp_gll = std::max(basis_order + 1, 2);
+                        quadrule = std::make_unique<HypercubeGaussLobatto<T, IDX, ndim, nqp_gll>>();
+                        if(basis_type == LAGRANGE){
+                            sum_fact = std::make_unique<SumFactorization<T, ndim>>(
+                                gauss_lobatto_sum_factorization_tables<
+                                    GaussLobattoLagrangeInterpolation<T, basis_order>, nqp_gll>);
                         }
-                        return 0;
-                    };
-                    NUMTOOL::TMP::invoke_at_index(
-                        NUMTOOL::TMP::make_range_sequence<int, 1, MAX_DYNAMIC_ORDER>{},
-                        geometry_order,
-                        el_order_dispatch
-                    );
+                    } else {
+                        // GAUSS_LEGENDRE and SYMMETRIC (the tensor product rule is already symmetric)
+                        // with nqp_1d points in 1D
+                        auto nqp_dispatch = [&]<int nqp>{
+                            quadrule = std::make_unique<HypercubeGaussLegendre<T, IDX, ndim, nqp>>();
 
-                    // construct the evaluation
-                    for(int iqp = 0; iqp < quadrule->npoints(); ++iqp){
-                        evals.push_back(BasisEvaluation{
-                                *basis, quadrule->getPoint(iqp).abscisse});
+                            // tensor product lagrange basis on tensor product quadrature
+                            if(basis_type == LAGRANGE){
+                                sum_fact = std::make_unique<SumFactorization<T, ndim>>(
+                                    gauss_legendre_sum_factorization_tables<
+                                        UniformLagrangeInterpolation<T, basis_order>, nqp>);
+                            }
+                            return 0;
+                        };
+                        NUMTOOL::TMP::invoke_at_index(
+                            NUMTOOL::TMP::make_range_sequence<int, 1, MAX_QUADRATURE_NQP>{},
+                            nqp_1d,
+                            nqp_dispatch
+                        );
                     }
+
+                    // construct the evaluation
+                    evals = BasisEvaluationTable<T, ndim>{*basis, *quadrule};
+                    geo_evals = tabulate_geometry<T, IDX, ndim>(domain_type, geometry_order, *quadrule);
+                    compute_ref_mass();
                     break;
                 }
                 case DOMAIN_TYPE::SIMPLEX: {
@@ -115,29 +243,38 @@ namespace iceicle {
                     }
 
                     // construct the quadrature rule
-                    auto el_order_dispatch = [&]<int geo_order>{
+                    auto nqp_dispatch = [&]<int nqp>{
                         switch(quadrature_type){
-                            // number of quadrature points in 1D
-                            static constexpr int nqp = geo_order + basis_order;
                             case FESPACE_ENUMS::GAUSS_LEGENDRE:
+                            case FESPACE_ENUMS::GAUSS_LOBATTO: // no Lobatto rule on simplices
                                 quadrule = std::make_unique<GrundmannMollerSimplexQuadrature<T, IDX, ndim, nqp>>();
                                 break;
+                            case FESPACE_ENUMS::SYMMETRIC:
+                            {
+                                static constexpr int degree = symmetric_simplex_degree<ndim, 2 * nqp - 1>;
+                                if constexpr (degree > 0) {
+                                    quadrule = std::make_unique<SymmetricSimplexQuadrature<T, IDX, ndim, degree>>();
+                                } else {
+                                    quadrule = std::make_unique<GrundmannMollerSimplexQuadrature<T, IDX, ndim, nqp>>();
+                                }
+                                break;
+                            }
                             default:
                                 break;
                         }
                         return 0;
                     };
+                    // the Grundmann Moller fallback of Gauss Lobatto is not shifted either
                     NUMTOOL::TMP::invoke_at_index(
-                        NUMTOOL::TMP::make_range_sequence<int, 1, MAX_DYNAMIC_ORDER>{},
-                        geometry_order,
-                        el_order_dispatch
+                        NUMTOOL::TMP::make_range_sequence<int, 1, MAX_QUADRATURE_NQP>{},
+                        (quadrature_type == GAUSS_LOBATTO)
+                            ? quadrature_npoints_1d(GAUSS_LEGENDRE, basis_order, geometry_order) : nqp_1d,
+                        nqp_dispatch
                     );
 
                     // construct the evaluation
-                    for(int iqp = 0; iqp < quadrule->npoints(); ++iqp){
-                        evals.push_back(BasisEvaluation{
-                                *basis, quadrule->getPoint(iqp).abscisse});
-                    }
+                    evals = BasisEvaluationTable<T, ndim>{*basis, *quadrule};
+                    compute_ref_mass();
 
                     break;
                 }
@@ -188,10 +325,9 @@ namespace iceicle {
             }
 
             // construct the evaluation
-            for(int iqp = 0; iqp < quadrule->npoints(); ++iqp){
-                evals.push_back(BasisEvaluation{
-                        *basis, quadrule->getPoint(iqp).abscisse});
-            }
+            evals = BasisEvaluationTable<T, ndim>{*basis, *quadrule};
+            geo_evals = tabulate_geometry<T, IDX, ndim>(domain_type, geometry_order, *quadrule);
+            compute_ref_mass();
         }
     };
 
@@ -209,8 +345,26 @@ namespace iceicle {
         public:
         std::unique_ptr<Quadrature> quadrule;
         std::unique_ptr<TraceBasisType> trace_basis;
-        std::vector<BasisEvaluation<T, ndim>> evals_l;
-        std::vector<BasisEvaluation<T, ndim>> evals_r;
+        BasisEvaluationTable<T, ndim> evals_l;
+        BasisEvaluationTable<T, ndim> evals_r;
+
+        /// @brief the quadrature points mapped to the left element reference domain
+        std::vector<DomainPoint> qp_xi_l;
+
+        /// @brief the quadrature points mapped to the right element reference domain
+        std::vector<DomainPoint> qp_xi_r;
+
+        /// @brief the nodal geometry shape functions of the left element at the quadrature points
+        /// (empty if not tabulated, see build_geometry_evals)
+        BasisEvaluationTable<T, ndim> geo_evals_l;
+
+        /// @brief the nodal geometry shape functions of the right element at the quadrature points
+        BasisEvaluationTable<T, ndim> geo_evals_r;
+
+        /// @brief the element transformations the geometry tables are for 
+        /// (a trace can only use the tables if its elements have the same transformation)
+        const ElementTransformation<T, IDX, ndim>* geo_trans_l = nullptr;
+        const ElementTransformation<T, IDX, ndim>* geo_trans_r = nullptr;
 
         ReferenceTraceSpace() = default;
 
@@ -222,9 +376,12 @@ namespace iceicle {
             const Basis<T, ndim>& basisL,
             const Basis<T, ndim>& basisR,
             std::integral_constant<int, basis_order> b_order,
-            std::integral_constant<int, geo_order> g_order
+            std::integral_constant<int, geo_order> g_order,
+            int quadrature_shift = 0
         ) {
             using namespace FESPACE_ENUMS;
+            const int nqp_1d = quadrature_npoints_1d(quadrature_type, basis_order, geo_order, quadrature_shift);
+            auto nqp_range = NUMTOOL::TMP::make_range_sequence<int, 1, MAX_QUADRATURE_NQP>{};
 
             switch(fac->domain_type()){
                 case DOMAIN_TYPE::HYPERCUBE:
@@ -237,10 +394,17 @@ namespace iceicle {
 
                     switch(quadrature_type){
                         case GAUSS_LEGENDRE:
+                        case SYMMETRIC: // the tensor product rule is already symmetric
+                            NUMTOOL::TMP::invoke_at_index(nqp_range, nqp_1d, [&]<int nqp>{
+                                quadrule = std::make_unique<HypercubeGaussLegendre<T, IDX, ndim - 1, nqp>>();
+                                return 0;
+                            });
+                            break;
+                        case GAUSS_LOBATTO:
                             quadrule = std::make_unique<
-                                HypercubeGaussLegendre<
+                                HypercubeGaussLobatto<
                                     T, IDX, ndim - 1,
-                                    (geo_order)+(basis_order)
+                                    std::max(basis_order + 1, 2)
                                 >
                             >();
                             break;
@@ -258,12 +422,27 @@ namespace iceicle {
 
                     switch(quadrature_type){
                         case GAUSS_LEGENDRE:
-                            quadrule = std::make_unique<
-                                GrundmannMollerSimplexQuadrature<
-                                    T, IDX, ndim - 1,
-                                    (geo_order)+(basis_order)
-                                >
-                            >();
+                        case GAUSS_LOBATTO: // no Lobatto rule on simplices
+                        {
+                            // the Grundmann Moller fallback of Gauss Lobatto is not shifted
+                            int nqp_gm = (quadrature_type == GAUSS_LOBATTO)
+                                ? quadrature_npoints_1d(GAUSS_LEGENDRE, basis_order, geo_order) : nqp_1d;
+                            NUMTOOL::TMP::invoke_at_index(nqp_range, nqp_gm, [&]<int nqp>{
+                                quadrule = std::make_unique<GrundmannMollerSimplexQuadrature<T, IDX, ndim - 1, nqp>>();
+                                return 0;
+                            });
+                            break;
+                        }
+                        case SYMMETRIC:
+                            NUMTOOL::TMP::invoke_at_index(nqp_range, nqp_1d, [&]<int nqp>{
+                                static constexpr int degree = symmetric_simplex_degree<ndim - 1, 2 * nqp - 1>;
+                                if constexpr (degree > 0) {
+                                    quadrule = std::make_unique<SymmetricSimplexQuadrature<T, IDX, ndim - 1, degree>>();
+                                } else {
+                                    quadrule = std::make_unique<GrundmannMollerSimplexQuadrature<T, IDX, ndim - 1, nqp>>();
+                                }
+                                return 0;
+                            });
                             break;
                         default:
                             break;
@@ -273,17 +452,36 @@ namespace iceicle {
                     break;
             }
 
-            // precompute the basis evaluations
+            // precompute the mapped quadrature points and the basis evaluations
+            // these only depend on the face domain, face numbers, and orientation
+            qp_xi_l.resize(quadrule->npoints());
+            qp_xi_r.resize(quadrule->npoints());
             for(int iqp = 0; iqp < quadrule->npoints(); ++iqp){
                 const QuadraturePoint<T, ndim - 1> &quadpt = quadrule->getPoint(iqp);
-                DomainPoint xiL, xiR;
-                fac->transform_xiL(quadpt.abscisse, xiL);
-                fac->transform_xiR(quadpt.abscisse, xiR);
-                
-                evals_l.emplace_back(basisL, xiL);
-                evals_r.emplace_back(basisR, xiR);
+                fac->transform_xiL(quadpt.abscisse, qp_xi_l[iqp]);
+                fac->transform_xiR(quadpt.abscisse, qp_xi_r[iqp]);
             }
+            evals_l = BasisEvaluationTable<T, ndim>{basisL, std::span<const DomainPoint>{qp_xi_l}};
+            evals_r = BasisEvaluationTable<T, ndim>{basisR, std::span<const DomainPoint>{qp_xi_r}};
+
+        }
 
+        /**
+         * @brief tabulate the geometry shape functions of the left and right elements at the quadrature points
+         * so the element transformation jacobians and hessians on the trace are contractions with the node coordinates
+         * @param trans_l the transformation of the left element
+         * @param trans_r the transformation of the right element
+         */
+        auto build_geometry_evals(
+            const ElementTransformation<T, IDX, ndim>* trans_l,
+            const ElementTransformation<T, IDX, ndim>* trans_r
+        ) -> void {
+            geo_trans_l = trans_l;
+            geo_trans_r = trans_r;
+            geo_evals_l = tabulate_geometry<T, IDX, ndim>(trans_l->domain_type, trans_l->order,
+                    std::span<const DomainPoint>{qp_xi_l});
+            geo_evals_r = tabulate_geometry<T, IDX, ndim>(trans_r->domain_type, trans_r->order,
+                    std::span<const DomainPoint>{qp_xi_r});
         }
     };
 }
@@ -15,6 +15,19 @@ namespace iceicle {
     template<class T, int ndim>
     using NodeArray = std::vector<MATH::GEOMETRY::Point<T, ndim>>;
 
+    /// @brief the contribution of a node of an element to the regularized location of an interior node 
+    /// x[inode] = sum weight * x[jnode] over all the entries for inode
+    /// @tparam T the real number type
+    template<class T>
+    struct interior_node_weight {
+        /// @brief the local index of the interior node in the element
+        int inode;
+        /// @brief the local index of the contributing node in the element
+        int jnode;
+        /// @brief the weight of the contribution
+        T weight;
+    };
+
     /** 
      * @brief what the reference domain is 
      * This is important for determining equivalent external API objects
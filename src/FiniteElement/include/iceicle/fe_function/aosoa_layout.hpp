@@ -0,0 +1,337 @@
+/**
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ * @brief array of structures of arrays (AoSoA) layout of DG data
+ * where blocks of elements of the same type are interleaved in the innermost dimension
+ */
+#pragma once
+#include <iceicle/fe_function/layout_enums.hpp>
+#include <iceicle/element/finite_element.hpp>
+#include <iceicle/crs.hpp>
+#include <algorithm>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace iceicle {
+
+    /**
+     * @brief map from (ielem, ildof) to the storage of a blocked DG representation
+     *
+     * Elements of each element batch (elements of the same type, see FESpace::element_batches)
+     * are chunked into blocks of nlane elements.
+     * Each block stores [dof][vector component][lane] so that the same degree of freedom
+     * of every element in the block is contiguous, and batched kernels can load a SIMD lane per element.
+     * Blocks at the end of a batch that are not full are padded with unused lanes
+     *
+     * NOTE: this is independent of vector components;
+     * the storage offsets are in units of (dof x lane) and get multiplied by the number of vector components
+     *
+     * @tparam IndexType the index type
+     * @tparam nlane the number of elements interleaved in a block
+     */
+    template< class IndexType, int nlane = 4 >
+    class dg_aosoa_map {
+    public:
+
+        // =====================
+        // = Integral Typedefs =
+        // =====================
+
+        using index_type = IndexType;
+        using size_type = std::make_unsigned_t<index_type>;
+
+        /// @brief the number of lanes in a block
+        static constexpr int block_width = nlane;
+
+        /// @brief lane entries of blocks that are not used
+        static constexpr index_type unused_lane = -1;
+
+        // ==============
+        // = Properties =
+        // ==============
+
+        /// @brief the degrees of freedom of an element are strided by the lanes of the block
+        inline static constexpr bool local_dof_contiguous() noexcept
+        { return false; }
+
+    private:
+
+        /// @brief the number of degrees of freedom of each element
+        std::vector<index_type> el_ndofs;
+
+        /// @brief the block each element belongs to
+        std::vector<index_type> el_blocks;
+
+        /// @brief the lane of each element in its block
+        std::vector<int> el_lanes;
+
+        /// @brief offsets of the start of each block in units of (dof x lane)
+        std::vector<index_type> block_offsets;
+
+        /// @brief the elements of each block (unused_lane for padding)
+        std::vector<index_type> block_els;
+
+        /// @brief the max size in number of degrees of freedom for an element
+        std::size_t max_dof_size;
+
+    public:
+
+        // ================
+        // = Constructors =
+        // ================
+
+        /** @brief default constructor */
+        constexpr dg_aosoa_map() noexcept : block_offsets{0}, max_dof_size{0} {}
+
+        /**
+         * @brief construct from a list of FiniteElements grouped into batches of the same type
+         * @param elements the finite elements
+         * @param batches each row is a set of indices into elements with the same number of basis functions
+         */
+        template<class T, int ndim>
+        dg_aosoa_map(
+            const std::vector<FiniteElement<T, index_type, ndim>> &elements,
+            const util::crs<index_type, index_type> &batches
+        ) : el_ndofs(elements.size()), el_blocks(elements.size(), unused_lane),
+            el_lanes(elements.size(), 0), block_offsets{0}, max_dof_size{0}
+        {
+            for(index_type ibatch = 0; ibatch < batches.nrow(); ++ibatch){
+                std::span<const index_type> batch_els = batches.rowspan(ibatch);
+                for(std::size_t istart = 0; istart < batch_els.size(); istart += nlane){
+                    index_type iblock = block_offsets.size() - 1;
+                    index_type ndof_block = 0;
+                    for(int ilane = 0; ilane < nlane; ++ilane){
+                        if(istart + ilane < batch_els.size()){
+                            index_type iel = batch_els[istart + ilane];
+                            el_ndofs[iel] = elements[iel].nbasis();
+                            el_blocks[iel] = iblock;
+                            el_lanes[iel] = ilane;
+                            ndof_block = std::max(ndof_block, el_ndofs[iel]);
+                            block_els.push_back(iel);
+                        } else {
+                            block_els.push_back(unused_lane);
+                        }
+                    }
+                    block_offsets.push_back(block_offsets.back() + ndof_block * nlane);
+                    max_dof_size = std::max(max_dof_size, (std::size_t) ndof_block);
+                }
+            }
+        }
+
+        // === Default copy and move semantics ===
+        dg_aosoa_map(const dg_aosoa_map<index_type, nlane>& other) = default;
+        dg_aosoa_map(dg_aosoa_map<index_type, nlane>&& other) noexcept = default;
+
+        dg_aosoa_map& operator=(const dg_aosoa_map<index_type, nlane>& other) = default;
+        dg_aosoa_map& operator=(dg_aosoa_map<index_type, nlane>&& other) noexcept = default;
+
+        // =============
+        // = Accessors =
+        // =============
+
+        /// @brief the block that the given element belongs to
+        [[nodiscard]] constexpr auto block(index_type ielem) const noexcept -> index_type
+        { return el_blocks[ielem]; }
+
+        /// @brief the lane of the given element in its block
+        [[nodiscard]] constexpr auto lane(index_type ielem) const noexcept -> int
+        { return el_lanes[ielem]; }
+
+        /// @brief the start of the given block in units of (dof x lane)
+        [[nodiscard]] constexpr auto block_offset(index_type iblock) const noexcept -> index_type
+        { return block_offsets[iblock]; }
+
+        /// @brief the elements in each lane of a block (unused_lane for padding)
+        [[nodiscard]] constexpr auto block_elements(index_type iblock) const noexcept
+        -> std::span<const index_type, nlane>
+        { return std::span<const index_type, nlane>{block_els.data() + iblock * nlane, nlane}; }
+
+        // ===========
+        // = Utility =
+        // ===========
+
+        /// @brief get the number of blocks
+        [[nodiscard]] constexpr auto nblock() const noexcept -> size_type
+        { return block_offsets.size() - 1; }
+
+        /** @brief get the size requirement for all degrees of freedom given
+         * the number of vector components per dof (including padded lanes)
+         * @param nv_comp th number of vector components per dof
+         * @return the size requirement
+         */
+        constexpr size_type calculate_size_requirement( index_type nv_comp ) const noexcept {
+            return block_offsets.back() * nv_comp;
+        }
+
+        /**
+         * @brief calculate the largest size requirement for a single element
+         * @param nv_comp the number of vector components per dof
+         * @return the maximum size requirement
+         */
+        constexpr size_type max_el_size_reqirement( index_type nv_comp ) const noexcept {
+            return nv_comp * max_dof_size;
+        }
+
+        /**
+         * @brief get the number of degrees of freedom at the given element index
+         * @param elidx the index of the element to get the ndofs for
+         * @return the number of degrees of freedom
+         */
+        [[nodiscard]] constexpr size_type ndof_el( index_type elidx ) const noexcept {
+            return el_ndofs[elidx];
+        }
+
+        /** @brief get the number of elements represented in the map */
+        [[nodiscard]] constexpr size_type nelem() const noexcept { return el_ndofs.size(); }
+
+        /** @brief get the size of the storage in units of (dof x lane) including padded lanes */
+        [[nodiscard]] constexpr size_type size() const noexcept { return static_cast<size_type>(block_offsets.back()); }
+    };
+
+    // Deduction Guides
+    template<class T, class IDX, int ndim>
+    dg_aosoa_map(const std::vector<FiniteElement<T, IDX, ndim> > &, const util::crs<IDX, IDX> &)
+        -> dg_aosoa_map<IDX>;
+
+    /**
+     * @brief a dg layout of the index space where blocks of elements
+     * are interleaved in the fastest index (see dg_aosoa_map)
+     *
+     * the index of (ielem, idof, iv) is
+     * nv * block_offset + (idof * nv + iv) * nlane + lane
+     *
+     * @tparam IDX the index type
+     * @tparam vextent the extent of the vector component
+     * @tparam nlane the number of elements interleaved in a block
+     */
+    template<class IDX, std::size_t vextent, int nlane = 4>
+    struct fe_layout_aosoa {
+
+        // ============
+        // = Typedefs =
+        // ============
+        using index_type = IDX;
+        using size_type = std::make_unsigned_t<IDX>;
+        using dof_mapping_type = dg_aosoa_map<IDX, nlane>;
+
+        // ===========
+        // = Members =
+        // ===========
+
+        /// @brief the map from the element and local dof indices to the blocked storage
+        const dof_mapping_type& map_ref;
+
+        /// @brief dynamic vector component if vextent is not specified
+        index_type nv_d = 0;
+
+        // ================
+        // = Constructors =
+        // ================
+        fe_layout_aosoa(const dof_mapping_type& map_ref)
+        noexcept requires(!is_dynamic_size<vextent>::value)
+        : map_ref{map_ref} {}
+
+        /// @brief integral constant for argument deduction
+        fe_layout_aosoa(const dof_mapping_type& map_ref, std::integral_constant<std::size_t, vextent>)
+        noexcept requires(!is_dynamic_size<vextent>::value)
+        : map_ref{map_ref} {}
+
+        fe_layout_aosoa(const dof_mapping_type& map_ref, index_type nv)
+        noexcept requires(is_dynamic_size<vextent>::value)
+        : map_ref{map_ref}, nv_d{nv} {}
+
+        fe_layout_aosoa(const fe_layout_aosoa<IDX, vextent, nlane>& other) noexcept = default;
+        fe_layout_aosoa(fe_layout_aosoa<IDX, vextent, nlane>&& other) noexcept = default;
+
+        // ==============
+        // = Properties =
+        // ==============
+
+        /// @brief the data for an element is strided by the number of lanes
+        /// so it can never be block copied to an elspan
+        inline static constexpr bool local_dof_contiguous() noexcept { return false; }
+
+        /// @brief static access to the extents
+        inline static constexpr std::size_t static_extent() noexcept {
+            return vextent;
+        }
+
+        /// @brief the number of elements interleaved in a block
+        inline static constexpr int block_width() noexcept { return nlane; }
+
+        // =========
+        // = Sizes =
+        // =========
+
+        /// @brief the number of elements in the index space */
+        [[nodiscard]] constexpr size_type nelem() const noexcept { return map_ref.nelem(); }
+
+        /// @brief get the number of degrees of freedom for the given element
+        /// @param elidx the element index
+        [[nodiscard]] constexpr size_type ndof(index_type ielem) const noexcept {
+            return map_ref.ndof_el(ielem);
+        }
+
+        /// @brief get the number of vector components
+        [[nodiscard]] inline constexpr std::size_t nv() const noexcept {
+            if constexpr(is_dynamic_size<vextent>::value){
+                return nv_d;
+            } else {
+                return vextent;
+            }
+        }
+
+        /// @brief the total size of the global index space represented by this layout
+        /// (including padded lanes)
+        constexpr size_type size() const noexcept {
+            return map_ref.size() * nv();
+        }
+
+        /// @brief the start of the data for a block
+        /// the block data is [ndof x nv x nlane] in row major order
+        /// @param iblock the block index
+        [[nodiscard]] constexpr auto block_start(index_type iblock) const noexcept -> index_type {
+            return map_ref.block_offset(iblock) * nv();
+        }
+
+        // ============
+        // = Indexing =
+        // ============
+#ifndef NDEBUG
+        inline static constexpr bool index_noexcept = false;
+#else
+        inline static constexpr bool index_noexcept = true;
+#endif
+
+        /**
+         * Get the result of the mapping from an index triple
+         * to the global index
+         * @param ielem the element index
+         * @param idof the degree of freedom index
+         * @param iv the vector component index
+         */
+        [[nodiscard]] constexpr index_type operator[](
+            index_type ielem,
+            index_type idof,
+            index_type iv
+        ) const noexcept(index_noexcept) {
+#ifndef NDEBUG
+            // Bounds checking version in debug
+            if(ielem < 0 || ielem >= nelem()   ) throw std::out_of_range("Element index out of range");
+            if(idof  < 0 || idof >= ndof(ielem)) throw std::out_of_range("Dof index out of range");
+            if(iv < 0    || iv >= nv()         ) throw std::out_of_range("Vector compoenent index out of range");
+#endif
+            return block_start(map_ref.block(ielem))
+                + (idof * nv() + iv) * nlane + map_ref.lane(ielem);
+        }
+    };
+
+    // deduction guides
+    template<class IDX, int nlane>
+    fe_layout_aosoa(const dg_aosoa_map<IDX, nlane>&, IDX nv) -> fe_layout_aosoa<IDX, dynamic_ncomp, nlane>;
+
+    template<class IDX, int nlane, std::size_t vextent>
+    fe_layout_aosoa(const dg_aosoa_map<IDX, nlane>&, std::integral_constant<std::size_t, vextent>)
+        -> fe_layout_aosoa<IDX, vextent, nlane>;
+}
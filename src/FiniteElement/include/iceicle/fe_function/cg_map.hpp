@@ -147,4 +147,11 @@ namespace iceicle {
     template< class T, class IDX, int ndim >
     cg_dof_map(const AbstractMesh<T, IDX, ndim>&) -> cg_dof_map<T, IDX, ndim>;
 
+    /// @brief true if the dof map is a cg_dof_map
+    template<class MapType>
+    struct is_cg_dof_map : std::false_type {};
+
+    template< class T, class IDX, int ndim >
+    struct is_cg_dof_map<cg_dof_map<T, IDX, ndim>> : std::true_type {};
+
 }
@@ -204,8 +204,14 @@ namespace iceicle {
             }
         }
 
+        // copies of the nodes owned by this process on other processes follow the new coordinates
+        // NOTE: with multiple processes this must be called on all processes
+        geo_map.update_ghost_coordinates(mesh);
+
         // NOTE: moving the nodes requires updating the replciated per-element coordinates
-        mesh.update_coord_els();
+        // only the rows of the elements surrounding the moved (and ghost) nodes are touched
+        mesh.update_nodes(geo_map.selected_nodes);
+        mesh.update_nodes(geo_map.ghost_nodes);
         // TODO: mesh validation and consistency operations
     }
 
@@ -295,4 +301,36 @@ namespace iceicle {
             }
         }
     }
+
+    /**
+     * @brief scatter the face data of the ghost nodes of the trace 
+     * (selected nodes owned by another process, see geo_dof_map) 
+     * to compact ghost storage, the counterpart of scatter_facspan() for the ghost nodes 
+     *
+     * The ghost data is added to the owning processes with geo_dof_map::reverse_exchange()
+     *
+     * @param [in] trace the trace who's data is being represented
+     * @param [in] alpha the multiplier for the face data 
+     * @param [in] fac_data the fac local data 
+     * @param [in] geo_map the geometry dof selection 
+     * @param [in/out] ghost_data the data of each ghost node (fac_data.nv() values per ghost node) to add to
+     */
+    template< class value_type, class index_type, int ndim>
+    inline auto scatter_facspan_ghosts(
+        TraceSpace<value_type, index_type, ndim> &trace,
+        value_type alpha,
+        facspan auto fac_data,
+        const geo_dof_map<value_type, index_type, ndim>& geo_map,
+        std::span<value_type> ghost_data
+    ) -> void {
+        if(geo_map.nghost() == 0) return;
+        for(index_type inode = 0; inode < trace.face->n_nodes(); ++inode){
+            index_type ighost = geo_map.inv_ghost_nodes[trace.face->nodes()[inode]];
+            if(ighost != geo_map.nghost()){
+                for(index_type iv = 0; iv < fac_data.nv(); ++iv){
+                    ghost_data[ighost * fac_data.nv() + iv] += alpha * fac_data[inode, iv];
+                }
+            }
+        }
+    }
 }
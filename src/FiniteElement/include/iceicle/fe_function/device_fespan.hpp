@@ -0,0 +1,139 @@
+/**
+ * @brief finite element data resident on the offload device
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/device_array.hpp"
+#include "iceicle/fe_function/dglayout.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fe_function/layout_right.hpp"
+#include <cstddef>
+#include <span>
+#include <type_traits>
+
+namespace iceicle {
+
+    /**
+     * @brief owning storage for dg finite element data (fe_layout_right over a dg_dof_map)
+     * that lives on the offload device
+     *
+     * fe_layout_right holds a reference to the host dof map, so the element offsets of the map
+     * are mirrored to the device along with the data. On the device the value of
+     * element iel, local degree of freedom idof, and vector component iv is
+     * data[(offsets[iel] + idof) * nv + iv] (see index())
+     *
+     * The host mirror is an fespan over the same dof map (host_view())
+     * and is only up to date after update_host() (i.e for PVDWriter output).
+     *
+     * @tparam T the floating point type
+     * @tparam IDX the index type
+     * @tparam nv the number of vector components
+     */
+    template<class T, class IDX, std::size_t nv>
+    class device_fespan {
+        public:
+        using value_type = T;
+        using index_type = IDX;
+        using host_layout_type = fe_layout_right<IDX, dg_dof_map<IDX>, nv>;
+
+        /// @brief the number of vector components
+        static constexpr std::size_t nv_comp = nv;
+
+        private:
+        /// @brief the host dof map (the layout of the host mirror)
+        const dg_dof_map<IDX>* map;
+
+        /// @brief the mirrored element offsets of the dof map (size nelem + 1)
+        util::device_array<IDX> dev_offsets;
+
+        /// @brief the values
+        util::device_array<T> values;
+
+        public:
+
+        /**
+         * @brief allocate zero initialized data on the device for the given dof map
+         * @param map the dof map (must outlive this)
+         */
+        explicit device_fespan(const dg_dof_map<IDX>& map)
+        : map{&map}, dev_offsets{std::span<const IDX>{map.offsets}},
+          values(map.calculate_size_requirement(nv), 0.0) {}
+
+        /// @brief the global data index on the device (or the host mirror)
+        /// @param offsets the element offsets (offsets())
+        static constexpr auto index(const IDX* offsets, IDX iel, IDX idof, std::size_t iv) noexcept -> std::size_t
+        { return (offsets[iel] + idof) * nv + iv; }
+
+        /// @brief the number of elements
+        [[nodiscard]] auto nelem() const noexcept -> std::size_t { return map->nelem(); }
+
+        /// @brief the number of degrees of freedom of element iel
+        [[nodiscard]] auto ndof(IDX iel) const noexcept -> std::size_t { return map->ndof_el(iel); }
+
+        /// @brief the total number of values
+        [[nodiscard]] auto size() const noexcept -> std::size_t { return values.size(); }
+
+        /// @brief the data to capture in device kernels
+        [[nodiscard]] auto data() noexcept -> T* { return values.data(); }
+
+        /// @brief the data to capture in device kernels
+        [[nodiscard]] auto data() const noexcept -> const T* { return values.data(); }
+
+        /// @brief the element offsets to capture in device kernels
+        [[nodiscard]] auto offsets() const noexcept -> const IDX* { return dev_offsets.data(); }
+
+        /// @brief the dof map of the host mirror
+        [[nodiscard]] auto dof_map() const noexcept -> const dg_dof_map<IDX>& { return *map; }
+
+        /// @brief an fespan over the host mirror
+        [[nodiscard]] auto host_view() noexcept -> fespan<T, host_layout_type> {
+            return fespan<T, host_layout_type>{values.host().data(), host_layout_type{*map}};
+        }
+
+        /// @brief copy the device data of element iel to the host mirror
+        auto update_host(IDX iel) -> void
+        { values.update_host(map->offsets[iel] * nv, ndof(iel) * nv); }
+
+        /// @brief copy the host mirror of element iel to the device
+        auto update_device(IDX iel) -> void
+        { values.update_device(map->offsets[iel] * nv, ndof(iel) * nv); }
+
+        /// @brief copy all the device data to the host mirror
+        auto update_host() -> void { values.update_host(); }
+
+        /// @brief copy all the host mirror to the device
+        auto update_device() -> void { values.update_device(); }
+
+        /**
+         * @brief copy host finite element data over the same elements to the device
+         * @param u the host data (any layout over the same dof map)
+         */
+        template<class LayoutPolicy, class AccessorPolicy>
+        auto copy_from_host(fespan<T, LayoutPolicy, AccessorPolicy> u) -> void {
+            auto mirror = host_view();
+            for(IDX iel = 0; iel < (IDX) nelem(); ++iel){
+                for(IDX idof = 0; idof < (IDX) ndof(iel); ++idof){
+                    for(std::size_t iv = 0; iv < nv; ++iv) mirror[iel, idof, iv] = u[iel, idof, iv];
+                }
+            }
+            update_device();
+        }
+
+        /**
+         * @brief copy the device data to host finite element data over the same elements
+         * (updates the host mirror)
+         * @param [out] u the host data (any layout over the same dof map)
+         */
+        template<class LayoutPolicy, class AccessorPolicy>
+        auto copy_to_host(fespan<T, LayoutPolicy, AccessorPolicy> u) -> void {
+            update_host();
+            auto mirror = host_view();
+            for(IDX iel = 0; iel < (IDX) nelem(); ++iel){
+                for(IDX idof = 0; idof < (IDX) ndof(iel); ++idof){
+                    for(std::size_t iv = 0; iv < nv; ++iv) u[iel, idof, iv] = mirror[iel, idof, iv];
+                }
+            }
+        }
+    };
+}
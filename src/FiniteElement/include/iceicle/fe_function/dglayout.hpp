@@ -149,6 +149,10 @@ namespace iceicle {
 
         /** @brief get the size of the global degree of freedom index space represented by this map */
         [[nodiscard]] constexpr size_type size() const noexcept { return static_cast<size_type>(offsets.back()); }
+
+        /** @brief the bytes allocated for the map */
+        [[nodiscard]] auto memory_bytes() const noexcept -> std::size_t 
+        { return offsets.capacity() * sizeof(index_type); }
     };
 
     // Deduction Guides
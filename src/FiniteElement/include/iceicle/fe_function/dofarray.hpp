@@ -1,5 +1,7 @@
 /// @brief owning view of data over a set of degrees of freedom
 #include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/memory_arena.hpp"
+#include <memory>
 namespace iceicle {
 
     /**
@@ -42,19 +44,28 @@ namespace iceicle {
             /// the accessor policy
             AccessorPolicy _accessor;
 
+            /// @brief allocate the storage aligned to util::simd_alignment
+            void allocate() {
+                _ptr = util::aligned_allocator<T>{}.allocate(size());
+                std::uninitialized_default_construct_n(_ptr, size());
+            }
+
         public:
 
             template<typename... LayoutArgsT>
             constexpr dofarray(LayoutArgsT&&... layout_args) 
             noexcept : _layout{layout_args...}, _accessor{} 
-            { _ptr = new T[size()]; }
+            { allocate(); }
 
             template<typename... LayoutArgsT>
             constexpr dofarray(LayoutArgsT&&... layout_args, const AccessorPolicy &_accessor) 
             noexcept : _layout{layout_args...}, _accessor{_accessor} 
-            { _ptr = new T[size()]; }
+            { allocate(); }
 
-            ~dofarray(){ delete[] _ptr; }
+            ~dofarray(){ 
+                std::destroy_n(_ptr, size());
+                util::aligned_allocator<T>{}.deallocate(_ptr, size());
+            }
 
             // ===================
             // = Size Operations =
@@ -9,8 +9,11 @@
 #include "iceicle/fe_function/el_layout.hpp"
 #include "iceicle/fe_function/trace_layout.hpp"
 #include "iceicle/fe_function/layout_right.hpp"
+#include "iceicle/fe_function/aosoa_layout.hpp"
 #include "iceicle/fe_function/node_set_layout.hpp"
 #include "iceicle/fespace/fespace.hpp"
+#include "iceicle/thread_utils.hpp"
+#include <array>
 #include <cstdlib>
 #include <ostream>
 #include <ranges>
@@ -285,10 +288,8 @@ namespace iceicle {
         if constexpr(std::is_same_v<LayoutPolicyy, LayoutPolicyx>) {
             // do in a single loop over the 1d index space 
             T *ydata = y.data();
-            T *xdata = x.data();
-            for(int i = 0; i < x.size(); ++i){
-                ydata[i] += alpha * xdata[i];
-            }
+            const T *xdata = x.data();
+            util::parallel_for(x.size(), [=](std::size_t i){ ydata[i] += alpha * xdata[i]; });
         } else {
             for(int ielem = 0; ielem < x.nelem(); ++ielem){
                 for(int idof = 0; idof < x.ndof(ielem); ++idof){
@@ -313,10 +314,8 @@ namespace iceicle {
         if constexpr(std::is_same_v<LayoutPolicyy, LayoutPolicyx>) {
             // do in a single loop over the 1d index space 
             T *ydata = y.data();
-            T *xdata = x.data();
-            for(int i = 0; i < x.size(); ++i){
-                ydata[i] = alpha * xdata[i] + beta * ydata[i];
-            }
+            const T *xdata = x.data();
+            util::parallel_for(x.size(), [=](std::size_t i){ ydata[i] = alpha * xdata[i] + beta * ydata[i]; });
         } else {
             for(int ielem = 0; ielem < x.nelem(); ++ielem){
                 for(int idof = 0; idof < x.ndof(ielem); ++idof){
@@ -338,7 +337,9 @@ namespace iceicle {
     void copy_fespan(const fespan<T, LayoutPolicyx> &x, fespan<T, LayoutPolicyy> y){
         if constexpr(std::is_same_v<LayoutPolicyy, LayoutPolicyx>) {
             // do in a single loop over the 1d index space 
-            std::copy_n(x.data(), x.size(), y.data());
+            T *ydata = y.data();
+            const T *xdata = x.data();
+            util::parallel_for(x.size(), [=](std::size_t i){ ydata[i] = xdata[i]; });
         } else {
             // TODO: more assurances that x and y still share a space
             for(int ielem = 0; ielem < x.nelem(); ++ielem){
@@ -351,6 +352,118 @@ namespace iceicle {
         }
     }
 
+    // ==================================================
+    // = Fused vector operations over contiguous fespans =
+    // ==================================================
+    // The vector operations of the solvers are memory bandwidth bound
+    // so these do several operations in one threaded pass over the 1d index space.
+    // The norms and dot products are local to this rank (see mpi::allreduce_sums)
+
+    /**
+     * @brief y <= alpha * x + beta * y and the squared l2 norm of the result in a single pass
+     * y is not read if beta is 0
+     * @return the local sum of squares of y (after the update) 
+     */
+    template<typename T, class LayoutPolicy>
+    auto axpby_and_norm_sq(T alpha, const fespan<T, LayoutPolicy> &x, T beta, fespan<T, LayoutPolicy> y) -> T {
+        const T *xdata = x.data();
+        T *ydata = y.data();
+        return util::parallel_sums<1, T>(y.size(), [=](std::size_t i, std::array<T, 1>& sums){
+            T yi = (beta == 0.0) ? alpha * xdata[i] : alpha * xdata[i] + beta * ydata[i];
+            ydata[i] = yi;
+            sums[0] += yi * yi;
+        })[0];
+    }
+
+    /**
+     * @brief fused Runge-Kutta stage update y <= alpha * x + beta * y + gamma * r 
+     * with the squared l2 norm of the stage residual r in the same pass 
+     * y is not read if beta is 0
+     *
+     * @param alpha the multiplier for x (i.e the previous solution)
+     * @param x the fespan to add 
+     * @param beta the multiplier for y 
+     * @param gamma the multiplier for r (i.e the timestep times the stage coefficient)
+     * @param r the stage residual
+     * @param y the fespan to update
+     * @return the local sum of squares of r
+     */
+    template<typename T, class LayoutPolicy>
+    auto rk_stage_update(T alpha, const fespan<T, LayoutPolicy> &x, T beta, 
+            T gamma, const fespan<T, LayoutPolicy> &r, fespan<T, LayoutPolicy> y) -> T {
+        const T *xdata = x.data();
+        const T *rdata = r.data();
+        T *ydata = y.data();
+        return util::parallel_sums<1, T>(y.size(), [=](std::size_t i, std::array<T, 1>& sums){
+            T ri = rdata[i];
+            T yi = alpha * xdata[i] + gamma * ri;
+            ydata[i] = (beta == 0.0) ? yi : yi + beta * ydata[i];
+            sums[0] += ri * ri;
+        })[0];
+    }
+
+    /**
+     * @brief Runge-Kutta stage update in the Shu-Osher form y <= alpha * x + beta * w + gamma * r 
+     * with the squared l2 norm of the stage residual r in the same pass 
+     * y may be the same as x, w, or r (each entry is only read before it is written)
+     *
+     * @param alpha the multiplier for x (i.e the solution at the start of the step)
+     * @param x the fespan to add 
+     * @param beta the multiplier for w 
+     * @param w the stage solution
+     * @param gamma the multiplier for r (i.e the timestep times the stage coefficient)
+     * @param r the stage residual
+     * @param y the fespan to write
+     * @return the local sum of squares of r
+     */
+    template<typename T, class LayoutPolicy>
+    auto rk_stage_update(T alpha, const fespan<T, LayoutPolicy> &x, T beta, const fespan<T, LayoutPolicy> &w,
+            T gamma, const fespan<T, LayoutPolicy> &r, fespan<T, LayoutPolicy> y) -> T {
+        const T *xdata = x.data();
+        const T *wdata = w.data();
+        const T *rdata = r.data();
+        T *ydata = y.data();
+        return util::parallel_sums<1, T>(y.size(), [=](std::size_t i, std::array<T, 1>& sums){
+            T ri = rdata[i];
+            ydata[i] = alpha * xdata[i] + beta * wdata[i] + gamma * ri;
+            sums[0] += ri * ri;
+        })[0];
+    }
+
+    /**
+     * @brief the dot product of x with y and the squared norms of x and y in one pass
+     * @return {x . y, x . x, y . y} on this rank
+     */
+    template<typename T, class LayoutPolicy>
+    auto dot_and_norms_sq(const fespan<T, LayoutPolicy> &x, const fespan<T, LayoutPolicy> &y) -> std::array<T, 3> {
+        const T *xdata = x.data();
+        const T *ydata = y.data();
+        return util::parallel_sums<3, T>(x.size(), [=](std::size_t i, std::array<T, 3>& sums){
+            sums[0] += xdata[i] * ydata[i];
+            sums[1] += xdata[i] * xdata[i];
+            sums[2] += ydata[i] * ydata[i];
+        });
+    }
+
+    /// @brief the dot product of x and y on this rank
+    template<typename T, class LayoutPolicy>
+    auto dot(const fespan<T, LayoutPolicy> &x, const fespan<T, LayoutPolicy> &y) -> T {
+        const T *xdata = x.data();
+        const T *ydata = y.data();
+        return util::parallel_sums<1, T>(x.size(), [=](std::size_t i, std::array<T, 1>& sums){
+            sums[0] += xdata[i] * ydata[i];
+        })[0];
+    }
+
+    /// @brief the squared l2 norm of x on this rank
+    template<typename T, class LayoutPolicy>
+    auto norm_sq(const fespan<T, LayoutPolicy> &x) -> T {
+        const T *xdata = x.data();
+        return util::parallel_sums<1, T>(x.size(), [=](std::size_t i, std::array<T, 1>& sums){
+            sums[0] += xdata[i] * xdata[i];
+        })[0];
+    }
+
     /**
      * @brief dofspan represents a non-owning view for the data over a set of degreees of freedom 
      * and vector components
@@ -828,6 +941,48 @@ namespace iceicle {
         }
     }
 
+    /**
+     * @brief the data of an element in a global layout_right is a contiguous [dof][vector component] block
+     * (the compact_layout_right of an elspan) when the dof map keeps local dofs contiguous (i.e dg_dof_map)
+     */
+    template<class IDX, std::size_t vextent, class MapType>
+    struct is_equivalent_el_layout<compact_layout_right<IDX, vextent>, fe_layout_right<IDX, MapType, vextent>> {
+        static constexpr bool value = MapType::local_dof_contiguous() && !is_dynamic_size<vextent>::value;
+    };
+
+    /**
+     * @brief prefetch the data of an element into cache 
+     * ahead of extract_elspan (read) or scatter_elspan (write)
+     * does nothing unless the element data is a contiguous block of the global data
+     *
+     * @tparam for_write true if the data will be written
+     * @param iel the element index 
+     * @param fedata the global data
+     */
+    template<
+        bool for_write = false,
+        class T,
+        class GlobalLayoutPolicy,
+        class GlobalAccessorPolicy
+    > inline void prefetch_elspan(
+        std::size_t iel,
+        const fespan<T, GlobalLayoutPolicy, GlobalAccessorPolicy> fedata
+    ){
+#if defined(__GNUC__) || defined(__clang__)
+        using el_layout_type = decltype(fedata.create_element_layout(iel));
+        if constexpr (
+            is_equivalent_el_layout<el_layout_type, GlobalLayoutPolicy>::value
+            && std::is_same<GlobalAccessorPolicy, default_accessor<T>>::value
+        ) {
+            static constexpr std::size_t cache_line = 64;
+            const char* block = reinterpret_cast<const char*>(fedata.data() + fedata.get_layout()[iel, 0, 0]);
+            std::size_t nbytes = fedata.create_element_layout(iel).size() * sizeof(T);
+            for(std::size_t offset = 0; offset < nbytes; offset += cache_line)
+                { __builtin_prefetch(block + offset, (for_write) ? 1 : 0, 3); }
+        }
+#endif
+    }
+
     /**
      * @brief extract the data for a specific element 
      * from a global fespan 
@@ -854,7 +1009,7 @@ namespace iceicle {
         ) {
             // memcopy/memmove poggers
             std::copy_n(
-                &( fedata[fe_index{iel, 0, 0}] ),
+                fedata.data() + fedata.get_layout()[iel, 0, 0],
                 eldata.ndof() * eldata.nv(),
                 eldata.data());
         } else {
@@ -897,11 +1052,18 @@ namespace iceicle {
             has_equivalent_el_layout<decltype(eldata), decltype(fedata)>::value 
             && std::is_same<local_accessor_policy, default_accessor<T>>::value
         ) {
-            T *fe_data_block = &( fedata[fe_index{iel, 0, 0}] );
-            T *el_data_block = eldata.data();
-            std::size_t blocksize = eldata.extents().ndof * eldata.extents().nv;
-            for(int i = 0; i < blocksize; ++i){
-                fe_data_block[i] = alpha * el_data_block[i] + beta * fe_data_block[i];
+            T *fe_data_block = fedata.data() + fedata.get_layout()[iel, 0, 0];
+            const T *el_data_block = eldata.data();
+            std::size_t blocksize = eldata.ndof() * eldata.nv();
+            // the common cases without the multiplies
+            if(beta == 0.0 && alpha == 1.0){
+                std::copy_n(el_data_block, blocksize, fe_data_block);
+            } else if(beta == 1.0 && alpha == 1.0) {
+                for(std::size_t i = 0; i < blocksize; ++i) fe_data_block[i] += el_data_block[i];
+            } else {
+                for(std::size_t i = 0; i < blocksize; ++i){
+                    fe_data_block[i] = alpha * el_data_block[i] + beta * fe_data_block[i];
+                }
             }
         } else {
             // NOTE: assuming extents are equivalent 
@@ -915,6 +1077,89 @@ namespace iceicle {
         }
     }
 
+    /**
+     * @brief gather the data of a block of elements with the same number of dofs
+     * into AoSoA scratch stored [dof][vector component][lane] (the block layout of dg_aosoa_map)
+     * so batched kernels can load a SIMD lane per element
+     *
+     * @param iels the element index of each lane (negative for unused lanes which are zeroed) 
+     * @param fedata the global data to gather from
+     * @param ndof the number of degrees of freedom of each element
+     * @param block the scratch to gather to (size ndof * nv * nlane)
+     */
+    template<
+        class T,
+        class GlobalLayoutPolicy,
+        class GlobalAccessorPolicy,
+        class IDX,
+        std::size_t nlane
+    > inline void extract_elspan_block(
+        std::span<const IDX, nlane> iels,
+        const fespan<T, GlobalLayoutPolicy, GlobalAccessorPolicy> fedata,
+        std::size_t ndof,
+        std::span<T> block
+    ) {
+        const std::size_t nv = fedata.nv();
+        const std::size_t blocksize = ndof * nv;
+        for(std::size_t ilane = 0; ilane < nlane; ++ilane){
+            if(iels[ilane] < 0) {
+                for(std::size_t i = 0; i < blocksize; ++i) block[i * nlane + ilane] = 0;
+            } else if constexpr (GlobalLayoutPolicy::local_dof_contiguous()
+                    && std::is_same_v<GlobalAccessorPolicy, default_accessor<T>>) {
+                const T* fe_data_block = fedata.data() + fedata.get_layout()[iels[ilane], 0, 0];
+                for(std::size_t i = 0; i < blocksize; ++i) block[i * nlane + ilane] = fe_data_block[i];
+            } else {
+                for(std::size_t idof = 0; idof < ndof; ++idof){
+                    for(std::size_t iv = 0; iv < nv; ++iv)
+                        block[(idof * nv + iv) * nlane + ilane] = fedata[iels[ilane], idof, iv];
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief scatter AoSoA scratch of a block of elements (see extract_elspan_block) 
+     * back into the global data array 
+     *
+     * follows the y = alpha * x + beta * y convention
+     *
+     * @param [in] iels the element index of each lane (negative for unused lanes which are skipped) 
+     * @param [in] alpha the multiplier for the block data 
+     * @param [in] block the block data stored [dof][vector component][lane]
+     * @param [in] beta the multiplier for values in the global data array 
+     * @param [in/out] fedata the global data array to scatter to 
+     */
+    template<
+        class T,
+        class GlobalLayoutPolicy,
+        class IDX,
+        std::size_t nlane
+    > inline void scatter_elspan_block(
+        std::span<const IDX, nlane> iels,
+        T alpha,
+        std::span<const T> block,
+        T beta,
+        fespan<T, GlobalLayoutPolicy> fedata
+    ) {
+        const std::size_t nv = fedata.nv();
+        for(std::size_t ilane = 0; ilane < nlane; ++ilane){
+            if(iels[ilane] < 0) continue;
+            const std::size_t ndof = fedata.ndof(iels[ilane]);
+            if constexpr (GlobalLayoutPolicy::local_dof_contiguous()) {
+                T* fe_data_block = fedata.data() + fedata.get_layout()[iels[ilane], 0, 0];
+                for(std::size_t i = 0; i < ndof * nv; ++i)
+                    fe_data_block[i] = alpha * block[i * nlane + ilane] + beta * fe_data_block[i];
+            } else {
+                for(std::size_t idof = 0; idof < ndof; ++idof){
+                    for(std::size_t iv = 0; iv < nv; ++iv){
+                        fedata[iels[ilane], idof, iv] = alpha * block[(idof * nv + iv) * nlane + ilane]
+                            + beta * fedata[iels[ilane], idof, iv];
+                    }
+                }
+            }
+        }
+    }
+
     /**
         * @brief extract the data from a trace 
         * into a facspan from a global nodal data structure 
@@ -2,11 +2,20 @@
 /// @author Gianni Absillis (gabsill@ncsu.edu)
 #pragma once
 #include "iceicle/anomaly_log.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/thread_utils.hpp"
+#include "iceicle/fe_function/node_selection.hpp"
 #include <type_traits>
 #include <span>
 #include <memory>
+#include <numeric>
+#include <unordered_map>
 #include <vector>
 #include <iceicle/fespace/fespace.hpp>
+#ifdef ICEICLE_USE_MPI
+#include "iceicle/mpi_type.hpp"
+#include <mpi.h>
+#endif
 
 
 namespace iceicle {
@@ -356,6 +365,18 @@ namespace iceicle {
         
     };
 
+    /**
+     * @brief the selection of nodes (and their parameterizations) that are geometry degrees of freedom
+     *
+     * In parallel (a partitioned mesh over more than one process) the selected nodes shared by processes
+     * have an owner: the lowest rank that selects the node (has it on one of its selected traces).
+     * The dofs (selected_nodes) of a process are only the nodes it owns,
+     * so the geometry data and interface conservation residual layouts are distributed without overlap.
+     * The local copies of nodes owned by another process are the ghost nodes:
+     * updated coordinates are copied from the owner (update_ghost_coordinates()) 
+     * and residual contributions of the ghost nodes are added to the owner (reverse_exchange()).
+     * A node that is removed as a boundary dof on any process is removed on all processes.
+     */
     template<class T, class IDX, int ndim>
     struct geo_dof_map {
 
@@ -365,6 +386,7 @@ namespace iceicle {
 
         using index_type = IDX;
         using size_type = std::make_unsigned_t<index_type>;
+        using global_index_type = AbstractMesh<T, IDX, ndim>::global_index_type;
 
         // ================
         // = Data Members =
@@ -391,45 +413,122 @@ namespace iceicle {
         /// @brief flag that gets set to true when the data structures are all in usable state
         bool finalized = false;
 
+        // === Distributed Memory ===
+
+        /// @brief true if the selection spans multiple processes (the ghost data is in use)
+        bool distributed = false;
+
+        /// @brief the mesh the node indices refer to 
+        AbstractMesh<T, IDX, ndim>* meshptr = nullptr;
+
+        /// @brief local node indices of the selected nodes that are owned by another process
+        std::vector<index_type> ghost_nodes{};
+
+        /// @brief index in ghost_nodes each node maps to, or nghost() if not a ghost node
+        std::vector<index_type> inv_ghost_nodes{};
+
+        /// @brief the rank that owns each ghost node
+        std::vector<int> ghost_owner{};
+
+        /// @brief the index of each ghost node in the selected_nodes of the owner
+        std::vector<index_type> ghost_owner_dof{};
+
+        /// @brief the start of the data of each ghost node in the cols of the owner
+        std::vector<index_type> ghost_owner_col{};
+
+        /// @brief the parametric_function of each ghost node (consistent with the owner after finalize())
+        std::vector< std::unique_ptr< ParametricCoordTransformation<T, ndim> > > ghost_accessors;
+
+        /// @brief for each rank: the dofs of this process that have ghost copies on the rank
+        std::vector<std::vector<index_type>> shared_dofs{};
+
+        /// @brief for each rank: the ghost nodes owned by the rank (in the order of shared_dofs on the rank)
+        std::vector<std::vector<index_type>> shared_ghosts{};
+
+        /// @brief local node index of each node index in the mesh this was partitioned from 
+        /// (only used when distributed)
+        std::unordered_map<global_index_type, index_type> inv_gnode_idxs{};
+
         // ================
         // = Constructors =
         // ================
 
         geo_dof_map(std::ranges::forward_range auto trace_indices, FESpace<T, IDX, ndim>& fespace, bool remove_boundary_dofs = false)
-        : selected_traces{std::ranges::begin(trace_indices), std::ranges::end(trace_indices)}
+        : selected_traces{std::ranges::begin(trace_indices), std::ranges::end(trace_indices)},
+          meshptr{fespace.meshptr}
         {
+            AbstractMesh<T, IDX, ndim>& mesh = *(fespace.meshptr);
+
             // helper array to keep track of which global node indices to select
-            std::vector<bool> to_select(fespace.meshptr->n_nodes(), false);
+            node_selection<index_type> to_select(mesh.n_nodes());
+            node_selection<index_type> to_remove(mesh.n_nodes());
             using trace_type = std::remove_reference_t<decltype(fespace)>::TraceType;
 
             // loop over selected faces and select nodes
             for(index_type trace_idx : trace_indices){
                 const trace_type& trace = fespace.traces[trace_idx];
                 for(index_type inode : trace.face->nodes_span()){
-                    to_select[inode] = true;
+                    to_select.set(inode);
                 }
             }
 
             if(remove_boundary_dofs){
                 // loop over the boundary faces and deactivate all boundary nodes 
                 // since some may be connected to an active interior face 
+                // (process boundaries are not boundaries of the domain)
                 for(const trace_type &trace : fespace.get_boundary_traces()){
+                    if(trace.face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) continue;
                     for(index_type inode : trace.face->nodes_span()){
-                        to_select[inode] = false;
+                        to_remove.set(inode);
                     }
                 }
             }
 
-            // construct the selected nodes list 
-            for(int inode = 0; inode < fespace.meshptr->n_nodes(); ++inode){
-                if(to_select[inode]) selected_nodes.push_back(inode);
+#ifdef ICEICLE_USE_MPI
+            int nrank = mpi::mpi_world_size();
+            distributed = nrank > 1 && mesh.gnode_idxs.size() == mesh.n_nodes();
+            if(distributed){
+                int myrank = mpi::mpi_world_rank();
+                for(index_type inode = 0; inode < mesh.n_nodes(); ++inode)
+                    { inv_gnode_idxs[mesh.gnode_idxs[inode]] = inode; }
+
+                // agree on the owner and removal of each node in the mesh this was partitioned from
+                global_index_type nnode_global = 0;
+                for(global_index_type ignode : mesh.gnode_idxs) nnode_global = std::max(nnode_global, ignode + 1);
+                MPI_Allreduce(MPI_IN_PLACE, &nnode_global, 1, mpi_get_type<global_index_type>(), MPI_MAX, MPI_COMM_WORLD);
+                std::vector<int> owner(nnode_global, nrank);
+                std::vector<int> removed(nnode_global, 0);
+                for(index_type inode = 0; inode < mesh.n_nodes(); ++inode){
+                    if(to_select.test(inode)) owner[mesh.gnode_idxs[inode]] = myrank;
+                    if(to_remove.test(inode)) removed[mesh.gnode_idxs[inode]] = 1;
+                }
+                MPI_Allreduce(MPI_IN_PLACE, owner.data(), nnode_global, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+                MPI_Allreduce(MPI_IN_PLACE, removed.data(), nnode_global, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+                // select the owned nodes and keep a ghost copy of the nodes owned elsewhere
+                for(index_type inode = 0; inode < mesh.n_nodes(); ++inode){
+                    global_index_type ignode = mesh.gnode_idxs[inode];
+                    if(removed[ignode] || owner[ignode] == nrank){
+                        to_select.reset(inode);
+                    } else if(owner[ignode] == myrank){
+                        to_select.set(inode);
+                    } else {
+                        to_select.reset(inode);
+                        ghost_nodes.push_back(inode);
+                        ghost_owner.push_back(owner[ignode]);
+                    }
+                }
+            } else 
+#endif
+            {
+                to_select -= to_remove;
             }
 
+            // construct the selected nodes list 
+            selected_nodes = to_select.to_list();
+
             // default value for nodes that aren't selected is to map to selected_nodes.size()
-            inv_selected_nodes = std::vector<index_type>(fespace.meshptr->n_nodes(), selected_nodes.size());
-            for(int idof = 0; idof < selected_nodes.size(); ++idof){
-                inv_selected_nodes[selected_nodes[idof]] = idof;
-            }
+            inv_selected_nodes = inverse_node_list(selected_nodes, mesh.n_nodes());
 
 // initialize the is_parametric array
             is_parametric = std::vector<bool>(selected_nodes.size(), false);
@@ -440,12 +539,22 @@ namespace iceicle {
             for(size_type idof = 0; idof < selected_nodes.size(); ++idof)
                 parametric_accessors[idof] = std::make_unique<parametric_transformations::Identity<T, ndim>>();
 
+            // ghost nodes start with the identity accessor as well
+            inv_ghost_nodes = inverse_node_list(ghost_nodes, mesh.n_nodes());
+            ghost_accessors = std::vector< std::unique_ptr< ParametricCoordTransformation<T, ndim> > >(
+                    ghost_nodes.size());
+            for(size_type ighost = 0; ighost < ghost_nodes.size(); ++ighost){
+                ghost_accessors[ighost] = std::make_unique<parametric_transformations::Identity<T, ndim>>();
+            }
+            setup_ghost_exchange(mesh);
+
             // this is finalized until parametric nodes are registered
             cols.reserve(ndof()+1);
             cols.push_back(0);
             for(int idof = 0; idof < ndof(); ++idof){
                 cols.push_back(cols[idof] + ndim);
             }
+            exchange_ghost_cols();
             finalized = true;
         }
 
@@ -458,42 +567,288 @@ namespace iceicle {
         /// @brief register a node as a parametrically controlled node 
         /// the vector components in parametric space s get mapped to x (size = ndim) 
         /// @param inode the index of the node in the mesh (will get converted internally to the ldof)
-        /// if inode doesn't have an ldof this entry is just ignored
+        /// if inode doesn't have an ldof (or is not a valid node index) this entry is just ignored
+        /// ghost nodes are registered as well (the parameterization of a node must agree across processes)
         /// @param parametric_transform the set of functions that governs the invertible s -> x mapping
         template<class parametric_t>
         auto register_parametric_node(index_type inode, parametric_t parametric_transform) -> void 
         requires(std::is_base_of_v<ParametricCoordTransformation<T, ndim>, parametric_t>)
         {
+            if(inode < 0 || inode >= (index_type) inv_selected_nodes.size()) return;
             finalized = false;
             index_type idof = inv_selected_nodes[inode];
             if(idof != ndof()){
                 parametric_accessors[idof] = std::make_unique<parametric_t>(
                         std::move(parametric_transform));
                 is_parametric[idof] = true;
+            } else if(inv_ghost_nodes.size() > 0 && inv_ghost_nodes[inode] != nghost()) {
+                ghost_accessors[inv_ghost_nodes[inode]] = std::make_unique<parametric_t>(
+                        std::move(parametric_transform));
             }
         }
 
+        /// @brief check if a node of the mesh is a dof or a ghost node of this map (O(1))
+        /// @param inode the index of the node in the mesh
+        auto represents_node(index_type inode) const -> bool {
+            if(inode < 0 || inode >= (index_type) inv_selected_nodes.size()) return false;
+            return inv_selected_nodes[inode] != (index_type) ndof()
+                || (inv_ghost_nodes.size() > 0 && inv_ghost_nodes[inode] != (index_type) nghost());
+        }
+
         /// @brief the number of degrees of freedom represented
         auto ndof() const -> size_type { return selected_nodes.size(); }
 
         /// @brief the total number of components represented
         auto size() const -> size_type { return cols[ndof()]; }
 
+        /// @brief the number of ghost nodes (selected nodes owned by another process)
+        auto nghost() const -> size_type { return ghost_nodes.size(); }
+
+        /// @brief get the local node index of a node in the mesh this was partitioned from 
+        /// @param ignode the node index in the mesh before partitioning
+        /// @return the local node index or -1 if the node is not on this process
+        auto local_node_index(global_index_type ignode) const -> index_type {
+            if(!distributed) return ignode;
+            auto it = inv_gnode_idxs.find(ignode);
+            return (it == inv_gnode_idxs.end()) ? -1 : it->second;
+        }
+
         /// @brief put all data structures in usable state
+        /// (with multiple processes this must be called on all processes)
         auto finalize() -> void {
-            // compute the columns array;
-            cols.clear();
-            cols.reserve(ndof()+1);
-            cols.push_back(0);
-            for(int idof = 0; idof < ndof(); ++idof){
-                if(is_parametric[idof]){
-                    cols.push_back(cols[idof] + parametric_accessors[idof]->s_size());
-                } else {
-                    cols.push_back(cols[idof] + ndim);
+            synchronize_ghost_parameterizations();
+
+            // compute the columns array: the sizes of each dof in parallel then the running sum
+            cols.assign(ndof() + 1, 0);
+            util::parallel_for(ndof(), [this](size_type idof){
+                cols[idof + 1] = (is_parametric[idof]) ? parametric_accessors[idof]->s_size() : ndim;
+            });
+            std::inclusive_scan(cols.begin(), cols.end(), cols.begin());
+            exchange_ghost_cols();
+
+            finalized = true;
+        }
+
+        // ==============================
+        // = Distributed Memory Updates =
+        // ==============================
+
+        /**
+         * @brief send the data of the owned dofs to the ghost copies on the other processes
+         * (no-op if not distributed)
+         * @param owned_data the data of each dof of this process (nv values per dof)
+         * @param [out] ghost_data the data of each ghost node (nv values per ghost node)
+         * @param nv the number of values per node
+         */
+        template<class data_t>
+        auto forward_exchange(std::span<const data_t> owned_data, std::span<data_t> ghost_data, int nv) const -> void {
+#ifdef ICEICLE_USE_MPI
+            if(!distributed) return;
+            std::vector<std::vector<data_t>> send_buffers, recv_buffers;
+            std::vector<int> recv_ranks;
+            std::vector<MPI_Request> requests;
+            for(int irank = 0; irank < (int) shared_ghosts.size(); ++irank){
+                if(shared_ghosts[irank].size() == 0) continue;
+                recv_ranks.push_back(irank);
+                recv_buffers.emplace_back(shared_ghosts[irank].size() * nv);
+                requests.emplace_back();
+                MPI_Irecv(recv_buffers.back().data(), recv_buffers.back().size(), mpi_get_type<data_t>(),
+                        irank, 1, MPI_COMM_WORLD, &requests.back());
+            }
+            // reserve so the buffers being sent do not move
+            send_buffers.reserve(shared_dofs.size());
+            for(int irank = 0; irank < (int) shared_dofs.size(); ++irank){
+                if(shared_dofs[irank].size() == 0) continue;
+                std::vector<data_t>& buffer = send_buffers.emplace_back();
+                for(index_type idof : shared_dofs[irank]){
+                    for(int iv = 0; iv < nv; ++iv) buffer.push_back(owned_data[idof * nv + iv]);
+                }
+                requests.emplace_back();
+                MPI_Isend(buffer.data(), buffer.size(), mpi_get_type<data_t>(),
+                        irank, 1, MPI_COMM_WORLD, &requests.back());
+            }
+            MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+            for(std::size_t ineighbor = 0; ineighbor < recv_ranks.size(); ++ineighbor){
+                const std::vector<index_type>& ghosts = shared_ghosts[recv_ranks[ineighbor]];
+                for(std::size_t i = 0; i < ghosts.size(); ++i){
+                    for(int iv = 0; iv < nv; ++iv)
+                        { ghost_data[ghosts[i] * nv + iv] = recv_buffers[ineighbor][i * nv + iv]; }
                 }
             }
+#endif
+        }
 
-            finalized = true;
+        /**
+         * @brief add the data of the ghost nodes to the owned dofs on the owning processes 
+         * (no-op if not distributed)
+         * @param ghost_data the data of each ghost node (nv values per ghost node)
+         * @param [in/out] owned_data the data of each dof of this process (nv values per dof) to add to
+         * @param nv the number of values per node
+         */
+        template<class data_t>
+        auto reverse_exchange(std::span<const data_t> ghost_data, std::span<data_t> owned_data, int nv) const -> void {
+#ifdef ICEICLE_USE_MPI
+            if(!distributed) return;
+            std::vector<std::vector<data_t>> send_buffers, recv_buffers;
+            std::vector<int> recv_ranks;
+            std::vector<MPI_Request> requests;
+            for(int irank = 0; irank < (int) shared_dofs.size(); ++irank){
+                if(shared_dofs[irank].size() == 0) continue;
+                recv_ranks.push_back(irank);
+                recv_buffers.emplace_back(shared_dofs[irank].size() * nv);
+                requests.emplace_back();
+                MPI_Irecv(recv_buffers.back().data(), recv_buffers.back().size(), mpi_get_type<data_t>(),
+                        irank, 2, MPI_COMM_WORLD, &requests.back());
+            }
+            send_buffers.reserve(shared_ghosts.size());
+            for(int irank = 0; irank < (int) shared_ghosts.size(); ++irank){
+                if(shared_ghosts[irank].size() == 0) continue;
+                std::vector<data_t>& buffer = send_buffers.emplace_back();
+                for(index_type ighost : shared_ghosts[irank]){
+                    for(int iv = 0; iv < nv; ++iv) buffer.push_back(ghost_data[ighost * nv + iv]);
+                }
+                requests.emplace_back();
+                MPI_Isend(buffer.data(), buffer.size(), mpi_get_type<data_t>(),
+                        irank, 2, MPI_COMM_WORLD, &requests.back());
+            }
+            MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+            for(std::size_t ineighbor = 0; ineighbor < recv_ranks.size(); ++ineighbor){
+                const std::vector<index_type>& dofs = shared_dofs[recv_ranks[ineighbor]];
+                for(std::size_t i = 0; i < dofs.size(); ++i){
+                    for(int iv = 0; iv < nv; ++iv)
+                        { owned_data[dofs[i] * nv + iv] += recv_buffers[ineighbor][i * nv + iv]; }
+                }
+            }
+#endif
+        }
+
+        /// @brief copy the coordinates of the owned nodes to the ghost nodes on the other processes
+        /// and refresh the copies of the node coordinates in the elements communicated from other processes 
+        /// (no-op if not distributed)
+        /// @param mesh the mesh to update
+        auto update_ghost_coordinates(AbstractMesh<T, IDX, ndim>& mesh) const -> void {
+            if(!distributed) return;
+            std::vector<T> owned_coord(ndof() * ndim);
+            std::vector<T> ghost_coord(nghost() * ndim);
+            for(index_type idof = 0; idof < ndof(); ++idof){
+                for(int idim = 0; idim < ndim; ++idim)
+                    { owned_coord[idof * ndim + idim] = mesh.coord[selected_nodes[idof]][idim]; }
+            }
+            forward_exchange(std::span<const T>{owned_coord}, std::span<T>{ghost_coord}, ndim);
+            for(index_type ighost = 0; ighost < nghost(); ++ighost){
+                for(int idim = 0; idim < ndim; ++idim)
+                    { mesh.coord[ghost_nodes[ighost]][idim] = ghost_coord[ighost * ndim + idim]; }
+            }
+
+            // the communicated elements store their own copy of the coordinates
+            for(auto& rank_elements : mesh.communicated_elements){
+                for(CommElementInfo<T, IDX, ndim>& comm_el : rank_elements){
+                    for(std::size_t inode = 0; inode < comm_el.conn_el.size(); ++inode)
+                        { comm_el.coord_el[inode] = mesh.coord[comm_el.conn_el[inode]]; }
+                }
+            }
+        }
+
+        private:
+
+        /// @brief set up the shared_dofs and shared_ghosts communication pattern 
+        /// and the ghost_owner_dof by asking the owner of each ghost node
+        auto setup_ghost_exchange(const AbstractMesh<T, IDX, ndim>& mesh) -> void {
+#ifdef ICEICLE_USE_MPI
+            if(!distributed) return;
+            int nrank = mpi::mpi_world_size();
+            shared_dofs.assign(nrank, std::vector<index_type>{});
+            shared_ghosts.assign(nrank, std::vector<index_type>{});
+            for(index_type ighost = 0; ighost < nghost(); ++ighost)
+                { shared_ghosts[ghost_owner[ighost]].push_back(ighost); }
+
+            // request the nodes by the index in the mesh this was partitioned from
+            std::vector<int> send_counts(nrank), recv_counts(nrank), send_displs(nrank + 1, 0), recv_displs(nrank + 1, 0);
+            std::vector<global_index_type> requested_nodes{};
+            for(int irank = 0; irank < nrank; ++irank){
+                send_counts[irank] = shared_ghosts[irank].size();
+                for(index_type ighost : shared_ghosts[irank])
+                    { requested_nodes.push_back(mesh.gnode_idxs[ghost_nodes[ighost]]); }
+            }
+            MPI_Alltoall(send_counts.data(), 1, MPI_INT, recv_counts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+            for(int irank = 0; irank < nrank; ++irank){
+                send_displs[irank + 1] = send_displs[irank] + send_counts[irank];
+                recv_displs[irank + 1] = recv_displs[irank] + recv_counts[irank];
+            }
+            std::vector<global_index_type> recieved_nodes(recv_displs[nrank]);
+            MPI_Alltoallv(requested_nodes.data(), send_counts.data(), send_displs.data(), mpi_get_type<global_index_type>(),
+                    recieved_nodes.data(), recv_counts.data(), recv_displs.data(), mpi_get_type<global_index_type>(),
+                    MPI_COMM_WORLD);
+
+            // answer with the dof index on this process
+            std::vector<index_type> owned_dofs(recv_displs[nrank]);
+            for(int irank = 0; irank < nrank; ++irank){
+                for(int i = recv_displs[irank]; i < recv_displs[irank + 1]; ++i){
+                    index_type inode = local_node_index(recieved_nodes[i]);
+                    index_type idof = (inode < 0) ? ndof() : inv_selected_nodes[inode];
+                    if(idof == ndof()){
+                        util::AnomalyLog::log_anomaly(util::Anomaly{"ghost node is not selected on the owning process",
+                                util::general_anomaly_tag{}});
+                        idof = 0;
+                    }
+                    owned_dofs[i] = idof;
+                    shared_dofs[irank].push_back(idof);
+                }
+            }
+            std::vector<index_type> answered_dofs(send_displs[nrank]);
+            MPI_Alltoallv(owned_dofs.data(), recv_counts.data(), recv_displs.data(), mpi_get_type<index_type>(),
+                    answered_dofs.data(), send_counts.data(), send_displs.data(), mpi_get_type<index_type>(),
+                    MPI_COMM_WORLD);
+            ghost_owner_dof.resize(nghost());
+            for(int irank = 0; irank < nrank; ++irank){
+                for(std::size_t i = 0; i < shared_ghosts[irank].size(); ++i)
+                    { ghost_owner_dof[shared_ghosts[irank][i]] = answered_dofs[send_displs[irank] + i]; }
+            }
+#endif
+        }
+
+        /// @brief a node that is fixed on any process is fixed on all processes, 
+        /// then check that the remaining parameterizations agree in size with the owner
+        auto synchronize_ghost_parameterizations() -> void {
+            if(!distributed) return;
+            auto fix_node = [this](IDX inode) {
+                std::array<T, ndim> pt;
+                std::ranges::copy(meshptr->coord[inode], pt.begin());
+                register_parametric_node(inode, parametric_transformations::Fixed<T, ndim>{pt});
+            };
+
+            // ghost copies that are fixed fix the owner
+            std::vector<int> ghost_fixed(nghost()), owned_fixed(ndof(), 0);
+            for(index_type ighost = 0; ighost < nghost(); ++ighost)
+                { ghost_fixed[ighost] = (ghost_accessors[ighost]->s_size() == 0); }
+            reverse_exchange(std::span<const int>{ghost_fixed}, std::span<int>{owned_fixed}, 1);
+            for(index_type idof = 0; idof < ndof(); ++idof){
+                bool movable = !is_parametric[idof] || parametric_accessors[idof]->s_size() != 0;
+                if(owned_fixed[idof] > 0 && movable) fix_node(selected_nodes[idof]);
+            }
+
+            // the owner parameterization size is authoritative
+            std::vector<index_type> owned_sizes(ndof()), ghost_sizes(nghost());
+            for(index_type idof = 0; idof < ndof(); ++idof)
+                { owned_sizes[idof] = (is_parametric[idof]) ? parametric_accessors[idof]->s_size() : ndim; }
+            forward_exchange(std::span<const index_type>{owned_sizes}, std::span<index_type>{ghost_sizes}, 1);
+            for(index_type ighost = 0; ighost < nghost(); ++ighost){
+                index_type ghost_size = ghost_accessors[ighost]->s_size();
+                if(ghost_sizes[ighost] == 0 && ghost_size != 0) {
+                    fix_node(ghost_nodes[ighost]);
+                } else if(ghost_sizes[ighost] != ghost_size) {
+                    util::AnomalyLog::log_anomaly(util::Anomaly{"parameterization of a shared node "
+                            "does not match the owning process", util::general_anomaly_tag{}});
+                }
+            }
+        }
+
+        /// @brief get the start of the data for each ghost node from the owner 
+        auto exchange_ghost_cols() -> void {
+            if(!distributed) return;
+            ghost_owner_col.resize(nghost());
+            forward_exchange(std::span<const index_type>{cols.data(), ndof()},
+                    std::span<index_type>{ghost_owner_col}, 1);
         }
     };
 
@@ -507,6 +862,7 @@ namespace iceicle {
     namespace mesh_parameterizations {
 
         /// @brief fix the boundary nodes to only be able to slide along the boundary 
+        /// the nodes are numbered as the uniform mesh before partitioning
         template<class T, class IDX, int ndim>
         auto hyper_rectangle(
                 std::array<IDX, (std::size_t) ndim> nelem,
@@ -518,8 +874,20 @@ namespace iceicle {
             std::array<IDX, ndim> nnode;
             std::ranges::transform(nelem, nnode.begin(), [](IDX el_count){ return el_count + 1; });
 
-            // TODO: be more efficient than entire cartesian product
-            for(IDX inode{0}; const std::array<IDX, ndim>& ijk : cartesian_index_product(nnode)){
+            // only visit the local nodes that are represented (selected or ghost)
+            // and recover the cartesian index from the node index before partitioning
+            // (the first index varies fastest, see cartesian_index_product)
+            using global_index_type = AbstractMesh<T, IDX, ndim>::global_index_type;
+            IDX nnode_local = (geo_map.meshptr == nullptr) ? 0 : geo_map.meshptr->n_nodes();
+            for(IDX inode = 0; inode < nnode_local; ++inode){
+                if(!geo_map.represents_node(inode)) continue;
+                global_index_type ignode = (geo_map.distributed) ? geo_map.meshptr->gnode_idxs[inode] : inode;
+                std::array<IDX, ndim> ijk;
+                for(int idim = 0; idim < ndim; ++idim){
+                    ijk[idim] = (IDX) (ignode % nnode[idim]);
+                    ignode /= nnode[idim];
+                }
+                if(ignode != 0) continue; // not a node of the hyper rectangle
 
                 std::vector<std::pair<int, T>> fixed_coordinates{};
                 for(int idim = 0; idim < ndim; ++idim){
@@ -533,7 +901,6 @@ namespace iceicle {
                         parameterization{fixed_coordinates, xmin, xmax};
                     geo_map.register_parametric_node(inode, parameterization);
                 }
-                ++inode;
             }
 
             geo_map.finalize();
@@ -552,6 +919,7 @@ namespace iceicle {
             { return std::abs(a - b) < 1e-8; };
 
             for(IDX inode = 0; inode < mesh.n_nodes(); ++inode){
+                if(!geo_map.represents_node(inode)) continue;
                 std::vector<std::pair<int, T>> fixed_coordinates{};
                 for(int idim = 0; idim < ndim; ++idim){
                     if(near(mesh.coord[inode][idim], xmin[idim]) )
@@ -568,6 +936,7 @@ namespace iceicle {
         }
 
         /// @brief fix all the nodes given in the list
+        /// (node indices of the mesh before partitioning)
         template<class T, class IDX, int ndim>
         auto fixed_nodelist(
             std::span<IDX> nodelist,
@@ -575,7 +944,9 @@ namespace iceicle {
             geo_dof_map<T, IDX, ndim>& geo_map
         ) -> void 
         {
-            for(IDX inode : nodelist){
+            for(IDX ignode : nodelist){
+                IDX inode = geo_map.local_node_index(ignode);
+                if(inode < 0 || !geo_map.represents_node(inode)) continue;
                 std::array<T, ndim> pt;
                 std::ranges::copy(mesh.coord[inode], pt.begin());
                 parametric_transformations::Fixed<T, ndim> parameterization{pt};
@@ -735,6 +1106,8 @@ namespace iceicle {
     };
 
     /// @brief represents the layout of memeory for interface conservation residual
+    /// In parallel only the rows of the dofs owned by this process are represented 
+    /// (contributions to ghost nodes are added to the owner with geo_dof_map::reverse_exchange())
     template<class T, class IDX, int ndim, int _nv>
     struct ic_residual_layout {
         // ============
@@ -0,0 +1,115 @@
+/**
+ * @brief word packed selection of mesh nodes
+ * for building the selected node lists and inverse maps of node set layouts
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/thread_utils.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace iceicle {
+
+    /**
+     * @brief a set of node indices in [0, size()) stored as one bit per node
+     *
+     * Marking and testing a node is a single word operation
+     * and the selected nodes are gathered a word at a time (popcount and count trailing zeros)
+     * so building the selection is O(nnode / 64) plus the number of selected nodes
+     * instead of a search per node
+     *
+     * @tparam IDX the index type
+     */
+    template<class IDX>
+    class node_selection {
+        public:
+        using word_type = std::uint64_t;
+        static constexpr std::size_t word_bits = 64;
+
+        private:
+        std::vector<word_type> words{};
+        std::size_t nbit = 0;
+
+        /// @brief the number of words gathered by one task in to_list()
+        static constexpr std::size_t words_per_block = 1024;
+
+        public:
+
+        node_selection() = default;
+
+        /// @brief an empty selection of nnode nodes
+        explicit node_selection(std::size_t nnode)
+        : words((nnode + word_bits - 1) / word_bits, 0), nbit{nnode} {}
+
+        /// @brief the number of nodes that can be selected
+        [[nodiscard]] auto size() const noexcept -> std::size_t { return nbit; }
+
+        /// @brief select a node
+        auto set(IDX inode) noexcept -> void
+        { words[inode / word_bits] |= (word_type{1} << (inode % word_bits)); }
+
+        /// @brief remove a node from the selection
+        auto reset(IDX inode) noexcept -> void
+        { words[inode / word_bits] &= ~(word_type{1} << (inode % word_bits)); }
+
+        /// @brief check if a node is selected
+        [[nodiscard]] auto test(IDX inode) const noexcept -> bool
+        { return (words[inode / word_bits] >> (inode % word_bits)) & word_type{1}; }
+
+        /// @brief remove every node selected in other (of the same size)
+        auto operator-=(const node_selection& other) noexcept -> node_selection& {
+            for(std::size_t iword = 0; iword < words.size(); ++iword) words[iword] &= ~other.words[iword];
+            return *this;
+        }
+
+        /// @brief the number of selected nodes
+        [[nodiscard]] auto count() const noexcept -> std::size_t {
+            std::size_t n = 0;
+            for(word_type word : words) n += std::popcount(word);
+            return n;
+        }
+
+        /**
+         * @brief the selected nodes in increasing order
+         * blocks of words are counted then gathered in parallel
+         */
+        [[nodiscard]] auto to_list() const -> std::vector<IDX> {
+            std::size_t nblock = (words.size() + words_per_block - 1) / words_per_block;
+            std::vector<std::size_t> offsets(nblock + 1, 0);
+            util::parallel_for(nblock, [&](std::size_t iblock){
+                std::size_t end = std::min(words.size(), (iblock + 1) * words_per_block);
+                std::size_t n = 0;
+                for(std::size_t iword = iblock * words_per_block; iword < end; ++iword) n += std::popcount(words[iword]);
+                offsets[iblock + 1] = n;
+            });
+            for(std::size_t iblock = 0; iblock < nblock; ++iblock) offsets[iblock + 1] += offsets[iblock];
+
+            std::vector<IDX> list(offsets[nblock]);
+            util::parallel_for(nblock, [&](std::size_t iblock){
+                std::size_t end = std::min(words.size(), (iblock + 1) * words_per_block);
+                std::size_t ilist = offsets[iblock];
+                for(std::size_t iword = iblock * words_per_block; iword < end; ++iword){
+                    for(word_type word = words[iword]; word != 0; word &= word - 1)
+                        { list[ilist++] = (IDX) (iword * word_bits + std::countr_zero(word)); }
+                }
+            });
+            return list;
+        }
+    };
+
+    /**
+     * @brief the O(1) inverse lookup of a list of node indices
+     * @param list the distinct node indices
+     * @param nnode the number of nodes
+     * @return for each node the index in list, or list.size() if not in the list
+     */
+    template<class IDX>
+    auto inverse_node_list(const std::vector<IDX>& list, std::size_t nnode) -> std::vector<IDX> {
+        std::vector<IDX> inv(nnode, (IDX) list.size());
+        util::parallel_for(list.size(), [&](std::size_t i){ inv[list[i]] = (IDX) i; });
+        return inv;
+    }
+}
@@ -5,6 +5,7 @@
  */
 #pragma once
 #include "iceicle/fespace/fespace.hpp"
+#include "iceicle/fe_function/node_selection.hpp"
 #include <ranges>
 #include <type_traits>
 #include <vector>
@@ -51,14 +52,14 @@ namespace iceicle {
 #endif
         {
             // helper array to keep track of which global node indices to select
-            std::vector<bool> to_select(fespace.meshptr->n_nodes(), false);
+            node_selection<index_type> to_select(fespace.meshptr->n_nodes());
             using trace_type = std::remove_reference_t<decltype(fespace)>::TraceType;
 
             // loop over selected faces and select nodes
             for(index_type trace_idx : trace_indices){
                 const trace_type& trace = fespace.traces[trace_idx];
                 for(index_type inode : trace.face->nodes_span()){
-                    to_select[inode] = true;
+                    to_select.set(inode);
                 }
             }
 
@@ -66,20 +67,15 @@ namespace iceicle {
             // since some may be connected to an active interior face 
             for(const trace_type &trace : fespace.get_boundary_traces()){
                 for(index_type inode : trace.face->nodes_span()){
-                    to_select[inode] = false;
+                    to_select.reset(inode);
                 }
             }
 
             // construct the selected nodes list 
-            for(int inode = 0; inode < fespace.meshptr->n_nodes(); ++inode){
-                if(to_select[inode]) selected_nodes.push_back(inode);
-            }
+            selected_nodes = to_select.to_list();
 
             // default value for nodes that aren't selected is to map to selected_nodes.size()
-            inv_selected_nodes = std::vector<index_type>(fespace.meshptr->n_nodes(), selected_nodes.size());
-            for(int idof = 0; idof < selected_nodes.size(); ++idof){
-                inv_selected_nodes[selected_nodes[idof]] = idof;
-            }
+            inv_selected_nodes = inverse_node_list(selected_nodes, fespace.meshptr->n_nodes());
         }
 
         nodeset_dof_map() = default;
@@ -2,7 +2,11 @@
 #include <iceicle/load_shaders.hpp>
 #include <iceicle/geometry/face.hpp>
 #include <iceicle/mesh/mesh.hpp>
+#include <iceicle/fespace/fespace.hpp>
+#include <iceicle/fe_function/fespan.hpp>
 #include <iceicle/opengl_drawer.hpp>
+#include <algorithm>
+#include <limits>
 #include <vector>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -317,6 +321,256 @@ namespace iceicle::gl {
         }
     };
 
+    inline const char *fe_field_2d_vert =
+#include "../../../../../shaders/fe_field_2d.vert"
+    ;
+
+    inline const char *fe_field_2d_frag =
+#include "../../../../../shaders/fe_field_2d.frag"
+    ;
+
+    /**
+     * @brief draws one component of a 2D finite element solution
+     * with the field evaluated on the GPU
+     *
+     * The elements are drawn in the batches of the fespace (elements that share basis functions).
+     * For each batch the device holds:
+     * - the basis functions at the vertices of a subdivided reference patch [nvert x nbasis] (once)
+     * - the physical coordinates of the patch vertices of each element (set_geometry)
+     * - the coefficients of the drawn component for each element (set_coefficients)
+     * and the vertex shader sums the coefficients times the basis functions with one instance per element.
+     * A new solution only uploads nelem * nbasis floats instead of the subdivided triangles.
+     *
+     * The tables are texture buffer objects (OpenGL 3.1+) to stay within the 3.3 core profile
+     */
+    template<typename T, typename IDX>
+    class FieldDrawer2D {
+
+        /// @brief the device data for a batch of elements that share basis functions
+        struct ElementBatch {
+            std::vector<IDX> elidxs;
+            int nbasis;
+            int nvert;
+            GLsizei nindex;
+
+            GLuint index_buffer;
+            GLuint basis_buffer, basis_texture;
+            GLuint coord_buffer, coord_texture;
+            GLuint coeff_buffer, coeff_texture;
+        };
+
+        GLuint vertex_array_id;
+        std::vector<ElementBatch> batches;
+
+        /// @brief create a texture buffer over a new buffer object
+        static void create_texture_buffer(GLenum format, GLuint& buffer, GLuint& texture){
+            glGenBuffers(1, &buffer);
+            glGenTextures(1, &texture);
+            glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+            glBindTexture(GL_TEXTURE_BUFFER, texture);
+            glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+        }
+
+        void free_batches(){
+            for(ElementBatch& batch : batches){
+                GLuint buffers[4] = {batch.index_buffer, batch.basis_buffer, batch.coord_buffer, batch.coeff_buffer};
+                GLuint textures[3] = {batch.basis_texture, batch.coord_texture, batch.coeff_texture};
+                glDeleteBuffers(4, buffers);
+                glDeleteTextures(3, textures);
+            }
+            batches.clear();
+        }
+
+        public:
+
+        /// The shader that evaluates and colors the field
+        Shader shader;
+
+        /// the number of subdivisions of each element edge
+        int nsubdiv;
+
+        /// the range of values for the colormap
+        GLfloat umin = 0.0, umax = 1.0;
+
+        /**
+         * @brief the vertices and triangles of a subdivided reference domain
+         * @param domain_type the reference domain (HYPERCUBE [-1, 1]^2 or SIMPLEX)
+         * @param nsubdiv the number of subdivisions of each edge
+         * @param [out] xi the reference coordinates of the vertices [nvert x 2]
+         * @param [out] indices the vertex indices of the triangles
+         */
+        static void reference_patch(DOMAIN_TYPE domain_type, int nsubdiv,
+                std::vector<T>& xi, std::vector<GLuint>& indices)
+        {
+            xi.clear();
+            indices.clear();
+            const int n = nsubdiv;
+            if(domain_type == DOMAIN_TYPE::SIMPLEX){
+                // row j has n + 1 - j vertices
+                auto vidx = [n](int i, int j) -> GLuint { return j * (n + 1) - j * (j - 1) / 2 + i; };
+                for(int j = 0; j <= n; ++j) for(int i = 0; i <= n - j; ++i){
+                    xi.push_back((T) i / n);
+                    xi.push_back((T) j / n);
+                }
+                for(int j = 0; j < n; ++j) for(int i = 0; i < n - j; ++i){
+                    indices.insert(indices.end(), {vidx(i, j), vidx(i + 1, j), vidx(i, j + 1)});
+                    if(i + j < n - 1)
+                        indices.insert(indices.end(), {vidx(i + 1, j), vidx(i + 1, j + 1), vidx(i, j + 1)});
+                }
+            } else {
+                auto vidx = [n](int i, int j) -> GLuint { return j * (n + 1) + i; };
+                for(int j = 0; j <= n; ++j) for(int i = 0; i <= n; ++i){
+                    xi.push_back(-1.0 + 2.0 * i / n);
+                    xi.push_back(-1.0 + 2.0 * j / n);
+                }
+                for(int j = 0; j < n; ++j) for(int i = 0; i < n; ++i){
+                    indices.insert(indices.end(), {vidx(i, j), vidx(i + 1, j), vidx(i + 1, j + 1)});
+                    indices.insert(indices.end(), {vidx(i, j), vidx(i + 1, j + 1), vidx(i, j + 1)});
+                }
+            }
+        }
+
+        /// @param nsubdiv the number of subdivisions of each element edge
+        FieldDrawer2D(int nsubdiv = 4)
+        : shader(fe_field_2d_vert, fe_field_2d_frag, nullptr), nsubdiv{nsubdiv} {
+            glGenVertexArrays(1, &vertex_array_id);
+        }
+
+        FieldDrawer2D(const FieldDrawer2D& other) = delete;
+        FieldDrawer2D& operator=(const FieldDrawer2D& other) = delete;
+
+        ~FieldDrawer2D(){
+            free_batches();
+            glDeleteVertexArrays(1, &vertex_array_id);
+        }
+
+        /**
+         * @brief tabulate the basis functions and upload the element geometry
+         * call again when the fespace is rebuilt or the mesh nodes move
+         * @param fespace the finite element space
+         */
+        void set_geometry(FESpace<T, IDX, 2>& fespace){
+            free_batches();
+            glBindVertexArray(vertex_array_id);
+            std::vector<T> xi{};
+            std::vector<GLuint> indices{};
+            std::vector<T> bi{};
+            std::vector<GLfloat> basis_table{};
+            std::vector<GLfloat> coords{};
+            for(IDX ibatch = 0; ibatch < fespace.element_batches.nrow(); ++ibatch){
+                std::span<const IDX> elidxs = fespace.element_batches.rowspan(ibatch);
+                if(elidxs.empty()) continue;
+                const FiniteElement<T, IDX, 2>& el0 = fespace.elements[elidxs[0]];
+
+                ElementBatch batch{};
+                batch.elidxs.assign(elidxs.begin(), elidxs.end());
+                batch.nbasis = el0.nbasis();
+                reference_patch(el0.trans->domain_type, nsubdiv, xi, indices);
+                batch.nvert = xi.size() / 2;
+                batch.nindex = indices.size();
+
+                glGenBuffers(1, &batch.index_buffer);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch.index_buffer);
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+
+                // the basis functions are the same for all the elements in the batch
+                bi.resize(batch.nbasis);
+                basis_table.resize(batch.nvert * batch.nbasis);
+                for(int ivert = 0; ivert < batch.nvert; ++ivert){
+                    el0.eval_basis(xi.data() + 2 * ivert, bi.data());
+                    std::ranges::copy(bi, basis_table.begin() + ivert * batch.nbasis);
+                }
+                create_texture_buffer(GL_R32F, batch.basis_buffer, batch.basis_texture);
+                glBufferData(GL_TEXTURE_BUFFER, basis_table.size() * sizeof(GLfloat), basis_table.data(), GL_STATIC_DRAW);
+
+                coords.resize(batch.elidxs.size() * batch.nvert * 2);
+                for(std::size_t ibel = 0; ibel < batch.elidxs.size(); ++ibel){
+                    const FiniteElement<T, IDX, 2>& el = fespace.elements[batch.elidxs[ibel]];
+                    for(int ivert = 0; ivert < batch.nvert; ++ivert){
+                        MATH::GEOMETRY::Point<T, 2> ref_pt{xi[2 * ivert], xi[2 * ivert + 1]};
+                        MATH::GEOMETRY::Point<T, 2> phys_pt = el.transform(ref_pt);
+                        coords[(ibel * batch.nvert + ivert) * 2] = phys_pt[0];
+                        coords[(ibel * batch.nvert + ivert) * 2 + 1] = phys_pt[1];
+                    }
+                }
+                create_texture_buffer(GL_RG32F, batch.coord_buffer, batch.coord_texture);
+                glBufferData(GL_TEXTURE_BUFFER, coords.size() * sizeof(GLfloat), coords.data(), GL_STATIC_DRAW);
+
+                create_texture_buffer(GL_R32F, batch.coeff_buffer, batch.coeff_texture);
+                glBufferData(GL_TEXTURE_BUFFER, batch.elidxs.size() * batch.nbasis * sizeof(GLfloat),
+                        nullptr, GL_STREAM_DRAW);
+
+                batches.push_back(std::move(batch));
+            }
+            glBindBuffer(GL_TEXTURE_BUFFER, 0);
+            glBindTexture(GL_TEXTURE_BUFFER, 0);
+            glBindVertexArray(0);
+        }
+
+        /**
+         * @brief upload the coefficients of one component of the solution
+         * WARNING: prerequisite: set_geometry() with the fespace of u
+         * @param u the solution
+         * @param iv the component to draw
+         * @param rescale set umin and umax to the range of the coefficients
+         */
+        template<class LayoutPolicy, class AccessorPolicy>
+        void set_coefficients(fespan<T, LayoutPolicy, AccessorPolicy> u, int iv, bool rescale = true){
+            std::vector<GLfloat> coeffs{};
+            GLfloat cmin = std::numeric_limits<GLfloat>::max(), cmax = std::numeric_limits<GLfloat>::lowest();
+            for(ElementBatch& batch : batches){
+                coeffs.resize(batch.elidxs.size() * batch.nbasis);
+                for(std::size_t ibel = 0; ibel < batch.elidxs.size(); ++ibel){
+                    for(int ibasis = 0; ibasis < batch.nbasis; ++ibasis){
+                        GLfloat c = u[batch.elidxs[ibel], ibasis, iv];
+                        coeffs[ibel * batch.nbasis + ibasis] = c;
+                        cmin = std::min(cmin, c);
+                        cmax = std::max(cmax, c);
+                    }
+                }
+                glBindBuffer(GL_TEXTURE_BUFFER, batch.coeff_buffer);
+                glBufferSubData(GL_TEXTURE_BUFFER, 0, coeffs.size() * sizeof(GLfloat), coeffs.data());
+            }
+            glBindBuffer(GL_TEXTURE_BUFFER, 0);
+            // the coefficient range bounds the field for nodal bases
+            if(rescale && cmin <= cmax){
+                umin = cmin;
+                umax = cmax;
+            }
+        }
+
+        /**
+         * @brief draw the field
+         * WARNING: prerequisite: set_geometry() and set_coefficients()
+         * @param bounds the bounding box of the mesh (scaled into the viewport)
+         */
+        void draw(BoundingBox bounds){
+            shader.load();
+            shader.set3Float("xmin", bounds.xmin);
+            shader.set3Float("xmax", bounds.xmax);
+            shader.setFloat("umin", umin);
+            shader.setFloat("umax", umax);
+            shader.setInt("basis_table", 0);
+            shader.setInt("vertex_coords", 1);
+            shader.setInt("coefficients", 2);
+            glBindVertexArray(vertex_array_id);
+            for(ElementBatch& batch : batches){
+                shader.setInt("nbasis", batch.nbasis);
+                shader.setInt("nvert", batch.nvert);
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_BUFFER, batch.basis_texture);
+                glActiveTexture(GL_TEXTURE1);
+                glBindTexture(GL_TEXTURE_BUFFER, batch.coord_texture);
+                glActiveTexture(GL_TEXTURE2);
+                glBindTexture(GL_TEXTURE_BUFFER, batch.coeff_texture);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch.index_buffer);
+                glDrawElementsInstanced(GL_TRIANGLES, batch.nindex, GL_UNSIGNED_INT, nullptr, batch.elidxs.size());
+            }
+            glActiveTexture(GL_TEXTURE0);
+            glBindVertexArray(0);
+        }
+    };
+
     template<typename T>
     std::vector< glm::vec3 > to_opengl_vertices(const NodeArray<T, 2> &nodes){
         std::vector< glm::vec3 > out;
@@ -1,13 +1,33 @@
 /// @brief Mechanism for restarting from previous state
 /// @author Gianni Absillis (gabsill@ncsu.edu)
 
+#pragma once
 #include "iceicle/anomaly_log.hpp"
 #include "iceicle/fespace/fespace.hpp"
 #include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fe_function/geo_layouts.hpp"
+#include "iceicle/mapped_file.hpp"
+#include "iceicle/thread_utils.hpp"
 #include <iomanip>
 #include <iceicle/iceicle_mpi_utils.hpp>
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#ifdef ICEICLE_USE_MPI
+#include <mpi.h>
+#endif
 
 namespace iceicle {
    
@@ -107,4 +127,572 @@ namespace iceicle {
         }
     }
 
+    namespace impl {
+
+        /// @brief the identifier at the start of binary restart files
+        inline constexpr std::array<char, 8> restart_magic{'I', 'C', 'E', 'R', 'S', 'T', 'B', '1'};
+
+        /// @brief the number of 64 bit fields after the identifier in the binary restart header
+        /// precision, nv, ndim, nelem, mesh_hash, nrank
+        inline constexpr std::size_t restart_header_nfield = 6;
+
+        /// @brief the number of 64 bit fields for each rank in the binary restart header
+        /// block offset, block size, nelem, nnode
+        inline constexpr std::size_t restart_rank_nfield = 4;
+
+        /// @brief 64 bit FNV-1a hash of a byte range
+        inline auto fnv1a(std::span<const std::byte> bytes, std::uint64_t hash = 14695981039346656037ull)
+        -> std::uint64_t {
+            for(std::byte b : bytes){
+                hash ^= static_cast<std::uint64_t>(b);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        /// @brief append the bytes of a trivially copyable value to a buffer
+        template<class V>
+        inline auto append_bytes(std::vector<std::byte>& buffer, const V& value) -> void {
+            const std::byte* value_bytes = reinterpret_cast<const std::byte*>(&value);
+            buffer.insert(buffer.end(), value_bytes, value_bytes + sizeof(V));
+        }
+
+        /// @brief read a trivially copyable value from bytes and advance the position
+        template<class V>
+        inline auto consume_bytes(std::span<const std::byte> bytes, std::size_t& pos) -> V {
+            V value;
+            std::memcpy(&value, bytes.data() + pos, sizeof(V));
+            pos += sizeof(V);
+            return value;
+        }
+
+        /// @brief read a real value stored with the given precision in bytes (4 or 8)
+        template<class T>
+        inline auto consume_real(std::span<const std::byte> bytes, std::size_t& pos, std::size_t precision) -> T {
+            if(precision == sizeof(float)) return static_cast<T>(consume_bytes<float>(bytes, pos));
+            return static_cast<T>(consume_bytes<double>(bytes, pos));
+        }
+
+        /// @brief the global index of each element and node of a mesh
+        /// (the local index if the mesh has not been partitioned)
+        template<class T, class IDX, int ndim>
+        inline auto restart_global_el(const AbstractMesh<T, IDX, ndim>& mesh, IDX iel) -> std::uint64_t
+        { return mesh.gel_idxs.empty() ? iel : mesh.gel_idxs[iel]; }
+
+        template<class T, class IDX, int ndim>
+        inline auto restart_global_node(const AbstractMesh<T, IDX, ndim>& mesh, IDX inode) -> std::uint64_t
+        { return mesh.gnode_idxs.empty() ? inode : mesh.gnode_idxs[inode]; }
+
+        /**
+         * @brief a hash of the global mesh topology that is independent of the partitioning
+         * the sum over elements of the hash of the global element index and global node indices
+         */
+        template<class T, class IDX, int ndim>
+        inline auto restart_mesh_hash(AbstractMesh<T, IDX, ndim>& mesh) -> std::uint64_t {
+            // the element hashes are chained over the indices (no byte buffer) and summed over threads
+            std::uint64_t hash = util::parallel_sums<1, std::uint64_t>(mesh.nelem(),
+                [&mesh](IDX iel, std::array<std::uint64_t, 1>& sum){
+                    auto index_bytes = [](const std::uint64_t& index)
+                    { return std::span<const std::byte>{reinterpret_cast<const std::byte*>(&index), sizeof(index)}; };
+                    std::uint64_t el_hash = fnv1a(index_bytes(restart_global_el(mesh, iel)));
+                    for(IDX inode : mesh.get_el_nodes(iel))
+                        { el_hash = fnv1a(index_bytes(restart_global_node(mesh, inode)), el_hash); }
+                    sum[0] += el_hash;
+                })[0];
+#ifdef ICEICLE_USE_MPI
+            if(mpi::mpi_initialized()) {
+                std::uint64_t hash_local = hash;
+                MPI_Allreduce(&hash_local, &hash, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+            }
+#endif
+            return hash;
+        }
+
+        /**
+         * @brief a single file shared by all ranks
+         * using MPI-IO when mpi is initialized, otherwise a file stream
+         */
+        class restart_file {
+#ifdef ICEICLE_USE_MPI
+            MPI_File fh{};
+            bool use_mpi = false;
+#endif
+            std::fstream fs{};
+            bool good = false;
+
+            /// @brief the largest single MPI-IO transfer
+            static constexpr std::size_t max_chunk = INT_MAX / 2;
+
+            public:
+
+            /// @brief open the file (collective)
+            /// @param path the file path
+            /// @param write true to create the file for writing, false to read
+            restart_file(const std::filesystem::path& path, bool write) {
+#ifdef ICEICLE_USE_MPI
+                if(mpi::mpi_initialized()) {
+                    use_mpi = true;
+                    int amode = write ? (MPI_MODE_CREATE | MPI_MODE_WRONLY) : MPI_MODE_RDONLY;
+                    if(write) {
+                        // truncate a previous file of the same name
+                        if(mpi::mpi_world_rank() == 0) MPI_File_delete(path.c_str(), MPI_INFO_NULL);
+                        MPI_Barrier(MPI_COMM_WORLD);
+                    }
+                    good = MPI_File_open(MPI_COMM_WORLD, path.c_str(), amode, MPI_INFO_NULL, &fh) == MPI_SUCCESS;
+                    return;
+                }
+#endif
+                fs.open(path, write ? (std::ios::out | std::ios::binary | std::ios::trunc) : (std::ios::in | std::ios::binary));
+                good = static_cast<bool>(fs);
+            }
+
+            restart_file(const restart_file&) = delete;
+            restart_file& operator=(const restart_file&) = delete;
+
+            ~restart_file() {
+#ifdef ICEICLE_USE_MPI
+                if(use_mpi && good) MPI_File_close(&fh);
+#endif
+            }
+
+            explicit operator bool() const noexcept { return good; }
+
+            /// @brief collectively write bytes at the given offset (every rank must call this)
+            auto write_at_all(std::uint64_t offset, std::span<const std::byte> bytes) -> void {
+#ifdef ICEICLE_USE_MPI
+                if(use_mpi) {
+                    // every rank makes the same number of collective calls
+                    unsigned long long nchunk = (bytes.size() + max_chunk - 1) / max_chunk, nchunk_max;
+                    MPI_Allreduce(&nchunk, &nchunk_max, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX, MPI_COMM_WORLD);
+                    for(unsigned long long ichunk = 0; ichunk < nchunk_max; ++ichunk){
+                        std::size_t begin = std::min(bytes.size(), ichunk * max_chunk);
+                        std::size_t count = std::min(bytes.size() - begin, max_chunk);
+                        MPI_File_write_at_all(fh, offset + begin, bytes.data() + begin,
+                                (int) count, MPI_BYTE, MPI_STATUS_IGNORE);
+                    }
+                    return;
+                }
+#endif
+                fs.seekp(offset);
+                fs.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+            }
+
+            /// @brief read bytes at the given offset (independent)
+            auto read_at(std::uint64_t offset, std::span<std::byte> bytes) -> void {
+#ifdef ICEICLE_USE_MPI
+                if(use_mpi) {
+                    for(std::size_t begin = 0; begin < bytes.size(); begin += max_chunk){
+                        std::size_t count = std::min(bytes.size() - begin, max_chunk);
+                        MPI_File_read_at(fh, offset + begin, bytes.data() + begin,
+                                (int) count, MPI_BYTE, MPI_STATUS_IGNORE);
+                    }
+                    return;
+                }
+#endif
+                fs.seekg(offset);
+                fs.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+                if(!fs) good = false;
+            }
+        };
+    }
+
+    namespace impl {
+
+        /// @brief the identifier at the start of delta restart files
+        inline constexpr std::array<char, 8> restart_delta_magic{'I', 'C', 'E', 'R', 'S', 'T', 'D', '1'};
+
+        /**
+         * @brief write a binary restart file (see write_restart_binary for the layout)
+         * @param fespace the finite element space
+         * @param u the solution
+         * @param nodes the local indices of the nodes to write coordinates for
+         * @param out_filename the file to write
+         * @param base if set, write a delta file with this index of the full restart file it applies to
+         */
+        template<class T, class IDX, int ndim, class LayoutPolicy>
+        auto write_restart_file(
+            FESpace<T, IDX, ndim>& fespace,
+            fespan<T, LayoutPolicy> u,
+            std::span<const IDX> nodes,
+            const std::filesystem::path& out_filename,
+            std::optional<std::uint64_t> base
+        ) -> void {
+            AbstractMesh<T, IDX, ndim>& mesh = *fespace.meshptr;
+            int myrank = mpi::mpi_world_rank(), nrank = mpi::mpi_world_size();
+
+            if(myrank == 0) std::filesystem::create_directories(out_filename.parent_path());
+
+            // build this rank's block
+            std::vector<std::byte> block{};
+            for(IDX inode : nodes){
+                append_bytes(block, restart_global_node(mesh, inode));
+                for(int idim = 0; idim < ndim; ++idim) append_bytes(block, (T) mesh.coord[inode][idim]);
+            }
+            for(IDX ielem = 0; ielem < fespace.elements.size(); ++ielem){
+                append_bytes(block, restart_global_el(mesh, ielem));
+                append_bytes(block, (std::uint64_t) u.ndof(ielem));
+                for(IDX idof = 0; idof < u.ndof(ielem); ++idof){
+                    for(int iv = 0; iv < u.nv(); ++iv) append_bytes(block, (T) u[ielem, idof, iv]);
+                }
+            }
+            append_bytes(block, fnv1a(block));
+
+            // per rank block information
+            std::array<std::uint64_t, restart_rank_nfield> rank_info{0, block.size(),
+                (std::uint64_t) fespace.elements.size(), (std::uint64_t) nodes.size()};
+            std::vector<std::uint64_t> all_info(restart_rank_nfield * nrank);
+#ifdef ICEICLE_USE_MPI
+            if(mpi::mpi_initialized()) {
+                MPI_Allgather(rank_info.data(), restart_rank_nfield, MPI_UINT64_T,
+                        all_info.data(), restart_rank_nfield, MPI_UINT64_T, MPI_COMM_WORLD);
+            } else
+#endif
+            { std::ranges::copy(rank_info, all_info.begin()); }
+
+            std::uint64_t header_size = restart_magic.size() + (base ? sizeof(std::uint64_t) : 0)
+                + sizeof(std::uint64_t) * (restart_header_nfield + restart_rank_nfield * nrank);
+            std::uint64_t offset = header_size, nelem_global = 0;
+            for(int irank = 0; irank < nrank; ++irank){
+                all_info[restart_rank_nfield * irank] = offset;
+                offset += all_info[restart_rank_nfield * irank + 1];
+                nelem_global += all_info[restart_rank_nfield * irank + 2];
+            }
+            std::uint64_t mesh_hash = restart_mesh_hash(mesh);
+
+            restart_file file{out_filename, true};
+            if(!file) {
+                util::AnomalyLog::log_anomaly(util::Anomaly{
+                    "Cannot open restart file for writing", util::general_anomaly_tag{}});
+                return;
+            }
+
+            // rank 0 writes the header in front of its block
+            if(myrank == 0){
+                std::vector<std::byte> out_bytes{};
+                for(char c : (base ? restart_delta_magic : restart_magic)) append_bytes(out_bytes, c);
+                if(base) append_bytes(out_bytes, base.value());
+                for(std::uint64_t field : {(std::uint64_t) sizeof(T), (std::uint64_t) u.nv(), (std::uint64_t) ndim,
+                        nelem_global, mesh_hash, (std::uint64_t) nrank})
+                    { append_bytes(out_bytes, field); }
+                for(std::uint64_t field : all_info) append_bytes(out_bytes, field);
+                out_bytes.insert(out_bytes.end(), block.begin(), block.end());
+                file.write_at_all(0, out_bytes);
+            } else {
+                file.write_at_all(all_info[restart_rank_nfield * myrank], block);
+            }
+        }
+
+        /**
+         * @brief read a binary restart file (see read_restart_binary)
+         * @param fespace the finite element space (overwrites the nodes in the file)
+         * @param u the solution to read
+         * @param in_filename the file to read
+         * @param allow_delta if delta files may be read (a delta file first reads its full restart file)
+         */
+        template<class T, class IDX, int ndim, class LayoutPolicy>
+        auto read_restart_file(
+            FESpace<T, IDX, ndim>& fespace,
+            fespan<T, LayoutPolicy> u,
+            const std::filesystem::path& in_filename,
+            bool allow_delta
+        ) -> void {
+            using namespace util;
+            AbstractMesh<T, IDX, ndim>& mesh = *fespace.meshptr;
+            int myrank = mpi::mpi_world_rank();
+
+            // map the file so each rank only pulls the pages of the blocks it parses from disk
+            // (all ranks fall back to reading the blocks with restart_file if any rank cannot map it)
+            mapped_file mapped{in_filename.string(), true, false};
+            int all_mapped = mapped.mapped();
+#ifdef ICEICLE_USE_MPI
+            if(mpi::mpi_initialized()) MPI_Allreduce(MPI_IN_PLACE, &all_mapped, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+#endif
+            std::optional<restart_file> file{};
+            if(!all_mapped) {
+                file.emplace(in_filename, false);
+                if(!*file) {
+                    AnomalyLog::log_anomaly(Anomaly{"Cannot open restart file " + in_filename.string(), general_anomaly_tag{}});
+                    return;
+                }
+            }
+
+            // the bytes [offset, offset + size) of the file, empty if out of range or the read failed
+            // NOTE: when read (not mapped) the bytes are only valid until the next call
+            std::vector<std::byte> buffer{};
+            auto bytes_at = [&](std::uint64_t offset, std::uint64_t size) -> std::span<const std::byte> {
+                if(all_mapped) {
+                    if(offset > mapped.size() || size > mapped.size() - offset) return {};
+                    return std::span<const std::byte>{reinterpret_cast<const std::byte*>(mapped.data()) + offset, size};
+                }
+                buffer.resize(size);
+                file->read_at(offset, buffer);
+                if(!*file) return {};
+                return std::span<const std::byte>{buffer};
+            };
+
+            // header
+            std::span<const std::byte> header = bytes_at(0,
+                    restart_magic.size() + sizeof(std::uint64_t) * (restart_header_nfield + 1));
+            std::size_t pos = restart_magic.size();
+            if(header.size() > 0 && allow_delta
+                    && std::memcmp(header.data(), restart_delta_magic.data(), restart_delta_magic.size()) == 0) {
+                // apply the delta on top of the full restart it was written against
+                std::uint64_t base = consume_bytes<std::uint64_t>(header, pos);
+                read_restart_file(fespace, u, in_filename.parent_path() / ("restart" + std::to_string(base) + ".bin"), false);
+            } else if(header.size() == 0 || std::memcmp(header.data(), restart_magic.data(), restart_magic.size()) != 0) {
+                AnomalyLog::log_anomaly(Anomaly{"Not a binary restart file: " + in_filename.string(), general_anomaly_tag{}});
+                return;
+            }
+            std::uint64_t precision = consume_bytes<std::uint64_t>(header, pos);
+            std::uint64_t nv = consume_bytes<std::uint64_t>(header, pos);
+            std::uint64_t file_ndim = consume_bytes<std::uint64_t>(header, pos);
+            consume_bytes<std::uint64_t>(header, pos); // the global number of elements
+            std::uint64_t mesh_hash = consume_bytes<std::uint64_t>(header, pos);
+            std::uint64_t nrank_file = consume_bytes<std::uint64_t>(header, pos);
+            if(precision != sizeof(float) && precision != sizeof(double)) {
+                AnomalyLog::log_anomaly(Anomaly{"unsupported restart precision", general_anomaly_tag{}});
+                return;
+            }
+            if(nv != (std::uint64_t) u.nv() || file_ndim != (std::uint64_t) ndim) {
+                AnomalyLog::log_anomaly(Anomaly{"restart file has a different number of fields or dimensionality", general_anomaly_tag{}});
+                return;
+            }
+            if(mesh_hash != restart_mesh_hash(mesh)) {
+                AnomalyLog::log_anomaly(Anomaly{"restart file was written for a different mesh topology", general_anomaly_tag{}});
+                return;
+            }
+
+            std::span<const std::byte> rank_bytes = bytes_at(pos, sizeof(std::uint64_t) * restart_rank_nfield * nrank_file);
+            if(rank_bytes.size() == 0) {
+                AnomalyLog::log_anomaly(Anomaly{"truncated restart header: " + in_filename.string(), general_anomaly_tag{}});
+                return;
+            }
+            std::vector<std::uint64_t> rank_info(restart_rank_nfield * nrank_file);
+            std::memcpy(rank_info.data(), rank_bytes.data(), rank_bytes.size());
+
+            // local index of each global index, or -1 if not on this process
+            // (the identity when the mesh has not been partitioned)
+            std::unordered_map<std::uint64_t, IDX> local_el{}, local_node{};
+            if(!mesh.gel_idxs.empty())
+                for(IDX iel = 0; iel < fespace.elements.size(); ++iel) local_el[restart_global_el(mesh, iel)] = iel;
+            if(!mesh.gnode_idxs.empty())
+                for(IDX inode = 0; inode < mesh.n_nodes(); ++inode) local_node[restart_global_node(mesh, inode)] = inode;
+            auto find_el = [&](std::uint64_t igel) -> IDX {
+                if(mesh.gel_idxs.empty()) return (igel < fespace.elements.size()) ? (IDX) igel : -1;
+                auto it = local_el.find(igel);
+                return (it == local_el.end()) ? -1 : it->second;
+            };
+            auto find_node = [&](std::uint64_t ignode) -> IDX {
+                if(mesh.gnode_idxs.empty()) return (ignode < (std::uint64_t) mesh.n_nodes()) ? (IDX) ignode : -1;
+                auto it = local_node.find(ignode);
+                return (it == local_node.end()) ? -1 : it->second;
+            };
+            std::vector<char> el_found(fespace.elements.size(), 0);
+            std::size_t nfound = 0;
+
+            auto read_block = [&](std::uint64_t iblock) -> bool {
+                std::uint64_t offset = rank_info[restart_rank_nfield * iblock];
+                std::uint64_t size = rank_info[restart_rank_nfield * iblock + 1];
+                std::uint64_t nel = rank_info[restart_rank_nfield * iblock + 2];
+                std::uint64_t nnode = rank_info[restart_rank_nfield * iblock + 3];
+                auto corrupt = [iblock](std::string what) -> bool {
+                    AnomalyLog::log_anomaly(Anomaly{what + " in restart block " + std::to_string(iblock),
+                            general_anomaly_tag{}});
+                    return false;
+                };
+                std::span<const std::byte> block = bytes_at(offset, size);
+                if(block.size() < sizeof(std::uint64_t)) return corrupt("checksum mismatch");
+                std::span<const std::byte> data = block.first(block.size() - sizeof(std::uint64_t));
+                std::size_t checksum_pos = data.size();
+                if(consume_bytes<std::uint64_t>(block, checksum_pos) != fnv1a(data)) return corrupt("checksum mismatch");
+
+                // the node records are fixed size so are parsed in parallel
+                const std::size_t node_record = sizeof(std::uint64_t) + ndim * precision;
+                if(nnode > data.size() / node_record) return corrupt("truncated nodes");
+                util::parallel_for(nnode, [&](std::uint64_t inode_file){
+                    std::size_t pos = inode_file * node_record;
+                    IDX inode = find_node(consume_bytes<std::uint64_t>(data, pos));
+                    if(inode < 0) return;
+                    for(int idim = 0; idim < ndim; ++idim) mesh.coord[inode][idim] = consume_real<T>(data, pos, precision);
+                });
+
+                // find the start of each element record from the record headers
+                std::vector<std::size_t> el_pos(nel);
+                std::size_t pos = nnode * node_record;
+                for(std::uint64_t iel = 0; iel < nel; ++iel){
+                    if(data.size() - pos < 2 * sizeof(std::uint64_t)) return corrupt("truncated elements");
+                    el_pos[iel] = pos;
+                    pos += sizeof(std::uint64_t);
+                    std::uint64_t ndof = consume_bytes<std::uint64_t>(data, pos);
+                    if(ndof * nv * precision > data.size() - pos) return corrupt("truncated elements");
+                    pos += ndof * nv * precision;
+                }
+
+                // then copy the coefficients in parallel
+                // (straight from the file bytes when the element data is contiguous and the precision matches)
+                std::array<std::size_t, 2> counts = util::parallel_sums<2, std::size_t>(nel,
+                    [&](std::uint64_t iel_file, std::array<std::size_t, 2>& counts){
+                        std::size_t pos = el_pos[iel_file];
+                        IDX ielem = find_el(consume_bytes<std::uint64_t>(data, pos));
+                        std::uint64_t ndof = consume_bytes<std::uint64_t>(data, pos);
+                        if(ielem < 0) return;
+                        if(ndof != (std::uint64_t) u.ndof(ielem)) {
+                            counts[1] += 1;
+                            return;
+                        }
+                        bool copied = false;
+                        if constexpr (LayoutPolicy::local_dof_contiguous()) {
+                            if(precision == sizeof(T)) {
+                                std::memcpy(u.data() + u.get_layout()[ielem, 0, 0], data.data() + pos, ndof * nv * sizeof(T));
+                                copied = true;
+                            }
+                        }
+                        if(!copied) {
+                            for(IDX idof = 0; idof < u.ndof(ielem); ++idof){
+                                for(int iv = 0; iv < u.nv(); ++iv) u[ielem, idof, iv] = consume_real<T>(data, pos, precision);
+                            }
+                        }
+                        if(!el_found[ielem]) {
+                            el_found[ielem] = 1;
+                            counts[0] += 1;
+                        }
+                    });
+                nfound += counts[0];
+                if(counts[1] > 0) {
+                    AnomalyLog::log_anomaly(Anomaly{"restart file has a different number of basis functions",
+                            general_anomaly_tag{}});
+                    return false;
+                }
+                return true;
+            };
+
+            // try this rank's block first, then search every block
+            // NOTE: nodes of a delta file are only found in the other blocks when elements are missing,
+            // but the elements of this rank are in one block with the nodes around them
+            bool ok = true;
+            if((std::uint64_t) myrank < nrank_file) ok = read_block(myrank);
+            for(std::uint64_t iblock = 0; ok && nfound < fespace.elements.size() && iblock < nrank_file; ++iblock){
+                if(iblock != (std::uint64_t) myrank) ok = read_block(iblock);
+            }
+            if(ok && nfound < fespace.elements.size()) {
+                AnomalyLog::log_anomaly(Anomaly{"restart file is missing elements of this partition", general_anomaly_tag{}});
+            }
+            mesh.update_coord_els();
+        }
+    }
+
+    /**
+     * @brief write a binary restart file "RESTART/restart<k>.bin" shared by all ranks
+     *
+     * Layout (native endianness):
+     *   header: "ICERSTB1", precision (bytes per real), nv, ndim, global number of elements,
+     *           mesh topology hash, number of ranks, then for each rank the
+     *           block offset, block size, number of elements, and number of nodes (all uint64)
+     *   one block per rank:
+     *           for each node: global node index, coordinates
+     *           for each element: global element index, ndof, the ndof x nv coefficients
+     *           FNV-1a checksum of the block
+     *
+     * The blocks are written with one collective MPI-IO write.
+     * Because every record carries its global index, the file can be read
+     * on any number of ranks (see read_restart_binary)
+     *
+     * @param fespace the finite element space
+     * @param u the solution to write to the restart file
+     * @param k the iteration identifier for the restart file
+     */
+    template<class T, class IDX, int ndim, class LayoutPolicy>
+    auto write_restart_binary(
+        FESpace<T, IDX, ndim>& fespace,
+        fespan<T, LayoutPolicy> u,
+        IDX k
+    ) -> void {
+        std::vector<IDX> nodes(fespace.meshptr->n_nodes());
+        std::iota(nodes.begin(), nodes.end(), 0);
+        std::filesystem::path restart_directory = std::filesystem::current_path() / "RESTART";
+        impl::write_restart_file(fespace, u, std::span<const IDX>{nodes},
+                restart_directory / ("restart" + std::to_string(k) + ".bin"), std::nullopt);
+    }
+
+    /**
+     * @brief read a binary restart file written by write_restart_binary (or a delta from IncrementalRestart)
+     *
+     * The file may have been written with a different number of ranks (or partitioning):
+     * each rank reads its own block when that contains all of its elements,
+     * otherwise it reads every block and takes the records with its global indices.
+     * The mesh topology hash, nv, and the number of basis functions of each element must match.
+     * Values stored in a different precision are converted.
+     *
+     * @param fespace the finite element space (will overwrite mesh nodes)
+     * @param u the solution to read
+     * @param restart_name the name of the restart file in the RESTART directory (i.e "restart10.bin")
+     */
+    template<class T, class IDX, int ndim, class LayoutPolicy>
+    auto read_restart_binary(
+        FESpace<T, IDX, ndim>& fespace,
+        fespan<T, LayoutPolicy> u,
+        std::string restart_name
+    ) -> void {
+        impl::read_restart_file(fespace, u, std::filesystem::current_path() / "RESTART" / restart_name, true);
+    }
+
+    /**
+     * @brief incremental binary checkpoints for MDG where only the selected nodes move
+     *
+     * Every nfull-th checkpoint is a full binary restart "RESTART/restart<k>.bin"
+     * the others are delta files "RESTART/restart<k>.delta.bin" with the solution
+     * and only the coordinates of the nodes selected (by any geo_dof_map) since the last full checkpoint.
+     * Reading a delta file with read_restart_binary first reads the full checkpoint it refers to.
+     *
+     * NOTE: nodes that are moved without being in a selected node set are not captured by the deltas
+     */
+    template<class T, class IDX, int ndim>
+    class IncrementalRestart {
+        /// @brief the number of checkpoints between full checkpoints
+        IDX nfull;
+
+        /// @brief the number of checkpoints written
+        IDX ncheckpoint = 0;
+
+        /// @brief the index of the last full checkpoint
+        std::uint64_t base_k = 0;
+
+        /// @brief the nodes selected since the last full checkpoint (sorted)
+        std::vector<IDX> moved_nodes{};
+
+        public:
+
+        /// @param nfull the number of checkpoints between full checkpoints (1 writes only full checkpoints)
+        explicit IncrementalRestart(IDX nfull = 10) : nfull{std::max(nfull, (IDX) 1)} {}
+
+        /**
+         * @brief write a checkpoint
+         * @param fespace the finite element space
+         * @param u the solution
+         * @param geo_map the geometry degrees of freedom (the nodes that may move)
+         * @param k the iteration identifier for the checkpoint
+         */
+        template<class LayoutPolicy>
+        auto write(
+            FESpace<T, IDX, ndim>& fespace,
+            fespan<T, LayoutPolicy> u,
+            const geo_dof_map<T, IDX, ndim>& geo_map,
+            IDX k
+        ) -> void {
+            std::filesystem::path restart_directory = std::filesystem::current_path() / "RESTART";
+            if(ncheckpoint++ % nfull == 0){
+                write_restart_binary(fespace, u, k);
+                base_k = k;
+                moved_nodes.clear();
+            } else {
+                std::vector<IDX> merged{};
+                std::vector<IDX> selected(geo_map.selected_nodes.begin(), geo_map.selected_nodes.end());
+                std::ranges::sort(selected);
+                std::ranges::set_union(moved_nodes, selected, std::back_inserter(merged));
+                moved_nodes = std::move(merged);
+                impl::write_restart_file(fespace, u, std::span<const IDX>{moved_nodes},
+                        restart_directory / ("restart" + std::to_string(k) + ".delta.bin"), std::optional{base_k});
+            }
+        }
+    };
 }
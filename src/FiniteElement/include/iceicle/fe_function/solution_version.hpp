@@ -0,0 +1,84 @@
+/**
+ * @brief identify the state of a solution and mesh
+ * so that results computed from them (i.e residuals) can be reused
+ * when neither has changed
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/fe_function/fespan.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+namespace iceicle {
+
+    /**
+     * @brief the version of a solution on a mesh
+     *
+     * The solution generation is a fingerprint of the coefficients
+     * (fespans are views so no write to the data can be tracked),
+     * the mesh generation is AbstractMesh::coord_version.
+     * Two versions compare equal only if both were taken from the same storage
+     */
+    struct solution_version {
+        /// @brief the storage the solution was read from (nullptr: unversioned, never matches)
+        const void* data = nullptr;
+
+        /// @brief the number of coefficients
+        std::size_t size = 0;
+
+        /// @brief fingerprint of the coefficient values
+        std::uint64_t u_generation = 0;
+
+        /// @brief the coord_version of the mesh
+        std::size_t coord_generation = 0;
+
+        /// @brief true if this version can match another
+        [[nodiscard]] auto versioned() const noexcept -> bool { return data != nullptr; }
+
+        friend auto operator==(const solution_version& a, const solution_version& b) noexcept -> bool {
+            return a.versioned() && a.data == b.data && a.size == b.size
+                && a.u_generation == b.u_generation && a.coord_generation == b.coord_generation;
+        }
+    };
+
+    /**
+     * @brief a 64 bit fingerprint of the bit patterns of the given values
+     * one multiply and xor per word so is cheap compared to any evaluation it is used to skip
+     */
+    template<class T>
+    [[nodiscard]] inline auto data_fingerprint(std::span<const T> values) noexcept -> std::uint64_t {
+        static_assert(std::is_trivially_copyable_v<T>);
+        std::uint64_t h = 0xcbf29ce484222325ull ^ values.size();
+        const std::byte* bytes = reinterpret_cast<const std::byte*>(values.data());
+        std::size_t nbytes = values.size_bytes();
+        std::size_t iword = 0;
+        for(; iword + sizeof(std::uint64_t) <= nbytes; iword += sizeof(std::uint64_t)){
+            std::uint64_t w;
+            std::memcpy(&w, bytes + iword, sizeof(w));
+            h = (h ^ w) * 0x100000001b3ull;
+            h ^= h >> 29;
+        }
+        for(; iword < nbytes; ++iword) h = (h ^ static_cast<std::uint64_t>(bytes[iword])) * 0x100000001b3ull;
+        return h;
+    }
+
+    /**
+     * @brief get the version of a solution
+     * @param u the solution (unversioned unless it uses the default accessor)
+     * @param coord_generation the coord_version of the mesh
+     */
+    template<class T, class LayoutPolicy, class AccessorPolicy>
+    [[nodiscard]] auto get_solution_version(fespan<T, LayoutPolicy, AccessorPolicy> u, std::size_t coord_generation)
+    -> solution_version {
+        if constexpr (std::is_same_v<AccessorPolicy, default_accessor<T>>) {
+            std::span<const T> values{u.data(), u.size()};
+            return solution_version{u.data(), u.size(), data_fingerprint(values), coord_generation};
+        } else {
+            return solution_version{};
+        }
+    }
+}
@@ -10,18 +10,33 @@
 
 #include "iceicle/basis/basis.hpp"
 #include "iceicle/crs.hpp"
+#include "iceicle/flat_map.hpp"
+#include "iceicle/graph_coloring.hpp"
+#include "iceicle/memory_report.hpp"
 #include "iceicle/element/finite_element.hpp"
+#include "iceicle/element/ddg_trace_factors.hpp"
+#include "iceicle/element/geometric_factors.hpp"
 #include <iceicle/element/reference_element.hpp>
 #include "iceicle/fe_definitions.hpp"
 #include "iceicle/fe_function/dglayout.hpp"
 #include "iceicle/fe_function/cg_map.hpp"
+#include "iceicle/fespace/kernel_registry.hpp"
 #include "iceicle/geometry/face.hpp"
 #include "iceicle/geometry/geo_element.hpp"
 #include "iceicle/quadrature/QuadratureRule.hpp"
+#include "iceicle/transformations/HypercubeTransformations.hpp"
+#include "iceicle/transformations/SimplexElementTransformation.hpp"
+#include "iceicle/build_config.hpp"
+#include "iceicle/profiler.hpp"
+#include "iceicle/thread_utils.hpp"
 #include <iceicle/mesh/mesh.hpp>
 #include <iceicle/tmp_utils.hpp>
 #include <Numtool/tmp_flow_control.hpp>
-#include <map>
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <memory>
+#include <span>
 #include <type_traits>
 
 #ifdef ICEICLE_USE_MPI 
@@ -44,10 +59,15 @@ namespace iceicle {
 
         FESPACE_ENUMS::FESPACE_BASIS_TYPE btype;
 
+        /// @brief the number of 1D quadrature points added to (or removed from) the exact rule
+        /// (see quadrature_npoints_1d)
+        int quadrature_shift = 0;
 
         friend bool operator<(const FETypeKey &l, const FETypeKey &r){
             using namespace FESPACE_ENUMS;
-            if(l.qtype != r.qtype){
+            if(l.quadrature_shift != r.quadrature_shift){
+                return l.quadrature_shift < r.quadrature_shift;
+            } else if(l.qtype != r.qtype){
                 return (int) l.qtype < (int) r.qtype;
             } else if(l.btype != r.btype){
                 return (int) l.btype < (int) r.btype;
@@ -62,6 +82,8 @@ namespace iceicle {
                 return false;
             }
         }
+
+        friend bool operator==(const FETypeKey &l, const FETypeKey &r) = default;
     };
 
     /**
@@ -90,6 +112,9 @@ namespace iceicle {
 
         unsigned int face_info_r;
 
+        /// @brief the number of 1D quadrature points added to (or removed from) the exact rule
+        int quadrature_shift = 0;
+
         auto operator <=>(const TraceTypeKey&) const = default;
     };
 
@@ -150,18 +175,48 @@ namespace iceicle {
         /** @brief maps local dofs to global dofs for cg space */
         cg_dof_map<T, IDX, ndim> cg_map;
 
-        /** @brief the mapping of faces connected to each node */
-        util::crs<IDX> fac_surr_nodes;
+        /** @brief the mapping of faces connected to each node (built on first use) */
+        auto fac_surr_nodes() const -> const util::crs<IDX>& 
+        { return _fac_surr_nodes.get([this]{ return build_fac_surr_nodes(); }); }
 
-        /** @brief the mapping of elements connected to each node */
-        util::crs<IDX, IDX> el_surr_nodes;
+        /** @brief the mapping of elements connected to each node (built on first use) */
+        auto el_surr_nodes() const -> const util::crs<IDX, IDX>& 
+        { return _el_surr_nodes.get([this]{ return build_el_surr_nodes(); }); }
 
-        /** @brief the mapping of faces connected to each element */
-        util::crs<IDX> fac_surr_el;
+        /** @brief the mapping of faces connected to each element (built on first use) */
+        auto fac_surr_el() const -> const util::crs<IDX>& 
+        { return _fac_surr_el.get([this]{ return build_fac_surr_el(); }); }
+
+        /// @brief free the connectivity matrices (they are built again on the next use)
+        auto release_connectivity() -> void {
+            _fac_surr_nodes.reset();
+            _el_surr_nodes.reset();
+            _fac_surr_el.reset();
+        }
 
         /// @brief element information recieved from each respective MPI rank
         std::vector<std::vector<ElementType>> comm_elements;
 
+        /// @brief coloring of the interior traces such that no two traces of the same color
+        /// share an element (for conflict free parallel assembly)
+        /// each row is a color and the entries are indices into traces
+        util::crs<IDX, IDX> interior_trace_colors;
+
+        /// @brief the elements grouped by FETypeKey so that kernels can be specialized per batch
+        /// each row is a batch and the entries are indices into elements
+        util::crs<IDX, IDX> element_batches;
+
+        /// @brief the FETypeKey shared by all the elements of each batch
+        std::vector<FETypeKey> element_batch_keys;
+
+        /// @brief optional cache of the geometric factors at the quadrature points
+        /// (nullptr until enable_geometric_factors() is called)
+        std::unique_ptr<GeometricFactors<T, IDX, ndim>> geo_factors{};
+
+        /// @brief optional cache of the DDG interface data at the interior trace quadrature points
+        /// (nullptr until enable_ddg_factors() is called)
+        std::unique_ptr<DDGTraceFactors<T, IDX, ndim>> ddg_factors{};
+
         private:
 
         // ========================================
@@ -170,8 +225,389 @@ namespace iceicle {
 
         using ReferenceElementType = ReferenceElement<T, IDX, ndim>;
         using ReferenceTraceType = ReferenceTraceSpace<T, IDX, ndim>;
-        std::map<FETypeKey, ReferenceElementType> ref_el_map;
-        std::map<TraceTypeKey, ReferenceTraceType> ref_trace_map;
+        util::small_flat_map<FETypeKey, ReferenceElementType> ref_el_map;
+        util::small_flat_map<TraceTypeKey, ReferenceTraceType> ref_trace_map;
+
+        // connectivity that is only needed by some solvers (i.e not explicit DG)
+        // so it is built on first use
+        util::lazy_value<util::crs<IDX>> _fac_surr_nodes;
+        util::lazy_value<util::crs<IDX, IDX>> _el_surr_nodes;
+        util::lazy_value<util::crs<IDX>> _fac_surr_el;
+
+        /// @brief the quadrature type of the traces
+        FESPACE_ENUMS::FESPACE_QUADRATURE trace_quadrature_type = FESPACE_ENUMS::FESPACE_QUADRATURE::GAUSS_LEGENDRE;
+
+        /// @brief the requested shift of the element and trace quadrature rules (see set_quadrature_shifts)
+        int volume_quadrature_shift = 0;
+        int trace_quadrature_shift = 0;
+
+        /// @brief create the reference trace space for a face, the left and right basis, the geometry order,
+        /// and the quadrature shift
+        /// (captures the compile time basis order of the constructor so traces can be rebuilt after construction)
+        std::function<ReferenceTraceType(const GeoFaceType*, const BasisType&, const BasisType&, int, int)> ref_trace_factory{};
+
+        /// @brief the color of each interior trace (indexed from interior_trace_start)
+        std::vector<IDX> interior_trace_color{};
+
+        /// @brief derived data is stored compactly (see compact())
+        bool compact_mode = false;
+
+        /// @brief create the reference trace space for a face
+        /// the trace quadrature is for the higher basis order of the two sides
+        static auto make_reference_trace(const GeoFaceType* fac, FESPACE_ENUMS::FESPACE_BASIS_TYPE basis_type,
+                FESPACE_ENUMS::FESPACE_QUADRATURE quadrature_type,
+                const BasisType& basisL, const BasisType& basisR, int geo_order,
+                int quadrature_shift) -> ReferenceTraceType {
+            ReferenceTraceType ref_trace{};
+            int trace_order = std::max(basisL.getPolynomialOrder(), basisR.getPolynomialOrder());
+            NUMTOOL::TMP::invoke_at_index(
+                NUMTOOL::TMP::make_range_sequence<int, 0, build_config::FESPACE_BUILD_PN>{}, trace_order,
+                [&]<int basis_order>() -> int {
+                    NUMTOOL::TMP::invoke_at_index(
+                        NUMTOOL::TMP::make_range_sequence<int, 1, MAX_DYNAMIC_ORDER>{}, geo_order,
+                        [&]<int order>() -> int {
+                            ref_trace = ReferenceTraceType(fac, basis_type, quadrature_type, basisL, basisR,
+                                std::integral_constant<int, basis_order>{}, std::integral_constant<int, order>{},
+                                quadrature_shift);
+                            return 0;
+                        });
+                    return 0;
+                });
+            return ref_trace;
+        }
+
+        /// @brief get the reference element for a type key (creating it if it does not exist yet)
+        auto get_reference_element(const FETypeKey& fe_key) -> ReferenceElementType& {
+            return ref_el_map.get_or_emplace(fe_key, [&]{
+                ReferenceElementType ref_el{};
+                NUMTOOL::TMP::invoke_at_index(
+                    NUMTOOL::TMP::make_range_sequence<int, 0, build_config::FESPACE_BUILD_PN>{}, fe_key.basis_order,
+                    [&]<int basis_order>() -> int {
+                        ref_el = ReferenceElementType(fe_key.domain_type, fe_key.geometry_order,
+                                fe_key.btype, fe_key.qtype, tmp::compile_int<basis_order>{}, fe_key.quadrature_shift);
+                        return 0;
+                    });
+                return ref_el;
+            });
+        }
+
+        /// @brief point a finite element to a (new) reference element
+        static auto set_reference_element(ElementType& el, ReferenceElementType& ref_el) -> void {
+            el.basis = ref_el.basis.get();
+            el.quadrule = ref_el.quadrule.get();
+            el.qp_evals = std::span<const BasisEvaluation<T, ndim>>{ref_el.evals};
+            el.sum_fact = ref_el.sum_fact.get();
+            el.ref_mass = std::span<const T>{ref_el.ref_mass};
+            el.geo_qp_evals = std::span<const BasisEvaluation<T, ndim>>{ref_el.geo_evals};
+        }
+
+        /// @brief form the element batches from the type key of each element
+        /// the batches are in key order and each batch lists its elements in increasing order
+        /// @param el_keys the type key of each element (must have a reference element)
+        auto build_element_batches(std::span<const FETypeKey> el_keys) -> void {
+            std::vector<FETypeKey> keys{};
+            for(std::size_t ikey = 0; ikey < ref_el_map.size(); ++ikey) keys.push_back(ref_el_map.key_at(ikey));
+            std::sort(keys.begin(), keys.end());
+
+            // the elements of each key as the transpose of the key of each element
+            util::crs<IDX, IDX> el_key_idxs = util::make_crs<IDX, IDX>(el_keys.size(), [](IDX){ return 1; },
+                [&](IDX iel, std::span<IDX> row){ row[0] = std::ranges::find(keys, el_keys[iel]) - keys.begin(); });
+            util::crs<IDX, IDX> key_elements = util::transpose_crs(el_key_idxs, keys.size());
+
+            // only the keys with elements form batches
+            std::vector<IDX> nonempty{};
+            element_batch_keys.clear();
+            for(IDX ikey = 0; ikey < (IDX) keys.size(); ++ikey) if(key_elements.rowsize(ikey) > 0) {
+                nonempty.push_back(ikey);
+                element_batch_keys.push_back(keys[ikey]);
+            }
+            element_batches = util::make_crs<IDX, IDX>(nonempty.size(),
+                [&](IDX ibatch){ return key_elements.rowsize(nonempty[ibatch]); },
+                [&](IDX ibatch, std::span<IDX> row){ std::ranges::copy(key_elements.rowspan(nonempty[ibatch]), row.begin()); });
+        }
+
+        /**
+         * @brief generate the finite elements for the elements of the mesh
+         * The type keys and affine checks are computed in parallel and
+         * the reference elements are only created once for each distinct key
+         *
+         * @param make_key make_key(geo_trans) -> FETypeKey of the element with the given transformation
+         * @param make_ref make_ref(fe_key) -> ReferenceElementType for a key
+         */
+        template<class KeyF, class RefF>
+        auto build_elements(KeyF&& make_key, RefF&& make_ref) -> void {
+            ICEICLE_PROFILE_REGION("fespace_elements");
+            const std::size_t nelem = meshptr->nelem();
+            std::vector<FETypeKey> el_keys(nelem);
+            std::vector<char> affine(nelem);
+            util::parallel_for(nelem, [&](std::size_t iel){
+                el_keys[iel] = make_key(meshptr->el_transformations[iel]);
+                affine[iel] = ElementType::affine_transformation(
+                        meshptr->el_transformations[iel], meshptr->coord_els.rowspan(iel));
+            });
+
+            // the reference element of each element (consecutive elements usually share a key)
+            std::vector<ReferenceElementType*> ref_els(nelem);
+            for(std::size_t iel = 0; iel < nelem; ++iel){
+                if(iel > 0 && el_keys[iel] == el_keys[iel - 1]) {
+                    ref_els[iel] = ref_els[iel - 1];
+                } else {
+                    ref_els[iel] = &ref_el_map.get_or_emplace(el_keys[iel], [&]{ return make_ref(el_keys[iel]); });
+                }
+            }
+
+            elements.clear();
+            elements.reserve(nelem);
+            for(IDX ielem = 0; ielem < (IDX) nelem; ++ielem){
+                ReferenceElementType &ref_el = *ref_els[ielem];
+                elements.push_back(ElementType{
+                    .trans = meshptr->el_transformations[ielem], 
+                    .basis = ref_el.basis.get(),
+                    .quadrule = ref_el.quadrule.get(),
+                    .qp_evals = std::span<const BasisEvaluation<T, ndim>>{ref_el.evals},
+                    .inodes = meshptr->conn_el.rowspan(ielem), // NOTE: meshptr cannot invalidate anymore
+                    .coord_el = meshptr->coord_els.rowspan(ielem),
+                    .elidx = ielem,
+                    .affine = (bool) affine[ielem],
+                    .sum_fact = ref_el.sum_fact.get(),
+                    .ref_mass = std::span<const T>{ref_el.ref_mass},
+                    .geo_qp_evals = std::span<const BasisEvaluation<T, ndim>>{ref_el.geo_evals}
+                });
+            }
+            build_element_batches(el_keys);
+        }
+
+        /// @brief color the interior traces by the elements they touch
+        auto color_interior_traces() -> void {
+            IDX ninterior = interior_trace_end - interior_trace_start;
+            interior_trace_colors = util::greedy_coloring(ninterior, (IDX) elements.size(),
+                [this](IDX iitrace) -> std::array<IDX, 2> {
+                    const TraceType& trace = traces[interior_trace_start + iitrace];
+                    return std::array<IDX, 2>{trace.elL.elidx, trace.elR.elidx};
+                });
+            interior_trace_color.assign(ninterior, 0);
+            for(IDX icolor = 0; icolor < interior_trace_colors.nrow(); ++icolor){
+                for(IDX& itrace : interior_trace_colors.rowspan(icolor)) { 
+                    interior_trace_color[itrace] = icolor;
+                    itrace += interior_trace_start;
+                }
+            }
+        }
+
+        /// @brief move an interior trace to the lowest color that does not conflict 
+        /// with the other traces of its elements
+        /// @param itrace the index of the trace in traces
+        auto recolor_interior_trace(IDX itrace) -> void {
+            const TraceType& trace = traces[itrace];
+            IDX icolor_old = interior_trace_color[itrace - interior_trace_start];
+
+            // colors taken by the other interior traces of the two elements
+            std::vector<IDX> taken{};
+            for(IDX iel : {trace.elL.elidx, trace.elR.elidx}){
+                for(IDX jtrace : fac_surr_el().rowspan(iel)){
+                    if(jtrace != itrace && (std::size_t) jtrace >= interior_trace_start 
+                            && (std::size_t) jtrace < interior_trace_end)
+                        taken.push_back(interior_trace_color[jtrace - interior_trace_start]);
+                }
+            }
+            if(std::ranges::find(taken, icolor_old) == taken.end()) return;
+            IDX icolor = 0;
+            while(std::ranges::find(taken, icolor) != taken.end()) ++icolor;
+
+            // remove from the old color
+            std::vector<IDX> old_row{};
+            for(IDX jtrace : interior_trace_colors.rowspan(icolor_old)) if(jtrace != itrace) old_row.push_back(jtrace);
+            interior_trace_colors.replace_row(icolor_old, old_row);
+
+            // add to the new color (adding a color if needed)
+            if((std::size_t) icolor == interior_trace_colors.nrow()){
+                std::vector<std::vector<IDX>> colors_ragged(interior_trace_colors.nrow() + 1);
+                for(IDX jcolor = 0; jcolor < interior_trace_colors.nrow(); ++jcolor){
+                    std::span<const IDX> row = interior_trace_colors.rowspan(jcolor);
+                    colors_ragged[jcolor] = std::vector<IDX>{row.begin(), row.end()};
+                }
+                interior_trace_colors = util::crs<IDX, IDX>{colors_ragged};
+            }
+            std::span<const IDX> row = interior_trace_colors.rowspan(icolor);
+            std::vector<IDX> new_row{row.begin(), row.end()};
+            new_row.insert(std::ranges::lower_bound(new_row, itrace), itrace);
+            interior_trace_colors.replace_row(icolor, new_row);
+            interior_trace_color[itrace - interior_trace_start] = icolor;
+        }
+
+        /// @brief the left and right finite elements of a face 
+        /// (the communicated element for the off process side of a parallel face)
+        /// the elements must already be current
+        auto face_elements(const GeoFaceType* fac) -> std::array<ElementType*, 2> {
+            bool is_interior = fac->bctype == BOUNDARY_CONDITIONS::INTERIOR;
+            ElementType *elptrL = &elements[fac->elemL];
+            ElementType *elptrR = (is_interior) ? &elements[fac->elemR] : &elements[fac->elemL];
+#ifdef ICEICLE_USE_MPI
+            // update the boundary trace spaces to use the new communicated FiniteElements
+            if(fac->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) {
+                auto [jrank, imleft] = decode_mpi_bcflag(fac->bcflag);
+                IDX jlocal_elidx = (imleft) ? fac->elemR : fac->elemL;
+
+                std::vector<IDX> &comm_el_idxs = meshptr->el_recv_list[jrank];
+                auto itr = lower_bound(comm_el_idxs.begin(), comm_el_idxs.end(), jlocal_elidx);
+                std::size_t index = distance(comm_el_idxs.begin(), itr);
+
+                if(imleft){
+                    elptrR = &(comm_elements[jrank].at(index));
+                } else {
+                    elptrL = &(comm_elements[jrank].at(index));
+                    elptrR = &elements[fac->elemR]; // special case because parallel faces are essential interior
+                }
+            }
+#endif
+            return {elptrL, elptrR};
+        }
+
+        /// @brief the reference trace type of a face between the given elements
+        auto trace_type_key(const GeoFaceType* fac, const ElementType& elL, const ElementType& elR) const 
+        -> TraceTypeKey {
+            int basis_order_trace = std::max(elL.basis->getPolynomialOrder(), elR.basis->getPolynomialOrder());
+            int geometry_order = std::max(elL.trans->order, elR.trans->order);
+            return TraceTypeKey{ 
+                .basis_order_l = elL.basis->getPolynomialOrder(),
+                .basis_order_r = elR.basis->getPolynomialOrder(),
+                .basis_order_trace = basis_order_trace, 
+                .geometry_order = geometry_order,
+                .domain_type = fac->domain_type(),
+                .qtype = trace_quadrature_type,
+                .face_info_l = fac->face_infoL,
+                .face_info_r = fac->face_infoR,
+                .quadrature_shift = effective_quadrature_shift(trace_quadrature_type, basis_order_trace,
+                        geometry_order, trace_quadrature_shift)
+            };
+        }
+
+        /// @brief get the reference trace for a type key (creating it for the given face if it does not exist yet)
+        auto get_reference_trace(const TraceTypeKey& trace_key, const GeoFaceType* fac,
+                const ElementType& elL, const ElementType& elR) -> ReferenceTraceType& {
+            return ref_trace_map.get_or_emplace(trace_key, [&]{
+                ReferenceTraceType ref_trace = ref_trace_factory(fac, *(elL.basis), *(elR.basis), 
+                        trace_key.geometry_order, trace_key.quadrature_shift);
+                ref_trace.build_geometry_evals(elL.trans, elR.trans);
+                return ref_trace;
+            });
+        }
+
+        /// @brief create the trace space for a face 
+        static auto make_trace(const GeoFaceType* fac, ElementType& elL, ElementType& elR,
+                const ReferenceTraceType& ref_trace, IDX ifac) -> TraceType {
+            // parallel bdy faces are essentially also interior faces 
+            // aside from being a bit *special* :3
+            TraceType trace = (fac->bctype == BOUNDARY_CONDITIONS::INTERIOR 
+                    || fac->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM)
+                ? TraceType(fac, &elL, &elR, ref_trace.trace_basis.get(),
+                    ref_trace.quadrule.get(),
+                    std::span<const BasisEvaluation<T, ndim>>{ref_trace.evals_l},
+                    std::span<const BasisEvaluation<T, ndim>>{ref_trace.evals_r},
+                    ifac, ref_trace.qp_xi_l, ref_trace.qp_xi_r)
+                : TraceType::make_bdy_trace_space(
+                    fac, &elL, ref_trace.trace_basis.get(), 
+                    ref_trace.quadrule.get(), 
+                    std::span<const BasisEvaluation<T, ndim>>{ref_trace.evals_l},
+                    std::span<const BasisEvaluation<T, ndim>>{ref_trace.evals_r},
+                    ifac, ref_trace.qp_xi_l, ref_trace.qp_xi_r);
+
+            // the geometry tables are only valid for the element transformations they were built for
+            if(ref_trace.geo_trans_l == trace.elL.trans)
+                trace.geo_evals_l = std::span<const BasisEvaluation<T, ndim>>{ref_trace.geo_evals_l};
+            if(ref_trace.geo_trans_r == trace.elR.trans)
+                trace.geo_evals_r = std::span<const BasisEvaluation<T, ndim>>{ref_trace.geo_evals_r};
+            return trace;
+        }
+
+        /// @brief rebuild the trace for a face of the mesh in place
+        /// the face must keep its index and the elements must already be current
+        /// @param ifac the face index (and trace index)
+        auto rebuild_trace(IDX ifac) -> void {
+            const GeoFaceType* fac = meshptr->faces[ifac].get();
+            auto [elptrL, elptrR] = face_elements(fac);
+            ReferenceTraceType &ref_trace = get_reference_trace(trace_type_key(fac, *elptrL, *elptrR), fac, *elptrL, *elptrR);
+
+            // traces hold references so they are replaced by constructing in place
+            TraceType* trace_ptr = &traces[ifac];
+            std::destroy_at(trace_ptr);
+            std::construct_at(trace_ptr, make_trace(fac, *elptrL, *elptrR, ref_trace, ifac));
+            traces[ifac].geo_factors = geo_factors.get();
+            traces[ifac].ddg_factors = ddg_factors.get();
+            traces[ifac].offset_r = meshptr->periodic_offset(ifac);
+        }
+
+        /**
+         * @brief generate the trace spaces for the faces of the mesh
+         * The elements and type keys of each face are found in parallel and
+         * the reference traces are only created once for each distinct key
+         */
+        auto build_traces() -> void {
+            ICEICLE_PROFILE_REGION("fespace_traces");
+
+            // the mesh faces are final at this point so make the compact face table current
+            meshptr->update_face_table();
+
+            const std::size_t nfac = meshptr->faces.size();
+            std::vector<std::array<ElementType*, 2>> fac_els(nfac);
+            std::vector<TraceTypeKey> trace_keys(nfac);
+            util::parallel_for(nfac, [&](std::size_t ifac){
+                const GeoFaceType* fac = meshptr->faces[ifac].get();
+                fac_els[ifac] = face_elements(fac);
+                trace_keys[ifac] = trace_type_key(fac, *fac_els[ifac][0], *fac_els[ifac][1]);
+            });
+
+            traces.clear();
+            traces.reserve(nfac);
+            for(std::size_t ifac = 0; ifac < nfac; ++ifac){
+                const GeoFaceType* fac = meshptr->faces[ifac].get();
+                ReferenceTraceType &ref_trace = get_reference_trace(trace_keys[ifac], fac, *fac_els[ifac][0], *fac_els[ifac][1]);
+                traces.push_back(make_trace(fac, *fac_els[ifac][0], *fac_els[ifac][1], ref_trace, (IDX) ifac));
+            }
+            for(IDX ifac : meshptr->periodic_faces) traces[ifac].offset_r = meshptr->periodic_offset(ifac);
+
+            // reuse the face indexing from the mesh
+            interior_trace_start = meshptr->interiorFaceStart;
+            interior_trace_end = meshptr->interiorFaceEnd;
+            bdy_trace_start = meshptr->bdyFaceStart;
+            bdy_trace_end = meshptr->bdyFaceEnd;
+        }
+
+        /// @brief build the connectivity of faces to nodes 
+        /// as the transpose of the nodes of each face
+        auto build_fac_surr_nodes() const -> util::crs<IDX> {
+            ICEICLE_PROFILE_REGION("fespace_fac_surr_nodes");
+            util::crs<IDX> trace_nodes = util::make_crs<IDX, std::size_t>(traces.size(),
+                [&](IDX itrace){ return traces[itrace].face->nodes_span().size(); },
+                [&](IDX itrace, std::span<IDX> row){ std::ranges::copy(traces[itrace].face->nodes_span(), row.begin()); });
+            return util::transpose_crs(trace_nodes, meshptr->n_nodes());
+        }
+
+        /// @brief build the connectivity of elements to nodes
+        auto build_el_surr_nodes() const -> util::crs<IDX, IDX> {
+            ICEICLE_PROFILE_REGION("fespace_el_surr_nodes");
+            return util::crs<IDX, IDX>{meshptr->elsup};
+        }
+
+        /// @brief build the connectivity of faces to elements
+        /// as the transpose of the elements of each face
+        auto build_fac_surr_el() const -> util::crs<IDX> {
+            ICEICLE_PROFILE_REGION("fespace_fac_surr_el");
+            auto trace_elements = [&](IDX itrace) -> std::array<IDX, 2> {
+                const TraceType& trace = traces[itrace];
+                if(trace.face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM){
+                    // take some extra care to not add the wrong element index
+                    auto [jrank, imleft] = decode_mpi_bcflag(trace.face->bcflag);
+                    return {imleft ? trace.elL.elidx : trace.elR.elidx, -1};
+                } else {
+                    return {trace.elL.elidx, trace.elR.elidx};
+                }
+            };
+            util::crs<IDX> trace_els = util::make_crs<IDX, std::size_t>(traces.size(),
+                [&](IDX itrace){ return (trace_elements(itrace)[1] == -1) ? 1 : 2; },
+                [&](IDX itrace, std::span<IDX> row){ std::ranges::copy_n(trace_elements(itrace).begin(), row.size(), row.begin()); });
+            return util::transpose_crs(trace_els, elements.size());
+        }
 
         public:
 
@@ -192,6 +628,9 @@ namespace iceicle {
          *
          * @tparam basis_order the polynomial order of 1D basis functions
          *
+         * NOTE: periodic boundaries are interior traces only if the mesh faces were joined 
+         * beforehand with make_periodic_faces_interior() (MeshCache meshes already are)
+         *
          * @param meshptr pointer to the mesh 
          * @param basis_type enumeration of what basis to use 
          * @param quadrature_type enumeration of what quadrature rule to use 
@@ -205,42 +644,29 @@ namespace iceicle {
             tmp::compile_int<basis_order> basis_order_arg
         ) : type{SPACE_TYPE::L2}, meshptr(meshptr), cg_map{*meshptr}, elements{} {
 
-            // Generate the Finite Elements
-            elements.reserve(meshptr->nelem());
-            for(ElementTransformation<T, IDX, ndim>* geo_trans : meshptr->el_transformations){
-                // create the Element Domain type key
-                FETypeKey fe_key = {
-                    .domain_type = geo_trans->domain_type,
-                    .basis_order = basis_order,
-                    .geometry_order = geo_trans->order,
-                    .qtype = quadrature_type,
-                    .btype = basis_type
-                };
-
-                // check if an evaluation doesn't exist yet
-                if(ref_el_map.find(fe_key) == ref_el_map.end()){
-                    ref_el_map[fe_key] = ReferenceElementType(geo_trans->domain_type, geo_trans->order, basis_type, quadrature_type, basis_order_arg);
-                }
-                ReferenceElementType &ref_el = ref_el_map[fe_key];
-
-                // this will be the index of the new element
-                IDX ielem = elements.size();
-
-                // create the finite element
-                ElementType fe{
-                    .trans = geo_trans, 
-                    .basis = ref_el.basis.get(),
-                    .quadrule = ref_el.quadrule.get(),
-                    .qp_evals = std::span<const BasisEvaluation<T, ndim>>{ref_el.evals},
-                    .inodes = meshptr->conn_el.rowspan(ielem), // NOTE: meshptr cannot invalidate anymore
-                    .coord_el = meshptr->coord_els.rowspan(ielem),
-                    .elidx = ielem
-                };
+            trace_quadrature_type = quadrature_type;
+            ref_trace_factory = [basis_type, quadrature_type](const GeoFaceType* fac,
+                    const BasisType& basisL, const BasisType& basisR, int geo_order, int quadrature_shift) {
+                return make_reference_trace(fac, basis_type, quadrature_type, basisL, basisR, geo_order, quadrature_shift);
+            };
 
-                // add to the elements list
-                elements.push_back(fe);
-            }
+            ICEICLE_PROFILE_REGION("fespace_setup");
 
+            // Generate the Finite Elements
+            build_elements(
+                [&](const ElementTransformation<T, IDX, ndim>* geo_trans) -> FETypeKey {
+                    return FETypeKey{
+                        .domain_type = geo_trans->domain_type,
+                        .basis_order = basis_order,
+                        .geometry_order = geo_trans->order,
+                        .qtype = quadrature_type,
+                        .btype = basis_type
+                    };
+                },
+                [&](const FETypeKey& fe_key){
+                    return ReferenceElementType(fe_key.domain_type, fe_key.geometry_order,
+                            basis_type, quadrature_type, basis_order_arg);
+                });
 
 #ifdef ICEICLE_USE_MPI
             // ========================
@@ -268,11 +694,10 @@ namespace iceicle {
                     };
 
                     // check if an evaluation doesn't exist yet
-                    if(ref_el_map.find(fe_key) == ref_el_map.end()){
-                        ref_el_map[fe_key] = ReferenceElementType(geo_el_info.trans->domain_type,
+                    ReferenceElementType &ref_el = ref_el_map.get_or_emplace(fe_key, [&]{
+                        return ReferenceElementType(geo_el_info.trans->domain_type,
                                 geo_el_info.trans->order, basis_type, quadrature_type, basis_order_arg);
-                    }
-                    ReferenceElementType &ref_el = ref_el_map[fe_key];
+                    });
                 
                     // create the finite element
                     ElementType fe(
@@ -282,8 +707,10 @@ namespace iceicle {
                         std::span<const BasisEvaluation<T, ndim>>{ref_el.evals},
                         geo_el_info.conn_el,
                         geo_el_info.coord_el,
-                        elements.size() // this will be the index of the new element
+                        elements.size(), // this will be the index of the new element
+                        ref_el.sum_fact.get()
                     );
+                    fe.geo_qp_evals = std::span<const BasisEvaluation<T, ndim>>{ref_el.geo_evals};
 
                     comm_elements[irank].push_back(fe);
                 }
@@ -291,170 +718,51 @@ namespace iceicle {
 #endif
 
             // Generate the Trace Spaces
-            traces.reserve(meshptr->faces.size());
-            for(const auto& fac : meshptr->faces){
-                // NOTE: assuming element indexing is the same as the mesh still
-
-                bool is_interior = fac->bctype == BOUNDARY_CONDITIONS::INTERIOR;
-                ElementType *elptrL = &elements[fac->elemL];
-                ElementType *elptrR = (is_interior) ? &elements[fac->elemR] : &elements[fac->elemL];
-
-#ifdef ICEICLE_USE_MPI
-            // update the boundary trace spaces to use the new communicated FiniteElements
-                if(fac->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) {
-                    auto [jrank, imleft] = decode_mpi_bcflag(fac->bcflag);
-                    IDX jlocal_elidx = (imleft) ? fac->elemR : fac->elemL;
-
-                    std::vector<IDX> &comm_el_idxs = meshptr->el_recv_list[jrank];
-                    auto itr = lower_bound(comm_el_idxs.begin(), comm_el_idxs.end(), jlocal_elidx);
-                    std::size_t index = distance(comm_el_idxs.begin(), itr);
-
-                    if(imleft){
-                        elptrR = &(comm_elements[jrank].at(index));
-                    } else {
-                        elptrL = &(comm_elements[jrank].at(index));
-                        elptrR = &elements[fac->elemR]; // special case because parallel faces are essential interior
-                    }
-                }
-#endif
-                ElementType& elL = *elptrL;
-                ElementType& elR = *elptrR;
-
-                int geo_order = std::max(elL.trans->order, elR.trans->order);
-
-                auto geo_order_dispatch = [&]<int geo_order>() -> int{
-                    TraceTypeKey trace_key = { 
-                        .basis_order_l = elL.basis->getPolynomialOrder(),
-                        .basis_order_r = elR.basis->getPolynomialOrder(),
-                        .basis_order_trace = std::max(elL.basis->getPolynomialOrder(), elR.basis->getPolynomialOrder()), 
-                        .geometry_order = geo_order,
-                        .domain_type = fac->domain_type(),
-                        .qtype = quadrature_type,
-                        .face_info_l = fac->face_infoL,
-                        .face_info_r = fac->face_infoR
-                    };
-
-                    if(ref_trace_map.find(trace_key) == ref_trace_map.end()){
-                        ref_trace_map[trace_key] = ReferenceTraceType(fac.get(),
-                            basis_type, quadrature_type, 
-                            *(elL.basis), *(elR.basis),
-                            std::integral_constant<int, basis_order>{},
-                            std::integral_constant<int, geo_order>{});
-                    }
-                    ReferenceTraceType &ref_trace = ref_trace_map[trace_key];
-                    
-                    if(is_interior || fac->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM){
-                        // parallel bdy faces are essentially also interior faces 
-                        // aside from being a bit *special* :3
-                        TraceType trace{ fac.get(), &elL, &elR, ref_trace.trace_basis.get(),
-                            ref_trace.quadrule.get(),
-                            std::span<const BasisEvaluation<T, ndim>>{ref_trace.evals_l},
-                            std::span<const BasisEvaluation<T, ndim>>{ref_trace.evals_r},
-                            (IDX) traces.size() };
-                        traces.push_back(trace);
-                    } else {
-                        TraceType trace = TraceType::make_bdy_trace_space(
-                            fac.get(), &elL, ref_trace.trace_basis.get(), 
-                            ref_trace.quadrule.get(), 
-                            std::span<const BasisEvaluation<T, ndim>>{ref_trace.evals_l},
-                            std::span<const BasisEvaluation<T, ndim>>{ref_trace.evals_r},
-                            (IDX) traces.size());
-                        traces.push_back(trace);
-                    }
-
-                    return 0;
-                };
-
-                NUMTOOL::TMP::invoke_at_index(
-                    NUMTOOL::TMP::make_range_sequence<int, 1, MAX_DYNAMIC_ORDER>{},
-                    geo_order,
-                    geo_order_dispatch                    
-                );
-            }
-            // reuse the face indexing from the mesh
-            interior_trace_start = meshptr->interiorFaceStart;
-            interior_trace_end = meshptr->interiorFaceEnd;
-            bdy_trace_start = meshptr->bdyFaceStart;
-            bdy_trace_end = meshptr->bdyFaceEnd;
+            build_traces();
 
             // generate the dof offsets 
             dg_map = dg_dof_map{elements};
 
-            // ===================================
-            // = Build the connectivity matrices =
-            // ===================================
-
-            // generate the face surrounding nodes connectivity matrix 
-            std::vector<std::vector<IDX>> connectivity_ragged(meshptr->n_nodes());
-            for(int itrace = 0; itrace < traces.size(); ++itrace){
-                const TraceType& trace = traces[itrace];
-                for(IDX inode : trace.face->nodes_span()){
-                    connectivity_ragged[inode].push_back(itrace);
-                }
-            }
-            fac_surr_nodes = util::crs{connectivity_ragged};
-
-            el_surr_nodes = util::crs{meshptr->elsup};
-
-            std::vector<std::vector<IDX>> fac_surr_el_ragged(elements.size());
-            for(int itrace = 0; itrace < traces.size(); ++itrace) {
-                const TraceType& trace = traces[itrace];
-                if(trace.face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM){
-                    // take some extra care to not add the wrong element index
-                    auto [jrank, imleft] = decode_mpi_bcflag(trace.face->bcflag);
-                    if(imleft){
-                        fac_surr_el_ragged[trace.elL.elidx].push_back(itrace);
-                    } else {
-                        fac_surr_el_ragged[trace.elR.elidx].push_back(itrace);
-                    }
-                } else {
-                    fac_surr_el_ragged[trace.elL.elidx].push_back(itrace);
-                    fac_surr_el_ragged[trace.elR.elidx].push_back(itrace);
-                }
-            }
-            fac_surr_el = util::crs{fac_surr_el_ragged};
+            // the connectivity matrices are built on first use
+            color_interior_traces();
         } 
 
         /// @brief construct an FESpace that represents an isoparametric CG space
         /// to the given mesh 
+        /// NOTE: join the periodic faces of the mesh first (see make_periodic_faces_interior())
         /// @param meshptr pointer to the mesh
         FESpace(MeshType *meshptr) : type{SPACE_TYPE::ISOPARAMETRIC_H1}, meshptr(meshptr), cg_map{*meshptr}, elements{} {
+
+            ref_trace_factory = [](const GeoFaceType* fac,
+                    const BasisType& basisL, const BasisType& basisR, int geo_order, int) {
+                ReferenceTraceType ref_trace{};
+                NUMTOOL::TMP::invoke_at_index(
+                    NUMTOOL::TMP::make_range_sequence<int, 1, MAX_DYNAMIC_ORDER>{}, geo_order,
+                    [&]<int order>() -> int {
+                        ref_trace = ReferenceTraceType(fac, FESPACE_ENUMS::FESPACE_BASIS_TYPE::LAGRANGE,
+                            FESPACE_ENUMS::FESPACE_QUADRATURE::GAUSS_LEGENDRE, basisL, basisR,
+                            std::integral_constant<int, order>{}, std::integral_constant<int, order>{});
+                        return 0;
+                    });
+                return ref_trace;
+            };
             
-            // Generate the Finite Elements
-            elements.reserve(meshptr->nelem());
-            for(ElementTransformation<T, IDX, ndim>* geo_trans : meshptr->el_transformations){
-                // create the Element Domain type key
-                FETypeKey fe_key = {
-                    .domain_type = geo_trans->domain_type,
-                    .basis_order = geo_trans->order,
-                    .geometry_order = geo_trans->order,
-                    .qtype = FESPACE_ENUMS::FESPACE_QUADRATURE::GAUSS_LEGENDRE,
-                    .btype = FESPACE_ENUMS::FESPACE_BASIS_TYPE::LAGRANGE 
-                };
-
-                // check if an evaluation doesn't exist yet
-                if(ref_el_map.find(fe_key) == ref_el_map.end()){
-                    ref_el_map[fe_key] = ReferenceElementType(geo_trans->domain_type, geo_trans->order);
-                }
-                ReferenceElementType &ref_el = ref_el_map[fe_key];
-               
-                // this will be the index of the new element
-                IDX ielem = elements.size();
-
-                // create the finite element
-                ElementType fe{
-                    .trans = geo_trans, 
-                    .basis = ref_el.basis.get(),
-                    .quadrule = ref_el.quadrule.get(),
-                    .qp_evals = std::span<const BasisEvaluation<T, ndim>>{ref_el.evals},
-                    .inodes = meshptr->conn_el.rowspan(ielem), // NOTE: meshptr cannot invalidate anymore
-                    .coord_el = meshptr->coord_els.rowspan(ielem),
-                    .elidx = ielem
-                };
+            ICEICLE_PROFILE_REGION("fespace_setup");
 
-                // add to the elements list
-                elements.push_back(fe);
-            }
+            // Generate the Finite Elements
+            build_elements(
+                [](const ElementTransformation<T, IDX, ndim>* geo_trans) -> FETypeKey {
+                    return FETypeKey{
+                        .domain_type = geo_trans->domain_type,
+                        .basis_order = geo_trans->order,
+                        .geometry_order = geo_trans->order,
+                        .qtype = FESPACE_ENUMS::FESPACE_QUADRATURE::GAUSS_LEGENDRE,
+                        .btype = FESPACE_ENUMS::FESPACE_BASIS_TYPE::LAGRANGE 
+                    };
+                },
+                [](const FETypeKey& fe_key){
+                    return ReferenceElementType(fe_key.domain_type, fe_key.geometry_order);
+                });
 
 #ifdef ICEICLE_USE_MPI
             // ========================
@@ -481,10 +789,9 @@ namespace iceicle {
                     };
 
                     // check if an evaluation doesn't exist yet
-                    if(ref_el_map.find(fe_key) == ref_el_map.end()){
-                        ref_el_map[fe_key] = ReferenceElementType(comm_el.trans->domain_type, comm_el.trans->order);
-                    }
-                    ReferenceElementType &ref_el = ref_el_map[fe_key];
+                    ReferenceElementType &ref_el = ref_el_map.get_or_emplace(fe_key, [&]{
+                        return ReferenceElementType(comm_el.trans->domain_type, comm_el.trans->order);
+                    });
                 
                     // this will be the index of the new element
                     IDX ielem = elements.size();
@@ -497,7 +804,8 @@ namespace iceicle {
                         .qp_evals = std::span<const BasisEvaluation<T, ndim>>{ref_el.evals},
                         .inodes = comm_el.conn_el, // NOTE: meshptr cannot invalidate anymore
                         .coord_el = comm_el.coord_el,
-                        .elidx = ielem
+                        .elidx = ielem,
+                        .geo_qp_evals = std::span<const BasisEvaluation<T, ndim>>{ref_el.geo_evals}
                     };
 
                     comm_elements[irank].push_back(fe);
@@ -505,131 +813,13 @@ namespace iceicle {
             }
 #endif
             // Generate the Trace Spaces
-            traces.reserve(meshptr->faces.size());
-            for(const auto& fac : meshptr->faces){
-                // NOTE: assuming element indexing is the same as the mesh still
-
-                bool is_interior = fac->bctype == BOUNDARY_CONDITIONS::INTERIOR;
-                ElementType *elptrL = &elements[fac->elemL];
-                ElementType *elptrR = (is_interior) ? &elements[fac->elemR] : &elements[fac->elemL];
-
-#ifdef ICEICLE_USE_MPI
-            // update the boundary trace spaces to use the new communicated FiniteElements
-                if(fac->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) {
-                    auto [jrank, imleft] = decode_mpi_bcflag(fac->bcflag);
-                    IDX jlocal_elidx = (imleft) ? fac->elemR : fac->elemL;
-
-                    std::vector<IDX> &comm_el_idxs = meshptr->el_recv_list[jrank];
-                    auto itr = lower_bound(comm_el_idxs.begin(), comm_el_idxs.end(), jlocal_elidx);
-                    std::size_t index = distance(comm_el_idxs.begin(), itr);
-
-                    if(imleft){
-                        elptrR = &(comm_elements[jrank].at(index));
-                    } else {
-                        elptrL = &(comm_elements[jrank].at(index));
-                        elptrR = &elements[fac->elemR]; // special case because parallel faces are essential interior
-                    }
-                }
-#endif
-                ElementType& elL = *elptrL;
-                ElementType& elR = *elptrR;
-
-                int geo_order = std::max(elL.trans->order, elR.trans->order);
-
-                auto geo_order_dispatch = [&]<int geo_order>() -> int{
-                    TraceTypeKey trace_key = { 
-                        .basis_order_l = elL.basis->getPolynomialOrder(),
-                        .basis_order_r = elR.basis->getPolynomialOrder(),
-                        .basis_order_trace = std::max(elL.basis->getPolynomialOrder(), elR.basis->getPolynomialOrder()), 
-                        .geometry_order = geo_order,
-                        .domain_type = fac->domain_type(),
-                        .qtype = FESPACE_ENUMS::FESPACE_QUADRATURE::GAUSS_LEGENDRE,
-                        .face_info_l = fac->face_infoL,
-                        .face_info_r = fac->face_infoR
-                    };
-
-                    if(ref_trace_map.find(trace_key) == ref_trace_map.end()){
-                        ref_trace_map[trace_key] = ReferenceTraceType(
-                            fac.get(),
-                            FESPACE_ENUMS::FESPACE_BASIS_TYPE::LAGRANGE,
-                            FESPACE_ENUMS::FESPACE_QUADRATURE::GAUSS_LEGENDRE,
-                            *(elL.basis),
-                            *(elR.basis),
-                            std::integral_constant<int, geo_order>{},
-                            std::integral_constant<int, geo_order>{});
-                    }
-                    ReferenceTraceType &ref_trace = ref_trace_map[trace_key];
-                    
-                    if(is_interior || fac->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM){
-                        // parallel bdy faces are essentially also interior faces 
-                        // aside from being a bit *special* :3
-                        TraceType trace{ fac.get(), &elL, &elR, ref_trace.trace_basis.get(),
-                            ref_trace.quadrule.get(), 
-                            std::span<const BasisEvaluation<T, ndim>>{ref_trace.evals_l},
-                            std::span<const BasisEvaluation<T, ndim>>{ref_trace.evals_r},
-                            (IDX) traces.size() };
-                        traces.push_back(trace);
-                    } else {
-                        TraceType trace = TraceType::make_bdy_trace_space(
-                            fac.get(), &elL, ref_trace.trace_basis.get(), 
-                            ref_trace.quadrule.get(),
-                            std::span<const BasisEvaluation<T, ndim>>{ref_trace.evals_l},
-                            std::span<const BasisEvaluation<T, ndim>>{ref_trace.evals_r},
-                            (IDX) traces.size());
-                        traces.push_back(trace);
-                    }
-
-                    return 0;
-                };
-
-                NUMTOOL::TMP::invoke_at_index(
-                    NUMTOOL::TMP::make_range_sequence<int, 1, MAX_DYNAMIC_ORDER>{},
-                    geo_order,
-                    geo_order_dispatch                    
-                );
-            }
-            // reuse the face indexing from the mesh
-            interior_trace_start = meshptr->interiorFaceStart;
-            interior_trace_end = meshptr->interiorFaceEnd;
-            bdy_trace_start = meshptr->bdyFaceStart;
-            bdy_trace_end = meshptr->bdyFaceEnd;
+            build_traces();
 
             // generate the dof offsets 
             dg_map = dg_dof_map{elements};
 
-            // ===================================
-            // = Build the connectivity matrices =
-            // ===================================
-
-            // generate the face surrounding nodes connectivity matrix 
-            std::vector<std::vector<IDX>> connectivity_ragged(meshptr->n_nodes());
-            for(int itrace = 0; itrace < traces.size(); ++itrace){
-                const TraceType& trace = traces[itrace];
-                for(IDX inode : trace.face->nodes_span()){
-                    connectivity_ragged[inode].push_back(itrace);
-                }
-            }
-            fac_surr_nodes = util::crs{connectivity_ragged};
-
-            el_surr_nodes = util::crs{meshptr->elsup};
-
-            std::vector<std::vector<IDX>> fac_surr_el_ragged(elements.size());
-            for(int itrace = 0; itrace < traces.size(); ++itrace) {
-                const TraceType& trace = traces[itrace];
-                if(trace.face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM){
-                    // take some extra care to not add the wrong element index
-                    auto [jrank, imleft] = decode_mpi_bcflag(trace.face->bcflag);
-                    if(imleft){
-                        fac_surr_el_ragged[trace.elL.elidx].push_back(itrace);
-                    } else {
-                        fac_surr_el_ragged[trace.elR.elidx].push_back(itrace);
-                    }
-                } else {
-                    fac_surr_el_ragged[trace.elL.elidx].push_back(itrace);
-                    fac_surr_el_ragged[trace.elR.elidx].push_back(itrace);
-                }
-            }
-            fac_surr_el = util::crs{fac_surr_el_ragged};
+            // the connectivity matrices are built on first use
+            color_interior_traces();
         }
 
         /**
@@ -663,6 +853,412 @@ namespace iceicle {
                 traces.begin() + bdy_trace_end};
         }
 
+        /**
+         * @brief build the geometric factor cache and point the elements and traces to it
+         * so that integrators can use the precomputed geometric quantities
+         */
+        auto enable_geometric_factors() -> void {
+            geo_factors = std::make_unique<GeometricFactors<T, IDX, ndim>>(*meshptr, elements, traces, compact_mode);
+            for(ElementType& el : elements) el.geo_factors = geo_factors.get();
+            for(TraceType& trace : traces) trace.geo_factors = geo_factors.get();
+            // the DDG data uses the trace normals and points
+            if(ddg_factors) enable_ddg_factors();
+        }
+
+        /**
+         * @brief build the cache of the DDG interface length scale and physical basis gradients and hessians
+         * at the interior trace quadrature points and point the traces to it
+         * so the DDG viscous trace integrals do not recompute them every residual evaluation
+         */
+        auto enable_ddg_factors() -> void {
+            ddg_factors = std::make_unique<DDGTraceFactors<T, IDX, ndim>>(*meshptr, traces,
+                    interior_trace_start, interior_trace_end);
+            for(TraceType& trace : traces) trace.ddg_factors = ddg_factors.get();
+        }
+
+        /**
+         * @brief reduce the memory held for derived data (see memory_report())
+         * - the connectivity matrices that are built on first use are released
+         * - the geometric factor cache stores a single inverse jacobian for affine elements
+         *   (rebuilt now if it is enabled)
+         *
+         * The data is computed again on access so this trades some time for memory.
+         */
+        auto compact() -> void {
+            compact_mode = true;
+            release_connectivity();
+            if(geo_factors) enable_geometric_factors();
+        }
+
+        /// @brief if compact() has been called
+        [[nodiscard]] auto is_compact() const noexcept -> bool { return compact_mode; }
+
+        /**
+         * @brief the memory held by this space on this process
+         * (use MemoryReport::reduce_sums() for all processes)
+         *
+         * The entries are the elements and traces, the tables shared by the elements and traces of the same type,
+         * the dof maps, the orderings and connectivity, the geometric factor cache (if enabled),
+         * then the mesh coordinates and connectivity this space refers to.
+         * The basis and quadrature objects are not counted.
+         *
+         * @return the report with one entry for each data structure
+         */
+        [[nodiscard]] auto memory_report() const -> util::MemoryReport {
+            using namespace util;
+            MemoryReport report{};
+            report.add("elements", elements.size(), vector_bytes(elements));
+            report.add("traces", traces.size(), vector_bytes(traces));
+            std::size_t ncomm = 0, comm_bytes = vector_bytes(comm_elements);
+            for(const auto& comm_rank : comm_elements) { ncomm += comm_rank.size(); comm_bytes += vector_bytes(comm_rank); }
+            report.add("communicated elements", ncomm, comm_bytes);
+
+            std::size_t ref_el_bytes = 0;
+            for(std::size_t i = 0; i < ref_el_map.size(); ++i){
+                const ReferenceElementType& ref_el = ref_el_map.value_at(i);
+                ref_el_bytes += sizeof(ReferenceElementType) + ref_el.evals.memory_bytes() + vector_bytes(ref_el.ref_mass)
+                    + ref_el.geo_evals.memory_bytes();
+            }
+            report.add("reference elements", ref_el_map.size(), ref_el_bytes);
+            std::size_t ref_trace_bytes = 0;
+            for(std::size_t i = 0; i < ref_trace_map.size(); ++i){
+                const ReferenceTraceType& ref_trace = ref_trace_map.value_at(i);
+                ref_trace_bytes += sizeof(ReferenceTraceType) + ref_trace.evals_l.memory_bytes() 
+                    + ref_trace.evals_r.memory_bytes() + vector_bytes(ref_trace.qp_xi_l) + vector_bytes(ref_trace.qp_xi_r)
+                    + ref_trace.geo_evals_l.memory_bytes() + ref_trace.geo_evals_r.memory_bytes();
+            }
+            report.add("reference traces", ref_trace_map.size(), ref_trace_bytes);
+
+            report.add("dg map", dg_map.nelem(), dg_map.memory_bytes());
+            report.add("trace colors", interior_trace_colors.nrow(),
+                    crs_bytes(interior_trace_colors) + vector_bytes(interior_trace_color));
+            report.add("element batches", element_batches.nrow(),
+                    crs_bytes(element_batches) + vector_bytes(element_batch_keys));
+
+            std::size_t conn_bytes = 0;
+            if(const auto* ptr = _fac_surr_nodes.get_if()) conn_bytes += crs_bytes(*ptr);
+            if(const auto* ptr = _el_surr_nodes.get_if()) conn_bytes += crs_bytes(*ptr);
+            if(const auto* ptr = _fac_surr_el.get_if()) conn_bytes += crs_bytes(*ptr);
+            report.add("lazy connectivity", 0, conn_bytes);
+
+            report.add("geometric factors (elements)", (geo_factors) ? elements.size() : 0,
+                    (geo_factors) ? geo_factors->element_memory_bytes() : 0);
+            report.add("geometric factors (traces)", (geo_factors) ? traces.size() : 0,
+                    (geo_factors) ? geo_factors->trace_memory_bytes() : 0);
+            report.add("ddg trace factors", (ddg_factors) ? interior_trace_end - interior_trace_start : 0,
+                    (ddg_factors) ? ddg_factors->memory_bytes() : 0);
+
+            report.add("mesh coordinates", meshptr->coord.size(),
+                    vector_bytes(meshptr->coord) + crs_bytes(meshptr->coord_els));
+            report.add("mesh connectivity", meshptr->nelem(), crs_bytes(meshptr->conn_el) + crs_bytes(meshptr->elsup)
+                    + crs_bytes(meshptr->facsuel) + vector_bytes(meshptr->el_transformations)
+                    + vector_bytes(meshptr->faces));
+            return report;
+        }
+
+        /**
+         * @brief recompute the cached geometric factors for elements and traces 
+         * that have moved since they were last computed
+         * does nothing if the cache has not been enabled
+         */
+        auto update_geometric_factors() -> void {
+            if(geo_factors) geo_factors->update(elements, traces);
+            if(ddg_factors) ddg_factors->update(traces, interior_trace_start, interior_trace_end);
+        }
+
+        /**
+         * @brief patch the space in place after a local change to the mesh topology 
+         * (i.e edge_swap()) instead of rebuilding it 
+         *
+         * The element and face indices are reused by the edit so the elements keep their basis 
+         * and the dg_map offsets and element batches do not change. 
+         * The traces of the edited faces are rebuilt and the connectivity rows 
+         * and interior trace coloring are patched for the edited entities. 
+         *
+         * NOTE: the mesh must already be patched (AbstractMesh::apply_topology_edit())
+         * @param edit the entities touched by the change
+         */
+        auto apply_topology_edit(const topology_edit<IDX>& edit) -> void {
+            // the element transformations and node counts are unchanged, 
+            // so the views into the mesh stay valid and only derived data is refreshed
+            for(IDX iel : edit.elements){
+                ElementType& el = elements[iel];
+                el.affine = ElementType::affine_transformation(el.trans, meshptr->coord_els.rowspan(iel));
+            }
+
+            bool qp_changed = false;
+            for(IDX ifac : edit.faces){
+                int nqp_old = traces[ifac].nQP();
+                rebuild_trace(ifac);
+                qp_changed = qp_changed || nqp_old != traces[ifac].nQP();
+            }
+
+            // faces surrounding nodes (connectivity that is not built yet will be built from the patched state)
+            if(util::crs<IDX, IDX>* el_surr_nodes_ptr = _el_surr_nodes.get_if()){
+                for(IDX inode : edit.nodes) el_surr_nodes_ptr->replace_row(inode, meshptr->elsup.rowspan(inode));
+            }
+            if(util::crs<IDX>* fac_surr_nodes_ptr = _fac_surr_nodes.get_if()) for(IDX inode : edit.nodes){
+                std::vector<IDX> candidates{};
+                for(IDX itrace : fac_surr_nodes_ptr->rowspan(inode)) candidates.push_back(itrace);
+                for(IDX itrace : edit.faces) candidates.push_back(itrace);
+                std::ranges::sort(candidates);
+                auto unique_subrange = std::ranges::unique(candidates);
+                candidates.erase(unique_subrange.begin(), unique_subrange.end());
+
+                std::vector<IDX> row{};
+                for(IDX itrace : candidates){
+                    std::span<const IDX> fac_nodes = traces[itrace].face->nodes_span();
+                    if(std::ranges::find(fac_nodes, inode) != fac_nodes.end()) row.push_back(itrace);
+                }
+                fac_surr_nodes_ptr->replace_row(inode, row);
+            }
+
+            // faces surrounding elements
+            if(util::crs<IDX>* fac_surr_el_ptr = _fac_surr_el.get_if()) for(IDX iel : edit.elements){
+                std::vector<IDX> candidates{};
+                for(IDX itrace : fac_surr_el_ptr->rowspan(iel)) candidates.push_back(itrace);
+                for(IDX itrace : edit.faces) candidates.push_back(itrace);
+                std::ranges::sort(candidates);
+                auto unique_subrange = std::ranges::unique(candidates);
+                candidates.erase(unique_subrange.begin(), unique_subrange.end());
+
+                std::vector<IDX> row{};
+                for(IDX itrace : candidates){
+                    const TraceType& trace = traces[itrace];
+                    bool touches = trace.elL.elidx == iel || trace.elR.elidx == iel;
+                    if(trace.face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM){
+                        // only the local side has a valid element index
+                        auto [jrank, imleft] = decode_mpi_bcflag(trace.face->bcflag);
+                        touches = (imleft) ? trace.elL.elidx == iel : trace.elR.elidx == iel;
+                    }
+                    if(touches) row.push_back(itrace);
+                }
+                fac_surr_el_ptr->replace_row(iel, row);
+            }
+
+            // keep the coloring conflict free
+            for(IDX ifac : edit.faces){
+                if((std::size_t) ifac >= interior_trace_start && (std::size_t) ifac < interior_trace_end)
+                    recolor_interior_trace(ifac);
+            }
+
+            if(geo_factors){
+                // the cache layout depends on the number of quadrature points of each trace
+                if(qp_changed) enable_geometric_factors();
+                else update_geometric_factors();
+            }
+            // the DDG data layout depends on the basis sizes of the rebuilt traces
+            if(ddg_factors) enable_ddg_factors();
+        }
+
+        /**
+         * @brief change the basis order of elements in place (p-adaptivity)
+         *
+         * The elements with a new order are pointed to the reference element of that order,
+         * the traces of their faces are rebuilt, and the dg_map offsets and element batches are recomputed.
+         * The element and trace indices (and so the connectivity and the trace coloring) do not change.
+         * Under MPI the new orders of the communicated elements are exchanged.
+         * The geometric factor cache is rebuilt if it is enabled (the quadrature rules change).
+         *
+         * NOTE: solution data in the old dg_map layout must be transferred by the caller
+         * (see p_adaptivity.hpp) and solvers holding sizes or matrices for this space must be recreated
+         *
+         * @param el_orders the basis order for each element (size = elements.size())
+         */
+        auto set_element_orders(std::span<const int> el_orders) -> void {
+            if(el_orders.size() != elements.size() || element_batch_keys.empty()) return;
+
+            // the type key of each element
+            std::vector<FETypeKey> el_keys(elements.size());
+            for(IDX ibatch = 0; ibatch < element_batches.nrow(); ++ibatch){
+                for(IDX iel : element_batches.rowspan(ibatch)) el_keys[iel] = element_batch_keys[ibatch];
+            }
+
+            std::vector<bool> trace_changed(traces.size(), false);
+            for(IDX iel = 0; iel < elements.size(); ++iel){
+                if(el_keys[iel].basis_order == el_orders[iel]) continue;
+                el_keys[iel].basis_order = el_orders[iel];
+                el_keys[iel].quadrature_shift = effective_quadrature_shift(el_keys[iel].qtype, el_orders[iel],
+                        el_keys[iel].geometry_order, volume_quadrature_shift);
+                set_reference_element(elements[iel], get_reference_element(el_keys[iel]));
+                for(IDX itrace : fac_surr_el().rowspan(iel)) trace_changed[itrace] = true;
+            }
+
+#ifdef ICEICLE_USE_MPI
+            // exchange the orders of the communicated elements
+            int nrank;
+            MPI_Comm_size(MPI_COMM_WORLD, &nrank);
+            std::vector<std::vector<int>> send_orders(nrank), recv_orders(nrank);
+            std::vector<MPI_Request> requests{};
+            for(int irank = 0; irank < nrank; ++irank){
+                if(irank < (int) meshptr->el_send_list.size() && !meshptr->el_send_list[irank].empty()){
+                    for(IDX iel : meshptr->el_send_list[irank]) send_orders[irank].push_back(el_orders[iel]);
+                    requests.emplace_back();
+                    MPI_Isend(send_orders[irank].data(), send_orders[irank].size(), MPI_INT,
+                            irank, 0, MPI_COMM_WORLD, &requests.back());
+                }
+                if(irank < (int) comm_elements.size() && !comm_elements[irank].empty()){
+                    recv_orders[irank].resize(comm_elements[irank].size());
+                    requests.emplace_back();
+                    MPI_Irecv(recv_orders[irank].data(), recv_orders[irank].size(), MPI_INT,
+                            irank, 0, MPI_COMM_WORLD, &requests.back());
+                }
+            }
+            MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+
+            bool comm_changed = false;
+            for(int irank = 0; irank < (int) comm_elements.size(); ++irank){
+                for(std::size_t icomm = 0; icomm < comm_elements[irank].size(); ++icomm){
+                    ElementType& el = comm_elements[irank][icomm];
+                    if(el.basis->getPolynomialOrder() == recv_orders[irank][icomm]) continue;
+                    FETypeKey fe_key = element_batch_keys[0];
+                    fe_key.domain_type = el.trans->domain_type;
+                    fe_key.geometry_order = el.trans->order;
+                    fe_key.basis_order = recv_orders[irank][icomm];
+                    fe_key.quadrature_shift = effective_quadrature_shift(fe_key.qtype, fe_key.basis_order,
+                            fe_key.geometry_order, volume_quadrature_shift);
+                    set_reference_element(el, get_reference_element(fe_key));
+                    comm_changed = true;
+                }
+            }
+            if(comm_changed){
+                for(IDX itrace = 0; itrace < traces.size(); ++itrace){
+                    if(traces[itrace].face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) trace_changed[itrace] = true;
+                }
+            }
+#endif
+
+            for(IDX itrace = 0; itrace < traces.size(); ++itrace){
+                if(trace_changed[itrace]) rebuild_trace(itrace);
+            }
+
+            build_element_batches(el_keys);
+            dg_map = dg_dof_map{elements};
+
+            if(geo_factors) enable_geometric_factors();
+            else if(ddg_factors) enable_ddg_factors();
+        }
+
+        /**
+         * @brief change the number of quadrature points of the element and trace rules in place
+         * relative to the exact rule (see quadrature_npoints_1d)
+         *
+         * i.e over-integrate the domain integral of a nonlinear flux with volume_shift = 1
+         * or assemble a preconditioner with reduced trace quadrature with trace_shift = -1.
+         * The elements and traces are pointed to the reference elements and traces of the new rules
+         * and the element batches are recomputed. The bases (and so the dg_map) do not change.
+         * The geometric factor cache is rebuilt if it is enabled.
+         * The shifts are kept for elements whose order changes (set_element_orders).
+         *
+         * NOTE: quadrature point data of a discretization (i.e callback tables) must be built after this.
+         * The isoparametric H1 space always uses the exact rule.
+         *
+         * @param volume_shift the number of 1D points added to the element rules (negative to remove)
+         * @param trace_shift the number of 1D points added to the trace rules (negative to remove)
+         */
+        auto set_quadrature_shifts(int volume_shift, int trace_shift) -> void {
+            if(type != SPACE_TYPE::L2 || element_batch_keys.empty()) return;
+            volume_quadrature_shift = volume_shift;
+            trace_quadrature_shift = trace_shift;
+
+            // the type key of each element with the new shift
+            std::vector<FETypeKey> el_keys(elements.size());
+            for(IDX ibatch = 0; ibatch < element_batches.nrow(); ++ibatch){
+                for(IDX iel : element_batches.rowspan(ibatch)) el_keys[iel] = element_batch_keys[ibatch];
+            }
+            for(IDX iel = 0; iel < elements.size(); ++iel){
+                FETypeKey& key = el_keys[iel];
+                int shift = effective_quadrature_shift(key.qtype, key.basis_order, key.geometry_order, volume_shift);
+                if(shift == key.quadrature_shift) continue;
+                key.quadrature_shift = shift;
+                set_reference_element(elements[iel], get_reference_element(key));
+            }
+
+#ifdef ICEICLE_USE_MPI
+            // every process applies the same shifts so the communicated elements are updated locally
+            for(std::vector<ElementType>& rank_elements : comm_elements){
+                for(ElementType& el : rank_elements){
+                    FETypeKey key = element_batch_keys[0];
+                    key.domain_type = el.trans->domain_type;
+                    key.geometry_order = el.trans->order;
+                    key.basis_order = el.basis->getPolynomialOrder();
+                    key.quadrature_shift = effective_quadrature_shift(key.qtype, key.basis_order,
+                            key.geometry_order, volume_shift);
+                    set_reference_element(el, get_reference_element(key));
+                }
+            }
+#endif
+
+            for(IDX itrace = 0; itrace < traces.size(); ++itrace) rebuild_trace(itrace);
+            build_element_batches(el_keys);
+
+            if(geo_factors) enable_geometric_factors();
+            else if(ddg_factors) enable_ddg_factors();
+        }
+
+        /**
+         * @brief call a kernel for a batch of elements with the concrete transformation type
+         * so the transformation can be inlined instead of called through ElementTransformation
+         *
+         * fcn(std::type_identity<TransformationType>{}, elidxs) where elidxs are the element indices 
+         * TransformationType is transformations::hypercube or transformations::triangle
+         * or void if there is no concrete type for the batch (use the ElementTransformation)
+         *
+         * @param ibatch the index of the batch 
+         * @param fcn the kernel to call
+         */
+        template<class F>
+        auto dispatch_element_batch(IDX ibatch, F&& fcn) const -> void {
+            const FETypeKey& key = element_batch_keys[ibatch];
+            std::span<const IDX> elidxs = element_batches.rowspan(ibatch);
+            bool dispatched = false;
+            switch(key.domain_type){
+                case DOMAIN_TYPE::HYPERCUBE:
+                    NUMTOOL::TMP::constexpr_for_range<1, build_config::FESPACE_BUILD_GEO_PN + 1>(
+                        [&]<int geo_order>{
+                            if(key.geometry_order == geo_order){
+                                fcn(std::type_identity<transformations::hypercube<T, IDX, ndim, geo_order>>{}, elidxs);
+                                dispatched = true;
+                            }
+                        }
+                    );
+                    break;
+                case DOMAIN_TYPE::SIMPLEX:
+                    if constexpr (ndim == 2) {
+                        if(key.geometry_order == 1){
+                            fcn(std::type_identity<transformations::triangle<T, IDX>>{}, elidxs);
+                            dispatched = true;
+                        }
+                    }
+                    break;
+                default:
+                    break;
+            }
+            if(!dispatched) fcn(std::type_identity<void>{}, elidxs);
+        }
+
+        /**
+         * @brief call a kernel for a batch of elements with the concrete transformation type 
+         * (see dispatch_element_batch) and the compile time element sizes of the batch
+         *
+         * fcn(std::type_identity<TransformationType>{}, std::type_identity<SizesType>{}, elidxs)
+         * where SizesType is the fixed_element_sizes of the batch if it is in the kernel registry 
+         * (see dispatch_fixed_element_sizes) or void to use the generic kernels
+         *
+         * @param ibatch the index of the batch 
+         * @param fcn the kernel to call
+         */
+        template<class F>
+        auto dispatch_element_kernel(IDX ibatch, F&& fcn) const -> void {
+            const FETypeKey& key = element_batch_keys[ibatch];
+            dispatch_element_batch(ibatch, [&](auto trans_tag, std::span<const IDX> elidxs){
+                dispatch_fixed_element_sizes<ndim>(key.domain_type, key.basis_order,
+                    key.geometry_order, key.qtype, key.quadrature_shift, [&](auto sizes_tag){
+                        fcn(trans_tag, sizes_tag, elidxs);
+                    });
+            });
+        }
+
         auto print_info(std::ostream& out)
         -> std::ostream& {
             out << "Finite Element Space" << std::endl;
@@ -682,5 +1278,11 @@ namespace iceicle {
         }
 
     };
-    
+
+#ifdef ICEICLE_EXTERN_TEMPLATES
+    // compiled once in iceicle_core (see src/core/instantiations.cpp)
+    extern template class FESpace<build_config::T, build_config::IDX, 1>;
+    extern template class FESpace<build_config::T, build_config::IDX, 2>;
+    extern template class FESpace<build_config::T, build_config::IDX, 3>;
+#endif
 }
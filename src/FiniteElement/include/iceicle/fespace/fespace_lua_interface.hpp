@@ -1,5 +1,6 @@
 #pragma once
 #include "Numtool/tmp_flow_control.hpp"
+#include "iceicle/anomaly_log.hpp"
 #include "iceicle/build_config.hpp"
 #include "iceicle/element/reference_element.hpp"
 #include "iceicle/mesh/mesh.hpp"
@@ -33,20 +34,68 @@ namespace iceicle {
             if(util::eq_icase(quadrature_name.value(), "gauss")){
                 qtype = FESPACE_ENUMS::GAUSS_LEGENDRE;
             }
+            if(util::eq_icase_any(quadrature_name.value(), "gauss_lobatto", "lobatto", "gll")){
+                qtype = FESPACE_ENUMS::GAUSS_LOBATTO;
+            }
+            if(util::eq_icase_any(quadrature_name.value(), "symmetric", "witherden_vincent")){
+                qtype = FESPACE_ENUMS::SYMMETRIC;
+            }
         }
 
         // get the basis polynomial order
         sol::optional<int> order = tbl["order"];
-        if(order){
-            auto seq = NUMTOOL::TMP::make_range_sequence<int, 0, build_config::FESPACE_BUILD_PN>{};
-            return NUMTOOL::TMP::invoke_at_index(seq, order.value(),
-                [&]<int order_comp>{
-                    return FESpace<T, IDX, ndim>{meshptr, btype, qtype, std::integral_constant<int, order_comp>{}};
-                }
-            );
-        } else {
-            return FESpace<T, IDX, ndim>{meshptr, btype, qtype, std::integral_constant<int, 0>{}};
+        FESpace<T, IDX, ndim> fespace = [&]{
+            if(order){
+                auto seq = NUMTOOL::TMP::make_range_sequence<int, 0, build_config::FESPACE_BUILD_PN>{};
+                return NUMTOOL::TMP::invoke_at_index(seq, order.value(),
+                    [&]<int order_comp>{
+                        return FESpace<T, IDX, ndim>{meshptr, btype, qtype, std::integral_constant<int, order_comp>{}};
+                    }
+                );
+            } else {
+                return FESpace<T, IDX, ndim>{meshptr, btype, qtype, std::integral_constant<int, 0>{}};
+            }
+        }();
+
+        // quadrature policies of the element (volume) and trace rules
+        // "exact" (default), "over" (the 3/2 rule for nonlinear fluxes),
+        // "reduced" (basis order + 1 points for mass and preconditioner assembly), or the number of points to add
+        sol::optional<sol::table> policy_tbl = tbl["quadrature_policy"];
+        if(policy_tbl){
+            int basis_order = order.value_or(0);
+            auto policy_shift = [&](sol::object policy) -> int {
+                if(policy.is<int>()) return policy.as<int>();
+                if(!policy.is<std::string>()) return 0;
+                std::string name = policy.as<std::string>();
+                if(util::eq_icase(name, "exact")) return 0;
+                if(util::eq_icase_any(name, "over", "over_integrated")) return (basis_order + 2) / 2;
+                if(util::eq_icase(name, "reduced")) return -MAX_DYNAMIC_ORDER;
+                util::AnomalyLog::log_anomaly(util::Anomaly{"unrecognized quadrature policy: " + name,
+                        util::general_anomaly_tag{}});
+                return 0;
+            };
+            fespace.set_quadrature_shifts(policy_shift(policy_tbl.value()["volume"]),
+                    policy_shift(policy_tbl.value()["trace"]));
+        }
+
+        // optionally cache the geometric factors
+        sol::optional<bool> geometric_factors = tbl["geometric_factors"];
+        if(geometric_factors && geometric_factors.value()){
+            fespace.enable_geometric_factors();
+        }
+
+        // optionally cache the DDG interface data of the interior traces
+        sol::optional<bool> ddg_factors = tbl["ddg_factors"];
+        if(ddg_factors && ddg_factors.value()){
+            fespace.enable_ddg_factors();
+        }
+
+        // optionally release derived data to reduce the memory footprint
+        sol::optional<bool> compact = tbl["compact"];
+        if(compact && compact.value()){
+            fespace.compact();
         }
+        return fespace;
     }
 
     template<class T, class IDX, int ndim>
@@ -0,0 +1,96 @@
+/**
+ * @brief registry of the element configurations that get kernels specialized 
+ * on compile time numbers of basis functions and quadrature points
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/build_config.hpp"
+#include "iceicle/element/reference_element.hpp"
+#include "iceicle/fe_definitions.hpp"
+#include <Numtool/integer_utils.hpp>
+#include <Numtool/tmp_flow_control.hpp>
+#include <type_traits>
+
+namespace iceicle {
+
+    /**
+     * @brief the compile time sizes of the elements of a configuration in the kernel registry
+     *
+     * The quadrature is the one ReferenceElement constructs for geometry order 1:
+     * basis_order + 1 Gauss Legendre (or Gauss Lobatto) points in 1D on hypercubes
+     * and the Grundmann Moller rule of order basis_order + 1 on simplices
+     *
+     * @tparam ndim the number of dimensions
+     * @tparam domain the reference domain of the elements
+     * @tparam basis_order the polynomial order of the basis
+     */
+    template<int ndim, DOMAIN_TYPE domain, int basis_order>
+    struct fixed_element_sizes {
+        /// @brief the reference domain
+        static constexpr DOMAIN_TYPE domain_type = domain;
+
+        /// @brief the polynomial order of the basis
+        static constexpr int order = basis_order;
+
+        /// @brief the number of 1D basis functions (tensor product bases)
+        static constexpr int nbasis_1d = basis_order + 1;
+
+        /// @brief the number of 1D quadrature points (tensor product rules)
+        static constexpr int nqp_1d = basis_order + 1;
+
+        /// @brief the number of basis functions
+        static constexpr int nbasis = (domain == DOMAIN_TYPE::HYPERCUBE) 
+            ? MATH::power_T<nbasis_1d, ndim>::value
+            : MATH::binomial<basis_order + ndim, ndim>();
+
+        /// @brief the number of quadrature points
+        static constexpr int nqp = (domain == DOMAIN_TYPE::HYPERCUBE) 
+            ? MATH::power_T<nqp_1d, ndim>::value
+            : MATH::binomial<ndim + nqp_1d + 1, ndim + 1>();
+    };
+
+    /**
+     * @brief call a kernel with the compile time sizes of an element configuration
+     *
+     * fcn(std::type_identity<fixed_element_sizes<ndim, domain, basis_order>>{}) 
+     * if the configuration is in the registry, or fcn(std::type_identity<void>{}) otherwise.
+     * The registry is geometry order 1 on hypercubes and simplices 
+     * for basis orders 1 to build_config::SPECIALIZED_KERNEL_PN 
+     * with the quadrature the sizes are computed for (the symmetric simplex rules have a different size
+     * and shifted rules have a different number of points)
+     *
+     * @param domain_type the reference domain of the elements
+     * @param basis_order the polynomial order of the basis
+     * @param geometry_order the polynomial order of the element transformation
+     * @param qtype the quadrature type
+     * @param quadrature_shift the shift of the quadrature rule from the exact rule (see quadrature_npoints_1d)
+     * @param fcn the kernel to call
+     */
+    template<int ndim, class F>
+    auto dispatch_fixed_element_sizes(
+        DOMAIN_TYPE domain_type,
+        int basis_order,
+        int geometry_order,
+        FESPACE_ENUMS::FESPACE_QUADRATURE qtype,
+        int quadrature_shift,
+        F&& fcn
+    ) -> void {
+        bool dispatched = false;
+        bool in_registry = (geometry_order == 1) && (quadrature_shift == 0) && (domain_type == DOMAIN_TYPE::HYPERCUBE 
+            || (domain_type == DOMAIN_TYPE::SIMPLEX && qtype != FESPACE_ENUMS::SYMMETRIC));
+        if(in_registry){
+            NUMTOOL::TMP::constexpr_for_range<1, build_config::SPECIALIZED_KERNEL_PN + 1>(
+                [&]<int basis_order_c>{
+                    if(basis_order != basis_order_c) return;
+                    if(domain_type == DOMAIN_TYPE::HYPERCUBE){
+                        fcn(std::type_identity<fixed_element_sizes<ndim, DOMAIN_TYPE::HYPERCUBE, basis_order_c>>{});
+                    } else {
+                        fcn(std::type_identity<fixed_element_sizes<ndim, DOMAIN_TYPE::SIMPLEX, basis_order_c>>{});
+                    }
+                    dispatched = true;
+                }
+            );
+        }
+        if(!dispatched) fcn(std::type_identity<void>{});
+    }
+}
@@ -0,0 +1,312 @@
+/// @brief locate physical points in the elements of a finite element space
+/// @author Gianni Absillis (gabsill@ncsu.edu)
+#pragma once
+#include "iceicle/element/finite_element.hpp"
+#include "iceicle/fe_definitions.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/geometry/geo_primitives.hpp"
+#include "iceicle/thread_utils.hpp"
+#include "iceicle/transformations/transformation_utils.hpp"
+#include <Numtool/point.hpp>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace iceicle {
+
+    /// @brief a physical point located in an element
+    template<class T, class IDX, int ndim>
+    struct element_point {
+        /// @brief the index of the element in the fespace
+        IDX iel;
+
+        /// @brief the point in the reference domain of the element
+        MATH::GEOMETRY::Point<T, ndim> xi;
+    };
+
+    /// @brief check if a point is in the reference domain of the given type (within tol)
+    template<class T, int ndim>
+    inline
+    auto in_reference_domain(DOMAIN_TYPE domain_type, const MATH::GEOMETRY::Point<T, ndim>& xi, T tol)
+    -> bool {
+        switch(domain_type){
+            case DOMAIN_TYPE::HYPERCUBE:
+                for(int idim = 0; idim < ndim; ++idim)
+                    { if(std::abs(xi[idim]) > 1.0 + tol) return false; }
+                return true;
+            case DOMAIN_TYPE::SIMPLEX: {
+                T sum = 0.0;
+                for(int idim = 0; idim < ndim; ++idim){
+                    if(xi[idim] < -tol) return false;
+                    sum += xi[idim];
+                }
+                return sum <= 1.0 + tol;
+            }
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * @brief find the reference domain point that maps to a physical point 
+     * with Newton's method from the inverse of the affine part (see transformations::inverse_map)
+     * @param el the element
+     * @param x the physical point
+     * @param tol the tolerance on the physical distance (relative to the element size)
+     *        and on being inside the reference domain
+     * @param max_it the maximum number of Newton iterations
+     * @return the reference point if Newton converged to a point inside the reference domain
+     */
+    template<class T, class IDX, int ndim>
+    inline
+    auto inverse_transform(
+        const FiniteElement<T, IDX, ndim>& el,
+        const MATH::GEOMETRY::Point<T, ndim>& x,
+        T tol = 1e-10,
+        int max_it = 20
+    ) -> std::optional<MATH::GEOMETRY::Point<T, ndim>> {
+        auto result = transformations::inverse_map(*el.trans, el.coord_el, x, tol, max_it);
+        if(result.converged && in_reference_domain(el.trans->domain_type, result.xi, std::sqrt(tol)))
+            return result.xi;
+        return std::nullopt;
+    }
+
+    /**
+     * @brief the bounding box of the nodes of each element
+     * padded by a fraction of the box size for curved high order geometry
+     * @param fespace the finite element space
+     * @param padding the fraction of the box size to pad each side by
+     */
+    template<class T, class IDX, int ndim>
+    inline
+    auto element_bounding_boxes(FESpace<T, IDX, ndim>& fespace, T padding = 0.05)
+    -> std::vector<BoundingBox<T, ndim>> {
+        std::vector<BoundingBox<T, ndim>> bboxes(fespace.elements.size());
+        for(std::size_t iel = 0; iel < fespace.elements.size(); ++iel){
+            BoundingBox<T, ndim>& bbox = bboxes[iel];
+            std::ranges::fill(bbox.xmin, 1e100);
+            std::ranges::fill(bbox.xmax, -1e100);
+            for(const auto& node : fespace.elements[iel].coord_el){
+                for(int idim = 0; idim < ndim; ++idim){
+                    bbox.xmin[idim] = std::min(bbox.xmin[idim], node[idim]);
+                    bbox.xmax[idim] = std::max(bbox.xmax[idim], node[idim]);
+                }
+            }
+            for(int idim = 0; idim < ndim; ++idim){
+                T pad = padding * (bbox.xmax[idim] - bbox.xmin[idim]);
+                bbox.xmin[idim] -= pad;
+                bbox.xmax[idim] += pad;
+            }
+        }
+        return bboxes;
+    }
+
+    /**
+     * @brief find the element that contains a physical point
+     * elements whose bounding box contains the point are checked with inverse_transform
+     * @param fespace the finite element space
+     * @param bboxes the bounding box of each element (see element_bounding_boxes)
+     * @param x the physical point
+     * @return the element and reference point, or nullopt if no element on this process contains x
+     */
+    template<class T, class IDX, int ndim>
+    inline
+    auto find_element(
+        FESpace<T, IDX, ndim>& fespace,
+        std::span<const BoundingBox<T, ndim>> bboxes,
+        const MATH::GEOMETRY::Point<T, ndim>& x
+    ) -> std::optional<element_point<T, IDX, ndim>> {
+        for(std::size_t iel = 0; iel < fespace.elements.size(); ++iel){
+            const BoundingBox<T, ndim>& bbox = bboxes[iel];
+            bool inside = true;
+            for(int idim = 0; idim < ndim; ++idim)
+                { inside = inside && x[idim] >= bbox.xmin[idim] && x[idim] <= bbox.xmax[idim]; }
+            if(!inside) continue;
+            if(auto xi = inverse_transform(fespace.elements[iel], x))
+                { return element_point<T, IDX, ndim>{(IDX) iel, xi.value()}; }
+        }
+        return std::nullopt;
+    }
+
+    /// @brief find the element that contains a physical point \overload computes the bounding boxes
+    /// NOTE: for more than one point build an ElementBVH
+    template<class T, class IDX, int ndim>
+    inline
+    auto find_element(FESpace<T, IDX, ndim>& fespace, const MATH::GEOMETRY::Point<T, ndim>& x)
+    -> std::optional<element_point<T, IDX, ndim>> {
+        std::vector<BoundingBox<T, ndim>> bboxes = element_bounding_boxes(fespace);
+        return find_element(fespace, std::span<const BoundingBox<T, ndim>>{bboxes}, x);
+    }
+
+    /**
+     * @brief bounding volume hierarchy (AABB tree) over element bounding boxes
+     * to find the candidate elements for a point in O(log N)
+     *
+     * Built top down by splitting the elements at the median bounding box center
+     * along the longest axis of each node until leaf_size elements remain
+     *
+     * @tparam T the real value type
+     * @tparam IDX the index type
+     * @tparam ndim the number of dimensions
+     */
+    template<class T, class IDX, int ndim>
+    class ElementBVH {
+
+        struct bvh_node {
+            /// @brief the box containing every element box in this node
+            BoundingBox<T, ndim> bbox;
+
+            /// @brief the child nodes (-1 for leaves)
+            int left = -1, right = -1;
+
+            /// @brief the range of elements in this node in the element ordering
+            std::size_t begin, end;
+        };
+
+        std::vector<bvh_node> nodes{};
+
+        /// @brief the element boxes
+        std::vector<BoundingBox<T, ndim>> bboxes{};
+
+        /// @brief the element indices ordered so every node is a contiguous range
+        std::vector<IDX> order{};
+
+        static auto contains(const BoundingBox<T, ndim>& bbox, const MATH::GEOMETRY::Point<T, ndim>& x) -> bool {
+            for(int idim = 0; idim < ndim; ++idim)
+                { if(x[idim] < bbox.xmin[idim] || x[idim] > bbox.xmax[idim]) return false; }
+            return true;
+        }
+
+        auto build(std::size_t begin, std::size_t end, std::size_t leaf_size) -> int {
+            int inode = nodes.size();
+            nodes.push_back(bvh_node{.begin = begin, .end = end});
+            BoundingBox<T, ndim> bbox;
+            std::ranges::fill(bbox.xmin, 1e100);
+            std::ranges::fill(bbox.xmax, -1e100);
+            for(std::size_t i = begin; i < end; ++i){
+                for(int idim = 0; idim < ndim; ++idim){
+                    bbox.xmin[idim] = std::min(bbox.xmin[idim], bboxes[order[i]].xmin[idim]);
+                    bbox.xmax[idim] = std::max(bbox.xmax[idim], bboxes[order[i]].xmax[idim]);
+                }
+            }
+            nodes[inode].bbox = bbox;
+            if(end - begin <= leaf_size) return inode;
+
+            int axis = 0;
+            for(int idim = 1; idim < ndim; ++idim){
+                if(bbox.xmax[idim] - bbox.xmin[idim] > bbox.xmax[axis] - bbox.xmin[axis]) axis = idim;
+            }
+            std::size_t mid = begin + (end - begin) / 2;
+            std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+                [&](IDX a, IDX b){
+                    return bboxes[a].xmin[axis] + bboxes[a].xmax[axis] < bboxes[b].xmin[axis] + bboxes[b].xmax[axis];
+                });
+            int left = build(begin, mid, leaf_size);
+            int right = build(mid, end, leaf_size);
+            nodes[inode].left = left;
+            nodes[inode].right = right;
+            return inode;
+        }
+
+        public:
+
+        ElementBVH() = default;
+
+        /**
+         * @brief build the tree
+         * @param element_bboxes the bounding box of each element (see element_bounding_boxes)
+         * @param leaf_size the maximum number of elements in a leaf
+         */
+        ElementBVH(std::vector<BoundingBox<T, ndim>> element_bboxes, std::size_t leaf_size = 4)
+        : bboxes{std::move(element_bboxes)}, order(bboxes.size())
+        {
+            std::iota(order.begin(), order.end(), (IDX) 0);
+            if(!bboxes.empty()) build(0, bboxes.size(), std::max(leaf_size, (std::size_t) 1));
+        }
+
+        /// @brief build the tree over the elements of a finite element space
+        ElementBVH(FESpace<T, IDX, ndim>& fespace, std::size_t leaf_size = 4)
+        : ElementBVH(element_bounding_boxes(fespace), leaf_size) {}
+
+        /**
+         * @brief visit the elements whose bounding box contains x
+         * @param x the physical point
+         * @param f called with each candidate element index, returns true to stop the search
+         * @return true if f stopped the search
+         */
+        template<class F>
+        auto visit(const MATH::GEOMETRY::Point<T, ndim>& x, F&& f) const -> bool {
+            if(nodes.empty()) return false;
+            std::vector<int> stack{0};
+            while(!stack.empty()){
+                const bvh_node& node = nodes[stack.back()];
+                stack.pop_back();
+                if(!contains(node.bbox, x)) continue;
+                if(node.left < 0){
+                    for(std::size_t i = node.begin; i < node.end; ++i){
+                        if(contains(bboxes[order[i]], x) && f(order[i])) return true;
+                    }
+                } else {
+                    stack.push_back(node.right);
+                    stack.push_back(node.left);
+                }
+            }
+            return false;
+        }
+
+        /// @brief the indices of the elements whose bounding box contains x
+        [[nodiscard]] auto candidates(const MATH::GEOMETRY::Point<T, ndim>& x) const -> std::vector<IDX> {
+            std::vector<IDX> result{};
+            visit(x, [&](IDX iel){ result.push_back(iel); return false; });
+            return result;
+        }
+    };
+
+    /**
+     * @brief find the element that contains a physical point
+     * \overload uses the bounding volume hierarchy to find the candidate elements
+     */
+    template<class T, class IDX, int ndim>
+    inline
+    auto find_element(
+        FESpace<T, IDX, ndim>& fespace,
+        const ElementBVH<T, IDX, ndim>& bvh,
+        const MATH::GEOMETRY::Point<T, ndim>& x
+    ) -> std::optional<element_point<T, IDX, ndim>> {
+        std::optional<element_point<T, IDX, ndim>> result = std::nullopt;
+        bvh.visit(x, [&](IDX iel){
+            if(auto xi = inverse_transform(fespace.elements[iel], x)){
+                result = element_point<T, IDX, ndim>{iel, xi.value()};
+                return true;
+            }
+            return false;
+        });
+        return result;
+    }
+
+    /**
+     * @brief find the elements that contain a batch of physical points
+     * (i.e the probes, or the nodes of another mesh to transfer a solution to)
+     * the points are distributed over threads
+     * @param fespace the finite element space
+     * @param bvh the bounding volume hierarchy over the elements of fespace
+     * @param points the physical points
+     * @return the element and reference point for each point, or nullopt if no element on this process contains it
+     */
+    template<class T, class IDX, int ndim>
+    inline
+    auto find_elements(
+        FESpace<T, IDX, ndim>& fespace,
+        const ElementBVH<T, IDX, ndim>& bvh,
+        std::span<const MATH::GEOMETRY::Point<T, ndim>> points
+    ) -> std::vector<std::optional<element_point<T, IDX, ndim>>> {
+        std::vector<std::optional<element_point<T, IDX, ndim>>> result(points.size());
+        util::parallel_for(points.size(), [&](std::size_t ipoint){
+            result[ipoint] = find_element(fespace, bvh, points[ipoint]);
+        });
+        return result;
+    }
+}
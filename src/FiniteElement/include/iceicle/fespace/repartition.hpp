@@ -0,0 +1,283 @@
+/**
+ * @brief dynamic load rebalancing of a distributed finite element space
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/build_config.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/geometry/face_utils.hpp"
+#include "iceicle/geometry/transformations_table.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/mesh/mesh.hpp"
+#include "iceicle/mesh/mesh_partition.hpp"
+#include <Numtool/tmp_flow_control.hpp>
+#include <algorithm>
+#include <span>
+#include <type_traits>
+#include <vector>
+#ifdef ICEICLE_USE_MPI
+#include "iceicle/mpi_type.hpp"
+#include <mpi.h>
+#endif
+
+namespace iceicle {
+
+#if defined(ICEICLE_USE_MPI) && defined(ICEICLE_USE_METIS)
+    namespace impl::repartition {
+
+        /// @brief gather a variable size array from every rank to rank 0
+        /// @param local the data on this rank
+        /// @param [out] counts the size of the data from each rank (only on rank 0)
+        /// @return the data from every rank in order of rank (only on rank 0)
+        template<class V>
+        auto gather_to_root(const std::vector<V>& local, std::vector<int>& counts) -> std::vector<V> {
+            int myrank, nrank;
+            MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
+            MPI_Comm_size(MPI_COMM_WORLD, &nrank);
+            int count = local.size();
+            counts.assign((myrank == 0) ? nrank : 0, 0);
+            MPI_Gather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+            std::vector<int> displs(counts.size() + 1, 0);
+            for(std::size_t irank = 0; irank < counts.size(); ++irank)
+                displs[irank + 1] = displs[irank] + counts[irank];
+            std::vector<V> all(displs.back());
+            MPI_Gatherv(local.data(), count, mpi_get_type<V>(), all.data(), counts.data(), displs.data(),
+                    mpi_get_type<V>(), 0, MPI_COMM_WORLD);
+            return all;
+        }
+
+        /// @brief number of IDX entries in the element header (before the element nodes)
+        /// [global element index, domain type, geometry order, number of nodes, basis order, cost, number of coefficients]
+        inline constexpr int el_header_size = 7;
+
+        /// @brief number of IDX entries in the boundary face header (before the face nodes)
+        /// [global element index, domain type, geometry order, number of nodes, face_nr_l, face_nr_r, orientation_r, bctype, bcflag]
+        inline constexpr int bdy_header_size = 9;
+    }
+#endif
+
+    /**
+     * @brief rebalance the finite element space over the processes
+     *
+     * The elements are weighted by the given measured cost, or their estimated cost (nbasis x nqp)
+     * if none is given (i.e ElementCost::partition_weights), and the faces by
+     * the trace basis size (see estimate_partition_weights), gathered with the solution coefficients
+     * to rank 0 and repartitioned with partition_mesh.
+     * The mesh (*fespace.meshptr) and fespace are replaced with the new partition
+     * and the solution coefficients are sent to the processes that own their elements
+     *
+     * NOTE: layouts that refer to fespace.dg_map stay valid (and map the new partition),
+     * but anything else built on the mesh or fespace (i.e geometry maps, dof data) must be rebuilt.
+     * The interior faces are recreated, so face indices and the order of faces change
+     * (boundary flags that refer to face indices, i.e periodic faces, are not renumbered).
+     *
+     * @param fespace the finite element space to rebalance
+     * @param u the solution on the current partition
+     * @param el_cost the measured integer cost of each element on this process
+     *        (empty to use the estimated cost, not deduced so a std::vector converts)
+     * @return the data for the solution on the new partition in the layout of u
+     * (i.e fespan{result.data(), u.get_layout()})
+     */
+    template<class T, class IDX, int ndim, class LayoutPolicy>
+    auto repartition(FESpace<T, IDX, ndim>& fespace, fespan<T, LayoutPolicy> u,
+            std::type_identity_t<std::span<const IDX>> el_cost = {}) -> std::vector<T> {
+        using Point = MATH::GEOMETRY::Point<T, ndim>;
+        using FESpaceType = FESpace<T, IDX, ndim>;
+
+#if defined(ICEICLE_USE_MPI) && defined(ICEICLE_USE_METIS)
+        using namespace impl::repartition;
+        int myrank, nrank;
+        MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
+        MPI_Comm_size(MPI_COMM_WORLD, &nrank);
+        if(nrank > 1) {
+            AbstractMesh<T, IDX, ndim>& mesh = *fespace.meshptr;
+            // the mesh is reassembled on rank 0 so the global ids fit the local index type
+            auto gel = [&mesh](IDX iel) -> IDX
+                { return (mesh.gel_idxs.empty()) ? iel : (IDX) mesh.gel_idxs[iel]; };
+            auto gnode = [&mesh](IDX inode) -> IDX
+                { return (mesh.gnode_idxs.empty()) ? inode : (IDX) mesh.gnode_idxs[inode]; };
+
+            // ====================================
+            // = Pack the local elements and data =
+            // ====================================
+            std::vector<IDX> el_data{}, bdy_data{}, node_gidxs(mesh.n_nodes());
+            std::vector<T> coeffs{}, node_coord(mesh.n_nodes() * ndim);
+            for(IDX iel = 0; iel < mesh.nelem(); ++iel){
+                const FiniteElement<T, IDX, ndim>& el = fespace.elements[iel];
+                std::span<const IDX> el_nodes = mesh.conn_el.rowspan(iel);
+                IDX ncoeff = u.ndof(iel) * u.nv();
+                el_data.insert(el_data.end(), {gel(iel), (IDX) el.trans->domain_type, (IDX) el.trans->order,
+                        (IDX) el_nodes.size(), (IDX) el.basis->getPolynomialOrder(),
+                        (el_cost.empty()) ? (IDX) (el.nbasis() * el.nQP()) : el_cost[iel], ncoeff});
+                for(IDX inode : el_nodes) el_data.push_back(gnode(inode));
+                for(IDX idof = 0; idof < u.ndof(iel); ++idof){
+                    for(IDX iv = 0; iv < u.nv(); ++iv)
+                        coeffs.push_back(u[iel, idof, iv]);
+                }
+            }
+            for(IDX inode = 0; inode < mesh.n_nodes(); ++inode){
+                node_gidxs[inode] = gnode(inode);
+                for(int idim = 0; idim < ndim; ++idim)
+                    node_coord[inode * ndim + idim] = mesh.coord[inode][idim];
+            }
+            // physical boundary faces (interior and interprocess faces are found again)
+            for(IDX ifac = mesh.bdyFaceStart; ifac < mesh.bdyFaceEnd; ++ifac){
+                const Face<T, IDX, ndim>& fac = *mesh.faces[ifac];
+                if(fac.bctype == BOUNDARY_CONDITIONS::INTERIOR || fac.bctype == BOUNDARY_CONDITIONS::PARALLEL_COM)
+                    continue;
+                std::span<const IDX> fac_nodes = fac.nodes_span();
+                bdy_data.insert(bdy_data.end(), {gel(fac.elemL), (IDX) fac.domain_type(), (IDX) fac.geometry_order(),
+                        (IDX) fac_nodes.size(), (IDX) fac.face_nr_l(), (IDX) fac.face_nr_r(),
+                        (IDX) fac.orientation_r(), (IDX) fac.bctype, (IDX) fac.bcflag});
+                for(IDX inode : fac_nodes) bdy_data.push_back(gnode(inode));
+            }
+
+            // the space to rebuild (the largest key over all ranks so ranks without elements agree)
+            int space_info[4] = {(int) fespace.type, -1, -1, -1};
+            if(fespace.element_batch_keys.size() > 0){
+                space_info[1] = (int) fespace.element_batch_keys[0].btype;
+                space_info[2] = (int) fespace.element_batch_keys[0].qtype;
+                space_info[3] = fespace.element_batch_keys[0].basis_order;
+            }
+            MPI_Allreduce(MPI_IN_PLACE, space_info, 4, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+            bool had_geo_factors = (fespace.geo_factors != nullptr);
+            bool had_ddg_factors = (fespace.ddg_factors != nullptr);
+            bool was_compact = fespace.is_compact();
+
+            // ==================================
+            // = Reassemble the mesh on rank 0  =
+            // ==================================
+            std::vector<int> counts;
+            std::vector<IDX> all_el_data = gather_to_root(el_data, counts);
+            std::vector<IDX> all_bdy_data = gather_to_root(bdy_data, counts);
+            std::vector<IDX> all_node_gidxs = gather_to_root(node_gidxs, counts);
+            std::vector<T> all_node_coord = gather_to_root(node_coord, counts);
+            std::vector<T> all_coeffs = gather_to_root(coeffs, counts);
+
+            AbstractMesh<T, IDX, ndim> gmesh{};
+            partition_weights<IDX> weights{};
+            std::vector<std::vector<T>> gcoeffs{};
+            if(myrank == 0){
+                IDX nnode = 0;
+                for(IDX ignode : all_node_gidxs) nnode = std::max(nnode, ignode + 1);
+                gmesh.coord.resize(nnode);
+                for(std::size_t i = 0; i < all_node_gidxs.size(); ++i){
+                    for(int idim = 0; idim < ndim; ++idim)
+                        gmesh.coord[all_node_gidxs[i]][idim] = all_node_coord[i * ndim + idim];
+                }
+
+                IDX nelem = 0;
+                for(std::size_t i = 0; i < all_el_data.size(); i += el_header_size + all_el_data[i + 3])
+                    nelem = std::max(nelem, all_el_data[i] + 1);
+                std::vector<std::vector<IDX>> ragged_conn_el(nelem);
+                std::vector<int> el_basis_order(nelem);
+                gmesh.el_transformations.resize(nelem);
+                weights.el_weights.resize(nelem);
+                gcoeffs.resize(nelem);
+                std::size_t icoeff = 0;
+                for(std::size_t i = 0; i < all_el_data.size(); i += el_header_size + all_el_data[i + 3]){
+                    IDX iel = all_el_data[i];
+                    gmesh.el_transformations[iel] = transformation_table<T, IDX, ndim>
+                        .get_transform((DOMAIN_TYPE) all_el_data[i + 1], all_el_data[i + 2]);
+                    ragged_conn_el[iel].assign(all_el_data.begin() + i + el_header_size,
+                            all_el_data.begin() + i + el_header_size + all_el_data[i + 3]);
+                    el_basis_order[iel] = all_el_data[i + 4];
+                    weights.el_weights[iel] = all_el_data[i + 5];
+                    gcoeffs[iel].assign(all_coeffs.begin() + icoeff, all_coeffs.begin() + icoeff + all_el_data[i + 6]);
+                    icoeff += all_el_data[i + 6];
+                }
+                gmesh.conn_el = util::crs<IDX, IDX>{ragged_conn_el};
+                gmesh.coord_els = util::crs<Point, IDX>{std::span{gmesh.conn_el.cols(), gmesh.conn_el.cols() + gmesh.conn_el.nrow() + 1}};
+                gmesh.update_coord_els();
+
+                // faces
+                gmesh.faces = hash_interior_faces<T, IDX, ndim>(gmesh.conn_el, gmesh.el_transformations);
+                gmesh.interiorFaceStart = 0;
+                gmesh.interiorFaceEnd = gmesh.faces.size();
+                gmesh.bdyFaceStart = gmesh.interiorFaceEnd;
+                for(std::size_t i = 0; i < all_bdy_data.size(); i += bdy_header_size + all_bdy_data[i + 3]){
+                    IDX iel = all_bdy_data[i];
+                    std::span<const IDX> fac_nodes{all_bdy_data.data() + i + bdy_header_size, (std::size_t) all_bdy_data[i + 3]};
+                    DOMAIN_TYPE domain_l = gmesh.el_transformations[iel]->domain_type;
+                    auto face_opt = make_face<T, IDX, ndim>((DOMAIN_TYPE) all_bdy_data[i + 1], domain_l, domain_l,
+                            all_bdy_data[i + 2], iel, -1, fac_nodes, all_bdy_data[i + 4], all_bdy_data[i + 5],
+                            all_bdy_data[i + 6], (BOUNDARY_CONDITIONS) all_bdy_data[i + 7], all_bdy_data[i + 8]);
+                    if(face_opt) {
+                        gmesh.faces.push_back(std::move(face_opt.value()));
+                    } else {
+                        util::AnomalyLog::log_anomaly(util::Anomaly{"could not find face", util::general_anomaly_tag{}});
+                    }
+                }
+                gmesh.bdyFaceEnd = gmesh.faces.size();
+
+                // trace weights from the basis order of the neighboring elements
+                weights.face_weights = estimate_partition_weights(gmesh, std::span<const int>{el_basis_order}).face_weights;
+            }
+
+            // ===============
+            // = Repartition =
+            // ===============
+            mesh = partition_mesh(gmesh, weights);
+            mesh.make_periodic_faces_interior();
+
+            // rebuild the finite element space on the new mesh
+            if(space_info[0] == (int) FESpaceType::SPACE_TYPE::ISOPARAMETRIC_H1){
+                fespace = FESpaceType{&mesh};
+            } else {
+                auto seq = NUMTOOL::TMP::make_range_sequence<int, 0, build_config::FESPACE_BUILD_PN>{};
+                NUMTOOL::TMP::invoke_at_index(seq, std::max(space_info[3], 0),
+                    [&]<int order_comp>{
+                        fespace = FESpaceType{&mesh, (FESPACE_ENUMS::FESPACE_BASIS_TYPE) space_info[1],
+                            (FESPACE_ENUMS::FESPACE_QUADRATURE) space_info[2], std::integral_constant<int, order_comp>{}};
+                        return 0;
+                    }
+                );
+            }
+            if(had_geo_factors) fespace.enable_geometric_factors();
+            if(had_ddg_factors) fespace.enable_ddg_factors();
+            if(was_compact) fespace.compact();
+
+            // =============================
+            // = Migrate the solution data =
+            // =============================
+            auto all_gel_idxs = gather_to_root(mesh.gel_idxs, counts);
+            std::vector<T> send_coeffs{};
+            std::vector<int> send_counts, send_displs;
+            if(myrank == 0){
+                send_counts.assign(nrank, 0);
+                send_displs.assign(nrank, 0);
+                std::size_t k = 0;
+                for(int irank = 0; irank < nrank; ++irank){
+                    send_displs[irank] = send_coeffs.size();
+                    for(int i = 0; i < counts[irank]; ++i, ++k){
+                        const std::vector<T>& el_coeffs = gcoeffs[all_gel_idxs[k]];
+                        send_coeffs.insert(send_coeffs.end(), el_coeffs.begin(), el_coeffs.end());
+                    }
+                    send_counts[irank] = send_coeffs.size() - send_displs[irank];
+                }
+            }
+            int recv_count;
+            MPI_Scatter(send_counts.data(), 1, MPI_INT, &recv_count, 1, MPI_INT, 0, MPI_COMM_WORLD);
+            std::vector<T> recv_coeffs(recv_count);
+            MPI_Scatterv(send_coeffs.data(), send_counts.data(), send_displs.data(), mpi_get_type<T>(),
+                    recv_coeffs.data(), recv_count, mpi_get_type<T>(), 0, MPI_COMM_WORLD);
+
+            const LayoutPolicy& layout = u.get_layout();
+            std::vector<T> u_data(layout.size());
+            fespan u_new{u_data.data(), layout};
+            std::size_t icoeff = 0;
+            for(IDX iel = 0; iel < mesh.nelem(); ++iel){
+                for(IDX idof = 0; idof < u_new.ndof(iel); ++idof){
+                    for(IDX iv = 0; iv < u_new.nv(); ++iv)
+                        u_new[iel, idof, iv] = recv_coeffs[icoeff++];
+                }
+            }
+            return u_data;
+        }
+#endif
+        // nothing to rebalance
+        return std::vector<T>(u.data(), u.data() + u.size());
+    }
+}
@@ -13,6 +13,7 @@
 #include <span>
 #include <string_view>
 #include <memory>
+#include <type_traits>
 
 #ifdef ICEICLE_USE_MPI
     #include <mpi.h>
@@ -165,6 +166,36 @@ namespace iceicle {
         return BOUNDARY_CONDITIONS::INTERIOR;
     }
 
+    /// @brief compile time tag for a boundary condition
+    template<BOUNDARY_CONDITIONS bc>
+    using bc_tag = std::integral_constant<BOUNDARY_CONDITIONS, bc>;
+
+    /**
+     * @brief call fcn with the compile time tag of a runtime boundary condition 
+     * fcn(bc_tag<bc>{}) so the branch on the boundary condition type is taken once 
+     * and kernels can specialize on it
+     */
+    template<class F>
+    constexpr auto dispatch_bctype(BOUNDARY_CONDITIONS bctype, F&& fcn) -> void {
+        using enum BOUNDARY_CONDITIONS;
+        switch(bctype){
+            case PERIODIC:           fcn(bc_tag<PERIODIC>{}); break;
+            case PARALLEL_COM:       fcn(bc_tag<PARALLEL_COM>{}); break;
+            case NEUMANN:            fcn(bc_tag<NEUMANN>{}); break;
+            case DIRICHLET:          fcn(bc_tag<DIRICHLET>{}); break;
+            case EXTRAPOLATION:      fcn(bc_tag<EXTRAPOLATION>{}); break;
+            case RIEMANN:            fcn(bc_tag<RIEMANN>{}); break;
+            case NO_SLIP_ISOTHERMAL: fcn(bc_tag<NO_SLIP_ISOTHERMAL>{}); break;
+            case SLIP_WALL:          fcn(bc_tag<SLIP_WALL>{}); break;
+            case WALL_GENERAL:       fcn(bc_tag<WALL_GENERAL>{}); break;
+            case INLET:              fcn(bc_tag<INLET>{}); break;
+            case OUTLET:             fcn(bc_tag<OUTLET>{}); break;
+            case SPACETIME_PAST:     fcn(bc_tag<SPACETIME_PAST>{}); break;
+            case SPACETIME_FUTURE:   fcn(bc_tag<SPACETIME_FUTURE>{}); break;
+            default:                 fcn(bc_tag<INTERIOR>{}); break;
+        }
+    }
+
     /// @brief encode a boundary condition flag for an interprocess face 
     /// in a way that is unique for each given rank + imleft combination
     /// @param mpi_rank the rank of the neighboring process on the face
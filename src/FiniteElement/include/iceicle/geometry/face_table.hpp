@@ -0,0 +1,266 @@
+/**
+ * @brief compact structure of arrays table of the faces of a mesh
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "Numtool/tmp_flow_control.hpp"
+#include "iceicle/build_config.hpp"
+#include "iceicle/crs.hpp"
+#include "iceicle/fe_definitions.hpp"
+#include "iceicle/geometry/face.hpp"
+#include "iceicle/geometry/hypercube_face.hpp"
+#include <array>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace iceicle {
+
+    /**
+     * @brief the geometric transformations of a concrete face type
+     * as a struct of function pointers (analogous to ElementTransformation)
+     * the face specific data (nodes and face number) is passed in from a FaceTable
+     */
+    template<class T, class IDX, int ndim>
+    struct FaceTransformation {
+
+        // type aliases
+        using Point = MATH::GEOMETRY::Point<T, ndim>;
+        using FacePoint = MATH::GEOMETRY::Point<T, ndim - 1>;
+        using JacobianType = NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, (std::size_t) ndim, (std::size_t) ndim - 1>;
+
+        /// @brief the domain type of the face
+        DOMAIN_TYPE domain_type;
+
+        /// @brief the polynomial order of the face geometry
+        int order;
+
+        /// @brief the number of nodes of the face
+        int nnode;
+
+        /// @brief transform from the face reference domain to the physical domain
+        ///
+        /// @param [in] nodes the face node indices
+        /// @param [in] face_nr_l the face number for the left element
+        /// @param [in] s the point in the face reference domain
+        /// @param [in] coord the node coordinates
+        /// @param [out] result the position in the physical domain
+        void (*transform)(const IDX* nodes, int face_nr_l, const FacePoint& s,
+                NodeArray<T, ndim>& coord, Point& result) = nullptr;
+
+        /// @brief the jacobian of the transformation from the face reference domain to the physical domain
+        ///
+        /// @param [in] coord the node coordinates
+        /// @param [in] nodes the face node indices
+        /// @param [in] face_nr_l the face number for the left element
+        /// @param [in] s the point in the face reference domain
+        /// @return the jacobian dx/ds
+        JacobianType (*jacobian)(NodeArray<T, ndim>& coord, const IDX* nodes,
+                int face_nr_l, const FacePoint& s) = nullptr;
+    };
+
+    /// @brief table of the face transformations for the concrete face types that support them
+    template<class T, class IDX, int ndim>
+    class FaceTransformationTable {
+        public:
+        std::array<FaceTransformation<T, IDX, ndim>, build_config::FESPACE_BUILD_GEO_PN + 1> hypercube_transforms;
+
+        FaceTransformationTable(){
+            if constexpr (ndim >= 2) {
+                NUMTOOL::TMP::constexpr_for_range<1, build_config::FESPACE_BUILD_GEO_PN + 1>(
+                    [&]<int order>{
+                        using FacePoint = FaceTransformation<T, IDX, ndim>::FacePoint;
+                        using Point = FaceTransformation<T, IDX, ndim>::Point;
+                        hypercube_transforms[order] = FaceTransformation<T, IDX, ndim>{
+                            .domain_type = DOMAIN_TYPE::HYPERCUBE,
+                            .order = order,
+                            .nnode = hypercube_trans<T, IDX, ndim, order>.n_nodes,
+                            .transform = [](const IDX* nodes, int face_nr_l, const FacePoint& s,
+                                    NodeArray<T, ndim>& coord, Point& result) -> void
+                            { hypercube_trans<T, IDX, ndim, order>.transform_physical(nodes, face_nr_l, s, coord, result); },
+                            .jacobian = [](NodeArray<T, ndim>& coord, const IDX* nodes,
+                                    int face_nr_l, const FacePoint& s)
+                            { return hypercube_trans<T, IDX, ndim, order>.Jacobian(coord, nodes, face_nr_l, s); }
+                        };
+                    }
+                );
+            }
+        }
+
+        /// @brief get the transformation for the concrete type of the given face
+        /// @return the transformation or nullptr if the face type does not have one
+        /// (face operations must go through the virtual interface)
+        auto get_transform(const Face<T, IDX, ndim>& face) noexcept
+        -> const FaceTransformation<T, IDX, ndim>*
+        {
+            const FaceTransformation<T, IDX, ndim>* result = nullptr;
+            if constexpr (ndim >= 2) {
+                NUMTOOL::TMP::constexpr_for_range<1, build_config::FESPACE_BUILD_GEO_PN + 1>(
+                    [&]<int order>{
+                        if(dynamic_cast<const HypercubeFace<T, IDX, ndim, order>*>(&face) != nullptr)
+                            result = &hypercube_transforms[order];
+                    }
+                );
+            }
+            return result;
+        }
+    };
+
+    template<class T, class IDX, int ndim>
+    inline static FaceTransformationTable<T, IDX, ndim> face_transformation_table{};
+
+    /**
+     * @brief structure of arrays table of the faces of a mesh
+     *
+     * The connectivity and boundary condition data of each face is stored contiguously
+     * and the face nodes are stored in a crs table
+     * so that traversals over faces do not need to go through each heap allocated Face.
+     *
+     * Faces are also grouped by concrete face type (face_groups) with a face transformation
+     * for each group so that the geometry of a group can be evaluated without virtual calls.
+     * Groups with no face transformation (group_transforms[igroup] == nullptr)
+     * must use the Face objects in the mesh.
+     *
+     * NOTE: this is a copy of the data in AbstractMesh::faces at the time of construction
+     */
+    template<class T, class IDX, int ndim>
+    struct FaceTable {
+        using face_t = Face<T, IDX, ndim>;
+        using Point = MATH::GEOMETRY::Point<T, ndim>;
+        using FacePoint = MATH::GEOMETRY::Point<T, ndim - 1>;
+        using JacobianType = typename FaceTransformation<T, IDX, ndim>::JacobianType;
+
+        /// @brief the left element of each face
+        std::vector<IDX> elemL{};
+
+        /// @brief the right element of each face
+        std::vector<IDX> elemR{};
+
+        /// @brief the face number of each face for the left element
+        std::vector<int> face_nr_l{};
+
+        /// @brief the face number of each face for the right element
+        std::vector<int> face_nr_r{};
+
+        /// @brief the orientation of each face for the right element
+        std::vector<int> orientation_r{};
+
+        /// @brief the boundary condition type of each face
+        std::vector<BOUNDARY_CONDITIONS> bctype{};
+
+        /// @brief the boundary condition flag of each face
+        std::vector<IDX> bcflag{};
+
+        /// @brief the node indices of each face
+        util::crs<IDX, IDX> face_nodes{};
+
+        /// @brief the faces grouped by concrete type, each row is a group of face indices
+        util::crs<IDX, IDX> face_groups{};
+
+        /// @brief the transformation for each group (nullptr if not available)
+        std::vector<const FaceTransformation<T, IDX, ndim>*> group_transforms{};
+
+        /// @brief the group of each face
+        std::vector<IDX> face_group{};
+
+        FaceTable() = default;
+
+        /// @brief build the table from a list of faces
+        /// @param faces the faces (i.e AbstractMesh::faces)
+        FaceTable(const std::vector<std::unique_ptr<face_t>>& faces)
+        : elemL(faces.size()), elemR(faces.size()), face_nr_l(faces.size()), face_nr_r(faces.size()),
+          orientation_r(faces.size()), bctype(faces.size()), bcflag(faces.size()), face_group(faces.size())
+        {
+            std::vector<std::vector<IDX>> nodes_ragged(faces.size());
+            std::vector<std::vector<IDX>> groups_ragged{};
+            for(std::size_t ifac = 0; ifac < faces.size(); ++ifac){
+                const face_t& fac = *faces[ifac];
+                elemL[ifac] = fac.elemL;
+                elemR[ifac] = fac.elemR;
+                face_nr_l[ifac] = fac.face_nr_l();
+                face_nr_r[ifac] = fac.face_nr_r();
+                orientation_r[ifac] = fac.orientation_r();
+                bctype[ifac] = fac.bctype;
+                bcflag[ifac] = fac.bcflag;
+                std::span<const IDX> nodes = fac.nodes_span();
+                nodes_ragged[ifac] = std::vector<IDX>{nodes.begin(), nodes.end()};
+
+                // group by concrete type (all faces without a transformation share the nullptr group)
+                const FaceTransformation<T, IDX, ndim>* trans
+                    = face_transformation_table<T, IDX, ndim>.get_transform(fac);
+                std::size_t igroup = 0;
+                while(igroup < group_transforms.size() && group_transforms[igroup] != trans) ++igroup;
+                if(igroup == group_transforms.size()){
+                    group_transforms.push_back(trans);
+                    groups_ragged.emplace_back();
+                }
+                groups_ragged[igroup].push_back(ifac);
+                face_group[ifac] = igroup;
+            }
+            face_nodes = util::crs<IDX, IDX>{nodes_ragged};
+            face_groups = util::crs<IDX, IDX>{groups_ragged};
+        }
+
+        /// @brief update the table entries of a single face that was replaced or modified
+        /// @param ifac the index of the face 
+        /// @param fac the face at that index (i.e *AbstractMesh::faces[ifac])
+        auto update_face(IDX ifac, const face_t& fac) -> void {
+            elemL[ifac] = fac.elemL;
+            elemR[ifac] = fac.elemR;
+            face_nr_l[ifac] = fac.face_nr_l();
+            face_nr_r[ifac] = fac.face_nr_r();
+            orientation_r[ifac] = fac.orientation_r();
+            bctype[ifac] = fac.bctype;
+            bcflag[ifac] = fac.bcflag;
+            face_nodes.replace_row(ifac, fac.nodes_span());
+
+            // move the face to the group of its (possibly) new concrete type
+            const FaceTransformation<T, IDX, ndim>* trans
+                = face_transformation_table<T, IDX, ndim>.get_transform(fac);
+            IDX igroup_old = face_group[ifac];
+            if(group_transforms[igroup_old] == trans) return;
+            std::vector<IDX> old_group{};
+            for(IDX jfac : face_groups.rowspan(igroup_old)) if(jfac != ifac) old_group.push_back(jfac);
+            face_groups.replace_row(igroup_old, old_group);
+
+            std::size_t igroup = 0;
+            while(igroup < group_transforms.size() && group_transforms[igroup] != trans) ++igroup;
+            if(igroup == group_transforms.size()){
+                // add a new group row
+                group_transforms.push_back(trans);
+                std::vector<std::vector<IDX>> groups_ragged(face_groups.nrow() + 1);
+                for(std::size_t jgroup = 0; jgroup < face_groups.nrow(); ++jgroup){
+                    std::span<const IDX> row = face_groups.rowspan(jgroup);
+                    groups_ragged[jgroup] = std::vector<IDX>{row.begin(), row.end()};
+                }
+                face_groups = util::crs<IDX, IDX>{groups_ragged};
+            }
+            std::span<const IDX> new_row = face_groups.rowspan(igroup);
+            std::vector<IDX> new_group{new_row.begin(), new_row.end()};
+            new_group.insert(std::ranges::lower_bound(new_group, ifac), ifac);
+            face_groups.replace_row(igroup, new_group);
+            face_group[ifac] = igroup;
+        }
+
+        /// @brief the number of faces in the table
+        [[nodiscard]] auto nfac() const noexcept -> std::size_t { return elemL.size(); }
+
+        /// @brief the node indices of the given face
+        [[nodiscard]] auto nodes(IDX ifac) const noexcept -> std::span<const IDX>
+        { return face_nodes.rowspan(ifac); }
+
+        /// @brief the transformation for the given face (nullptr if it must use the Face object)
+        [[nodiscard]] auto transformation(IDX ifac) const noexcept -> const FaceTransformation<T, IDX, ndim>*
+        { return group_transforms[face_group[ifac]]; }
+
+        /// @brief transform from the face reference domain to the physical domain
+        /// NOTE: the face must have a transformation
+        auto transform(IDX ifac, const FacePoint& s, NodeArray<T, ndim>& coord, Point& result) const -> void
+        { transformation(ifac)->transform(nodes(ifac).data(), face_nr_l[ifac], s, coord, result); }
+
+        /// @brief the jacobian of the face transformation
+        /// NOTE: the face must have a transformation
+        auto jacobian(IDX ifac, NodeArray<T, ndim>& coord, const FacePoint& s) const -> JacobianType
+        { return transformation(ifac)->jacobian(coord, nodes(ifac).data(), face_nr_l[ifac], s); }
+    };
+}
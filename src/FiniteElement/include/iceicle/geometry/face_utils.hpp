@@ -304,6 +304,38 @@ namespace iceicle {
         }
     }
 
+    /// @brief make an interior face from the face identifiers of two elements
+    /// NOTE: we use the minimum geometry order for the face so that the intersection of 
+    /// different order elements results in well defined mappings from both sides.
+    /// (The higher order element will always have a well-posed representation of lower order geometry)
+    /// This does, however, require the higher order element to conform to the lower order geometry
+    template<class T, class IDX, int ndim>
+    [[nodiscard]] inline constexpr 
+    auto make_face_from_info(
+        IDX elemL,
+        IDX elemR,
+        ElementTransformation<T, IDX, ndim> *transL,
+        ElementTransformation<T, IDX, ndim> *transR,
+        std::span<IDX> el_nodesL,
+        std::span<IDX> el_nodesR,
+        DOMAIN_TYPE fac_domn,
+        int face_nr_l,
+        int face_nr_r,
+        int orient_r,
+        BOUNDARY_CONDITIONS bctype,
+        int bcflag
+    ) noexcept -> std::optional< std::unique_ptr< Face<T, IDX, ndim> > > {
+        if(transL->order <= transR->order) {
+            std::vector<IDX> face_nodes = transL->get_face_nodes(face_nr_l, el_nodesL);
+            return make_face<T, IDX, ndim>(fac_domn, transL->domain_type, transR->domain_type, transL->order,
+                    elemL, elemR, face_nodes, face_nr_l, face_nr_r, orient_r, bctype, bcflag);
+        } else {
+            std::vector<IDX> face_nodes = transR->get_face_nodes(face_nr_r, el_nodesR);
+            return make_face<T, IDX, ndim>(fac_domn, transL->domain_type, transR->domain_type, transR->order,
+                    elemL, elemR, face_nodes, face_nr_l, face_nr_r, orient_r, bctype, bcflag);
+        }
+    }
+
     /// @brief Make the face that corresponds to the intersection of the two given elements 
     /// or std::nullopt if there is no intersection of the given elements
     /// @param elemL the index of the left element 
@@ -332,24 +364,65 @@ namespace iceicle {
         auto face_info_match = intersect_face_info(transL, transR, el_nodesL, el_nodesR);
         if(face_info_match){
             auto [fac_domn, face_nr_l, face_nr_r, orient_r] = face_info_match.value();
-            // NOTE: we use the minimum geometry order for the face so that the intersection of 
-            // different order elements results in well defined mappings from both sides.
-            // (The higher order element will always have a well-posed representation of lower order geometry)
-            // This does, however, require the higher order element to conform to the lower order geometry
-            if(transL->order <= transR->order) {
-                std::vector<IDX> face_nodes = transL->get_face_nodes(face_nr_l, el_nodesL);
-                return make_face<T, IDX, ndim>(fac_domn, transL->domain_type, transR->domain_type, transL->order,
-                        elemL, elemR, face_nodes, face_nr_l, face_nr_r, orient_r, bctype, bcflag);
-            } else {
-                std::vector<IDX> face_nodes = transR->get_face_nodes(face_nr_r, el_nodesR);
-                return make_face<T, IDX, ndim>(fac_domn, transL->domain_type, transR->domain_type, transR->order,
-                        elemL, elemR, face_nodes, face_nr_l, face_nr_r, orient_r, bctype, bcflag);
-            }
+            return make_face_from_info<T, IDX, ndim>(elemL, elemR, transL, transR, el_nodesL, el_nodesR,
+                    fac_domn, face_nr_l, face_nr_r, orient_r, bctype, bcflag);
         } else {
             return std::nullopt;
         }
     }
 
+    /// @brief Make the face between two elements when the matching face numbers are already known 
+    /// (i.e from matching face vertices)
+    /// or std::nullopt if the faces do not match
+    /// @param elemL the index of the left element 
+    /// @param elemR the index of the right element 
+    /// @param transL the transformation for the left element domain
+    /// @param transR the transformation for the right element domain
+    /// @param el_nodesL the element node indices for the left element
+    /// @param el_nodesR the element node indices for the right element
+    /// @param face_nr_l the face number of the face for the left element 
+    /// @param face_nr_r the face number of the face for the right element
+    /// @param bctype the boundary condition type 
+    /// @param bcflag the integer flag for the boundary condition
+    /// @return a pointer to the created face if applicable
+    template<class T, class IDX, int ndim>
+    [[nodiscard]] inline constexpr 
+    auto make_face(
+        IDX elemL,
+        IDX elemR,
+        ElementTransformation<T, IDX, ndim> *transL,
+        ElementTransformation<T, IDX, ndim> *transR,
+        std::span<IDX> el_nodesL,
+        std::span<IDX> el_nodesR,
+        int face_nr_l,
+        int face_nr_r,
+        BOUNDARY_CONDITIONS bctype = BOUNDARY_CONDITIONS::INTERIOR,
+        int bcflag = 0
+    ) noexcept -> std::optional< std::unique_ptr< Face<T, IDX, ndim> > > {
+        DOMAIN_TYPE domn_type = transL->face_domain_type(face_nr_l);
+        if(domn_type != transR->face_domain_type(face_nr_r)){
+            util::AnomalyLog::log_anomaly(util::Anomaly{"All vertices match, but face domain types differ", util::general_anomaly_tag{}});
+            return std::nullopt;
+        }
+
+        std::vector<IDX> face_vert_l{transL->get_face_vert(face_nr_l, el_nodesL)};
+        std::vector<IDX> face_vert_r{transR->get_face_vert(face_nr_r, el_nodesR)};
+        switch(domn_type){
+            case DOMAIN_TYPE::HYPERCUBE:
+            {
+                int orient_r = hypercube_orient_trans<T, IDX, ndim>.getOrientation(face_vert_l.data(), face_vert_r.data());
+                return make_face_from_info<T, IDX, ndim>(elemL, elemR, transL, transR, el_nodesL, el_nodesR,
+                        domn_type, face_nr_l, face_nr_r, orient_r, bctype, bcflag);
+            }
+
+            default:
+            {
+                util::AnomalyLog::log_anomaly(util::Anomaly{"orientation deduction not supported for the given domain type", util::general_anomaly_tag{}});
+                return std::nullopt;
+            }
+        }
+    }
+
     /**
      * @brief get the normal vector at a given point 
      * @param face the face to get the normal vector to
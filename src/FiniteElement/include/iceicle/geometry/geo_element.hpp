@@ -12,6 +12,7 @@
 #include <Numtool/fixed_size_tensor.hpp>
 #include <mdspan/mdspan.hpp>
 #include <memory>
+#include <span>
 
 namespace iceicle {
 
@@ -70,6 +71,12 @@ namespace iceicle {
         /// @return vector of coordinates for the nodes of this element
         std::vector<Point> (*get_el_coord)(const NodeArray<T, ndim>& coord, const IDX* nodes) = nullptr;
 
+        /// @brief get the weights that place the interior nodes (not on any face) 
+        /// from the nodes on the faces (nullptr if there are no interior nodes)
+        /// 
+        /// @return the weights for every interior node, grouped by interior node
+        std::span<const interior_node_weight<T>> (*regularization_stencil)() = nullptr;
+
         // =============================
         // = Coordinate Transformation =
         // =============================
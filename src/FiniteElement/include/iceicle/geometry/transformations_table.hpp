@@ -26,6 +26,7 @@ namespace iceicle {
                         .nnode = transformations::hypercube<T, IDX, ndim, order>::nnode,
                         .nfac = transformations::hypercube<T, IDX, ndim, order>::nfac,
                         .get_el_coord = transformations::hypercube<T, IDX, ndim, order>::get_el_coord,
+                        .regularization_stencil = transformations::hypercube<T, IDX, ndim, order>::regularization_stencil,
                         .transform = transformations::hypercube<T, IDX, ndim, order>::transform,
                         .jacobian = transformations::hypercube<T, IDX, ndim, order>::jacobian,
                         .hessian = transformations::hypercube<T, IDX, ndim, order>::hessian,
@@ -0,0 +1,360 @@
+/**
+ * @brief generation of uniform meshes directly on each process
+ * (instead of generating the global mesh on one process and partitioning it)
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/fe_definitions.hpp"
+#include "iceicle/geometry/face.hpp"
+#include "iceicle/geometry/hypercube_face.hpp"
+#include "iceicle/geometry/transformations_table.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/mesh/mesh.hpp"
+#include "iceicle/mesh/mesh_utils.hpp"
+#include "iceicle/transformations/HypercubeTransformations.hpp"
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace iceicle {
+
+    /**
+     * @brief choose the number of blocks in each direction
+     * to split a uniform mesh into one block per process
+     *
+     * This minimizes the number of faces between the blocks
+     * with at most one block per element in each direction,
+     * and at least two element layers per block in periodic directions that are split
+     * (so the two neighbors across the periodic boundary are different elements)
+     *
+     * @param nelem the number of elements in each direction
+     * @param periodic for each direction, true if the mesh is periodic in that direction
+     * @param nrank the number of blocks
+     * @return the number of blocks in each direction (with product nrank)
+     *         or std::nullopt if the mesh cannot be split into nrank blocks
+     */
+    template<class IDX, int ndim>
+    auto uniform_rank_grid(
+        const std::array<IDX, ndim>& nelem,
+        const std::array<bool, ndim>& periodic,
+        int nrank
+    ) -> std::optional<std::array<int, ndim>> {
+        std::optional<std::array<int, ndim>> best{};
+        double best_cost = std::numeric_limits<double>::max();
+        std::array<int, ndim> nblock{};
+
+        // the number of faces on the cuts between blocks
+        auto cut_faces = [&]{
+            double cost = 0;
+            for(int idim = 0; idim < ndim; ++idim){
+                double nface_plane = 1;
+                for(int jdim = 0; jdim < ndim; ++jdim) if(jdim != idim) nface_plane *= nelem[jdim];
+                int ncut = (nblock[idim] == 1) ? 0 : ((periodic[idim]) ? nblock[idim] : nblock[idim] - 1);
+                cost += ncut * nface_plane;
+            }
+            return cost;
+        };
+
+        // try every factorization of nrank
+        auto factor = [&](auto&& self, int idim, int remaining) -> void {
+            if(idim < ndim - 1){
+                for(int n = 1; n <= remaining; ++n) if(remaining % n == 0){
+                    nblock[idim] = n;
+                    self(self, idim + 1, remaining / n);
+                }
+                return;
+            }
+            nblock[idim] = remaining;
+            for(int jdim = 0; jdim < ndim; ++jdim){
+                if(nblock[jdim] > nelem[jdim]) return;
+                if(periodic[jdim] && nblock[jdim] > 1 && nelem[jdim] / nblock[jdim] < 2) return;
+            }
+            double cost = cut_faces();
+            if(cost < best_cost){
+                best_cost = cost;
+                best = nblock;
+            }
+        };
+        factor(factor, 0, nrank);
+        return best;
+    }
+
+    /**
+     * @brief generate the block of a uniform mesh of linear hypercubes owned by this process
+     *
+     * The elements are split into a cartesian grid of blocks (see uniform_rank_grid)
+     * ordered lexicographically (first direction fastest) by rank.
+     * Each process generates its block from the 1D node coordinates of the global mesh
+     * as AbstractMesh(nodes_1d, 1, bctypes, bcflags) would,
+     * and forms the PARALLEL_COM faces and communicated elements with its neighbors
+     * from the block structure, so no process holds the global mesh and no communication is needed.
+     * The result has the layout of partition_mesh (interior faces, PARALLEL_COM faces, then boundary faces)
+     * with gel_idxs and gnode_idxs in the numbering of the global uniform mesh.
+     *
+     * Periodic directions that are split are connected with PARALLEL_COM faces
+     * to halo elements translated by the period,
+     * otherwise the periodic faces are kept for make_periodic_faces_interior().
+     *
+     * @param nodes_1d the node coordinates in each direction of the global mesh
+     * @param bctypes the boundary conditions of each side of the domain (see AbstractMesh)
+     * @param bcflags the boundary condition flags of each side of the domain
+     * @param myrank the block to generate
+     * @param nrank the number of blocks
+     * @return the mesh of the block, or std::nullopt if the mesh cannot be split into nrank blocks
+     */
+    template<class T, class IDX, int ndim,
+        std::ranges::random_access_range R_bctype, std::ranges::random_access_range R_bcflags>
+    auto distributed_uniform_mesh(
+        const std::array<std::vector<T>, ndim>& nodes_1d,
+        R_bctype&& bctypes,
+        R_bcflags&& bcflags,
+        int myrank = mpi::mpi_world_rank(),
+        int nrank = std::max(mpi::mpi_world_size(), 1)
+    ) -> std::optional<AbstractMesh<T, IDX, ndim>> {
+        using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+        using Point = MATH::GEOMETRY::Point<T, ndim>;
+        using FaceType = HypercubeFace<T, IDX, ndim, 1>;
+        using global_index_type = AbstractMesh<T, IDX, ndim>::global_index_type;
+        static constexpr int nfacevert = MATH::power_T<2, ndim-1>::value;
+
+        std::array<IDX, ndim> gnelem;
+        std::array<bool, ndim> periodic;
+        for(int idim = 0; idim < ndim; ++idim){
+            gnelem[idim] = nodes_1d[idim].size() - 1;
+            periodic[idim] = bctypes[idim] == BOUNDARY_CONDITIONS::PERIODIC;
+        }
+        std::optional<std::array<int, ndim>> nblock_opt = uniform_rank_grid<IDX, ndim>(gnelem, periodic, nrank);
+        if(!nblock_opt){
+            util::AnomalyLog::log_anomaly(util::Anomaly{"cannot split the uniform mesh into "
+                    + std::to_string(nrank) + " blocks", util::general_anomaly_tag{}});
+            return std::nullopt;
+        }
+        std::array<int, ndim> nblock = nblock_opt.value();
+
+        // the position of a block in the block grid and the range of elements in each direction
+        auto block_coord = [&](int irank){
+            std::array<int, ndim> c;
+            for(int idim = 0; idim < ndim; ++idim){
+                c[idim] = irank % nblock[idim];
+                irank /= nblock[idim];
+            }
+            return c;
+        };
+        auto block_rank = [&](const std::array<int, ndim>& c){
+            int irank = 0;
+            for(int idim = ndim - 1; idim >= 0; --idim) irank = irank * nblock[idim] + c[idim];
+            return irank;
+        };
+        auto block_lo = [&](int idim, int c) -> IDX
+        { return (IDX) ((long long) c * gnelem[idim] / nblock[idim]); };
+
+        std::array<int, ndim> c = block_coord(myrank);
+        std::array<IDX, ndim> lo, nelem_block, stride_el, stride_node;
+        for(int idim = 0; idim < ndim; ++idim){
+            lo[idim] = block_lo(idim, c[idim]);
+            nelem_block[idim] = block_lo(idim, c[idim] + 1) - lo[idim];
+        }
+        global_index_type gstride_el_acc = 1, gstride_node_acc = 1;
+        IDX stride_el_acc = 1, stride_node_acc = 1;
+        std::array<global_index_type, ndim> gstride_el, gstride_node;
+        for(int idim = 0; idim < ndim; ++idim){
+            stride_el[idim] = stride_el_acc;
+            stride_node[idim] = stride_node_acc;
+            gstride_el[idim] = gstride_el_acc;
+            gstride_node[idim] = gstride_node_acc;
+            stride_el_acc *= nelem_block[idim];
+            stride_node_acc *= nelem_block[idim] + 1;
+            gstride_el_acc *= gnelem[idim];
+            gstride_node_acc *= gnelem[idim] + 1;
+        }
+
+        // === generate the block ===
+        // sides shared with another block are generated as placeholder PARALLEL_COM faces
+        std::array<std::vector<T>, ndim> local_nodes_1d;
+        Tensor<BOUNDARY_CONDITIONS, 2 * ndim> local_bctypes;
+        Tensor<int, 2 * ndim> local_bcflags;
+        for(int idim = 0; idim < ndim; ++idim){
+            local_nodes_1d[idim].assign(nodes_1d[idim].begin() + lo[idim],
+                    nodes_1d[idim].begin() + lo[idim] + nelem_block[idim] + 1);
+            bool shared_neg = c[idim] > 0 || (periodic[idim] && nblock[idim] > 1);
+            bool shared_pos = c[idim] < nblock[idim] - 1 || (periodic[idim] && nblock[idim] > 1);
+            local_bctypes[idim] = (shared_neg) ? BOUNDARY_CONDITIONS::PARALLEL_COM : bctypes[idim];
+            local_bcflags[idim] = (shared_neg) ? 0 : bcflags[idim];
+            local_bctypes[ndim + idim] = (shared_pos) ? BOUNDARY_CONDITIONS::PARALLEL_COM : bctypes[ndim + idim];
+            local_bcflags[ndim + idim] = (shared_pos) ? 0 : bcflags[ndim + idim];
+        }
+        AbstractMesh<T, IDX, ndim> mesh{local_nodes_1d, 1, local_bctypes, local_bcflags};
+        mesh.el_send_list = std::vector<std::vector<IDX>>(nrank);
+        mesh.el_recv_list = std::vector<std::vector<IDX>>(nrank);
+        mesh.communicated_elements.clear();
+        mesh.communicated_elements.resize(nrank);
+
+        // global indices
+        mesh.gel_idxs.resize(mesh.nelem());
+        for(IDX iel = 0; iel < mesh.nelem(); ++iel){
+            global_index_type ig = 0;
+            for(int idim = 0; idim < ndim; ++idim)
+                ig += (lo[idim] + (iel / stride_el[idim]) % nelem_block[idim]) * gstride_el[idim];
+            mesh.gel_idxs[iel] = ig;
+        }
+        mesh.gnode_idxs.resize(mesh.n_nodes());
+        for(IDX inode = 0; inode < mesh.n_nodes(); ++inode){
+            global_index_type ig = 0;
+            for(int idim = 0; idim < ndim; ++idim)
+                ig += (lo[idim] + (inode / stride_node[idim]) % (nelem_block[idim] + 1)) * gstride_node[idim];
+            mesh.gnode_idxs[inode] = ig;
+        }
+
+        // === halo nodes and elements ===
+        transformations::HypercubeElementTransformation<T, IDX, ndim, 1> trans{};
+
+        // the local node at the given block node ordinates
+        // (outside the block these are halo nodes which are added on first use)
+        std::map<std::array<IDX, ndim>, IDX> halo_nodes{};
+        auto local_node = [&](const std::array<IDX, ndim>& ijk) -> IDX {
+            bool inside = true;
+            for(int idim = 0; idim < ndim; ++idim)
+                inside = inside && ijk[idim] >= 0 && ijk[idim] <= nelem_block[idim];
+            if(inside){
+                IDX inode = 0;
+                for(int idim = 0; idim < ndim; ++idim) inode += ijk[idim] * stride_node[idim];
+                return inode;
+            }
+            auto it = halo_nodes.find(ijk);
+            if(it != halo_nodes.end()) return it->second;
+
+            // across periodic boundaries the global node wraps around
+            // and the coordinates are translated by the period
+            Point x;
+            global_index_type ig = 0;
+            for(int idim = 0; idim < ndim; ++idim){
+                IDX inode_g = lo[idim] + ijk[idim];
+                T period = nodes_1d[idim].back() - nodes_1d[idim].front();
+                if(inode_g < 0){
+                    inode_g += gnelem[idim];
+                    x[idim] = nodes_1d[idim][inode_g] - period;
+                } else if(inode_g > gnelem[idim]){
+                    inode_g -= gnelem[idim];
+                    x[idim] = nodes_1d[idim][inode_g] + period;
+                } else {
+                    x[idim] = nodes_1d[idim][inode_g];
+                }
+                ig += inode_g * gstride_node[idim];
+            }
+            IDX inode = mesh.coord.size();
+            mesh.coord.push_back(x);
+            mesh.gnode_idxs.push_back(ig);
+            halo_nodes.emplace(ijk, inode);
+            return inode;
+        };
+
+        // the halo elements from each rank by their index on that rank
+        std::vector<std::map<IDX, CommElementInfo<T, IDX, ndim>>> halo_elements(nrank);
+
+        for(IDX ifac = mesh.bdyFaceStart; ifac < mesh.bdyFaceEnd; ++ifac){
+            if(mesh.faces[ifac]->bctype != BOUNDARY_CONDITIONS::PARALLEL_COM) continue;
+            IDX iel = mesh.faces[ifac]->elemL;
+            int idim = mesh.faces[ifac]->face_nr_l() % ndim;
+            bool positive = mesh.faces[ifac]->face_nr_l() >= ndim;
+
+            std::array<IDX, ndim> ijk;
+            for(int jdim = 0; jdim < ndim; ++jdim) ijk[jdim] = (iel / stride_el[jdim]) % nelem_block[jdim];
+
+            // the neighboring block and the index of the neighbor element in that block
+            std::array<int, ndim> c_other = c;
+            c_other[idim] = (c[idim] + ((positive) ? 1 : -1) + nblock[idim]) % nblock[idim];
+            int rank_other = block_rank(c_other);
+            IDX jel = 0, stride_other = 1;
+            for(int jdim = 0; jdim < ndim; ++jdim){
+                IDX n_other = block_lo(jdim, c_other[jdim] + 1) - block_lo(jdim, c_other[jdim]);
+                IDX ijk_other = (jdim != idim) ? ijk[jdim] : ((positive) ? 0 : n_other - 1);
+                jel += ijk_other * stride_other;
+                stride_other *= n_other;
+            }
+
+            // the nodes of the neighbor element in this block
+            std::array<IDX, ndim> ijk_halo = ijk;
+            ijk_halo[idim] = (positive) ? nelem_block[idim] : -1;
+            std::vector<IDX> halo_conn(trans.n_nodes());
+            for(int inode = 0; inode < trans.n_nodes(); ++inode){
+                std::array<IDX, ndim> ijk_node;
+                for(int jdim = 0; jdim < ndim; ++jdim)
+                    ijk_node[jdim] = ijk_halo[jdim] + trans.tensor_prod.ijk_poin[inode][jdim];
+                halo_conn[inode] = local_node(ijk_node);
+            }
+            if(!halo_elements[rank_other].contains(jel)){
+                std::vector<Point> halo_coord{};
+                for(IDX inode : halo_conn) halo_coord.push_back(mesh.coord[inode]);
+                halo_elements[rank_other].emplace(jel, CommElementInfo<T, IDX, ndim>{
+                    transformation_table<T, IDX, ndim>.get_transform(DOMAIN_TYPE::HYPERCUBE, 1),
+                    halo_conn, halo_coord});
+            }
+            mesh.el_send_list[rank_other].push_back(iel);
+            mesh.el_recv_list[rank_other].push_back(jel);
+
+            // the lower element in the global mesh is the left element
+            IDX elemL = (positive) ? iel : jel;
+            IDX elemR = (positive) ? jel : iel;
+            const IDX* nodesL = (positive) ? &mesh.conn_el[iel, 0] : halo_conn.data();
+            const IDX* nodesR = (positive) ? halo_conn.data() : &mesh.conn_el[iel, 0];
+            int face_nr_l = ndim + idim;
+            int face_nr_r = idim;
+            Tensor<IDX, FaceType::trans.n_nodes> face_nodes;
+            trans.get_face_nodes(face_nr_l, nodesL, face_nodes.data());
+            IDX vert_l[nfacevert];
+            IDX vert_r[nfacevert];
+            trans.get_face_vert(face_nr_l, nodesL, vert_l);
+            trans.get_face_vert(face_nr_r, nodesR, vert_r);
+            int orient_r = FaceType::orient_trans.getOrientation(vert_l, vert_r);
+
+            mesh.faces[ifac] = std::make_unique<FaceType>(elemL, elemR, face_nodes, face_nr_l, face_nr_r,
+                orient_r, BOUNDARY_CONDITIONS::PARALLEL_COM, encode_mpi_bcflag(rank_other, positive));
+        }
+
+        // the element lists are sorted and the communicated elements follow the receive order
+        for(int irank = 0; irank < nrank; ++irank){
+            for(std::vector<IDX>* list : {&mesh.el_send_list[irank], &mesh.el_recv_list[irank]}){
+                std::ranges::sort(*list);
+                auto unique_subrange = std::ranges::unique(*list);
+                list->erase(unique_subrange.begin(), unique_subrange.end());
+            }
+            for(auto& [jel, comm_el] : halo_elements[irank])
+                mesh.communicated_elements[irank].push_back(std::move(comm_el));
+        }
+
+        // === reorganize the faces as partition_mesh (interior, PARALLEL_COM, boundary) ===
+        std::vector<IDX> new_index(mesh.faces.size());
+        std::vector<std::unique_ptr<Face<T, IDX, ndim>>> reordered{};
+        reordered.reserve(mesh.faces.size());
+        for(IDX ifac = 0; ifac < mesh.interiorFaceEnd; ++ifac){
+            new_index[ifac] = reordered.size();
+            reordered.push_back(std::move(mesh.faces[ifac]));
+        }
+        for(bool parallel : {true, false}){
+            for(IDX ifac = mesh.bdyFaceStart; ifac < mesh.bdyFaceEnd; ++ifac){
+                if((mesh.faces[ifac]->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) != parallel) continue;
+                new_index[ifac] = reordered.size();
+                reordered.push_back(std::move(mesh.faces[ifac]));
+            }
+        }
+        mesh.faces = std::move(reordered);
+        mesh.bdyFaceStart = mesh.interiorFaceEnd;
+        mesh.bdyFaceEnd = mesh.faces.size();
+        for(IDX ifac = mesh.bdyFaceStart; ifac < mesh.bdyFaceEnd; ++ifac){
+            if(mesh.faces[ifac]->bctype == BOUNDARY_CONDITIONS::PERIODIC)
+                mesh.faces[ifac]->bcflag = new_index[mesh.faces[ifac]->bcflag];
+        }
+
+        // set up the additional connectivity for the halo nodes and new faces
+        mesh.elsup = to_elsup(mesh.conn_el, mesh.n_nodes());
+        update_facsuel(mesh);
+        return std::optional{std::move(mesh)};
+    }
+}
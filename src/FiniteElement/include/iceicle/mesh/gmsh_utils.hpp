@@ -1,5 +1,6 @@
 /// @brief Utilities for dealing with gmsh input files 
 /// @author Gianni Absillis (gabsill@ncsu.edu)
+#pragma once
 
 #include "iceicle/fe_definitions.hpp"
 #include "iceicle/geometry/face.hpp"
@@ -8,13 +9,19 @@
 #include "iceicle/geometry/transformations_table.hpp"
 #include "iceicle/mesh/mesh.hpp"
 #include "iceicle/anomaly_log.hpp"
+#include "iceicle/mapped_file.hpp"
 #include "iceicle/mesh/mesh_utils.hpp"
 #include "iceicle/string_utils.hpp"
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <istream>
 #include <sstream>
 #include <list>
+#include <span>
 #include <string>
+#include <string_view>
 #include <map>
 
 namespace iceicle {
@@ -54,19 +61,55 @@ namespace iceicle {
             std::size_t nvolumes;
         };
 
+        /// @brief flat map from entity tags to the physical tags of each entity
+        struct EntityTagMap {
+            /// @brief the entity tags
+            std::vector<std::size_t> entity_tags{};
+
+            /// @brief the start of the physical tags for each entity (crs layout)
+            std::vector<std::size_t> phys_offsets{0};
+
+            /// @brief the physical tags for all entities
+            std::vector<std::size_t> phys_tags{};
+
+            /// @brief if the entity tags were added in ascending order (gmsh writes them this way)
+            bool ascending = true;
+
+            /// @brief add an entity and its physical tags
+            template<std::ranges::range R>
+            auto add(std::size_t entity_tag, R&& tags) -> void {
+                if(entity_tags.size() > 0 && entity_tag < entity_tags.back()) ascending = false;
+                entity_tags.push_back(entity_tag);
+                for(auto tag : tags) phys_tags.push_back(tag);
+                phys_offsets.push_back(phys_tags.size());
+            }
+
+            /// @brief get the physical tags of the given entity (empty if not found)
+            [[nodiscard]] inline
+            auto find(std::size_t entity_tag) const -> std::span<const std::size_t> {
+                auto it = (ascending) 
+                    ? std::lower_bound(entity_tags.begin(), entity_tags.end(), entity_tag)
+                    : std::find(entity_tags.begin(), entity_tags.end(), entity_tag);
+                if(it == entity_tags.end() || *it != entity_tag) return std::span<const std::size_t>{};
+                std::size_t ientity = std::distance(entity_tags.begin(), it);
+                return std::span<const std::size_t>{phys_tags.data() + phys_offsets[ientity],
+                    phys_tags.data() + phys_offsets[ientity + 1]};
+            }
+        };
+
         ///@brief maps for entities to their corresponding tags
         /// The first tag will be used to define the boundary condition
         struct TagMaps {
-            std::map<std::size_t, std::vector<std::size_t>> pt_map;
-            std::map<std::size_t, std::vector<std::size_t>> curv_map;
-            std::map<std::size_t, std::vector<std::size_t>> surf_map;
-            std::map<std::size_t, std::vector<std::size_t>> vol_map;
+            EntityTagMap pt_map;
+            EntityTagMap curv_map;
+            EntityTagMap surf_map;
+            EntityTagMap vol_map;
 
             /// @brief given the dimensionality return the tag map of entities of that dimensionality 
             /// or an empty map if not applicable
             inline constexpr
             auto map_by_dimensionality(int ndim) const
-            -> const std::map<std::size_t, std::vector<std::size_t>>&
+            -> const EntityTagMap&
             {
                 switch(ndim){
                     case 0:
@@ -78,7 +121,7 @@ namespace iceicle {
                     case 3:
                         return vol_map;
                     default:
-                        static std::map<std::size_t, std::vector<std::size_t>> empty{};
+                        static EntityTagMap empty{};
                         return empty;
                 }
             }
@@ -107,11 +150,11 @@ namespace iceicle {
                 std::size_t nphys_tag;
                 std::istringstream linestream{line};
                 linestream >> pt_tag >> x >> y >> z >> nphys_tag;
+                std::vector<std::size_t> phys_tags(nphys_tag);
                 for(int itag = 0; itag < nphys_tag; ++itag){
-                    int tag;
-                    linestream >> tag;
-                    tag_maps.pt_map[pt_tag].push_back(tag);
+                    linestream >> phys_tags[itag];
                 }
+                tag_maps.pt_map.add(pt_tag, phys_tags);
             }
 
             // get the curve tags (omit bounding points info)
@@ -121,11 +164,11 @@ namespace iceicle {
                 std::size_t nphys_tag;
                 std::istringstream linestream{line};
                 linestream >> curv_tag >> xmin >> ymin >> zmin >> xmax >> ymax >> zmax >> nphys_tag;
+                std::vector<std::size_t> phys_tags(nphys_tag);
                 for(int itag = 0; itag < nphys_tag; ++itag){
-                    int tag;
-                    linestream >> tag;
-                    tag_maps.curv_map[curv_tag].push_back(tag);
+                    linestream >> phys_tags[itag];
                 }
+                tag_maps.curv_map.add(curv_tag, phys_tags);
             }
 
             // get the surface tags (omit bounding curve info)
@@ -135,11 +178,11 @@ namespace iceicle {
                 std::size_t nphys_tag;
                 std::istringstream linestream{line};
                 linestream >> surf_tag >> xmin >> ymin >> zmin >> xmax >> ymax >> zmax >> nphys_tag;
+                std::vector<std::size_t> phys_tags(nphys_tag);
                 for(int itag = 0; itag < nphys_tag; ++itag){
-                    int tag;
-                    linestream >> tag;
-                    tag_maps.surf_map[surf_tag].push_back(tag);
+                    linestream >> phys_tags[itag];
                 }
+                tag_maps.surf_map.add(surf_tag, phys_tags);
             }
 
             // get the volume tags (omit bounding surface info)
@@ -149,11 +192,11 @@ namespace iceicle {
                 std::size_t nphys_tag;
                 std::istringstream linestream{line};
                 linestream >> vol_tag >> xmin >> ymin >> zmin >> xmax >> ymax >> zmax >> nphys_tag;
+                std::vector<std::size_t> phys_tags(nphys_tag);
                 for(int itag = 0; itag < nphys_tag; ++itag){
-                    int tag;
-                    linestream >> tag;
-                    tag_maps.vol_map[vol_tag].push_back(tag);
+                    linestream >> phys_tags[itag];
                 }
+                tag_maps.vol_map.add(vol_tag, phys_tags);
             }
             return tag_maps;
         }
@@ -412,16 +455,15 @@ namespace iceicle {
                 int entity_dim, entity_tag, element_type;
                 std::size_t nelem_block;
                 linestream >> entity_dim >> entity_tag >> element_type >> nelem_block;
-                auto physical_tags = tag_maps.map_by_dimensionality(entity_dim).find(entity_tag);
+                std::span<const std::size_t> physical_tags = tag_maps.map_by_dimensionality(entity_dim).find(entity_tag);
 
                 if (entity_dim == ndim-1){
 
                     // === Get the Boundary condition information ===
                     // default index: 0
                     int bdy_map_index = 0;
-                    if(physical_tags != tag_maps.map_by_dimensionality(entity_dim).end()
-                            && physical_tags->second.size() > 0){
-                        bdy_map_index = physical_tags->second[0];
+                    if(physical_tags.size() > 0){
+                        bdy_map_index = physical_tags[0];
                     }
                     auto lookup = bcmap.find(bdy_map_index);
                     if(lookup == bcmap.end()){
@@ -481,6 +523,307 @@ namespace iceicle {
             util::crs<IDX, IDX> el_conn{el_conn_ragged};
             return std::optional{std::tuple{el_transformations, el_conn, boundary_infos}};
         }
+
+        // ==========================
+        // = Binary (MSH 4.1) files =
+        // ==========================
+
+        /// @brief read only view of the bytes of a file (memory mapped when available)
+        using mapped_file = util::mapped_file;
+
+        /// @brief cursor over the bytes of a gmsh file 
+        /// for reading binary values and the ascii lines between binary sections
+        struct binary_cursor {
+            const char* data;
+            std::size_t size;
+            std::size_t pos = 0;
+
+            /// @brief set if a read went past the end of the data
+            bool overflow = false;
+
+            /// @brief read a value of the given type from the current position (unaligned)
+            template<class V>
+            auto read() -> V {
+                V val{};
+                if(pos + sizeof(V) > size){
+                    overflow = true;
+                    pos = size;
+                    return val;
+                }
+                std::memcpy(&val, data + pos, sizeof(V));
+                pos += sizeof(V);
+                return val;
+            }
+
+            /// @brief skip over the given number of bytes
+            auto skip(std::size_t nbytes) -> void {
+                if(pos + nbytes > size) overflow = true;
+                pos = std::min(size, pos + nbytes);
+            }
+
+            /// @brief true if the cursor has reached the end
+            [[nodiscard]] auto done() const noexcept -> bool { return pos >= size; }
+
+            /// @brief read the next line of text (without the line ending)
+            auto getline() -> std::string_view {
+                std::string_view remaining{data + pos, size - pos};
+                std::size_t eol = remaining.find('\n');
+                std::string_view line = remaining.substr(0, eol);
+                pos = (eol == std::string_view::npos) ? size : pos + eol + 1;
+                if(line.size() > 0 && line.back() == '\r') line.remove_suffix(1);
+                return line;
+            }
+
+            /// @brief move past the next line that matches the given marker (i.e "$EndNodes")
+            auto skip_past(std::string_view marker) -> void {
+                std::string_view remaining{data + pos, size - pos};
+                std::size_t imarker = remaining.find(marker);
+                pos = (imarker == std::string_view::npos) ? size : pos + imarker;
+                getline();
+            }
+        };
+
+        /// @brief read the entities section of a binary gmsh file
+        /// @param cursor the cursor positioned at the start of the section data
+        inline
+        auto read_entities_binary(binary_cursor& cursor) -> TagMaps {
+            TagMaps tag_maps{};
+            std::size_t npoints = cursor.read<std::size_t>();
+            std::size_t ncurves = cursor.read<std::size_t>();
+            std::size_t nsurfaces = cursor.read<std::size_t>();
+            std::size_t nvolumes = cursor.read<std::size_t>();
+
+            auto read_phys_tags = [&cursor]() -> std::vector<std::size_t> {
+                std::size_t nphys_tag = cursor.read<std::size_t>();
+                std::vector<std::size_t> phys_tags(nphys_tag);
+                for(std::size_t itag = 0; itag < nphys_tag; ++itag)
+                    { phys_tags[itag] = cursor.read<int>(); }
+                return phys_tags;
+            };
+
+            // points: tag, x, y, z, physical tags
+            for(std::size_t ipt = 0; ipt < npoints && !cursor.overflow; ++ipt){
+                int pt_tag = cursor.read<int>();
+                cursor.skip(3 * sizeof(double));
+                tag_maps.pt_map.add(pt_tag, read_phys_tags());
+            }
+
+            // entities of higher dimension: tag, bounding box, physical tags, bounding entities
+            auto read_entity = [&](EntityTagMap& map){
+                int tag = cursor.read<int>();
+                cursor.skip(6 * sizeof(double));
+                map.add(tag, read_phys_tags());
+                std::size_t nbound = cursor.read<std::size_t>();
+                cursor.skip(nbound * sizeof(int));
+            };
+            for(std::size_t i = 0; i < ncurves && !cursor.overflow; ++i) read_entity(tag_maps.curv_map);
+            for(std::size_t i = 0; i < nsurfaces && !cursor.overflow; ++i) read_entity(tag_maps.surf_map);
+            for(std::size_t i = 0; i < nvolumes && !cursor.overflow; ++i) read_entity(tag_maps.vol_map);
+            return tag_maps;
+        }
+
+        /// @brief read the node coordinate data from a binary gmsh file 
+        ///
+        /// the block headers are scanned first so that the blocks can be read in parallel
+        /// blocks with contiguous node tags are copied directly when the layout matches NodeArray
+        ///
+        /// @param cursor the cursor positioned at the start of the section data
+        template<class T, class IDX, int ndim>
+        auto read_nodes_binary(binary_cursor& cursor) -> std::optional<NodeArray<T, ndim>> {
+            using Point = MATH::GEOMETRY::Point<T, ndim>;
+            std::size_t nblocks = cursor.read<std::size_t>();
+            [[maybe_unused]] std::size_t nnodes = cursor.read<std::size_t>();
+            [[maybe_unused]] std::size_t min_nodetag = cursor.read<std::size_t>();
+            std::size_t max_nodetag = cursor.read<std::size_t>();
+
+            // === locate the blocks ===
+            struct node_block {
+                std::size_t start;  // position of the node tags
+                std::size_t nnode;  // number of nodes in the block
+                std::size_t stride; // number of doubles per node
+            };
+            std::vector<node_block> blocks;
+            blocks.reserve(nblocks);
+            for(std::size_t iblock = 0; iblock < nblocks && !cursor.overflow; ++iblock){
+                int entity_dim = cursor.read<int>();
+                [[maybe_unused]] int entity_tag = cursor.read<int>();
+                int parametric = cursor.read<int>();
+                std::size_t n_blocknodes = cursor.read<std::size_t>();
+
+                // xyz followed by the parametric coordinates if present
+                std::size_t stride = 3 + ((parametric) ? entity_dim : 0);
+                blocks.push_back(node_block{cursor.pos, n_blocknodes, stride});
+                cursor.skip(n_blocknodes * (sizeof(std::size_t) + stride * sizeof(double)));
+            }
+            if(cursor.overflow){
+                util::AnomalyLog::log_anomaly(util::Anomaly{"unexpected end of file in nodes section", util::general_anomaly_tag{}});
+                return std::nullopt;
+            }
+
+            // === read the blocks ===
+            NodeArray<T, ndim> coord(max_nodetag + 1);
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+            for(std::size_t iblock = 0; iblock < blocks.size(); ++iblock){
+                const node_block& block = blocks[iblock];
+                const char* tags = cursor.data + block.start;
+                const char* xyz = tags + block.nnode * sizeof(std::size_t);
+                if(block.nnode == 0) continue;
+
+                // check for contiguous node tags
+                std::size_t first_tag, last_tag;
+                std::memcpy(&first_tag, tags, sizeof(std::size_t));
+                std::memcpy(&last_tag, tags + (block.nnode - 1) * sizeof(std::size_t), sizeof(std::size_t));
+
+                if constexpr(std::same_as<T, double> && ndim == 3 && sizeof(Point) == 3 * sizeof(double)) {
+                    if(block.stride == 3 && last_tag - first_tag + 1 == block.nnode){
+                        // the layout matches so copy the whole block 
+                        std::memcpy(coord[first_tag].data(), xyz, block.nnode * 3 * sizeof(double));
+                        continue;
+                    }
+                }
+
+                for(std::size_t inode = 0; inode < block.nnode; ++inode){
+                    std::size_t tag;
+                    double x[3];
+                    std::memcpy(&tag, tags + inode * sizeof(std::size_t), sizeof(std::size_t));
+                    std::memcpy(x, xyz + inode * block.stride * sizeof(double), 3 * sizeof(double));
+                    for(int idim = 0; idim < ndim; ++idim)
+                        { coord[tag][idim] = x[idim]; }
+                }
+            }
+            return std::optional{coord};
+        }
+
+        /// @brief read the elements from a binary gmsh file 
+        ///
+        /// the block headers are scanned first to find the offsets of each block in the flat 
+        /// connectivity arrays so that the blocks can be read in parallel
+        ///
+        /// @param cursor the cursor positioned at the start of the section data
+        /// @param tag_maps the entity physical tags
+        /// @param bcmap map from physical tags to boundary conditions
+        template<class T, class IDX, int ndim>
+        auto read_elements_binary(
+            binary_cursor& cursor,
+            const TagMaps& tag_maps,
+            const std::map<int, std::tuple<BOUNDARY_CONDITIONS, int>>& bcmap
+        ) -> std::optional< std::tuple< 
+            std::vector< ElementTransformation<T, IDX, ndim> *>, 
+            util::crs<IDX, IDX>, 
+            std::vector< std::tuple< BOUNDARY_CONDITIONS, int, std::vector<IDX> > >
+        > > {
+            using boundary_face_desc = std::tuple<BOUNDARY_CONDITIONS, int, std::vector<IDX>>;
+
+            std::size_t nblocks = cursor.read<std::size_t>();
+            [[maybe_unused]] std::size_t nelem = cursor.read<std::size_t>();
+            [[maybe_unused]] std::size_t min_eltag = cursor.read<std::size_t>();
+            [[maybe_unused]] std::size_t max_eltag = cursor.read<std::size_t>();
+
+            // === locate the blocks ===
+            struct element_block {
+                std::size_t start;      // position of the element data
+                std::size_t nelem;      // number of elements in the block
+                int nnode;              // number of nodes per element
+                int element_type;       // gmsh element type
+                int entity_dim;         // dimension of the entity
+                std::size_t out_offset; // index of the first element (or boundary face) of the block in the output
+                BOUNDARY_CONDITIONS bc_type;
+                int bc_flag;
+            };
+            std::vector<element_block> blocks;
+            std::size_t nelem_interior = 0, nfac_bdy = 0;
+            for(std::size_t iblock = 0; iblock < nblocks && !cursor.overflow; ++iblock){
+                int entity_dim = cursor.read<int>();
+                int entity_tag = cursor.read<int>();
+                int element_type = cursor.read<int>();
+                std::size_t nelem_block = cursor.read<std::size_t>();
+                int nnode = gmsh_nnode(element_type);
+                element_block block{cursor.pos, nelem_block, nnode, element_type, entity_dim, 0,
+                    BOUNDARY_CONDITIONS::INTERIOR, 0};
+                cursor.skip(nelem_block * (nnode + 1) * sizeof(std::size_t));
+
+                if(entity_dim == ndim - 1){
+                    // === Get the Boundary condition information ===
+                    // default index: 0
+                    int bdy_map_index = 0;
+                    std::span<const std::size_t> physical_tags = tag_maps.map_by_dimensionality(entity_dim).find(entity_tag);
+                    if(physical_tags.size() > 0){
+                        bdy_map_index = physical_tags[0];
+                    }
+                    auto lookup = bcmap.find(bdy_map_index);
+                    if(lookup == bcmap.end()){
+                        util::AnomalyLog::log_anomaly("Could not map boundary condition with physical tag: " + std::to_string(bdy_map_index));
+                        return std::nullopt;
+                    }
+                    std::tie(block.bc_type, block.bc_flag) = lookup->second;
+                    block.out_offset = nfac_bdy;
+                    nfac_bdy += nelem_block;
+                    blocks.push_back(block);
+                } else if(entity_dim == ndim) {
+                    if(element_type == 2 || element_type == 3){
+                        block.out_offset = nelem_interior;
+                        nelem_interior += nelem_block;
+                        blocks.push_back(block);
+                    } else {
+                        util::AnomalyLog::log_anomaly(util::Anomaly{"unsupported element type", util::general_anomaly_tag{}});
+                    }
+                }
+            }
+            if(cursor.overflow){
+                util::AnomalyLog::log_anomaly(util::Anomaly{"unexpected end of file in elements section", util::general_anomaly_tag{}});
+                return std::nullopt;
+            }
+
+            // === size the flat output arrays ===
+            std::vector<IDX> el_cols(nelem_interior + 1);
+            el_cols[0] = 0;
+            std::vector< ElementTransformation<T, IDX, ndim>* > el_transformations(nelem_interior);
+            for(const element_block& block : blocks){
+                if(block.entity_dim != ndim) continue;
+                DOMAIN_TYPE domain = (block.element_type == 2) ? DOMAIN_TYPE::SIMPLEX : DOMAIN_TYPE::HYPERCUBE;
+                auto trans = transformation_table<T, IDX, ndim>.get_transform(domain, 1);
+                for(std::size_t ielem = block.out_offset; ielem < block.out_offset + block.nelem; ++ielem){
+                    el_cols[ielem + 1] = el_cols[ielem] + block.nnode;
+                    el_transformations[ielem] = trans;
+                }
+            }
+            util::crs<IDX, IDX> el_conn{std::span<const IDX>{el_cols}};
+            std::vector<boundary_face_desc> boundary_infos(nfac_bdy);
+
+            // === read the blocks ===
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+            for(std::size_t iblock = 0; iblock < blocks.size(); ++iblock){
+                const element_block& block = blocks[iblock];
+                std::vector<std::size_t> record(block.nnode + 1);
+                for(std::size_t ielem = 0; ielem < block.nelem; ++ielem){
+                    // element tag followed by the node tags
+                    std::memcpy(record.data(), cursor.data + block.start + ielem * record.size() * sizeof(std::size_t),
+                            record.size() * sizeof(std::size_t));
+                    if(block.entity_dim == ndim - 1){
+                        std::vector<IDX> fac_nodes(record.begin() + 1, record.end());
+                        boundary_infos[block.out_offset + ielem] = std::tuple{block.bc_type, block.bc_flag, fac_nodes};
+                    } else {
+                        std::span<IDX> el_nodes = el_conn.rowspan(block.out_offset + ielem);
+                        if(block.element_type == 3){
+                            // ordering for tensor prod 0 3 1 2
+                            el_nodes[0] = record[1];
+                            el_nodes[1] = record[4];
+                            el_nodes[2] = record[2];
+                            el_nodes[3] = record[3];
+                        } else {
+                            for(int inode = 0; inode < block.nnode; ++inode)
+                                { el_nodes[inode] = record[inode + 1]; }
+                        }
+                    }
+                }
+            }
+
+            return std::optional{std::tuple{el_transformations, el_conn, boundary_infos}};
+        }
     }
 
     /// @brief create a mesh from a gmsh file 
@@ -550,7 +893,7 @@ namespace iceicle {
 
                         // check for errors
                         if(!header.ascii) {
-                            AnomalyLog::log_anomaly(Anomaly{"Currently only supports ASCII gmsh file types", file_parse_tag{line_no}});
+                            AnomalyLog::log_anomaly(Anomaly{"binary gmsh files must be read by file name", file_parse_tag{line_no}});
                         }
                         if(header.version_major < 4) {
                             AnomalyLog::log_anomaly(Anomaly{"must be version 4.1 or greater", file_parse_tag{line_no}});
@@ -600,4 +943,85 @@ namespace iceicle {
         }
         return std::optional{AbstractMesh{coord, el_conn, el_transformations, boundary_infos}};
     }
+
+    /// @brief create a mesh from a gmsh file given the file name 
+    /// ASCII files are read through read_gmsh(std::istream&, ...)
+    /// binary (MSH 4.1) files are memory mapped and the node and element blocks are read in parallel
+    /// @param filename the name of the gmsh file
+    /// @param bcmap maps integer physical tags to boundary condition information (see above)
+    template<class T, class IDX, int ndim>
+    auto read_gmsh(const std::string& filename, std::map<int, std::tuple<BOUNDARY_CONDITIONS, int>>& bcmap) 
+    -> std::optional<AbstractMesh<T, IDX, ndim>> {
+        using namespace impl::gmsh;
+        using namespace util;
+        using boundary_face_desc = std::tuple<BOUNDARY_CONDITIONS, int, std::vector<IDX>>;
+
+        mapped_file file{filename};
+        if(!file){
+            AnomalyLog::log_anomaly(Anomaly{"Could not open gmsh file: " + filename, general_anomaly_tag{}});
+            return std::nullopt;
+        }
+        binary_cursor cursor{file.data(), file.size()};
+
+        // data 
+        NodeArray<T, ndim> coord;
+        Header header{};
+        TagMaps tag_maps{};
+        std::vector< ElementTransformation<T, IDX, ndim>* > el_transformations{};
+        util::crs<IDX, IDX> el_conn{};
+        std::vector<boundary_face_desc> boundary_infos{};
+
+        while(!cursor.done()){
+            std::string_view line = cursor.getline();
+            if(eq_icase(line, "$MeshFormat")){
+                header = read_header(std::string{cursor.getline()});
+                if(header.ascii){
+                    // use the line based reader
+                    std::ifstream infile{filename};
+                    return read_gmsh<T, IDX, ndim>(infile, bcmap);
+                }
+                if(header.version_major < 4 || (header.version_major == 4 && header.version_minor < 1)) {
+                    AnomalyLog::log_anomaly(Anomaly{"must be version 4.1 or greater", general_anomaly_tag{}});
+                    return std::nullopt;
+                }
+                if(header.data_size != sizeof(std::size_t)){
+                    AnomalyLog::log_anomaly(Anomaly{"binary gmsh data size must match size_t", general_anomaly_tag{}});
+                    return std::nullopt;
+                }
+                // binary files write the integer 1 to check endianness
+                if(cursor.read<int>() != 1){
+                    AnomalyLog::log_anomaly(Anomaly{"binary gmsh file endianness does not match", general_anomaly_tag{}});
+                    return std::nullopt;
+                }
+                cursor.skip_past("$EndMeshFormat");
+                std::cout << "Reading binary gmsh file... " << std::endl;
+            } else if(eq_icase(line, "$Entities")){
+                std::cout << "Reading entities" << std::endl;
+                tag_maps = read_entities_binary(cursor);
+                cursor.skip_past("$EndEntities");
+            } else if(eq_icase(line, "$Nodes")){
+                std::cout << "Reading nodes" << std::endl;
+                auto coord_opt = read_nodes_binary<T, IDX, ndim>(cursor);
+                if(coord_opt)
+                    coord = std::move(coord_opt.value());
+                else 
+                    return std::nullopt;
+                cursor.skip_past("$EndNodes");
+            } else if(eq_icase(line, "$Elements")){
+                std::cout << "Reading Elements" << std::endl;
+                auto opt = read_elements_binary<T, IDX, ndim>(cursor, tag_maps, bcmap);
+                if(opt){
+                    std::tie(el_transformations, el_conn, boundary_infos) = opt.value();
+                } else {
+                    return std::nullopt;
+                }
+                cursor.skip_past("$EndElements");
+            } else if(line.size() > 1 && line[0] == '$'){
+                // skip sections we do not use
+                std::string end_marker = "$End" + std::string{line.substr(1)};
+                cursor.skip_past(end_marker);
+            }
+        }
+        return std::optional{AbstractMesh{coord, el_conn, el_transformations, boundary_infos}};
+    }
 }
@@ -10,6 +10,7 @@
 #include "iceicle/build_config.hpp"
 #include "iceicle/fe_definitions.hpp"
 #include "iceicle/geometry/face_utils.hpp"
+#include "iceicle/geometry/face_table.hpp"
 #include "iceicle/geometry/transformations_table.hpp"
 #include "iceicle/geometry/hypercube_face.hpp"
 #include "iceicle/geometry/simplex_element.hpp"
@@ -20,36 +21,49 @@
 #include <iceicle/geometry/geo_element.hpp>
 #include <iceicle/geometry/hypercube_element.hpp>
 #include <iceicle/crs.hpp>
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include <optional>
 #include <ostream>
 #include <ranges>
 #include <type_traits>
 #include <memory>
 #include <list>
+#include <span>
+#include <vector>
 #include <set>
+#include <string>
 #ifndef NDEBUG
 #include <iomanip>
 #endif
 namespace iceicle {
 
     /// @brief generate the node connectivity matrix in crs format from the element connectivity matrix 
-    /// elsup -> elements surrounding points
+    /// elsup -> elements surrounding points (the transpose of conn_el, see util::transpose_crs)
     /// @param conn_el the element connectivity matrix
     /// @param nnode the number of nodes
     template<class IDX>
-    constexpr
-    auto to_elsup(util::crs<IDX, IDX>& conn_el, std::integral auto nnode)
+    auto to_elsup(const util::crs<IDX, IDX>& conn_el, std::integral auto nnode)
     -> util::crs<IDX, IDX>
     {
-        std::vector<std::vector<IDX>> elsup_ragged(nnode);
-        for(IDX iel = 0; iel < conn_el.nrow(); ++iel){
-            for(IDX inode : conn_el.rowspan(iel)){
-                elsup_ragged[inode].push_back(iel);
-            }
-        }
-        return util::crs<IDX, IDX>{elsup_ragged};
+        return util::transpose_crs(conn_el, (std::size_t) nnode);
     }
 
+    /// @brief the entities touched by a local change to the mesh topology (i.e edge_swap())
+    /// so that connectivity and finite element spaces can be patched in place instead of rebuilt
+    template<class IDX>
+    struct topology_edit {
+        /// @brief elements whose node connectivity or faces changed
+        std::vector<IDX> elements{};
+
+        /// @brief faces that were replaced (in the same face index)
+        std::vector<IDX> faces{};
+
+        /// @brief nodes whose surrounding elements or faces changed
+        std::vector<IDX> nodes{};
+    };
+
     /// @brief generate the element connectivity matrix from the face list 
     /// elsuel -> elements surrounding elements 
     /// @param face_list the list of faces 
@@ -73,6 +87,124 @@ namespace iceicle {
         return util::crs{elsuel_dynamic};
     }
 
+    /**
+     * @brief find and create all the interior faces by hashing the vertices of each element face 
+     *
+     * The sorted vertex indices of every element face are inserted into an open addressing hash table 
+     * and element faces with the same vertices are matched in a single pass over the element faces.
+     * Faces are created with the lower element index as the left element,
+     * in order of the left element and left face number.
+     *
+     * The vertex gathering and face creation are threaded over elements when ICEICLE_USE_OPENMP is defined
+     *
+     * @param conn_el the element connectivity
+     * @param el_transformations the transformation for each element 
+     * @return the interior faces
+     */
+    template<class T, class IDX, int ndim>
+    auto hash_interior_faces(
+        util::crs<IDX, IDX>& conn_el,
+        std::span<ElementTransformation<T, IDX, ndim>* const> el_transformations
+    ) -> std::vector< std::unique_ptr< Face<T, IDX, ndim> > > {
+        IDX nelem = conn_el.nrow();
+
+        // === index the element faces ===
+        // element face ief = elfac_offsets[iel] + face number
+        std::vector<IDX> elfac_offsets(nelem + 1);
+        elfac_offsets[0] = 0;
+        for(IDX iel = 0; iel < nelem; ++iel)
+            { elfac_offsets[iel + 1] = elfac_offsets[iel] + el_transformations[iel]->nfac; }
+        IDX nelfac = elfac_offsets[nelem];
+
+        // the element of each element face 
+        std::vector<IDX> elfac_el(nelfac);
+        std::vector<IDX> vert_offsets(nelfac + 1);
+        vert_offsets[0] = 0;
+        for(IDX iel = 0; iel < nelem; ++iel){
+            for(int iface = 0; iface < el_transformations[iel]->nfac; ++iface){
+                IDX ief = elfac_offsets[iel] + iface;
+                elfac_el[ief] = iel;
+                vert_offsets[ief + 1] = vert_offsets[ief] + el_transformations[iel]->n_face_vert(iface);
+            }
+        }
+
+        // === sorted vertices and hashes of each element face ===
+        std::vector<IDX> sorted_vert(vert_offsets[nelfac]);
+        std::vector<std::size_t> hashes(nelfac);
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for(IDX iel = 0; iel < nelem; ++iel){
+            for(int iface = 0; iface < el_transformations[iel]->nfac; ++iface){
+                IDX ief = elfac_offsets[iel] + iface;
+                std::vector<IDX> vert = el_transformations[iel]->get_face_vert(iface, conn_el.rowspan(iel));
+                std::ranges::sort(vert);
+                std::size_t hash = vert.size();
+                for(IDX ivert : vert){
+                    // hash combine
+                    hash ^= std::hash<IDX>{}(ivert) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+                }
+                hashes[ief] = hash;
+                std::ranges::copy(vert, sorted_vert.begin() + vert_offsets[ief]);
+            }
+        }
+
+        auto vert_span = [&](IDX ief) -> std::span<const IDX> {
+            return std::span<const IDX>{sorted_vert.data() + vert_offsets[ief], sorted_vert.data() + vert_offsets[ief + 1]};
+        };
+
+        // === match element faces with linear probing ===
+        // power of 2 capacity at least twice the number of element faces
+        std::size_t capacity = 1;
+        while(capacity < 2 * (std::size_t) nelfac) capacity <<= 1;
+        std::vector<IDX> table(capacity, -1);
+
+        // the matching element face for the lower element face index
+        std::vector<IDX> match(nelfac, -1);
+        for(IDX ief = 0; ief < nelfac; ++ief){
+            std::size_t islot = hashes[ief] & (capacity - 1);
+            while(true){
+                IDX jef = table[islot];
+                if(jef == -1){
+                    table[islot] = ief;
+                    break;
+                } else if(hashes[jef] == hashes[ief] && std::ranges::equal(vert_span(jef), vert_span(ief))){
+                    if(match[jef] == -1 && elfac_el[jef] != elfac_el[ief]){
+                        match[jef] = ief;
+                    } else {
+                        util::AnomalyLog::log_anomaly(util::Anomaly{"more than two element faces share the same vertices",
+                                util::general_anomaly_tag{}});
+                    }
+                    break;
+                }
+                islot = (islot + 1) & (capacity - 1);
+            }
+        }
+
+        // === create the faces ===
+        std::vector< std::unique_ptr< Face<T, IDX, ndim> > > matched_faces(nelfac);
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for(IDX ief = 0; ief < nelfac; ++ief){
+            IDX jef = match[ief];
+            if(jef != -1){
+                IDX iel = elfac_el[ief];
+                IDX jel = elfac_el[jef];
+                auto face_opt = make_face(iel, jel, el_transformations[iel], el_transformations[jel],
+                        conn_el.rowspan(iel), conn_el.rowspan(jel), 
+                        (int) (ief - elfac_offsets[iel]), (int) (jef - elfac_offsets[jel]));
+                if(face_opt) matched_faces[ief] = std::move(face_opt.value());
+            }
+        }
+
+        std::vector< std::unique_ptr< Face<T, IDX, ndim> > > faces;
+        for(auto& facptr : matched_faces){
+            if(facptr) faces.push_back(std::move(facptr));
+        }
+        return faces;
+    }
+
     template<class T, class IDX, int ndim>
     constexpr
     auto create_element(DOMAIN_TYPE domain, int geo_order, std::span<IDX> nodes)
@@ -284,6 +416,12 @@ namespace iceicle {
         using Point = MATH::GEOMETRY::Point<T, ndim>;
 
         public:
+
+        /// @brief the index type for the node and element ids of the mesh this was partitioned from
+        /// (never narrower than IDX)
+        using global_index_type = std::conditional_t<(sizeof(build_config::GIDX) < sizeof(IDX)),
+              IDX, build_config::GIDX>;
+
         // ===========================
         // = Primary Data Structures =
         // ===========================
@@ -296,6 +434,7 @@ namespace iceicle {
 
         /// The node coordinates for each element 
         /// NOTE: updates to coord must be propogated to this array
+        /// (update_nodes() for the rows of the moved nodes, update_coord_els() for all rows)
         util::crs<Point, IDX> coord_els;
 
         /// @brief the element transformations for each element
@@ -337,6 +476,32 @@ namespace iceicle {
 
         std::vector< std::vector< CommElementInfo<T, IDX, ndim> > > communicated_elements;
 
+        /// @brief the index of each node in the mesh this was partitioned from
+        /// (empty if the mesh has not been partitioned, in which case the indices are the same)
+        std::vector<global_index_type> gnode_idxs{};
+
+        /// @brief the index of each element in the mesh this was partitioned from
+        /// (empty if the mesh has not been partitioned, in which case the indices are the same)
+        std::vector<global_index_type> gel_idxs{};
+
+        /// @brief incremented whenever node coordinates are propogated to coord_els
+        /// (update_coord_els() or update_node())
+        /// so that geometry dependent data can detect when the mesh has moved
+        std::size_t coord_version = 0;
+
+        /// @brief the coord_version at which each element last had its coord_els updated
+        /// (empty until the first update) so that geometry dependent data can be 
+        /// invalidated only for the elements that moved
+        std::vector<std::size_t> el_coord_version{};
+
+        /// @brief compact structure of arrays copy of the face data grouped by face type
+        /// NOTE: this is only as current as the last call to update_face_table()
+        FaceTable<T, IDX, ndim> face_table{};
+
+        /// @brief the (sorted) indices of the interior faces that join two elements 
+        /// across a periodic boundary (see make_periodic_faces_interior())
+        std::vector<IDX> periodic_faces{};
+
         inline IDX nelem() { return conn_el.nrow(); }
 
         // ===============
@@ -400,35 +565,7 @@ namespace iceicle {
             elsup = util::crs<IDX, IDX>{elsup_ragged};
 
             // find the interior faces
-            // if elements share at least ndim points, then they have a face
-            for(IDX ielem = 0; ielem < nelem(); ++ielem){
-                int max_faces = el_transformations[ielem]->nfac;
-                std::vector<IDX> connected_elements;
-                connected_elements.reserve(max_faces);
-
-                // loop through elements that share a node
-                for(IDX inode : conn_el.rowspan(ielem)){
-                    for(auto jelem_iter = std::lower_bound(elsup.rowspan(inode).begin(), elsup.rowspan(inode).end(), ielem);
-                            jelem_iter != elsup.rowspan(inode).end(); ++jelem_iter){
-                        IDX jelem = *jelem_iter;
-
-                        // skip the cases that would lead to duplicate or boundary faces
-                        if( ielem == jelem || std::ranges::find(connected_elements, jelem) != std::ranges::end(connected_elements) )
-                            continue; 
-
-                        // try making the face that is the intersection of the two elements
-                        auto face_opt = make_face(ielem, jelem, 
-                                el_transformations[ielem], el_transformations[jelem],
-                                conn_el.rowspan(ielem), conn_el.rowspan(jelem));
-                        if(face_opt){
-                            faces.push_back(std::move(face_opt.value()));
-                            // short circuit if all the faces have been found
-                            connected_elements.push_back(jelem);
-                            if(connected_elements.size() == max_faces) break;
-                        }
-                    }
-                }
-            }
+            faces = hash_interior_faces<T, IDX, ndim>(this->conn_el, this->el_transformations);
 
             interiorFaceStart = 0;
             interiorFaceEnd = faces.size();
@@ -479,7 +616,10 @@ namespace iceicle {
           bdyFaceStart(other.bdyFaceStart), bdyFaceEnd(other.bdyFaceEnd), elsup{other.elsup},
           facsuel{other.facsuel},
           el_send_list(other.el_send_list), el_recv_list(other.el_recv_list),
-          communicated_elements(other.communicated_elements)
+          communicated_elements(other.communicated_elements),
+          gnode_idxs(other.gnode_idxs), gel_idxs(other.gel_idxs),
+          coord_version(other.coord_version), el_coord_version(other.el_coord_version),
+          face_table{other.face_table}, periodic_faces{other.periodic_faces}
         {
             for(auto& facptr : other.faces){
                 faces.push_back(std::move(facptr->clone()));
@@ -506,6 +646,12 @@ namespace iceicle {
                 el_send_list = other.el_send_list;
                 el_recv_list = other.el_recv_list;
                 communicated_elements = other.communicated_elements;
+                gnode_idxs = other.gnode_idxs;
+                gel_idxs = other.gel_idxs;
+                coord_version = other.coord_version;
+                el_coord_version = other.el_coord_version;
+                face_table = other.face_table;
+                periodic_faces = other.periodic_faces;
             }
             return *this;
         }
@@ -996,16 +1142,250 @@ namespace iceicle {
                 IDX inode = conn_el.data()[i];
                 coord_els.data()[i] = coord[inode];
             }
+            ++coord_version;
+            el_coord_version.assign(nelem(), coord_version);
         }
 
         /// @brief element coordinate data for all elements affected by the given node
         void update_node(IDX inode) {
-            for(IDX iel : elsup.rowspan(inode)){
-                for(int ilocal = 0; ilocal < conn_el.rowsize(iel); ++ilocal){
-                    if(conn_el[iel, ilocal] == inode)
-                        coord_els[iel, ilocal] = coord[conn_el[iel, ilocal]];
+            update_nodes(std::span<const IDX>{&inode, 1});
+        }
+
+        /**
+         * @brief update the element coordinate data for only the elements surrounding the given nodes
+         * (the rows of coord_els found through elsup) 
+         * instead of copying every element with update_coord_els()
+         *
+         * all the elements touched share a single new coord_version
+         * @param inodes the indices of the nodes that were moved
+         */
+        void update_nodes(std::span<const IDX> inodes) {
+            ++coord_version;
+            if(el_coord_version.size() < nelem()) el_coord_version.resize(nelem(), 0);
+            for(IDX inode : inodes){
+                for(IDX iel : elsup.rowspan(inode)){
+                    for(int ilocal = 0; ilocal < conn_el.rowsize(iel); ++ilocal){
+                        if(conn_el[iel, ilocal] == inode)
+                            coord_els[iel, ilocal] = coord[inode];
+                    }
+                    el_coord_version[iel] = coord_version;
+                }
+            }
+        }
+
+        /// @brief get the coord_version at which the given element was last updated
+        /// @param iel the element index
+        [[nodiscard]] inline 
+        auto element_coord_version(IDX iel) const noexcept -> std::size_t {
+            return ((std::size_t) iel < el_coord_version.size()) ? el_coord_version[iel] : 0;
+        }
+
+        /// @brief rebuild the compact face table from the faces
+        /// must be called after faces are added or modified for face_table to reflect the changes
+        auto update_face_table() -> void {
+            face_table = FaceTable<T, IDX, ndim>{faces};
+        }
+
+        /// @brief update the compact face table entries for the given faces only
+        /// @param ifacs the indices of the faces that were replaced or modified
+        auto update_face_table(std::span<const IDX> ifacs) -> void {
+            if(face_table.nfac() != faces.size()) {
+                update_face_table();
+                return;
+            }
+            for(IDX ifac : ifacs) face_table.update_face(ifac, *faces[ifac]);
+        }
+
+        /**
+         * @brief patch the mesh connectivity after a local topology change 
+         * where conn_el (and coord_els) rows of edit.elements and the faces edit.faces have been replaced
+         *
+         * updates the elsup rows of edit.nodes, the face table entries of edit.faces, 
+         * and marks the coordinates of edit.elements as changed
+         *
+         * @param edit the entities touched by the change
+         */
+        auto apply_topology_edit(const topology_edit<IDX>& edit) -> void {
+            for(IDX inode : edit.nodes){
+                // the candidates are the previously surrounding elements and the edited elements
+                std::vector<IDX> candidates{};
+                for(IDX iel : elsup.rowspan(inode)) candidates.push_back(iel);
+                for(IDX iel : edit.elements) candidates.push_back(iel);
+                std::ranges::sort(candidates);
+                auto unique_subrange = std::ranges::unique(candidates);
+                candidates.erase(unique_subrange.begin(), unique_subrange.end());
+
+                std::vector<IDX> elsup_row{};
+                for(IDX iel : candidates){
+                    std::span<const IDX> el_nodes = conn_el.rowspan(iel);
+                    if(std::ranges::find(el_nodes, inode) != el_nodes.end()) elsup_row.push_back(iel);
                 }
+                elsup.replace_row(inode, elsup_row);
             }
+
+            update_face_table(edit.faces);
+
+            ++coord_version;
+            if(el_coord_version.size() < nelem()) el_coord_version.resize(nelem(), 0);
+            for(IDX iel : edit.elements) el_coord_version[iel] = coord_version;
+        }
+
+        /**
+         * @brief convert each pair of PERIODIC boundary faces into one interior face between the two elements
+         * so periodic boundaries go through the interior trace kernels
+         *
+         * The bcflag of a periodic face is the index of its partner face.
+         * The new face keeps the nodes of the first face of the pair (the left element).
+         * The right element is attached through its face number and an orientation 
+         * found by matching its face vertices translated by the periodic offset.
+         *
+         * The converted faces are appended to the interior faces and recorded in periodic_faces.
+         * The boundary faces after them are renumbered 
+         * so anything holding face indices (i.e FESpace) must be built after this.
+         *
+         * @param rel_tol the tolerance for matching translated vertices relative to the face size
+         * @return the number of face pairs converted
+         */
+        auto make_periodic_faces_interior(T rel_tol = 1e-8) -> IDX {
+            using enum BOUNDARY_CONDITIONS;
+            auto vertex_centroid = [&](std::span<const IDX> verts){
+                Point c{};
+                for(IDX ivert : verts) for(int idim = 0; idim < ndim; ++idim) c[idim] += coord[ivert][idim];
+                for(int idim = 0; idim < ndim; ++idim) c[idim] /= verts.size();
+                return c;
+            };
+
+            std::vector<std::unique_ptr<face_t>> new_faces{};
+            std::vector<char> converted(faces.size(), false);
+            for(IDX ifac = bdyFaceStart; ifac < bdyFaceEnd; ++ifac){
+                const face_t& facA = *faces[ifac];
+                if(facA.bctype != PERIODIC || converted[ifac]) continue;
+                IDX jfac = facA.bcflag;
+                if(jfac < bdyFaceStart || jfac >= bdyFaceEnd || jfac == ifac
+                        || faces[jfac]->bctype != PERIODIC || faces[jfac]->bcflag != ifac){
+                    util::AnomalyLog::log_anomaly(util::Anomaly{"periodic face " + std::to_string(ifac) 
+                            + " has no matching partner face", util::general_anomaly_tag{}});
+                    continue;
+                }
+                const face_t& facB = *faces[jfac];
+                IDX iel = facA.elemL, jel = facB.elemL;
+                ElementTransformation<T, IDX, ndim>* transL = el_transformations[iel];
+                ElementTransformation<T, IDX, ndim>* transR = el_transformations[jel];
+                int face_nr_l = facA.face_nr_l(), face_nr_r = facB.face_nr_l();
+                DOMAIN_TYPE fac_domn = transL->face_domain_type(face_nr_l);
+
+                // the face takes its nodes from the left so the right must represent that geometry
+                if(fac_domn != DOMAIN_TYPE::HYPERCUBE || transR->face_domain_type(face_nr_r) != fac_domn
+                        || transR->order < transL->order){
+                    util::AnomalyLog::log_anomaly(util::Anomaly{"periodic faces " + std::to_string(ifac) + " and "
+                            + std::to_string(jfac) + " cannot be joined", util::general_anomaly_tag{}});
+                    continue;
+                }
+
+                std::vector<IDX> vert_l = transL->get_face_vert(face_nr_l, get_el_nodes(iel));
+                std::vector<IDX> vert_r = transR->get_face_vert(face_nr_r, get_el_nodes(jel));
+                Point centroid_l = vertex_centroid(vert_l);
+                Point centroid_r = vertex_centroid(vert_r);
+                T h = 0;
+                for(IDX ivert : vert_l){
+                    T dist = 0;
+                    for(int idim = 0; idim < ndim; ++idim) 
+                        dist += std::pow(coord[ivert][idim] - centroid_l[idim], 2);
+                    h = std::max(h, std::sqrt(dist));
+                }
+
+                // express the right vertices as the left vertices they translate to
+                std::vector<IDX> vert_r_matched(vert_r.size(), -1);
+                for(std::size_t ir = 0; ir < vert_r.size(); ++ir){
+                    for(IDX ivert : vert_l){
+                        T dist = 0;
+                        for(int idim = 0; idim < ndim; ++idim) dist += std::pow(coord[vert_r[ir]][idim]
+                                + (centroid_l[idim] - centroid_r[idim]) - coord[ivert][idim], 2);
+                        if(std::sqrt(dist) <= rel_tol * h) vert_r_matched[ir] = ivert;
+                    }
+                }
+                if(vert_l.size() != vert_r.size() || std::ranges::find(vert_r_matched, -1) != vert_r_matched.end()){
+                    util::AnomalyLog::log_anomaly(util::Anomaly{"periodic faces " + std::to_string(ifac) + " and "
+                            + std::to_string(jfac) + " are not translations of each other", util::general_anomaly_tag{}});
+                    continue;
+                }
+
+                int orient_r = hypercube_orient_trans<T, IDX, ndim>.getOrientation(vert_l.data(), vert_r_matched.data());
+                if(orient_r < 0){
+                    util::AnomalyLog::log_anomaly(util::Anomaly{"Cannot orient periodic face", util::general_anomaly_tag{}});
+                    continue;
+                }
+                std::vector<IDX> face_nodes = transL->get_face_nodes(face_nr_l, get_el_nodes(iel));
+                auto fac_opt = make_face<T, IDX, ndim>(fac_domn, transL->domain_type, transR->domain_type,
+                        transL->order, iel, jel, face_nodes, face_nr_l, face_nr_r, orient_r);
+                if(!fac_opt){
+                    util::AnomalyLog::log_anomaly(util::Anomaly{"Cannot form periodic face", util::general_anomaly_tag{}});
+                    continue;
+                }
+                new_faces.push_back(std::move(fac_opt.value()));
+                converted[ifac] = converted[jfac] = true;
+            }
+            IDX npair = new_faces.size();
+            if(npair == 0) return 0;
+
+            // renumber: [interior faces][converted periodic faces][remaining faces]
+            std::vector<IDX> new_index(faces.size(), -1);
+            std::vector<std::unique_ptr<face_t>> renumbered{};
+            renumbered.reserve(faces.size() - npair);
+            for(IDX ifac = 0; ifac < interiorFaceEnd; ++ifac){
+                new_index[ifac] = renumbered.size();
+                renumbered.push_back(std::move(faces[ifac]));
+            }
+            for(auto& facptr : new_faces){
+                periodic_faces.push_back(renumbered.size());
+                renumbered.push_back(std::move(facptr));
+            }
+            for(IDX ifac = interiorFaceEnd; ifac < (IDX) faces.size(); ++ifac){
+                if(converted[ifac]) continue;
+                new_index[ifac] = renumbered.size();
+                renumbered.push_back(std::move(faces[ifac]));
+            }
+            faces = std::move(renumbered);
+            interiorFaceEnd += npair;
+            bdyFaceStart += npair;
+            bdyFaceEnd -= npair;
+
+            // periodic faces that could not be joined still refer to their partner
+            for(IDX ifac = bdyFaceStart; ifac < bdyFaceEnd; ++ifac){
+                if(faces[ifac]->bctype == PERIODIC) faces[ifac]->bcflag = new_index[faces[ifac]->bcflag];
+            }
+
+            // faces surrounding elements
+            std::vector<std::vector<IDX>> facsuel_ragged(nelem());
+            for(IDX iel = 0; iel < nelem(); ++iel){
+                facsuel_ragged[iel].resize(el_transformations[iel]->nfac);
+            }
+            for(IDX ifac = interiorFaceStart; ifac < interiorFaceEnd; ++ifac) {
+                facsuel_ragged[faces[ifac]->elemL][faces[ifac]->face_nr_l()] = ifac;
+                facsuel_ragged[faces[ifac]->elemR][faces[ifac]->face_nr_r()] = ifac;
+            }
+            for(IDX ifac = bdyFaceStart; ifac < bdyFaceEnd; ++ifac) {
+                facsuel_ragged[faces[ifac]->elemL][faces[ifac]->face_nr_l()] = ifac;
+            }
+            facsuel = util::crs<IDX, IDX>{facsuel_ragged};
+            update_face_table();
+            return npair;
+        }
+
+        /**
+         * @brief the translation from the right element of a face to the face
+         * x_face = x_right + offset (zero unless the face is one of periodic_faces)
+         * computed from the current coordinates so it follows node movement
+         */
+        auto periodic_offset(IDX ifac) -> Point {
+            Point offset{};
+            if(!std::ranges::binary_search(periodic_faces, ifac)) return offset;
+            const face_t& fac = *faces[ifac];
+            std::vector<IDX> vert_l = el_transformations[fac.elemL]->get_face_vert(fac.face_nr_l(), get_el_nodes(fac.elemL));
+            std::vector<IDX> vert_r = el_transformations[fac.elemR]->get_face_vert(fac.face_nr_r(), get_el_nodes(fac.elemR));
+            for(IDX ivert : vert_l) for(int idim = 0; idim < ndim; ++idim) offset[idim] += coord[ivert][idim] / vert_l.size();
+            for(IDX ivert : vert_r) for(int idim = 0; idim < ndim; ++idim) offset[idim] -= coord[ivert][idim] / vert_r.size();
+            return offset;
         }
 
         /// @brief get a span of the node indices for the given element
@@ -1079,4 +1459,11 @@ namespace iceicle {
 
         ~AbstractMesh() = default;
     };
+
+#ifdef ICEICLE_EXTERN_TEMPLATES
+    // compiled once in iceicle_core (see src/core/instantiations.cpp)
+    extern template class AbstractMesh<build_config::T, build_config::IDX, 1>;
+    extern template class AbstractMesh<build_config::T, build_config::IDX, 2>;
+    extern template class AbstractMesh<build_config::T, build_config::IDX, 3>;
+#endif
 }
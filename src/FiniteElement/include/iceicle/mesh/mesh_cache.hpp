@@ -0,0 +1,159 @@
+/**
+ * @brief a cache of uniform meshes shared by the unit tests and the benchmarks
+ *
+ * The meshes are described by the arguments of the uniform AbstractMesh constructor (uniform_mesh_desc)
+ * and built once per process. With a cache directory the meshes are also serialized
+ * in the native mesh format so later processes (i.e every test under ctest) read them
+ * instead of finding the interior faces again.
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/fe_definitions.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/mesh/mesh.hpp"
+#include "iceicle/mesh/native_mesh.hpp"
+#include "iceicle/tmp_utils.hpp"
+#include <array>
+#include <compare>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <system_error>
+
+namespace iceicle {
+
+    /// @brief the arguments of the uniform hyper-rectangle AbstractMesh constructor
+    template<class T, class IDX, int ndim>
+    struct uniform_mesh_desc {
+        std::array<T, ndim> xmin;
+        std::array<T, ndim> xmax;
+        std::array<IDX, ndim> nelem;
+        int order = 1;
+        std::array<BOUNDARY_CONDITIONS, 2 * ndim> bctypes;
+        std::array<int, 2 * ndim> bcflags{};
+
+        auto operator<=>(const uniform_mesh_desc&) const = default;
+
+        /// @brief the periodic unit box [0, 1]^ndim with nelem elements in every direction
+        static auto periodic_box(IDX nelem, int order = 1) -> uniform_mesh_desc {
+            uniform_mesh_desc desc{};
+            desc.xmin.fill(0.0);
+            desc.xmax.fill(1.0);
+            desc.nelem.fill(nelem);
+            desc.order = order;
+            desc.bctypes.fill(BOUNDARY_CONDITIONS::PERIODIC);
+            return desc;
+        }
+
+        /// @brief the periodic box [xmin, xmax] (the defaults of the Tensor AbstractMesh constructor)
+        static auto box(std::array<T, ndim> xmin, std::array<T, ndim> xmax,
+                std::array<IDX, ndim> nelem, int order = 1) -> uniform_mesh_desc {
+            uniform_mesh_desc desc{xmin, xmax, nelem, order};
+            desc.bctypes.fill(BOUNDARY_CONDITIONS::PERIODIC);
+            return desc;
+        }
+
+        /// @brief build the mesh
+        auto build() const -> AbstractMesh<T, IDX, ndim> {
+            return AbstractMesh<T, IDX, ndim>{tmp::from_range_t{}, xmin, xmax, nelem, order, bctypes, bcflags};
+        }
+
+        /// @brief a file name unique to the description and the native mesh format of this build
+        auto name() const -> std::string {
+            // FNV-1a over the bytes of every field
+            std::uint64_t hash = 14695981039346656037ull;
+            auto add = [&hash](const auto& value){
+                const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+                for(std::size_t i = 0; i < sizeof(value); ++i) { hash = (hash ^ bytes[i]) * 1099511628211ull; }
+            };
+            add(xmin); add(xmax); add(nelem); add(order); add(bctypes); add(bcflags);
+            add(impl::native_mesh::version); add(sizeof(T)); add(sizeof(IDX));
+            std::string nelem_str{};
+            for(int idim = 0; idim < ndim; ++idim) nelem_str += (idim > 0 ? "x" : "") + std::to_string(nelem[idim]);
+            return "box" + std::to_string(ndim) + "d_p" + std::to_string(order) + "_" + nelem_str
+                + "_" + std::to_string(hash);
+        }
+    };
+
+    /**
+     * @brief a cache of uniform meshes keyed by their description
+     *
+     * The cached meshes have their periodic faces joined into interior faces (see make_periodic_faces_interior()).
+     * They are shared by every caller and must not be modified
+     * (use copy() for a mesh to move the nodes of)
+     */
+    template<class T, class IDX, int ndim>
+    class MeshCache {
+        std::map<uniform_mesh_desc<T, IDX, ndim>, std::unique_ptr<AbstractMesh<T, IDX, ndim>>> meshes{};
+
+        public:
+
+        /// @brief the directory of the serialized meshes (empty only caches in memory)
+        /// meshes are only serialized on a single process
+        std::filesystem::path directory{};
+
+        MeshCache() = default;
+
+        explicit MeshCache(std::filesystem::path directory) : directory{std::move(directory)} {}
+
+        /**
+         * @brief the mesh for the description
+         * read from the cache directory or built (and written to the directory) on the first request
+         * then the periodic faces are joined
+         */
+        auto get(const uniform_mesh_desc<T, IDX, ndim>& desc) -> AbstractMesh<T, IDX, ndim>& {
+            auto it = meshes.find(desc);
+            if(it != meshes.end()) return *(it->second);
+
+            bool serialize = !directory.empty() && mpi::mpi_world_size() == 1;
+            std::string basename = (directory / desc.name()).string();
+            std::unique_ptr<AbstractMesh<T, IDX, ndim>> mesh{};
+            if(serialize && std::filesystem::exists(impl::native_mesh::rank_filename(basename, 0))) {
+                auto mesh_opt = read_native_mesh<T, IDX, ndim>(basename);
+                if(mesh_opt) mesh = std::make_unique<AbstractMesh<T, IDX, ndim>>(std::move(mesh_opt.value()));
+            }
+            if(!mesh) {
+                mesh = std::make_unique<AbstractMesh<T, IDX, ndim>>(desc.build());
+                std::error_code ec;
+                if(serialize) std::filesystem::create_directories(directory, ec);
+                if(serialize && !ec) {
+                    // write to a unique name and rename so concurrent processes never read a partial file
+                    std::string tmp_basename = basename + ".tmp" + std::to_string(std::random_device{}());
+                    write_native_mesh(*mesh, tmp_basename);
+                    std::filesystem::rename(impl::native_mesh::rank_filename(tmp_basename, 0),
+                            impl::native_mesh::rank_filename(basename, 0), ec);
+                }
+            }
+
+            // join the periodic faces once for every FESpace on the mesh
+            // (after serializing, the native mesh format keeps the periodic boundary faces)
+            mesh->make_periodic_faces_interior();
+            return *(meshes[desc] = std::move(mesh));
+        }
+
+        /// @brief a copy of the cached mesh that can be modified
+        auto copy(const uniform_mesh_desc<T, IDX, ndim>& desc) -> AbstractMesh<T, IDX, ndim> {
+            return AbstractMesh<T, IDX, ndim>{get(desc)};
+        }
+
+        /// @brief the number of meshes in memory
+        [[nodiscard]] auto size() const noexcept -> std::size_t { return meshes.size(); }
+
+        /**
+         * @brief the cache shared by the process
+         * serialized to the directory in the environment variable ICEICLE_MESH_CACHE if it is set
+         */
+        static auto instance() -> MeshCache& {
+            static MeshCache cache{[]{
+                const char* dir = std::getenv("ICEICLE_MESH_CACHE");
+                return (dir == nullptr) ? std::filesystem::path{} : std::filesystem::path{dir};
+            }()};
+            return cache;
+        }
+    };
+}
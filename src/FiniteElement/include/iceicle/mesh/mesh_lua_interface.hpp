@@ -4,25 +4,38 @@
 #include "iceicle/fe_definitions.hpp"
 #include "iceicle/geometry/face.hpp"
 #include "iceicle/geometry/transformations_table.hpp"
+#include "iceicle/mesh/distributed_uniform_mesh.hpp"
 #include "iceicle/mesh/mesh_utils.hpp"
 #include "iceicle/mesh/gmsh_utils.hpp"
+#include "iceicle/mesh/native_mesh.hpp"
+#include "iceicle/mesh/mesh_partition.hpp"
 #include "iceicle/string_utils.hpp"
+#include "iceicle/thread_utils.hpp"
+#include <array>
 #include <fstream>
 #include <iceicle/mesh/mesh.hpp>
 #include <iceicle/lua_utils.hpp>
 #include <optional>
+#include <span>
 #include <sol/sol.hpp>
+#ifdef ICEICLE_USE_MPI
+#include "iceicle/mpi_type.hpp"
+#include <mpi.h>
+#endif
 
 namespace iceicle {
 
     /**
      * @brief construct a uniform mesh from inputs provided in a lua table
+     * with distributed = true each process generates its block of the mesh (see distributed_uniform_mesh)
+     * which is already partitioned
      */
     template<class T, class IDX, int ndim>
     [[nodiscard]]
     auto lua_uniform_mesh(sol::table& mesh_table)
     -> std::optional<AbstractMesh<T, IDX, ndim>> {
         using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+        bool distributed = mesh_table.get_or("distributed", false);
         // boundary conditions
         Tensor<BOUNDARY_CONDITIONS, 2 * ndim> bctypes;
         for(int iside = 0; iside < 2 * ndim; ++iside){
@@ -38,6 +51,10 @@ namespace iceicle {
 
         // optional geometry order input
         int geometry_order = mesh_table.get_or("geometry_order", 1);
+        if(distributed && geometry_order != 1){
+            util::AnomalyLog::log_anomaly("distributed uniform meshes only support geometry_order = 1");
+            return std::nullopt;
+        }
 
         // bounding box
         Tensor<T, ndim> xmin;
@@ -54,6 +71,10 @@ namespace iceicle {
                 xmin[idim] = bounding_box_table.value()["min"][idim + 1];
                 xmax[idim] = bounding_box_table.value()["max"][idim + 1];
             }
+            if(distributed){
+                return distributed_uniform_mesh<T, IDX, ndim>(
+                    generate_directional_nodes<ndim>(xmin, xmax, nelem, 1), bctypes, bcflags);
+            }
             return std::optional{
                 AbstractMesh<T, IDX, ndim>{xmin, xmax, nelem, geometry_order, bctypes, bcflags}};
         } else {
@@ -80,6 +101,8 @@ namespace iceicle {
                         nodes_1d[idim].push_back(nodes_dir[inode + 1]);
                     }
                 }
+                if(distributed)
+                    return distributed_uniform_mesh<T, IDX, ndim>(nodes_1d, bctypes, bcflags);
                 return std::optional{AbstractMesh<T, IDX, ndim>{nodes_1d, geometry_order, bctypes, bcflags}};
             } else {
                 return std::nullopt;
@@ -220,11 +243,9 @@ namespace iceicle {
     auto lua_read_gmsh(sol::table& mesh_table) -> std::optional<AbstractMesh<T, IDX, ndim>> {
         using namespace iceicle::util;
         
-        // get the filename to read and open the file 
+        // get the filename to read
         sol::optional<std::string> filename = mesh_table["file"];
         if(filename) {
-            std::ifstream infile{filename.value()};
-
             // get the boundary definitions
             std::map<int, std::tuple<BOUNDARY_CONDITIONS, int>> bcmap;
             sol::optional<sol::table> bctable_opt = mesh_table["bc_definitions"];
@@ -238,7 +259,7 @@ namespace iceicle {
                 }
             }
 
-            return read_gmsh<T, IDX, ndim>(infile, bcmap);
+            return read_gmsh<T, IDX, ndim>(filename.value(), bcmap);
         } else {
             AnomalyLog::log_anomaly(Anomaly{"In the gmsh table \"file\" must be specified", general_anomaly_tag{}});
             return std::nullopt;
@@ -278,32 +299,89 @@ namespace iceicle {
         return std::nullopt;
     }
 
-    /// @brief perturb the nodes of the mesh if applicable
+    /**
+     * @brief perturb the nodes of the mesh if applicable
+     *
+     * mesh_perturbation is either
+     * - the name of a perturbation function ("taylor-green" or "zig-zag")
+     * - a table of ndim expression strings for the perturbed coordinates (see util::lua_get_expression)
+     * - a lua function f(n, x) called for batches of n nodes with x the flat table of their coordinates 
+     *   { x1, y1, x2, y2, ... } which returns the perturbed coordinates in the same layout
+     *   (mesh_perturbation_batch sets the number of nodes in a batch)
+     *
+     * This is applied to the nodes on each process 
+     * so distributed meshes (i.e uniform_mesh.distributed) are perturbed without a global mesh
+     */
     template<class T, class IDX, int ndim>
     auto perturb_mesh(sol::table& config, AbstractMesh<T, IDX, ndim>& mesh) -> void {
         using namespace util;
+        std::size_t batch_size = config.get_or("mesh_perturbation_batch", 65536);
         sol::optional<std::string> perturb_fcn_name = config["mesh_perturbation"];
-        if(perturb_fcn_name){
-            std::vector<bool> fixed_nodes = flag_boundary_nodes(mesh);
+        if(perturb_fcn_name && (eq_icase(perturb_fcn_name.value(), "taylor-green")
+                    || eq_icase(perturb_fcn_name.value(), "zig-zag"))){
 
             std::function< void(std::span<T, ndim>, std::span<T, ndim>) > perturb_fcn;
             if(eq_icase(perturb_fcn_name.value(), "taylor-green")){
-                auto bounding_box = compute_bounding_box(mesh);
+                // the bounding box of the elements (halo nodes are excluded)
+                // over all processes
+                BoundingBox<T, ndim> bounding_box{};
+                std::ranges::fill(bounding_box.xmin, 1e100);
+                std::ranges::fill(bounding_box.xmax, -1e100);
+                for(IDX inode : std::span{mesh.conn_el.data(), mesh.conn_el.data() + mesh.conn_el.nnz()}){
+                    for(int idim = 0; idim < ndim; ++idim){
+                        bounding_box.xmin[idim] = std::min(bounding_box.xmin[idim], mesh.coord[inode][idim]);
+                        bounding_box.xmax[idim] = std::max(bounding_box.xmax[idim], mesh.coord[inode][idim]);
+                    }
+                }
+#ifdef ICEICLE_USE_MPI
+                if(mpi::mpi_initialized()){
+                    MPI_Allreduce(MPI_IN_PLACE, bounding_box.xmin.data(), ndim, mpi_get_type<T>(), MPI_MIN, MPI_COMM_WORLD);
+                    MPI_Allreduce(MPI_IN_PLACE, bounding_box.xmax.data(), ndim, mpi_get_type<T>(), MPI_MAX, MPI_COMM_WORLD);
+                }
+#endif
                 perturb_fcn = PERTURBATION_FUNCTIONS::TaylorGreenVortex<T, ndim>{
                     .v0 = 0.5,
                     .xmin = bounding_box.xmin,
                     .xmax = bounding_box.xmax,
                     .L = 1
                 };
-            } else if(eq_icase(perturb_fcn_name.value(), "zig-zag")){
+            } else {
                 if constexpr (ndim >= 2){
                     perturb_fcn = PERTURBATION_FUNCTIONS::ZigZag<T, ndim>{};
                 } else {
                     AnomalyLog::log_anomaly(Anomaly{"zig-zag requires 2D or higher", general_anomaly_tag{}});
+                    return;
                 }
             }
 
-            perturb_nodes(mesh, perturb_fcn, fixed_nodes);
+            // the perturbation functions are pure so the nodes of a batch are perturbed concurrently
+            perturb_nodes_batched(mesh, [&perturb_fcn](std::size_t npoint, const T* x, T* xout){
+                parallel_for(npoint, [&](std::size_t ipoint){
+                    std::array<T, ndim> xin;
+                    std::copy_n(x + ipoint * ndim, ndim, xin.begin());
+                    perturb_fcn(std::span<T, ndim>{xin}, std::span<T, ndim>{xout + ipoint * ndim, ndim});
+                });
+            }, batch_size);
+        } else if(auto expr_func = lua_get_expression_batch_function<T>(config["mesh_perturbation"], ndim, ndim)){
+            perturb_nodes_batched(mesh, expr_func.value(), batch_size);
+        } else if(sol::optional<sol::protected_function> perturb_lua = config["mesh_perturbation"]){
+            sol::state_view lua{config.lua_state()};
+            perturb_nodes_batched(mesh, [&](std::size_t npoint, const T* x, T* xout){
+                sol::table xtbl = lua.create_table(npoint * ndim, 0);
+                for(std::size_t i = 0; i < npoint * ndim; ++i) xtbl[i + 1] = x[i];
+                sol::protected_function_result result = perturb_lua.value()(npoint, xtbl);
+                if(!result.valid() || result.get_type() != sol::type::table){
+                    AnomalyLog::log_anomaly(Anomaly{"mesh_perturbation function did not return a table",
+                            general_anomaly_tag{}});
+                    std::copy_n(x, npoint * ndim, xout);
+                    return;
+                }
+                sol::table xout_tbl = result;
+                for(std::size_t i = 0; i < npoint * ndim; ++i) xout[i] = xout_tbl.get_or(i + 1, x[i]);
+            }, batch_size);
+        } else if(perturb_fcn_name){
+            AnomalyLog::log_anomaly(Anomaly{"unrecognized mesh_perturbation: " + perturb_fcn_name.value(),
+                    general_anomaly_tag{}});
         }
     }
 
@@ -318,7 +396,11 @@ namespace iceicle {
             if(mesh_management){ 
                 sol::optional<sol::table> edge_flip_list = mesh_management.value()["edge_flips"];
                 
-                if(edge_flip_list) for(const auto& kv_pair : edge_flip_list.value()){
+                if(edge_flip_list && !mesh.gel_idxs.empty()){
+                    // the face indices are for the mesh before partitioning
+                    AnomalyLog::log_anomaly(Anomaly{"edge_flips are not supported for distributed meshes", 
+                            general_anomaly_tag{}});
+                } else if(edge_flip_list) for(const auto& kv_pair : edge_flip_list.value()){
                     IDX ifac = kv_pair.second.as<IDX>();
                     edge_swap(mesh, ifac);
                 }
@@ -333,4 +415,77 @@ namespace iceicle {
             AnomalyLog::log_anomaly(msg);
         }
     }
+
+    /// @brief if the mesh given by construct_mesh_from_config is already partitioned 
+    /// (uniform_mesh.distributed = true) so it should not be reordered or partitioned
+    inline auto lua_mesh_is_distributed(sol::table config) -> bool {
+        sol::optional<sol::table> gmesh_table = config["gmsh"];
+        sol::optional<sol::table> uniform_mesh_table = config["uniform_mesh"];
+        return !gmesh_table && uniform_mesh_table 
+            && uniform_mesh_table.value().get_or("distributed", false);
+    }
+
+    /// @brief reorder the elements, nodes, and faces of the mesh for memory locality
+    /// (see reorder_mesh and reorder_faces)
+    /// this is on by default and can be turned off with mesh_reordering = false
+    template<class T, class IDX, int ndim>
+    auto lua_reorder_mesh(sol::table config, AbstractMesh<T, IDX, ndim>& mesh) -> void {
+        sol::optional<bool> mesh_reordering = config["mesh_reordering"];
+        if(mesh_reordering.value_or(true)){
+            reorder_mesh(mesh);
+            reorder_faces(mesh);
+        }
+    }
+
+    /// @brief read the partitioned mesh from the native mesh files (see native_mesh.hpp)
+    /// given by native_mesh = "<basename>"
+    /// @return the mesh on this process, or std::nullopt if native_mesh is not given
+    /// or any process could not read its file (in which case the mesh should be built and partitioned)
+    template<class T, class IDX, int ndim>
+    auto lua_read_native_mesh(sol::table config) -> std::optional<AbstractMesh<T, IDX, ndim>> {
+        sol::optional<std::string> basename = config["native_mesh"];
+        if(!basename) return std::nullopt;
+
+        std::optional<AbstractMesh<T, IDX, ndim>> mesh = read_native_mesh<T, IDX, ndim>(basename.value());
+        if(util::AnomalyLog::size() > 0) {
+            std::cerr << "Could not read native mesh, falling back to building the mesh: ";
+            util::AnomalyLog::handle_anomalies(std::cerr);
+        }
+
+        // every process must agree or the partitions will be inconsistent
+        int found = mesh.has_value();
+#ifdef ICEICLE_USE_MPI
+        if(mpi::mpi_initialized())
+            MPI_Allreduce(MPI_IN_PLACE, &found, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+#endif
+        if(!found) return std::nullopt;
+        return mesh;
+    }
+
+    /// @brief write the partitioned mesh to the native mesh files (see native_mesh.hpp)
+    /// if native_mesh = "<basename>" is given
+    template<class T, class IDX, int ndim>
+    auto lua_write_native_mesh(sol::table config, const AbstractMesh<T, IDX, ndim>& mesh) -> void {
+        sol::optional<std::string> basename = config["native_mesh"];
+        if(basename) write_native_mesh(mesh, basename.value());
+    }
+
+    /// @brief get the weights for partition_mesh
+    /// partition_weights = "uniform" (default) uses unit weights 
+    /// partition_weights = "basis" estimates the element and face costs from the basis order in fespace.order 
+    /// (see estimate_partition_weights)
+    template<class T, class IDX, int ndim>
+    auto lua_partition_weights(sol::table config, AbstractMesh<T, IDX, ndim>& mesh) -> partition_weights<IDX> {
+        sol::optional<std::string> weights_name = config["partition_weights"];
+        if(!weights_name || util::eq_icase(weights_name.value(), "uniform"))
+            return partition_weights<IDX>{};
+        if(util::eq_icase(weights_name.value(), "basis")){
+            sol::optional<sol::table> fespace_tbl = config["fespace"];
+            int order = (fespace_tbl) ? fespace_tbl.value().get_or("order", 0) : 0;
+            return estimate_partition_weights(mesh, order);
+        }
+        util::AnomalyLog::log_anomaly(util::Anomaly{
+            "unrecognized partition_weights: " + weights_name.value(), util::general_anomaly_tag{}});
+        return partition_weights<IDX>{};
+    }
 }
@@ -1,9 +1,105 @@
+#pragma once
 #include "iceicle/anomaly_log.hpp"
 #include "iceicle/fe_definitions.hpp"
 #include "iceicle/geometry/face.hpp"
 #include "iceicle/geometry/face_utils.hpp"
 #include "iceicle/geometry/geo_element.hpp"
 #include <iceicle/mesh/mesh.hpp>
+#include <algorithm>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace iceicle {
+
+    /// @brief weights for the graph partitioning of the mesh
+    /// empty vectors use unit weights
+    template<class IDX>
+    struct partition_weights {
+        /// @brief the estimated (or measured) computational cost of each element (METIS vertex weights)
+        std::vector<IDX> el_weights{};
+
+        /// @brief the communication cost of each face of the mesh (METIS edge weights)
+        /// only used for the faces that connect two elements
+        std::vector<IDX> face_weights{};
+    };
+
+    /// @brief estimate the number of basis functions (or nodes) of a lagrange space on a domain
+    /// @param domain_type the reference domain
+    /// @param dim the dimensionality of the domain
+    /// @param order the polynomial order
+    inline constexpr
+    auto estimate_nbasis(DOMAIN_TYPE domain_type, int dim, int order) noexcept -> int {
+        int n = 1;
+        if(domain_type == DOMAIN_TYPE::SIMPLEX){
+            // (order + dim) choose dim
+            for(int i = 1; i <= dim; ++i) n = n * (order + i) / i;
+        } else {
+            for(int i = 0; i < dim; ++i) n *= order + 1;
+        }
+        return n;
+    }
+
+    /**
+     * @brief estimate the partitioning weights from the number of basis functions of each element
+     *
+     * The cost of an element is estimated as nbasis x nqp
+     * where the quadrature is taken to have as many points as a tensor product rule 
+     * (or basis functions for simplices) of order + 1.
+     * The cost of a face is the number of trace degrees of freedom for the higher order side.
+     *
+     * @param mesh the mesh to partition 
+     * @param el_basis_order the basis polynomial order of each element
+     * @return the weights for partition_mesh
+     */
+    template<class T, class IDX, int ndim>
+    auto estimate_partition_weights(AbstractMesh<T, IDX, ndim>& mesh, std::span<const int> el_basis_order)
+    -> partition_weights<IDX> {
+        partition_weights<IDX> weights{
+            std::vector<IDX>(mesh.nelem()),
+            std::vector<IDX>(mesh.faces.size(), 1)
+        };
+        for(IDX iel = 0; iel < mesh.nelem(); ++iel){
+            DOMAIN_TYPE domain_type = mesh.el_transformations[iel]->domain_type;
+            int order = el_basis_order[iel];
+            IDX nbasis = estimate_nbasis(domain_type, ndim, order);
+            IDX nqp = (domain_type == DOMAIN_TYPE::HYPERCUBE) 
+                ? estimate_nbasis(domain_type, ndim, order + 1) : nbasis;
+            weights.el_weights[iel] = nbasis * nqp;
+        }
+        for(IDX ifac = mesh.interiorFaceStart; ifac < mesh.interiorFaceEnd; ++ifac){
+            const Face<T, IDX, ndim>& fac = *mesh.faces[ifac];
+            int order = std::max(el_basis_order[fac.elemL], el_basis_order[fac.elemR]);
+            weights.face_weights[ifac] = estimate_nbasis(fac.domain_type(), ndim - 1, order);
+        }
+        return weights;
+    }
+
+    /// @brief estimate the partitioning weights for a uniform basis order (see above)
+    /// so that mixed element types are weighted by their cost
+    template<class T, class IDX, int ndim>
+    auto estimate_partition_weights(AbstractMesh<T, IDX, ndim>& mesh, int basis_order)
+    -> partition_weights<IDX> {
+        std::vector<int> el_basis_order(mesh.nelem(), basis_order);
+        return estimate_partition_weights(mesh, std::span<const int>{el_basis_order});
+    }
+
+    /// @brief keep the full mesh on every process (instead of partition_mesh)
+    /// sets up empty communication arrays so no elements are exchanged between processes
+    /// (i.e for the time parallel driver where the processes solve different time slices)
+    /// @param mesh the full mesh (on every process)
+    /// @return the mesh with empty communication arrays
+    template<class T, class IDX, int ndim>
+    auto replicate_mesh(AbstractMesh<T, IDX, ndim>& mesh) -> AbstractMesh<T, IDX, ndim>& {
+        int nrank = std::max(mpi::mpi_world_size(), 1);
+        mesh.el_send_list = std::vector<std::vector<IDX>>(nrank, std::vector<IDX>());
+        mesh.el_recv_list = std::vector<std::vector<IDX>>(nrank, std::vector<IDX>());
+        mesh.communicated_elements.clear();
+        mesh.communicated_elements.resize(nrank);
+        return mesh;
+    }
+}
+
 #ifdef ICEICLE_USE_METIS
 #include <metis.h>
 #ifdef ICEICLE_USE_MPI 
@@ -17,13 +113,18 @@
 namespace iceicle {
 
 
-    /// @brief partition the mesh using METIS 
-    /// @param mesh the single processor mesh to partition
-    /// NOTE: assumes valid mesh is on rank 0, other ranks can be empty or incomplete
-    ///
-    /// @return the partitioned mesh on each processor 
+    /**
+     * @brief distribute the mesh on rank 0 to the processes given the partition of its elements
+     * @param mesh the single processor mesh to distribute
+     * @param el_partition the rank each element of the mesh is sent to (only read on rank 0)
+     * NOTE: assumes valid mesh is on rank 0, other ranks can be empty or incomplete
+     * Only rank 0 holds global data, every other rank only receives the nodes and coordinates
+     * of its own partition (and its halo elements) so the memory per rank scales with the partition size
+     *
+     * @return the partitioned mesh on each processor
+     */
     template<class T, class IDX, int ndim>
-    auto partition_mesh(AbstractMesh<T, IDX, ndim>& mesh) 
+    auto distribute_mesh(AbstractMesh<T, IDX, ndim>& mesh, std::span<const int> el_partition)
     -> AbstractMesh<T, IDX, ndim>
     {
         // get mpi information
@@ -31,45 +132,31 @@ namespace iceicle {
         MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
         MPI_Comm_size(MPI_COMM_WORLD, &nrank);
 
-        // metis will floating point exception when partitioning into 1 partition
-        // ...
-        // ...
-        //
-        // :3
         if(nrank == 1) {
             // set up empty communication arrays that are used in parallel structures
-            mesh.el_send_list = std::vector<std::vector<IDX>>(nrank, std::vector<IDX>());
-            mesh.el_recv_list = std::vector<std::vector<IDX>>(nrank, std::vector<IDX>());
-            mesh.communicated_elements.resize(nrank);
-            return mesh;
+            return replicate_mesh(mesh);
         }
 
         /// @brief create an empty mesh -- this will be the partitioned mesh
         AbstractMesh<T, IDX, ndim> pmesh{};
 
-        // Broadcast all the node data 
-        NodeArray<T, ndim> gcoord{};
-        unsigned long n_nodes_total;
-        if(myrank == 0)
-        { 
-            gcoord = mesh.coord;
-            n_nodes_total = mesh.coord.size();
-        }
-        MPI_Bcast(&n_nodes_total, 1, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);
-        if(myrank != 0)
-        { gcoord.resize(n_nodes_total); }
-
-        // WARNING: assumption about size of Point type
-        MPI_Bcast(gcoord[0].data(), gcoord.size() * ndim, mpi_get_type<T>(), 0, MPI_COMM_WORLD);
-
         // global node index for each local node
         std::vector<long unsigned int> gnode_idxs;
 
-        // local node index for each global node index;
-        std::vector<IDX> inv_gnode_idxs(n_nodes_total, -1);
-
-        // for each global element index, store the local index, or -1
-        std::vector<IDX> inv_gel_idxs(mesh.nelem(), -1);
+        // local node index for each global node index
+        // (sparse so that ranks other than the root only store their own nodes)
+        std::unordered_map<long unsigned int, IDX> inv_gnode_idxs;
+        auto local_node = [&inv_gnode_idxs](long unsigned int ignode) -> IDX {
+            auto it = inv_gnode_idxs.find(ignode);
+            return (it == inv_gnode_idxs.end()) ? -1 : it->second;
+        };
+
+        // local index for each global element index (-1 if not on this rank)
+        std::unordered_map<IDX, IDX> inv_gel_idxs;
+        auto local_el = [&inv_gel_idxs](IDX iel) -> IDX {
+            auto it = inv_gel_idxs.find(iel);
+            return (it == inv_gel_idxs.end()) ? -1 : it->second;
+        };
 
         // initialize the communication requirement matrix
         pmesh.el_send_list = std::vector<std::vector<IDX>>(nrank, std::vector<IDX>());
@@ -79,22 +166,6 @@ namespace iceicle {
         // only the first processor will perform the partitioning
         if(myrank == 0){
             IDX nelem = mesh.nelem();
-            util::crs elsuel{util::convert_crs<idx_t, idx_t>(to_elsuel<T, IDX, ndim>(nelem, mesh.faces))};
-
-            // number of balancing constraints (not specifying so leave at 1)
-            IDX ncon = 1;
-
-            // set the options
-            idx_t options[METIS_NOPTIONS];
-            METIS_SetDefaultOptions(options);
-            options[METIS_OPTION_NUMBERING] = 0;
-
-            idx_t obj_val; // the objective value (edge-cut) of the partitioning scheme
-            std::vector<idx_t> el_partition(nelem);
-
-            METIS_PartGraphKway(&nelem, &ncon, elsuel.cols(), elsuel.data(),
-                    NULL, NULL, NULL, &nrank, NULL, NULL,
-                    options, &obj_val, el_partition.data());
 
             // ====================================
             // = Generate the Partitioned Meshes  =
@@ -112,18 +183,31 @@ namespace iceicle {
                 }
             }
 
-            // send the node lists to each processor 
+            // remove duplicates so each processor only gets the nodes it needs once
+            for(int irank = 0; irank < nrank; ++irank){
+                std::ranges::sort(all_node_idxs[irank]);
+                auto unique_subrange = std::ranges::unique(all_node_idxs[irank]);
+                all_node_idxs[irank].erase(unique_subrange.begin(), unique_subrange.end());
+            }
+
+            // send the node lists and the coordinates of those nodes to each processor 
+            // (each processor only receives the coordinates it owns instead of the global coordinates)
             for(int irank = 1; irank < nrank; ++irank){
                 // send the size 
                 unsigned long sz = all_node_idxs[irank].size();
                 MPI_Send(&sz, 1, MPI_UNSIGNED_LONG, irank, 0, MPI_COMM_WORLD);
                 MPI_Send(all_node_idxs[irank].data(), sz, MPI_UNSIGNED_LONG, irank, 0, MPI_COMM_WORLD);
+
+                std::vector<T> rank_coord;
+                rank_coord.reserve(sz * ndim);
+                for(unsigned long inode : all_node_idxs[irank]){
+                    for(int idim = 0; idim < ndim; ++idim)
+                        { rank_coord.push_back(mesh.coord[inode][idim]); }
+                }
+                MPI_Send(rank_coord.data(), sz * ndim, mpi_get_type<T>(), irank, 0, MPI_COMM_WORLD);
             }
 
-            gnode_idxs = all_node_idxs[0];
-            std::ranges::sort(gnode_idxs);
-            auto unique_subrange = std::ranges::unique(gnode_idxs);
-            gnode_idxs.erase(unique_subrange.begin(), unique_subrange.end());
+            gnode_idxs = std::move(all_node_idxs[0]);
 
             for(IDX ilocal = 0; ilocal < gnode_idxs.size(); ++ilocal)
                 { inv_gnode_idxs[gnode_idxs[ilocal]] = ilocal; }
@@ -131,7 +215,7 @@ namespace iceicle {
 
             pmesh.coord.reserve(gnode_idxs.size());
             for(unsigned long inode : gnode_idxs)
-                { pmesh.coord.push_back(gcoord[inode]); }
+                { pmesh.coord.push_back(mesh.coord[inode]); }
 
             // === Step 2: Elements ===
 
@@ -143,7 +227,7 @@ namespace iceicle {
                     inv_gel_idxs[iel] = ragged_conn_el.size();
                     std::vector<IDX> el_nodes;
                     for(IDX inode : mesh.get_el_nodes(iel)){
-                        el_nodes.push_back(inv_gnode_idxs[inode]);
+                        el_nodes.push_back(local_node(inode));
                     }
                     ragged_conn_el.push_back(el_nodes);
                     pmesh.el_transformations.push_back(trans);
@@ -186,8 +270,8 @@ namespace iceicle {
                 if(rank_l == 0) {
                     if(rank_r == 0){
                         // Easy case: internal face on this process
-                        IDX iel_parallel = inv_gel_idxs[iel];
-                        IDX ier_parallel = inv_gel_idxs[ier];
+                        IDX iel_parallel = local_el(iel);
+                        IDX ier_parallel = local_el(ier);
 
                         auto face_parallel = make_face(iel_parallel, ier_parallel, 
                             pmesh.el_transformations[iel_parallel], pmesh.el_transformations[ier_parallel], 
@@ -219,7 +303,7 @@ namespace iceicle {
                         MPI_Send(&ier, 1, mpi_get_type<IDX>(), rank_other, 6, MPI_COMM_WORLD);
 
                         // exchange local element index 
-                        IDX iel_local = inv_gel_idxs[iel];
+                        IDX iel_local = local_el(iel);
                         IDX ier_local;
                         MPI_Sendrecv(
                             &iel_local, 1, mpi_get_type<IDX>(), rank_other, 7,
@@ -241,7 +325,7 @@ namespace iceicle {
                         // create a list of local nodes
                         std::vector<IDX> local_face_nodes(n_face_nodes);
                         for(int inode = 0; inode < n_face_nodes; ++inode)
-                            local_face_nodes[inode] = inv_gnode_idxs[face.nodes()[inode]];
+                            local_face_nodes[inode] = local_node(face.nodes()[inode]);
 
                         // send the face numbers and orientation 
                         int face_nr_l = face.face_nr_l(), face_nr_r = face.face_nr_r();
@@ -286,7 +370,7 @@ namespace iceicle {
 
                     // exchange local element index 
                     IDX iel_local;
-                    IDX ier_local = inv_gel_idxs[ier];
+                    IDX ier_local = local_el(ier);
                     MPI_Sendrecv(
                         &ier_local, 1, mpi_get_type<IDX>(), rank_other, 7,
                         &iel_local, 1, mpi_get_type<IDX>(), rank_other, 7, 
@@ -307,7 +391,7 @@ namespace iceicle {
                     // create a list of local nodes
                     std::vector<IDX> local_face_nodes(n_face_nodes);
                     for(int inode = 0; inode < n_face_nodes; ++inode)
-                        local_face_nodes[inode] = inv_gnode_idxs[face.nodes()[inode]];
+                        local_face_nodes[inode] = local_node(face.nodes()[inode]);
 
                     // send the face numbers and orientation 
                     int face_nr_l = face.face_nr_l(), face_nr_r = face.face_nr_r();
@@ -420,15 +504,11 @@ namespace iceicle {
             }
 
             // reorganize the faces so that the now boundary faces (PARALLEL_COM) are at the end
-            IDX boundary_faces_begin = pmesh.faces.size();
-            for(IDX iface = 0; iface < boundary_faces_begin; ++iface) {
-                if(pmesh.faces[iface]->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM)
-                {
-                    --boundary_faces_begin;
-                    std::swap(pmesh.faces[iface], pmesh.faces[boundary_faces_begin]);
-                    --iface;
-                }
-            }
+            // (stable to keep the ordering of the serial mesh faces)
+            auto parallel_faces = std::stable_partition(pmesh.faces.begin(), pmesh.faces.end(),
+                [](const std::unique_ptr<Face<T, IDX, ndim>>& fac)
+                { return fac->bctype != BOUNDARY_CONDITIONS::PARALLEL_COM; });
+            IDX boundary_faces_begin = std::distance(pmesh.faces.begin(), parallel_faces);
             pmesh.interiorFaceStart = 0;
             pmesh.interiorFaceEnd = boundary_faces_begin;
             pmesh.bdyFaceStart = boundary_faces_begin;
@@ -447,12 +527,12 @@ namespace iceicle {
                     // create a list of local nodes
                     std::vector<IDX> local_face_nodes(face.n_nodes());
                     for(int inode = 0; inode < face.n_nodes(); ++inode)
-                        local_face_nodes[inode] = inv_gnode_idxs[face.nodes()[inode]];
+                        local_face_nodes[inode] = local_node(face.nodes()[inode]);
                     // face is local
                     auto face_opt = make_face<T, IDX, ndim>(
                         face.domain_type(), mesh.el_transformations[face.elemL]->domain_type,
                         mesh.el_transformations[face.elemL]->domain_type,
-                        face.geometry_order(), inv_gel_idxs[iel], 0,
+                        face.geometry_order(), local_el(iel), 0,
                         local_face_nodes, 
                         face.face_nr_l(), face.face_nr_r(), face.orientation_r(),
                         face.bctype, face.bcflag
@@ -518,17 +598,17 @@ namespace iceicle {
             gnode_idxs.resize(n_nodes);
             MPI_Recv(gnode_idxs.data(), n_nodes, MPI_UNSIGNED_LONG, 0, 0, MPI_COMM_WORLD, &status);
 
-            std::ranges::sort(gnode_idxs);
-            auto unique_subrange = std::ranges::unique(gnode_idxs);
-            gnode_idxs.erase(unique_subrange.begin(), unique_subrange.end());
-
-
             for(IDX ilocal = 0; ilocal < gnode_idxs.size(); ++ilocal)
                 { inv_gnode_idxs[gnode_idxs[ilocal]] = ilocal; }
 
-            pmesh.coord.reserve(n_nodes);
-            for(unsigned long inode : gnode_idxs)
-                { pmesh.coord.push_back(gcoord[inode]); }
+            // recieve the coordinates of the nodes on this processor
+            std::vector<T> rank_coord(n_nodes * ndim);
+            MPI_Recv(rank_coord.data(), n_nodes * ndim, mpi_get_type<T>(), 0, 0, MPI_COMM_WORLD, &status);
+            pmesh.coord.resize(n_nodes);
+            for(IDX ilocal = 0; ilocal < n_nodes; ++ilocal){
+                for(int idim = 0; idim < ndim; ++idim)
+                    { pmesh.coord[ilocal][idim] = rank_coord[ilocal * ndim + idim]; }
+            }
 
             // === Step 2: Elements ===
 
@@ -545,7 +625,7 @@ namespace iceicle {
                 std::vector<IDX> elnodes(n_nodes);
                 MPI_Recv(elnodes.data(), n_nodes, mpi_get_type<IDX>(), 0, 0, MPI_COMM_WORLD, &status);
                 for(int inode = 0; inode < n_nodes; ++inode){
-                    elnodes[inode] = inv_gnode_idxs[elnodes[inode]];
+                    elnodes[inode] = local_node(elnodes[inode]);
                 }
                 pmesh.el_transformations.push_back(
                     transformation_table<T, IDX, ndim>.get_transform((DOMAIN_TYPE) domain_type, geo_order));
@@ -579,8 +659,8 @@ namespace iceicle {
                 MPI_Recv(&ier, 1, mpi_get_type<IDX>(), 0, 6, MPI_COMM_WORLD, &status);
 
                 // one of these will be -1, we will overwrite with the local from the other rank
-                IDX iel_local = inv_gel_idxs[iel];
-                IDX ier_local = inv_gel_idxs[ier];
+                IDX iel_local = local_el(iel);
+                IDX ier_local = local_el(ier);
 
                 if(rank_l != rank_r){
                     // exchange local element index with other rank
@@ -613,7 +693,7 @@ namespace iceicle {
                 std::vector<IDX> face_nodes(n_face_nodes);
                 MPI_Recv(face_nodes.data(), n_face_nodes, mpi_get_type<IDX>(), 0, 10, MPI_COMM_WORLD, &status);
                 for(int inode = 0; inode < n_face_nodes; ++inode)
-                    face_nodes[inode] = inv_gnode_idxs[face_nodes[inode]];
+                    face_nodes[inode] = local_node(face_nodes[inode]);
 
                 // get the face numbers and orientation
                 int face_nr_l, face_nr_r, orient_r;
@@ -643,16 +723,11 @@ namespace iceicle {
             }
 
             // reorganize the faces so that the now boundary faces (PARALLEL_COM) are at the end
-            IDX boundary_faces_begin = pmesh.faces.size();
-            for(IDX iface = 0; iface < boundary_faces_begin; ++iface)
-            {
-                if(pmesh.faces[iface]->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM)
-                {
-                    --boundary_faces_begin;
-                    std::swap(pmesh.faces[iface], pmesh.faces[boundary_faces_begin]);
-                    --iface;
-                }
-            }
+            // (stable to keep the ordering of the serial mesh faces)
+            auto parallel_faces = std::stable_partition(pmesh.faces.begin(), pmesh.faces.end(),
+                [](const std::unique_ptr<Face<T, IDX, ndim>>& fac)
+                { return fac->bctype != BOUNDARY_CONDITIONS::PARALLEL_COM; });
+            IDX boundary_faces_begin = std::distance(pmesh.faces.begin(), parallel_faces);
             pmesh.interiorFaceStart = 0;
             pmesh.interiorFaceEnd = boundary_faces_begin;
             pmesh.bdyFaceStart = boundary_faces_begin;
@@ -667,7 +742,7 @@ namespace iceicle {
                 // get the global element index
                 IDX iel;
                 MPI_Recv(&iel, 1, mpi_get_type<IDX>(), 0, 2, MPI_COMM_WORLD, &status);
-                IDX iel_local = inv_gel_idxs[iel];
+                IDX iel_local = local_el(iel);
 
                 // get the geometry_order
                 int geo_order;
@@ -679,7 +754,7 @@ namespace iceicle {
                 std::vector<IDX> face_nodes(n_face_nodes);
                 MPI_Recv(face_nodes.data(), n_face_nodes, mpi_get_type<IDX>(), 0, 5, MPI_COMM_WORLD, &status);
                 for(int inode = 0; inode < n_face_nodes; ++inode){
-                    face_nodes[inode] = inv_gnode_idxs[face_nodes[inode]];
+                    face_nodes[inode] = local_node(face_nodes[inode]);
                 }
 
                 // get the face numbers and orientation
@@ -713,10 +788,16 @@ namespace iceicle {
         }
 
         // sort the element communication lists and remove duplicates
+        // both sides of a rank pair store the sending rank's local indices 
+        // so after sorting the send list on one rank matches the recv list on the other
         for(int i = 0; i < nrank; ++i){
             std::ranges::sort(pmesh.el_recv_list[i]);
             auto unique_subrange = std::ranges::unique(pmesh.el_recv_list[i]);
             pmesh.el_recv_list[i].erase(unique_subrange.begin(), unique_subrange.end());
+
+            std::ranges::sort(pmesh.el_send_list[i]);
+            auto unique_send_subrange = std::ranges::unique(pmesh.el_send_list[i]);
+            pmesh.el_send_list[i].erase(unique_send_subrange.begin(), unique_send_subrange.end());
         }
 
 
@@ -742,7 +823,13 @@ namespace iceicle {
                         // ...
                         // ...
                         for(IDX inode : pmesh.get_el_nodes(ielem)){
-                            MPI_Send(&gnode_idxs[inode], 1, mpi_get_type<IDX>(), jrank, 10, MPI_COMM_WORLD);
+                            MPI_Send(&gnode_idxs[inode], 1, MPI_UNSIGNED_LONG, jrank, 10, MPI_COMM_WORLD);
+                        }
+
+                        // coordinates of the element nodes 
+                        // (the receiving processor does not have the global coordinates)
+                        for(IDX inode : pmesh.get_el_nodes(ielem)){
+                            MPI_Send(pmesh.coord[inode].data(), ndim, mpi_get_type<T>(), jrank, 11, MPI_COMM_WORLD);
                         }
                     }
                 }
@@ -754,26 +841,31 @@ namespace iceicle {
                     MPI_Recv(&domain_type, 1, MPI_INT, irank, ielem, MPI_COMM_WORLD, &status);
                     MPI_Recv(&n_nodes, 1, MPI_INT, irank, ielem, MPI_COMM_WORLD, &status);
 
-                    std::vector<IDX> el_gnodes(n_nodes);
+                    std::vector<long unsigned int> el_gnodes(n_nodes);
                     for(int i = 0; i < n_nodes; ++i)
-                        MPI_Recv(&el_gnodes[i], 1, mpi_get_type<IDX>(), irank, 10, MPI_COMM_WORLD, &status);
+                        MPI_Recv(&el_gnodes[i], 1, MPI_UNSIGNED_LONG, irank, 10, MPI_COMM_WORLD, &status);
+
+                    std::vector<MATH::GEOMETRY::Point<T, ndim>> el_gcoord(n_nodes);
+                    for(int i = 0; i < n_nodes; ++i)
+                        MPI_Recv(el_gcoord[i].data(), ndim, mpi_get_type<T>(), irank, 11, MPI_COMM_WORLD, &status);
 
                     std::vector<IDX> el_nodes;
                     std::vector<MATH::GEOMETRY::Point<T, ndim>> el_coord;
-                    for(IDX ignode : el_gnodes){
-                        IDX inode = inv_gnode_idxs[ignode];
+                    for(int i = 0; i < n_nodes; ++i){
+                        long unsigned int ignode = el_gnodes[i];
+                        IDX inode = local_node(ignode);
 
                         // check if node is found or add it
                         if(inode == -1){
                             // add a new node
                             inode = gnode_idxs.size();
-                            inv_gnode_idxs[gnode_idxs.size()] = ignode;
+                            inv_gnode_idxs[ignode] = inode;
                             gnode_idxs.push_back(ignode);
-                            pmesh.coord.push_back(gcoord[ignode]);
+                            pmesh.coord.push_back(el_gcoord[i]);
                         }
 
                         el_nodes.push_back(inode);
-                        el_coord.push_back(gcoord[ignode]);
+                        el_coord.push_back(el_gcoord[i]);
                     }
 
                     CommElementInfo<T, IDX, ndim> comm_el{
@@ -788,6 +880,13 @@ namespace iceicle {
             MPI_Barrier(MPI_COMM_WORLD);
         }
 
+        // keep the global indices to map back to the mesh that was partitioned
+        using global_index_type = AbstractMesh<T, IDX, ndim>::global_index_type;
+        pmesh.gnode_idxs = std::vector<global_index_type>(gnode_idxs.begin(), gnode_idxs.end());
+        pmesh.gel_idxs.resize(pmesh.nelem());
+        for(auto [iel_global, iel_local] : inv_gel_idxs)
+            { pmesh.gel_idxs[iel_local] = iel_global; }
+
 #ifndef NDEBUG 
         for(int i = 0; i < nrank; ++i){
             MPI_Barrier(MPI_COMM_WORLD);
@@ -828,6 +927,83 @@ namespace iceicle {
 
     }
 
+    /// @brief partition the mesh using METIS 
+    /// @param mesh the single processor mesh to partition
+    /// @param weights the element and face weights for the partitioner (see estimate_partition_weights)
+    /// default is unit weights
+    /// NOTE: assumes valid mesh is on rank 0, other ranks can be empty or incomplete
+    /// (see distribute_mesh)
+    ///
+    /// @return the partitioned mesh on each processor 
+    template<class T, class IDX, int ndim>
+    auto partition_mesh(AbstractMesh<T, IDX, ndim>& mesh, const partition_weights<IDX>& weights = {}) 
+    -> AbstractMesh<T, IDX, ndim>
+    {
+        // get mpi information
+        int nrank, myrank;
+        MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
+        MPI_Comm_size(MPI_COMM_WORLD, &nrank);
+
+        // metis will floating point exception when partitioning into 1 partition
+        // ...
+        // ...
+        //
+        // :3
+        if(nrank == 1) {
+            // set up empty communication arrays that are used in parallel structures
+            return replicate_mesh(mesh);
+        }
+
+        // only the first processor will perform the partitioning
+        std::vector<int> el_partition{};
+        if(myrank == 0){
+            IDX nelem = mesh.nelem();
+
+            // build the element graph (same connectivity as to_elsuel) along with the edge weights
+            std::vector<std::vector<idx_t>> elsuel_ragged(nelem), adjwgt_ragged(nelem);
+            for(std::size_t ifac = 0; ifac < mesh.faces.size(); ++ifac){
+                IDX elemL = mesh.faces[ifac]->elemL;
+                IDX elemR = mesh.faces[ifac]->elemR;
+                if(elemR != -1){
+                    idx_t wgt = (weights.face_weights.empty()) ? 1 : std::max((idx_t) weights.face_weights[ifac], (idx_t) 1);
+                    elsuel_ragged[elemL].push_back(elemR);
+                    adjwgt_ragged[elemL].push_back(wgt);
+                    elsuel_ragged[elemR].push_back(elemL);
+                    adjwgt_ragged[elemR].push_back(wgt);
+                }
+            }
+            util::crs<idx_t, idx_t> elsuel{elsuel_ragged};
+            util::crs<idx_t, idx_t> adjwgt{adjwgt_ragged};
+
+            // vertex weights (metis requires positive weights)
+            std::vector<idx_t> vwgt{};
+            if(!weights.el_weights.empty()){
+                vwgt.resize(nelem);
+                for(IDX iel = 0; iel < nelem; ++iel)
+                    vwgt[iel] = std::max((idx_t) weights.el_weights[iel], (idx_t) 1);
+            }
+
+            // number of balancing constraints (not specifying so leave at 1)
+            IDX ncon = 1;
+
+            // set the options
+            idx_t options[METIS_NOPTIONS];
+            METIS_SetDefaultOptions(options);
+            options[METIS_OPTION_NUMBERING] = 0;
+
+            idx_t obj_val; // the objective value (edge-cut) of the partitioning scheme
+            std::vector<idx_t> metis_partition(nelem);
+
+            METIS_PartGraphKway(&nelem, &ncon, elsuel.cols(), elsuel.data(),
+                    (vwgt.empty()) ? NULL : vwgt.data(), NULL,
+                    (weights.face_weights.empty()) ? NULL : adjwgt.data(), &nrank, NULL, NULL,
+                    options, &obj_val, metis_partition.data());
+
+            el_partition.assign(metis_partition.begin(), metis_partition.end());
+        }
+        return distribute_mesh(mesh, std::span<const int>{el_partition});
+    }
+
 }
 
 
@@ -836,7 +1012,7 @@ namespace iceicle {
 #else // No metis 
     namespace iceicle {
         template<class T, class IDX, int ndim>
-        auto partition_mesh(const AbstractMesh<T, IDX, ndim>& mesh) 
+        auto partition_mesh(const AbstractMesh<T, IDX, ndim>& mesh, const partition_weights<IDX>& weights = {}) 
         -> const AbstractMesh<T, IDX, ndim>&
         {
             return mesh;
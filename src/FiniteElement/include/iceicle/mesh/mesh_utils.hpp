@@ -11,62 +11,25 @@
 #include "iceicle/geometry/transformations_table.hpp"
 #include "iceicle/mesh/mesh.hpp"
 #include "iceicle/geometry/geo_primitives.hpp"
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
 #include <random>
 #include <vector>
 
 namespace iceicle {
 
     /// @brief find and create all the interior faces for a mesh
+    /// (see hash_interior_faces)
     template<class T, class IDX, int ndim>
     auto find_interior_faces(
         AbstractMesh<T, IDX, ndim>& mesh
     ) {
-        using namespace util;
-
-        // elements surrounding points
-        std::vector<std::vector<IDX>> elsup(mesh.n_nodes());
-        for(IDX ielem = 0; ielem < mesh.nelem(); ++ielem){
-            for(IDX inode : mesh.conn_el.rowspan(ielem)){
-                elsup[inode].push_back(ielem);
-            }
-        }
-
-        // remove duplicates and sort
-        for(IDX inode = 0; inode < mesh.n_nodes(); ++inode){
-            std::ranges::sort(elsup[inode]);
-            auto unique_subrange = std::ranges::unique(elsup[inode]);
-            elsup[inode].erase(unique_subrange.begin(), unique_subrange.end());
-        }
-
-        // if elements share at least ndim points, then they have a face
-        for(IDX ielem = 0; ielem < mesh.nelem(); ++ielem){
-            int max_faces = mesh.el_transformations[ielem]->nfac;
-            std::vector<IDX> connected_elements;
-            connected_elements.reserve(max_faces);
-
-            // loop through elements that share a node
-            for(IDX inode : mesh.conn_el.rowspan(ielem)){
-                for(auto jelem_iter = std::lower_bound(elsup[inode].begin(), elsup[inode].end(), ielem);
-                        jelem_iter != elsup[inode].end(); ++jelem_iter){
-                    IDX jelem = *jelem_iter;
-
-                    // skip the cases that would lead to duplicate or boundary faces
-                    if( ielem == jelem || std::ranges::find(connected_elements, jelem) != std::ranges::end(connected_elements))
-                        continue; 
-
-                    // try making the face that is the intersection of the two elements
-                    auto face_opt = make_face(ielem, jelem, 
-                            mesh.el_transformations[ielem], mesh.el_transformations[jelem],
-                            mesh.conn_el.rowspan(ielem), mesh.conn_el.rowspan(jelem));
-                    if(face_opt){
-                        mesh.faces.push_back(std::move(face_opt.value()));
-                        // short circuit if all the faces have been found
-                        connected_elements.push_back(jelem);
-                        if(connected_elements.size() == max_faces) break;
-                    }
-                }
-            }
-        }
+        auto interior_faces = hash_interior_faces<T, IDX, ndim>(mesh.conn_el, mesh.el_transformations);
+        for(auto& facptr : interior_faces)
+            { mesh.faces.push_back(std::move(facptr)); }
     }
 
     /// @brief form a mixed uniform mesh with square and triangle elements
@@ -207,10 +170,11 @@ namespace iceicle {
                 ->centroid(mesh.get_el_coord(faceptr->elemL));
             auto centroid_r = mesh.el_transformations[faceptr->elemR]
                 ->centroid(mesh.get_el_coord(faceptr->elemR));
+            auto offset_r = mesh.periodic_offset(ifac);
             Tensor<T, ndim> internal_l, internal_r;
             for(int idim = 0; idim < ndim; ++idim){
                 internal_l[idim] = centroid_l[idim] - centroid_fac[idim];
-                internal_r[idim] = centroid_r[idim] - centroid_fac[idim];
+                internal_r[idim] = centroid_r[idim] + offset_r[idim] - centroid_fac[idim];
             }
             // TODO: generalize face centroid ref domain 
             MATH::GEOMETRY::Point<T, ndim - 1> s;
@@ -223,27 +187,41 @@ namespace iceicle {
 
         for(IDX ifac = mesh.bdyFaceStart; ifac < mesh.bdyFaceEnd; ++ifac){
             auto faceptr = mesh.faces[ifac].get();
+            // interprocess faces only have one element on this process
+            bool im_right = faceptr->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM 
+                && !decode_mpi_bcflag(faceptr->bcflag).second;
+            IDX iel = (im_right) ? faceptr->elemR : faceptr->elemL;
             auto centroid_fac = face_centroid(*faceptr, mesh.coord);
-            auto centroid_l = mesh.el_transformations[faceptr->elemL]
-                ->centroid(mesh.get_el_coord(faceptr->elemL));
-            Tensor<T, ndim> internal_l, internal_r;
+            auto centroid_el = mesh.el_transformations[iel]->centroid(mesh.get_el_coord(iel));
+            Tensor<T, ndim> internal_el;
             for(int idim = 0; idim < ndim; ++idim){
-                internal_l[idim] = centroid_l[idim] - centroid_fac[idim];
+                internal_el[idim] = centroid_el[idim] - centroid_fac[idim];
             }
             // TODO: generalize face centroid ref domain 
             MATH::GEOMETRY::Point<T, ndim - 1> s;
             for(int idim = 0; idim < ndim - 1; ++idim) s[idim] = 0.0; 
             auto normal = calc_normal(*faceptr, mesh.coord, s);
-            if(dot(normal, internal_l) > 0.0){
+            if((im_right) ? dot(normal, internal_el) < 0.0 : dot(normal, internal_el) > 0.0){
                 invalid_faces.push_back(ifac);
             }
         }
         return invalid_faces.size() == 0;
     }
 
+    /**
+     * @brief swap the diagonal of the two triangles that share an interior face 
+     * The connectivity of the mesh (conn_el, coord_els, faces, facsuel, elsup, and the face table)
+     * is patched in place, the element and face indices are reused
+     *
+     * @param mesh the mesh 
+     * @param ifac the index of the face to swap
+     * @return the entities touched by the swap 
+     * (to patch spaces built on the mesh with FESpace::apply_topology_edit())
+     * empty if the swap could not be performed
+     */
     template<class T, class IDX>
     auto edge_swap(AbstractMesh<T, IDX, 2>& mesh, IDX ifac)
-    -> void {
+    -> topology_edit<IDX> {
         IDX elemL = mesh.faces[ifac]->elemL;
         IDX elemR = mesh.faces[ifac]->elemR;
         ElementTransformation<T, IDX, 2> *transL = mesh.el_transformations[elemL];
@@ -259,7 +237,7 @@ namespace iceicle {
 
             if(transL->order != 1 || transR->order != 1) [[unlikely]] {
                 util::AnomalyLog::log_anomaly("Not implemented");
-                return;
+                return topology_edit<IDX>{};
             }
 
             //           c
@@ -347,7 +325,7 @@ namespace iceicle {
                         face_nr_l, face_nr_r, orient_r);
                 if(!face_opt){
                     util::AnomalyLog::log_anomaly("failed to make new face.");
-                    return;
+                    return topology_edit<IDX>{};
                 } else {
                     std::swap(face_opt.value(), mesh.faces[ifac]);
                 }
@@ -446,6 +424,37 @@ namespace iceicle {
                 if(fac.bctype == BOUNDARY_CONDITIONS::INTERIOR)
                     mesh.facsuel[fac.elemR, fac.face_nr_r()] = ifac_update;
             }
+
+            // === patch the remaining connectivity ===
+            topology_edit<IDX> edit{};
+            edit.faces.push_back(ifac);
+            edit.elements = {elemL, elemR};
+            for(IDX ifac_update : faces_to_update){
+                const Face<T, IDX, 2>& fac = *(mesh.faces[ifac_update]);
+                edit.faces.push_back(ifac_update);
+                edit.elements.push_back(fac.elemL);
+                edit.elements.push_back(fac.elemR);
+            }
+            std::ranges::sort(edit.elements);
+            auto unique_subrange = std::ranges::unique(edit.elements);
+            edit.elements.erase(unique_subrange.begin(), unique_subrange.end());
+            edit.nodes = {a, b, c, d};
+            mesh.apply_topology_edit(edit);
+            return edit;
+        }
+        return topology_edit<IDX>{};
+    }
+
+    /// @brief copy the node coordinates to the communicated (halo) elements
+    /// for node movement that every process applies to its halo nodes as well 
+    /// (i.e perturb_nodes on a mesh from distributed_uniform_mesh)
+    template<class T, class IDX, int ndim>
+    auto update_communicated_coords(AbstractMesh<T, IDX, ndim> &mesh) -> void {
+        for(auto& rank_elements : mesh.communicated_elements){
+            for(auto& comm_el : rank_elements){
+                for(std::size_t inode = 0; inode < comm_el.conn_el.size(); ++inode)
+                    { comm_el.coord_el[inode] = mesh.coord[comm_el.conn_el[inode]]; }
+            }
         }
     }
 
@@ -481,6 +490,42 @@ namespace iceicle {
             }
         }
         mesh.update_coord_els();
+        update_communicated_coords(mesh);
+    }
+
+    /**
+     * @brief perturb all the nodes with a function that is evaluated at batches of nodes
+     * (i.e compiled expressions or lua functions, so there is one call per batch instead of per node)
+     *
+     * @param mesh the mesh 
+     * @param batch_func the function to perturb the node coordinates f(npoint, x, xout)
+     *        x: [in] the current coordinates of npoint nodes [npoint x ndim]
+     *        xout: [out] the perturbed coordinates [npoint x ndim]
+     * @param batch_size the largest number of nodes in a batch
+     */
+    template<class T, class IDX, int ndim>
+    void perturb_nodes_batched(
+        AbstractMesh<T, IDX, ndim> &mesh,
+        std::invocable<std::size_t, const T*, T*> auto&& batch_func,
+        std::size_t batch_size = 65536
+    ) {
+        std::size_t nnode = mesh.n_nodes();
+        batch_size = std::max(std::min(batch_size, nnode), (std::size_t) 1);
+        std::vector<T> x(batch_size * ndim), xout(batch_size * ndim);
+        for(std::size_t start = 0; start < nnode; start += batch_size){
+            std::size_t npoint = std::min(batch_size, nnode - start);
+            for(std::size_t ipoint = 0; ipoint < npoint; ++ipoint){
+                for(int idim = 0; idim < ndim; ++idim)
+                    { x[ipoint * ndim + idim] = mesh.coord[start + ipoint][idim]; }
+            }
+            batch_func(npoint, x.data(), xout.data());
+            for(std::size_t ipoint = 0; ipoint < npoint; ++ipoint){
+                for(int idim = 0; idim < ndim; ++idim)
+                    { mesh.coord[start + ipoint][idim] = xout[ipoint * ndim + idim]; }
+            }
+        }
+        mesh.update_coord_els();
+        update_communicated_coords(mesh);
     }
 
 
@@ -502,6 +547,204 @@ namespace iceicle {
         return bbox;
     }
 
+    /// @brief rebuild the faces surrounding elements (facsuel) from the faces of the mesh
+    template<class T, class IDX, int ndim>
+    auto update_facsuel(AbstractMesh<T, IDX, ndim>& mesh) -> void {
+        std::vector<std::vector<IDX>> facsuel_ragged(mesh.nelem());
+        for(IDX iel = 0; iel < mesh.nelem(); ++iel){
+            facsuel_ragged[iel].resize(mesh.el_transformations[iel]->nfac);
+        }
+        for(IDX ifac = mesh.interiorFaceStart; ifac < mesh.interiorFaceEnd; ++ifac) {
+            facsuel_ragged[mesh.faces[ifac]->elemL][mesh.faces[ifac]->face_nr_l()] = ifac;
+            facsuel_ragged[mesh.faces[ifac]->elemR][mesh.faces[ifac]->face_nr_r()] = ifac;
+        }
+        for(IDX ifac = mesh.bdyFaceStart; ifac < mesh.bdyFaceEnd; ++ifac) {
+            const Face<T, IDX, ndim>& fac = *mesh.faces[ifac];
+            // interprocess faces only have one element on this process
+            if(fac.bctype == BOUNDARY_CONDITIONS::PARALLEL_COM && !decode_mpi_bcflag(fac.bcflag).second)
+                facsuel_ragged[fac.elemR][fac.face_nr_r()] = ifac;
+            else
+                facsuel_ragged[fac.elemL][fac.face_nr_l()] = ifac;
+        }
+        mesh.facsuel = util::crs<IDX, IDX>{facsuel_ragged};
+    }
+
+    /// @brief compute the key of a point along the morton (Z-order) space filling curve
+    /// @param x the point
+    /// @param bbox the bounding box that the point is normalized by
+    /// @return the bits of the quantized coordinates interleaved (x fastest)
+    template<class T, int ndim>
+    auto morton_key(const MATH::GEOMETRY::Point<T, ndim>& x, const BoundingBox<T, ndim>& bbox)
+    -> std::uint64_t {
+        // number of bits per coordinate that fit in the key
+        static constexpr int nbit = (ndim == 1) ? 32 : 63 / ndim;
+        static constexpr std::uint64_t max_quantized = (std::uint64_t{1} << nbit) - 1;
+
+        std::array<std::uint64_t, ndim> quantized;
+        for(int idim = 0; idim < ndim; ++idim){
+            T extent = bbox.xmax[idim] - bbox.xmin[idim];
+            T xi = (extent > 0) ? (x[idim] - bbox.xmin[idim]) / extent : 0;
+            xi = std::clamp(xi, (T) 0, (T) 1);
+            quantized[idim] = static_cast<std::uint64_t>(xi * max_quantized);
+        }
+
+        std::uint64_t key = 0;
+        for(int ibit = 0; ibit < nbit; ++ibit){
+            for(int idim = 0; idim < ndim; ++idim){
+                key |= ((quantized[idim] >> ibit) & std::uint64_t{1}) << (ibit * ndim + idim);
+            }
+        }
+        return key;
+    }
+
+    /**
+     * @brief renumber the elements and nodes of the mesh for memory locality
+     *
+     * Elements are sorted along the morton space filling curve of the element centroids
+     * so that elements that are close in memory are also close geometrically.
+     * Nodes are then numbered in the order they are first used by the reordered elements.
+     * The faces, element coordinates, elsup, and facsuel are renumbered to match.
+     *
+     * NOTE: communication lists refer to element indices on other processes,
+     * so this must be done on the serial mesh before partition_mesh
+     * (which keeps the relative ordering of the elements on each process)
+     *
+     * @param mesh the mesh to reorder
+     * @return the new index of each element (i.e new_el[old_index])
+     */
+    template<class T, class IDX, int ndim>
+    auto reorder_mesh(AbstractMesh<T, IDX, ndim>& mesh) -> std::vector<IDX> {
+        using Point = MATH::GEOMETRY::Point<T, ndim>;
+        IDX nelem = mesh.nelem();
+        IDX nnode = mesh.n_nodes();
+
+        for(const auto& fac : mesh.faces){
+            if(fac->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) {
+                util::AnomalyLog::log_anomaly(util::Anomaly{"Cannot reorder a partitioned mesh",
+                        util::general_anomaly_tag{}});
+                std::vector<IDX> new_el(nelem);
+                std::iota(new_el.begin(), new_el.end(), 0);
+                return new_el;
+            }
+        }
+
+        // === Element ordering ===
+        BoundingBox<T, ndim> bbox = compute_bounding_box(mesh);
+        std::vector<std::uint64_t> keys(nelem);
+        for(IDX iel = 0; iel < nelem; ++iel){
+            Point centroid{};
+            for(int idim = 0; idim < ndim; ++idim) centroid[idim] = 0;
+            for(IDX inode : mesh.conn_el.rowspan(iel)){
+                for(int idim = 0; idim < ndim; ++idim)
+                    centroid[idim] += mesh.coord[inode][idim];
+            }
+            for(int idim = 0; idim < ndim; ++idim)
+                centroid[idim] /= mesh.conn_el.rowsize(iel);
+            keys[iel] = morton_key(centroid, bbox);
+        }
+
+        // old element index for each new element index
+        std::vector<IDX> el_order(nelem);
+        std::iota(el_order.begin(), el_order.end(), 0);
+        std::ranges::stable_sort(el_order, [&keys](IDX iel, IDX jel){ return keys[iel] < keys[jel]; });
+        std::vector<IDX> new_el(nelem);
+        for(IDX inew = 0; inew < nelem; ++inew)
+            { new_el[el_order[inew]] = inew; }
+
+        // === Node ordering ===
+        std::vector<IDX> new_node(nnode, -1);
+        IDX next_node = 0;
+        for(IDX iel : el_order){
+            for(IDX inode : mesh.conn_el.rowspan(iel)){
+                if(new_node[inode] == -1) new_node[inode] = next_node++;
+            }
+        }
+        // nodes that are not part of any element go at the end
+        for(IDX inode = 0; inode < nnode; ++inode){
+            if(new_node[inode] == -1) new_node[inode] = next_node++;
+        }
+
+        // === Permute the mesh data ===
+        NodeArray<T, ndim> coord(nnode);
+        for(IDX inode = 0; inode < nnode; ++inode)
+            { coord[new_node[inode]] = mesh.coord[inode]; }
+
+        std::vector<std::vector<IDX>> ragged_conn_el(nelem);
+        std::vector<ElementTransformation<T, IDX, ndim>*> el_transformations(nelem);
+        for(IDX inew = 0; inew < nelem; ++inew){
+            IDX iold = el_order[inew];
+            for(IDX inode : mesh.conn_el.rowspan(iold))
+                { ragged_conn_el[inew].push_back(new_node[inode]); }
+            el_transformations[inew] = mesh.el_transformations[iold];
+        }
+
+        mesh.coord = std::move(coord);
+        mesh.conn_el = util::crs<IDX, IDX>{ragged_conn_el};
+        mesh.el_transformations = std::move(el_transformations);
+        mesh.coord_els = util::crs<Point, IDX>{std::span{mesh.conn_el.cols(), mesh.conn_el.cols() + mesh.conn_el.nrow() + 1}};
+        mesh.update_coord_els();
+        mesh.elsup = to_elsup(mesh.conn_el, mesh.n_nodes());
+
+        // === Renumber the faces ===
+        for(auto& facptr : mesh.faces){
+            const Face<T, IDX, ndim>& fac = *facptr;
+            bool is_interior = fac.bctype == BOUNDARY_CONDITIONS::INTERIOR;
+            IDX elemL = new_el[fac.elemL];
+            IDX elemR = (is_interior || fac.elemR == fac.elemL) ? new_el[fac.elemR] : fac.elemR;
+            DOMAIN_TYPE domain_l = mesh.el_transformations[elemL]->domain_type;
+            DOMAIN_TYPE domain_r = (is_interior) ? mesh.el_transformations[elemR]->domain_type : domain_l;
+
+            std::vector<IDX> face_nodes;
+            for(IDX inode : fac.nodes_span())
+                { face_nodes.push_back(new_node[inode]); }
+
+            auto face_opt = make_face<T, IDX, ndim>(fac.domain_type(), domain_l, domain_r,
+                    fac.geometry_order(), elemL, elemR, face_nodes, fac.face_nr_l(), fac.face_nr_r(),
+                    fac.orientation_r(), fac.bctype, fac.bcflag);
+            if(face_opt){
+                facptr = std::move(face_opt.value());
+            } else {
+                util::AnomalyLog::log_anomaly(util::Anomaly{"Cannot renumber face", util::general_anomaly_tag{}});
+            }
+        }
+
+        update_facsuel(mesh);
+        mesh.update_face_table();
+        return new_el;
+    }
+
+    /**
+     * @brief reorder the faces so that consecutive faces touch nearby elements
+     *
+     * Interior faces are sorted by (min(elemL, elemR), max(elemL, elemR))
+     * and boundary faces by elemL, so a traversal of the faces streams through the elements
+     * in order (best after reorder_mesh) and contiguous chunks of faces touch few elements.
+     * The interior and boundary face ranges are kept.
+     *
+     * @param mesh the mesh to reorder the faces of
+     */
+    template<class T, class IDX, int ndim>
+    auto reorder_faces(AbstractMesh<T, IDX, ndim>& mesh) -> void {
+        using face_ptr = std::unique_ptr<Face<T, IDX, ndim>>;
+        auto interior_key = [](const face_ptr& fac){
+            return std::pair{std::min(fac->elemL, fac->elemR), std::max(fac->elemL, fac->elemR)};
+        };
+        // the periodic faces are tracked through the sort by address
+        std::vector<const Face<T, IDX, ndim>*> periodic_faceptrs{};
+        for(IDX ifac : mesh.periodic_faces) periodic_faceptrs.push_back(mesh.faces[ifac].get());
+        std::ranges::sort(periodic_faceptrs);
+        std::stable_sort(mesh.faces.begin() + mesh.interiorFaceStart, mesh.faces.begin() + mesh.interiorFaceEnd,
+            [&interior_key](const face_ptr& a, const face_ptr& b){ return interior_key(a) < interior_key(b); });
+        mesh.periodic_faces.clear();
+        for(IDX ifac = mesh.interiorFaceStart; ifac < mesh.interiorFaceEnd; ++ifac)
+            if(std::ranges::binary_search(periodic_faceptrs, mesh.faces[ifac].get())) mesh.periodic_faces.push_back(ifac);
+        std::stable_sort(mesh.faces.begin() + mesh.bdyFaceStart, mesh.faces.begin() + mesh.bdyFaceEnd,
+            [](const face_ptr& a, const face_ptr& b){ return a->elemL < b->elemL; });
+
+        update_facsuel(mesh);
+        mesh.update_face_table();
+    }
+
     namespace PERTURBATION_FUNCTIONS {
 
         /// @brief randomly perturb the nodes 
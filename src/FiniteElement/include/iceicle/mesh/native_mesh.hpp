@@ -0,0 +1,359 @@
+/**
+ * @brief native binary format for partitioned meshes
+ *
+ * Each process writes its own partition of the mesh to <basename>_<rank>.icemesh
+ * with everything needed to reconstruct the AbstractMesh without
+ * finding interior faces or partitioning again.
+ * Restarts must use the same number of processes the mesh was written with.
+ *
+ * All sections are written in the native byte order of the machine:
+ *  - header: magic, version, sizeof(T), sizeof(IDX), ndim, nrank, rank
+ *  - nodes: nnode, coordinates [nnode x ndim]
+ *  - elements: conn_el in crs form, domain type and geometry order of each element
+ *  - faces: the face ranges, the face table arrays, and the domain types and geometry order of each face
+ *  - communication: for each rank the send list, recieve list and communicated elements
+ *  - global indices: the index of each node and element in the mesh that was partitioned (as int64)
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/crs.hpp"
+#include "iceicle/fe_definitions.hpp"
+#include "iceicle/geometry/face.hpp"
+#include "iceicle/geometry/face_table.hpp"
+#include "iceicle/geometry/face_utils.hpp"
+#include "iceicle/geometry/transformations_table.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/mesh/mesh.hpp"
+#include "iceicle/mesh/mesh_utils.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace iceicle {
+
+    namespace impl::native_mesh {
+
+        /// @brief the identifier at the start of every native mesh file
+        inline constexpr std::array<char, 8> magic{'I', 'C', 'E', 'M', 'E', 'S', 'H', '\0'};
+
+        /// @brief the version of the file format
+        inline constexpr std::uint32_t version = 2;
+
+        /// @brief the header of a native mesh file
+        struct header {
+            std::array<char, 8> magic;
+            std::uint32_t version;
+            std::uint32_t sizeof_T;
+            std::uint32_t sizeof_IDX;
+            std::uint32_t ndim;
+            std::uint32_t nrank;
+            std::uint32_t rank;
+        };
+
+        template<class V>
+        auto write_value(std::ofstream& out, const V& value) -> void
+        { out.write(reinterpret_cast<const char*>(&value), sizeof(V)); }
+
+        template<class V>
+        auto write_array(std::ofstream& out, std::span<const V> values) -> void {
+            write_value(out, (std::uint64_t) values.size());
+            out.write(reinterpret_cast<const char*>(values.data()), values.size_bytes());
+        }
+
+        template<class V>
+        auto read_value(std::ifstream& in) -> V {
+            V value{};
+            in.read(reinterpret_cast<char*>(&value), sizeof(V));
+            return value;
+        }
+
+        template<class V>
+        auto read_array(std::ifstream& in) -> std::vector<V> {
+            std::uint64_t n = read_value<std::uint64_t>(in);
+            if(!in) return std::vector<V>{};
+            std::vector<V> values(n);
+            in.read(reinterpret_cast<char*>(values.data()), n * sizeof(V));
+            return values;
+        }
+
+        /// @brief write a crs array as its row offsets followed by its data
+        template<class V, class IDX>
+        auto write_crs(std::ofstream& out, const util::crs<V, IDX>& arr) -> void {
+            write_array(out, std::span<const IDX>{arr.cols(), arr.cols() + arr.nrow() + 1});
+            write_array(out, std::span<const V>{arr.data(), arr.data() + arr.nnz()});
+        }
+
+        template<class V, class IDX>
+        auto read_crs(std::ifstream& in) -> util::crs<V, IDX> {
+            std::vector<IDX> cols = read_array<IDX>(in);
+            std::vector<V> data = read_array<V>(in);
+            if(!in || cols.empty() || (std::size_t) cols.back() != data.size())
+                return util::crs<V, IDX>{};
+            util::crs<V, IDX> arr{std::span<const IDX>{cols}};
+            std::ranges::copy(data, arr.data());
+            return arr;
+        }
+
+        /// @brief the file for the given process
+        inline auto rank_filename(const std::string& basename, int rank) -> std::filesystem::path
+        { return std::filesystem::path{basename + "_" + std::to_string(rank) + ".icemesh"}; }
+    }
+
+    /**
+     * @brief write the partition of the mesh on this process to <basename>_<rank>.icemesh
+     * (see native_mesh.hpp for the format)
+     *
+     * @param mesh the partitioned mesh (i.e the result of partition_mesh)
+     * @param basename the name of the files without the rank and extension
+     */
+    template<class T, class IDX, int ndim>
+    auto write_native_mesh(const AbstractMesh<T, IDX, ndim>& mesh, const std::string& basename) -> void {
+        using namespace impl::native_mesh;
+        int myrank = mpi::mpi_world_rank();
+        std::uint32_t nrank = mesh.el_send_list.size();
+
+        std::filesystem::path filename = rank_filename(basename, myrank);
+        if(filename.has_parent_path())
+            std::filesystem::create_directories(filename.parent_path());
+        std::ofstream out{filename, std::ios::binary};
+        if(!out) {
+            util::AnomalyLog::log_anomaly(util::Anomaly{
+                "Cannot open native mesh file for writing: " + filename.string(), util::general_anomaly_tag{}});
+            return;
+        }
+
+        write_value(out, header{magic, version, sizeof(T), sizeof(IDX), ndim, nrank, (std::uint32_t) myrank});
+
+        // nodes
+        std::vector<T> coord_flat(mesh.coord.size() * ndim);
+        for(std::size_t inode = 0; inode < mesh.coord.size(); ++inode){
+            for(int idim = 0; idim < ndim; ++idim)
+                coord_flat[inode * ndim + idim] = mesh.coord[inode][idim];
+        }
+        write_array(out, std::span<const T>{coord_flat});
+
+        // elements
+        write_crs(out, mesh.conn_el);
+        std::vector<int> el_domains(mesh.el_transformations.size()), el_orders(mesh.el_transformations.size());
+        for(std::size_t iel = 0; iel < mesh.el_transformations.size(); ++iel){
+            el_domains[iel] = (int) mesh.el_transformations[iel]->domain_type;
+            el_orders[iel] = mesh.el_transformations[iel]->order;
+        }
+        write_array(out, std::span<const int>{el_domains});
+        write_array(out, std::span<const int>{el_orders});
+
+        // faces
+        // the face table is built from the faces so it is current regardless of update_face_table() calls
+        FaceTable<T, IDX, ndim> table{mesh.faces};
+        std::size_t nfac = table.nfac();
+        std::vector<int> fac_domains(nfac), fac_domains_l(nfac), fac_domains_r(nfac), fac_orders(nfac), bctypes(nfac);
+        for(std::size_t ifac = 0; ifac < nfac; ++ifac){
+            const Face<T, IDX, ndim>& fac = *mesh.faces[ifac];
+            fac_domains[ifac] = (int) fac.domain_type();
+            fac_orders[ifac] = fac.geometry_order();
+            bctypes[ifac] = (int) fac.bctype;
+
+            // the element domains, elements on other processes are found in the communicated elements
+            auto remote_domain = [&](IDX iel) -> int {
+                int jrank = decode_mpi_bcflag(fac.bcflag).first;
+                const std::vector<IDX>& recv_list = mesh.el_recv_list[jrank];
+                std::size_t index = std::distance(recv_list.begin(),
+                        std::lower_bound(recv_list.begin(), recv_list.end(), iel));
+                return (int) mesh.communicated_elements[jrank][index].trans->domain_type;
+            };
+            switch(fac.bctype){
+                case BOUNDARY_CONDITIONS::INTERIOR:
+                    fac_domains_l[ifac] = (int) mesh.el_transformations[fac.elemL]->domain_type;
+                    fac_domains_r[ifac] = (int) mesh.el_transformations[fac.elemR]->domain_type;
+                    break;
+                case BOUNDARY_CONDITIONS::PARALLEL_COM:
+                    if(decode_mpi_bcflag(fac.bcflag).second){
+                        fac_domains_l[ifac] = (int) mesh.el_transformations[fac.elemL]->domain_type;
+                        fac_domains_r[ifac] = remote_domain(fac.elemR);
+                    } else {
+                        fac_domains_l[ifac] = remote_domain(fac.elemL);
+                        fac_domains_r[ifac] = (int) mesh.el_transformations[fac.elemR]->domain_type;
+                    }
+                    break;
+                default:
+                    fac_domains_l[ifac] = (int) mesh.el_transformations[fac.elemL]->domain_type;
+                    fac_domains_r[ifac] = fac_domains_l[ifac];
+            }
+        }
+        write_value(out, std::array<IDX, 4>{mesh.interiorFaceStart, mesh.interiorFaceEnd,
+                mesh.bdyFaceStart, mesh.bdyFaceEnd});
+        write_array(out, std::span<const IDX>{table.elemL});
+        write_array(out, std::span<const IDX>{table.elemR});
+        write_array(out, std::span<const int>{table.face_nr_l});
+        write_array(out, std::span<const int>{table.face_nr_r});
+        write_array(out, std::span<const int>{table.orientation_r});
+        write_array(out, std::span<const int>{bctypes});
+        write_array(out, std::span<const IDX>{table.bcflag});
+        write_crs(out, table.face_nodes);
+        write_array(out, std::span<const int>{fac_domains});
+        write_array(out, std::span<const int>{fac_domains_l});
+        write_array(out, std::span<const int>{fac_domains_r});
+        write_array(out, std::span<const int>{fac_orders});
+
+        // communication
+        for(std::uint32_t irank = 0; irank < nrank; ++irank){
+            write_array(out, std::span<const IDX>{mesh.el_send_list[irank]});
+            write_array(out, std::span<const IDX>{mesh.el_recv_list[irank]});
+            write_value(out, (std::uint64_t) mesh.communicated_elements[irank].size());
+            for(const CommElementInfo<T, IDX, ndim>& comm_el : mesh.communicated_elements[irank]){
+                write_value(out, (int) comm_el.trans->domain_type);
+                write_value(out, comm_el.trans->order);
+                write_array(out, std::span<const IDX>{comm_el.conn_el});
+                for(const MATH::GEOMETRY::Point<T, ndim>& pt : comm_el.coord_el)
+                    for(int idim = 0; idim < ndim; ++idim) write_value(out, pt[idim]);
+            }
+        }
+
+        // global indices
+        // (fixed width so the files do not depend on the global index type of the build)
+        write_array(out, std::span<const std::int64_t>{std::vector<std::int64_t>(mesh.gnode_idxs.begin(), mesh.gnode_idxs.end())});
+        write_array(out, std::span<const std::int64_t>{std::vector<std::int64_t>(mesh.gel_idxs.begin(), mesh.gel_idxs.end())});
+
+        if(!out) {
+            util::AnomalyLog::log_anomaly(util::Anomaly{
+                "Failed writing native mesh file: " + filename.string(), util::general_anomaly_tag{}});
+        }
+    }
+
+    /**
+     * @brief read the partition of the mesh for this process from <basename>_<rank>.icemesh
+     * (see native_mesh.hpp for the format)
+     *
+     * The element coordinates, elsup, facsuel and face table are rebuilt from the stored data
+     *
+     * @param basename the name of the files without the rank and extension
+     * @return the partitioned mesh or std::nullopt if the file does not exist or does not match
+     * this build (scalar and index sizes, dimensionality) or the number of processes
+     */
+    template<class T, class IDX, int ndim>
+    auto read_native_mesh(const std::string& basename) -> std::optional<AbstractMesh<T, IDX, ndim>> {
+        using namespace impl::native_mesh;
+        using Point = MATH::GEOMETRY::Point<T, ndim>;
+        int myrank = mpi::mpi_world_rank();
+
+        std::filesystem::path filename = rank_filename(basename, myrank);
+        std::ifstream in{filename, std::ios::binary};
+        if(!in) return std::nullopt;
+
+        auto fail = [&filename](const std::string& msg) -> std::optional<AbstractMesh<T, IDX, ndim>> {
+            util::AnomalyLog::log_anomaly(util::Anomaly{
+                "Native mesh file " + filename.string() + ": " + msg, util::general_anomaly_tag{}});
+            return std::nullopt;
+        };
+
+        header head = read_value<header>(in);
+        if(!in || head.magic != magic) return fail("not a native mesh file");
+        if(head.version != version) return fail("unsupported version");
+        if(head.sizeof_T != sizeof(T) || head.sizeof_IDX != sizeof(IDX) || head.ndim != ndim)
+            return fail("written with a different scalar type, index type, or dimensionality");
+        if(head.rank != (std::uint32_t) myrank
+                || (mpi::mpi_initialized() && head.nrank != (std::uint32_t) mpi::mpi_world_size()))
+            return fail("written with a different number of processes");
+
+        AbstractMesh<T, IDX, ndim> mesh{};
+
+        // nodes
+        std::vector<T> coord_flat = read_array<T>(in);
+        mesh.coord.resize(coord_flat.size() / ndim);
+        for(std::size_t inode = 0; inode < mesh.coord.size(); ++inode){
+            for(int idim = 0; idim < ndim; ++idim)
+                mesh.coord[inode][idim] = coord_flat[inode * ndim + idim];
+        }
+
+        // elements
+        mesh.conn_el = read_crs<IDX, IDX>(in);
+        std::vector<int> el_domains = read_array<int>(in);
+        std::vector<int> el_orders = read_array<int>(in);
+        if(!in || el_domains.size() != mesh.conn_el.nrow() || el_orders.size() != mesh.conn_el.nrow())
+            return fail("corrupt element section");
+        mesh.el_transformations.resize(mesh.conn_el.nrow());
+        for(IDX iel = 0; iel < mesh.nelem(); ++iel){
+            mesh.el_transformations[iel] = transformation_table<T, IDX, ndim>
+                .get_transform((DOMAIN_TYPE) el_domains[iel], el_orders[iel]);
+            if(mesh.el_transformations[iel] == nullptr) return fail("unsupported element type");
+        }
+        mesh.coord_els = util::crs<Point, IDX>{std::span{mesh.conn_el.cols(), mesh.conn_el.cols() + mesh.conn_el.nrow() + 1}};
+        mesh.update_coord_els();
+        mesh.elsup = to_elsup(mesh.conn_el, mesh.n_nodes());
+
+        // faces
+        std::array<IDX, 4> face_ranges = read_value<std::array<IDX, 4>>(in);
+        mesh.interiorFaceStart = face_ranges[0];
+        mesh.interiorFaceEnd = face_ranges[1];
+        mesh.bdyFaceStart = face_ranges[2];
+        mesh.bdyFaceEnd = face_ranges[3];
+        std::vector<IDX> elemL = read_array<IDX>(in);
+        std::vector<IDX> elemR = read_array<IDX>(in);
+        std::vector<int> face_nr_l = read_array<int>(in);
+        std::vector<int> face_nr_r = read_array<int>(in);
+        std::vector<int> orientation_r = read_array<int>(in);
+        std::vector<int> bctypes = read_array<int>(in);
+        std::vector<IDX> bcflags = read_array<IDX>(in);
+        util::crs<IDX, IDX> face_nodes = read_crs<IDX, IDX>(in);
+        std::vector<int> fac_domains = read_array<int>(in);
+        std::vector<int> fac_domains_l = read_array<int>(in);
+        std::vector<int> fac_domains_r = read_array<int>(in);
+        std::vector<int> fac_orders = read_array<int>(in);
+        std::size_t nfac = elemL.size();
+        if(!in || face_nodes.nrow() != nfac || fac_orders.size() != nfac)
+            return fail("corrupt face section");
+        mesh.faces.reserve(nfac);
+        for(std::size_t ifac = 0; ifac < nfac; ++ifac){
+            std::span<const IDX> nodes = face_nodes.rowspan(ifac);
+            auto face_opt = make_face<T, IDX, ndim>(
+                (DOMAIN_TYPE) fac_domains[ifac], (DOMAIN_TYPE) fac_domains_l[ifac], (DOMAIN_TYPE) fac_domains_r[ifac],
+                fac_orders[ifac], elemL[ifac], elemR[ifac], nodes, face_nr_l[ifac], face_nr_r[ifac],
+                orientation_r[ifac], (BOUNDARY_CONDITIONS) bctypes[ifac], bcflags[ifac]);
+            if(!face_opt) return fail("could not make face " + std::to_string(ifac));
+            mesh.faces.push_back(std::move(face_opt.value()));
+        }
+        update_facsuel(mesh);
+        mesh.update_face_table();
+
+        // communication
+        mesh.el_send_list.assign(head.nrank, std::vector<IDX>{});
+        mesh.el_recv_list.assign(head.nrank, std::vector<IDX>{});
+        mesh.communicated_elements.assign(head.nrank, std::vector<CommElementInfo<T, IDX, ndim>>{});
+        for(std::uint32_t irank = 0; irank < head.nrank; ++irank){
+            mesh.el_send_list[irank] = read_array<IDX>(in);
+            mesh.el_recv_list[irank] = read_array<IDX>(in);
+            std::uint64_t ncomm = read_value<std::uint64_t>(in);
+            if(!in) return fail("corrupt communication section");
+            for(std::uint64_t icomm = 0; icomm < ncomm; ++icomm){
+                int domain_type = read_value<int>(in);
+                int order = read_value<int>(in);
+                CommElementInfo<T, IDX, ndim> comm_el{
+                    transformation_table<T, IDX, ndim>.get_transform((DOMAIN_TYPE) domain_type, order),
+                    read_array<IDX>(in),
+                    std::vector<Point>{}
+                };
+                if(!in || comm_el.trans == nullptr) return fail("corrupt communicated element");
+                comm_el.coord_el.resize(comm_el.conn_el.size());
+                for(Point& pt : comm_el.coord_el)
+                    for(int idim = 0; idim < ndim; ++idim) pt[idim] = read_value<T>(in);
+                mesh.communicated_elements[irank].push_back(std::move(comm_el));
+            }
+        }
+
+        // global indices
+        std::vector<std::int64_t> gnode_idxs = read_array<std::int64_t>(in);
+        std::vector<std::int64_t> gel_idxs = read_array<std::int64_t>(in);
+        mesh.gnode_idxs.assign(gnode_idxs.begin(), gnode_idxs.end());
+        mesh.gel_idxs.assign(gel_idxs.begin(), gel_idxs.end());
+        if(!in) return fail("unexpected end of file");
+        return mesh;
+    }
+}
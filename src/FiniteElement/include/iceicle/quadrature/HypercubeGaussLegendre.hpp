@@ -14,21 +14,15 @@
 #include <Numtool/integer_utils.hpp>
 namespace iceicle {
 
-    template<typename T, typename IDX, int ndim, int npoin1d>
-    class HypercubeGaussLegendre final : public QuadratureRule<T, IDX, ndim> {
-
-        // the total number of quadrature points
-        static constexpr int num_poin = MATH::power_T<npoin1d, ndim>::value;
-
-        // ==================
-        // = Working Arrays =
-        // ==================
-        QuadraturePoint<T, ndim> qpoints[num_poin];
-
-        public:
-        HypercubeGaussLegendre(){
-            GaussLegendreQuadrature<T, IDX, npoin1d> quadrule_1d{};
-
+    namespace impl {
+        /**
+         * @brief fill the tensor product of a 1D quadrature rule
+         * the first dimension is the slowest index
+         * @param quadrule_1d the 1D quadrature rule
+         * @param [out] qpoints the npoin1d^ndim tensor product points
+         */
+        template<typename T, int ndim, int npoin1d, class Quadrature1D>
+        void fill_tensor_quadrature(const Quadrature1D& quadrule_1d, QuadraturePoint<T, ndim>* qpoints){
             for(int idim = 0; idim < ndim; ++idim){
                 // number of times to repeat the loop over 1d point set
                 const int nrepeat = std::pow(npoin1d, idim);
@@ -60,10 +54,55 @@ namespace iceicle {
                 qpoints[0].weight = 1.0;
             }
         }
+    }
+
+    template<typename T, typename IDX, int ndim, int npoin1d>
+    class HypercubeGaussLegendre final : public QuadratureRule<T, IDX, ndim> {
+
+        // the total number of quadrature points
+        static constexpr int num_poin = MATH::power_T<npoin1d, ndim>::value;
+
+        // ==================
+        // = Working Arrays =
+        // ==================
+        QuadraturePoint<T, ndim> qpoints[num_poin];
+
+        public:
+        HypercubeGaussLegendre(){
+            GaussLegendreQuadrature<T, IDX, npoin1d> quadrule_1d{};
+            impl::fill_tensor_quadrature<T, ndim, npoin1d>(quadrule_1d, qpoints);
+        }
+
+        int npoints() const override { return num_poin; }
+
+        const QuadraturePoint<T, ndim> &getPoint(int ipoint) const override { return qpoints[ipoint]; }
+    };
+
+    /**
+     * @brief tensor product Gauss-Lobatto-Legendre quadrature on the reference hypercube
+     * the points include the element boundary so with npoin1d = Pn + 1 
+     * they are the collocation nodes of GaussLobattoLagrangeInterpolation
+     */
+    template<typename T, typename IDX, int ndim, int npoin1d>
+    class HypercubeGaussLobatto final : public QuadratureRule<T, IDX, ndim> {
+
+        // the total number of quadrature points
+        static constexpr int num_poin = MATH::power_T<npoin1d, ndim>::value;
+
+        // ==================
+        // = Working Arrays =
+        // ==================
+        QuadraturePoint<T, ndim> qpoints[num_poin];
+
+        public:
+        HypercubeGaussLobatto(){
+            GaussLobattoQuadrature<T, IDX, npoin1d> quadrule_1d{};
+            impl::fill_tensor_quadrature<T, ndim, npoin1d>(quadrule_1d, qpoints);
+        }
 
         int npoints() const override { return num_poin; }
 
         const QuadraturePoint<T, ndim> &getPoint(int ipoint) const override { return qpoints[ipoint]; }
     };
  
-}
+}
\ No newline at end of file
@@ -2,9 +2,11 @@
  * @file SimplexQuadrature.hpp
  * @brief Quadrature on simplical elements
  * Using Grundmann Moller formuila
+ * or tabulated fully symmetric rules
  */
 #pragma once
 #include <iceicle/quadrature/QuadratureRule.hpp>
+#include <iceicle/quadrature/symmetric_simplex_tables.hpp>
 #include <Numtool/integer_utils.hpp>
 #include <array>
 #include <algorithm>
@@ -101,4 +103,101 @@ namespace iceicle {
             const QuadraturePoint<T, ndim> &getPoint(int ipoint) const override { return qpoints[ipoint]; }
         };
 
+
+    namespace impl {
+        /// @brief the total number of points of the orbits of a symmetric rule
+        template<std::size_t norbit>
+        constexpr auto orbit_npoin(const std::array<simplex_orbit, norbit>& orbits) -> int {
+            int npoin = 0;
+            for(const simplex_orbit& orbit : orbits) npoin += orbit_size(orbit.type);
+            return npoin;
+        }
+    }
+
+    /**
+     * @brief Fully symmetric simplex quadrature rules 
+     * with positive weights and all the points in the interior
+     * (the form of the rules of Witherden and Vincent 2015)
+     *
+     * Each point set is an orbit under the symmetry group of the simplex 
+     * of a generator in barycentric coordinates, so far fewer points are needed than 
+     * Grundmann Moller for the same degree (i.e 60 instead of 165 points for degree 17 on triangles)
+     * and the weights are positive
+     *
+     * The rules are tabulated in symmetric_simplex_tables.hpp,
+     * use symmetric_simplex_rule_exists to check if a rule is available
+     *
+     * @tparam T The floating point type
+     * @tparam IDX The Index Type
+     * @tparam ndim the number of spatial dimensions
+     * @tparam degree the polynomial degree that is integrated exactly
+     */
+    template<typename T, typename IDX, int ndim, int degree>
+    class SymmetricSimplexQuadrature final: public QuadratureRule<T, IDX, ndim> {
+
+        using Table = impl::symmetric_simplex_table<ndim, degree>;
+        static_assert(Table::exists, "There is no symmetric rule tabulated for this dimension and degree");
+
+        /// The number of integration points
+        static constexpr int num_poin = impl::orbit_npoin(Table::orbits);
+
+        // ==================
+        // = Working Arrays =
+        // ==================
+        QuadraturePoint<T, ndim> qpoints[num_poin];
+
+        public:
+        SymmetricSimplexQuadrature(){
+            int iarr = 0;
+            for(const impl::simplex_orbit& orbit : Table::orbits){
+                // the barycentric generator 
+                // and the class of each coordinate (coordinates in the same class are equal)
+                std::array<T, ndim + 1> bary;
+                std::array<int, ndim + 1> classes;
+                impl::orbit_generator(orbit, bary.data(), classes.data());
+
+                // every distinct permutation of the classes is a point of the orbit
+                std::array<int, ndim + 1> perm = classes;
+                std::ranges::sort(perm);
+                do {
+                    QuadraturePoint<T, ndim> &qpoint = qpoints[iarr++];
+                    qpoint.weight = orbit.weight;
+                    for(int idim = 0; idim < ndim; ++idim){
+                        int icoord = std::distance(classes.begin(), std::ranges::find(classes, perm[idim]));
+                        qpoint.abscisse[idim] = bary[icoord];
+                    }
+                } while(std::ranges::next_permutation(perm).found);
+            }
+        }
+
+        int npoints() const override { return num_poin; }
+
+        const QuadraturePoint<T, ndim> &getPoint(int ipoint) const override { return qpoints[ipoint]; }
+    };
+
+    /// @brief if a fully symmetric rule is tabulated for the given dimension and degree
+    template<int ndim, int degree>
+    inline constexpr bool symmetric_simplex_rule_exists = impl::symmetric_simplex_table<ndim, degree>::exists;
+
+    namespace impl {
+        /// @brief the smallest tabulated degree in [degree, max_degree] or -1 if there is none
+        template<int ndim, int degree, int max_degree>
+        constexpr auto smallest_symmetric_degree() -> int {
+            if constexpr (degree > max_degree) return -1;
+            else if constexpr (symmetric_simplex_table<ndim, degree>::exists) return degree;
+            else return smallest_symmetric_degree<ndim, degree + 1, max_degree>();
+        }
+    }
+
+    /**
+     * @brief the degree of the smallest tabulated symmetric rule that integrates the given degree exactly
+     * or -1 if no tabulated rule is exact for that degree
+     *
+     * A rule of higher degree than asked for is used when the degree itself is not tabulated 
+     * so the symmetric rules are used wherever a sufficient rule exists
+     */
+    template<int ndim, int degree>
+    inline constexpr int symmetric_simplex_degree 
+        = impl::smallest_symmetric_degree<ndim, degree, impl::symmetric_simplex_max_degree<ndim>>();
+
 }
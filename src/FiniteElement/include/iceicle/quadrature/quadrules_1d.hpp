@@ -11,8 +11,126 @@
 #include <Numtool/constexpr_math.hpp>
 
 #include <iceicle/quadrature/QuadratureRule.hpp>
+#include <array>
+#include <numbers>
+#include <utility>
 namespace iceicle {
 
+    namespace impl {
+
+        /// @brief cosine that can be evaluated at compile time (Taylor series on [-pi, pi])
+        constexpr auto constexpr_cos(double x) -> double {
+            constexpr double pi = std::numbers::pi;
+            while(x > pi) x -= 2 * pi;
+            while(x < -pi) x += 2 * pi;
+            double term = 1.0, sum = 1.0;
+            for(int k = 1; k < 40; ++k){
+                term *= -x * x / ((2 * k - 1) * (2 * k));
+                sum += term;
+            }
+            return sum;
+        }
+
+        /// @brief the Legendre polynomial P_n and its derivative at x by the three term recurrence
+        template<class T>
+        constexpr auto legendre_and_derivative(int n, T x) -> std::pair<T, T> {
+            if(n == 0) return {1.0, 0.0};
+            T p0 = 1.0, p1 = x;
+            for(int k = 2; k <= n; ++k){
+                T p2 = ((2 * k - 1) * x * p1 - (k - 1) * p0) / k;
+                p0 = p1;
+                p1 = p2;
+            }
+            // P'_n = n (x P_n - P_{n-1}) / (x^2 - 1)
+            return {p1, n * (x * p1 - p0) / (x * x - 1)};
+        }
+
+        /// @brief 1D quadrature points and weights computed at compile time
+        template<class T, int npoin>
+        struct quadrule_1d_table {
+            std::array<T, npoin> points{};
+            std::array<T, npoin> weights{};
+        };
+
+        /// @brief the Gauss Legendre points and weights (in the order of GaussLegendreQuadrature)
+        /// +-x pairs from the largest x and the center point last for odd npoin
+        template<class T, int npoin>
+        constexpr auto compute_gauss_legendre() -> quadrule_1d_table<T, npoin> {
+            quadrule_1d_table<T, npoin> table{};
+            T weightcenter = 2.0;
+            for(int i = 1; i <= npoin / 2; ++i){
+                T xi = constexpr_cos(std::numbers::pi * (i - 0.25) / (npoin + 0.5));
+                T dlegendre = 0.0;
+                for(int inewton = 0; inewton < 100; ++inewton){
+                    auto [legendre_eval, dleg] = legendre_and_derivative<T>(npoin, xi);
+                    dlegendre = dleg;
+                    T dxi = legendre_eval / dlegendre;
+                    xi -= dxi;
+                    if(dxi < 1e-16 && dxi > -1e-16) break;
+                }
+                dlegendre = legendre_and_derivative<T>(npoin, xi).second;
+                T weight = 2.0 / ((1 - xi * xi) * dlegendre * dlegendre);
+                weightcenter -= 2 * weight;
+                table.points[2 * i - 2] = xi;
+                table.weights[2 * i - 2] = weight;
+                table.points[2 * i - 1] = -xi;
+                table.weights[2 * i - 1] = weight;
+            }
+            if(npoin % 2 != 0){
+                table.points[npoin - 1] = 0.0;
+                table.weights[npoin - 1] = weightcenter;
+            }
+            return table;
+        }
+
+        /// @brief the Gauss Lobatto Legendre points and weights ordered from -1 to 1
+        template<class T, int npoin>
+        constexpr auto compute_gauss_lobatto() -> quadrule_1d_table<T, npoin> {
+            static_assert(npoin >= 2, "Gauss-Lobatto quadrature includes both endpoints");
+            constexpr int N = npoin - 1;
+            constexpr T wcoeff = 2.0 / (N * (N + 1));
+            quadrule_1d_table<T, npoin> table{};
+            table.points[0] = -1.0;
+            table.weights[0] = wcoeff;
+            table.points[N] = 1.0;
+            table.weights[N] = wcoeff;
+            for(int i = 1; 2 * i < N; ++i){
+                // Chebyshev-Gauss-Lobatto initial guess, Newton on P'_N
+                // (1 - x^2) P''_N = 2 x P'_N - N (N + 1) P_N
+                T xi = -constexpr_cos(std::numbers::pi * i / N);
+                for(int inewton = 0; inewton < 100; ++inewton){
+                    auto [legendre_eval, dlegendre] = legendre_and_derivative<T>(N, xi);
+                    T d2legendre = (2 * xi * dlegendre - N * (N + 1) * legendre_eval) / (1 - xi * xi);
+                    T dxi = dlegendre / d2legendre;
+                    xi -= dxi;
+                    if(dxi < 1e-16 && dxi > -1e-16) break;
+                }
+                T legendre_eval = legendre_and_derivative<T>(N, xi).first;
+                T weight = wcoeff / (legendre_eval * legendre_eval);
+                table.points[i] = xi;
+                table.weights[i] = weight;
+                table.points[N - i] = -xi;
+                table.weights[N - i] = weight;
+            }
+            if(N % 2 == 0){
+                T legendre_eval = legendre_and_derivative<T>(N, 0.0).first;
+                table.points[N / 2] = 0.0;
+                table.weights[N / 2] = wcoeff / (legendre_eval * legendre_eval);
+            }
+            return table;
+        }
+    }
+
+    /// @brief the Gauss Legendre points and weights baked at compile time
+    template<class T, int npoin>
+    inline constexpr impl::quadrule_1d_table<T, npoin> gauss_legendre_table 
+        = impl::compute_gauss_legendre<T, npoin>();
+
+    /// @brief the Gauss Lobatto Legendre points and weights baked at compile time
+    template<class T, int npoin>
+    inline constexpr impl::quadrule_1d_table<T, npoin> gauss_lobatto_table 
+        = impl::compute_gauss_lobatto<T, npoin>();
+
 
     /**
      * @brief 
@@ -32,47 +150,44 @@ namespace iceicle {
         public:
 
         GaussLegendreQuadrature(){
+            // copy the compile time table
+            for(int ipoin = 0; ipoin < npoin; ++ipoin){
+                qpoints[ipoin].abscisse = {gauss_legendre_table<T, npoin>.points[ipoin]};
+                qpoints[ipoin].weight = gauss_legendre_table<T, npoin>.weights[ipoin];
+            }
+        }
 
-            // rules are symmetric, only do half
-            static constexpr int m = (npoin) / 2;
+        int npoints() const override { return npoin; }
 
-            T weightcenter;
-            if constexpr (npoin % 2 != 0) weightcenter = 2.0;
-            for(int i = 1; i <= m; i++){
-                // populate initial guess 
-                T xi = std::cos(M_PI * (i - 0.25) / (npoin + 0.5));
-               
-                T dlegendre = 0.0;
-                // Newton-Raphson loop
-                static constexpr int max_newton_it = 50;
-                for(int inewton = 0; inewton < max_newton_it; ++inewton){
-                    
-                    T legendre_eval = MATH::POLYNOMIAL::legendre1d<T, npoin>(xi);
-                    dlegendre = MATH::POLYNOMIAL::dlegendre1d<T, npoin>(xi);
+        const QuadraturePoint<T, ndim> &getPoint(int ipoint) const override { return qpoints[ipoint]; }
+    };
 
-                    T dxi = legendre_eval / dlegendre;
-                    if(std::abs(dxi) < 1e-16){
-                        xi -= dxi;
-                        break;
-                    }
+    /**
+     * @brief Gauss-Lobatto-Legendre quadrature
+     * the points are -1, 1, and the roots of P'_{npoin - 1}
+     * ordered from -1 to 1 (so they can be used as collocation nodes)
+     * exact for polynomials of degree 2 * npoin - 3
+     */
+    template<typename T, typename IDX, int npoin>
+    class GaussLobattoQuadrature final : public QuadratureRule<double, int, 1> {
+        static_assert(npoin >= 2, "Gauss-Lobatto quadrature includes both endpoints");
 
-                    xi -= dxi;
-                }
+        /// d is the maximum polynomial degree of the integration formula
+        static constexpr int d = 2 * npoin - 3;
+
+        /// this is a one dimensional quadrature rule
+        static constexpr int ndim = 1;
 
-                T weight = 2.0 / ((1 - SQUARED(xi)) * SQUARED(dlegendre));
-                if constexpr (npoin % 2 != 0) weightcenter -=  2 * weight;
-                int iarr = i - 1;
-                qpoints[2 * iarr].abscisse = {xi};
-                qpoints[2 * iarr].weight = weight;
+        /// The Quadrature Points
+        QuadraturePoint<T, ndim> qpoints[npoin];
 
-                qpoints[2 * iarr + 1].abscisse = {-xi};
-                qpoints[2 * iarr + 1].weight = weight;
-                
-            }
+        public:
 
-            if constexpr(npoin % 2 != 0){
-                qpoints[npoin - 1].abscisse = {0.0};
-                qpoints[npoin - 1].weight = weightcenter;
+        GaussLobattoQuadrature(){
+            // copy the compile time table
+            for(int ipoin = 0; ipoin < npoin; ++ipoin){
+                qpoints[ipoin].abscisse = {gauss_lobatto_table<T, npoin>.points[ipoin]};
+                qpoints[ipoin].weight = gauss_lobatto_table<T, npoin>.weights[ipoin];
             }
         }
 
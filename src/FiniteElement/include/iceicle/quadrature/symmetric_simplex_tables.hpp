@@ -0,0 +1,438 @@
+/**
+ * @file symmetric_simplex_tables.hpp
+ * @brief tabulated fully symmetric quadrature rules on the reference simplex
+ * (the simplex with vertices at the origin and the unit vectors, so the weights sum to 1 / ndim!)
+ *
+ * Each rule is a list of orbits: a weight and the free barycentric coordinates of the generator.
+ * The rules have positive weights and all points strictly inside the simplex.
+ * They were found by Levenberg-Marquardt on the orthonormal (Dubiner) basis moment equations
+ * for the orbit structures and point counts of Witherden and Vincent (2015)
+ * (the degree 9 tetrahedron rule uses 59 instead of 71 points)
+ * and are exact to round-off (see TestSimplexQuadrature.cpp).
+ */
+#pragma once
+#include <array>
+
+namespace iceicle::impl {
+
+    /// @brief the orbits of points under the symmetry group of the simplex
+    /// named by the multiplicity of the barycentric coordinates of the generator
+    enum class SIMPLEX_ORBIT {
+        S3,    ///< triangle centroid (1 point)
+        S21,   ///< (a, a, 1 - 2a) (3 points)
+        S111,  ///< (a, b, 1 - a - b) (6 points)
+        S4,    ///< tetrahedron centroid (1 point)
+        S31,   ///< (a, a, a, 1 - 3a) (4 points)
+        S22,   ///< (a, a, 1/2 - a, 1/2 - a) (6 points)
+        S211,  ///< (a, a, b, 1 - 2a - b) (12 points)
+        S1111  ///< (a, b, c, 1 - a - b - c) (24 points)
+    };
+
+    /// @brief an orbit of a symmetric rule
+    struct simplex_orbit {
+        /// the type of orbit
+        SIMPLEX_ORBIT type;
+
+        /// the weight of each point in the orbit
+        double weight;
+
+        /// the free barycentric coordinates of the generator
+        std::array<double, 3> params{};
+    };
+
+    /// @brief the number of points in an orbit
+    constexpr auto orbit_size(SIMPLEX_ORBIT type) -> int {
+        switch(type){
+            case SIMPLEX_ORBIT::S3:    return 1;
+            case SIMPLEX_ORBIT::S21:   return 3;
+            case SIMPLEX_ORBIT::S111:  return 6;
+            case SIMPLEX_ORBIT::S4:    return 1;
+            case SIMPLEX_ORBIT::S31:   return 4;
+            case SIMPLEX_ORBIT::S22:   return 6;
+            case SIMPLEX_ORBIT::S211:  return 12;
+            case SIMPLEX_ORBIT::S1111: return 24;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief the barycentric generator of an orbit
+     * @param orbit the orbit
+     * @param [out] bary the barycentric coordinates [size = ndim + 1]
+     * @param [out] classes equal values for coordinates that are equal by definition [size = ndim + 1]
+     * (so the distinct permutations of the classes are the points of the orbit)
+     */
+    template<class T>
+    constexpr auto orbit_generator(const simplex_orbit& orbit, T* bary, int* classes) -> void {
+        const double a = orbit.params[0], b = orbit.params[1], c = orbit.params[2];
+        auto set = [&]<std::size_t n>(std::array<double, n> values, std::array<int, n> cls){
+            for(std::size_t i = 0; i < n; ++i){
+                bary[i] = values[i];
+                classes[i] = cls[i];
+            }
+        };
+        switch(orbit.type){
+            case SIMPLEX_ORBIT::S3:    set(std::array{1.0 / 3, 1.0 / 3, 1.0 / 3}, std::array{0, 0, 0}); break;
+            case SIMPLEX_ORBIT::S21:   set(std::array{a, a, 1 - 2 * a}, std::array{0, 0, 1}); break;
+            case SIMPLEX_ORBIT::S111:  set(std::array{a, b, 1 - a - b}, std::array{0, 1, 2}); break;
+            case SIMPLEX_ORBIT::S4:    set(std::array{0.25, 0.25, 0.25, 0.25}, std::array{0, 0, 0, 0}); break;
+            case SIMPLEX_ORBIT::S31:   set(std::array{a, a, a, 1 - 3 * a}, std::array{0, 0, 0, 1}); break;
+            case SIMPLEX_ORBIT::S22:   set(std::array{a, a, 0.5 - a, 0.5 - a}, std::array{0, 0, 1, 1}); break;
+            case SIMPLEX_ORBIT::S211:  set(std::array{a, a, b, 1 - 2 * a - b}, std::array{0, 0, 1, 2}); break;
+            case SIMPLEX_ORBIT::S1111: set(std::array{a, b, c, 1 - a - b - c}, std::array{0, 1, 2, 3}); break;
+        }
+    }
+
+    /// @brief the tabulated rule of a given degree
+    /// specializations provide exists = true and the orbits
+    template<int ndim, int degree>
+    struct symmetric_simplex_table {
+        static constexpr bool exists = false;
+    };
+
+
+    /// @brief triangle degree 1 (1 points)
+    template<> struct symmetric_simplex_table<2, 1> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 1> orbits{{
+            {SIMPLEX_ORBIT::S3, 5.00000000000000000e-01, {}}
+        }};
+    };
+
+    /// @brief triangle degree 2 (3 points)
+    template<> struct symmetric_simplex_table<2, 2> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 1> orbits{{
+            {SIMPLEX_ORBIT::S21, 1.66666666666666657e-01, {1.66666666666666657e-01}}
+        }};
+    };
+
+    /// @brief triangle degree 3 (6 points)
+    template<> struct symmetric_simplex_table<2, 3> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 1> orbits{{
+            {SIMPLEX_ORBIT::S111, 8.33333333333333287e-02, {6.59027622374092181e-01, 2.31933368553030567e-01}}
+        }};
+    };
+
+    /// @brief triangle degree 4 (6 points)
+    template<> struct symmetric_simplex_table<2, 4> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 2> orbits{{
+            {SIMPLEX_ORBIT::S21, 5.49758718276609354e-02, {9.15762135097707430e-02}},
+            {SIMPLEX_ORBIT::S21, 1.11690794839005736e-01, {4.45948490915964890e-01}}
+        }};
+    };
+
+    /// @brief triangle degree 5 (7 points)
+    template<> struct symmetric_simplex_table<2, 5> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 3> orbits{{
+            {SIMPLEX_ORBIT::S3, 1.12500000000000003e-01, {}},
+            {SIMPLEX_ORBIT::S21, 6.61970763942530960e-02, {4.70142064105115109e-01}},
+            {SIMPLEX_ORBIT::S21, 6.29695902724135698e-02, {1.01286507323456343e-01}}
+        }};
+    };
+
+    /// @brief triangle degree 6 (12 points)
+    template<> struct symmetric_simplex_table<2, 6> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 3> orbits{{
+            {SIMPLEX_ORBIT::S21, 5.83931378631896841e-02, {2.49286745170910429e-01}},
+            {SIMPLEX_ORBIT::S21, 2.54224531851034094e-02, {6.30890144915022266e-02}},
+            {SIMPLEX_ORBIT::S111, 4.14255378091867854e-02, {3.10352451033784393e-01, 5.31450498448169453e-02}}
+        }};
+    };
+
+    /// @brief triangle degree 7 (15 points)
+    template<> struct symmetric_simplex_table<2, 7> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 3> orbits{{
+            {SIMPLEX_ORBIT::S21, 2.65389008951162075e-02, {6.49305131591648571e-02}},
+            {SIMPLEX_ORBIT::S111, 3.54265418460667850e-02, {5.17039939069322996e-01, 2.84575584249170344e-01}},
+            {SIMPLEX_ORBIT::S111, 3.46373410397084469e-02, {4.38634717923724743e-02, 6.42577343822696045e-01}}
+        }};
+    };
+
+    /// @brief triangle degree 8 (16 points)
+    template<> struct symmetric_simplex_table<2, 8> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 5> orbits{{
+            {SIMPLEX_ORBIT::S3, 7.21578038388935861e-02, {}},
+            {SIMPLEX_ORBIT::S21, 5.16086852673591223e-02, {1.70569307751760213e-01}},
+            {SIMPLEX_ORBIT::S21, 4.75458171336423097e-02, {4.59292588292723181e-01}},
+            {SIMPLEX_ORBIT::S21, 1.62292488115990396e-02, {5.05472283170309775e-02}},
+            {SIMPLEX_ORBIT::S111, 1.36151570872174964e-02, {8.39477740995760516e-03, 2.63112829634638112e-01}}
+        }};
+    };
+
+    /// @brief triangle degree 9 (19 points)
+    template<> struct symmetric_simplex_table<2, 9> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 6> orbits{{
+            {SIMPLEX_ORBIT::S3, 4.85678981413994182e-02, {}},
+            {SIMPLEX_ORBIT::S21, 3.98238694636051244e-02, {1.88203535619032719e-01}},
+            {SIMPLEX_ORBIT::S21, 3.89137705023871391e-02, {4.37089591492936635e-01}},
+            {SIMPLEX_ORBIT::S21, 1.56673501135695357e-02, {4.89682519198737620e-01}},
+            {SIMPLEX_ORBIT::S21, 1.27888378293490156e-02, {4.47295133944527121e-02}},
+            {SIMPLEX_ORBIT::S111, 2.16417696886446881e-02, {3.68384120547362859e-02, 2.21962989160765706e-01}}
+        }};
+    };
+
+    /// @brief triangle degree 10 (25 points)
+    template<> struct symmetric_simplex_table<2, 10> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 6> orbits{{
+            {SIMPLEX_ORBIT::S3, 4.16098684932250731e-02, {}},
+            {SIMPLEX_ORBIT::S21, 2.63259747341222962e-02, {1.62913117874094765e-01}},
+            {SIMPLEX_ORBIT::S21, 5.47564417013420620e-03, {2.85035002883878355e-02}},
+            {SIMPLEX_ORBIT::S111, 1.46614320478261183e-02, {3.36856986806102834e-02, 1.53303055169561359e-01}},
+            {SIMPLEX_ORBIT::S111, 2.81386398554055901e-02, {3.36695875278231638e-01, 1.46811505393930425e-01}},
+            {SIMPLEX_ORBIT::S111, 1.76974738957691967e-02, {6.07329778500850015e-01, 2.93076045045794729e-02}}
+        }};
+    };
+
+    /// @brief triangle degree 11 (28 points)
+    template<> struct symmetric_simplex_table<2, 11> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 8> orbits{{
+            {SIMPLEX_ORBIT::S3, 4.05028231009570416e-02, {}},
+            {SIMPLEX_ORBIT::S21, 6.18527800057811633e-03, {3.09950633619965818e-02}},
+            {SIMPLEX_ORBIT::S21, 6.03162808812212833e-03, {4.99118476586475124e-01}},
+            {SIMPLEX_ORBIT::S21, 3.13280943620541930e-02, {4.36394160521023700e-01}},
+            {SIMPLEX_ORBIT::S21, 3.38049416809643871e-02, {2.14816425363575925e-01}},
+            {SIMPLEX_ORBIT::S21, 2.01386129207032048e-02, {1.13980480259247299e-01}},
+            {SIMPLEX_ORBIT::S111, 2.03931382077585967e-02, {6.39689007854490232e-01, 3.12516720226683753e-01}},
+            {SIMPLEX_ORBIT::S111, 7.44544708253754798e-03, {8.25175761685019826e-01, 1.48077183931318839e-02}}
+        }};
+    };
+
+    /// @brief triangle degree 12 (33 points)
+    template<> struct symmetric_simplex_table<2, 12> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 8> orbits{{
+            {SIMPLEX_ORBIT::S21, 2.49591674640304712e-02, {4.40111648658593091e-01}},
+            {SIMPLEX_ORBIT::S21, 1.42430260344387719e-02, {1.09257827659354295e-01}},
+            {SIMPLEX_ORBIT::S21, 1.21334190407260158e-02, {4.88203750945541526e-01}},
+            {SIMPLEX_ORBIT::S21, 3.12706065979513823e-02, {2.71462507014926080e-01}},
+            {SIMPLEX_ORBIT::S21, 3.96582125498681944e-03, {2.46463634363355936e-02}},
+            {SIMPLEX_ORBIT::S111, 7.54183878825571887e-03, {8.51337792510239999e-01, 1.27279717233589357e-01}},
+            {SIMPLEX_ORBIT::S111, 1.08917925193037796e-02, {2.91655679738340945e-01, 2.30341563552671387e-02}},
+            {SIMPLEX_ORBIT::S111, 2.16136818297071043e-02, {1.16296019677926590e-01, 2.55454228638517356e-01}}
+        }};
+    };
+
+    /// @brief triangle degree 13 (37 points)
+    template<> struct symmetric_simplex_table<2, 13> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 9> orbits{{
+            {SIMPLEX_ORBIT::S3, 3.39800182934158201e-02, {}},
+            {SIMPLEX_ORBIT::S21, 3.02616855176958584e-03, {2.15096811088431837e-02}},
+            {SIMPLEX_ORBIT::S21, 2.91392425595999906e-02, {2.21372286291832893e-01}},
+            {SIMPLEX_ORBIT::S21, 2.78009837652266646e-02, {4.26941414259800422e-01}},
+            {SIMPLEX_ORBIT::S21, 1.19972009644473653e-02, {4.89076946452539352e-01}},
+            {SIMPLEX_ORBIT::S111, 1.73206380704241866e-02, {6.23545995553675625e-01, 6.80122435542066528e-02}},
+            {SIMPLEX_ORBIT::S111, 1.20895199057969097e-02, {7.48507115899952225e-01, 1.63597401067850479e-01}},
+            {SIMPLEX_ORBIT::S111, 4.79534050177163156e-03, {5.12638910238236850e-03, 7.22357793124188019e-01}},
+            {SIMPLEX_ORBIT::S111, 7.48270055258283377e-03, {8.64707770295442768e-01, 1.10922042803463392e-01}}
+        }};
+    };
+
+    /// @brief triangle degree 14 (42 points)
+    template<> struct symmetric_simplex_table<2, 14> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 10> orbits{{
+            {SIMPLEX_ORBIT::S21, 1.09417906847144447e-02, {4.88963910362178622e-01}},
+            {SIMPLEX_ORBIT::S21, 2.46170180120004094e-03, {1.93909612487010476e-02}},
+            {SIMPLEX_ORBIT::S21, 2.10812943684965080e-02, {1.77205532412543443e-01}},
+            {SIMPLEX_ORBIT::S21, 2.58870522536457925e-02, {2.73477528308838647e-01}},
+            {SIMPLEX_ORBIT::S21, 7.21684983488833382e-03, {6.17998830908726010e-02}},
+            {SIMPLEX_ORBIT::S21, 1.63941767720626741e-02, {4.17644719340453940e-01}},
+            {SIMPLEX_ORBIT::S111, 2.50511441925033596e-03, {8.79757171370171176e-01, 1.18974497696956852e-01}},
+            {SIMPLEX_ORBIT::S111, 1.23328766062818368e-02, {7.70608554774996457e-01, 5.71247574036479397e-02}},
+            {SIMPLEX_ORBIT::S111, 1.92857553935303419e-02, {9.29162493569718195e-02, 3.36861459796345020e-01}},
+            {SIMPLEX_ORBIT::S111, 7.21815405676692022e-03, {2.98372882136257733e-01, 1.46469500556544105e-02}}
+        }};
+    };
+
+    /// @brief triangle degree 15 (49 points)
+    template<> struct symmetric_simplex_table<2, 15> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 11> orbits{{
+            {SIMPLEX_ORBIT::S3, 2.39710384965183855e-02, {}},
+            {SIMPLEX_ORBIT::S21, 6.48967021702743542e-03, {4.92339213565699430e-01}},
+            {SIMPLEX_ORBIT::S21, 2.21710663823791124e-03, {1.86277110040519792e-02}},
+            {SIMPLEX_ORBIT::S21, 1.67808729399421611e-02, {2.15608885829879887e-01}},
+            {SIMPLEX_ORBIT::S21, 9.45188760689453719e-03, {8.30442744251539688e-02}},
+            {SIMPLEX_ORBIT::S111, 6.02741284998818943e-03, {7.79586788073649894e-01, 1.98952627587007866e-02}},
+            {SIMPLEX_ORBIT::S111, 1.48801904864624517e-02, {9.54321137191806584e-02, 6.97844787542367562e-01}},
+            {SIMPLEX_ORBIT::S111, 3.67436437856404020e-03, {8.93280821558066873e-01, 1.46503127582919869e-02}},
+            {SIMPLEX_ORBIT::S111, 1.59991871513693769e-02, {1.86720291135292121e-01, 3.44212999914539519e-01}},
+            {SIMPLEX_ORBIT::S111, 1.54385594804923847e-02, {7.92342892452848058e-02, 3.70669168918287661e-01}},
+            {SIMPLEX_ORBIT::S111, 5.84867720265280604e-03, {1.55099494459148939e-02, 6.51774935566242664e-01}}
+        }};
+    };
+
+    /// @brief triangle degree 16 (55 points)
+    template<> struct symmetric_simplex_table<2, 16> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 12> orbits{{
+            {SIMPLEX_ORBIT::S3, 2.26680825059100872e-02, {}},
+            {SIMPLEX_ORBIT::S21, 1.08509496340497471e-03, {1.24255720014440924e-02}},
+            {SIMPLEX_ORBIT::S21, 8.40430607148185890e-03, {8.54025394079332006e-02}},
+            {SIMPLEX_ORBIT::S21, 7.22527733754236429e-03, {4.91748383418915913e-01}},
+            {SIMPLEX_ORBIT::S21, 1.29977152273383668e-02, {4.56694266953874661e-01}},
+            {SIMPLEX_ORBIT::S111, 5.83558616862343230e-03, {3.24540035240218017e-01, 1.41607725337947916e-02}},
+            {SIMPLEX_ORBIT::S111, 9.72998416004170093e-03, {1.53415536794146878e-01, 2.06220992786642049e-01}},
+            {SIMPLEX_ORBIT::S111, 9.12911855504844501e-03, {7.38343305566065866e-01, 7.12787628321478600e-02}},
+            {SIMPLEX_ORBIT::S111, 2.00544666166777158e-02, {3.23159128486343872e-01, 1.91773272709181763e-01}},
+            {SIMPLEX_ORBIT::S111, 4.74113143968042314e-03, {1.45396949589418553e-02, 8.07388915980843391e-01}},
+            {SIMPLEX_ORBIT::S111, 1.16519744382981034e-02, {3.23749502700390934e-01, 7.42954789913306823e-02}},
+            {SIMPLEX_ORBIT::S111, 3.55686140409471486e-03, {7.12700461594862750e-02, 1.66232232237057929e-02}}
+        }};
+    };
+
+    /// @brief triangle degree 17 (60 points)
+    template<> struct symmetric_simplex_table<2, 17> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 13> orbits{{
+            {SIMPLEX_ORBIT::S21, 1.48325583735246045e-02, {4.17195101524169332e-01}},
+            {SIMPLEX_ORBIT::S21, 5.60736581496868759e-03, {4.92999084836024670e-01}},
+            {SIMPLEX_ORBIT::S21, 6.30884428907667154e-03, {7.03111696113695173e-02}},
+            {SIMPLEX_ORBIT::S21, 1.83224966868937647e-02, {2.86612524329644625e-01}},
+            {SIMPLEX_ORBIT::S21, 1.22030656397548905e-02, {4.64605965545341448e-01}},
+            {SIMPLEX_ORBIT::S21, 1.16862294334584456e-02, {1.69709430967304897e-01}},
+            {SIMPLEX_ORBIT::S111, 4.95166239419586162e-03, {1.27641284576574341e-02, 6.49061383192832131e-01}},
+            {SIMPLEX_ORBIT::S111, 9.76864627775428374e-03, {1.71461409253039238e-01, 7.36994410884886514e-02}},
+            {SIMPLEX_ORBIT::S111, 4.70842210142352613e-03, {7.89260755414779247e-01, 1.96366702481635624e-01}},
+            {SIMPLEX_ORBIT::S111, 9.01752354882731514e-04, {9.66765387003209797e-01, 1.21436166650499382e-02}},
+            {SIMPLEX_ORBIT::S111, 3.17872347876358525e-03, {9.00567027053749247e-01, 1.37080023813583377e-02}},
+            {SIMPLEX_ORBIT::S111, 1.13164995898565844e-02, {3.10526723992961773e-01, 6.22105631128788028e-01}},
+            {SIMPLEX_ORBIT::S111, 1.40273470176182271e-02, {2.87064866572529276e-01, 1.61235465054627825e-01}}
+        }};
+    };
+
+    /// @brief triangle degree 18 (67 points)
+    template<> struct symmetric_simplex_table<2, 18> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 15> orbits{{
+            {SIMPLEX_ORBIT::S3, 1.81778676507133342e-02, {}},
+            {SIMPLEX_ORBIT::S21, 6.02332381699985549e-03, {4.87580301574869535e-01}},
+            {SIMPLEX_ORBIT::S21, 1.82375447044718191e-02, {2.42264702514271957e-01}},
+            {SIMPLEX_ORBIT::S21, 9.47458575338943308e-03, {4.61809506406449244e-01}},
+            {SIMPLEX_ORBIT::S21, 1.66522350166950668e-02, {3.99955628067576230e-01}},
+            {SIMPLEX_ORBIT::S21, 3.56466300985948522e-03, {3.88302560886855941e-02}},
+            {SIMPLEX_ORBIT::S21, 8.27957997600162372e-03, {9.19477421216431945e-02}},
+            {SIMPLEX_ORBIT::S111, 2.26526725112853253e-03, {6.00418954634256874e-01, 3.89761103347338253e-03}},
+            {SIMPLEX_ORBIT::S111, 6.11474063480544911e-04, {5.48360042042318968e-04, 2.70909109951620146e-02}},
+            {SIMPLEX_ORBIT::S111, 6.87980811747110257e-03, {7.70372376214675247e-01, 4.58049158598607814e-02}},
+            {SIMPLEX_ORBIT::S111, 1.18909554500764153e-02, {1.22696757371927548e-01, 6.70953985194234548e-01}},
+            {SIMPLEX_ORBIT::S111, 2.50533043728986106e-03, {2.35772184958191744e-01, 7.58929479855198541e-01}},
+            {SIMPLEX_ORBIT::S111, 3.42005505980359087e-03, {8.78342189467521739e-01, 1.08195793791033293e-01}},
+            {SIMPLEX_ORBIT::S111, 8.87374455101020213e-03, {3.19751624525377365e-01, 6.39988092004714626e-01}},
+            {SIMPLEX_ORBIT::S111, 1.27410876559122203e-02, {3.33493529449880755e-01, 1.20587695163924646e-01}}
+        }};
+    };
+
+    /// @brief tetrahedron degree 1 (1 points)
+    template<> struct symmetric_simplex_table<3, 1> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 1> orbits{{
+            {SIMPLEX_ORBIT::S4, 1.66666666666666657e-01, {}}
+        }};
+    };
+
+    /// @brief tetrahedron degree 2 (4 points)
+    template<> struct symmetric_simplex_table<3, 2> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 1> orbits{{
+            {SIMPLEX_ORBIT::S31, 4.16666666666666644e-02, {1.38196601125010504e-01}}
+        }};
+    };
+
+    /// @brief tetrahedron degree 3 (8 points)
+    template<> struct symmetric_simplex_table<3, 3> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 2> orbits{{
+            {SIMPLEX_ORBIT::S31, 2.18325634347415892e-02, {3.28452278766964589e-01}},
+            {SIMPLEX_ORBIT::S31, 1.98341032319250751e-02, {1.10412827796155549e-01}}
+        }};
+    };
+
+    /// @brief tetrahedron degree 4 (14 points)
+    template<> struct symmetric_simplex_table<3, 4> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 3> orbits{{
+            {SIMPLEX_ORBIT::S31, 1.08289272167719827e-02, {8.74281722897649882e-02}},
+            {SIMPLEX_ORBIT::S31, 1.47829557707038570e-02, {3.09576390482713903e-01}},
+            {SIMPLEX_ORBIT::S22, 1.07031891194605509e-02, {4.34494774668466255e-01}}
+        }};
+    };
+
+    /// @brief tetrahedron degree 5 (14 points)
+    template<> struct symmetric_simplex_table<3, 5> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 3> orbits{{
+            {SIMPLEX_ORBIT::S31, 1.87813209530026427e-02, {3.10885919263300614e-01}},
+            {SIMPLEX_ORBIT::S31, 1.22488405193936587e-02, {9.27352503108912207e-02}},
+            {SIMPLEX_ORBIT::S22, 7.09100346284691121e-03, {4.55037041256496494e-02}}
+        }};
+    };
+
+    /// @brief tetrahedron degree 6 (24 points)
+    template<> struct symmetric_simplex_table<3, 6> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 4> orbits{{
+            {SIMPLEX_ORBIT::S31, 9.22619692394245280e-03, {3.22337890142275485e-01}},
+            {SIMPLEX_ORBIT::S31, 1.67953517588677391e-03, {4.06739585346113583e-02}},
+            {SIMPLEX_ORBIT::S31, 6.65379170969458353e-03, {2.14602871259152006e-01}},
+            {SIMPLEX_ORBIT::S211, 8.03571428571428492e-03, {6.36610018750175255e-02, 2.69672331458315817e-01}}
+        }};
+    };
+
+    /// @brief tetrahedron degree 7 (35 points)
+    template<> struct symmetric_simplex_table<3, 7> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 5> orbits{{
+            {SIMPLEX_ORBIT::S4, 1.59142149106884755e-02, {}},
+            {SIMPLEX_ORBIT::S31, 7.05493020166117132e-03, {3.15701149778202794e-01}},
+            {SIMPLEX_ORBIT::S22, 5.31615463880959638e-03, {4.49510177401603650e-01}},
+            {SIMPLEX_ORBIT::S211, 1.35179513831722360e-03, {2.12654725414832477e-02, 8.10830241098548510e-01}},
+            {SIMPLEX_ORBIT::S211, 6.20118845472243663e-03, {1.88833831026001042e-01, 4.71607003609978842e-02}}
+        }};
+    };
+
+    /// @brief tetrahedron degree 8 (46 points)
+    template<> struct symmetric_simplex_table<3, 8> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 7> orbits{{
+            {SIMPLEX_ORBIT::S31, 7.33189069454324386e-03, {1.88655317868399591e-01}},
+            {SIMPLEX_ORBIT::S31, 7.47288395079723656e-03, {3.13510469258504343e-01}},
+            {SIMPLEX_ORBIT::S31, 5.46625269629662063e-03, {1.18961230192473094e-01}},
+            {SIMPLEX_ORBIT::S31, 1.55589751285426718e-03, {4.58816095214904657e-02}},
+            {SIMPLEX_ORBIT::S22, 6.22090153284610148e-03, {6.62625761026211929e-02}},
+            {SIMPLEX_ORBIT::S211, 1.19583501352538493e-03, {2.11702281480057944e-02, 2.45028515868764812e-01}},
+            {SIMPLEX_ORBIT::S211, 2.30696149077666383e-03, {2.03790966148929692e-01, 2.98336850737674231e-03}}
+        }};
+    };
+
+    /// @brief tetrahedron degree 9 (59 points)
+    template<> struct symmetric_simplex_table<3, 9> {
+        static constexpr bool exists = true;
+        static constexpr std::array<simplex_orbit, 9> orbits{{
+            {SIMPLEX_ORBIT::S4, 9.50116487259817198e-03, {}},
+            {SIMPLEX_ORBIT::S31, 2.92046427665448101e-05, {1.24741013606378716e-02}},
+            {SIMPLEX_ORBIT::S31, 4.93697884572227332e-03, {3.22340965625314335e-01}},
+            {SIMPLEX_ORBIT::S31, 1.33923785597636234e-03, {4.57665680179765583e-02}},
+            {SIMPLEX_ORBIT::S31, 3.80119804450591110e-03, {1.63770743368939459e-01}},
+            {SIMPLEX_ORBIT::S22, 6.29688988920983767e-03, {1.11849666052113689e-01}},
+            {SIMPLEX_ORBIT::S211, 3.50450568717084951e-03, {1.82683214787282389e-01, 5.99322979384751098e-01}},
+            {SIMPLEX_ORBIT::S211, 1.39827713342867269e-03, {4.58769974284473192e-01, 2.47154136823536175e-03}},
+            {SIMPLEX_ORBIT::S211, 1.67702425464423630e-03, {3.33885807331383636e-02, 7.18544532414528536e-01}}
+        }};
+    };
+
+    /// @brief the highest tabulated degree
+    template<int ndim>
+    inline constexpr int symmetric_simplex_max_degree = (ndim == 2) ? 18 : 9;
+}
@@ -13,6 +13,8 @@
 #include <cmath>
 #include <mdspan/mdspan.hpp>
 #include <algorithm>
+#include <span>
+#include <vector>
 
 namespace iceicle::transformations {
 
@@ -48,6 +50,46 @@ struct hypercube {
     return el_coord;
   }
 
+  /**
+   * @brief the weights that place each interior node (not on any facet) 
+   * at the average over the reference directions of the linear interpolation 
+   * between the two facet nodes on the reference line through it 
+   * (this reproduces multilinear transformations exactly)
+   *
+   * @return 2 * ndim weights per interior node, grouped by interior node
+   */
+  static
+  auto regularization_stencil() -> std::span<const interior_node_weight<T>> {
+    static const std::vector<interior_node_weight<T>> stencil = []{
+      std::vector<interior_node_weight<T>> stencil{};
+      for(int inode = 0; inode < nnode; ++inode){
+        std::array<int, ndim> ijk = TensorProdType::ijk_poin[inode];
+        bool interior = true;
+        for(int idim = 0; idim < ndim; ++idim)
+          { if(ijk[idim] == 0 || ijk[idim] == Pn) interior = false; }
+        if(!interior) continue;
+
+        for(int idim = 0; idim < ndim; ++idim){
+          // endpoints along this line
+          std::array<int, ndim> ijk_0 = ijk;
+          ijk_0[idim] = 0;
+          std::array<int, ndim> ijk_1 = ijk;
+          ijk_1[idim] = Pn;
+
+          // barycentric weights of ijk
+          T w1 = ((T) ijk[idim]) / Pn;
+          T w0 = 1.0 - w1;
+          stencil.push_back(interior_node_weight<T>{inode, 
+              (int) TensorProdType::convert_ijk(ijk_0.data()), w0 / ndim});
+          stencil.push_back(interior_node_weight<T>{inode, 
+              (int) TensorProdType::convert_ijk(ijk_1.data()), w1 / ndim});
+        }
+      }
+      return stencil;
+    }();
+    return stencil;
+  }
+
   /**
   * @brief transform from the reference domain to the physcial domain
   * T(s): s -> x
@@ -728,40 +770,17 @@ public:
   auto regularize_nodes(
       const IDX gnodes[nnode],            /// [in] global node indices 
       NodeArray<T, ndim> &coord /// [in/out] node coordinate array
-  ) -> void const {
+  ) const -> void {
+    std::span<const interior_node_weight<T>> stencil = 
+      hypercube<T, IDX, ndim, Pn>::regularization_stencil();
 
-    // loop  over all interior nodes
-    for(int inode = 0; inode < nnode; ++inode) if(is_interior_inode(inode)) {
-      std::array<int, ndim> ijk = TensorProdType::ijk_poin[inode];
-
-      // get the global node coordinate of the interior node
-      IDX ignode = TensorProdType::convert_ijk(ijk.data());
-
-      // set the coordinate vlaues to 0 to add later
-      for(int jdim = 0; jdim < ndim; ++jdim){
-        coord[ignode][jdim] = 0.0;
-      }
-
-      for(int idim = 0; idim < ndim; ++idim){
-        // endpoints along this line
-        std::array<int, ndim> ijk_0 = ijk;
-        ijk_0[idim] = 0;
-        std::array<int, ndim> ijk_1 = ijk;
-        ijk_1[idim] = Pn;
-
-        // barycentric weights of ijk
-        T w0 = ((T) ijk[idim]) / Pn;
-        T w1 = 1.0 - w0;
-
-        // get the global node coordinates of the endpoints
-        IDX ignode_0 = TensorProdType::convert_ijk(ijk_0.data());
-        IDX ignode_1 = TensorProdType::convert_ijk(ijk_1.data());
-
-        // update the global node coordinate by weighted sum
-        for(int jdim = 0; jdim < ndim; ++jdim){
-          coord[ignode][jdim] += w0 / ndim * coord[ignode_0][jdim] + w1 / ndim * coord[ignode_1][jdim];
-        }
-      }
+    // interior nodes never contribute to the stencil so they can be zeroed and accumulated in place
+    for(const interior_node_weight<T>& entry : stencil) {
+      for(int idim = 0; idim < ndim; ++idim) coord[gnodes[entry.inode]][idim] = 0.0;
+    }
+    for(const interior_node_weight<T>& entry : stencil) {
+      for(int idim = 0; idim < ndim; ++idim)
+        { coord[gnodes[entry.inode]][idim] += entry.weight * coord[gnodes[entry.jnode]][idim]; }
     }
   }
 
@@ -4,8 +4,10 @@
 #include "iceicle/linalg/linalg_utils.hpp"
 #include "iceicle/basis/tensor_product.hpp"
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstddef>
+#include <span>
 #include <iceicle/bitset.hpp>
 
 namespace iceicle {
@@ -63,6 +65,7 @@ namespace iceicle {
           pt[idim] = static_cast<T>(1.0);
         }
       }
+      return pt;
     }
 
     /// @brief get the number of dimensions of given code
@@ -113,7 +116,7 @@ namespace iceicle {
     constexpr
     auto gen_vert() noexcept -> vertex_list<t>
     {
-      static constexpr int ndim = get_ndim(t);
+      constexpr int ndim = get_ndim(t);
       vertex_list<t> vertices;
       std::ranges::fill(vertices, vcode<ndim>{0});
 
@@ -121,7 +124,7 @@ namespace iceicle {
       for(int idim = 0; idim < ndim; ++idim){
         if(t[idim] == simpl_ext){
           // simplex extrusion domain comes to a single point
-          vertices[nvert_current] = vcode<ndim>{static_cast<unsigned long long>(std::pow(2, idim))};
+          vertices[nvert_current] = vcode<ndim>{1ull << idim};
           ++nvert_current;
         } else {
           // prismatic extrusion extrudes all the vertices of the current domain
@@ -256,5 +259,319 @@ namespace iceicle {
       static constexpr std::size_t ndim = e.count();
       static constexpr tcode<ndim> extruson_t = extrusion_toplogy(t, e);
     };
+
+    // ====================
+    // = Generated Tables =
+    // ====================
+    //
+    // The tables below are generated at compile time (constexpr) for each topology
+    // so the transformations are straight-line code over a fixed number of vertices.
+    // The reference domain of every topology lies in [0, 1]^ndim
+
+    /// @brief the vertex codes of the topology t
+    template<geo_code auto t>
+    inline constexpr vertex_list<t> vertices = gen_vert<t>();
+
+    /// @brief the reference domain coordinates of the vertices of the topology t
+    template<class T, geo_code auto t>
+    inline constexpr std::array<MATH::GEOMETRY::Point<T, get_ndim(t)>, n_vert(t)> vertex_coordinates = []{
+      std::array<MATH::GEOMETRY::Point<T, get_ndim(t)>, n_vert(t)> coords{};
+      for(std::size_t ivert = 0; ivert < n_vert(t); ++ivert)
+        coords[ivert] = vcode_to_point<T>(vertices<t>[ivert]);
+      return coords;
+    }();
+
+    /// @brief the number of vertices of the polytope formed by the first d dimensions of the topology t
+    template<std::size_t ndim>
+    constexpr
+    auto n_vert_lower(tcode<ndim> t, std::size_t d) noexcept -> std::size_t
+    {
+      std::size_t nvert = 1;
+      for(std::size_t idim = 0; idim < d; ++idim){
+        // the first dimension is always a segment
+        if(idim == 0 || t[idim] == prism_ext) nvert *= 2;
+        else nvert += 1;
+      }
+      return nvert;
+    }
+
+    /// @brief get the number of faces (facets of codimension 1) of the given polytope
+    /// @param t the code that defines the polytope domain
+    template<std::size_t ndim>
+    constexpr
+    auto n_faces(tcode<ndim> t) noexcept -> std::size_t
+    {
+      if constexpr(ndim == 0) { return 0; }
+      else {
+        std::size_t nface = 2;
+        for(std::size_t idim = 1; idim < ndim; ++idim){
+          // prism extrusions add a bottom and top face
+          // simplical extrusions add only the base (the other faces meet at the apex)
+          if(t[idim] == prism_ext) nface += 2;
+          else nface += 1;
+        }
+        return nface;
+      }
+    }
+
+    /// @brief the vertices of a face as indices into the vertex list of the topology
+    /// @tparam nvert_max the maximum number of vertices (the number of vertices of the topology)
+    template<std::size_t nvert_max>
+    struct face_vertex_list {
+      /// @brief the vertex indices (the first nvert are used)
+      std::array<std::size_t, nvert_max> vertices{};
+
+      /// @brief the number of vertices on the face
+      std::size_t nvert = 0;
+
+      /// @brief the vertex indices of the face
+      [[nodiscard]] constexpr
+      auto indices() const noexcept -> std::span<const std::size_t>
+      { return std::span<const std::size_t>{vertices.data(), nvert}; }
+    };
+
+    /// @brief generate the faces of a given topology
+    /// @tparam t the bitcode for the topology
+    /// @return the vertex indices (into gen_vert<t>()) of each face
+    ///
+    /// The faces are built with the same extrusions as the vertices:
+    /// The segment has the faces x_0 = 0 and x_0 = 1.
+    /// A prismatic extrusion extrudes each face of the current domain
+    /// and adds the bottom (x_d = 0) and top (x_d = 1) faces.
+    /// A simplical extrusion connects each face of the current domain to the apex
+    /// and adds the base (x_d = 0).
+    template<geo_code auto t>
+    constexpr
+    auto gen_faces() noexcept -> std::array<face_vertex_list<n_vert(t)>, n_faces(t)>
+    {
+      constexpr std::size_t ndim = get_ndim(t);
+      using face_t = face_vertex_list<n_vert(t)>;
+      std::array<face_t, n_faces(t)> faces{};
+      if constexpr (ndim > 0) {
+        faces[0].vertices[0] = 0;
+        faces[0].nvert = 1;
+        faces[1].vertices[0] = 1;
+        faces[1].nvert = 1;
+        std::size_t nface = 2;
+        std::size_t nvert_current = 2;
+        for(std::size_t idim = 1; idim < ndim; ++idim){
+          if(t[idim] == prism_ext){
+            for(std::size_t iface = 0; iface < nface; ++iface){
+              face_t& face = faces[iface];
+              for(std::size_t ivert = 0; ivert < face.nvert; ++ivert)
+                face.vertices[face.nvert + ivert] = face.vertices[ivert] + nvert_current;
+              face.nvert *= 2;
+            }
+            for(std::size_t ivert = 0; ivert < nvert_current; ++ivert){
+              faces[nface].vertices[ivert] = ivert;
+              faces[nface + 1].vertices[ivert] = ivert + nvert_current;
+            }
+            faces[nface].nvert = nvert_current;
+            faces[nface + 1].nvert = nvert_current;
+            nface += 2;
+            nvert_current *= 2;
+          } else {
+            for(std::size_t iface = 0; iface < nface; ++iface){
+              face_t& face = faces[iface];
+              face.vertices[face.nvert] = nvert_current;
+              ++face.nvert;
+            }
+            for(std::size_t ivert = 0; ivert < nvert_current; ++ivert)
+              faces[nface].vertices[ivert] = ivert;
+            faces[nface].nvert = nvert_current;
+            nface += 1;
+            nvert_current += 1;
+          }
+        }
+      }
+      return faces;
+    }
+
+    /// @brief the faces of the topology t
+    template<geo_code auto t>
+    inline constexpr auto faces = gen_faces<t>();
+
+    // ===================
+    // = Shape Functions =
+    // ===================
+
+    namespace impl {
+
+      /// @brief fill the vertex shape functions of the polytope formed by the first d dimensions of t
+      /// following the extrusions of gen_vert()
+      ///
+      /// A prismatic extrusion in dimension k splits each shape function into (1 - y_k) N and y_k N.
+      /// A simplical extrusion in dimension k scales the domain below towards the apex:
+      /// N(y) = (1 - y_k) N_base(y / (1 - y_k)) and the apex is y_k
+      /// (this gives the linear simplex and the rational pyramid shape functions)
+      ///
+      /// @param y the coordinates (scaled by the simplical extrusions above d)
+      /// @param weight the product of the shape function factors of the extrusions above d
+      /// @param [out] N the shape functions starting at the first vertex of this polytope
+      template<class T, geo_code auto t, std::size_t d>
+      constexpr
+      auto fill_shp(std::array<T, get_ndim(t)> y, T weight, T* N) noexcept -> void
+      {
+        if constexpr (d == 0) {
+          N[0] = weight;
+        } else {
+          constexpr std::size_t k = d - 1;
+          constexpr std::size_t nsub = n_vert_lower(t, k);
+          if constexpr (k == 0 || t[k] == prism_ext) {
+            fill_shp<T, t, k>(y, weight * (1.0 - y[k]), N);
+            fill_shp<T, t, k>(y, weight * y[k], N + nsub);
+          } else {
+            T s = y[k];
+            T a = 1.0 - s;
+            for(std::size_t jdim = 0; jdim < k; ++jdim)
+              y[jdim] = (a == 0.0) ? 0.0 : y[jdim] / a;
+            fill_shp<T, t, k>(y, weight * a, N);
+            N[nsub] = weight * s;
+          }
+        }
+      }
+
+      /// @brief fill the vertex shape function gradients of the polytope formed by the first d dimensions of t
+      /// (the derivative of fill_shp() by the chain rule)
+      ///
+      /// @param y the scaled coordinates
+      /// @param dy the gradient of each scaled coordinate with respect to the reference coordinates
+      /// @param weight the product of the shape function factors of the extrusions above d
+      /// @param dweight the gradient of weight
+      /// @param [out] dN the shape function gradients starting at the first vertex of this polytope
+      template<class T, geo_code auto t, std::size_t d>
+      constexpr
+      auto fill_deriv(
+        std::array<T, get_ndim(t)> y,
+        std::array<std::array<T, get_ndim(t)>, get_ndim(t)> dy,
+        T weight,
+        const std::array<T, get_ndim(t)>& dweight,
+        std::array<T, get_ndim(t)>* dN
+      ) noexcept -> void
+      {
+        constexpr std::size_t ndim = get_ndim(t);
+        if constexpr (d == 0) {
+          for(std::size_t jdim = 0; jdim < ndim; ++jdim) dN[0][jdim] = dweight[jdim];
+        } else {
+          constexpr std::size_t k = d - 1;
+          constexpr std::size_t nsub = n_vert_lower(t, k);
+          std::array<T, ndim> dweight0, dweight1;
+          if constexpr (k == 0 || t[k] == prism_ext) {
+            for(std::size_t jdim = 0; jdim < ndim; ++jdim){
+              dweight0[jdim] = dweight[jdim] * (1.0 - y[k]) - weight * dy[k][jdim];
+              dweight1[jdim] = dweight[jdim] * y[k] + weight * dy[k][jdim];
+            }
+            fill_deriv<T, t, k>(y, dy, weight * (1.0 - y[k]), dweight0, dN);
+            fill_deriv<T, t, k>(y, dy, weight * y[k], dweight1, dN + nsub);
+          } else {
+            T s = y[k];
+            T a = 1.0 - s;
+            const std::array<T, ndim> ds = dy[k];
+            for(std::size_t jdim = 0; jdim < ndim; ++jdim){
+              dweight0[jdim] = dweight[jdim] * a - weight * ds[jdim];
+              dN[nsub][jdim] = dweight[jdim] * s + weight * ds[jdim];
+            }
+            for(std::size_t idim = 0; idim < k; ++idim){
+              for(std::size_t jdim = 0; jdim < ndim; ++jdim){
+                dy[idim][jdim] = (a == 0.0) ? 0.0
+                  : dy[idim][jdim] / a + y[idim] * ds[jdim] / (a * a);
+              }
+              y[idim] = (a == 0.0) ? 0.0 : y[idim] / a;
+            }
+            fill_deriv<T, t, k>(y, dy, weight * a, dweight0, dN);
+          }
+        }
+      }
+    }
+
+    /// @brief the vertex shape functions of the topology t
+    /// @param xi the reference domain point
+    /// @return the shape function of each vertex (in the order of gen_vert())
+    template<class T, geo_code auto t>
+    constexpr
+    auto shp(const MATH::GEOMETRY::Point<T, get_ndim(t)>& xi) noexcept -> std::array<T, n_vert(t)>
+    {
+      constexpr std::size_t ndim = get_ndim(t);
+      std::array<T, ndim> y;
+      for(std::size_t idim = 0; idim < ndim; ++idim) y[idim] = xi[idim];
+      std::array<T, n_vert(t)> N;
+      impl::fill_shp<T, t, ndim>(y, 1.0, N.data());
+      return N;
+    }
+
+    /// @brief the gradients of the vertex shape functions of the topology t
+    /// @param xi the reference domain point
+    /// @return dN[ivert][jdim] the derivative of the shape function of vertex ivert wrt xi_jdim
+    template<class T, geo_code auto t>
+    constexpr
+    auto shp_deriv(const MATH::GEOMETRY::Point<T, get_ndim(t)>& xi) noexcept
+    -> std::array<std::array<T, get_ndim(t)>, n_vert(t)>
+    {
+      constexpr std::size_t ndim = get_ndim(t);
+      std::array<T, ndim> y;
+      std::array<std::array<T, ndim>, ndim> dy;
+      std::array<T, ndim> dweight;
+      for(std::size_t idim = 0; idim < ndim; ++idim){
+        y[idim] = xi[idim];
+        dweight[idim] = 0.0;
+        for(std::size_t jdim = 0; jdim < ndim; ++jdim) dy[idim][jdim] = (idim == jdim) ? 1.0 : 0.0;
+      }
+      std::array<std::array<T, ndim>, n_vert(t)> dN;
+      impl::fill_deriv<T, t, ndim>(y, dy, 1.0, dweight, dN.data());
+      return dN;
+    }
+
+    // ===================
+    // = Transformations =
+    // ===================
+
+    /// @brief the transformation from the reference domain to the physical domain
+    /// for the (linear) geometry defined by the vertices of the topology t
+    /// @param vertex_coords the physical coordinates of each vertex (in the order of gen_vert())
+    /// @param xi the reference domain point
+    /// @return the physical domain point
+    template<class T, geo_code auto t>
+    constexpr
+    auto transform(
+      std::span<const MATH::GEOMETRY::Point<T, get_ndim(t)>> vertex_coords,
+      const MATH::GEOMETRY::Point<T, get_ndim(t)>& xi
+    ) noexcept -> MATH::GEOMETRY::Point<T, get_ndim(t)>
+    {
+      constexpr std::size_t ndim = get_ndim(t);
+      std::array<T, n_vert(t)> N = shp<T, t>(xi);
+      MATH::GEOMETRY::Point<T, ndim> x;
+      for(std::size_t idim = 0; idim < ndim; ++idim) x[idim] = 0.0;
+      for(std::size_t ivert = 0; ivert < n_vert(t); ++ivert){
+        for(std::size_t idim = 0; idim < ndim; ++idim)
+          x[idim] += N[ivert] * vertex_coords[ivert][idim];
+      }
+      return x;
+    }
+
+    /// @brief the jacobian of transform()
+    /// @param vertex_coords the physical coordinates of each vertex (in the order of gen_vert())
+    /// @param xi the reference domain point
+    /// @return J[i][j] = dx_i / dxi_j
+    template<class T, geo_code auto t>
+    constexpr
+    auto jacobian(
+      std::span<const MATH::GEOMETRY::Point<T, get_ndim(t)>> vertex_coords,
+      const MATH::GEOMETRY::Point<T, get_ndim(t)>& xi
+    ) noexcept -> NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, get_ndim(t), get_ndim(t)>
+    {
+      constexpr std::size_t ndim = get_ndim(t);
+      auto dN = shp_deriv<T, t>(xi);
+      NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, ndim, ndim> J;
+      for(std::size_t idim = 0; idim < ndim; ++idim){
+        for(std::size_t jdim = 0; jdim < ndim; ++jdim) J[idim][jdim] = 0.0;
+      }
+      for(std::size_t ivert = 0; ivert < n_vert(t); ++ivert){
+        for(std::size_t idim = 0; idim < ndim; ++idim){
+          for(std::size_t jdim = 0; jdim < ndim; ++jdim)
+            J[idim][jdim] += dN[ivert][jdim] * vertex_coords[ivert][idim];
+        }
+      }
+      return J;
+    }
   }
 }
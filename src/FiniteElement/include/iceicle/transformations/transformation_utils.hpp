@@ -1,5 +1,248 @@
+/// @brief inversion of element transformations (physical domain to reference domain)
+/// @author Gianni Absillis (gabsill@ncsu.edu)
 #pragma once
+#include "iceicle/geometry/geo_element.hpp"
+#include <Numtool/fixed_size_tensor.hpp>
+#include <Numtool/point.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <span>
+
 namespace iceicle::transformations {
 
+    /// @brief the result of inverting an element transformation at a physical point
+    template<class T, int ndim>
+    struct inverse_map_result {
+        /// @brief the reference domain point (the last iterate if not converged)
+        MATH::GEOMETRY::Point<T, ndim> xi;
+
+        /// @brief the max norm of x - T(xi)
+        T residual;
+
+        /// @brief the number of Newton iterations taken
+        int iterations;
+
+        /// @brief the residual reached the tolerance
+        bool converged;
+    };
+
+    /// @brief the inverse of the jacobian J^{-1} = adj(J) / det(J) (protected from division by zero)
+    template<class T, int ndim>
+    inline auto safe_inverse(const NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, ndim, ndim>& J) noexcept
+    -> NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, ndim, ndim> {
+        using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+        auto adjJ = adjugate(J);
+        T detJ = determinant(J);
+        detJ = (detJ == 0.0) ? 1.0 : detJ;
+        Tensor<T, ndim, ndim> Jinv;
+        for(int i = 0; i < ndim; ++i){
+            for(int j = 0; j < ndim; ++j) Jinv[i][j] = adjJ[i][j] / detJ;
+        }
+        return Jinv;
+    }
+
+    /// @brief the largest distance of an element node from the first node in any direction
+    /// (the length scale for the inversion tolerance)
+    template<class T, int ndim>
+    inline auto element_length_scale(std::span<const MATH::GEOMETRY::Point<T, ndim>> el_coord) noexcept -> T {
+        T h = 0.0;
+        for(const auto& node : el_coord){
+            for(int idim = 0; idim < ndim; ++idim) h = std::max(h, std::abs(node[idim] - el_coord[0][idim]));
+        }
+        return (h == 0.0) ? 1.0 : h;
+    }
+
+    /**
+     * @brief the inverse of the affine part of an element transformation
+     * x ~ T(xi_c) + J(xi_c) (xi - xi_c) about the reference domain centroid xi_c
+     *
+     * This is exact for simplices and parallelepipeds and is the initial guess for Newton's method.
+     * Construct once per element to reuse it for many points.
+     */
+    template<class T, class IDX, int ndim>
+    struct affine_inverse {
+        using Point = MATH::GEOMETRY::Point<T, ndim>;
+        using JacobianType = NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, ndim, ndim>;
+
+        /// @brief the reference domain centroid
+        Point xi_c;
+
+        /// @brief the physical location of the centroid
+        Point x_c;
+
+        /// @brief the inverse jacobian at the centroid
+        JacobianType Jinv_c;
+
+        affine_inverse(const ElementTransformation<T, IDX, ndim>& trans, std::span<Point> el_coord)
+        : xi_c{trans.centroid_ref()}, x_c{trans.transform(el_coord, xi_c)},
+          Jinv_c{safe_inverse<T, ndim>(trans.jacobian(el_coord, xi_c))} {}
+
+        /// @brief the reference point the affine part maps to x
+        auto operator()(const Point& x) const noexcept -> Point {
+            Point xi = xi_c;
+            for(int i = 0; i < ndim; ++i){
+                for(int j = 0; j < ndim; ++j) xi[i] += Jinv_c[i][j] * (x[j] - x_c[j]);
+            }
+            return xi;
+        }
+    };
+
+    /**
+     * @brief invert an element transformation at a physical point with Newton's method
+     * from the given initial guess
+     *
+     * Each step is backtracked (halved up to 8 times) until the residual decreases
+     * so curved elements do not overshoot into the folded part of the transformation.
+     * The iteration stops if xi leaves a box of 10 times the reference domain (x is not in this element)
+     * or if no step decreases the residual.
+     *
+     * @param trans the element transformation
+     * @param el_coord the element node coordinates
+     * @param x the physical point
+     * @param xi0 the initial guess
+     * @param abs_tol the tolerance on the max norm of the physical residual x - T(xi)
+     * @param max_it the maximum number of Newton iterations
+     */
+    template<class T, class IDX, int ndim>
+    inline auto newton_inverse(
+        const ElementTransformation<T, IDX, ndim>& trans,
+        std::span<MATH::GEOMETRY::Point<T, ndim>> el_coord,
+        const MATH::GEOMETRY::Point<T, ndim>& x,
+        const MATH::GEOMETRY::Point<T, ndim>& xi0,
+        T abs_tol,
+        int max_it = 20
+    ) -> inverse_map_result<T, ndim> {
+        using Point = MATH::GEOMETRY::Point<T, ndim>;
+        static constexpr int max_backtrack = 8;
+
+        auto residual = [&](const Point& xi, Point& r) -> T {
+            Point x_xi = trans.transform(el_coord, xi);
+            T rnorm = 0.0;
+            for(int idim = 0; idim < ndim; ++idim){
+                r[idim] = x[idim] - x_xi[idim];
+                rnorm = std::max(rnorm, std::abs(r[idim]));
+            }
+            return rnorm;
+        };
+
+        inverse_map_result<T, ndim> result{.xi = xi0, .residual = 0.0, .iterations = 0, .converged = false};
+        Point r;
+        result.residual = residual(result.xi, r);
+        for(; result.iterations < max_it; ++result.iterations){
+            if(result.residual <= abs_tol){
+                result.converged = true;
+                return result;
+            }
+
+            auto Jinv = safe_inverse<T, ndim>(trans.jacobian(el_coord, result.xi));
+            Point dxi;
+            for(int i = 0; i < ndim; ++i){
+                dxi[i] = 0.0;
+                for(int j = 0; j < ndim; ++j) dxi[i] += Jinv[i][j] * r[j];
+            }
+
+            // backtracking line search on the residual
+            T alpha = 1.0;
+            bool decreased = false;
+            for(int ibt = 0; ibt <= max_backtrack && !decreased; ++ibt, alpha *= 0.5){
+                Point xi_trial, r_trial;
+                for(int idim = 0; idim < ndim; ++idim) xi_trial[idim] = result.xi[idim] + alpha * dxi[idim];
+                T res_trial = residual(xi_trial, r_trial);
+                if(res_trial < result.residual){
+                    result.xi = xi_trial;
+                    r = r_trial;
+                    result.residual = res_trial;
+                    decreased = true;
+                }
+            }
+            if(!decreased) return result;
+
+            // points far outside the reference domain will not be in this element
+            for(int idim = 0; idim < ndim; ++idim){
+                if(std::abs(result.xi[idim]) > 10.0) return result;
+            }
+        }
+        result.converged = result.residual <= abs_tol;
+        return result;
+    }
+
+    namespace impl {
+        /// @brief Newton's method from the affine guess, restarting from the centroid if that does not converge
+        template<class T, class IDX, int ndim>
+        inline auto inverse_map(
+            const ElementTransformation<T, IDX, ndim>& trans,
+            std::span<MATH::GEOMETRY::Point<T, ndim>> el_coord,
+            const affine_inverse<T, IDX, ndim>& affine,
+            const MATH::GEOMETRY::Point<T, ndim>& x,
+            T abs_tol,
+            int max_it
+        ) -> inverse_map_result<T, ndim> {
+            inverse_map_result<T, ndim> result = newton_inverse(trans, el_coord, x, affine(x), abs_tol, max_it);
+            if(!result.converged){
+                inverse_map_result<T, ndim> restart = newton_inverse(trans, el_coord, x, affine.xi_c, abs_tol, max_it);
+                restart.iterations += result.iterations;
+                if(restart.converged || restart.residual < result.residual) result = restart;
+                else result.iterations = restart.iterations;
+            }
+            return result;
+        }
+    }
+
+    /**
+     * @brief invert an element transformation at a physical point
+     *
+     * Newton's method starting from the inverse of the affine part,
+     * restarting from the reference domain centroid if that does not converge
+     *
+     * @param trans the element transformation
+     * @param el_coord the element node coordinates
+     * @param x the physical point
+     * @param tol the tolerance on the physical residual relative to the element size
+     * @param max_it the maximum number of Newton iterations for each start
+     */
+    template<class T, class IDX, int ndim>
+    inline auto inverse_map(
+        const ElementTransformation<T, IDX, ndim>& trans,
+        std::span<MATH::GEOMETRY::Point<T, ndim>> el_coord,
+        const MATH::GEOMETRY::Point<T, ndim>& x,
+        T tol = 1e-10,
+        int max_it = 20
+    ) -> inverse_map_result<T, ndim> {
+        T abs_tol = tol * element_length_scale<T, ndim>(el_coord);
+        affine_inverse<T, IDX, ndim> affine{trans, el_coord};
+        return impl::inverse_map(trans, el_coord, affine, x, abs_tol, max_it);
+    }
 
+    /**
+     * @brief invert an element transformation at many physical points
+     * (i.e all the probes or transfer points that fall in one element)
+     * the element length scale and affine part are computed once for all the points
+     *
+     * @param trans the element transformation
+     * @param el_coord the element node coordinates
+     * @param x the physical points
+     * @param [out] results the inversion of each point [size = x.size()]
+     * @param tol the tolerance on the physical residual relative to the element size
+     * @param max_it the maximum number of Newton iterations for each start
+     * @return the number of points that converged
+     */
+    template<class T, class IDX, int ndim>
+    inline auto inverse_map_batch(
+        const ElementTransformation<T, IDX, ndim>& trans,
+        std::span<MATH::GEOMETRY::Point<T, ndim>> el_coord,
+        std::span<const MATH::GEOMETRY::Point<T, ndim>> x,
+        std::span<inverse_map_result<T, ndim>> results,
+        T tol = 1e-10,
+        int max_it = 20
+    ) -> std::size_t {
+        T abs_tol = tol * element_length_scale<T, ndim>(el_coord);
+        affine_inverse<T, IDX, ndim> affine{trans, el_coord};
+        std::size_t nconverged = 0;
+        for(std::size_t ipoin = 0; ipoin < x.size(); ++ipoin){
+            results[ipoin] = impl::inverse_map(trans, el_coord, affine, x[ipoin], abs_tol, max_it);
+            if(results[ipoin].converged) ++nconverged;
+        }
+        return nconverged;
+    }
 }
@@ -0,0 +1,29 @@
+/**
+ * @file instantiations.cpp
+ * @brief explicit instantiations of the common classes for the configured floating point and index types
+ * so every driver linking iceicle_core shares one compiled copy
+ * (declared extern template in the class headers when ICEICLE_EXTERN_TEMPLATES is defined)
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#include <iceicle/build_config.hpp>
+#include <iceicle/mesh/mesh.hpp>
+#include <iceicle/fespace/fespace.hpp>
+#include <iceicle/pvd_writer.hpp>
+
+namespace iceicle {
+
+    using T = build_config::T;
+    using IDX = build_config::IDX;
+
+    template class AbstractMesh<T, IDX, 1>;
+    template class AbstractMesh<T, IDX, 2>;
+    template class AbstractMesh<T, IDX, 3>;
+
+    template class FESpace<T, IDX, 1>;
+    template class FESpace<T, IDX, 2>;
+    template class FESpace<T, IDX, 3>;
+
+    // vtu output is for 2D and 3D (1D uses the DatWriter)
+    template class io::PVDWriter<T, IDX, 2>;
+    template class io::PVDWriter<T, IDX, 3>;
+}
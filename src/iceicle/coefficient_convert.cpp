@@ -0,0 +1,181 @@
+/**
+ * @brief expand the raw coefficient output of the "coefficients" writer to vtu or xdmf files offline
+ *
+ * The mesh and fespace are built from the same input deck as the run (the mesh is not partitioned)
+ * and the coefficient files of every process are loaded by global index for each output.
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/build_config.hpp"
+#include "iceicle/coefficient_writer.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fe_function/layout_right.hpp"
+#include "iceicle/fespace/fespace_lua_interface.hpp"
+#include "iceicle/mesh/mesh_lua_interface.hpp"
+#include "iceicle/program_args.hpp"
+#include "iceicle/pvd_writer.hpp"
+#include "iceicle/string_utils.hpp"
+#include "iceicle/writer.hpp"
+#ifdef ICEICLE_USE_HDF5
+#include "iceicle/xdmf_writer.hpp"
+#endif
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <sol/sol.hpp>
+#include <string>
+#include <vector>
+
+using namespace iceicle;
+using namespace iceicle::util;
+using namespace iceicle::util::program_args;
+
+using T = build_config::T;
+using IDX = build_config::IDX;
+
+/// @brief the coefficient files of each output (by time index) in the directory
+auto find_outputs(const std::filesystem::path& directory, const std::string& collection)
+-> std::map<long, std::vector<std::filesystem::path>> {
+    std::map<long, std::vector<std::filesystem::path>> outputs{};
+    std::regex file_pattern{collection + "([0-9]+)_rank[0-9]+\\.coef"};
+    for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator{directory}){
+        std::smatch match;
+        std::string filename = entry.path().filename().string();
+        if(std::regex_match(filename, match, file_pattern)) outputs[std::stol(match[1])].push_back(entry.path());
+    }
+    return outputs;
+}
+
+template <int ndim>
+void convert(sol::table script_config, cli_parser& cli_args) {
+  // the global mesh numbering of the run (before partitioning)
+  auto mesh_opt = construct_mesh_from_config<T, IDX, ndim>(script_config);
+  if (!mesh_opt) {
+    std::cerr << "Mesh construction failed..." << std::endl;
+    AnomalyLog::handle_anomalies();
+    return;
+  }
+  AbstractMesh<T, IDX, ndim> mesh = mesh_opt.value();
+  manual_mesh_management(script_config, mesh);
+  lua_reorder_mesh(script_config, mesh);
+  mesh.make_periodic_faces_interior();
+  sol::table fespace_tbl = script_config["fespace"];
+  auto fespace = lua_fespace(&mesh, fespace_tbl);
+
+  std::filesystem::path directory = cli_args["directory"]
+    ? std::filesystem::path{cli_args["directory"].as<std::string>()}
+    : std::filesystem::current_path() / "iceicle_data";
+  std::string collection = cli_args["collection"] ? cli_args["collection"].as<std::string>() : "coefficients";
+  std::string format = cli_args["format"] ? cli_args["format"].as<std::string>() : "vtu";
+  std::map<long, std::vector<std::filesystem::path>> outputs = find_outputs(directory, collection);
+  if (outputs.empty()) {
+    std::cerr << "No coefficient files " << collection << "<itime>_rank<r>.coef in " << directory << std::endl;
+    return;
+  }
+
+  // size the storage of each field group for the largest output (the basis orders may change between outputs)
+  std::vector<std::vector<std::string>> group_names{};
+  std::size_t max_ndof = 0;
+  for (const auto& [itime, paths] : outputs) {
+    std::size_t ndof = 0;
+    for (const std::filesystem::path& path : paths) {
+      io::CoefficientSnapshot<T> header = io::read_coefficient_file<T>(path, false);
+      for (std::uint64_t el_ndof : header.el_ndofs) ndof += el_ndof;
+      if (group_names.empty())
+        for (const auto& group : header.fields) group_names.push_back(group.names);
+    }
+    max_ndof = std::max(max_ndof, ndof);
+  }
+  std::vector<std::vector<T>> group_data{};
+  using layout_t = fe_layout_right<IDX, dg_dof_map<IDX>, dynamic_ncomp>;
+  std::vector<fespan<T, layout_t>> group_spans{};
+  group_data.reserve(group_names.size());
+  group_spans.reserve(group_names.size());
+  for (const std::vector<std::string>& names : group_names) {
+    group_data.emplace_back(max_ndof * names.size());
+    group_spans.emplace_back(group_data.back().data(), fespace.dg_map, (IDX) names.size());
+  }
+
+  // the output writer
+  io::Writer writer{};
+  if (eq_icase(format, "vtu")) {
+    io::PVDWriter<T, IDX, ndim> pvd_writer{};
+    pvd_writer.data_directory = directory;
+    pvd_writer.collection_name = collection;
+    pvd_writer.register_fespace(fespace);
+    for (std::size_t igroup = 0; igroup < group_spans.size(); ++igroup)
+      pvd_writer.register_fields(group_spans[igroup], group_names[igroup]);
+    writer = pvd_writer;
+  } else if (eq_icase(format, "xdmf")) {
+#ifdef ICEICLE_USE_HDF5
+    io::XDMFWriter<T, IDX, ndim> xdmf_writer{};
+    xdmf_writer.data_directory = directory;
+    xdmf_writer.collection_name = collection;
+    xdmf_writer.register_fespace(fespace);
+    for (std::size_t igroup = 0; igroup < group_spans.size(); ++igroup)
+      xdmf_writer.register_fields(group_spans[igroup], group_names[igroup]);
+    writer = xdmf_writer;
+#else
+    std::cerr << "xdmf output requires building with ICEICLE_USE_HDF5" << std::endl;
+    return;
+#endif
+  } else {
+    std::cerr << "Unrecognized format: " << format << std::endl;
+    return;
+  }
+
+  for (const auto& [itime, paths] : outputs) {
+    std::vector<io::CoefficientSnapshot<T>> pieces{};
+    for (const std::filesystem::path& path : paths) pieces.push_back(io::read_coefficient_file<T>(path));
+    if (!io::load_coefficient_snapshot(fespace, std::span<const io::CoefficientSnapshot<T>>{pieces})) break;
+    for (std::size_t igroup = 0; igroup < group_spans.size(); ++igroup)
+      io::load_coefficient_fields(fespace, std::span<const io::CoefficientSnapshot<T>>{pieces}, igroup, group_spans[igroup]);
+    if (AnomalyLog::size() > 0) break;
+    writer.write(itime, pieces.front().time);
+    std::cout << "converted output " << itime << " (" << paths.size() << " pieces)" << std::endl;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  cli_parser cli_args{argc, argv};
+  cli_args.add_options(
+      cli_flag{"help", "print the help text and quit."},
+      cli_option{"scriptfile", "The lua input deck of the run (for the mesh and fespace)",
+                 parse_type<std::string_view>{}},
+      cli_option{"directory", "The directory of the coefficient files (defaults to iceicle_data)",
+                 parse_type<std::string_view>{}},
+      cli_option{"collection", "The collection name of the coefficient files (defaults to coefficients)",
+                 parse_type<std::string_view>{}},
+      cli_option{"format", "vtu or xdmf (defaults to vtu)", parse_type<std::string_view>{}});
+  if (cli_args["help"]) {
+    cli_args.print_options(std::cout);
+    return 0;
+  }
+
+  sol::state lua_state;
+  lua_state.open_libraries(sol::lib::base);
+  lua_state.open_libraries(sol::lib::package);
+  lua_state.open_libraries(sol::lib::math);
+  sol::optional<sol::table> script_config_opt = lua_state.script_file(
+      cli_args["scriptfile"] ? cli_args["scriptfile"].as<std::string>() : std::string{"iceicle.lua"});
+  if (!script_config_opt) {
+    std::cerr << "Error loading script configuration" << std::endl;
+    return 1;
+  }
+  sol::table script_config = script_config_opt.value();
+
+  int ndim_arg = script_config["ndim"];
+  switch (ndim_arg) {
+  case 1:
+    convert<1>(script_config, cli_args);
+    break;
+  case 2:
+    convert<2>(script_config, cli_args);
+    break;
+  }
+  AnomalyLog::handle_anomalies();
+  return 0;
+}
@@ -4,29 +4,25 @@
  * @author Gianni Absillis (gabsill@ncsu.edu)
  */
 
-#include "iceicle/disc/conservation_law.hpp"
+#include "conservation_law_driver.hpp"
 #include "iceicle/anomaly_log.hpp"
-#include "iceicle/dat_writer.hpp"
-#include "iceicle/disc/bc_lua_interface.hpp"
-#include "iceicle/disc/burgers.hpp"
-#include "iceicle/disc/navier_stokes.hpp"
 #include "iceicle/fespace/fespace_lua_interface.hpp"
-#include "iceicle/geometry/face.hpp"
 #include "iceicle/iceicle_mpi_utils.hpp"
-#include "iceicle/initialization.hpp"
+#include "iceicle/lua_utils.hpp"
 #include "iceicle/mesh/mesh_lua_interface.hpp"
+#include "iceicle/mesh/mesh_partition.hpp"
+#include "iceicle/mesh/mesh_utils.hpp"
+#include "iceicle/profiler.hpp"
 #include "iceicle/program_args.hpp"
-#include "iceicle/pvd_writer.hpp"
-#include "iceicle/solvers_lua_interface.hpp"
 #include "iceicle/string_utils.hpp"
-#include "iceicle/mesh/mesh_partition.hpp"
-// #include "iceicle/disc/ns_lua_interface.hpp"
 #include <sol/table.hpp>
 #ifdef ICEICLE_USE_PETSC
 #elifdef ICEICLE_USE_MPI
 #include "mpi.h"
 #endif
 #include <fenv.h>
+#include <filesystem>
+#include <fmt/format.h>
 #include <sol/sol.hpp>
 
 // using declarations
@@ -73,219 +69,26 @@ public:
   }
 };
 
-template <class T, class IDX, int ndim, class pflux, class cflux, class dflux>
-void initialize_and_solve(
-    sol::table config_tbl, FESpace<T, IDX, ndim> &fespace,
-    ConservationLawDDG<T, ndim, pflux, cflux, dflux> &conservation_law) {
-
-  // ==============================
-  // = Set Discretization Options =
-  // ==============================
-    sol::table cons_law_tbl = config_tbl["conservation_law"];
-    // discretization options
-    conservation_law.sigma_ic = cons_law_tbl.get_or("sigma_ic", conservation_law.sigma_ic);
-    conservation_law.interior_penalty = cons_law_tbl.get_or("interior_penalty", conservation_law.interior_penalty);
-
-  // ==================================
-  // = Initialize the solution vector =
-  // ==================================
-  constexpr int neq =
-      std::remove_reference_t<decltype(conservation_law)>::nv_comp;
-  fe_layout_right u_layout{fespace.dg_map, to_size<neq>{}};
-  std::vector<T> u_data(u_layout.size());
-  fespan u{u_data.data(), u_layout};
-  initialize_solution_lua(config_tbl, fespace, u);
-
-  // ===============================
-  // = Output the Initial Solution =
-  // ===============================
-  if constexpr(ndim == 1){
-    io::DatWriter<T, IDX, ndim> dat_writer{fespace};
-    dat_writer.register_fields(u, conservation_law.field_names);
-    dat_writer.collection_name = "initial_condition";
-    dat_writer.write_dat(0, 0.0);
-  }
-  if constexpr (ndim == 2 || ndim == 3) {
-    io::PVDWriter<T, IDX, ndim> pvd_writer{};
-    pvd_writer.register_fespace(fespace);
-    pvd_writer.register_fields(u, conservation_law.field_names);
-    pvd_writer.collection_name = "initial_condition";
-    pvd_writer.write_vtu(0, 0.0);
-  }
-
-  // ==================================
-  // = Set up the Boundary Conditions =
-  // ==================================
-  sol::optional<sol::table> bc_desc_opt = config_tbl["boundary_conditions"];
-  if (bc_desc_opt) {
-    sol::table bc_tbl = bc_desc_opt.value();
-    add_dirichlet_callbacks(conservation_law, bc_tbl);
-    add_neumann_callbacks(conservation_law, bc_tbl);
-  }
-
-  // ========================
-  // = Add User Source Term =
-  // ========================
-  solvers::add_source_term_callback(conservation_law, config_tbl);
-
-  // =========
-  // = Solve =
-  // =========
-  sol::optional<sol::table> mdg_tbl = config_tbl["mdg"];
-  IDX ncycles = (mdg_tbl) ? mdg_tbl.value().get_or("ncycles", 1) : 1;
-  for (IDX icycle = 0; icycle < ncycles; ++icycle) {
-
-    mpi::execute_on_rank(0, [&] {
-      std::cout << "==============" << std::endl;
-      std::cout << "Cycle: " << icycle << std::endl;
-      std::cout << "==============" << std::endl;
-    });
-    auto geo_map = solvers::lua_select_mdg_geometry(
-        config_tbl, fespace, conservation_law, icycle, u);
-    solvers::lua_solve(config_tbl, fespace, geo_map, conservation_law, u);
-  }
-
-  // ============================
-  // = Post-Processing/Analysis =
-  // ============================
-  solvers::lua_error_analysis(config_tbl, fespace, conservation_law, u);
-}
-
+/// @brief set up the discretization given by the conservation_law table of the config and solve it
+/// the conservation laws are compiled in separate translation units (see conservation_law_driver.hpp)
 template <int ndim>
-[[gnu::noinline]]
-void setup(sol::table script_config, cli_parser cli_args) {
-  // ==============
-  // = Setup Mesh =
-  // ==============
-  auto mesh_opt = construct_mesh_from_config<T, IDX, ndim>(script_config);
-  if (!mesh_opt){
-    std::cerr << "Mesh construction failed..." << std::endl;
-    AnomalyLog::handle_anomalies();
-    return; // exit if we have no valid mesh
-  }
-  AbstractMesh<T, IDX, ndim> mesh = mesh_opt.value();
-  std::vector<IDX> invalid_faces;
-  if (!validate_normals(mesh, invalid_faces)) {
-    std::cout << "invalid normals on the following faces: ";
-    for (IDX ifac : invalid_faces)
-      std::cout << ifac << ", ";
-    std::cout << "\n";
-    return;
-  }
-  perturb_mesh(script_config, mesh);
-  manual_mesh_management(script_config, mesh);
-
-  AbstractMesh<T, IDX, ndim> pmesh{partition_mesh(mesh)};
-
-  if(AnomalyLog::size() > 0){
-    std::cerr << "Errors from setting up mesh: ";
-    AnomalyLog::handle_anomalies(std::cerr);
-    return;
-  }
-
-  if (cli_args["debug1"]) {
-    // linear advection a = [0.2, 0];
-    // 2 element mesh on [0, 1]^2
-    pmesh.coord[7][0] = 0.7;
-    pmesh.coord[4][0] = 0.55;
-  }
-  if (cli_args["debug2"]) {
-    pmesh.coord[4][0] = 0.69;
-  }
-
-  // ===================================
-  // = create the finite element space =
-  // ===================================
-  sol::table fespace_tbl = script_config["fespace"];
-  auto fespace = lua_fespace(&pmesh, fespace_tbl);
-  fespace.print_info(std::cout);
-
-  // ============================
-  // = Setup the Discretization =
-  // ============================
+void solve_case(sol::table script_config, FESpace<T, IDX, ndim> &fespace) {
   if (script_config["conservation_law"].valid()) {
     sol::table cons_law_tbl = script_config["conservation_law"];
+    std::string name = cons_law_tbl["name"].get<std::string>();
+    if (driver::case_solver<ndim> solver = driver::find_case<ndim>(name)) {
+      solver(script_config, fespace);
+    } else {
+      AnomalyLog::log_anomaly(
+          Anomaly{"No such conservation_law implemented",
+                  text_not_found_tag{name}});
+    }
+  } else {
+    std::cout << "No conservation_law table specified: exiting...";
+  }
+}
 
-    if (eq_icase(cons_law_tbl["name"].get<std::string>(), "burgers")) {
-
-      // get the coefficients for burgers equation
-      BurgersCoefficients<T, ndim> burgers_coeffs{};
-      sol::optional<T> mu_input = cons_law_tbl["mu"];
-      if (mu_input)
-        burgers_coeffs.mu = mu_input.value();
-
-      // WARNING: for some reason in release mode
-      // if we create these tables from cons_law_tbl
-      // the second one won't read properly
-      sol::optional<sol::table> b_adv_input =
-          script_config["conservation_law"]["b_adv"];
-      sol::optional<sol::table> a_adv_input =
-          script_config["conservation_law"]["a_adv"];
-      if (a_adv_input.has_value()) {
-        for (int idim = 0; idim < ndim; ++idim)
-          burgers_coeffs.a[idim] =
-              script_config["conservation_law"]["a_adv"][idim + 1];
-      }
-      if (b_adv_input.has_value()) {
-        for (int idim = 0; idim < ndim; ++idim)
-          burgers_coeffs.b[idim] =
-              script_config["conservation_law"]["b_adv"][idim + 1];
-      }
-
-      std::cout << burgers_coeffs.mu 
-                << " " << burgers_coeffs.a[0] 
-                << " " << burgers_coeffs.b[0] 
-            << std::endl;
-      // create the discretization
-      BurgersFlux physical_flux{burgers_coeffs};
-      BurgersUpwind convective_flux{burgers_coeffs};
-      BurgersDiffusionFlux diffusive_flux{burgers_coeffs};
-      ConservationLawDDG disc{std::move(physical_flux),
-                              std::move(convective_flux),
-                              std::move(diffusive_flux)};
-      disc.field_names = std::vector<std::string>{"u"};
-      disc.residual_names = std::vector<std::string>{"residual"};
-
-      initialize_and_solve(script_config, fespace, disc);
-
-    } else if (eq_icase(cons_law_tbl["name"].get<std::string>(),
-                        "spacetime-burgers")) {
-      static constexpr int ndim_space = ndim - 1;
-      // get the coefficients for burgers equation
-      BurgersCoefficients<T, ndim_space> burgers_coeffs{};
-      sol::optional<T> mu_input = cons_law_tbl["mu"];
-      if (mu_input)
-        burgers_coeffs.mu = mu_input.value();
-
-      sol::optional<sol::table> b_adv_input =
-          script_config["conservation_law"]["b_adv"];
-      sol::optional<sol::table> a_adv_input =
-          script_config["conservation_law"]["a_adv"];
-      if (a_adv_input.has_value()) {
-        for (int idim = 0; idim < ndim_space; ++idim)
-          burgers_coeffs.a[idim] =
-              script_config["conservation_law"]["a_adv"][idim + 1];
-      }
-      if (b_adv_input.has_value()) {
-        for (int idim = 0; idim < ndim_space; ++idim)
-          burgers_coeffs.b[idim] =
-              script_config["conservation_law"]["b_adv"][idim + 1];
-      }
-      std::cout << burgers_coeffs.b[0] << std::endl;
-
-      // create the discretization
-      SpacetimeBurgersFlux physical_flux{burgers_coeffs};
-      SpacetimeBurgersUpwind convective_flux{burgers_coeffs};
-      SpacetimeBurgersDiffusion diffusive_flux{burgers_coeffs};
-      ConservationLawDDG disc{std::move(physical_flux),
-                              std::move(convective_flux),
-                              std::move(diffusive_flux)};
-      disc.field_names = std::vector<std::string>{"u"};
-      disc.residual_names = std::vector<std::string>{"residual"};
-      initialize_and_solve(script_config, fespace, disc);
-
-    } else if (eq_icase_any(cons_law_tbl["name"].get<std::string>(),
-                            "navier-stokes", "euler")) {
+// TODO: register navier-stokes and euler in their own translation unit
 //      using namespace navier_stokes;
 //      using namespace util;
 //
@@ -344,25 +147,133 @@ void setup(sol::table script_config, cli_parser cli_args) {
 //        navier_stokes::Flux<T, ndim> physical_flux{physics};
 //        fcn(physical_flux);
 //      }
+
+template <int ndim>
+[[gnu::noinline]]
+void setup(sol::table script_config, cli_parser cli_args) {
+  // ==============
+  // = Setup Mesh =
+  // ==============
+  AbstractMesh<T, IDX, ndim> pmesh{};
+  if (auto native_mesh = lua_read_native_mesh<T, IDX, ndim>(script_config)) {
+    // restart from the already partitioned mesh
+    pmesh = native_mesh.value();
+  } else {
+    auto mesh_opt = construct_mesh_from_config<T, IDX, ndim>(script_config);
+    if (!mesh_opt){
+      std::cerr << "Mesh construction failed..." << std::endl;
+      AnomalyLog::handle_anomalies();
+      return; // exit if we have no valid mesh
+    }
+    AbstractMesh<T, IDX, ndim> mesh = mesh_opt.value();
+    std::vector<IDX> invalid_faces;
+    if (!validate_normals(mesh, invalid_faces)) {
+      std::cout << "invalid normals on the following faces: ";
+      for (IDX ifac : invalid_faces)
+        std::cout << ifac << ", ";
+      std::cout << "\n";
+      return;
+    }
+    perturb_mesh(script_config, mesh);
+    manual_mesh_management(script_config, mesh);
+
+    // the time parallel driver solves the full mesh on every process
+    sol::optional<sol::table> parareal_opt = script_config["solver"]["parareal"];
+    if (lua_mesh_is_distributed(script_config)) {
+      // each process generated its own block of the mesh
+      if (parareal_opt)
+        AnomalyLog::log_anomaly("uniform_mesh.distributed is not supported by the parareal solver");
+      pmesh = std::move(mesh);
     } else {
-      AnomalyLog::log_anomaly(
-          Anomaly{"No such conservation_law implemented",
-                  text_not_found_tag{cons_law_tbl["name"].get<std::string>()}});
+      lua_reorder_mesh(script_config, mesh);
+      if (parareal_opt)
+        pmesh = replicate_mesh(mesh);
+      else
+        pmesh = partition_mesh(mesh, lua_partition_weights(script_config, mesh));
     }
+    if (AnomalyLog::size() == 0)
+      lua_write_native_mesh(script_config, pmesh);
+  }
 
-  } else {
-    std::cout << "No conservation_law table specified: exiting...";
+  if(AnomalyLog::size() > 0){
+    std::cerr << "Errors from setting up mesh: ";
+    AnomalyLog::handle_anomalies(std::cerr);
+    return;
+  }
+
+  if (cli_args["debug1"]) {
+    // linear advection a = [0.2, 0];
+    // 2 element mesh on [0, 1]^2
+    pmesh.coord[7][0] = 0.7;
+    pmesh.coord[4][0] = 0.55;
+  }
+  if (cli_args["debug2"]) {
+    pmesh.coord[4][0] = 0.69;
+  }
+
+  // join the periodic boundaries so they are treated as interior traces
+  pmesh.make_periodic_faces_interior();
+
+  // ===================================
+  // = create the finite element space =
+  // ===================================
+  sol::table fespace_tbl = script_config["fespace"];
+  auto fespace = lua_fespace(&pmesh, fespace_tbl);
+  fespace.print_info(std::cout);
+
+  // ==================================
+  // = Solve every case of the ensemble =
+  // ==================================
+  // the mesh and fespace are shared, so the node coordinates (moved by MDG)
+  // and element orders (changed by p-adaptation) are reset for each case
+  std::vector<sol::table> cases = lua_ensemble_cases(script_config);
+  bool ensemble = script_config["ensemble"].valid();
+  NodeArray<T, ndim> coord_initial = pmesh.coord;
+  std::vector<int> orders_initial(fespace.elements.size());
+  for (const FiniteElement<T, IDX, ndim> &el : fespace.elements)
+    orders_initial[el.elidx] = el.basis->getPolynomialOrder();
+  const std::filesystem::path base_directory = std::filesystem::current_path();
+
+  for (std::size_t icase = 0; icase < cases.size(); ++icase) {
+    sol::table case_config = cases[icase];
+    if (ensemble) {
+      if (icase > 0) {
+        pmesh.coord = coord_initial;
+        pmesh.update_coord_els();
+        fespace.set_element_orders(orders_initial);
+      }
+
+      // each case writes to its own directory
+      std::filesystem::path case_directory = base_directory /
+          case_config.get_or("output_directory", fmt::format("case_{}", icase + 1));
+      std::filesystem::create_directories(case_directory);
+      std::filesystem::current_path(case_directory);
+      mpi::execute_on_rank(0, [&] {
+        std::cout << "======================" << std::endl;
+        std::cout << "Ensemble case: " << icase + 1 << " / " << cases.size() << std::endl;
+        std::cout << "Output: " << case_directory.string() << std::endl;
+        std::cout << "======================" << std::endl;
+      });
+    }
+
+    solve_case<ndim>(case_config, fespace);
+
+    // report the anomalies of this case and continue with the next
+    if (ensemble) {
+      AnomalyLog::handle_anomalies();
+      std::filesystem::current_path(base_directory);
+    }
   }
 }
 
 int main(int argc, char *argv[]) {
 
   // Initialize
+  // MPI is initialized first (funneled for threads within each rank)
+  // so that PETSc uses this initialization
+  mpi::init_funneled(&argc, &argv);
 #ifdef ICEICLE_USE_PETSC
   PetscInitialize(&argc, &argv, nullptr, nullptr);
-#elifdef ICEICLE_USE_MPI
-  /* Initialize MPI */
-  MPI_Init(&argc, &argv);
 #endif
 
   // ===============================
@@ -376,6 +287,7 @@ int main(int argc, char *argv[]) {
                "enable floating point exceptions (ignoring FE_INEXACT)"},
       cli_option{"scriptfile", "The file name for the lua script to run",
                  parse_type<std::string_view>{}},
+      cli_flag{"profile", "time the solver regions and print a summary at exit"},
       cli_flag{"debug1", "internal debug flag"},
       cli_flag{"debug2", "internal debug flag"});
   if (cli_args["help"]) {
@@ -415,6 +327,10 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
+  // region profiling
+  std::string profile_filename =
+      lua_setup_profiler(script_config, cli_args["profile"]);
+
   //    // template specialization: ndim
   int ndim_arg = script_config["ndim"];
   std::cout << "ndim: " << ndim_arg << std::endl;
@@ -433,11 +349,12 @@ int main(int argc, char *argv[]) {
   //        ndim_arg,
   //        ndim_func);
 
-#ifdef ICEICLE_USE_PETSC
   // cleanup
+  Profiler::report(std::cout, profile_filename);
+#ifdef ICEICLE_USE_PETSC
   PetscFinalize();
-#elifdef ICEICLE_USE_MPI
-  // cleanup
+#endif
+#ifdef ICEICLE_USE_MPI
   MPI_Finalize();
 #endif
   AnomalyLog::handle_anomalies();
@@ -0,0 +1,96 @@
+/**
+ * @brief the burgers equation for the conservation law miniapp
+ * (see conservation_law_driver.hpp)
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+
+#include "conservation_law_driver.hpp"
+#include "iceicle/disc/burgers.hpp"
+#include <iostream>
+
+using namespace iceicle;
+
+using T = build_config::T;
+using IDX = build_config::IDX;
+
+namespace {
+
+/// @brief read the burgers coefficients from the conservation_law table
+template <int ndim_space>
+auto parse_burgers_coefficients(sol::table script_config)
+    -> BurgersCoefficients<T, ndim_space> {
+  sol::table cons_law_tbl = script_config["conservation_law"];
+  BurgersCoefficients<T, ndim_space> burgers_coeffs{};
+  sol::optional<T> mu_input = cons_law_tbl["mu"];
+  if (mu_input)
+    burgers_coeffs.mu = mu_input.value();
+
+  // WARNING: for some reason in release mode
+  // if we create these tables from cons_law_tbl
+  // the second one won't read properly
+  sol::optional<sol::table> b_adv_input =
+      script_config["conservation_law"]["b_adv"];
+  sol::optional<sol::table> a_adv_input =
+      script_config["conservation_law"]["a_adv"];
+  if (a_adv_input.has_value()) {
+    for (int idim = 0; idim < ndim_space; ++idim)
+      burgers_coeffs.a[idim] =
+          script_config["conservation_law"]["a_adv"][idim + 1];
+  }
+  if (b_adv_input.has_value()) {
+    for (int idim = 0; idim < ndim_space; ++idim)
+      burgers_coeffs.b[idim] =
+          script_config["conservation_law"]["b_adv"][idim + 1];
+  }
+  return burgers_coeffs;
+}
+
+template <int ndim>
+void solve_burgers(sol::table script_config, FESpace<T, IDX, ndim> &fespace) {
+  BurgersCoefficients<T, ndim> burgers_coeffs =
+      parse_burgers_coefficients<ndim>(script_config);
+  std::cout << burgers_coeffs.mu 
+            << " " << burgers_coeffs.a[0] 
+            << " " << burgers_coeffs.b[0] 
+        << std::endl;
+
+  // create the discretization
+  BurgersFlux physical_flux{burgers_coeffs};
+  BurgersUpwind convective_flux{burgers_coeffs};
+  BurgersDiffusionFlux diffusive_flux{burgers_coeffs};
+  ConservationLawDDG disc{std::move(physical_flux),
+                          std::move(convective_flux),
+                          std::move(diffusive_flux)};
+  disc.field_names = std::vector<std::string>{"u"};
+  disc.residual_names = std::vector<std::string>{"residual"};
+
+  driver::initialize_and_solve(script_config, fespace, disc);
+}
+
+template <int ndim>
+void solve_spacetime_burgers(sol::table script_config, FESpace<T, IDX, ndim> &fespace) {
+  static constexpr int ndim_space = ndim - 1;
+  BurgersCoefficients<T, ndim_space> burgers_coeffs =
+      parse_burgers_coefficients<ndim_space>(script_config);
+  std::cout << burgers_coeffs.b[0] << std::endl;
+
+  // create the discretization
+  SpacetimeBurgersFlux physical_flux{burgers_coeffs};
+  SpacetimeBurgersUpwind convective_flux{burgers_coeffs};
+  SpacetimeBurgersDiffusion diffusive_flux{burgers_coeffs};
+  ConservationLawDDG disc{std::move(physical_flux),
+                          std::move(convective_flux),
+                          std::move(diffusive_flux)};
+  disc.field_names = std::vector<std::string>{"u"};
+  disc.residual_names = std::vector<std::string>{"residual"};
+  driver::initialize_and_solve(script_config, fespace, disc);
+}
+
+driver::register_case<1> burgers_1d{"burgers", solve_burgers<1>};
+driver::register_case<2> burgers_2d{"burgers", solve_burgers<2>};
+
+// spacetime requires at least one spatial dimension
+driver::register_case<2> spacetime_burgers_2d{"spacetime-burgers", solve_spacetime_burgers<2>};
+
+} // namespace
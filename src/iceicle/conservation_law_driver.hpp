@@ -0,0 +1,176 @@
+/**
+ * @brief the driver shared by the translation units of the conservation law miniapp
+ *
+ * Each conservation law is compiled in its own translation unit
+ * and registers the function that sets up and solves it for each dimensionality.
+ * The main translation unit only compiles mesh and fespace setup
+ * and selects the conservation law from the registry at runtime,
+ * so the expensive solver instantiations build in parallel
+ * and editing one conservation law only rebuilds that translation unit.
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/build_config.hpp"
+#include "iceicle/dat_writer.hpp"
+#include "iceicle/disc/bc_lua_interface.hpp"
+#include "iceicle/disc/conservation_law.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/initialization.hpp"
+#include "iceicle/pvd_writer.hpp"
+#include "iceicle/solvers_lua_interface.hpp"
+#include "iceicle/string_utils.hpp"
+#include "iceicle/thread_utils.hpp"
+#include "iceicle/tmp_utils.hpp"
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <sol/sol.hpp>
+#include <string>
+
+namespace iceicle::driver {
+
+/// @brief sets up and solves a conservation law given the config on the fespace
+template <int ndim>
+using case_solver = void (*)(sol::table, FESpace<build_config::T, build_config::IDX, ndim> &);
+
+/// @brief the conservation laws available for each dimensionality
+/// in lower case (see eq_icase)
+template <int ndim>
+auto case_registry() -> std::map<std::string, case_solver<ndim>> & {
+  static std::map<std::string, case_solver<ndim>> registry{};
+  return registry;
+}
+
+/// @brief register a conservation law during static initialization
+/// usage: at namespace scope in the conservation law translation unit
+/// static driver::register_case<2> reg{"burgers", solve_burgers<2>};
+template <int ndim>
+struct register_case {
+  register_case(std::string name, case_solver<ndim> solver) {
+    std::ranges::transform(name, name.begin(), [](unsigned char c) { return std::tolower(c); });
+    case_registry<ndim>()[name] = solver;
+  }
+};
+
+/// @brief find the conservation law with the given name (case insensitive)
+/// @return the solver or nullptr if it is not registered for this dimensionality
+template <int ndim>
+auto find_case(std::string name) -> case_solver<ndim> {
+  std::ranges::transform(name, name.begin(), [](unsigned char c) { return std::tolower(c); });
+  auto &registry = case_registry<ndim>();
+  auto it = registry.find(name);
+  return (it == registry.end()) ? nullptr : it->second;
+}
+
+/// @brief set the discretization options, initialize the solution, and solve
+/// following the config
+template <class T, class IDX, int ndim, class pflux, class cflux, class dflux>
+void initialize_and_solve(
+    sol::table config_tbl, FESpace<T, IDX, ndim> &fespace,
+    ConservationLawDDG<T, ndim, pflux, cflux, dflux> &conservation_law) {
+
+  // ==============================
+  // = Set Discretization Options =
+  // ==============================
+    sol::table cons_law_tbl = config_tbl["conservation_law"];
+    // discretization options
+    conservation_law.sigma_ic = cons_law_tbl.get_or("sigma_ic", conservation_law.sigma_ic);
+    conservation_law.interior_penalty = cons_law_tbl.get_or("interior_penalty", conservation_law.interior_penalty);
+    conservation_law.flux_differencing = cons_law_tbl.get_or("flux_differencing", conservation_law.flux_differencing);
+    if constexpr (!two_point_physical_flux<pflux>) {
+      if(conservation_law.flux_differencing)
+        util::AnomalyLog::log_anomaly(util::Anomaly{"flux_differencing requires a physical flux with a two point flux",
+            util::general_anomaly_tag{}});
+    }
+    sol::optional<sol::table> av_opt = cons_law_tbl["artificial_viscosity"];
+    if(av_opt){
+      sol::table av_tbl = av_opt.value();
+      auto& av = conservation_law.artificial_viscosity;
+      av.eps0 = av_tbl.get_or("eps0", av.eps0);
+      av.kappa = av_tbl.get_or("kappa", av.kappa);
+      av.s0_offset = av_tbl.get_or("s0_offset", av.s0_offset);
+      av.sensor_component = av_tbl.get_or("component", av.sensor_component);
+    }
+
+  // ==================================
+  // = Initialize the solution vector =
+  // ==================================
+  constexpr int neq =
+      std::remove_reference_t<decltype(conservation_law)>::nv_comp;
+  fe_layout_right u_layout{fespace.dg_map, tmp::to_size<neq>{}};
+  util::first_touch_vector<T> u_data(u_layout.size());
+  fespan u{u_data.data(), u_layout};
+  initialize_solution_lua(config_tbl, fespace, u);
+
+  // ===============================
+  // = Output the Initial Solution =
+  // ===============================
+  if constexpr(ndim == 1){
+    io::DatWriter<T, IDX, ndim> dat_writer{fespace};
+    dat_writer.register_fields(u, conservation_law.field_names);
+    dat_writer.collection_name = "initial_condition";
+    dat_writer.write_dat(0, 0.0);
+  }
+  if constexpr (ndim == 2 || ndim == 3) {
+    io::PVDWriter<T, IDX, ndim> pvd_writer{};
+    pvd_writer.register_fespace(fespace);
+    pvd_writer.register_fields(u, conservation_law.field_names);
+    pvd_writer.collection_name = "initial_condition";
+    pvd_writer.write_vtu(0, 0.0);
+  }
+
+  // ==================================
+  // = Set up the Boundary Conditions =
+  // ==================================
+  sol::optional<sol::table> bc_desc_opt = config_tbl["boundary_conditions"];
+  if (bc_desc_opt) {
+    sol::table bc_tbl = bc_desc_opt.value();
+    add_dirichlet_callbacks(conservation_law, bc_tbl);
+    add_neumann_callbacks(conservation_law, bc_tbl);
+  }
+
+  // ========================
+  // = Add User Source Term =
+  // ========================
+  solvers::add_source_term_callback(conservation_law, config_tbl);
+  if (cons_law_tbl.get_or("tabulate_callbacks", false))
+    conservation_law.tabulate_callbacks(fespace);
+
+  // =========
+  // = Solve =
+  // =========
+  sol::optional<sol::table> mdg_tbl = config_tbl["mdg"];
+  IDX ncycles = (mdg_tbl) ? mdg_tbl.value().get_or("ncycles", 1) : 1;
+  ncycles = std::max(ncycles, (IDX) solvers::lua_p_adapt_ncycles(config_tbl));
+  for (IDX icycle = 0; icycle < ncycles; ++icycle) {
+
+    mpi::execute_on_rank(0, [&] {
+      std::cout << "==============" << std::endl;
+      std::cout << "Cycle: " << icycle << std::endl;
+      std::cout << "==============" << std::endl;
+    });
+    // the layout follows the dg_map of the space but p-adaptation reallocates the data
+    fespan u_cycle{u_data.data(), u_layout};
+    auto geo_map = solvers::lua_select_mdg_geometry(
+        config_tbl, fespace, conservation_law, icycle, u_cycle);
+    solvers::lua_solve(config_tbl, fespace, geo_map, conservation_law, u_cycle);
+
+    if (icycle < ncycles - 1) {
+      solvers::lua_p_adapt(config_tbl, fespace, conservation_law, u_data);
+      if (cons_law_tbl.get_or("tabulate_callbacks", false))
+        conservation_law.tabulate_callbacks(fespace);
+    }
+  }
+
+  // ============================
+  // = Post-Processing/Analysis =
+  // ============================
+  fespan u_final{u_data.data(), u_layout};
+  solvers::lua_error_analysis(config_tbl, fespace, conservation_law, u_final);
+}
+
+} // namespace iceicle::driver
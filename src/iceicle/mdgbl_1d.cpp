@@ -159,6 +159,7 @@ int main(int argc, char *argv[]){
             PetscNewton solver{fespace, disc, conv_criteria};
             solver.ivis = 1;
             io::DatWriter<T, IDX, ndim> writer{fespace};
+            writer.append = true; // one file per field set for the whole solve
             writer.register_fields(u, "u");
             solver.vis_callback = [&](IDX k, Vec res_data, Vec du_data){
                 T res_norm;
@@ -1,5 +1,7 @@
 #include <iceicle/mesh/mesh.hpp>
 #include <iceicle/pvd_writer.hpp>
+#include <iceicle/extraction_writer.hpp>
+#include <iceicle/shared_memory_ring.hpp>
 #include <iceicle/fe_function/opengl_fe_function_utils.hpp>
 #include <iceicle/opengl_utils.hpp>
 #include <iceicle/geometry/face_utils.hpp>
@@ -18,6 +20,8 @@
 #include "imgui_impl_opengl3.h"
 
 #include <iostream>
+#include <limits>
+#include <optional>
 #include <random>
 
 using namespace glm;
@@ -101,9 +105,18 @@ int main(int argc, char**argv){
     ShapeDrawer<ArrowGenerated> normal_drawer{};
     BufferedShapeDrawer<Curve> face_drawer{};
 
+    // ===================================
+    // = Live monitoring of a simulation =
+    // ===================================
+    // attaches to the shared memory ring of an output writer = "live" (see LiveWriter)
+    char live_name[256] = "/iceicle_live";
+    std::optional<util::shared_memory_ring> live_ring{};
+    std::optional<io::live_frame> live_frame{};
+    std::vector<std::byte> live_bytes{};
+    BufferedShapeDrawer<Curve> live_drawer{};
+
     // ================
     // = FrameBuffers =
-    // ================
     FrameBuffer fbo1(800, 600);
 
     while(!glfwWindowShouldClose(window)){
@@ -230,6 +243,68 @@ int main(int argc, char**argv){
             ImGui::End();
         }
 
+        { // live monitoring 
+            ImGui::Begin("Live Monitor");
+            ImGui::InputText("shared memory name", live_name, sizeof(live_name));
+            if (ImGui::Button(live_ring ? "Detach" : "Attach")){
+                if(live_ring) live_ring.reset();
+                else live_ring = util::shared_memory_ring::attach(live_name);
+                live_frame.reset();
+            }
+
+            // the writer closes the ring when it finishes or recreates it for larger frames
+            if(live_ring && live_ring->closed())
+                live_ring = util::shared_memory_ring::attach(live_name);
+
+            if(live_ring && live_ring->read_latest(live_bytes)){
+                live_frame = io::decode_live_frame(live_bytes);
+                if(live_frame){
+                    // outline every cell through its corner points
+                    live_drawer.clear();
+                    glm::vec3 xmin_live{std::numeric_limits<float>::max()}, xmax_live{std::numeric_limits<float>::lowest()};
+                    std::uint32_t start = 0;
+                    for(std::size_t icell = 0; icell < live_frame->types.size(); ++icell){
+                        int ncorner = 0;
+                        switch(live_frame->types[icell]){
+                            case 5: case 22: ncorner = 3; break; // triangles
+                            case 9: case 23: case 28: ncorner = 4; break; // quadrilaterals
+                            default: break;
+                        }
+                        Curve outline{};
+                        for(int icorner = 0; icorner <= ncorner && ncorner > 0; ++icorner){
+                            const float* x = live_frame->points.data() + 3 * (start + icorner % ncorner);
+                            outline.pts.emplace_back(x[0], x[1], x[2]);
+                            xmin_live = glm::min(xmin_live, outline.pts.back());
+                            xmax_live = glm::max(xmax_live, outline.pts.back());
+                        }
+                        if(ncorner > 0) live_drawer.add_shape(outline);
+                        start = live_frame->offsets[icell];
+                    }
+                    live_drawer.shader.load();
+                    live_drawer.shader.set3Float("xmin", xmin_live);
+                    live_drawer.shader.set3Float("xmax", xmax_live);
+                    live_drawer.update();
+                }
+            }
+
+            if(live_frame){
+                ImGui::Text("itime = %d, time = %g", live_frame->itime, live_frame->time);
+                ImGui::Text("%zu cells, %zu points", live_frame->types.size(), live_frame->npoin());
+                for(std::size_t ifield = 0; ifield < live_frame->nfield(); ++ifield){
+                    float vmin = std::numeric_limits<float>::max(), vmax = std::numeric_limits<float>::lowest();
+                    for(std::size_t ipoin = 0; ipoin < live_frame->npoin(); ++ipoin){
+                        float v = live_frame->values[ipoin * live_frame->nfield() + ifield];
+                        vmin = std::min(vmin, v);
+                        vmax = std::max(vmax, v);
+                    }
+                    ImGui::Text("%s: [%g, %g]", live_frame->names[ifield].c_str(), vmin, vmax);
+                }
+            } else if(live_ring) {
+                ImGui::Text("waiting for frames...");
+            }
+            ImGui::End();
+        }
+
         // Draw our Mesh
         {
             ImGui::Begin("Mesh View");
@@ -253,6 +328,8 @@ int main(int argc, char**argv){
 
             if(mesh && draw_normals) normal_drawer.draw();
 
+            if(live_frame) live_drawer.draw();
+
             fbo1.unbind();
 
             ImGui::Image((ImTextureID) fbo1.texture, wSize, 
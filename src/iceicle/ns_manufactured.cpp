@@ -201,25 +201,42 @@ int main(int argc, char *argv[]) {
   // ==============
   // = Setup Mesh =
   // ==============
-  auto mesh_opt = construct_mesh_from_config<T, IDX, ndim>(script_config);
-  if (!mesh_opt) {
-    std::cerr << "Mesh construction failed..." << std::endl;
-    AnomalyLog::handle_anomalies();
-    return 1; // exit if we have no valid mesh
-  }
-  AbstractMesh<T, IDX, ndim> mesh = mesh_opt.value();
-  std::vector<IDX> invalid_faces;
-  if (!validate_normals(mesh, invalid_faces)) {
-    std::cout << "invalid normals on the following faces: ";
-    for (IDX ifac : invalid_faces)
-      std::cout << ifac << ", ";
-    std::cout << "\n";
-    return 1;
+  AbstractMesh<T, IDX, ndim> pmesh{};
+  if (auto native_mesh = lua_read_native_mesh<T, IDX, ndim>(script_config)) {
+    // restart from the already partitioned mesh
+    pmesh = native_mesh.value();
+  } else {
+    auto mesh_opt = construct_mesh_from_config<T, IDX, ndim>(script_config);
+    if (!mesh_opt) {
+      std::cerr << "Mesh construction failed..." << std::endl;
+      AnomalyLog::handle_anomalies();
+      return 1; // exit if we have no valid mesh
+    }
+    AbstractMesh<T, IDX, ndim> mesh = mesh_opt.value();
+    std::vector<IDX> invalid_faces;
+    if (!validate_normals(mesh, invalid_faces)) {
+      std::cout << "invalid normals on the following faces: ";
+      for (IDX ifac : invalid_faces)
+        std::cout << ifac << ", ";
+      std::cout << "\n";
+      return 1;
+    }
+    perturb_mesh(script_config, mesh);
+    manual_mesh_management(script_config, mesh);
+
+    if (lua_mesh_is_distributed(script_config)) {
+      // each process generated its own block of the mesh
+      pmesh = std::move(mesh);
+    } else {
+      lua_reorder_mesh(script_config, mesh);
+      pmesh = partition_mesh(mesh, lua_partition_weights(script_config, mesh));
+    }
+    if (AnomalyLog::size() == 0)
+      lua_write_native_mesh(script_config, pmesh);
   }
-  perturb_mesh(script_config, mesh);
-  manual_mesh_management(script_config, mesh);
 
-  AbstractMesh<T, IDX, ndim> pmesh{partition_mesh(mesh)};
+  // join the periodic boundaries so they are treated as interior traces
+  pmesh.make_periodic_faces_interior();
 
   // ===================================
   // = create the finite element space =
@@ -243,6 +260,7 @@ int main(int argc, char *argv[]) {
   ConservationLawDDG conservation_law{std::move(flux), std::move(numflux), std::move(diffusion_flux)};
   // conservation_law.interior_penalty = true;
   conservation_law.user_source = std::function{source};
+  conservation_law.tabulate_callbacks(fespace);
   conservation_law.field_names = std::vector<std::string>{"rho", "rhou"};
   conservation_law.residual_names = std::vector<std::string>{"density_conservation", "momentum_u_conservation"};
   if constexpr (ndim >= 2) {
@@ -0,0 +1,441 @@
+/**
+ * @brief strong and weak scaling benchmark on canned problems
+ *
+ * Builds a generated mesh sized for the number of processes
+ * (a fixed number of elements per process for weak scaling or a fixed total for strong scaling),
+ * then times a fixed number of residual evaluations, explicit RK steps, and Newton iterations
+ * with the region profiler.
+ * Each phase is reported as the maximum time over the processes, the degrees of freedom
+ * processed per second per core, and the parallel efficiency against a reference rate.
+ *
+ * Results are appended as rows to a csv file so runs at different process counts build one table:
+ * when no reference rate is given the row with the fewest processes for the same
+ * problem, mode, order, and phase in the csv is the reference.
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+
+#include "Numtool/tmp_flow_control.hpp"
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/build_config.hpp"
+#include "iceicle/disc/burgers.hpp"
+#include "iceicle/disc/conservation_law.hpp"
+#include "iceicle/disc/navier_stokes.hpp"
+#include "iceicle/explicit_utils.hpp"
+#include "iceicle/fe_function/layout_right.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/form_residual.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/initialization.hpp"
+#include "iceicle/mesh/distributed_uniform_mesh.hpp"
+#include "iceicle/mesh/mesh.hpp"
+#include "iceicle/mesh/mesh_partition.hpp"
+#include "iceicle/mesh/mesh_utils.hpp"
+#include "iceicle/profiler.hpp"
+#include "iceicle/program_args.hpp"
+#include "iceicle/residual_workspace.hpp"
+#include "iceicle/ssp_rk3.hpp"
+#include "iceicle/tmp_utils.hpp"
+#ifdef ICEICLE_USE_PETSC
+#include "iceicle/petsc_newton.hpp"
+#elifdef ICEICLE_USE_MPI
+#include "mpi.h"
+#endif
+#include <array>
+#include <cmath>
+#include <fenv.h>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+using namespace iceicle;
+using namespace iceicle::solvers;
+using namespace iceicle::util;
+using namespace iceicle::util::program_args;
+
+using T = build_config::T;
+using IDX = build_config::IDX;
+
+/// @brief the benchmark configuration shared by all processes
+struct bench_config {
+    /// @brief the canned problem (burgers1d, burgers2d, or ns2d)
+    std::string problem = "burgers2d";
+
+    /// @brief weak or strong scaling
+    std::string mode = "weak";
+
+    /// @brief the number of elements per process (weak) or in total (strong)
+    IDX nelem = 1024;
+
+    /// @brief the polynomial order of the basis functions
+    int order = 1;
+
+    /// @brief the ratio of quads to triangles for the 2D meshes
+    T quad_ratio = 1.0;
+
+    /// @brief the number of residual evaluations, RK steps, and Newton iterations to time
+    IDX nres = 20, nrk = 10, nnewton = 0;
+
+    /// @brief the explicit timestep
+    T dt = 1e-5;
+
+    /// @brief the dofs/s/core the efficiency is measured against (0: take it from the csv)
+    double reference_rate = 0.0;
+
+    std::string csv_filename = "scaling.csv";
+    std::string json_filename = "";
+};
+
+/// @brief the measurements of a timed phase
+struct phase_result {
+    std::string phase;
+    std::uint64_t count;
+    double time_max;
+    double time_avg;
+    double rate_per_core;
+    std::optional<double> efficiency;
+};
+
+/// @brief the number of elements in total over all the processes
+auto global_nelem(const bench_config& config) -> IDX {
+    return (config.mode == "weak") ? config.nelem * std::max(mpi::mpi_world_size(), 1) : config.nelem;
+}
+
+/**
+ * @brief find the reference rate for a phase from the rows of an existing csv
+ * the row with the fewest processes for the same problem, mode, order, and phase
+ */
+auto csv_reference_rate(const bench_config& config, const std::string& phase) -> std::optional<double> {
+    std::ifstream in{config.csv_filename};
+    if(!in) return std::nullopt;
+    std::string line;
+    std::getline(in, line); // header
+    std::optional<double> rate{};
+    int min_rank = std::numeric_limits<int>::max();
+    while(std::getline(in, line)){
+        std::vector<std::string> cols{};
+        std::stringstream ss{line};
+        for(std::string col; std::getline(ss, col, ',');) cols.push_back(col);
+        if(cols.size() < 11) continue;
+        if(cols[0] != config.problem || cols[1] != config.mode || cols[2] != std::to_string(config.order)
+                || cols[6] != phase) continue;
+        int nrank = std::stoi(cols[3]);
+        if(nrank < min_rank){
+            min_rank = nrank;
+            rate = std::stod(cols[10]);
+        }
+    }
+    return rate;
+}
+
+/// @brief append the results to the csv (rank 0)
+void write_csv(const bench_config& config, std::size_t ndof, const std::vector<phase_result>& results) {
+    bool new_file = !std::filesystem::exists(config.csv_filename);
+    std::ofstream out{config.csv_filename, std::ios::app};
+    if(new_file) out << "problem,mode,order,nrank,nelem,ndof,phase,count,time_max,time_avg,dofs_per_s_per_core,efficiency\n";
+    for(const phase_result& r : results){
+        out << fmt::format("{},{},{},{},{},{},{},{},{:.6e},{:.6e},{:.6e},{}\n",
+                config.problem, config.mode, config.order, mpi::mpi_world_size(), global_nelem(config), ndof,
+                r.phase, r.count, r.time_max, r.time_avg, r.rate_per_core,
+                (r.efficiency) ? fmt::format("{:.4f}", r.efficiency.value()) : "");
+    }
+}
+
+/// @brief write the results and the full region profile as json (rank 0)
+void write_json(const bench_config& config, std::size_t ndof,
+        const std::vector<phase_result>& results, const std::vector<profile_region_stats>& stats) {
+    std::ofstream out{config.json_filename};
+    out << fmt::format("{{\n\"problem\": \"{}\",\n\"mode\": \"{}\",\n\"order\": {},\n\"nrank\": {},\n"
+            "\"nelem\": {},\n\"ndof\": {},\n\"phases\": [",
+            config.problem, config.mode, config.order, mpi::mpi_world_size(), global_nelem(config), ndof);
+    for(std::size_t i = 0; i < results.size(); ++i){
+        const phase_result& r = results[i];
+        out << fmt::format("{}\n  {{\"phase\": \"{}\", \"count\": {}, \"time_max\": {:.6e}, \"time_avg\": {:.6e}, "
+                "\"dofs_per_s_per_core\": {:.6e}, \"efficiency\": {}}}",
+                (i > 0) ? "," : "", r.phase, r.count, r.time_max, r.time_avg, r.rate_per_core,
+                (r.efficiency) ? fmt::format("{:.4f}", r.efficiency.value()) : "null");
+    }
+    out << "\n],\n\"profile\": ";
+    Profiler::write_json(out, stats);
+    out << "}\n";
+}
+
+/**
+ * @brief time the phases on the given finite element space and discretization
+ * @param u the initialized solution
+ */
+template<int ndim, class disc_class, class uLayoutPolicy>
+void run_phases(const bench_config& config, FESpace<T, IDX, ndim>& fespace,
+        disc_class& disc, fespan<T, uLayoutPolicy> u) {
+    std::size_t ndof = mpi::allreduce_sums(std::array<std::size_t, 1>{u.size()})[0];
+    std::vector<T> u0(u.data(), u.data() + u.size());
+
+    Profiler::enable();
+
+    // === residual evaluations ===
+    {
+        std::vector<T> res_data(u.size());
+        fespan res{res_data.data(), u.get_layout()};
+        ResidualWorkspace<T, IDX> workspace{fespace, disc_class::dnv_comp};
+        form_residual(fespace, disc, u, res, workspace); // warm up the workspace
+        ProfileRegion region{"residual"};
+        for(IDX ires = 0; ires < config.nres; ++ires)
+            form_residual(fespace, disc, u, res, workspace);
+    }
+
+    // === explicit RK steps ===
+    if(config.nrk > 0) {
+        RK3SSP solver{fespace, disc, FixedTimestep<T, IDX>{config.dt}, TimestepTermination<T, IDX>{config.nrk}};
+        ProfileRegion region{"rk_steps"};
+        for(IDX istep = 0; istep < config.nrk; ++istep)
+            solver.step(fespace, disc, u);
+    }
+
+    // === Newton iterations ===
+#ifdef ICEICLE_USE_PETSC
+    if(config.nnewton > 0) {
+        std::ranges::copy(u0, u.data());
+        // zero tolerances so every iteration runs
+        ConvergenceCriteria<T, IDX> conv_criteria{.tau_abs = 0.0, .tau_rel = 0.0, .kmax = config.nnewton};
+        PetscNewton solver{fespace, disc, conv_criteria};
+        ProfileRegion region{"newton"};
+        solver.solve(u);
+    }
+#endif
+
+    Profiler::disable();
+    std::vector<profile_region_stats> stats = Profiler::aggregate();
+
+    // === per phase rates ===
+    const std::array<std::pair<std::string, IDX>, 3> phases{{
+        {"residual", config.nres}, {"rk_steps", config.nrk}, {"newton", config.nnewton}}};
+    std::vector<phase_result> results{};
+    if(mpi::mpi_world_rank() == 0) {
+        int ncore = std::max(mpi::mpi_world_size(), 1);
+        for(const auto& [name, count] : phases){
+            for(const profile_region_stats& s : stats){
+                if(s.depth != 1 || s.name != name || count == 0) continue;
+                phase_result r{name, (std::uint64_t) count, s.time_max, s.time_avg, 0.0, std::nullopt};
+                r.rate_per_core = (double) ndof * count / (std::max(s.time_max, 1e-300) * ncore);
+                std::optional<double> reference = (config.reference_rate > 0)
+                    ? std::optional<double>{config.reference_rate} : csv_reference_rate(config, name);
+                if(reference) r.efficiency = r.rate_per_core / reference.value();
+                results.push_back(r);
+            }
+        }
+
+        Profiler::write_summary(std::cout, stats);
+        std::cout << fmt::format("\n{} {} scaling | order {} | {} ranks | {} elements | {} dofs\n",
+                config.problem, config.mode, config.order, ncore, global_nelem(config), ndof);
+        std::cout << fmt::format("{:<10} {:>8} {:>14} {:>16} {:>10}\n",
+                "phase", "count", "time_max (s)", "dofs/s/core", "eff");
+        for(const phase_result& r : results){
+            std::cout << fmt::format("{:<10} {:>8} {:>14.6e} {:>16.6e} {:>10}\n",
+                    r.phase, r.count, r.time_max, r.rate_per_core,
+                    (r.efficiency) ? fmt::format("{:.4f}", r.efficiency.value()) : "-");
+        }
+
+        if(!config.csv_filename.empty()) write_csv(config, ndof, results);
+        if(!config.json_filename.empty()) write_json(config, ndof, results, stats);
+    }
+}
+
+/// @brief build a periodic box mesh and partition it
+/// 1D uses the uniform segment mesh, 2D uses the mixed quad/triangle mesh
+/// (uniform meshes are generated by each process instead, see distributed_uniform_mesh)
+template<int ndim>
+auto build_mesh(const bench_config& config) -> std::optional<AbstractMesh<T, IDX, ndim>> {
+    IDX nelem = global_nelem(config);
+    if constexpr (ndim == 1) {
+        // each process generates its block unless the mesh is too small to split into blocks
+        std::array<T, 1> xmin{0}, xmax{2 * M_PI};
+        std::array<IDX, 1> nelem_dir{nelem};
+        std::array<BOUNDARY_CONDITIONS, 2> bcs{BOUNDARY_CONDITIONS::PERIODIC, BOUNDARY_CONDITIONS::PERIODIC};
+        std::array<int, 2> bcflags{0, 0};
+        if(uniform_rank_grid<IDX, 1>(nelem_dir, {true}, mpi::mpi_world_size()))
+            return distributed_uniform_mesh<T, IDX, 1>(
+                    generate_directional_nodes<1>(xmin, xmax, nelem_dir, 1), bcs, bcflags);
+        AbstractMesh<T, IDX, 1> mesh{Tensor<T, 1>{0}, Tensor<T, 1>{2 * M_PI}, Tensor<IDX, 1>{nelem}, 1};
+        return partition_mesh(mesh);
+    } else {
+        // square with about nelem elements
+        IDX nx = std::max((IDX) std::ceil(std::sqrt((double) nelem)), (IDX) 1);
+        std::array<IDX, 2> nelem_dir{nx, nx};
+        std::array<T, 2> xmin{0, 0}, xmax{2 * M_PI, 2 * M_PI};
+        std::array<T, 2> quad_ratio{config.quad_ratio, config.quad_ratio};
+        std::array<BOUNDARY_CONDITIONS, 4> bcs{BOUNDARY_CONDITIONS::PERIODIC, BOUNDARY_CONDITIONS::PERIODIC,
+            BOUNDARY_CONDITIONS::PERIODIC, BOUNDARY_CONDITIONS::PERIODIC};
+        std::array<int, 4> bcflags{0, 0, 0, 0};
+
+        // meshes of only quads are generated by each process 
+        if(config.quad_ratio >= 1.0 && uniform_rank_grid<IDX, 2>(nelem_dir, {true, true}, mpi::mpi_world_size()))
+            return distributed_uniform_mesh<T, IDX, 2>(
+                    generate_directional_nodes<2>(xmin, xmax, nelem_dir, 1), bcs, bcflags);
+        auto mesh_opt = mixed_uniform_mesh<T, IDX>(nelem_dir, xmin, xmax, quad_ratio, bcs, bcflags);
+        if(!mesh_opt) return std::nullopt;
+        return partition_mesh(mesh_opt.value());
+    }
+}
+
+/// @brief viscous Burgers with a sine wave initial condition
+template<int ndim, int order>
+auto run_burgers(const bench_config& config) -> int {
+    auto mesh = build_mesh<ndim>(config);
+    if(!mesh) return 1;
+    mesh->make_periodic_faces_interior();
+    FESpace<T, IDX, ndim> fespace{&mesh.value(), FESPACE_ENUMS::LEGENDRE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, tmp::compile_int<order>{}};
+
+    BurgersCoefficients<T, ndim> burgers_coeffs{};
+    burgers_coeffs.mu = 0.01;
+    for(int idim = 0; idim < ndim; ++idim) {
+        burgers_coeffs.a[idim] = 0.5;
+        burgers_coeffs.b[idim] = 1.0;
+    }
+    BurgersFlux physical_flux{burgers_coeffs};
+    BurgersUpwind convective_flux{burgers_coeffs};
+    BurgersDiffusionFlux diffusive_flux{burgers_coeffs};
+    ConservationLawDDG disc{std::move(physical_flux), std::move(convective_flux), std::move(diffusive_flux)};
+    disc.field_names = std::vector<std::string>{"u"};
+
+    static constexpr int neq = decltype(disc)::nv_comp;
+    fe_layout_right u_layout{fespace.dg_map, tmp::to_size<neq>{}};
+    std::vector<T> u_data(u_layout.size());
+    fespan u{u_data.data(), u_layout};
+    std::function<void(const T*, T*)> ic = [](const T* x, T* out) {
+        out[0] = 1.0;
+        for(int idim = 0; idim < ndim; ++idim) out[0] += 0.5 * std::sin(x[idim]);
+    };
+    projection_initialization(fespace, ic, tmp::compile_int<neq>{}, u);
+
+    run_phases(config, fespace, disc, u);
+    return 0;
+}
+
+/// @brief compressible Navier-Stokes with a smooth density and momentum perturbation
+template<int order>
+auto run_navier_stokes(const bench_config& config) -> int {
+    static constexpr int ndim = 2;
+    auto mesh = build_mesh<ndim>(config);
+    if(!mesh) return 1;
+    mesh->make_periodic_faces_interior();
+    FESpace<T, IDX, ndim> fespace{&mesh.value(), FESPACE_ENUMS::LEGENDRE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, tmp::compile_int<order>{}};
+
+    navier_stokes::ReferenceParameters<T> ref{};
+    navier_stokes::CaloricallyPerfectEoS<T, ndim> eos{};
+    navier_stokes::constant_viscosity<T> mu{0.01};
+    navier_stokes::Physics physics{ref, eos, mu};
+    navier_stokes::Flux flux{physics, std::true_type{}};
+    navier_stokes::VanLeer numflux{physics};
+    navier_stokes::DiffusionFlux diffusion_flux{physics, std::true_type{}};
+    ConservationLawDDG disc{std::move(flux), std::move(numflux), std::move(diffusion_flux)};
+    disc.field_names = std::vector<std::string>{"rho", "rhou", "rhov", "rhoe"};
+    disc.tabulate_callbacks(fespace);
+
+    static constexpr int neq = decltype(disc)::nv_comp;
+    fe_layout_right u_layout{fespace.dg_map, tmp::to_size<neq>{}};
+    std::vector<T> u_data(u_layout.size());
+    fespan u{u_data.data(), u_layout};
+    std::function<void(const T*, T*)> ic = [](const T* x, T* out) {
+        T s = std::sin(x[0] + x[1]);
+        out[0] = 1.0 + 0.2 * s;
+        out[1] = 0.5 + 0.1 * s;
+        out[2] = 0.3 + 0.1 * s;
+        out[3] = 2.5 + 0.2 * s;
+    };
+    projection_initialization(fespace, ic, tmp::compile_int<neq>{}, u);
+
+    run_phases(config, fespace, disc, u);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+
+    // MPI is initialized first (funneled for threads within each rank)
+    // so that PETSc uses this initialization
+    mpi::init_funneled(&argc, &argv);
+#ifdef ICEICLE_USE_PETSC
+    PetscInitialize(&argc, &argv, nullptr, nullptr);
+#endif
+
+    // ===============================
+    // = Command line argument setup =
+    // ===============================
+    cli_parser cli_args{argc, argv};
+    cli_args.add_options(
+        cli_flag{"help", "print the help text and quit."},
+        cli_flag{"enable_fp_except", "enable floating point exceptions (ignoring FE_INEXACT)"},
+        cli_option{"problem", "the canned problem: burgers1d, burgers2d, or ns2d", parse_type<std::string_view>{}},
+        cli_option{"mode", "weak (nelem per process) or strong (nelem in total) scaling", parse_type<std::string_view>{}},
+        cli_option{"nelem", "the number of elements per process (weak) or in total (strong)", parse_type<IDX>{}},
+        cli_option{"order", "The polynomial order of the basis functions", parse_type<int>{}},
+        cli_option{"quad_ratio", "the ratio of quads to triangles for the 2D meshes", parse_type<T>{}},
+        cli_option{"nres", "the number of residual evaluations to time", parse_type<IDX>{}},
+        cli_option{"nrk", "the number of RK3-SSP steps to time", parse_type<IDX>{}},
+        cli_option{"nnewton", "the number of Newton iterations to time (requires PETSc)", parse_type<IDX>{}},
+        cli_option{"dt", "the explicit timestep", parse_type<T>{}},
+        cli_option{"reference_rate", "the dofs/s/core for an efficiency of 1 (default: the fewest ranks in the csv)", parse_type<double>{}},
+        cli_option{"csv", "the csv file to append the results to (empty to disable)", parse_type<std::string_view>{}},
+        cli_option{"json", "the json file to write the results and profile to", parse_type<std::string_view>{}}
+    );
+    if(cli_args["help"]){
+        cli_args.print_options(std::cout);
+        return 0;
+    }
+    if(cli_args["enable_fp_except"]){
+        feenableexcept(FE_ALL_EXCEPT & ~FE_INEXACT);
+    }
+
+    bench_config config{};
+    if(cli_args["problem"]) config.problem = cli_args["problem"].as<std::string>();
+    if(cli_args["mode"]) config.mode = cli_args["mode"].as<std::string>();
+    if(cli_args["nelem"]) config.nelem = cli_args["nelem"].as<IDX>();
+    if(cli_args["order"]) config.order = cli_args["order"].as<int>();
+    if(cli_args["quad_ratio"]) config.quad_ratio = cli_args["quad_ratio"].as<T>();
+    if(cli_args["nres"]) config.nres = cli_args["nres"].as<IDX>();
+    if(cli_args["nrk"]) config.nrk = cli_args["nrk"].as<IDX>();
+    if(cli_args["nnewton"]) config.nnewton = cli_args["nnewton"].as<IDX>();
+    if(cli_args["dt"]) config.dt = cli_args["dt"].as<T>();
+    if(cli_args["reference_rate"]) config.reference_rate = cli_args["reference_rate"].as<double>();
+    if(cli_args["csv"]) config.csv_filename = cli_args["csv"].as<std::string>();
+    if(cli_args["json"]) config.json_filename = cli_args["json"].as<std::string>();
+#ifndef ICEICLE_USE_PETSC
+    if(config.nnewton > 0){
+        AnomalyLog::log_anomaly(Anomaly{"Newton iterations require PETSc, skipping the newton phase", general_anomaly_tag{}});
+        config.nnewton = 0;
+    }
+#endif
+
+    int ierr = 0;
+    if(config.mode != "weak" && config.mode != "strong") {
+        AnomalyLog::log_anomaly(Anomaly{"unknown scaling mode " + config.mode, general_anomaly_tag{}});
+        ierr = 1;
+    } else {
+        ierr = NUMTOOL::TMP::invoke_at_index(NUMTOOL::TMP::make_range_sequence<int, 1, MAX_DYNAMIC_ORDER>{},
+            config.order, [&]<int order>() -> int {
+                if(config.problem == "burgers1d") return run_burgers<1, order>(config);
+                if(config.problem == "burgers2d") return run_burgers<2, order>(config);
+                if(config.problem == "ns2d") return run_navier_stokes<order>(config);
+                AnomalyLog::log_anomaly(Anomaly{"unknown problem " + config.problem, general_anomaly_tag{}});
+                return 1;
+            });
+    }
+
+    // cleanup
+#ifdef ICEICLE_USE_PETSC
+    PetscFinalize();
+#endif
+#ifdef ICEICLE_USE_MPI
+    MPI_Finalize();
+#endif
+    AnomalyLog::handle_anomalies();
+    return ierr;
+}
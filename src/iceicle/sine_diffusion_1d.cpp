@@ -137,6 +137,7 @@ int main(int argc, char *argv[]){
         RK3TVD solver{fespace, disc, dt, stop_condition};
         solver.ivis = (cli_args["ivis"].has_value()) ? cli_args["ivis"].as<IDX>() : 100;
         io::DatWriter<T, IDX, ndim> writer{fespace};
+        writer.append = true; // one file per field set for the whole solve
         writer.register_fields(u, "u");
         solver.vis_callback = [&](decltype(solver) &solver){
             T sum = 0.0;
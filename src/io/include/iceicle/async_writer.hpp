@@ -0,0 +1,206 @@
+/// @brief a writer that overlaps file output with the solver on a background thread
+/// @author Gianni Absillis (gabsill@ncsu.edu)
+
+#pragma once
+#include "iceicle/writer.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+#ifdef ICEICLE_USE_MPI
+#include <mpi.h>
+#endif
+
+namespace iceicle::io {
+
+    /**
+     * @brief writes solution snapshots on a background thread so the solver does not wait on file output
+     *
+     * Each call to write copies the solution into a free snapshot buffer (a ring of nbuffer buffers)
+     * and returns; the background thread copies the oldest snapshot into the staging storage
+     * that the wrapped writer was registered on and writes the file.
+     * When every snapshot buffer is waiting to be written, write blocks until one is free (back-pressure),
+     * so at most nbuffer copies of the solution are held.
+     *
+     * Files are written in the order they are requested by a single wrapped writer
+     * (so collection files like the pvd stay consistent).
+     *
+     * Copies share the same background thread and buffers (so this can be held by a Writer).
+     * The remaining snapshots are written before the last copy is destroyed.
+     *
+     * NOTE: the wrapped writers make MPI calls, so under MPI this falls back to synchronous output
+     * unless MPI was initialized with MPI_THREAD_MULTIPLE
+     *
+     * @tparam T the real value type
+     */
+    template<class T>
+    class AsyncWriter {
+
+        struct snapshot {
+            std::vector<T> data;
+            int itime;
+            T time;
+        };
+
+        struct shared_state {
+            /// @brief the solution storage that is snapshotted
+            std::span<const T> source;
+
+            /// @brief the storage the writer is registered on
+            std::vector<T> staging;
+
+            /// @brief the wrapped writer
+            Writer writer;
+
+            /// @brief the snapshot buffers
+            std::vector<snapshot> ring;
+
+            /// @brief snapshots waiting to be written (oldest first) and free snapshots
+            std::deque<snapshot*> pending{};
+            std::vector<snapshot*> free{};
+
+            /// @brief if a snapshot is being written
+            bool busy = false;
+
+            bool stop = false;
+
+            std::mutex mutex;
+
+            /// @brief signals the background thread that a snapshot is pending
+            std::condition_variable pending_cv;
+
+            /// @brief signals the solver thread that a snapshot is free
+            std::condition_variable free_cv;
+
+            std::thread worker;
+
+            shared_state(std::span<const T> source, std::size_t nbuffer)
+            : source{source}, staging(source.begin(), source.end()), ring(std::max(nbuffer, (std::size_t) 1))
+            {
+                for(snapshot& snap : ring) {
+                    snap.data.resize(source.size());
+                    free.push_back(&snap);
+                }
+            }
+
+            auto worker_loop() -> void {
+                std::unique_lock lock{mutex};
+                while(true) {
+                    pending_cv.wait(lock, [&]{ return stop || !pending.empty(); });
+                    if(pending.empty()) return;
+                    snapshot* snap = pending.front();
+                    pending.pop_front();
+                    busy = true;
+                    lock.unlock();
+
+                    std::ranges::copy(snap->data, staging.begin());
+                    writer.write(snap->itime, snap->time);
+
+                    lock.lock();
+                    busy = false;
+                    free.push_back(snap);
+                    free_cv.notify_all();
+                }
+            }
+
+            ~shared_state() {
+                if(worker.joinable()){
+                    {
+                        std::lock_guard lock{mutex};
+                        stop = true;
+                    }
+                    pending_cv.notify_all();
+                    worker.join();
+                }
+            }
+        };
+
+        std::shared_ptr<shared_state> state;
+
+        /// @brief if the wrapped writers may be called from another thread
+        static auto threads_supported() -> bool {
+#ifdef ICEICLE_USE_MPI
+            if(!mpi::mpi_initialized()) return true;
+            int provided;
+            MPI_Query_thread(&provided);
+            return provided >= MPI_THREAD_MULTIPLE;
+#else
+            return true;
+#endif
+        }
+
+        public:
+        using value_type = T;
+
+        /**
+         * @brief start the background writer
+         * @param source the solution storage to write (must outlive the writer)
+         * @param make_writer creates the wrapped writer given the span of staging storage
+         *        (the same size and layout as source) to register the fields on
+         * @param nbuffer the number of snapshots that may be waiting to be written
+         */
+        AsyncWriter(std::span<const T> source, std::function<Writer(std::span<T>)> make_writer, std::size_t nbuffer = 2)
+        : state{std::make_shared<shared_state>(source, nbuffer)}
+        {
+            state->writer = make_writer(std::span<T>{state->staging});
+            if(threads_supported())
+                state->worker = std::thread{[s = state.get()]{ s->worker_loop(); }};
+        }
+
+        /// @brief if output is written on the background thread (otherwise write is synchronous)
+        [[nodiscard]] auto is_async() const noexcept -> bool { return state->worker.joinable(); }
+
+        /**
+         * @brief snapshot the solution and queue it to be written
+         * blocks when all the snapshot buffers are waiting to be written
+         * @param itime the time index
+         * @param time the time value
+         */
+        auto write(int itime, T time) -> void {
+            if(!is_async()) {
+                std::ranges::copy(state->source, state->staging.begin());
+                state->writer.write(itime, time);
+                return;
+            }
+            std::unique_lock lock{state->mutex};
+            state->free_cv.wait(lock, [&]{ return !state->free.empty(); });
+            snapshot* snap = state->free.back();
+            state->free.pop_back();
+            lock.unlock();
+
+            std::ranges::copy(state->source, snap->data.begin());
+            snap->itime = itime;
+            snap->time = time;
+
+            lock.lock();
+            state->pending.push_back(snap);
+            state->pending_cv.notify_one();
+        }
+
+        /// @brief block until every queued snapshot has been written
+        auto flush() -> void {
+            std::unique_lock lock{state->mutex};
+            state->free_cv.wait(lock, [&]{ return state->pending.empty() && !state->busy; });
+        }
+
+        /// @brief rename the collection of the wrapped writer (after the queued snapshots are written)
+        auto rename_collection(std::string_view new_name) -> void {
+            flush();
+            state->writer.rename_collection(new_name);
+        }
+    };
+
+    /// @brief external function interface for type erasure to write a file
+    /// writes the file with the given time index and time values
+    template<class T>
+    auto write_file(AsyncWriter<T>& writer, int itime, T time) -> void {
+        writer.write(itime, time);
+    }
+}
@@ -0,0 +1,398 @@
+/**
+ * @brief compact output of the raw DG coefficients keyed by element type and basis
+ * (expanded to vtu or hdf5 offline by the coefficient_convert tool)
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/fe_function/dglayout.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fe_function/layout_right.hpp"
+#include "iceicle/fe_function/restart.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace iceicle::io {
+
+    namespace impl {
+        /// @brief the identifier at the start of coefficient files
+        inline constexpr std::string_view coefficient_magic = "ICECOEF1";
+
+        /// @brief the number of int64 fields of each element type key
+        /// domain type, geometry order, basis type, basis order, quadrature type
+        inline constexpr std::size_t coefficient_key_nfield = 5;
+
+        /// @brief the fespan layout is the element major dg layout so the data can be written as is
+        template<class LayoutPolicy>
+        inline constexpr bool is_dg_layout_right = false;
+
+        template<class IDX, std::size_t vextent>
+        inline constexpr bool is_dg_layout_right<fe_layout_right<IDX, dg_dof_map<IDX>, vextent>> = true;
+
+        /// @brief the FETypeKey of every element of an fespace
+        template<class T, class IDX, int ndim>
+        inline auto element_type_keys(const FESpace<T, IDX, ndim>& fespace) -> std::vector<FETypeKey> {
+            std::vector<FETypeKey> el_keys(fespace.elements.size());
+            for(IDX ibatch = 0; ibatch < fespace.element_batches.nrow(); ++ibatch){
+                for(IDX iel : fespace.element_batches.rowspan(ibatch)) el_keys[iel] = fespace.element_batch_keys[ibatch];
+            }
+            return el_keys;
+        }
+    }
+
+    /**
+     * @brief writes the raw coefficients of the registered fields every output
+     * to "<collection_name><itime>_rank<r>.coef" in the data directory (one file per process)
+     *
+     * Unlike the vtu and xdmf writers nothing is evaluated at subdivided points:
+     * the solution is written in its native form (a dump of the fespan storage for the dg layout)
+     * along with what is needed to evaluate it offline (see read_coefficient_file and load_coefficient_snapshot).
+     *
+     * File layout (native endianness):
+     * - the 8 character magic "ICECOEF1"
+     * - uint64: sizeof(T), ndim, the number of element type keys, elements, nodes, and field groups
+     * - int64 itime, T time
+     * - for each key: int64 domain type, geometry order, basis type, basis order, quadrature type
+     * - for each element: uint64 global element index, key index, ndof
+     * - for each node: uint64 global node index, T coordinates[ndim]
+     * - for each field group: uint64 nv, for each field uint64 length of the name followed by the characters,
+     *   then the coefficients of every element in element, dof, then vector component order (T[sum(ndof) * nv])
+     */
+    template<class T, class IDX, int ndim>
+    class CoefficientWriter {
+
+        struct field_group {
+            std::vector<std::string> names;
+
+            /// @brief write the coefficients of every element to the stream
+            std::function<void(std::ostream&, const FESpace<T, IDX, ndim>&)> write;
+        };
+
+        FESpace<T, IDX, ndim>* fespace_ptr = nullptr;
+
+        std::vector<field_group> fields{};
+
+        public:
+        using value_type = T;
+
+        std::string collection_name = "coefficients";
+        std::filesystem::path data_directory;
+
+        CoefficientWriter() : data_directory(std::filesystem::current_path() / "iceicle_data") {}
+
+        /// @brief register the finite element space the fields are defined on
+        void register_fespace(FESpace<T, IDX, ndim>& fespace) { fespace_ptr = &fespace; }
+
+        /**
+         * @brief register a set of fields represented in an fespan
+         * @param fedata the global data view to write to files (the storage must outlive the writer)
+         * @param field_names the names for each vector component of fedata
+         */
+        template<class LayoutPolicy, class AccessorPolicy>
+        void register_fields(fespan<T, LayoutPolicy, AccessorPolicy>& fedata, std::vector<std::string> field_names) {
+            if(field_names.size() != fedata.nv())
+                util::AnomalyLog::log_anomaly(util::Anomaly{"field names size does not match number of fields", util::general_anomaly_tag{}});
+            fespan<T, LayoutPolicy, AccessorPolicy> data = fedata;
+            fields.push_back(field_group{field_names,
+                [data](std::ostream& out, const FESpace<T, IDX, ndim>& fespace){
+                    if constexpr (impl::is_dg_layout_right<LayoutPolicy>
+                            && std::is_same_v<AccessorPolicy, default_accessor<T>>) {
+                        out.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
+                    } else {
+                        std::vector<T> el_data{};
+                        for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+                            el_data.clear();
+                            for(std::size_t idof = 0; idof < data.ndof(el.elidx); ++idof){
+                                for(std::size_t iv = 0; iv < data.nv(); ++iv) el_data.push_back(data[el.elidx, idof, iv]);
+                            }
+                            out.write(reinterpret_cast<const char*>(el_data.data()), el_data.size() * sizeof(T));
+                        }
+                    }
+                }
+            });
+        }
+
+        /**
+         * @brief write the coefficients of every registered field group for one output
+         * @param itime the time index
+         * @param time the time value
+         */
+        void write_coefficients(int itime, T time) {
+            if(fespace_ptr == nullptr){
+                util::AnomalyLog::log_anomaly(util::Anomaly{"fespace not set for coefficient writer", util::general_anomaly_tag{}});
+                return;
+            }
+            FESpace<T, IDX, ndim>& fespace = *fespace_ptr;
+            const AbstractMesh<T, IDX, ndim>& mesh = *fespace.meshptr;
+            std::filesystem::create_directories(data_directory);
+            std::ofstream out{data_directory / (collection_name + std::to_string(itime)
+                    + "_rank" + std::to_string(mpi::mpi_world_rank()) + ".coef"), std::ios::binary | std::ios::trunc};
+            if(!out) {
+                util::AnomalyLog::log_anomaly(util::Anomaly{"could not open coefficient file for writing", util::general_anomaly_tag{}});
+                return;
+            }
+            auto write_value = [&out]<class V>(V value){ out.write(reinterpret_cast<const char*>(&value), sizeof(V)); };
+
+            // the distinct element type keys
+            std::vector<FETypeKey> el_keys = impl::element_type_keys(fespace);
+            std::vector<FETypeKey> keys{};
+            std::vector<std::uint64_t> el_key_idxs(el_keys.size());
+            for(std::size_t iel = 0; iel < el_keys.size(); ++iel){
+                auto it = std::ranges::find(keys, el_keys[iel]);
+                el_key_idxs[iel] = it - keys.begin();
+                if(it == keys.end()) keys.push_back(el_keys[iel]);
+            }
+
+            out.write(impl::coefficient_magic.data(), impl::coefficient_magic.size());
+            for(std::uint64_t field : {(std::uint64_t) sizeof(T), (std::uint64_t) ndim, (std::uint64_t) keys.size(),
+                    (std::uint64_t) fespace.elements.size(), (std::uint64_t) mesh.n_nodes(), (std::uint64_t) fields.size()})
+                { write_value(field); }
+            write_value((std::int64_t) itime);
+            write_value(time);
+            for(const FETypeKey& key : keys){
+                for(std::int64_t field : {(std::int64_t) key.domain_type, (std::int64_t) key.geometry_order,
+                        (std::int64_t) key.btype, (std::int64_t) key.basis_order, (std::int64_t) key.qtype})
+                    { write_value(field); }
+            }
+            for(IDX iel = 0; iel < (IDX) fespace.elements.size(); ++iel){
+                write_value(iceicle::impl::restart_global_el(mesh, iel));
+                write_value(el_key_idxs[iel]);
+                write_value((std::uint64_t) fespace.elements[iel].nbasis());
+            }
+            for(IDX inode = 0; inode < mesh.n_nodes(); ++inode){
+                write_value(iceicle::impl::restart_global_node(mesh, inode));
+                for(int idim = 0; idim < ndim; ++idim) write_value((T) mesh.coord[inode][idim]);
+            }
+            for(const field_group& group : fields){
+                write_value((std::uint64_t) group.names.size());
+                for(const std::string& name : group.names){
+                    write_value((std::uint64_t) name.size());
+                    out.write(name.data(), name.size());
+                }
+                group.write(out, fespace);
+            }
+        }
+
+        void rename_collection(std::string_view new_name) { collection_name = new_name; }
+    };
+
+    template<class T, class IDX, int ndim>
+    auto write_file(CoefficientWriter<T, IDX, ndim>& writer, int itime, T time) -> void {
+        writer.write_coefficients(itime, time);
+    }
+
+    /// @brief the contents of a coefficient file (the output of one process)
+    template<class T>
+    struct CoefficientSnapshot {
+        int ndim = 0;
+        std::int64_t itime = 0;
+        T time = 0;
+
+        /// @brief the element type keys
+        std::vector<FETypeKey> keys{};
+
+        /// @brief the global index, key index, and number of basis functions of each element
+        std::vector<std::uint64_t> el_gidxs{}, el_keys{}, el_ndofs{};
+
+        /// @brief the global index and coordinates (ndim per node) of each node
+        std::vector<std::uint64_t> node_gidxs{};
+        std::vector<T> coords{};
+
+        struct field_group {
+            std::vector<std::string> names{};
+
+            /// @brief the coefficients in element, dof, then vector component order
+            std::vector<T> coefficients{};
+        };
+        std::vector<field_group> fields{};
+    };
+
+    /**
+     * @brief read a file written by CoefficientWriter
+     * @param path the path to the file
+     * @param read_fields false to only read the field names and skip the coefficients
+     * @return the snapshot (empty with an anomaly if the file is not a coefficient file of this precision)
+     */
+    template<class T>
+    auto read_coefficient_file(const std::filesystem::path& path, bool read_fields = true) -> CoefficientSnapshot<T> {
+        CoefficientSnapshot<T> snapshot{};
+        std::ifstream in{path, std::ios::binary};
+        auto read_value = [&in]<class V>(V& value){ in.read(reinterpret_cast<char*>(&value), sizeof(V)); };
+        char magic[impl::coefficient_magic.size()];
+        in.read(magic, sizeof(magic));
+        std::uint64_t value_size = 0, ndim = 0, nkey = 0, nelem = 0, nnode = 0, ngroup = 0;
+        for(std::uint64_t* field : {&value_size, &ndim, &nkey, &nelem, &nnode, &ngroup}) read_value(*field);
+        if(!in || std::string_view{magic, sizeof(magic)} != impl::coefficient_magic || value_size != sizeof(T)){
+            util::AnomalyLog::log_anomaly(util::Anomaly{"not a coefficient file of this precision: " + path.string(),
+                    util::general_anomaly_tag{}});
+            return snapshot;
+        }
+        snapshot.ndim = ndim;
+        read_value(snapshot.itime);
+        read_value(snapshot.time);
+        for(std::uint64_t ikey = 0; ikey < nkey; ++ikey){
+            std::int64_t fields[impl::coefficient_key_nfield];
+            for(std::int64_t& field : fields) read_value(field);
+            snapshot.keys.push_back(FETypeKey{
+                .domain_type = (DOMAIN_TYPE) fields[0],
+                .basis_order = (int) fields[3],
+                .geometry_order = (int) fields[1],
+                .qtype = (FESPACE_ENUMS::FESPACE_QUADRATURE) fields[4],
+                .btype = (FESPACE_ENUMS::FESPACE_BASIS_TYPE) fields[2]
+            });
+        }
+        snapshot.el_gidxs.resize(nelem);
+        snapshot.el_keys.resize(nelem);
+        snapshot.el_ndofs.resize(nelem);
+        std::uint64_t ndof_total = 0;
+        for(std::uint64_t iel = 0; iel < nelem; ++iel){
+            read_value(snapshot.el_gidxs[iel]);
+            read_value(snapshot.el_keys[iel]);
+            read_value(snapshot.el_ndofs[iel]);
+            ndof_total += snapshot.el_ndofs[iel];
+        }
+        snapshot.node_gidxs.resize(nnode);
+        snapshot.coords.resize(nnode * ndim);
+        for(std::uint64_t inode = 0; inode < nnode; ++inode){
+            read_value(snapshot.node_gidxs[inode]);
+            in.read(reinterpret_cast<char*>(snapshot.coords.data() + inode * ndim), ndim * sizeof(T));
+        }
+        for(std::uint64_t igroup = 0; igroup < ngroup && in; ++igroup){
+            typename CoefficientSnapshot<T>::field_group group{};
+            std::uint64_t nv = 0;
+            read_value(nv);
+            for(std::uint64_t iv = 0; iv < nv; ++iv){
+                std::uint64_t len = 0;
+                read_value(len);
+                std::string name(len, ' ');
+                in.read(name.data(), len);
+                group.names.push_back(name);
+            }
+            if(read_fields) {
+                group.coefficients.resize(ndof_total * nv);
+                in.read(reinterpret_cast<char*>(group.coefficients.data()), group.coefficients.size() * sizeof(T));
+            } else {
+                in.seekg(ndof_total * nv * sizeof(T), std::ios::cur);
+            }
+            snapshot.fields.push_back(std::move(group));
+        }
+        if(!in) {
+            util::AnomalyLog::log_anomaly(util::Anomaly{"truncated coefficient file: " + path.string(), util::general_anomaly_tag{}});
+            snapshot.fields.clear();
+        }
+        return snapshot;
+    }
+
+    /**
+     * @brief set the node coordinates and element basis orders of an fespace from the coefficient files of one output
+     *
+     * The records are matched to the fespace by global index so the pieces of any partitioning can be
+     * loaded into the serial fespace of the same mesh.
+     * The domain type, geometry order, and basis type of each element must match the fespace.
+     *
+     * NOTE: changing basis orders (p-adaptivity) rebuilds the dg_map, the solution storage must be resized
+     *
+     * @param fespace the finite element space
+     * @param pieces the files of every process for one output
+     * @return true if every element was found and matches
+     */
+    template<class T, class IDX, int ndim>
+    auto load_coefficient_snapshot(FESpace<T, IDX, ndim>& fespace, std::span<const CoefficientSnapshot<T>> pieces) -> bool {
+        using namespace util;
+        AbstractMesh<T, IDX, ndim>& mesh = *fespace.meshptr;
+        std::unordered_map<std::uint64_t, IDX> local_el{}, local_node{};
+        for(IDX iel = 0; iel < (IDX) fespace.elements.size(); ++iel) local_el[iceicle::impl::restart_global_el(mesh, iel)] = iel;
+        for(IDX inode = 0; inode < mesh.n_nodes(); ++inode) local_node[iceicle::impl::restart_global_node(mesh, inode)] = inode;
+
+        std::vector<FETypeKey> el_keys = impl::element_type_keys(fespace);
+        std::vector<int> el_orders(fespace.elements.size());
+        for(IDX iel = 0; iel < (IDX) fespace.elements.size(); ++iel) el_orders[iel] = el_keys[iel].basis_order;
+        std::vector<bool> el_found(fespace.elements.size(), false);
+        for(const CoefficientSnapshot<T>& piece : pieces){
+            if(piece.ndim != ndim) {
+                AnomalyLog::log_anomaly(Anomaly{"coefficient file has a different dimensionality", general_anomaly_tag{}});
+                return false;
+            }
+            for(std::size_t inode = 0; inode < piece.node_gidxs.size(); ++inode){
+                auto it = local_node.find(piece.node_gidxs[inode]);
+                if(it == local_node.end()) continue;
+                for(int idim = 0; idim < ndim; ++idim) mesh.coord[it->second][idim] = piece.coords[inode * ndim + idim];
+            }
+            for(std::size_t iel = 0; iel < piece.el_gidxs.size(); ++iel){
+                auto it = local_el.find(piece.el_gidxs[iel]);
+                if(it == local_el.end()) continue;
+                const FETypeKey& key = piece.keys[piece.el_keys[iel]];
+                const FETypeKey& el_key = el_keys[it->second];
+                if(key.domain_type != el_key.domain_type || key.geometry_order != el_key.geometry_order
+                        || key.btype != el_key.btype) {
+                    AnomalyLog::log_anomaly(Anomaly{"coefficient file element type or basis does not match the fespace",
+                            general_anomaly_tag{}});
+                    return false;
+                }
+                el_orders[it->second] = key.basis_order;
+                el_found[it->second] = true;
+            }
+        }
+        mesh.update_coord_els();
+        bool orders_changed = false;
+        for(IDX iel = 0; iel < (IDX) fespace.elements.size(); ++iel)
+            { orders_changed = orders_changed || (el_keys[iel].basis_order != el_orders[iel]); }
+        if(orders_changed) fespace.set_element_orders(el_orders);
+        if(std::ranges::count(el_found, false) > 0) {
+            AnomalyLog::log_anomaly(Anomaly{"coefficient files are missing elements", general_anomaly_tag{}});
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief copy the coefficients of a field group from the coefficient files of one output
+     * (after load_coefficient_snapshot has set the basis orders)
+     * @param fespace the finite element space
+     * @param pieces the files of every process for one output
+     * @param igroup the index of the field group
+     * @param u the solution to fill (nv must match the group)
+     */
+    template<class T, class IDX, int ndim, class LayoutPolicy>
+    auto load_coefficient_fields(
+        FESpace<T, IDX, ndim>& fespace,
+        std::span<const CoefficientSnapshot<T>> pieces,
+        std::size_t igroup,
+        fespan<T, LayoutPolicy> u
+    ) -> void {
+        using namespace util;
+        AbstractMesh<T, IDX, ndim>& mesh = *fespace.meshptr;
+        std::unordered_map<std::uint64_t, IDX> local_el{};
+        for(IDX iel = 0; iel < (IDX) fespace.elements.size(); ++iel) local_el[iceicle::impl::restart_global_el(mesh, iel)] = iel;
+        for(const CoefficientSnapshot<T>& piece : pieces){
+            if(igroup >= piece.fields.size() || piece.fields[igroup].names.size() != u.nv()) {
+                AnomalyLog::log_anomaly(Anomaly{"coefficient file does not have the field group", general_anomaly_tag{}});
+                return;
+            }
+            const std::vector<T>& coefficients = piece.fields[igroup].coefficients;
+            std::size_t offset = 0;
+            for(std::size_t iel = 0; iel < piece.el_gidxs.size(); ++iel){
+                auto it = local_el.find(piece.el_gidxs[iel]);
+                std::size_t ndof = piece.el_ndofs[iel];
+                if(it != local_el.end() && ndof == u.ndof(it->second)) {
+                    for(std::size_t idof = 0; idof < ndof; ++idof){
+                        for(std::size_t iv = 0; iv < u.nv(); ++iv)
+                            { u[it->second, idof, iv] = coefficients[offset + idof * u.nv() + iv]; }
+                    }
+                }
+                offset += ndof * u.nv();
+            }
+        }
+    }
+}
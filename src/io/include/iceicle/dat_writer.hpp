@@ -3,18 +3,33 @@
 #include "iceicle/fespace/fespace.hpp"
 #include "iceicle/fe_function/fespan.hpp"
 #include "iceicle/iceicle_mpi_utils.hpp"
+#include <cstdint>
 #include <fstream>
 #include <fmt/core.h>
+#include <fmt/format.h>
 #include <filesystem>
+#include <iterator>
 #include <memory>
 #include <string>
 namespace iceicle::io {
 
+    /// @brief the encoding of dat files
+    enum class dat_format {
+        /// space separated text columns (for gnuplot)
+        ascii,
+
+        /// native endian binary records: for each output the int64 time index, the double time value,
+        /// the uint64 number of points and columns, then the point major values (x then each field)
+        binary
+    };
+
     template<class T, class IDX, int ndim>
     class DatWriter{
 
         struct writeable_field {
-            virtual void write_data(std::ofstream &out, FESpace<T, IDX, ndim> &fespace) const = 0;
+            /// @brief format the data for one output into buffer
+            virtual void write_data(std::string &buffer, FESpace<T, IDX, ndim> &fespace,
+                    dat_format format, int itime, T time) const = 0;
 
             virtual auto clone() const -> std::unique_ptr<writeable_field> = 0;
 
@@ -26,28 +41,42 @@ namespace iceicle::io {
             /// the data view 
             fespan<T, LayoutPolicy, AccessorPolicy> fedata;
 
+            /// the number of equally spaced points to sample in each element
+            int npoin;
+
             /// the field name for each vector component of fespan 
             std::vector<std::string> field_names;
 
             /// @brief constructor with argument forwarding for the vector constructor
             template<class... VecArgs>
-            DataField(fespan<T, LayoutPolicy, AccessorPolicy> fedata, VecArgs&&... vec_args)
-            : fedata(fedata), field_names({std::forward<VecArgs>(vec_args)...}){}
+            DataField(fespan<T, LayoutPolicy, AccessorPolicy> fedata, int npoin, VecArgs&&... vec_args)
+            : fedata(fedata), npoin(npoin), field_names({std::forward<VecArgs>(vec_args)...}){}
 
-            /// @brief adds the xml DataArray tags and data to a given vtu file 
-            void write_data(std::ofstream &out, FESpace<T, IDX, ndim> &fespace) const override
+            /// @brief format the point coordinates and field values at npoin points in each element
+            void write_data(std::string &buffer, FESpace<T, IDX, ndim> &fespace,
+                    dat_format format, int itime, T time) const override
             {
                 using Element = FiniteElement<T, IDX, ndim>;
                 constexpr int field_width = 18;
                 constexpr int precision = 10;
-                constexpr int npoin = 30;
+                auto out = std::back_inserter(buffer);
+                auto append_binary = [&buffer]<class V>(V value){
+                    buffer.append(reinterpret_cast<const char*>(&value), sizeof(V));
+                };
                 if constexpr(ndim == 1){
                     // headers
-                    out << fmt::format("{:>{}}", "x", field_width);
-                    for(const std::string &s : field_names){
-                        out << " " << fmt::format("{:>{}}", s, field_width);
+                    if(format == dat_format::binary){
+                        append_binary((std::int64_t) itime);
+                        append_binary((double) time);
+                        append_binary((std::uint64_t) (npoin * fespace.elements.size()));
+                        append_binary((std::uint64_t) (field_names.size() + 1));
+                    } else {
+                        fmt::format_to(out, "{:>{}}", "x", field_width);
+                        for(const std::string &s : field_names){
+                            fmt::format_to(out, " {:>{}}", s, field_width);
+                        }
+                        buffer.push_back('\n');
                     }
-                    out << std::endl;
 
                     // loop over the elements
                     for(Element &el : fespace.elements){
@@ -57,23 +86,25 @@ namespace iceicle::io {
                         for(int ipoin = 0; ipoin < npoin; ++ipoin){
                             MATH::GEOMETRY::Point<T, ndim> refnode{-1.0 + 2.0 / (npoin - 1) * ipoin};
                             MATH::GEOMETRY::Point<T, ndim> physnode = el.transform(refnode);
-                            out << fmt::format("{:{}.{}e}", physnode[0], field_width, precision);
+                            if(format == dat_format::binary) append_binary((T) physnode[0]);
+                            else fmt::format_to(out, "{:{}.{}e}", physnode[0], field_width, precision);
 
+                            el.eval_basis(refnode, basis_data.data());
                             for(IDX ifield = 0; ifield < field_names.size(); ++ifield){
-                                el.eval_basis(refnode, basis_data.data());
                                 T field_value = 0;
                                 for(std::size_t idof = 0; idof < el.nbasis(); ++idof){
                                     field_value += fedata[el.elidx, idof, ifield] 
                                         * basis_data[idof];
                                 }
-                                out << " " << fmt::format("{:>{}.{}e}", field_value, field_width, precision);
+                                if(format == dat_format::binary) append_binary(field_value);
+                                else fmt::format_to(out, " {:>{}.{}e}", field_value, field_width, precision);
                             }
 
-                            out << std::endl;
+                            if(format == dat_format::ascii) buffer.push_back('\n');
                         }
                         // add an extra linebreak after each element 
                         // so that gnuplot can plot in line segments per element
-                        out << std::endl;
+                        if(format == dat_format::ascii) buffer.push_back('\n');
                     }
                 }
             }
@@ -83,80 +114,35 @@ namespace iceicle::io {
             }
         };
 
-
-        template< class LayoutPolicy, class AccessorPolicy>
-        struct Endpoints final : public writeable_field {
-            /// the data view 
-            fespan<T, LayoutPolicy, AccessorPolicy> fedata;
-
-            /// the field name for each vector component of fespan 
-            std::vector<std::string> field_names;
-
-            /// @brief constructor with argument forwarding for the vector constructor
-            template<class... VecArgs>
-            Endpoints(fespan<T, LayoutPolicy, AccessorPolicy> fedata, VecArgs&&... vec_args)
-            : fedata(fedata), field_names({std::forward<VecArgs>(vec_args)...}){}
-
-            /// @brief adds the xml DataArray tags and data to a given vtu file 
-            void write_data(std::ofstream &out, FESpace<T, IDX, ndim> &fespace) const override
-            {
-                using Element = FiniteElement<T, IDX, ndim>;
-                constexpr int field_width = 18;
-                constexpr int precision = 10;
-                constexpr int npoin = 2;
-                if constexpr(ndim == 1){
-                    // headers
-                    out << fmt::format("{:>{}}", "x", field_width);
-                    for(const std::string &s : field_names){
-                        out << " " << fmt::format("{:>{}}", s, field_width);
-                    }
-                    out << std::endl;
-
-                    // loop over the elements
-                    for(Element &el : fespace.elements){
-                        // storage for basis functions 
-                        std::vector<T> basis_data(el.nbasis());
-
-                        for(int ipoin = 0; ipoin < npoin; ++ipoin){
-                            MATH::GEOMETRY::Point<T, ndim> refnode{-1.0 + 2.0 / (npoin - 1) * ipoin};
-                            MATH::GEOMETRY::Point<T, ndim> physnode = el.transform(refnode);
-                            out << fmt::format("{:{}.{}e}", physnode[0], field_width, precision);
-
-                            for(IDX ifield = 0; ifield < field_names.size(); ++ifield){
-                                el.eval_basis(refnode, basis_data.data());
-                                T field_value = 0;
-                                for(std::size_t idof = 0; idof < el.nbasis(); ++idof){
-                                    field_value += fedata[el.elidx, idof, ifield] 
-                                        * basis_data[idof];
-                                }
-                                out << " " << fmt::format("{:>{}.{}e}", field_value, field_width, precision);
-                            }
-
-                            out << std::endl;
-                        }
-                        // add an extra linebreak after each element 
-                        // so that gnuplot can plot in line segments per element
-                        out << std::endl;
-                    }
-                }
-            }
-
-            auto clone() const -> std::unique_ptr<writeable_field> override {
-                return std::make_unique<Endpoints<LayoutPolicy, AccessorPolicy>>(*this);
-            }
-        };
+        /// @brief the number of points per element for the fieldset and the endpoints files
+        static constexpr int npoin_fieldset = 30;
+        static constexpr int npoin_endpoints = 2;
 
         private:
         AbstractMesh<T, IDX, ndim> *meshptr;
         FESpace<T, IDX, ndim> *fespace_ptr;
         std::vector<std::unique_ptr<writeable_field>> fields;
 
+        /// @brief the formatting buffer (reused between outputs)
+        std::string buffer{};
+
+        /// @brief if the appended files have been started (the first output truncates them)
+        bool append_started = false;
+
         public:
         using value_type = T;
 
         std::string collection_name = "iceicle_data";
         std::filesystem::path data_directory;
 
+        /// @brief the encoding of the files
+        dat_format format = dat_format::ascii;
+
+        /// @brief append every output to one file per field set instead of one file per output
+        /// (ascii outputs are separated by two blank lines and a comment with the time index and time
+        /// so they can be selected with the gnuplot index keyword)
+        bool append = false;
+
         DatWriter(FESpace<T, IDX, ndim> &fespace)
         : fespace_ptr{&fespace}, meshptr{fespace.meshptr}, data_directory{std::filesystem::current_path()}{
             data_directory /= "iceicle_data";
@@ -164,7 +150,8 @@ namespace iceicle::io {
 
         DatWriter(const DatWriter<T, IDX, ndim>& other) 
             : meshptr(other.meshptr), fespace_ptr(other.fespace_ptr), fields{}, 
-              collection_name(other.collection_name), data_directory(other.data_directory) 
+              collection_name(other.collection_name), data_directory(other.data_directory),
+              format(other.format), append(other.append)
         {
             for(const std::unique_ptr<writeable_field>& field : other.fields){
                 fields.push_back(field->clone());
@@ -192,10 +179,10 @@ namespace iceicle::io {
 
             // create the field handle and add it to the list
             auto field_ptr = std::make_unique<DataField<LayoutPolicy, AccessorPolicy>>(
-                    fedata, std::forward<FieldNameTs>(field_names)...);
+                    fedata, npoin_fieldset, field_names...);
             fields.push_back(std::move(field_ptr));
-            auto field_ptr2 = std::make_unique<Endpoints<LayoutPolicy, AccessorPolicy>>(
-                    fedata, std::forward<FieldNameTs>(field_names)...);
+            auto field_ptr2 = std::make_unique<DataField<LayoutPolicy, AccessorPolicy>>(
+                    fedata, npoin_endpoints, std::forward<FieldNameTs>(field_names)...);
             fields.push_back(std::move(field_ptr2));
         }
 
@@ -218,19 +205,23 @@ namespace iceicle::io {
 
             // create the field handle and add it to the list
             auto field_ptr = std::make_unique<DataField<LayoutPolicy, AccessorPolicy>>(
-                    fedata, field_names);
+                    fedata, npoin_fieldset, field_names);
             fields.push_back(std::move(field_ptr));
-            auto field_ptr2 = std::make_unique<Endpoints<LayoutPolicy, AccessorPolicy>>(
-                    fedata, field_names);
+            auto field_ptr2 = std::make_unique<DataField<LayoutPolicy, AccessorPolicy>>(
+                    fedata, npoin_endpoints, field_names);
             fields.push_back(std::move(field_ptr2));
         }
 
+        /// @brief write the fields for one output
+        /// each field set is formatted into memory and written with a single write
         void write_dat(int itime, T time){
 
             if(fespace_ptr == nullptr) {
                 throw std::logic_error("fespace pointer not set");
             }
-
+            if(!meshptr){
+                throw std::logic_error("mesh doesn't exist");
+            }
 
             std::filesystem::create_directories(data_directory);
 
@@ -238,23 +229,30 @@ namespace iceicle::io {
                 auto &field = *(fields[i]);
                 std::filesystem::path field_path = data_directory;
                 std::string name = (i % 2 == 0) ? "fieldset" : "endpoints";
+                std::string extension = (format == dat_format::binary) ? ".bin" : ".dat";
                 field_path /= 
                         collection_name + "_"
                         + (name + std::to_string(i / 2)
                         + "_rank" + std::to_string(mpi::mpi_world_rank())
-                        + "_i" + std::to_string(itime)
-                        + ".dat");
+                        + (append ? "" : "_i" + std::to_string(itime))
+                        + extension);
 
-                std::ofstream out{field_path};
+                std::ios::openmode mode = std::ios::out | std::ios::binary;
+                if(append && append_started) mode |= std::ios::app;
+                std::ofstream out{field_path, mode};
                 if(!out) {
                     throw std::logic_error("could not open mesh file for writing.");
                 }
 
-                if(!meshptr){
-                    throw std::logic_error("mesh doesn't exist");
+                buffer.clear();
+                if(append && format == dat_format::ascii){
+                    if(append_started) buffer.append("\n\n");
+                    fmt::format_to(std::back_inserter(buffer), "# itime {} time {}\n", itime, time);
                 }
-                field.write_data(out, *fespace_ptr);
+                field.write_data(buffer, *fespace_ptr, format, itime, time);
+                out.write(buffer.data(), buffer.size());
             }
+            append_started = true;
         }
     };
 }
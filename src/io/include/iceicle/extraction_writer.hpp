@@ -0,0 +1,703 @@
+/// @brief in-situ extraction of small outputs for monitoring:
+/// probe points, plane slices, boundary surfaces, and live frames in shared memory
+/// @author Gianni Absillis (gabsill@ncsu.edu)
+#pragma once
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/element/finite_element.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/fespace/point_location.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/pvd_writer.hpp"
+#include "iceicle/shared_memory_ring.hpp"
+#include <fmt/format.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace iceicle::io {
+
+    namespace impl {
+
+        /// @brief evaluates the registered fields at reference points of elements
+        template<class T, class IDX, int ndim>
+        class field_sampler {
+            using Element = FiniteElement<T, IDX, ndim>;
+            using Point = MATH::GEOMETRY::Point<T, ndim>;
+
+            /// @brief evaluate a field group: writes nv values to out
+            using eval_fcn = std::function<void(const Element&, const Point&, T*)>;
+
+            std::vector<eval_fcn> evals{};
+            std::vector<std::size_t> nvs{};
+
+            public:
+            /// @brief the name of every field in order
+            std::vector<std::string> names{};
+
+            /**
+             * @brief register a set of fields represented in an fespan
+             * @param fedata the global data view (must outlive the sampler)
+             * @param field_names the names for each vector component of fedata
+             */
+            template<class LayoutPolicy, class AccessorPolicy>
+            void add(fespan<T, LayoutPolicy, AccessorPolicy>& fedata, std::vector<std::string> field_names) {
+                if(field_names.size() != fedata.nv())
+                    util::AnomalyLog::log_anomaly(util::Anomaly{"field names size does not match number of fields", util::general_anomaly_tag{}});
+                fespan<T, LayoutPolicy, AccessorPolicy> data = fedata;
+                evals.push_back([data](const Element& el, const Point& xi, T* out){
+                    std::vector<T> basis_data(el.nbasis());
+                    el.eval_basis(xi, basis_data.data());
+                    for(std::size_t iv = 0; iv < data.nv(); ++iv){
+                        out[iv] = 0.0;
+                        for(std::size_t idof = 0; idof < el.nbasis(); ++idof)
+                            { out[iv] += data[el.elidx, idof, iv] * basis_data[idof]; }
+                    }
+                });
+                nvs.push_back(fedata.nv());
+                names.insert(names.end(), field_names.begin(), field_names.end());
+            }
+
+            /// @brief the total number of field values at each point
+            [[nodiscard]] auto nfield() const noexcept -> std::size_t { return names.size(); }
+
+            /// @brief evaluate every field at the reference point xi of el into out (size nfield())
+            void sample(const Element& el, const Point& xi, T* out) const {
+                for(std::size_t igroup = 0; igroup < evals.size(); ++igroup){
+                    evals[igroup](el, xi, out);
+                    out += nvs[igroup];
+                }
+            }
+        };
+
+        /// @brief points, cells, and point values of an extracted output
+        template<class T>
+        struct sampled_grid {
+            /// @brief the point coordinates (npoin x 3)
+            std::vector<T> points{};
+
+            /// @brief vtk cell connectivity, offsets, and types
+            std::vector<std::int64_t> connectivity{}, offsets{}, types{};
+
+            /// @brief the sampled field values (npoin x nfield)
+            std::vector<T> values{};
+
+            [[nodiscard]] auto npoin() const noexcept -> std::size_t { return points.size() / 3; }
+
+            /// @brief add a cell given the point indices and vtk type
+            void add_cell(std::initializer_list<std::int64_t> cell_points, std::int64_t vtk_type) {
+                connectivity.insert(connectivity.end(), cell_points.begin(), cell_points.end());
+                offsets.push_back(connectivity.size());
+                types.push_back(vtk_type);
+            }
+        };
+
+        /**
+         * @brief write an extracted grid as a vtu file
+         * @param path the file path
+         * @param grid the extracted points, cells, and values
+         * @param names the names of the fields
+         * @param format the data encoding
+         * @param compress zlib compress binary data
+         */
+        template<class T>
+        void write_sampled_vtu(const std::filesystem::path& path, const sampled_grid<T>& grid,
+                std::span<const std::string> names, vtu_format format, bool compress) {
+            std::ofstream out{path, std::ios::binary};
+            if(!out) {
+                util::AnomalyLog::log_anomaly(util::Anomaly{"could not open " + path.string() + " for writing",
+                        util::general_anomaly_tag{}});
+                return;
+            }
+            DataArrayWriter arrays{format, compress};
+            write_vtu_header(out, arrays.is_compressed());
+            write_open(XMLTag{"UnstructuredGrid"}, out);
+            write_open(XMLTag{"Piece", {
+                {"NumberOfPoints", std::to_string(grid.npoin())},
+                {"NumberOfCells", std::to_string(grid.types.size())}
+            }}, out);
+
+            write_open(XMLTag{"Points"}, out);
+            arrays.write(out, "Points", std::span<const T>{grid.points}, 3);
+            write_close(XMLTag{"Points"}, out);
+
+            write_open(XMLTag{"Cells"}, out);
+            arrays.write(out, "connectivity", std::span<const std::int64_t>{grid.connectivity});
+            arrays.write(out, "offsets", std::span<const std::int64_t>{grid.offsets});
+            arrays.write(out, "types", std::span<const std::int64_t>{grid.types});
+            write_close(XMLTag{"Cells"}, out);
+
+            write_open(XMLTag{"PointData"}, out);
+            std::vector<T> column(grid.npoin());
+            for(std::size_t ifield = 0; ifield < names.size(); ++ifield){
+                for(std::size_t ipoin = 0; ipoin < grid.npoin(); ++ipoin)
+                    { column[ipoin] = grid.values[ipoin * names.size() + ifield]; }
+                arrays.write(out, names[ifield], std::span<const T>{column});
+            }
+            write_close(XMLTag{"PointData"}, out);
+
+            write_close(XMLTag{"Piece"}, out);
+            write_close(XMLTag{"UnstructuredGrid"}, out);
+            arrays.write_appended(out);
+            write_vtu_footer(out);
+        }
+
+        /// @brief the file name of an extracted output "<collection><itime>[_rank<r>]<extension>"
+        inline auto extraction_filename(std::string_view collection_name, int itime, std::string_view extension)
+        -> std::string {
+            std::string name = std::string{collection_name} + std::to_string(itime);
+            if(mpi::mpi_world_size() > 1) name += "_rank" + std::to_string(mpi::mpi_world_rank());
+            return name + std::string{extension};
+        }
+    }
+
+    /**
+     * @brief samples the solution at probe points every output
+     *
+     * The probes are located with find_element once (or every output if relocate is set, i.e for moving meshes)
+     * and every output appends one line to "<collection_name>[_rank<r>].dat":
+     * the time index, the time, then the field values at every probe on this process
+     * (the header comment lists the probe order)
+     */
+    template<class T, class IDX, int ndim>
+    class ProbeWriter {
+        using Point = MATH::GEOMETRY::Point<T, ndim>;
+
+        FESpace<T, IDX, ndim>* fespace_ptr = nullptr;
+        impl::field_sampler<T, IDX, ndim> sampler{};
+
+        /// @brief the probes that are on this process and their locations
+        std::vector<std::size_t> local_probes{};
+        std::vector<element_point<T, IDX, ndim>> locations{};
+        bool located = false;
+
+        /// @brief if the file has been started (the first output truncates it)
+        bool started = false;
+
+        void locate() {
+            local_probes.clear();
+            locations.clear();
+            ElementBVH<T, IDX, ndim> bvh{*fespace_ptr};
+            auto found = find_elements(*fespace_ptr, bvh, std::span<const Point>{probes});
+            for(std::size_t iprobe = 0; iprobe < probes.size(); ++iprobe){
+                if(found[iprobe]){
+                    local_probes.push_back(iprobe);
+                    locations.push_back(found[iprobe].value());
+                }
+            }
+            located = true;
+        }
+
+        public:
+        using value_type = T;
+
+        std::string collection_name = "probes";
+        std::filesystem::path data_directory;
+
+        /// @brief the probe points in the physical domain
+        std::vector<Point> probes{};
+
+        /// @brief locate the probes again at every output (for moving meshes)
+        bool relocate = false;
+
+        ProbeWriter() : data_directory(std::filesystem::current_path() / "iceicle_data") {}
+
+        /// @brief register the finite element space the fields are defined on
+        void register_fespace(FESpace<T, IDX, ndim>& fespace) { fespace_ptr = &fespace; located = false; }
+
+        /// @brief register a set of fields represented in an fespan (must outlive the writer)
+        template<class LayoutPolicy, class AccessorPolicy>
+        void register_fields(fespan<T, LayoutPolicy, AccessorPolicy>& fedata, std::vector<std::string> field_names)
+        { sampler.add(fedata, field_names); }
+
+        /// @brief the number of probes found on this process
+        [[nodiscard]] auto nlocal() -> std::size_t {
+            if(!located) locate();
+            return local_probes.size();
+        }
+
+        /// @brief the field values at the located probes (nlocal() x nfield)
+        [[nodiscard]] auto sample() -> std::vector<T> {
+            if(!located || relocate) locate();
+            std::vector<T> values(local_probes.size() * sampler.nfield());
+            for(std::size_t i = 0; i < locations.size(); ++i){
+                sampler.sample(fespace_ptr->elements[locations[i].iel], locations[i].xi,
+                        values.data() + i * sampler.nfield());
+            }
+            return values;
+        }
+
+        /// @brief append the probe values for one output
+        void write_probes(int itime, T time) {
+            if(fespace_ptr == nullptr){
+                util::AnomalyLog::log_anomaly(util::Anomaly{"fespace not set for probe writer", util::general_anomaly_tag{}});
+                return;
+            }
+            std::vector<T> values = sample();
+            std::filesystem::create_directories(data_directory);
+            std::string name = collection_name;
+            if(mpi::mpi_world_size() > 1) name += "_rank" + std::to_string(mpi::mpi_world_rank());
+            std::ofstream out{data_directory / (name + ".dat"), started ? std::ios::app : std::ios::trunc};
+            if(!out) {
+                util::AnomalyLog::log_anomaly(util::Anomaly{"could not open probe file for writing", util::general_anomaly_tag{}});
+                return;
+            }
+            std::string buffer{};
+            auto it = std::back_inserter(buffer);
+            if(!started){
+                fmt::format_to(it, "# itime time");
+                for(std::size_t iprobe : local_probes){
+                    for(const std::string& field : sampler.names) fmt::format_to(it, " {}[{}]", field, iprobe);
+                }
+                buffer.push_back('\n');
+            }
+            fmt::format_to(it, "{} {:.10e}", itime, time);
+            for(T value : values) fmt::format_to(it, " {:.10e}", value);
+            buffer.push_back('\n');
+            out.write(buffer.data(), buffer.size());
+            started = true;
+        }
+
+        void rename_collection(std::string_view new_name) { collection_name = new_name; }
+    };
+
+    /**
+     * @brief samples the solution on a regular grid over a line segment (2D) or a parallelogram (3D) slice
+     *
+     * The grid points are origin + i / (n[0] - 1) * u + j / (n[1] - 1) * v located with find_element,
+     * a cell (line or quad) is output when all of its points are in the domain on this process.
+     * Each output is written to "<collection_name><itime>[_rank<r>].vtu"
+     */
+    template<class T, class IDX, int ndim>
+    class SliceWriter {
+        using Point = MATH::GEOMETRY::Point<T, ndim>;
+
+        FESpace<T, IDX, ndim>* fespace_ptr = nullptr;
+        impl::field_sampler<T, IDX, ndim> sampler{};
+
+        public:
+        using value_type = T;
+
+        std::string collection_name = "slice";
+        std::filesystem::path data_directory;
+
+        /// @brief the origin of the slice
+        Point origin{};
+
+        /// @brief the edges of the slice from the origin (v is only used in 3D)
+        Point u{}, v{};
+
+        /// @brief the number of grid points along u and v
+        std::array<int, 2> n{32, 32};
+
+        vtu_format format = vtu_format::ascii;
+        bool compress = false;
+
+        SliceWriter() : data_directory(std::filesystem::current_path() / "iceicle_data") {}
+
+        void register_fespace(FESpace<T, IDX, ndim>& fespace) { fespace_ptr = &fespace; }
+
+        /// @brief register a set of fields represented in an fespan (must outlive the writer)
+        template<class LayoutPolicy, class AccessorPolicy>
+        void register_fields(fespan<T, LayoutPolicy, AccessorPolicy>& fedata, std::vector<std::string> field_names)
+        { sampler.add(fedata, field_names); }
+
+        /// @brief sample the slice
+        [[nodiscard]] auto extract() const -> impl::sampled_grid<T> {
+            static_assert(ndim == 2 || ndim == 3, "slices are defined in 2D and 3D");
+            impl::sampled_grid<T> grid{};
+            int nu = std::max(n[0], 2);
+            int nv = (ndim == 3) ? std::max(n[1], 2) : 1;
+            std::vector<Point> xs(nu * nv);
+            for(int j = 0; j < nv; ++j){
+                for(int i = 0; i < nu; ++i){
+                    Point& x = xs[j * nu + i];
+                    x = origin;
+                    for(int idim = 0; idim < ndim; ++idim){
+                        x[idim] += u[idim] * i / (nu - 1.0);
+                        if(ndim == 3) x[idim] += v[idim] * j / (nv - 1.0);
+                    }
+                }
+            }
+            ElementBVH<T, IDX, ndim> bvh{*fespace_ptr};
+            auto found = find_elements(*fespace_ptr, bvh, std::span<const Point>{xs});
+            std::vector<std::int64_t> ipoin(nu * nv, -1);
+            for(std::size_t k = 0; k < xs.size(); ++k){
+                if(!found[k]) continue;
+                ipoin[k] = grid.npoin();
+                for(int idim = 0; idim < 3; ++idim) grid.points.push_back((idim < ndim) ? xs[k][idim] : 0.0);
+                grid.values.resize(grid.values.size() + sampler.nfield());
+                sampler.sample(fespace_ptr->elements[found[k]->iel], found[k]->xi,
+                        grid.values.data() + grid.values.size() - sampler.nfield());
+            }
+            if constexpr (ndim == 2) {
+                for(int i = 0; i + 1 < nu; ++i){
+                    if(ipoin[i] >= 0 && ipoin[i + 1] >= 0) grid.add_cell({ipoin[i], ipoin[i + 1]}, 3);
+                }
+            } else {
+                for(int j = 0; j + 1 < nv; ++j){
+                    for(int i = 0; i + 1 < nu; ++i){
+                        std::int64_t p0 = ipoin[j * nu + i], p1 = ipoin[j * nu + i + 1],
+                            p2 = ipoin[(j + 1) * nu + i + 1], p3 = ipoin[(j + 1) * nu + i];
+                        if(p0 >= 0 && p1 >= 0 && p2 >= 0 && p3 >= 0) grid.add_cell({p0, p1, p2, p3}, 9);
+                    }
+                }
+            }
+            return grid;
+        }
+
+        void write_slice(int itime, T time) {
+            if(fespace_ptr == nullptr){
+                util::AnomalyLog::log_anomaly(util::Anomaly{"fespace not set for slice writer", util::general_anomaly_tag{}});
+                return;
+            }
+            std::filesystem::create_directories(data_directory);
+            impl::write_sampled_vtu(data_directory / impl::extraction_filename(collection_name, itime, ".vtu"),
+                    extract(), std::span<const std::string>{sampler.names}, format, compress);
+        }
+
+        void rename_collection(std::string_view new_name) { collection_name = new_name; }
+    };
+
+    /**
+     * @brief samples the solution on the boundary faces with the selected boundary condition flags
+     *
+     * Each face is subdivided into nsample points per direction (the refinement level of the output):
+     * line cells in 2D, quads or triangles in 3D.
+     * Each output is written to "<collection_name><itime>[_rank<r>].vtu"
+     */
+    template<class T, class IDX, int ndim>
+    class SurfaceWriter {
+        using Point = MATH::GEOMETRY::Point<T, ndim>;
+
+        FESpace<T, IDX, ndim>* fespace_ptr = nullptr;
+        impl::field_sampler<T, IDX, ndim> sampler{};
+
+        public:
+        using value_type = T;
+
+        std::string collection_name = "surface";
+        std::filesystem::path data_directory;
+
+        /// @brief the boundary condition flags of the faces to output (empty for all boundary faces)
+        std::vector<int> bcflags{};
+
+        /// @brief the number of sample points along each direction of a face
+        int nsample = 4;
+
+        vtu_format format = vtu_format::ascii;
+        bool compress = false;
+
+        SurfaceWriter() : data_directory(std::filesystem::current_path() / "iceicle_data") {}
+
+        void register_fespace(FESpace<T, IDX, ndim>& fespace) { fespace_ptr = &fespace; }
+
+        /// @brief register a set of fields represented in an fespan (must outlive the writer)
+        template<class LayoutPolicy, class AccessorPolicy>
+        void register_fields(fespan<T, LayoutPolicy, AccessorPolicy>& fedata, std::vector<std::string> field_names)
+        { sampler.add(fedata, field_names); }
+
+        /// @brief sample the selected boundary faces
+        [[nodiscard]] auto extract() const -> impl::sampled_grid<T> {
+            static_assert(ndim == 2 || ndim == 3, "surfaces are defined in 2D and 3D");
+            using FacePoint = MATH::GEOMETRY::Point<T, ndim - 1>;
+            impl::sampled_grid<T> grid{};
+            AbstractMesh<T, IDX, ndim>& mesh = *fespace_ptr->meshptr;
+            int ns = std::max(nsample, 2);
+
+            // add a sample point on the face and return its index
+            auto add_point = [&](const Face<T, IDX, ndim>& face, const FacePoint& s) -> std::int64_t {
+                const FiniteElement<T, IDX, ndim>& el = fespace_ptr->elements[face.elemL];
+                Point xi;
+                face.transform_xiL(s, xi);
+                Point x = el.transform(xi);
+                std::int64_t ipoin = grid.npoin();
+                for(int idim = 0; idim < 3; ++idim) grid.points.push_back((idim < ndim) ? x[idim] : 0.0);
+                grid.values.resize(grid.values.size() + sampler.nfield());
+                sampler.sample(el, xi, grid.values.data() + grid.values.size() - sampler.nfield());
+                return ipoin;
+            };
+
+            for(IDX ifac = mesh.bdyFaceStart; ifac < mesh.bdyFaceEnd; ++ifac){
+                const Face<T, IDX, ndim>& face = *mesh.faces[ifac];
+                if(face.bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) continue;
+                if(!bcflags.empty() && std::ranges::find(bcflags, face.bcflag) == bcflags.end()) continue;
+
+                if constexpr (ndim == 2) {
+                    std::int64_t previous = -1;
+                    for(int i = 0; i < ns; ++i){
+                        FacePoint s{-1.0 + 2.0 * i / (ns - 1.0)};
+                        std::int64_t ipoin = add_point(face, s);
+                        if(previous >= 0) grid.add_cell({previous, ipoin}, 3);
+                        previous = ipoin;
+                    }
+                } else if(face.domain_type() == DOMAIN_TYPE::HYPERCUBE) {
+                    std::vector<std::int64_t> ipoin(ns * ns);
+                    for(int j = 0; j < ns; ++j){
+                        for(int i = 0; i < ns; ++i)
+                            { ipoin[j * ns + i] = add_point(face, FacePoint{-1.0 + 2.0 * i / (ns - 1.0), -1.0 + 2.0 * j / (ns - 1.0)}); }
+                    }
+                    for(int j = 0; j + 1 < ns; ++j){
+                        for(int i = 0; i + 1 < ns; ++i){
+                            grid.add_cell({ipoin[j * ns + i], ipoin[j * ns + i + 1],
+                                    ipoin[(j + 1) * ns + i + 1], ipoin[(j + 1) * ns + i]}, 9);
+                        }
+                    }
+                } else {
+                    // triangular face: points with i + j < ns
+                    std::vector<std::int64_t> ipoin(ns * ns, -1);
+                    for(int j = 0; j < ns; ++j){
+                        for(int i = 0; i + j < ns; ++i)
+                            { ipoin[j * ns + i] = add_point(face, FacePoint{i / (ns - 1.0), j / (ns - 1.0)}); }
+                    }
+                    for(int j = 0; j + 1 < ns; ++j){
+                        for(int i = 0; i + j + 1 < ns; ++i){
+                            grid.add_cell({ipoin[j * ns + i], ipoin[j * ns + i + 1], ipoin[(j + 1) * ns + i]}, 5);
+                            if(i + j + 2 < ns) grid.add_cell({ipoin[j * ns + i + 1], ipoin[(j + 1) * ns + i + 1],
+                                    ipoin[(j + 1) * ns + i]}, 5);
+                        }
+                    }
+                }
+            }
+            return grid;
+        }
+
+        void write_surface(int itime, T time) {
+            if(fespace_ptr == nullptr){
+                util::AnomalyLog::log_anomaly(util::Anomaly{"fespace not set for surface writer", util::general_anomaly_tag{}});
+                return;
+            }
+            std::filesystem::create_directories(data_directory);
+            impl::write_sampled_vtu(data_directory / impl::extraction_filename(collection_name, itime, ".vtu"),
+                    extract(), std::span<const std::string>{sampler.names}, format, compress);
+        }
+
+        void rename_collection(std::string_view new_name) { collection_name = new_name; }
+    };
+
+    /**
+     * @brief a frame published by the LiveWriter
+     *
+     * The points are the vtk nodes of every element (duplicated between elements as in the vtu output)
+     * and cell icell is the points offsets[icell - 1] to offsets[icell] (from 0 for the first cell)
+     * Coordinates and values are single precision to halve the copy and upload to the viewer
+     */
+    struct live_frame {
+        int itime;
+        double time;
+
+        /// @brief the name of every field
+        std::vector<std::string> names{};
+
+        /// @brief the point coordinates (npoin x 3)
+        std::vector<float> points{};
+
+        /// @brief the field values (npoin x nfield)
+        std::vector<float> values{};
+
+        /// @brief the end offset of each cell in the points
+        std::vector<std::uint32_t> offsets{};
+
+        /// @brief the vtk type of each cell
+        std::vector<std::uint8_t> types{};
+
+        [[nodiscard]] auto npoin() const noexcept -> std::size_t { return points.size() / 3; }
+        [[nodiscard]] auto nfield() const noexcept -> std::size_t { return names.size(); }
+    };
+
+    namespace impl {
+        /// @brief the fixed size start of an encoded live frame
+        struct live_frame_header {
+            std::uint64_t npoin;
+            std::uint64_t ncell;
+            std::uint64_t nfield;
+            std::uint64_t names_bytes;
+            std::int64_t itime;
+            double time;
+        };
+
+        /// @brief append the bytes of a range of trivially copyable values
+        template<class V>
+        void append_bytes(std::vector<std::byte>& bytes, std::span<const V> values) {
+            std::size_t start = bytes.size();
+            bytes.resize(start + values.size_bytes());
+            std::memcpy(bytes.data() + start, values.data(), values.size_bytes());
+        }
+
+        /// @brief encode a sampled grid with duplicated points per cell as a live frame
+        template<class T>
+        auto encode_live_frame(const sampled_grid<T>& grid, std::span<const std::string> names,
+                int itime, T time) -> std::vector<std::byte> {
+            std::string names_joined{};
+            for(const std::string& name : names) { names_joined += name; names_joined.push_back('\0'); }
+            live_frame_header header{grid.npoin(), grid.types.size(), names.size(),
+                names_joined.size(), itime, static_cast<double>(time)};
+
+            std::vector<float> points(grid.points.begin(), grid.points.end());
+            std::vector<float> values(grid.values.begin(), grid.values.end());
+            std::vector<std::uint32_t> offsets(grid.offsets.begin(), grid.offsets.end());
+            std::vector<std::uint8_t> types(grid.types.begin(), grid.types.end());
+
+            std::vector<std::byte> bytes{};
+            bytes.reserve(sizeof(header) + names_joined.size() + 4 * (points.size() + values.size() + offsets.size())
+                    + types.size());
+            append_bytes(bytes, std::span<const live_frame_header>{&header, 1});
+            append_bytes(bytes, std::span<const char>{names_joined});
+            append_bytes(bytes, std::span<const float>{points});
+            append_bytes(bytes, std::span<const float>{values});
+            append_bytes(bytes, std::span<const std::uint32_t>{offsets});
+            append_bytes(bytes, std::span<const std::uint8_t>{types});
+            return bytes;
+        }
+    }
+
+    /**
+     * @brief decode a frame read from the shared memory ring of a LiveWriter
+     * @return the frame or nullopt if the bytes are not a complete frame
+     */
+    inline auto decode_live_frame(std::span<const std::byte> bytes) -> std::optional<live_frame> {
+        impl::live_frame_header header;
+        if(bytes.size() < sizeof(header)) return std::nullopt;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        std::size_t nbytes = sizeof(header) + header.names_bytes
+            + sizeof(float) * (3 + header.nfield) * header.npoin
+            + (sizeof(std::uint32_t) + sizeof(std::uint8_t)) * header.ncell;
+        if(bytes.size() != nbytes) return std::nullopt;
+
+        live_frame frame{static_cast<int>(header.itime), header.time};
+        std::size_t pos = sizeof(header);
+        auto read = [&]<class V>(std::vector<V>& values, std::size_t n){
+            values.resize(n);
+            std::memcpy(values.data(), bytes.data() + pos, n * sizeof(V));
+            pos += n * sizeof(V);
+        };
+        std::vector<char> names_joined;
+        read(names_joined, header.names_bytes);
+        for(auto it = names_joined.begin(); it != names_joined.end();){
+            auto end = std::find(it, names_joined.end(), '\0');
+            frame.names.emplace_back(it, end);
+            it = (end == names_joined.end()) ? end : end + 1;
+        }
+        if(frame.names.size() != header.nfield) return std::nullopt;
+        read(frame.points, 3 * header.npoin);
+        read(frame.values, header.nfield * header.npoin);
+        read(frame.offsets, header.ncell);
+        read(frame.types, header.ncell);
+        return frame;
+    }
+
+    /**
+     * @brief publishes the solution at the vtk nodes of every element to a shared memory ring
+     * for a viewer attached to the running simulation (see decode_live_frame)
+     *
+     * Nothing is written to disk and the solver never waits on the viewer.
+     * The ring is named shm_name (with "_rank<r>" appended for multiple processes)
+     * and is recreated with a larger slot size if the frame grows (i.e from p-adaptation)
+     */
+    template<class T, class IDX, int ndim>
+    class LiveWriter {
+        using Point = MATH::GEOMETRY::Point<T, ndim>;
+
+        FESpace<T, IDX, ndim>* fespace_ptr = nullptr;
+        impl::field_sampler<T, IDX, ndim> sampler{};
+
+        /// @brief shared so copies of the writer (type erasure) publish to the same ring
+        std::shared_ptr<util::shared_memory_ring> ring{};
+
+        public:
+        using value_type = T;
+
+        /// @brief the shared memory name of the ring
+        std::string shm_name = "/iceicle_live";
+
+        /// @brief the number of frames kept in the ring
+        std::uint32_t nslot = 3;
+
+        void register_fespace(FESpace<T, IDX, ndim>& fespace) { fespace_ptr = &fespace; }
+
+        /// @brief register a set of fields represented in an fespan (must outlive the writer)
+        template<class LayoutPolicy, class AccessorPolicy>
+        void register_fields(fespan<T, LayoutPolicy, AccessorPolicy>& fedata, std::vector<std::string> field_names)
+        { sampler.add(fedata, field_names); }
+
+        /// @brief sample the fields at the vtk nodes of every element
+        [[nodiscard]] auto extract() const -> impl::sampled_grid<T> {
+            impl::sampled_grid<T> grid{};
+            for(const FiniteElement<T, IDX, ndim>& el : fespace_ptr->elements){
+                impl::VTKElement<T, ndim>& vtk_el = impl::get_vtk_element(el.trans, el.basis->getPolynomialOrder());
+                for(const Point& refnode : vtk_el.nodes){
+                    Point x = el.transform(refnode);
+                    for(int idim = 0; idim < 3; ++idim) grid.points.push_back((idim < ndim) ? x[idim] : 0.0);
+                    grid.values.resize(grid.values.size() + sampler.nfield());
+                    sampler.sample(el, refnode, grid.values.data() + grid.values.size() - sampler.nfield());
+                }
+                grid.offsets.push_back(grid.npoin());
+                grid.types.push_back(vtk_el.vtk_id);
+            }
+            return grid;
+        }
+
+        /// @brief publish the current solution as the latest frame
+        void publish(int itime, T time) {
+            if(fespace_ptr == nullptr){
+                util::AnomalyLog::log_anomaly(util::Anomaly{"fespace not set for live writer", util::general_anomaly_tag{}});
+                return;
+            }
+            std::vector<std::byte> frame = impl::encode_live_frame(extract(),
+                    std::span<const std::string>{sampler.names}, itime, time);
+            if(!ring || frame.size() > ring->slot_bytes()){
+                // closing the old ring tells attached viewers to attach again
+                ring.reset();
+                std::string name = shm_name;
+                if(mpi::mpi_world_size() > 1) name += "_rank" + std::to_string(mpi::mpi_world_rank());
+                std::optional<util::shared_memory_ring> created =
+                    util::shared_memory_ring::create(name, frame.size() + frame.size() / 4, nslot);
+                if(!created) return;
+                ring = std::make_shared<util::shared_memory_ring>(std::move(created.value()));
+            }
+            ring->publish(frame);
+        }
+
+        /// @brief the ring is named by shm_name
+        void rename_collection(std::string_view new_name) {}
+    };
+
+    /// @brief external function interface for type erasure to write a file
+    /// writes the file with the given time index and time values
+    template<class T, class IDX, int ndim>
+    auto write_file(ProbeWriter<T, IDX, ndim>& writer, int itime, T time) -> void {
+        writer.write_probes(itime, time);
+    }
+
+    /// @brief external function interface for type erasure to write a file
+    /// writes the file with the given time index and time values
+    template<class T, class IDX, int ndim>
+    auto write_file(SliceWriter<T, IDX, ndim>& writer, int itime, T time) -> void {
+        writer.write_slice(itime, time);
+    }
+
+    /// @brief external function interface for type erasure to write a file
+    /// writes the file with the given time index and time values
+    template<class T, class IDX, int ndim>
+    auto write_file(SurfaceWriter<T, IDX, ndim>& writer, int itime, T time) -> void {
+        writer.write_surface(itime, time);
+    }
+
+    /// @brief external function interface for type erasure to write a file
+    /// publishes the frame with the given time index and time values
+    template<class T, class IDX, int ndim>
+    auto write_file(LiveWriter<T, IDX, ndim>& writer, int itime, T time) -> void {
+        writer.publish(itime, time);
+    }
+}
@@ -0,0 +1,146 @@
+/// @brief time history of scalar functionals (i.e integrated forces) in a compact binary file
+/// @author Gianni Absillis (gabsill@ncsu.edu)
+#pragma once
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace iceicle::io {
+
+    /**
+     * @brief appends the values of a set of scalar functionals at every output
+     * to "<collection_name>.bin" in the data directory
+     *
+     * The functionals are evaluated on every process (evaluate may be collective)
+     * and only rank 0 writes.
+     * The file starts with a header:
+     * - the 8 character magic "ICEFUNC1"
+     * - uint32 the number of values, uint32 sizeof(T)
+     * - for each value: uint32 length of the name followed by the characters
+     *
+     * followed by one record per output: int64 itime, T time, T values[nvalue]
+     * so the history can be memory mapped as a fixed stride array after the header
+     */
+    template<class T>
+    class FunctionalWriter {
+
+        /// @brief if the file has been started (the first output truncates it)
+        bool started = false;
+
+        public:
+        using value_type = T;
+
+        std::string collection_name = "functionals";
+        std::filesystem::path data_directory;
+
+        /// @brief the name of each value
+        std::vector<std::string> names{};
+
+        /// @brief compute the values (same size as names)
+        std::function<std::vector<T>()> evaluate{};
+
+        FunctionalWriter() : data_directory(std::filesystem::current_path() / "iceicle_data") {}
+
+        /// @brief evaluate the functionals and append a record
+        void write_functionals(int itime, T time) {
+            if(!evaluate){
+                util::AnomalyLog::log_anomaly(util::Anomaly{"no functionals set for functional writer", util::general_anomaly_tag{}});
+                return;
+            }
+            std::vector<T> values = evaluate();
+            if(values.size() != names.size()){
+                util::AnomalyLog::log_anomaly(util::Anomaly{"number of functional values does not match the names", util::general_anomaly_tag{}});
+                return;
+            }
+            if(mpi::mpi_world_rank() != 0) { started = true; return; }
+
+            std::filesystem::create_directories(data_directory);
+            std::ofstream out{data_directory / (collection_name + ".bin"),
+                std::ios::binary | (started ? std::ios::app : std::ios::trunc)};
+            if(!out) {
+                util::AnomalyLog::log_anomaly(util::Anomaly{"could not open functional file for writing", util::general_anomaly_tag{}});
+                return;
+            }
+            auto write_u32 = [&out](std::uint32_t n){ out.write(reinterpret_cast<const char*>(&n), sizeof(n)); };
+            if(!started){
+                out.write("ICEFUNC1", 8);
+                write_u32(names.size());
+                write_u32(sizeof(T));
+                for(const std::string& name : names){
+                    write_u32(name.size());
+                    out.write(name.data(), name.size());
+                }
+            }
+            std::int64_t itime_record = itime;
+            out.write(reinterpret_cast<const char*>(&itime_record), sizeof(itime_record));
+            out.write(reinterpret_cast<const char*>(&time), sizeof(T));
+            out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+            started = true;
+        }
+
+        void rename_collection(std::string_view new_name) { collection_name = new_name; started = false; }
+    };
+
+    /// @brief the contents of a functional history file
+    template<class T>
+    struct FunctionalHistory {
+        std::vector<std::string> names{};
+        std::vector<std::int64_t> itimes{};
+        std::vector<T> times{};
+
+        /// @brief the values of each record (names.size() per record)
+        std::vector<T> values{};
+    };
+
+    /**
+     * @brief read a file written by FunctionalWriter
+     * @param path the path to the file
+     * @return the history (empty with an anomaly if the file is not a functional history of this precision)
+     */
+    template<class T>
+    auto read_functional_history(const std::filesystem::path& path) -> FunctionalHistory<T> {
+        FunctionalHistory<T> history{};
+        std::ifstream in{path, std::ios::binary};
+        char magic[8];
+        std::uint32_t nvalue, value_size;
+        auto read_u32 = [&in](std::uint32_t& n){ in.read(reinterpret_cast<char*>(&n), sizeof(n)); };
+        in.read(magic, 8);
+        read_u32(nvalue);
+        read_u32(value_size);
+        if(!in || std::string_view{magic, 8} != "ICEFUNC1" || value_size != sizeof(T)){
+            util::AnomalyLog::log_anomaly(util::Anomaly{"not a functional history file of this precision: " + path.string(),
+                    util::general_anomaly_tag{}});
+            return history;
+        }
+        for(std::uint32_t i = 0; i < nvalue; ++i){
+            std::uint32_t len;
+            read_u32(len);
+            std::string name(len, ' ');
+            in.read(name.data(), len);
+            history.names.push_back(name);
+        }
+        std::int64_t itime;
+        T time;
+        std::vector<T> record(nvalue);
+        while(in.read(reinterpret_cast<char*>(&itime), sizeof(itime))){
+            in.read(reinterpret_cast<char*>(&time), sizeof(T));
+            in.read(reinterpret_cast<char*>(record.data()), nvalue * sizeof(T));
+            if(!in) break; // truncated last record
+            history.itimes.push_back(itime);
+            history.times.push_back(time);
+            history.values.insert(history.values.end(), record.begin(), record.end());
+        }
+        return history;
+    }
+
+    template<class T>
+    auto write_file(FunctionalWriter<T>& writer, int itime, T time) -> void {
+        writer.write_functionals(itime, time);
+    }
+}
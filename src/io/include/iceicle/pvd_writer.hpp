@@ -4,12 +4,24 @@
  */
 #pragma once
 #include "iceicle/anomaly_log.hpp"
+#include "iceicle/build_config.hpp"
 #include "iceicle/element/finite_element.hpp"
 #include "iceicle/fe_definitions.hpp"
 #include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fe_function/solution_version.hpp"
 #include "iceicle/geometry/geo_element.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/thread_utils.hpp"
 #include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <ostream>
+#include <span>
+#include <string_view>
+#include <type_traits>
 #include <stdexcept>
 #include <vector>
 #include <string>
@@ -19,9 +31,31 @@
 #include <cassert>
 #include <iomanip>
 #include <fstream>
+#include <sstream>
+#include <utility>
+#ifdef ICEICLE_USE_MPI
+#include <mpi.h>
+#endif
 #include <filesystem>
 namespace iceicle::io {
 
+    /// @brief the encoding of the DataArray values in a vtu file
+    enum class vtu_format {
+        /// the values are written as text inside each DataArray
+        ascii,
+
+        /// the values are in the AppendedData section as base64 encoded binary
+        base64,
+
+        /// the values are in the AppendedData section as raw binary 
+        /// (smallest and fastest to read and write but the file is no longer valid xml)
+        raw,
+
+        /// the values are written as base64 encoded binary inside each DataArray
+        /// (used for aggregated parallel output where pieces from several ranks share a file)
+        binary
+    };
+
     namespace impl{
 
         struct XMLField{
@@ -46,12 +80,142 @@ namespace iceicle::io {
         /**@brief write a closing XML tag </tagname> */
         void write_close(const XMLTag &tag, std::ostream &out);
 
-        /** write the VTKFile header tag */
-        void write_vtu_header(std::ostream &out);
+        /** 
+         * write the VTKFile header tag 
+         * @param compressed if the appended data blocks are zlib compressed
+         */
+        void write_vtu_header(std::ostream &out, bool compressed = false);
 
         /** close the VTKFile header tag */
         void write_vtu_footer(std::ostream &out);
 
+        /// @brief the vtk type name for the values of a DataArray
+        template<class V>
+        constexpr auto vtk_type_name() -> const char* {
+            if constexpr (std::is_same_v<V, double>) return "Float64";
+            else if constexpr (std::is_same_v<V, float>) return "Float32";
+            else if constexpr (std::is_same_v<V, std::int64_t>) return "Int64";
+            else if constexpr (std::is_same_v<V, std::int32_t>) return "Int32";
+            else static_assert(!std::is_same_v<V, V>, "unsupported vtk data type");
+        }
+
+        /// @brief evaluate the basis functions of an element at all the given reference domain nodes in one batch
+        /// @return the basis function values [nnode][nbasis]
+        template<class T, class IDX, int ndim>
+        auto eval_basis_at_nodes(
+            const FiniteElement<T, IDX, ndim>& el,
+            const std::vector<MATH::GEOMETRY::Point<T, ndim>>& nodes
+        ) -> std::vector<T> {
+            std::vector<T> xi(nodes.size() * ndim);
+            for(std::size_t inode = 0; inode < nodes.size(); ++inode)
+                std::copy_n(nodes[inode].data(), ndim, xi.data() + inode * ndim);
+            std::vector<T> basis_data(nodes.size() * el.nbasis());
+            el.basis->evalBasisBatch(nodes.size(), xi.data(), basis_data.data());
+            return basis_data;
+        }
+
+        /**
+         * @brief writes the DataArray elements of a vtu file in the selected format
+         *
+         * For the appended formats each DataArray is an empty tag with the offset of its block
+         * in the AppendedData section, which is collected here and written with write_appended()
+         * after the UnstructuredGrid is closed.
+         * A block is the UInt64 byte count followed by the data
+         * or the vtkZLibDataCompressor block header followed by the compressed blocks
+         */
+        class DataArrayWriter {
+            vtu_format format;
+            bool compress;
+
+            /// @brief the encoded blocks of the AppendedData section
+            std::string appended{};
+
+            /// @brief the PDataArray tags of the arrays written (for the parallel .pvtu file)
+            std::vector<XMLTag> written_tags{};
+
+            /// @brief encode a block (with its header) and append to dest
+            void encode_block(std::span<const std::byte> bytes, std::string &dest) const;
+
+            /// @brief encode the values as a block: to the appended data or inline
+            /// @return the offset of the block in the appended data
+            template<class V>
+            auto write_block(std::ostream &out, std::span<const V> values) -> std::size_t {
+                std::size_t offset = appended.size();
+                std::string inline_block{};
+                std::string &dest = (format == vtu_format::binary) ? inline_block : appended;
+                encode_block(std::as_bytes(values), dest);
+                if(format == vtu_format::binary) out << inline_block << '\n';
+                return offset;
+            }
+
+            public:
+
+            /**
+             * @param format the encoding of the values
+             * @param compress zlib compress the binary blocks 
+             *        (requires ICEICLE_USE_ZLIB, ignored for ascii)
+             */
+            DataArrayWriter(vtu_format format = vtu_format::ascii, bool compress = false);
+
+            /// @brief if the binary blocks are compressed
+            [[nodiscard]] auto is_compressed() const noexcept -> bool { return compress; }
+
+            /**
+             * @brief write a DataArray
+             * @param out the vtu file
+             * @param name the Name of the array
+             * @param values the values (component fastest)
+             * @param ncomp the NumberOfComponents
+             */
+            template<class V>
+            void write(std::ostream &out, std::string_view name, std::span<const V> values, int ncomp = 1) {
+                // extended precision is written as Float64
+                using out_t = std::conditional_t<
+                    std::is_floating_point_v<V> && !std::is_same_v<V, float>, double, V>;
+
+                std::vector<XMLField> fields{
+                    {"type", vtk_type_name<out_t>()},
+                    {"Name", std::string{name}}
+                };
+                if(ncomp > 1) fields.push_back({"NumberOfComponents", std::to_string(ncomp)});
+                written_tags.push_back(XMLTag{"PDataArray", fields});
+                if(format == vtu_format::ascii){
+                    fields.push_back({"format", "ascii"});
+                    write_open(XMLTag{"DataArray", fields}, out);
+                    const std::size_t values_per_line = (ncomp > 1) ? ncomp : 8;
+                    for(std::size_t i = 0; i < values.size(); ++i){
+                        out << values[i] << (((i + 1) % values_per_line == 0) ? '\n' : ' ');
+                    }
+                    if(values.size() % values_per_line != 0) out << '\n';
+                    write_close(XMLTag{"DataArray"}, out);
+                } else {
+                    std::vector<out_t> converted{};
+                    if constexpr (!std::is_same_v<out_t, V>) converted.assign(values.begin(), values.end());
+                    auto write_values = [&](std::ostream& block_out) {
+                        if constexpr (std::is_same_v<out_t, V>) return write_block(block_out, values);
+                        else return write_block(block_out, std::span<const out_t>{converted});
+                    };
+                    if(format == vtu_format::binary) {
+                        fields.push_back({"format", "binary"});
+                        write_open(XMLTag{"DataArray", fields}, out);
+                        write_values(out);
+                        write_close(XMLTag{"DataArray"}, out);
+                    } else {
+                        std::size_t offset = write_values(out);
+                        fields.push_back({"format", "appended"});
+                        fields.push_back({"offset", std::to_string(offset)});
+                        write_empty(XMLTag{"DataArray", fields}, out);
+                    }
+                }
+            }
+
+            /// @brief the PDataArray tags of every array written in order
+            [[nodiscard]] auto written() const noexcept -> std::span<const XMLTag> { return written_tags; }
+
+            /// @brief write the AppendedData section and clear the blocks (nothing for ascii)
+            void write_appended(std::ostream &out);
+        };
+
         // =====================
         // = VTK Element Types =
         // =====================
@@ -166,18 +330,26 @@ namespace iceicle::io {
             .vtk_id = 10
         };
 
+        /// @brief the maximum polynomial order of the vtk cells (the output refinement level)
+        /// set by the writer for the duration of a write
+        inline auto vtk_max_order() -> int& {
+            static int max_order = std::numeric_limits<int>::max();
+            return max_order;
+        }
+
         /**
          * @brief get the VTKElement based on the Element 
          * @param el the element 
          * @param basis_order an optional basis order argument
          *        uses the maximum polynomial order between the element and basis order 
+         *        (limited to vtk_max_order())
          */
         template<typename T, typename IDX, int ndim>
         VTKElement<T, ndim> &get_vtk_element(const ElementTransformation<T, IDX, ndim> *el, int basis_order = 1){
 
             static VTKElement<T, ndim> NO_ELEMENT{};
 
-            int max_order = std::max(el->order, basis_order);
+            int max_order = std::min(std::max(el->order, basis_order), vtk_max_order());
             if constexpr (ndim == 2){
                 switch(el->domain_type){
 
@@ -251,7 +423,8 @@ namespace iceicle::io {
         */
         struct writeable_field {
             /// @brief adds the xml DataArray tags and data to a given vtu file 
-            virtual void write_data(std::ofstream &vtu_file, FESpace<T, IDX, ndim> &fespace) const = 0;
+            virtual void write_data(std::ostream &vtu_file, impl::DataArrayWriter &arrays,
+                    FESpace<T, IDX, ndim> &fespace) const = 0;
 
             /// @brief if this data is in dg format and requires duplicated mesh nodes
             virtual auto is_dg_format() const -> bool { return true; }
@@ -291,18 +464,61 @@ namespace iceicle::io {
             /// the discretization
             disc_t& disc;
 
+            /// the version of the solution and mesh the residuals below were computed for
+            /// (writing the same state again reuses them)
+            mutable std::optional<solution_version> computed_version{};
+
+            /// the number of vtk points of the computed residuals
+            mutable std::size_t n_vtk_poin = 0;
+
+            /// the full, domain, and trace residuals at the vtk points [n_vtk_poin x nresidual]
+            mutable std::vector<T> res_storage{}, domain_storage{}, trace_storage{};
+
             /// Constructor
             ResidualsField(fespan<T, LayoutPolicy, AccessorPolicy> fedata, 
                 std::vector<std::string> residual_names, disc_t& disc)
             : fedata{fedata}, residual_names{residual_names}, disc{disc}
             {}
 
-            void write_data(std::ofstream &vtu_file, FESpace<T, IDX, ndim>& fespace) const override 
+            void write_data(std::ostream &vtu_file, impl::DataArrayWriter &arrays,
+                    FESpace<T, IDX, ndim>& fespace) const override 
             {
+                solution_version version = get_solution_version(fedata, fespace.meshptr->coord_version);
+                if(!computed_version || !(computed_version.value() == version)){
+                    compute_residuals(fespace);
+                    computed_version = version;
+                }
+                std::mdspan res_mat{ res_storage.data(), n_vtk_poin, residual_names.size() };
+                std::mdspan domain_mat{ domain_storage.data(), n_vtk_poin, residual_names.size() };
+                std::mdspan trace_mat{ trace_storage.data(), n_vtk_poin, residual_names.size() };
+
+                // write a column of a residual matrix as a DataArray
+                std::vector<T> column(n_vtk_poin);
+                auto write_column = [&](std::string name, auto mat, std::size_t ifield){
+                    for(std::size_t ipoin = 0; ipoin < n_vtk_poin; ++ipoin)
+                        { column[ipoin] = mat[ipoin, ifield]; }
+                    arrays.write(vtu_file, name, std::span<const T>{column});
+                };
+
+                // === write full residuals ===
+                for(std::size_t ifield = 0; ifield < residual_names.size(); ++ifield)
+                    { write_column(residual_names[ifield], res_mat, ifield); }
+
+                // === write domain residuals ===
+                for(std::size_t ifield = 0; ifield < residual_names.size(); ++ifield)
+                    { write_column(std::string{"domain_"} + residual_names[ifield], domain_mat, ifield); }
+
+                // === write trace residuals ===
+                for(std::size_t ifield = 0; ifield < residual_names.size(); ++ifield)
+                    { write_column(std::string{"trace_"} + residual_names[ifield], trace_mat, ifield); }
+            }
+
+            /// @brief compute the full, domain, and trace residuals at the vtk points
+            void compute_residuals(FESpace<T, IDX, ndim>& fespace) const {
                 using namespace impl;
                 using Element = FiniteElement<T, IDX, ndim>;
                 // compute the number of vtk points 
-                std::size_t n_vtk_poin = 0;
+                n_vtk_poin = 0;
                 std::vector<std::size_t> el_vtk_offsets{0};
                 IDX iel = 0;
                 for(Element &el : fespace.elements){
@@ -313,11 +529,11 @@ namespace iceicle::io {
                     ++iel;
                 }
 
-                std::vector<T> res_storage( residual_names.size() * n_vtk_poin );
+                res_storage.resize( residual_names.size() * n_vtk_poin );
                 std::mdspan res_mat{ res_storage.data(), n_vtk_poin, residual_names.size() };
-                std::vector<T> domain_storage( residual_names.size() * n_vtk_poin );
+                domain_storage.resize( residual_names.size() * n_vtk_poin );
                 std::mdspan domain_mat{ domain_storage.data(), n_vtk_poin, residual_names.size() };
-                std::vector<T> trace_storage( residual_names.size() * n_vtk_poin );
+                trace_storage.resize( residual_names.size() * n_vtk_poin );
                 std::mdspan trace_mat{ trace_storage.data(), n_vtk_poin, residual_names.size() };
                 std::ranges::fill(res_storage, 0.0);
                 std::ranges::fill(domain_storage, 0.0);
@@ -343,19 +559,19 @@ namespace iceicle::io {
                     // NOTE: using the vtk el based on basis polynomial order
                     VTKElement<T, ndim> &vtk_el = get_vtk_element(el.trans, el.basis->getPolynomialOrder());
 
-                    // storage for basis functions 
-                    std::vector<T> basis_data(el.nbasis());
+                    // basis functions at all the vtk nodes [inode][idof]
+                    std::vector<T> basis_data = impl::eval_basis_at_nodes(el, vtk_el.nodes);
 
                     // get the solution for each point in the vtk element
-                    for(const MATH::GEOMETRY::Point<T, ndim> &refnode : vtk_el.nodes){
-                        el.eval_basis(refnode, basis_data.data());
+                    for(std::size_t inode = 0; inode < vtk_el.nodes.size(); ++inode){
+                        const T *bi = basis_data.data() + inode * el.nbasis();
 
                         // compute residual contribution at given node
                         std::ranges::fill(res_poin, 0.0);
                         for(int ieq = 0; ieq < fedata.nv(); ++ieq){
                             for(std::size_t idof = 0; idof < el.nbasis(); ++idof){
                                 res_poin[ieq] += res_el[idof, ieq] 
-                                    * basis_data[idof];
+                                    * bi[idof];
                             }
 
                             res_mat[i_vtk_poin, ieq] += res_poin[ieq];
@@ -392,18 +608,17 @@ namespace iceicle::io {
 
                     { // left
                         VTKElement<T, ndim> &vtk_el = get_vtk_element(trace.elL.trans, trace.elL.basis->getPolynomialOrder());
-                        std::vector<T> basis_data(trace.elL.nbasis());
+                        std::vector<T> basis_data = impl::eval_basis_at_nodes(trace.elL, vtk_el.nodes);
 
                         for(int inode = 0; inode < vtk_el.nodes.size(); ++inode){
-                            auto& refnode = vtk_el.nodes[inode];
-                            trace.elL.eval_basis(refnode, basis_data.data());
+                            const T *bi = basis_data.data() + inode * trace.elL.nbasis();
 
                             // compute residual contribution at given node
                             std::ranges::fill(res_poin, 0.0);
                             for(int ieq = 0; ieq < fedata.nv(); ++ieq){
                                 for(std::size_t idof = 0; idof < trace.elL.nbasis(); ++idof){
                                     res_poin[ieq] += resL[idof, ieq] 
-                                        * basis_data[idof];
+                                        * bi[idof];
                                 }
 
                                 res_mat[el_vtk_offsets[trace.elL.elidx] + inode, ieq] += res_poin[ieq];
@@ -414,18 +629,17 @@ namespace iceicle::io {
                     }
                     { // right
                         VTKElement<T, ndim> &vtk_el = get_vtk_element(trace.elR.trans, trace.elR.basis->getPolynomialOrder());
-                        std::vector<T> basis_data(trace.elR.nbasis());
+                        std::vector<T> basis_data = impl::eval_basis_at_nodes(trace.elR, vtk_el.nodes);
 
                         for(int inode = 0; inode < vtk_el.nodes.size(); ++inode){
-                            auto& refnode = vtk_el.nodes[inode];
-                            trace.elR.eval_basis(refnode, basis_data.data());
+                            const T *bi = basis_data.data() + inode * trace.elR.nbasis();
 
                             // compute residual contribution at given node
                             std::ranges::fill(res_poin, 0.0);
                             for(int ieq = 0; ieq < fedata.nv(); ++ieq){
                                 for(std::size_t idof = 0; idof < trace.elR.nbasis(); ++idof){
                                     res_poin[ieq] += resR[idof, ieq] 
-                                        * basis_data[idof];
+                                        * bi[idof];
                                 }
 
                                 res_mat[el_vtk_offsets[trace.elR.elidx] + inode, ieq] += res_poin[ieq];
@@ -453,18 +667,17 @@ namespace iceicle::io {
                     disc.boundaryIntegral(trace, fespace.meshptr->coord, uL, uR, resL);
                     { // left
                         VTKElement<T, ndim> &vtk_el = get_vtk_element(trace.elL.trans, trace.elL.basis->getPolynomialOrder());
-                        std::vector<T> basis_data(trace.elL.nbasis());
+                        std::vector<T> basis_data = impl::eval_basis_at_nodes(trace.elL, vtk_el.nodes);
 
                         for(int inode = 0; inode < vtk_el.nodes.size(); ++inode){
-                            auto& refnode = vtk_el.nodes[inode];
-                            trace.elL.eval_basis(refnode, basis_data.data());
+                            const T *bi = basis_data.data() + inode * trace.elL.nbasis();
 
                             // compute residual contribution at given node
                             std::ranges::fill(res_poin, 0.0);
                             for(int ieq = 0; ieq < fedata.nv(); ++ieq){
                                 for(std::size_t idof = 0; idof < trace.elL.nbasis(); ++idof){
                                     res_poin[ieq] += resL[idof, ieq] 
-                                        * basis_data[idof];
+                                        * bi[idof];
                                 }
 
                                 res_mat[el_vtk_offsets[trace.elL.elidx] + inode, ieq] += res_poin[ieq];
@@ -474,95 +687,6 @@ namespace iceicle::io {
                     }
                 }
 
-                // === write full residuals ===
-                for(std::size_t ifield = 0; ifield < residual_names.size(); ++ifield){
-                    // point data tag
-                    write_open(XMLTag{"DataArray", {
-                        {"type", "Float64"},
-                        {"Name", residual_names[ifield]}, 
-                        {"format", "ascii"}
-                    }}, vtu_file);
-
-                    // loop over the elements
-                    std::size_t i_vtk_poin = 0;
-                    for(Element &el : fespace.elements){
-                        // NOTE: using the vtk el based on basis polynomial order
-                        VTKElement<T, ndim> &vtk_el = get_vtk_element(el.trans, el.basis->getPolynomialOrder());
-
-                        // storage for basis functions 
-                        std::vector<T> basis_data(el.nbasis());
-                        for(int ilnode = 0; ilnode < vtk_el.nodes.size(); ++ilnode){
-                            vtu_file << " " << res_mat[i_vtk_poin, ifield];
-                            ++i_vtk_poin;
-                        }
-
-                        // line break for each element
-                        vtu_file << std::endl;
-                    }
-
-                    // close the data array tag
-                    write_close(XMLTag{"DataArray"}, vtu_file);
-                }
-
-                // === write domain residuals ===
-                for(std::size_t ifield = 0; ifield < residual_names.size(); ++ifield){
-                    // point data tag
-                    write_open(XMLTag{"DataArray", {
-                        {"type", "Float64"},
-                        {"Name", std::string{"domain_"} + residual_names[ifield]}, 
-                        {"format", "ascii"}
-                    }}, vtu_file);
-
-                    // loop over the elements
-                    std::size_t i_vtk_poin = 0;
-                    for(Element &el : fespace.elements){
-                        // NOTE: using the vtk el based on basis polynomial order
-                        VTKElement<T, ndim> &vtk_el = get_vtk_element(el.trans, el.basis->getPolynomialOrder());
-
-                        // storage for basis functions 
-                        std::vector<T> basis_data(el.nbasis());
-                        for(int ilnode = 0; ilnode < vtk_el.nodes.size(); ++ilnode){
-                            vtu_file << " " << domain_mat[i_vtk_poin, ifield];
-                            ++i_vtk_poin;
-                        }
-
-                        // line break for each element
-                        vtu_file << std::endl;
-                    }
-
-                    // close the data array tag
-                    write_close(XMLTag{"DataArray"}, vtu_file);
-                }
-
-                // === write trace residuals ===
-                for(std::size_t ifield = 0; ifield < residual_names.size(); ++ifield){
-                    // point data tag
-                    write_open(XMLTag{"DataArray", {
-                        {"type", "Float64"},
-                        {"Name", std::string{"trace_"} + residual_names[ifield]}, 
-                        {"format", "ascii"}
-                    }}, vtu_file);
-
-                    // loop over the elements
-                    std::size_t i_vtk_poin = 0;
-                    for(Element &el : fespace.elements){
-                        // NOTE: using the vtk el based on basis polynomial order
-                        VTKElement<T, ndim> &vtk_el = get_vtk_element(el.trans, el.basis->getPolynomialOrder());
-
-                        // storage for basis functions 
-                        std::vector<T> basis_data(el.nbasis());
-                        for(int ilnode = 0; ilnode < vtk_el.nodes.size(); ++ilnode){
-                            vtu_file << " " << trace_mat[i_vtk_poin, ifield];
-                            ++i_vtk_poin;
-                        }
-
-                        // line break for each element
-                        vtu_file << std::endl;
-                    }
-
-                    // close the data array tag
-                    write_close(XMLTag{"DataArray"}, vtu_file);
-                }
             }
 
             auto clone() const -> std::unique_ptr<writeable_field> override {
@@ -604,36 +728,41 @@ namespace iceicle::io {
             }
 
             /// @brief adds the xml DataArray tags and data to a given vtu file 
-            void write_data(std::ofstream &vtu_file, FESpace<T, IDX, ndim> &fespace) const override
+            void write_data(std::ostream &vtu_file, impl::DataArrayWriter &arrays,
+                    FESpace<T, IDX, ndim> &fespace) const override
             {
                 using namespace impl;
                 using Element = FiniteElement<T, IDX, ndim>;
 
                 // compute the number of vtk points 
-                std::size_t n_vtk_poin = 0;
+                // and the offset of the first vtk point of each element
+                std::vector<std::size_t> el_vtk_offsets{0};
                 for(Element &el : fespace.elements){
                     // NOTE: using the vtk el based on basis polynomial order
                     VTKElement<T, ndim> &vtk_el = get_vtk_element(el.trans, el.basis->getPolynomialOrder());
-                    n_vtk_poin += vtk_el.nodes.size();
+                    el_vtk_offsets.push_back(el_vtk_offsets.back() + vtk_el.nodes.size());
                 }
+                std::size_t n_vtk_poin = el_vtk_offsets.back();
 
                 // storage for the fields 
                 std::vector<T> output_storage( (field_names.size() + derived_field_names.size()) * n_vtk_poin );
                 std::mdspan output_mat{output_storage.data(), n_vtk_poin, field_names.size() + derived_field_names.size()};
 
-                std::size_t i_vtk_poin = 0;
-                // loop over the elements
-                for(Element &el : fespace.elements){
+                // loop over the elements 
+                // threaded since each element writes to its own range of vtk points
+                util::parallel_for(fespace.elements.size(), [&](std::size_t iel){
+                        Element &el = fespace.elements[iel];
+                        std::size_t i_vtk_poin = el_vtk_offsets[iel];
 
                         // NOTE: using the vtk el based on basis polynomial order
                         VTKElement<T, ndim> &vtk_el = get_vtk_element(el.trans, el.basis->getPolynomialOrder());
 
-                        // storage for basis functions 
-                        std::vector<T> basis_data(el.nbasis());
+                        // basis functions at all the vtk nodes [inode][idof]
+                        std::vector<T> basis_data = impl::eval_basis_at_nodes(el, vtk_el.nodes);
 
                         // get the solution for each point in the vtk element
-                        for(const MATH::GEOMETRY::Point<T, ndim> &refnode : vtk_el.nodes){
-                            el.eval_basis(refnode, basis_data.data());
+                        for(std::size_t inode = 0; inode < vtk_el.nodes.size(); ++inode){
+                            const T *bi = basis_data.data() + inode * el.nbasis();
 
                             // compute the pde variables
                             std::vector<T> u(fedata.nv());
@@ -641,80 +770,41 @@ namespace iceicle::io {
                             for(int ieq = 0; ieq < fedata.nv(); ++ieq){
                                 for(std::size_t idof = 0; idof < el.nbasis(); ++idof){
                                     u[ieq] += fedata[el.elidx, idof, ieq] 
-                                        * basis_data[idof];
+                                        * bi[idof];
                                 }
 
                                 output_mat[i_vtk_poin, ieq] = u[ieq];
                             } 
 
                             // compute derived variables 
-                            std::vector<T> u_derived = derived_fields_callback(u.data());
+                            // NOTE: the callback may not be thread safe (i.e if it calls into lua)
+                            std::vector<T> u_derived;
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp critical(iceicle_derived_fields)
+#endif
+                            u_derived = derived_fields_callback(u.data());
                             for(int ifield = 0; ifield < derived_field_names.size(); ++ifield){
                                 output_mat[i_vtk_poin, fedata.nv() + ifield] = u_derived[ifield];
                             }
                             ++i_vtk_poin; // increment the point index
                         }
-                }
-
-                // print out pde variables
-                for(std::size_t ifield = 0; ifield < field_names.size(); ++ifield){
-                    // point data tag
-                    write_open(XMLTag{"DataArray", {
-                        {"type", "Float64"},
-                        {"Name", field_names[ifield]}, 
-                        {"format", "ascii"}
-                    }}, vtu_file);
-
-                    // loop over the elements
-                    std::size_t i_vtk_poin = 0;
-                    for(Element &el : fespace.elements){
-                        // NOTE: using the vtk el based on basis polynomial order
-                        VTKElement<T, ndim> &vtk_el = get_vtk_element(el.trans, el.basis->getPolynomialOrder());
-
-                        // storage for basis functions 
-                        std::vector<T> basis_data(el.nbasis());
-                        for(int ilnode = 0; ilnode < vtk_el.nodes.size(); ++ilnode){
-                            vtu_file << " " << output_mat[i_vtk_poin, ifield];
-                            ++i_vtk_poin;
-                        }
+                });
 
-                        // line break for each element
-                        vtu_file << std::endl;
-                    }
+                // write each field as a DataArray
+                std::vector<T> column(n_vtk_poin);
+                auto write_column = [&](const std::string& name, std::size_t ifield){
+                    for(std::size_t ipoin = 0; ipoin < n_vtk_poin; ++ipoin)
+                        { column[ipoin] = output_mat[ipoin, ifield]; }
+                    arrays.write(vtu_file, name, std::span<const T>{column});
+                };
 
-                    // close the data array tag
-                    write_close(XMLTag{"DataArray"}, vtu_file);
-                }
+                // print out pde variables
+                for(std::size_t ifield = 0; ifield < field_names.size(); ++ifield)
+                    { write_column(field_names[ifield], ifield); }
 
                 // print out derived variables
-                for(std::size_t ifield = 0; ifield < derived_field_names.size(); ++ifield){
-                    // point data tag
-                    write_open(XMLTag{"DataArray", {
-                        {"type", "Float64"},
-                        {"Name", derived_field_names[ifield]}, 
-                        {"format", "ascii"}
-                    }}, vtu_file);
-
-                    // loop over the elements
-                    std::size_t i_vtk_poin = 0;
-                    for(Element &el : fespace.elements){
-                        // NOTE: using the vtk el based on basis polynomial order
-                        VTKElement<T, ndim> &vtk_el = get_vtk_element(el.trans, el.basis->getPolynomialOrder());
-
-                        // storage for basis functions 
-                        std::vector<T> basis_data(el.nbasis());
-                        for(int ilnode = 0; ilnode < vtk_el.nodes.size(); ++ilnode){
-                            vtu_file << " " << output_mat[i_vtk_poin, fedata.nv() + ifield];
-                            ++i_vtk_poin;
-                        }
-
-                        // line break for each element
-                        vtu_file << std::endl;
-                    }
-
-                    // close the data array tag
-                    write_close(XMLTag{"DataArray"}, vtu_file);
-                }
+                for(std::size_t ifield = 0; ifield < derived_field_names.size(); ++ifield)
+                    { write_column(derived_field_names[ifield], fedata.nv() + ifield); }
             }
 
             auto clone() const -> std::unique_ptr<writeable_field> override {
@@ -746,32 +836,21 @@ namespace iceicle::io {
             MDGVectorDataField(dofspan<value_type, LayoutPolicy, AccessorPolicy> mdgdata, std::string field_name)
             : mdgdata(mdgdata), field_name(field_name){}
 
-            void write_data(std::ofstream &vtu_file, FESpace<T, IDX, ndim>& fespace) const override {
+            void write_data(std::ostream &vtu_file, impl::DataArrayWriter &arrays,
+                    FESpace<T, IDX, ndim>& fespace) const override {
                 using namespace impl;
                 const nodeset_dof_map<index_type>& nodeset = mdgdata.get_layout().nodeset;
 
-                write_open(XMLTag{"DataArray", {
-                    {"type", "Float64"},
-                    {"Name", field_name}, 
-                    {"NumberOfComponents", std::to_string(mdgdata.nv())},
-                    {"format", "ascii"}
-                }}, vtu_file);
-
+                // nodes that are not selected are zero
+                std::vector<T> nodal_data(fespace.meshptr->n_nodes() * mdgdata.nv(), 0.0);
                 for(index_type inode = 0; inode < fespace.meshptr->n_nodes(); ++inode){
                     index_type idof = nodeset.inv_selected_nodes[inode];
-                    if(idof == nodeset.selected_nodes.size()){
-                        for(index_type iv = 0; iv < mdgdata.nv(); ++iv){
-                            vtu_file << "0.0 ";
-                        }
-                        vtu_file << std::endl;
-                    } else {
-                        for(index_type iv = 0; iv < mdgdata.nv(); ++iv){
-                            vtu_file << mdgdata[idof, iv] << " ";
-                        }
-                        vtu_file << std::endl;
+                    if(idof != nodeset.selected_nodes.size()){
+                        for(index_type iv = 0; iv < mdgdata.nv(); ++iv)
+                            { nodal_data[inode * mdgdata.nv() + iv] = mdgdata[idof, iv]; }
                     }
                 }
-                write_close(XMLTag{"DataArray"}, vtu_file);
+                arrays.write(vtu_file, field_name, std::span<const T>{nodal_data}, mdgdata.nv());
             }
 
             auto is_dg_format() const -> bool override {
@@ -789,6 +868,9 @@ namespace iceicle::io {
         FESpace<T, IDX, ndim> *fespace_ptr = nullptr;
         std::vector<std::unique_ptr<writeable_field>> fields;
 
+        /// @brief the time and file of each entry in the .pvd collection
+        std::vector<std::pair<T, std::string>> pvd_entries{};
+
         // @brief callback function for when no derived fields are used
         static constexpr 
         auto empty_derived_fields_callback(const T *)
@@ -802,6 +884,21 @@ namespace iceicle::io {
         std::string collection_name = "data";
         std::filesystem::path data_directory;
 
+        /// @brief the encoding of the DataArray values
+        vtu_format format = vtu_format::ascii;
+
+        /// @brief zlib compress the binary data (requires ICEICLE_USE_ZLIB, ignored for ascii)
+        bool compress = false;
+
+        /// @brief if this is a positive integer less than the number of processes
+        /// the pieces are gathered to this many writer processes (limits the file count per timestep)
+        /// otherwise every process writes its own piece file
+        int naggregate = 0;
+
+        /// @brief the maximum polynomial order of the output cells
+        /// (1 writes linear cells for smaller files when monitoring)
+        int max_order = std::numeric_limits<int>::max();
+
         PVDWriter() : data_directory(std::filesystem::current_path()) {
             data_directory /= "iceicle_data";
         }
@@ -813,7 +910,9 @@ namespace iceicle::io {
 
         PVDWriter(const PVDWriter<T, IDX, ndim>& other)
             : meshptr(other.meshptr), fespace_ptr(other.fespace_ptr), fields{}, print_precision(other.print_precision),
-              collection_name(other.collection_name), data_directory(other.data_directory)
+              collection_name(other.collection_name), data_directory(other.data_directory),
+              format(other.format), compress(other.compress), naggregate(other.naggregate),
+              max_order(other.max_order), pvd_entries(other.pvd_entries)
         {
             for(const std::unique_ptr<writeable_field>& field : other.fields){
                 fields.push_back(field->clone());
@@ -876,7 +975,22 @@ namespace iceicle::io {
         }
 
         private:
-        auto write_cg_unstructured_grid(std::ofstream& out){
+
+        /// @brief write the Cells with the given connectivity and the number of nodes and vtk id of each cell
+        auto write_cells(std::ostream &out, impl::DataArrayWriter &arrays,
+            std::span<const std::int64_t> connectivity,
+            std::span<const std::int64_t> offsets,
+            std::span<const std::int64_t> types
+        ) -> void {
+            using namespace impl;
+            write_open(XMLTag{"Cells"}, out);
+            arrays.write(out, "connectivity", connectivity);
+            arrays.write(out, "offsets", offsets);
+            arrays.write(out, "types", types);
+            write_close(XMLTag{"Cells"}, out);
+        }
+
+        auto write_cg_unstructured_grid(std::ostream& out, impl::DataArrayWriter &arrays) -> void {
             using namespace impl;
             using namespace util;
             using Element = FiniteElement<T, IDX, ndim>;
@@ -889,37 +1003,20 @@ namespace iceicle::io {
             // = write the nodes =
             // ===================
             write_open(XMLTag{"Points"}, out);
-            write_open(XMLTag{"DataArray", {
-                {"type", "Float64"},
-                {"Name", "Points"},
-                {"NumberOfComponents", "3"},
-                {"format", "ascii"}
-            }}, out);
-
+            std::vector<T> points(3 * meshptr->n_nodes(), 0.0);
             for(IDX inode = 0; inode < meshptr->n_nodes(); ++inode){
                 for(int idim = 0; idim < ndim; ++idim){
-                    out << meshptr->coord[inode][idim] << " ";
+                    points[3 * inode + idim] = meshptr->coord[inode][idim];
                 }
-                for(int idim = ndim; idim < 3; ++idim){
-                    out << 0.0;
-                }
-                out << std::endl;
             }
-            write_close(XMLTag{"DataArray"}, out);
+            arrays.write(out, "Points", std::span<const T>{points}, 3);
             write_close(XMLTag{"Points"}, out);
 
             // ===============
             // = write cells =
             // ===============
-            
-            // === connectivity ===
-            write_open(XMLTag{"Cells"}, out);
-            write_open(XMLTag{"DataArray", {
-                {"type", "Int64"},
-                {"Name", "connectivity"},
-                {"format", "ascii"}
-            }}, out);
-            
+            std::vector<std::int64_t> connectivity{}, offsets{}, types{};
+            std::int64_t goffset = 0;
             for(Element &el : fespace_ptr->elements){
                 VTKElement<T, ndim> &vtk_el = get_vtk_element(el.trans, el.trans->order);
                 if(vtk_el.nodes.size() != el.trans->nnode){
@@ -929,60 +1026,26 @@ namespace iceicle::io {
                 // TODO: FIX AND GENERALIZE TO OTHER ELEMENT TYPES 
                 // convert to paraview ordering
                 std::span<const IDX> nodes = el.inodes;
-                out << std::to_string(nodes[0]) << " "
-                    << std::to_string(nodes[2]) << " "
-                    << std::to_string(nodes[3]) << " "
-                    << std::to_string(nodes[1]) << " ";
-
-//                for(IDX inode : el.geo_el->nodes_span()){
-//                    out << std::to_string(inode) << " ";
-//                }
-                out << std::endl;
-            }
-            write_close(XMLTag{"DataArray"}, out);
+                connectivity.insert(connectivity.end(), {nodes[0], nodes[2], nodes[3], nodes[1]});
 
-            // === offsets ===
-            write_open(XMLTag{"DataArray", {
-                {"type", "Int64"},
-                {"Name", "offsets"},
-                {"format", "ascii"}
-            }}, out);
-            std::size_t goffset = 0;
-            for(Element &el : fespace_ptr->elements){
-                VTKElement<T, ndim> &vtk_el = get_vtk_element(el.trans, el.trans->order);
                 goffset += vtk_el.nodes.size();
-                out << std::to_string(goffset) << " ";
-            }
-            out << "\n";
-            write_close(XMLTag{"DataArray"}, out);
-
-            // === cell types ===
-            write_open(XMLTag{"DataArray", {
-                {"type", "Int64"},
-                {"Name", "types"},
-                {"format", "ascii"}
-            }}, out);
-            for(Element &el : fespace_ptr->elements){
-                VTKElement<T, ndim> &vtk_el = get_vtk_element(el.trans, el.trans->order);
-                out << vtk_el.vtk_id  << " ";
+                offsets.push_back(goffset);
+                types.push_back(vtk_el.vtk_id);
             }
-            out << "\n";
-            write_close(XMLTag{"DataArray"}, out);
-
-            write_close(XMLTag{"Cells"}, out);
+            write_cells(out, arrays, connectivity, offsets, types);
 
             // ===================
             // = write PointData =
             // ===================
             write_open(XMLTag{"PointData"}, out);
             for(auto &field_ptr : fields){
-                field_ptr->write_data(out, *fespace_ptr);
+                field_ptr->write_data(out, arrays, *fespace_ptr);
             }
             write_close(XMLTag{"PointData"}, out);
             write_close(XMLTag{"Piece"}, out);
         }
 
-        auto write_dg_unstructured_grid(std::ofstream &out) -> void {
+        auto write_dg_unstructured_grid(std::ostream &out, impl::DataArrayWriter &arrays) -> void {
             using namespace impl;
             using namespace util;
             using Element = FiniteElement<T, IDX, ndim>;
@@ -1003,91 +1066,43 @@ namespace iceicle::io {
             // ===================
 
             write_open(XMLTag{"Points"}, out);
-            write_open(XMLTag{"DataArray", {
-                {"type", "Float64"},
-                {"Name", "Points"},
-                {"NumberOfComponents", "3"},
-                {"format", "ascii"}
-            }}, out);
-
+            std::vector<T> points(3 * nodecount, 0.0);
+            std::size_t ipoin = 0;
             for(Element &el : fespace_ptr->elements){
                 VTKElement<T, ndim> &vtk_el = get_vtk_element(el.trans, el.basis->getPolynomialOrder());
                 MATH::GEOMETRY::Point<T, ndim> point_phys;
                 for(const MATH::GEOMETRY::Point<T, ndim> &refnode : vtk_el.nodes){
                     // interpolate the point from the vtk element 
                     point_phys = el.transform(refnode);
-
-                    // print the physical node
                     for(int idim = 0; idim < ndim; ++idim)
-                    { out << point_phys[idim] << " "; }
-
-                    // fill with zeros
-                    for(int idim = ndim; idim < 3; ++idim)
-                    { out << 0.0 << " "; }
-                    out << std::endl;
+                        { points[3 * ipoin + idim] = point_phys[idim]; }
+                    ++ipoin;
                 }
             }
-            write_close(XMLTag{"DataArray"}, out);
+            arrays.write(out, "Points", std::span<const T>{points}, 3);
             write_close(XMLTag{"Points"}, out);
 
             // ===============
             // = write cells =
             // ===============
-            
-            // === connectivity ===
-            write_open(XMLTag{"Cells"}, out);
-            write_open(XMLTag{"DataArray", {
-                {"type", "Int64"},
-                {"Name", "connectivity"},
-                {"format", "ascii"}
-            }}, out);
-            
-            std::size_t ignode = 0;
-            for(Element &el : fespace_ptr->elements){
-                VTKElement<T, ndim> &vtk_el = get_vtk_element(el.trans, el.basis->getPolynomialOrder());
-                for(int ilnode = 0; ilnode < vtk_el.nodes.size(); ++ilnode){
-                    out << std::to_string(ignode++) << " ";
-                }
-                out << std::endl;
-            }
-            write_close(XMLTag{"DataArray"}, out);
-
-            // === offsets ===
-            write_open(XMLTag{"DataArray", {
-                {"type", "Int64"},
-                {"Name", "offsets"},
-                {"format", "ascii"}
-            }}, out);
-            std::size_t goffset = 0;
+            // the nodes are duplicated for each element
+            std::vector<std::int64_t> connectivity(nodecount), offsets{}, types{};
+            std::iota(connectivity.begin(), connectivity.end(), 0);
+            std::int64_t goffset = 0;
             for(Element &el : fespace_ptr->elements){
                 VTKElement<T, ndim> &vtk_el = get_vtk_element(el.trans, el.basis->getPolynomialOrder());
                 goffset += vtk_el.nodes.size();
-                out << std::to_string(goffset) << " ";
+                offsets.push_back(goffset);
+                types.push_back(vtk_el.vtk_id);
             }
-            out << "\n";
-            write_close(XMLTag{"DataArray"}, out);
-
-            // === cell types ===
-            write_open(XMLTag{"DataArray", {
-                {"type", "Int64"},
-                {"Name", "types"},
-                {"format", "ascii"}
-            }}, out);
-            for(Element &el : fespace_ptr->elements){
-                VTKElement<T, ndim> &vtk_el = get_vtk_element(el.trans, el.basis->getPolynomialOrder());
-                out << vtk_el.vtk_id  << " ";
-            }
-            out << "\n";
-            write_close(XMLTag{"DataArray"}, out);
-
-            write_close(XMLTag{"Cells"}, out);
+            write_cells(out, arrays, connectivity, offsets, types);
 
             // ===================
             // = write PointData =
             // ===================
             write_open(XMLTag{"PointData"}, out);
             for(auto &field_ptr : fields){
-                field_ptr->write_data(out, *fespace_ptr);
+                field_ptr->write_data(out, arrays, *fespace_ptr);
             }
             write_close(XMLTag{"PointData"}, out);
 
@@ -1095,13 +1110,106 @@ namespace iceicle::io {
 
         }
 
+        /// @brief the piece of this process: the mesh and the fields
+        auto write_piece(std::ostream &out, impl::DataArrayWriter &arrays) -> void {
+            using namespace util;
+            bool use_dg_mesh = fields[0]->is_dg_format();
+            for(int ifield = 1; ifield < fields.size(); ++ifield){
+                if(fields[ifield]->is_dg_format() != use_dg_mesh){
+                    AnomalyLog::log_anomaly(Anomaly{"Cannot mix dg and cg fields", general_anomaly_tag{}});
+                }
+            }
+            if(use_dg_mesh) write_dg_unstructured_grid(out, arrays);
+            else write_cg_unstructured_grid(out, arrays);
+        }
+
+        /// @brief write a complete .vtu file around the given pieces
+        auto write_vtu_file(const std::filesystem::path &path, std::span<const std::string> pieces,
+                impl::DataArrayWriter &arrays) -> void {
+            using namespace impl;
+            std::ofstream out{path, std::ios::binary};
+            if(!out) {
+                throw std::logic_error("could not open mesh file for writing.");
+            }
+            write_vtu_header(out, arrays.is_compressed());
+            write_open(XMLTag{"UnstructuredGrid"}, out);
+            for(const std::string &piece : pieces) out.write(piece.data(), piece.size());
+            write_close(XMLTag{"UnstructuredGrid"}, out);
+            arrays.write_appended(out);
+            write_vtu_footer(out);
+        }
+
+        /**
+         * @brief write the .pvtu file that ties the piece files together (on rank 0)
+         * @param path the .pvtu file path 
+         * @param sources the piece file names (relative to the .pvtu)
+         * @param arrays the writer of the piece of rank 0 (for the array types and names)
+         */
+        auto write_pvtu_file(const std::filesystem::path &path, std::span<const std::string> sources,
+                const impl::DataArrayWriter &arrays) -> void {
+            using namespace impl;
+            std::ofstream out{path};
+            if(!out) {
+                throw std::logic_error("could not open pvtu file for writing.");
+            }
+            std::span<const XMLTag> tags = arrays.written();
+            out << "<VTKFile type=\"PUnstructuredGrid\" version=\"0.1\" byte_order=\"LittleEndian\" header_type=\"UInt64\">" << std::endl;
+            write_open(XMLTag{"PUnstructuredGrid", {{"GhostLevel", "0"}}}, out);
+
+            // the array order of a piece is Points, connectivity, offsets, types, then the PointData
+            write_open(XMLTag{"PPoints"}, out);
+            write_empty(tags[0], out);
+            write_close(XMLTag{"PPoints"}, out);
+            write_open(XMLTag{"PPointData"}, out);
+            for(std::size_t itag = 4; itag < tags.size(); ++itag) write_empty(tags[itag], out);
+            write_close(XMLTag{"PPointData"}, out);
+
+            for(const std::string &source : sources)
+                write_empty(XMLTag{"Piece", {{"Source", source}}}, out);
+            write_close(XMLTag{"PUnstructuredGrid"}, out);
+            write_vtu_footer(out);
+        }
+
+        /// @brief add a time entry to the .pvd collection and rewrite it (on rank 0)
+        auto write_pvd_file(T time, std::string file) -> void {
+            using namespace impl;
+            pvd_entries.emplace_back(time, std::move(file));
+            std::filesystem::path pvd_path = data_directory;
+            pvd_path /= (collection_name + ".pvd");
+            std::ofstream out{pvd_path};
+            if(!out) {
+                throw std::logic_error("could not open pvd file for writing.");
+            }
+            out << std::setprecision(16);
+            out << "<?xml version=\"1.0\"?>" << std::endl;
+            write_open(XMLTag{"VTKFile", {{"type", "Collection"}, {"version", "0.1"}}}, out);
+            write_open(XMLTag{"Collection"}, out);
+            for(const auto& [entry_time, entry_file] : pvd_entries){
+                std::ostringstream time_str{};
+                time_str << std::setprecision(16) << entry_time;
+                write_empty(XMLTag{"DataSet", {
+                    {"timestep", time_str.str()},
+                    {"part", "0"},
+                    {"file", entry_file}
+                }}, out);
+            }
+            write_close(XMLTag{"Collection"}, out);
+            write_vtu_footer(out);
+        }
+
         public:
         /**
          * @brief write the mesh and field values in a .vtu file 
+         * and add the time entry to the .pvd collection for this writer
+         *
+         * In parallel each rank writes its piece and rank 0 writes a .pvtu file that references the pieces
+         * If naggregate > 0 the pieces are gathered to naggregate writer ranks 
+         * that each write one file with the pieces of their group (in binary inline format
+         * since appended data offsets are per file)
+         *
          * @param itime the timestep
          * @param time the time value
          * NOTE: the user is responsible for making sure itime and time are unique 
-         * (aside from parallel case, separate file names are generated per process in parallel)
          */
         void write_vtu(int itime, T time){
 
@@ -1111,43 +1219,93 @@ namespace iceicle::io {
 
             using namespace impl;
             using namespace util;
-            using Element = FiniteElement<T, IDX, ndim>;
-
-            // create the path if it doesn't exist
-            std::filesystem::create_directories(data_directory);
-
-            std::filesystem::path mesh_path = data_directory;
-            mesh_path /= (collection_name + std::to_string(itime) + ".vtu");
-
-            std::ofstream out{mesh_path};
-            if(!out) {
-                throw std::logic_error("could not open mesh file for writing.");
-            }
 
             if(!meshptr){
                 throw std::logic_error("mesh doesn't exist");
             }
 
-            // setup the output stream 
-            out << std::setprecision(print_precision);
+            // limit the cell order while this file is written
+            struct order_guard {
+                int previous = vtk_max_order();
+                order_guard(int order) { vtk_max_order() = std::max(order, 1); }
+                ~order_guard() { vtk_max_order() = previous; }
+            } guard{max_order};
 
-            write_vtu_header(out);
-            
-            bool use_dg_mesh = fields[0]->is_dg_format();
+            // create the path if it doesn't exist
+            std::filesystem::create_directories(data_directory);
+            std::string basename = collection_name + std::to_string(itime);
+            int irank = mpi::mpi_world_rank();
+            int nrank = mpi::mpi_world_size();
+
+            if(nrank == 1) {
+                DataArrayWriter arrays{format, compress};
+                std::ostringstream piece_stream{};
+                piece_stream << std::setprecision(print_precision);
+                write_piece(piece_stream, arrays);
+                std::string piece = piece_stream.str();
+                std::string file = basename + ".vtu";
+                write_vtu_file(data_directory / file, std::span{&piece, 1}, arrays);
+                write_pvd_file(time, file);
+                return;
+            }
 
-            for(int ifield = 1; ifield < fields.size(); ++ifield){
-                if(fields[ifield]->is_dg_format() != use_dg_mesh){
-                    AnomalyLog::log_anomaly(Anomaly{"Cannot mix dg and cg fields", general_anomaly_tag{}});
+#ifdef ICEICLE_USE_MPI
+            bool aggregate = naggregate > 0 && naggregate < nrank;
+            vtu_format piece_format = (aggregate && format != vtu_format::ascii) ? vtu_format::binary : format;
+            DataArrayWriter arrays{piece_format, compress};
+            std::ostringstream piece_stream{};
+            piece_stream << std::setprecision(print_precision);
+            write_piece(piece_stream, arrays);
+            std::string piece = piece_stream.str();
+
+            std::vector<std::string> sources{};
+            if(aggregate){
+                // contiguous groups of ranks with the first rank of each group writing
+                int igroup = (int) (((long) irank * naggregate) / nrank);
+                MPI_Comm group_comm;
+                MPI_Comm_split(MPI_COMM_WORLD, igroup, irank, &group_comm);
+                int group_rank, group_size;
+                MPI_Comm_rank(group_comm, &group_rank);
+                MPI_Comm_size(group_comm, &group_size);
+
+                long long piece_size = piece.size();
+                std::vector<long long> piece_sizes(group_size);
+                MPI_Gather(&piece_size, 1, MPI_LONG_LONG, piece_sizes.data(), 1, MPI_LONG_LONG, 0, group_comm);
+                std::vector<int> counts(group_size), displs(group_size);
+                std::string group_data{};
+                if(group_rank == 0){
+                    long long total = 0;
+                    for(int i = 0; i < group_size; ++i){
+                        counts[i] = (int) piece_sizes[i];
+                        displs[i] = (int) total;
+                        total += piece_sizes[i];
+                    }
+                    group_data.resize(total);
+                }
+                MPI_Gatherv(piece.data(), (int) piece.size(), MPI_CHAR, group_data.data(),
+                        counts.data(), displs.data(), MPI_CHAR, 0, group_comm);
+                if(group_rank == 0){
+                    std::vector<std::string> pieces(group_size);
+                    for(int i = 0; i < group_size; ++i) pieces[i] = group_data.substr(displs[i], counts[i]);
+                    write_vtu_file(data_directory / (basename + "_group" + std::to_string(igroup) + ".vtu"),
+                            pieces, arrays);
                 }
+                MPI_Comm_free(&group_comm);
+                for(int jgroup = 0; jgroup < naggregate; ++jgroup)
+                    sources.push_back(basename + "_group" + std::to_string(jgroup) + ".vtu");
+            } else {
+                write_vtu_file(data_directory / (basename + "_rank" + std::to_string(irank) + ".vtu"),
+                        std::span{&piece, 1}, arrays);
+                for(int jrank = 0; jrank < nrank; ++jrank)
+                    sources.push_back(basename + "_rank" + std::to_string(jrank) + ".vtu");
             }
 
-            write_open(XMLTag{"UnstructuredGrid"}, out);
-
-            if(use_dg_mesh) write_dg_unstructured_grid(out);
-            else write_cg_unstructured_grid(out);
-
-            write_close(XMLTag{"UnstructuredGrid"}, out);
-            write_vtu_footer(out);
+            if(irank == 0){
+                std::string file = basename + ".pvtu";
+                write_pvtu_file(data_directory / file, sources, arrays);
+                write_pvd_file(time, file);
+            }
+#endif
         }
 
         
@@ -1171,7 +1329,7 @@ namespace iceicle::io {
             std::filesystem::path mesh_path = data_directory;
             mesh_path /= "mesh.vtu";
 
-            std::ofstream out{mesh_path};
+            std::ofstream out{mesh_path, std::ios::binary};
             if(!out) {
                 throw std::logic_error("could not open mesh file for writing.");
             }
@@ -1182,8 +1340,9 @@ namespace iceicle::io {
 
             // setup the output stream 
             out << std::setprecision(print_precision);
+            DataArrayWriter arrays{format, compress};
 
-            write_vtu_header(out);
+            write_vtu_header(out, arrays.is_compressed());
             
             // count the number of nodes (duplicate for each element)
             std::size_t nodecount = 0;
@@ -1203,90 +1362,46 @@ namespace iceicle::io {
             // ===================
 
             write_open(XMLTag{"Points"}, out);
-            write_open(XMLTag{"DataArray", {
-                {"type", "Float64"},
-                {"Name", "Points"},
-                {"NumberOfComponents", "3"},
-                {"format", "ascii"}
-            }}, out);
-
+            std::vector<T> points(3 * nodecount, 0.0);
+            std::size_t ipoin = 0;
             for(Element *elptr : meshptr->elements){
                 VTKElement<T, ndim> &vtk_el = get_vtk_element(elptr);
                 MATH::GEOMETRY::Point<T, ndim> point_phys;
                 for(const MATH::GEOMETRY::Point<T, ndim> &refnode : vtk_el.nodes){
                     // interpolate the point from the vtk element 
                     elptr->transform(meshptr->nodes, refnode, point_phys);
-
-                    // print the physical node
                     for(int idim = 0; idim < ndim; ++idim)
-                    { out << point_phys[idim] << " "; }
-
-                    // fill with zeros
-                    for(int idim = ndim; idim < 3; ++idim)
-                    { out << 0.0 << " "; }
-                    out << std::endl;
+                        { points[3 * ipoin + idim] = point_phys[idim]; }
+                    ++ipoin;
                 }
             }
-            write_close(XMLTag{"DataArray"}, out);
+            arrays.write(out, "Points", std::span<const T>{points}, 3);
             write_close(XMLTag{"Points"}, out);
 
             // ===============
             // = write cells =
             // ===============
-            
-            // === connectivity ===
-            write_open(XMLTag{"Cells"}, out);
-            write_open(XMLTag{"DataArray", {
-                {"type", "Int64"},
-                {"Name", "connectivity"},
-                {"format", "ascii"}
-            }}, out);
-            
-            std::size_t ignode = 0;
-            for(Element *elptr : meshptr->elements){
-                VTKElement<T, ndim> &vtk_el = get_vtk_element(elptr);
-                for(int ilnode = 0; ilnode < vtk_el.nodes.size(); ++ilnode){
-                    out << std::to_string(ignode++) << " ";
-                }
-                out << std::endl;
-            }
-            write_close(XMLTag{"DataArray"}, out);
-
-            // === offsets ===
-            write_open(XMLTag{"DataArray", {
-                {"type", "Int64"},
-                {"Name", "offsets"},
-                {"format", "ascii"}
-            }}, out);
-            std::size_t goffset = 0;
+            std::vector<std::int64_t> connectivity(nodecount), offsets{}, types{};
+            std::iota(connectivity.begin(), connectivity.end(), 0);
+            std::int64_t goffset = 0;
             for(Element *elptr : meshptr->elements){
                 VTKElement<T, ndim> &vtk_el = get_vtk_element(elptr);
                 goffset += vtk_el.nodes.size();
-                out << std::to_string(goffset) << " ";
+                offsets.push_back(goffset);
+                types.push_back(vtk_el.vtk_id);
             }
-            out << "\n";
-            write_close(XMLTag{"DataArray"}, out);
-
-            // === cell types ===
-            write_open(XMLTag{"DataArray", {
-                {"type", "Int64"},
-                {"Name", "types"},
-                {"format", "ascii"}
-            }}, out);
-            for(Element *elptr : meshptr->elements){
-                VTKElement<T, ndim> &vtk_el = get_vtk_element(elptr);
-                out << vtk_el.vtk_id  << " ";
-            }
-            out << "\n";
-            write_close(XMLTag{"DataArray"}, out);
-
-            write_close(XMLTag{"Cells"}, out);
+            write_cells(out, arrays, connectivity, offsets, types);
 
             write_close(XMLTag{"Piece"}, out);
             write_close(XMLTag{"UnstructuredGrid"}, out);
+            arrays.write_appended(out);
             write_vtu_footer(out);
         }
     };
 
-
+#ifdef ICEICLE_EXTERN_TEMPLATES
+    // compiled once in iceicle_core (see src/core/instantiations.cpp)
+    extern template class PVDWriter<build_config::T, build_config::IDX, 2>;
+    extern template class PVDWriter<build_config::T, build_config::IDX, 3>;
+#endif
 }
@@ -3,9 +3,11 @@
 
 #pragma once
 #include "iceicle/anomaly_log.hpp"
+#include "iceicle/profiler.hpp"
 #include "iceicle/pvd_writer.hpp"
 #include <iceicle/fespace/fespace.hpp>
 #include <iceicle/dat_writer.hpp>
+#include <iceicle/xdmf_writer.hpp>
 #include <memory>
 namespace iceicle::io {
 
@@ -24,6 +26,15 @@ namespace iceicle::io {
         writer.write_vtu(itime, time);
     }
 
+#ifdef ICEICLE_USE_HDF5
+    /// @brief external function interface for type erasure to write a file 
+    /// writes the file with the given time index and time values 
+    template<class T, class IDX, int ndim>
+    auto write_file(XDMFWriter<T, IDX, ndim>& writer, int itime, T time) -> void {
+        writer.write_h5(itime, time);
+    }
+#endif
+
     namespace impl {
         /// @brief external function interface for type erasure to rename the collection
         template<class T, class IDX, int ndim>
@@ -36,6 +47,14 @@ namespace iceicle::io {
         auto rename_collection(PVDWriter<T, IDX, ndim>& writer, std::string_view new_name) -> void {
             writer.collection_name = new_name;
         }
+
+#ifdef ICEICLE_USE_HDF5
+        /// @brief external function interface for type erasure to rename the collection
+        template<class T, class IDX, int ndim>
+        auto rename_collection(XDMFWriter<T, IDX, ndim>& writer, std::string_view new_name) -> void {
+            writer.collection_name = new_name;
+        }
+#endif
     }
 
     struct EmptyWriter { using value_type = double; };
@@ -79,8 +98,12 @@ namespace iceicle::io {
             }
 
             /// @brief rename the collection of a writer
+            /// (writers declared after this header provide a rename_collection member)
             void do_rename_collection(std::string_view new_name) override {
-                impl::rename_collection(_writer, new_name);
+                if constexpr (requires { _writer.rename_collection(new_name); })
+                    _writer.rename_collection(new_name);
+                else
+                    impl::rename_collection(_writer, new_name);
             }
 
             auto clone() const -> std::unique_ptr<WriterConcept> override {
@@ -110,6 +133,7 @@ namespace iceicle::io {
             int itime,
             double time
         ) {
+            ICEICLE_PROFILE_REGION("write_output");
             pimpl->do_write_file(itime, time);
         }
 
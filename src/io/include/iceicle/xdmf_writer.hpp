@@ -0,0 +1,394 @@
+/**
+ * @brief write solutions with collective (parallel) HDF5 and XDMF metadata for ParaView
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#ifdef ICEICLE_USE_HDF5
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/element/finite_element.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/lossy_compression.hpp"
+#include "iceicle/pvd_writer.hpp"
+#include "iceicle/thread_utils.hpp"
+#include <hdf5.h>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#ifdef ICEICLE_USE_MPI
+#include <mpi.h>
+#endif
+
+namespace iceicle::io {
+
+    namespace impl {
+
+        /// @brief the XDMF mixed topology id for a vtk element (node ordering matches vtk for these types)
+        /// @return the id or -1 if unsupported
+        template<class T, int ndim>
+        inline auto xdmf_topology_id(const VTKElement<T, ndim>& vtk_el) -> int {
+            if constexpr (ndim == 2) {
+                switch(vtk_el.nodes.size()){
+                    case 3: return 4;  // Triangle
+                    case 6: return 36; // Triangle_6
+                    case 4: return 5;  // Quadrilateral
+                    case 8: return 37; // Quadrilateral_8
+                    case 9: return 50; // Quadrilateral_9
+                }
+            } else if constexpr (ndim == 3) {
+                switch(vtk_el.nodes.size()){
+                    case 4: return 6;  // Tetrahedron
+                    case 8: return 9;  // Hexahedron
+                }
+            }
+            return -1;
+        }
+
+        /// @brief the HDF5 memory type for values
+        template<class V>
+        inline auto hdf5_type() -> hid_t {
+            if constexpr (std::is_same_v<V, double>) return H5T_NATIVE_DOUBLE;
+            else if constexpr (std::is_same_v<V, float>) return H5T_NATIVE_FLOAT;
+            else if constexpr (std::is_same_v<V, std::int64_t>) return H5T_NATIVE_INT64;
+            else if constexpr (std::is_same_v<V, std::uint8_t>) return H5T_NATIVE_UINT8;
+            else static_assert(!std::is_same_v<V, V>, "unsupported hdf5 data type");
+        }
+    }
+
+    /**
+     * @brief writes the solution with collective HDF5 (one .h5 file per output time)
+     * and a temporal XDMF collection ("<collection_name>.xmf") for ParaView
+     *
+     * The high order DG data are sampled at the same subdivided points as PVDWriter
+     * (the nodes of the VTK element for each element) and every rank writes its
+     * contiguous slab of every dataset in a single collective write.
+     *
+     * File layout of each .h5 file:
+     *   /points   (npoin x 3)
+     *   /topology mixed topology (xdmf type id followed by the global point indices for each cell)
+     *   /fields/<name> (npoin) for each field
+     *
+     * If error_bound is set, the coefficients of every registered field group are also stored
+     * per element with the lossy_compress codec (each vector component of an element is one run of ndof values):
+     *   /coefficients/group<i>/error_bound (1)     the absolute error bound of every coefficient
+     *   /coefficients/group<i>/elements    (nelem) the global element index
+     *   /coefficients/group<i>/ndof        (nelem) the number of coefficients of each component
+     *   /coefficients/group<i>/offsets     (nelem) the global byte offset of the element in data
+     *   /coefficients/group<i>/data        (nbytes) the compressed coefficients
+     * With write_sampled_fields = false only these compressed coefficients (and the mesh) are written.
+     * Modal coefficients (a HypercubeLegendreBasis) compress far better than nodal coefficients
+     * because the high order modes of a resolved solution quantize to zero.
+     *
+     * NOTE: in parallel this requires an HDF5 built with MPI (H5_HAVE_PARALLEL)
+     */
+    template<class T, class IDX, int ndim>
+    class XDMFWriter {
+
+        /// @brief samples a group of fields at the vtk points of every element
+        /// given the offset of the first point of each element and the number of points
+        /// returns the values point major (npoin x nfield)
+        using sample_fcn = std::function<std::vector<T>(FESpace<T, IDX, ndim>&, const std::vector<std::size_t>&)>;
+
+        /// @brief compresses the coefficients of each element of a group of fields with the given error bound
+        /// returns the bytes of each element
+        using compress_fcn = std::function<std::vector<std::vector<std::uint8_t>>(FESpace<T, IDX, ndim>&, T)>;
+
+        struct field_group {
+            std::vector<std::string> names;
+            sample_fcn sample;
+            compress_fcn compress;
+        };
+
+        FESpace<T, IDX, ndim>* fespace_ptr = nullptr;
+
+        std::vector<field_group> fields{};
+
+        /// @brief the times and h5 files of each output (for the temporal collection on rank 0)
+        std::vector<std::pair<T, std::string>> entries{};
+
+        /// @brief the number of cells, points, and topology entries of each output
+        struct grid_sizes { std::size_t ncell, npoin, ntopo; };
+        std::vector<grid_sizes> entry_sizes{};
+
+        /// @brief the offset of this rank and the global size for a local size
+        static auto global_slab(std::size_t nlocal) -> std::pair<std::size_t, std::size_t> {
+#ifdef ICEICLE_USE_MPI
+            unsigned long long local = nlocal, offset = 0, total = 0;
+            MPI_Exscan(&local, &offset, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+            if(mpi::mpi_world_rank() == 0) offset = 0;
+            MPI_Allreduce(&local, &total, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+            return {offset, total};
+#else
+            return {0, nlocal};
+#endif
+        }
+
+        /**
+         * @brief collectively write a 1 or 2 dimensional dataset
+         * @param file the HDF5 file
+         * @param name the dataset path
+         * @param values the local rows (row major)
+         * @param ncol the number of columns
+         */
+        template<class V>
+        static auto write_dataset(hid_t file, const std::string& name, const std::vector<V>& values, std::size_t ncol)
+        -> void {
+            std::size_t nrow_local = values.size() / ncol;
+            auto [row_offset, nrow] = global_slab(nrow_local);
+            int rank = (ncol > 1) ? 2 : 1;
+            hsize_t dims[2] = {nrow, ncol};
+            hsize_t start[2] = {row_offset, 0};
+            hsize_t count[2] = {nrow_local, ncol};
+
+            hid_t filespace = H5Screate_simple(rank, dims, nullptr);
+            hid_t dset = H5Dcreate2(file, name.c_str(), impl::hdf5_type<V>(), filespace,
+                    H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+            H5Sselect_hyperslab(filespace, H5S_SELECT_SET, start, nullptr, count, nullptr);
+            hid_t memspace = H5Screate_simple(rank, count, nullptr);
+
+            hid_t xfer = H5Pcreate(H5P_DATASET_XFER);
+#ifdef ICEICLE_USE_MPI
+            H5Pset_dxpl_mpio(xfer, H5FD_MPIO_COLLECTIVE);
+#endif
+            H5Dwrite(dset, impl::hdf5_type<V>(), memspace, filespace, xfer, values.data());
+
+            H5Pclose(xfer);
+            H5Sclose(memspace);
+            H5Dclose(dset);
+            H5Sclose(filespace);
+        }
+
+        /// @brief rewrite the temporal XDMF collection with every output so far (on rank 0)
+        auto write_xdmf() const -> void {
+            std::filesystem::path xmf_path = data_directory;
+            xmf_path /= (collection_name + ".xmf");
+            std::ofstream out{xmf_path};
+            if(!out) {
+                util::AnomalyLog::log_anomaly(util::Anomaly{"could not open xdmf file for writing", util::general_anomaly_tag{}});
+                return;
+            }
+            const char* precision = (sizeof(T) == 4) ? "4" : "8";
+            out << std::setprecision(16);
+            out << "<?xml version=\"1.0\"?>\n";
+            out << "<Xdmf Version=\"3.0\">\n<Domain>\n";
+            out << "<Grid Name=\"" << collection_name << "\" GridType=\"Collection\" CollectionType=\"Temporal\">\n";
+            for(std::size_t ientry = 0; ientry < entries.size(); ++ientry){
+                const auto& [time, h5file] = entries[ientry];
+                const grid_sizes& sizes = entry_sizes[ientry];
+                out << "<Grid Name=\"mesh\" GridType=\"Uniform\">\n";
+                out << "<Time Value=\"" << time << "\"/>\n";
+                out << "<Topology TopologyType=\"Mixed\" NumberOfElements=\"" << sizes.ncell << "\">\n";
+                out << "<DataItem Dimensions=\"" << sizes.ntopo << "\" NumberType=\"Int\" Precision=\"8\" Format=\"HDF\">"
+                    << h5file << ":/topology</DataItem>\n</Topology>\n";
+                out << "<Geometry GeometryType=\"XYZ\">\n";
+                out << "<DataItem Dimensions=\"" << sizes.npoin << " 3\" NumberType=\"Float\" Precision=\"" << precision
+                    << "\" Format=\"HDF\">" << h5file << ":/points</DataItem>\n</Geometry>\n";
+                for(const field_group& group : fields){
+                    if(!write_sampled_fields) break;
+                    for(const std::string& name : group.names){
+                        out << "<Attribute Name=\"" << name << "\" AttributeType=\"Scalar\" Center=\"Node\">\n";
+                        out << "<DataItem Dimensions=\"" << sizes.npoin << "\" NumberType=\"Float\" Precision=\"" << precision
+                            << "\" Format=\"HDF\">" << h5file << ":/fields/" << name << "</DataItem>\n</Attribute>\n";
+                    }
+                }
+                out << "</Grid>\n";
+            }
+            out << "</Grid>\n</Domain>\n</Xdmf>\n";
+        }
+
+        /// @brief collectively write the compressed coefficients of every field group
+        auto write_coefficients(hid_t file, FESpace<T, IDX, ndim>& fespace, T eb) const -> void {
+            const AbstractMesh<T, IDX, ndim>& mesh = *fespace.meshptr;
+            hid_t coeff_grp = H5Gcreate2(file, "coefficients", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+            for(std::size_t igroup = 0; igroup < fields.size(); ++igroup){
+                std::string grp_name = "coefficients/group" + std::to_string(igroup);
+                hid_t grp = H5Gcreate2(file, grp_name.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+                std::vector<std::vector<std::uint8_t>> el_bytes = fields[igroup].compress(fespace, eb);
+
+                std::size_t nbytes = 0;
+                for(const std::vector<std::uint8_t>& bytes : el_bytes) nbytes += bytes.size();
+                std::size_t byte_offset = global_slab(nbytes).first;
+                std::vector<std::uint8_t> data{};
+                data.reserve(nbytes);
+                std::vector<std::int64_t> elements{}, ndofs{}, offsets{};
+                for(std::size_t iel = 0; iel < el_bytes.size(); ++iel){
+                    elements.push_back(mesh.gel_idxs.empty() ? iel : mesh.gel_idxs[iel]);
+                    ndofs.push_back(fespace.elements[iel].nbasis());
+                    offsets.push_back(byte_offset + data.size());
+                    data.insert(data.end(), el_bytes[iel].begin(), el_bytes[iel].end());
+                }
+                std::vector<T> eb_value{};
+                if(mpi::mpi_world_rank() == 0) eb_value.push_back(eb);
+
+                write_dataset(file, grp_name + "/error_bound", eb_value, 1);
+                write_dataset(file, grp_name + "/elements", elements, 1);
+                write_dataset(file, grp_name + "/ndof", ndofs, 1);
+                write_dataset(file, grp_name + "/offsets", offsets, 1);
+                write_dataset(file, grp_name + "/data", data, 1);
+                H5Gclose(grp);
+            }
+            H5Gclose(coeff_grp);
+        }
+
+        public:
+        using value_type = T;
+
+        std::string collection_name = "data";
+        std::filesystem::path data_directory;
+
+        /// @brief if set, also write the lossy compressed coefficients with this absolute error bound
+        std::optional<T> error_bound = std::nullopt;
+
+        /// @brief write the fields sampled at the vtk points (for ParaView)
+        bool write_sampled_fields = true;
+
+        XDMFWriter() : data_directory(std::filesystem::current_path()) {
+            data_directory /= "iceicle_data";
+        }
+
+        /// @brief register the finite element space the fields are defined on
+        void register_fespace(FESpace<T, IDX, ndim>& fespace) { fespace_ptr = &fespace; }
+
+        /**
+         * @brief register a set of fields represented in an fespan
+         * @param fedata the global data view to write to files (must outlive the writer)
+         * @param field_names the names for each vector component of fedata
+         */
+        template<class LayoutPolicy, class AccessorPolicy>
+        void register_fields(fespan<T, LayoutPolicy, AccessorPolicy>& fedata, std::vector<std::string> field_names) {
+            if(field_names.size() != fedata.nv())
+                util::AnomalyLog::log_anomaly(util::Anomaly{"field names size does not match number of fields", util::general_anomaly_tag{}});
+            fespan<T, LayoutPolicy, AccessorPolicy> data = fedata;
+            fields.push_back(field_group{field_names,
+                [data](FESpace<T, IDX, ndim>& fespace, const std::vector<std::size_t>& el_offsets){
+                    using Element = FiniteElement<T, IDX, ndim>;
+                    const std::size_t nv = data.nv();
+                    std::vector<T> values(el_offsets.back() * nv, 0.0);
+                    util::parallel_for(fespace.elements.size(), [&](std::size_t iel){
+                        Element& el = fespace.elements[iel];
+                        impl::VTKElement<T, ndim>& vtk_el = impl::get_vtk_element(el.trans, el.basis->getPolynomialOrder());
+                        std::vector<T> basis_data(el.nbasis());
+                        std::size_t ipoin = el_offsets[iel];
+                        for(const MATH::GEOMETRY::Point<T, ndim>& refnode : vtk_el.nodes){
+                            el.eval_basis(refnode, basis_data.data());
+                            for(std::size_t iv = 0; iv < nv; ++iv){
+                                for(std::size_t idof = 0; idof < el.nbasis(); ++idof)
+                                    { values[ipoin * nv + iv] += data[el.elidx, idof, iv] * basis_data[idof]; }
+                            }
+                            ++ipoin;
+                        }
+                    });
+                    return values;
+                },
+                [data](FESpace<T, IDX, ndim>& fespace, T eb){
+                    std::vector<std::vector<std::uint8_t>> el_bytes(fespace.elements.size());
+                    util::parallel_for(fespace.elements.size(), [&](std::size_t iel){
+                        IDX elidx = fespace.elements[iel].elidx;
+                        std::vector<T> coeffs(data.ndof(elidx));
+                        for(std::size_t iv = 0; iv < data.nv(); ++iv){
+                            for(std::size_t idof = 0; idof < coeffs.size(); ++idof)
+                                { coeffs[idof] = data[elidx, idof, iv]; }
+                            util::lossy_compress(std::span<const T>{coeffs}, eb, el_bytes[iel]);
+                        }
+                    });
+                    return el_bytes;
+                }
+            });
+        }
+
+        /**
+         * @brief collectively write the mesh and fields at the subdivided points to
+         * "<collection_name><itime>.h5" and add the output to the XDMF collection
+         * @param itime the time index
+         * @param time the time value
+         */
+        void write_h5(int itime, T time) {
+            using namespace impl;
+            using Element = FiniteElement<T, IDX, ndim>;
+            if(fespace_ptr == nullptr){
+                util::AnomalyLog::log_anomaly(util::Anomaly{"fespace not set for xdmf writer", util::general_anomaly_tag{}});
+                return;
+            }
+            FESpace<T, IDX, ndim>& fespace = *fespace_ptr;
+            if(mpi::mpi_world_rank() == 0) std::filesystem::create_directories(data_directory);
+#ifdef ICEICLE_USE_MPI
+            MPI_Barrier(MPI_COMM_WORLD);
+#endif
+
+            // local points and the mixed topology (duplicated points for each element as in PVDWriter)
+            std::vector<std::size_t> el_offsets{0};
+            for(Element& el : fespace.elements){
+                VTKElement<T, ndim>& vtk_el = get_vtk_element(el.trans, el.basis->getPolynomialOrder());
+                el_offsets.push_back(el_offsets.back() + vtk_el.nodes.size());
+            }
+            auto [point_offset, npoin] = global_slab(el_offsets.back());
+
+            std::vector<T> points(3 * el_offsets.back(), 0.0);
+            std::vector<std::int64_t> topology{};
+            for(std::size_t iel = 0; iel < fespace.elements.size(); ++iel){
+                Element& el = fespace.elements[iel];
+                VTKElement<T, ndim>& vtk_el = get_vtk_element(el.trans, el.basis->getPolynomialOrder());
+                int xdmf_id = xdmf_topology_id(vtk_el);
+                if(xdmf_id < 0) util::AnomalyLog::log_anomaly(util::Anomaly{
+                        "no xdmf topology for the element", util::general_anomaly_tag{}});
+                topology.push_back(xdmf_id);
+                std::size_t ipoin = el_offsets[iel];
+                for(const MATH::GEOMETRY::Point<T, ndim>& refnode : vtk_el.nodes){
+                    MATH::GEOMETRY::Point<T, ndim> point_phys = el.transform(refnode);
+                    for(int idim = 0; idim < ndim; ++idim) points[3 * ipoin + idim] = point_phys[idim];
+                    topology.push_back(point_offset + ipoin);
+                    ++ipoin;
+                }
+            }
+
+            // open the file for collective access
+            std::string h5file = collection_name + std::to_string(itime) + ".h5";
+            std::filesystem::path h5_path = data_directory / h5file;
+            hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+#ifdef ICEICLE_USE_MPI
+            H5Pset_fapl_mpio(fapl, MPI_COMM_WORLD, MPI_INFO_NULL);
+#endif
+            hid_t file = H5Fcreate(h5_path.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+            H5Pclose(fapl);
+            if(file < 0){
+                util::AnomalyLog::log_anomaly(util::Anomaly{"could not create hdf5 file " + h5_path.string(), util::general_anomaly_tag{}});
+                return;
+            }
+
+            write_dataset(file, "points", points, 3);
+            write_dataset(file, "topology", topology, 1);
+            hid_t field_grp = H5Gcreate2(file, "fields", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+            for(const field_group& group : fields){
+                if(!write_sampled_fields) break;
+                std::vector<T> values = group.sample(fespace, el_offsets);
+                const std::size_t nfield = group.names.size();
+                std::vector<T> column(el_offsets.back());
+                for(std::size_t ifield = 0; ifield < nfield; ++ifield){
+                    for(std::size_t ipoin = 0; ipoin < column.size(); ++ipoin)
+                        { column[ipoin] = values[ipoin * nfield + ifield]; }
+                    write_dataset(file, "fields/" + group.names[ifield], column, 1);
+                }
+            }
+            H5Gclose(field_grp);
+            if(error_bound) write_coefficients(file, fespace, error_bound.value());
+            H5Fclose(file);
+
+            // the global sizes for the collection
+            std::size_t ncell = global_slab(fespace.elements.size()).second;
+            std::size_t ntopo = global_slab(topology.size()).second;
+            if(mpi::mpi_world_rank() == 0){
+                entries.emplace_back(time, h5file);
+                entry_sizes.push_back(grid_sizes{ncell, npoin, ntopo});
+                write_xdmf();
+            }
+        }
+    };
+}
+#endif
@@ -1,5 +1,9 @@
 #include <iceicle/pvd_writer.hpp>
+#include <iceicle/anomaly_log.hpp>
 #include <ostream>
+#ifdef ICEICLE_USE_ZLIB
+#include <zlib.h>
+#endif
 namespace iceicle::io {
 
     namespace impl {
@@ -30,7 +34,7 @@ namespace iceicle::io {
             out << "</" << tag.name << ">" << std::endl;
         }
 
-        void write_vtu_header(std::ostream &out){
+        void write_vtu_header(std::ostream &out, bool compressed){
             
             XMLTag vtkfiletag = {.name="VTKFile", .fields = {
                 {"type", "UnstructuredGrid"},
@@ -38,6 +42,7 @@ namespace iceicle::io {
                 {"byte_order", "LittleEndian"},
                 {"header_type", "UInt64"}
             }};
+            if(compressed) vtkfiletag.fields.push_back({"compressor", "vtkZLibDataCompressor"});
 
             write_open(vtkfiletag, out);
         }
@@ -45,5 +50,83 @@ namespace iceicle::io {
         void write_vtu_footer(std::ostream &out){
             out << "</VTKFile>" << std::endl;
         }
+
+        /// @brief base64 encode the bytes (with padding) and append to out
+        static void base64_encode(std::span<const std::byte> bytes, std::string &out){
+            static constexpr char table[] =
+                "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            auto byte = [&](std::size_t i) -> unsigned int 
+                { return (i < bytes.size()) ? std::to_integer<unsigned int>(bytes[i]) : 0u; };
+            for(std::size_t i = 0; i < bytes.size(); i += 3){
+                unsigned int triple = (byte(i) << 16) | (byte(i + 1) << 8) | byte(i + 2);
+                out += table[(triple >> 18) & 63];
+                out += table[(triple >> 12) & 63];
+                out += (i + 1 < bytes.size()) ? table[(triple >> 6) & 63] : '=';
+                out += (i + 2 < bytes.size()) ? table[triple & 63] : '=';
+            }
+        }
+
+        DataArrayWriter::DataArrayWriter(vtu_format format, bool compress)
+        : format{format}, compress{compress && format != vtu_format::ascii} 
+        {
+#ifndef ICEICLE_USE_ZLIB
+            if(this->compress){
+                util::AnomalyLog::log_anomaly(util::Anomaly{
+                    "zlib compressed vtu output requires building with ICEICLE_USE_ZLIB, writing uncompressed",
+                    util::general_anomaly_tag{}});
+                this->compress = false;
+            }
+#endif
+        }
+
+        void DataArrayWriter::encode_block(std::span<const std::byte> bytes, std::string &dest) const {
+            // the header and data are encoded separately for base64 (as vtk does)
+            auto emit = [&](std::span<const std::byte> part){
+                if(format == vtu_format::raw) 
+                    dest.append(reinterpret_cast<const char *>(part.data()), part.size());
+                else 
+                    base64_encode(part, dest);
+            };
+
+            if(compress) {
+#ifdef ICEICLE_USE_ZLIB
+                // header: [nblock, block size, last partial block size, compressed size of each block]
+                static constexpr std::uint64_t block_size = 1 << 15;
+                const std::uint64_t nbytes = bytes.size();
+                const std::uint64_t nblock = (nbytes + block_size - 1) / block_size;
+                std::vector<std::uint64_t> header{nblock, block_size, nbytes % block_size};
+                std::vector<std::byte> compressed{};
+                for(std::uint64_t iblock = 0; iblock < nblock; ++iblock){
+                    std::uint64_t start = iblock * block_size;
+                    uLong len = std::min(block_size, nbytes - start);
+                    uLongf compressed_len = compressBound(len);
+                    std::size_t compressed_start = compressed.size();
+                    compressed.resize(compressed_start + compressed_len);
+                    compress2(reinterpret_cast<Bytef *>(compressed.data() + compressed_start), &compressed_len, 
+                            reinterpret_cast<const Bytef *>(bytes.data() + start), len, Z_DEFAULT_COMPRESSION);
+                    compressed.resize(compressed_start + compressed_len);
+                    header.push_back(compressed_len);
+                }
+                emit(std::as_bytes(std::span<const std::uint64_t>{header}));
+                emit(std::span<const std::byte>{compressed});
+#endif
+            } else {
+                const std::uint64_t nbytes = bytes.size();
+                emit(std::as_bytes(std::span<const std::uint64_t>{&nbytes, 1}));
+                emit(bytes);
+            }
+        }
+
+        void DataArrayWriter::write_appended(std::ostream &out){
+            if(format == vtu_format::ascii || format == vtu_format::binary) return;
+            write_open(XMLTag{"AppendedData", {
+                {"encoding", (format == vtu_format::raw) ? "raw" : "base64"}
+            }}, out);
+            out << "_";
+            out.write(appended.data(), appended.size());
+            out << std::endl;
+            write_close(XMLTag{"AppendedData"}, out);
+            appended.clear();
+        }
     }
 }
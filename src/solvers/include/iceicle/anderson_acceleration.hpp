@@ -0,0 +1,267 @@
+/**
+ * @brief Anderson acceleration of fixed point iterations driven by explicit solvers
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/explicit_utils.hpp"
+#include "iceicle/form_residual.hpp"
+#ifdef ICEICLE_USE_MPI
+#include "iceicle/mpi_type.hpp"
+#include <mpi.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+namespace iceicle::solvers {
+
+/**
+ * @brief Anderson acceleration (type-II, windowed) for steady problems
+ * converged by pseudo-time stepping with an explicit solver
+ *
+ * One step of the wrapped solver is the fixed point map u -> G(u)
+ * with fixed point residual f(u) = G(u) - u.
+ * With the differences of the last m iterates
+ * dF = [f_{k-m+1} - f_{k-m}, ..., f_k - f_{k-1}] and dG likewise,
+ * the next iterate is
+ *
+ *    gamma = argmin || f_k - dF gamma ||
+ *    u_{k+1} = G(u_k) - dG gamma - (1 - beta) (f_k - dF gamma)
+ *
+ * (Walker and Ni 2011 SIAM J. Numer. Anal.)
+ * The history is a ring buffer of full solution sized vectors.
+ * The least squares problem is solved through the (regularized) normal equations of size m;
+ * if they are singular the history is restarted.
+ *
+ * @tparam T the floating point type
+ * @tparam IDX the index type
+ * @tparam SolverT the explicit solver that provides step(fespace, disc, u),
+ * stop_condition, itime, time, and res_data
+ */
+template<class T, class IDX, class SolverT>
+class AndersonAcceleration {
+
+public:
+
+    /// @brief the wrapped solver (one step is one fixed point iteration)
+    SolverT& solver;
+
+    /// @brief the number of previous iterates to use (0 is the plain fixed point iteration)
+    IDX window = 5;
+
+    /// @brief the mixing (damping) parameter (1 is undamped)
+    T beta = 1.0;
+
+    /// @brief stop when the l2 norm of the fixed point residual G(u) - u is below this (if positive)
+    T tol = 0.0;
+
+    /// @brief the relative regularization of the normal equations
+    T regularization = 1e-12;
+
+    /// @brief the residual data array (of the wrapped solver)
+    std::vector<T>& res_data;
+
+    /// @brief the current timestep (number of fixed point iterations)
+    IDX itime = 0;
+
+    /// @brief the current (pseudo) time
+    T time = 0.0;
+
+    /// @brief the l2 norm of the last fixed point residual G(u) - u
+    T fixed_point_residual = 0.0;
+
+    /// @brief the callback function for visualization during solve()
+    /// is given a reference to this when called
+    std::function<void(AndersonAcceleration &)> vis_callback = [](AndersonAcceleration &accel){
+        std::cout << std::setprecision(8);
+        std::cout << "itime: " << std::setw(6) << accel.itime
+            << " | t: " << std::setw(14) << accel.time
+            << " | fixed point residual l2: " << std::setw(14) << accel.fixed_point_residual
+            << std::endl;
+    };
+
+    /// @brief if this is a positive integer
+    /// then the vis_callback will be called every ivis iterations
+    IDX ivis = -1;
+
+private:
+
+    /// @brief the differences of the fixed point residuals (ring buffer)
+    std::vector<std::vector<T>> dF{};
+
+    /// @brief the differences of the fixed point map (ring buffer)
+    std::vector<std::vector<T>> dG{};
+
+    /// @brief the index of the oldest entry in the ring buffer
+    IDX head = 0;
+
+    /// @brief the number of valid entries in the ring buffer
+    IDX nhist = 0;
+
+public:
+
+    /// @param solver the explicit solver to accelerate
+    AndersonAcceleration(SolverT& solver)
+    : solver{solver}, res_data{solver.res_data} {}
+
+    AndersonAcceleration(const AndersonAcceleration&) = delete;
+    AndersonAcceleration& operator=(const AndersonAcceleration&) = delete;
+
+    /**
+     * @brief perform accelerated fixed point iterations until the stop condition
+     * of the wrapped solver is reached or the fixed point residual is below tol
+     *
+     * @param [in] fespace the finite element space
+     * @param [in] disc the discretization
+     * @param [in/out] u the solution as an fespan view
+     */
+    template<int ndim, class disc_class, class LayoutPolicy, class uAccessorPolicy>
+    void solve(FESpace<T, IDX, ndim> &fespace, disc_class &disc, fespan<T, LayoutPolicy, uAccessorPolicy> u) {
+        std::size_t n = u.size();
+        std::vector<T> g_data(n), f(n), g_prev(n), f_prev(n);
+        fespan g{g_data.data(), u.get_layout()};
+
+        // the ring buffer storage
+        dF.assign(window, std::vector<T>(n));
+        dG.assign(window, std::vector<T>(n));
+        head = 0;
+        nhist = 0;
+
+        // the least squares workspace
+        std::vector<T> gram(window * window), gamma(window);
+
+        // call initial residual to get initial wavespeeds for dt
+        {
+            fespan res{res_data.data(), u.get_layout()};
+            form_residual(fespace, disc, u, res);
+        }
+
+        sync_counters();
+        vis_callback(*this);
+
+        for(IDX k = 0; !solver.stop_condition(solver.itime, solver.time); ++k){
+            // fixed point map and residual
+            copy_fespan(u, g);
+            solver.step(fespace, disc, g);
+            for(std::size_t i = 0; i < n; ++i) f[i] = g_data[i] - u.data()[i];
+            fixed_point_residual = std::sqrt(dot(f, f));
+
+            // push the differences to the history
+            if(k > 0 && window > 0){
+                IDX islot = (head + nhist) % window;
+                if(nhist == window) head = (head + 1) % window;
+                else ++nhist;
+                for(std::size_t i = 0; i < n; ++i){
+                    dF[islot][i] = f[i] - f_prev[i];
+                    dG[islot][i] = g_data[i] - g_prev[i];
+                }
+            }
+            std::ranges::copy(f, f_prev.begin());
+            std::ranges::copy(g_data, g_prev.begin());
+
+            // least squares for the mixing coefficients
+            IDX m = nhist;
+            if(m > 0){
+                T trace = 0.0;
+                for(IDX i = 0; i < m; ++i){
+                    const std::vector<T>& dFi = dF[(head + i) % window];
+                    for(IDX j = 0; j <= i; ++j){
+                        T aij = dot(dFi, dF[(head + j) % window]);
+                        gram[i * m + j] = gram[j * m + i] = aij;
+                    }
+                    trace += gram[i * m + i];
+                    gamma[i] = dot(dFi, f);
+                }
+                for(IDX i = 0; i < m; ++i) gram[i * m + i] += regularization * trace;
+                if(trace <= 0 || !solve_dense(m, gram, gamma)){
+                    // restart from the plain fixed point iteration
+                    nhist = 0;
+                    head = 0;
+                    m = 0;
+                }
+            }
+
+            // u_{k+1} = g - dG gamma - (1 - beta) (f - dF gamma)
+            for(std::size_t i = 0; i < n; ++i){
+                T gi = g_data[i];
+                T fi = f[i];
+                for(IDX j = 0; j < m; ++j){
+                    gi -= gamma[j] * dG[(head + j) % window][i];
+                    fi -= gamma[j] * dF[(head + j) % window][i];
+                }
+                u.data()[i] = gi - (1.0 - beta) * fi;
+            }
+
+            sync_counters();
+            if(ivis > 0 && itime % ivis == 0) vis_callback(*this);
+            if(tol > 0 && fixed_point_residual <= tol) break;
+        }
+
+        // output the final iteration
+        vis_callback(*this);
+    }
+
+private:
+
+    /// @brief take the iteration counters from the wrapped solver
+    void sync_counters() {
+        itime = solver.itime;
+        time = solver.time;
+    }
+
+    /// @brief the global dot product of two vectors
+    static auto dot(const std::vector<T>& a, const std::vector<T>& b) -> T {
+        T sum = 0.0;
+        for(std::size_t i = 0; i < a.size(); ++i) sum += a[i] * b[i];
+#ifdef ICEICLE_USE_MPI
+        MPI_Allreduce(MPI_IN_PLACE, &sum, 1, mpi_get_type<T>(), MPI_SUM, MPI_COMM_WORLD);
+#endif
+        return sum;
+    }
+
+    /**
+     * @brief solve the small dense system A x = b with gaussian elimination and partial pivoting
+     * @param m the size of the system
+     * @param [in/out] A the row major matrix (destroyed)
+     * @param [in/out] b the right hand side, overwritten with the solution
+     * @return false if the matrix is singular
+     */
+    static auto solve_dense(IDX m, std::vector<T>& A, std::vector<T>& b) -> bool {
+        for(IDX icol = 0; icol < m; ++icol){
+            IDX ipiv = icol;
+            for(IDX irow = icol + 1; irow < m; ++irow)
+                if(std::abs(A[irow * m + icol]) > std::abs(A[ipiv * m + icol])) ipiv = irow;
+            if(A[ipiv * m + icol] == 0.0 || !std::isfinite(A[ipiv * m + icol])) return false;
+            if(ipiv != icol){
+                for(IDX j = 0; j < m; ++j) std::swap(A[icol * m + j], A[ipiv * m + j]);
+                std::swap(b[icol], b[ipiv]);
+            }
+            for(IDX irow = icol + 1; irow < m; ++irow){
+                T factor = A[irow * m + icol] / A[icol * m + icol];
+                for(IDX j = icol; j < m; ++j) A[irow * m + j] -= factor * A[icol * m + j];
+                b[irow] -= factor * b[icol];
+            }
+        }
+        for(IDX irow = m - 1; irow >= 0; --irow){
+            for(IDX j = irow + 1; j < m; ++j) b[irow] -= A[irow * m + j] * b[j];
+            b[irow] /= A[irow * m + irow];
+        }
+        return true;
+    }
+};
+
+// template argument deduction
+template<class SolverT>
+AndersonAcceleration(SolverT&) -> AndersonAcceleration<
+    std::remove_cvref_t<decltype(std::declval<SolverT&>().time)>,
+    std::remove_cvref_t<decltype(std::declval<SolverT&>().itime)>, SolverT>;
+
+}
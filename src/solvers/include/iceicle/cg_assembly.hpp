@@ -0,0 +1,469 @@
+/**
+ * @brief residual assembly and the global mass matrix for continuous (ISOPARAMETRIC_H1) spaces
+ *
+ * The degrees of freedom of an isoparametric CG space are the mesh nodes (see cg_dof_map)
+ * so neighboring elements scatter to the same entries.
+ * Elements are colored so that no two elements of a color share a node
+ * and each color is assembled in parallel without atomics.
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/crs.hpp"
+#include "iceicle/element_linear_solve.hpp"
+#include "iceicle/fe_function/cg_map.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/form_residual.hpp"
+#include "iceicle/geometry/face.hpp"
+#include "iceicle/graph_coloring.hpp"
+#include "iceicle/profiler.hpp"
+#include "iceicle/thread_utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace iceicle::solvers {
+
+    /// @brief true if the layout maps element local dofs to the shared dofs of a CG space
+    template<class LayoutPolicy>
+    concept cg_layout = requires { typename LayoutPolicy::dof_mapping_type; }
+        && is_cg_dof_map<typename LayoutPolicy::dof_mapping_type>::value;
+
+    /**
+     * @brief Workspace for form_cg_residual that persists across calls
+     * Holds the element coloring (no two elements of a color share a node),
+     * the physical boundary traces, and the element-local scratch storage (one set per thread)
+     *
+     * Valid as long as the mesh connectivity does not change
+     */
+    template<class T, class IDX>
+    struct CGWorkspace {
+        /// @brief the number of scratch buffers per thread
+        static constexpr int nbuffer = 3;
+
+        /// @brief the size of each scratch buffer
+        std::size_t max_local_size = 0;
+
+        /// @brief the number of threads scratch storage is allocated for
+        int nthread = 1;
+
+        /// @brief the scratch storage
+        std::vector<T> scratch;
+
+        /// @brief each row is a set of elements that do not share any node
+        util::crs<IDX, IDX> element_colors;
+
+        /// @brief the indices (into fespace.traces) of the boundary traces
+        /// interior traces do not contribute for a continuous solution
+        std::vector<IDX> physical_bdy_traces;
+
+        /// @brief default constructor: an empty workspace
+        CGWorkspace() = default;
+
+        /**
+         * @brief construct the workspace for a given finite element space
+         * @param fespace the finite element space
+         * @param nv the number of vector components per degree of freedom
+         */
+        template<int ndim>
+        CGWorkspace(FESpace<T, IDX, ndim>& fespace, std::size_t nv)
+        : max_local_size{fespace.cg_map.max_el_size_reqirement(nv)}, nthread{util::max_threads()}
+        {
+            scratch.resize(nthread * nbuffer * max_local_size);
+            const cg_dof_map<T, IDX, ndim>& cg_map = fespace.cg_map;
+            element_colors = util::greedy_coloring<IDX>(cg_map.nelem(), cg_map.size(), [&](IDX iel){
+                return fespace.meshptr->conn_el.rowspan(iel);
+            });
+            for(IDX itrace = fespace.bdy_trace_start; itrace < fespace.bdy_trace_end; ++itrace){
+                if(fespace.traces[itrace].face->bctype != BOUNDARY_CONDITIONS::PARALLEL_COM)
+                    physical_bdy_traces.push_back(itrace);
+            }
+        }
+
+        /// @brief get the scratch buffer for a thread
+        auto scratch_data(int ithread, int ibuffer) -> T* {
+            return scratch.data() + (ithread * nbuffer + ibuffer) * max_local_size;
+        }
+    };
+
+    /**
+     * @brief form the residual of a discretization for a continuous solution
+     * the sum of the domain integrals and boundary integrals scattered to the shared dofs
+     * (M du/dt = residual where M is the global mass matrix, see CGMassMatrix)
+     *
+     * NOTE: the dofs are not communicated between processes
+     *
+     * @param fespace the ISOPARAMETRIC_H1 finite element space
+     * @param disc the discretization
+     * @param u the solution (in a cg layout)
+     * @param res the residual to fill (in a cg layout)
+     * @param workspace persistent storage constructed from this fespace
+     */
+    template<class T, class IDX, int ndim, class disc_class,
+        class uLayoutPolicy, class uAccessorPolicy, class resLayoutPolicy>
+    auto form_cg_residual(
+        FESpace<T, IDX, ndim>& fespace,
+        disc_class& disc,
+        fespan<T, uLayoutPolicy, uAccessorPolicy> u,
+        fespan<T, resLayoutPolicy> res,
+        CGWorkspace<T, IDX>& workspace
+    ) -> void
+    requires specifies_ncomp<disc_class>
+    {
+        using Element = FiniteElement<T, IDX, ndim>;
+        using Trace = TraceSpace<T, IDX, ndim>;
+        ICEICLE_PROFILE_REGION("form_cg_residual");
+
+        fespace.update_geometric_factors();
+        res = 0;
+
+        // boundary faces
+        {
+        ICEICLE_PROFILE_REGION("boundary_traces");
+        T* u_data = workspace.scratch_data(0, 0);
+        T* res_data = workspace.scratch_data(0, 1);
+        for(IDX itrace : workspace.physical_bdy_traces){
+            const Trace& trace = fespace.traces[itrace];
+            auto u_layout = u.create_element_layout(trace.elL.elidx);
+            dofspan u_el{u_data, u_layout};
+            auto res_layout = res.create_element_layout(trace.elL.elidx);
+            dofspan res_el{res_data, res_layout};
+            extract_elspan(trace.elL.elidx, u, u_el);
+            res_el = 0;
+            disc.boundaryIntegral(trace, fespace.meshptr->coord, u_el, u_el, res_el);
+            scatter_elspan(trace.elL.elidx, 1.0, res_el, 1.0, res);
+        }
+        }
+
+        // domain integrals
+        // elements within a color do not share dofs so scatters do not race
+        auto domain_residual = [&](const Element& el, T* u_data, T* res_data){
+            auto u_layout = u.create_element_layout(el.elidx);
+            dofspan u_el{u_data, u_layout};
+            auto res_layout = res.create_element_layout(el.elidx);
+            dofspan res_el{res_data, res_layout};
+            extract_elspan(el.elidx, u, u_el);
+            res_el = 0;
+            disc.domain_integral(el, u_el, res_el);
+            scatter_elspan(el.elidx, 1.0, res_el, 1.0, res);
+        };
+        {
+        ICEICLE_PROFILE_REGION("domain");
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp parallel num_threads(workspace.nthread)
+        {
+            int ithread = util::thread_num();
+            T* u_thread = workspace.scratch_data(ithread, 0);
+            T* res_thread = workspace.scratch_data(ithread, 1);
+            for(IDX icolor = 0; icolor < workspace.element_colors.nrow(); ++icolor){
+                std::span<IDX> color = workspace.element_colors.rowspan(icolor);
+#pragma omp for schedule(static)
+                for(std::size_t i = 0; i < color.size(); ++i)
+                    domain_residual(fespace.elements[color[i]], u_thread, res_thread);
+                // implicit barrier before the next color
+            }
+        }
+#else
+        for(const Element& el : fespace.elements)
+            domain_residual(el, workspace.scratch_data(0, 0), workspace.scratch_data(0, 1));
+#endif
+        }
+    }
+
+    /**
+     * @brief the global (scalar) mass matrix of an ISOPARAMETRIC_H1 space in compressed row storage
+     * applied to each vector component
+     *
+     * M_ij = sum_e \int_e \phi_i \phi_j
+     *
+     * If lumped, only the row sums are kept so M^{-1} is a scale.
+     * Otherwise M^{-1} is applied with Jacobi preconditioned conjugate gradient iterations
+     * (M is symmetric positive definite and well conditioned,
+     * the condition number does not grow with the mesh size)
+     *
+     * update() only rebuilds the entries when the mesh coordinates have changed
+     * (as tracked by AbstractMesh::coord_version)
+     */
+    template<class T, class IDX>
+    class CGMassMatrix {
+        public:
+
+        /// @brief keep only the row sums of the mass matrix
+        bool lumped = false;
+
+        /// @brief the relative tolerance of the conjugate gradient solve
+        T rtol = 1e-12;
+
+        /// @brief the maximum number of conjugate gradient iterations
+        IDX max_it = 200;
+
+        /// @brief the number of conjugate gradient iterations in the last apply_inverse()
+        IDX last_nit = 0;
+
+        private:
+
+        /// @brief the values of the matrix entries for each row (structure from the node graph)
+        util::crs<T, IDX> entries{};
+
+        /// @brief the column index of each entry (same structure as entries)
+        util::crs<IDX, IDX> columns{};
+
+        /// @brief the diagonal (or the row sums if lumped)
+        std::vector<T> diag{};
+
+        /// @brief the mesh coordinate version the entries were computed for
+        std::size_t coord_version = 0;
+
+        /// @brief if the entries have been computed at all
+        bool built = false;
+
+        /// @brief conjugate gradient storage
+        std::vector<T> x{}, r{}, z{}, p{}, q{};
+
+        public:
+
+        /// @brief default constructor: empty matrix (must be built before use)
+        CGMassMatrix() = default;
+
+        /**
+         * @brief construct and build the mass matrix
+         * @param fespace the ISOPARAMETRIC_H1 finite element space
+         * @param lumped keep only the row sums
+         */
+        template<int ndim>
+        CGMassMatrix(FESpace<T, IDX, ndim>& fespace, bool lumped = false)
+        : lumped{lumped} { build(fespace); }
+
+        /**
+         * @brief assemble the mass matrix from the element mass matrices
+         * @param fespace the ISOPARAMETRIC_H1 finite element space
+         */
+        template<int ndim>
+        auto build(FESpace<T, IDX, ndim>& fespace) -> void {
+            const cg_dof_map<T, IDX, ndim>& cg_map = fespace.cg_map;
+            AbstractMesh<T, IDX, ndim>& mesh = *fespace.meshptr;
+            const IDX ndof = cg_map.size();
+
+            // the nonzeros of each row are the nodes of the surrounding elements
+            if(!built){
+                std::vector<std::vector<IDX>> node_graph(ndof);
+                for(IDX idof = 0; idof < ndof; ++idof){
+                    for(IDX iel : mesh.elsup.rowspan(idof)){
+                        for(IDX jdof : mesh.conn_el.rowspan(iel)) node_graph[idof].push_back(jdof);
+                    }
+                    std::ranges::sort(node_graph[idof]);
+                    auto unique_subrange = std::ranges::unique(node_graph[idof]);
+                    node_graph[idof].erase(unique_subrange.begin(), unique_subrange.end());
+                }
+                columns = util::crs<IDX, IDX>{node_graph};
+                entries = util::convert_crs<T, IDX>(columns);
+            }
+            std::fill_n(entries.data(), entries.nnz(), 0.0);
+
+            for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+                MATH::MATRIX::DenseMatrix<T> mass = calculate_mass_matrix(el);
+                for(std::size_t ildof = 0; ildof < cg_map.ndof_el(el.elidx); ++ildof){
+                    IDX idof = cg_map[el.elidx, ildof];
+                    std::span<IDX> cols = columns.rowspan(idof);
+                    std::span<T> vals = entries.rowspan(idof);
+                    for(std::size_t jldof = 0; jldof < cg_map.ndof_el(el.elidx); ++jldof){
+                        auto it = std::ranges::lower_bound(cols, cg_map[el.elidx, jldof]);
+                        vals[it - cols.begin()] += mass[ildof][jldof];
+                    }
+                }
+            }
+
+            diag.assign(ndof, 0.0);
+            for(IDX idof = 0; idof < ndof; ++idof){
+                std::span<IDX> cols = columns.rowspan(idof);
+                std::span<T> vals = entries.rowspan(idof);
+                for(std::size_t k = 0; k < cols.size(); ++k){
+                    if(lumped) diag[idof] += vals[k];
+                    else if(cols[k] == idof) diag[idof] = vals[k];
+                }
+                if(diag[idof] <= 0.0){
+                    // i.e row sums of higher order simplex bases
+                    util::AnomalyLog::log_record("Nonpositive global mass matrix diagonal at dof ", idof);
+                    diag[idof] = 1.0;
+                }
+            }
+            coord_version = mesh.coord_version;
+            built = true;
+        }
+
+        /**
+         * @brief rebuild the entries only if the mesh has moved since the last build
+         * @param fespace the ISOPARAMETRIC_H1 finite element space
+         */
+        template<int ndim>
+        auto update(FESpace<T, IDX, ndim>& fespace) -> void {
+            if(!built || coord_version != fespace.meshptr->coord_version)
+                build(fespace);
+        }
+
+        /// @brief the number of rows
+        [[nodiscard]] auto nrow() const noexcept -> IDX { return diag.size(); }
+
+        /// @brief the column indices of the entries of a row (sorted)
+        [[nodiscard]] auto row_columns(IDX irow) const -> std::span<const IDX> { return columns.rowspan(irow); }
+
+        /// @brief the values of the entries of a row (unlumped)
+        [[nodiscard]] auto row_values(IDX irow) const -> std::span<const T> { return entries.rowspan(irow); }
+
+        /**
+         * @brief y = M x for one vector component of a cg layout
+         * @param x the input data (nrow * nv values in layout right order)
+         * @param y the output data
+         * @param nv the number of vector components
+         * @param iv the vector component
+         */
+        auto multiply(const T* x, T* y, std::size_t nv, std::size_t iv) const -> void {
+            const IDX n = nrow();
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+            for(IDX irow = 0; irow < n; ++irow){
+                if(lumped) {
+                    y[irow * nv + iv] = diag[irow] * x[irow * nv + iv];
+                } else {
+                    std::span<const IDX> cols = columns.rowspan(irow);
+                    std::span<const T> vals = entries.rowspan(irow);
+                    T sum = 0.0;
+                    for(std::size_t k = 0; k < cols.size(); ++k) sum += vals[k] * x[cols[k] * nv + iv];
+                    y[irow * nv + iv] = sum;
+                }
+            }
+        }
+
+        /**
+         * @brief apply the inverse mass matrix
+         * out = alpha * M^{-1} res + beta * out
+         *
+         * NOTE: res and out must not overlap
+         *
+         * @param [in] alpha the multiplier for M^{-1} res
+         * @param [in] res the global residual (cg layout)
+         * @param [in] beta the multiplier for out
+         * @param [in/out] out the global data to add to (cg layout)
+         */
+        template<class resLayoutPolicy, class resAccessorPolicy, class outLayoutPolicy, class outAccessorPolicy>
+        auto apply_inverse(
+            T alpha,
+            fespan<T, resLayoutPolicy, resAccessorPolicy> res,
+            T beta,
+            fespan<T, outLayoutPolicy, outAccessorPolicy> out
+        ) -> void {
+            const IDX n = nrow();
+            const std::size_t nv = res.nv();
+            if(lumped){
+                for(IDX idof = 0; idof < n; ++idof){
+                    for(std::size_t iv = 0; iv < nv; ++iv){
+                        T x = res.data()[idof * nv + iv] / diag[idof];
+                        T& o = out.data()[idof * nv + iv];
+                        o = (beta == 0.0) ? alpha * x : alpha * x + beta * o;
+                    }
+                }
+                return;
+            }
+
+            // one conjugate gradient solve per vector component (strided in the layout)
+            x.resize(n * nv);
+            r.resize(n * nv); z.resize(n * nv); p.resize(n * nv); q.resize(n * nv);
+            IDX nit_max = 0;
+            for(std::size_t iv = 0; iv < nv; ++iv){
+                auto at = [nv, iv](std::vector<T>& v, IDX i) -> T& { return v[i * nv + iv]; };
+                T bnorm = 0.0, rz = 0.0;
+                for(IDX i = 0; i < n; ++i){
+                    T b = res.data()[i * nv + iv];
+                    at(x, i) = b / diag[i]; // (Jacobi initial guess)
+                    bnorm += b * b;
+                }
+                multiply(x.data(), q.data(), nv, iv);
+                for(IDX i = 0; i < n; ++i){
+                    at(r, i) = res.data()[i * nv + iv] - at(q, i);
+                    at(z, i) = at(r, i) / diag[i];
+                    at(p, i) = at(z, i);
+                    rz += at(r, i) * at(z, i);
+                }
+                bnorm = std::sqrt(bnorm);
+                IDX it = 0;
+                for(; it < max_it; ++it){
+                    T rnorm = 0.0;
+                    for(IDX i = 0; i < n; ++i) rnorm += at(r, i) * at(r, i);
+                    if(std::sqrt(rnorm) <= rtol * bnorm) break;
+                    multiply(p.data(), q.data(), nv, iv);
+                    T pq = 0.0;
+                    for(IDX i = 0; i < n; ++i) pq += at(p, i) * at(q, i);
+                    T a = rz / pq;
+                    T rz_new = 0.0;
+                    for(IDX i = 0; i < n; ++i){
+                        at(x, i) += a * at(p, i);
+                        at(r, i) -= a * at(q, i);
+                        at(z, i) = at(r, i) / diag[i];
+                        rz_new += at(r, i) * at(z, i);
+                    }
+                    for(IDX i = 0; i < n; ++i) at(p, i) = at(z, i) + (rz_new / rz) * at(p, i);
+                    rz = rz_new;
+                }
+                nit_max = std::max(nit_max, it);
+            }
+            last_nit = nit_max;
+
+            for(std::size_t i = 0; i < n * nv; ++i){
+                T& o = out.data()[i];
+                o = (beta == 0.0) ? alpha * x[i] : alpha * x[i] + beta * o;
+            }
+        }
+    };
+
+    /**
+     * @brief the right hand side M^{-1} residual of an explicit time integrator for a continuous solution
+     * out = alpha * M^{-1} residual(u) + beta * out
+     *
+     * The workspace is built on first use and the mass matrix follows the mesh (see CGMassMatrix::update)
+     */
+    template<class T, class IDX>
+    struct CGExplicitRhs {
+        /// @brief the residual assembly workspace
+        CGWorkspace<T, IDX> workspace{};
+
+        /// @brief the global mass matrix (set mass.lumped before the first call to lump)
+        CGMassMatrix<T, IDX> mass{};
+
+        /// @brief if the workspace has been built
+        bool initialized = false;
+
+        /**
+         * @param fespace the ISOPARAMETRIC_H1 finite element space
+         * @param disc the discretization
+         * @param u the solution
+         * @param res storage for the residual (must not overlap out)
+         * @param alpha the multiplier for M^{-1} residual
+         * @param beta the multiplier for out
+         * @param out the global data to add to
+         */
+        template<int ndim, class disc_class, class uLayoutPolicy, class uAccessorPolicy,
+            class resLayoutPolicy, class outLayoutPolicy, class outAccessorPolicy>
+        auto operator()(
+            FESpace<T, IDX, ndim>& fespace,
+            disc_class& disc,
+            fespan<T, uLayoutPolicy, uAccessorPolicy> u,
+            fespan<T, resLayoutPolicy> res,
+            T alpha,
+            T beta,
+            fespan<T, outLayoutPolicy, outAccessorPolicy> out
+        ) -> void {
+            if(!initialized){
+                workspace = CGWorkspace<T, IDX>{fespace, u.nv()};
+                initialized = true;
+            }
+            mass.update(fespace);
+            form_cg_residual(fespace, disc, u, res, workspace);
+            mass.apply_inverse(alpha, res, beta, out);
+        }
+    };
+}
@@ -5,11 +5,14 @@
 /// @author Gianni Absillis (gabsill@ncsu.edu)
 
 #include "Numtool/fixed_size_tensor.hpp"
+#include "iceicle/anomaly_log.hpp"
 #include "iceicle/fe_function/component_span.hpp"
 #include "iceicle/fe_function/fespan.hpp"
 #include "iceicle/fe_function/geo_layouts.hpp"
 #include "iceicle/fe_function/layout_right.hpp"
 #include "iceicle/fespace/fespace.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/krylov_method.hpp"
 #include "iceicle/mpi_type.hpp"
 #include "iceicle/nonlinear_solver_utils.hpp"
 #include "iceicle/petsc_interface.hpp"
@@ -19,6 +22,7 @@
 
 #include <petsc.h>
 
+#include <algorithm>
 #include <iostream>
 #include <petsclog.h>
 #include <petscmat.h>
@@ -39,6 +43,17 @@ namespace iceicle::solvers {
             /// WARNING: must be setup by user
             Vec Jx;
 
+            /// @brief the diagonal regularization (column layout of J)
+            /// computed by gn_update_scaling() once per Jacobian assembly
+            ///
+            /// WARNING: must be setup by user
+            Vec scale;
+
+            /// @brief the vector to use as temporary storage for the regularization times x
+            ///
+            /// WARNING: must be setup by user
+            Vec work;
+
             /// @brief regularization for pde dofs
             PetscScalar lambda_u = 1e-7;
 
@@ -65,12 +80,53 @@ namespace iceicle::solvers {
         };
 
 
+        /// @brief Petsc context for the augmented least squares operator [J; D^{1/2}]
+        /// where D is the diagonal regularization of the Gauss Newton subproblem
+        ///
+        /// Vectors in the row space of the operator are the residual rows followed by the regularization rows
+        struct GNLeastSquaresCtx {
+            /// the Jacobian Matrix
+            Mat J;
+
+            /// @brief the square root of the diagonal regularization (column layout of J)
+            Vec sqrt_scale;
+
+            /// @brief vector without storage to view the residual rows of an augmented vector
+            Vec res_rows;
+
+            /// @brief vector without storage to view the regularization rows of an augmented vector
+            Vec reg_rows;
+
+            /// @brief the vector to use as temporary storage (column layout of J)
+            Vec work;
+        };
+
+        /// @brief compute the diagonal regularization of the subproblem
+        /// using the column norms of J (More 1977 Levenberg-Marquardt Implementation and Theory)
+        ///
+        /// Must be called after each assembly of J or change of the regularization coefficients
+        /// @param ctx the subproblem context
+        /// @param colnorms (optional) the already computed column norms of J
+        inline
+        auto gn_update_scaling(GNSubproblemCtx* ctx, Vec colnorms = nullptr) -> PetscErrorCode {
+            PetscFunctionBeginUser;
+            if(colnorms) PetscCall(VecCopy(colnorms, ctx->scale));
+            else petsc::column_norms(ctx->J, ctx->scale);
+            PetscScalar* scale_data;
+            PetscCall(VecGetArray(ctx->scale, &scale_data));
+            for(PetscInt i = 0; i < ctx->npde; ++i)
+                { scale_data[i] *= ctx->lambda_u; }
+            for(PetscInt i = ctx->npde; i < ctx->npde + ctx->ngeo; ++i )
+                { scale_data[i] = std::max(ctx->lambda_b, ctx->lambda_b * scale_data[i]); }
+            PetscCall(VecRestoreArray(ctx->scale, &scale_data));
+            PetscFunctionReturn(EXIT_SUCCESS);
+        }
+
         inline
         auto gn_subproblem(Mat A, Vec x, Vec y) -> PetscErrorCode {
             GNSubproblemCtx *ctx;
 
             PetscFunctionBeginUser;
-            // Allocate the storage for x1
 
             PetscCall(MatShellGetContext(A, &ctx));
 
@@ -80,36 +136,72 @@ namespace iceicle::solvers {
             // y = J^T*J*x
             PetscCall(MatMultTranspose(ctx->J, ctx->Jx, y));
 
-            Vec lambdax;
-            VecCreate(PETSC_COMM_WORLD, &lambdax);
-            VecSetSizes(lambdax, ctx->npde + ctx->ngeo, PETSC_DETERMINE);
-            VecSetFromOptions(lambdax);
-            PetscScalar* lambdax_data;
-            const PetscScalar* xdata;
-            VecGetArray(lambdax, &lambdax_data);
-            VecGetArrayRead(x, &xdata);
-
-//          // TODO: switch to parallel full size
-            std::vector<PetscScalar> colnorms(ctx->npde + ctx->ngeo);
-            // scaling using column norms (More 1977 Levenberg-Marquardt Implementation and Theory)
-            MatGetColumnNorms(ctx->J, NORM_2, colnorms.data());
-            for(PetscInt i = 0; i < ctx->npde; ++i) {
-                lambdax_data[i] = xdata[i] * ctx->lambda_u * colnorms[i];
-            }
-            for(PetscInt i = ctx->npde; i < ctx->npde + ctx->ngeo; ++i )
-                { lambdax_data[i] = xdata[i] * std::max(ctx->lambda_b, ctx->lambda_b * colnorms[i]); }
-            VecRestoreArray(lambdax, &lambdax_data);
-            VecRestoreArrayRead(x, &xdata);
-
             // y = (J^T*J + lambda * I)*x
-            PetscCall(VecAXPY(y, 1.0, lambdax));
+            PetscCall(VecPointwiseMult(ctx->work, ctx->scale, x));
+            PetscCall(VecAXPY(y, 1.0, ctx->work));
+
+            PetscFunctionReturn(EXIT_SUCCESS);
+        }
+
+        /// @brief y = [J; D^{1/2}] x
+        inline
+        auto gn_least_squares_mult(Mat A, Vec x, Vec y) -> PetscErrorCode {
+            GNLeastSquaresCtx *ctx;
+
+            PetscFunctionBeginUser;
+            PetscCall(MatShellGetContext(A, &ctx));
+
+            PetscInt nres;
+            PetscScalar* ydata;
+            PetscCall(VecGetLocalSize(ctx->res_rows, &nres));
+            PetscCall(VecGetArray(y, &ydata));
+            PetscCall(VecPlaceArray(ctx->res_rows, ydata));
+            PetscCall(VecPlaceArray(ctx->reg_rows, ydata + nres));
+
+            PetscCall(MatMult(ctx->J, x, ctx->res_rows));
+            PetscCall(VecPointwiseMult(ctx->reg_rows, ctx->sqrt_scale, x));
+
+            PetscCall(VecResetArray(ctx->res_rows));
+            PetscCall(VecResetArray(ctx->reg_rows));
+            PetscCall(VecRestoreArray(y, &ydata));
+            PetscFunctionReturn(EXIT_SUCCESS);
+        }
+
+        /// @brief x = [J; D^{1/2}]^T y
+        inline
+        auto gn_least_squares_mult_transpose(Mat A, Vec y, Vec x) -> PetscErrorCode {
+            GNLeastSquaresCtx *ctx;
 
-            VecDestroy(&lambdax);
+            PetscFunctionBeginUser;
+            PetscCall(MatShellGetContext(A, &ctx));
+
+            PetscInt nres;
+            const PetscScalar* ydata;
+            PetscCall(VecGetLocalSize(ctx->res_rows, &nres));
+            PetscCall(VecGetArrayRead(y, &ydata));
+            PetscCall(VecPlaceArray(ctx->res_rows, ydata));
+            PetscCall(VecPlaceArray(ctx->reg_rows, ydata + nres));
+
+            PetscCall(MatMultTranspose(ctx->J, ctx->res_rows, x));
+            PetscCall(VecPointwiseMult(ctx->work, ctx->sqrt_scale, ctx->reg_rows));
+            PetscCall(VecAXPY(x, 1.0, ctx->work));
+
+            PetscCall(VecResetArray(ctx->res_rows));
+            PetscCall(VecResetArray(ctx->reg_rows));
+            PetscCall(VecRestoreArrayRead(y, &ydata));
             PetscFunctionReturn(EXIT_SUCCESS);
         }
     }
     
-    template<class T, class IDX, int ndim, class disc_class, class ls_type = no_linesearch<T, IDX>>
+    /**
+     * @brief Levenberg-Marquardt solver for the MDG problem
+     *
+     * The jacobian can be assembled from a cheaper preconditioner discretization pc_disc 
+     * (i.e a dissipative Riemann solver, frozen artificial viscosity) 
+     * the residuals (right hand side and linesearch) are always formed with disc
+     */
+    template<class T, class IDX, int ndim, class disc_class, class ls_type = no_linesearch<T, IDX>,
+        class pc_disc_class = disc_class>
     class CorriganLM {
         public:
 
@@ -127,6 +219,9 @@ namespace iceicle::solvers {
         /// @brief reference to the discretization to use
         disc_class& disc;
 
+        /// @brief the discretization the jacobian is assembled from (disc unless given)
+        pc_disc_class& pc_disc;
+
         /// @brief the convergence crieria
         ///
         /// determines whether the solver should terminate
@@ -138,6 +233,9 @@ namespace iceicle::solvers {
         /// @brief map of geometry dofs to consider for interface conservation enforcement
         const geo_dof_map<T, IDX, ndim>& geo_map;
 
+        /// @brief persistent storage for the residual evaluations
+        ResidualWorkspace<T, IDX> workspace;
+
         // === Petsc Data Members ===
 
         /// @brief the Jacobian Matrix
@@ -146,9 +244,26 @@ namespace iceicle::solvers {
         /// @brief the matrix for the linear subproblem (JTJ + Regularization)
         Mat subproblem_mat;
 
+        /// @brief the laplacian and element regularization entries of the subproblem matrix
+        /// (added in one pass per iteration, keeps its capacity across iterations)
+        petsc::triplet_buffer regularization_entries{};
+
         /// @brief context for matrix free subproblem implementation
         impl::GNSubproblemCtx subproblem_ctx;
 
+        /// @brief context for the augmented least squares operator
+        impl::GNLeastSquaresCtx lsq_ctx;
+
+        /// @brief the preconditioner matrix for the least squares subproblem
+        /// diagonal of J^T J + D 
+        Mat lsq_pmat;
+
+        /// @brief the augmented right hand side [r; 0] for the least squares subproblem
+        Vec lsq_rhs;
+
+        /// @brief storage for the diagonal of the least squares preconditioner
+        Vec lsq_diag;
+
         /// @brief the residual vector 
         Vec res_data;
 
@@ -214,6 +329,26 @@ namespace iceicle::solvers {
         /// taking advantage of the sparsity structure
         const bool sparse_jacobian_calculation;
 
+        /// @brief set to true to solve the subproblem as the regularized least squares problem
+        ///   min || J p - r ||^2 + || D^{1/2} p ||^2
+        /// with LSQR on the augmented operator [J; D^{1/2}]
+        /// (never forms J^T J, preconditioned with the column scaling diag(J^T J + D))
+        ///
+        /// The explicitly formed subproblem takes precedence
+        const bool least_squares_subproblem;
+
+        /// @brief do not update the cached state of a separate pc_disc (i.e the artificial viscosity) 
+        /// during the solve
+        bool freeze_pc_disc_state = false;
+
+        /// @brief set to true to only recompute the geometry columns of the jacobian 
+        /// around nodes that moved since the last assembly (see mdg_jacobian_cache)
+        bool incremental_mdg_jacobian = false;
+
+        /// @brief the stored geometry columns for incremental_mdg_jacobian
+        /// set move_tolerance and refresh_interval to control the reuse
+        mdg_jacobian_cache<T, IDX, ndim> mdg_cache{};
+
         // === Regularization Parameters ===
         
         /// @brief regularization for pde dofs
@@ -254,13 +389,31 @@ namespace iceicle::solvers {
             const ls_type& linesearch,
             const geo_dof_map<T, IDX, ndim>& geo_map,
             bool explicitly_form_subproblem = false,
-            bool sparse_jacobian_calculation = true
-        ) : fespace{fespace}, cg_fespace(fespace.meshptr), disc{disc}, conv_criteria{conv_criteria}, 
-            linesearch{linesearch}, geo_map{geo_map},
+            bool sparse_jacobian_calculation = true,
+            bool least_squares_subproblem = false
+        ) : CorriganLM(fespace, disc, disc, conv_criteria, linesearch, geo_map, 
+                explicitly_form_subproblem, sparse_jacobian_calculation, least_squares_subproblem) {}
+
+        CorriganLM(
+            FESpace<T, IDX, ndim>& fespace,
+            disc_class& disc, 
+            pc_disc_class& pc_disc, 
+            ConvergenceCriteria<T, IDX>& conv_criteria,
+            const ls_type& linesearch,
+            const geo_dof_map<T, IDX, ndim>& geo_map,
+            bool explicitly_form_subproblem = false,
+            bool sparse_jacobian_calculation = true,
+            bool least_squares_subproblem = false
+        ) : fespace{fespace}, cg_fespace(fespace.meshptr), disc{disc}, pc_disc{pc_disc}, 
+            conv_criteria{conv_criteria}, linesearch{linesearch}, geo_map{geo_map},
+            workspace{fespace, disc_class::dnv_comp},
             explicitly_form_subproblem{explicitly_form_subproblem},
             sparse_jacobian_calculation{sparse_jacobian_calculation},
+            least_squares_subproblem{least_squares_subproblem && !explicitly_form_subproblem},
             lambda_el(fespace.elements.size(), 0)
         {
+            static_assert(pc_disc_class::nv_comp == disc_class::nv_comp,
+                    "the preconditioner discretization must have the same number of equations");
             static constexpr int neq = disc_class::nv_comp;
 
             // define data layouts
@@ -273,8 +426,10 @@ namespace iceicle::solvers {
             PetscInt local_res_size = u_layout.size() + ic_layout.size();
 
 
-            std::cout << std::endl << " System information: " << std::endl;
-            std::cout <<              "---------------------" << std::endl;
+            if(!sparse_jacobian_calculation && mpi::mpi_world_size() > 1) {
+                util::AnomalyLog::log_anomaly(util::Anomaly{
+                    "The dense jacobian calculation only supports a single process", util::general_anomaly_tag{}});
+            }
 
             IDX total_pde_unknowns, total_geo_unknowns, total_pde_residual, total_ic_residual;
             IDX local_pde_unknowns = u_layout.size();
@@ -286,16 +441,20 @@ namespace iceicle::solvers {
             MPI_Allreduce(&local_pde_residual, &total_pde_residual, 1, mpi_get_type<IDX>(), MPI_SUM, PETSC_COMM_WORLD);
             MPI_Allreduce(&local_ic_residual, &total_ic_residual, 1, mpi_get_type<IDX>(), MPI_SUM, PETSC_COMM_WORLD);
 
-            std::cout << "PDE unknowns      : " << total_pde_unknowns << std::endl;
-            std::cout << "Geometry unknowns : " << total_geo_unknowns << std::endl;
-            std::cout << "PDE residual size : " << total_pde_residual << std::endl;
-            std::cout << "ICE residual size : " << total_ic_residual << std::endl;
+            if(mpi::mpi_world_rank() == 0) {
+                std::cout << std::endl << " System information: " << std::endl;
+                std::cout <<              "---------------------" << std::endl;
+                std::cout << "PDE unknowns      : " << total_pde_unknowns << std::endl;
+                std::cout << "Geometry unknowns : " << total_geo_unknowns << std::endl;
+                std::cout << "PDE residual size : " << total_pde_residual << std::endl;
+                std::cout << "ICE residual size : " << total_ic_residual << std::endl;
+            }
 
             // Create and set up the jacobian matrix 
             MatCreate(PETSC_COMM_WORLD, &jac);
             MatSetSizes(jac, local_res_size, local_u_size, PETSC_DETERMINE, PETSC_DETERMINE);
             MatSetFromOptions(jac);
-            MatSetUp(jac);
+            preallocate_petsc_jacobian(fespace, neq, jac, geo_map);
 
             if(explicitly_form_subproblem){
 
@@ -304,6 +463,46 @@ namespace iceicle::solvers {
                 MatProductSetType(subproblem_mat, MATPRODUCT_AtB);
                 MatProductSetFromOptions(subproblem_mat);
 
+            } else if(least_squares_subproblem) {
+
+                // the augmented operator [J; D^{1/2}]
+                MatCreate(PETSC_COMM_WORLD, &subproblem_mat);
+                MatSetSizes(subproblem_mat, local_res_size + local_u_size, local_u_size,
+                        PETSC_DETERMINE, PETSC_DETERMINE);
+                VecCreate(PETSC_COMM_WORLD, &subproblem_ctx.scale);
+                VecSetSizes(subproblem_ctx.scale, local_u_size, PETSC_DETERMINE);
+                VecSetFromOptions(subproblem_ctx.scale);
+                VecDuplicate(subproblem_ctx.scale, &subproblem_ctx.work);
+                VecDuplicate(subproblem_ctx.scale, &lsq_ctx.sqrt_scale);
+                VecDuplicate(subproblem_ctx.scale, &lsq_diag);
+                VecCreateMPIWithArray(PETSC_COMM_WORLD, 1, local_res_size, PETSC_DECIDE, nullptr, &lsq_ctx.res_rows);
+                VecCreateMPIWithArray(PETSC_COMM_WORLD, 1, local_u_size, PETSC_DECIDE, nullptr, &lsq_ctx.reg_rows);
+                VecCreate(PETSC_COMM_WORLD, &lsq_rhs);
+                VecSetSizes(lsq_rhs, local_res_size + local_u_size, PETSC_DETERMINE);
+                VecSetFromOptions(lsq_rhs);
+
+                subproblem_ctx.J = jac;
+                subproblem_ctx.npde = fespace.dg_map.calculate_size_requirement(disc_class::nv_comp);
+                subproblem_ctx.ngeo = geo_map.size();
+                lsq_ctx.J = jac;
+                lsq_ctx.work = subproblem_ctx.work;
+
+                MatSetType(subproblem_mat, MATSHELL);
+                MatSetUp(subproblem_mat);
+                MatShellSetOperation(subproblem_mat, MATOP_MULT, (void (*)()) impl::gn_least_squares_mult);
+                MatShellSetOperation(subproblem_mat, MATOP_MULT_TRANSPOSE,
+                        (void (*)()) impl::gn_least_squares_mult_transpose);
+                MatShellSetContext(subproblem_mat, (void *) &lsq_ctx);
+
+                // diagonal preconditioner matrix for the normal equations
+                MatCreateAIJ(PETSC_COMM_WORLD, local_u_size, local_u_size, PETSC_DETERMINE, PETSC_DETERMINE,
+                        1, nullptr, 0, nullptr, &lsq_pmat);
+                PetscInt prow_start, prow_end;
+                MatGetOwnershipRange(lsq_pmat, &prow_start, &prow_end);
+                for(PetscInt irow = prow_start; irow < prow_end; ++irow)
+                    { MatSetValue(lsq_pmat, irow, irow, 1.0, INSERT_VALUES); }
+                MatAssemblyBegin(lsq_pmat, MAT_FINAL_ASSEMBLY);
+                MatAssemblyEnd(lsq_pmat, MAT_FINAL_ASSEMBLY);
             } else {
                 
                 MatCreate(PETSC_COMM_WORLD, &subproblem_mat);
@@ -312,6 +511,10 @@ namespace iceicle::solvers {
                 VecCreate(PETSC_COMM_WORLD, &Jx);
                 VecSetSizes(Jx, local_res_size, PETSC_DETERMINE);
                 VecSetFromOptions(Jx);
+                VecCreate(PETSC_COMM_WORLD, &subproblem_ctx.scale);
+                VecSetSizes(subproblem_ctx.scale, local_u_size, PETSC_DETERMINE);
+                VecSetFromOptions(subproblem_ctx.scale);
+                VecDuplicate(subproblem_ctx.scale, &subproblem_ctx.work);
 
                 subproblem_ctx.J = jac;
                 subproblem_ctx.Jx = Jx;
@@ -348,6 +551,9 @@ namespace iceicle::solvers {
 
             if(explicitly_form_subproblem){
                 PCSetType(pc, PCILU);
+            } else if(least_squares_subproblem) {
+                KSPSetType(ksp, KSPLSQR);
+                PCSetType(pc, PCJACOBI);
             } else {
                 PCSetType(pc, PCNONE);
             }
@@ -360,11 +566,66 @@ namespace iceicle::solvers {
         // = Member Functions =
         // ====================
 
+        /**
+         * @brief set the Krylov method of the linear solves
+         * the petsc options database is applied again after and takes precedence
+         * @param config the Krylov method configuration
+         */
+        auto set_krylov_method(const KrylovMethod& config) -> void {
+            config.setup(ksp);
+            PetscCallAbort(PETSC_COMM_WORLD, KSPSetFromOptions(ksp));
+        }
+
+        /// @brief the jacobian is assembled from a different discretization than the residual
+        [[nodiscard]] auto separate_pc_disc() const noexcept -> bool {
+            return static_cast<const void*>(&pc_disc) != static_cast<const void*>(&disc);
+        }
+
+        /**
+         * @brief form the residuals of disc into res_data and the jacobian of pc_disc
+         * (the jacobian is not assembled)
+         * @param u the current solution 
+         * @param coord the current geometry parameterization
+         */
+        template<class uLayoutPolicy, class coordLayoutPolicy>
+        auto form_residual_and_jacobian(fespan<T, uLayoutPolicy> u, 
+                component_span<T, coordLayoutPolicy> coord) -> void {
+            static constexpr int neq = disc_class::nv_comp;
+            fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, neq>{}};
+            ic_residual_layout<T, IDX, ndim, neq> ic_layout{geo_map};
+
+            if(sparse_jacobian_calculation) 
+            { // vecspan scope
+                petsc::VecSpan res_view{res_data};
+                fespan res{res_view.data(), u.get_layout()};
+                form_petsc_jacobian_fd(fespace, pc_disc, u, res, jac);
+                dofspan mdg_res{res_view.data() + u_layout.size(), ic_layout};
+                form_petsc_mdg_jacobian_fd(fespace, pc_disc, u, coord, mdg_res, jac,
+                        incremental_mdg_jacobian ? &mdg_cache : nullptr);
+            } // end vecspan scope
+            else 
+            {
+                form_petsc_jacobian_dense_fd(fespace, pc_disc, u, coord, res_data, jac);
+            }
+
+            // the jacobian evaluation leaves the residuals of pc_disc
+            if(separate_pc_disc()) {
+                update_mesh(coord, *(fespace.meshptr));
+                petsc::VecSpan res_view{res_data};
+                fespan res{res_view.data(), u.get_layout()};
+                dofspan mdg_res{res_view.data() + u_layout.size(), ic_layout};
+                form_dg_mdg_residual(fespace, disc, u, res, geo_map, mdg_res, workspace);
+            }
+        }
+
         template<class uLayoutPolicy>
         auto solve(fespan<T, uLayoutPolicy> u) -> IDX {
             T lambda_u_min = lambda_u;
             T lambda_b_min = lambda_b;
 
+            // start from a full assembly of the geometry columns
+            mdg_cache.invalidate();
+
             // update context from current state to make sure everything is synced
             subproblem_ctx.lambda_u = lambda_u;
             subproblem_ctx.lambda_b = lambda_b;
@@ -382,18 +643,8 @@ namespace iceicle::solvers {
             extract_geospan(*(fespace.meshptr), coord);
 
             // get initial residual and jacobian 
-            if(sparse_jacobian_calculation) 
-            { // vecspan scope
-                petsc::VecSpan res_view{res_data};
-                fespan res{res_view.data(), u.get_layout()};
-                form_petsc_jacobian_fd(fespace, disc, u, res, jac);
-                dofspan mdg_res{res_view.data() + u_layout.size(), ic_layout};
-                form_petsc_mdg_jacobian_fd(fespace, disc, u, coord, mdg_res, jac);
-            } // end vecspan scope
-            else 
-            {
-                form_petsc_jacobian_dense_fd(fespace, disc, u, coord, res_data, jac);
-            }
+            if(separate_pc_disc()) update_cached_state(fespace, pc_disc, u);
+            form_residual_and_jacobian(u, coord);
 
             // assemble the Jacobian matrix  (assembly needed for symbolic product)
             MatAssemblyBegin(jac, MAT_FINAL_ASSEMBLY);
@@ -436,10 +687,9 @@ namespace iceicle::solvers {
                     VecCreate(PETSC_COMM_WORLD, &lambda);
                     VecSetSizes(lambda, u_layout.size() + geo_layout.size(), PETSC_DETERMINE);
                     VecSetFromOptions(lambda);
+                    petsc::column_norms(jac, lambda);
                     { // lambda read scope
                         petsc::VecSpan lambda_view{lambda};
-                        PetscCallAbort(PETSC_COMM_WORLD,
-                                MatGetColumnNorms(jac, NORM_2, lambda_view.data()));
 
                         // diagonal regularization
                         for(PetscInt i = 0; i < u_layout.size(); ++i)
@@ -498,7 +748,7 @@ namespace iceicle::solvers {
                                             PetscScalar value = KTK[ilnode, jlnode] * (
                                                 lambda_lag * rnorm );
 
-                                            MatSetValueLocal(subproblem_mat, imat, jmat, value, ADD_VALUES);
+                                            regularization_entries.add(imat, jmat, value);
                                         }
                                     }
                                 }
@@ -520,8 +770,7 @@ namespace iceicle::solvers {
                                                 PetscInt imat = u_layout.size() + geo_layout[igeo, iv];
                                                 PetscInt jmat = u_layout.size() + geo_layout[igeo, jv];
 
-                                                MatSetValueLocal(subproblem_mat, imat, jmat,
-                                                        lambda_el[iel], ADD_VALUES);
+                                                regularization_entries.add(imat, jmat, lambda_el[iel]);
                                             }
                                         }
                                     }
@@ -529,16 +778,49 @@ namespace iceicle::solvers {
                             }
                         }
                     }
+                    regularization_entries.flush(subproblem_mat, true);
+
+                } else if(least_squares_subproblem) {
+                    subproblem_ctx.lambda_u = lambda_u;
+                    subproblem_ctx.lambda_b = lambda_b;
+
+                    // regularization from the column norms: D
+                    petsc::column_norms(jac, lsq_diag);
+                    PetscCallAbort(PETSC_COMM_WORLD, impl::gn_update_scaling(&subproblem_ctx, lsq_diag));
+                    PetscCallAbort(PETSC_COMM_WORLD, VecCopy(subproblem_ctx.scale, lsq_ctx.sqrt_scale));
+                    PetscCallAbort(PETSC_COMM_WORLD, VecSqrtAbs(lsq_ctx.sqrt_scale));
 
+                    // column scaling preconditioner: diag(J^T J + D)_i = ||J_i||^2 + D_i
+                    PetscCallAbort(PETSC_COMM_WORLD, VecPointwiseMult(lsq_diag, lsq_diag, lsq_diag));
+                    PetscCallAbort(PETSC_COMM_WORLD, VecAXPY(lsq_diag, 1.0, subproblem_ctx.scale));
+                    PetscCallAbort(PETSC_COMM_WORLD, MatDiagonalSet(lsq_pmat, lsq_diag, INSERT_VALUES));
+
+                    // right hand side [r; 0]
+                    petsc::VecSpan rhs_view{lsq_rhs};
+                    petsc::VecSpan res_view{res_data};
+                    std::copy(res_view.begin(), res_view.end(), rhs_view.begin());
+                    std::fill(rhs_view.begin() + res_view.size(), rhs_view.end(), 0.0);
                 } else {
                     // matrix product is implicitly defined in the operator
+                    // the regularization is computed once for the current jacobian
+                    subproblem_ctx.lambda_u = lambda_u;
+                    subproblem_ctx.lambda_b = lambda_b;
+                    PetscCallAbort(PETSC_COMM_WORLD, impl::gn_update_scaling(&subproblem_ctx));
                 }
                 PetscCallAbort(PETSC_COMM_WORLD, MatAssemblyBegin(subproblem_mat, MAT_FINAL_ASSEMBLY));
                 PetscCallAbort(PETSC_COMM_WORLD, MatAssemblyEnd(subproblem_mat, MAT_FINAL_ASSEMBLY));
 
                 // Solve the subproblem
-                PetscCallAbort(PETSC_COMM_WORLD, KSPSetOperators(ksp, subproblem_mat, subproblem_mat));
-                PetscCallAbort(PETSC_COMM_WORLD, KSPSolve(ksp, Jtr, du_data));
+                if(least_squares_subproblem){
+                    // min || J du - r ||^2 + || D^{1/2} du ||^2
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSetOperators(ksp, subproblem_mat, lsq_pmat));
+                    ICEICLE_PROFILE_REGION("ksp_solve");
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSolve(ksp, lsq_rhs, du_data));
+                } else {
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSetOperators(ksp, subproblem_mat, subproblem_mat));
+                    ICEICLE_PROFILE_REGION("ksp_solve");
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSolve(ksp, Jtr, du_data));
+                }
 
                 if(verbosity >= 4){
                     PetscViewer viewer;
@@ -565,14 +847,9 @@ namespace iceicle::solvers {
                 } else {
                     // its linesearchin time!
                    
-                    T local_rnorm_old = 0;
-                    {
-                        petsc::VecSpan res_view{res_data};
-                        for(IDX i = 0; i < u_layout.size() + ic_layout.size(); ++i){
-                            local_rnorm_old += SQUARED(res_view.data()[i]);
-                        }
-                    }
-                    local_rnorm_old = sqrt(local_rnorm_old);
+                    // norm over all processes so every process takes the same step
+                    PetscReal rnorm_old;
+                    PetscCallAbort(PETSC_COMM_WORLD, VecNorm(res_data, NORM_2, &rnorm_old));
                     T rnorm_step;
 
                     std::vector<T> coord_step_data(coord_data);
@@ -612,9 +889,11 @@ namespace iceicle::solvers {
                         update_mesh(coord_step, *(fespace.meshptr));
 
                         // === Get the residuals ===
-                        form_residual(fespace, disc, u_step, res_work);
-                        form_mdg_residual(fespace, disc, u_step, geo_map, mdg_res);
-                        T rnorm = res_work.vector_norm() + mdg_res.vector_norm();
+                        form_dg_mdg_residual(fespace, disc, u_step, res_work, geo_map, mdg_res, workspace);
+                        T res_norm = res_work.vector_norm(), mdg_norm = mdg_res.vector_norm();
+                        T rnorm_sq[2] = {res_norm * res_norm, mdg_norm * mdg_norm};
+                        MPI_Allreduce(MPI_IN_PLACE, rnorm_sq, 2, mpi_get_type<T>(), MPI_SUM, PETSC_COMM_WORLD);
+                        T rnorm = std::sqrt(rnorm_sq[0]) + std::sqrt(rnorm_sq[1]);
                         rnorm_step = rnorm; // extract it
 
                         // Add any penalties
@@ -642,8 +921,13 @@ namespace iceicle::solvers {
                         }
                     }
 
+                    // an inverted element on any process rejects the step on all of them
+                    int local_inversion = reset_for_element_inversion, any_inversion;
+                    MPI_Allreduce(&local_inversion, &any_inversion, 1, MPI_INT, MPI_MAX, PETSC_COMM_WORLD);
+                    reset_for_element_inversion = any_inversion;
+
                     // safegaurd and use the fact that comparing with infinity returns false
-                    if(!reset_for_element_inversion && rnorm_step < 10 * local_rnorm_old ){
+                    if(!reset_for_element_inversion && rnorm_step < 10 * rnorm_old ){
                         // Perform the linesearch update
                         petsc::VecSpan du_view{du_data};
                         fespan du{du_view.data(), u.get_layout()};
@@ -679,23 +963,13 @@ namespace iceicle::solvers {
                     MatZeroEntries(subproblem_mat); 
 
                 // get updated residual and jacobian 
-                if(sparse_jacobian_calculation) 
-                {
-                    // NOTE: regular form_petsc_jacobian_fd does not update mesh 
-                    // the mdg counterpart does
-                    // TODO: consider removing all update mesh calls from form_x functions 
-                    // and require manual 
-                    update_mesh(coord, *(fespace.meshptr));
-                    petsc::VecSpan res_view{res_data};
-                    fespan res{res_view.data(), u.get_layout()};
-                    form_petsc_jacobian_fd(fespace, disc, u, res, jac);
-                    dofspan mdg_res{res_view.data() + u_layout.size(), ic_layout};
-                    form_petsc_mdg_jacobian_fd(fespace, disc, u, coord, mdg_res, jac);
-                }
-                else
-                {
-                    form_petsc_jacobian_dense_fd(fespace, disc, u, coord, res_data, jac);
-                }
+                // NOTE: regular form_petsc_jacobian_fd does not update mesh 
+                // the mdg counterpart does
+                // TODO: consider removing all update mesh calls from form_x functions 
+                // and require manual 
+                if(sparse_jacobian_calculation) update_mesh(coord, *(fespace.meshptr));
+                if(separate_pc_disc() && !freeze_pc_disc_state) update_cached_state(fespace, pc_disc, u);
+                form_residual_and_jacobian(u, coord);
 
                 // assemble the Jacobian matrix 
                 MatAssemblyBegin(jac, MAT_FINAL_ASSEMBLY);
@@ -0,0 +1,1639 @@
+/**
+ * @brief explicit residual evaluation of ConservationLawDDG on the offload device
+ *
+ * see doc/design/device_residual.md
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "Numtool/fixed_size_tensor.hpp"
+#include "Numtool/point.hpp"
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/device_array.hpp"
+#include "iceicle/disc/burgers.hpp"
+#include "iceicle/disc/conservation_law.hpp"
+#include "iceicle/disc/navier_stokes.hpp"
+#include "iceicle/element/ddg_trace_factors.hpp"
+#include "iceicle/element/finite_element.hpp"
+#include "iceicle/fe_function/device_fespan.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/geometry/face.hpp"
+#include "iceicle/halo_exchange.hpp"
+#include "iceicle/profiler.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#ifdef ICEICLE_USE_MPI
+#include <mpi.h>
+#endif
+
+namespace iceicle::solvers {
+
+    // ===========================
+    // = Device Physics Kernels  =
+    // ===========================
+
+    /**
+     * @brief the Burgers fluxes (BurgersFlux, BurgersUpwind, and BurgersDiffusionFlux) for the device kernels
+     *
+     * The host fluxes hold a reference to the BurgersCoefficients so this holds a copy of the coefficients
+     * and works on flat arrays: states [neq], gradients [neq x ndim], and fluxes [neq x ndim] (row major)
+     *
+     * @tparam T the floating point type
+     * @tparam ndim the number of dimensions
+     */
+    template<class T, int ndim>
+    struct BurgersDeviceFlux {
+        /// @brief the number of vector components
+        static constexpr std::size_t nv_comp = 1;
+
+        /// @brief BurgersDiffusionFlux provides the homogeneity tensor for the interface correction
+        static constexpr bool has_homogeneity_tensor = true;
+
+        /// @brief the diffusion coefficient
+        T mu;
+
+        /// @brief the linear advection coefficient
+        T a[ndim];
+
+        /// @brief the nonlinear advection coefficient
+        T b[ndim];
+
+        /// @brief copy the coefficients
+        static constexpr auto from_coefficients(const BurgersCoefficients<T, ndim>& coeffs) noexcept
+        -> BurgersDeviceFlux {
+            BurgersDeviceFlux flux{coeffs.mu, {}, {}};
+            for(int idim = 0; idim < ndim; ++idim){
+                flux.a[idim] = coeffs.a[idim];
+                flux.b[idim] = coeffs.b[idim];
+            }
+            return flux;
+        }
+
+        /// @brief the physical flux F = au + 0.5*buu - mu * gradu (see BurgersFlux)
+        constexpr auto flux(const T* u, const T* gradu, T* f) const noexcept -> void {
+            for(int idim = 0; idim < ndim; ++idim){
+                T lambda = a[idim] + 0.5 * b[idim] * u[0];
+                f[idim] = lambda * u[0] - mu * gradu[idim];
+            }
+        }
+
+        /// @brief the maximum wavespeed at a state (see BurgersFlux::wavespeed)
+        constexpr auto wavespeed(const T* u) const noexcept -> T {
+            T lambda_norm = 0;
+            for(int idim = 0; idim < ndim; ++idim){
+                T lambda = a[idim] + 0.5 * b[idim] * u[0];
+                lambda_norm += lambda * lambda;
+            }
+            return std::sqrt(lambda_norm);
+        }
+
+        /// @brief the timestep from cfl for a wavespeed (see BurgersFlux::dt_from_cfl)
+        constexpr auto dt_from_cfl(T cfl, T reference_length, T lambda) const noexcept -> T
+        { return (reference_length * cfl) / (mu / reference_length + lambda); }
+
+        /// @brief the upwind convective normal flux (see BurgersUpwind)
+        constexpr auto conv_nflux(const T* uL, const T* uR, const T* unit_normal, T* fadvn) const noexcept -> void {
+            T u_avg = 0.5 * (uL[0] + uR[0]);
+            T P = 0;
+            for(int idim = 0; idim < ndim; ++idim)
+                { P += unit_normal[idim] * (a[idim] + 0.5 * b[idim] * u_avg); }
+            T u_upwind = (P > 0) ? uL[0] : uR[0];
+            T f = 0;
+            for(int idim = 0; idim < ndim; ++idim)
+                { f += unit_normal[idim] * (a[idim] + 0.5 * b[idim] * u_upwind); }
+            fadvn[0] = f * u_upwind;
+        }
+
+        /// @brief the diffusive normal flux (see BurgersDiffusionFlux)
+        constexpr auto diff_nflux(const T* u, const T* gradu, const T* unit_normal, T* fviscn) const noexcept -> void {
+            T fvisc = 0;
+            for(int idim = 0; idim < ndim; ++idim) fvisc += mu * gradu[idim] * unit_normal[idim];
+            fviscn[0] = fvisc;
+        }
+
+        /// @brief the diffusive normal flux for a prescribed normal gradient (see BurgersDiffusionFlux::neumann_flux)
+        constexpr auto neumann_flux(const T* gradn, T* fviscn) const noexcept -> void
+        { fviscn[0] = mu * gradn[0]; }
+
+        /// @brief the homogeneity tensor [neq x ndim x neq x ndim] (the identity times the viscosity)
+        constexpr auto homogeneity_tensor(const T* u, T* G) const noexcept -> void {
+            for(int kdim = 0; kdim < ndim; ++kdim){
+                for(int sdim = 0; sdim < ndim; ++sdim) G[kdim * ndim + sdim] = (kdim == sdim) ? mu : 0.0;
+            }
+        }
+
+        /// @brief BurgersFlux has no apply_bc so the other boundary conditions do not contribute
+        static constexpr auto implements_bc(BOUNDARY_CONDITIONS) noexcept -> bool { return false; }
+    };
+
+    /**
+     * @brief the Navier-Stokes fluxes (navier_stokes::Flux, VanLeer, and DiffusionFlux)
+     * in conservative variables with a calorically perfect gas for the device kernels
+     *
+     * The viscosity law of the host Physics is a std::function so the supported laws
+     * (constant_viscosity, Sutherlands, and DimensionlessSutherlands) are recovered from it
+     * as coefficients of mu_c * theta^1.5 * (T_0 + T_s) / (T + T_s) with theta = T / T_0
+     * (or mu_c for a constant viscosity).
+     *
+     * The boundary conditions of Flux::apply_bc take the wall temperature (NO_SLIP_ISOTHERMAL)
+     * and the free stream state (RIEMANN) from the tabulated boundary values (see device_physics::bc_values)
+     *
+     * @tparam T the floating point type
+     * @tparam ndim the number of dimensions
+     */
+    template<class T, int ndim>
+    struct NavierStokesDeviceFlux {
+        /// @brief the number of vector components
+        static constexpr std::size_t nv_comp = ndim + 2;
+
+        /// @brief navier_stokes::DiffusionFlux has no homogeneity tensor (no interface correction)
+        static constexpr bool has_homogeneity_tensor = false;
+
+        static constexpr T MIN_DENSITY = navier_stokes::CaloricallyPerfectEoS<T, ndim>::MIN_DENSITY;
+        static constexpr T MIN_PRESSURE = navier_stokes::CaloricallyPerfectEoS<T, ndim>::MIN_PRESSURE;
+
+        /// @brief the ratio of specific heats
+        T gamma;
+
+        /// @brief the temperature coefficient cp * T_ref * rho_ref / p_ref
+        T T_coeff;
+
+        /// @brief the Prandtl number
+        T Pr;
+
+        /// @brief the nondimensionalization
+        T Re, Eu, e_coeff;
+
+        /// @brief the viscosity law coefficients
+        T mu_c, T_0, T_s;
+
+        /// @brief if the viscosity follows Sutherlands law (otherwise mu_c)
+        bool sutherland;
+
+        /// @brief if the physical flux (Flux full_ns) and the diffusive flux (DiffusionFlux full_ns) are viscous
+        bool viscous, viscous_nflux;
+
+        /// @brief the maximum viscosity seen by the host physical flux for the viscous timestep limit
+        T visc_max;
+
+        /// @brief the thermodynamic state
+        struct state_type {
+            T rho;
+            T velocity[ndim];
+            T vv;
+            T rhoE;
+            T E;
+            T p;
+            T temp;
+            T csound;
+        };
+
+        /**
+         * @brief copy the parameters of the physics
+         * @param physics the host physics
+         * @param viscous the full_ns parameter of the physical flux
+         * @param viscous_nflux the full_ns parameter of the diffusive flux
+         * @param visc_max the maximum viscosity of the host physical flux
+         */
+        static auto from_physics(
+            const navier_stokes::Physics<T, ndim, navier_stokes::CaloricallyPerfectEoS<T, ndim>>& physics,
+            bool viscous, bool viscous_nflux, T visc_max
+        ) -> NavierStokesDeviceFlux {
+            NavierStokesDeviceFlux flux{};
+            flux.gamma = physics.eos.gamma;
+            T cp = physics.eos.gamma / (physics.eos.gamma - 1) * physics.eos.Rgas;
+            flux.T_coeff = cp * physics.ref.T * physics.ref.rho / physics.ref.p;
+            flux.Pr = physics.Pr;
+            flux.Re = physics.nondim.Re;
+            flux.Eu = physics.nondim.Eu;
+            flux.e_coeff = physics.nondim.e_coeff;
+            flux.viscous = viscous;
+            flux.viscous_nflux = viscous_nflux;
+            flux.visc_max = visc_max;
+            if(auto law = physics.viscosity.template target<navier_stokes::constant_viscosity<T>>()){
+                flux.sutherland = false;
+                flux.mu_c = law->mu;
+            } else if(auto law = physics.viscosity.template target<navier_stokes::Sutherlands<T>>()){
+                flux.sutherland = true;
+                flux.mu_c = law->mu_0;
+                flux.T_0 = law->T_0;
+                flux.T_s = law->T_s;
+            } else if(auto law = physics.viscosity.template target<navier_stokes::DimensionlessSutherlands<T>>()){
+                flux.sutherland = true;
+                flux.mu_c = law->mu_ratio;
+                flux.T_0 = law->T_0_ratio;
+                flux.T_s = law->T_s_ratio;
+            } else {
+                util::AnomalyLog::log_anomaly(util::Anomaly{
+                    "The device Navier-Stokes flux only supports constant_viscosity, Sutherlands, "
+                    "and DimensionlessSutherlands: using the viscosity at unit temperature",
+                    util::general_anomaly_tag{}});
+                flux.sutherland = false;
+                flux.mu_c = physics.viscosity(1.0);
+            }
+            return flux;
+        }
+
+        /// @brief the viscosity at a temperature
+        constexpr auto viscosity_law(T temp) const noexcept -> T {
+            if(!sutherland) return mu_c;
+            // (T / T_0)^1.5 without the call to pow
+            T theta = temp / T_0;
+            return mu_c * theta * std::sqrt(theta) * (T_0 + T_s) / (temp + T_s);
+        }
+
+        /// @brief the thermodynamic state of conservative variables (see CaloricallyPerfectEoS::calc_thermo_state)
+        constexpr auto thermo_state(const T* u) const noexcept -> state_type {
+            state_type state;
+            state.rho = std::max(MIN_DENSITY, u[0]);
+            state.vv = 0;
+            for(int idim = 0; idim < ndim; ++idim){
+                state.velocity[idim] = u[1 + idim] / state.rho;
+                state.vv += state.velocity[idim] * state.velocity[idim];
+            }
+            state.rhoE = u[ndim + 1];
+            state.E = state.rhoE / state.rho;
+            T e = state.E - 0.5 * e_coeff * state.vv;
+            state.p = std::max(MIN_PRESSURE, (gamma - 1) / (e_coeff * Eu) * state.rho * e);
+            state.temp = state.p / state.rho * gamma / (gamma - 1) / T_coeff;
+            state.csound = std::sqrt((gamma * Eu * state.p) / state.rho);
+            return state;
+        }
+
+        /// @brief the pressure from the density and temperature (see VARSET::RHO_U_T)
+        constexpr auto pressure_from_temperature(T rho, T temp) const noexcept -> T
+        { return std::max(MIN_PRESSURE, std::max(MIN_DENSITY, rho) * (gamma - 1) / gamma * T_coeff * temp); }
+
+        /// @brief the conservative variables from the density, velocity, and pressure (see VARSET::RHO_U_P)
+        constexpr auto conservative_from_rho_u_p(T rho_in, const T* velocity, T p_in, T* u) const noexcept -> void {
+            T rho = std::max(MIN_DENSITY, rho_in);
+            T p = std::max(MIN_PRESSURE, p_in);
+            T vv = 0;
+            for(int idim = 0; idim < ndim; ++idim) vv += velocity[idim] * velocity[idim];
+            T e = p * e_coeff * Eu / (gamma - 1) / rho;
+            T E = e + 0.5 * e_coeff * vv;
+            u[0] = rho;
+            for(int idim = 0; idim < ndim; ++idim) u[1 + idim] = velocity[idim] * rho;
+            u[ndim + 1] = rho * E;
+        }
+
+        /**
+         * @brief the velocity gradient [ndim x ndim] and total energy gradient [ndim] from the conservative gradients
+         * (see CaloricallyPerfectEoS::calc_state_gradients)
+         */
+        constexpr auto state_gradients(const state_type& state, const T* gradu, T* grad_vel, T* grad_E) const noexcept -> void {
+            for(int idim = 0; idim < ndim; ++idim){
+                for(int jdim = 0; jdim < ndim; ++jdim){
+                    grad_vel[idim * ndim + jdim] = gradu[(1 + idim) * ndim + jdim] / state.rho
+                        - state.velocity[idim] / state.rho * gradu[jdim];
+                }
+            }
+            for(int jdim = 0; jdim < ndim; ++jdim)
+                grad_E[jdim] = (gradu[(ndim + 1) * ndim + jdim] - state.E * gradu[jdim]) / state.rho;
+        }
+
+        /// @brief the viscous stress tensor [ndim x ndim] (see Physics::calc_shear_stress)
+        static constexpr auto shear_stress(const T* grad_vel, T mu, T* tau) noexcept -> void {
+            T dukduk = 0;
+            for(int k = 0; k < ndim; ++k) dukduk += grad_vel[k * ndim + k];
+            for(int idim = 0; idim < ndim; ++idim){
+                for(int jdim = 0; jdim < ndim; ++jdim)
+                    tau[idim * ndim + jdim] = mu * (grad_vel[idim * ndim + jdim] + grad_vel[jdim * ndim + idim]);
+                tau[idim * ndim + idim] -= 2.0 / 3.0 * mu * dukduk;
+            }
+        }
+
+        /// @brief the physical flux (see navier_stokes::Flux::operator())
+        constexpr auto flux(const T* u, const T* gradu, T* f) const noexcept -> void {
+            state_type state = thermo_state(u);
+            for(int jdim = 0; jdim < ndim; ++jdim){
+                f[jdim] = u[1 + jdim];
+                for(int idim = 0; idim < ndim; ++idim)
+                    f[(1 + idim) * ndim + jdim] = u[1 + idim] * state.velocity[jdim];
+                f[(1 + jdim) * ndim + jdim] += Eu * state.p;
+                f[(ndim + 1) * ndim + jdim] = state.velocity[jdim] * (state.rhoE + Eu * e_coeff * state.p);
+            }
+            if(viscous){
+                T mu = viscosity_law(state.temp);
+                T grad_vel[ndim * ndim], grad_E[ndim], tau[ndim * ndim];
+                state_gradients(state, gradu, grad_vel, grad_E);
+                shear_stress(grad_vel, mu, tau);
+                for(int jdim = 0; jdim < ndim; ++jdim){
+                    // heat flux (see Physics::calc_heat_flux)
+                    T q = grad_E[jdim] / e_coeff;
+                    for(int kdim = 0; kdim < ndim; ++kdim) q -= state.velocity[kdim] * grad_vel[kdim * ndim + jdim];
+                    q *= mu * gamma / Pr;
+
+                    T energy_flux = q;
+                    for(int idim = 0; idim < ndim; ++idim){
+                        f[(1 + idim) * ndim + jdim] -= tau[idim * ndim + jdim] / Re;
+                        energy_flux += state.velocity[idim] * tau[idim * ndim + jdim];
+                    }
+                    energy_flux *= e_coeff / Re;
+                    f[(ndim + 1) * ndim + jdim] -= energy_flux;
+                }
+            }
+        }
+
+        /// @brief the maximum wavespeed |v| + c at a state (see navier_stokes::Flux::wavespeed)
+        constexpr auto wavespeed(const T* u) const noexcept -> T {
+            state_type state = thermo_state(u);
+            return state.csound + std::sqrt(state.vv);
+        }
+
+        /// @brief the viscosity at a state (zero if the physical flux is inviscid) for the viscous timestep limit
+        constexpr auto viscosity(const T* u) const noexcept -> T
+        { return (viscous) ? viscosity_law(thermo_state(u).temp) : 0.0; }
+
+        /// @brief the timestep from cfl for a wavespeed (see navier_stokes::Flux::dt_from_cfl)
+        constexpr auto dt_from_cfl(T cfl, T reference_length, T lambda) const noexcept -> T {
+            T dt = (reference_length * cfl) / lambda;
+            if(viscous && visc_max > 0)
+                dt = std::min(dt, reference_length * reference_length * cfl / visc_max);
+            return dt;
+        }
+
+        /// @brief the Van Leer flux normal to the interface (see navier_stokes::VanLeer)
+        constexpr auto conv_nflux(const T* uL, const T* uR, const T* unit_normal, T* fadvn) const noexcept -> void {
+            state_type stateL = thermo_state(uL);
+            state_type stateR = thermo_state(uR);
+            T vnormalL = 0, vnormalR = 0;
+            for(int idim = 0; idim < ndim; ++idim){
+                vnormalL += stateL.velocity[idim] * unit_normal[idim];
+                vnormalR += stateR.velocity[idim] * unit_normal[idim];
+            }
+            T machL = vnormalL / stateL.csound;
+            T machR = vnormalR / stateR.csound;
+
+            // positive fluxes
+            if(machL > 1){
+                fadvn[0] = stateL.rho * vnormalL;
+                for(int idim = 0; idim < ndim; ++idim)
+                    fadvn[1 + idim] = uL[1 + idim] * vnormalL + Eu * stateL.p * unit_normal[idim];
+                fadvn[ndim + 1] = vnormalL * (stateL.rhoE + Eu * e_coeff * stateL.p);
+            } else if(machL < -1){
+                for(std::size_t ieq = 0; ieq < nv_comp; ++ieq) fadvn[ieq] = 0;
+            } else {
+                T fmL = stateL.rho * stateL.csound * (machL + 1) * (machL + 1) / 4.0;
+                fadvn[0] = fmL;
+                for(int idim = 0; idim < ndim; ++idim){
+                    fadvn[1 + idim] = fmL * (stateL.velocity[idim]
+                        + unit_normal[idim] * (-vnormalL + 2 * stateL.csound) / gamma);
+                }
+                T c = (gamma - 1) * vnormalL + 2 * stateL.csound;
+                fadvn[ndim + 1] = fmL * ((stateL.vv - vnormalL * vnormalL) / 2 + c * c / (2 * (gamma * gamma - 1)));
+            }
+
+            // negative fluxes
+            if(machR < -1){
+                fadvn[0] += stateR.rho * vnormalR;
+                for(int idim = 0; idim < ndim; ++idim)
+                    fadvn[1 + idim] += uR[1 + idim] * vnormalR + Eu * stateR.p * unit_normal[idim];
+                fadvn[ndim + 1] += vnormalR * (stateR.rhoE + Eu * e_coeff * stateR.p);
+            } else if(machR <= 1){
+                T fmR = -stateR.rho * stateR.csound * (machR - 1) * (machR - 1) / 4.0;
+                fadvn[0] += fmR;
+                for(int idim = 0; idim < ndim; ++idim){
+                    fadvn[1 + idim] += fmR * (stateR.velocity[idim]
+                        + unit_normal[idim] * (-vnormalR - 2 * stateR.csound) / gamma);
+                }
+                T c = (gamma - 1) * vnormalR - 2 * stateR.csound;
+                fadvn[ndim + 1] += fmR * ((stateR.vv - vnormalR * vnormalR) / 2 + c * c / (2 * (gamma * gamma - 1)));
+            }
+        }
+
+        /// @brief the diffusive normal flux (see navier_stokes::DiffusionFlux)
+        constexpr auto diff_nflux(const T* u, const T* gradu, const T* unit_normal, T* fviscn) const noexcept -> void {
+            for(std::size_t ieq = 0; ieq < nv_comp; ++ieq) fviscn[ieq] = 0;
+            if(!viscous_nflux) return;
+            state_type state = thermo_state(u);
+            T mu = viscosity_law(state.temp);
+            T grad_vel[ndim * ndim], grad_E[ndim], tau[ndim * ndim];
+            state_gradients(state, gradu, grad_vel, grad_E);
+            shear_stress(grad_vel, mu, tau);
+            for(int jdim = 0; jdim < ndim; ++jdim){
+                T energy_flux = mu * gamma / Pr * grad_E[jdim] * unit_normal[jdim];
+                for(int idim = 0; idim < ndim; ++idim){
+                    fviscn[1 + idim] += tau[idim * ndim + jdim] / Re * unit_normal[jdim];
+                    energy_flux += state.velocity[idim] * tau[idim * ndim + jdim] * unit_normal[jdim];
+                }
+                energy_flux *= e_coeff / Re;
+                fviscn[ndim + 1] += energy_flux;
+            }
+        }
+
+        /// @brief the diffusive normal flux for a prescribed normal gradient (zero, see DiffusionFlux::neumann_flux)
+        constexpr auto neumann_flux(const T*, T* fviscn) const noexcept -> void
+        { for(std::size_t ieq = 0; ieq < nv_comp; ++ieq) fviscn[ieq] = 0; }
+
+        /// @brief the boundary conditions of navier_stokes::Flux::apply_bc
+        static constexpr auto implements_bc(BOUNDARY_CONDITIONS bctype) noexcept -> bool {
+            return bctype == BOUNDARY_CONDITIONS::SLIP_WALL || bctype == BOUNDARY_CONDITIONS::WALL_GENERAL
+                || bctype == BOUNDARY_CONDITIONS::NO_SLIP_ISOTHERMAL || bctype == BOUNDARY_CONDITIONS::RIEMANN;
+        }
+
+        /**
+         * @brief the exterior state for a boundary condition (see navier_stokes::Flux::apply_bc)
+         * @param bctype the boundary condition (implements_bc(bctype) must be true)
+         * @param uL the interior state
+         * @param graduL the interior gradients
+         * @param unit_normal the unit normal
+         * @param bcvals the tabulated boundary values: the wall temperature in the energy component
+         * for NO_SLIP_ISOTHERMAL and the free stream state (density, velocity, temperature) for RIEMANN
+         * @param [out] uR the exterior state
+         * @param [out] graduR the exterior gradients (equal to the interior gradients)
+         */
+        constexpr auto apply_bc(BOUNDARY_CONDITIONS bctype, const T* uL, const T* graduL, const T* unit_normal,
+                const T* bcvals, T* uR, T* graduR) const noexcept -> void {
+            for(std::size_t k = 0; k < nv_comp * ndim; ++k) graduR[k] = graduL[k];
+            if(bctype == BOUNDARY_CONDITIONS::WALL_GENERAL){
+                bctype = (viscous) ? BOUNDARY_CONDITIONS::NO_SLIP_ISOTHERMAL : BOUNDARY_CONDITIONS::SLIP_WALL;
+            }
+            if(bctype == BOUNDARY_CONDITIONS::SLIP_WALL){
+                // density and energy are the same, flip the momentum over the normal
+                uR[0] = uL[0];
+                uR[ndim + 1] = uL[ndim + 1];
+                T mom_n = 0;
+                for(int idim = 0; idim < ndim; ++idim) mom_n += uL[1 + idim] * unit_normal[idim];
+                for(int idim = 0; idim < ndim; ++idim) uR[1 + idim] = uL[1 + idim] - 2 * mom_n * unit_normal[idim];
+            } else if(bctype == BOUNDARY_CONDITIONS::NO_SLIP_ISOTHERMAL){
+                // same density, zero velocity, and the wall temperature
+                T rho = thermo_state(uL).rho;
+                T zero[ndim]{};
+                conservative_from_rho_u_p(rho, zero, pressure_from_temperature(rho, bcvals[ndim + 1]), uR);
+            } else {
+                // RIEMANN: Carlson "Inflow/Outflow Boundary Conditions with Application to FUN3D"
+                state_type stateL = thermo_state(uL);
+                T rho_fs = std::max(MIN_DENSITY, bcvals[0]);
+                T p_fs = pressure_from_temperature(rho_fs, bcvals[ndim + 1]);
+                T csound_fs = std::sqrt((gamma * Eu * p_fs) / rho_fs);
+                T normal_uadv_i = 0, normal_uadv_o = 0;
+                for(int idim = 0; idim < ndim; ++idim){
+                    normal_uadv_i += stateL.velocity[idim] * unit_normal[idim];
+                    normal_uadv_o += bcvals[1 + idim] * unit_normal[idim];
+                }
+                T normal_mach = normal_uadv_i / stateL.csound;
+                T Rplus = normal_uadv_i + 2 * stateL.csound / (gamma - 1);
+                T Rminus = normal_uadv_o - 2 * csound_fs / (gamma - 1);
+                // the supersonic outflow branch of the host does not change Rminus
+                if(normal_mach < 0) Rplus = normal_uadv_o + 2 * csound_fs / (gamma - 1);
+
+                T Ub = 0.5 * (Rplus + Rminus);
+                T cb = 0.25 * (gamma - 1) * (Rplus - Rminus);
+                T uadvB[ndim];
+                for(int idim = 0; idim < ndim; ++idim)
+                    uadvB[idim] = stateL.velocity[idim] + (Ub - normal_uadv_i) * unit_normal[idim];
+                T sb = stateL.csound * stateL.csound / (gamma * std::pow(stateL.rho, gamma - 1));
+                T rhoR = std::pow(cb * cb / (gamma * sb), 1.0 / (gamma - 1));
+                T pR = rhoR * cb * cb / gamma;
+                conservative_from_rho_u_p(rhoR, uadvB, pR, uR);
+            }
+        }
+    };
+
+    /**
+     * @brief the device fluxes of a discretization
+     * specializations provide the type of the device fluxes, make(disc) to copy the parameters,
+     * and bc_values(disc, bctype, bcflag, out) for the values the device apply_bc needs
+     * (the primary template is for discretizations without a device implementation)
+     */
+    template<class disc_class>
+    struct device_physics {};
+
+    /// @brief Burgers equation with the ConservationLawDDG discretization
+    template<class T, int ndim, class ST_Info>
+    struct device_physics<ConservationLawDDG<T, ndim, BurgersFlux<T, ndim>,
+        BurgersUpwind<T, ndim>, BurgersDiffusionFlux<T, ndim>, ST_Info>> {
+        using type = BurgersDeviceFlux<T, ndim>;
+
+        static auto make(const auto& disc) -> type
+        { return type::from_coefficients(disc.phys_flux.coeffs); }
+
+        /// @brief no boundary condition uses apply_bc
+        static auto bc_values(const auto&, BOUNDARY_CONDITIONS, int, T* out) -> void
+        { out[0] = 0.0; }
+    };
+
+    /// @brief the Navier-Stokes equations in conservative variables with the Van Leer flux
+    template<class T, int ndim, bool full_ns, bool full_ns_diffusion, class ST_Info>
+    struct device_physics<ConservationLawDDG<T, ndim,
+        navier_stokes::Flux<T, ndim, navier_stokes::CaloricallyPerfectEoS<T, ndim>,
+            navier_stokes::VARSET::CONSERVATIVE, full_ns>,
+        navier_stokes::VanLeer<T, ndim, navier_stokes::CaloricallyPerfectEoS<T, ndim>,
+            navier_stokes::VARSET::CONSERVATIVE>,
+        navier_stokes::DiffusionFlux<T, ndim, navier_stokes::CaloricallyPerfectEoS<T, ndim>,
+            navier_stokes::VARSET::CONSERVATIVE, full_ns_diffusion>, ST_Info>> {
+        using type = NavierStokesDeviceFlux<T, ndim>;
+
+        static auto make(const auto& disc) -> type {
+            return type::from_physics(disc.phys_flux.physics, full_ns, full_ns_diffusion,
+                disc.phys_flux.visc_max);
+        }
+
+        /// @brief the wall temperature and free stream state (see NavierStokesDeviceFlux::apply_bc)
+        static auto bc_values(const auto& disc, BOUNDARY_CONDITIONS bctype, int bcflag, T* out) -> void {
+            const auto& physics = disc.phys_flux.physics;
+            std::fill_n(out, ndim + 2, 0.0);
+            if(bctype == BOUNDARY_CONDITIONS::NO_SLIP_ISOTHERMAL
+                    || (bctype == BOUNDARY_CONDITIONS::WALL_GENERAL && full_ns)){
+                out[ndim + 1] = physics.isothermal_temperatures[bcflag];
+            } else if(bctype == BOUNDARY_CONDITIONS::RIEMANN){
+                out[0] = physics.free_stream.rho_inf;
+                for(int idim = 0; idim < ndim; ++idim)
+                    out[1 + idim] = physics.free_stream.u_direction[idim] * physics.free_stream.u_inf;
+                out[ndim + 1] = physics.free_stream.temp_inf;
+            }
+        }
+    };
+
+    /// @brief a discretization that has device fluxes (see device_physics)
+    template<class disc_class>
+    concept device_discretization = requires(const disc_class& disc) {
+        typename device_physics<disc_class>::type;
+        { device_physics<disc_class>::make(disc) } -> std::same_as<typename device_physics<disc_class>::type>;
+    };
+
+    // ===================
+    // = Device Residual =
+    // ===================
+
+    /**
+     * @brief the residual of a ConservationLawDDG (see form_residual)
+     * evaluated on the offload device over device_fespan data
+     *
+     * The geometry and basis data is flattened into device arrays on construction:
+     * - reference basis tables (values and reference gradients at the quadrature points)
+     *   for each element batch (FESpace::element_batches share a ReferenceElement)
+     * - the inverse jacobian and integration measure at each element quadrature point
+     * - for each interior and parallel communication trace: the unit normal, surface measure,
+     *   and DDG length scale at each quadrature point and the basis values, physical gradients,
+     *   and physical hessians of both elements
+     * - for each physical boundary trace: the same data for the interior element
+     *   and the boundary values at each quadrature point (the dirichlet and neumann callbacks
+     *   through the tabulations of ConservationLawDDG, and device_physics::bc_values)
+     *
+     * The domain integral is one kernel over all the elements and the traces are one kernel per color
+     * (no two traces of a color write to the same element) so the residual is scattered without atomics.
+     * Boundary conditions the device fluxes do not implement (and SPACETIME_PAST)
+     * are integrated on the host: only their elements are copied between the host mirror and the device.
+     *
+     * Parallel communication traces read the remote element from a device copy of the ghost layer
+     * of a HaloExchange (without shared memory so the construction makes no MPI calls).
+     * The elements sent to other ranks are copied to the host for the exchange,
+     * which overlaps with the domain and interior trace kernels.
+     *
+     * The tables are rebuilt by update() when the mesh moves (AbstractMesh::coord_version)
+     * (the boundary values are tabulated again then, the callbacks must only depend on the position).
+     *
+     * Not supported on the device (an anomaly is logged): artificial viscosity and user_source.
+     *
+     * @tparam T the floating point type
+     * @tparam IDX the index type
+     * @tparam ndim the number of dimensions
+     * @tparam disc_class the discretization (with device_physics)
+     */
+    template<class T, class IDX, int ndim, device_discretization disc_class>
+    class DeviceResidual {
+        public:
+        using Physics = typename device_physics<disc_class>::type;
+
+        /// @brief the number of vector components
+        static constexpr std::size_t neq = disc_class::nv_comp;
+
+        /// @brief the device solution and residual storage
+        using device_span = device_fespan<T, IDX, neq>;
+
+        private:
+
+        // ==================
+        // = Element Tables =
+        // ==================
+
+        /// @brief the reference element (element batch) of each element
+        util::device_array<IDX> el_ref{};
+
+        /// @brief the offset of each element into the quadrature point data (size nelem + 1)
+        util::device_array<std::size_t> el_qp_offsets{};
+
+        /// @brief the inverse jacobian at each element quadrature point [ndim x ndim] (row major)
+        util::device_array<T> el_jinv{};
+
+        /// @brief max(0, detJ) * weight at each element quadrature point
+        util::device_array<T> el_dvol{};
+
+        /// @brief the number of basis functions and quadrature points of each reference element
+        util::device_array<int> ref_nbasis{}, ref_nqp{};
+
+        /// @brief the offset of each reference element into the basis tables
+        util::device_array<std::size_t> ref_offsets{};
+
+        /// @brief the basis values [nqp x nbasis] and reference gradients [nqp x nbasis x ndim] of each reference element
+        util::device_array<T> ref_bi{}, ref_grad_bi{};
+
+        /// @brief the maximum wavespeed of each element from the last evaluation
+        util::device_array<T> el_wavespeeds{};
+
+        /// @brief the maximum viscosity at the quadrature points of each element from the last evaluation
+        util::device_array<T> el_viscosity{};
+
+        /// @brief if the element wavespeeds are from an evaluation since the last build
+        bool wavespeeds_current = false;
+
+        /// @brief the CFL reference length (see CFLTimestep) and max(1, polynomial order) of each element
+        util::device_array<T> el_reflen{};
+        util::device_array<int> el_order{};
+
+        // ================
+        // = Trace Tables =
+        // ================
+
+        /// @brief the interior traces of each color [color_offsets[icolor], color_offsets[icolor + 1])
+        std::vector<std::size_t> color_offsets{0};
+
+        /// @brief the parallel communication traces of each color (after the interior traces)
+        std::vector<std::size_t> par_color_offsets{0};
+
+        /// @brief the left and right element of each trace (the ghost index for the remote side of a parallel trace)
+        util::device_array<IDX> tr_elL{}, tr_elR{};
+
+        /// @brief which side of each trace is a ghost element: 0 for neither, 1 for the left, 2 for the right
+        util::device_array<unsigned char> tr_ghost_side{};
+
+        /// @brief the offset of each trace into the quadrature point data (size ntrace + 1)
+        util::device_array<std::size_t> tr_qp_offsets{};
+
+        /// @brief the offset of the left and right element basis data of each trace into the trace basis tables
+        util::device_array<std::size_t> tr_basis_offsetsL{}, tr_basis_offsetsR{};
+
+        /// @brief the DDG coefficients beta0 and beta1 of each trace (from the polynomial orders)
+        util::device_array<T> tr_beta0{}, tr_beta1{};
+
+        /// @brief the unit normal [ndim], surface measure, and DDG length scale at each trace quadrature point
+        util::device_array<T> tr_normals{}, tr_dsurf{}, tr_h_ddg{};
+
+        /// @brief the basis values [nbasis], physical gradients [nbasis x ndim],
+        /// and physical hessians [nbasis x ndim x ndim] at each trace quadrature point for each side
+        util::device_array<T> tr_bi{}, tr_grad_bi{}, tr_hess_bi{};
+
+        // =======================
+        // = Parallel Ghost Data =
+        // =======================
+
+        /// @brief the exchange of the elements on other ranks
+        HaloExchange<T, IDX> halo{};
+
+        /// @brief the local elements sent to other ranks (copied to the host for the exchange)
+        std::vector<IDX> par_send_elements{};
+
+        /// @brief the offset of each ghost element into ghost_data in degrees of freedom (size nghost + 1)
+        util::device_array<std::size_t> ghost_offsets{};
+
+        /// @brief the ghost element data on the device (vector component fastest)
+        util::device_array<T> ghost_data{};
+
+        // ============================
+        // = Physical Boundary Traces =
+        // ============================
+
+        /// @brief the boundary traces of each color [bdy_color_offsets[icolor], bdy_color_offsets[icolor + 1])
+        std::vector<std::size_t> bdy_color_offsets{0};
+
+        /// @brief the interior element and boundary condition of each boundary trace
+        util::device_array<IDX> bdy_el{};
+        util::device_array<int> bdy_bctype{};
+
+        /// @brief the offset of each boundary trace into the quadrature point data (size nbdy + 1)
+        util::device_array<std::size_t> bdy_qp_offsets{};
+
+        /// @brief the offset of each boundary trace into the boundary basis tables
+        util::device_array<std::size_t> bdy_basis_offsets{};
+
+        /// @brief the DDG penalty coefficient beta0 of each boundary trace
+        util::device_array<T> bdy_beta0{};
+
+        /// @brief the unit normal [ndim], surface measure, and DDG length scale at each boundary quadrature point
+        util::device_array<T> bdy_normals{}, bdy_dsurf{}, bdy_h_ddg{};
+
+        /// @brief the basis values [nbasis] and physical gradients [nbasis x ndim] at each boundary quadrature point
+        util::device_array<T> bdy_bi{}, bdy_grad_bi{};
+
+        /// @brief the boundary values [neq] at each boundary quadrature point
+        util::device_array<T> bdy_values{};
+
+        /// @brief the boundary traces integrated on the host
+        std::vector<IDX> host_bdy_traces{};
+
+        /// @brief the elements the host boundary traces read and the left elements they write to
+        std::vector<IDX> bdy_read_elements{}, bdy_write_elements{};
+
+        /// @brief host scratch for the compact element data of the host boundary traces
+        std::vector<T> uL_data{}, uR_data{}, resL_data{};
+
+        /// @brief the mesh coordinate version the tables were built for
+        std::size_t coord_version = 0;
+
+        /**
+         * @brief order items so no two items of a color write to the same element
+         * (the color of an item is the number of earlier items that write to its element)
+         * @param write_els the element each item writes to
+         * @param nelem the number of elements
+         * @param [out] offsets the items of each color are [offsets[icolor], offsets[icolor + 1]) of the order
+         * @return the item indices in color order
+         */
+        static auto color_by_element(std::span<const IDX> write_els, std::size_t nelem,
+                std::vector<std::size_t>& offsets) -> std::vector<std::size_t> {
+            std::vector<std::size_t> count(nelem, 0), color(write_els.size());
+            std::size_t ncolor = 0;
+            for(std::size_t i = 0; i < write_els.size(); ++i){
+                color[i] = count[write_els[i]]++;
+                ncolor = std::max(ncolor, color[i] + 1);
+            }
+            offsets.assign(ncolor + 1, 0);
+            for(std::size_t c : color) ++offsets[c + 1];
+            for(std::size_t icolor = 0; icolor < ncolor; ++icolor) offsets[icolor + 1] += offsets[icolor];
+            std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1), order(write_els.size());
+            for(std::size_t i = 0; i < write_els.size(); ++i) order[next[color[i]]++] = i;
+            return order;
+        }
+
+        public:
+
+        /**
+         * @brief build the device tables for the finite element space
+         * @param fespace the finite element space (dg)
+         * @param disc the discretization
+         */
+        DeviceResidual(FESpace<T, IDX, ndim>& fespace, disc_class& disc) { build(fespace, disc); }
+
+        /// @brief flatten the geometry, basis, and boundary data of the finite element space into the device tables
+        auto build(FESpace<T, IDX, ndim>& fespace, disc_class& disc) -> void {
+            using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+            using Element = FiniteElement<T, IDX, ndim>;
+            using Trace = TraceSpace<T, IDX, ndim>;
+            const std::size_t nelem = fespace.elements.size();
+            fespace.update_geometric_factors();
+
+            // reference basis tables for each element batch
+            std::vector<IDX> ref_of_el(nelem, 0);
+            std::vector<int> nbasis_h{}, nqp_h{};
+            std::vector<std::size_t> ref_offsets_h{0};
+            std::vector<T> bi_h{}, grad_bi_h{};
+            for(IDX ibatch = 0; ibatch < (IDX) fespace.element_batches.nrow(); ++ibatch){
+                std::span<const IDX> elidxs = fespace.element_batches.rowspan(ibatch);
+                for(IDX iel : elidxs) ref_of_el[iel] = ibatch;
+                const Element& el = fespace.elements[elidxs[0]];
+                nbasis_h.push_back(el.nbasis());
+                nqp_h.push_back(el.nQP());
+                for(int iqp = 0; iqp < el.nQP(); ++iqp){
+                    auto bi = el.eval_basis_qp(iqp);
+                    auto grad_ref = el.eval_grad_basis_qp(iqp);
+                    for(int ibasis = 0; ibasis < el.nbasis(); ++ibasis){
+                        bi_h.push_back(bi[ibasis]);
+                        for(int kdim = 0; kdim < ndim; ++kdim) grad_bi_h.push_back(grad_ref[ibasis, kdim]);
+                    }
+                }
+                ref_offsets_h.push_back(bi_h.size());
+            }
+
+            // element geometry at the quadrature points and the CFL reference lengths
+            std::vector<std::size_t> qp_offsets_h{0};
+            std::vector<T> jinv_h{}, dvol_h{}, reflen_h{};
+            std::vector<int> order_h{};
+            for(const Element& el : fespace.elements){
+                QPGeometry<T, IDX, ndim> qp_geo{el};
+                for(int iqp = 0; iqp < el.nQP(); ++iqp){
+                    auto [Jinv, dvol] = qp_geo[iqp];
+                    for(int kdim = 0; kdim < ndim; ++kdim)
+                        for(int jdim = 0; jdim < ndim; ++jdim) jinv_h.push_back(Jinv[kdim][jdim]);
+                    dvol_h.push_back(dvol);
+                }
+                qp_offsets_h.push_back(dvol_h.size());
+                auto J = el.jacobian(el.trans->centroid_ref());
+                reflen_h.push_back(std::pow(determinant(J), 1.0 / ndim));
+                order_h.push_back(std::max(1, el.basis->getPolynomialOrder()));
+            }
+
+            // the unit normal, surface measure, and physical point at a trace quadrature point
+            auto trace_qp_geometry = [&](const Trace& trace, int iqp){
+                const QuadraturePoint<T, ndim - 1> &quadpt = trace.getQP(iqp);
+                Tensor<T, ndim> unit_normal;
+                T dsurf;
+                MATH::GEOMETRY::Point<T, ndim> phys_pt;
+                if(trace.has_geometric_factors()){
+                    unit_normal = trace.geo_factors->unit_normal(trace.facidx, iqp);
+                    dsurf = trace.geo_factors->dsurf(trace.facidx, iqp);
+                    phys_pt = trace.geo_factors->trace_phys_pt(trace.facidx, iqp);
+                } else {
+                    auto Jfac = trace.face->Jacobian(fespace.meshptr->coord, quadpt.abscisse);
+                    T sqrtg = trace.face->rootRiemannMetric(Jfac, quadpt.abscisse);
+                    dsurf = quadpt.weight * sqrtg;
+                    unit_normal = normalize(calc_ortho(Jfac));
+                    trace.face->transform(quadpt.abscisse, fespace.meshptr->coord, phys_pt);
+                }
+                return std::tuple{unit_normal, dsurf, phys_pt};
+            };
+
+            // traces with both sides
+            std::vector<IDX> elL_h{}, elR_h{};
+            std::vector<unsigned char> ghost_side_h{};
+            std::vector<std::size_t> tr_qp_offsets_h{0}, basisL_h{}, basisR_h{};
+            std::vector<T> beta0_h{}, beta1_h{}, normals_h{}, dsurf_h{}, h_ddg_h{}, tr_bi_h{}, tr_grad_h{}, tr_hess_h{};
+            // append the basis data of one side at a quadrature point
+            auto append_basis = [](const Element& el, auto bi, auto gradBi, auto hessBi,
+                    std::vector<T>& bi_out, std::vector<T>& grad_out, std::vector<T>& hess_out){
+                for(int ibasis = 0; ibasis < el.nbasis(); ++ibasis){
+                    bi_out.push_back(bi[ibasis]);
+                    for(int idim = 0; idim < ndim; ++idim){
+                        grad_out.push_back(gradBi[ibasis, idim]);
+                        for(int jdim = 0; jdim < ndim; ++jdim) hess_out.push_back(hessBi[ibasis, idim, jdim]);
+                    }
+                }
+            };
+            auto append_trace = [&](const Trace& trace, IDX ielL, IDX ielR, unsigned char ghost_side){
+                const Element& elL = trace.elL;
+                const Element& elR = trace.elR;
+                elL_h.push_back(ielL);
+                elR_h.push_back(ielR);
+                ghost_side_h.push_back(ghost_side);
+
+                // Danis and Yan reccomended for NS (see ConservationLawDDG::trace_integral)
+                int order = std::max(elL.basis->getPolynomialOrder(), elR.basis->getPolynomialOrder());
+                beta0_h.push_back(std::pow(order + 1, 2));
+                beta1_h.push_back(1 / std::max((T) (2 * order * (order + 1)), 1.0));
+
+                const bool ddg_cached = trace.has_ddg_factors();
+                MATH::GEOMETRY::Point<T, ndim> centroidL{}, centroidR{};
+                if(!ddg_cached){
+                    centroidL = elL.centroid();
+                    centroidR = trace.centroid_r();
+                }
+                PhysDomainEvalStorage storageL{elL};
+                PhysDomainEvalStorage storageR{elR};
+                std::vector<T> sideR_bi{}, sideR_grad{}, sideR_hess{};
+                basisL_h.push_back(tr_bi_h.size());
+                for(int iqp = 0; iqp < trace.nQP(); ++iqp){
+                    auto [unit_normal, dsurf, phys_pt] = trace_qp_geometry(trace, iqp);
+                    for(int idim = 0; idim < ndim; ++idim) normals_h.push_back(unit_normal[idim]);
+                    dsurf_h.push_back(dsurf);
+                    h_ddg_h.push_back((ddg_cached) ? trace.ddg_factors->h_ddg(trace.facidx, iqp)
+                        : ddg_interface_distance<T, ndim>(unit_normal, phys_pt, centroidL, centroidR));
+
+                    auto biL = trace.qp_evals_l[iqp].bi_span;
+                    auto biR = trace.qp_evals_r[iqp].bi_span;
+                    if(ddg_cached){
+                        append_basis(elL, biL, trace.ddg_factors->grad_basis_l(trace, iqp),
+                            trace.ddg_factors->hess_basis_l(trace, iqp), tr_bi_h, tr_grad_h, tr_hess_h);
+                        append_basis(elR, biR, trace.ddg_factors->grad_basis_r(trace, iqp),
+                            trace.ddg_factors->hess_basis_r(trace, iqp), sideR_bi, sideR_grad, sideR_hess);
+                    } else {
+                        PhysDomainEval evalL{storageL, elL, trace.xiL_qp(iqp), trace.qp_evals_l[iqp],
+                            trace.jacobian_l_qp(iqp), trace.hessian_l_qp(iqp)};
+                        PhysDomainEval evalR{storageR, elR, trace.xiR_qp(iqp), trace.qp_evals_r[iqp],
+                            trace.jacobian_r_qp(iqp), trace.hessian_r_qp(iqp)};
+                        append_basis(elL, biL, evalL.phys_grad_basis, evalL.phys_hess_basis,
+                            tr_bi_h, tr_grad_h, tr_hess_h);
+                        append_basis(elR, biR, evalR.phys_grad_basis, evalR.phys_hess_basis,
+                            sideR_bi, sideR_grad, sideR_hess);
+                    }
+                }
+                // the right side follows the left side
+                basisR_h.push_back(tr_bi_h.size());
+                tr_bi_h.insert(tr_bi_h.end(), sideR_bi.begin(), sideR_bi.end());
+                tr_grad_h.insert(tr_grad_h.end(), sideR_grad.begin(), sideR_grad.end());
+                tr_hess_h.insert(tr_hess_h.end(), sideR_hess.begin(), sideR_hess.end());
+                tr_qp_offsets_h.push_back(dsurf_h.size());
+            };
+
+            // interior traces in color order
+            color_offsets.assign(1, 0);
+            for(IDX icolor = 0; icolor < (IDX) fespace.interior_trace_colors.nrow(); ++icolor){
+                for(IDX itrace : fespace.interior_trace_colors.rowspan(icolor)){
+                    const Trace& trace = fespace.traces[itrace];
+                    append_trace(trace, trace.elL.elidx, trace.elR.elidx, 0);
+                }
+                color_offsets.push_back(elL_h.size());
+            }
+
+            // parallel communication traces colored by the local element
+            std::vector<const Trace*> par_traces{};
+            for(const Trace& trace : fespace.get_boundary_traces()){
+                if(trace.face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) par_traces.push_back(&trace);
+            }
+            par_color_offsets.assign(1, elL_h.size());
+            std::vector<std::size_t> ghost_offsets_h{0};
+            par_send_elements.clear();
+#ifdef ICEICLE_USE_MPI
+            if(par_traces.size() > 0){
+                halo = HaloExchange<T, IDX>{fespace, neq, false};
+                std::vector<IDX> local_els{}, ghosts{};
+                std::vector<char> imlefts{};
+                for(const Trace* trace : par_traces){
+                    auto [jrank, imleft] = decode_mpi_bcflag(trace->face->bcflag);
+                    local_els.push_back((imleft) ? trace->elL.elidx : trace->elR.elidx);
+                    ghosts.push_back(halo.ghost_index(jrank, (imleft) ? trace->face->elemR : trace->face->elemL));
+                    imlefts.push_back(imleft);
+                }
+                std::vector<std::size_t> par_offsets{};
+                std::vector<std::size_t> order = color_by_element(local_els, nelem, par_offsets);
+                for(std::size_t i : order){
+                    if(imlefts[i]) append_trace(*par_traces[i], local_els[i], ghosts[i], 2);
+                    else append_trace(*par_traces[i], ghosts[i], local_els[i], 1);
+                }
+                for(std::size_t icolor = 1; icolor < par_offsets.size(); ++icolor)
+                    par_color_offsets.push_back(color_offsets.back() + par_offsets[icolor]);
+
+                // the ghost layer on the device (only the ghosts on traces take space)
+                std::vector<std::size_t> ghost_nbasis(halo.nghost(), 0);
+                for(std::size_t i = 0; i < par_traces.size(); ++i){
+                    const Element& remote = (imlefts[i]) ? par_traces[i]->elR : par_traces[i]->elL;
+                    ghost_nbasis[ghosts[i]] = remote.nbasis();
+                }
+                for(std::size_t n : ghost_nbasis) ghost_offsets_h.push_back(ghost_offsets_h.back() + n);
+
+                const auto& mesh = *(fespace.meshptr);
+                for(const auto& send_list : mesh.el_send_list)
+                    par_send_elements.insert(par_send_elements.end(), send_list.begin(), send_list.end());
+                std::ranges::sort(par_send_elements);
+                auto dups = std::ranges::unique(par_send_elements);
+                par_send_elements.erase(dups.begin(), dups.end());
+            }
+#else
+            if(par_traces.size() > 0){
+                util::AnomalyLog::log_anomaly(util::Anomaly{
+                    "Built without mpi, parallel communication traces are skipped by DeviceResidual",
+                    util::general_anomaly_tag{}});
+            }
+#endif
+
+            // physical boundary traces: on the device if the boundary condition is implemented
+            std::vector<const Trace*> device_bdy{};
+            host_bdy_traces.clear();
+            for(const Trace& trace : fespace.get_boundary_traces()){
+                BOUNDARY_CONDITIONS bctype = trace.face->bctype;
+                switch(bctype){
+                    case BOUNDARY_CONDITIONS::PARALLEL_COM:
+                        break;
+                    case BOUNDARY_CONDITIONS::DIRICHLET:
+                    case BOUNDARY_CONDITIONS::NEUMANN:
+                    case BOUNDARY_CONDITIONS::EXTRAPOLATION:
+                    case BOUNDARY_CONDITIONS::SPACETIME_FUTURE:
+                        device_bdy.push_back(&trace);
+                        break;
+                    case BOUNDARY_CONDITIONS::SPACETIME_PAST:
+                        host_bdy_traces.push_back(trace.facidx);
+                        break;
+                    default:
+                        // the host boundaryIntegral has no contribution without apply_bc
+                        if constexpr (implements_bcs<std::remove_cvref_t<decltype(disc.phys_flux)>>) {
+                            if(Physics::implements_bc(bctype)) device_bdy.push_back(&trace);
+                            else host_bdy_traces.push_back(trace.facidx);
+                        }
+                        break;
+                }
+            }
+            std::vector<IDX> bdy_write_h{};
+            for(const Trace* trace : device_bdy) bdy_write_h.push_back(trace->elL.elidx);
+            std::vector<std::size_t> bdy_order = color_by_element(bdy_write_h, nelem, bdy_color_offsets);
+            std::vector<IDX> bdy_el_h{};
+            std::vector<int> bctype_h{};
+            std::vector<std::size_t> bdy_qp_offsets_h{0}, bdy_basis_h{};
+            std::vector<T> bdy_beta0_h{}, bdy_normals_h{}, bdy_dsurf_h{}, bdy_h_ddg_h{},
+                bdy_bi_h{}, bdy_grad_h{}, bdy_values_h{};
+            std::vector<T> gradb_data(fespace.dg_map.max_el_size_reqirement(ndim));
+            for(std::size_t i : bdy_order){
+                const Trace& trace = *device_bdy[i];
+                const Element& elL = trace.elL;
+                const BOUNDARY_CONDITIONS bctype = trace.face->bctype;
+                const int bcflag = trace.face->bcflag;
+                bdy_el_h.push_back(elL.elidx);
+                bctype_h.push_back(static_cast<int>(bctype));
+                bdy_basis_h.push_back(bdy_bi_h.size());
+                int order = elL.basis->getPolynomialOrder();
+                bdy_beta0_h.push_back(std::pow(order + 1, 2));
+                auto centroidL = elL.centroid();
+                for(int iqp = 0; iqp < trace.nQP(); ++iqp){
+                    auto [unit_normal, dsurf, phys_pt] = trace_qp_geometry(trace, iqp);
+                    for(int idim = 0; idim < ndim; ++idim) bdy_normals_h.push_back(unit_normal[idim]);
+                    bdy_dsurf_h.push_back(dsurf);
+
+                    // uses distance to quadpt on boundary face (see ConservationLawDDG::boundaryIntegral)
+                    T h_ddg = 0;
+                    for(int idim = 0; idim < ndim; ++idim)
+                        { h_ddg += std::abs(unit_normal[idim] * (phys_pt[idim] - centroidL[idim])); }
+                    h_ddg = std::copysign(std::max(std::abs(h_ddg), std::numeric_limits<T>::epsilon()), h_ddg);
+                    bdy_h_ddg_h.push_back(h_ddg);
+
+                    auto biL = trace.qp_evals_l[iqp].bi_span;
+                    auto gradBiL = trace.eval_phys_grad_basis_l_qp(iqp, gradb_data.data());
+                    for(int ibasis = 0; ibasis < elL.nbasis(); ++ibasis){
+                        bdy_bi_h.push_back(biL[ibasis]);
+                        for(int idim = 0; idim < ndim; ++idim) bdy_grad_h.push_back(gradBiL[ibasis, idim]);
+                    }
+
+                    // the boundary values
+                    std::array<T, neq> vals{};
+                    if(bctype == BOUNDARY_CONDITIONS::DIRICHLET){
+                        disc.dirichlet_table.eval(disc.dirichlet_callbacks[bcflag],
+                            trace.facidx, iqp, phys_pt.data(), vals.data());
+                    } else if(bctype == BOUNDARY_CONDITIONS::NEUMANN){
+                        disc.neumann_table.eval(disc.neumann_callbacks[bcflag],
+                            trace.facidx, iqp, phys_pt.data(), vals.data());
+                    } else if(Physics::implements_bc(bctype)){
+                        device_physics<disc_class>::bc_values(disc, bctype, bcflag, vals.data());
+                    }
+                    bdy_values_h.insert(bdy_values_h.end(), vals.begin(), vals.end());
+                }
+                bdy_qp_offsets_h.push_back(bdy_dsurf_h.size());
+            }
+
+            // elements of the host boundary traces
+            std::vector<bool> reads(nelem, false), writes(nelem, false);
+            for(IDX itrace : host_bdy_traces){
+                const Trace& trace = fespace.traces[itrace];
+                reads[trace.elL.elidx] = reads[trace.elR.elidx] = true;
+                writes[trace.elL.elidx] = true;
+            }
+            bdy_read_elements.clear();
+            bdy_write_elements.clear();
+            for(IDX iel = 0; iel < (IDX) nelem; ++iel){
+                if(reads[iel]) bdy_read_elements.push_back(iel);
+                if(writes[iel]) bdy_write_elements.push_back(iel);
+            }
+            std::size_t max_el_size = fespace.dg_map.max_el_size_reqirement(neq);
+            uL_data.resize(max_el_size);
+            uR_data.resize(max_el_size);
+            resL_data.resize(max_el_size);
+
+            // copy everything to the device
+            el_ref.assign(ref_of_el);
+            el_qp_offsets.assign(qp_offsets_h);
+            el_jinv.assign(jinv_h);
+            el_dvol.assign(dvol_h);
+            ref_nbasis.assign(nbasis_h);
+            ref_nqp.assign(nqp_h);
+            ref_offsets.assign(ref_offsets_h);
+            ref_bi.assign(bi_h);
+            ref_grad_bi.assign(grad_bi_h);
+            el_wavespeeds = util::device_array<T>(nelem, 0.0);
+            el_viscosity = util::device_array<T>(nelem, 0.0);
+            wavespeeds_current = false;
+            el_reflen.assign(reflen_h);
+            el_order.assign(order_h);
+            tr_elL.assign(elL_h);
+            tr_elR.assign(elR_h);
+            tr_ghost_side.assign(ghost_side_h);
+            tr_qp_offsets.assign(tr_qp_offsets_h);
+            tr_basis_offsetsL.assign(basisL_h);
+            tr_basis_offsetsR.assign(basisR_h);
+            tr_beta0.assign(beta0_h);
+            tr_beta1.assign(beta1_h);
+            tr_normals.assign(normals_h);
+            tr_dsurf.assign(dsurf_h);
+            tr_h_ddg.assign(h_ddg_h);
+            tr_bi.assign(tr_bi_h);
+            tr_grad_bi.assign(tr_grad_h);
+            tr_hess_bi.assign(tr_hess_h);
+            ghost_offsets.assign(ghost_offsets_h);
+            ghost_data = util::device_array<T>(ghost_offsets_h.back() * neq, 0.0);
+            bdy_el.assign(bdy_el_h);
+            bdy_bctype.assign(bctype_h);
+            bdy_qp_offsets.assign(bdy_qp_offsets_h);
+            bdy_basis_offsets.assign(bdy_basis_h);
+            bdy_beta0.assign(bdy_beta0_h);
+            bdy_normals.assign(bdy_normals_h);
+            bdy_dsurf.assign(bdy_dsurf_h);
+            bdy_h_ddg.assign(bdy_h_ddg_h);
+            bdy_bi.assign(bdy_bi_h);
+            bdy_grad_bi.assign(bdy_grad_h);
+            bdy_values.assign(bdy_values_h);
+            coord_version = fespace.meshptr->coord_version;
+        }
+
+        /// @brief rebuild the tables only if the mesh has moved since the last build
+        auto update(FESpace<T, IDX, ndim>& fespace, disc_class& disc) -> void {
+            if(coord_version != fespace.meshptr->coord_version) build(fespace, disc);
+        }
+
+        /**
+         * @brief form the residual on the device
+         * (the same residual as form_residual up to rounding)
+         *
+         * Records the maximum wavespeed (and viscosity) of the physical flux for the CFL condition
+         * and keeps the element wavespeeds on the device for cfl_timestep()
+         * (disc.element_wavespeeds is not written)
+         *
+         * @param fespace the finite element space this was built with
+         * @param disc the discretization
+         * @param u the solution on the device
+         * @param [out] res the residual on the device
+         */
+        auto operator()(
+            FESpace<T, IDX, ndim>& fespace,
+            disc_class& disc,
+            device_span& u,
+            device_span& res
+        ) -> void {
+            ICEICLE_PROFILE_REGION("device_residual");
+            if(disc.user_source || disc.artificial_viscosity.active()){
+                util::AnomalyLog::log_anomaly(util::Anomaly{
+                    "DeviceResidual does not support user_source or artificial viscosity: they are not applied",
+                    util::general_anomaly_tag{}});
+            }
+            update(fespace, disc);
+
+            {
+                T* res_data = res.data();
+                std::size_t res_size = res.size();
+#ifdef ICEICLE_USE_DEVICE
+#pragma omp target teams distribute parallel for
+#endif
+                for(std::size_t i = 0; i < res_size; ++i) res_data[i] = 0.0;
+            }
+
+            // send the process boundary elements while the local work is done
+#ifdef ICEICLE_USE_MPI
+            const bool exchange = par_color_offsets.size() > 1;
+            if(exchange){
+                for(IDX iel : par_send_elements) u.update_host(iel);
+                halo.begin_exchange(u.host_view());
+            }
+#endif
+
+            host_boundary_traces(fespace, disc, u, res);
+            for(std::size_t icolor = 0; icolor + 1 < bdy_color_offsets.size(); ++icolor)
+                { boundary_traces(disc, bdy_color_offsets[icolor], bdy_color_offsets[icolor + 1], u, res); }
+            domain_integrals(disc, u, res);
+            for(std::size_t icolor = 0; icolor + 1 < color_offsets.size(); ++icolor)
+                { interior_traces(disc, color_offsets[icolor], color_offsets[icolor + 1], u, res); }
+
+#ifdef ICEICLE_USE_MPI
+            if(exchange){
+                halo.finish_exchange();
+                const std::span<const std::size_t> offsets_h = ghost_offsets.host();
+                for(std::size_t ighost = 0; ighost + 1 < offsets_h.size(); ++ighost){
+                    std::size_t n = (offsets_h[ighost + 1] - offsets_h[ighost]) * neq;
+                    if(n > 0) std::copy_n(halo.ghost_element_data(ighost), n,
+                            ghost_data.host().data() + offsets_h[ighost] * neq);
+                }
+                ghost_data.update_device();
+                for(std::size_t icolor = 0; icolor + 1 < par_color_offsets.size(); ++icolor)
+                    { interior_traces(disc, par_color_offsets[icolor], par_color_offsets[icolor + 1], u, res); }
+            }
+#endif
+        }
+
+        /// @brief if the element wavespeeds for cfl_timestep() are from an evaluation on the current tables
+        [[nodiscard]] auto has_wavespeeds() const noexcept -> bool { return wavespeeds_current; }
+
+        /**
+         * @brief the timestep of the element CFL conditions from the wavespeeds of the last evaluation
+         * (the element timesteps of CFLTimestep, reduced on the device)
+         * the residual must be evaluated first (see has_wavespeeds())
+         * @param fespace the finite element space this was built with
+         * @param disc the discretization
+         * @param cfl the cfl condition
+         * @return the minimum over the elements of dt_from_cfl(cfl, reference length, wavespeed) / (2 * order + 1)
+         */
+        auto cfl_timestep(FESpace<T, IDX, ndim>& fespace, disc_class& disc, T cfl) -> T {
+            update(fespace, disc);
+            const Physics phys = device_physics<disc_class>::make(disc);
+            const std::size_t nelem = el_wavespeeds.size();
+            const T* wavespeeds = el_wavespeeds.data();
+            const T* reflen = el_reflen.data();
+            const int* order = el_order.data();
+            T dt = std::numeric_limits<T>::max();
+#ifdef ICEICLE_USE_DEVICE
+#pragma omp target teams distribute parallel for map(to: phys) reduction(min: dt)
+#endif
+            for(std::size_t iel = 0; iel < nelem; ++iel){
+                T dt_el = phys.dt_from_cfl(cfl, reflen[iel], wavespeeds[iel]) / (2 * order[iel] + 1);
+                dt = std::min(dt, dt_el);
+            }
+            return dt;
+        }
+
+        /// @brief the l2 norm of device data (i.e the residual)
+        static auto l2_norm(device_span& res) -> T {
+            const T* res_data = res.data();
+            std::size_t res_size = res.size();
+            T sum = 0;
+#ifdef ICEICLE_USE_DEVICE
+#pragma omp target teams distribute parallel for reduction(+: sum)
+#endif
+            for(std::size_t i = 0; i < res_size; ++i) sum += res_data[i] * res_data[i];
+            return std::sqrt(sum);
+        }
+
+        private:
+
+        /// @brief the boundary traces the device does not implement on the host
+        /// (written over the zero residual of their left elements)
+        auto host_boundary_traces(FESpace<T, IDX, ndim>& fespace, disc_class& disc, device_span& u, device_span& res) -> void {
+            if(host_bdy_traces.empty()) return;
+            for(IDX iel : bdy_read_elements) u.update_host(iel);
+            auto u_host = u.host_view();
+            auto res_host = res.host_view();
+            for(IDX iel : bdy_write_elements){
+                for(std::size_t idof = 0; idof < res.ndof(iel); ++idof)
+                    for(std::size_t ieq = 0; ieq < neq; ++ieq) res_host[iel, idof, ieq] = 0.0;
+            }
+            for(IDX itrace : host_bdy_traces){
+                const TraceSpace<T, IDX, ndim>& trace = fespace.traces[itrace];
+                dofspan uL{uL_data.data(), u_host.create_element_layout(trace.elL.elidx)};
+                dofspan uR{uR_data.data(), u_host.create_element_layout(trace.elR.elidx)};
+                dofspan resL{resL_data.data(), res_host.create_element_layout(trace.elL.elidx)};
+                extract_elspan(trace.elL.elidx, u_host, uL);
+                extract_elspan(trace.elR.elidx, u_host, uR);
+                resL = 0;
+                disc.boundaryIntegral(trace, fespace.meshptr->coord, uL, uR, resL);
+                scatter_elspan(trace.elL.elidx, 1.0, resL, 1.0, res_host);
+            }
+            for(IDX iel : bdy_write_elements) res.update_device(iel);
+        }
+
+        /// @brief the boundary traces [begin, end) of a color (one kernel, see ConservationLawDDG::boundaryIntegral)
+        auto boundary_traces(disc_class& disc, std::size_t begin, std::size_t end, device_span& u, device_span& res) -> void {
+            const Physics phys = device_physics<disc_class>::make(disc);
+            const T sigma_ic = disc.sigma_ic;
+            const IDX* offsets = u.offsets();
+            const T* u_data = u.data();
+            T* res_data = res.data();
+            const IDX* el_p = bdy_el.data();
+            const int* bctype_p = bdy_bctype.data();
+            const std::size_t* qp_offsets = bdy_qp_offsets.data();
+            const std::size_t* basis_offsets = bdy_basis_offsets.data();
+            const T* beta0_p = bdy_beta0.data();
+            const T* normals = bdy_normals.data();
+            const T* dsurf_p = bdy_dsurf.data();
+            const T* h_ddg_p = bdy_h_ddg.data();
+            const T* bi_p = bdy_bi.data();
+            const T* grad_p = bdy_grad_bi.data();
+            const T* values_p = bdy_values.data();
+
+#ifdef ICEICLE_USE_DEVICE
+#pragma omp target teams distribute parallel for map(to: phys)
+#endif
+            for(std::size_t itrace = begin; itrace < end; ++itrace){
+                const IDX iel = el_p[itrace];
+                const int nbasis = offsets[iel + 1] - offsets[iel];
+                const BOUNDARY_CONDITIONS bctype = static_cast<BOUNDARY_CONDITIONS>(bctype_p[itrace]);
+                const T beta0 = beta0_p[itrace];
+                const std::size_t nqp = qp_offsets[itrace + 1] - qp_offsets[itrace];
+                for(std::size_t iqp = 0; iqp < nqp; ++iqp){
+                    const std::size_t iqp_tr = qp_offsets[itrace] + iqp;
+                    const T* unit_normal = normals + iqp_tr * ndim;
+                    const T dsurf = dsurf_p[iqp_tr];
+                    const T h_ddg = h_ddg_p[iqp_tr];
+                    const T* bcvals = values_p + iqp_tr * neq;
+                    const std::size_t ibasis0 = basis_offsets[itrace] + iqp * nbasis;
+                    const T* bi = bi_p + ibasis0;
+                    const T* gradBi = grad_p + ibasis0 * ndim;
+
+                    // NOTE: Neumann Boundary conditions only use the diffusive flux
+                    if(bctype == BOUNDARY_CONDITIONS::NEUMANN){
+                        T fviscn[neq];
+                        phys.neumann_flux(bcvals, fviscn);
+                        for(std::size_t ieq = 0; ieq < neq; ++ieq){
+                            for(int itest = 0; itest < nbasis; ++itest)
+                                { res_data[device_span::index(offsets, iel, itest, ieq)] += fviscn[ieq] * dsurf * bi[itest]; }
+                        }
+                        continue;
+                    }
+
+                    // the interior solution and gradient
+                    T uL[neq]{};
+                    T graduL[neq * ndim]{};
+                    for(int ibasis = 0; ibasis < nbasis; ++ibasis){
+                        for(std::size_t ieq = 0; ieq < neq; ++ieq){
+                            T c = u_data[device_span::index(offsets, iel, ibasis, ieq)];
+                            uL[ieq] += c * bi[ibasis];
+                            for(int idim = 0; idim < ndim; ++idim) graduL[ieq * ndim + idim] += c * gradBi[ibasis * ndim + idim];
+                        }
+                    }
+
+                    // the exterior state and the interface correction multiplier
+                    T uR[neq]{};
+                    T graduR[neq * ndim]{};
+                    T ic_multiplier = 0.0;
+                    const bool extrapolate = bctype == BOUNDARY_CONDITIONS::EXTRAPOLATION
+                        || bctype == BOUNDARY_CONDITIONS::SPACETIME_FUTURE;
+                    if(extrapolate){
+                        for(std::size_t ieq = 0; ieq < neq; ++ieq) uR[ieq] = uL[ieq];
+                    } else if(bctype == BOUNDARY_CONDITIONS::DIRICHLET){
+                        for(std::size_t ieq = 0; ieq < neq; ++ieq) uR[ieq] = bcvals[ieq];
+                        ic_multiplier = sigma_ic;
+                    } else {
+                        if constexpr (requires { phys.apply_bc(bctype, uL, graduL, unit_normal, bcvals, uR, graduR); }) {
+                            phys.apply_bc(bctype, uL, graduL, unit_normal, bcvals, uR, graduR);
+                        }
+                        // the general boundary conditions apply the full interface correction
+                        ic_multiplier = (sigma_ic != 0.0) ? 1.0 : 0.0;
+                    }
+
+                    T fadvn[neq];
+                    phys.conv_nflux(uL, uR, unit_normal, fadvn);
+
+                    // the DDG gradient (only the interior gradient for extrapolation)
+                    T grad_ddg[neq * ndim];
+                    T uavg[neq];
+                    for(std::size_t ieq = 0; ieq < neq; ++ieq){
+                        T jumpu = uR[ieq] - uL[ieq];
+                        for(int idim = 0; idim < ndim; ++idim){
+                            grad_ddg[ieq * ndim + idim] = (extrapolate) ? graduL[ieq * ndim + idim]
+                                : beta0 * jumpu / h_ddg * unit_normal[idim] + graduL[ieq * ndim + idim];
+                        }
+                        uavg[ieq] = 0.5 * (uL[ieq] + uR[ieq]);
+                    }
+                    T fviscn[neq];
+                    phys.diff_nflux(uavg, grad_ddg, unit_normal, fviscn);
+
+                    // scatter contribution
+                    for(std::size_t ieq = 0; ieq < neq; ++ieq){
+                        T fn = (fviscn[ieq] - fadvn[ieq]) * dsurf;
+                        for(int itest = 0; itest < nbasis; ++itest)
+                            { res_data[device_span::index(offsets, iel, itest, ieq)] += fn * bi[itest]; }
+                    }
+
+                    // the interface correction
+                    if constexpr (Physics::has_homogeneity_tensor) {
+                        if(ic_multiplier != 0.0){
+                            T G[neq * ndim * neq * ndim];
+                            phys.homogeneity_tensor(uavg, G);
+                            for(std::size_t ieq = 0; ieq < neq; ++ieq){
+                                for(int sdim = 0; sdim < ndim; ++sdim){
+                                    T ic_contrib = 0;
+                                    for(int kdim = 0; kdim < ndim; ++kdim){
+                                        for(std::size_t req = 0; req < neq; ++req){
+                                            ic_contrib += ic_multiplier * G[((ieq * ndim + kdim) * neq + req) * ndim + sdim]
+                                                * unit_normal[kdim] * (uR[req] - uL[req]) * dsurf;
+                                        }
+                                    }
+                                    for(int itest = 0; itest < nbasis; ++itest){
+                                        res_data[device_span::index(offsets, iel, itest, ieq)] -=
+                                            ic_contrib * gradBi[itest * ndim + sdim];
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        /// @brief the domain integral of every element (one kernel)
+        auto domain_integrals(disc_class& disc, device_span& u, device_span& res) -> void {
+            const Physics phys = device_physics<disc_class>::make(disc);
+            const IDX nelem = (IDX) u.nelem();
+            const IDX* offsets = u.offsets();
+            const T* u_data = u.data();
+            T* res_data = res.data();
+            const IDX* el_ref_p = el_ref.data();
+            const std::size_t* qp_offsets = el_qp_offsets.data();
+            const T* jinv = el_jinv.data();
+            const T* dvol_p = el_dvol.data();
+            const int* nbasis_p = ref_nbasis.data();
+            const int* nqp_p = ref_nqp.data();
+            const std::size_t* ref_offsets_p = ref_offsets.data();
+            const T* ref_bi_p = ref_bi.data();
+            const T* ref_grad_p = ref_grad_bi.data();
+            T* wavespeeds = el_wavespeeds.data();
+            T* viscosities = el_viscosity.data();
+
+#ifdef ICEICLE_USE_DEVICE
+#pragma omp target teams distribute parallel for map(to: phys)
+#endif
+            for(IDX iel = 0; iel < nelem; ++iel){
+                const IDX iref = el_ref_p[iel];
+                const int nbasis = nbasis_p[iref];
+                const int nqp = nqp_p[iref];
+                T lambda_el = 0, mu_el = 0;
+                for(int iqp = 0; iqp < nqp; ++iqp){
+                    const std::size_t ibasis0 = ref_offsets_p[iref] + iqp * nbasis;
+                    const T* bi = ref_bi_p + ibasis0;
+                    const T* grad_ref = ref_grad_p + ibasis0 * ndim;
+                    const std::size_t iqp_el = qp_offsets[iel] + iqp;
+                    const T* Jinv = jinv + iqp_el * ndim * ndim;
+                    const T dvol = dvol_p[iqp_el];
+
+                    // physical gradients of the basis functions: dB/dx_j = dB/dxi_k J^{-1}_{kj}
+                    auto gradx = [&](int ibasis, int jdim) -> T {
+                        T sum = 0;
+                        for(int kdim = 0; kdim < ndim; ++kdim) sum += grad_ref[ibasis * ndim + kdim] * Jinv[kdim * ndim + jdim];
+                        return sum;
+                    };
+
+                    // the solution and gradient at the quadrature point
+                    T uq[neq]{};
+                    T gradu[neq * ndim]{};
+                    for(int ibasis = 0; ibasis < nbasis; ++ibasis){
+                        for(std::size_t ieq = 0; ieq < neq; ++ieq){
+                            T c = u_data[device_span::index(offsets, iel, ibasis, ieq)];
+                            uq[ieq] += c * bi[ibasis];
+                            for(int jdim = 0; jdim < ndim; ++jdim) gradu[ieq * ndim + jdim] += c * gradx(ibasis, jdim);
+                        }
+                    }
+
+                    T flux[neq * ndim];
+                    phys.flux(uq, gradu, flux);
+                    T lambda = phys.wavespeed(uq);
+                    lambda_el = (lambda > lambda_el) ? lambda : lambda_el;
+                    if constexpr (requires { phys.viscosity(uq); }) {
+                        T mu = phys.viscosity(uq);
+                        mu_el = (mu > mu_el) ? mu : mu_el;
+                    }
+
+                    // test function loop
+                    for(int itest = 0; itest < nbasis; ++itest){
+                        for(std::size_t ieq = 0; ieq < neq; ++ieq){
+                            T sum = 0;
+                            for(int jdim = 0; jdim < ndim; ++jdim) sum += flux[ieq * ndim + jdim] * dvol * gradx(itest, jdim);
+                            res_data[device_span::index(offsets, iel, itest, ieq)] += sum;
+                        }
+                    }
+                }
+                wavespeeds[iel] = lambda_el;
+                viscosities[iel] = mu_el;
+            }
+
+            // the maximum wavespeed (and viscosity) for the CFL condition
+            T lambda_max = 0, visc_max = 0;
+#ifdef ICEICLE_USE_DEVICE
+#pragma omp target teams distribute parallel for reduction(max: lambda_max, visc_max)
+#endif
+            for(IDX iel = 0; iel < nelem; ++iel){
+                lambda_max = std::max(lambda_max, wavespeeds[iel]);
+                visc_max = std::max(visc_max, viscosities[iel]);
+            }
+            wavespeeds_current = true;
+            if constexpr (requires { disc.phys_flux.lambda_max; })
+                { disc.phys_flux.lambda_max = std::max(disc.phys_flux.lambda_max, lambda_max); }
+            if constexpr (requires { disc.phys_flux.visc_max; })
+                { disc.phys_flux.visc_max = std::max(disc.phys_flux.visc_max, visc_max); }
+        }
+
+        /// @brief the traces [begin, end) of a color with both sides (one kernel)
+        /// the ghost side of a parallel communication trace reads the ghost data and is not scattered to
+        auto interior_traces(disc_class& disc, std::size_t begin, std::size_t end, device_span& u, device_span& res) -> void {
+            const Physics phys = device_physics<disc_class>::make(disc);
+            const T ic_multiplier = disc.sigma_ic;
+            const T beta1_multiplier = (disc.interior_penalty) ? 0.0 : 1.0;
+            const IDX* offsets = u.offsets();
+            const T* u_data = u.data();
+            T* res_data = res.data();
+            const T* ghost_u = ghost_data.data();
+            const std::size_t* ghost_offsets_p = ghost_offsets.data();
+            const IDX* elL_p = tr_elL.data();
+            const IDX* elR_p = tr_elR.data();
+            const unsigned char* ghost_side_p = tr_ghost_side.data();
+            const std::size_t* qp_offsets = tr_qp_offsets.data();
+            const std::size_t* basis_offsetsL = tr_basis_offsetsL.data();
+            const std::size_t* basis_offsetsR = tr_basis_offsetsR.data();
+            const T* beta0_p = tr_beta0.data();
+            const T* beta1_p = tr_beta1.data();
+            const T* normals = tr_normals.data();
+            const T* dsurf_p = tr_dsurf.data();
+            const T* h_ddg_p = tr_h_ddg.data();
+            const T* bi_p = tr_bi.data();
+            const T* grad_p = tr_grad_bi.data();
+            const T* hess_p = tr_hess_bi.data();
+
+#ifdef ICEICLE_USE_DEVICE
+#pragma omp target teams distribute parallel for map(to: phys)
+#endif
+            for(std::size_t itrace = begin; itrace < end; ++itrace){
+                const IDX ielL = elL_p[itrace];
+                const IDX ielR = elR_p[itrace];
+                const bool ghostL = ghost_side_p[itrace] == 1;
+                const bool ghostR = ghost_side_p[itrace] == 2;
+                auto nbasis_of = [&](bool ghost, IDX iel) -> int {
+                    return (ghost) ? ghost_offsets_p[iel + 1] - ghost_offsets_p[iel] : offsets[iel + 1] - offsets[iel];
+                };
+                auto coefficient = [&](bool ghost, IDX iel, int ibasis, std::size_t ieq) -> T {
+                    return (ghost) ? ghost_u[(ghost_offsets_p[iel] + ibasis) * neq + ieq]
+                        : u_data[device_span::index(offsets, iel, ibasis, ieq)];
+                };
+                const int nbasisL = nbasis_of(ghostL, ielL);
+                const int nbasisR = nbasis_of(ghostR, ielR);
+                const T beta0 = beta0_p[itrace];
+                const T beta1 = beta1_multiplier * beta1_p[itrace];
+                const std::size_t nqp = qp_offsets[itrace + 1] - qp_offsets[itrace];
+                for(std::size_t iqp = 0; iqp < nqp; ++iqp){
+                    const std::size_t iqp_tr = qp_offsets[itrace] + iqp;
+                    const T* unit_normal = normals + iqp_tr * ndim;
+                    const T dsurf = dsurf_p[iqp_tr];
+                    const T h_ddg = h_ddg_p[iqp_tr];
+                    const std::size_t ibasisL0 = basis_offsetsL[itrace] + iqp * nbasisL;
+                    const std::size_t ibasisR0 = basis_offsetsR[itrace] + iqp * nbasisR;
+                    const T* biL = bi_p + ibasisL0;
+                    const T* biR = bi_p + ibasisR0;
+                    const T* gradBiL = grad_p + ibasisL0 * ndim;
+                    const T* gradBiR = grad_p + ibasisR0 * ndim;
+                    const T* hessBiL = hess_p + ibasisL0 * ndim * ndim;
+                    const T* hessBiR = hess_p + ibasisR0 * ndim * ndim;
+
+                    // the solution, gradients, and hessians on each side
+                    T uL[neq]{}, uR[neq]{};
+                    T graduL[neq * ndim]{}, graduR[neq * ndim]{};
+                    T hessuL[neq * ndim * ndim]{}, hessuR[neq * ndim * ndim]{};
+                    auto contract = [&](bool ghost, IDX iel, int nbasis, const T* bi, const T* gradBi, const T* hessBi,
+                            T* uq, T* gradu, T* hessu){
+                        for(int ibasis = 0; ibasis < nbasis; ++ibasis){
+                            for(std::size_t ieq = 0; ieq < neq; ++ieq){
+                                T c = coefficient(ghost, iel, ibasis, ieq);
+                                uq[ieq] += c * bi[ibasis];
+                                for(int idim = 0; idim < ndim; ++idim)
+                                    { gradu[ieq * ndim + idim] += c * gradBi[ibasis * ndim + idim]; }
+                                for(int ihess = 0; ihess < ndim * ndim; ++ihess)
+                                    { hessu[ieq * ndim * ndim + ihess] += c * hessBi[ibasis * ndim * ndim + ihess]; }
+                            }
+                        }
+                    };
+                    contract(ghostL, ielL, nbasisL, biL, gradBiL, hessBiL, uL, graduL, hessuL);
+                    contract(ghostR, ielR, nbasisR, biR, gradBiR, hessBiR, uR, graduR, hessuR);
+
+                    T fadvn[neq];
+                    phys.conv_nflux(uL, uR, unit_normal, fadvn);
+
+                    // the DDG single valued gradient
+                    T grad_ddg[neq * ndim];
+                    for(std::size_t ieq = 0; ieq < neq; ++ieq){
+                        T jumpu = uR[ieq] - uL[ieq];
+                        for(int idim = 0; idim < ndim; ++idim){
+                            T hessTerm = 0;
+                            for(int jdim = 0; jdim < ndim; ++jdim){
+                                std::size_t ihess = ieq * ndim * ndim + jdim * ndim + idim;
+                                hessTerm += (hessuR[ihess] - hessuL[ihess]) * unit_normal[jdim];
+                            }
+                            grad_ddg[ieq * ndim + idim] = beta0 * jumpu / h_ddg * unit_normal[idim]
+                                + 0.5 * (graduL[ieq * ndim + idim] + graduR[ieq * ndim + idim])
+                                + beta1 * h_ddg * hessTerm;
+                        }
+                    }
+
+                    T uavg[neq];
+                    for(std::size_t ieq = 0; ieq < neq; ++ieq) uavg[ieq] = 0.5 * (uL[ieq] + uR[ieq]);
+                    T fviscn[neq];
+                    phys.diff_nflux(uavg, grad_ddg, unit_normal, fviscn);
+
+                    // scatter contribution
+                    for(std::size_t ieq = 0; ieq < neq; ++ieq){
+                        T fn = (fviscn[ieq] - fadvn[ieq]) * dsurf;
+                        if(!ghostL){
+                            for(int itest = 0; itest < nbasisL; ++itest)
+                                { res_data[device_span::index(offsets, ielL, itest, ieq)] += fn * biL[itest]; }
+                        }
+                        if(!ghostR){
+                            for(int itest = 0; itest < nbasisR; ++itest)
+                                { res_data[device_span::index(offsets, ielR, itest, ieq)] -= fn * biR[itest]; }
+                        }
+                    }
+
+                    // the interface correction (DDGIC)
+                    if constexpr (Physics::has_homogeneity_tensor) {
+                        if(ic_multiplier != 0.0){
+                            T G[neq * ndim * neq * ndim];
+                            phys.homogeneity_tensor(uavg, G);
+                            for(std::size_t ieq = 0; ieq < neq; ++ieq){
+                                for(int sdim = 0; sdim < ndim; ++sdim){
+                                    T ic_contrib = 0;
+                                    for(int kdim = 0; kdim < ndim; ++kdim){
+                                        for(std::size_t req = 0; req < neq; ++req){
+                                            ic_contrib += ic_multiplier * G[((ieq * ndim + kdim) * neq + req) * ndim + sdim]
+                                                * unit_normal[kdim] * (uR[req] - uL[req]) * dsurf;
+                                        }
+                                    }
+                                    // 0.5 comes from average operator
+                                    if(!ghostL){
+                                        for(int itest = 0; itest < nbasisL; ++itest){
+                                            res_data[device_span::index(offsets, ielL, itest, ieq)] -=
+                                                ic_contrib * 0.5 * gradBiL[itest * ndim + sdim];
+                                        }
+                                    }
+                                    if(!ghostR){
+                                        for(int itest = 0; itest < nbasisR; ++itest){
+                                            res_data[device_span::index(offsets, ielR, itest, ieq)] -=
+                                                ic_contrib * 0.5 * gradBiR[itest * ndim + sdim];
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    // deduction guide
+    template<class T, class IDX, int ndim, class disc_class>
+    DeviceResidual(FESpace<T, IDX, ndim>&, disc_class&) -> DeviceResidual<T, IDX, ndim, disc_class>;
+}
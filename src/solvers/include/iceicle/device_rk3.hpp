@@ -0,0 +1,384 @@
+/**
+ * @brief explicit 3 stage Runge-Kutta schemes with the solution and residual resident on the offload device
+ *
+ * see doc/design/device_residual.md
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/device_array.hpp"
+#include "iceicle/device_residual.hpp"
+#include "iceicle/element_linear_solve.hpp"
+#include "iceicle/explicit_utils.hpp"
+#include "iceicle/fe_function/device_fespan.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include <cstddef>
+#include <concepts>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace iceicle::solvers {
+
+    /**
+     * @brief the inverse mass matrix of every element as a dense block on the device
+     * applied as a batched dense matrix-vector product
+     *
+     * The blocks are formed by applying TensorProductInverseMassOperator to the unit vectors
+     * so they are the same inverse the host schemes apply
+     *
+     * @tparam T the floating point type
+     * @tparam IDX the index type
+     */
+    template<class T, class IDX>
+    class DeviceInverseMass {
+        /// @brief the host inverse mass operator the blocks are formed from
+        TensorProductInverseMassOperator<T, IDX> inv_mass{};
+
+        /// @brief the row major inverse mass block of each element
+        util::device_array<T> blocks{};
+
+        /// @brief the offset of each element into blocks (size nelem + 1)
+        util::device_array<std::size_t> offsets{};
+
+        /// @brief the mesh coordinate version the blocks were formed for
+        std::size_t coord_version = 0;
+
+        public:
+
+        template<int ndim>
+        explicit DeviceInverseMass(FESpace<T, IDX, ndim>& fespace) { build(fespace); }
+
+        /// @brief form the blocks and copy them to the device
+        template<int ndim>
+        auto build(FESpace<T, IDX, ndim>& fespace) -> void {
+            inv_mass.build(fespace);
+            std::vector<std::size_t> offsets_h{0};
+            for(const auto& el : fespace.elements)
+                { offsets_h.push_back(offsets_h.back() + el.nbasis() * el.nbasis()); }
+            std::vector<T> blocks_h(offsets_h.back());
+            std::vector<T> unit(fespace.dg_map.max_el_size_reqirement(1)), column(unit.size()),
+                scratch(inv_mass.scratch_size());
+            for(const auto& el : fespace.elements){
+                const std::size_t ndof = el.nbasis();
+                T* block = blocks_h.data() + offsets_h[el.elidx];
+                for(std::size_t jdof = 0; jdof < ndof; ++jdof){
+                    std::fill_n(unit.begin(), ndof, 0.0);
+                    unit[jdof] = 1.0;
+                    inv_mass.element_apply(el.elidx, ndof, unit.data(), column.data(), scratch.data());
+                    for(std::size_t idof = 0; idof < ndof; ++idof) block[idof * ndof + jdof] = column[idof];
+                }
+            }
+            blocks.assign(blocks_h);
+            offsets.assign(offsets_h);
+            coord_version = fespace.meshptr->coord_version;
+        }
+
+        /// @brief form the blocks again only if the mesh has moved since the last build
+        template<int ndim>
+        auto update(FESpace<T, IDX, ndim>& fespace) -> void {
+            if(coord_version != fespace.meshptr->coord_version) build(fespace);
+        }
+
+        /**
+         * @brief a Runge-Kutta stage in the Shu-Osher form on the device
+         *   y = alpha * x + beta * w + gamma * M^{-1} res
+         * (y may be x but not w or res)
+         */
+        template<std::size_t nv>
+        auto stage(
+            T alpha,
+            const device_fespan<T, IDX, nv>& x,
+            T beta,
+            const device_fespan<T, IDX, nv>& w,
+            T gamma,
+            const device_fespan<T, IDX, nv>& res,
+            device_fespan<T, IDX, nv>& y
+        ) const -> void {
+            using span_t = device_fespan<T, IDX, nv>;
+            const IDX nelem = (IDX) res.nelem();
+            const IDX* el_offsets = res.offsets();
+            const T* x_data = x.data();
+            const T* w_data = w.data();
+            const T* res_data = res.data();
+            T* y_data = y.data();
+            const T* blocks_p = blocks.data();
+            const std::size_t* offsets_p = offsets.data();
+#ifdef ICEICLE_USE_DEVICE
+#pragma omp target teams distribute parallel for
+#endif
+            for(IDX iel = 0; iel < nelem; ++iel){
+                const IDX ndof = el_offsets[iel + 1] - el_offsets[iel];
+                const T* block = blocks_p + offsets_p[iel];
+                for(std::size_t iv = 0; iv < nv; ++iv){
+                    for(IDX idof = 0; idof < ndof; ++idof){
+                        T k = 0;
+                        for(IDX jdof = 0; jdof < ndof; ++jdof)
+                            { k += block[idof * ndof + jdof] * res_data[span_t::index(el_offsets, iel, jdof, iv)]; }
+                        std::size_t i = span_t::index(el_offsets, iel, idof, iv);
+                        y_data[i] = alpha * x_data[i] + beta * w_data[i] + gamma * k;
+                    }
+                }
+            }
+        }
+    };
+
+    /**
+     * @brief the timestep for a device time integrator
+     *
+     * CFLTimestep uses the element wavespeeds on the device (DeviceResidual::cfl_timestep)
+     * so they are always available (the residual is evaluated first if they are not current).
+     * Other timestep classes are evaluated on the host with the host mirror of the solution
+     * (which is not up to date, FixedTimestep only uses the timestep).
+     *
+     * @param timestep the timestep class
+     * @param residual the device residual evaluation
+     * @param fespace the finite element space
+     * @param disc the discretization
+     * @param u the solution on the device
+     * @param res storage for the residual on the device
+     * @return the timestep
+     */
+    template<class T, class IDX, int ndim, class disc_class, class TimestepClass>
+    auto device_timestep(
+        const TimestepClass &timestep,
+        DeviceResidual<T, IDX, ndim, disc_class> &residual,
+        FESpace<T, IDX, ndim> &fespace,
+        disc_class &disc,
+        device_fespan<T, IDX, disc_class::nv_comp> &u,
+        device_fespan<T, IDX, disc_class::nv_comp> &res
+    ) -> T {
+        if constexpr (std::same_as<TimestepClass, CFLTimestep<T, IDX>>) {
+            if(!residual.has_wavespeeds()) residual(fespace, disc, u, res);
+            return residual.cfl_timestep(fespace, disc, timestep.cfl);
+        } else {
+            return timestep(fespace, disc, u.host_view());
+        }
+    }
+
+    /**
+     * @brief Explicit 3-stage Strong Stability Preserving Runge-Kutta (see RK3SSP)
+     * with the solution, stages, and residual resident on the offload device
+     *
+     * The timestep is evaluated by device_timestep() (CFLTimestep on the device).
+     * vis_callback is where the solution is copied to the host (i.e u.copy_to_host() for PVDWriter output).
+     * The stage_limiter of RK3SSP is not supported.
+     *
+     * @tparam disc_class the discretization (with device_physics)
+     */
+    template<class T, class IDX, int ndim, class disc_class, class TimestepClass, class StopCondition>
+    class DeviceRK3SSP {
+        public:
+        using device_span = device_fespan<T, IDX, disc_class::nv_comp>;
+
+        /** The timestep determination */
+        TimestepClass timestep;
+
+        /** The termination criteria */
+        StopCondition stop_condition;
+
+        /// @brief the device residual evaluation
+        DeviceResidual<T, IDX, ndim, disc_class> residual;
+
+        /// @brief the inverse mass blocks on the device
+        DeviceInverseMass<T, IDX> inv_mass;
+
+        /// @brief the residual and stage solutions on the device
+        device_span res, u_stage, u_next;
+
+        /// @brief the current timestep
+        IDX itime = 0;
+
+        /// @brief the current time
+        T time = 0.0;
+
+        /// @brief the callback function for visualization during solve()
+        /// is given a reference to this and the device solution when called
+        /// default is to print out the l2 norm of the residual
+        std::function<void(DeviceRK3SSP &, device_span &)> vis_callback = [](DeviceRK3SSP &solver, device_span &){
+            std::cout << std::setprecision(8);
+            std::cout << "itime: " << std::setw(6) << solver.itime
+                << " | t: " << std::setw(14) << solver.time
+                << " | residual l2: " << std::setw(14) << solver.residual.l2_norm(solver.res)
+                << std::endl;
+        };
+
+        /// @brief if this is a positive integer
+        /// then the vis_callback will be called every ivis timesteps
+        /// (itime % ivis == 0)
+        IDX ivis = -1;
+
+        /**
+         * @brief create a DeviceRK3SSP solver and build the device tables
+         * @param fespace the finite element space
+         * @param disc the discretization
+         * @param timestep the class that determines the timestep
+         * @param stop_condition the termination condition
+         */
+        DeviceRK3SSP(
+            FESpace<T, IDX, ndim> &fespace,
+            disc_class &disc,
+            const TimestepClass &timestep,
+            const StopCondition &stop_condition
+        ) requires TerminationCondition<StopCondition>
+        : timestep{timestep}, stop_condition{stop_condition}, residual{fespace, disc}, inv_mass{fespace},
+          res{fespace.dg_map}, u_stage{fespace.dg_map}, u_next{fespace.dg_map} {}
+
+        /**
+         * @brief perform a single timestep
+         * @param [in] fespace the finite element space
+         * @param [in] disc the discretization
+         * @param [in/out] u the solution on the device
+         */
+        void step(FESpace<T, IDX, ndim> &fespace, disc_class &disc, device_span &u) {
+            T dt = device_timestep(timestep, residual, fespace, disc, u, res);
+            dt = stop_condition.limit_dt(dt, time);
+            inv_mass.update(fespace);
+
+            // y = alpha * u + beta * w + gamma * dt * M^{-1} R(w)
+            auto stage = [&](device_span& w, T alpha, T beta, T gamma, device_span& y){
+                residual(fespace, disc, w, res);
+                inv_mass.stage(alpha, u, beta, w, gamma * dt, res, y);
+            };
+            stage(u, 0.0, 1.0, 1.0, u_stage);
+            stage(u_stage, 0.75, 0.25, 0.25, u_next);
+            stage(u_next, 1.0 / 3.0, 2.0 / 3.0, 2.0 / 3.0, u);
+
+            itime++;
+            time += dt;
+        }
+
+        /**
+         * @brief perform timesteps until the stop condition is reached
+         * @param [in] fespace the finite element space
+         * @param [in] disc the discretization
+         * @param [in/out] u the solution on the device
+         */
+        void solve(FESpace<T, IDX, ndim> &fespace, disc_class &disc, device_span &u) {
+            // call initial residual to get initial wavespeeds for dt
+            residual(fespace, disc, u, res);
+            vis_callback(*this, u);
+            while(!stop_condition(itime, time)){
+                step(fespace, disc, u);
+                if(itime % ivis == 0) vis_callback(*this, u);
+            }
+            vis_callback(*this, u);
+        }
+    };
+
+    template<class T, class IDX, int ndim, class disc_class, class TimestepClass, class StopCondition>
+    DeviceRK3SSP(FESpace<T, IDX, ndim> &, disc_class &, const TimestepClass &, const StopCondition &)
+        -> DeviceRK3SSP<T, IDX, ndim, disc_class, TimestepClass, StopCondition>;
+
+    /**
+     * @brief Explicit 3-stage Total Variation Diminishing Runge-Kutta (see RK3TVD)
+     * with the solution, stages, and residual resident on the offload device
+     * (the same host interaction as DeviceRK3SSP)
+     *
+     * @tparam disc_class the discretization (with device_physics)
+     */
+    template<class T, class IDX, int ndim, class disc_class, class TimestepClass, class StopCondition>
+    class DeviceRK3TVD {
+        public:
+        using device_span = device_fespan<T, IDX, disc_class::nv_comp>;
+
+        /** The timestep determination */
+        TimestepClass timestep;
+
+        /** The termination criteria */
+        StopCondition stop_condition;
+
+        /// @brief the device residual evaluation
+        DeviceResidual<T, IDX, ndim, disc_class> residual;
+
+        /// @brief the inverse mass blocks on the device
+        DeviceInverseMass<T, IDX> inv_mass;
+
+        /// @brief the residual and stage solutions on the device
+        device_span res, u_stage, u_next;
+
+        /// @brief the current timestep
+        IDX itime = 0;
+
+        /// @brief the current time
+        T time = 0.0;
+
+        /// @brief the callback function for visualization during solve()
+        /// is given a reference to this and the device solution when called
+        /// default is to print out the l2 norm of the residual
+        std::function<void(DeviceRK3TVD &, device_span &)> vis_callback = [](DeviceRK3TVD &solver, device_span &){
+            std::cout << std::setprecision(8);
+            std::cout << "itime: " << std::setw(6) << solver.itime
+                << " | t: " << std::setw(14) << solver.time
+                << " | residual l2: " << std::setw(14) << solver.residual.l2_norm(solver.res)
+                << std::endl;
+        };
+
+        /// @brief if this is a positive integer
+        /// then the vis_callback will be called every ivis timesteps
+        /// (itime % ivis == 0)
+        IDX ivis = -1;
+
+        /**
+         * @brief create a DeviceRK3TVD solver and build the device tables
+         * @param fespace the finite element space
+         * @param disc the discretization
+         * @param timestep the class that determines the timestep
+         * @param stop_condition the termination condition
+         */
+        DeviceRK3TVD(
+            FESpace<T, IDX, ndim> &fespace,
+            disc_class &disc,
+            const TimestepClass &timestep,
+            const StopCondition &stop_condition
+        ) requires TerminationCondition<StopCondition>
+        : timestep{timestep}, stop_condition{stop_condition}, residual{fespace, disc}, inv_mass{fespace},
+          res{fespace.dg_map}, u_stage{fespace.dg_map}, u_next{fespace.dg_map} {}
+
+        /**
+         * @brief perform a single timestep
+         * @param [in] fespace the finite element space
+         * @param [in] disc the discretization
+         * @param [in/out] u the solution on the device
+         */
+        void step(FESpace<T, IDX, ndim> &fespace, disc_class &disc, device_span &u) {
+            T dt = device_timestep(timestep, residual, fespace, disc, u, res);
+            dt = stop_condition.limit_dt(dt, time);
+            inv_mass.update(fespace);
+
+            // y = alfa * u + beta * w + beta * dt * M^{-1} R(w) (the 3 stage coefficients of RK3TVD)
+            auto stage = [&](device_span& w, T alfa, T beta, device_span& y){
+                residual(fespace, disc, w, res);
+                inv_mass.stage(alfa, u, beta, w, beta * dt, res, y);
+            };
+            stage(u, 0.0, 1.0, u_stage);
+            stage(u_stage, 0.75, 0.25, u_next);
+            stage(u_next, 1.0 / 3.0, 2.0 / 3.0, u);
+
+            itime++;
+            time += dt;
+        }
+
+        /**
+         * @brief perform timesteps until the stop condition is reached
+         * @param [in] fespace the finite element space
+         * @param [in] disc the discretization
+         * @param [in/out] u the solution on the device
+         */
+        void solve(FESpace<T, IDX, ndim> &fespace, disc_class &disc, device_span &u) {
+            // call initial residual to get initial wavespeeds for dt
+            residual(fespace, disc, u, res);
+            vis_callback(*this, u);
+            while(!stop_condition(itime, time)){
+                step(fespace, disc, u);
+                if(itime % ivis == 0) vis_callback(*this, u);
+            }
+            vis_callback(*this, u);
+        }
+    };
+
+    template<class T, class IDX, int ndim, class disc_class, class TimestepClass, class StopCondition>
+    DeviceRK3TVD(FESpace<T, IDX, ndim> &, disc_class &, const TimestepClass &, const StopCondition &)
+        -> DeviceRK3TVD<T, IDX, ndim, disc_class, TimestepClass, StopCondition>;
+}
@@ -0,0 +1,196 @@
+/**
+ * @brief tracking of the elements whose residual can be skipped
+ * (i.e uniform far field regions that stay at the freestream state)
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/crs.hpp"
+#include "iceicle/element/finite_element.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/geometry/face.hpp"
+#include "iceicle/thread_utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace iceicle::solvers {
+
+    /**
+     * @brief marks elements inactive when their state and residual stay within tolerance of their neighbors
+     * (across interior and periodic faces)
+     * so form_residual can skip them
+     *
+     * Every recheck_interval residual evaluations the element average states are recomputed and
+     * - an active element is deactivated if the largest magnitude of its residual coefficients is at most residual_tol
+     *   and its average state is within state_tol (in every component) of the average state of each face neighbor
+     * - an inactive element is reactivated if its average state is no longer within state_tol of a face neighbor
+     *   (a neighbor changed)
+     *
+     * form_residual skips the domain integral of inactive elements and the traces between two inactive elements,
+     * and does not scatter to inactive elements, so their residual is zero and explicit schemes leave them
+     * at their current state. Traces between an active and an inactive element are still integrated for the active side.
+     * Elements on process boundaries, elements with a physical boundary face other than extrapolation
+     * (the boundary values may change in time, i.e Dirichlet or inflow conditions),
+     * and elements with a source term (if pin_sources) are always active (pinned):
+     * an inactive element only sees changes through the states of its neighbors.
+     *
+     * NOTE: a disturbance must not cross an inactive element between rechecks,
+     * so recheck_interval should be small compared to the number of residual evaluations
+     * that a wave takes to cross an element (i.e a few timesteps)
+     *
+     * @tparam T the floating point type
+     * @tparam IDX the index type
+     */
+    template<class T, class IDX>
+    class ElementActivity {
+
+        /// @brief the number of vector components (0 when disabled)
+        std::size_t nv = 0;
+
+        /// @brief for each element, nonzero if active
+        std::vector<char> active_flags{};
+
+        /// @brief for each element, nonzero if it can never be deactivated (process boundaries)
+        std::vector<char> pinned{};
+
+        /// @brief the face neighbors of each element
+        util::crs<IDX, IDX> neighbors{};
+
+        /// @brief the element average states from the last recheck [nelem x nv]
+        std::vector<T> means{};
+
+        /// @brief the number of residual evaluations since enable()
+        std::size_t ncall = 0;
+
+        public:
+
+        /// @brief the largest residual coefficient magnitude of an element that can be deactivated
+        T residual_tol = 1e-10;
+
+        /// @brief the largest difference in the average state of neighboring elements that can be inactive
+        T state_tol = 1e-10;
+
+        /// @brief the number of residual evaluations between rechecks of the element activity
+        std::size_t recheck_interval = 10;
+
+        /// @brief the number of inactive elements after the last recheck
+        IDX ninactive = 0;
+
+        ElementActivity() = default;
+
+        /**
+         * @brief start tracking the element activity (all elements start active)
+         * @param fespace the finite element space
+         * @param ncomp the number of vector components of the solution
+         * @param is_parallel_com_element for each element true if it is on a process boundary
+         * @param pin_sources if every element is pinned because the discretization has a source term
+         */
+        template<int ndim>
+        void enable(FESpace<T, IDX, ndim>& fespace, std::size_t ncomp,
+                const std::vector<char>& is_parallel_com_element, bool pin_sources = false) {
+            nv = ncomp;
+            const std::size_t nelem = fespace.elements.size();
+            active_flags.assign(nelem, 1);
+            pinned = is_parallel_com_element;
+            pinned.resize(nelem, 0);
+            if(pin_sources) std::ranges::fill(pinned, 1);
+            std::vector<std::vector<IDX>> adjacent(nelem);
+            for(const auto& trace : fespace.get_interior_traces()){
+                adjacent[trace.elL.elidx].push_back(trace.elR.elidx);
+                adjacent[trace.elR.elidx].push_back(trace.elL.elidx);
+            }
+            // periodic traces are boundary traces of both elements
+            for(std::size_t itrace = fespace.bdy_trace_start; itrace < fespace.bdy_trace_end; ++itrace){
+                const auto& trace = fespace.traces[itrace];
+                if(trace.face->bctype == BOUNDARY_CONDITIONS::PERIODIC)
+                    { adjacent[trace.elL.elidx].push_back(trace.elR.elidx); }
+                else if(trace.face->bctype != BOUNDARY_CONDITIONS::EXTRAPOLATION
+                        && trace.face->bctype != BOUNDARY_CONDITIONS::PARALLEL_COM)
+                    { pinned[trace.elL.elidx] = 1; }
+            }
+            neighbors = util::crs<IDX, IDX>{adjacent};
+            means.assign(nelem * nv, 0.0);
+            ncall = 0;
+            ninactive = 0;
+        }
+
+        /// @brief stop tracking (every element is active)
+        void disable() {
+            nv = 0;
+            active_flags.clear();
+            ninactive = 0;
+        }
+
+        /// @brief if the element activity is tracked
+        [[nodiscard]] auto enabled() const noexcept -> bool { return nv > 0; }
+
+        /// @brief if the residual of the given element is formed
+        [[nodiscard]] auto active(IDX iel) const noexcept -> bool
+        { return nv == 0 || active_flags[iel]; }
+
+        /**
+         * @brief count a residual evaluation and recheck the element activity if it is due
+         * @param fespace the finite element space
+         * @param u the solution the residual was formed from
+         * @param res the residual (zero on the inactive elements)
+         */
+        template<int ndim, class uLayoutPolicy, class uAccessorPolicy, class resLayoutPolicy>
+        void update(
+            FESpace<T, IDX, ndim>& fespace,
+            fespan<T, uLayoutPolicy, uAccessorPolicy> u,
+            fespan<T, resLayoutPolicy> res
+        ) {
+            if(!enabled() || ncall++ % std::max(recheck_interval, (std::size_t) 1) != 0) return;
+            const std::size_t nelem = fespace.elements.size();
+
+            // the element average states
+            util::parallel_for(nelem, [&](std::size_t iel){
+                const FiniteElement<T, IDX, ndim>& el = fespace.elements[iel];
+                T* ubar = means.data() + iel * nv;
+                std::fill_n(ubar, nv, 0.0);
+                QPGeometry geo{el};
+                T vol = 0;
+                for(int iqp = 0; iqp < el.nQP(); ++iqp){
+                    T dvol = geo[iqp].dvol;
+                    vol += dvol;
+                    auto bi = el.eval_basis_qp(iqp);
+                    for(int ibasis = 0; ibasis < el.nbasis(); ++ibasis){
+                        for(std::size_t iv = 0; iv < nv; ++iv) ubar[iv] += dvol * bi[ibasis] * u[iel, ibasis, iv];
+                    }
+                }
+                if(vol > 0) for(std::size_t iv = 0; iv < nv; ++iv) ubar[iv] /= vol;
+            });
+
+            auto state_close = [&](std::size_t iel){
+                for(IDX jel : neighbors.rowspan(iel)){
+                    for(std::size_t iv = 0; iv < nv; ++iv){
+                        if(!(std::abs(means[iel * nv + iv] - means[jel * nv + iv]) <= state_tol)) return false;
+                    }
+                }
+                return true;
+            };
+
+            // decide from the flags of the previous recheck so the result does not depend on the element order
+            std::vector<char> next_flags(nelem);
+            util::parallel_for(nelem, [&](std::size_t iel){
+                if(pinned[iel]) { next_flags[iel] = 1; return; }
+                bool close = state_close(iel);
+                if(active_flags[iel]){
+                    T res_max = 0;
+                    for(std::size_t idof = 0; idof < res.ndof(iel); ++idof){
+                        for(std::size_t iv = 0; iv < nv; ++iv) res_max = std::max(res_max, std::abs(res[iel, idof, iv]));
+                    }
+                    next_flags[iel] = !(close && res_max <= residual_tol);
+                } else {
+                    next_flags[iel] = !close;
+                }
+            });
+            active_flags = std::move(next_flags);
+            ninactive = (IDX) std::ranges::count(active_flags, 0);
+        }
+    };
+}
@@ -0,0 +1,305 @@
+/**
+ * @brief element block Jacobi preconditioner from the element diagonal jacobian blocks
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/fd_utils.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/form_petsc_jacobian.hpp"
+#include "iceicle/linalg/small_dense.hpp"
+#include <mdspan/mdspan.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace iceicle::solvers {
+
+    /**
+     * @brief block diagonal inverse of the DG jacobian
+     *
+     * The diagonal block of each element is dR_el / du_el: the domain integral
+     * plus the self coupling of every trace around the element.
+     * These are computed with the analytic element jacobians of the discretization when
+     * provided (see form_petsc_jacobian_fd) and element local finite differences otherwise,
+     * then inverted and stored contiguously so that applying the preconditioner
+     * is a dense matrix-vector product per element.
+     *
+     * Only the element blocks are stored, so the memory is that of the diagonal of the full jacobian
+     *
+     * With single_precision set the blocks are formed and inverted in T and then stored as float,
+     * halving the storage and the memory traffic of apply() (the products are still accumulated in T).
+     * Pair this with iterative refinement of the outer linear solve (see petsc::refined_solve)
+     *
+     * @tparam T the floating point type
+     * @tparam IDX the index type
+     */
+    template<typename T, typename IDX>
+    class ElementBlockJacobi {
+        private:
+
+        /// @brief the inverse diagonal block entries for each element (row major)
+        /// rows and columns are the compact element dof indices (vector component fastest)
+        std::vector<T> binv_data{};
+
+        /// @brief the inverse diagonal blocks in single precision (used instead of binv_data when single_precision)
+        std::vector<float> binv_data_sp{};
+
+        /// @brief the offset of the start of each element inverse block (size = nelem + 1)
+        std::vector<std::size_t> offsets{0};
+
+        /// @brief out = D^{-1} res with the inverse blocks stored in type S
+        template<class S, class resType, class outType>
+        auto apply_blocks(const S* binv_base, resType res, outType out) const -> void {
+            const std::size_t nv = res.nv();
+            for(IDX iel = 0; iel < (IDX) offsets.size() - 1; ++iel){
+                const std::size_t ndof = res.ndof(iel);
+                const std::size_t n = ndof * nv;
+                const S* binv = binv_base + offsets[iel];
+                for(std::size_t idof = 0; idof < ndof; ++idof){
+                    for(std::size_t iv = 0; iv < nv; ++iv){
+                        const S* row = binv + (idof * nv + iv) * n;
+                        T sum = 0;
+                        for(std::size_t jdof = 0; jdof < ndof; ++jdof){
+                            for(std::size_t jv = 0; jv < nv; ++jv)
+                                { sum += static_cast<T>(row[jdof * nv + jv]) * res[iel, jdof, jv]; }
+                        }
+                        out[iel, idof, iv] = sum;
+                    }
+                }
+            }
+        }
+
+        public:
+
+        /// @brief store the inverse blocks in single precision (takes effect on the next build())
+        bool single_precision = false;
+
+        /// @brief default constructor: empty preconditioner (must be built before use)
+        ElementBlockJacobi() = default;
+
+        /**
+         * @brief compute and invert the element diagonal jacobian blocks at the state u
+         * On a singular block the identity is used and an anomaly is logged
+         *
+         * @param fespace the finite element space
+         * @param disc the discretization
+         * @param u the solution to linearize about
+         * @param epsilon (optional) the epsilon to use for finite difference
+         *                NOTE: this gets scaled by the norm of the compact residual vector
+         */
+        template<int ndim, class disc_class, class uLayoutPolicy, class uAccessorPolicy>
+        auto build(
+            FESpace<T, IDX, ndim>& fespace,
+            disc_class& disc,
+            fespan<T, uLayoutPolicy, uAccessorPolicy> u,
+            T epsilon = std::sqrt(std::numeric_limits<T>::epsilon())
+        ) -> void {
+            using Element = FiniteElement<T, IDX, ndim>;
+            using Trace = TraceSpace<T, IDX, ndim>;
+            using namespace std::experimental;
+
+            const std::size_t ncomp = disc_class::dnv_comp;
+            const std::size_t max_local_size =
+                fespace.dg_map.max_el_size_reqirement(ncomp);
+
+            // the uninverted blocks are formed in place
+            offsets.resize(fespace.elements.size() + 1);
+            offsets[0] = 0;
+            for(const Element& el : fespace.elements){
+                std::size_t n = el.nbasis() * ncomp;
+                offsets[el.elidx + 1] = offsets[el.elidx] + n * n;
+            }
+            binv_data.assign(offsets.back(), 0.0);
+
+            // storage for local solutions, residuals, and jacobians
+            std::vector<T> uL_data(max_local_size);
+            std::vector<T> uR_data(max_local_size);
+            std::vector<T> resL_data(max_local_size);
+            std::vector<T> resLp_data(max_local_size);
+            std::vector<T> resR_data(max_local_size);
+            std::vector<T> resRp_data(max_local_size);
+            std::vector<T> jacLL_data(max_local_size * max_local_size);
+            std::vector<T> jacLR_data(max_local_size * max_local_size);
+            std::vector<T> jacRL_data(max_local_size * max_local_size);
+            std::vector<T> jacRR_data(max_local_size * max_local_size);
+
+            // types for the compact views to detect analytic jacobians
+            using compact_uspan_t = decltype(dofspan{uL_data.data(), u.create_element_layout(0)});
+            using compact_jac_t = decltype(mdspan{jacLL_data.data(), extents{max_local_size, max_local_size}});
+            using coord_t = decltype(fespace.meshptr->coord);
+
+            // view of the diagonal block of an element
+            auto block = [&](IDX iel){
+                std::size_t n = fespace.elements[iel].nbasis() * ncomp;
+                return mdspan{binv_data.data() + offsets[iel], extents{n, n}};
+            };
+            auto add_block = [](auto blk, auto jac){
+                for(std::size_t i = 0; i < jac.extent(0); ++i){
+                    for(std::size_t j = 0; j < jac.extent(1); ++j)
+                        { blk[i, j] += jac[i, j]; }
+                }
+            };
+
+            // finite difference of the compact residual res(ujac) wrt ujac added to blk
+            auto fd_block = [&](auto&& res_op, auto ujac, auto res, auto resp, auto blk){
+                T eps_scaled = scale_fd_epsilon(epsilon, res.vector_norm());
+                for(IDX idofu = 0; idofu < ujac.ndof(); ++idofu){
+                    for(IDX iequ = 0; iequ < ncomp; ++iequ){
+                        IDX jcol = ujac.get_layout()[idofu, iequ];
+                        T old_val = ujac[idofu, iequ];
+                        ujac[idofu, iequ] += eps_scaled;
+                        resp = 0;
+                        res_op(resp);
+                        for(IDX idoff = 0; idoff < res.ndof(); ++idoff){
+                            for(IDX ieqf = 0; ieqf < ncomp; ++ieqf){
+                                IDX irow = res.get_layout()[idoff, ieqf];
+                                blk[irow, jcol] += (resp[idoff, ieqf] - res[idoff, ieqf]) / eps_scaled;
+                            }
+                        }
+                        ujac[idofu, iequ] = old_val;
+                    }
+                }
+            };
+
+            // boundary faces
+            for(const Trace& trace : fespace.get_boundary_traces()) {
+                if(trace.face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) continue;
+                dofspan uL{uL_data.data(), u.create_element_layout(trace.elL.elidx)};
+                dofspan uR{uR_data.data(), u.create_element_layout(trace.elR.elidx)};
+                dofspan resL{resL_data.data(), u.create_element_layout(trace.elL.elidx)};
+                dofspan resLp{resLp_data.data(), u.create_element_layout(trace.elL.elidx)};
+                extract_elspan(trace.elL.elidx, u, uL);
+                extract_elspan(trace.elR.elidx, u, uR);
+
+                bool analytic_jac = false;
+                if constexpr (provides_boundary_jacobian<disc_class, Trace, coord_t, compact_uspan_t, compact_jac_t>) {
+                    mdspan jacL{jacLL_data.data(), extents{resL.size(), uL.size()}};
+                    std::fill_n(jacLL_data.begin(), jacL.size(), 0);
+                    analytic_jac = disc.boundary_integral_jacobian(trace, fespace.meshptr->coord, uL, uR, jacL);
+                    if(analytic_jac) add_block(block(trace.elL.elidx), jacL);
+                }
+                if(!analytic_jac){
+                    resL = 0;
+                    disc.boundaryIntegral(trace, fespace.meshptr->coord, uL, uR, resL);
+                    fd_block([&](auto resp){
+                        disc.boundaryIntegral(trace, fespace.meshptr->coord, uL, uR, resp);
+                    }, uL, resL, resLp, block(trace.elL.elidx));
+                }
+            }
+
+            // interior faces: only the self coupling of each side
+            for(const Trace& trace : fespace.get_interior_traces()) {
+                dofspan uL{uL_data.data(), u.create_element_layout(trace.elL.elidx)};
+                dofspan uR{uR_data.data(), u.create_element_layout(trace.elR.elidx)};
+                dofspan resL{resL_data.data(), u.create_element_layout(trace.elL.elidx)};
+                dofspan resLp{resLp_data.data(), u.create_element_layout(trace.elL.elidx)};
+                dofspan resR{resR_data.data(), u.create_element_layout(trace.elR.elidx)};
+                dofspan resRp{resRp_data.data(), u.create_element_layout(trace.elR.elidx)};
+                extract_elspan(trace.elL.elidx, u, uL);
+                extract_elspan(trace.elR.elidx, u, uR);
+
+                if constexpr (provides_trace_jacobian<disc_class, Trace, coord_t, compact_uspan_t, compact_jac_t>) {
+                    mdspan jacLL{jacLL_data.data(), extents{resL.size(), uL.size()}};
+                    mdspan jacRL{jacRL_data.data(), extents{resR.size(), uL.size()}};
+                    mdspan jacLR{jacLR_data.data(), extents{resL.size(), uR.size()}};
+                    mdspan jacRR{jacRR_data.data(), extents{resR.size(), uR.size()}};
+                    std::fill_n(jacLL_data.begin(), jacLL.size(), 0);
+                    std::fill_n(jacRL_data.begin(), jacRL.size(), 0);
+                    std::fill_n(jacLR_data.begin(), jacLR.size(), 0);
+                    std::fill_n(jacRR_data.begin(), jacRR.size(), 0);
+                    disc.trace_integral_jacobian(trace, fespace.meshptr->coord, uL, uR,
+                            jacLL, jacLR, jacRL, jacRR);
+                    add_block(block(trace.elL.elidx), jacLL);
+                    add_block(block(trace.elR.elidx), jacRR);
+                } else {
+                    resL = 0;
+                    resR = 0;
+                    disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, resL, resR);
+
+                    // the residual on the side not being differentiated is discarded
+                    fd_block([&](auto resp){
+                        dofspan resRd{resRp_data.data(), u.create_element_layout(trace.elR.elidx)};
+                        resRd = 0;
+                        disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, resp, resRd);
+                    }, uL, resL, resLp, block(trace.elL.elidx));
+                    fd_block([&](auto resp){
+                        dofspan resLd{resLp_data.data(), u.create_element_layout(trace.elL.elidx)};
+                        resLd = 0;
+                        disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, resLd, resp);
+                    }, uR, resR, resRp, block(trace.elR.elidx));
+                }
+            }
+
+            // domain integral
+            for(const Element& el : fespace.elements) {
+                dofspan u_el{uL_data.data(), u.create_element_layout(el.elidx)};
+                dofspan res_el{resL_data.data(), u.create_element_layout(el.elidx)};
+                dofspan resp_el{resLp_data.data(), u.create_element_layout(el.elidx)};
+                mdspan jac_el{jacLL_data.data(), extents{res_el.size(), u_el.size()}};
+                extract_elspan(el.elidx, u, u_el);
+
+                if constexpr (provides_domain_jacobian<disc_class, Element, decltype(u_el), decltype(jac_el)>) {
+                    std::fill_n(jacLL_data.begin(), jac_el.size(), 0);
+                    disc.domain_integral_jacobian(el, u_el, jac_el);
+                    add_block(block(el.elidx), jac_el);
+                } else {
+                    res_el = 0;
+                    disc.domain_integral(el, u_el, res_el);
+                    fd_block([&](auto resp){ disc.domain_integral(el, u_el, resp); },
+                        u_el, res_el, resp_el, block(el.elidx));
+                }
+            }
+
+            // invert the blocks in place
+            std::vector<linalg::pivot_index> piv{};
+            std::vector<T> work{};
+            for(const Element& el : fespace.elements){
+                const std::size_t n = el.nbasis() * ncomp;
+                T* binv = binv_data.data() + offsets[el.elidx];
+                piv.resize(n);
+                work.resize(n * n);
+                bool inverted = linalg::dispatch_basis_size(n, [&](auto N) -> bool {
+                    return linalg::lu_invert<decltype(N)::value>(binv, piv.data(), work.data(), n);
+                });
+                if(!inverted){
+                    // set to Identity on failure and log anomaly
+                    std::fill_n(binv, n * n, 0.0);
+                    for(std::size_t i = 0; i < n; ++i)
+                        { binv[i * n + i] = 1.0; }
+                    util::AnomalyLog::log_record("Singular jacobian block encountered on element ", el.elidx);
+                }
+            }
+
+            // demote the inverse blocks and release the working precision storage
+            if(single_precision){
+                binv_data_sp.assign(binv_data.begin(), binv_data.end());
+                binv_data.clear();
+                binv_data.shrink_to_fit();
+            } else {
+                binv_data_sp.clear();
+                binv_data_sp.shrink_to_fit();
+            }
+        }
+
+        /**
+         * @brief apply the preconditioner
+         * out = D^{-1} res where D is the block diagonal of the jacobian
+         *
+         * NOTE: res and out must not overlap
+         *
+         * @param [in] res the global residual
+         * @param [out] out the global preconditioned residual
+         */
+        template<class resLayoutPolicy, class resAccessorPolicy, class outLayoutPolicy, class outAccessorPolicy>
+        auto apply(
+            fespan<T, resLayoutPolicy, resAccessorPolicy> res,
+            fespan<T, outLayoutPolicy, outAccessorPolicy> out
+        ) const -> void {
+            if(!binv_data_sp.empty()) apply_blocks(binv_data_sp.data(), res, out);
+            else apply_blocks(binv_data.data(), res, out);
+        }
+    };
+}
@@ -0,0 +1,216 @@
+/**
+ * @brief sampled measurement of the residual cost of each element
+ * for load imbalance diagnosis and repartition weights
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <ios>
+#include <ostream>
+#include <vector>
+#ifdef ICEICLE_USE_MPI
+#include <mpi.h>
+#endif
+
+namespace iceicle::solvers {
+
+    /**
+     * @brief accumulates the wall time form_residual spends on each element
+     * every sample_interval residual evaluations (the other evaluations are not timed)
+     *
+     * On a sampled evaluation each element is charged
+     * - the time of its domain integral
+     * - the time of the physical boundary traces and process boundary traces it is the local element of
+     * - half the time of each interior trace it is on
+     *   (in the element-centric traversal, the interior traces it is the left element of)
+     *
+     * and the time of the boundary trace, interior and domain, and parallel trace phases is accumulated.
+     * Every element is charged by the single thread that integrates it.
+     * The element costs are the mean seconds per sampled evaluation (see seconds).
+     *
+     * @tparam T the floating point type
+     * @tparam IDX the index type
+     */
+    template<class T, class IDX>
+    class ElementCost {
+        public:
+        using clock = std::chrono::steady_clock;
+
+        /// @brief the phases of form_residual that are timed
+        static constexpr int nphase = 3;
+
+        /// @brief the names of the phases for the summary
+        static constexpr std::array<const char*, nphase> phase_names{
+            "boundary_traces", "interior_and_domain", "parallel_traces"};
+
+        private:
+        /// @brief the accumulated seconds charged to each element (empty when disabled)
+        std::vector<double> el_seconds{};
+
+        /// @brief the accumulated seconds of each phase
+        std::array<double, nphase> phase_seconds{};
+
+        /// @brief the number of residual evaluations since enable()
+        std::size_t ncall = 0;
+
+        /// @brief if the current residual evaluation is timed
+        bool sampled_ = false;
+
+        public:
+
+        /// @brief the number of residual evaluations between timed evaluations
+        std::size_t sample_interval = 10;
+
+        /// @brief the number of timed residual evaluations
+        std::size_t nsample = 0;
+
+        ElementCost() = default;
+
+        /**
+         * @brief start measuring the element costs (clears previous measurements)
+         * @param nelem the number of elements on this process
+         */
+        void enable(std::size_t nelem) {
+            el_seconds.assign(nelem, 0.0);
+            phase_seconds.fill(0.0);
+            ncall = 0;
+            nsample = 0;
+            sampled_ = false;
+        }
+
+        /// @brief stop measuring and discard the measurements
+        void disable() {
+            el_seconds.clear();
+            sampled_ = false;
+        }
+
+        /// @brief if the element costs are measured
+        [[nodiscard]] auto enabled() const noexcept -> bool { return !el_seconds.empty(); }
+
+        /// @brief count a residual evaluation and decide if it is timed
+        void begin_evaluation() noexcept {
+            sampled_ = enabled() && ncall++ % std::max(sample_interval, (std::size_t) 1) == 0;
+            if(sampled_) ++nsample;
+        }
+
+        /// @brief if the current residual evaluation is timed
+        [[nodiscard]] auto sampled() const noexcept -> bool { return sampled_; }
+
+        /// @brief the time point to measure from (only call on a sampled evaluation)
+        [[nodiscard]] static auto now() noexcept -> clock::time_point { return clock::now(); }
+
+        /// @brief the seconds since start
+        [[nodiscard]] static auto elapsed(clock::time_point start) noexcept -> double
+        { return std::chrono::duration<double>(clock::now() - start).count(); }
+
+        /// @brief charge the given seconds to the element
+        void charge(IDX iel, double seconds) noexcept { el_seconds[iel] += seconds; }
+
+        /// @brief add the given seconds to the phase
+        void charge_phase(int iphase, double seconds) noexcept { phase_seconds[iphase] += seconds; }
+
+        /// @brief the mean seconds per sampled evaluation charged to the given element
+        [[nodiscard]] auto seconds(IDX iel) const noexcept -> double
+        { return (nsample > 0) ? el_seconds[iel] / nsample : 0.0; }
+
+        /// @brief the mean seconds per sampled evaluation of the given phase on this process
+        [[nodiscard]] auto phase(int iphase) const noexcept -> double
+        { return (nsample > 0) ? phase_seconds[iphase] / nsample : 0.0; }
+
+        /**
+         * @brief write the element costs as a field (i.e for PVDWriter::register_fields)
+         * every degree of freedom and component of an element is set to its cost in seconds
+         * @param field the field over the elements of the measured space
+         */
+        template<class LayoutPolicy, class AccessorPolicy>
+        void fill_field(fespan<T, LayoutPolicy, AccessorPolicy> field) const {
+            for(IDX iel = 0; iel < (IDX) el_seconds.size(); ++iel){
+                T cost = (T) seconds(iel);
+                for(std::size_t idof = 0; idof < field.ndof(iel); ++idof){
+                    for(std::size_t iv = 0; iv < field.nv(); ++iv) field[iel, idof, iv] = cost;
+                }
+            }
+        }
+
+        /**
+         * @brief integer element weights proportional to the element costs for the graph partitioner
+         * (i.e partition_weights::el_weights or the measured cost for repartition)
+         * scaled so the most expensive element over all processes has max_weight
+         * (every element has a weight of at least 1)
+         *
+         * NOTE: collective when MPI is initialized
+         *
+         * @param max_weight the weight of the most expensive element
+         * @return the weight of each element on this process
+         */
+        [[nodiscard]] auto partition_weights(IDX max_weight = 1000) const -> std::vector<IDX> {
+            double max_seconds = 0;
+            for(double s : el_seconds) max_seconds = std::max(max_seconds, s);
+#ifdef ICEICLE_USE_MPI
+            if(mpi::mpi_initialized())
+                MPI_Allreduce(MPI_IN_PLACE, &max_seconds, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+#endif
+            std::vector<IDX> weights(el_seconds.size(), 1);
+            if(max_seconds > 0) for(std::size_t iel = 0; iel < el_seconds.size(); ++iel){
+                weights[iel] = std::max((IDX) 1, (IDX) std::lround(max_weight * el_seconds[iel] / max_seconds));
+            }
+            return weights;
+        }
+
+        /**
+         * @brief print the mean, maximum, and imbalance (maximum / mean) over the processes
+         * of the measured seconds per evaluation of each phase and the element total on rank 0
+         * with the most expensive process
+         *
+         * NOTE: collective when MPI is initialized
+         *
+         * @param out the stream to print to
+         */
+        void print_imbalance_summary(std::ostream& out) const {
+            constexpr int nrec = nphase + 1;
+            std::array<double, nrec> local{};
+            for(int iphase = 0; iphase < nphase; ++iphase) local[iphase] = phase(iphase);
+            for(IDX iel = 0; iel < (IDX) el_seconds.size(); ++iel) local[nphase] += seconds(iel);
+
+            int myrank = mpi::mpi_world_rank();
+            int nrank = std::max(mpi::mpi_world_size(), 1);
+            std::array<double, nrec> sum = local, max = local;
+            std::array<int, nrec> max_rank{};
+#ifdef ICEICLE_USE_MPI
+            if(mpi::mpi_initialized()) {
+                MPI_Allreduce(MPI_IN_PLACE, sum.data(), nrec, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+                struct { double value; int rank; } loc[nrec];
+                for(int i = 0; i < nrec; ++i) loc[i] = {local[i], myrank};
+                MPI_Allreduce(MPI_IN_PLACE, loc, nrec, MPI_DOUBLE_INT, MPI_MAXLOC, MPI_COMM_WORLD);
+                for(int i = 0; i < nrec; ++i) { max[i] = loc[i].value; max_rank[i] = loc[i].rank; }
+            }
+#endif
+            if(myrank != 0) return;
+            std::ios_base::fmtflags flags = out.flags();
+            std::streamsize precision = out.precision();
+            out << "element cost: " << nsample << " sampled residual evaluations on " << nrank << " processes"
+                << " (seconds per evaluation)" << std::endl;
+            out << std::setw(22) << std::left << "phase" << std::right
+                << std::setw(14) << "mean" << std::setw(14) << "max" << std::setw(8) << "rank"
+                << std::setw(12) << "imbalance" << std::endl;
+            for(int i = 0; i < nrec; ++i){
+                double mean = sum[i] / nrank;
+                out << std::setw(22) << std::left << ((i < nphase) ? phase_names[i] : "elements") << std::right
+                    << std::scientific << std::setprecision(4)
+                    << std::setw(14) << mean << std::setw(14) << max[i] << std::setw(8) << max_rank[i]
+                    << std::fixed << std::setprecision(3)
+                    << std::setw(12) << ((mean > 0) ? max[i] / mean : 1.0) << std::endl;
+            }
+            out.flags(flags);
+            out.precision(precision);
+        }
+    };
+}
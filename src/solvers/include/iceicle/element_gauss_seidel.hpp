@@ -0,0 +1,353 @@
+/**
+ * @brief nonlinear element block Gauss-Seidel and block Jacobi smoothers
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/fd_utils.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/form_residual.hpp"
+#include "iceicle/geometry/face.hpp"
+#include "iceicle/linalg/small_dense.hpp"
+#include "iceicle/mesh/mesh_utils.hpp"
+#include "iceicle/nonlinear_solver_utils.hpp"
+#include "iceicle/thread_utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace iceicle::solvers {
+
+    /// @brief the order that the elements are visited in a sweep
+    enum class SWEEP_ORDERING {
+        NATURAL, /// @brief the element index order
+        MORTON,  /// @brief the morton space filling curve of the element centroids
+        LINES    /// @brief lines of elements through facsuel that follow a direction (i.e the flow)
+    };
+
+    /**
+     * @brief nonlinear element block smoother for res(u) = forcing
+     *
+     * Each element in turn does local Newton iterations on its own residual
+     * (the domain integral and every trace around the element) with the neighbors held fixed.
+     * For Gauss-Seidel the neighbor states are the latest ones from the current sweep,
+     * for Jacobi they are from the previous sweep and the elements are solved in parallel.
+     *
+     * The element jacobian blocks are formed by finite differences of the element residual
+     * one element at a time so only one block per thread is stored
+     *
+     * @tparam T the floating point type
+     * @tparam IDX the index type
+     */
+    template<class T, class IDX>
+    class ElementGaussSeidel {
+        public:
+
+        /// @brief the element visiting order (set_ordering() or natural on first use if empty)
+        std::vector<IDX> order{};
+
+        /// @brief use neighbor states from the previous sweep (block Jacobi, parallel over elements)
+        bool jacobi = false;
+
+        /// @brief follow a forward sweep by a backward sweep (Gauss-Seidel only)
+        bool symmetric = false;
+
+        /// @brief the damping of the element updates
+        T omega = 1.0;
+
+        /// @brief the number of local Newton iterations per element per sweep
+        IDX newton_iter = 1;
+
+        /// @brief the finite difference epsilon (scaled by the norm of the element residual)
+        T epsilon = std::sqrt(std::numeric_limits<T>::epsilon());
+
+        /// @brief the l2 norm of the global residual after the last solve() iteration
+        T res_norm = 0.0;
+
+        private:
+
+        /// @brief the state at the start of a jacobi sweep
+        std::vector<T> u_old{};
+
+        /// @brief per thread scratch: the element state, residual, perturbed residual,
+        /// neighbor state, neighbor residual, and the element jacobian
+        struct scratch {
+            std::vector<T> u, res, resp, unb, resnb, jac;
+            std::vector<linalg::pivot_index> piv;
+        };
+        std::vector<scratch> scratches{};
+
+        public:
+
+        /**
+         * @brief set the element ordering of the sweeps
+         * @param fespace the finite element space
+         * @param ordering the type of ordering
+         * @param direction the direction of the lines (for SWEEP_ORDERING::LINES)
+         */
+        template<int ndim>
+        auto set_ordering(
+            FESpace<T, IDX, ndim>& fespace,
+            SWEEP_ORDERING ordering,
+            const NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, ndim>& direction = {}
+        ) -> void {
+            using Point = MATH::GEOMETRY::Point<T, ndim>;
+            AbstractMesh<T, IDX, ndim>& mesh = *fespace.meshptr;
+            const IDX nelem = fespace.elements.size();
+            order.resize(nelem);
+            std::iota(order.begin(), order.end(), 0);
+            std::vector<Point> centroids(nelem);
+            for(IDX iel = 0; iel < nelem; ++iel) centroids[iel] = fespace.elements[iel].centroid();
+
+            switch(ordering){
+                case SWEEP_ORDERING::NATURAL:
+                    break;
+                case SWEEP_ORDERING::MORTON:
+                {
+                    BoundingBox<T, ndim> bbox = compute_bounding_box(mesh);
+                    std::vector<std::uint64_t> keys(nelem);
+                    for(IDX iel = 0; iel < nelem; ++iel) keys[iel] = morton_key(centroids[iel], bbox);
+                    std::ranges::stable_sort(order, [&keys](IDX iel, IDX jel){ return keys[iel] < keys[jel]; });
+                    break;
+                }
+                case SWEEP_ORDERING::LINES:
+                {
+                    auto upstream = [&](IDX iel){
+                        T dot = 0;
+                        for(int idim = 0; idim < ndim; ++idim) dot += centroids[iel][idim] * direction[idim];
+                        return dot;
+                    };
+
+                    // seed lines from the most upstream unvisited element
+                    // and march to the neighbor most aligned with the direction
+                    std::vector<IDX> seeds = order;
+                    std::ranges::stable_sort(seeds, {}, upstream);
+                    std::vector<bool> visited(nelem, false);
+                    order.clear();
+                    for(IDX seed : seeds){
+                        IDX iel = seed;
+                        while(iel >= 0 && !visited[iel]){
+                            visited[iel] = true;
+                            order.push_back(iel);
+                            IDX next = -1;
+                            T best = 0;
+                            for(IDX ifac : mesh.facsuel.rowspan(iel)){
+                                const Face<T, IDX, ndim>& fac = *mesh.faces[ifac];
+                                if(fac.bctype != BOUNDARY_CONDITIONS::INTERIOR) continue;
+                                IDX jel = (fac.elemL == iel) ? fac.elemR : fac.elemL;
+                                if(visited[jel]) continue;
+                                T dot = 0, dist = 0;
+                                for(int idim = 0; idim < ndim; ++idim){
+                                    T dx = centroids[jel][idim] - centroids[iel][idim];
+                                    dot += dx * direction[idim];
+                                    dist += dx * dx;
+                                }
+                                T alignment = dot / std::sqrt(dist);
+                                if(alignment > best){
+                                    best = alignment;
+                                    next = jel;
+                                }
+                            }
+                            iel = next;
+                        }
+                    }
+                    break;
+                }
+            }
+        }
+
+        /**
+         * @brief one sweep over the elements (or a forward and backward sweep if symmetric)
+         * @param fespace the finite element space
+         * @param disc the discretization
+         * @param [in/out] u the solution
+         * @param forcing the right hand side of res(u) = forcing
+         */
+        template<int ndim, class disc_class, class uLayoutPolicy, class fLayoutPolicy>
+        auto sweep(
+            FESpace<T, IDX, ndim>& fespace,
+            disc_class& disc,
+            fespan<T, uLayoutPolicy> u,
+            fespan<T, fLayoutPolicy> forcing
+        ) -> void { sweep_impl(fespace, disc, u, &forcing); }
+
+        /// @brief one sweep for res(u) = 0 (see above)
+        template<int ndim, class disc_class, class uLayoutPolicy>
+        auto sweep(
+            FESpace<T, IDX, ndim>& fespace,
+            disc_class& disc,
+            fespan<T, uLayoutPolicy> u
+        ) -> void { sweep_impl(fespace, disc, u, static_cast<fespan<T, uLayoutPolicy>*>(nullptr)); }
+
+        /**
+         * @brief sweep until the residual converges (standalone nonlinear solver)
+         * @param fespace the finite element space
+         * @param disc the discretization
+         * @param [in/out] u the solution
+         * @param conv_criteria the convergence criteria (kmax is the maximum number of sweeps)
+         * @return the number of sweeps performed
+         */
+        template<int ndim, class disc_class, class uLayoutPolicy>
+        auto solve(
+            FESpace<T, IDX, ndim>& fespace,
+            disc_class& disc,
+            fespan<T, uLayoutPolicy> u,
+            ConvergenceCriteria<T, IDX>& conv_criteria
+        ) -> IDX {
+            std::vector<T> res_data(u.size());
+            fespan res{res_data.data(), u.get_layout()};
+            // constructed per solve so no shared memory window (the construction is not collective)
+            ResidualWorkspace<T, IDX> workspace{fespace, disc_class::dnv_comp, false};
+            workspace.enable_norm_monitor(disc_class::dnv_comp);
+            auto residual_norm = [&]{
+                form_residual(fespace, disc, u, res, workspace);
+                return workspace.monitor.l2();
+            };
+            res_norm = residual_norm();
+            conv_criteria.r0 = res_norm;
+            IDX k;
+            for(k = 0; k < conv_criteria.kmax; ++k){
+                sweep(fespace, disc, u);
+                res_norm = residual_norm();
+                if(conv_criteria.done_callback(res_norm) || !std::isfinite(res_norm)) {
+                    ++k;
+                    break;
+                }
+            }
+            return k;
+        }
+
+        private:
+
+        /// @brief one sweep with the forcing (nullptr for no forcing)
+        template<int ndim, class disc_class, class uLayoutPolicy, class forcing_t>
+        auto sweep_impl(
+            FESpace<T, IDX, ndim>& fespace,
+            disc_class& disc,
+            fespan<T, uLayoutPolicy> u,
+            const forcing_t* forcing
+        ) -> void {
+            const IDX nelem = fespace.elements.size();
+            if(order.size() != (std::size_t) nelem) set_ordering(fespace, SWEEP_ORDERING::NATURAL);
+            const std::size_t max_local_size = fespace.dg_map.max_el_size_reqirement(u.nv());
+            const int nthread = jacobi ? util::max_threads() : 1;
+            scratches.resize(nthread);
+            for(scratch& s : scratches){
+                s.u.resize(max_local_size);
+                s.res.resize(max_local_size);
+                s.resp.resize(max_local_size);
+                s.unb.resize(max_local_size);
+                s.resnb.resize(max_local_size);
+                s.jac.resize(max_local_size * max_local_size);
+                s.piv.resize(max_local_size);
+            }
+
+            if(jacobi){
+                u_old.assign(u.data(), u.data() + u.size());
+                fespan u_prev{u_old.data(), u.get_layout()};
+                util::parallel_for(nelem, [&](IDX i){
+                    solve_element(fespace, disc, order[i], u_prev, u, forcing, scratches[util::thread_num()]);
+                });
+            } else {
+                for(IDX iel : order) solve_element(fespace, disc, iel, u, u, forcing, scratches[0]);
+                if(symmetric){
+                    for(auto it = order.rbegin(); it != order.rend(); ++it)
+                        { solve_element(fespace, disc, *it, u, u, forcing, scratches[0]); }
+                }
+            }
+        }
+
+        /**
+         * @brief local Newton iterations on one element
+         * @param u_nb the state the neighbors are read from
+         * @param u the state that is updated
+         */
+        template<int ndim, class disc_class, class nbLayoutPolicy, class uLayoutPolicy, class forcing_t>
+        auto solve_element(
+            FESpace<T, IDX, ndim>& fespace,
+            disc_class& disc,
+            IDX iel,
+            fespan<T, nbLayoutPolicy> u_nb,
+            fespan<T, uLayoutPolicy> u,
+            const forcing_t* forcing,
+            scratch& s
+        ) -> void {
+            const FiniteElement<T, IDX, ndim>& el = fespace.elements[iel];
+            AbstractMesh<T, IDX, ndim>& mesh = *fespace.meshptr;
+            dofspan uK{s.u.data(), u.create_element_layout(iel)};
+            dofspan resK{s.res.data(), u.create_element_layout(iel)};
+            dofspan respK{s.resp.data(), u.create_element_layout(iel)};
+            extract_elspan(iel, u, uK);
+            const std::size_t n = uK.size();
+
+            // res_K(u_K) - f_K with the neighbors fixed
+            auto element_residual = [&](auto res) -> void {
+                res = 0;
+                disc.domain_integral(el, uK, res);
+                for(IDX ifac : mesh.facsuel.rowspan(iel)){
+                    const TraceSpace<T, IDX, ndim>& trace = fespace.traces[ifac];
+                    if(trace.face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) continue;
+                    if(trace.face->bctype == BOUNDARY_CONDITIONS::INTERIOR){
+                        bool left = trace.elL.elidx == iel;
+                        IDX jel = left ? trace.elR.elidx : trace.elL.elidx;
+                        dofspan unb{s.unb.data(), u.create_element_layout(jel)};
+                        dofspan resnb{s.resnb.data(), u.create_element_layout(jel)};
+                        extract_elspan(jel, u_nb, unb);
+                        resnb = 0;
+                        if(left) disc.trace_integral(trace, mesh.coord, uK, unb, res, resnb);
+                        else disc.trace_integral(trace, mesh.coord, unb, uK, resnb, res);
+                    } else {
+                        dofspan uR{s.unb.data(), u.create_element_layout(trace.elR.elidx)};
+                        extract_elspan(trace.elR.elidx, u_nb, uR);
+                        disc.boundaryIntegral(trace, mesh.coord, uK, uR, res);
+                    }
+                }
+                if(forcing != nullptr){
+                    const forcing_t& f = *forcing;
+                    for(IDX idof = 0; idof < res.ndof(); ++idof){
+                        for(IDX iv = 0; iv < res.nv(); ++iv) res[idof, iv] -= f[iel, idof, iv];
+                    }
+                }
+            };
+
+            for(IDX inewton = 0; inewton < newton_iter; ++inewton){
+                element_residual(resK);
+
+                // finite difference jacobian (row major, compact element dof order)
+                T eps_scaled = scale_fd_epsilon(epsilon, resK.vector_norm());
+                for(IDX jdof = 0; jdof < uK.ndof(); ++jdof){
+                    for(IDX jv = 0; jv < uK.nv(); ++jv){
+                        IDX jcol = uK.get_layout()[jdof, jv];
+                        T old_val = uK[jdof, jv];
+                        uK[jdof, jv] += eps_scaled;
+                        element_residual(respK);
+                        for(IDX idof = 0; idof < resK.ndof(); ++idof){
+                            for(IDX iv = 0; iv < resK.nv(); ++iv){
+                                IDX irow = resK.get_layout()[idof, iv];
+                                s.jac[irow * n + jcol] = (respK[idof, iv] - resK[idof, iv]) / eps_scaled;
+                            }
+                        }
+                        uK[jdof, jv] = old_val;
+                    }
+                }
+
+                // du = -J^{-1} (res - f) into the residual storage
+                bool factored = linalg::dispatch_basis_size(n, [&](auto N) -> bool {
+                    if(!linalg::lu_factor<decltype(N)::value>(s.jac.data(), s.piv.data(), n)) return false;
+                    linalg::lu_solve<decltype(N)::value>(s.jac.data(), s.piv.data(), s.res.data(), n);
+                    return true;
+                });
+                if(!factored){
+                    util::AnomalyLog::log_record("Singular jacobian block encountered on element ", iel);
+                    return;
+                }
+                for(std::size_t i = 0; i < n; ++i) s.u[i] -= omega * s.res[i];
+            }
+            scatter_elspan(iel, 1.0, uK, 0.0, u);
+        }
+    };
+}
@@ -0,0 +1,665 @@
+/**
+ * @brief line implicit preconditioner along the strongly coupled element lines of the DG jacobian
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/crs.hpp"
+#include "iceicle/fd_utils.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/form_petsc_jacobian.hpp"
+#include "iceicle/linalg/small_dense.hpp"
+#include "iceicle/petsc_interface.hpp"
+#include "iceicle/thread_utils.hpp"
+#include <mdspan/mdspan.hpp>
+#include <petscerror.h>
+#include <petscmat.h>
+#include <petscpc.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace iceicle::solvers {
+
+    /**
+     * @brief block tridiagonal solves along lines of strongly coupled elements
+     *
+     * On stretched boundary layer meshes the jacobian coupling across the thin direction
+     * dominates and element block Jacobi (see ElementBlockJacobi) stalls.
+     * This keeps the diagonal blocks and the off diagonal blocks between consecutive elements of
+     * lines through the face neighbor graph (elsuel) and solves each line exactly with the block Thomas algorithm.
+     *
+     * Lines are detected from the coupling weight w(K, J) = ||B_KJ||_F of the off diagonal blocks:
+     * starting from the most anisotropic element a line is grown at both ends to the unvisited neighbor
+     * with the largest weight as long as that coupling is at least coupling_ratio times the weakest
+     * coupling of both elements. Isotropic regions end up as lines of one element (block Jacobi there).
+     *
+     * Lines are independent so the factorization and apply() are threaded over lines.
+     * Only the blocks along the lines are kept after the factorization.
+     *
+     * @tparam T the floating point type
+     * @tparam IDX the index type
+     */
+    template<typename T, typename IDX>
+    class ElementLineImplicit {
+        private:
+
+        /// @brief the compact (dof, vector component) index of the start of each element (size = nelem + 1)
+        std::vector<std::size_t> el_start{0};
+
+        /// @brief the unique face neighbors of each element (sorted)
+        util::crs<IDX, IDX> neighbors{};
+
+        /// @brief the lines of elements (in line order)
+        util::crs<IDX, IDX> lines{};
+
+        /// @brief the diagonal blocks, inverted in place by the factorization into Dhat^{-1} (row major)
+        std::vector<T> diag_data{};
+
+        /// @brief the offset of the start of each diagonal block (size = nelem + 1)
+        std::vector<std::size_t> diag_offsets{0};
+
+        /// @brief the off diagonal blocks B_KJ for each neighbor J of K (row major, released after factorization)
+        std::vector<T> offdiag_data{};
+
+        /// @brief the offset of the start of each off diagonal block (size = neighbors.nnz() + 1)
+        std::vector<std::size_t> offdiag_offsets{0};
+
+        /// @brief the coupling to the previous element in the line of each element L_K = B_{K, prev}
+        std::vector<T> lower_data{};
+
+        /// @brief the scaled coupling to the next element in the line of each element G_K = Dhat_K^{-1} B_{K, next}
+        std::vector<T> upper_data{};
+
+        /// @brief the offsets of the start of the lower and upper block of each element (size = nelem + 1)
+        std::vector<std::size_t> lower_offsets{0}, upper_offsets{0};
+
+        /// @brief the size of the block row of element iel
+        auto block_size(IDX iel) const -> std::size_t { return el_start[iel + 1] - el_start[iel]; }
+
+        /// @brief the index into the off diagonal blocks of neighbor jel of iel (-1 if not a neighbor)
+        auto neighbor_slot(IDX iel, IDX jel) const -> IDX {
+            auto row = neighbors.rowspan(iel);
+            auto it = std::lower_bound(row.begin(), row.end(), jel);
+            if(it == row.end() || *it != jel) return -1;
+            return neighbors.cols()[iel] + (IDX) std::distance(row.begin(), it);
+        }
+
+        /// @brief allocate zeroed diagonal and off diagonal blocks for the current structure
+        auto allocate_blocks() -> void {
+            const IDX nelem = el_start.size() - 1;
+            diag_offsets.resize(nelem + 1);
+            diag_offsets[0] = 0;
+            for(IDX iel = 0; iel < nelem; ++iel){
+                std::size_t n = block_size(iel);
+                diag_offsets[iel + 1] = diag_offsets[iel] + n * n;
+            }
+            offdiag_offsets.resize(neighbors.nnz() + 1);
+            offdiag_offsets[0] = 0;
+            for(IDX iel = 0; iel < nelem; ++iel){
+                for(IDX islot = neighbors.cols()[iel]; islot < neighbors.cols()[iel + 1]; ++islot){
+                    offdiag_offsets[islot + 1] = offdiag_offsets[islot]
+                        + block_size(iel) * block_size(neighbors.data()[islot]);
+                }
+            }
+            diag_data.assign(diag_offsets.back(), 0.0);
+            offdiag_data.assign(offdiag_offsets.back(), 0.0);
+        }
+
+        /// @brief the Frobenius norm of the off diagonal block in slot islot
+        auto coupling_weight(IDX islot) const -> T {
+            T sum = 0;
+            for(std::size_t i = offdiag_offsets[islot]; i < offdiag_offsets[islot + 1]; ++i)
+                { sum += offdiag_data[i] * offdiag_data[i]; }
+            return std::sqrt(sum);
+        }
+
+        /// @brief group the elements into lines from the off diagonal block weights
+        auto detect_lines() -> void {
+            const IDX nelem = el_start.size() - 1;
+            std::vector<T> weights(neighbors.nnz());
+            for(IDX islot = 0; islot < (IDX) neighbors.nnz(); ++islot)
+                { weights[islot] = coupling_weight(islot); }
+
+            // the weakest and strongest coupling of each element
+            std::vector<T> wmin(nelem, 0.0), wmax(nelem, 0.0);
+            for(IDX iel = 0; iel < nelem; ++iel){
+                if(neighbors.rowsize(iel) == 0) continue;
+                auto first = weights.begin() + neighbors.cols()[iel];
+                auto last = weights.begin() + neighbors.cols()[iel + 1];
+                wmin[iel] = *std::min_element(first, last);
+                wmax[iel] = *std::max_element(first, last);
+            }
+
+            // J extends the line at K if the coupling is strong from both sides
+            auto strong = [&](IDX kel, IDX kslot, IDX jel) -> bool {
+                IDX jslot = neighbor_slot(jel, kel);
+                if(weights[kslot] <= 0.0 || jslot < 0) return false;
+                bool strong_k = neighbors.rowsize(kel) == 1 || weights[kslot] >= coupling_ratio * wmin[kel];
+                bool strong_j = neighbors.rowsize(jel) == 1 || weights[jslot] >= coupling_ratio * wmin[jel];
+                return strong_k && strong_j;
+            };
+
+            // the strongest unvisited neighbor of K that extends the line (-1 if none)
+            std::vector<bool> visited(nelem, false);
+            auto next_in_line = [&](IDX kel) -> IDX {
+                IDX best = -1;
+                T wbest = 0.0;
+                for(IDX islot = neighbors.cols()[kel]; islot < neighbors.cols()[kel + 1]; ++islot){
+                    IDX jel = neighbors.data()[islot];
+                    if(visited[jel] || weights[islot] <= wbest) continue;
+                    if(strong(kel, islot, jel)){
+                        best = jel;
+                        wbest = weights[islot];
+                    }
+                }
+                return best;
+            };
+
+            // seed from the most anisotropic elements
+            std::vector<IDX> seeds(nelem);
+            std::iota(seeds.begin(), seeds.end(), 0);
+            auto anisotropy = [&](IDX iel) -> T {
+                return (wmin[iel] > 0.0) ? wmax[iel] / wmin[iel] : std::numeric_limits<T>::max();
+            };
+            std::stable_sort(seeds.begin(), seeds.end(),
+                    [&](IDX a, IDX b){ return anisotropy(a) > anisotropy(b); });
+
+            std::vector<std::vector<IDX>> lines_dynamic{};
+            for(IDX seed : seeds){
+                if(visited[seed]) continue;
+                visited[seed] = true;
+                std::vector<IDX> forward{seed}, backward{};
+                for(IDX jel = next_in_line(seed); jel >= 0 && forward.size() < max_line_length;
+                        jel = next_in_line(forward.back())){
+                    visited[jel] = true;
+                    forward.push_back(jel);
+                }
+                for(IDX jel = next_in_line(seed); jel >= 0 && forward.size() + backward.size() < max_line_length;
+                        jel = next_in_line(backward.back())){
+                    visited[jel] = true;
+                    backward.push_back(jel);
+                }
+                std::vector<IDX> line(backward.rbegin(), backward.rend());
+                line.insert(line.end(), forward.begin(), forward.end());
+                lines_dynamic.push_back(std::move(line));
+            }
+            lines = util::crs<IDX, IDX>{lines_dynamic};
+        }
+
+        /// @brief block LU factorization of each line (Dhat_K = D_K - L_K G_prev)
+        auto factor() -> void {
+            const IDX nelem = el_start.size() - 1;
+            detect_lines();
+
+            // size the line blocks
+            std::vector<IDX> prev(nelem, -1), next(nelem, -1);
+            for(IDX iline = 0; iline < (IDX) lines.nrow(); ++iline){
+                auto line = lines.rowspan(iline);
+                for(std::size_t i = 1; i < line.size(); ++i){
+                    prev[line[i]] = line[i - 1];
+                    next[line[i - 1]] = line[i];
+                }
+            }
+            lower_offsets.resize(nelem + 1);
+            upper_offsets.resize(nelem + 1);
+            lower_offsets[0] = upper_offsets[0] = 0;
+            for(IDX iel = 0; iel < nelem; ++iel){
+                lower_offsets[iel + 1] = lower_offsets[iel] + ((prev[iel] >= 0) ? block_size(iel) * block_size(prev[iel]) : 0);
+                upper_offsets[iel + 1] = upper_offsets[iel] + ((next[iel] >= 0) ? block_size(iel) * block_size(next[iel]) : 0);
+            }
+            lower_data.assign(lower_offsets.back(), 0.0);
+            upper_data.assign(upper_offsets.back(), 0.0);
+
+            std::vector<char> singular(nelem, 0);
+            util::parallel_for((IDX) lines.nrow(), [&](IDX iline){
+                auto line = lines.rowspan(iline);
+                std::vector<linalg::pivot_index> piv{};
+                std::vector<T> work{};
+                for(std::size_t i = 0; i < line.size(); ++i){
+                    const IDX kel = line[i];
+                    const std::size_t n = block_size(kel);
+                    T* dhat = diag_data.data() + diag_offsets[kel];
+                    if(i > 0){
+                        const IDX pel = line[i - 1];
+                        const std::size_t np = block_size(pel);
+                        const T* dinv_p = diag_data.data() + diag_offsets[pel];
+                        const T* b_pk = offdiag_data.data() + offdiag_offsets[neighbor_slot(pel, kel)];
+                        const T* b_kp = offdiag_data.data() + offdiag_offsets[neighbor_slot(kel, pel)];
+                        T* lk = lower_data.data() + lower_offsets[kel];
+                        T* gp = upper_data.data() + upper_offsets[pel];
+                        std::copy_n(b_kp, n * np, lk);
+
+                        // G_prev = Dhat_prev^{-1} B_{prev, K}
+                        for(std::size_t a = 0; a < np; ++a){
+                            for(std::size_t b = 0; b < n; ++b){
+                                T sum = 0;
+                                for(std::size_t c = 0; c < np; ++c) { sum += dinv_p[a * np + c] * b_pk[c * n + b]; }
+                                gp[a * n + b] = sum;
+                            }
+                        }
+
+                        // Dhat_K = D_K - L_K G_prev
+                        for(std::size_t a = 0; a < n; ++a){
+                            for(std::size_t b = 0; b < n; ++b){
+                                T sum = 0;
+                                for(std::size_t c = 0; c < np; ++c) { sum += lk[a * np + c] * gp[c * n + b]; }
+                                dhat[a * n + b] -= sum;
+                            }
+                        }
+                    }
+
+                    piv.resize(n);
+                    work.resize(n * n);
+                    bool inverted = linalg::dispatch_basis_size(n, [&](auto N) -> bool {
+                        return linalg::lu_invert<decltype(N)::value>(dhat, piv.data(), work.data(), n);
+                    });
+                    if(!inverted){
+                        // set to Identity on failure and log anomaly after the threaded region
+                        std::fill_n(dhat, n * n, 0.0);
+                        for(std::size_t a = 0; a < n; ++a) { dhat[a * n + a] = 1.0; }
+                        singular[kel] = 1;
+                    }
+                }
+            });
+            for(IDX iel = 0; iel < nelem; ++iel){
+                if(singular[iel])
+                    util::AnomalyLog::log_record("Singular line block encountered on element ", iel);
+            }
+
+            // only the line blocks are needed by apply()
+            offdiag_data.clear();
+            offdiag_data.shrink_to_fit();
+        }
+
+        public:
+
+        /// @brief a neighbor continues a line if its coupling is at least
+        /// coupling_ratio times the weakest coupling of both elements
+        T coupling_ratio = 4.0;
+
+        /// @brief the maximum number of elements in a line
+        std::size_t max_line_length = std::numeric_limits<std::size_t>::max();
+
+        /// @brief default constructor: empty preconditioner (must be built before use)
+        ElementLineImplicit() = default;
+
+        /// @brief the lines found by the last build (rows are the elements of each line in order)
+        auto get_lines() const -> const util::crs<IDX, IDX>& { return lines; }
+
+        /**
+         * @brief set the element block sizes and the face neighbor graph
+         * called by build(), call directly before build_from_matrix()
+         * only the interior faces couple elements, so lines do not cross process boundaries
+         *
+         * @param fespace the finite element space
+         * @param ncomp the number of vector components per dof
+         */
+        template<class T2, class IDX2, int ndim>
+        auto set_structure(FESpace<T2, IDX2, ndim>& fespace, std::size_t ncomp) -> void {
+            const IDX nelem = fespace.elements.size();
+            el_start.resize(nelem + 1);
+            el_start[0] = 0;
+            for(IDX iel = 0; iel < nelem; ++iel)
+                { el_start[iel + 1] = el_start[iel] + fespace.dg_map.ndof_el(iel) * ncomp; }
+
+            std::vector<std::vector<IDX>> neighbors_dynamic(nelem);
+            for(const auto& trace : fespace.get_interior_traces()){
+                IDX iL = trace.elL.elidx, iR = trace.elR.elidx;
+                if(iL == iR) continue;
+                neighbors_dynamic[iL].push_back(iR);
+                neighbors_dynamic[iR].push_back(iL);
+            }
+            for(std::vector<IDX>& row : neighbors_dynamic){
+                std::sort(row.begin(), row.end());
+                row.erase(std::unique(row.begin(), row.end()), row.end());
+            }
+            neighbors = util::crs<IDX, IDX>{neighbors_dynamic};
+        }
+
+        /**
+         * @brief compute the element diagonal and neighbor coupling blocks at the state u,
+         * detect the lines, and factor the line systems
+         * the analytic jacobians of the discretization are used when provided (see ElementBlockJacobi)
+         *
+         * @param fespace the finite element space
+         * @param disc the discretization
+         * @param u the solution to linearize about
+         * @param epsilon (optional) the epsilon to use for finite difference
+         *                NOTE: this gets scaled by the norm of the compact residual vector
+         */
+        template<int ndim, class disc_class, class uLayoutPolicy, class uAccessorPolicy>
+        auto build(
+            FESpace<T, IDX, ndim>& fespace,
+            disc_class& disc,
+            fespan<T, uLayoutPolicy, uAccessorPolicy> u,
+            T epsilon = std::sqrt(std::numeric_limits<T>::epsilon())
+        ) -> void {
+            using Element = FiniteElement<T, IDX, ndim>;
+            using Trace = TraceSpace<T, IDX, ndim>;
+            using namespace std::experimental;
+
+            const std::size_t ncomp = disc_class::dnv_comp;
+            const std::size_t max_local_size =
+                fespace.dg_map.max_el_size_reqirement(ncomp);
+            set_structure(fespace, ncomp);
+            allocate_blocks();
+
+            // storage for local solutions, residuals, and jacobians
+            std::vector<T> uL_data(max_local_size);
+            std::vector<T> uR_data(max_local_size);
+            std::vector<T> resL_data(max_local_size);
+            std::vector<T> resLp_data(max_local_size);
+            std::vector<T> resR_data(max_local_size);
+            std::vector<T> resRp_data(max_local_size);
+            std::vector<T> jacLL_data(max_local_size * max_local_size);
+            std::vector<T> jacLR_data(max_local_size * max_local_size);
+            std::vector<T> jacRL_data(max_local_size * max_local_size);
+            std::vector<T> jacRR_data(max_local_size * max_local_size);
+
+            // types for the compact views to detect analytic jacobians
+            using compact_uspan_t = decltype(dofspan{uL_data.data(), u.create_element_layout(0)});
+            using compact_jac_t = decltype(mdspan{jacLL_data.data(), extents{max_local_size, max_local_size}});
+            using coord_t = decltype(fespace.meshptr->coord);
+
+            // views of the diagonal block of an element and the coupling block of row iel to column jel
+            auto block = [&](IDX iel){
+                return mdspan{diag_data.data() + diag_offsets[iel], extents{block_size(iel), block_size(iel)}};
+            };
+            auto offblock = [&](IDX iel, IDX jel){
+                return mdspan{offdiag_data.data() + offdiag_offsets[neighbor_slot(iel, jel)],
+                    extents{block_size(iel), block_size(jel)}};
+            };
+            auto add_block = [](auto blk, auto jac){
+                for(std::size_t i = 0; i < jac.extent(0); ++i){
+                    for(std::size_t j = 0; j < jac.extent(1); ++j)
+                        { blk[i, j] += jac[i, j]; }
+                }
+            };
+
+            // finite difference of the compact residuals res_op(resA, resB) wrt ujac added to blkA and blkB
+            auto fd_blocks = [&](auto&& res_op, auto ujac, auto resA, auto respA, auto blkA,
+                    auto resB, auto respB, auto blkB){
+                T eps_scaled = scale_fd_epsilon(epsilon, std::max(resA.vector_norm(), resB.vector_norm()));
+                auto accumulate = [&](auto res, auto resp, auto blk, IDX jcol){
+                    for(IDX idoff = 0; idoff < res.ndof(); ++idoff){
+                        for(IDX ieqf = 0; ieqf < ncomp; ++ieqf){
+                            IDX irow = res.get_layout()[idoff, ieqf];
+                            blk[irow, jcol] += (resp[idoff, ieqf] - res[idoff, ieqf]) / eps_scaled;
+                        }
+                    }
+                };
+                for(IDX idofu = 0; idofu < ujac.ndof(); ++idofu){
+                    for(IDX iequ = 0; iequ < ncomp; ++iequ){
+                        IDX jcol = ujac.get_layout()[idofu, iequ];
+                        T old_val = ujac[idofu, iequ];
+                        ujac[idofu, iequ] += eps_scaled;
+                        respA = 0;
+                        respB = 0;
+                        res_op(respA, respB);
+                        accumulate(resA, respA, blkA, jcol);
+                        accumulate(resB, respB, blkB, jcol);
+                        ujac[idofu, iequ] = old_val;
+                    }
+                }
+            };
+            auto fd_block = [&](auto&& res_op, auto ujac, auto res, auto resp, auto blk){
+                T eps_scaled = scale_fd_epsilon(epsilon, res.vector_norm());
+                for(IDX idofu = 0; idofu < ujac.ndof(); ++idofu){
+                    for(IDX iequ = 0; iequ < ncomp; ++iequ){
+                        IDX jcol = ujac.get_layout()[idofu, iequ];
+                        T old_val = ujac[idofu, iequ];
+                        ujac[idofu, iequ] += eps_scaled;
+                        resp = 0;
+                        res_op(resp);
+                        for(IDX idoff = 0; idoff < res.ndof(); ++idoff){
+                            for(IDX ieqf = 0; ieqf < ncomp; ++ieqf){
+                                IDX irow = res.get_layout()[idoff, ieqf];
+                                blk[irow, jcol] += (resp[idoff, ieqf] - res[idoff, ieqf]) / eps_scaled;
+                            }
+                        }
+                        ujac[idofu, iequ] = old_val;
+                    }
+                }
+            };
+
+            // boundary faces
+            for(const Trace& trace : fespace.get_boundary_traces()) {
+                if(trace.face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) continue;
+                dofspan uL{uL_data.data(), u.create_element_layout(trace.elL.elidx)};
+                dofspan uR{uR_data.data(), u.create_element_layout(trace.elR.elidx)};
+                dofspan resL{resL_data.data(), u.create_element_layout(trace.elL.elidx)};
+                dofspan resLp{resLp_data.data(), u.create_element_layout(trace.elL.elidx)};
+                extract_elspan(trace.elL.elidx, u, uL);
+                extract_elspan(trace.elR.elidx, u, uR);
+
+                bool analytic_jac = false;
+                if constexpr (provides_boundary_jacobian<disc_class, Trace, coord_t, compact_uspan_t, compact_jac_t>) {
+                    mdspan jacL{jacLL_data.data(), extents{resL.size(), uL.size()}};
+                    std::fill_n(jacLL_data.begin(), jacL.size(), 0);
+                    analytic_jac = disc.boundary_integral_jacobian(trace, fespace.meshptr->coord, uL, uR, jacL);
+                    if(analytic_jac) add_block(block(trace.elL.elidx), jacL);
+                }
+                if(!analytic_jac){
+                    resL = 0;
+                    disc.boundaryIntegral(trace, fespace.meshptr->coord, uL, uR, resL);
+                    fd_block([&](auto resp){
+                        disc.boundaryIntegral(trace, fespace.meshptr->coord, uL, uR, resp);
+                    }, uL, resL, resLp, block(trace.elL.elidx));
+                }
+            }
+
+            // interior faces: the self coupling and the coupling across the face
+            for(const Trace& trace : fespace.get_interior_traces()) {
+                const IDX iL = trace.elL.elidx, iR = trace.elR.elidx;
+                dofspan uL{uL_data.data(), u.create_element_layout(iL)};
+                dofspan uR{uR_data.data(), u.create_element_layout(iR)};
+                dofspan resL{resL_data.data(), u.create_element_layout(iL)};
+                dofspan resLp{resLp_data.data(), u.create_element_layout(iL)};
+                dofspan resR{resR_data.data(), u.create_element_layout(iR)};
+                dofspan resRp{resRp_data.data(), u.create_element_layout(iR)};
+                extract_elspan(iL, u, uL);
+                extract_elspan(iR, u, uR);
+
+                if constexpr (provides_trace_jacobian<disc_class, Trace, coord_t, compact_uspan_t, compact_jac_t>) {
+                    mdspan jacLL{jacLL_data.data(), extents{resL.size(), uL.size()}};
+                    mdspan jacRL{jacRL_data.data(), extents{resR.size(), uL.size()}};
+                    mdspan jacLR{jacLR_data.data(), extents{resL.size(), uR.size()}};
+                    mdspan jacRR{jacRR_data.data(), extents{resR.size(), uR.size()}};
+                    std::fill_n(jacLL_data.begin(), jacLL.size(), 0);
+                    std::fill_n(jacRL_data.begin(), jacRL.size(), 0);
+                    std::fill_n(jacLR_data.begin(), jacLR.size(), 0);
+                    std::fill_n(jacRR_data.begin(), jacRR.size(), 0);
+                    disc.trace_integral_jacobian(trace, fespace.meshptr->coord, uL, uR,
+                            jacLL, jacLR, jacRL, jacRR);
+                    add_block(block(iL), jacLL);
+                    add_block(block(iR), jacRR);
+                    if(iL == iR){
+                        add_block(block(iL), jacLR);
+                        add_block(block(iR), jacRL);
+                    } else {
+                        add_block(offblock(iL, iR), jacLR);
+                        add_block(offblock(iR, iL), jacRL);
+                    }
+                } else {
+                    resL = 0;
+                    resR = 0;
+                    disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, resL, resR);
+                    auto res_op = [&](auto respL, auto respR){
+                        disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, respL, respR);
+                    };
+                    if(iL == iR){
+                        // both sides are the same element: differentiate through both arguments
+                        fd_blocks(res_op, uL, resL, resLp, block(iL), resR, resRp, block(iL));
+                        fd_blocks(res_op, uR, resL, resLp, block(iL), resR, resRp, block(iL));
+                    } else {
+                        // perturbing one side gives the diagonal block and the coupling to the other side
+                        fd_blocks(res_op, uL, resL, resLp, block(iL), resR, resRp, offblock(iR, iL));
+                        fd_blocks(res_op, uR, resL, resLp, offblock(iL, iR), resR, resRp, block(iR));
+                    }
+                }
+            }
+
+            // domain integral
+            for(const Element& el : fespace.elements) {
+                dofspan u_el{uL_data.data(), u.create_element_layout(el.elidx)};
+                dofspan res_el{resL_data.data(), u.create_element_layout(el.elidx)};
+                dofspan resp_el{resLp_data.data(), u.create_element_layout(el.elidx)};
+                mdspan jac_el{jacLL_data.data(), extents{res_el.size(), u_el.size()}};
+                extract_elspan(el.elidx, u, u_el);
+
+                if constexpr (provides_domain_jacobian<disc_class, Element, decltype(u_el), decltype(jac_el)>) {
+                    std::fill_n(jacLL_data.begin(), jac_el.size(), 0);
+                    disc.domain_integral_jacobian(el, u_el, jac_el);
+                    add_block(block(el.elidx), jac_el);
+                } else {
+                    res_el = 0;
+                    disc.domain_integral(el, u_el, res_el);
+                    fd_block([&](auto resp){ disc.domain_integral(el, u_el, resp); },
+                        u_el, res_el, resp_el, block(el.elidx));
+                }
+            }
+
+            factor();
+        }
+
+        /**
+         * @brief extract the element diagonal and neighbor coupling blocks from an assembled jacobian,
+         * detect the lines, and factor the line systems
+         * set_structure() must have been called with the fespace the matrix was assembled on
+         *
+         * @param jac the jacobian (the local rows are the compact dg dofs of this process)
+         */
+        auto build_from_matrix(Mat jac) -> void {
+            const IDX nelem = el_start.size() - 1;
+            allocate_blocks();
+            PetscInt rstart;
+            PetscCallAbort(PETSC_COMM_WORLD, MatGetOwnershipRange(jac, &rstart, nullptr));
+
+            std::vector<PetscInt> rows{}, cols{};
+            std::vector<PetscScalar> values{};
+            auto global_indices = [&](IDX iel, std::vector<PetscInt>& idx){
+                idx.resize(block_size(iel));
+                std::iota(idx.begin(), idx.end(), (PetscInt) (rstart + el_start[iel]));
+            };
+            auto get_block = [&](IDX jel, T* blk){
+                global_indices(jel, cols);
+                values.resize(rows.size() * cols.size());
+                PetscCallAbort(PETSC_COMM_WORLD, MatGetValues(jac, rows.size(), rows.data(),
+                            cols.size(), cols.data(), values.data()));
+                std::copy(values.begin(), values.end(), blk);
+            };
+            for(IDX iel = 0; iel < nelem; ++iel){
+                global_indices(iel, rows);
+                get_block(iel, diag_data.data() + diag_offsets[iel]);
+                for(IDX islot = neighbors.cols()[iel]; islot < neighbors.cols()[iel + 1]; ++islot)
+                    { get_block(neighbors.data()[islot], offdiag_data.data() + offdiag_offsets[islot]); }
+            }
+            factor();
+        }
+
+        /**
+         * @brief apply the preconditioner to contiguous compact dg vectors
+         * out = M^{-1} res where M is the block diagonal of the lines of the jacobian
+         *
+         * NOTE: res and out must not overlap
+         *
+         * @param [in] res the compact residual (element dofs contiguous, vector component fastest)
+         * @param [out] out the preconditioned residual
+         */
+        auto apply(const T* res, T* out) const -> void {
+            util::parallel_for((IDX) lines.nrow(), [&](IDX iline){
+                auto line = lines.rowspan(iline);
+                std::vector<T> rhs{};
+
+                // forward elimination: out_K = Dhat_K^{-1} (res_K - L_K out_prev)
+                for(std::size_t i = 0; i < line.size(); ++i){
+                    const IDX kel = line[i];
+                    const std::size_t n = block_size(kel);
+                    rhs.assign(res + el_start[kel], res + el_start[kel] + n);
+                    if(i > 0){
+                        const IDX pel = line[i - 1];
+                        const std::size_t np = block_size(pel);
+                        const T* lk = lower_data.data() + lower_offsets[kel];
+                        const T* out_p = out + el_start[pel];
+                        for(std::size_t a = 0; a < n; ++a){
+                            for(std::size_t c = 0; c < np; ++c) { rhs[a] -= lk[a * np + c] * out_p[c]; }
+                        }
+                    }
+                    const T* dinv = diag_data.data() + diag_offsets[kel];
+                    T* out_k = out + el_start[kel];
+                    for(std::size_t a = 0; a < n; ++a){
+                        T sum = 0;
+                        for(std::size_t b = 0; b < n; ++b) { sum += dinv[a * n + b] * rhs[b]; }
+                        out_k[a] = sum;
+                    }
+                }
+
+                // back substitution: out_K -= G_K out_next
+                for(std::size_t i = line.size(); i-- > 1;){
+                    const IDX nel = line[i];
+                    const IDX kel = line[i - 1];
+                    const std::size_t n = block_size(kel);
+                    const std::size_t nn = block_size(nel);
+                    const T* gk = upper_data.data() + upper_offsets[kel];
+                    const T* out_n = out + el_start[nel];
+                    T* out_k = out + el_start[kel];
+                    for(std::size_t a = 0; a < n; ++a){
+                        for(std::size_t c = 0; c < nn; ++c) { out_k[a] -= gk[a * nn + c] * out_n[c]; }
+                    }
+                }
+            });
+        }
+
+        /**
+         * @brief apply the preconditioner
+         * out = M^{-1} res where M is the block diagonal of the lines of the jacobian
+         *
+         * NOTE: res and out must not overlap and use a contiguous element layout (fe_layout_right)
+         *
+         * @param [in] res the global residual
+         * @param [out] out the global preconditioned residual
+         */
+        template<class resLayoutPolicy, class resAccessorPolicy, class outLayoutPolicy, class outAccessorPolicy>
+        auto apply(
+            fespan<T, resLayoutPolicy, resAccessorPolicy> res,
+            fespan<T, outLayoutPolicy, outAccessorPolicy> out
+        ) const -> void {
+            apply(res.data(), out.data());
+        }
+    };
+
+    namespace impl {
+
+        /// @brief PCSHELL setup: rebuild the line preconditioner from the preconditioning matrix
+        template<class T, class IDX>
+        inline
+        auto line_implicit_pc_setup(PC pc) -> PetscErrorCode {
+            ElementLineImplicit<T, IDX> *line_pc;
+            Mat amat, pmat;
+            PetscFunctionBeginUser;
+            PetscCall(PCShellGetContext(pc, &line_pc));
+            PetscCall(PCGetOperators(pc, &amat, &pmat));
+            line_pc->build_from_matrix(pmat);
+            PetscFunctionReturn(EXIT_SUCCESS);
+        }
+
+        /// @brief PCSHELL apply of the line preconditioner
+        template<class T, class IDX>
+        inline
+        auto line_implicit_pc_apply(PC pc, Vec r, Vec z) -> PetscErrorCode {
+            ElementLineImplicit<T, IDX> *line_pc;
+            PetscFunctionBeginUser;
+            PetscCall(PCShellGetContext(pc, &line_pc));
+            {
+                petsc::VecSpan rview{r};
+                petsc::VecSpan zview{z};
+                line_pc->apply(rview.data(), zview.data());
+            }
+            PetscFunctionReturn(EXIT_SUCCESS);
+        }
+    }
+}
@@ -6,11 +6,21 @@
 #pragma once
 #include "Numtool/matrix/permutation_matrix.hpp"
 #include "iceicle/anomaly_log.hpp"
+#include "iceicle/disc/kernel_work.hpp"
+#include "iceicle/profiler.hpp"
 #include <iceicle/element/finite_element.hpp>
 #include <iceicle/fe_function/fe_function.hpp>
 #include <iceicle/fe_function/fespan.hpp>
+#include <iceicle/basis/sum_factorization.hpp>
+#include <iceicle/flat_map.hpp>
+#include <iceicle/fespace/fespace.hpp>
+#include <iceicle/linalg/small_dense.hpp>
+#include <iceicle/thread_utils.hpp>
 #include <Numtool/matrix/dense_matrix.hpp>
 #include <Numtool/matrix/decomposition/decomp_lu.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
 namespace iceicle::solvers {
     
     /**
@@ -25,6 +35,9 @@ namespace iceicle::solvers {
         MATH::MATRIX::DenseMatrix<T> mass; /// the mass matrix (decomposed) (not including jacobian)
         MATH::MATRIX::PermutationMatrix<unsigned int> pi; // permutation matrix for decomposition
 
+        /// @brief the inverse of a diagonal mass matrix (empty if the mass matrix is not diagonal)
+        std::vector<T> minv_diag{};
+
         using Point = MATH::GEOMETRY::Point<T, ndim>;
 
         public:
@@ -35,7 +48,17 @@ namespace iceicle::solvers {
          * @param node_coords the global node coordinates array
          */
         ElementLinearSolver(const FiniteElement<T, IDX, ndim> &el)
-        : mass{calculate_mass_matrix(el)}, pi{} {
+        : mass{has_diagonal_mass(el) ? MATH::MATRIX::DenseMatrix<T>(0, 0) : calculate_mass_matrix(el)}, pi{} {
+
+            // diagonal mass matrix: skip the decomposition
+            if(has_diagonal_mass(el)) {
+                minv_diag.resize(el.nbasis());
+                if(!calculate_inverse_diagonal_mass(el, minv_diag.data())){
+                    std::ranges::fill(minv_diag, 1.0);
+                    util::AnomalyLog::log_record("Singular Mass Matrix encountered on element ", el.elidx);
+                }
+                return;
+            }
 
             // decompse the mass matrix
             try {
@@ -47,7 +70,7 @@ namespace iceicle::solvers {
                 for(int i = 0; i < el.nbasis(); ++i){
                     mass[i][i] = 1.0;
                 }
-                util::AnomalyLog::log_anomaly(util::Anomaly{"Singular Mass Matrix encountered on element " + std::to_string(el.elidx), util::general_anomaly_tag{}});
+                util::AnomalyLog::log_record("Singular Mass Matrix encountered on element ", el.elidx);
             }
         }
 
@@ -58,6 +81,11 @@ namespace iceicle::solvers {
          * @param [in] b the residual
          */
         void solve(ElementData<T, neq> &u, ElementData<T, neq> &b){
+            if(!minv_diag.empty()){
+                for(std::size_t idof = 0; idof < minv_diag.size(); ++idof)
+                    { u.getData()[idof] = minv_diag[idof] * b.getData()[idof]; }
+                return;
+            }
             MATH::MATRIX::SOLVERS::sub_lu(mass, pi, b.getData(), u.getData());
         }
 
@@ -74,6 +102,13 @@ namespace iceicle::solvers {
             elspan auto u, 
             const elspan auto res
         ){
+            if(!minv_diag.empty()){
+                for(int idof = 0; idof < u.ndof(); ++idof){
+                    for(int ieq = 0; ieq < decltype(u)::static_extent(); ++ieq)
+                        { u[idof, ieq] = minv_diag[idof] * res[idof, ieq]; }
+                }
+                return;
+            }
             for(int ieq = 0; ieq < decltype(u)::static_extent(); ++ieq){
                 std::vector<T> ueq(u.ndof());
                 std::vector<T> reseq(u.ndof());
@@ -88,4 +123,699 @@ namespace iceicle::solvers {
             }
         }
     };
+
+    namespace impl {
+        /**
+         * @brief compute the dense inverse mass matrix of an element
+         * (directly for diagonal mass matrices, Cholesky since the mass matrix is symmetric positive definite, 
+         * pivoted LU otherwise)
+         * On a singular mass matrix the identity is used and an anomaly is logged
+         * @param el the element
+         * @param [out] minv the row major (nbasis x nbasis) inverse mass matrix
+         */
+        template<class T, class IDX, int ndim>
+        auto invert_mass_matrix(const FiniteElement<T, IDX, ndim>& el, T* minv) -> void {
+            const std::size_t ndof = el.nbasis();
+            if(has_diagonal_mass(el)){
+                std::vector<T> minv_diag(ndof);
+                std::fill_n(minv, ndof * ndof, 0.0);
+                bool inverted = calculate_inverse_diagonal_mass(el, minv_diag.data());
+                for(std::size_t idof = 0; idof < ndof; ++idof)
+                    { minv[idof * ndof + idof] = inverted ? minv_diag[idof] : 1.0; }
+                if(!inverted)
+                    util::AnomalyLog::log_record("Singular Mass Matrix encountered on element ", el.elidx);
+                return;
+            }
+            MATH::MATRIX::DenseMatrix<T> mass = calculate_mass_matrix(el);
+            for(std::size_t idof = 0; idof < ndof; ++idof){
+                for(std::size_t jdof = 0; jdof < ndof; ++jdof)
+                    { minv[idof * ndof + jdof] = mass[idof][jdof]; }
+            }
+            bool inverted = linalg::dispatch_basis_size(ndof, [&](auto N) -> bool {
+                return linalg::cholesky_invert<decltype(N)::value>(minv, ndof);
+            });
+            if(!inverted){
+                // not positive definite (i.e an inverted element): fall back to pivoted LU
+                for(std::size_t idof = 0; idof < ndof; ++idof){
+                    for(std::size_t jdof = 0; jdof < ndof; ++jdof)
+                        { minv[idof * ndof + jdof] = mass[idof][jdof]; }
+                }
+                std::vector<linalg::pivot_index> piv(ndof);
+                std::vector<T> work(ndof * ndof);
+                inverted = linalg::lu_invert(minv, piv.data(), work.data(), ndof);
+            }
+            if(!inverted){
+                // set to Identity on failure and log anomaly
+                std::fill_n(minv, ndof * ndof, 0.0);
+                for(std::size_t idof = 0; idof < ndof; ++idof)
+                    { minv[idof * ndof + idof] = 1.0; }
+                util::AnomalyLog::log_record("Singular Mass Matrix encountered on element ", el.elidx);
+            }
+        }
+    }
+
+    /**
+     * @brief block diagonal inverse mass matrix operator for DG spaces
+     * 
+     * The inverse of each element mass matrix is computed once and stored contiguously
+     * so that applying the inverse mass matrix is a dense matrix-vector product per element.
+     * update() only rebuilds the inverses when the mesh coordinates have changed
+     * (as tracked by AbstractMesh::coord_version)
+     *
+     * @tparam T the floating point type 
+     * @tparam IDX the index type
+     */
+    template<typename T, typename IDX>
+    class InverseMassOperator {
+        private:
+
+        /// @brief the inverse mass matrix entries for each element (row major) 
+        std::vector<T> minv_data{};
+
+        /// @brief the offset of the start of each element inverse mass matrix (size = nelem + 1)
+        std::vector<std::size_t> offsets{0};
+
+        /// @brief the mesh coordinate version the inverses were computed for 
+        std::size_t coord_version = 0;
+
+        /// @brief if the inverses have been computed at all
+        bool built = false;
+
+        public:
+
+        /// @brief default constructor: empty operator (must be built before use)
+        InverseMassOperator() = default;
+
+        /**
+         * @brief construct and build the inverse mass matrices 
+         * @param fespace the finite element space
+         */
+        template<int ndim>
+        InverseMassOperator(FESpace<T, IDX, ndim>& fespace)
+        { build(fespace); }
+
+        /**
+         * @brief compute the inverse mass matrices for every element (see impl::invert_mass_matrix)
+         * @param fespace the finite element space
+         */
+        template<int ndim>
+        auto build(FESpace<T, IDX, ndim>& fespace) -> void {
+            offsets.resize(fespace.elements.size() + 1);
+            offsets[0] = 0;
+            for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+                offsets[el.elidx + 1] = offsets[el.elidx] + el.nbasis() * el.nbasis();
+            }
+            minv_data.resize(offsets.back());
+
+            util::parallel_for(fespace.elements.size(), [&](std::size_t ielem){
+                const FiniteElement<T, IDX, ndim>& el = fespace.elements[ielem];
+                impl::invert_mass_matrix(el, minv_data.data() + offsets[el.elidx]);
+            });
+                if(!inverted){
+                    // not positive definite (i.e an inverted element): fall back to pivoted LU
+                    for(std::size_t idof = 0; idof < ndof; ++idof){
+                        for(std::size_t jdof = 0; jdof < ndof; ++jdof)
+                            { minv[idof * ndof + jdof] = mass[idof][jdof]; }
+                    }
+                    std::vector<linalg::pivot_index> piv(ndof);
+                    std::vector<T> work(ndof * ndof);
+                    inverted = linalg::lu_invert(minv, piv.data(), work.data(), ndof);
+                }
+                if(!inverted){
+                    // set to Identity on failure and log anomaly
+                    std::fill_n(minv, ndof * ndof, 0.0);
+                    for(std::size_t idof = 0; idof < ndof; ++idof)
+                        { minv[idof * ndof + idof] = 1.0; }
+                    util::AnomalyLog::log_record("Singular Mass Matrix encountered on element ", el.elidx);
+                }
+            });
+            coord_version = fespace.meshptr->coord_version;
+            built = true;
+        }
+
+        /**
+         * @brief rebuild the inverse mass matrices only if the mesh has moved since the last build 
+         * @param fespace the finite element space
+         */
+        template<int ndim>
+        auto update(FESpace<T, IDX, ndim>& fespace) -> void {
+            if(!built || coord_version != fespace.meshptr->coord_version)
+                build(fespace);
+        }
+
+        /**
+         * @brief get the inverse mass matrix of an element
+         * @param iel the element index 
+         * @return pointer to the row major (nbasis x nbasis) inverse mass matrix
+         */
+        auto element_data(IDX iel) const -> const T* 
+        { return minv_data.data() + offsets[iel]; }
+
+        /**
+         * @brief apply the inverse mass matrix 
+         * out = alpha * M^{-1} res + beta * out 
+         *
+         * NOTE: res and out must not overlap
+         *
+         * @param [in] alpha the multiplier for M^{-1} res 
+         * @param [in] res the global residual
+         * @param [in] beta the multiplier for out
+         * @param [in/out] out the global data to add to
+         */
+        template<class resLayoutPolicy, class resAccessorPolicy, class outLayoutPolicy, class outAccessorPolicy>
+        auto apply(
+            T alpha,
+            fespan<T, resLayoutPolicy, resAccessorPolicy> res,
+            T beta,
+            fespan<T, outLayoutPolicy, outAccessorPolicy> out
+        ) const -> void {
+            ICEICLE_PROFILE_REGION("inverse_mass");
+            if(util::Profiler::enabled()) {
+                [[maybe_unused]] kernel_work work = kernel_model::inverse_mass(minv_data.size(), res.size(), res.nv(), beta != 0.0, sizeof(T));
+                ICEICLE_PROFILE_WORK(work.flops, work.bytes);
+            }
+            const IDX nelem = offsets.size() - 1;
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+            for(IDX iel = 0; iel < nelem; ++iel){
+                const std::size_t ndof = res.ndof(iel);
+                const T* minv = minv_data.data() + offsets[iel];
+                for(std::size_t idof = 0; idof < ndof; ++idof){
+                    for(std::size_t iv = 0; iv < res.nv(); ++iv){
+                        T sum = 0.0;
+                        for(std::size_t jdof = 0; jdof < ndof; ++jdof)
+                            { sum += minv[idof * ndof + jdof] * res[iel, jdof, iv]; }
+                        if(beta == 0.0){
+                            out[iel, idof, iv] = alpha * sum;
+                        } else {
+                            out[iel, idof, iv] = alpha * sum + beta * out[iel, idof, iv];
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    /**
+     * @brief block diagonal inverse mass matrix operator that uses the tensor product structure
+     * of hypercube Lagrange elements (elements with a SumFactorization) and never forms their mass matrices
+     *
+     * - Collocated bases (Lagrange on the Gauss-Lobatto quadrature points, i.e DG-SEM):
+     *   the mass matrix is diagonal M_ii = w_i detJ_i so the inverse is a scale by 1 / (w_i detJ_i)
+     * - Affine elements: M = detJ (M_1d x ... x M_1d) so the inverse is
+     *   the Kronecker product of the 1D inverse mass matrices scaled by 1 / detJ
+     * - Curved elements (if weight_adjusted):
+     *   the weight adjusted approximation M_J^{-1} ~ M^{-1} M_{1/J} M^{-1} where M is the reference
+     *   mass matrix (Kronecker product) and M_{1/J} is applied by sum factorization.
+     *   This is not the exact inverse but is high order accurate (Chan, Hewett, Warburton 2017)
+     *
+     * Elements with an orthonormal basis (i.e Legendre) that are affine also use a diagonal scale
+     * by 1 / (detJ M_ref,ii) (see has_diagonal_mass)
+     *
+     * All other elements (and curved elements with weight_adjusted = false) store the dense
+     * inverse like InverseMassOperator. 
+     * Same interface as InverseMassOperator (other than element_data)
+     *
+     * @tparam T the floating point type 
+     * @tparam IDX the index type
+     */
+    template<typename T, typename IDX>
+    class TensorProductInverseMassOperator {
+        private:
+
+        /// @brief how the inverse mass matrix of an element is applied
+        enum class element_kind { dense, diagonal, kronecker, weight_adjusted };
+
+        /// @brief the 1D tables of a tensor product reference element
+        struct tensor_reference {
+            /// @brief the number of dimensions
+            int ndim;
+
+            /// @brief the number of 1D basis functions
+            int nbasis_1d;
+
+            /// @brief the number of 1D quadrature points
+            int nqp_1d;
+
+            /// @brief the 1D inverse mass matrix [nbasis_1d x nbasis_1d]
+            std::vector<T> minv_1d;
+
+            /// @brief the 1D basis functions at the 1D quadrature points [nqp_1d x nbasis_1d]
+            std::vector<T> interp_1d;
+        };
+
+        /// @brief the tensor product reference elements
+        std::vector<tensor_reference> refs{};
+
+        /// @brief the kind of each element
+        std::vector<element_kind> kinds{};
+
+        /// @brief the index of the tensor reference of each element (unused for dense elements)
+        std::vector<std::size_t> iref{};
+
+        /// @brief the per element data:
+        /// the row major inverse for dense elements, 1 / (w_i detJ_i) for diagonal elements,
+        /// 1 / detJ for kronecker elements and w_q / detJ_q at each quadrature point for weight adjusted elements
+        std::vector<T> el_data{};
+
+        /// @brief the offset of the start of each element data (size = nelem + 1)
+        std::vector<std::size_t> offsets{0};
+
+        /// @brief the per thread workspace size (right hand side, solution, and scratch for element_apply)
+        std::size_t work_size = 0;
+
+        /// @brief the per thread workspace
+        mutable std::vector<T> work{};
+
+        /// @brief the mesh coordinate version the inverses were computed for 
+        std::size_t coord_version = 0;
+
+        /// @brief if the inverses have been computed at all
+        bool built = false;
+
+        public:
+
+        /// @brief use the weight adjusted inverse for curved tensor product elements
+        /// (otherwise curved elements that are not collocated use the dense inverse)
+        bool weight_adjusted = false;
+
+        /// @brief default constructor: empty operator (must be built before use)
+        TensorProductInverseMassOperator() = default;
+
+        /**
+         * @brief construct and build the inverse mass operator
+         * @param fespace the finite element space
+         * @param weight_adjusted use the weight adjusted inverse for curved tensor product elements
+         */
+        template<int ndim>
+        TensorProductInverseMassOperator(FESpace<T, IDX, ndim>& fespace, bool weight_adjusted = false)
+        : weight_adjusted{weight_adjusted} { build(fespace); }
+
+        /**
+         * @brief compute the element data for every element
+         * On a singular mass matrix the identity is used and an anomaly is logged
+         * @param fespace the finite element space
+         */
+        template<int ndim>
+        auto build(FESpace<T, IDX, ndim>& fespace) -> void {
+            using Element = FiniteElement<T, IDX, ndim>;
+            const std::size_t nelem = fespace.elements.size();
+
+            // the 1D tables for each distinct sum factorization
+            util::small_flat_map<const SumFactorization<T, ndim>*, std::size_t> ref_index{};
+            refs.clear();
+            kinds.resize(nelem);
+            iref.assign(nelem, 0);
+            work_size = 0;
+            for(const Element& el : fespace.elements){
+                const SumFactorization<T, ndim>* sf = el.sum_fact;
+                const std::size_t ndof = el.nbasis();
+                kinds[el.elidx] = element_kind::dense;
+                if(has_diagonal_mass(el)) {
+                    kinds[el.elidx] = element_kind::diagonal;
+                    work_size = std::max(work_size, 2 * ndof);
+                    continue;
+                }
+                if(sf == nullptr || sf->nbasis() != el.nbasis() || sf->nqp() != el.nQP()) {
+                    work_size = std::max(work_size, 2 * ndof);
+                    continue;
+                }
+
+                iref[el.elidx] = ref_index.get_or_emplace(sf, [&]{
+                    const int nb = sf->nbasis_1d, nq = sf->nqp_1d;
+                    tensor_reference ref{ndim, nb, nq, std::vector<T>(nb * nb, 0.0), sf->interp_1d};
+                    for(int iqp = 0; iqp < nq; ++iqp){
+                        for(int ibasis = 0; ibasis < nb; ++ibasis){
+                            for(int jbasis = 0; jbasis < nb; ++jbasis){
+                                ref.minv_1d[ibasis * nb + jbasis] += sf->weights_1d[iqp] 
+                                    * sf->interp_1d[iqp * nb + ibasis] * sf->interp_1d[iqp * nb + jbasis];
+                            }
+                        }
+                    }
+                    linalg::cholesky_invert(ref.minv_1d.data(), nb);
+                    refs.push_back(std::move(ref));
+                    return refs.size() - 1;
+                });
+
+                if(sf->collocated()) kinds[el.elidx] = element_kind::diagonal;
+                else if(el.is_affine()) kinds[el.elidx] = element_kind::kronecker;
+                else if(weight_adjusted) kinds[el.elidx] = element_kind::weight_adjusted;
+                work_size = std::max(work_size,
+                        2 * ndof + sf->nqp() + sf->scratch_size() + ndof);
+            }
+
+            offsets.resize(nelem + 1);
+            offsets[0] = 0;
+            for(const Element& el : fespace.elements){
+                std::size_t size;
+                switch(kinds[el.elidx]){
+                    case element_kind::dense: size = el.nbasis() * el.nbasis(); break;
+                    case element_kind::diagonal: size = el.nbasis(); break;
+                    case element_kind::kronecker: size = 1; break;
+                    case element_kind::weight_adjusted: size = el.nQP(); break;
+                }
+                offsets[el.elidx + 1] = offsets[el.elidx] + size;
+            }
+            el_data.resize(offsets.back());
+
+            util::parallel_for(nelem, [&](std::size_t ielem){
+                const Element& el = fespace.elements[ielem];
+                T* data = el_data.data() + offsets[el.elidx];
+                auto detJ_at = [&el](int iqp) -> T {
+                    auto J = el.jacobian(el.getQP(iqp).abscisse);
+                    return NUMTOOL::TENSOR::FIXED_SIZE::determinant(J);
+                };
+                switch(kinds[el.elidx]){
+                    case element_kind::dense:
+                        impl::invert_mass_matrix(el, data);
+                        break;
+                    case element_kind::diagonal:
+                        if(has_diagonal_mass(el)){
+                            // orthonormal basis on an affine element
+                            if(!calculate_inverse_diagonal_mass(el, data)){
+                                std::fill_n(data, el.nbasis(), 1.0);
+                                util::AnomalyLog::log_record("Singular Mass Matrix encountered on element ", el.elidx);
+                            }
+                            break;
+                        }
+                        for(int idof = 0; idof < el.nbasis(); ++idof){
+                            T mii = el.getQP(idof).weight * detJ_at(idof);
+                            if(mii == 0){
+                                std::fill_n(data, el.nbasis(), 1.0);
+                                util::AnomalyLog::log_record("Singular Mass Matrix encountered on element ", el.elidx);
+                                break;
+                            }
+                            data[idof] = 1.0 / mii;
+                        }
+                        break;
+                    case element_kind::kronecker:
+                    {
+                        T detJ = detJ_at(0);
+                        data[0] = (detJ == 0) ? 1.0 : 1.0 / detJ;
+                        if(detJ == 0)
+                            util::AnomalyLog::log_record("Singular Mass Matrix encountered on element ", el.elidx);
+                        break;
+                    }
+                    case element_kind::weight_adjusted:
+                        for(int iqp = 0; iqp < el.nQP(); ++iqp){
+                            T detJ = detJ_at(iqp);
+                            if(detJ == 0){
+                                // drop the weight correction at this point and log anomaly
+                                util::AnomalyLog::log_record("Singular Mass Matrix encountered on element ", el.elidx);
+                                detJ = 1.0;
+                            }
+                            data[iqp] = el.getQP(iqp).weight / detJ;
+                        }
+                        break;
+                }
+            });
+            coord_version = fespace.meshptr->coord_version;
+            built = true;
+        }
+
+        /**
+         * @brief rebuild the element data only if the mesh has moved since the last build 
+         * @param fespace the finite element space
+         */
+        template<int ndim>
+        auto update(FESpace<T, IDX, ndim>& fespace) -> void {
+            if(!built || coord_version != fespace.meshptr->coord_version)
+                build(fespace);
+        }
+
+        /// @brief the scratch size required for element_apply()
+        auto scratch_size() const noexcept -> std::size_t { return work_size; }
+
+        /**
+         * @brief apply the inverse mass matrix of one element to a contiguous vector
+         * @param iel the element index
+         * @param ndof the number of degrees of freedom of the element
+         * @param [in] b the right hand side [ndof]
+         * @param [out] x M^{-1} b [ndof] (must not overlap b)
+         * @param scratch storage of at least scratch_size()
+         */
+        auto element_apply(IDX iel, std::size_t ndof, const T* b, T* x, T* scratch) const noexcept -> void {
+            const T* data = el_data.data() + offsets[iel];
+            switch(kinds[iel]){
+                case element_kind::dense:
+                    for(std::size_t idof = 0; idof < ndof; ++idof){
+                        T sum = 0.0;
+                        for(std::size_t jdof = 0; jdof < ndof; ++jdof)
+                            { sum += data[idof * ndof + jdof] * b[jdof]; }
+                        x[idof] = sum;
+                    }
+                    break;
+                case element_kind::diagonal:
+                    for(std::size_t idof = 0; idof < ndof; ++idof)
+                        { x[idof] = data[idof] * b[idof]; }
+                    break;
+                case element_kind::kronecker:
+                {
+                    const tensor_reference& ref = refs[iref[iel]];
+                    kronecker_apply(ref.ndim, ref.minv_1d.data(), ref.nbasis_1d, ref.nbasis_1d,
+                            false, b, x, scratch);
+                    for(std::size_t idof = 0; idof < ndof; ++idof) x[idof] *= data[0];
+                    break;
+                }
+                case element_kind::weight_adjusted:
+                {
+                    const tensor_reference& ref = refs[iref[iel]];
+                    const std::size_t nqp = offsets[iel + 1] - offsets[iel];
+                    T* u = scratch;
+                    T* q = u + ndof;
+                    T* kscratch = q + nqp;
+
+                    // u = M^{-1} b
+                    kronecker_apply(ref.ndim, ref.minv_1d.data(), ref.nbasis_1d, ref.nbasis_1d,
+                            false, b, u, kscratch);
+
+                    // u = M_{1/J} u = B^T diag(w / J) B u
+                    kronecker_apply(ref.ndim, ref.interp_1d.data(), ref.nqp_1d, ref.nbasis_1d,
+                            false, u, q, kscratch);
+                    for(std::size_t iqp = 0; iqp < nqp; ++iqp) q[iqp] *= data[iqp];
+                    kronecker_apply(ref.ndim, ref.interp_1d.data(), ref.nqp_1d, ref.nbasis_1d,
+                            true, q, u, kscratch);
+
+                    // x = M^{-1} u
+                    kronecker_apply(ref.ndim, ref.minv_1d.data(), ref.nbasis_1d, ref.nbasis_1d,
+                            false, u, x, kscratch);
+                    break;
+                }
+            }
+        }
+
+        /**
+         * @brief apply the inverse mass matrix of one element to several right hand sides at once
+         * (i.e every vector component of the element)
+         *
+         * The dense and diagonal inverses are applied to the whole block in one pass
+         * so each entry of the inverse is loaded once for all the right hand sides.
+         * The sum factorized inverses are applied one right hand side at a time.
+         *
+         * @param iel the element index
+         * @param ndof the number of degrees of freedom of the element
+         * @param nrhs the number of right hand sides
+         * @param [in] b the right hand sides [ndof x nrhs] (row major)
+         * @param [out] x M^{-1} b [ndof x nrhs] (row major, must not overlap b)
+         * @param scratch storage of at least scratch_size()
+         */
+        auto element_apply_block(IDX iel, std::size_t ndof, std::size_t nrhs, const T* b, T* x, T* scratch) const noexcept -> void {
+            const T* data = el_data.data() + offsets[iel];
+            switch(kinds[iel]){
+                case element_kind::dense:
+                    std::fill_n(x, ndof * nrhs, 0.0);
+                    for(std::size_t idof = 0; idof < ndof; ++idof){
+                        T* xrow = x + idof * nrhs;
+                        for(std::size_t jdof = 0; jdof < ndof; ++jdof){
+                            const T minv = data[idof * ndof + jdof];
+                            const T* brow = b + jdof * nrhs;
+                            for(std::size_t irhs = 0; irhs < nrhs; ++irhs) xrow[irhs] += minv * brow[irhs];
+                        }
+                    }
+                    break;
+                case element_kind::diagonal:
+                    for(std::size_t idof = 0; idof < ndof; ++idof){
+                        for(std::size_t irhs = 0; irhs < nrhs; ++irhs)
+                            { x[idof * nrhs + irhs] = data[idof] * b[idof * nrhs + irhs]; }
+                    }
+                    break;
+                default:
+                {
+                    T* bvec = scratch;
+                    T* xvec = bvec + ndof;
+                    for(std::size_t irhs = 0; irhs < nrhs; ++irhs){
+                        for(std::size_t idof = 0; idof < ndof; ++idof) bvec[idof] = b[idof * nrhs + irhs];
+                        element_apply(iel, ndof, bvec, xvec, xvec + ndof);
+                        for(std::size_t idof = 0; idof < ndof; ++idof) x[idof * nrhs + irhs] = xvec[idof];
+                    }
+                    break;
+                }
+            }
+        }
+
+        /**
+         * @brief apply the inverse mass matrix 
+         * out = alpha * M^{-1} res + beta * out 
+         *
+         * NOTE: res and out must not overlap
+         *
+         * @param [in] alpha the multiplier for M^{-1} res 
+         * @param [in] res the global residual
+         * @param [in] beta the multiplier for out
+         * @param [in/out] out the global data to add to
+         */
+        template<class resLayoutPolicy, class resAccessorPolicy, class outLayoutPolicy, class outAccessorPolicy>
+        auto apply(
+            T alpha,
+            fespan<T, resLayoutPolicy, resAccessorPolicy> res,
+            T beta,
+            fespan<T, outLayoutPolicy, outAccessorPolicy> out
+        ) const -> void {
+            const IDX nelem = offsets.size() - 1;
+            if(work.size() < work_size * util::max_threads())
+                work.resize(work_size * util::max_threads());
+            util::parallel_for(nelem, [&](IDX iel){
+                const std::size_t ndof = res.ndof(iel);
+                T* b = work.data() + util::thread_num() * work_size;
+                T* x = b + ndof;
+                T* scratch = x + ndof;
+                for(std::size_t iv = 0; iv < res.nv(); ++iv){
+                    for(std::size_t idof = 0; idof < ndof; ++idof)
+                        { b[idof] = res[iel, idof, iv]; }
+                    element_apply(iel, ndof, b, x, scratch);
+                    for(std::size_t idof = 0; idof < ndof; ++idof){
+                        if(beta == 0.0){
+                            out[iel, idof, iv] = alpha * x[idof];
+                        } else {
+                            out[iel, idof, iv] = alpha * x[idof] + beta * out[iel, idof, iv];
+                        }
+                    }
+                }
+            });
+        }
+    };
+
+    /**
+     * @brief block diagonal mass matrix operator for DG spaces
+     *
+     * The mass matrix of each element is computed once and stored contiguously (row major)
+     * update() only rebuilds when the mesh coordinates have changed
+     * (as tracked by AbstractMesh::coord_version)
+     *
+     * @tparam T the floating point type 
+     * @tparam IDX the index type
+     */
+    template<typename T, typename IDX>
+    class MassOperator {
+        private:
+
+        /// @brief the mass matrix entries for each element (row major) 
+        std::vector<T> mass_data{};
+
+        /// @brief the offset of the start of each element mass matrix (size = nelem + 1)
+        std::vector<std::size_t> offsets{0};
+
+        /// @brief the mesh coordinate version the mass matrices were computed for 
+        std::size_t coord_version = 0;
+
+        /// @brief if the mass matrices have been computed at all
+        bool built = false;
+
+        public:
+
+        /// @brief default constructor: empty operator (must be built before use)
+        MassOperator() = default;
+
+        /**
+         * @brief construct and build the mass matrices 
+         * @param fespace the finite element space
+         */
+        template<int ndim>
+        MassOperator(FESpace<T, IDX, ndim>& fespace)
+        { build(fespace); }
+
+        /**
+         * @brief compute the mass matrices for every element
+         * @param fespace the finite element space
+         */
+        template<int ndim>
+        auto build(FESpace<T, IDX, ndim>& fespace) -> void {
+            offsets.resize(fespace.elements.size() + 1);
+            offsets[0] = 0;
+            for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+                offsets[el.elidx + 1] = offsets[el.elidx] + el.nbasis() * el.nbasis();
+            }
+            mass_data.resize(offsets.back());
+            for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+                const std::size_t ndof = el.nbasis();
+                T* mass_el = mass_data.data() + offsets[el.elidx];
+                MATH::MATRIX::DenseMatrix<T> mass = calculate_mass_matrix(el);
+                for(std::size_t idof = 0; idof < ndof; ++idof){
+                    for(std::size_t jdof = 0; jdof < ndof; ++jdof)
+                        { mass_el[idof * ndof + jdof] = mass[idof][jdof]; }
+                }
+            }
+            coord_version = fespace.meshptr->coord_version;
+            built = true;
+        }
+
+        /**
+         * @brief rebuild the mass matrices only if the mesh has moved since the last build 
+         * @param fespace the finite element space
+         */
+        template<int ndim>
+        auto update(FESpace<T, IDX, ndim>& fespace) -> void {
+            if(!built || coord_version != fespace.meshptr->coord_version)
+                build(fespace);
+        }
+
+        /**
+         * @brief get the mass matrix of an element
+         * @param iel the element index 
+         * @return pointer to the row major (nbasis x nbasis) mass matrix
+         */
+        auto element_data(IDX iel) const -> const T* 
+        { return mass_data.data() + offsets[iel]; }
+
+        /**
+         * @brief apply the mass matrix 
+         * out = alpha * M u + beta * out 
+         *
+         * NOTE: u and out must not overlap
+         *
+         * @param [in] alpha the multiplier for M u
+         * @param [in] u the global data to multiply
+         * @param [in] beta the multiplier for out
+         * @param [in/out] out the global data to add to
+         */
+        template<class uLayoutPolicy, class uAccessorPolicy, class outLayoutPolicy, class outAccessorPolicy>
+        auto apply(
+            T alpha,
+            fespan<T, uLayoutPolicy, uAccessorPolicy> u,
+            T beta,
+            fespan<T, outLayoutPolicy, outAccessorPolicy> out
+        ) const -> void {
+            const IDX nelem = offsets.size() - 1;
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+            for(IDX iel = 0; iel < nelem; ++iel){
+                const std::size_t ndof = u.ndof(iel);
+                const T* mass_el = mass_data.data() + offsets[iel];
+                for(std::size_t idof = 0; idof < ndof; ++idof){
+                    for(std::size_t iv = 0; iv < u.nv(); ++iv){
+                        T sum = 0.0;
+                        for(std::size_t jdof = 0; jdof < ndof; ++jdof)
+                            { sum += mass_el[idof * ndof + jdof] * u[iel, jdof, iv]; }
+                        if(beta == 0.0){
+                            out[iel, idof, iv] = alpha * sum;
+                        } else {
+                            out[iel, idof, iv] = alpha * sum + beta * out[iel, idof, iv];
+                        }
+                    }
+                }
+            }
+        }
+    };
 }
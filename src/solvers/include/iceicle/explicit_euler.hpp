@@ -10,6 +10,8 @@
 #include "iceicle/element/finite_element.hpp"
 #include "iceicle/fespace/fespace.hpp"
 #include "iceicle/form_residual.hpp"
+#include "iceicle/cg_assembly.hpp"
+#include "iceicle/element_linear_solve.hpp"
 #include "iceicle/explicit_utils.hpp"
 
 #include <iostream>
@@ -30,6 +32,15 @@ public:
     /// @brief the residual data array
     std::vector<T> res_data;
 
+    /// @brief persistent storage for residual evaluation
+    ResidualWorkspace<T, IDX> workspace;
+
+    /// @brief the cached inverse mass operator (matrix free for tensor product elements)
+    TensorProductInverseMassOperator<T, IDX> inv_mass;
+
+    /// @brief the residual and global mass matrix for continuous (cg layout) solutions
+    CGExplicitRhs<T, IDX> cg_rhs;
+
     /// @brief the current timestep 
     IDX itime = 0;
 
@@ -38,16 +49,12 @@ public:
 
     /// @brief the callback function for visualization during solve()
     /// is given a reference to this when called 
-    /// default is to print out a l2 norm of the residual data array
+    /// default is to print out the l2 norm of the residual (see ResidualWorkspace::monitor)
     std::function<void(ExplicitEuler &)> vis_callback = [](ExplicitEuler &disc){
-        T sum = 0.0;
-        for(int i = 0; i < disc.res_data.size(); ++i){
-            sum += SQUARED(disc.res_data[i]);
-        }
         std::cout << std::setprecision(8);
         std::cout << "itime: " << std::setw(6) << disc.itime 
             << " | t: " << std::setw(14) << disc.time
-            << " | residual l2: " << std::setw(14) << std::sqrt(sum) 
+            << " | residual l2: " << std::setw(14) << disc.workspace.monitor.l2() 
             << std::endl;
     };
 
@@ -73,8 +80,9 @@ public:
     )
     requires specifies_ncomp<disc_class> && TerminationCondition<StopCondition>
     : res_data(fespace.dg_map.calculate_size_requirement(disc_class::nv_comp)),
-      timestep{timestep}, stop_condition{stop_condition}
-    {}
+      timestep{timestep}, stop_condition{stop_condition},
+      workspace{fespace, disc_class::dnv_comp}, inv_mass{fespace}
+    { workspace.enable_norm_monitor(disc_class::dnv_comp); }
 
     /**
      * @brief perform a single timestep 
@@ -89,6 +97,9 @@ public:
     requires TimestepT<TimestepClass, T, IDX, ndim, disc_class, LayoutPolicy, uAccessorPolicy>
     {
        
+        // update the solution dependent data cached by the discretization (once per step)
+        update_cached_state(fespace, disc, u);
+
         // calculate the timestep 
         T dt = timestep(fespace, disc, u);
 
@@ -98,38 +109,13 @@ public:
         // create view of the residual using the same Layout as u 
         fespan res{res_data.data(), u.get_layout()};
 
-        // get the rhs
-        form_residual(fespace, disc, u, res);
-
-        // storage for rhs of mass matrix equation
-        int max_ndof = fespace.dg_map.max_el_size_reqirement(1);
-        std::vector<T> b(max_ndof);
-        std::vector<T> du(max_ndof);
-
-        // TODO: prestore mass matrix with the reference element 
-        // TODO: need to build a global mass matrix if doing CG (but not for DG)
-        for(FiniteElement<T, IDX, ndim> &el : fespace.elements){
-            using namespace MATH::MATRIX;
-            using namespace MATH::MATRIX::SOLVERS;
-            DenseMatrix<T> mass = calculate_mass_matrix(el);
-            PermutationMatrix<unsigned int> pi = decompose_lu(mass);
-
-            const IDX ndof = el.nbasis();
-            for(IDX ieqn = 0; ieqn < disc_class::nv_comp; ++ieqn){
-
-                // copy the residual for each degree of freedom to the rhs 
-                for(IDX idof = 0; idof < el.nbasis(); ++idof){
-                    b[idof] = res[el.elidx, idof, ieqn];
-                }
-
-                // solve the matrix equation 
-                sub_lu(mass, pi, b.data(), du.data());
-
-                // TODO: add to u 
-                for(IDX idof = 0; idof < el.nbasis(); ++idof){
-                    u[el.elidx, idof, ieqn] += dt * du[idof];
-                }
-            }
+        // u += dt * M^{-1} res
+        if constexpr (cg_layout<LayoutPolicy>) {
+            cg_rhs(fespace, disc, u, res, dt, 1.0, u);
+        } else {
+            form_residual(fespace, disc, u, res, workspace);
+            inv_mass.update(fespace);
+            inv_mass.apply(dt, res, 1.0, u);
         }
 
         // update the timestep and time
@@ -157,7 +143,7 @@ public:
             fespan res{res_data.data(), u.get_layout()};
 
             // get the rhs
-            form_residual(fespace, disc, u, res);
+            form_residual(fespace, disc, u, res, workspace);
         }
 
         // visualization callback on initial state (0 % anything == 0) 
@@ -5,9 +5,19 @@
  */
 #pragma once
 #include "Numtool/fixed_size_tensor.hpp"
+#include "iceicle/element_linear_solve.hpp"
 #include "iceicle/fe_function/fespan.hpp"
 #include "iceicle/fespace/fespace.hpp"
+#include "iceicle/form_residual.hpp"
+#include "iceicle/residual_workspace.hpp"
+#include "iceicle/thread_utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <span>
 #include <variant>
+#include <vector>
 namespace iceicle::solvers{
 
     // ==========================
@@ -54,38 +64,156 @@ namespace iceicle::solvers{
         ) const noexcept { return dt; }
     };
 
+    /**
+     * @brief a discretization that records the maximum wavespeed of each element 
+     * during the residual evaluation (see ConservationLawDDG::track_element_wavespeeds)
+     */
+    template<class disc_T, class T>
+    concept element_wavespeed_disc = requires(disc_T& disc, T scalar) {
+        { disc.track_element_wavespeeds } -> std::convertible_to<bool>;
+        { disc.element_wavespeeds } -> std::convertible_to<std::vector<T>>;
+        { disc.dt_from_cfl(scalar, scalar, scalar) } -> std::convertible_to<T>;
+    };
+
     /**
      * @brief determine the timestep based on the CFL condition 
      * of the discretization
+     *
+     * The reference length (ndim-th root of the jacobian determinant at the centroid) 
+     * and polynomial order of each element are cached and only recomputed when the mesh has moved
+     * (as tracked by AbstractMesh::coord_version)
+     *
+     * If the discretization can record element wavespeeds (element_wavespeed_disc), 
+     * this turns the tracking on and each element gets its own timestep from its own wavespeed
+     * (from the residual evaluation of the previous step). 
+     * The global timestep is the minimum of the element timesteps.
+     * Otherwise the global wavespeed of the discretization is used with the minimum reference length
      */
     template<class T, class IDX>
     struct CFLTimestep {
         T cfl = 0.3;
 
+        private:
+
+        /// @brief the cached reference length of each element
+        mutable std::vector<T> reflens{};
+
+        /// @brief the cached polynomial order of each element (at least 1)
+        mutable std::vector<int> orders{};
+
+        /// @brief the mesh coordinate version the reference lengths were computed for
+        mutable std::size_t coord_version = 0;
+
+        /// @brief the timestep of each element from the last call
+        mutable std::vector<T> dt_el{};
+
+        /// @brief update the cached reference lengths if the mesh has moved
+        template<int ndim>
+        auto update_reference_lengths(FESpace<T, IDX, ndim> &fespace) const -> void {
+            if(reflens.size() == fespace.elements.size() && coord_version == fespace.meshptr->coord_version)
+                return;
+            reflens.resize(fespace.elements.size());
+            orders.resize(fespace.elements.size());
+            util::parallel_for(fespace.elements.size(), [&](std::size_t iel){
+                const FiniteElement<T, IDX, ndim> &el = fespace.elements[iel];
+                MATH::GEOMETRY::Point<T, ndim> center_xi = el.trans->centroid_ref();
+                auto J = el.jacobian(center_xi);
+                // TODO: switch to min eigenvalues of jacobian
+                // since the determinant is the product of the eigenvalues, 
+                // we can take the ndim-th root to approximate based on isotropic transformation
+                reflens[el.elidx] = std::pow(NUMTOOL::TENSOR::FIXED_SIZE::determinant(J), 1.0 / ndim);
+                orders[el.elidx] = std::max(1, el.basis->getPolynomialOrder());
+            });
+            coord_version = fespace.meshptr->coord_version;
+        }
+
+        /**
+         * @brief compute the element timesteps into dt_el 
+         * @return false if the element wavespeeds are not available (yet)
+         */
+        template<class disc_T>
+        auto compute_element_timesteps(disc_T &disc) const -> bool {
+            if constexpr (element_wavespeed_disc<disc_T, T>) {
+                const std::size_t nelem = reflens.size();
+                bool available = disc.track_element_wavespeeds && disc.element_wavespeeds.size() == nelem;
+                disc.track_element_wavespeeds = true;
+                if(!available){
+                    // start recording for the next residual evaluation
+                    disc.element_wavespeeds.assign(nelem, 0.0);
+                    return false;
+                }
+                dt_el.resize(nelem);
+                util::parallel_for(nelem, [&](std::size_t iel){
+                    dt_el[iel] = disc.dt_from_cfl(cfl, reflens[iel], disc.element_wavespeeds[iel]) 
+                        / (2 * orders[iel] + 1);
+                });
+                return true;
+            } else {
+                return false;
+            }
+        }
+
+        public:
+
         template< int ndim, class disc_T, class LayoutPolicy, class AccessorPolicy >
         inline T operator()(
             FESpace<T, IDX, ndim> &fespace,
             disc_T &disc,
             fespan<T, LayoutPolicy, AccessorPolicy> u
-        ) const noexcept {
+        ) const {
+            update_reference_lengths(fespace);
+
+            // element local wavespeeds
+            if(compute_element_timesteps(disc)){
+                T dt = std::numeric_limits<T>::max();
+                for(T dt_iel : dt_el) dt = std::min(dt, dt_iel);
+                return dt;
+            }
 
-            // first: reference length is the minimum diagonal entry of the jacobian at the cell center
+            // global wavespeed: the reference length is the minimum over the elements
             T reflen = 1e8;
             int Pn_max = 1;
-            for(const FiniteElement<T, IDX, ndim> &el : fespace.elements){
-                MATH::GEOMETRY::Point<T, ndim> center_xi = el.trans->centroid_ref();
-                auto J = el.jacobian(center_xi);
-                // TODO: switch to min eigenvalues of jacobian
-                // since the determinant is the product of the eigenvalues, 
-                // we can take the ndim-th root to approximate based on isotropic transformation
-                reflen = std::min(reflen,
-                        std::pow(NUMTOOL::TENSOR::FIXED_SIZE::determinant(J), 1.0 / ndim));
-
-                Pn_max = std::max(Pn_max, el.basis->getPolynomialOrder());
+            for(std::size_t iel = 0; iel < reflens.size(); ++iel){
+                reflen = std::min(reflen, reflens[iel]);
+                Pn_max = std::max(Pn_max, orders[iel]);
             }
 
             // calculate the timestep from the CFL condition 
-            return disc.dt_from_cfl(cfl, reflen) / (2 * Pn_max + 1);
+            T dt = disc.dt_from_cfl(cfl, reflen) / (2 * Pn_max + 1);
+            dt_el.assign(reflens.size(), dt);
+            return dt;
+        }
+
+        /**
+         * @brief the timestep of each element from the last call to operator() or local_timesteps()
+         * (the global timestep for every element if element wavespeeds were not available)
+         */
+        auto element_timesteps() const noexcept -> std::span<const T> { return dt_el; }
+
+        /**
+         * @brief the local timestep of each element from the CFL condition 
+         * using the element reference length and polynomial order 
+         * (for local timestepping in pseudo-transient continuation)
+         *
+         * @param fespace the finite element space 
+         * @param disc the discretization 
+         * @param u the current solution
+         * @return the timestep for each element
+         */
+        template< int ndim, class disc_T, class LayoutPolicy, class AccessorPolicy >
+        auto local_timesteps(
+            FESpace<T, IDX, ndim> &fespace,
+            disc_T &disc,
+            fespan<T, LayoutPolicy, AccessorPolicy> u
+        ) const -> std::vector<T> {
+            update_reference_lengths(fespace);
+            if(!compute_element_timesteps(disc)){
+                dt_el.resize(reflens.size());
+                util::parallel_for(reflens.size(), [&](std::size_t iel){
+                    dt_el[iel] = disc.dt_from_cfl(cfl, reflens[iel]) / (2 * orders[iel] + 1);
+                });
+            }
+            return dt_el;
         }
     };
 
@@ -164,4 +292,82 @@ namespace iceicle::solvers{
     /** @brief a variant of all the termination classes */
     template<class T, class IDX>
     using TerminationVariant = std::variant<TimestepTermination<T, IDX>, TfinalTermination<T, IDX> >;
+
+    // ============================
+    // = Fused Runge-Kutta Stages =
+    // ============================
+
+    /**
+     * @brief a Runge-Kutta stage in the Shu-Osher form in a single pass over the elements
+     *   y = alpha * x + beta * w + gamma * M^{-1} R(w)
+     *
+     * As each element residual completes in form_residual, the inverse mass matrix is applied 
+     * and the stage update is written while the element data is still in cache. 
+     * The stage derivative M^{-1} R(w) is never stored globally.
+     *
+     * y must not be w (the neighbors of an element still read w after it completes)
+     * but may be x. For multistage schemes, ping-pong between two stage buffers
+     * (swapping the buffers instead of copying) and write the last stage to the solution.
+     *
+     * The per thread storage is allocated on the first stage and reused after
+     *
+     * @tparam T the floating point type
+     * @tparam IDX the index type
+     */
+    template<class T, class IDX>
+    class FusedRKStage {
+        /// @brief the per thread storage for the inverse mass matrix application
+        std::vector<T> work{};
+
+        public:
+
+        /**
+         * @brief evaluate the stage 
+         * @param fespace the finite element space 
+         * @param disc the discretization 
+         * @param workspace the residual workspace constructed from this fespace
+         * @param inv_mass the inverse mass operator (up to date with the mesh)
+         * @param w the stage solution the residual is evaluated at
+         * @param res the residual storage (holds R(w) after)
+         * @param alpha the multiplier of x 
+         * @param x the solution at the start of the step
+         * @param beta the multiplier of w 
+         * @param gamma the multiplier of the stage derivative (i.e the timestep times the stage coefficient)
+         * @param [out] y the updated stage solution
+         */
+        template<int ndim, class disc_class, class LayoutPolicy, 
+            class wAccessorPolicy, class xAccessorPolicy, class yAccessorPolicy>
+        auto operator()(
+            FESpace<T, IDX, ndim> &fespace,
+            disc_class &disc,
+            ResidualWorkspace<T, IDX> &workspace,
+            const TensorProductInverseMassOperator<T, IDX> &inv_mass,
+            fespan<T, LayoutPolicy, wAccessorPolicy> w,
+            fespan<T, LayoutPolicy> res,
+            T alpha,
+            fespan<T, LayoutPolicy, xAccessorPolicy> x,
+            T beta,
+            T gamma,
+            fespan<T, LayoutPolicy, yAccessorPolicy> y
+        ) -> void {
+            const std::size_t work_size = inv_mass.scratch_size();
+            if(work.size() < work_size * workspace.nthread)
+                work.resize(work_size * workspace.nthread);
+            form_residual(fespace, disc, w, res, workspace, [&](IDX iel, int ithread){
+                const std::size_t ndof = res.ndof(iel);
+                T* b = work.data() + ithread * work_size;
+                T* k = b + ndof;
+                T* scratch = k + ndof;
+                for(std::size_t iv = 0; iv < res.nv(); ++iv){
+                    for(std::size_t idof = 0; idof < ndof; ++idof)
+                        { b[idof] = res[iel, idof, iv]; }
+                    inv_mass.element_apply(iel, ndof, b, k, scratch);
+                    for(std::size_t idof = 0; idof < ndof; ++idof){
+                        y[iel, idof, iv] = alpha * x[iel, idof, iv] 
+                            + beta * w[iel, idof, iv] + gamma * k[idof];
+                    }
+                }
+            });
+        }
+    };
 }
@@ -4,6 +4,8 @@
 #include "iceicle/fe_function/node_set_layout.hpp"
 #include "iceicle/form_residual.hpp"
 #include "iceicle/linalg/linalg_utils.hpp"
+#include "iceicle/profiler.hpp"
+#include "iceicle/thread_utils.hpp"
 
 namespace iceicle::solvers{
 
@@ -25,6 +27,7 @@ namespace iceicle::solvers{
         T epsilon = std::sqrt(std::numeric_limits<T>::epsilon())
     ) -> void {
         using namespace util;
+        ICEICLE_PROFILE_REGION("form_jacobian_dense");
         // check sizes
         if(jac.extent(0) < res.size()){
             AnomalyLog::log_anomaly(Anomaly{"jacobian rows is less than number of equations", general_anomaly_tag{}});
@@ -42,9 +45,9 @@ namespace iceicle::solvers{
             T uold = u[jdof];
             u[jdof] += epsilon;
             form_residual(fespace, disc, nodeset, u, std::span{resp}, neq_mdg_arg);
-            for(IDX ieq = 0; ieq < res.size(); ++ieq){
+            util::parallel_for(res.size(), [&](std::size_t ieq){
                 jac[ieq, jdof] = (resp[ieq] - res[ieq]) / epsilon;
-            }
+            });
             u[jdof] = uold;
         }
 
@@ -67,6 +70,7 @@ namespace iceicle::solvers{
         T epsilon = std::sqrt(std::numeric_limits<T>::epsilon())
     ) -> void {
         using namespace util;
+        ICEICLE_PROFILE_REGION("form_jacobian_dense");
         // check sizes
         if(jac.extent(0) < res.size()){
             AnomalyLog::log_anomaly(Anomaly{"jacobian rows is less than number of equations", general_anomaly_tag{}});
@@ -84,9 +88,9 @@ namespace iceicle::solvers{
             T uold = u[jdof];
             u[jdof] += epsilon;
             form_residual(fespace, disc, geo_map, u, std::span{resp});
-            for(IDX ieq = 0; ieq < res.size(); ++ieq){
+            util::parallel_for(res.size(), [&](std::size_t ieq){
                 jac[ieq, jdof] = (resp[ieq] - res[ieq]) / epsilon;
-            }
+            });
             u[jdof] = uold;
         }
 
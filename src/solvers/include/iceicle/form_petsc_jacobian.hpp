@@ -7,20 +7,80 @@
 #include "iceicle/fespace/fespace.hpp"
 #include "iceicle/fe_function/fespan.hpp"
 #include "iceicle/fe_function/component_span.hpp"
+#include "iceicle/fe_function/node_set_layout.hpp"
 #include "iceicle/form_residual.hpp"
 #include "iceicle/geometry/face.hpp"
 #include "iceicle/petsc_interface.hpp"
 #include "iceicle/fd_utils.hpp"
+#include "iceicle/graph_coloring.hpp"
+#include "iceicle/profiler.hpp"
+#include <algorithm>
+#include <concepts>
 #include <cmath>
 #include <limits>
 #include <petscsystypes.h>
 #include <set>
+#include <span>
 #include <petscerror.h>
 #include <petscmat.h>
 #include <mdspan/mdspan.hpp>
 
 namespace iceicle::solvers {
 
+    /// @brief the discretization can compute the jacobian of the domain integral directly
+    template<class disc_class, class ElementT, class USpan, class JacSpan>
+    concept provides_domain_jacobian = requires(
+        disc_class& disc,
+        const ElementT& el,
+        USpan u_el,
+        JacSpan jac_el
+    ) {
+        disc.domain_integral_jacobian(el, u_el, jac_el);
+    };
+
+    /// @brief the discretization can compute the jacobian of the interior trace integral directly
+    template<class disc_class, class TraceT, class CoordT, class USpan, class JacSpan>
+    concept provides_trace_jacobian = requires(
+        disc_class& disc,
+        const TraceT& trace,
+        CoordT& coord,
+        USpan uL,
+        USpan uR,
+        JacSpan jac
+    ) {
+        disc.trace_integral_jacobian(trace, coord, uL, uR, jac, jac, jac, jac);
+    };
+
+    /// @brief the discretization can compute the jacobian of the boundary integral directly
+    /// returns false if not implemented for the boundary condition of the given trace 
+    template<class disc_class, class TraceT, class CoordT, class USpan, class JacSpan>
+    concept provides_boundary_jacobian = requires(
+        disc_class& disc,
+        const TraceT& trace,
+        CoordT& coord,
+        USpan uL,
+        USpan uR,
+        JacSpan jac
+    ) {
+        { disc.boundary_integral_jacobian(trace, coord, uL, uR, jac) } -> std::convertible_to<bool>;
+    };
+
+    /// @brief the discretization can compute the exact derivatives of the interface conservation
+    /// residual wrt the coordinates of a node
+    /// returns false if not implemented for the given trace
+    template<class disc_class, class TraceT, class CoordT, class USpan, class IDX, class JacSpan>
+    concept provides_interface_shape_jacobian = requires(
+        disc_class& disc,
+        const TraceT& trace,
+        CoordT& coord,
+        USpan uL,
+        USpan uR,
+        IDX inode,
+        JacSpan jac
+    ) {
+        { disc.interface_conservation_shape_jacobian(trace, coord, uL, uR, inode, jac) } -> std::convertible_to<bool>;
+    };
+
     /**
      * @brief form the jacobian for the given discretization on the given 
      * finite element space using finite differences.
@@ -28,6 +88,10 @@ namespace iceicle::solvers {
      * The ordering of vector components in the jacobian will match the layout provided
      * for the residual view
      *
+     * If the discretization provides domain_integral_jacobian, trace_integral_jacobian, 
+     * or boundary_integral_jacobian, those are used for the respective integrals 
+     * and finite differences are used otherwise
+     *
      * @tparam T the floaating point type
      * @tparam IDX the index type 
      * @tparam ndim the number of dimensions 
@@ -61,6 +125,7 @@ namespace iceicle::solvers {
         T epsilon = std::sqrt(std::numeric_limits<T>::epsilon()),
         MPI_Comm comm = MPI_COMM_WORLD 
     ) {
+        ICEICLE_PROFILE_REGION("form_jacobian");
 
         using Element = FiniteElement<T, IDX, ndim>;
         using Trace = TraceSpace<T, IDX, ndim>;
@@ -78,6 +143,8 @@ namespace iceicle::solvers {
         // get the start indices for the petsc matrix on this processor
         PetscInt proc_range_beg, proc_range_end;
         PetscCallAbort(comm, MatGetOwnershipRange(jac, &proc_range_beg, &proc_range_end));
+        PetscInt proc_col_beg, proc_col_end;
+        PetscCallAbort(comm, MatGetOwnershipRangeColumn(jac, &proc_col_beg, &proc_col_end));
 
         // storage for local solution
         std::vector<T> uL_data(max_local_size);
@@ -92,9 +159,17 @@ namespace iceicle::solvers {
         // storage for compact jacobians
         std::vector<T> jacL_data(max_local_size * max_local_size);
         std::vector<T> jacR_data(max_local_size * max_local_size);
+        std::vector<T> jacLR_data(max_local_size * max_local_size);
+        std::vector<T> jacRR_data(max_local_size * max_local_size);
 
-        // boundary faces 
+        // types for the compact views to detect analytic jacobians
+        using compact_uspan_t = decltype(dofspan{uL_data.data(), u.create_element_layout(0)});
+        using compact_jac_t = decltype(mdspan{jacL_data.data(), extents{max_local_size, max_local_size}});
+        using coord_t = decltype(fespace.meshptr->coord);
+
+        // boundary faces (excluding parallel communication)
         for(const Trace &trace : fespace.get_boundary_traces()) {
+            if(trace.face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) continue;
             // compact data views 
             dofspan uL{uL_data.data(), u.create_element_layout(trace.elL.elidx)};
             dofspan uR{uR_data.data(), u.create_element_layout(trace.elR.elidx)};
@@ -118,13 +193,19 @@ namespace iceicle::solvers {
             disc.boundaryIntegral(trace, fespace.meshptr->coord, uL, uR, resL);
             scatter_elspan(trace.elL.elidx, 1.0, resL, 1.0, res);
 
+            std::size_t glob_index_L = u.get_layout()[trace.elL.elidx, 0, 0];
+
+            // use the analytic jacobian if available for this boundary condition
+            bool analytic_jac = false;
+            if constexpr (provides_boundary_jacobian<disc_class, Trace, coord_t, compact_uspan_t, compact_jac_t>) {
+                analytic_jac = disc.boundary_integral_jacobian(trace, fespace.meshptr->coord, uL, uR, jacL);
+            }
+
             // set up the perturbation amount scaled by unperturbed residual 
             T eps_scaled = scale_fd_epsilon(epsilon, resL.vector_norm());
 
-            std::size_t glob_index_L = u.get_layout()[trace.elL.elidx, 0, 0];
-
             // perturb and form jacobian 
-            for(IDX idofu = 0; idofu < trace.elL.nbasis(); ++idofu){
+            if(!analytic_jac) for(IDX idofu = 0; idofu < trace.elL.nbasis(); ++idofu){
                 for(IDX iequ = 0; iequ < ncomp; ++iequ){
                     // get the compact column index for this dof and component 
                     IDX jcol = uL.get_layout()[idofu, iequ];
@@ -154,7 +235,7 @@ namespace iceicle::solvers {
 
             // TODO: change to a scatter generalized operation to support CG structures
             petsc::add_to_petsc_mat(jac, proc_range_beg + glob_index_L, 
-                    proc_range_beg + glob_index_L, jacL);
+                    proc_col_beg + glob_index_L, jacL);
         }
 
         // interior faces 
@@ -187,6 +268,29 @@ namespace iceicle::solvers {
             std::size_t glob_index_L = u.get_layout()[trace.elL.elidx, 0, 0];
             std::size_t glob_index_R = u.get_layout()[trace.elR.elidx, 0, 0];
 
+            if constexpr (provides_trace_jacobian<disc_class, Trace, coord_t, compact_uspan_t, compact_jac_t>) {
+                // analytic jacobian of the trace integral
+                mdspan jacLL{jacL_data.data(), extents{resL.size(), uL.size()}};
+                mdspan jacRL{jacR_data.data(), extents{resR.size(), uL.size()}};
+                mdspan jacLR{jacLR_data.data(), extents{resL.size(), uR.size()}};
+                mdspan jacRR{jacRR_data.data(), extents{resR.size(), uR.size()}};
+                std::fill_n(jacL_data.begin(), jacLL.size(), 0);
+                std::fill_n(jacR_data.begin(), jacRL.size(), 0);
+                std::fill_n(jacLR_data.begin(), jacLR.size(), 0);
+                std::fill_n(jacRR_data.begin(), jacRR.size(), 0);
+                disc.trace_integral_jacobian(trace, fespace.meshptr->coord, uL, uR,
+                        jacLL, jacLR, jacRL, jacRR);
+                petsc::add_to_petsc_mat(jac, proc_range_beg + glob_index_L, 
+                        proc_col_beg + glob_index_L, jacLL);
+                petsc::add_to_petsc_mat(jac, proc_range_beg + glob_index_R, 
+                        proc_col_beg + glob_index_L, jacRL);
+                petsc::add_to_petsc_mat(jac, proc_range_beg + glob_index_L, 
+                        proc_col_beg + glob_index_R, jacLR);
+                petsc::add_to_petsc_mat(jac, proc_range_beg + glob_index_R, 
+                        proc_col_beg + glob_index_R, jacRR);
+                continue;
+            }
+
             // set up the perturbation amount scaled by unperturbed residual 
             T eps_scaled = scale_fd_epsilon(epsilon, std::max(resL.vector_norm(), resR.vector_norm()));
 
@@ -233,9 +337,9 @@ namespace iceicle::solvers {
             // send the jacobians to the petsc matrix 
             // (note global indices uL, then resL/resR)
             petsc::add_to_petsc_mat(jac, proc_range_beg + glob_index_L, 
-                    proc_range_beg + glob_index_L, jacL);
+                    proc_col_beg + glob_index_L, jacL);
             petsc::add_to_petsc_mat(jac, proc_range_beg + glob_index_R, 
-                    proc_range_beg + glob_index_L, jacR);
+                    proc_col_beg + glob_index_L, jacR);
             
             // perturb and form jacobian wrt uR
             // make compact jacobian views
@@ -279,40 +383,473 @@ namespace iceicle::solvers {
             }
             // send the jacobians to the petsc matrix 
             petsc::add_to_petsc_mat(jac, proc_range_beg + glob_index_L, 
-                    proc_range_beg + glob_index_R, jacL);
+                    proc_col_beg + glob_index_R, jacL);
             petsc::add_to_petsc_mat(jac, proc_range_beg + glob_index_R, 
-                    proc_range_beg + glob_index_R, jacR);
+                    proc_col_beg + glob_index_R, jacR);
         }
 
-        // domain integral 
-        for(const Element &el : fespace.elements) {
-            // compact data views 
-            dofspan u_el{uL_data.data(), u.create_element_layout(el.elidx)};
+        // domain integral batched by element type
+        for(IDX ibatch = 0; ibatch < fespace.element_batches.nrow(); ++ibatch){
+            fespace.dispatch_element_kernel(ibatch, [&](auto trans_tag, auto sizes_tag, std::span<const IDX> elidxs){
+                for(IDX iel : elidxs) {
+                    const Element &el = fespace.elements[iel];
 
-            // residual data views 
-            dofspan res_el{resL_data.data(), res.create_element_layout(el.elidx)};
-            dofspan resp_el{resLp_data.data(), res.create_element_layout(el.elidx)};
+                    // compact data views 
+                    dofspan u_el{uL_data.data(), u.create_element_layout(el.elidx)};
 
-            // jacobian data view
-            mdspan jac_el{jacL_data.data(), extents{res_el.size(), u_el.size()}};
-            std::fill_n(jacL_data.begin(), jac_el.size(), 0);
+                    // residual data views 
+                    dofspan res_el{resL_data.data(), res.create_element_layout(el.elidx)};
+                    dofspan resp_el{resLp_data.data(), res.create_element_layout(el.elidx)};
 
+                    // jacobian data view
+                    mdspan jac_el{jacL_data.data(), extents{res_el.size(), u_el.size()}};
+                    std::fill_n(jacL_data.begin(), jac_el.size(), 0);
 
-            // extract the compact values from the global u view 
-            extract_elspan(el.elidx, u, u_el);
 
-            res_el = 0;
-            disc.domain_integral(el, u_el, res_el);
-            disc.domain_integral_jacobian(el, u_el, jac_el); // TODO: combine
+                    // extract the compact values from the global u view 
+                    extract_elspan(el.elidx, u, u_el);
 
-            // get the global index to the start of the contiguous component x dof range for L/R elem
-            std::size_t glob_index_el = u.get_layout()[el.elidx, 0, 0];
-            // send residual to global residual 
-            scatter_elspan(el.elidx, 1.0, res_el, 1.0, res);
+                    res_el = 0;
+                    domain_integral_batched(disc, el, u_el, res_el, trans_tag, sizes_tag);
+                    if constexpr (provides_domain_jacobian<disc_class, Element, decltype(u_el), decltype(jac_el)>) {
+                        if constexpr (requires { disc.domain_integral_jacobian(el, u_el, jac_el, trans_tag); }) {
+                            disc.domain_integral_jacobian(el, u_el, jac_el, trans_tag); // TODO: combine
+                        } else {
+                            disc.domain_integral_jacobian(el, u_el, jac_el); // TODO: combine
+                        }
+                    } else {
+                        // finite difference fallback
+                        T eps_scaled = scale_fd_epsilon(epsilon, res_el.vector_norm());
+                        for(IDX idofu = 0; idofu < el.nbasis(); ++idofu){
+                            for(IDX iequ = 0; iequ < ncomp; ++iequ){
+                                IDX jcol = u_el.get_layout()[idofu, iequ];
+                                T old_val = u_el[idofu, iequ];
+                                u_el[idofu, iequ] += eps_scaled;
+                                resp_el = 0;
+                                domain_integral_batched(disc, el, u_el, resp_el, trans_tag, sizes_tag);
+                                for(IDX idoff = 0; idoff < el.nbasis(); ++idoff) {
+                                    for(IDX ieqf = 0; ieqf < ncomp; ++ieqf){
+                                        IDX irow = u_el.get_layout()[idoff, ieqf];
+                                        jac_el[irow, jcol] += (resp_el[idoff, ieqf] - res_el[idoff, ieqf]) / eps_scaled;
+                                    }
+                                }
+                                u_el[idofu, iequ] = old_val;
+                            }
+                        }
+                    }
 
-            // TODO: change to a scatter generalized operation to support CG structures
-            petsc::add_to_petsc_mat(jac, proc_range_beg + glob_index_el, 
-                    proc_range_beg + glob_index_el, jac_el);
+                    // get the global index to the start of the contiguous component x dof range for L/R elem
+                    std::size_t glob_index_el = u.get_layout()[el.elidx, 0, 0];
+                    // send residual to global residual 
+                    scatter_elspan(el.elidx, 1.0, res_el, 1.0, res);
+
+                    // TODO: change to a scatter generalized operation to support CG structures
+                    petsc::add_to_petsc_mat(jac, proc_range_beg + glob_index_el, 
+                            proc_col_beg + glob_index_el, jac_el);
+                }
+            });
+        }
+
+#ifdef ICEICLE_USE_MPI
+        // parallel communication faces 
+        // the residual uses the neighbor element data from a halo exchange
+        // and only the coupling to the process local side is represented in the jacobian
+        {
+            // constructed per call so no shared memory window (the construction is not collective)
+            HaloExchange<T, IDX> halo{fespace, ncomp, false};
+            halo.begin_exchange(u);
+            halo.finish_exchange();
+            for(const Trace &trace : fespace.get_boundary_traces()) {
+                if(trace.face->bctype != BOUNDARY_CONDITIONS::PARALLEL_COM) continue;
+                auto [jrank, imleft] = decode_mpi_bcflag(trace.face->bcflag);
+                T* ughost_data = halo.ghost_element_data(halo.ghost_index(jrank,
+                            (imleft) ? trace.face->elemR : trace.face->elemL));
+
+                // the remote side reads from the ghost layer, the local side from u
+                compact_layout_right<IDX, disc_class::nv_comp> uL_layout{trace.elL};
+                dofspan uL{(imleft) ? uL_data.data() : ughost_data, uL_layout};
+                compact_layout_right<IDX, disc_class::nv_comp> uR_layout{trace.elR};
+                dofspan uR{(imleft) ? ughost_data : uR_data.data(), uR_layout};
+                dofspan resL{resL_data.data(), uL_layout};
+                dofspan resLp{resLp_data.data(), uL_layout};
+                dofspan resR{resR_data.data(), uR_layout};
+                dofspan resRp{resRp_data.data(), uR_layout};
+
+                const Element& el_local = (imleft) ? trace.elL : trace.elR;
+                auto& u_local = (imleft) ? uL : uR;
+                auto& res_local = (imleft) ? resL : resR;
+                auto& resp_local = (imleft) ? resLp : resRp;
+
+                // get the unperturbed residual and send the local side to the full residual
+                extract_elspan(el_local.elidx, u, u_local);
+                resL = 0;
+                resR = 0;
+                disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, resL, resR);
+                scatter_elspan(el_local.elidx, 1.0, res_local, 1.0, res);
+
+                // perturb the local side
+                mdspan jac_local{jacL_data.data(), extents{res_local.size(), u_local.size()}};
+                std::fill_n(jacL_data.begin(), jac_local.size(), 0);
+                T eps_scaled = scale_fd_epsilon(epsilon, res_local.vector_norm());
+                for(IDX idofu = 0; idofu < el_local.nbasis(); ++idofu){
+                    for(IDX iequ = 0; iequ < ncomp; ++iequ){
+                        IDX jcol = u_local.get_layout()[idofu, iequ];
+                        T old_val = u_local[idofu, iequ];
+                        u_local[idofu, iequ] += eps_scaled;
+                        resLp = 0;
+                        resRp = 0;
+                        disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, resLp, resRp);
+                        for(IDX idoff = 0; idoff < el_local.nbasis(); ++idoff) {
+                            for(IDX ieqf = 0; ieqf < ncomp; ++ieqf){
+                                IDX irow = res_local.get_layout()[idoff, ieqf];
+                                jac_local[irow, jcol] += (resp_local[idoff, ieqf] - res_local[idoff, ieqf]) / eps_scaled;
+                            }
+                        }
+                        u_local[idofu, iequ] = old_val;
+                    }
+                }
+
+                std::size_t glob_index_local = u.get_layout()[el_local.elidx, 0, 0];
+                petsc::add_to_petsc_mat(jac, proc_range_beg + glob_index_local, 
+                        proc_col_beg + glob_index_local, jac_local);
+            }
+        }
+#endif
+    }
+
+    /**
+     * @brief get the element itself and the elements that share a face with it
+     * (the closed neighborhood in the element face graph)
+     *
+     * Interior traces and boundary traces with a process local element on the right
+     * (periodic faces that are not joined into the interior) couple elements
+     *
+     * @param fespace the finite element space 
+     * @param iel the element index
+     * @return the element index followed by the face neighbor element indices
+     */
+    template<class T, class IDX, int ndim>
+    auto element_face_neighbors(FESpace<T, IDX, ndim>& fespace, IDX iel)
+    -> std::vector<IDX> {
+        std::vector<IDX> neighbors{iel};
+        for(IDX itrace : fespace.fac_surr_el().rowspan(iel)){
+            const TraceSpace<T, IDX, ndim>& trace = fespace.traces[itrace];
+            bool interior = itrace >= fespace.interior_trace_start && itrace < fespace.interior_trace_end;
+            // the right element of a parallel trace is an index on another process
+            if(!interior && (trace.face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM 
+                        || trace.elR.elidx == trace.elL.elidx)) continue;
+            IDX jel = (trace.elL.elidx == iel) ? trace.elR.elidx : trace.elL.elidx;
+            if(std::ranges::find(neighbors, jel) == neighbors.end()) neighbors.push_back(jel);
+        }
+        return neighbors;
+    }
+
+    /**
+     * @brief distance-2 coloring of the elements in the element face graph 
+     * no two elements of the same color share a face neighbor 
+     * so the residual columns of all elements in a color can be perturbed at once
+     *
+     * @param fespace the finite element space 
+     * @return the elements of each color (each row is a color)
+     */
+    template<class T, class IDX, int ndim>
+    auto color_elements_distance2(FESpace<T, IDX, ndim>& fespace)
+    -> util::crs<IDX, IDX> {
+        IDX nelem = fespace.elements.size();
+        return util::greedy_coloring(nelem, nelem, [&fespace](IDX iel){
+            return element_face_neighbors(fespace, iel);
+        });
+    }
+
+    /**
+     * @brief preallocate the jacobian matrix with the exact number of nonzeros per row 
+     * for the couplings assembled by form_petsc_jacobian_fd and form_petsc_mdg_jacobian_fd
+     *
+     * PDE rows of an element couple to the dofs of the element and its face neighbors 
+     * and the geometry dofs of the nodes of those elements.
+     * Interface conservation rows of a geometry dof couple to the elements on either side of the 
+     * selected traces that contain the node and the geometry dofs of the nodes of those elements.
+     *
+     * NOTE: only process local couplings are represented (same as form_petsc_jacobian_fd)
+     *
+     * @param fespace the finite element space 
+     * @param neq the number of vector components per degree of freedom
+     * @param jac the matrix to preallocate (sizes must already be set)
+     * @param selected_traces the traces selected for interface conservation (empty if not mdg)
+     * @param selected_nodes the nodes of the geometry dofs
+     * @param inv_selected_nodes the geometry dof of each node, or selected_nodes.size() if not selected
+     * @param geo_cols the offset of the columns of each geometry dof (size = selected_nodes.size() + 1)
+     * @param ic_rows_per_node the number of interface conservation rows for each geometry dof
+     * @param comm (optional) mpi communicator default: MPI_COMM_WORLD
+     */
+    template<class T, class IDX, int ndim>
+    auto preallocate_petsc_jacobian(
+        FESpace<T, IDX, ndim>& fespace,
+        std::size_t neq,
+        Mat jac,
+        std::span<const IDX> selected_traces,
+        std::span<const IDX> selected_nodes,
+        std::span<const IDX> inv_selected_nodes,
+        std::span<const IDX> geo_cols,
+        std::size_t ic_rows_per_node,
+        MPI_Comm comm = MPI_COMM_WORLD
+    ) -> void {
+        const std::size_t nelem = fespace.elements.size();
+        const std::size_t nsel = selected_nodes.size();
+        const std::size_t dg_size = fespace.dg_map.calculate_size_requirement(neq);
+
+        PetscInt nrow_local, ncol_local;
+        PetscCallAbort(comm, MatGetLocalSize(jac, &nrow_local, &ncol_local));
+        std::vector<PetscInt> d_nnz(nrow_local, 0);
+        std::vector<PetscInt> o_nnz(nrow_local, 0);
+
+        // geometry dof columns for the nodes of a set of elements 
+        // stamp prevents counting a geometry dof twice for the same row block
+        std::vector<std::size_t> geo_stamp(nsel, std::numeric_limits<std::size_t>::max());
+        auto count_geo_cols = [&](std::size_t stamp, const std::vector<IDX>& els) -> PetscInt {
+            PetscInt ncol = 0;
+            for(IDX jel : els){
+                for(IDX inode : fespace.elements[jel].inodes){
+                    std::size_t jgdof = inv_selected_nodes[inode];
+                    if(jgdof != nsel && geo_stamp[jgdof] != stamp){
+                        geo_stamp[jgdof] = stamp;
+                        ncol += geo_cols[jgdof + 1] - geo_cols[jgdof];
+                    }
+                }
+            }
+            return ncol;
+        };
+        auto count_u_cols = [&](const std::vector<IDX>& els) -> PetscInt {
+            PetscInt ncol = 0;
+            for(IDX jel : els) ncol += fespace.dg_map.ndof_el(jel) * neq;
+            return ncol;
+        };
+
+        // PDE rows 
+        for(IDX iel = 0; iel < nelem; ++iel){
+            std::vector<IDX> neighbors = element_face_neighbors(fespace, iel);
+            PetscInt ncol = count_u_cols(neighbors);
+            if(nsel > 0) ncol += count_geo_cols(iel, neighbors);
+            std::size_t row_start = fespace.dg_map.offsets[iel] * neq;
+            std::size_t row_end = fespace.dg_map.offsets[iel + 1] * neq;
+            for(std::size_t irow = row_start; irow < row_end; ++irow) d_nnz[irow] = ncol;
+        }
+
+        // interface conservation rows
+        if(nsel > 0){
+            std::vector<std::vector<IDX>> ic_els(nsel);
+            for(IDX itrace : selected_traces){
+                const TraceSpace<T, IDX, ndim>& trace = fespace.traces[itrace];
+                for(IDX inode : trace.face->nodes_span()){
+                    std::size_t igdof = inv_selected_nodes[inode];
+                    if(igdof == nsel) continue;
+                    for(IDX jel : {trace.elL.elidx, trace.elR.elidx}){
+                        if(std::ranges::find(ic_els[igdof], jel) == ic_els[igdof].end())
+                            ic_els[igdof].push_back(jel);
+                    }
+                }
+            }
+            for(std::size_t igdof = 0; igdof < nsel; ++igdof){
+                PetscInt ncol = count_u_cols(ic_els[igdof]) + count_geo_cols(nelem + igdof, ic_els[igdof]);
+                std::size_t row_start = dg_size + igdof * ic_rows_per_node;
+                for(std::size_t irow = row_start; irow < row_start + ic_rows_per_node; ++irow) d_nnz[irow] = ncol;
+            }
+        }
+
+        // entries beyond the local columns can only come from the local assembly offset
+        for(PetscInt& nnz : d_nnz) nnz = std::min(nnz, ncol_local);
+
+        // block matrices (i.e MATBAIJ) are preallocated by the number of nonzero blocks per block row
+        PetscInt bs;
+        PetscCallAbort(comm, MatGetBlockSize(jac, &bs));
+        if(bs > 1){
+            std::vector<PetscInt> d_bnnz(nrow_local / bs, 0);
+            std::vector<PetscInt> o_bnnz(nrow_local / bs, 0);
+            for(PetscInt irow = 0; irow < nrow_local; ++irow)
+                { d_bnnz[irow / bs] = std::max(d_bnnz[irow / bs], (d_nnz[irow] + bs - 1) / bs); }
+            PetscCallAbort(comm, MatXAIJSetPreallocation(jac, bs, d_bnnz.data(), o_bnnz.data(), NULL, NULL));
+        } else {
+            PetscCallAbort(comm, MatXAIJSetPreallocation(jac, 1, d_nnz.data(), o_nnz.data(), NULL, NULL));
+        }
+
+        // do not error if a coupling is missed (i.e from a discretization specific stencil)
+        PetscCallAbort(comm, MatSetOption(jac, MAT_NEW_NONZERO_ALLOCATION_ERR, PETSC_FALSE));
+    }
+
+    /// @brief preallocate the jacobian matrix for the DG discretization only 
+    /// @param fespace the finite element space 
+    /// @param neq the number of vector components per degree of freedom
+    /// @param jac the matrix to preallocate (sizes must already be set)
+    template<class T, class IDX, int ndim>
+    auto preallocate_petsc_jacobian(FESpace<T, IDX, ndim>& fespace, std::size_t neq, Mat jac,
+            MPI_Comm comm = MPI_COMM_WORLD) -> void {
+        preallocate_petsc_jacobian(fespace, neq, jac, std::span<const IDX>{}, std::span<const IDX>{},
+                std::span<const IDX>{}, std::span<const IDX>{}, 0, comm);
+    }
+
+    /// @brief preallocate the jacobian matrix for MDG with geometry dofs from a geo_dof_map
+    /// (neq interface conservation rows per geometry dof)
+    /// @param fespace the finite element space 
+    /// @param neq the number of vector components per degree of freedom
+    /// @param jac the matrix to preallocate (sizes must already be set)
+    /// @param geo_map the geometry degrees of freedom
+    template<class T, class IDX, int ndim>
+    auto preallocate_petsc_jacobian(FESpace<T, IDX, ndim>& fespace, std::size_t neq, Mat jac,
+            const geo_dof_map<T, IDX, ndim>& geo_map, MPI_Comm comm = MPI_COMM_WORLD) -> void {
+        preallocate_petsc_jacobian(fespace, neq, jac, std::span<const IDX>{geo_map.selected_traces},
+                std::span<const IDX>{geo_map.selected_nodes}, std::span<const IDX>{geo_map.inv_selected_nodes},
+                std::span<const IDX>{geo_map.cols}, neq, comm);
+    }
+
+    /// @brief preallocate the jacobian matrix for MDG with geometry dofs from a nodeset_dof_map
+    /// (ndim columns and ndim interface conservation rows per node)
+    /// @param fespace the finite element space 
+    /// @param neq the number of vector components per degree of freedom
+    /// @param jac the matrix to preallocate (sizes must already be set)
+    /// @param nodeset the selected nodes
+    template<class T, class IDX, int ndim>
+    auto preallocate_petsc_jacobian(FESpace<T, IDX, ndim>& fespace, std::size_t neq, Mat jac,
+            const nodeset_dof_map<IDX>& nodeset, MPI_Comm comm = MPI_COMM_WORLD) -> void {
+        std::vector<IDX> node_cols(nodeset.selected_nodes.size() + 1);
+        for(std::size_t i = 0; i < node_cols.size(); ++i) node_cols[i] = i * ndim;
+        preallocate_petsc_jacobian(fespace, neq, jac, std::span<const IDX>{nodeset.selected_traces},
+                std::span<const IDX>{nodeset.selected_nodes}, std::span<const IDX>{nodeset.inv_selected_nodes},
+                std::span<const IDX>{node_cols}, ndim, comm);
+    }
+
+    /**
+     * @brief form the jacobian for the given discretization using colored finite differences
+     * Will simultaneously form the residual.
+     *
+     * For each color of the distance-2 element coloring, and each local dof and vector component,
+     * all elements in the color are perturbed together and a single residual is evaluated.
+     * The columns are then recovered from the element face sparsity.
+     * This requires (number of colors) x (max element dofs) x (ncomp) residual evaluations
+     *
+     * NOTE: only process local couplings are represented (same as form_petsc_jacobian_fd)
+     *
+     * @param fespace the finite element space 
+     * @param disc the discretization
+     * @param u the solution to get the residual for
+     * @param [out] res the residual
+     * @param [out] jac a petsc matrix to fill with the jacobian 
+     * @param el_colors the distance-2 element coloring (see color_elements_distance2)
+     * @param workspace the residual workspace for this fespace
+     * @param epsilon (optional) the epsilon to use for finite difference
+     *                NOTE: this gets scaled by the norm of the element residual 
+     * @param comm (optional) mpi communicator default: MPI_COMM_WORLD
+     */
+    template<
+        class T,
+        class IDX,
+        int ndim,
+        class disc_class,
+        class uLayoutPolicy,
+        class uAccessorPolicy,
+        class resLayoutPolicy
+    >
+    void form_petsc_jacobian_fd_colored(
+        FESpace<T, IDX, ndim> &fespace,
+        disc_class &disc,
+        fespan<T, uLayoutPolicy, uAccessorPolicy> u,
+        fespan<T, resLayoutPolicy> res,
+        Mat jac,
+        const util::crs<IDX, IDX>& el_colors,
+        ResidualWorkspace<T, IDX>& workspace,
+        T epsilon = std::sqrt(std::numeric_limits<T>::epsilon()),
+        MPI_Comm comm = MPI_COMM_WORLD 
+    ) {
+        ICEICLE_PROFILE_REGION("form_jacobian_colored");
+        using namespace std::experimental;
+        const std::size_t ncomp = disc_class::dnv_comp;
+
+        // get the start indices for the petsc matrix on this processor
+        PetscInt proc_range_beg, proc_range_end;
+        PetscCallAbort(comm, MatGetOwnershipRange(jac, &proc_range_beg, &proc_range_end));
+
+        // unperturbed residual
+        form_residual(fespace, disc, u, res, workspace);
+
+        // perturbed solution and residual
+        std::vector<T> up_data(u.size());
+        fespan up{up_data.data(), u.get_layout()};
+        copy_fespan(u, up);
+        std::vector<T> resp_data(res.size());
+        fespan resp{resp_data.data(), res.get_layout()};
+
+        // perturbation amount for each element scaled by the unperturbed element residual
+        std::vector<T> eps_el(fespace.elements.size());
+        for(IDX iel = 0; iel < fespace.elements.size(); ++iel){
+            T norm_sq = 0;
+            for(IDX idof = 0; idof < res.ndof(iel); ++idof){
+                for(IDX iv = 0; iv < ncomp; ++iv)
+                    { norm_sq += SQUARED(res[iel, idof, iv]); }
+            }
+            eps_el[iel] = scale_fd_epsilon(epsilon, std::sqrt(norm_sq));
+        }
+
+        for(IDX icolor = 0; icolor < el_colors.nrow(); ++icolor){
+            std::span<const IDX> color_els = el_colors.rowspan(icolor);
+
+            // the neighbors and compact jacobian blocks [neighbor rows x element columns] 
+            // for each element in the color
+            std::vector<std::vector<IDX>> neighbors(color_els.size());
+            std::vector<std::vector<std::vector<T>>> blocks(color_els.size());
+            std::size_t max_col = 0;
+            for(std::size_t i = 0; i < color_els.size(); ++i){
+                IDX iel = color_els[i];
+                neighbors[i] = element_face_neighbors(fespace, iel);
+                std::size_t ncol = u.ndof(iel) * ncomp;
+                for(IDX jel : neighbors[i])
+                    { blocks[i].emplace_back(res.ndof(jel) * ncomp * ncol, 0.0); }
+                max_col = std::max(max_col, ncol);
+            }
+
+            for(std::size_t jcol = 0; jcol < max_col; ++jcol){
+                // compact column index is vector component fastest
+                IDX jdof = jcol / ncomp;
+                IDX jv = jcol % ncomp;
+
+                // perturb all the elements in the color
+                for(IDX iel : color_els){
+                    if(jdof < u.ndof(iel)) up[iel, jdof, jv] += eps_el[iel];
+                }
+
+                form_residual(fespace, disc, up, resp, workspace);
+
+                // recover the columns and undo the perturbation 
+                for(std::size_t i = 0; i < color_els.size(); ++i){
+                    IDX iel = color_els[i];
+                    if(jdof >= u.ndof(iel)) continue;
+                    std::size_t ncol = u.ndof(iel) * ncomp;
+                    for(std::size_t k = 0; k < neighbors[i].size(); ++k){
+                        IDX jel = neighbors[i][k];
+                        std::vector<T>& block = blocks[i][k];
+                        for(IDX idof = 0; idof < res.ndof(jel); ++idof){
+                            for(IDX iv = 0; iv < ncomp; ++iv){
+                                std::size_t irow = idof * ncomp + iv;
+                                block[irow * ncol + jcol] = 
+                                    (resp[jel, idof, iv] - res[jel, idof, iv]) / eps_el[iel];
+                            }
+                        }
+                    }
+                    up[iel, jdof, jv] = u[iel, jdof, jv];
+                }
+            }
+
+            // send the jacobian blocks to the petsc matrix
+            for(std::size_t i = 0; i < color_els.size(); ++i){
+                IDX iel = color_els[i];
+                std::size_t glob_index_col = u.get_layout()[iel, 0, 0];
+                for(std::size_t k = 0; k < neighbors[i].size(); ++k){
+                    IDX jel = neighbors[i][k];
+                    std::size_t glob_index_row = u.get_layout()[jel, 0, 0];
+                    mdspan jac_block{blocks[i][k].data(), 
+                        extents{res.ndof(jel) * ncomp, u.ndof(iel) * ncomp}};
+                    petsc::add_to_petsc_mat(jac, proc_range_beg + glob_index_row, 
+                            proc_range_beg + glob_index_col, jac_block);
+                }
+            }
         }
     }
 
@@ -333,6 +870,7 @@ namespace iceicle::solvers {
         T epsilon = std::sqrt(std::numeric_limits<T>::epsilon()),
         MPI_Comm comm = MPI_COMM_WORLD 
     ) -> void {
+        ICEICLE_PROFILE_REGION("form_mdg_jacobian");
         using Element = FiniteElement<T, IDX, ndim>;
         using Trace = TraceSpace<T, IDX, ndim>;
         using index_type = IDX;
@@ -356,6 +894,9 @@ namespace iceicle::solvers {
         std::vector<T> res_storage{};
         std::vector<T> resp_storage{};
 
+        // the scattered interface conservation entries (added once at the end)
+        petsc::triplet_buffer ic_entries{};
+
         const nodeset_dof_map<index_type>& nodeset = mdg_residual.get_layout().nodeset; 
 
         // jacobian of interface condition residual wrt u
@@ -415,7 +956,7 @@ namespace iceicle::solvers {
                                 // get the global row index based on the dof in node selection
                                 IDX irow = mdg_range_beg + mdg_residual.get_layout()[igdof, ieqf];
                                 T fd_val = (resp[idoff, ieqf] - res[idoff, ieqf]) / eps_scaled;
-                                MatSetValue(jac, irow, jcol, fd_val, ADD_VALUES);
+                                ic_entries.add(irow, jcol, fd_val);
                             }
                         }
                     }
@@ -449,7 +990,7 @@ namespace iceicle::solvers {
                                 // get the global row index based on the dof in node selection
                                 IDX irow = mdg_range_beg + mdg_residual.get_layout()[igdof, ieqf];
                                 T fd_val = (resp[idoff, ieqf] - res[idoff, ieqf]) / eps_scaled;
-                                MatSetValue(jac, irow, jcol, fd_val, ADD_VALUES);
+                                ic_entries.add(irow, jcol, fd_val);
                             }
                         }
                     }
@@ -464,13 +1005,17 @@ namespace iceicle::solvers {
         std::vector<T> resR_storage(fespace.dg_map.max_el_size_reqirement(u.nv()));
         std::vector<T> resRp_storage(fespace.dg_map.max_el_size_reqirement(u.nv()));
 
+        // mask of the traces that contribute to the interface conservation residual
+        std::vector<bool> is_ic_trace(fespace.traces.size(), false);
+        for(IDX itrace : nodeset.selected_traces) is_ic_trace[itrace] = true;
+
         // Jacobian wrt x 
         for(IDX jmdg = 0; jmdg < mdg_residual.ndof(); ++jmdg){
             // the global node index corresponding to this mdg dof
             IDX inode = nodeset.selected_nodes[jmdg];
 
             // loop over element surrounding for domain integral
-            for(IDX iel : fespace.el_surr_nodes.rowspan(inode)) {
+            for(IDX iel : fespace.el_surr_nodes().rowspan(inode)) {
                 const Element& el = fespace.elements[iel];
 
                 // set up compact data views
@@ -492,12 +1037,12 @@ namespace iceicle::solvers {
                 // set up the perturbation amount scaled by unperturbed residual 
                 T eps_scaled = scale_fd_epsilon(epsilon, res.vector_norm());
 
+                // dense block of the element rows and the ndim columns of this node
+                jacL_storage.resize(res.size() * ndim);
+                mdspan jac_x{jacL_storage.data(), extents{res.size(), (std::size_t) ndim}};
+
                 // loop over dimensions of node and perturb
                 for(int idim = 0; idim < ndim; ++idim){
-                    
-                        // the unknowns will always have ndim vector components 
-                        IDX jcol = mdg_range_beg + jmdg * ndim + idim;
-
                         T old_val = fespace.meshptr->coord[inode][idim];
                         fespace.meshptr->coord[inode][idim] += eps_scaled;
 
@@ -508,22 +1053,25 @@ namespace iceicle::solvers {
                         // jacobian contribution 
                         for(IDX idoff = 0; idoff < res.ndof(); ++idoff){
                             for(IDX ieqf = 0; ieqf < res.nv(); ++ieqf){
-                                IDX irow = proc_range_beg + glob_index_el + res.get_layout()[idoff, ieqf];
-                                T fd_val = (resp[idoff, ieqf] - res[idoff, ieqf]) / eps_scaled;
-                                MatSetValue(jac, irow, jcol, fd_val, ADD_VALUES);
+                                IDX irow = res.get_layout()[idoff, ieqf];
+                                jac_x[irow, idim] = (resp[idoff, ieqf] - res[idoff, ieqf]) / eps_scaled;
                             }
                         }
 
                         // revert perturbation
                         fespace.meshptr->coord[inode][idim] = old_val;
                 }
+
+                // the unknowns will always have ndim vector components 
+                petsc::add_to_petsc_mat(jac, proc_range_beg + glob_index_el, 
+                        mdg_range_beg + jmdg * ndim, jac_x, comm);
             }
 
             // build the extended stencil of face indices around the node
             // use a set to prevent repeats
             std::set<IDX>traces_to_visit{};
-            for(IDX iel : fespace.el_surr_nodes.rowspan(inode)){
-                for(IDX itrace : fespace.fac_surr_el.rowspan(iel)){
+            for(IDX iel : fespace.el_surr_nodes().rowspan(inode)){
+                for(IDX itrace : fespace.fac_surr_el().rowspan(iel)){
                     traces_to_visit.insert(itrace);
                 }
             }
@@ -545,6 +1093,15 @@ namespace iceicle::solvers {
                 // extract the compact values from the global u view
                 extract_elspan(trace.elL.elidx, u, uL);
                 extract_elspan(trace.elR.elidx, u, uR);
+                // the interior traces of the interface conservation residual 
+                // form dICE/dx with du/dx from the same flux evaluations
+                const bool fused_ic = is_ic_trace[itrace] && trace.face->bctype == BOUNDARY_CONDITIONS::INTERIOR;
+                trace_layout_right<IDX, decltype(mdg_residual)::static_extent()> ic_layout{trace};
+                res_storage.resize(ic_layout.size());
+                dofspan ic_res{res_storage, ic_layout};
+                resp_storage.resize(ic_layout.size());
+                dofspan ic_resp{resp_storage, ic_layout};
+
                 // du/dx  (L and R)
                 {
                     dofspan resL{resL_storage, u.create_element_layout(trace.elL.elidx)};
@@ -554,26 +1111,53 @@ namespace iceicle::solvers {
                     resL = 0; resR = 0;
 
                     // get the unperturbed residual
-                    if(trace.face->bctype == BOUNDARY_CONDITIONS::INTERIOR){
+                    if(fused_ic){
+                        ic_res = 0;
+                        trace_interface_conservation(disc, trace, fespace.meshptr->coord, uL, uR, resL, resR, ic_res);
+                    } else if(trace.face->bctype == BOUNDARY_CONDITIONS::INTERIOR){
                         disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, resL, resR);
                     } else {
                         disc.boundaryIntegral(trace, fespace.meshptr->coord, uL, uR, resL);
                     }
 
                     // set up the perturbation amount scaled by unperturbed residual 
-                    T eps_scaled = scale_fd_epsilon(epsilon, std::max(resL.vector_norm(), resR.vector_norm()));
+                    // (shared by the interface conservation residual if fused)
+                    T res_norm = std::max(resL.vector_norm(), resR.vector_norm());
+                    if(fused_ic) res_norm = std::max(res_norm, ic_res.vector_norm());
+                    T eps_scaled = scale_fd_epsilon(epsilon, res_norm);
+
+                    // dense blocks of the L/R element rows and the ndim columns of this node
+                    jacL_storage.resize(resL.size() * ndim);
+                    jacR_storage.resize(resR.size() * ndim);
+                    mdspan jacL_x{jacL_storage.data(), extents{resL.size(), (std::size_t) ndim}};
+                    mdspan jacR_x{jacR_storage.data(), extents{resR.size(), (std::size_t) ndim}};
 
                     // loop over dimensions of node and perturb
                     for(int idim = 0; idim < ndim; ++idim) {
-                        // the unknowns will always have ndim vector components 
-                        IDX jcol = mdg_range_beg + jmdg * ndim + idim;
-
                         T old_val = fespace.meshptr->coord[inode][idim];
                         fespace.meshptr->coord[inode][idim] += eps_scaled;
 
                         // get the perturbed residual
                         resLp = 0; resRp = 0;
-                        if(trace.face->bctype == BOUNDARY_CONDITIONS::INTERIOR){
+                        if(fused_ic){
+                            ic_resp = 0;
+                            trace_interface_conservation(disc, trace, fespace.meshptr->coord, uL, uR, resLp, resRp, ic_resp);
+
+                            // dICE/dx
+                            IDX jcol = mdg_range_beg + jmdg * ndim + idim;
+                            for(IDX idoff = 0; idoff < ic_res.ndof(); ++idoff){
+                                // only scatter if node is actually in nodeset 
+                                IDX ignode = trace.face->nodes()[idoff];
+                                IDX igdof = nodeset.inv_selected_nodes[ignode];
+                                if(igdof != nodeset.selected_nodes.size()){
+                                    for(IDX ieqf = 0; ieqf < ic_res.nv(); ++ieqf){
+                                        IDX irow = mdg_range_beg + mdg_residual.get_layout()[igdof, ieqf];
+                                        T fd_val = (ic_resp[idoff, ieqf] - ic_res[idoff, ieqf]) / eps_scaled;
+                                        ic_entries.add(irow, jcol, fd_val);
+                                    }
+                                }
+                            }
+                        } else if(trace.face->bctype == BOUNDARY_CONDITIONS::INTERIOR){
                             disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, resLp, resRp);
                         } else {
                             disc.boundaryIntegral(trace, fespace.meshptr->coord, uL, uR, resLp);
@@ -582,9 +1166,8 @@ namespace iceicle::solvers {
                         // resL
                         for(IDX idoff = 0; idoff < resL.ndof(); ++idoff){
                             for(IDX ieqf = 0; ieqf < resL.nv(); ++ieqf){
-                                IDX irow = proc_range_beg + glob_index_L + resL.get_layout()[idoff, ieqf];
-                                T fd_val = (resLp[idoff, ieqf] - resL[idoff, ieqf]) / eps_scaled;
-                                MatSetValue(jac, irow, jcol, fd_val, ADD_VALUES);
+                                IDX irow = resL.get_layout()[idoff, ieqf];
+                                jacL_x[irow, idim] = (resLp[idoff, ieqf] - resL[idoff, ieqf]) / eps_scaled;
                             }
                         }
 
@@ -592,9 +1175,8 @@ namespace iceicle::solvers {
                         if(trace.face->bctype == BOUNDARY_CONDITIONS::INTERIOR){
                             for(IDX idoff = 0; idoff < resR.ndof(); ++idoff){
                                 for(IDX ieqf = 0; ieqf < resR.nv(); ++ieqf){
-                                    IDX irow = proc_range_beg + glob_index_R + resR.get_layout()[idoff, ieqf];
-                                    T fd_val = (resRp[idoff, ieqf] - resR[idoff, ieqf]) / eps_scaled;
-                                    MatSetValue(jac, irow, jcol, fd_val, ADD_VALUES);
+                                    IDX irow = resR.get_layout()[idoff, ieqf];
+                                    jacR_x[irow, idim] = (resRp[idoff, ieqf] - resR[idoff, ieqf]) / eps_scaled;
                                 }
                             }
                         }
@@ -602,15 +1184,20 @@ namespace iceicle::solvers {
                         // revert perturbation
                         fespace.meshptr->coord[inode][idim] = old_val;
                     }
+
+                    // the unknowns will always have ndim vector components 
+                    petsc::add_to_petsc_mat(jac, proc_range_beg + glob_index_L, 
+                            mdg_range_beg + jmdg * ndim, jacL_x, comm);
+                    if(trace.face->bctype == BOUNDARY_CONDITIONS::INTERIOR){
+                        petsc::add_to_petsc_mat(jac, proc_range_beg + glob_index_R, 
+                                mdg_range_beg + jmdg * ndim, jacR_x, comm);
+                    }
                 }
 
-                // dICE/dx
-                {
-                    auto res_layout = trace_layout_right{trace};
-                    res_storage.resize(res_layout.size());
-                    dofspan res{res_storage, res_layout};
-                    resp_storage.resize(res_layout.size());
-                    dofspan resp{resp_storage, res_layout};
+                // dICE/dx (only for the boundary traces in the interface conservation residual)
+                if(is_ic_trace[itrace] && !fused_ic) {
+                    dofspan res{res_storage, ic_layout};
+                    dofspan resp{resp_storage, ic_layout};
 
                     // get the unperturbed residual
                     res = 0;
@@ -642,7 +1229,7 @@ namespace iceicle::solvers {
                                     // get the global row index based on the dof in node selection
                                     IDX irow = mdg_range_beg + mdg_residual.get_layout()[igdof, ieqf];
                                     T fd_val = (resp[idoff, ieqf] - res[idoff, ieqf]) / eps_scaled;
-                                    MatSetValue(jac, irow, jcol, fd_val, ADD_VALUES);
+                                    ic_entries.add(irow, jcol, fd_val);
                                 }
                             }
                         }
@@ -654,11 +1241,76 @@ namespace iceicle::solvers {
             }
 
         }
+
+        // add the scattered interface conservation entries
+        ic_entries.flush(jac, false, comm);
+    }
+
+    /**
+     * @brief storage of the geometry columns of the mdg jacobian for incremental assembly
+     *
+     * Holds the finite difference entries of the geometry columns of each selected node
+     * and the node coordinates when they were computed.
+     * With a cache, form_petsc_mdg_jacobian_fd only recomputes the columns of the nodes 
+     * with a moved node (further than move_tolerance since the last computation) in the 
+     * elements of their stencil. All other columns are added from the stored entries.
+     *
+     * NOTE: the reused columns are evaluated at the solution u of their last computation
+     * (lagged in u), refresh_interval forces a full assembly periodically
+     */
+    template<class T, class IDX, int ndim>
+    struct mdg_jacobian_cache {
+        /// @brief a node has moved if the distance to the stored coordinates is greater than this
+        T move_tolerance = 0.0;
+
+        /// @brief recompute all the columns every refresh_interval assemblies (never forced if <= 0)
+        IDX refresh_interval = 0;
+
+        /// @brief the number of assemblies made with this cache
+        IDX nassembly = 0;
+
+        /// @brief the number of selected nodes with recomputed columns in the last assembly
+        IDX nrecomputed = 0;
+
+        /// @brief the coordinates of each selected node at the last computation
+        std::vector<std::array<T, ndim>> node_coords;
+
+        /// @brief the stored jacobian entries (row, col, value) of the columns of each selected node
+        std::vector<std::vector<PetscInt>> rows;
+        std::vector<std::vector<PetscInt>> cols;
+        std::vector<std::vector<T>> vals;
+
+        /// @brief force a full assembly on the next use
+        void invalidate() { node_coords.clear(); }
+    };
+
+    /// @brief from the jacobian terms due to the interface condition enforcement 
+    /// NOTE: this works with the non-square matrix
+    template<
+        class T, class IDX, int ndim,
+        class disc_class, class uLayoutPolicy, class uAccessorPolicy
+    >
+    auto form_petsc_mdg_jacobian_fd(
+        FESpace<T, IDX, ndim>& fespace,
+        disc_class& disc,
+        fespan<T, uLayoutPolicy, uAccessorPolicy> u,
+        geospan auto x,
+        icespan auto mdg_residual,
+        Mat jac,
+        T epsilon = std::sqrt(std::numeric_limits<T>::epsilon()),
+        MPI_Comm comm = MPI_COMM_WORLD 
+    ) -> void 
+    {
+        form_petsc_mdg_jacobian_fd(fespace, disc, u, x, mdg_residual, jac,
+                static_cast<mdg_jacobian_cache<T, IDX, ndim>*>(nullptr), epsilon, comm);
     }
 
     /// @brief from the jacobian terms due to the interface condition enforcement 
+    /// incrementally assembling the geometry columns with a cache (see mdg_jacobian_cache)
     /// NOTE: this works with the non-square matrix
-template<
+    ///
+    /// @param cache the cache of the geometry columns (nullptr for a full assembly without a cache)
+    template<
         class T, class IDX, int ndim,
         class disc_class, class uLayoutPolicy, class uAccessorPolicy
     >
@@ -669,10 +1321,12 @@ template<
         geospan auto x,
         icespan auto mdg_residual,
         Mat jac,
+        mdg_jacobian_cache<T, IDX, ndim>* cache,
         T epsilon = std::sqrt(std::numeric_limits<T>::epsilon()),
         MPI_Comm comm = MPI_COMM_WORLD 
     ) -> void 
     {
+        ICEICLE_PROFILE_REGION("form_mdg_jacobian");
         using Element = FiniteElement<T, IDX, ndim>;
         using Trace = TraceSpace<T, IDX, ndim>;
         using index_type = IDX;
@@ -688,6 +1342,11 @@ template<
         PetscCallAbort(comm, MatGetOwnershipRange(jac, &proc_range_beg, &proc_range_end));
         mdg_range_beg = proc_range_beg + u.size();
 
+        // the column distribution differs from the rows for the non-square matrix
+        PetscInt proc_col_beg, proc_col_end, mdg_col_beg;
+        PetscCallAbort(comm, MatGetOwnershipRangeColumn(jac, &proc_col_beg, &proc_col_end));
+        mdg_col_beg = proc_col_beg + u.size();
+
         // preallocate storage for compact views of u 
         const std::size_t max_local_size =
             fespace.dg_map.max_el_size_reqirement(neq);
@@ -698,12 +1357,46 @@ template<
         std::vector<T> res_storage{};
         std::vector<T> resp_storage{};
 
+        // the scattered interface conservation and geometry column entries (added once at the end)
+        petsc::triplet_buffer mdg_entries{};
+
         // get the selected geometry to apply interface condition to
         const geo_dof_map<T, IDX, ndim>& geo_map = x.get_layout().geo_map;
 
         // apply the x coordinates to the mesh
         update_mesh(x, *(fespace.meshptr));
 
+        // the start of the interface conservation rows and geometry columns on every process 
+        // to address the dofs of ghost nodes on the owning process
+        std::vector<PetscInt> mdg_range_begs{}, mdg_col_begs{};
+#ifdef ICEICLE_USE_MPI
+        if(geo_map.distributed){
+            int nrank;
+            MPI_Comm_size(comm, &nrank);
+            mdg_range_begs.resize(nrank);
+            mdg_col_begs.resize(nrank);
+            MPI_Allgather(&mdg_range_beg, 1, MPIU_INT, mdg_range_begs.data(), 1, MPIU_INT, comm);
+            MPI_Allgather(&mdg_col_beg, 1, MPIU_INT, mdg_col_begs.data(), 1, MPIU_INT, comm);
+        }
+#endif
+
+        // the global interface conservation row for a node (owned or ghost) 
+        // or -1 if the node is not a geometry dof
+        auto ic_row = [&](IDX inode, IDX ieq) -> IDX {
+            IDX igdof = geo_map.inv_selected_nodes[inode];
+            if(igdof != geo_map.selected_nodes.size())
+                return mdg_range_beg + mdg_residual.get_layout()[igdof, ieq];
+            if(geo_map.nghost() > 0){
+                IDX ighost = geo_map.inv_ghost_nodes[inode];
+                if(ighost != geo_map.nghost())
+                    return mdg_range_begs[geo_map.ghost_owner[ighost]] + geo_map.ghost_owner_dof[ighost] * neq + ieq;
+            }
+            return -1;
+        };
+
+        // interface conservation contributions to the ghost nodes
+        std::vector<T> ghost_res(geo_map.nghost() * neq, 0.0);
+
         // jacobian of ice residual wrt u
         for(index_type itrace: geo_map.selected_traces){
             Trace& trace = fespace.traces[itrace];
@@ -732,6 +1425,7 @@ template<
             res = 0;
             disc.interface_conservation(trace, fespace.meshptr->coord, uL, uR, res);
             scatter_facspan(trace, 1.0, res, 1.0, mdg_residual);
+            scatter_facspan_ghosts(trace, 1.0, res, geo_map, std::span<T>{ghost_res});
 
             // set up the perturbation amount scaled by unperturbed residual 
             T eps_scaled = scale_fd_epsilon(epsilon, res.vector_norm());
@@ -739,7 +1433,7 @@ template<
             // dICE/duL
             for(IDX idofu = 0; idofu < uL.ndof(); ++idofu){
                 for(IDX iequ = 0; iequ < uL.nv(); ++iequ){
-                    IDX jcol = proc_range_beg + glob_index_L + uL.get_layout()[idofu, iequ];
+                    IDX jcol = proc_col_beg + glob_index_L + uL.get_layout()[idofu, iequ];
 
                     // perturb 
                     T old_val = uL[idofu, iequ];
@@ -754,14 +1448,13 @@ template<
 
                         // only do perturbation if node is actually in nodeset 
                         IDX ignode = trace.face->nodes()[idoff];
-                        IDX igdof = geo_map.inv_selected_nodes[ignode];
 
-                        if(igdof != geo_map.selected_nodes.size()){
+                        if(ic_row(ignode, 0) >= 0){
                             for(IDX ieqf = 0; ieqf < neq; ++ieqf) {
                                 // get the global row index based on the dof in node selection
-                                IDX irow = mdg_range_beg + mdg_residual.get_layout()[igdof, ieqf];
+                                IDX irow = ic_row(ignode, ieqf);
                                 T fd_val = (resp[idoff, ieqf] - res[idoff, ieqf]) / eps_scaled;
-                                MatSetValue(jac, irow, jcol, fd_val, ADD_VALUES);
+                                mdg_entries.add(irow, jcol, fd_val);
                             }
                         }
                     }
@@ -773,7 +1466,7 @@ template<
             // dICE/duR
             for(IDX idofu = 0; idofu < uR.ndof(); ++idofu){
                 for(IDX iequ = 0; iequ < uR.nv(); ++iequ){
-                    IDX jcol = proc_range_beg + glob_index_R + uR.get_layout()[idofu, iequ];
+                    IDX jcol = proc_col_beg + glob_index_R + uR.get_layout()[idofu, iequ];
 
                     // perturb 
                     T old_val = uR[idofu, iequ];
@@ -788,14 +1481,13 @@ template<
 
                         // only do perturbation if node is actually in nodeset 
                         IDX ignode = trace.face->nodes()[idoff];
-                        IDX igdof = geo_map.inv_selected_nodes[ignode];
 
-                        if(igdof != geo_map.selected_nodes.size()){
+                        if(ic_row(ignode, 0) >= 0){
                             for(IDX ieqf = 0; ieqf < neq; ++ieqf) {
                                 // get the global row index based on the dof in node selection
-                                IDX irow = mdg_range_beg + mdg_residual.get_layout()[igdof, ieqf];
+                                IDX irow = ic_row(ignode, ieqf);
                                 T fd_val = (resp[idoff, ieqf] - res[idoff, ieqf]) / eps_scaled;
-                                MatSetValue(jac, irow, jcol, fd_val, ADD_VALUES);
+                                mdg_entries.add(irow, jcol, fd_val);
                             }
                         }
                     }
@@ -805,18 +1497,112 @@ template<
             }
         }
 
+        // add the ghost node contributions to the owning processes
+        geo_map.reverse_exchange(std::span<const T>{ghost_res},
+                std::span<T>{mdg_residual.data(), mdg_residual.size()}, neq);
+
         std::vector<T> resL_storage(fespace.dg_map.max_el_size_reqirement(u.nv()));
         std::vector<T> resLp_storage(fespace.dg_map.max_el_size_reqirement(u.nv()));
         std::vector<T> resR_storage(fespace.dg_map.max_el_size_reqirement(u.nv()));
         std::vector<T> resRp_storage(fespace.dg_map.max_el_size_reqirement(u.nv()));
 
+        // mask of the traces that contribute to the interface conservation residual
+        std::vector<bool> is_ic_trace(fespace.traces.size(), false);
+        for(IDX itrace : geo_map.selected_traces) is_ic_trace[itrace] = true;
+
+        // the geometry dofs perturbed on this process: the owned dofs then the ghost nodes 
+        // the local contributions to the columns of a ghost node are added to the columns on the owner
+        IDX nselected = mdg_residual.ndof();
+        IDX ngeo_local = nselected + geo_map.nghost();
+        auto geo_node = [&](IDX jgeo) -> IDX {
+            return (jgeo < nselected) ? geo_map.selected_nodes[jgeo] : geo_map.ghost_nodes[jgeo - nselected];
+        };
+        auto geo_accessor = [&](IDX jgeo) -> ParametricCoordTransformation<T, ndim>* {
+            return (jgeo < nselected) ? geo_map.parametric_accessors[jgeo].get() 
+                : geo_map.ghost_accessors[jgeo - nselected].get();
+        };
+        auto geo_col = [&](IDX jgeo, IDX is) -> IDX {
+            if(jgeo < nselected) return mdg_col_beg + geo_map.cols[jgeo] + is;
+            IDX ighost = jgeo - nselected;
+            return mdg_col_begs[geo_map.ghost_owner[ighost]] + geo_map.ghost_owner_col[ighost] + is;
+        };
+
+        // determine which geometry columns need to be recomputed
+        std::vector<bool> recompute(ngeo_local, true);
+        if(cache) {
+            bool full_assembly = cache->node_coords.size() != (std::size_t) ngeo_local
+                || (cache->refresh_interval > 0 && cache->nassembly % cache->refresh_interval == 0);
+            if(full_assembly) {
+                cache->node_coords.assign(ngeo_local, std::array<T, ndim>{});
+                cache->rows.assign(ngeo_local, {});
+                cache->cols.assign(ngeo_local, {});
+                cache->vals.assign(ngeo_local, {});
+            } else {
+                // mark the elements with a node that moved 
+                std::vector<bool> el_moved(fespace.elements.size(), false);
+                for(IDX jmdg = 0; jmdg < ngeo_local; ++jmdg){
+                    IDX inode = geo_node(jmdg);
+                    T dist2 = 0;
+                    for(int idim = 0; idim < ndim; ++idim){
+                        T dx = fespace.meshptr->coord[inode][idim] - cache->node_coords[jmdg][idim];
+                        dist2 += dx * dx;
+                    }
+                    if(dist2 > cache->move_tolerance * cache->move_tolerance) {
+                        for(IDX iel : fespace.el_surr_nodes().rowspan(inode)) el_moved[iel] = true;
+                    }
+                }
+
+                // a column is affected if an element of a trace in its stencil has a moved node
+                auto is_moved = [&](IDX iel){ return iel < (IDX) el_moved.size() && el_moved[iel]; };
+                for(IDX jmdg = 0; jmdg < ngeo_local; ++jmdg){
+                    IDX inode = geo_node(jmdg);
+                    bool affected = false;
+                    for(IDX iel : fespace.el_surr_nodes().rowspan(inode)){
+                        for(IDX itrace : fespace.fac_surr_el().rowspan(iel)){
+                            const Trace& trace = fespace.traces[itrace];
+                            affected = affected || is_moved(trace.elL.elidx) || is_moved(trace.elR.elidx);
+                        }
+                    }
+                    recompute[jmdg] = affected;
+                }
+            }
+            cache->nassembly++;
+            cache->nrecomputed = std::ranges::count(recompute, true);
+        }
+
         // Jacobian wrt x 
-        for(IDX jmdg = 0; jmdg < mdg_residual.ndof(); ++jmdg){
-            // the global node index corresponding to this mdg dof
-            IDX inode = geo_map.selected_nodes[jmdg];
+        for(IDX jmdg = 0; jmdg < ngeo_local; ++jmdg){
+            // the node index corresponding to this mdg dof
+            IDX inode = geo_node(jmdg);
+
+            // add the stored columns of this node
+            if(!recompute[jmdg]) {
+                for(std::size_t ientry = 0; ientry < cache->vals[jmdg].size(); ++ientry){
+                    mdg_entries.add(cache->rows[jmdg][ientry], cache->cols[jmdg][ientry],
+                            cache->vals[jmdg][ientry]);
+                }
+                continue;
+            }
+
+            // add a geometry column entry to the jacobian (and store it in the cache)
+            auto add_geo_value = [&](IDX irow, IDX jcol, T fd_val){
+                mdg_entries.add(irow, jcol, fd_val);
+                if(cache){
+                    cache->rows[jmdg].push_back(irow);
+                    cache->cols[jmdg].push_back(jcol);
+                    cache->vals[jmdg].push_back(fd_val);
+                }
+            };
+            if(cache) {
+                for(int idim = 0; idim < ndim; ++idim)
+                    { cache->node_coords[jmdg][idim] = fespace.meshptr->coord[inode][idim]; }
+                cache->rows[jmdg].clear();
+                cache->cols[jmdg].clear();
+                cache->vals[jmdg].clear();
+            }
 
             // loop over element surrounding for domain integral
-            for(IDX iel : fespace.el_surr_nodes.rowspan(inode)) {
+            for(IDX iel : fespace.el_surr_nodes().rowspan(inode)) {
                 const Element& el = fespace.elements[iel];
 
                 // set up compact data views
@@ -839,14 +1625,14 @@ template<
                 T eps_scaled = scale_fd_epsilon(epsilon, res.vector_norm());
 
                 // get the original parameterization 
-                auto* parametrization = geo_map.parametric_accessors[jmdg].get();
+                auto* parametrization = geo_accessor(jmdg);
                 std::vector<T> s(parametrization->s_size());
                 parametrization->x_to_s(fespace.meshptr->coord[inode], s);
 
                 // loop over dimension of the geometric parameterization and peturb
-                for(int is = 0; is < x.nv(jmdg); ++is){
+                for(int is = 0; is < geo_accessor(jmdg)->s_size(); ++is){
                     
-                        IDX jcol = mdg_range_beg + geo_map.cols[jmdg] + is;
+                        IDX jcol = geo_col(jmdg, is);
 
                         T old_val = s[is];
                         s[is] += eps_scaled;
@@ -864,7 +1650,7 @@ template<
                             for(IDX ieqf = 0; ieqf < res.nv(); ++ieqf){
                                 IDX irow = proc_range_beg + glob_index_el + res.get_layout()[idoff, ieqf];
                                 T fd_val = (resp[idoff, ieqf] - res[idoff, ieqf]) / eps_scaled;
-                                MatSetValue(jac, irow, jcol, fd_val, ADD_VALUES);
+                                add_geo_value(irow, jcol, fd_val);
                             }
                         }
 
@@ -877,10 +1663,12 @@ template<
 
             // build the extended stencil of face indices around the node
             // use a set to prevent repeats
+            // (process boundaries need the remote element data so only local couplings are represented)
             std::set<IDX>traces_to_visit{};
-            for(IDX iel : fespace.el_surr_nodes.rowspan(inode)){
-                for(IDX itrace : fespace.fac_surr_el.rowspan(iel)){
-                    traces_to_visit.insert(itrace);
+            for(IDX iel : fespace.el_surr_nodes().rowspan(inode)){
+                for(IDX itrace : fespace.fac_surr_el().rowspan(iel)){
+                    if(fespace.traces[itrace].face->bctype != BOUNDARY_CONDITIONS::PARALLEL_COM)
+                        traces_to_visit.insert(itrace);
                 }
             }
 
@@ -920,13 +1708,13 @@ template<
                     T eps_scaled = scale_fd_epsilon(epsilon, std::max(resL.vector_norm(), resR.vector_norm()));
 
                     // get the original parameterization 
-                    auto* parametrization = geo_map.parametric_accessors[jmdg].get();
+                    auto* parametrization = geo_accessor(jmdg);
                     std::vector<T> s(parametrization->s_size());
                     parametrization->x_to_s(fespace.meshptr->coord[inode], s);
 
                     // loop over dimension of the geometric parameterization and peturb
-                    for(int is = 0; is < x.nv(jmdg); ++is){
-                        IDX jcol = mdg_range_beg + geo_map.cols[jmdg] + is;
+                    for(int is = 0; is < geo_accessor(jmdg)->s_size(); ++is){
+                        IDX jcol = geo_col(jmdg, is);
 
                         T old_val = s[is];
                         s[is] += eps_scaled;
@@ -946,7 +1734,7 @@ template<
                             for(IDX ieqf = 0; ieqf < resL.nv(); ++ieqf){
                                 IDX irow = proc_range_beg + glob_index_L + resL.get_layout()[idoff, ieqf];
                                 T fd_val = (resLp[idoff, ieqf] - resL[idoff, ieqf]) / eps_scaled;
-                                MatSetValue(jac, irow, jcol, fd_val, ADD_VALUES);
+                                add_geo_value(irow, jcol, fd_val);
                             }
                         }
 
@@ -956,7 +1744,7 @@ template<
                                 for(IDX ieqf = 0; ieqf < resR.nv(); ++ieqf){
                                     IDX irow = proc_range_beg + glob_index_R + resR.get_layout()[idoff, ieqf];
                                     T fd_val = (resRp[idoff, ieqf] - resR[idoff, ieqf]) / eps_scaled;
-                                    MatSetValue(jac, irow, jcol, fd_val, ADD_VALUES);
+                                    add_geo_value(irow, jcol, fd_val);
                                 }
                             }
                         }
@@ -970,8 +1758,10 @@ template<
             }
 
             // loop over the traces selected for interface conservation 
-            for(IDX itrace : geo_map.selected_traces) {
-                
+            // in the extended stencil around the node
+            for(IDX itrace : traces_to_visit) {
+                if(!is_ic_trace[itrace]) continue;
+
                 const Trace& trace = fespace.traces[itrace];
 
                 // set up compact data views
@@ -996,6 +1786,48 @@ template<
                     resp_storage.resize(res_layout.size());
                     dofspan resp{resp_storage, res_layout};
 
+                    // exact shape derivatives if the discretization provides them
+                    jacL_storage.resize(res.size() * ndim);
+                    mdspan dres_dx{jacL_storage.data(), extents{res.size(), (std::size_t) ndim}};
+                    bool analytic_shape = false;
+                    if constexpr (provides_interface_shape_jacobian<disc_class, Trace, NodeArray<T, ndim>,
+                            decltype(uL), IDX, decltype(dres_dx)>) {
+                        analytic_shape = disc.interface_conservation_shape_jacobian(
+                                trace, fespace.meshptr->coord, uL, uR, inode, dres_dx);
+                    }
+                    if(analytic_shape) {
+                        // chain rule with the parameterization dx/ds 
+                        // (finite difference of the geometric map only, exact for affine parameterizations)
+                        auto* parametrization = geo_accessor(jmdg);
+                        std::vector<T> s(parametrization->s_size());
+                        parametrization->x_to_s(fespace.meshptr->coord[inode], s);
+                        std::array<T, ndim> x0, xp;
+                        for(int idim = 0; idim < ndim; ++idim) x0[idim] = fespace.meshptr->coord[inode][idim];
+                        for(int is = 0; is < geo_accessor(jmdg)->s_size(); ++is){
+                            IDX jcol = geo_col(jmdg, is);
+                            T old_val = s[is];
+                            T h = scale_fd_epsilon(epsilon, std::abs(old_val));
+                            s[is] += h;
+                            parametrization->s_to_x(s, xp);
+                            s[is] = old_val;
+
+                            for(IDX idoff = 0; idoff < res.ndof(); ++idoff){
+                                // only scatter if node is actually in nodeset 
+                                IDX ignode = trace.face->nodes()[idoff];
+                                if(ic_row(ignode, 0) >= 0){
+                                    for(IDX ieqf = 0; ieqf < neq; ++ieqf){
+                                        IDX irow = ic_row(ignode, ieqf);
+                                        T dres_ds = 0;
+                                        for(int idim = 0; idim < ndim; ++idim)
+                                            { dres_ds += dres_dx[res.get_layout()[idoff, ieqf], idim] * (xp[idim] - x0[idim]) / h; }
+                                        add_geo_value(irow, jcol, dres_ds);
+                                    }
+                                }
+                            }
+                        }
+                        continue;
+                    }
+
                     // get the unperturbed residual
                     res = 0;
                     disc.interface_conservation(trace, fespace.meshptr->coord, uL, uR, res);
@@ -1003,14 +1835,14 @@ template<
                     T eps_scaled = scale_fd_epsilon(epsilon, res.vector_norm());
 
                     // get the original parameterization 
-                    auto* parametrization = geo_map.parametric_accessors[jmdg].get();
+                    auto* parametrization = geo_accessor(jmdg);
                     std::vector<T> s(parametrization->s_size());
                     parametrization->x_to_s(fespace.meshptr->coord[inode], s);
 
                     // loop over dimension of the geometric parameterization and peturb
-                    for(int is = 0; is < x.nv(jmdg); ++is){
+                    for(int is = 0; is < geo_accessor(jmdg)->s_size(); ++is){
 
-                        IDX jcol = mdg_range_beg + geo_map.cols[jmdg] + is;
+                        IDX jcol = geo_col(jmdg, is);
 
                         T old_val = s[is];
                         s[is] += eps_scaled;
@@ -1025,14 +1857,13 @@ template<
 
                             // only scatter if node is actually in nodeset 
                             IDX ignode = trace.face->nodes()[idoff];
-                            IDX igdof = geo_map.inv_selected_nodes[ignode];
                             
-                            if(igdof != geo_map.selected_nodes.size()){
+                            if(ic_row(ignode, 0) >= 0){
                                 for(IDX ieqf = 0; ieqf < neq; ++ieqf){
                                     // get the global row index based on the dof in node selection
-                                    IDX irow = mdg_range_beg + mdg_residual.get_layout()[igdof, ieqf];
+                                    IDX irow = ic_row(ignode, ieqf);
                                     T fd_val = (resp[idoff, ieqf] - res[idoff, ieqf]) / eps_scaled;
-                                    MatSetValue(jac, irow, jcol, fd_val, ADD_VALUES);
+                                    add_geo_value(irow, jcol, fd_val);
                                 }
                             }
                         }
@@ -1046,6 +1877,9 @@ template<
             }
 
         }
+
+        // add the scattered interface conservation and stored geometry column entries
+        mdg_entries.flush(jac, false, comm);
     }
 
     template<
@@ -1062,6 +1896,7 @@ template<
         T epsilon = std::sqrt(std::numeric_limits<T>::epsilon())
     ) -> void 
     {
+        ICEICLE_PROFILE_REGION("form_jacobian_dense");
 
         petsc::VecSpan res_span{res};
         std::vector<T> resp_data(res_span.size());
@@ -6,6 +6,7 @@
 
 #pragma once 
 #include "iceicle/anomaly_log.hpp"
+#include "iceicle/disc/kernel_work.hpp"
 #include "iceicle/element/finite_element.hpp"
 #include "iceicle/fe_function/fespan.hpp"
 #include "iceicle/fe_function/geo_layouts.hpp"
@@ -14,7 +15,14 @@
 #include "iceicle/fe_function/component_span.hpp"
 #include "iceicle/fespace/fespace.hpp"
 #include "iceicle/geometry/face.hpp"
+#include "iceicle/profiler.hpp"
+#include "iceicle/residual_workspace.hpp"
 #include "iceicle/tmp_utils.hpp"
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <ranges>
+#include <span>
 #include <type_traits>
 
 #ifdef ICEICLE_USE_MPI
@@ -38,12 +46,124 @@ namespace iceicle::solvers {
         std::convertible_to<decltype(disc_class::dnv_comp), int>
         && std::convertible_to<decltype(disc_class::nv_comp), int>;
 
+    /**
+     * @brief call the domain integral of the discretization with the concrete transformation type 
+     * and the compile time element sizes of the element batch (see FESpace::dispatch_element_kernel) 
+     * if the discretization does not take the tags, calls the regular domain integral
+     *
+     * @param disc the discretization
+     * @param el the element
+     * @param u_el the element solution 
+     * @param res_el the element residual to add to
+     * @param trans_tag std::type_identity of the concrete transformation type (or void)
+     * @param sizes_tag std::type_identity of the fixed_element_sizes (or void)
+     */
+    template<class disc_class, class ElementT, class TransT, class SizesT = void>
+    inline void domain_integral_batched(
+        disc_class &disc,
+        const ElementT &el,
+        auto u_el,
+        auto res_el,
+        std::type_identity<TransT> trans_tag,
+        std::type_identity<SizesT> sizes_tag = {}
+    ) {
+        if constexpr (requires { disc.domain_integral(el, u_el, res_el, trans_tag, sizes_tag); }) {
+            disc.domain_integral(el, u_el, res_el, trans_tag, sizes_tag);
+        } else if constexpr (requires { disc.domain_integral(el, u_el, res_el, trans_tag); }) {
+            disc.domain_integral(el, u_el, res_el, trans_tag);
+        } else {
+            disc.domain_integral(el, u_el, res_el);
+        }
+    }
+
+    /**
+     * @brief add the trace integral (boundary integral for boundary traces) and the interface conservation residual of a trace
+     * with the combined trace kernel of the discretization for interior traces if it has one
+     * (the interface states and fluxes are shared, see ConservationLawDDG::trace_integral_interface_conservation)
+     * otherwise calls trace_integral or boundaryIntegral then interface_conservation
+     *
+     * @param disc the discretization
+     * @param trace the trace
+     * @param coord the node coordinates
+     * @param uL the left element solution
+     * @param uR the right element solution
+     * @param resL the left element residual to add to
+     * @param resR the right element residual to add to (unused for boundary traces)
+     * @param ic_res the interface conservation residual of the trace to add to
+     */
+    template<class disc_class, class TraceT, class CoordT>
+    inline void trace_interface_conservation(
+        disc_class &disc,
+        const TraceT &trace,
+        CoordT &coord,
+        auto uL,
+        auto uR,
+        auto resL,
+        auto resR,
+        auto ic_res
+    ) {
+        if(trace.face->bctype == BOUNDARY_CONDITIONS::INTERIOR){
+            if constexpr (requires { disc.trace_integral_interface_conservation(trace, coord, uL, uR, resL, resR, ic_res); }) {
+                disc.trace_integral_interface_conservation(trace, coord, uL, uR, resL, resR, ic_res);
+            } else {
+                disc.trace_integral(trace, coord, uL, uR, resL, resR);
+                disc.interface_conservation(trace, coord, uL, uR, ic_res);
+            }
+        } else {
+            disc.boundaryIntegral(trace, coord, uL, uR, resL);
+            disc.interface_conservation(trace, coord, uL, uR, ic_res);
+        }
+    }
+
+    /**
+     * @brief update the solution dependent data that the discretization caches between residual evaluations
+     * (i.e the artificial viscosity of ConservationLawDDG)
+     * does nothing if the discretization does not cache any
+     *
+     * @param fespace the finite element space 
+     * @param disc the discretization
+     * @param u the current solution
+     * @return true if the cached data changed (so residuals evaluated before are stale)
+     */
+    template<class T, class IDX, int ndim, class disc_class, class uLayoutPolicy, class uAccessorPolicy>
+    inline auto update_cached_state(
+        FESpace<T, IDX, ndim> &fespace,
+        disc_class &disc,
+        fespan<T, uLayoutPolicy, uAccessorPolicy> u
+    ) -> bool {
+        if constexpr (requires { disc.update_cached_state(fespace, u); }) {
+            return disc.update_cached_state(fespace, u);
+        } else {
+            return false;
+        }
+    }
+
     /**
      * @brief form the residual based on the fespace and discretization 
      * The residual is the function over the vector components for each degree of freedom
      * where getting a residual of 0 solves the discretized portion of the equation 
      * (i.e. for semi-discrete forms M du/dt = residual)
      *
+     * Inter-process element data is communicated with the halo exchange in the workspace
+     * which overlaps with the boundary, interior trace, and domain integrals.
+     * The parallel communication traces are processed last.
+     * The element data of the interior trace workspace.trace_prefetch_distance traces ahead 
+     * is prefetched while the current trace is integrated 
+     * (the two elements of a trace are generally far apart in memory so hardware prefetchers miss them).
+     * If the workspace monitors the residual norms, they are accumulated as each element residual completes
+     * and their reduction is started before returning.
+     * If the workspace collects the interface conservation residual (see form_dg_mdg_residual)
+     * the selected interior traces also form it into the workspace cache with the same flux evaluations.
+     * If the workspace tracks the element activity (see ResidualWorkspace::enable_activity_tracking)
+     * the residual of the inactive elements is left at zero and the traces between two inactive elements are skipped.
+     * If the workspace samples the element costs (see ResidualWorkspace::enable_cost_sampling)
+     * every sample_interval-th call times the kernels of each element and the phases.
+     *
+     * element_done(iel, ithread) is called once for each element as soon as its residual is complete
+     * (on the thread that completed it, ithread indexes per thread storage of size workspace.nthread)
+     * so the caller can consume the element residual while it is still in cache.
+     * It must not write to u or res of other elements.
+     *
      * @tparam T the floaating point type
      * @tparam IDX the index type 
      * @tparam ndim the number of dimensions 
@@ -51,7 +171,11 @@ namespace iceicle::solvers {
      *
      * @param fespace the finite element space 
      * @param disc the discretization
-     * @param u_data the 
+     * @param u the solution 
+     * @param res the residual to fill
+     * @param workspace persistent scratch storage, halo exchange, and trace orderings
+     *        constructed from this fespace
+     * @param element_done the callback for each completed element residual
      */
     template<
         class T, 
@@ -60,162 +184,136 @@ namespace iceicle::solvers {
         class disc_class,
         class uLayoutPolicy,
         class uAccessorPolicy,
-        class resLayoutPolicy
+        class resLayoutPolicy,
+        class ElementDone
     >
     void form_residual(
         FESpace<T, IDX, ndim> &fespace,
         disc_class &disc,
         fespan<T, uLayoutPolicy, uAccessorPolicy> u,
-        fespan<T, resLayoutPolicy> res
+        fespan<T, resLayoutPolicy> res,
+        ResidualWorkspace<T, IDX>& workspace,
+        ElementDone&& element_done
     )
-    requires specifies_ncomp<disc_class>
+    requires specifies_ncomp<disc_class> && std::invocable<ElementDone&, IDX, int>
     {
         using Element = FiniteElement<T, IDX, ndim>;
         using Trace = TraceSpace<T, IDX, ndim>;
+        ICEICLE_PROFILE_REGION("form_residual");
+
+        // start communicating inter-process element data 
+        HaloExchange<T, IDX>& halo = workspace.halo;
+        halo.begin_exchange(u);
+
+        // bring cached geometric factors up to date with any moved nodes
+        fespace.update_geometric_factors();
+
+        // analytic work of each phase for the achieved GFLOP/s and GB/s (only counted once per workspace)
+        if(util::Profiler::enabled() && !workspace.phase_work){
+            auto indexed = [&](const std::vector<IDX>& itraces){
+                return itraces | std::views::transform([&](IDX itrace) -> const Trace& { return fespace.traces[itrace]; });
+            };
+            workspace.phase_work = std::array<kernel_work, 3>{
+                trace_work<T, ndim>(disc, indexed(workspace.physical_bdy_traces), true),
+                trace_work<T, ndim>(disc, fespace.get_interior_traces(), false) + domain_work<T, ndim>(disc, fespace.elements),
+                trace_work<T, ndim>(disc, indexed(workspace.parallel_com_traces), true)
+            };
+        }
+        auto add_phase_work = [&](int iphase){
+            if(workspace.phase_work)
+                { ICEICLE_PROFILE_WORK((*workspace.phase_work)[iphase].flops, (*workspace.phase_work)[iphase].bytes); }
+        };
 
         // zero out the residual
         res = 0;
+        ResidualNormMonitor<T>& monitor = workspace.monitor;
+        if(monitor.enabled()) monitor.begin_accumulate();
+        const ElementActivity<T, IDX>& activity = workspace.activity;
+
+        // time the elements and phases if this evaluation is sampled
+        using cost_time = typename ElementCost<T, IDX>::clock::time_point;
+        ElementCost<T, IDX>& cost = workspace.cost;
+        cost.begin_evaluation();
+        const bool timed = cost.sampled();
+        cost_time phase_start{};
+
+        // storage for compact views of u and res 
+        T *uL_data = workspace.scratch_data(0, 0);
+        T *uR_data = workspace.scratch_data(0, 1);
+        T *resL_data = workspace.scratch_data(0, 2);
+        T *resR_data = workspace.scratch_data(0, 3);
+
+        // boundary faces (excluding parallel communication)
+        {
+        ICEICLE_PROFILE_REGION("boundary_traces");
+        if(timed) phase_start = cost.now();
+        for(const auto& group : workspace.physical_bdy_groups){
+        // resolve the boundary condition once for the group
+        dispatch_bctype(group.bctype, [&](auto bc){
+        for(std::size_t i = group.begin; i < group.end; ++i){
+            const Trace& trace = fespace.traces[workspace.physical_bdy_traces[i]];
+            if(!activity.active(trace.elL.elidx)) continue;
+            cost_time start{};
+            if(timed) start = cost.now();
 
-        // preallocate storage for compact views of u and res 
-        const std::size_t max_local_size =
-            fespace.dg_map.max_el_size_reqirement(disc_class::nv_comp);
-        T *uL_data = new T[max_local_size];
-        T *uR_data = new T[max_local_size];
-        T *resL_data = new T[max_local_size];
-        T *resR_data = new T[max_local_size];
-
-#ifdef ICEICLE_USE_MPI
-        int myrank, nrank;
-        MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
-        MPI_Comm_size(MPI_COMM_WORLD, &nrank);
-        std::vector< std::vector< std::vector< T > > > interprocess_u(nrank);
-        for(int irank = 0; irank < nrank; ++irank) {
-            // we want to index by local element index on the other rank 
-            // so we resize to the maximum of the local element indexes we know of
-            std::vector<IDX>& recv_list = fespace.meshptr->el_recv_list[irank];
-            IDX max_iel = (recv_list.size() == 0) ? 0 : std::ranges::max(recv_list) + 1;
-            interprocess_u[irank].resize(max_iel);
-        }
-
-        // communicate inter-process element data 
-        for(int irank = 0; irank < nrank; ++irank){
-            if(irank == myrank) {
-                // send data to each process
-                for(int jrank = 0; jrank < nrank; ++jrank){
-                    for(IDX ielem : fespace.meshptr->el_send_list[jrank]){
-                        // set up the buffer and layout
-                        FiniteElement<T, IDX, ndim>& el = fespace.elements[ielem];
-                        compact_layout_right<IDX, disc_class::nv_comp> layout(el);
-                        int size = layout.size();
-                        std::vector<T> u_to_send(size);
-
-                        // copy over the data to send into the buffer
-                        dofspan uel{u_to_send, layout};
-                        extract_elspan(ielem, u, uel);
-
-                        // send the data
-                        MPI_Send(u_to_send.data(), size, mpi_get_type<T>(), jrank, ielem, MPI_COMM_WORLD);
-                    }
-                }
-            } else {
-                for(int irecv = 0; irecv < fespace.meshptr->el_recv_list[irank].size(); ++irecv){
-                    IDX ielem = fespace.meshptr->el_recv_list[irank][irecv];
-                    // set up the layout for sizing
-                    FiniteElement<T, IDX, ndim>& el = fespace.comm_elements[irank][irecv];
-                    compact_layout_right<IDX, disc_class::nv_comp> layout(el);
-                    int size = layout.size();
-                    interprocess_u[irank][ielem].resize(size);
-
-                    // get the data
-                    MPI_Recv(interprocess_u[irank][ielem].data(), size, mpi_get_type<T>(), 
-                        irank, ielem, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-                }
-            }
-        }
-#endif
-
-        // boundary faces 
-        for(const Trace &trace : fespace.get_boundary_traces()){
-
-            if(trace.face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) {
-
-#ifdef ICEICLE_USE_MPI
-                auto [jrank, imleft] = decode_mpi_bcflag(trace.face->bcflag);
-                if(imleft){
-                    // set up compact data layouts
-                    auto uL_layout = u.create_element_layout(trace.elL.elidx);
-                    dofspan uL{uL_data, uL_layout};
-                    compact_layout_right<IDX, disc_class::nv_comp> uR_layout{trace.elR};
-                    dofspan uR{interprocess_u[jrank][trace.face->elemR], uR_layout};
-
-                    auto resL_layout = res.create_element_layout(trace.elL.elidx);
-                    dofspan resL{resL_data, resL_layout};
-                    compact_layout_right<IDX, disc_class::nv_comp> resR_layout{trace.elR};
-                    dofspan resR{resR_data, resR_layout};
-
-                    // extract the compact values from the global u view
-                    extract_elspan(trace.elL.elidx, u, uL);
-
-                    // zero out residual 
-                    resL = 0;
-
-                    disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, resL, resR);
-
-                    // scatter only the left
-                    scatter_elspan(trace.elL.elidx, 1.0, resL, 1.0, res);
-                } else {
-                    compact_layout_right<IDX, disc_class::nv_comp> uL_layout{trace.elL};
-                    dofspan uL{interprocess_u[jrank][trace.face->elemL], uL_layout};
-                    auto uR_layout = u.create_element_layout(trace.elR.elidx);
-                    dofspan uR{uR_data, uR_layout};
-
-
-                    compact_layout_right<IDX, disc_class::nv_comp> resL_layout{trace.elL};
-                    dofspan resL{resL_data, resL_layout};
-                    auto resR_layout = u.create_element_layout(trace.elR.elidx);
-                    dofspan resR{resR_data, resR_layout};
-
-                    // extract the compact values from the global u view
-                    extract_elspan(trace.elR.elidx, u, uR);
+            // set up compact data views
+            auto uL_layout = u.create_element_layout(trace.elL.elidx);
+            dofspan uL{uL_data, uL_layout};
+            auto uR_layout = u.create_element_layout(trace.elR.elidx);
+            dofspan uR{uR_data, uR_layout};
 
-                    // zero out residual 
-                    resR = 0;
+            auto resL_layout = res.create_element_layout(trace.elL.elidx);
+            dofspan resL{resL_data, resL_layout};
 
-                    disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, resL, resR);
+            // extract the compact values from the global u view
+            extract_elspan(trace.elL.elidx, u, uL);
+            extract_elspan(trace.elR.elidx, u, uR);
 
-                    // scatter only the right
-                    scatter_elspan(trace.elR.elidx, 1.0, resR, 1.0, res);
-                }
-#else 
-                util::AnomalyLog::log_anomaly(util::Anomaly{"Built without mpi, parallel communication boundary condition will not work", util::general_anomaly_tag{}});
-#endif
+            // zero out the residual
+            resL = 0;
 
+            // use the boundary condition specialized integral if the discretization has one
+            if constexpr (requires { disc.boundaryIntegral(bc, trace, fespace.meshptr->coord, uL, uR, resL); }) {
+                disc.boundaryIntegral(bc, trace, fespace.meshptr->coord, uL, uR, resL);
             } else {
-                // set up compact data views
-                auto uL_layout = u.create_element_layout(trace.elL.elidx);
-                dofspan uL{uL_data, uL_layout};
-                auto uR_layout = u.create_element_layout(trace.elR.elidx);
-                dofspan uR{uR_data, uR_layout};
-
-                auto resL_layout = res.create_element_layout(trace.elL.elidx);
-                dofspan resL{resL_data, resL_layout};
-
-                // extract the compact values from the global u view
-                extract_elspan(trace.elL.elidx, u, uL);
-                extract_elspan(trace.elR.elidx, u, uR);
-
-                // zero out the residual
-                resL = 0;
-
                 disc.boundaryIntegral(trace, fespace.meshptr->coord, uL, uR, resL);
-
-                scatter_elspan(trace.elL.elidx, 1.0, resL, 1.0, res);
             }
 
+            scatter_elspan(trace.elL.elidx, 1.0, resL, 1.0, res);
+            if(timed) cost.charge(trace.elL.elidx, cost.elapsed(start));
+        }
+        });
+        }
+        add_phase_work(0);
+        if(timed) cost.charge_phase(0, cost.elapsed(phase_start));
         }
 
-        // interior faces 
-        for(const Trace &trace : fespace.get_interior_traces()){
+        // the interior trace integral
+        // with the interface conservation residual if it is collected for this trace
+        auto interior_trace_integral = [&](const Trace& trace, auto uL, auto uR, auto resL, auto resR){
+            std::size_t ic_offset = (workspace.collect_interface_conservation)
+                ? workspace.ic_res_offset(fespace, trace.facidx) : workspace.no_ic_trace;
+            if(ic_offset != workspace.no_ic_trace){
+                trace_layout_right<IDX, disc_class::nv_comp> ic_layout{trace};
+                dofspan ic_res{workspace.ic_res_cache.data() + ic_offset, ic_layout};
+                ic_res = 0;
+                trace_interface_conservation(disc, trace, fespace.meshptr->coord, uL, uR, resL, resR, ic_res);
+            } else {
+                disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, resL, resR);
+            }
+        };
+
+        // interior face contribution given scratch storage
+        auto interior_trace_residual = [&](const Trace& trace,
+                T* uL_data, T* uR_data, T* resL_data, T* resR_data)
+        {
+            // only the active sides receive the residual
+            const bool activeL = activity.active(trace.elL.elidx);
+            const bool activeR = activity.active(trace.elR.elidx);
+            if(!activeL && !activeR && !workspace.collect_interface_conservation) return;
+            cost_time start{};
+            if(timed) start = cost.now();
+
             // set up compact data views
             auto uL_layout = u.create_element_layout(trace.elL.elidx);
             dofspan uL{uL_data, uL_layout};
@@ -235,36 +333,414 @@ namespace iceicle::solvers {
             resL = 0;
             resR = 0;
 
-           disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, resL, resR); 
+           interior_trace_integral(trace, uL, uR, resL, resR);
+
+           if(activeL) scatter_elspan(trace.elL.elidx, 1.0, resL, 1.0, res);
+           if(activeR) scatter_elspan(trace.elR.elidx, 1.0, resR, 1.0, res);
+
+           // traces within a color do not share elements so the charges do not race
+           if(timed){
+               double seconds = cost.elapsed(start);
+               cost.charge(trace.elL.elidx, 0.5 * seconds);
+               cost.charge(trace.elR.elidx, 0.5 * seconds);
+           }
+        };
+
+        // start loading the element data of a trace that will be integrated soon
+        const std::size_t prefetch_distance = std::max(workspace.trace_prefetch_distance, 0);
+        auto prefetch_trace = [&](const Trace& trace){
+            prefetch_elspan(trace.elL.elidx, u);
+            prefetch_elspan(trace.elR.elidx, u);
+            prefetch_elspan<true>(trace.elL.elidx, res);
+            prefetch_elspan<true>(trace.elR.elidx, res);
+        };
+
+        // domain integral contribution given scratch storage
+        // and the concrete transformation type and element sizes of the element batch
+        // the residual of the element is complete after this unless it is on a process boundary
+        auto domain_residual = [&](const Element& el, T* u_data, T* res_data, auto trans_tag, auto sizes_tag, int ithread)
+        {
+            if(activity.active(el.elidx)){
+                cost_time start{};
+                if(timed) start = cost.now();
+
+                // set up compact data views (reuse the storage defined for traces)
+                auto uel_layout = u.create_element_layout(el.elidx);
+                dofspan u_el{u_data, uel_layout};
+
+                auto ures_layout = res.create_element_layout(el.elidx);
+                dofspan res_el{res_data, ures_layout};
+
+                // extract the compact values from the global u view 
+                extract_elspan(el.elidx, u, u_el);
+
+                // zero out the residual 
+                res_el = 0;
+
+                domain_integral_batched(disc, el, u_el, res_el, trans_tag, sizes_tag);
+
+                scatter_elspan(el.elidx, 1.0, res_el, 1.0, res);
+                if(timed) cost.charge(el.elidx, cost.elapsed(start));
+            }
+
+            if(!workspace.is_parallel_com_element[el.elidx]){
+                if(monitor.enabled()) monitor.accumulate(ithread, el.elidx, el.nbasis(), res);
+                element_done(el.elidx, ithread);
+            }
+        };
+
+        // element-centric traversal (see ResidualWorkspace::enable_element_centric)
+        // the solution of the element is extracted once for the domain integral and the traces it is the left element of
+        // the discretization must add to the residual views (as every discretization in the library does)
+        // so the traces accumulate directly into the element residual
+        if(workspace.element_centric
+                && workspace.trace_res_offsets.size() != fespace.interior_trace_end - fespace.interior_trace_start)
+            { workspace.enable_element_centric(fespace, disc_class::dnv_comp); }
+        auto fused_element_residual = [&](const Element& el, T* u_data, T* uR_data, T* res_data, auto trans_tag, auto sizes_tag)
+        {
+            cost_time start{};
+            if(timed) start = cost.now();
+            auto uel_layout = u.create_element_layout(el.elidx);
+            dofspan u_el{u_data, uel_layout};
+            auto res_layout = res.create_element_layout(el.elidx);
+            dofspan res_el{res_data, res_layout};
+
+            const bool active = activity.active(el.elidx);
+            extract_elspan(el.elidx, u, u_el);
+            res_el = 0;
+            if(active) domain_integral_batched(disc, el, u_el, res_el, trans_tag, sizes_tag);
+
+            for(IDX itrace : workspace.el_owned_traces.rowspan(el.elidx)){
+                const Trace& trace = fespace.traces[itrace];
+
+                // the right element residual is written straight to the cache
+                auto resR_layout = res.create_element_layout(trace.elR.elidx);
+                dofspan resR{workspace.trace_res_cache.data()
+                    + workspace.trace_res_offsets[itrace - fespace.interior_trace_start], resR_layout};
+                resR = 0;
+                if(!active && !activity.active(trace.elR.elidx) && !workspace.collect_interface_conservation) continue;
 
-           scatter_elspan(trace.elL.elidx, 1.0, resL, 1.0, res);
-           scatter_elspan(trace.elR.elidx, 1.0, resR, 1.0, res);
+                auto uR_layout = u.create_element_layout(trace.elR.elidx);
+                dofspan uR{uR_data, uR_layout};
+                extract_elspan(trace.elR.elidx, u, uR);
+
+                interior_trace_integral(trace, u_el, uR, res_el, resR);
+            }
+            if(active) scatter_elspan(el.elidx, 1.0, res_el, 1.0, res);
+            if(timed) cost.charge(el.elidx, cost.elapsed(start));
+        };
+
+        // add the cached residual of the traces the element is the right element of
+        // the residual of the element is complete after this unless it is on a process boundary
+        auto received_trace_residual = [&](IDX iel, int ithread)
+        {
+            auto res_layout = res.create_element_layout(iel);
+            if(activity.active(iel)){
+                cost_time start{};
+                if(timed) start = cost.now();
+                for(IDX itrace : workspace.el_received_traces.rowspan(iel)){
+                    dofspan res_trace{workspace.trace_res_cache.data()
+                        + workspace.trace_res_offsets[itrace - fespace.interior_trace_start], res_layout};
+                    scatter_elspan(iel, 1.0, res_trace, 1.0, res);
+                }
+                if(timed) cost.charge(iel, cost.elapsed(start));
+            }
+            if(!workspace.is_parallel_com_element[iel]){
+                if(monitor.enabled()) monitor.accumulate(ithread, iel, fespace.elements[iel].nbasis(), res);
+                element_done(iel, ithread);
+            }
+        };
+
+        auto element_centric_residual = [&]{
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp parallel num_threads(workspace.nthread)
+            {
+                int ithread = util::thread_num();
+                for(IDX ibatch = 0; ibatch < fespace.element_batches.nrow(); ++ibatch){
+                    fespace.dispatch_element_kernel(ibatch, [&](auto trans_tag, auto sizes_tag, std::span<const IDX> elidxs){
+#pragma omp for schedule(static)
+                        for(std::size_t i = 0; i < elidxs.size(); ++i){
+                            fused_element_residual(fespace.elements[elidxs[i]], workspace.scratch_data(ithread, 0),
+                                workspace.scratch_data(ithread, 1), workspace.scratch_data(ithread, 2), trans_tag, sizes_tag);
+                        }
+                    });
+                }
+                // implicit barrier: every trace cache is written
+#pragma omp for schedule(static)
+                for(std::size_t iel = 0; iel < fespace.elements.size(); ++iel)
+                    { received_trace_residual(iel, ithread); }
+            }
+            halo.finish_exchange();
+#elifdef ICEICLE_USE_TASK_POOL
+            util::task_pool& pool = util::global_task_pool();
+            using task_id = util::task_pool::task_id;
+            std::vector<task_id> batches_done{};
+            for(IDX ibatch = 0; ibatch < fespace.element_batches.nrow(); ++ibatch){
+                fespace.dispatch_element_kernel(ibatch, [&](auto trans_tag, auto sizes_tag, std::span<const IDX> elidxs){
+                    batches_done.push_back(pool.submit_ranges(workspace.batch_task_bounds[ibatch],
+                        [&, trans_tag, sizes_tag, elidxs](std::size_t begin, std::size_t end){
+                            int ithread = pool.thread_index();
+                            for(std::size_t i = begin; i < end; ++i){
+                                fused_element_residual(fespace.elements[elidxs[i]], workspace.scratch_data(ithread, 0),
+                                    workspace.scratch_data(ithread, 1), workspace.scratch_data(ithread, 2), trans_tag, sizes_tag);
+                            }
+                        }));
+                });
+            }
+            // the cached trace residuals can be written by any batch
+            for(IDX ibatch = 0; ibatch < fespace.element_batches.nrow(); ++ibatch){
+                std::span<const IDX> elidxs = fespace.element_batches.rowspan(ibatch);
+                pool.submit_ranges(workspace.batch_task_bounds[ibatch],
+                    [&, elidxs](std::size_t begin, std::size_t end){
+                        int ithread = pool.thread_index();
+                        for(std::size_t i = begin; i < end; ++i) received_trace_residual(elidxs[i], ithread);
+                    }, batches_done);
+            }
+            halo.finish_exchange();
+            pool.wait_all();
+#else
+            for(IDX ibatch = 0; ibatch < fespace.element_batches.nrow(); ++ibatch){
+                fespace.dispatch_element_kernel(ibatch, [&](auto trans_tag, auto sizes_tag, std::span<const IDX> elidxs){
+                    for(IDX iel : elidxs)
+                        { fused_element_residual(fespace.elements[iel], uL_data, uR_data, resL_data, trans_tag, sizes_tag); }
+                });
+            }
+            for(IDX iel = 0; iel < (IDX) fespace.elements.size(); ++iel) received_trace_residual(iel, 0);
+            halo.finish_exchange();
+#endif
+        };
+
+        {
+        ICEICLE_PROFILE_REGION("interior_and_domain");
+        add_phase_work(1);
+        if(timed) phase_start = cost.now();
+        if(workspace.element_centric) {
+            element_centric_residual();
+        } else {
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp parallel num_threads(workspace.nthread)
+        {
+            // each thread gets its own scratch storage
+            int ithread = util::thread_num();
+            T* uL_thread = workspace.scratch_data(ithread, 0);
+            T* uR_thread = workspace.scratch_data(ithread, 1);
+            T* resL_thread = workspace.scratch_data(ithread, 2);
+            T* resR_thread = workspace.scratch_data(ithread, 3);
+
+            // interior faces 
+            // traces within a color do not share elements so scatters do not race
+            for(IDX icolor = 0; icolor < fespace.interior_trace_colors.nrow(); ++icolor){
+                std::span<IDX> color = fespace.interior_trace_colors.rowspan(icolor);
+#pragma omp for schedule(static)
+                for(std::size_t i = 0; i < color.size(); ++i){
+                    if(prefetch_distance > 0 && i + prefetch_distance < color.size())
+                        { prefetch_trace(fespace.traces[color[i + prefetch_distance]]); }
+                    interior_trace_residual(fespace.traces[color[i]],
+                        uL_thread, uR_thread, resL_thread, resR_thread);
+                }
+                // implicit barrier before the next color
+            }
+
+            // domain integral batched by element type
+            for(IDX ibatch = 0; ibatch < fespace.element_batches.nrow(); ++ibatch){
+                fespace.dispatch_element_kernel(ibatch, [&](auto trans_tag, auto sizes_tag, std::span<const IDX> elidxs){
+#pragma omp for schedule(static)
+                    for(std::size_t i = 0; i < elidxs.size(); ++i){
+                        domain_residual(fespace.elements[elidxs[i]], uL_thread, resL_thread, trans_tag, sizes_tag, ithread);
+                    }
+                });
+            }
         }
+        // finish the inter-process communication 
+        halo.finish_exchange();
+#elifdef ICEICLE_USE_TASK_POOL
+        util::task_pool& pool = util::global_task_pool();
+        using task_id = util::task_pool::task_id;
 
-        // domain integral
-        for(const Element &el : fespace.elements){
-            // set up compact data views (reuse the storage defined for traces)
-            auto uel_layout = u.create_element_layout(el.elidx);
-            dofspan u_el{uL_data, uel_layout};
+        // interior faces 
+        // traces within a color do not share elements so scatters do not race
+        // each color depends on the previous color
+        std::vector<task_id> deps{};
+        for(IDX icolor = 0; icolor < fespace.interior_trace_colors.nrow(); ++icolor){
+            std::span<IDX> color = fespace.interior_trace_colors.rowspan(icolor);
+            task_id color_done = pool.submit_ranges(workspace.color_task_bounds[icolor],
+                [&, color](std::size_t begin, std::size_t end){
+                    // each thread gets its own scratch storage
+                    int ithread = pool.thread_index();
+                    for(std::size_t i = begin; i < end; ++i){
+                        if(prefetch_distance > 0 && i + prefetch_distance < end)
+                            { prefetch_trace(fespace.traces[color[i + prefetch_distance]]); }
+                        interior_trace_residual(fespace.traces[color[i]],
+                            workspace.scratch_data(ithread, 0), workspace.scratch_data(ithread, 1),
+                            workspace.scratch_data(ithread, 2), workspace.scratch_data(ithread, 3));
+                    }
+                }, deps);
+            deps = {color_done};
+        }
 
-            auto ures_layout = res.create_element_layout(el.elidx);
-            dofspan res_el{resL_data, ures_layout};
+        // domain integral batched by element type 
+        // the batches touch distinct elements so only depend on the interior faces
+        for(IDX ibatch = 0; ibatch < fespace.element_batches.nrow(); ++ibatch){
+            fespace.dispatch_element_kernel(ibatch, [&](auto trans_tag, auto sizes_tag, std::span<const IDX> elidxs){
+                pool.submit_ranges(workspace.batch_task_bounds[ibatch],
+                    [&, trans_tag, sizes_tag, elidxs](std::size_t begin, std::size_t end){
+                        int ithread = pool.thread_index();
+                        for(std::size_t i = begin; i < end; ++i){
+                            domain_residual(fespace.elements[elidxs[i]], workspace.scratch_data(ithread, 0),
+                                workspace.scratch_data(ithread, 2), trans_tag, sizes_tag, ithread);
+                        }
+                    }, deps);
+            });
+        }
 
-            // extract the compact values from the global u view 
-            extract_elspan(el.elidx, u, u_el);
+        // finish the inter-process communication while the tasks execute 
+        // (only this thread makes MPI calls)
+        halo.finish_exchange();
+        pool.wait_all();
+#else
+        // interior faces 
+        std::span<const Trace> interior_traces = fespace.get_interior_traces();
+        for(std::size_t i = 0; i < interior_traces.size(); ++i){
+            if(prefetch_distance > 0 && i + prefetch_distance < interior_traces.size())
+                { prefetch_trace(interior_traces[i + prefetch_distance]); }
+            interior_trace_residual(interior_traces[i], uL_data, uR_data, resL_data, resR_data);
+        }
 
-            // zero out the residual 
-            res_el = 0;
+        // domain integral batched by element type
+        for(IDX ibatch = 0; ibatch < fespace.element_batches.nrow(); ++ibatch){
+            fespace.dispatch_element_kernel(ibatch, [&](auto trans_tag, auto sizes_tag, std::span<const IDX> elidxs){
+                for(IDX iel : elidxs){
+                    domain_residual(fespace.elements[iel], uL_data, resL_data, trans_tag, sizes_tag, 0);
+                }
+            });
+        }
 
-            disc.domain_integral(el, u_el, res_el);
+        // finish the inter-process communication 
+        halo.finish_exchange();
+#endif
+        }
+        // includes the wait for the halo exchange
+        if(timed) cost.charge_phase(1, cost.elapsed(phase_start));
+        }
+
+        // parallel communication faces 
+#ifdef ICEICLE_USE_MPI
+        ICEICLE_PROFILE_REGION("parallel_traces");
+        add_phase_work(2);
+        if(timed) phase_start = cost.now();
+        for(std::size_t ipar = 0; ipar < workspace.parallel_com_traces.size(); ++ipar){
+            cost_time start{};
+            if(timed) start = cost.now();
+            const Trace& trace = fespace.traces[workspace.parallel_com_traces[ipar]];
+            bool imleft = workspace.parallel_com_imleft[ipar];
+            T* ughost_data = halo.ghost_element_data(workspace.parallel_com_ghosts[ipar]);
+
+            // the remote side reads from the ghost layer, the local side from u
+            compact_layout_right<IDX, disc_class::nv_comp> uL_layout{trace.elL};
+            dofspan uL{(imleft) ? uL_data : ughost_data, uL_layout};
+            compact_layout_right<IDX, disc_class::nv_comp> uR_layout{trace.elR};
+            dofspan uR{(imleft) ? ughost_data : uR_data, uR_layout};
+
+            compact_layout_right<IDX, disc_class::nv_comp> resL_layout{trace.elL};
+            dofspan resL{resL_data, resL_layout};
+            compact_layout_right<IDX, disc_class::nv_comp> resR_layout{trace.elR};
+            dofspan resR{resR_data, resR_layout};
+
+            const Element& el_local = (imleft) ? trace.elL : trace.elR;
+            auto& u_local = (imleft) ? uL : uR;
+            auto& res_local = (imleft) ? resL : resR;
+
+            // extract the compact values from the global u view
+            extract_elspan(el_local.elidx, u, u_local);
 
-            scatter_elspan(el.elidx, 1.0, res_el, 1.0, res);
+            // zero out residual 
+            res_local = 0;
+
+            disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, resL, resR);
+
+            // scatter only the side owned by this process
+            scatter_elspan(el_local.elidx, 1.0, res_local, 1.0, res);
+            if(timed) cost.charge(el_local.elidx, cost.elapsed(start));
         }
+        if(timed) cost.charge_phase(2, cost.elapsed(phase_start));
+#else 
+        if(workspace.parallel_com_traces.size() > 0)
+            util::AnomalyLog::log_anomaly(util::Anomaly{"Built without mpi, parallel communication boundary condition will not work", util::general_anomaly_tag{}});
+#endif
 
-        delete[] uL_data;
-        delete[] uR_data;
-        delete[] resL_data;
-        delete[] resR_data;
+        // finish the norms with the process boundary elements
+        // and reduce while the caller continues
+        if(monitor.enabled()){
+            for(IDX iel : workspace.parallel_com_elements)
+                { monitor.accumulate(0, iel, fespace.elements[iel].nbasis(), res); }
+            monitor.begin_reduction();
+        }
+        for(IDX iel : workspace.parallel_com_elements) element_done(iel, 0);
+
+        // recheck which elements can be skipped (if due)
+        workspace.activity.update(fespace, u, res);
+    }
+
+    /**
+     * @brief form the residual based on the fespace and discretization 
+     * (see the overload with the element_done callback)
+     *
+     * @param fespace the finite element space 
+     * @param disc the discretization
+     * @param u the solution 
+     * @param res the residual to fill
+     * @param workspace persistent scratch storage, halo exchange, and trace orderings
+     *        constructed from this fespace
+     */
+    template<
+        class T, 
+        class IDX,
+        int ndim,
+        class disc_class,
+        class uLayoutPolicy,
+        class uAccessorPolicy,
+        class resLayoutPolicy
+    >
+    void form_residual(
+        FESpace<T, IDX, ndim> &fespace,
+        disc_class &disc,
+        fespan<T, uLayoutPolicy, uAccessorPolicy> u,
+        fespan<T, resLayoutPolicy> res,
+        ResidualWorkspace<T, IDX>& workspace
+    )
+    requires specifies_ncomp<disc_class>
+    { form_residual(fespace, disc, u, res, workspace, [](IDX, int){}); }
+
+    /**
+     * @brief form the residual based on the fespace and discretization 
+     * constructs a workspace for this evaluation 
+     * (prefer the overload that takes a ResidualWorkspace for repeated evaluation)
+     *
+     * @param fespace the finite element space 
+     * @param disc the discretization
+     * @param u the solution 
+     * @param res the residual to fill
+     */
+    template<
+        class T, 
+        class IDX,
+        int ndim,
+        class disc_class,
+        class uLayoutPolicy,
+        class uAccessorPolicy,
+        class resLayoutPolicy
+    >
+    void form_residual(
+        FESpace<T, IDX, ndim> &fespace,
+        disc_class &disc,
+        fespan<T, uLayoutPolicy, uAccessorPolicy> u,
+        fespan<T, resLayoutPolicy> res
+    )
+    requires specifies_ncomp<disc_class>
+    {
+        // no shared memory window so the construction is not collective
+        ResidualWorkspace<T, IDX> workspace{fespace, disc_class::dnv_comp, false};
+        form_residual(fespace, disc, u, res, workspace);
     }
 
     template<
@@ -337,7 +813,8 @@ namespace iceicle::solvers {
         disc_class& disc,
         fespan<T, uLayoutPolicy, uAccessorPolicy> u,
         const geo_dof_map<T, IDX, ndim>& geo_map,
-        icespan auto mdg_residual
+        icespan auto mdg_residual,
+        const ResidualWorkspace<T, IDX>* ic_workspace = nullptr
     ) -> void {
         using Element = FiniteElement<T, IDX, ndim>;
         using Trace = TraceSpace<T, IDX, ndim>;
@@ -354,6 +831,9 @@ namespace iceicle::solvers {
         std::vector<T> uR_storage(max_local_size);
         std::vector<T> res_storage{};
 
+        // contributions to the selected nodes owned by other processes
+        std::vector<T> ghost_res(geo_map.nghost() * disc_class::nv_comp, 0.0);
+
         // loop over the boundary faces in the selection 
         for(index_type itrace : geo_map.selected_traces){
             Trace& trace = fespace.traces[itrace];
@@ -365,6 +845,17 @@ namespace iceicle::solvers {
             dofspan uR{uR_storage, uR_layout};
 
             trace_layout_right<IDX, disc_class::nv_comp> res_layout{trace};
+
+            // the interface conservation residual collected by form_residual
+            std::size_t ic_offset = (ic_workspace) ? ic_workspace->ic_res_offset(fespace, itrace)
+                : ResidualWorkspace<T, IDX>::no_ic_trace;
+            if(ic_offset != ResidualWorkspace<T, IDX>::no_ic_trace){
+                dofspan res{ic_workspace->ic_res_cache.data() + ic_offset, res_layout};
+                scatter_facspan(trace, 1.0, res, 1.0, mdg_residual);
+                scatter_facspan_ghosts(trace, 1.0, res, geo_map, std::span<T>{ghost_res});
+                continue;
+            }
+
             res_storage.resize(res_layout.size());
             dofspan res{res_storage, res_layout};
 
@@ -377,7 +868,53 @@ namespace iceicle::solvers {
             disc.interface_conservation(trace, fespace.meshptr->coord, uL, uR, res);
 
             scatter_facspan(trace, 1.0, res, 1.0, mdg_residual);
+            scatter_facspan_ghosts(trace, 1.0, res, geo_map, std::span<T>{ghost_res});
         }
+
+        // add the ghost node contributions to the owning processes
+        geo_map.reverse_exchange(std::span<const T>{ghost_res},
+                std::span<T>{mdg_residual.data(), mdg_residual.size()}, disc_class::nv_comp);
+    }
+
+    /**
+     * @brief form the residual and the interface conservation residual of the geometry selection
+     *
+     * Equivalent to form_residual then form_mdg_residual, but the selected interior traces
+     * form both residuals with one evaluation of the interface states and fluxes
+     * (see trace_interface_conservation)
+     *
+     * @param fespace the finite element space 
+     * @param disc the discretization
+     * @param u the solution 
+     * @param res the residual to fill
+     * @param geo_map the geometry selection
+     * @param mdg_residual the interface conservation residual to fill
+     * @param workspace persistent scratch storage constructed from this fespace
+     */
+    template<
+        class T,
+        class IDX,
+        int ndim,
+        class disc_class,
+        class uLayoutPolicy,
+        class uAccessorPolicy,
+        class resLayoutPolicy
+    >
+    auto form_dg_mdg_residual(
+        FESpace<T, IDX, ndim>& fespace,
+        disc_class& disc,
+        fespan<T, uLayoutPolicy, uAccessorPolicy> u,
+        fespan<T, resLayoutPolicy> res,
+        const geo_dof_map<T, IDX, ndim>& geo_map,
+        icespan auto mdg_residual,
+        ResidualWorkspace<T, IDX>& workspace
+    ) -> void {
+        workspace.set_interface_conservation_traces(fespace, std::span<const IDX>{geo_map.selected_traces},
+                disc_class::dnv_comp);
+        workspace.collect_interface_conservation = true;
+        form_residual(fespace, disc, u, res, workspace);
+        workspace.collect_interface_conservation = false;
+        form_mdg_residual(fespace, disc, u, geo_map, mdg_residual, &workspace);
     }
 
     /**
@@ -447,7 +984,8 @@ namespace iceicle::solvers {
         // apply the geometric parameterization to the mesh
         update_mesh(x, *(fespace.meshptr));
 
-        form_residual(fespace, disc, u_dg, res_dg);
-        form_mdg_residual(fespace, disc, u_dg, geo_map, res_mdg);
+        // no shared memory window so the construction is not collective
+        ResidualWorkspace<T, IDX> workspace{fespace, disc_class::dnv_comp, false};
+        form_dg_mdg_residual(fespace, disc, u_dg, res_dg, geo_map, res_mdg, workspace);
     }
 }
@@ -0,0 +1,378 @@
+/**
+ * @brief persistent non-blocking exchange of element data across MPI ranks
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/profiler.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#ifdef ICEICLE_USE_MPI
+#include "iceicle/mpi_type.hpp"
+#include <mpi.h>
+#endif
+
+namespace iceicle::solvers {
+
+#ifdef ICEICLE_USE_MPI
+    namespace impl {
+        /**
+         * @brief an MPI-3 shared memory window over the ranks of a node
+         * in a passive target epoch for its whole lifetime
+         * freeing is collective over the node so every rank must destroy its windows in the same order
+         */
+        struct node_shared_window {
+            /// @brief the node communicator (owned by mpi::get_node_topology())
+            MPI_Comm node_comm = MPI_COMM_NULL;
+            MPI_Win win = MPI_WIN_NULL;
+
+            /// @brief the start of the segment of this rank
+            void* base = nullptr;
+
+            node_shared_window() = default;
+            node_shared_window(const node_shared_window&) = delete;
+            node_shared_window& operator=(const node_shared_window&) = delete;
+
+            ~node_shared_window() {
+                int finalized;
+                MPI_Finalized(&finalized);
+                if(finalized) return;
+                if(win != MPI_WIN_NULL) {
+                    MPI_Win_unlock_all(win);
+                    MPI_Win_free(&win);
+                }
+            }
+        };
+    }
+#endif
+
+    /**
+     * @brief Exchanges the element-local solution data for elements on process boundaries
+     * Buffers are packed per neighbor rank and allocated once on construction
+     * so that the exchange can be reused across residual evaluations
+     *
+     * Usage:
+     * begin_exchange(u) packs and posts the non-blocking sends and recieves,
+     * work that does not need remote data can then be done,
+     * finish_exchange() waits for completion before ghost_element_data() is accessed
+     *
+     * The recieved elements form a compact ghost layer:
+     * each element on a neighboring rank that is recieved is given a ghost element index
+     * (contiguous for each neighbor in increasing rank) and its data is stored once
+     * no matter how many traces it is connected to
+     *
+     * Neighbors on the same node (MPI_COMM_TYPE_SHARED) do not send messages:
+     * each rank packs the data for its node neighbors into its segment of a node shared memory window
+     * and the neighbors read the ghost element data directly from that segment.
+     * The segment is double buffered (alternating each exchange) so one node barrier
+     * in finish_exchange() is the only synchronization:
+     * a rank writes a buffer again two exchanges later, after every node neighbor has passed
+     * the barrier of the exchange in between and so finished reading it.
+     * Only neighbors on other nodes use messages.
+     *
+     * The shared memory path is only taken for a distributed mesh (AbstractMesh::gel_idxs is set
+     * by the partitioning on every rank). Its construction is then collective over the ranks of each node
+     * (the window is allocated on the node communicator of mpi::get_node_topology())
+     * so every rank must construct the exchange, as for the exchanges themselves.
+     * Otherwise (or with shared_memory = false) the construction makes no MPI calls.
+     *
+     * Without MPI this is an empty exchange
+     *
+     * @tparam T the floating point type
+     * @tparam IDX the index type
+     */
+    template<class T, class IDX>
+    class HaloExchange {
+
+#ifdef ICEICLE_USE_MPI
+        /// @brief the neighbor ranks that elements are sent to
+        std::vector<int> send_ranks;
+
+        /// @brief the local element indices to send to each neighbor in send_ranks
+        std::vector<std::vector<IDX>> send_elements;
+
+        /// @brief the packed send buffer for each neighbor in send_ranks
+        std::vector<std::vector<T>> send_buffers;
+
+        /// @brief the neighbor ranks that elements are recieved from
+        std::vector<int> recv_ranks;
+
+        /// @brief the element indices (local to the neighbor rank) recieved from each neighbor in recv_ranks 
+        /// in sorted order
+        std::vector<std::vector<IDX>> recv_elements;
+
+        /// @brief the index into recv_ranks for each rank (-1 if not a neighbor)
+        std::vector<int> recv_neighbor;
+
+        /// @brief the index of the first ghost element for each neighbor in recv_ranks 
+        /// ghost elements of neighbor i are [ghost_start[i], ghost_start[i + 1])
+        std::vector<IDX> ghost_start;
+
+        /// @brief the offset of each ghost element into ghost_data (size = nghost + 1)
+        std::vector<std::size_t> ghost_offsets;
+
+        /// @brief the compact solution data of the ghost elements recieved by message (vector component fastest)
+        /// the data from each neighbor is contiguous so it is recieved in place
+        std::vector<T> ghost_data;
+
+        /// @brief outstanding requests for the sends and recieves
+        std::vector<MPI_Request> requests;
+
+        /// @brief the node shared memory window (null if no ranks on the node are neighbors)
+        /// copies share the window so only one copy should be used for exchanges
+        std::shared_ptr<impl::node_shared_window> shm{};
+
+        /// @brief for each neighbor in send_ranks the offset into each buffer of this rank's segment 
+        /// (std::size_t(-1) if the neighbor is on another node)
+        std::vector<std::size_t> send_shared_offsets;
+
+        /// @brief the size of each of the two buffers of this rank's segment
+        std::size_t shared_buffer_size = 0;
+
+        /// @brief for each neighbor in recv_ranks if the data is read from the shared window
+        std::vector<bool> recv_shared;
+
+        /// @brief for each buffer the location of each ghost element in the shared window 
+        /// (nullptr for ghost elements recieved by message)
+        std::array<std::vector<T*>, 2> shared_ghost_ptrs;
+
+        /// @brief the buffer written by the next begin_exchange() and the buffer to read from
+        int write_buffer = 0, read_buffer = 0;
+#endif
+
+        public:
+
+        /// @brief default constructor: an empty exchange
+        HaloExchange() = default;
+
+        /**
+         * @brief construct the exchange pattern and allocate buffers
+         * @param fespace the finite element space (which provides the mesh communication lists)
+         * @param nv the number of vector components per degree of freedom
+         * @param shared_memory exchange with neighbors on the same node through a shared memory window
+         * (collective over the ranks of the node when the mesh is distributed)
+         */
+        template<int ndim>
+        HaloExchange(FESpace<T, IDX, ndim>& fespace, std::size_t nv, bool shared_memory = true)
+        {
+#ifdef ICEICLE_USE_MPI
+            int nrank;
+            MPI_Comm_size(MPI_COMM_WORLD, &nrank);
+            auto& mesh = *(fespace.meshptr);
+
+            // only a distributed mesh has neighbors that every rank of the node constructs an exchange with
+            // (the node communicator is split once per process)
+            const mpi::node_topology* node = (shared_memory && nrank > 1 && !mesh.gel_idxs.empty())
+                ? &mpi::get_node_topology() : nullptr;
+            auto on_node = [&](int irank){ return node != nullptr && node->on_node(irank); };
+
+            recv_neighbor.assign(nrank, -1);
+            ghost_start.push_back(0);
+            ghost_offsets.push_back(0);
+            for(int irank = 0; irank < nrank; ++irank){
+                // send buffer sizing
+                if(mesh.el_send_list[irank].size() > 0){
+                    std::size_t size = 0;
+                    for(IDX ielem : mesh.el_send_list[irank])
+                        { size += fespace.elements[ielem].nbasis() * nv; }
+                    send_ranks.push_back(irank);
+                    send_elements.push_back(mesh.el_send_list[irank]);
+                    if(on_node(irank)) {
+                        send_shared_offsets.push_back(shared_buffer_size);
+                        shared_buffer_size += size;
+                        send_buffers.emplace_back();
+                    } else {
+                        send_shared_offsets.push_back(std::size_t(-1));
+                        send_buffers.emplace_back(size);
+                    }
+                }
+
+                // ghost element numbering and offsets
+                std::vector<IDX>& recv_list = mesh.el_recv_list[irank];
+                if(recv_list.size() > 0){
+                    recv_neighbor[irank] = recv_ranks.size();
+                    recv_ranks.push_back(irank);
+                    recv_elements.push_back(recv_list);
+                    recv_shared.push_back(on_node(irank));
+                    for(int irecv = 0; irecv < recv_list.size(); ++irecv){
+                        ghost_offsets.push_back(ghost_offsets.back() 
+                                + fespace.comm_elements[irank][irecv].nbasis() * nv);
+                    }
+                    ghost_start.push_back(ghost_offsets.size() - 1);
+                }
+            }
+
+            // the data from node neighbors is not stored in ghost_data
+            std::vector<std::size_t> ghost_sizes(nghost());
+            for(IDX ighost = 0; ighost < nghost(); ++ighost)
+                { ghost_sizes[ighost] = ghost_offsets[ighost + 1] - ghost_offsets[ighost]; }
+            for(std::size_t ineighbor = 0; ineighbor < recv_ranks.size(); ++ineighbor){
+                for(IDX ighost = ghost_start[ineighbor]; ighost < ghost_start[ineighbor + 1]; ++ighost){
+                    ghost_offsets[ighost + 1] = ghost_offsets[ighost] 
+                        + ((recv_shared[ineighbor]) ? 0 : ghost_sizes[ighost]);
+                }
+            }
+            ghost_data.resize(ghost_offsets.back());
+
+            std::size_t nmessage = 0;
+            for(std::size_t offset : send_shared_offsets) if(offset == std::size_t(-1)) ++nmessage;
+            for(bool shared : recv_shared) if(!shared) ++nmessage;
+            requests.resize(nmessage);
+
+            if(node != nullptr) setup_shared_window(*node, ghost_sizes);
+#endif
+        }
+
+        private:
+#ifdef ICEICLE_USE_MPI
+        /**
+         * @brief allocate the node shared window and locate the ghost elements of node neighbors in it 
+         * (collective over the node)
+         * @param node the node topology
+         * @param ghost_sizes the data size of each ghost element
+         */
+        auto setup_shared_window(const mpi::node_topology& node, const std::vector<std::size_t>& ghost_sizes) -> void {
+            // only use the window if any rank on the node has a node neighbor
+            int has_shared = (shared_buffer_size > 0) 
+                || std::ranges::any_of(recv_shared, [](bool b){ return b; });
+            MPI_Allreduce(MPI_IN_PLACE, &has_shared, 1, MPI_INT, MPI_MAX, node.comm);
+            if(!has_shared) return;
+            shm = std::make_shared<impl::node_shared_window>();
+            shm->node_comm = node.comm;
+            MPI_Win_allocate_shared((MPI_Aint) (2 * shared_buffer_size * sizeof(T)), sizeof(T), MPI_INFO_NULL,
+                    node.comm, &shm->base, &shm->win);
+            MPI_Win_lock_all(MPI_MODE_NOCHECK, shm->win);
+
+            // tell each node neighbor where its data is in this segment
+            std::vector<std::array<std::uint64_t, 2>> sent_info{}, recv_info(recv_ranks.size());
+            sent_info.reserve(send_ranks.size());
+            std::vector<MPI_Request> info_requests{};
+            for(std::size_t ineighbor = 0; ineighbor < recv_ranks.size(); ++ineighbor){
+                if(!recv_shared[ineighbor]) continue;
+                info_requests.emplace_back();
+                MPI_Irecv(recv_info[ineighbor].data(), 2, MPI_UINT64_T, recv_ranks[ineighbor], 1,
+                        MPI_COMM_WORLD, &info_requests.back());
+            }
+            for(std::size_t ineighbor = 0; ineighbor < send_ranks.size(); ++ineighbor){
+                if(send_shared_offsets[ineighbor] == std::size_t(-1)) continue;
+                sent_info.push_back({send_shared_offsets[ineighbor], shared_buffer_size});
+                info_requests.emplace_back();
+                MPI_Isend(sent_info.back().data(), 2, MPI_UINT64_T, send_ranks[ineighbor], 1,
+                        MPI_COMM_WORLD, &info_requests.back());
+            }
+            MPI_Waitall(info_requests.size(), info_requests.data(), MPI_STATUSES_IGNORE);
+
+            for(int ibuf = 0; ibuf < 2; ++ibuf) shared_ghost_ptrs[ibuf].assign(nghost(), nullptr);
+            for(std::size_t ineighbor = 0; ineighbor < recv_ranks.size(); ++ineighbor){
+                if(!recv_shared[ineighbor]) continue;
+                MPI_Aint segment_size;
+                int disp_unit;
+                T* segment;
+                MPI_Win_shared_query(shm->win, node.node_rank[recv_ranks[ineighbor]], &segment_size, &disp_unit, &segment);
+                auto [offset, buffer_size] = recv_info[ineighbor];
+                for(int ibuf = 0; ibuf < 2; ++ibuf){
+                    T* ptr = segment + ibuf * buffer_size + offset;
+                    for(IDX ighost = ghost_start[ineighbor]; ighost < ghost_start[ineighbor + 1]; ++ighost){
+                        shared_ghost_ptrs[ibuf][ighost] = ptr;
+                        ptr += ghost_sizes[ighost];
+                    }
+                }
+            }
+        }
+#endif
+        public:
+
+        /**
+         * @brief pack the element data to send and post the non-blocking communication
+         * @param u the global solution to get the element data from
+         */
+        template<class LayoutPolicy, class AccessorPolicy>
+        auto begin_exchange(fespan<T, LayoutPolicy, AccessorPolicy> u) -> void {
+#ifdef ICEICLE_USE_MPI
+            ICEICLE_PROFILE_REGION("halo_begin");
+            int ireq = 0;
+
+            // post the recieves first
+            for(int ineighbor = 0; ineighbor < recv_ranks.size(); ++ineighbor){
+                if(recv_shared[ineighbor]) continue;
+                std::size_t begin = ghost_offsets[ghost_start[ineighbor]];
+                std::size_t end = ghost_offsets[ghost_start[ineighbor + 1]];
+                MPI_Irecv(ghost_data.data() + begin, end - begin, mpi_get_type<T>(),
+                        recv_ranks[ineighbor], 0, MPI_COMM_WORLD, &requests[ireq++]);
+            }
+
+            for(int ineighbor = 0; ineighbor < send_ranks.size(); ++ineighbor){
+                // node neighbors read straight from this rank's segment of the shared window
+                bool shared = send_shared_offsets[ineighbor] != std::size_t(-1);
+                T* buffer = (shared) 
+                    ? static_cast<T*>(shm->base) + write_buffer * shared_buffer_size + send_shared_offsets[ineighbor]
+                    : send_buffers[ineighbor].data();
+                std::size_t offset = 0;
+                for(IDX ielem : send_elements[ineighbor]){
+                    dofspan uel{buffer + offset, u.create_element_layout(ielem)};
+                    extract_elspan(ielem, u, uel);
+                    offset += uel.size();
+                }
+                if(!shared) {
+                    MPI_Isend(buffer, offset, mpi_get_type<T>(),
+                            send_ranks[ineighbor], 0, MPI_COMM_WORLD, &requests[ireq++]);
+                }
+            }
+#endif
+        }
+
+        /// @brief wait for all the communication posted in begin_exchange() to complete
+        auto finish_exchange() -> void {
+#ifdef ICEICLE_USE_MPI
+            ICEICLE_PROFILE_REGION("halo_wait");
+            MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+            if(shm) {
+                // make the writes to the window visible to the node neighbors
+                MPI_Win_sync(shm->win);
+                MPI_Barrier(shm->node_comm);
+                MPI_Win_sync(shm->win);
+                read_buffer = write_buffer;
+                write_buffer = 1 - write_buffer;
+            }
+#endif
+        }
+
+#ifdef ICEICLE_USE_MPI
+        /// @brief the number of ghost elements (elements on other ranks that have data recieved)
+        [[nodiscard]] auto nghost() const noexcept -> IDX { return ghost_offsets.size() - 1; }
+
+        /**
+         * @brief get the ghost element index of an element on another rank
+         * (this is a search so should be precomputed outside of hot loops)
+         * @param jrank the rank that owns the element
+         * @param ielem the element index local to jrank
+         * @return the ghost element index
+         */
+        [[nodiscard]] auto ghost_index(int jrank, IDX ielem) const -> IDX {
+            int ineighbor = recv_neighbor[jrank];
+            const std::vector<IDX>& recv_list = recv_elements[ineighbor];
+            return ghost_start[ineighbor] + std::distance(recv_list.begin(),
+                    std::lower_bound(recv_list.begin(), recv_list.end(), ielem));
+        }
+
+        /**
+         * @brief get the recieved compact element data (vector component fastest)
+         * only valid after finish_exchange()
+         * @param ighost the ghost element index (see ghost_index())
+         * @return pointer to the start of the element data
+         */
+        auto ghost_element_data(IDX ighost) -> T* {
+            if(shm && shared_ghost_ptrs[read_buffer][ighost] != nullptr)
+                return shared_ghost_ptrs[read_buffer][ighost];
+            return ghost_data.data() + ghost_offsets[ighost];
+        }
+#endif
+    };
+}
@@ -0,0 +1,433 @@
+/**
+ * @brief static condensation solver for HDG discretizations (see hdg_diffusion.hpp)
+ *
+ * Each element only couples to the trace unknowns on its own faces:
+ *   [ A   B ] [ u      ]   [ F ]
+ *   [ B^T C ] [ lambda ] = [ 0 ]
+ * so u = A^{-1} (F - B lambda) is eliminated element by element
+ * and the globally coupled system S lambda = g, S = sum_K C - B^T A^{-1} B,
+ * only has the trace unknowns.
+ *
+ * The element blocks A are grouped by size and inverted with the batched dense kernels,
+ * the local Schur complements and the recovery of u are parallel over elements
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/crs.hpp"
+#include "iceicle/disc/hdg_diffusion.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/geometry/face.hpp"
+#include "iceicle/linalg/small_dense.hpp"
+#include "iceicle/profiler.hpp"
+#include "iceicle/thread_utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace iceicle::solvers {
+
+    /**
+     * @brief solve an HDG discretization by static condensation onto the trace unknowns
+     *
+     * The trace unknowns of trace itrace are lambda[trace_offsets[itrace] + it] for it < trace_bases[itrace].nbasis.
+     * Dirichlet traces are set from the boundary condition and do not appear in the global system;
+     * faces with other boundary conditions are treated as homogeneous NEUMANN faces
+     *
+     * @tparam T the real number type
+     * @tparam IDX the index type
+     * @tparam ndim the number of dimensions
+     * @tparam disc_type the discretization (i.e HDGDiffusion)
+     */
+    template<class T, class IDX, int ndim, class disc_type>
+    class HDGSolver {
+        public:
+
+        /// @brief the finite element space
+        FESpace<T, IDX, ndim>& fespace;
+
+        /// @brief the discretization
+        disc_type& disc;
+
+        /// @brief relative residual tolerance of the global conjugate gradient solve
+        T rtol = 1e-12;
+
+        /// @brief the maximum number of global conjugate gradient iterations
+        IDX max_it = 5000;
+
+        /// @brief the number of conjugate gradient iterations of the last solve()
+        IDX last_nit = 0;
+
+        /// @brief the HDG basis of each trace
+        std::vector<HDGTraceBasis<T, ndim>> trace_bases{};
+
+        /// @brief the index of the first unknown of each trace in lambda (size = ntrace + 1)
+        std::vector<IDX> trace_offsets{};
+
+        /// @brief the trace unknowns (set by solve())
+        std::vector<T> lambda{};
+
+        private:
+
+        /// @brief the traces on the faces of each element
+        util::crs<IDX, IDX> el_traces{};
+
+        /// @brief 1 if the element is the right element of the corresponding entry of el_traces
+        util::crs<IDX, IDX> el_sides{};
+
+        /// @brief the row of each trace unknown in the global system (-1 for dirichlet unknowns)
+        std::vector<IDX> sys_index{};
+
+        /// @brief the column indices of the global system (sorted in each row)
+        util::crs<IDX, IDX> columns{};
+
+        /// @brief the entries of the global system
+        util::crs<T, IDX> entries{};
+
+        /// @brief the elements ordered by number of basis functions (so blocks of a size are contiguous)
+        std::vector<IDX> el_order{};
+
+        /// @brief the start of the storage of each element in the A^{-1}, A^{-1} B and A^{-1} F arrays
+        std::vector<std::size_t> ainv_offsets{}, ainvb_offsets{}, ainvf_offsets{};
+
+        /// @brief the element local factors
+        std::vector<T> ainv{}, ainvb{}, ainvf{};
+
+        /// @brief the number of hybrid unknowns on the faces of an element
+        auto nlambda_el(IDX iel) const -> IDX {
+            IDX n = 0;
+            for(IDX itrace : el_traces.rowspan(iel)) n += trace_bases[itrace].nbasis;
+            return n;
+        }
+
+        public:
+
+        /**
+         * @brief set up the trace bases and the structure of the global system
+         * @param fespace the finite element space (L2)
+         * @param disc the HDG discretization
+         */
+        HDGSolver(FESpace<T, IDX, ndim>& fespace, disc_type& disc)
+        : fespace{fespace}, disc{disc} {
+            NodeArray<T, ndim>& coord = fespace.meshptr->coord;
+            const IDX ntrace = fespace.traces.size();
+            const IDX nelem = fespace.elements.size();
+
+            std::vector<std::vector<IDX>> el_traces_ragged(nelem), el_sides_ragged(nelem);
+            trace_bases.reserve(ntrace);
+            trace_offsets.assign(1, 0);
+            bool unsupported_bc = false;
+            for(IDX itrace = 0; itrace < ntrace; ++itrace){
+                const TraceSpace<T, IDX, ndim>& trace = fespace.traces[itrace];
+                trace_bases.emplace_back(trace, coord);
+                trace_offsets.push_back(trace_offsets.back() + trace_bases.back().nbasis);
+                el_traces_ragged[trace.elL.elidx].push_back(itrace);
+                el_sides_ragged[trace.elL.elidx].push_back(0);
+                switch(trace.face->bctype){
+                    case BOUNDARY_CONDITIONS::INTERIOR:
+                        el_traces_ragged[trace.elR.elidx].push_back(itrace);
+                        el_sides_ragged[trace.elR.elidx].push_back(1);
+                        break;
+                    case BOUNDARY_CONDITIONS::DIRICHLET:
+                    case BOUNDARY_CONDITIONS::NEUMANN:
+                        break;
+                    default:
+                        unsupported_bc = true;
+                }
+            }
+            if(unsupported_bc){
+                util::AnomalyLog::log_anomaly(util::Anomaly{
+                    "HDGSolver only supports DIRICHLET and NEUMANN boundaries, others are treated as zero flux",
+                    util::general_anomaly_tag{}});
+            }
+            el_traces = util::crs<IDX, IDX>{el_traces_ragged};
+            el_sides = util::crs<IDX, IDX>{el_sides_ragged};
+
+            // number the unknowns of the global system
+            sys_index.assign(trace_offsets.back(), -1);
+            IDX nsys = 0;
+            for(IDX itrace = 0; itrace < ntrace; ++itrace){
+                if(fespace.traces[itrace].face->bctype == BOUNDARY_CONDITIONS::DIRICHLET) continue;
+                for(IDX idof = trace_offsets[itrace]; idof < trace_offsets[itrace + 1]; ++idof) sys_index[idof] = nsys++;
+            }
+
+            // the unknowns of a row couple to all the unknowns on the faces of the neighboring elements
+            std::vector<std::vector<IDX>> graph(nsys);
+            for(IDX iel = 0; iel < nelem; ++iel){
+                for(IDX itrace : el_traces.rowspan(iel)){
+                    for(IDX idof = trace_offsets[itrace]; idof < trace_offsets[itrace + 1]; ++idof){
+                        if(sys_index[idof] < 0) continue;
+                        for(IDX jtrace : el_traces.rowspan(iel)){
+                            for(IDX jdof = trace_offsets[jtrace]; jdof < trace_offsets[jtrace + 1]; ++jdof){
+                                if(sys_index[jdof] >= 0) graph[sys_index[idof]].push_back(sys_index[jdof]);
+                            }
+                        }
+                    }
+                }
+            }
+            for(std::vector<IDX>& row : graph){
+                std::ranges::sort(row);
+                auto unique_subrange = std::ranges::unique(row);
+                row.erase(unique_subrange.begin(), unique_subrange.end());
+            }
+            columns = util::crs<IDX, IDX>{graph};
+            entries = util::convert_crs<T, IDX>(columns);
+
+            // element storage ordered by block size for the batched inversion
+            el_order.resize(nelem);
+            for(IDX iel = 0; iel < nelem; ++iel) el_order[iel] = iel;
+            std::ranges::stable_sort(el_order, {}, [&](IDX iel){ return fespace.elements[iel].nbasis(); });
+            ainv_offsets.resize(nelem);
+            ainvb_offsets.resize(nelem);
+            ainvf_offsets.resize(nelem);
+            std::size_t ainv_size = 0, ainvb_size = 0, ainvf_size = 0;
+            for(IDX iel : el_order){
+                std::size_t nbasis = fespace.elements[iel].nbasis();
+                ainv_offsets[iel] = ainv_size;
+                ainvb_offsets[iel] = ainvb_size;
+                ainvf_offsets[iel] = ainvf_size;
+                ainv_size += nbasis * nbasis;
+                ainvb_size += nbasis * nlambda_el(iel);
+                ainvf_size += nbasis;
+            }
+            ainv.resize(ainv_size);
+            ainvb.resize(ainvb_size);
+            ainvf.resize(ainvf_size);
+        }
+
+        /// @brief the number of unknowns in the globally coupled system
+        [[nodiscard]] auto nsystem() const noexcept -> IDX { return columns.nrow(); }
+
+        /**
+         * @brief solve the discretization
+         * @param [out] u the element unknowns (the trace unknowns are in lambda)
+         * @return true if the global solve converged and every element block was invertible
+         */
+        template<class LayoutPolicy, class AccessorPolicy>
+        auto solve(fespan<T, LayoutPolicy, AccessorPolicy> u) -> bool {
+            ICEICLE_PROFILE_REGION("hdg_solve");
+            const IDX nelem = fespace.elements.size();
+            const IDX ntrace = fespace.traces.size();
+            bool success = true;
+
+            // dirichlet trace values and neumann fluxes
+            lambda.assign(trace_offsets.back(), 0.0);
+            std::vector<T> rhs(nsystem(), 0.0);
+            std::vector<T> trace_rhs{};
+            for(IDX itrace = 0; itrace < ntrace; ++itrace){
+                const TraceSpace<T, IDX, ndim>& trace = fespace.traces[itrace];
+                const HDGTraceBasis<T, ndim>& tbasis = trace_bases[itrace];
+                if(trace.face->bctype == BOUNDARY_CONDITIONS::DIRICHLET){
+                    disc.dirichlet_values(trace, tbasis, lambda.data() + trace_offsets[itrace]);
+                } else if(trace.face->bctype == BOUNDARY_CONDITIONS::NEUMANN){
+                    trace_rhs.assign(tbasis.nbasis, 0.0);
+                    disc.neumann_rhs(trace, tbasis, trace_rhs.data());
+                    for(int it = 0; it < tbasis.nbasis; ++it)
+                        { rhs[sys_index[trace_offsets[itrace] + it]] += trace_rhs[it]; }
+                }
+            }
+
+            // the stabilization of each element from the measure of its boundary
+            std::vector<T> tau(nelem);
+            util::parallel_for(nelem, [&](IDX iel){
+                T bdy_measure = 0;
+                for(IDX itrace : el_traces.rowspan(iel)) bdy_measure += trace_bases[itrace].measure();
+                tau[iel] = disc.stabilization(fespace.elements[iel], bdy_measure);
+            });
+
+            // element matrices: A into ainv, B into ainvb, F into ainvf, C into local storage
+            std::vector<std::size_t> c_offsets(nelem + 1, 0);
+            for(IDX iel = 0; iel < nelem; ++iel)
+                { c_offsets[iel + 1] = c_offsets[iel] + nlambda_el(iel) * nlambda_el(iel); }
+            std::vector<T> cmat(c_offsets.back(), 0.0);
+            std::ranges::fill(ainv, 0.0);
+            std::ranges::fill(ainvb, 0.0);
+            std::ranges::fill(ainvf, 0.0);
+            util::parallel_for(nelem, [&](IDX iel){
+                T* A = ainv.data() + ainv_offsets[iel];
+                T* B = ainvb.data() + ainvb_offsets[iel];
+                T* C = cmat.data() + c_offsets[iel];
+                const int nlam = nlambda_el(iel);
+                disc.domain_operator(fespace.elements[iel], A, ainvf.data() + ainvf_offsets[iel]);
+                int offset = 0;
+                for(std::size_t ilocal = 0; ilocal < el_traces.rowsize(iel); ++ilocal){
+                    IDX itrace = el_traces[iel, ilocal];
+                    disc.trace_operator(fespace.traces[itrace], el_sides[iel, ilocal] == 1,
+                        trace_bases[itrace], tau[iel], A, B, nlam, C, nlam, offset);
+                    offset += trace_bases[itrace].nbasis;
+                }
+            });
+
+            // batched inversion of the element blocks of each size
+            std::atomic<bool> blocks_spd = true;
+            for(std::size_t istart = 0; istart < el_order.size();){
+                const std::size_t nbasis = fespace.elements[el_order[istart]].nbasis();
+                std::size_t iend = istart;
+                while(iend < el_order.size() && fespace.elements[el_order[iend]].nbasis() == nbasis) ++iend;
+                T* blocks = ainv.data() + ainv_offsets[el_order[istart]];
+                linalg::dispatch_basis_size(nbasis, [&](auto N){
+                    linalg::batched_cholesky_invert<decltype(N)::value>(iend - istart, blocks,
+                        [&](std::size_t){ blocks_spd = false; }, nbasis);
+                });
+                istart = iend;
+            }
+            if(!blocks_spd){
+                util::AnomalyLog::log_anomaly(util::Anomaly{
+                    "HDG element block is not positive definite (increase the penalty)", util::general_anomaly_tag{}});
+                return false;
+            }
+
+            // A^{-1} B, A^{-1} F and the local schur complement C - B^T A^{-1} B, -B^T A^{-1} F (into cmat and bf)
+            std::vector<std::size_t> bf_offsets(nelem + 1, 0);
+            for(IDX iel = 0; iel < nelem; ++iel) bf_offsets[iel + 1] = bf_offsets[iel] + nlambda_el(iel);
+            std::vector<T> bf(bf_offsets.back(), 0.0);
+            util::parallel_for(nelem, [&](IDX iel){
+                const std::size_t nbasis = fespace.elements[iel].nbasis();
+                const std::size_t nlam = nlambda_el(iel);
+                const T* Ainv = ainv.data() + ainv_offsets[iel];
+                T* B = ainvb.data() + ainvb_offsets[iel];
+                T* C = cmat.data() + c_offsets[iel];
+                T* F = ainvf.data() + ainvf_offsets[iel];
+                std::vector<T> Bcopy(B, B + nbasis * nlam);
+                std::vector<T> Fcopy(F, F + nbasis);
+                for(std::size_t i = 0; i < nbasis; ++i){
+                    for(std::size_t j = 0; j < nlam; ++j){
+                        T sum = 0;
+                        for(std::size_t k = 0; k < nbasis; ++k) sum += Ainv[i * nbasis + k] * Bcopy[k * nlam + j];
+                        B[i * nlam + j] = sum;
+                    }
+                    T sum = 0;
+                    for(std::size_t k = 0; k < nbasis; ++k) sum += Ainv[i * nbasis + k] * Fcopy[k];
+                    F[i] = sum;
+                }
+                for(std::size_t a = 0; a < nlam; ++a){
+                    for(std::size_t b = 0; b < nlam; ++b){
+                        T sum = 0;
+                        for(std::size_t k = 0; k < nbasis; ++k) sum += Bcopy[k * nlam + a] * B[k * nlam + b];
+                        C[a * nlam + b] -= sum;
+                    }
+                    T sum = 0;
+                    for(std::size_t k = 0; k < nbasis; ++k) sum += Bcopy[k * nlam + a] * F[k];
+                    bf[bf_offsets[iel] + a] = -sum;
+                }
+            });
+
+            // scatter to the global system (dirichlet columns go to the right hand side)
+            std::fill_n(entries.data(), entries.nnz(), 0.0);
+            std::vector<IDX> el_dofs{};
+            for(IDX iel = 0; iel < nelem; ++iel){
+                el_dofs.clear();
+                for(IDX itrace : el_traces.rowspan(iel)){
+                    for(IDX idof = trace_offsets[itrace]; idof < trace_offsets[itrace + 1]; ++idof)
+                        el_dofs.push_back(idof);
+                }
+                const std::size_t nlam = el_dofs.size();
+                const T* C = cmat.data() + c_offsets[iel];
+                for(std::size_t a = 0; a < nlam; ++a){
+                    IDX irow = sys_index[el_dofs[a]];
+                    if(irow < 0) continue;
+                    rhs[irow] += bf[bf_offsets[iel] + a];
+                    std::span<IDX> cols = columns.rowspan(irow);
+                    std::span<T> vals = entries.rowspan(irow);
+                    for(std::size_t b = 0; b < nlam; ++b){
+                        IDX jcol = sys_index[el_dofs[b]];
+                        if(jcol < 0){
+                            rhs[irow] -= C[a * nlam + b] * lambda[el_dofs[b]];
+                        } else {
+                            auto it = std::ranges::lower_bound(cols, jcol);
+                            vals[it - cols.begin()] += C[a * nlam + b];
+                        }
+                    }
+                }
+            }
+
+            // global solve
+            std::vector<T> x(nsystem(), 0.0);
+            if(!conjugate_gradient(rhs, x)){
+                util::AnomalyLog::log_anomaly(util::Anomaly{
+                    "HDG trace system did not converge in " + std::to_string(max_it) + " iterations",
+                    util::general_anomaly_tag{}});
+                success = false;
+            }
+            for(std::size_t idof = 0; idof < sys_index.size(); ++idof)
+                { if(sys_index[idof] >= 0) lambda[idof] = x[sys_index[idof]]; }
+
+            // recover the element unknowns u = A^{-1} F - A^{-1} B lambda
+            util::parallel_for(nelem, [&](IDX iel){
+                const std::size_t nbasis = fespace.elements[iel].nbasis();
+                const std::size_t nlam = nlambda_el(iel);
+                const T* AinvB = ainvb.data() + ainvb_offsets[iel];
+                const T* AinvF = ainvf.data() + ainvf_offsets[iel];
+                for(std::size_t i = 0; i < nbasis; ++i){
+                    T ui = AinvF[i];
+                    std::size_t j = 0;
+                    for(IDX itrace : el_traces.rowspan(iel)){
+                        for(IDX idof = trace_offsets[itrace]; idof < trace_offsets[itrace + 1]; ++idof, ++j)
+                            { ui -= AinvB[i * nlam + j] * lambda[idof]; }
+                    }
+                    u[iel, i, 0] = ui;
+                }
+            });
+            return success;
+        }
+
+        private:
+
+        /// @brief y = S x for the global system
+        auto multiply(const std::vector<T>& x, std::vector<T>& y) const -> void {
+            util::parallel_for(nsystem(), [&](IDX irow){
+                std::span<const IDX> cols = columns.rowspan(irow);
+                std::span<const T> vals = entries.rowspan(irow);
+                T sum = 0;
+                for(std::size_t k = 0; k < cols.size(); ++k) sum += vals[k] * x[cols[k]];
+                y[irow] = sum;
+            });
+        }
+
+        /// @brief Jacobi preconditioned conjugate gradient on the (symmetric positive definite) global system
+        auto conjugate_gradient(const std::vector<T>& b, std::vector<T>& x) -> bool {
+            const IDX n = nsystem();
+            std::vector<T> diag(n), r(n), z(n), p(n), q(n);
+            for(IDX irow = 0; irow < n; ++irow){
+                std::span<const IDX> cols = columns.rowspan(irow);
+                auto it = std::ranges::lower_bound(cols, irow);
+                diag[irow] = entries.rowspan(irow)[it - cols.begin()];
+            }
+            T bnorm = 0, rz = 0;
+            for(IDX i = 0; i < n; ++i){
+                bnorm += b[i] * b[i];
+                r[i] = b[i];
+                z[i] = r[i] / diag[i];
+                p[i] = z[i];
+                rz += r[i] * z[i];
+            }
+            bnorm = std::sqrt(bnorm);
+            for(last_nit = 0; last_nit < max_it; ++last_nit){
+                T rnorm = 0;
+                for(IDX i = 0; i < n; ++i) rnorm += r[i] * r[i];
+                if(std::sqrt(rnorm) <= rtol * bnorm) return true;
+                multiply(p, q);
+                T pq = 0;
+                for(IDX i = 0; i < n; ++i) pq += p[i] * q[i];
+                T alpha = rz / pq;
+                T rz_new = 0;
+                for(IDX i = 0; i < n; ++i){
+                    x[i] += alpha * p[i];
+                    r[i] -= alpha * q[i];
+                    z[i] = r[i] / diag[i];
+                    rz_new += r[i] * z[i];
+                }
+                for(IDX i = 0; i < n; ++i) p[i] = z[i] + (rz_new / rz) * p[i];
+                rz = rz_new;
+            }
+            T rnorm = 0;
+            for(IDX i = 0; i < n; ++i) rnorm += r[i] * r[i];
+            return std::sqrt(rnorm) <= rtol * bnorm;
+        }
+    };
+}
@@ -5,7 +5,9 @@
 
 #pragma once
 #include "iceicle/fe_function/layout_enums.hpp"
+#include "iceicle/fe_function/restart.hpp"
 #include "iceicle/pvd_writer.hpp"
+#include "iceicle/lua_utils.hpp"
 #include "iceicle/string_utils.hpp"
 #include "iceicle/tmp_utils.hpp"
 #include <iceicle/fespace/fespace.hpp>
@@ -16,15 +18,32 @@
 
 namespace iceicle {
 
-    /// @brief initialize 
+    /// @brief initialize u to the L2 projection of func 
+    /// (thread parallel over the elements, see LinearFormSolver)
+    /// @param thread_safe func can be called concurrently (false for lua functions)
     template<class T, class IDX, int ndim, int neq, class LayoutPolicy, class AccessorPolicy>
     auto projection_initialization(
         FESpace<T, IDX, ndim>& fespace,
         ProjectionFunction<T, ndim, neq> func,
         tmp::compile_int<neq> neq_tag,
-        fespan<T, LayoutPolicy, AccessorPolicy> u
+        fespan<T, LayoutPolicy, AccessorPolicy> u,
+        bool thread_safe = true
     ) -> void {
         Projection<T, IDX, ndim, neq> projection{func};
+        projection.thread_safe = thread_safe;
+        solvers::LinearFormSolver projection_solver(fespace, projection);
+        projection_solver.solve(u);
+    }
+
+    /// @brief initialize u to the L2 projection of a function evaluated at batches of points
+    template<class T, class IDX, int ndim, int neq, class LayoutPolicy, class AccessorPolicy>
+    auto projection_initialization(
+        FESpace<T, IDX, ndim>& fespace,
+        ProjectionBatchFunction<T> batch_func,
+        tmp::compile_int<neq> neq_tag,
+        fespan<T, LayoutPolicy, AccessorPolicy> u
+    ) -> void {
+        Projection<T, IDX, ndim, neq> projection{batch_func};
         solvers::LinearFormSolver projection_solver(fespace, projection);
         projection_solver.solve(u);
     }
@@ -46,7 +65,10 @@ namespace iceicle {
         // check if restart file is specified 
         sol::optional<std::string> restart_name = config_table["restart"];
         if(restart_name){
-            read_restart(fespace, u, restart_name.value());
+            if(restart_name.value().ends_with(".bin"))
+                read_restart_binary(fespace, u, restart_name.value());
+            else
+                read_restart(fespace, u, restart_name.value());
         } else {
             // the initial condition function (default to zero)
             std::function<void(const T*, T*)> ic_func = [](const T* xin, T* out){
@@ -55,19 +77,31 @@ namespace iceicle {
                 }
             };
 
+            // expressions are evaluated for batches of points
+            ProjectionBatchFunction<T> ic_batch_func{};
+
+            // lua functions can not be called concurrently
+            bool thread_safe = true;
+
             // check if IC specified by name
             sol::optional<std::string> ic_as_name = config_table["initial_condition"];
             if(ic_as_name){
                 std::string ic_name = ic_as_name.value();
                 if(util::eq_icase(ic_name, "zero")){
                     // already defaulted to this case
+                } else if(auto expr_func = util::lua_get_expression_batch_function<T>(config_table["initial_condition"], neq, ndim)){
+                    ic_batch_func = expr_func.value();
                 }
+            } else if(auto expr_func = util::lua_get_expression_batch_function<T>(config_table["initial_condition"], neq, ndim)){
+                // a table of expressions for each equation
+                ic_batch_func = expr_func.value();
             }
 
             // check if IC is a function
             if constexpr (neq == 1) {
                 sol::optional<sol::function> ic_as_function = config_table["initial_condition"];
                 if(ic_as_function){
+                    thread_safe = false;
                     sol::function ic_f = ic_as_function.value();
                     ic_func = [ic_f](const T* xin, T* xout){
                         std::integer_sequence seq = std::make_integer_sequence<int, ndim>{};
@@ -81,6 +115,7 @@ namespace iceicle {
             } else {
                 sol::optional<sol::function> ic_as_function = config_table["initial_condition"];
                 if(ic_as_function){
+                    thread_safe = false;
                     sol::function ic_f = ic_as_function.value();
                     ic_func = [ic_f](const T* xin, T* xout){
                         std::integer_sequence seq = std::make_integer_sequence<int, ndim>{};
@@ -99,7 +134,10 @@ namespace iceicle {
 
             }
 
-            projection_initialization(fespace, ic_func, tmp::compile_int<neq>{}, u);
+            if(ic_batch_func)
+                projection_initialization(fespace, ic_batch_func, tmp::compile_int<neq>{}, u);
+            else
+                projection_initialization(fespace, ic_func, tmp::compile_int<neq>{}, u, thread_safe);
         }
     }
 }
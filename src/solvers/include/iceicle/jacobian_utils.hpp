@@ -4,7 +4,10 @@
 #include "iceicle/mesh/mesh.hpp"
 #include "iceicle/fe_function/fespan.hpp"
 #include "iceicle/fd_utils.hpp"
+#include "iceicle/dual_number.hpp"
+#include <algorithm>
 #include <ranges>
+#include <vector>
 
 #ifdef ICEICLE_USE_PETSC 
 #include "petscmat.h"
@@ -181,6 +184,98 @@ namespace iceicle {
 
 
         }
+
+        // @brief compute the residual and sensitivities for computations over a trace space with a single output span
+        // with forward mode automatic differentiation instead of finite differences
+        //
+        // res_op must be callable with dofspans of util::Dual<T, nlane> over the same layouts as uL, uR, and res
+        // (i.e a residual templated on the value type of the spans)
+        // The columns of the jacobians are seeded nlane at a time
+        // so the residual is evaluated ceil(ncol / nlane) times instead of ncol + 1 times
+        // and the sensitivities are exact
+        //
+        // @tparam nlane the number of derivative lanes (columns per residual evaluation)
+        // @param res_op the operation the compute the residual
+        // @param trace the trace space to calculate over
+        // @param mesh the mesh
+        // @param uL the data for the element on the canonical "left" side of the trace
+        // @param uR the data for the element on the canonical "right" side of the trace
+        // @param res the output span for the residual
+        // @param jac_wrt_uL the sensitivities of res wrt uL
+        // @param jac_wrt_uR the sensitivities of res wrt uR
+        // @param jac_wrt_x the sensitivities of x wrt mesh coordinates (not computed, as with eval_res_and_jac)
+        template<int nlane = 8, class Operator, class uL_span_t, class uR_span_t, class res_span_t>
+        auto eval_res_and_jac_dual(
+            Operator&& res_op,
+            const Trace_t& trace,
+            AbstractMesh<T, IDX, ndim>& mesh,
+            uL_span_t uL,
+            uR_span_t uR,
+            res_span_t res,
+            linalg::out_matrix auto jac_wrt_uL,
+            linalg::out_matrix auto jac_wrt_uR,
+            linalg::out_matrix auto jac_wrt_x
+        ) -> void
+        requires(elspan<uL_span_t> && elspan<uR_span_t>)
+        {
+            using Dual = util::Dual<T, nlane>;
+            using uL_idx_t = uL_span_t::index_type;
+            using uR_idx_t = uR_span_t::index_type;
+            using res_idx_t = res_span_t::index_type;
+
+            // zero out the residual and jacobians
+            res = 0;
+            linalg::fill(jac_wrt_uL, 0.0);
+            linalg::fill(jac_wrt_uR, 0.0);
+            linalg::fill(jac_wrt_x, 0.0);
+
+            // dual number copies of the data
+            std::vector<Dual> uL_dual_data(uL.size()), uR_dual_data(uR.size()), res_dual_data(res.size());
+            dofspan uL_dual{uL_dual_data, uL.get_layout()};
+            dofspan uR_dual{uR_dual_data, uR.get_layout()};
+            dofspan res_dual{res_dual_data, res.get_layout()};
+            for(uL_idx_t idof = 0; idof < uL.ndof(); ++idof)
+                for(uL_idx_t iv = 0; iv < uL.nv(); ++iv) uL_dual[idof, iv] = Dual{uL[idof, iv]};
+            for(uR_idx_t idof = 0; idof < uR.ndof(); ++idof)
+                for(uR_idx_t iv = 0; iv < uR.nv(); ++iv) uR_dual[idof, iv] = Dual{uR[idof, iv]};
+
+            // seed the columns [jbegin, jbegin + nlane) of u_dual, evaluate, and fill those columns of jac
+            auto sweep = [&](auto u, auto u_dual, auto jac) {
+                using idx_t = decltype(u)::index_type;
+                const idx_t ncol = u.size();
+                for(idx_t jbegin = 0; jbegin < ncol; jbegin += nlane) {
+                    for(idx_t idof = 0; idof < u.ndof(); ++idof) {
+                        for(idx_t iv = 0; iv < u.nv(); ++iv) {
+                            idx_t jcol = u.index_1d(idof, iv);
+                            u_dual[idof, iv] = (jcol >= jbegin && jcol < jbegin + nlane)
+                                ? Dual{u[idof, iv], (int) (jcol - jbegin)} : Dual{u[idof, iv]};
+                        }
+                    }
+                    res_dual = Dual{};
+                    res_op(trace, mesh.coord, uL_dual, uR_dual, res_dual);
+                    for(res_idx_t idoff = 0; idoff < res.ndof(); ++idoff) {
+                        for(res_idx_t ieqf = 0; ieqf < res.nv(); ++ieqf) {
+                            IDX irow = res.index_1d(idoff, ieqf);
+                            res[idoff, ieqf] = res_dual[idoff, ieqf].val;
+                            for(idx_t jcol = jbegin; jcol < std::min(ncol, (idx_t) (jbegin + nlane)); ++jcol)
+                                jac[irow, jcol] = res_dual[idoff, ieqf].grad[jcol - jbegin];
+                        }
+                    }
+                }
+                // unseed
+                for(idx_t idof = 0; idof < u.ndof(); ++idof)
+                    for(idx_t iv = 0; iv < u.nv(); ++iv) u_dual[idof, iv] = Dual{u[idof, iv]};
+            };
+
+            sweep(uL, uL_dual, jac_wrt_uL);
+
+            // stop if the jacobian with respect to uR is not requested
+            if(jac_wrt_uR.empty()) return;
+            sweep(uR, uR_dual, jac_wrt_uR);
+
+            // stop if jacobian with respect to geometry is not requested
+            if(jac_wrt_x.empty()) return;
+        }
     };
 
 #ifdef ICEICLE_USE_PETSC
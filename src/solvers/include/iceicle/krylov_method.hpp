@@ -0,0 +1,85 @@
+/**
+ * @brief configuration of the Krylov method of the linear solves of the petsc solvers
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include <petscerror.h>
+#include <petscksp.h>
+
+namespace iceicle::solvers {
+
+    /// @brief the Krylov methods for the linear solves
+    enum class KRYLOV_METHOD {
+        DEFAULT,    /// @brief keep the method chosen by the solver (GMRES unless the solver sets otherwise)
+        GMRES,      /// @brief restarted GMRES (KSPGMRES)
+        FGMRES,     /// @brief flexible GMRES for preconditioners that change between iterations (KSPFGMRES)
+        PGMRES,     /// @brief pipelined GMRES (KSPPGMRES)
+        PIPEFGMRES, /// @brief pipelined flexible GMRES (KSPPIPEFGMRES)
+        PIPEGCR,    /// @brief pipelined flexible GCR (KSPPIPEGCR)
+        PIPECG      /// @brief pipelined CG for symmetric positive definite systems (KSPPIPECG)
+    };
+
+    /**
+     * @brief set the Krylov method of a ksp
+     *
+     * GMRES does two blocking global reductions per iteration (the orthogonalization and the norm)
+     * which dominate on large rank counts.
+     * The pipelined methods fuse these into one non-blocking reduction
+     * that is overlapped with the next operator and preconditioner application,
+     * at the price of more vector storage and some loss of stability (restart more often).
+     * - PGMRES also overlaps the reduction for the norm of the new Krylov vector
+     * - PIPEFGMRES and PIPEGCR allow a varying (nonlinear or inner iterative) preconditioner;
+     *   PIPEFGMRES uses a shift that should approximate the center of the spectrum
+     *
+     * The petsc options database (i.e -ksp_type) is applied after and overrides this configuration
+     */
+    struct KrylovMethod {
+
+        /// @brief the Krylov method
+        KRYLOV_METHOD type = KRYLOV_METHOD::DEFAULT;
+
+        /// @brief the restart length of the GMRES variants and the maximum directions kept by PIPEGCR
+        /// (non-positive keeps the petsc default)
+        PetscInt restart = 0;
+
+        /// @brief the shift of PIPEFGMRES (non-positive keeps the petsc default)
+        PetscReal pipeline_shift = 0.0;
+
+        /**
+         * @brief configure the ksp
+         * call before KSPSetFromOptions
+         *
+         * @param ksp the linear solver
+         */
+        auto setup(KSP ksp) const -> void {
+            switch(type){
+                case KRYLOV_METHOD::DEFAULT:
+                    break;
+                case KRYLOV_METHOD::GMRES:
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSetType(ksp, KSPGMRES));
+                    break;
+                case KRYLOV_METHOD::FGMRES:
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSetType(ksp, KSPFGMRES));
+                    break;
+                case KRYLOV_METHOD::PGMRES:
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSetType(ksp, KSPPGMRES));
+                    break;
+                case KRYLOV_METHOD::PIPEFGMRES:
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSetType(ksp, KSPPIPEFGMRES));
+                    if(pipeline_shift > 0.0)
+                        PetscCallAbort(PETSC_COMM_WORLD, KSPPIPEFGMRESSetShift(ksp, pipeline_shift));
+                    break;
+                case KRYLOV_METHOD::PIPEGCR:
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSetType(ksp, KSPPIPEGCR));
+                    if(restart > 0) PetscCallAbort(PETSC_COMM_WORLD, KSPPIPEGCRSetMmax(ksp, restart));
+                    break;
+                case KRYLOV_METHOD::PIPECG:
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSetType(ksp, KSPPIPECG));
+                    break;
+            }
+            // no-op for the methods without a restart
+            if(restart > 0 && type != KRYLOV_METHOD::PIPEGCR)
+                PetscCallAbort(PETSC_COMM_WORLD, KSPGMRESSetRestart(ksp, restart));
+        }
+    };
+}
@@ -0,0 +1,86 @@
+/**
+ * @brief configuration of Krylov subspace reuse across the linear solves of the petsc solvers
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/anomaly_log.hpp"
+#include <petscerror.h>
+#include <petscksp.h>
+#include <petscoptions.h>
+#include <string>
+
+namespace iceicle::solvers {
+
+    /// @brief the ways to reuse information from previous linear solves
+    enum class KRYLOV_RECYCLING {
+        NONE,      /// @brief every linear solve starts from scratch
+        GCRODR,    /// @brief GCRO-DR: deflate the harmonic Ritz vectors of the previous solves (KSPHPDDM)
+        PROJECTION /// @brief initial guess from the projection onto the previous solutions (KSPGUESSFISCHER)
+    };
+
+    /**
+     * @brief set up a ksp to carry a subspace from one linear solve to the next
+     *
+     * Successive Newton and implicit time step systems change slowly
+     * so the subspace from the previous solves stays useful:
+     * - GCRODR keeps nrecycle harmonic Ritz vectors of the previous solve and deflates them from the next.
+     *   This needs petsc configured with HPDDM, otherwise PROJECTION is used and an anomaly is recorded
+     * - PROJECTION keeps the last nrecycle solutions and starts each solve
+     *   from the A-orthogonal projection of the right hand side onto them (works with any ksp type)
+     *
+     * The petsc options database (i.e -ksp_type, -ksp_guess_type) is applied after and overrides this configuration
+     */
+    struct KrylovRecycling {
+
+        /// @brief the recycling strategy
+        KRYLOV_RECYCLING type = KRYLOV_RECYCLING::NONE;
+
+        /// @brief the number of recycled vectors
+        PetscInt nrecycle = 10;
+
+        /**
+         * @brief configure the ksp
+         * call before KSPSetFromOptions
+         *
+         * @param ksp the linear solver
+         */
+        auto setup(KSP ksp) const -> void {
+            KRYLOV_RECYCLING use_type = type;
+#if !defined(PETSC_HAVE_HPDDM)
+            if(use_type == KRYLOV_RECYCLING::GCRODR){
+                util::AnomalyLog::log_record("GCRO-DR recycling needs petsc configured with HPDDM: using projection");
+                use_type = KRYLOV_RECYCLING::PROJECTION;
+            }
+#endif
+            switch(use_type){
+                case KRYLOV_RECYCLING::NONE:
+                    break;
+                case KRYLOV_RECYCLING::GCRODR:
+                {
+#if defined(PETSC_HAVE_HPDDM)
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSetType(ksp, KSPHPDDM));
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPHPDDMSetType(ksp, KSP_HPDDM_TYPE_GCRODR));
+                    // the recycled subspace size is only exposed through the options database
+                    const char* prefix;
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPGetOptionsPrefix(ksp, &prefix));
+                    std::string option = "-" + std::string{prefix ? prefix : ""} + "ksp_hpddm_recycle";
+                    PetscBool is_set;
+                    PetscCallAbort(PETSC_COMM_WORLD, PetscOptionsHasName(nullptr, prefix, "-ksp_hpddm_recycle", &is_set));
+                    if(!is_set) PetscCallAbort(PETSC_COMM_WORLD,
+                            PetscOptionsSetValue(nullptr, option.c_str(), std::to_string(nrecycle).c_str()));
+#endif
+                    break;
+                }
+                case KRYLOV_RECYCLING::PROJECTION:
+                {
+                    KSPGuess guess;
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPGetGuess(ksp, &guess));
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPGuessSetType(guess, KSPGUESSFISCHER));
+                    // model 1: A-orthogonal basis of the previous solutions
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPGuessFischerSetModel(guess, 1, nrecycle));
+                    break;
+                }
+            }
+        }
+    };
+}
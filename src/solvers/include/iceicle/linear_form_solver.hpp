@@ -5,16 +5,32 @@
 #include <iceicle/fespace/fespace.hpp>
 #include <iceicle/fe_function/fespan.hpp>
 #include <iceicle/element_linear_solve.hpp>
+#include <iceicle/profiler.hpp>
+#include <iceicle/thread_utils.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
 
 namespace iceicle::solvers {
 
     /// @brief Solver for u = f 
     /// or the weak form <u, v> = <f, v>
+    ///
+    /// The elements are independent so are solved in parallel over threads
+    /// with the inverse mass operator computed once (and kept for later solves on the same mesh).
+    /// Every element is local to the process so no communication is needed.
+    ///
+    /// If the discretization can evaluate its function at a batch of points 
+    /// (eval_points, quadrature_points, and domain_integral with the quadrature point values like Projection)
+    /// the elements are processed in chunks of batch_size: the quadrature points of the chunk are gathered, 
+    /// the function is evaluated in one call for the chunk, then the elements are integrated and solved
+    /// (so functions that are not thread safe, i.e lua functions, are called once per chunk instead of per point)
+    ///
     /// @tparam T the real number type
     /// @tparam IDX the indexing type 
     /// @tparam ndim the number of dimensions
     /// @tparam disc_type the discretization type that must provide 
-    ///  domain_integral(const FiniteElement&, NodeArray&, elspan)
+    ///  domain_integral(const FiniteElement&, elspan) (safe to call concurrently for distinct elements)
     ///  and static constxpr int nv_comp
     template<
         class T, 
@@ -28,6 +44,17 @@ namespace iceicle::solvers {
         /// @brief number of equations
         static constexpr int neq = disc_type::nv_comp;
 
+        /// @brief the discretization evaluates its function at batches of quadrature points
+        static constexpr bool batched = requires(const disc_type& d, const FiniteElement<T, IDX, ndim>& el,
+                std::size_t n, const T* x, T* f){
+            d.eval_points(n, x, f);
+            d.quadrature_points(el, f);
+        };
+
+        /// @brief the cached inverse mass matrices 
+        /// (exact: curved elements use the dense inverse)
+        TensorProductInverseMassOperator<T, IDX> inv_mass{};
+
         public:
         /// @brief store a reference to the fespace being used 
         FESpace<T, IDX, ndim> &fespace;
@@ -35,6 +62,9 @@ namespace iceicle::solvers {
         /// @brief store a reference to the discretization being solved
         disc_type &disc;
 
+        /// @brief the number of elements per batch of function evaluations
+        std::size_t batch_size = 16384;
+
         /// @brief Constructor 
         /// @param fespace the Finite Element Space
         /// @param disc the discretization 
@@ -49,34 +79,64 @@ namespace iceicle::solvers {
         auto solve(
             fespan<T, LayoutPolicy, AccessorPolicy> u
         ) -> void {
-            // TODO: generalize to CG and remove reliance on ElementLinearSolve
-            std::vector<T> u_local_data(fespace.dg_map.max_el_size_reqirement(neq));
-            std::vector<T> res_local_data(fespace.dg_map.max_el_size_reqirement(neq));
-            std::for_each(fespace.elements.begin(), fespace.elements.end(), 
-                [&](const FiniteElement<T, IDX, ndim> &el){
-                    // form the element local views
-                    // TODO: maybe instead of scatter from local view 
-                    // we can directly create the view on the subset of u 
-                    // for CG this might require a different compact Layout 
-                    dofspan u_local{u_local_data.data(), u.create_element_layout(el.elidx)};
-                    u_local = 0;
-
-                    dofspan res_local{res_local_data.data(), u.create_element_layout(el.elidx)};
-                    res_local = 0;
-
-                    // project
-                    disc.domain_integral(el, res_local);
-
-                    // solve 
-                    ElementLinearSolver<T, IDX, ndim, neq> solver{el};
-                    solver.solve(u_local, res_local);
-
-                    // scatter to global array 
-                    // (note we use 0 as multiplier for current values in global array)
-                    scatter_elspan(el.elidx, 1.0, u_local, 0.0, u);
+            ICEICLE_PROFILE_REGION("linear_form_solve");
+            // TODO: generalize to CG
+            inv_mass.update(fespace);
+
+            // per thread element scratch storage 
+            // (the element right hand side, the element solution, then the inverse mass workspace)
+            const std::size_t max_local_size = fespace.dg_map.max_el_size_reqirement(neq);
+            const std::size_t thread_size = 2 * max_local_size + inv_mass.scratch_size();
+            std::vector<T> scratch(util::max_threads() * thread_size);
+
+            // solve for one element given its (zeroed out) right hand side filled by integrate
+            auto solve_element = [&](const FiniteElement<T, IDX, ndim> &el, auto&& integrate){
+                T* thread_data = scratch.data() + util::thread_num() * thread_size;
+                dofspan res_local{thread_data, u.create_element_layout(el.elidx)};
+                res_local = 0;
+                integrate(res_local);
+
+                // u = M^{-1} res for all the components at once ([ndof x neq] row major right hand side)
+                const std::size_t ndof = el.nbasis();
+                T* x = thread_data + max_local_size;
+                inv_mass.element_apply_block(el.elidx, ndof, neq, thread_data, x, x + max_local_size);
+                for(std::size_t idof = 0; idof < ndof; ++idof){
+                    for(std::size_t iv = 0; iv < neq; ++iv) u[el.elidx, idof, iv] = x[idof * neq + iv];
+                }
+            };
+
+            if constexpr (batched) {
+                std::vector<std::size_t> qp_offsets{};
+                std::vector<T> x{}, f{};
+                for(std::size_t begin = 0; begin < fespace.elements.size(); begin += batch_size){
+                    std::size_t end = std::min(begin + batch_size, fespace.elements.size());
+
+                    // gather the quadrature points of the chunk
+                    qp_offsets.assign(end - begin + 1, 0);
+                    for(std::size_t iel = begin; iel < end; ++iel)
+                        { qp_offsets[iel - begin + 1] = qp_offsets[iel - begin] + fespace.elements[iel].nQP(); }
+                    x.resize(qp_offsets.back() * ndim);
+                    f.resize(qp_offsets.back() * neq);
+                    util::parallel_for(end - begin, [&](std::size_t i){
+                        disc.quadrature_points(fespace.elements[begin + i], x.data() + qp_offsets[i] * ndim);
+                    });
+
+                    // evaluate the function for the chunk
+                    disc.eval_points(qp_offsets.back(), x.data(), f.data());
+
+                    // integrate and solve
+                    util::parallel_for(end - begin, [&](std::size_t i){
+                        const FiniteElement<T, IDX, ndim> &el = fespace.elements[begin + i];
+                        solve_element(el, [&](auto res_local)
+                            { disc.domain_integral(el, f.data() + qp_offsets[i] * neq, res_local); });
+                    });
                 }
-            );
-    
+            } else {
+                util::parallel_for(fespace.elements.size(), [&](std::size_t iel){
+                    const FiniteElement<T, IDX, ndim> &el = fespace.elements[iel];
+                    solve_element(el, [&](auto res_local){ disc.domain_integral(el, res_local); });
+                });
+            }
         }
     };
 
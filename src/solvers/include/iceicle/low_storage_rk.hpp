@@ -0,0 +1,245 @@
+/**
+ * @brief low storage (2N) explicit Runge-Kutta schemes
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/form_residual.hpp"
+#include "iceicle/element_linear_solve.hpp"
+#include "iceicle/explicit_utils.hpp"
+
+#include <array>
+#include <iostream>
+#include <iomanip>
+#include <string>
+namespace iceicle::solvers {
+
+/**
+ * @brief Explicit low storage Runge-Kutta in the 2N form of Williamson (1980)
+ *
+ * for each stage i:
+ *   du = A_i du + dt M^{-1} R(u)
+ *   u  = u + B_i du
+ *
+ * Only the solution and one extra register (du) of solution size are needed
+ * plus the residual array that is kept for visualization
+ *
+ * Available orders:
+ * 3 : 3 stage third order scheme of Williamson (1980)
+ * 4 : 5 stage fourth order scheme RK4(3)5[2N] of Carpenter and Kennedy (1994)
+ */
+template< class T, class IDX, class TimestepClass, class StopCondition>
+class LowStorageRK {
+
+public:
+
+    /// @brief the maximum number of stages of the available schemes
+    static constexpr int max_stage = 5;
+
+    /** The timestep determination */
+    TimestepClass timestep;
+
+    /** The termination criteria */
+    StopCondition stop_condition;
+
+    /// @brief the residual data array
+    std::vector<T> res_data;
+
+    /// @brief the second register of the 2N scheme
+    std::vector<T> du_data;
+
+    /// @brief persistent storage for residual evaluation
+    ResidualWorkspace<T, IDX> workspace;
+
+    /// @brief the cached inverse mass operator (matrix free for tensor product elements)
+    TensorProductInverseMassOperator<T, IDX> inv_mass;
+
+    /// @brief the number of stages of the selected scheme
+    int nstage = 0;
+
+    /// @brief the 2N coefficients that multiply the du register
+    std::array<T, max_stage> A{};
+
+    /// @brief the 2N coefficients for the solution update
+    std::array<T, max_stage> B{};
+
+    /// @brief the current timestep
+    IDX itime = 0;
+
+    /// @brief the current time
+    T time = 0.0;
+
+#ifdef ICEICLE_USE_MPI
+    /// @brief the communicator the processes agree on the timestep over
+    MPI_Comm comm = MPI_COMM_WORLD;
+#endif
+
+    /// @brief the callback function for visualization during solve()
+    /// is given a reference to this when called
+    /// default is to print out the l2 norm of the residual (see ResidualWorkspace::monitor)
+    std::function<void(LowStorageRK &)> vis_callback = [](LowStorageRK &disc){
+        std::cout << std::setprecision(8);
+        std::cout << "itime: " << std::setw(6) << disc.itime
+            << " | t: " << std::setw(14) << disc.time
+            << " | residual l2: " << std::setw(14) << disc.workspace.monitor.l2()
+            << std::endl;
+    };
+
+    /// @brief if this is a positive integer
+    /// then the vis_callback will be called every ivis timesteps
+    /// (itime % ivis == 0)
+    IDX ivis = -1;
+
+    /**
+     * @brief create a LowStorageRK solver
+     * initializes the residual data vector
+     *
+     * @param fespace the finite element space
+     * @param disc the discretization
+     * @param timestep the class that determines the timestep
+     * @param stop_condition the termination criteria
+     * @param order the order of accuracy (3 or 4)
+     */
+    template<int ndim, class disc_class>
+    LowStorageRK(
+        FESpace<T, IDX, ndim> &fespace,
+        disc_class &disc,
+        const TimestepClass &timestep,
+        const StopCondition &stop_condition,
+        int order = 4
+    )
+    requires specifies_ncomp<disc_class> && TerminationCondition<StopCondition>
+    : timestep{timestep}, stop_condition{stop_condition},
+      res_data(fespace.dg_map.calculate_size_requirement(disc_class::nv_comp)),
+      du_data(fespace.dg_map.calculate_size_requirement(disc_class::nv_comp)),
+      workspace{fespace, disc_class::dnv_comp}, inv_mass{fespace}
+    {
+        workspace.enable_norm_monitor(disc_class::dnv_comp);
+        switch(order){
+            case 3:
+                nstage = 3;
+                A = {0.0, -5.0 / 9.0, -153.0 / 128.0};
+                B = {1.0 / 3.0, 15.0 / 16.0, 8.0 / 15.0};
+                break;
+            case 4:
+                nstage = 5;
+                A = {
+                    0.0,
+                    -567301805773.0 / 1357537059087.0,
+                    -2404267990393.0 / 2016746695238.0,
+                    -3550918686646.0 / 2091501179385.0,
+                    -1275806237668.0 / 842570457699.0
+                };
+                B = {
+                    1432997174477.0 / 9575080441755.0,
+                    5161836677717.0 / 13612068292357.0,
+                    1720146321549.0 / 2090206949498.0,
+                    3134564353537.0 / 4481467310338.0,
+                    2277821191437.0 / 14882151754819.0
+                };
+                break;
+            default:
+                util::AnomalyLog::log_anomaly(util::Anomaly{
+                    "Unsupported low storage Runge-Kutta order: " + std::to_string(order),
+                    util::general_anomaly_tag{}});
+        }
+    }
+
+    /**
+     * @brief perform a single timestep
+     * NOTE: this chooses the same layout for res based on u
+     *
+     * @param [in] fespace the finite element space
+     * @param [in] disc the discretization
+     * @param [in/out] u the solution as an fespan view
+     */
+    template<int ndim, class disc_class, class LayoutPolicy, class uAccessorPolicy>
+    void step(FESpace<T, IDX, ndim> &fespace, disc_class &disc, fespan<T, LayoutPolicy, uAccessorPolicy> u)
+    requires TimestepT<TimestepClass, T, IDX, ndim, disc_class, LayoutPolicy, uAccessorPolicy>
+    {
+        // create views using the same Layout as u
+        fespan res{res_data.data(), u.get_layout()};
+        fespan du{du_data.data(), u.get_layout()};
+
+        // update the solution dependent data cached by the discretization (once per step)
+        update_cached_state(fespace, disc, u);
+
+        // calculate the timestep
+        T dt = timestep(fespace, disc, u);
+
+        // Termination Condiditon restrictions on dt
+        dt = stop_condition.limit_dt(dt, time);
+
+        // sync dt between processes
+#ifdef ICEICLE_USE_MPI
+        T dt_individual = dt;
+        MPI_Allreduce(&dt_individual, &dt, 1, mpi_get_type<T>(), MPI_MAX, comm);
+#endif
+
+        // make sure the inverse mass matrices are up to date with the mesh
+        inv_mass.update(fespace);
+
+        for(int istage = 0; istage < nstage; ++istage){
+            form_residual(fespace, disc, u, res, workspace);
+
+            // du = A_i du + dt M^{-1} res (A_0 = 0 so du needs no initialization)
+            inv_mass.apply(dt, res, A[istage], du);
+
+            // u += B_i du
+            axpy(B[istage], du, u);
+        }
+
+        // update the timestep and time
+        itime++;
+        time += dt;
+    }
+
+    /**
+     * @brief perform timesteps until the stop condition is reached
+     * either itime reaches ntime (ntime >= 0)
+     * or the time value reaches tfinal
+     *
+     * NOTE: this chooses the same layout for res based on u
+     *
+     * @param [in] fespace the finite element space
+     * @param [in] disc the discretization
+     * @param [in/out] u the solution as an fespan view
+     */
+    template<int ndim, class disc_class, class LayoutPolicy, class uAccessorPolicy>
+    void solve(FESpace<T, IDX, ndim> &fespace, disc_class &disc, fespan<T, LayoutPolicy, uAccessorPolicy> u) {
+
+        // call initial residual to get initial wavespeeds for dt
+        {
+            // create view of the residual using the same Layout as u
+            fespan res{res_data.data(), u.get_layout()};
+
+            // get the rhs
+            form_residual(fespace, disc, u, res, workspace);
+        }
+
+        // visualization callback on initial state (0 % anything == 0)
+        vis_callback(*this);
+
+        // timestep loop
+        while(!stop_condition(itime, time)){
+            step(fespace, disc, u);
+            if(itime % ivis == 0){
+                vis_callback(*this);
+            }
+        }
+    }
+};
+
+// template argument deduction
+template<class T, class IDX, int ndim, class disc_class, class TimestepClass, class StopCondition>
+LowStorageRK(FESpace<T, IDX, ndim> &, disc_class &,
+    const TimestepClass &, const StopCondition &) -> LowStorageRK<T, IDX, TimestepClass, StopCondition>;
+
+template<class T, class IDX, int ndim, class disc_class, class TimestepClass, class StopCondition>
+LowStorageRK(FESpace<T, IDX, ndim> &, disc_class &,
+    const TimestepClass &, const StopCondition &, int) -> LowStorageRK<T, IDX, TimestepClass, StopCondition>;
+
+}
@@ -4,14 +4,22 @@
 
 #include "iceicle/fespace/fespace.hpp"
 #include <iceicle/nonlinear_solver_utils.hpp>
+#include <array>
 #include <limits>
 #include <cmath>
 #include <iomanip>
+#include <algorithm>
 #include <petsc.h>
 #include <petscmat.h>
 #include <petscsys.h>
 #include "iceicle/form_residual.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/element_block_jacobi.hpp"
+#include "iceicle/element_line_implicit.hpp"
+#include "iceicle/krylov_method.hpp"
+#include "iceicle/krylov_recycling.hpp"
 #include "iceicle/petsc_interface.hpp"
+#include "iceicle/memory_arena.hpp"
 #include "iceicle/fe_function/geo_layouts.hpp"
 #include "iceicle/fe_function/layout_right.hpp"
 #include "iceicle/fe_function/fespan.hpp"
@@ -20,6 +28,25 @@
 namespace iceicle::solvers {
 
 
+    /// @brief the finite difference approximation of the matrix-free jacobian vector products
+    enum class mf_difference {
+        /// one sided (J p ~ (r(u + h p) - r(u)) / h): one residual per product
+        forward,
+
+        /// second order central (J p ~ (r(u + h p) - r(u - h p)) / 2h): two residuals per product
+        central
+    };
+
+    /// @brief the choice of the step h for the matrix-free jacobian vector products
+    enum class mf_step {
+        /// h = sqrt(machine epsilon) 
+        fixed,
+
+        /// h = sqrt(machine epsilon * (1 + ||u||)) / ||p|| (Pernice and Walker)
+        /// which keeps the perturbation relative to the size of the state and direction
+        scaled
+    };
+
     namespace impl {
 
         /// @brief Context for calculating the jacobian with directional derivatives
@@ -39,6 +66,22 @@ namespace iceicle::solvers {
 
             /// @brief a span over the calculated full residual
             Vec res;
+
+            /// @brief persistent storage for residual evaluation
+            ResidualWorkspace<T, IDX>& workspace;
+
+            /// @brief work arrays for the peturbed states and residuals reused across Krylov iterations
+            util::vector_arena<T>& arena;
+
+            /// @brief the finite difference approximation
+            mf_difference difference = mf_difference::forward;
+
+            /// @brief the choice of finite difference step
+            mf_step step = mf_step::fixed;
+
+            /// @brief the norm of the state (u and the geometry parameterization) for mf_step::scaled
+            /// (set once per Newton iteration)
+            T unorm = 0;
         };
 
         template<class T, class IDX, int ndim, class disc_class, class uLayoutPolicy>
@@ -46,7 +89,7 @@ namespace iceicle::solvers {
         auto jacobian_mf_op(Mat A, Vec p, Vec y) 
         -> PetscErrorCode 
         {
-            static constexpr T epsilon = std::sqrt(std::numeric_limits<T>::epsilon());
+            static constexpr T sqrt_eps = std::sqrt(std::numeric_limits<T>::epsilon());
 
             // Set up the context
             JacobianContext<T, IDX, ndim, disc_class, uLayoutPolicy> *ctx;
@@ -58,6 +101,22 @@ namespace iceicle::solvers {
             const geo_dof_map<T, IDX, ndim>& geo_map = ctx->geo_map;
             fespan<T, uLayoutPolicy> u = ctx->u;
             Vec res = ctx->res;
+            ResidualWorkspace<T, IDX>& workspace = ctx->workspace;
+            util::vector_arena<T>& arena = ctx->arena;
+
+            // the norm of p for the scaled step is a non-blocking reduction
+            // overlapped with the extraction of the geometry below
+            // so a pipelined Krylov method is not serialized by a blocking reduction in the operator
+            PetscReal pnorm_sq_local = 0, pnorm_sq = 0;
+            MPI_Request pnorm_request = MPI_REQUEST_NULL;
+            if(ctx->step == mf_step::scaled){
+                {
+                    petsc::VecSpan pview{p};
+                    for(PetscScalar pi : pview) pnorm_sq_local += pi * pi;
+                }
+                MPI_Iallreduce(&pnorm_sq_local, &pnorm_sq, 1, MPIU_REAL, MPI_SUM,
+                        PETSC_COMM_WORLD, &pnorm_request);
+            }
 
             // create all the layouts
             fe_layout_right dg_layout{fespace.dg_map, tmp::to_size<disc_class::nv_comp>()};
@@ -65,39 +124,61 @@ namespace iceicle::solvers {
             ic_residual_layout<T, IDX, ndim, disc_class::nv_comp> ic_layout{geo_map};
 
             // get the geometric parameterization
-            std::vector<T> xdata(x_layout.size());
-            component_span x{xdata, x_layout};
+            auto xdata = arena.checkout(x_layout.size());
+            component_span x{xdata.span(), x_layout};
             extract_geospan(*(fespace.meshptr), x);
 
-            // setup peturbed residuals 
-            std::vector<T> resp(dg_layout.size() + ic_layout.size());
-            fespan res_dg{resp, dg_layout};
-            dofspan res_mdg{std::span{resp.begin() + dg_layout.size(), resp.end()}, ic_layout};
-
-            // perform the peturbation
-            std::vector<T> xdata_peturb = xdata;
-            std::vector<T> udata_peturb(dg_layout.size());
-            fespan up{udata_peturb, dg_layout};
-            copy_fespan(u, up);
-            component_span xp{xdata_peturb, x_layout};
-            {
-                petsc::VecSpan pview{p};
-                fespan du{pview, dg_layout};
-                component_span dx{pview.data() + dg_layout.size(), x_layout};
-                axpy(epsilon, du, up);
-                axpy(epsilon, dx, xp);
+            // the finite difference step
+            T epsilon = sqrt_eps;
+            if(ctx->step == mf_step::scaled){
+                MPI_Wait(&pnorm_request, MPI_STATUS_IGNORE);
+                T pnorm = std::sqrt(pnorm_sq);
+                if(pnorm == 0){
+                    PetscCall(VecZeroEntries(y));
+                    PetscFunctionReturn(EXIT_SUCCESS);
+                }
+                epsilon = std::sqrt(std::numeric_limits<T>::epsilon() * (1 + ctx->unorm)) / pnorm;
             }
 
+            // storage for the peturbed states
+            auto xdata_peturb = arena.checkout(x_layout.size());
+            auto udata_peturb = arena.checkout(dg_layout.size());
+            fespan up{udata_peturb.data(), dg_layout};
+            component_span xp{xdata_peturb.span(), x_layout};
+
+            // form the residual at the state peturbed by h * p 
+            auto peturbed_residual = [&](T h, std::span<T> resp){
+                fespan res_dg{resp.data(), dg_layout};
+                dofspan res_mdg{std::span{resp.begin() + dg_layout.size(), resp.end()}, ic_layout};
+
+                std::ranges::copy(xdata, xdata_peturb.begin());
+                copy_fespan(u, up);
+                {
+                    petsc::VecSpan pview{p};
+                    fespan du{pview, dg_layout};
+                    component_span dx{pview.data() + dg_layout.size(), x_layout};
+                    axpy(h, du, up);
+                    axpy(h, dx, xp);
+                }
+
+                // apply the peturbed geometric parameterization to the mesh 
+                update_mesh(xp, *(fespace.meshptr));
 
-            // apply the peturbed geometric parameterization to the mesh 
-            update_mesh(xp, *(fespace.meshptr));
+                form_dg_mdg_residual(fespace, disc, up, res_dg, geo_map, res_mdg, workspace);
+            };
 
-            // form the peturbed residual
-            form_residual(fespace, disc, up, res_dg);
-            form_mdg_residual(fespace, disc, up, geo_map, res_mdg);
+            auto resp = arena.checkout(dg_layout.size() + ic_layout.size());
+            peturbed_residual(epsilon, resp.span());
 
             // directional derivative
-            {
+            if(ctx->difference == mf_difference::central){
+                auto resm = arena.checkout(dg_layout.size() + ic_layout.size());
+                peturbed_residual(-epsilon, resm.span());
+                petsc::VecSpan yview{y};
+                for(IDX i = 0; i < resp.size(); ++i){
+                    yview[i] = (resp[i] - resm[i]) / (2 * epsilon);
+                }
+            } else {
                 petsc::VecSpan resview{res};
                 petsc::VecSpan yview{y};
                 for(IDX i = 0; i < resp.size(); ++i){
@@ -109,9 +190,58 @@ namespace iceicle::solvers {
             update_mesh(x, *(fespace.meshptr));
             PetscFunctionReturn(EXIT_SUCCESS);
         }
+
+        /// @brief Context for the element preconditioners (ElementBlockJacobi or ElementLineImplicit)
+        template<class T, class IDX, int ndim, class disc_class, class pc_type = ElementBlockJacobi<T, IDX>>
+        struct BlockJacobiContext {
+            /// @brief the finite element space
+            FESpace<T, IDX, ndim>& fespace;
+
+            /// @brief the geometry mapping
+            const geo_dof_map<T, IDX, ndim>& geo_map;
+
+            /// @brief the element preconditioner
+            pc_type& element_pc;
+        };
+
+        /// @brief apply the element preconditioner to the pde part 
+        /// the geometry part is left unpreconditioned 
+        /// (the interface conservation rows are copied to as many geometry dofs as there are)
+        template<class T, class IDX, int ndim, class disc_class, class pc_type = ElementBlockJacobi<T, IDX>>
+        inline 
+        auto block_jacobi_apply(PC pc, Vec r, Vec z)
+        -> PetscErrorCode 
+        {
+            BlockJacobiContext<T, IDX, ndim, disc_class, pc_type> *ctx;
+            PetscFunctionBeginUser;
+            PetscCall(PCShellGetContext(pc, &ctx));
+
+            fe_layout_right dg_layout{ctx->fespace.dg_map, tmp::to_size<disc_class::nv_comp>()};
+            geo_data_layout x_layout{ctx->geo_map};
+            ic_residual_layout<T, IDX, ndim, disc_class::nv_comp> ic_layout{ctx->geo_map};
+            {
+                petsc::VecSpan rview{r};
+                petsc::VecSpan zview{z};
+                fespan r_dg{rview.data(), dg_layout};
+                fespan z_dg{zview.data(), dg_layout};
+                ctx->element_pc.apply(r_dg, z_dg);
+
+                std::size_t ngeo = x_layout.size();
+                std::size_t ncopy = std::min(ngeo, (std::size_t) ic_layout.size());
+                std::copy_n(rview.data() + dg_layout.size(), ncopy, zview.data() + dg_layout.size());
+                std::fill_n(zview.data() + dg_layout.size() + ncopy, ngeo - ncopy, 0.0);
+            }
+            PetscFunctionReturn(EXIT_SUCCESS);
+        }
     }
 
-    template<class T, class IDX, int ndim, class disc_class, class ls_type = no_linesearch<T, IDX>>
+    /// @brief Matrix-free Newton-Krylov solver
+    ///
+    /// The element preconditioners can be built from a cheaper preconditioner discretization pc_disc
+    /// (i.e a dissipative Riemann solver, frozen artificial viscosity)
+    /// the residual and the jacobian vector products always use disc
+    template<class T, class IDX, int ndim, class disc_class, class ls_type = no_linesearch<T, IDX>,
+        class pc_disc_class = disc_class>
     struct MFNK {
 
         /// @brief the finite element space
@@ -120,6 +250,13 @@ namespace iceicle::solvers {
         /// @brief the discretization
         disc_class& disc;
 
+        /// @brief the discretization the element preconditioners are built from (disc unless given)
+        pc_disc_class& pc_disc;
+
+        /// @brief do not update the cached state of a separate pc_disc (i.e the artificial viscosity)
+        /// when the preconditioner is rebuilt
+        bool freeze_pc_disc_state = false;
+
         /// @brief the convergence criteria
         ConvergenceCriteria<T, IDX> conv_criteria;
 
@@ -129,6 +266,54 @@ namespace iceicle::solvers {
         /// @brief the geometry mapping
         const geo_dof_map<T, IDX, ndim>& geo_map;
 
+        /// @brief persistent storage for residual evaluation
+        ResidualWorkspace<T, IDX> workspace;
+
+        /// @brief the element block Jacobi preconditioner
+        ElementBlockJacobi<T, IDX> block_jacobi;
+
+        /// @brief the line implicit preconditioner (used instead of block_jacobi when use_line_implicit)
+        ElementLineImplicit<T, IDX> line_implicit;
+
+        /// @brief use block tridiagonal solves along strongly coupled element lines as the preconditioner
+        /// for high aspect ratio (boundary layer) meshes where element block Jacobi stalls
+        bool use_line_implicit = false;
+
+        /// @brief work arrays for the matrix-free jacobian products
+        util::vector_arena<T> arena;
+
+        /// @brief if this is a positive integer 
+        /// the element block Jacobi preconditioner is used 
+        /// and rebuilt every pc_refresh Newton iterations (k % pc_refresh == 0)
+        /// otherwise GMRES is unpreconditioned
+        IDX pc_refresh = 1;
+
+        /// @brief the Krylov method of the linear solves
+        /// (the pipelined methods overlap their reductions with the matrix-free products)
+        KrylovMethod krylov_method{};
+
+        /// @brief reuse of the Krylov subspace across the Newton linear solves
+        KrylovRecycling krylov_recycling{};
+
+        /// @brief the finite difference approximation of the jacobian vector products
+        mf_difference difference = mf_difference::forward;
+
+        /// @brief the choice of the finite difference step of the jacobian vector products
+        mf_step step = mf_step::fixed;
+
+        /// @brief adaptive relative tolerance for the linear solves 
+        /// (disabled by default: the KSP tolerances are used)
+        EisenstatWalkerForcing<T> forcing{};
+
+        /// @brief the maximum number of iterative refinement steps for each linear solve 
+        /// (see petsc::refined_solve) 
+        /// useful with a single precision preconditioner (block_jacobi.single_precision) 
+        /// since the refinement residual is recomputed in working precision
+        IDX linear_refinement = 0;
+
+        /// @brief relative tolerance for the iterative refinement
+        T linear_refinement_rtol = 1e-10;
+
         /// @brief if this is a positive integer 
         /// Then the diagnostics callback will be called every idiag timesteps
         /// (k % idiag == 0)
@@ -189,9 +374,27 @@ namespace iceicle::solvers {
             ConvergenceCriteria<T, IDX> conv_criteria,
             const ls_type& linesearch,
             const geo_dof_map<T, IDX, ndim>& geo_map
-        ) : fespace(fespace), disc(disc), conv_criteria(conv_criteria),
-            linesearch(linesearch), geo_map(geo_map)
-        {}
+        ) : MFNK(fespace, disc, disc, conv_criteria, linesearch, geo_map) {}
+
+        MFNK(
+            FESpace<T, IDX, ndim>& fespace,
+            disc_class& disc,
+            pc_disc_class& pc_disc,
+            ConvergenceCriteria<T, IDX> conv_criteria,
+            const ls_type& linesearch,
+            const geo_dof_map<T, IDX, ndim>& geo_map
+        ) : fespace(fespace), disc(disc), pc_disc(pc_disc), conv_criteria(conv_criteria),
+            linesearch(linesearch), geo_map(geo_map),
+            workspace{fespace, disc_class::dnv_comp}
+        {
+            static_assert(pc_disc_class::nv_comp == disc_class::nv_comp,
+                    "the preconditioner discretization must have the same number of equations");
+        }
+
+        /// @brief the preconditioner is built from a different discretization than the residual
+        [[nodiscard]] auto separate_pc_disc() const noexcept -> bool {
+            return static_cast<const void*>(&pc_disc) != static_cast<const void*>(&disc);
+        }
 
         /// @brief solve the PDE
         template<class uLayoutPolicy>
@@ -221,7 +424,11 @@ namespace iceicle::solvers {
                 .disc = disc,
                 .geo_map = geo_map,
                 .u = u,
-                .res = r
+                .res = r,
+                .workspace = workspace,
+                .arena = arena,
+                .difference = difference,
+                .step = step
             };
 
             MatCreate(PETSC_COMM_WORLD, &J);
@@ -237,61 +444,111 @@ namespace iceicle::solvers {
             KSP ksp;
             PC pc;
             PetscCallAbort(PETSC_COMM_WORLD, KSPCreate(PETSC_COMM_WORLD, &ksp));
+            krylov_method.setup(ksp);
+            krylov_recycling.setup(ksp);
             PetscCallAbort(PETSC_COMM_WORLD, KSPSetFromOptions(ksp));
 
             // default preconditioner
             PetscCallAbort(PETSC_COMM_WORLD, KSPGetPC(ksp, &pc));
-            PCSetType(pc, PCNONE);
+            impl::BlockJacobiContext<T, IDX, ndim, disc_class> pc_ctx{
+                .fespace = fespace,
+                .geo_map = geo_map,
+                .element_pc = block_jacobi
+            };
+            impl::BlockJacobiContext<T, IDX, ndim, disc_class, ElementLineImplicit<T, IDX>> line_pc_ctx{
+                .fespace = fespace,
+                .geo_map = geo_map,
+                .element_pc = line_implicit
+            };
+            if(pc_refresh > 0 && use_line_implicit){
+                PCSetType(pc, PCSHELL);
+                PCShellSetContext(pc, (void *) &line_pc_ctx);
+                PCShellSetApply(pc, impl::block_jacobi_apply<T, IDX, ndim, disc_class, ElementLineImplicit<T, IDX>>);
+                PCShellSetName(pc, "element line implicit");
+            } else if(pc_refresh > 0){
+                PCSetType(pc, PCSHELL);
+                PCShellSetContext(pc, (void *) &pc_ctx);
+                PCShellSetApply(pc, impl::block_jacobi_apply<T, IDX, ndim, disc_class>);
+                PCShellSetName(pc, "element block jacobi");
+            } else {
+                PCSetType(pc, PCNONE);
+            }
 
             { // get the initial residual 
                 petsc::VecSpan resview{r};
                 fespan res_pde{resview, u_layout};
                 dofspan res_mdg{resview.data() + u_layout.size(), ic_layout};
 
-                form_residual(fespace, disc, u, res_pde);
-                form_mdg_residual(fespace, disc, u, geo_map, res_mdg);
+                form_dg_mdg_residual(fespace, disc, u, res_pde, geo_map, res_mdg, workspace);
             }
 
+            // residual norms of the current and previous iterates 
+            // and the final linear residual norm of the previous linear solve
+            T r_cur, r_prev = 0, lin_rnorm = 0;
+            PetscCallAbort(PETSC_COMM_WORLD, VecNorm(r, NORM_2, &r_cur));
+            conv_criteria.r0 = r_cur;
+
             // =======================
             // = Main Iteration Loop =
             // =======================
             IDX k;
             for(k = 0; k < conv_criteria.kmax; ++k){
 
+                // refresh the preconditioner
+                if(pc_refresh > 0 && k % pc_refresh == 0){
+                    if(separate_pc_disc() && (k == 0 || !freeze_pc_disc_state))
+                        update_cached_state(fespace, pc_disc, u);
+                    if(use_line_implicit) line_implicit.build(fespace, pc_disc, u);
+                    else block_jacobi.build(fespace, pc_disc, u);
+                }
+
+                // the state norm for the scaled finite difference step
+                if(step == mf_step::scaled){
+                    std::vector<T> xdata(geo_layout.size());
+                    component_span x{xdata, geo_layout};
+                    extract_geospan(*(fespace.meshptr), x);
+                    T xnorm_sq = 0;
+                    for(T xi : xdata) xnorm_sq += xi * xi;
+                    std::array<T, 2> sums = mpi::allreduce_sums(std::array<T, 2>{norm_sq(u), xnorm_sq});
+                    j_ctx.unorm = std::sqrt(sums[0] + sums[1]);
+                }
+
                 // Solve for the step
                 MatAssemblyBegin(J, MAT_FINAL_ASSEMBLY);
                 MatAssemblyEnd(J, MAT_FINAL_ASSEMBLY);
                 PetscCallAbort(PETSC_COMM_WORLD, KSPSetOperators(ksp, J, J));
-                PetscCallAbort(PETSC_COMM_WORLD, KSPSolve(ksp, r, du));
+                if(forcing.choice != 0){
+                    T tau = conv_criteria.tau_abs + conv_criteria.tau_rel * conv_criteria.r0;
+                    T eta = forcing.forcing_term(k, r_cur, r_prev, lin_rnorm, tau);
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSetTolerances(ksp, eta, PETSC_DEFAULT, PETSC_DEFAULT, PETSC_DEFAULT));
+                }
+                petsc::refined_solve(ksp, r, du, linear_refinement, linear_refinement_rtol);
+                PetscCallAbort(PETSC_COMM_WORLD, KSPGetResidualNorm(ksp, &lin_rnorm));
 
                 // keep the old geometry data around
                 std::vector<T> xdata(geo_layout.size());
                 component_span x{xdata, geo_layout};
                 extract_geospan(*(fespace.meshptr), x);
 
+                // === Set up working arrays for linesearch update ===
+                // the pde and mdg residuals are contiguous so the work array is a petsc vec without copy
+                auto u_step_storage = arena.checkout(u.size());
+                fespan u_step{u_step_storage.data(), u.get_layout()};
+                auto x_step_storage = arena.checkout(geo_layout.size());
+                component_span x_step{x_step_storage.span(), geo_layout};
+                auto r_work_storage = arena.checkout(u.size() + ic_layout.size());
+                fespan res_work{r_work_storage.data(), u.get_layout()};
+                dofspan mdg_res{r_work_storage.data() + u.size(), ic_layout};
+                petsc::ArrayVec res_work_vec{r_work_storage};
+
                 T rnorm_step;
+                // the alpha that r_work_storage holds the residuals for
+                T alpha_evaluated = std::numeric_limits<T>::quiet_NaN();
                 // linesearchin time!
                 T alpha = linesearch([&](T alpha_arg){
-                    
-                        // === Set up working arrays for linesearch update ===
-
-                        // u step for linesearch
-                        std::vector<T> u_step_storage(u.size());
-                        fespan u_step{u_step_storage.data(), u.get_layout()};
-                        copy_fespan(u, u_step);
-
-                        // x step for linesearch
-                        std::vector<T> x_step_storage = xdata; // copy over the coordinates as well
-                        component_span x_step{x_step_storage, geo_layout};
-
-                        // working array for linesearch residuals
-                        std::vector<T> r_work_storage(u.size());
-                        fespan res_work{r_work_storage.data(), u.get_layout()};
-
-                        std::vector<T> r_mdg_work_storage(ic_layout.size());
-                        dofspan mdg_res{r_mdg_work_storage, ic_layout};
-
                         // === Compute the Update ===
+                        copy_fespan(u, u_step);
+                        std::ranges::copy(xdata, x_step_storage.begin());
 
                         petsc::VecSpan du_view{du};
                         fespan du{du_view.data(), u.get_layout()};
@@ -299,20 +556,20 @@ namespace iceicle::solvers {
 
                         // x update
                         component_span dx{du_view.data() + u.size(), geo_layout};
-                        axpy(-alpha_arg, dx, x);
+                        axpy(-alpha_arg, dx, x_step);
                         // apply the x coordinates to the mesh
-                        update_mesh(x, *(fespace.meshptr));
+                        update_mesh(x_step, *(fespace.meshptr));
 
                         // === Get the residuals ===
-                        form_residual(fespace, disc, u_step, res_work);
-                        form_mdg_residual(fespace, disc, u_step, geo_map, mdg_res);
-                        T rnorm = res_work.vector_norm() + mdg_res.vector_norm();
+                        form_dg_mdg_residual(fespace, disc, u_step, res_work, geo_map, mdg_res, workspace);
+                        alpha_evaluated = alpha_arg;
+                        T rnorm = res_work_vec.norm();
                         if(!std::isfinite(rnorm)) return 1e100;
                         rnorm_step = rnorm; // extract it
 
                         // Add any penalties
                         return rnorm;
-                });
+                }, r_cur);
 
                 // perform the update 
                 petsc::VecSpan du_view{du};
@@ -323,18 +580,23 @@ namespace iceicle::solvers {
                 // apply the x coordinates to the mesh
                 update_mesh(x, *(fespace.meshptr));
 
-                { // get the updated residual 
+                if(alpha == alpha_evaluated) {
+                    // the last trial was the accepted step so its residuals are the new residuals
+                    petsc::VecSpan resview{r};
+                    std::ranges::copy(r_work_storage.span(), resview.data());
+                } else { // get the updated residual 
                     petsc::VecSpan resview{r};
                     fespan res_pde{resview, u_layout};
                     dofspan res_mdg{resview.data() + u_layout.size(), ic_layout};
 
-                    form_residual(fespace, disc, u, res_pde);
-                    form_mdg_residual(fespace, disc, u, geo_map, res_mdg);
+                    form_dg_mdg_residual(fespace, disc, u, res_pde, geo_map, res_mdg, workspace);
                 }
 
                 // get the residual norm
                 T rk;
                 PetscCallAbort(PETSC_COMM_WORLD, VecNorm(r, NORM_2, &rk));
+                r_prev = r_cur;
+                r_cur = rk;
 
                 // Diagnostics 
                 if(idiag > 0 && k % idiag == 0) {
@@ -1,59 +1,171 @@
 /**
  * @brief utilities for solving mdg problems
- * 
+ *
  * @author Gianni Absillis (gabsill@ncsu.edu)
  */
 #pragma once
 #include "Numtool/point.hpp"
 #include "iceicle/fespace/fespace.hpp"
+#include "iceicle/thread_utils.hpp"
+#include <algorithm>
+#include <span>
 #include <vector>
 namespace iceicle {
 
     /**
-     * @brief given the current locations of surface nodes 
-     * recalculate the locations of interior nodes for elements 
-     * according to their barycentric weights 
+     * @brief the linear operator that places the interior nodes of elements
+     * (nodes not on any face) from the nodes on the faces
+     * according to the regularization stencil of each element type
+     *
+     * The stencils of all the elements are flattened into one sparse operator:
+     * interior node interior_nodes[irow] is placed at
+     * sum weights[k] * coord[source_nodes[k]] for k in [row_start[irow], row_start[irow + 1])
+     * The rows are grouped by element type.
+     * Rows only write their own interior node and read nodes on faces, so rows are applied in parallel.
+     */
+    template<class T, class IDX, int ndim>
+    class InteriorNodeRegularization {
+
+        /// @brief the interior node of each row
+        std::vector<IDX> interior_nodes{};
+
+        /// @brief the start of each row in source_nodes and weights (size = nrow + 1)
+        std::vector<IDX> row_start{0};
+
+        /// @brief the node that contributes to each stencil entry
+        std::vector<IDX> source_nodes{};
+
+        /// @brief the weight of each stencil entry
+        std::vector<T> weights{};
+
+        /// @brief the rows that each node contributes to
+        util::crs<IDX, IDX> rows_of_node{};
+
+        public:
+
+        /// @brief build the operator for all the elements of the finite element space
+        /// @param fespace the finite element space
+        InteriorNodeRegularization(const FESpace<T, IDX, ndim>& fespace) {
+            using element_t = FESpace<T, IDX, ndim>::ElementType;
+
+            // group the elements by element type
+            std::vector<IDX> element_order(fespace.elements.size());
+            for(IDX iel = 0; iel < element_order.size(); ++iel) element_order[iel] = iel;
+            std::ranges::stable_sort(element_order, [&fespace](IDX iel, IDX jel){
+                const auto* trans_i = fespace.elements[iel].trans;
+                const auto* trans_j = fespace.elements[jel].trans;
+                if(trans_i->domain_type != trans_j->domain_type) return trans_i->domain_type < trans_j->domain_type;
+                return trans_i->order < trans_j->order;
+            });
+
+            for(IDX iel : element_order){
+                const element_t& el = fespace.elements[iel];
+                if(el.trans->regularization_stencil == nullptr) continue;
+                std::span<const interior_node_weight<T>> stencil = el.trans->regularization_stencil();
+                for(std::size_t k = 0; k < stencil.size(); ++k){
+                    // new row when the interior node changes
+                    if(k == 0 || stencil[k].inode != stencil[k - 1].inode){
+                        if(k > 0) row_start.push_back(source_nodes.size());
+                        interior_nodes.push_back(el.inodes[stencil[k].inode]);
+                    }
+                    source_nodes.push_back(el.inodes[stencil[k].jnode]);
+                    weights.push_back(stencil[k].weight);
+                }
+                if(stencil.size() > 0) row_start.push_back(source_nodes.size());
+            }
+
+            // invert to get the rows each node contributes to
+            std::vector<std::vector<IDX>> rows_ragged(fespace.meshptr->n_nodes());
+            for(IDX irow = 0; irow < nrow(); ++irow){
+                for(IDX k = row_start[irow]; k < row_start[irow + 1]; ++k)
+                    { rows_ragged[source_nodes[k]].push_back(irow); }
+            }
+            for(std::vector<IDX>& rows : rows_ragged){
+                std::ranges::sort(rows);
+                auto unique_subrange = std::ranges::unique(rows);
+                rows.erase(unique_subrange.begin(), unique_subrange.end());
+            }
+            rows_of_node = util::crs<IDX, IDX>{rows_ragged};
+        }
+
+        /// @brief the number of interior nodes
+        [[nodiscard]] auto nrow() const -> IDX { return interior_nodes.size(); }
+
+        /// @brief place all the interior nodes
+        /// @param [in/out] coord the node coordinates
+        auto apply(NodeArray<T, ndim>& coord) const -> void {
+            util::parallel_for(nrow(), [&](IDX irow){ apply_row(irow, coord); });
+        }
+
+        /// @brief place only the interior nodes of the elements that contain a moved node
+        /// @param [in/out] coord the node coordinates
+        /// @param moved_nodes the indices of the nodes that moved
+        auto apply(NodeArray<T, ndim>& coord, std::span<const IDX> moved_nodes) const -> void {
+            std::vector<IDX> rows{};
+            for(IDX inode : moved_nodes){
+                if(inode < 0 || (std::size_t) inode >= rows_of_node.nrow()) continue;
+                for(IDX irow : rows_of_node.rowspan(inode)) rows.push_back(irow);
+            }
+            std::ranges::sort(rows);
+            auto unique_subrange = std::ranges::unique(rows);
+            rows.erase(unique_subrange.begin(), unique_subrange.end());
+            util::parallel_for(rows.size(), [&](std::size_t i){ apply_row(rows[i], coord); });
+        }
+
+        private:
+
+        auto apply_row(IDX irow, NodeArray<T, ndim>& coord) const -> void {
+            MATH::GEOMETRY::Point<T, ndim> x;
+            for(int idim = 0; idim < ndim; ++idim) x[idim] = 0.0;
+            for(IDX k = row_start[irow]; k < row_start[irow + 1]; ++k){
+                const MATH::GEOMETRY::Point<T, ndim>& xsource = coord[source_nodes[k]];
+                for(int idim = 0; idim < ndim; ++idim) x[idim] += weights[k] * xsource[idim];
+            }
+            coord[interior_nodes[irow]] = x;
+        }
+    };
+
+    /**
+     * @brief given the current locations of surface nodes
+     * recalculate the locations of interior nodes for elements
+     * according to their barycentric weights
      * @param fespace the finite element space
      */
     template<class T, class IDX, int ndim>
     auto regularize_interior_nodes(FESpace<T, IDX, ndim> &fespace) -> void {
-        for(auto& element : fespace.elements){
-            element.geo_el->regularize_interior_nodes(fespace.meshptr->nodes);
-        }
+        InteriorNodeRegularization<T, IDX, ndim> regularization{fespace};
+        regularization.apply(fespace.meshptr->coord);
+        fespace.meshptr->update_nodes(regularization.interior_nodes);
     }
 
 
     /**
-     * @brief get a vector of doubles 
-     * representing the distance to the nearest node for every node 
+     * @brief get a vector of doubles
+     * representing the distance to the nearest node for every node
+     * (the nearest node of the elements surrounding the node)
      * NOTE: in terms of node movement: 0.5 * radius should be enough to prevent overlaps
      */
     template<class T, class IDX, int ndim>
     auto node_freedom_radii(
         FESpace<T, IDX, ndim> &fespace
     ) -> std::vector<T> {
-        using element_t = FESpace<T, IDX, ndim>::ElementType;
-        using Point = MATH::GEOMETRY::Point<T, ndim>;
         static constexpr T big_number = 1e100;
-        NodeArray<T, ndim>& coord = fespace.meshptr->coord;
-        
+        const AbstractMesh<T, IDX, ndim>& mesh = *(fespace.meshptr);
+        const NodeArray<T, ndim>& coord = mesh.coord;
+
         std::vector<T> radii(coord.size(), big_number);
 
-        // NOTE: loop over elements because interior nodes exist
-        for(element_t& elem: fespace.elements){
-            // loop over all nodes and get min distance to surrounding nodes
-            for( IDX inode : elem.inodes){
-                for(IDX jnode : elem.inodes) if (jnode != inode){
-                    T distance = MATH::GEOMETRY::distance(
-                        coord[inode],
-                        coord[jnode]
-                    );
-
-                    radii[inode] = std::min(radii[inode], distance);
-                    radii[jnode] = std::min(radii[jnode], distance);
+        // NOTE: loop over the nodes of elements because interior nodes exist
+        // each node only writes its own radius so the nodes are independent
+        util::parallel_for(mesh.elsup.nrow(), [&](IDX inode){
+            T radius = big_number;
+            for(IDX iel : mesh.elsup.rowspan(inode)){
+                for(IDX jnode : mesh.conn_el.rowspan(iel)) if (jnode != inode){
+                    radius = std::min(radius, MATH::GEOMETRY::distance(coord[inode], coord[jnode]));
                 }
             }
-        }
+            radii[inode] = radius;
+        });
 
         return radii;
     }
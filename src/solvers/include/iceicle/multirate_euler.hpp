@@ -0,0 +1,377 @@
+/**
+ * @brief multirate (local time stepping) explicit Euler with power of two element clusters
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/element/finite_element.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fe_function/layout_right.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/form_residual.hpp"
+#include "iceicle/element_linear_solve.hpp"
+#include "iceicle/explicit_utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <limits>
+namespace iceicle::solvers {
+
+/// @brief a timestep class that can give a timestep for each element
+template<class TimestepClass, class T, class IDX, int ndim, class disc_T, class uLayoutPolicy, class uAccessorPolicy>
+concept LocalTimestepT = requires(
+    const TimestepClass& timestep,
+    FESpace<T, IDX, ndim> &fespace,
+    disc_T disc,
+    fespan<T, uLayoutPolicy, uAccessorPolicy> u
+){
+    {timestep.local_timesteps(fespace, disc, u)} -> std::same_as<std::vector<T>>;
+};
+
+/**
+ * @brief Multirate explicit Euler with local time stepping
+ *
+ * Elements are grouped into clusters by their CFL limited timestep:
+ * element e is in level l_e = floor(log2(dt_e / dt_min)) (capped at max_level)
+ * and advances with timestep dt_min * 2^{l_e}
+ *
+ * A macro step of dt_min * 2^L (L the highest level present) is split into 2^L substeps.
+ * Each element and trace contribution is evaluated at the start of every step of its level
+ * (a trace takes the finer level of its neighbors) and the time integral of the contribution
+ * is accumulated for the elements it couples to.
+ * Each element is updated at the end of its own step with the accumulated fluxes,
+ * so both sides of a cluster interface see the same time integrated flux
+ * and the scheme stays conservative (Osher and Sanders 1983)
+ *
+ * Parallel communication traces are treated at the finest level
+ * with a halo exchange every substep
+ *
+ * NOTE: this is first order in time
+ */
+template< class T, class IDX, class TimestepClass, class StopCondition>
+class MultirateEuler {
+
+public:
+
+    /** The timestep determination (must provide local_timesteps) */
+    TimestepClass timestep;
+
+    /** The termination criteria */
+    StopCondition stop_condition;
+
+    /// @brief the residual data array
+    std::vector<T> res_data;
+
+    /// @brief the time integrated residual accumulated over the current step of each element
+    std::vector<T> acc_data;
+
+    /// @brief persistent storage for residual evaluation
+    ResidualWorkspace<T, IDX> workspace;
+
+    /// @brief the cached inverse mass matrices
+    InverseMassOperator<T, IDX> inv_mass;
+
+    /// @brief the maximum cluster level (the coarsest cluster steps with dt_min * 2^max_level)
+    int max_level = 4;
+
+    /// @brief the cluster level of each element (from the last step)
+    std::vector<int> element_level;
+
+    /// @brief the current timestep (number of macro steps)
+    IDX itime = 0;
+
+    /// @brief the current time
+    T time = 0.0;
+
+#ifdef ICEICLE_USE_MPI
+    /// @brief the communicator the processes agree on the timestep and cluster levels over
+    MPI_Comm comm = MPI_COMM_WORLD;
+#endif
+
+    /// @brief the callback function for visualization during solve()
+    /// is given a reference to this when called
+    /// default is to print out the l2 norm of the residual (see ResidualWorkspace::monitor)
+    std::function<void(MultirateEuler &)> vis_callback = [](MultirateEuler &disc){
+        std::cout << std::setprecision(8);
+        std::cout << "itime: " << std::setw(6) << disc.itime
+            << " | t: " << std::setw(14) << disc.time
+            << " | residual l2: " << std::setw(14) << disc.workspace.monitor.l2()
+            << std::endl;
+    };
+
+    /// @brief if this is a positive integer
+    /// then the vis_callback will be called every ivis timesteps
+    /// (itime % ivis == 0)
+    IDX ivis = -1;
+
+    /**
+     * @brief create a MultirateEuler solver
+     * initializes the residual data vector
+     *
+     * @param fespace the finite element space
+     * @param disc the discretization
+     * @param timestep the class that determines the timestep of each element
+     * @param stop_condition the termination criteria
+     */
+    template<int ndim, class disc_class>
+    MultirateEuler(
+        FESpace<T, IDX, ndim> &fespace,
+        disc_class &disc,
+        const TimestepClass &timestep,
+        const StopCondition &stop_condition
+    )
+    requires specifies_ncomp<disc_class> && TerminationCondition<StopCondition>
+    : timestep{timestep}, stop_condition{stop_condition},
+      res_data(fespace.dg_map.calculate_size_requirement(disc_class::nv_comp)),
+      acc_data(fespace.dg_map.calculate_size_requirement(disc_class::nv_comp)),
+      workspace{fespace, disc_class::dnv_comp}, inv_mass{fespace},
+      element_level(fespace.elements.size(), 0)
+    { workspace.enable_norm_monitor(disc_class::dnv_comp); }
+
+    /**
+     * @brief perform a single macro timestep
+     * NOTE: this chooses the same layout for res based on u
+     *
+     * @param [in] fespace the finite element space
+     * @param [in] disc the discretization
+     * @param [in/out] u the solution as an fespan view
+     */
+    template<int ndim, class disc_class, class LayoutPolicy, class uAccessorPolicy>
+    void step(FESpace<T, IDX, ndim> &fespace, disc_class &disc, fespan<T, LayoutPolicy, uAccessorPolicy> u)
+    requires LocalTimestepT<TimestepClass, T, IDX, ndim, disc_class, LayoutPolicy, uAccessorPolicy>
+    {
+        using Element = FiniteElement<T, IDX, ndim>;
+        using Trace = TraceSpace<T, IDX, ndim>;
+
+        // update the solution dependent data cached by the discretization (once per macro step)
+        update_cached_state(fespace, disc, u);
+
+        // ==================================
+        // = Cluster elements by timestep   =
+        // ==================================
+        std::vector<T> dt_el = timestep.local_timesteps(fespace, disc, u);
+        T dt_min = std::numeric_limits<T>::max();
+        for(T dt : dt_el) dt_min = std::min(dt_min, dt);
+#ifdef ICEICLE_USE_MPI
+        T dt_min_local = dt_min;
+        MPI_Allreduce(&dt_min_local, &dt_min, 1, mpi_get_type<T>(), MPI_MIN, comm);
+#endif
+        int nlevel = 0;
+        for(IDX iel = 0; iel < (IDX) dt_el.size(); ++iel){
+            int level = (int) std::floor(std::log2(dt_el[iel] / dt_min));
+            element_level[iel] = std::clamp(level, 0, max_level);
+            nlevel = std::max(nlevel, element_level[iel]);
+        }
+#ifdef ICEICLE_USE_MPI
+        int nlevel_local = nlevel;
+        MPI_Allreduce(&nlevel_local, &nlevel, 1, MPI_INT, MPI_MAX, comm);
+#endif
+        const IDX nsub = IDX{1} << nlevel;
+
+        // Termination Condiditon restrictions on dt scale every cluster
+        T dt_macro = stop_condition.limit_dt(dt_min * nsub, time);
+        dt_min = dt_macro / nsub;
+
+        // make sure the inverse mass matrices are up to date with the mesh
+        inv_mass.update(fespace);
+
+        fespan res{res_data.data(), u.get_layout()};
+        fespan acc{acc_data.data(), u.get_layout()};
+        acc = 0;
+
+        // storage for compact views of u and res
+        T *uL_data = workspace.scratch_data(0, 0);
+        T *uR_data = workspace.scratch_data(0, 1);
+        T *resL_data = workspace.scratch_data(0, 2);
+        T *resR_data = workspace.scratch_data(0, 3);
+
+        // a level is active at substep isub if a step of that level starts there
+        auto active = [](IDX isub, int level){ return isub % (IDX{1} << level) == 0; };
+        auto level_dt = [&](int level){ return dt_min * (IDX{1} << level); };
+
+        for(IDX isub = 0; isub < nsub; ++isub){
+
+            // start communicating inter-process element data
+            HaloExchange<T, IDX>& halo = workspace.halo;
+            halo.begin_exchange(u);
+
+            // boundary faces (excluding parallel communication)
+            for(IDX itrace : workspace.physical_bdy_traces){
+                const Trace& trace = fespace.traces[itrace];
+                int level = element_level[trace.elL.elidx];
+                if(!active(isub, level)) continue;
+
+                auto uL_layout = u.create_element_layout(trace.elL.elidx);
+                dofspan uL{uL_data, uL_layout};
+                auto uR_layout = u.create_element_layout(trace.elR.elidx);
+                dofspan uR{uR_data, uR_layout};
+                auto resL_layout = res.create_element_layout(trace.elL.elidx);
+                dofspan resL{resL_data, resL_layout};
+
+                extract_elspan(trace.elL.elidx, u, uL);
+                extract_elspan(trace.elR.elidx, u, uR);
+                resL = 0;
+
+                disc.boundaryIntegral(trace, fespace.meshptr->coord, uL, uR, resL);
+
+                scatter_elspan(trace.elL.elidx, level_dt(level), resL, 1.0, acc);
+            }
+
+            // interior faces at the finer level of the two neighbors
+            for(const Trace &trace : fespace.get_interior_traces()){
+                int level = std::min(element_level[trace.elL.elidx], element_level[trace.elR.elidx]);
+                if(!active(isub, level)) continue;
+
+                auto uL_layout = u.create_element_layout(trace.elL.elidx);
+                dofspan uL{uL_data, uL_layout};
+                auto uR_layout = u.create_element_layout(trace.elR.elidx);
+                dofspan uR{uR_data, uR_layout};
+                auto resL_layout = res.create_element_layout(trace.elL.elidx);
+                dofspan resL{resL_data, resL_layout};
+                auto resR_layout = res.create_element_layout(trace.elR.elidx);
+                dofspan resR{resR_data, resR_layout};
+
+                extract_elspan(trace.elL.elidx, u, uL);
+                extract_elspan(trace.elR.elidx, u, uR);
+                resL = 0;
+                resR = 0;
+
+                disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, resL, resR);
+
+                scatter_elspan(trace.elL.elidx, level_dt(level), resL, 1.0, acc);
+                scatter_elspan(trace.elR.elidx, level_dt(level), resR, 1.0, acc);
+            }
+
+            // domain integral
+            for(const Element &el : fespace.elements){
+                int level = element_level[el.elidx];
+                if(!active(isub, level)) continue;
+
+                auto uel_layout = u.create_element_layout(el.elidx);
+                dofspan u_el{uL_data, uel_layout};
+                auto res_layout = res.create_element_layout(el.elidx);
+                dofspan res_el{resL_data, res_layout};
+
+                extract_elspan(el.elidx, u, u_el);
+                res_el = 0;
+
+                disc.domain_integral(el, u_el, res_el);
+
+                scatter_elspan(el.elidx, level_dt(level), res_el, 1.0, acc);
+            }
+
+            // finish the inter-process communication
+            halo.finish_exchange();
+
+            // parallel communication faces at the finest level (every substep)
+#ifdef ICEICLE_USE_MPI
+            for(std::size_t ipar = 0; ipar < workspace.parallel_com_traces.size(); ++ipar){
+                const Trace& trace = fespace.traces[workspace.parallel_com_traces[ipar]];
+                bool imleft = workspace.parallel_com_imleft[ipar];
+                T* ughost_data = halo.ghost_element_data(workspace.parallel_com_ghosts[ipar]);
+
+                // the remote side reads from the ghost layer, the local side from u
+                compact_layout_right<IDX, disc_class::nv_comp> uL_layout{trace.elL};
+                dofspan uL{(imleft) ? uL_data : ughost_data, uL_layout};
+                compact_layout_right<IDX, disc_class::nv_comp> uR_layout{trace.elR};
+                dofspan uR{(imleft) ? ughost_data : uR_data, uR_layout};
+
+                compact_layout_right<IDX, disc_class::nv_comp> resL_layout{trace.elL};
+                dofspan resL{resL_data, resL_layout};
+                compact_layout_right<IDX, disc_class::nv_comp> resR_layout{trace.elR};
+                dofspan resR{resR_data, resR_layout};
+
+                const Element& el_local = (imleft) ? trace.elL : trace.elR;
+                auto& u_local = (imleft) ? uL : uR;
+                auto& res_local = (imleft) ? resL : resR;
+
+                // extract the compact values from the global u view
+                extract_elspan(el_local.elidx, u, u_local);
+
+                // zero out residual 
+                res_local = 0;
+
+                disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, resL, resR);
+
+                // scatter only the side owned by this process
+                scatter_elspan(el_local.elidx, dt_min, res_local, 1.0, acc);
+            }
+#else 
+            if(workspace.parallel_com_traces.size() > 0)
+                util::AnomalyLog::log_anomaly(util::Anomaly{"Built without mpi, parallel communication boundary condition will not work", util::general_anomaly_tag{}});
+#endif
+
+            // update the elements whose step ends at this substep
+            // u_e += M^{-1} acc_e
+            for(const Element &el : fespace.elements){
+                if(!active(isub + 1, element_level[el.elidx])) continue;
+                const std::size_t ndof = el.nbasis();
+                const T* minv = inv_mass.element_data(el.elidx);
+                for(std::size_t idof = 0; idof < ndof; ++idof){
+                    for(std::size_t iv = 0; iv < u.nv(); ++iv){
+                        T sum = 0.0;
+                        for(std::size_t jdof = 0; jdof < ndof; ++jdof)
+                            { sum += minv[idof * ndof + jdof] * acc[el.elidx, jdof, iv]; }
+                        u[el.elidx, idof, iv] += sum;
+                    }
+                }
+                for(std::size_t idof = 0; idof < ndof; ++idof){
+                    for(std::size_t iv = 0; iv < u.nv(); ++iv)
+                        { acc[el.elidx, idof, iv] = 0.0; }
+                }
+            }
+        }
+
+        // the residual at the synchronized state
+        form_residual(fespace, disc, u, res, workspace);
+
+        // update the timestep and time
+        itime++;
+        time += dt_macro;
+    }
+
+    /**
+     * @brief perform timesteps until the stop condition is reached
+     * either itime reaches ntime (ntime >= 0)
+     * or the time value reaches tfinal
+     *
+     * NOTE: this chooses the same layout for res based on u
+     *
+     * @param [in] fespace the finite element space
+     * @param [in] disc the discretization
+     * @param [in/out] u the solution as an fespan view
+     */
+    template<int ndim, class disc_class, class LayoutPolicy, class uAccessorPolicy>
+    void solve(FESpace<T, IDX, ndim> &fespace, disc_class &disc, fespan<T, LayoutPolicy, uAccessorPolicy> u) {
+
+        // call initial residual to get initial wavespeeds for dt
+        {
+            // create view of the residual using the same Layout as u
+            fespan res{res_data.data(), u.get_layout()};
+
+            // get the rhs
+            form_residual(fespace, disc, u, res, workspace);
+        }
+
+        // visualization callback on initial state (0 % anything == 0)
+        vis_callback(*this);
+
+        // timestep loop
+        while(!stop_condition(itime, time)){
+            step(fespace, disc, u);
+            if(itime % ivis == 0){
+                vis_callback(*this);
+            }
+        }
+    }
+};
+
+// template argument deduction
+template<class T, class IDX, int ndim, class disc_class, class TimestepClass, class StopCondition>
+MultirateEuler(FESpace<T, IDX, ndim> &, disc_class &,
+    const TimestepClass &, const StopCondition &) -> MultirateEuler<T, IDX, TimestepClass, StopCondition>;
+
+}
@@ -5,8 +5,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <functional>
+#include <limits>
+#include <optional>
+#include <utility>
 #include <variant>
+#include <vector>
 #include <cmath>
 
 namespace iceicle::solvers {
@@ -59,6 +64,123 @@ namespace iceicle::solvers {
         }
     };
 
+    /**
+     * @brief policy for lagging the jacobian (and the preconditioner built from it)
+     * across nonlinear iterations
+     *
+     * The jacobian is refreshed when any of the following hold:
+     * - it has been used for refresh_interval iterations
+     * - convergence stalls: the residual reduction ratio r_k / r_{k-1} exceeds stall_ratio
+     * - the linesearch multiplier falls below alpha_min
+     *
+     * The default of refresh_interval = 1 refreshes every iteration
+     *
+     * @tparam T the data type
+     * @tparam IDX the index type
+     */
+    template<class T, class IDX>
+    struct JacobianLagPolicy {
+
+        /// @brief the maximum number of iterations to reuse a jacobian for
+        IDX refresh_interval = 1;
+
+        /// @brief refresh if r_k / r_{k-1} is greater than this
+        T stall_ratio = 0.5;
+
+        /// @brief refresh if the linesearch multiplier is less than this
+        T alpha_min = 0.1;
+
+        /// @brief the number of iterations the current jacobian has been used for
+        IDX age = 0;
+
+        /**
+         * @brief record an iteration with the current jacobian and decide if it should be refreshed
+         * @param rk the residual norm after the step 
+         * @param rkm1 the residual norm before the step 
+         * @param alpha the linesearch multiplier used for the step
+         * @return true if the jacobian should be refreshed (resets the age)
+         */
+        auto refresh(T rk, T rkm1, T alpha) -> bool {
+            ++age;
+            bool stalled = rkm1 > 0 && rk > stall_ratio * rkm1;
+            if(refresh_interval <= 1 || age >= refresh_interval || stalled || alpha < alpha_min){
+                age = 0;
+                return true;
+            }
+            return false;
+        }
+    };
+
+    /**
+     * @brief Eisenstat-Walker forcing terms for inexact Newton methods
+     * chooses the relative tolerance eta_k of the linear solve from the nonlinear residual history
+     * so that early iterations do not oversolve the linear system
+     *
+     * choice 1: eta_k = | ||F_k|| - ||F_{k-1} + J_{k-1} s_{k-1}|| | / ||F_{k-1}||
+     * choice 2: eta_k = gamma (||F_k|| / ||F_{k-1}||)^alpha
+     *
+     * with the safeguards from Eisenstat and Walker 1996 SIAM J. Sci. Comput.
+     * and a floor so that the final linear solve is not oversolved relative to the nonlinear tolerance
+     *
+     * @tparam T the data type
+     */
+    template<class T>
+    struct EisenstatWalkerForcing {
+
+        /// @brief the forcing term choice (1 or 2), 0 to use a fixed linear tolerance
+        int choice = 0;
+
+        /// @brief the initial forcing term
+        T eta0 = 0.3;
+
+        /// @brief the maximum forcing term
+        T eta_max = 0.9;
+
+        /// @brief the minimum forcing term
+        T eta_min = 1e-10;
+
+        /// @brief the multiplier for choice 2
+        T gamma = 0.9;
+
+        /// @brief the exponent for choice 2 (the safeguard for choice 1 uses the golden ratio)
+        T alpha = 2.0;
+
+        /// @brief the forcing term of the previous iteration
+        T eta_prev = 0;
+
+        /**
+         * @brief compute the forcing term for the current linear solve
+         * @param k the nonlinear iteration number
+         * @param rk the current nonlinear residual norm ||F_k||
+         * @param rkm1 the previous nonlinear residual norm ||F_{k-1}||
+         * @param lin_rkm1 the final linear residual norm of the previous solve ||F_{k-1} + J_{k-1} s_{k-1}||
+         * @param tau the nonlinear convergence tolerance
+         * @return the relative tolerance for the linear solve
+         */
+        auto forcing_term(int k, T rk, T rkm1, T lin_rkm1, T tau) -> T {
+            T eta;
+            if(k == 0 || rkm1 <= 0) {
+                eta = eta0;
+            } else if(choice == 1) {
+                static constexpr T golden = 1.618033988749895;
+                eta = std::abs(rk - lin_rkm1) / rkm1;
+                T eta_safe = std::pow(eta_prev, golden);
+                if(eta_safe > 0.1) eta = std::max(eta, eta_safe);
+            } else {
+                eta = gamma * std::pow(rk / rkm1, alpha);
+                T eta_safe = gamma * std::pow(eta_prev, alpha);
+                if(eta_safe > 0.1) eta = std::max(eta, eta_safe);
+            }
+            eta = std::min(eta, eta_max);
+
+            // do not oversolve relative to the nonlinear tolerance
+            if(rk > 0) eta = std::max(eta, 0.5 * tau / rk);
+            eta = std::clamp(eta, eta_min, eta_max);
+            eta_prev = eta;
+            return eta;
+        }
+    };
+
     // ========================
     // = Linesearch Utilities =
     // ========================
@@ -71,6 +193,53 @@ namespace iceicle::solvers {
     template<typename T>
     using function1d = std::function<T(T)>;
 
+    /**
+     * @brief a 1d function that remembers the values it has been evaluated at
+     * so that repeated evaluations at the same argument (i.e phi(0) in every zoom iteration)
+     * do not call the underlying function again (generally a full residual evaluation)
+     *
+     * @tparam T the floating point type
+     */
+    template<typename T>
+    class cached_function1d {
+        /// @brief the underlying function
+        function1d<T> fcn;
+
+        /// @brief the (argument, value) pairs evaluated so far
+        std::vector<std::pair<T, T>> values{};
+
+        /// @brief the number of calls to the underlying function
+        std::size_t _nevals = 0;
+
+        public:
+
+        /// @param fcn the function to cache
+        /// @param phi_0 the value at 0 if it is already known (i.e the current residual norm)
+        explicit cached_function1d(function1d<T> fcn, std::optional<T> phi_0 = std::nullopt)
+        : fcn{std::move(fcn)} {
+            if(phi_0) insert(0, phi_0.value());
+        }
+
+        /// @brief record a known value of the function
+        auto insert(T x, T fx) -> void {
+            auto it = std::ranges::find(values, x, &std::pair<T, T>::first);
+            if(it == values.end()) values.emplace_back(x, fx);
+            else it->second = fx;
+        }
+
+        /// @brief evaluate the function, calling the underlying function only for new arguments
+        auto operator()(T x) -> T {
+            auto it = std::ranges::find(values, x, &std::pair<T, T>::first);
+            if(it != values.end()) return it->second;
+            T fx = fcn(x);
+            ++_nevals;
+            values.emplace_back(x, fx);
+            return fx;
+        }
+
+        /// @brief the number of calls to the underlying function
+        [[nodiscard]] auto nevals() const noexcept -> std::size_t { return _nevals; }
+    };
 
     template<typename T>
     inline T finite_difference(function1d<T> fcn, T EPSILON, T x){
@@ -80,7 +249,14 @@ namespace iceicle::solvers {
     }
 
     template<typename T>
-    T zoom(function1d<T> fcn, T alpha_lo, T alpha_hi, int kmax, T c1, T c2){
+    inline T finite_difference(cached_function1d<T>& fcn, T EPSILON, T x){
+        T phi1 = fcn(x);
+        T phi2 = fcn(x + EPSILON);
+        return (phi2 - phi1) / EPSILON;
+    }
+
+    template<typename T>
+    T zoom(cached_function1d<T>& fcn, T alpha_lo, T alpha_hi, int kmax, T c1, T c2){
         static const T EPSILON = std::sqrt(std::numeric_limits<T>::epsilon());
 
         for(int k = 0; k < kmax; k++){
@@ -91,7 +267,7 @@ namespace iceicle::solvers {
             T dphi_ahi = finite_difference(fcn, EPSILON, alpha_hi);
 
             T d1 = dphi_alo + dphi_ahi - 3 * (phi_alo - phi_ahi) / (alpha_lo - alpha_hi);
-            T d2 = std::sqrt(std::max(SQUARED(d1) - dphi_alo * dphi_ahi, 1e-8)); // safeguard squareroot
+            T d2 = std::sqrt(std::max(d1 * d1 - dphi_alo * dphi_ahi, 1e-8)); // safeguard squareroot
             d2 = std::copysign(d2, (alpha_hi - alpha_lo));
 
             T aj = alpha_hi - (alpha_hi - alpha_lo) * (
@@ -137,7 +313,7 @@ namespace iceicle::solvers {
      * @return T the step length alpha that provides sufficient decrease based on the Wolfe Conditions
      */
     template<typename T>
-    T wolfe_ls(function1d<T> fcn, T alpha_max, T alpha1, int kmax, T c1, T c2){
+    T wolfe_ls(cached_function1d<T>& fcn, T alpha_max, T alpha1, int kmax, T c1, T c2){
         static T EPSILON = std::sqrt(std::numeric_limits<T>::epsilon());
         T a_im1 = 0;
         T a_i = alpha1;
@@ -169,13 +345,19 @@ namespace iceicle::solvers {
         return a_i;
     }
 
+    /// @brief wolfe_ls() with every distinct alpha evaluated at most once
     template<typename T>
-    T corrigan_ls(function1d<T> fcn, T alpha_max, T alpha1, int kmax, T alpha_min){
+    T wolfe_ls(function1d<T> fcn, T alpha_max, T alpha1, int kmax, T c1, T c2){
+        cached_function1d<T> cached_fcn{std::move(fcn)};
+        return wolfe_ls(cached_fcn, alpha_max, alpha1, kmax, c1, c2);
+    }
+
+    template<typename T>
+    T corrigan_ls(cached_function1d<T>& fcn, T alpha_max, T alpha1, int kmax, T alpha_min){
         T alpha_a = alpha_min, alpha_b = alpha_max;
         T alpha = alpha1;
         for(int k = 0; k < kmax; ++k){
-            T phi_0 = fcn(0); // TODO: pass in unchanged residual value 
-                              // because this is already calculated when getting jacobian in NL solver 
+            T phi_0 = fcn(0);
             if(k > 0)
                 alpha = (alpha_a + alpha_b) / 2;
             T phi_star = fcn(alpha);
@@ -190,12 +372,21 @@ namespace iceicle::solvers {
         return alpha;
     }
 
+    /// @brief corrigan_ls() with every distinct alpha evaluated at most once
+    template<typename T>
+    T corrigan_ls(function1d<T> fcn, T alpha_max, T alpha1, int kmax, T alpha_min){
+        cached_function1d<T> cached_fcn{std::move(fcn)};
+        return corrigan_ls(cached_fcn, alpha_max, alpha1, kmax, alpha_min);
+    }
+
     /**
      * @brief no linesearch strategy - take the full step 
      */
     template<typename T, typename IDX>
     struct no_linesearch {
         auto operator()(function1d<T> fcn) const -> T { return 1.0; }
+
+        auto operator()(function1d<T> fcn, T phi_0) const -> T { return 1.0; }
     };
 
     /**
@@ -229,6 +420,12 @@ namespace iceicle::solvers {
             return wolfe_ls(fcn, alpha_max, alpha_initial, max_it, c1, c2);
         }
 
+        /// @brief linesearch when phi(0) is already known (i.e the current residual norm)
+        auto operator()(function1d<T> fcn, T phi_0) const -> T {
+            cached_function1d<T> cached_fcn{std::move(fcn), phi_0};
+            return wolfe_ls(cached_fcn, alpha_max, alpha_initial, max_it, c1, c2);
+        }
+
     };
 
     /// @brief the linesearch strategy described in 
@@ -254,6 +451,12 @@ namespace iceicle::solvers {
             return corrigan_ls(fcn, alpha_max, alpha_initial, max_it, alpha_min);
         }
 
+        /// @brief linesearch when phi(0) is already known (i.e the current residual norm)
+        auto operator()(function1d<T> fcn, T phi_0) const -> T {
+            cached_function1d<T> cached_fcn{std::move(fcn), phi_0};
+            return corrigan_ls(cached_fcn, alpha_max, alpha_initial, max_it, alpha_min);
+        }
+
     };
 
     /// @brief a linesearch class that can set a linesearch multipler (alpha)
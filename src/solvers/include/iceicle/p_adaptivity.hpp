@@ -0,0 +1,194 @@
+/**
+ * @brief adaptive p-refinement for the hierarchical Legendre basis
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/build_config.hpp"
+#include "iceicle/fe_function/dglayout.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fe_function/layout_right.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/thread_utils.hpp"
+#include "iceicle/tmp_utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace iceicle::solvers {
+
+    namespace impl {
+        /// @brief the index of the mode with the given 1D indices
+        /// for a tensor product basis with nb1d modes in each direction (first dimension slowest, see QTypeProduct)
+        template<int ndim>
+        inline constexpr auto tensor_mode_index(const int (&ijk)[ndim], int nb1d) noexcept -> int {
+            int idof = 0;
+            for(int idim = 0; idim < ndim; ++idim) idof = idof * nb1d + ijk[idim];
+            return idof;
+        }
+
+        /// @brief the 1D indices of a mode of a tensor product basis with nb1d modes in each direction
+        template<int ndim>
+        inline constexpr auto tensor_mode_ijk(int idof, int nb1d, int (&ijk)[ndim]) noexcept -> void {
+            for(int idim = ndim - 1; idim >= 0; --idim){
+                ijk[idim] = idof % nb1d;
+                idof /= nb1d;
+            }
+        }
+
+        /// @brief if the element uses the tensor product Legendre basis
+        template<class T, class IDX, int ndim>
+        auto is_hierarchical(const FESpace<T, IDX, ndim>& fespace, IDX ibatch) -> bool {
+            const FETypeKey& key = fespace.element_batch_keys[ibatch];
+            return key.btype == FESPACE_ENUMS::LEGENDRE && key.domain_type == DOMAIN_TYPE::HYPERCUBE;
+        }
+    }
+
+    /**
+     * @brief the modal decay smoothness indicator of each element (Persson and Peraire 2006)
+     *
+     * S_e = log10( ||u - u_{p-1}||^2 / ||u||^2 )
+     * where u - u_{p-1} is the part of the solution in the modes of highest order p
+     * (the tensor product modes with a 1D index of p in any direction).
+     * The norms use the diagonal of the reference mass matrix (the Legendre modes are orthogonal).
+     * The maximum over the vector components is taken.
+     *
+     * A well resolved smooth solution has a very negative S_e,
+     * S_e near 0 means the energy is not decaying in the highest modes.
+     * Elements of order 0 or that do not use the Legendre basis on hypercubes have S_e = 0
+     * (so they are always candidates for refinement)
+     *
+     * @param fespace the finite element space
+     * @param u the solution
+     * @return the indicator for each element
+     */
+    template<class T, class IDX, int ndim, class LayoutPolicy, class AccessorPolicy>
+    auto modal_decay_indicator(
+        FESpace<T, IDX, ndim>& fespace,
+        fespan<T, LayoutPolicy, AccessorPolicy> u
+    ) -> std::vector<T> {
+        std::vector<T> indicator(fespace.elements.size(), 0.0);
+        for(IDX ibatch = 0; ibatch < fespace.element_batches.nrow(); ++ibatch){
+            if(!impl::is_hierarchical(fespace, ibatch)) continue;
+            int order = fespace.element_batch_keys[ibatch].basis_order;
+            if(order == 0) continue;
+            std::span<const IDX> elidxs = fespace.element_batches.rowspan(ibatch);
+            util::parallel_for(elidxs.size(), [&](std::size_t i){
+                IDX iel = elidxs[i];
+                const FiniteElement<T, IDX, ndim>& el = fespace.elements[iel];
+                int nbasis = el.nbasis();
+                T s_max = std::numeric_limits<T>::lowest();
+                for(std::size_t iv = 0; iv < u.nv(); ++iv){
+                    T e_top = 0.0, e_total = 0.0;
+                    for(int idof = 0; idof < nbasis; ++idof){
+                        int ijk[ndim];
+                        impl::tensor_mode_ijk(idof, order + 1, ijk);
+                        T weight = el.ref_mass.empty() ? 1.0 : el.ref_mass[idof * nbasis + idof];
+                        T e = weight * u[iel, idof, iv] * u[iel, idof, iv];
+                        e_total += e;
+                        if(std::ranges::max(ijk) == order) e_top += e;
+                    }
+                    T s = (e_total > 0.0) ? std::log10(std::max(e_top / e_total, std::numeric_limits<T>::min()))
+                        : std::numeric_limits<T>::lowest();
+                    s_max = std::max(s_max, s);
+                }
+                indicator[iel] = s_max;
+            });
+        }
+        return indicator;
+    }
+
+    /// @brief the thresholds and order limits to choose the element orders from the modal decay indicator
+    template<class T>
+    struct PAdaptation {
+        /// @brief raise the order of elements with an indicator above this
+        T refine_threshold = -4.0;
+
+        /// @brief lower the order of elements with an indicator below this
+        T coarsen_threshold = -8.0;
+
+        /// @brief the minimum order
+        int pmin = 0;
+
+        /// @brief the maximum order
+        int pmax = build_config::FESPACE_BUILD_PN;
+
+        /**
+         * @brief choose the new order of each element (changing by at most 1)
+         * elements that do not use the Legendre basis on hypercubes keep their order
+         * @param fespace the finite element space
+         * @param indicator the modal decay indicator of each element
+         * @return the order for each element
+         */
+        template<class IDX, int ndim>
+        auto select_orders(const FESpace<T, IDX, ndim>& fespace, std::span<const T> indicator) const
+        -> std::vector<int> {
+            std::vector<int> orders(fespace.elements.size());
+            for(IDX ibatch = 0; ibatch < fespace.element_batches.nrow(); ++ibatch){
+                int order = fespace.element_batch_keys[ibatch].basis_order;
+                bool adapt = impl::is_hierarchical(fespace, ibatch);
+                for(IDX iel : fespace.element_batches.rowspan(ibatch)){
+                    int new_order = order;
+                    if(adapt && indicator[iel] > refine_threshold) new_order = order + 1;
+                    else if(adapt && indicator[iel] < coarsen_threshold) new_order = order - 1;
+                    orders[iel] = (adapt) ? std::clamp(new_order, pmin, pmax) : order;
+                }
+            }
+            return orders;
+        }
+    };
+
+    /**
+     * @brief change the element orders of a Legendre space and transfer the solution
+     *
+     * The Legendre basis is hierarchical so the solution is transferred by truncation (lower order)
+     * or extension with zero high order modes (higher order) of the coefficients of each element.
+     * Refinement is exact and coarsening is the L2 projection on affine elements.
+     *
+     * @param fespace the finite element space (modified with FESpace::set_element_orders)
+     * @param el_orders the new order of each element
+     * @param u_data the solution data in the fe_layout_right of the dg_map, resized for the new space
+     * @tparam neq the number of vector components
+     */
+    template<int neq, class T, class IDX, int ndim, class DataT>
+    auto p_adapt(
+        FESpace<T, IDX, ndim>& fespace,
+        std::span<const int> el_orders,
+        DataT& u_data
+    ) -> void {
+        std::vector<int> old_orders(fespace.elements.size());
+        for(IDX iel = 0; iel < fespace.elements.size(); ++iel)
+            old_orders[iel] = fespace.elements[iel].basis->getPolynomialOrder();
+        if(std::ranges::equal(old_orders, el_orders)) return;
+
+        dg_dof_map<IDX> old_map = fespace.dg_map;
+        std::vector<T> old_data(u_data.begin(), u_data.end());
+        fespan u_old{old_data.data(), fe_layout_right{old_map, tmp::to_size<neq>{}}};
+
+        fespace.set_element_orders(el_orders);
+
+        fe_layout_right new_layout{fespace.dg_map, tmp::to_size<neq>{}};
+        u_data.resize(new_layout.size());
+        fespan u_new{u_data.data(), new_layout};
+        util::parallel_for(fespace.elements.size(), [&](std::size_t iel){
+            int pold = old_orders[iel], pnew = el_orders[iel];
+            if(pold == pnew){
+                for(std::size_t idof = 0; idof < u_new.ndof(iel); ++idof){
+                    for(int iv = 0; iv < neq; ++iv) u_new[iel, idof, iv] = u_old[iel, idof, iv];
+                }
+                return;
+            }
+            for(std::size_t idof = 0; idof < u_new.ndof(iel); ++idof){
+                for(int iv = 0; iv < neq; ++iv) u_new[iel, idof, iv] = 0.0;
+            }
+            for(std::size_t idof = 0; idof < u_old.ndof(iel); ++idof){
+                int ijk[ndim];
+                impl::tensor_mode_ijk((int) idof, pold + 1, ijk);
+                if(std::ranges::max(ijk) > pnew) continue;
+                int jdof = impl::tensor_mode_index(ijk, pnew + 1);
+                for(int iv = 0; iv < neq; ++iv) u_new[iel, jdof, iv] = u_old[iel, idof, iv];
+            }
+        });
+    }
+}
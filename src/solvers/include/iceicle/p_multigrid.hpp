@@ -0,0 +1,455 @@
+/**
+ * @brief p-multigrid (full approximation scheme) for steady problems
+ * with the hierarchical Legendre basis
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+
+#include "Numtool/tmp_flow_control.hpp"
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/build_config.hpp"
+#include "iceicle/element_gauss_seidel.hpp"
+#include "iceicle/element_linear_solve.hpp"
+#include "iceicle/explicit_utils.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fe_function/layout_right.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/form_residual.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/nonlinear_solver_utils.hpp"
+#include "iceicle/residual_workspace.hpp"
+#include "iceicle/thread_utils.hpp"
+#include "iceicle/tmp_utils.hpp"
+#ifdef ICEICLE_USE_PETSC
+#include "iceicle/element_block_jacobi.hpp"
+#endif
+#ifdef ICEICLE_USE_MPI
+#include "iceicle/mpi_type.hpp"
+#include <mpi.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+namespace iceicle::solvers {
+
+    /// @brief the smoother applied on each level of PMultigrid
+    enum class PMG_SMOOTHER {
+        RK3,               /// @brief SSP RK3 pseudo-time steps with local timesteps
+        BLOCK_JACOBI,      /// @brief damped element block Jacobi (requires PETSc)
+        BLOCK_GAUSS_SEIDEL /// @brief nonlinear element block Gauss-Seidel sweeps (see ElementGaussSeidel)
+    };
+
+    /**
+     * @brief p-multigrid with the full approximation scheme (FAS) for steady problems res(u) = 0
+     *
+     * The levels share the mesh and use the orders P, P-1, ..., pmin, each with its own FESpace.
+     * The tensor product Legendre basis is hierarchical so the basis of order p - 1 is a subset
+     * of the basis of order p:
+     *  - the restriction of the residual (the transpose of the prolongation) is truncation of the modes
+     *  - the restriction of the solution is truncation of the modes
+     *    (this is the L2 projection on affine elements because the basis is orthogonal)
+     *  - the prolongation of the correction is injection into the low order modes
+     *
+     * One V-cycle on level l with forcing f_l (f_0 = 0):
+     *  1. smooth res_l(u_l) = f_l
+     *  2. u_{l+1} = I u_l and f_{l+1} = res_{l+1}(I u_l) + R (f_l - res_l(u_l))
+     *  3. cycle level l + 1 (the coarsest level is only smoothed, with ncoarse iterations)
+     *  4. u_l += P (u_{l+1} - I u_l)
+     *  5. smooth res_l(u_l) = f_l
+     *
+     * NOTE: the finest space must use the Legendre basis on hypercube elements with a uniform order
+     *
+     * @tparam T the floating point type
+     * @tparam IDX the index type
+     * @tparam ndim the number of dimensions
+     * @tparam disc_class the discretization
+     */
+    template<class T, class IDX, int ndim, class disc_class>
+    class PMultigrid {
+        public:
+
+        /// @brief the number of vector components
+        static constexpr int neq = disc_class::nv_comp;
+
+        private:
+
+        /// @brief the storage and operators of one order
+        struct level {
+            /// @brief the space of the coarse levels (the finest level is given by the user)
+            std::unique_ptr<FESpace<T, IDX, ndim>> owned_space;
+
+            /// @brief the finite element space of this level
+            FESpace<T, IDX, ndim>* fespace;
+
+            /// @brief the polynomial order of this level
+            int order;
+
+            /// @brief the solution, residual, and forcing
+            std::vector<T> u_data, res_data, forcing_data;
+
+            /// @brief the restricted solution I u_{l-1} (to form the correction)
+            std::vector<T> u_restricted_data;
+
+            /// @brief the smoother storage
+            std::vector<T> stage_data, work_data;
+
+            /// @brief for each local dof of this level, the local dof of the same mode on the next finer level
+            std::vector<IDX> fine_dof;
+
+            /// @brief the cached inverse mass matrices
+            InverseMassOperator<T, IDX> inv_mass;
+
+            /// @brief persistent storage for residual evaluation
+            ResidualWorkspace<T, IDX> workspace;
+
+#ifdef ICEICLE_USE_PETSC
+            /// @brief the element block jacobi smoother
+            ElementBlockJacobi<T, IDX> block_jacobi;
+#endif
+
+            /// @brief the element block gauss-seidel smoother
+            ElementGaussSeidel<T, IDX> gauss_seidel;
+
+            level(FESpace<T, IDX, ndim>* fespace, std::unique_ptr<FESpace<T, IDX, ndim>> owned_space, int order)
+            : owned_space{std::move(owned_space)}, fespace{fespace}, order{order},
+              inv_mass{*fespace}, workspace{*fespace, disc_class::dnv_comp}
+            {
+                std::size_t n = layout().size();
+                u_data.resize(n);
+                res_data.resize(n);
+                forcing_data.resize(n);
+                u_restricted_data.resize(n);
+                stage_data.resize(n);
+                work_data.resize(n);
+            }
+
+            auto layout() const { return fe_layout_right{fespace->dg_map, tmp::to_size<neq>{}}; }
+
+            auto u() { return fespan{u_data.data(), layout()}; }
+            auto res() { return fespan{res_data.data(), layout()}; }
+            auto forcing() { return fespan{forcing_data.data(), layout()}; }
+            auto u_restricted() { return fespan{u_restricted_data.data(), layout()}; }
+            auto stage() { return fespan{stage_data.data(), layout()}; }
+            auto work() { return fespan{work_data.data(), layout()}; }
+        };
+
+        /// @brief the levels from finest to coarsest
+        std::vector<std::unique_ptr<level>> levels{};
+
+        /// @brief the discretization
+        disc_class& disc;
+
+        public:
+
+        /// @brief the convergence criteria on the finest residual norm (kmax is the maximum number of cycles)
+        ConvergenceCriteria<T, IDX> conv_criteria;
+
+        /// @brief the smoother on every level
+        PMG_SMOOTHER smoother = PMG_SMOOTHER::RK3;
+
+        /// @brief the number of pre-smoothing iterations
+        IDX nu1 = 2;
+
+        /// @brief the number of post-smoothing iterations
+        IDX nu2 = 2;
+
+        /// @brief the number of smoothing iterations on the coarsest level
+        IDX ncoarse = 20;
+
+        /// @brief the cfl number of the local timesteps of the RK3 smoother
+        T cfl = 0.5;
+
+        /// @brief the damping of the block jacobi smoother
+        T omega = 0.7;
+
+        /// @brief the element ordering of the gauss-seidel smoother
+        SWEEP_ORDERING sweep_ordering = SWEEP_ORDERING::MORTON;
+
+        /// @brief the direction of the lines for SWEEP_ORDERING::LINES (i.e the flow direction)
+        NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T, ndim> sweep_direction{};
+
+        /// @brief each gauss-seidel smoothing iteration is a forward and a backward sweep
+        bool symmetric_sweeps = true;
+
+        /// @brief the residual norm of the finest level after the last cycle
+        T res_norm = 0.0;
+
+        /// @brief if this is a positive integer then the vis_callback
+        /// will be called every ivis cycles
+        IDX ivis = -1;
+
+        /// @brief the callback function for visualization during solve()
+        /// is given a reference to this and the cycle number
+        std::function<void(PMultigrid&, IDX)> vis_callback = [](PMultigrid& pmg, IDX k){
+            std::cout << std::setprecision(8);
+            std::cout << "cycle: " << std::setw(6) << k
+                << " | residual l2: " << std::setw(14) << pmg.res_norm << std::endl;
+        };
+
+        /**
+         * @brief create the levels of the multigrid
+         * @param fespace the finest space (Legendre basis)
+         * @param disc the discretization
+         * @param conv_criteria the convergence criteria
+         * @param pmin the order of the coarsest level
+         */
+        PMultigrid(
+            FESpace<T, IDX, ndim>& fespace,
+            disc_class& disc,
+            const ConvergenceCriteria<T, IDX>& conv_criteria,
+            int pmin = 0
+        ) : disc{disc}, conv_criteria{conv_criteria} {
+            using namespace util;
+
+            // the hierarchy requires the same Legendre tensor product basis on every element
+            int pfine = fespace.element_batch_keys.empty() ? 0 : fespace.element_batch_keys[0].basis_order;
+            FESPACE_ENUMS::FESPACE_QUADRATURE qtype = fespace.element_batch_keys.empty()
+                ? FESPACE_ENUMS::GAUSS_LEGENDRE : fespace.element_batch_keys[0].qtype;
+            bool hierarchical = true;
+            for(const auto& key : fespace.element_batch_keys){
+                hierarchical = hierarchical && key.btype == FESPACE_ENUMS::LEGENDRE
+                    && key.domain_type == DOMAIN_TYPE::HYPERCUBE && key.basis_order == pfine;
+            }
+            if(!hierarchical) {
+                AnomalyLog::log_anomaly(Anomaly{"p-multigrid requires a uniform order Legendre basis on hypercube elements",
+                        general_anomaly_tag{}});
+                pmin = pfine;
+            }
+            pmin = std::clamp(pmin, 0, pfine);
+
+            levels.push_back(std::make_unique<level>(&fespace, nullptr, pfine));
+            for(int p = pfine - 1; p >= pmin; --p){
+                std::unique_ptr<FESpace<T, IDX, ndim>> coarse_space = NUMTOOL::TMP::invoke_at_index(
+                    NUMTOOL::TMP::make_range_sequence<int, 0, build_config::FESPACE_BUILD_PN>{}, p,
+                    [&]<int order>{
+                        return std::unique_ptr<FESpace<T, IDX, ndim>>{new FESpace<T, IDX, ndim>{
+                            fespace.meshptr, FESPACE_ENUMS::LEGENDRE, qtype, std::integral_constant<int, order>{}}};
+                    });
+                FESpace<T, IDX, ndim>* coarse_ptr = coarse_space.get();
+                levels.push_back(std::make_unique<level>(coarse_ptr, std::move(coarse_space), p));
+
+                // the modes are numbered with the first dimension slowest (see QTypeProduct)
+                level& coarse = *levels.back();
+                int nb_coarse = p + 1, nb_fine = p + 2;
+                int ndof_coarse = 1;
+                for(int idim = 0; idim < ndim; ++idim) ndof_coarse *= nb_coarse;
+                coarse.fine_dof.resize(ndof_coarse);
+                for(int idof = 0; idof < ndof_coarse; ++idof){
+                    int ijk[ndim];
+                    int rem = idof;
+                    for(int idim = ndim - 1; idim >= 0; --idim){
+                        ijk[idim] = rem % nb_coarse;
+                        rem /= nb_coarse;
+                    }
+                    IDX fine_idof = 0;
+                    for(int idim = 0; idim < ndim; ++idim) fine_idof = fine_idof * nb_fine + ijk[idim];
+                    coarse.fine_dof[idof] = fine_idof;
+                }
+            }
+        }
+
+        /// @brief the number of levels
+        [[nodiscard]] auto nlevel() const noexcept -> std::size_t { return levels.size(); }
+
+        /// @brief the polynomial order of a level (0 is the finest)
+        [[nodiscard]] auto level_order(std::size_t ilevel) const noexcept -> int { return levels[ilevel]->order; }
+
+        /**
+         * @brief coarse = truncation of the modes of fine
+         * @param icoarse the coarse level (> 0), fine_data is on level icoarse - 1
+         * @param fine_data the data on the finer level
+         * @param [out] coarse_data the data on the coarse level
+         */
+        template<class fineSpan, class coarseSpan>
+        auto restrict_modes(std::size_t icoarse, fineSpan fine_data, coarseSpan coarse_data) const -> void {
+            const level& coarse = *levels[icoarse];
+            util::parallel_for(coarse.fespace->elements.size(), [&](std::size_t iel){
+                for(std::size_t idof = 0; idof < coarse.fine_dof.size(); ++idof){
+                    for(int iv = 0; iv < neq; ++iv)
+                        { coarse_data[iel, idof, iv] = fine_data[iel, coarse.fine_dof[idof], iv]; }
+                }
+            });
+        }
+
+        /**
+         * @brief fine += injection of coarse into the low order modes
+         * @param icoarse the coarse level (> 0), fine_data is on level icoarse - 1
+         * @param coarse_data the data on the coarse level
+         * @param [in/out] fine_data the data on the finer level
+         */
+        template<class coarseSpan, class fineSpan>
+        auto prolong_add(std::size_t icoarse, coarseSpan coarse_data, fineSpan fine_data) const -> void {
+            const level& coarse = *levels[icoarse];
+            util::parallel_for(coarse.fespace->elements.size(), [&](std::size_t iel){
+                for(std::size_t idof = 0; idof < coarse.fine_dof.size(); ++idof){
+                    for(int iv = 0; iv < neq; ++iv)
+                        { fine_data[iel, coarse.fine_dof[idof], iv] += coarse_data[iel, idof, iv]; }
+                }
+            });
+        }
+
+        /// @brief the finite element space of a level (0 is the finest)
+        [[nodiscard]] auto level_space(std::size_t ilevel) const noexcept -> FESpace<T, IDX, ndim>&
+        { return *levels[ilevel]->fespace; }
+
+        /**
+         * @brief perform V-cycles until convergence
+         * @param [in/out] u the solution on the finest space
+         * @return the number of cycles performed
+         */
+        template<class LayoutPolicy>
+        auto solve(fespan<T, LayoutPolicy> u) -> IDX {
+            level& fine = *levels[0];
+            copy_fespan(u, fine.u());
+            std::ranges::fill(fine.forcing_data, 0.0);
+
+            res_norm = residual_norm(fine);
+            conv_criteria.r0 = res_norm;
+            vis_callback(*this, 0);
+
+            IDX k;
+            for(k = 0; k < conv_criteria.kmax; ++k){
+                vcycle(0);
+                res_norm = residual_norm(fine);
+
+                if(ivis > 0 && (k + 1) % ivis == 0) {
+                    copy_fespan(fine.u(), u);
+                    vis_callback(*this, k + 1);
+                }
+                if(conv_criteria.done_callback(res_norm) || !std::isfinite(res_norm)) {
+                    ++k;
+                    break;
+                }
+            }
+            copy_fespan(fine.u(), u);
+            return k;
+        }
+
+        private:
+
+        /// @brief res = res(u) - forcing on a level
+        auto defect(level& lev) -> void {
+            auto res = lev.res();
+            form_residual(*lev.fespace, disc, lev.u(), res, lev.workspace);
+            axpy(-1.0, lev.forcing(), res);
+        }
+
+        /// @brief the global l2 norm of res(u) - forcing on a level
+        auto residual_norm(level& lev) -> T {
+            auto res = lev.res();
+            form_residual(*lev.fespace, disc, lev.u(), res, lev.workspace);
+
+            // subtract the forcing and take the norm in one pass
+            std::array<T, 1> sum{axpby_and_norm_sq(-1.0, lev.forcing(), 1.0, res)};
+            return std::sqrt(mpi::allreduce_sums(sum)[0]);
+        }
+
+        /// @brief smooth res(u) = forcing on a level
+        auto smooth(level& lev, IDX niter) -> void {
+            if(niter <= 0) return;
+            auto u = lev.u();
+            auto res = lev.res();
+            auto work = lev.work();
+            if(smoother == PMG_SMOOTHER::BLOCK_JACOBI){
+#ifdef ICEICLE_USE_PETSC
+                // u -= omega D^{-1} (res(u) - f) with D the element diagonal blocks of dres/du
+                lev.block_jacobi.build(*lev.fespace, disc, u);
+                for(IDX iter = 0; iter < niter; ++iter){
+                    defect(lev);
+                    lev.block_jacobi.apply(res, work);
+                    axpy(-omega, work, u);
+                }
+#else
+                util::AnomalyLog::log_anomaly(util::Anomaly{"the block jacobi p-multigrid smoother requires PETSc",
+                        util::general_anomaly_tag{}});
+#endif
+            } else if(smoother == PMG_SMOOTHER::BLOCK_GAUSS_SEIDEL){
+                // local Newton solves of res_K(u) = f_K with the latest neighbor states
+                ElementGaussSeidel<T, IDX>& gs = lev.gauss_seidel;
+                if(gs.order.size() != lev.fespace->elements.size())
+                    { gs.set_ordering(*lev.fespace, sweep_ordering, sweep_direction); }
+                gs.symmetric = symmetric_sweeps;
+                for(IDX iter = 0; iter < niter; ++iter) gs.sweep(*lev.fespace, disc, u, lev.forcing());
+            } else {
+                // SSP RK3 pseudo-time steps of du/dt = M^{-1} (res(u) - f) with local timesteps
+                auto u0 = lev.stage();
+                lev.inv_mass.update(*lev.fespace);
+                CFLTimestep<T, IDX> timestep{cfl};
+                std::vector<T> dt{};
+
+                // u = a u0 + b (u + dt M^{-1} (res(u) - f))
+                auto rk_stage = [&](T a, T b){
+                    defect(lev);
+                    if(dt.empty()) dt = timestep.local_timesteps(*lev.fespace, disc, u);
+                    lev.inv_mass.apply(1.0, res, 0.0, work);
+                    util::parallel_for(lev.fespace->elements.size(), [&](std::size_t iel){
+                        for(std::size_t idof = 0; idof < u.ndof(iel); ++idof){
+                            for(int iv = 0; iv < neq; ++iv){
+                                u[iel, idof, iv] = a * u0[iel, idof, iv]
+                                    + b * (u[iel, idof, iv] + dt[iel] * work[iel, idof, iv]);
+                            }
+                        }
+                    });
+                };
+                for(IDX iter = 0; iter < niter; ++iter){
+                    copy_fespan(u, u0);
+                    dt.clear();
+                    rk_stage(0.0, 1.0);
+                    rk_stage(0.75, 0.25);
+                    rk_stage(1.0 / 3.0, 2.0 / 3.0);
+                }
+            }
+        }
+
+        /// @brief one FAS V-cycle starting at the given level
+        auto vcycle(std::size_t ilevel) -> void {
+            level& lev = *levels[ilevel];
+            if(ilevel == levels.size() - 1){
+                smooth(lev, ncoarse);
+                return;
+            }
+            smooth(lev, nu1);
+
+            // fine defect f - res(u)
+            level& coarse = *levels[ilevel + 1];
+            defect(lev);
+            auto res = lev.res();
+
+            // coarse problem res_c(u_c) = res_c(I u) + R (f - res(u))
+            restrict_modes(ilevel + 1, lev.u(), coarse.u());
+            copy_fespan(coarse.u(), coarse.u_restricted());
+            auto coarse_forcing = coarse.forcing();
+            restrict_modes(ilevel + 1, res, coarse_forcing);
+            {
+                auto coarse_res = coarse.res();
+                form_residual(*coarse.fespace, disc, coarse.u(), coarse_res, coarse.workspace);
+                // forcing = res_c(I u) - R (res(u) - f)
+                for(std::size_t i = 0; i < coarse.forcing_data.size(); ++i)
+                    { coarse.forcing_data[i] = coarse.res_data[i] - coarse.forcing_data[i]; }
+            }
+
+            vcycle(ilevel + 1);
+
+            // correction u += P (u_c - I u)
+            axpy(-1.0, coarse.u_restricted(), coarse.u());
+            prolong_add(ilevel + 1, coarse.u(), lev.u());
+
+            smooth(lev, nu2);
+        }
+    };
+
+    // template argument deduction
+    template<class T, class IDX, int ndim, class disc_class>
+    PMultigrid(FESpace<T, IDX, ndim>&, disc_class&, const ConvergenceCriteria<T, IDX>&, int)
+        -> PMultigrid<T, IDX, ndim, disc_class>;
+
+    template<class T, class IDX, int ndim, class disc_class>
+    PMultigrid(FESpace<T, IDX, ndim>&, disc_class&, const ConvergenceCriteria<T, IDX>&)
+        -> PMultigrid<T, IDX, ndim, disc_class>;
+}
@@ -0,0 +1,243 @@
+/**
+ * @brief Parareal time parallel driver over explicit integrators
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/explicit_utils.hpp"
+#include "iceicle/form_residual.hpp"
+#ifdef ICEICLE_USE_MPI
+#include "iceicle/mpi_type.hpp"
+#include <mpi.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+namespace iceicle::solvers {
+
+/**
+ * @brief Parareal (Lions, Maday, and Turinici 2001) over the time interval [t0, tfinal]
+ * split into nslice equal time slices
+ *
+ * With the coarse propagator G (cheap, i.e explicit euler with a large timestep)
+ * and the fine propagator F (the production integrator) over one slice
+ * the slice initial conditions are iterated as
+ *
+ *    U_{n+1}^{k+1} = G(U_n^{k+1}) + F(U_n^k) - G(U_n^k)
+ *
+ * The fine propagations of an iteration are independent and are distributed over the ranks of time_comm
+ * (slice n is propagated by rank n % nrank).
+ * The coarse sweeps are sequential and are performed by every rank.
+ * After k iterations the first k slices are exactly the fine solution
+ * so at most nslice iterations are needed.
+ *
+ * NOTE: every rank of time_comm must hold the full (non partitioned) spatial problem:
+ * the halo exchange of the residual is on MPI_COMM_WORLD so the mesh cannot also be partitioned in space.
+ * The propagators agree on the timestep only within MPI_COMM_SELF (see set_comm).
+ *
+ * @tparam T the floating point type
+ * @tparam IDX the index type
+ * @tparam CoarseSolver the coarse explicit solver
+ * @tparam FineSolver the fine explicit solver
+ * both solvers provide step(fespace, disc, u), itime, time, res_data, and workspace
+ * and use the TfinalTermination stop condition
+ */
+template<class T, class IDX, class CoarseSolver, class FineSolver>
+class Parareal {
+
+public:
+
+    /// @brief the coarse propagator
+    CoarseSolver& coarse;
+
+    /// @brief the fine propagator
+    FineSolver& fine;
+
+    /// @brief the start time
+    T t0 = 0.0;
+
+    /// @brief the final time
+    T tfinal;
+
+    /// @brief the number of time slices
+    IDX nslice;
+
+    /// @brief the maximum number of parareal iterations (capped at nslice)
+    IDX kmax;
+
+    /// @brief stop when the relative change of the slice initial conditions is below this
+    T tol = 0.0;
+
+    /// @brief the current parareal iteration
+    IDX iteration = 0;
+
+    /// @brief the maximum over the slices of the relative change of the slice initial conditions
+    /// in the last iteration
+    T defect = 0.0;
+
+#ifdef ICEICLE_USE_MPI
+    /// @brief the communicator to distribute the time slices over
+    MPI_Comm time_comm = MPI_COMM_WORLD;
+#endif
+
+    /// @brief the callback function for visualization after each iteration
+    /// is given a reference to this when called
+    std::function<void(Parareal &)> vis_callback = [](Parareal &parareal){
+        std::cout << std::setprecision(8);
+        std::cout << "parareal iteration: " << std::setw(4) << parareal.iteration
+            << " | defect: " << std::setw(14) << parareal.defect
+            << std::endl;
+    };
+
+    /**
+     * @param coarse the coarse propagator
+     * @param fine the fine propagator
+     * @param tfinal the final time
+     * @param nslice the number of time slices
+     * @param kmax the maximum number of parareal iterations
+     */
+    Parareal(CoarseSolver& coarse, FineSolver& fine, T tfinal, IDX nslice, IDX kmax)
+    : coarse{coarse}, fine{fine}, tfinal{tfinal}, nslice{std::max(nslice, (IDX) 1)}, kmax{kmax}
+    {
+        set_comm(coarse);
+        set_comm(fine);
+    }
+
+    /**
+     * @brief perform the parareal iterations
+     * @param [in] fespace the finite element space
+     * @param [in] disc the discretization
+     * @param [in/out] u the initial condition at t0, overwritten with the solution at tfinal
+     */
+    template<int ndim, class disc_class, class LayoutPolicy>
+    void solve(FESpace<T, IDX, ndim> &fespace, disc_class &disc, fespan<T, LayoutPolicy> u) {
+        int myrank = 0, nrank = 1;
+#ifdef ICEICLE_USE_MPI
+        MPI_Comm_rank(time_comm, &myrank);
+        MPI_Comm_size(time_comm, &nrank);
+#endif
+        std::size_t n = u.size();
+
+        // the slice initial conditions, the coarse propagations of the last iteration,
+        // and the fine propagations
+        std::vector<std::vector<T>> U(nslice + 1, std::vector<T>(n));
+        std::vector<std::vector<T>> G_old(nslice + 1, std::vector<T>(n));
+        std::vector<std::vector<T>> F(nslice + 1, std::vector<T>(n));
+        std::vector<T> G_new(n);
+        std::copy_n(u.data(), n, U[0].begin());
+
+        // initial coarse sweep
+        for(IDX islice = 0; islice < nslice; ++islice){
+            propagate(coarse, fespace, disc, islice, U[islice], G_old[islice + 1], u);
+            U[islice + 1] = G_old[islice + 1];
+        }
+
+        IDX niter = std::min(kmax, nslice);
+        for(iteration = 1; iteration <= niter; ++iteration){
+            // the first iteration - 1 slices are converged
+            IDX first = iteration - 1;
+
+            // fine propagations in parallel
+            for(IDX islice = first; islice < nslice; ++islice){
+                if(islice % nrank == myrank)
+                    propagate(fine, fespace, disc, islice, U[islice], F[islice + 1], u);
+            }
+#ifdef ICEICLE_USE_MPI
+            for(IDX islice = first; islice < nslice; ++islice){
+                MPI_Bcast(F[islice + 1].data(), n, mpi_get_type<T>(), islice % nrank, time_comm);
+            }
+#endif
+
+            // sequential coarse correction
+            // U[first + 1] is the fine solution of a converged initial condition
+            defect = 0.0;
+            for(IDX islice = first; islice < nslice; ++islice){
+                propagate(coarse, fespace, disc, islice, U[islice], G_new, u);
+                T diff = 0.0, norm = 0.0;
+                for(std::size_t i = 0; i < n; ++i){
+                    T unew = G_new[i] + F[islice + 1][i] - G_old[islice + 1][i];
+                    diff += (unew - U[islice + 1][i]) * (unew - U[islice + 1][i]);
+                    norm += unew * unew;
+                    U[islice + 1][i] = unew;
+                }
+                std::swap(G_old[islice + 1], G_new);
+                defect = std::max(defect, std::sqrt(diff / std::max(norm, std::numeric_limits<T>::min())));
+            }
+
+            if(myrank == 0) vis_callback(*this);
+            if(defect <= tol) break;
+        }
+        iteration = std::min(iteration, niter);
+
+        std::copy_n(U[nslice].begin(), n, u.data());
+        fine.time = tfinal;
+    }
+
+private:
+
+    /// @brief the start time of a slice
+    auto slice_start(IDX islice) const -> T
+    { return (islice == 0) ? t0 : t0 + (tfinal - t0) * islice / nslice; }
+
+    /// @brief the end time of a slice
+    auto slice_end(IDX islice) const -> T
+    { return (islice == nslice - 1) ? tfinal : t0 + (tfinal - t0) * (islice + 1) / nslice; }
+
+    /// @brief use the solver on each rank independently:
+    /// the timestep and the residual norms are reduced within MPI_COMM_SELF
+    /// (each rank propagates a different number of slices so collectives over time_comm would not match)
+    /// a solver without a comm member must not communicate (i.e ExplicitEuler)
+    template<class SolverT>
+    static auto set_comm(SolverT& solver) -> void {
+#ifdef ICEICLE_USE_MPI
+        if constexpr (requires { solver.comm = MPI_COMM_SELF; }) solver.comm = MPI_COMM_SELF;
+        if constexpr (requires { solver.workspace.monitor.comm = MPI_COMM_SELF; })
+            solver.workspace.monitor.comm = MPI_COMM_SELF;
+#endif
+    }
+
+    /**
+     * @brief propagate the initial condition of a slice over the slice with the given solver
+     * @param solver the propagator
+     * @param islice the slice index
+     * @param u_start the initial condition of the slice
+     * @param [out] u_end the solution at the end of the slice
+     * @param u_layout a view that provides the layout
+     */
+    template<class SolverT, int ndim, class disc_class, class LayoutPolicy>
+    auto propagate(SolverT& solver, FESpace<T, IDX, ndim> &fespace, disc_class &disc, IDX islice,
+            const std::vector<T>& u_start, std::vector<T>& u_end, fespan<T, LayoutPolicy> u_layout) -> void {
+        u_end = u_start;
+        fespan u_slice{u_end.data(), u_layout.get_layout()};
+        solver.itime = 0;
+        solver.time = slice_start(islice);
+        solver.stop_condition.tfinal = slice_end(islice);
+
+        // call initial residual to get initial wavespeeds for dt
+        // with the persistent workspace of the solver:
+        // constructing a workspace may be collective (see ResidualWorkspace) and only some ranks propagate a slice
+        {
+            fespan res{solver.res_data.data(), u_layout.get_layout()};
+            form_residual(fespace, disc, u_slice, res, solver.workspace);
+        }
+        while(!solver.stop_condition(solver.itime, solver.time))
+            solver.step(fespace, disc, u_slice);
+    }
+};
+
+// template argument deduction
+template<class CoarseSolver, class FineSolver, class T, class IDX>
+Parareal(CoarseSolver&, FineSolver&, T, IDX, IDX) -> Parareal<
+    std::remove_cvref_t<decltype(std::declval<FineSolver&>().time)>,
+    std::remove_cvref_t<decltype(std::declval<FineSolver&>().itime)>, CoarseSolver, FineSolver>;
+
+}
@@ -0,0 +1,473 @@
+/**
+ * @brief conversion between the iceicle mesh and the petsc DMPlex
+ * so the DM based petsc tools (DMPlexDistribute, PCFIELDSPLIT and PCPATCH from the DM, parallel DM I/O)
+ * can be used with iceicle meshes and distributed petsc meshes can be solved with iceicle
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/fe_definitions.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/geometry/face.hpp"
+#include "iceicle/geometry/transformations_table.hpp"
+#include "iceicle/mesh/mesh.hpp"
+#include "iceicle/mesh/mesh_partition.hpp"
+#include <mpi.h>
+#include <petscdmlabel.h>
+#include <petscdmplex.h>
+#include <petscerror.h>
+#include <petscsf.h>
+#include <algorithm>
+#include <array>
+#include <map>
+#include <span>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace iceicle::petsc {
+
+    /// @brief the DMPlex label of the boundary condition flag (bcflag) of the boundary faces
+    /// (the label used by the petsc mesh readers for the boundary markers)
+    inline constexpr const char* face_sets_label_name = "Face Sets";
+
+    /// @brief the DMPlex label of the iceicle boundary condition type (BOUNDARY_CONDITIONS) of the boundary faces
+    inline constexpr const char* bctype_label_name = "iceicle BC type";
+
+    namespace impl {
+
+        /// @brief the corners of the reference hypercube in the petsc vertex order
+        /// as the index (0 or 1) in each dimension
+        template<int ndim>
+        constexpr auto dmplex_hypercube_corners() -> std::array<std::array<int, ndim>, (1 << ndim)> {
+            if constexpr (ndim == 1) {
+                return {{ {0}, {1} }};
+            } else if constexpr (ndim == 2) {
+                return {{ {0, 0}, {1, 0}, {1, 1}, {0, 1} }};
+            } else {
+                return {{ {0, 0, 0}, {0, 1, 0}, {1, 1, 0}, {1, 0, 0},
+                          {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1} }};
+            }
+        }
+
+        /// @brief the index of a corner of a hypercube with (order + 1)^ndim tensor product nodes
+        /// (the last dimension is fastest)
+        template<int ndim>
+        constexpr auto hypercube_corner_node(const std::array<int, ndim>& corner, int order) -> int {
+            int inode = 0;
+            for(int idim = 0; idim < ndim; ++idim) inode = inode * (order + 1) + corner[idim] * order;
+            return inode;
+        }
+
+        /// @brief swap the last two vertices of a triangle if needed so they are counterclockwise (as in petsc)
+        template<class T, class IDX>
+        auto orient_triangle(const NodeArray<T, 2>& coord, std::vector<IDX>& vertices) -> void {
+            const auto& x0 = coord[vertices[0]];
+            const auto& x1 = coord[vertices[1]];
+            const auto& x2 = coord[vertices[2]];
+            T area = (x1[0] - x0[0]) * (x2[1] - x0[1]) - (x2[0] - x0[0]) * (x1[1] - x0[1]);
+            if(area < 0) std::swap(vertices[1], vertices[2]);
+        }
+
+        /**
+         * @brief the element nodes at the vertices of an element in the petsc vertex order
+         * @param mesh the mesh
+         * @param iel the element index
+         * @return the node indices, empty if the element type has no DMPlex equivalent
+         */
+        template<class T, class IDX, int ndim>
+        auto dmplex_cell_vertices(AbstractMesh<T, IDX, ndim>& mesh, IDX iel) -> std::vector<IDX> {
+            ElementTransformation<T, IDX, ndim>* trans = mesh.el_transformations[iel];
+            std::span<IDX> el_nodes = mesh.get_el_nodes(iel);
+            std::vector<IDX> vertices{};
+            if(trans->domain_type == DOMAIN_TYPE::HYPERCUBE) {
+                for(const std::array<int, ndim>& corner : dmplex_hypercube_corners<ndim>())
+                    { vertices.push_back(el_nodes[hypercube_corner_node<ndim>(corner, trans->order)]); }
+            } else if constexpr (ndim == 2) {
+                if(trans->domain_type == DOMAIN_TYPE::SIMPLEX && trans->order == 1) {
+                    vertices.assign(el_nodes.begin(), el_nodes.begin() + 3);
+                    orient_triangle(mesh.coord, vertices);
+                }
+            }
+            return vertices;
+        }
+    }
+
+    /**
+     * @brief create a DMPlex with the topology of the mesh
+     *
+     * Each process contributes its own elements (the process local elements of a partitioned mesh,
+     * or all the elements of an unpartitioned mesh from rank 0)
+     * so the DMPlex has the same distribution as the mesh and cell c on a process is element c of the mesh.
+     * The DMPlex vertices are the element vertices (the high order nodes are not part of the DMPlex)
+     * with the global numbering of the nodes of the mesh this was partitioned from.
+     * The coordinates are moved to the process that owns each vertex with a star forest
+     * so no process needs the global mesh.
+     *
+     * The boundary faces are labeled with their bcflag (face_sets_label_name)
+     * and boundary condition type (bctype_label_name)
+     *
+     * NOTE: every element must have the same type (hypercube of any geometry order, or linear triangles)
+     * NOTE: the periodic faces are not connected in the DMPlex
+     *
+     * @param mesh the mesh
+     * @param comm the communicator for the DMPlex
+     * @return the interpolated DMPlex (the caller destroys it with DMDestroy)
+     */
+    template<class T, class IDX, int ndim>
+    auto dmplex_from_mesh(AbstractMesh<T, IDX, ndim>& mesh, MPI_Comm comm = PETSC_COMM_WORLD) -> DM {
+        int myrank, nrank;
+        MPI_Comm_rank(comm, &myrank);
+        MPI_Comm_size(comm, &nrank);
+
+        // an unpartitioned mesh is only contributed from rank 0
+        const bool contributes = !mesh.gnode_idxs.empty() || myrank == 0;
+        const IDX nelem = (contributes) ? mesh.nelem() : 0;
+        const IDX nnode = (contributes) ? mesh.n_nodes() : 0;
+
+        // === the element vertices in petsc order ===
+        std::vector<std::vector<IDX>> el_vertices(nelem);
+        PetscInt ncorner = 0;
+        bool uniform = true;
+        for(IDX iel = 0; iel < nelem; ++iel){
+            el_vertices[iel] = impl::dmplex_cell_vertices(mesh, iel);
+            if(iel == 0) ncorner = el_vertices[iel].size();
+            uniform = uniform && el_vertices[iel].size() == (std::size_t) ncorner && ncorner > 0;
+        }
+        PetscInt ncorner_global;
+        MPI_Allreduce(&ncorner, &ncorner_global, 1, MPIU_INT, MPI_MAX, comm);
+        uniform = uniform && (nelem == 0 || ncorner == ncorner_global);
+        if(!uniform) util::AnomalyLog::log_anomaly(util::Anomaly{
+            "DMPlex conversion requires every element to be the same hypercube or linear triangle type",
+            util::general_anomaly_tag{}});
+
+        // === number the vertices ===
+        // the leaves are the local nodes, the roots the global nodes distributed in contiguous blocks
+        std::vector<PetscInt> gnode(nnode);
+        PetscInt max_gnode = -1;
+        for(IDX inode = 0; inode < nnode; ++inode){
+            gnode[inode] = (mesh.gnode_idxs.empty()) ? inode : (PetscInt) mesh.gnode_idxs[inode];
+            max_gnode = std::max(max_gnode, gnode[inode]);
+        }
+        PetscInt nnode_global;
+        MPI_Allreduce(&max_gnode, &nnode_global, 1, MPIU_INT, MPI_MAX, comm);
+        nnode_global += 1;
+
+        PetscLayout layout;
+        PetscCallAbort(comm, PetscLayoutCreate(comm, &layout));
+        PetscCallAbort(comm, PetscLayoutSetSize(layout, nnode_global));
+        PetscCallAbort(comm, PetscLayoutSetBlockSize(layout, 1));
+        PetscCallAbort(comm, PetscLayoutSetUp(layout));
+        PetscInt nroot;
+        PetscCallAbort(comm, PetscLayoutGetLocalSize(layout, &nroot));
+
+        PetscSF node_sf;
+        PetscCallAbort(comm, PetscSFCreate(comm, &node_sf));
+        PetscCallAbort(comm, PetscSFSetGraphLayout(node_sf, layout, nnode, nullptr, PETSC_COPY_VALUES, gnode.data()));
+
+        // mark the nodes that are vertices and gather their coordinates on the owning process
+        std::vector<PetscInt> leaf_is_vertex(nnode, 0), root_is_vertex(nroot, 0);
+        for(const std::vector<IDX>& vertices : el_vertices)
+            for(IDX inode : vertices) leaf_is_vertex[inode] = 1;
+        PetscCallAbort(comm, PetscSFReduceBegin(node_sf, MPIU_INT, leaf_is_vertex.data(), root_is_vertex.data(), MPI_MAX));
+        PetscCallAbort(comm, PetscSFReduceEnd(node_sf, MPIU_INT, leaf_is_vertex.data(), root_is_vertex.data(), MPI_MAX));
+
+        std::vector<PetscReal> leaf_coord(nnode * ndim), root_coord(nroot * ndim, 0.0);
+        for(IDX inode = 0; inode < nnode; ++inode){
+            for(int idim = 0; idim < ndim; ++idim) leaf_coord[inode * ndim + idim] = mesh.coord[inode][idim];
+        }
+        MPI_Datatype coord_type;
+        MPI_Type_contiguous(ndim, MPIU_REAL, &coord_type);
+        MPI_Type_commit(&coord_type);
+        PetscCallAbort(comm, PetscSFReduceBegin(node_sf, coord_type, leaf_coord.data(), root_coord.data(), MPI_REPLACE));
+        PetscCallAbort(comm, PetscSFReduceEnd(node_sf, coord_type, leaf_coord.data(), root_coord.data(), MPI_REPLACE));
+        MPI_Type_free(&coord_type);
+
+        // contiguous vertex numbers in the order of the global nodes
+        PetscInt nvert_owned = 0;
+        for(PetscInt iroot = 0; iroot < nroot; ++iroot) nvert_owned += root_is_vertex[iroot];
+        PetscInt vert_offset = 0;
+        MPI_Exscan(&nvert_owned, &vert_offset, 1, MPIU_INT, MPI_SUM, comm);
+        if(myrank == 0) vert_offset = 0;
+
+        std::vector<PetscInt> root_vertex(nroot, -1);
+        std::vector<PetscReal> vertex_coord{};
+        vertex_coord.reserve(nvert_owned * ndim);
+        for(PetscInt iroot = 0, ivert = vert_offset; iroot < nroot; ++iroot){
+            if(root_is_vertex[iroot]){
+                root_vertex[iroot] = ivert++;
+                for(int idim = 0; idim < ndim; ++idim) vertex_coord.push_back(root_coord[iroot * ndim + idim]);
+            }
+        }
+        std::vector<PetscInt> leaf_vertex(nnode, -1);
+        PetscCallAbort(comm, PetscSFBcastBegin(node_sf, MPIU_INT, root_vertex.data(), leaf_vertex.data(), MPI_REPLACE));
+        PetscCallAbort(comm, PetscSFBcastEnd(node_sf, MPIU_INT, root_vertex.data(), leaf_vertex.data(), MPI_REPLACE));
+        PetscCallAbort(comm, PetscSFDestroy(&node_sf));
+        PetscCallAbort(comm, PetscLayoutDestroy(&layout));
+
+        // === build the DMPlex ===
+        std::vector<PetscInt> cells{};
+        cells.reserve(nelem * ncorner_global);
+        if(uniform) {
+            for(const std::vector<IDX>& vertices : el_vertices)
+                for(IDX inode : vertices) cells.push_back(leaf_vertex[inode]);
+        }
+        const PetscInt ncell = cells.size() / std::max(ncorner_global, (PetscInt) 1);
+
+        DM dm;
+        PetscSF vertex_sf;
+        PetscInt* vertices_adj;
+        PetscCallAbort(comm, DMPlexCreateFromCellListParallelPetsc(comm, ndim, ncell, nvert_owned, PETSC_DETERMINE,
+                    ncorner_global, PETSC_TRUE, cells.data(), ndim, vertex_coord.data(), &vertex_sf, &vertices_adj, &dm));
+
+        // === label the boundary faces ===
+        // the local vertex points are in the (sorted) order of the global vertex numbers in vertices_adj
+        PetscInt vstart, vend;
+        PetscCallAbort(comm, DMPlexGetDepthStratum(dm, 0, &vstart, &vend));
+        std::unordered_map<PetscInt, PetscInt> vertex_point{};
+        for(PetscInt v = vstart; v < vend; ++v) vertex_point[vertices_adj[v - vstart]] = v;
+
+        PetscCallAbort(comm, DMCreateLabel(dm, face_sets_label_name));
+        PetscCallAbort(comm, DMCreateLabel(dm, bctype_label_name));
+        for(IDX ifac = (uniform && contributes) ? mesh.bdyFaceStart : 0;
+                uniform && contributes && ifac < mesh.bdyFaceEnd; ++ifac){
+            const Face<T, IDX, ndim>& face = *(mesh.faces[ifac]);
+            if(face.bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) continue;
+            std::vector<PetscInt> points{};
+            for(int inode = 0; inode < face.n_nodes(); ++inode){
+                PetscInt ivert = leaf_vertex[face.nodes()[inode]];
+                if(ivert >= 0) points.push_back(vertex_point[ivert]);
+            }
+            PetscInt face_point = -1;
+            if(points.size() == 1) {
+                face_point = points[0];
+            } else {
+                PetscInt njoin;
+                const PetscInt* join;
+                PetscCallAbort(comm, DMPlexGetFullJoin(dm, points.size(), points.data(), &njoin, &join));
+                if(njoin == 1) face_point = join[0];
+                PetscCallAbort(comm, DMPlexRestoreJoin(dm, points.size(), points.data(), &njoin, &join));
+            }
+            if(face_point >= 0) {
+                PetscCallAbort(comm, DMSetLabelValue(dm, face_sets_label_name, face_point, face.bcflag));
+                PetscCallAbort(comm, DMSetLabelValue(dm, bctype_label_name, face_point, (PetscInt) face.bctype));
+            } else {
+                util::AnomalyLog::log_anomaly(util::Anomaly{"could not find the DMPlex face of a boundary face",
+                        util::general_anomaly_tag{}});
+            }
+        }
+
+        PetscCallAbort(comm, PetscFree(vertices_adj));
+        PetscCallAbort(comm, PetscSFDestroy(&vertex_sf));
+        return dm;
+    }
+
+    /**
+     * @brief set the local section of a DMPlex from dmplex_from_mesh to the dg degrees of freedom of the fespace
+     * one field with neq components and nbasis * neq dofs on each cell
+     *
+     * The component is fastest within each cell the same as fe_layout_right
+     * so the DM global vectors have the same layout as the iceicle dg storage
+     * (i.e VecPlaceArray on a DM vector uses the iceicle data without a copy)
+     * and the components can be split with PCFIELDSPLIT (-pc_fieldsplit_block_size)
+     *
+     * @param dm the DMPlex with the cells in the order of the fespace elements
+     * @param fespace the finite element space
+     * @param neq the number of vector components
+     */
+    template<class T, class IDX, int ndim>
+    auto dmplex_set_dg_section(DM dm, FESpace<T, IDX, ndim>& fespace, PetscInt neq) -> void {
+        MPI_Comm comm;
+        PetscCallAbort(PETSC_COMM_WORLD, PetscObjectGetComm((PetscObject) dm, &comm));
+        PetscInt pstart, pend, cstart, cend;
+        PetscCallAbort(comm, DMPlexGetChart(dm, &pstart, &pend));
+        PetscCallAbort(comm, DMPlexGetHeightStratum(dm, 0, &cstart, &cend));
+        if(cend - cstart != (PetscInt) fespace.elements.size()) util::AnomalyLog::log_anomaly(util::Anomaly{
+                "The DMPlex cells do not match the fespace elements", util::general_anomaly_tag{}});
+
+        PetscSection section;
+        PetscCallAbort(comm, PetscSectionCreate(comm, &section));
+        PetscCallAbort(comm, PetscSectionSetNumFields(section, 1));
+        PetscCallAbort(comm, PetscSectionSetFieldComponents(section, 0, neq));
+        PetscCallAbort(comm, PetscSectionSetChart(section, pstart, pend));
+        for(PetscInt c = cstart; c < cend && c - cstart < (PetscInt) fespace.elements.size(); ++c){
+            PetscInt ndof = fespace.elements[c - cstart].nbasis() * neq;
+            PetscCallAbort(comm, PetscSectionSetDof(section, c, ndof));
+            PetscCallAbort(comm, PetscSectionSetFieldDof(section, c, 0, ndof));
+        }
+        PetscCallAbort(comm, PetscSectionSetUp(section));
+        PetscCallAbort(comm, DMSetLocalSection(dm, section));
+        PetscCallAbort(comm, PetscSectionDestroy(&section));
+    }
+
+    /**
+     * @brief create a mesh of linear elements from a DMPlex
+     *
+     * The quadrilaterals and hexahedra become linear hypercubes and the triangles linear simplices.
+     * Boundary faces are the faces with one cell in their support:
+     * the boundary condition type and flag are taken from the labels written by dmplex_from_mesh
+     * or else the face_sets_label_name value (0 if unlabeled) is looked up in bcmap (the same as the gmsh physical tags)
+     *
+     * A distributed DMPlex is gathered to rank 0 and then distributed with distribute_mesh
+     * keeping the petsc partition (i.e from DMPlexDistribute), so the petsc partitioners can be used.
+     * The DMPlex must not have overlap, iceicle builds the communication of the neighboring elements itself.
+     *
+     * @param dm the DMPlex
+     * @param bcmap the boundary condition type and flag for each face set label value
+     * @return the mesh (distributed the same as the DMPlex)
+     */
+    template<class T, class IDX, int ndim>
+    auto mesh_from_dmplex(DM dm, const std::map<int, std::tuple<BOUNDARY_CONDITIONS, int>>& bcmap = {})
+    -> AbstractMesh<T, IDX, ndim> {
+        MPI_Comm comm;
+        PetscCallAbort(PETSC_COMM_WORLD, PetscObjectGetComm((PetscObject) dm, &comm));
+        int nrank;
+        MPI_Comm_size(comm, &nrank);
+
+        PetscInt dim;
+        PetscCallAbort(comm, DMGetDimension(dm, &dim));
+        if(dim != ndim) {
+            util::AnomalyLog::log_anomaly(util::Anomaly{"The DMPlex dimension does not match the mesh dimension",
+                    util::general_anomaly_tag{}});
+            return AbstractMesh<T, IDX, ndim>{};
+        }
+
+        // gather a distributed DMPlex and keep the rank of each cell
+        DM serial_dm = dm;
+        std::vector<int> el_partition{};
+        if(nrank > 1) {
+            PetscInt overlap;
+            PetscCallAbort(comm, DMPlexGetOverlap(dm, &overlap));
+            if(overlap > 0) util::AnomalyLog::log_anomaly(util::Anomaly{
+                    "The DMPlex must be distributed without overlap", util::general_anomaly_tag{}});
+
+            PetscSF gather_sf;
+            PetscCallAbort(comm, DMPlexGetGatherDM(dm, &gather_sf, &serial_dm));
+            PetscInt cstart, cend, nroots, nleaves;
+            const PetscInt* ilocal;
+            const PetscSFNode* iremote;
+            PetscCallAbort(comm, DMPlexGetHeightStratum(serial_dm, 0, &cstart, &cend));
+            PetscCallAbort(comm, PetscSFGetGraph(gather_sf, &nroots, &nleaves, &ilocal, &iremote));
+            el_partition.assign(cend - cstart, 0);
+            for(PetscInt ileaf = 0; ileaf < nleaves; ++ileaf){
+                PetscInt p = (ilocal) ? ilocal[ileaf] : ileaf;
+                if(p >= cstart && p < cend) el_partition[p - cstart] = iremote[ileaf].rank;
+            }
+            PetscCallAbort(comm, PetscSFDestroy(&gather_sf));
+        }
+
+        // the faces are needed for the boundary conditions
+        DM idm = serial_dm;
+        DMPlexInterpolatedFlag interpolated;
+        PetscCallAbort(comm, DMPlexIsInterpolated(serial_dm, &interpolated));
+        if(interpolated != DMPLEX_INTERPOLATED_FULL) PetscCallAbort(comm, DMPlexInterpolate(serial_dm, &idm));
+
+        PetscInt cstart, cend, fstart, fend, vstart, vend;
+        PetscCallAbort(comm, DMPlexGetHeightStratum(idm, 0, &cstart, &cend));
+        PetscCallAbort(comm, DMPlexGetHeightStratum(idm, 1, &fstart, &fend));
+        PetscCallAbort(comm, DMPlexGetDepthStratum(idm, 0, &vstart, &vend));
+
+        // the vertices of a point in closure order
+        auto closure_vertices = [&](PetscInt point) -> std::vector<IDX> {
+            PetscInt nclosure;
+            PetscInt* closure = nullptr;
+            std::vector<IDX> vertices{};
+            PetscCallAbort(comm, DMPlexGetTransitiveClosure(idm, point, PETSC_TRUE, &nclosure, &closure));
+            for(PetscInt icl = 0; icl < nclosure; ++icl){
+                PetscInt p = closure[2 * icl];
+                if(p >= vstart && p < vend) vertices.push_back(p - vstart);
+            }
+            PetscCallAbort(comm, DMPlexRestoreTransitiveClosure(idm, point, PETSC_TRUE, &nclosure, &closure));
+            return vertices;
+        };
+
+        // === nodes ===
+        NodeArray<T, ndim> coord(vend - vstart);
+        {
+            DM cdm;
+            Vec coord_vec;
+            PetscSection coord_section;
+            const PetscScalar* coord_data;
+            PetscCallAbort(comm, DMGetCoordinateDM(idm, &cdm));
+            PetscCallAbort(comm, DMGetLocalSection(cdm, &coord_section));
+            PetscCallAbort(comm, DMGetCoordinatesLocal(idm, &coord_vec));
+            PetscCallAbort(comm, VecGetArrayRead(coord_vec, &coord_data));
+            for(PetscInt v = vstart; v < vend; ++v){
+                PetscInt offset;
+                PetscCallAbort(comm, PetscSectionGetOffset(coord_section, v, &offset));
+                for(int idim = 0; idim < ndim; ++idim) coord[v - vstart][idim] = PetscRealPart(coord_data[offset + idim]);
+            }
+            PetscCallAbort(comm, VecRestoreArrayRead(coord_vec, &coord_data));
+        }
+
+        // === elements ===
+        std::vector<std::vector<IDX>> ragged_conn{};
+        std::vector<ElementTransformation<T, IDX, ndim>*> el_transformations{};
+        for(PetscInt c = cstart; c < cend; ++c){
+            DMPolytopeType cell_type;
+            PetscCallAbort(comm, DMPlexGetCellType(idm, c, &cell_type));
+            std::vector<IDX> vertices = closure_vertices(c);
+            std::vector<IDX> el_nodes(vertices.size());
+            if(cell_type == DM_POLYTOPE_SEGMENT || cell_type == DM_POLYTOPE_QUADRILATERAL
+                    || cell_type == DM_POLYTOPE_HEXAHEDRON) {
+                auto corners = impl::dmplex_hypercube_corners<ndim>();
+                for(std::size_t ivert = 0; ivert < corners.size() && ivert < vertices.size(); ++ivert)
+                    { el_nodes[impl::hypercube_corner_node<ndim>(corners[ivert], 1)] = vertices[ivert]; }
+                el_transformations.push_back(transformation_table<T, IDX, ndim>.get_transform(DOMAIN_TYPE::HYPERCUBE, 1));
+            } else if(cell_type == DM_POLYTOPE_TRIANGLE && ndim == 2) {
+                el_nodes = vertices;
+                if constexpr (ndim == 2) impl::orient_triangle(coord, el_nodes);
+                el_transformations.push_back(transformation_table<T, IDX, ndim>.get_transform(DOMAIN_TYPE::SIMPLEX, 1));
+            } else {
+                util::AnomalyLog::log_anomaly(util::Anomaly{"Unsupported DMPlex cell type: "
+                        + std::string{DMPolytopeTypes[cell_type]}, util::general_anomaly_tag{}});
+                continue;
+            }
+            ragged_conn.push_back(std::move(el_nodes));
+        }
+
+        // === boundary faces ===
+        DMLabel face_sets, bctypes;
+        PetscCallAbort(comm, DMGetLabel(idm, face_sets_label_name, &face_sets));
+        PetscCallAbort(comm, DMGetLabel(idm, bctype_label_name, &bctypes));
+        using boundary_face_desc = typename AbstractMesh<T, IDX, ndim>::boundary_face_desc;
+        std::vector<boundary_face_desc> boundary_infos{};
+        for(PetscInt f = fstart; f < fend; ++f){
+            PetscInt support_size;
+            PetscCallAbort(comm, DMPlexGetSupportSize(idm, f, &support_size));
+            if(support_size != 1) continue;
+
+            PetscInt face_set = -1, bctype = -1;
+            if(face_sets) PetscCallAbort(comm, DMLabelGetValue(face_sets, f, &face_set));
+            if(bctypes) PetscCallAbort(comm, DMLabelGetValue(bctypes, f, &bctype));
+            if(bctype >= 0) {
+                boundary_infos.emplace_back((BOUNDARY_CONDITIONS) bctype, (int) face_set, closure_vertices(f));
+            } else {
+                auto lookup = bcmap.find((face_set < 0) ? 0 : face_set);
+                if(lookup == bcmap.end()) {
+                    util::AnomalyLog::log_anomaly("Could not map boundary condition with face set: "
+                            + std::to_string(face_set));
+                    continue;
+                }
+                auto [bc_type, bc_flag] = lookup->second;
+                boundary_infos.emplace_back(bc_type, bc_flag, closure_vertices(f));
+            }
+        }
+
+        if(idm != serial_dm) PetscCallAbort(comm, DMDestroy(&idm));
+        if(serial_dm != dm) PetscCallAbort(comm, DMDestroy(&serial_dm));
+
+        AbstractMesh<T, IDX, ndim> mesh = (ragged_conn.empty()) ? AbstractMesh<T, IDX, ndim>{}
+            : AbstractMesh<T, IDX, ndim>{coord, util::crs<IDX, IDX>{ragged_conn}, el_transformations, boundary_infos};
+        if(nrank == 1) return mesh;
+#ifdef ICEICLE_USE_METIS
+        return distribute_mesh(mesh, std::span<const int>{el_partition});
+#else
+        util::AnomalyLog::log_anomaly(util::Anomaly{"Importing a distributed DMPlex requires ICEICLE_USE_METIS",
+                util::general_anomaly_tag{}});
+        return mesh;
+#endif
+    }
+}
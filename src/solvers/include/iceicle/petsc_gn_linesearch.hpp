@@ -5,6 +5,7 @@
 #include <iceicle/nonlinear_solver_utils.hpp>
 #include <iceicle/fe_function/fespan.hpp>
 #include <iceicle/petsc_interface.hpp>
+#include <iceicle/form_petsc_jacobian.hpp>
 #include <petscksp.h>
 #include <petscmat.h>
 #include <petscpc.h>
@@ -30,6 +31,17 @@ namespace iceicle::solvers {
             /// WARNING: must be setup by user
             Vec Jx;
 
+            /// @brief the diagonal regularization (column layout of J)
+            /// computed by gn_update_scaling() once per Jacobian assembly
+            ///
+            /// WARNING: must be setup by user
+            Vec scale;
+
+            /// @brief the vector to use as temporary storage for the regularization times x
+            ///
+            /// WARNING: must be setup by user
+            Vec work;
+
             // regularization coefficient
             PetscScalar lambda; 
 
@@ -37,12 +49,23 @@ namespace iceicle::solvers {
             PetscInt nic;
         };
 
+        /// @brief compute the diagonal regularization of the subproblem
+        /// using the column norms of J (More 1977 Levenberg-Marquardt Implementation and Theory)
+        ///
+        /// Must be called after each assembly of J or change of the regularization coefficient
+        inline
+        auto gn_update_scaling(GNSubproblemCtx* ctx) -> PetscErrorCode {
+            PetscFunctionBeginUser;
+            petsc::column_norms(ctx->J, ctx->scale);
+            PetscCall(VecScale(ctx->scale, ctx->lambda));
+            PetscFunctionReturn(EXIT_SUCCESS);
+        }
+
         inline
         auto gn_subproblem(Mat A, Vec x, Vec y) -> PetscErrorCode {
             GNSubproblemCtx *ctx;
 
             PetscFunctionBeginUser;
-            // Allocate the storage for x1
 
             PetscCall(MatShellGetContext(A, &ctx));
 
@@ -52,36 +75,10 @@ namespace iceicle::solvers {
             // y = J^T*J*x
             PetscCall(MatMultTranspose(ctx->J, ctx->Jx, y));
 
-            Vec lambdax;
-            VecCreate(PETSC_COMM_WORLD, &lambdax);
-            VecSetSizes(lambdax, ctx->npde + ctx->nic, PETSC_DETERMINE);
-            VecSetFromOptions(lambdax);
-            PetscScalar* lambdax_data;
-            const PetscScalar* xdata;
-            VecGetArray(lambdax, &lambdax_data);
-            VecGetArrayRead(x, &xdata);
-//            for(PetscInt i = 0; i < ctx->npde; ++i){
-//                lambdax_data[i] = xdata[i] * ctx->lambda;
-//            }
-//            for(PetscInt i = ctx->npde; i < ctx->npde + ctx->nic; ++i){
-//                lambdax_data[i] = xdata[i] * 100 * ctx->lambda;
-//            }
-//          // TODO: switch to parallel full size
-            std::vector<PetscScalar> colnorms(ctx->npde + ctx->nic);
-            // scaling using column norms (More 1977 Levenberg-Marquardt Implementation and Theory)
-            MatGetColumnNorms(ctx->J, NORM_2, colnorms.data());
-            for(PetscInt i = 0; i < ctx->npde + ctx->nic; ++i){
-                lambdax_data[i] = xdata[i] * ctx->lambda * colnorms[i];
-            }
-//            for(PetscInt i = ctx->npde; i < ctx->npde + ctx->nic; ++i)
-//                lambdax_data[i] *= 100;
-            VecRestoreArray(lambdax, &lambdax_data);
-            VecRestoreArrayRead(x, &xdata);
-
             // y = (J^T*J + lambda * I)*x
-            PetscCall(VecAXPY(y, 1.0, lambdax));
+            PetscCall(VecPointwiseMult(ctx->work, ctx->scale, x));
+            PetscCall(VecAXPY(y, 1.0, ctx->work));
 
-            VecDestroy(&lambdax);
             PetscFunctionReturn(EXIT_SUCCESS);
         }
     }
@@ -270,7 +267,7 @@ namespace iceicle::solvers {
             MatCreate(comm, &(jac));
             MatSetSizes(jac, local_res_size, local_u_size, PETSC_DETERMINE, PETSC_DETERMINE);
             MatSetFromOptions(jac);
-            MatSetUp(jac);
+            preallocate_petsc_jacobian(fespace, disc_class::nv_comp, jac, nodeset, comm);
 
             PetscInt proc_range_beg, proc_range_end;
             PetscCallAbort(comm, MatGetOwnershipRange(jac, &proc_range_beg, &proc_range_end));
@@ -289,6 +286,10 @@ namespace iceicle::solvers {
                 VecCreate(comm, &Jx);
                 VecSetSizes(Jx, local_res_size, PETSC_DETERMINE);
                 VecSetFromOptions(Jx);
+                VecCreate(comm, &subproblem_ctx.scale);
+                VecSetSizes(subproblem_ctx.scale, local_u_size, PETSC_DETERMINE);
+                VecSetFromOptions(subproblem_ctx.scale);
+                VecDuplicate(subproblem_ctx.scale, &subproblem_ctx.work);
 
                 subproblem_ctx.J = jac;
                 subproblem_ctx.Jx = Jx;
@@ -417,6 +418,9 @@ namespace iceicle::solvers {
                     for(PetscInt idiag = 0; idiag < n; ++idiag){
                         MatSetValueLocal(jac, idiag, idiag, subproblem_ctx.lambda, ADD_VALUES);
                     }
+                } else {
+                    // the regularization is computed once for the current jacobian
+                    PetscCallAbort(comm, impl::gn_update_scaling(&subproblem_ctx));
                 }
 
                 MatAssemblyBegin(subproblem_mat, MAT_FINAL_ASSEMBLY);
@@ -426,7 +430,10 @@ namespace iceicle::solvers {
                 // form Jtr
                 PetscCallAbort(comm, MatMultTranspose(jac, res_data, Jtr));
                 PetscCallAbort(comm, KSPSetOperators(ksp, subproblem_mat, subproblem_mat));
-                PetscCallAbort(comm, KSPSolve(ksp, Jtr, du_data));
+                {
+                    ICEICLE_PROFILE_REGION("ksp_solve");
+                    PetscCallAbort(comm, KSPSolve(ksp, Jtr, du_data));
+                }
 
                 // update u
                 if constexpr (std::is_same_v<ls_type, no_linesearch<T, IDX>>){
@@ -0,0 +1,503 @@
+/**
+ * @brief implicit time integration (BDF and SDIRK) that uses petsc for the linear solves
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/element_linear_solve.hpp"
+#include "iceicle/explicit_utils.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/form_petsc_jacobian.hpp"
+#include "iceicle/form_residual.hpp"
+#include "iceicle/krylov_recycling.hpp"
+#include "iceicle/mpi_type.hpp"
+#include "iceicle/petsc_interface.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <petscksp.h>
+#include <petscmat.h>
+#include <petscpc.h>
+#include <petscvec.h>
+#include <vector>
+
+namespace iceicle::solvers {
+
+    /// @brief the implicit time integration schemes
+    enum class IMPLICIT_SCHEME {
+        BDF1,   /// @brief backward Euler
+        BDF2,   /// @brief second order backward difference (variable step, BDF1 for the first step)
+        SDIRK2, /// @brief 2 stage L-stable SDIRK (Alexander 1977) with an embedded first order estimate
+        SDIRK3  /// @brief 3 stage L-stable SDIRK (Alexander 1977) with an embedded second order estimate
+    };
+
+    /**
+     * @brief Implicit time integration for M du/dt = R(u)
+     *
+     * Every stage solves M (U - base) = extra + a dt R(U) with a modified Newton method
+     * The system matrix M - a dt dR/du is formed once per step from form_petsc_jacobian_fd at u^n
+     * and reused for every Newton iteration and stage (all SDIRK stages share the diagonal coefficient)
+     *
+     * For SDIRK schemes, if tol > 0 the timestep is adapted with the embedded error estimate
+     * and steps with an error estimate over tol are rejected and retried
+     *
+     * @tparam T the floating point type
+     * @tparam IDX the index type
+     * @tparam TimestepClass the timestep determination (initial timestep if adaptive)
+     * @tparam StopCondition the termination criteria
+     */
+    template< class T, class IDX, class TimestepClass, class StopCondition>
+    class ImplicitTimeIntegrator {
+
+        private:
+
+        /// @brief the system matrix M - a dt dR/du
+        Mat sys;
+
+        /// @brief the newton residual
+        Vec r_vec;
+
+        /// @brief the newton update
+        Vec du_vec;
+
+        /// @brief the linear solver
+        KSP ksp;
+
+        /// @brief the preconditioner
+        PC pc;
+
+        /// @brief the previous solution (for BDF2)
+        std::vector<T> uprev_data{};
+
+        /// @brief the previous timestep (for BDF2) 0 if there is no previous step
+        T dt_prev = 0;
+
+        /// @brief the timestep chosen by the error controller for the next step (0 if none)
+        T dt_next = 0;
+
+        public:
+
+        /// @brief the time integration scheme
+        IMPLICIT_SCHEME scheme;
+
+        /** The timestep determination */
+        TimestepClass timestep;
+
+        /** The termination criteria */
+        StopCondition stop_condition;
+
+        /// @brief the residual data array
+        std::vector<T> res_data;
+
+        /// @brief persistent storage for residual evaluation
+        ResidualWorkspace<T, IDX> workspace;
+
+        /// @brief the cached mass matrices
+        MassOperator<T, IDX> mass;
+
+        /// @brief the cached inverse mass matrices
+        InverseMassOperator<T, IDX> inv_mass;
+
+        /// @brief the maximum number of newton iterations per stage
+        IDX newton_kmax = 10;
+
+        /// @brief the relative newton tolerance for each stage (relative to the first newton residual)
+        T newton_rtol = 1e-8;
+
+        /// @brief the absolute newton tolerance for each stage
+        T newton_atol = 1e-12;
+
+        /// @brief the error tolerance for adaptive timestepping (SDIRK only), <= 0 for no adaptivity
+        T tol = 0;
+
+        /// @brief the number of rejected steps (adaptive SDIRK only)
+        IDX nreject = 0;
+
+        /// @brief the current timestep
+        IDX itime = 0;
+
+        /// @brief the current time
+        T time = 0.0;
+
+        /// @brief the callback function for visualization during solve()
+        /// is given a reference to this when called
+        /// default is to print out a l2 norm of the residual data array
+        std::function<void(ImplicitTimeIntegrator &)> vis_callback = [](ImplicitTimeIntegrator &solver){
+            T sum = 0.0;
+            for(int i = 0; i < solver.res_data.size(); ++i){
+                sum += SQUARED(solver.res_data[i]);
+            }
+            std::cout << std::setprecision(8);
+            std::cout << "itime: " << std::setw(6) << solver.itime
+                << " | t: " << std::setw(14) << solver.time
+                << " | residual l2: " << std::setw(14) << std::sqrt(sum)
+                << std::endl;
+        };
+
+        /// @brief if this is a positive integer
+        /// then the vis_callback will be called every ivis timesteps
+        /// (itime % ivis == 0)
+        IDX ivis = -1;
+
+        /**
+         * @brief create the implicit time integrator
+         * @param fespace the finite element space
+         * @param disc the discretization
+         * @param timestep the class that determines the timestep
+         * @param stop_condition the termination criteria
+         * @param scheme the time integration scheme
+         */
+        template<int ndim, class disc_class>
+        ImplicitTimeIntegrator(
+            FESpace<T, IDX, ndim> &fespace,
+            disc_class &disc,
+            const TimestepClass &timestep,
+            const StopCondition &stop_condition,
+            IMPLICIT_SCHEME scheme
+        )
+        requires specifies_ncomp<disc_class> && TerminationCondition<StopCondition>
+        : scheme{scheme}, timestep{timestep}, stop_condition{stop_condition},
+          res_data(fespace.dg_map.calculate_size_requirement(disc_class::nv_comp)),
+          workspace{fespace, disc_class::dnv_comp}, mass{fespace}, inv_mass{fespace}
+        {
+            PetscInt local_size = res_data.size();
+            MatCreate(PETSC_COMM_WORLD, &sys);
+            MatSetSizes(sys, local_size, local_size, PETSC_DETERMINE, PETSC_DETERMINE);
+            MatSetBlockSize(sys, disc_class::dnv_comp);
+            MatSetFromOptions(sys);
+            preallocate_petsc_jacobian(fespace, disc_class::dnv_comp, sys);
+
+            VecCreate(PETSC_COMM_WORLD, &r_vec);
+            VecSetSizes(r_vec, local_size, PETSC_DETERMINE);
+            VecSetFromOptions(r_vec);
+            VecDuplicate(r_vec, &du_vec);
+
+            PetscCallAbort(PETSC_COMM_WORLD, KSPCreate(PETSC_COMM_WORLD, &ksp));
+            PetscCallAbort(PETSC_COMM_WORLD, KSPGetPC(ksp, &pc));
+            PCSetType(pc, PCBJACOBI);
+            PetscCallAbort(PETSC_COMM_WORLD, KSPSetFromOptions(ksp));
+        }
+
+        ImplicitTimeIntegrator(const ImplicitTimeIntegrator&) = delete;
+        ImplicitTimeIntegrator& operator=(const ImplicitTimeIntegrator&) = delete;
+
+        ~ImplicitTimeIntegrator(){
+            MatDestroy(&sys);
+            VecDestroy(&r_vec);
+            VecDestroy(&du_vec);
+            KSPDestroy(&ksp);
+        }
+
+        private:
+
+        /// @brief add c * M to the diagonal blocks of the system matrix (matrix is left unassembled)
+        template<int ndim, class LayoutPolicy, class AccessorPolicy>
+        auto add_mass_to_system(
+            FESpace<T, IDX, ndim>& fespace,
+            fespan<T, LayoutPolicy, AccessorPolicy> u,
+            T c
+        ) -> void {
+            using namespace std::experimental;
+            PetscInt proc_range_beg, proc_range_end;
+            PetscCallAbort(PETSC_COMM_WORLD, MatGetOwnershipRange(sys, &proc_range_beg, &proc_range_end));
+            const std::size_t nv = u.nv();
+            std::vector<T> block_data{};
+            for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+                const std::size_t ndof = el.nbasis();
+                const std::size_t n = ndof * nv;
+                const T* mass_el = mass.element_data(el.elidx);
+                block_data.assign(n * n, 0.0);
+                mdspan block{block_data.data(), extents{n, n}};
+                for(std::size_t idof = 0; idof < ndof; ++idof){
+                    for(std::size_t jdof = 0; jdof < ndof; ++jdof){
+                        for(std::size_t iv = 0; iv < nv; ++iv)
+                            { block[idof * nv + iv, jdof * nv + iv] = c * mass_el[idof * ndof + jdof]; }
+                    }
+                }
+                std::size_t glob_index_el = u.get_layout()[el.elidx, 0, 0];
+                petsc::add_to_petsc_mat(sys, proc_range_beg + glob_index_el,
+                        proc_range_beg + glob_index_el, block);
+            }
+        }
+
+        /**
+         * @brief form the system matrix M - adt dR/du at u
+         * also computes the residual R(u) into res
+         */
+        template<int ndim, class disc_class, class LayoutPolicy, class AccessorPolicy>
+        auto form_system(
+            FESpace<T, IDX, ndim>& fespace,
+            disc_class& disc,
+            fespan<T, LayoutPolicy, AccessorPolicy> u,
+            fespan<T, LayoutPolicy> res,
+            T adt
+        ) -> void {
+            MatZeroEntries(sys);
+            form_petsc_jacobian_fd(fespace, disc, u, res, sys);
+            MatAssemblyBegin(sys, MAT_FINAL_ASSEMBLY);
+            MatAssemblyEnd(sys, MAT_FINAL_ASSEMBLY);
+            MatScale(sys, -adt);
+            add_mass_to_system(fespace, u, 1.0);
+            MatAssemblyBegin(sys, MAT_FINAL_ASSEMBLY);
+            MatAssemblyEnd(sys, MAT_FINAL_ASSEMBLY);
+        }
+
+        /**
+         * @brief change the timestep of the system matrix without reforming the jacobian
+         * M - adt_new J = (adt_new / adt_old) (M - adt_old J) + (1 - adt_new / adt_old) M
+         */
+        template<int ndim, class LayoutPolicy, class AccessorPolicy>
+        auto rescale_system(
+            FESpace<T, IDX, ndim>& fespace,
+            fespan<T, LayoutPolicy, AccessorPolicy> u,
+            T adt_old,
+            T adt_new
+        ) -> void {
+            T ratio = adt_new / adt_old;
+            MatScale(sys, ratio);
+            add_mass_to_system(fespace, u, 1.0 - ratio);
+            MatAssemblyBegin(sys, MAT_FINAL_ASSEMBLY);
+            MatAssemblyEnd(sys, MAT_FINAL_ASSEMBLY);
+        }
+
+        /**
+         * @brief solve M (U - base) = extra + adt R(U) for U with the modified newton method
+         * @param [in/out] U the initial guess and the stage solution
+         * @param base the data for the mass term
+         * @param extra the explicit contributions (can be empty for none)
+         * @param adt the implicit coefficient times the timestep
+         * @param [out] resU the residual R(U) at the solution
+         * @return true if the newton iterations converged
+         */
+        template<int ndim, class disc_class, class LayoutPolicy>
+        auto stage_solve(
+            FESpace<T, IDX, ndim>& fespace,
+            disc_class& disc,
+            fespan<T, LayoutPolicy> U,
+            const std::vector<T>& base,
+            const std::vector<T>& extra,
+            T adt,
+            fespan<T, LayoutPolicy> resU
+        ) -> bool {
+            std::vector<T> diff_data(U.size());
+            fespan diff{diff_data.data(), U.get_layout()};
+            T r0 = 0;
+            for(IDX k = 0; k < newton_kmax; ++k){
+                form_residual(fespace, disc, U, resU, workspace);
+                for(std::size_t i = 0; i < U.size(); ++i) diff_data[i] = U.data()[i] - base[i];
+                T rnorm;
+                {
+                    petsc::VecSpan rview{r_vec};
+                    fespan r{rview.data(), U.get_layout()};
+                    for(std::size_t i = 0; i < U.size(); ++i){
+                        rview[i] = adt * resU.data()[i] + (extra.empty() ? 0.0 : extra[i]);
+                    }
+                    mass.apply(-1.0, diff, 1.0, r);
+                }
+                PetscCallAbort(PETSC_COMM_WORLD, VecNorm(r_vec, NORM_2, &rnorm));
+                if(!std::isfinite(rnorm)) return false;
+                if(k == 0) r0 = rnorm;
+                if(rnorm <= newton_atol + newton_rtol * r0) return true;
+
+                {
+                    ICEICLE_PROFILE_REGION("ksp_solve");
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSolve(ksp, r_vec, du_vec));
+                }
+                petsc::VecSpan duview{du_vec};
+                for(std::size_t i = 0; i < U.size(); ++i) U.data()[i] += duview[i];
+            }
+            form_residual(fespace, disc, U, resU, workspace);
+            return false;
+        }
+
+        public:
+
+        /**
+         * @brief reuse a Krylov subspace across the linear solves
+         * the petsc options database is applied again after and takes precedence
+         * @param config the recycling configuration
+         */
+        auto set_krylov_recycling(const KrylovRecycling& config) -> void {
+            config.setup(ksp);
+            PetscCallAbort(PETSC_COMM_WORLD, KSPSetFromOptions(ksp));
+        }
+
+        /**
+         * @brief perform a single timestep
+         * NOTE: this chooses the same layout for res based on u
+         *
+         * @param [in] fespace the finite element space
+         * @param [in] disc the discretization
+         * @param [in/out] u the solution as an fespan view
+         */
+        template<int ndim, class disc_class, class LayoutPolicy>
+        void step(FESpace<T, IDX, ndim> &fespace, disc_class &disc, fespan<T, LayoutPolicy> u)
+        requires TimestepT<TimestepClass, T, IDX, ndim, disc_class, LayoutPolicy, default_accessor<T>>
+        {
+            // update the solution dependent data cached by the discretization (frozen over the step)
+            update_cached_state(fespace, disc, u);
+
+            // calculate the timestep
+            T dt = (dt_next > 0) ? dt_next : timestep(fespace, disc, u);
+            dt = stop_condition.limit_dt(dt, time);
+
+            mass.update(fespace);
+            inv_mass.update(fespace);
+
+            fespan res{res_data.data(), u.get_layout()};
+            std::vector<T> un_data{u.data(), u.data() + u.size()};
+            const std::vector<T> no_extra{};
+
+            if(scheme == IMPLICIT_SCHEME::BDF1 || scheme == IMPLICIT_SCHEME::BDF2) {
+                // variable step BDF2 coefficients with omega = dt / dt_prev
+                T a = 1.0;
+                std::vector<T> base = un_data;
+                if(scheme == IMPLICIT_SCHEME::BDF2 && dt_prev > 0) {
+                    T omega = dt / dt_prev;
+                    a = (1 + omega) / (1 + 2 * omega);
+                    for(std::size_t i = 0; i < base.size(); ++i){
+                        base[i] = (SQUARED(1 + omega) * un_data[i] - SQUARED(omega) * uprev_data[i])
+                            / (1 + 2 * omega);
+                    }
+                }
+                form_system(fespace, disc, u, res, a * dt);
+                PetscCallAbort(PETSC_COMM_WORLD, KSPSetOperators(ksp, sys, sys));
+                if(!stage_solve(fespace, disc, u, base, no_extra, a * dt, res)) {
+                    util::AnomalyLog::log_anomaly(util::Anomaly{"Newton iterations did not converge in implicit timestep "
+                            + std::to_string(itime), util::general_anomaly_tag{}});
+                }
+            } else {
+                // Butcher tableau of the stiffly accurate SDIRK scheme
+                // the last row of A is the solution weights
+                const int nstage = (scheme == IMPLICIT_SCHEME::SDIRK2) ? 2 : 3;
+                std::array<std::array<T, 3>, 3> A{};
+                std::array<T, 3> bhat{};
+                T gamma;
+                int embedded_order;
+                if(scheme == IMPLICIT_SCHEME::SDIRK2) {
+                    gamma = 1.0 - 1.0 / std::sqrt(2.0);
+                    A[0] = {gamma, 0, 0};
+                    A[1] = {1 - gamma, gamma, 0};
+                    bhat = {1, 0, 0};
+                    embedded_order = 1;
+                } else {
+                    gamma = 0.4358665215084590;
+                    A[0] = {gamma, 0, 0};
+                    A[1] = {(1 - gamma) / 2, gamma, 0};
+                    A[2] = {-1.5 * SQUARED(gamma) + 4 * gamma - 0.25, 1.5 * SQUARED(gamma) - 5 * gamma + 1.25, gamma};
+                    bhat = {gamma / (1 - gamma), (1 - 2 * gamma) / (1 - gamma), 0};
+                    embedded_order = 2;
+                }
+
+                // the jacobian is formed once for the step and reused over stages and rejections
+                form_system(fespace, disc, u, res, gamma * dt);
+                PetscCallAbort(PETSC_COMM_WORLD, KSPSetOperators(ksp, sys, sys));
+
+                std::vector<std::vector<T>> stage_res(nstage, std::vector<T>(u.size()));
+                std::vector<T> extra(u.size());
+                while(true) {
+                    bool converged = true;
+                    std::copy(un_data.begin(), un_data.end(), u.data());
+                    for(int istage = 0; istage < nstage; ++istage){
+                        std::fill(extra.begin(), extra.end(), 0.0);
+                        for(int jstage = 0; jstage < istage; ++jstage){
+                            for(std::size_t i = 0; i < extra.size(); ++i)
+                                { extra[i] += dt * A[istage][jstage] * stage_res[jstage][i]; }
+                        }
+                        fespan resU{stage_res[istage].data(), u.get_layout()};
+                        converged = converged && stage_solve(fespace, disc, u, un_data, extra, gamma * dt, resU);
+                    }
+                    // stiffly accurate: u holds the last stage which is the solution
+
+                    if(tol <= 0) {
+                        if(!converged) util::AnomalyLog::log_anomaly(util::Anomaly{
+                                "Newton iterations did not converge in implicit timestep " + std::to_string(itime),
+                                util::general_anomaly_tag{}});
+                        break;
+                    }
+
+                    // embedded error estimate: dt M^{-1} sum_j (b_j - bhat_j) R_j
+                    std::vector<T> err_res(u.size(), 0.0);
+                    for(int jstage = 0; jstage < nstage; ++jstage){
+                        T wt = A[nstage - 1][jstage] - bhat[jstage];
+                        for(std::size_t i = 0; i < err_res.size(); ++i)
+                            { err_res[i] += dt * wt * stage_res[jstage][i]; }
+                    }
+                    std::vector<T> err_data(u.size());
+                    fespan err{err_data.data(), u.get_layout()};
+                    inv_mass.apply(1.0, fespan{err_res.data(), u.get_layout()}, 0.0, err);
+                    T err_local[2] = {0, 0};
+                    for(std::size_t i = 0; i < err_data.size(); ++i){
+                        err_local[0] += SQUARED(err_data[i]);
+                        err_local[1] += SQUARED(un_data[i]);
+                    }
+                    T err_global[2];
+                    MPI_Allreduce(err_local, err_global, 2, mpi_get_type<T>(), MPI_SUM, PETSC_COMM_WORLD);
+                    T err_norm = std::sqrt(err_global[0]) / (tol * (1 + std::sqrt(err_global[1])));
+                    if(!converged || !std::isfinite(err_norm)) err_norm = 1e10;
+
+                    T factor = 0.9 * std::pow(std::max(err_norm, (T) 1e-10), -1.0 / (embedded_order + 1));
+                    if(err_norm <= 1.0) {
+                        dt_next = dt * std::clamp(factor, (T) 0.2, (T) 5.0);
+                        break;
+                    }
+
+                    // reject and retry with a smaller timestep
+                    // limit the timestep before rescaling so the system matrix matches gamma * dt
+                    T dt_new = stop_condition.limit_dt(dt * std::clamp(factor, (T) 0.1, (T) 0.9), time);
+                    rescale_system(fespace, u, gamma * dt, gamma * dt_new);
+                    dt = dt_new;
+                    ++nreject;
+                }
+            }
+
+            // keep the previous solution for multistep schemes
+            uprev_data = std::move(un_data);
+            dt_prev = dt;
+
+            // the residual at the new state
+            form_residual(fespace, disc, u, res, workspace);
+
+            // update the timestep and time
+            itime++;
+            time += dt;
+        }
+
+        /**
+         * @brief perform timesteps until the stop condition is reached
+         * @param [in] fespace the finite element space
+         * @param [in] disc the discretization
+         * @param [in/out] u the solution as an fespan view
+         */
+        template<int ndim, class disc_class, class LayoutPolicy>
+        void solve(FESpace<T, IDX, ndim> &fespace, disc_class &disc, fespan<T, LayoutPolicy> u) {
+
+            // call initial residual to get initial wavespeeds for dt
+            {
+                fespan res{res_data.data(), u.get_layout()};
+                form_residual(fespace, disc, u, res, workspace);
+            }
+
+            // visualization callback on initial state (0 % anything == 0)
+            vis_callback(*this);
+
+            // timestep loop
+            while(!stop_condition(itime, time)){
+                step(fespace, disc, u);
+                if(itime % ivis == 0){
+                    vis_callback(*this);
+                }
+            }
+        }
+    };
+
+    // template argument deduction
+    template<class T, class IDX, int ndim, class disc_class, class TimestepClass, class StopCondition>
+    ImplicitTimeIntegrator(FESpace<T, IDX, ndim> &, disc_class &,
+        const TimestepClass &, const StopCondition &, IMPLICIT_SCHEME)
+        -> ImplicitTimeIntegrator<T, IDX, TimestepClass, StopCondition>;
+}
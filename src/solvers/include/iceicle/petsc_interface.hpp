@@ -2,15 +2,100 @@
 #include <mpi.h>
 #include <petsc.h>
 #include <petscerror.h>
+#include "iceicle/profiler.hpp"
 #include <mdspan/mdspan.hpp>
+#include <petscksp.h>
 #include <petscsystypes.h>
 #include <petscvec.h>
+#include <algorithm>
+#include <concepts>
+#include <numeric>
+#include <type_traits>
+#include <vector>
 
 namespace iceicle::petsc {
 
+    /**
+     * @brief accumulates scattered (row, column, value) entries of a matrix
+     * and adds them with one MatSetValues call per row instead of one MatSetValue per entry
+     *
+     * Repeated entries are summed before insertion.
+     * The buffers keep their capacity across flushes so repeated assemblies with the same
+     * sparsity do not allocate
+     */
+    struct triplet_buffer {
+        std::vector<PetscInt> rows{};
+        std::vector<PetscInt> cols{};
+        std::vector<PetscScalar> vals{};
+
+        /// @brief scratch for the sorted order and the merged columns and values of a row
+        std::vector<std::size_t> order{};
+        std::vector<PetscInt> row_cols{};
+        std::vector<PetscScalar> row_vals{};
+
+        /// @brief add a value at (irow, jcol)
+        void add(PetscInt irow, PetscInt jcol, PetscScalar value) {
+            rows.push_back(irow);
+            cols.push_back(jcol);
+            vals.push_back(value);
+        }
+
+        /// @brief the number of entries buffered
+        [[nodiscard]] auto size() const noexcept -> std::size_t { return vals.size(); }
+
+        /// @brief discard the buffered entries
+        void clear() noexcept {
+            rows.clear();
+            cols.clear();
+            vals.clear();
+        }
+
+        /**
+         * @brief add the buffered entries to the matrix and clear the buffer
+         * @param A the matrix
+         * @param local if true the indices are local (MatSetValuesLocal)
+         * @param comm the mpi communicator
+         */
+        void flush(Mat A, bool local = false, MPI_Comm comm = MPI_COMM_WORLD) {
+            order.resize(vals.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b){
+                return rows[a] < rows[b] || (rows[a] == rows[b] && cols[a] < cols[b]);
+            });
+
+            for(std::size_t ibeg = 0; ibeg < order.size();){
+                PetscInt irow = rows[order[ibeg]];
+                row_cols.clear();
+                row_vals.clear();
+                std::size_t iend = ibeg;
+                for(; iend < order.size() && rows[order[iend]] == irow; ++iend){
+                    std::size_t ientry = order[iend];
+                    if(!row_cols.empty() && row_cols.back() == cols[ientry]) row_vals.back() += vals[ientry];
+                    else {
+                        row_cols.push_back(cols[ientry]);
+                        row_vals.push_back(vals[ientry]);
+                    }
+                }
+                PetscInt ncol = row_cols.size();
+                if(local) {
+                    PetscCallAbort(comm, MatSetValuesLocal(A, 1, &irow, ncol, row_cols.data(), row_vals.data(), ADD_VALUES));
+                } else {
+                    PetscCallAbort(comm, MatSetValues(A, 1, &irow, ncol, row_cols.data(), row_vals.data(), ADD_VALUES));
+                }
+                ibeg = iend;
+            }
+            clear();
+        }
+    };
+
     /**
      * @brief add to a logically dense block from an mdspan to a pestc matrix A 
      * Adds the values, if there previously was no value, just puts the value in that location
+     *
+     * If the matrix has a block size bs > 1 (i.e MATBAIJ) and the block is aligned to the 
+     * matrix blocks, the whole block is inserted with MatSetValuesBlocked 
+     * Row major contiguous data is passed directly without a copy
+     *
      * @param A the petsc matrix to add values to
      * @param rowstart the global starting row index of the block 
      * @param colstart the global starting column index of the block 
@@ -25,23 +110,46 @@ namespace iceicle::petsc {
         std::experimental::mdspan<T, Extents, LayoutPolicy, AccessorPolicy> data,
         MPI_Comm comm = MPI_COMM_WORLD
     ) noexcept {
-        std::size_t dimprod = data.extent(0) * data.extent(1);
-        // indices are the offest plus 0, 1, ... for rows and columns
-        // row idxm[i] and column idxn[j] set the value values[i*n + j]
-        std::vector<PetscInt> idxm(data.extent(0));
-        std::vector<PetscInt> idxn(data.extent(1));
-        std::iota(idxm.begin(), idxm.end(), rowstart);
-        std::iota(idxn.begin(), idxn.end(), colstart);
+        std::size_t m = data.extent(0), n = data.extent(1);
+        if(m == 0 || n == 0) return;
 
-        std::vector<T> values{};
-        values.reserve(dimprod);
-        for(std::size_t i = 0; i < data.extent(0); ++i){
-            for(std::size_t j = 0; j < data.extent(1); ++j){
-                values.push_back(data[i, j]);
+        // get the values in row major order
+        const PetscScalar* values_ptr;
+        std::vector<PetscScalar> values{};
+        if constexpr (std::is_same_v<LayoutPolicy, std::experimental::layout_right> 
+                && std::is_same_v<std::remove_const_t<T>, PetscScalar>) {
+            values_ptr = data.data_handle();
+        } else {
+            values.reserve(m * n);
+            for(std::size_t i = 0; i < m; ++i){
+                for(std::size_t j = 0; j < n; ++j){
+                    values.push_back(data[i, j]);
+                }
             }
+            values_ptr = values.data();
+        }
+
+        PetscInt bs;
+        PetscCallAbort(comm, MatGetBlockSize(A, &bs));
+        std::size_t ubs = bs;
+        if(bs > 1 && rowstart % ubs == 0 && colstart % ubs == 0 && m % ubs == 0 && n % ubs == 0){
+            // block indices 
+            std::vector<PetscInt> idxm(m / ubs);
+            std::vector<PetscInt> idxn(n / ubs);
+            std::iota(idxm.begin(), idxm.end(), rowstart / ubs);
+            std::iota(idxn.begin(), idxn.end(), colstart / ubs);
+            PetscCallAbort(comm, MatSetValuesBlocked(A, idxm.size(), idxm.data(), idxn.size(),
+                        idxn.data(), values_ptr, ADD_VALUES));
+        } else {
+            // indices are the offest plus 0, 1, ... for rows and columns
+            // row idxm[i] and column idxn[j] set the value values[i*n + j]
+            std::vector<PetscInt> idxm(m);
+            std::vector<PetscInt> idxn(n);
+            std::iota(idxm.begin(), idxm.end(), rowstart);
+            std::iota(idxn.begin(), idxn.end(), colstart);
+            PetscCallAbort(comm, MatSetValues(A, m, idxm.data(), n,
+                        idxn.data(), values_ptr, ADD_VALUES));
         }
-        PetscCallAbort(comm, MatSetValues(A, data.extent(0), idxm.data(), data.extent(1),
-                    idxn.data(), values.data(), ADD_VALUES));
     }
 
 
@@ -177,4 +285,143 @@ namespace iceicle::petsc {
         inline constexpr size_type size() const { return std::distance(begin(), end());}
     };
 
+    /**
+     * @brief a petsc vec that uses existing storage as its local array (no copy)
+     * i.e over the data of an fespan, dofspan, or component_span
+     * so that solver work arrays can be given to petsc operations (VecNorm, MatMult, KSPSolve)
+     * without copying in and out of a separately allocated vec
+     *
+     * The storage must outlive this and the vec is destroyed with the destructor
+     * (this does not free the storage)
+     *
+     * This is the reverse of VecSpan which views the storage of an existing vec
+     */
+    class ArrayVec {
+        Vec v = nullptr;
+        MPI_Comm comm;
+
+        public:
+
+        /**
+         * @brief create the vec over the local data
+         * @param data the start of the local storage
+         * @param local_size the number of local values
+         * @param comm the mpi communicator
+         */
+        inline ArrayVec(PetscScalar* data, PetscInt local_size, MPI_Comm comm = PETSC_COMM_WORLD)
+        : comm{comm} {
+            PetscCallAbort(comm, VecCreateMPIWithArray(comm, 1, local_size, PETSC_DETERMINE, data, &v));
+        }
+
+        /**
+         * @brief create the vec over any contiguous storage with data() and size()
+         * @param span the storage (i.e an fespan or std::vector)
+         * @param comm the mpi communicator
+         */
+        template<class SpanT>
+        requires requires(SpanT& span) {
+            { span.data() } -> std::convertible_to<PetscScalar*>;
+            { span.size() } -> std::convertible_to<std::size_t>;
+        }
+        inline explicit ArrayVec(SpanT& span, MPI_Comm comm = PETSC_COMM_WORLD)
+        : ArrayVec(span.data(), (PetscInt) span.size(), comm) {}
+
+        ArrayVec(const ArrayVec&) = delete;
+        ArrayVec& operator=(const ArrayVec&) = delete;
+
+        inline ArrayVec(ArrayVec&& other) noexcept : v{other.v}, comm{other.comm}
+        { other.v = nullptr; }
+        ArrayVec& operator=(ArrayVec&&) = delete;
+
+        ~ArrayVec() {
+            if(v != nullptr) PetscCallAbort(comm, VecDestroy(&v));
+        }
+
+        /// @brief the vec for petsc calls
+        inline operator Vec() const noexcept { return v; }
+
+        /// @brief mark the values as changed
+        /// must be called after writing to the storage directly before petsc uses the vec
+        /// (petsc caches norms by object state)
+        inline auto modified() const -> void {
+            PetscCallAbort(comm, PetscObjectStateIncrease((PetscObject) v));
+        }
+
+        /// @brief the global 2-norm of the current values of the storage
+        [[nodiscard]] inline auto norm() const -> PetscReal {
+            modified();
+            PetscReal nrm;
+            PetscCallAbort(comm, VecNorm(v, NORM_2, &nrm));
+            return nrm;
+        }
+    };
+
+    /**
+     * @brief get the 2-norm of each column of A in the parallel layout of the columns of A
+     *
+     * MatGetColumnNorms fills an array of the global number of columns on every rank,
+     * the locally owned column range is copied into the vector
+     *
+     * @param A the matrix (must be assembled)
+     * @param colnorms the vector to fill (same parallel layout as the columns of A)
+     * @param comm the mpi communicator
+     */
+    inline
+    void column_norms(Mat A, Vec colnorms, MPI_Comm comm = PETSC_COMM_WORLD)
+    {
+        PetscInt nrow, ncol, colstart, colend;
+        PetscCallAbort(comm, MatGetSize(A, &nrow, &ncol));
+        PetscCallAbort(comm, MatGetOwnershipRangeColumn(A, &colstart, &colend));
+        std::vector<PetscReal> norms(ncol);
+        PetscCallAbort(comm, MatGetColumnNorms(A, NORM_2, norms.data()));
+        PetscScalar* data;
+        PetscCallAbort(comm, VecGetArray(colnorms, &data));
+        for(PetscInt i = 0; i < colend - colstart; ++i)
+            { data[i] = norms[colstart + i]; }
+        PetscCallAbort(comm, VecRestoreArray(colnorms, &data));
+    }
+
+    /**
+     * @brief solve A x = b with the ksp followed by iterative refinement
+     *
+     * After the initial solve the linear residual r = b - A x is recomputed with the operator of the ksp
+     * in working precision and the correction A d = r is solved and added to x.
+     * This recovers an accurate solution when the inner solve is loose
+     * or uses a reduced precision preconditioner (i.e single precision element block Jacobi)
+     *
+     * @param ksp the linear solver (with operators set)
+     * @param b the right hand side
+     * @param x the solution
+     * @param nrefine the maximum number of refinement steps (0 is a plain KSPSolve)
+     * @param rtol stop refining when ||b - A x|| <= rtol * ||b||
+     * @param comm the mpi communicator
+     */
+    inline
+    void refined_solve(KSP ksp, Vec b, Vec x, int nrefine, PetscReal rtol, MPI_Comm comm = PETSC_COMM_WORLD)
+    {
+        ICEICLE_PROFILE_REGION("ksp_solve");
+        PetscCallAbort(comm, KSPSolve(ksp, b, x));
+        if(nrefine <= 0) return;
+
+        Mat A;
+        Vec r, d;
+        PetscCallAbort(comm, KSPGetOperators(ksp, &A, nullptr));
+        PetscCallAbort(comm, VecDuplicate(b, &r));
+        PetscCallAbort(comm, VecDuplicate(b, &d));
+        PetscReal bnorm;
+        PetscCallAbort(comm, VecNorm(b, NORM_2, &bnorm));
+        for(int irefine = 0; irefine < nrefine; ++irefine){
+            // r = b - A x
+            PetscCallAbort(comm, MatMult(A, x, r));
+            PetscCallAbort(comm, VecAYPX(r, -1.0, b));
+            PetscReal rnorm;
+            PetscCallAbort(comm, VecNorm(r, NORM_2, &rnorm));
+            if(rnorm <= rtol * bnorm) break;
+
+            PetscCallAbort(comm, KSPSolve(ksp, r, d));
+            PetscCallAbort(comm, VecAXPY(x, 1.0, d));
+        }
+        PetscCallAbort(comm, VecDestroy(&r));
+        PetscCallAbort(comm, VecDestroy(&d));
+    }
 }
@@ -7,13 +7,21 @@
 #include "iceicle/fespace/fespace.hpp"
 #include "iceicle/form_petsc_jacobian.hpp"
 #include "iceicle/form_residual.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/krylov_method.hpp"
+#include "iceicle/krylov_recycling.hpp"
 #include "iceicle/nonlinear_solver_utils.hpp"
 #include "iceicle/petsc_interface.hpp"
+#include "iceicle/petsc_preconditioner.hpp"
 #include "iceicle/mdg_utils.hpp"
 #include <fmt/core.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <petscerror.h>
 #include <petscksp.h>
 #include <petscmat.h>
@@ -23,18 +31,94 @@
 #include <petscsystypes.h>
 #include <petscvec.h>
 #include <petscviewer.h>
+#include <vector>
 
 namespace iceicle::solvers {
 
+    namespace impl {
+
+        /// @brief Context for the matrix-free jacobian vector products of the discretization 
+        /// when the assembled jacobian only preconditions the linear solves
+        template<class T, class IDX, int ndim, class disc_class, class uLayoutPolicy>
+        struct NewtonMFContext {
+            /// @brief the finite element space
+            FESpace<T, IDX, ndim>& fespace;
+
+            /// @brief the discretization
+            disc_class& disc;
+
+            /// @brief the current state vector
+            fespan<T, uLayoutPolicy> u;
+
+            /// @brief the residual at u
+            Vec res;
+
+            /// @brief persistent storage for residual evaluation
+            ResidualWorkspace<T, IDX>& workspace;
+
+            /// @brief storage for the peturbed state and residual
+            std::vector<T> u_peturb, res_peturb;
+
+            /// @brief the norm of u (set once per Newton iteration)
+            T unorm = 0;
+        };
+
+        /// @brief the forward difference jacobian vector product
+        /// J p ~ (r(u + h p) - r(u)) / h with h = sqrt(machine epsilon * (1 + ||u||)) / ||p||
+        template<class T, class IDX, int ndim, class disc_class, class uLayoutPolicy>
+        inline 
+        auto newton_mf_op(Mat A, Vec p, Vec y) 
+        -> PetscErrorCode 
+        {
+            NewtonMFContext<T, IDX, ndim, disc_class, uLayoutPolicy> *ctx;
+            PetscFunctionBeginUser;
+            PetscCall(MatShellGetContext(A, &ctx));
+
+            PetscReal pnorm;
+            PetscCall(VecNorm(p, NORM_2, &pnorm));
+            if(pnorm == 0){
+                PetscCall(VecZeroEntries(y));
+                PetscFunctionReturn(EXIT_SUCCESS);
+            }
+            T h = std::sqrt(std::numeric_limits<T>::epsilon() * (1 + ctx->unorm)) / pnorm;
+
+            fespan up{ctx->u_peturb.data(), ctx->u.get_layout()};
+            fespan resp{ctx->res_peturb.data(), ctx->u.get_layout()};
+            copy_fespan(ctx->u, up);
+            {
+                petsc::VecSpan pview{p};
+                fespan dir{pview.data(), ctx->u.get_layout()};
+                axpy(h, dir, up);
+            }
+            form_residual(ctx->fespace, ctx->disc, up, resp, ctx->workspace);
+
+            petsc::VecSpan resview{ctx->res};
+            petsc::VecSpan yview{y};
+            for(std::size_t i = 0; i < ctx->res_peturb.size(); ++i){
+                yview[i] = (ctx->res_peturb[i] - resview[i]) / h;
+            }
+            PetscFunctionReturn(EXIT_SUCCESS);
+        }
+    }
+
     /**
      * @brief Newton solver that uses Petsc for linear solvers 
+     *
+     * The jacobian can be assembled from a cheaper preconditioner discretization 
+     * (i.e a dissipative Riemann solver, frozen artificial viscosity)
+     * the residual is always formed with disc 
+     * and the linear solves use matrix-free products of disc preconditioned with the assembled jacobian
+     * (or the assembled jacobian directly with pc_disc_matrix_free = false)
+     *
      * @tparam T the floating point type 
      * @tparam IDX the index type
      * @tparam ndim the number of dimensions
      * @tparam disc_class the discretization
      * @tparam ls_type the linesearch type to use
+     * @tparam pc_disc_class the discretization the jacobian is assembled from
      */
-    template<class T, class IDX, int ndim, class disc_class, class ls_type = no_linesearch<T, IDX>>
+    template<class T, class IDX, int ndim, class disc_class, class ls_type = no_linesearch<T, IDX>,
+        class pc_disc_class = disc_class>
     class PetscNewton {
 
         // ================
@@ -56,6 +140,15 @@ namespace iceicle::solvers {
         /// @brief the preconditioner
         PC pc;
 
+        /// @brief the element coloring for colored finite differences (built on first use)
+        util::crs<IDX, IDX> el_colors;
+
+        /// @brief the preconditioner configuration
+        PetscPreconditioner preconditioner{};
+
+        /// @brief storage for the discarded residual of a separate pc_disc
+        std::vector<T> pc_res_storage{};
+
         public:
 
         // ============
@@ -70,6 +163,9 @@ namespace iceicle::solvers {
         /// @brief store a reference to the discretization being solved
         disc_class &disc;
 
+        /// @brief the discretization the jacobian is assembled from (disc unless given)
+        pc_disc_class &pc_disc;
+
         /// @brief the linesearch strategy
         const ls_type& linesearch;
 
@@ -77,6 +173,40 @@ namespace iceicle::solvers {
         /// determines whether the solver should terminate
         ConvergenceCriteria<T, IDX> conv_criteria;
 
+        /// @brief persistent storage for residual evaluation
+        ResidualWorkspace<T, IDX> workspace;
+
+        /// @brief if true, form the finite difference jacobian by perturbing 
+        /// all the elements of a distance-2 element coloring at once 
+        /// (see form_petsc_jacobian_fd_colored)
+        bool fd_coloring = false;
+
+        /// @brief with a separate pc_disc, use matrix-free jacobian products of disc
+        /// in the linear solves (the assembled jacobian is only the preconditioner)
+        /// otherwise the assembled jacobian is the linear operator (a defect correction iteration)
+        bool pc_disc_matrix_free = true;
+
+        /// @brief with a separate pc_disc, do not update its cached state 
+        /// (i.e the artificial viscosity) during the solve 
+        bool freeze_pc_disc_state = false;
+
+        /// @brief when to refresh the jacobian 
+        /// while the jacobian is lagged, only the residual is formed 
+        /// and the linear solver reuses the preconditioner
+        JacobianLagPolicy<T, IDX> jacobian_lag{};
+
+        /// @brief adaptive relative tolerance for the linear solves 
+        /// (disabled by default: the KSP tolerances are used)
+        EisenstatWalkerForcing<T> forcing{};
+
+        /// @brief the maximum number of iterative refinement steps for each linear solve 
+        /// (see petsc::refined_solve) 
+        /// refinement stops when the true linear residual is below linear_refinement_rtol
+        IDX linear_refinement = 0;
+
+        /// @brief relative tolerance for the iterative refinement
+        T linear_refinement_rtol = 1e-10;
+
         /// @brief if this is a positive integer 
         /// Then the diagnostics callback will be called every idiag timesteps
         /// (k % idiag == 0)
@@ -150,16 +280,37 @@ namespace iceicle::solvers {
             disc_class &disc,
             const ConvergenceCriteria<T, IDX> &conv_criteria,
             const ls_type& linesearch
-        ) : fespace(fespace), disc(disc), linesearch{linesearch}, 
-            conv_criteria{conv_criteria} 
+        ) : PetscNewton(fespace, disc, disc, conv_criteria, linesearch) {}
+
+        /**
+         * @brief Construct the Newton Solver with a separate discretization to assemble the jacobian
+         *
+         * @param fespace the finite element space
+         * @param disc the discretization
+         * @param pc_disc the discretization to assemble the jacobian from
+         * @param conv_criteria the convergence criteria for terminating the solve 
+         */
+        PetscNewton(
+            FESpace<T, IDX, ndim> &fespace,
+            disc_class &disc,
+            pc_disc_class &pc_disc,
+            const ConvergenceCriteria<T, IDX> &conv_criteria,
+            const ls_type& linesearch
+        ) : fespace(fespace), disc(disc), pc_disc(pc_disc), linesearch{linesearch}, 
+            conv_criteria{conv_criteria}, workspace{fespace, disc_class::dnv_comp}
         {
+            static_assert(pc_disc_class::nv_comp == disc_class::nv_comp,
+                    "the preconditioner discretization must have the same number of equations");
             PetscInt local_res_size = fespace.dg_map.calculate_size_requirement(disc_class::dnv_comp);
             PetscInt local_u_size = local_res_size;
             // Create and set up the matrix if not given 
             MatCreate(PETSC_COMM_WORLD, &(this->jac));
             MatSetSizes(this->jac, local_res_size, local_u_size, PETSC_DETERMINE, PETSC_DETERMINE);
+            // dofs are vector component fastest so each dof is a dense block 
+            // -mat_type baij will use block sparse storage
+            MatSetBlockSize(this->jac, disc_class::dnv_comp);
             MatSetFromOptions(this->jac);
-            MatSetUp(this->jac);
+            preallocate_petsc_jacobian(fespace, disc_class::dnv_comp, this->jac);
 
             // Create and set up the vectors
             VecCreate(PETSC_COMM_WORLD, &res_data);
@@ -174,9 +325,9 @@ namespace iceicle::solvers {
             // Create the linear solver and preconditioner
             PetscCallAbort(PETSC_COMM_WORLD, KSPCreate(PETSC_COMM_WORLD, &ksp));
 
-            // default to sor preconditioner
+            // default to sor preconditioner (see set_preconditioner)
             PetscCallAbort(PETSC_COMM_WORLD, KSPGetPC(ksp, &pc));
-            PCSetType(pc, PCSOR);
+            preconditioner.setup(ksp, this->jac, fespace, (IDX) disc_class::dnv_comp);
 
             // Get user input (can override defaults set above)
             PetscCallAbort(PETSC_COMM_WORLD, KSPSetFromOptions(ksp));
@@ -188,10 +339,78 @@ namespace iceicle::solvers {
             const ConvergenceCriteria<T, IDX> &conv_criteria
         ) : PetscNewton(fespace, disc, conv_criteria, no_linesearch<T, IDX>{}) {}
 
+        PetscNewton(
+            FESpace<T, IDX, ndim> &fespace,
+            disc_class &disc,
+            pc_disc_class &pc_disc,
+            const ConvergenceCriteria<T, IDX> &conv_criteria
+        ) : PetscNewton(fespace, disc, pc_disc, conv_criteria, no_linesearch<T, IDX>{}) {}
+
         // ====================
         // = Member Functions =
         // ====================
 
+        /**
+         * @brief replace the preconditioner of the linear solves
+         * the petsc options database is applied again after and takes precedence
+         * @param config the preconditioner configuration
+         */
+        auto set_preconditioner(const PetscPreconditioner& config) -> void {
+            preconditioner = config;
+            preconditioner.setup(ksp, jac, fespace, (IDX) disc_class::dnv_comp);
+            PetscCallAbort(PETSC_COMM_WORLD, KSPSetFromOptions(ksp));
+        }
+
+        /**
+         * @brief set the Krylov method of the linear solves
+         * the petsc options database is applied again after and takes precedence
+         * @param config the Krylov method configuration
+         */
+        auto set_krylov_method(const KrylovMethod& config) -> void {
+            config.setup(ksp);
+            PetscCallAbort(PETSC_COMM_WORLD, KSPSetFromOptions(ksp));
+        }
+
+        /**
+         * @brief reuse a Krylov subspace across the linear solves
+         * the petsc options database is applied again after and takes precedence
+         * @param config the recycling configuration
+         */
+        auto set_krylov_recycling(const KrylovRecycling& config) -> void {
+            config.setup(ksp);
+            PetscCallAbort(PETSC_COMM_WORLD, KSPSetFromOptions(ksp));
+        }
+
+        /// @brief the jacobian is assembled from a different discretization than the residual
+        [[nodiscard]] auto separate_pc_disc() const noexcept -> bool {
+            return static_cast<const void*>(&pc_disc) != static_cast<const void*>(&disc);
+        }
+
+        /**
+         * @brief form the residual and jacobian with the selected finite difference strategy
+         * with a separate pc_disc the jacobian is formed from pc_disc and res is left unchanged
+         * @param [in] u the current solution 
+         * @param [out] res the residual 
+         */
+        template<class uLayoutPolicy, class resLayoutPolicy>
+        auto form_jacobian(fespan<T, uLayoutPolicy> u, fespan<T, resLayoutPolicy> res) -> void {
+            auto form = [&](auto res_out){
+                if(fd_coloring){
+                    if(el_colors.nrow() == 0) el_colors = color_elements_distance2(fespace);
+                    form_petsc_jacobian_fd_colored(fespace, pc_disc, u, res_out, jac, el_colors, workspace);
+                } else {
+                    form_petsc_jacobian_fd(fespace, pc_disc, u, res_out, jac);
+                }
+            };
+            if(separate_pc_disc()){
+                // the residual of pc_disc is discarded
+                pc_res_storage.resize(res.size());
+                form(fespan{pc_res_storage.data(), res.get_layout()});
+            } else {
+                form(res);
+            }
+        }
+
         /**
          * @brief solve the nonlinear pde defined by disc and fespace 
          * @tparam uLayoutPolicy the layout of the input solution 
@@ -209,16 +428,50 @@ namespace iceicle::solvers {
 
 
             // get the initial residual and jacobian
+            update_cached_state(fespace, disc, u);
+            if(separate_pc_disc()) update_cached_state(fespace, pc_disc, u);
             {
                 petsc::VecSpan res_view{res_data};
                 fespan res{res_view.data(), u.get_layout()};
-                form_petsc_jacobian_fd(fespace, disc, u, res, jac);
+                form_jacobian(u, res);
+                if(separate_pc_disc()) form_residual(fespace, disc, u, res, workspace);
 //                std::cout << "res_initial" << std::endl;
 //                std::cout << res;
             } // end scope of res_view
+            MatAssemblyBegin(jac, MAT_FINAL_ASSEMBLY);
+            MatAssemblyEnd(jac, MAT_FINAL_ASSEMBLY);
 
             // set the initial residual norm
             PetscCallAbort(PETSC_COMM_WORLD, VecNorm(res_data, NORM_2, &(conv_criteria.r0)));
+            // residual norms of the current and previous iterates 
+            // and the final linear residual norm of the previous linear solve
+            T r_cur = conv_criteria.r0, r_prev = 0, lin_rnorm = 0;
+            jacobian_lag.age = 0;
+
+            // the linear operator: matrix-free products of disc preconditioned by the jacobian of pc_disc
+            // or the assembled jacobian
+            Mat jac_mf = nullptr;
+            impl::NewtonMFContext<T, IDX, ndim, disc_class, uLayoutPolicy> mf_ctx{
+                .fespace = fespace,
+                .disc = disc,
+                .u = u,
+                .res = res_data,
+                .workspace = workspace
+            };
+            if(separate_pc_disc() && pc_disc_matrix_free){
+                mf_ctx.u_peturb.resize(u.size());
+                mf_ctx.res_peturb.resize(u.size());
+                PetscInt local_size = u.size();
+                MatCreate(PETSC_COMM_WORLD, &jac_mf);
+                MatSetSizes(jac_mf, local_size, local_size, PETSC_DETERMINE, PETSC_DETERMINE);
+                MatSetType(jac_mf, MATSHELL);
+                MatSetUp(jac_mf);
+                MatShellSetOperation(jac_mf, MATOP_MULT, 
+                        (void (*)()) impl::newton_mf_op<T, IDX, ndim, disc_class, uLayoutPolicy>);
+                MatShellSetContext(jac_mf, (void *) &mf_ctx);
+                MatAssemblyBegin(jac_mf, MAT_FINAL_ASSEMBLY);
+                MatAssemblyEnd(jac_mf, MAT_FINAL_ASSEMBLY);
+            }
 
             IDX k;
             for(k = 0; k < conv_criteria.kmax; ++k){
@@ -227,8 +480,6 @@ namespace iceicle::solvers {
                 std::vector<T> node_radii{node_freedom_radii(fespace)};
 
                 // solve for du 
-                MatAssemblyBegin(jac, MAT_FINAL_ASSEMBLY);
-                MatAssemblyEnd(jac, MAT_FINAL_ASSEMBLY);
 
                 // view jacobian matrix
                 if(verbosity >= 4){
@@ -240,10 +491,24 @@ namespace iceicle::solvers {
     //                MatView(jac, PETSC_VIEWER_STDOUT_WORLD); // for debug purposes
                 }
 
-                PetscCallAbort(PETSC_COMM_WORLD, KSPSetOperators(ksp, this->jac, this->jac));
-                PetscCallAbort(PETSC_COMM_WORLD, KSPSolve(ksp, res_data, du_data));
+                if(jac_mf != nullptr){
+                    mf_ctx.unorm = std::sqrt(mpi::allreduce_sums(std::array<T, 1>{norm_sq(u)})[0]);
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSetOperators(ksp, jac_mf, this->jac));
+                } else {
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSetOperators(ksp, this->jac, this->jac));
+                }
+                preconditioner.setup_sub_solvers(ksp);
+                if(forcing.choice != 0){
+                    T tau = conv_criteria.tau_abs + conv_criteria.tau_rel * conv_criteria.r0;
+                    T eta = forcing.forcing_term(k, r_cur, r_prev, lin_rnorm, tau);
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSetTolerances(ksp, eta, PETSC_DEFAULT, PETSC_DEFAULT, PETSC_DEFAULT));
+                }
+                petsc::refined_solve(ksp, res_data, du_data, linear_refinement, linear_refinement_rtol);
+                PetscCallAbort(PETSC_COMM_WORLD, KSPGetResidualNorm(ksp, &lin_rnorm));
 
                 // update u
+                T alpha = 1.0;
+                bool residual_current = false;
                 if constexpr (std::is_same_v<ls_type, no_linesearch<T, IDX>>){
                     petsc::VecSpan du_view{du_data};
                     fespan du{du_view.data(), u.get_layout()};
@@ -263,19 +528,23 @@ namespace iceicle::solvers {
                     // working array for linesearch residuals
                     std::vector<T> r_work_storage(u.size());
                     fespan res_work{r_work_storage.data(), u.get_layout()};
+                    petsc::ArrayVec res_work_vec{r_work_storage};
 
                     std::vector<T> r_mdg_work_storage{};
 
+                    // the alpha that res_work holds the residual for
+                    T alpha_evaluated = std::numeric_limits<T>::quiet_NaN();
 
-                    T alpha = linesearch([&](T alpha_arg){
+                    alpha = linesearch([&](T alpha_arg){
                         static constexpr T BIG_RESIDUAL = 1e9;
 
                         // apply the step scaled by linesearch param
                         copy_fespan(u, u_step);
                         axpy(-alpha_arg, du, u_step);
 
-                        form_residual(fespace, disc, u_step, res_work);
-                        T rnorm = res_work.vector_norm();
+                        form_residual(fespace, disc, u_step, res_work, workspace);
+                        alpha_evaluated = alpha_arg;
+                        T rnorm = res_work_vec.norm();
 
                         // verbose output
                         if(verbosity >= 1){
@@ -291,25 +560,49 @@ namespace iceicle::solvers {
                             }
                             return BIG_RESIDUAL;
                         }
-                    });
+                    }, r_cur);
 
                     if(verbosity >= 1) std::cout << "linesearch: selected alpha = " << alpha << std::endl;
 
                     // apply the step times linesearch multiplier to u and x
                     axpy(-alpha, du, u);
+
+                    // the last trial was the accepted step so its residual is the new residual
+                    if(alpha == alpha_evaluated){
+                        petsc::VecSpan res_view{res_data};
+                        std::ranges::copy(r_work_storage, res_view.data());
+                        residual_current = true;
+                    }
                 }
 
-                // Get the new residual and Jacobian (for the next step)
-                {
+                // update the data cached by the discretization for the new iterate
+                // (an accepted trial residual was evaluated with the old data)
+                if(update_cached_state(fespace, disc, u)) residual_current = false;
+                if(separate_pc_disc() && !freeze_pc_disc_state) update_cached_state(fespace, pc_disc, u);
+
+                // Get the new residual 
+                if(!residual_current) {
                     petsc::VecSpan res_view{res_data};
                     fespan res{res_view.data(), u.get_layout()};
-                    MatZeroEntries(jac); // zero out the jacobian
-                    form_petsc_jacobian_fd(fespace, disc, u, res, jac);
+                    form_residual(fespace, disc, u, res, workspace);
                 } // end scope of res_view
 
                 // get the residual norm
                 T rk;
                 PetscCallAbort(PETSC_COMM_WORLD, VecNorm(res_data, NORM_2, &rk));
+
+                // Get the new Jacobian (for the next step) unless it is lagged
+                // the matrix keeps its nonzero structure so only the values are recomputed
+                if(jacobian_lag.refresh(rk, r_cur, alpha)) {
+                    petsc::VecSpan res_view{res_data};
+                    fespan res{res_view.data(), u.get_layout()};
+                    MatZeroEntries(jac); // zero out the jacobian
+                    form_jacobian(u, res);
+                    MatAssemblyBegin(jac, MAT_FINAL_ASSEMBLY);
+                    MatAssemblyEnd(jac, MAT_FINAL_ASSEMBLY);
+                }
+                r_prev = r_cur;
+                r_cur = rk;
                 
                 // Diagnostics 
                 if(idiag > 0 && k % idiag == 0) {
@@ -325,6 +618,7 @@ namespace iceicle::solvers {
                 if(conv_criteria.done_callback(rk)) break;
 
             }
+            if(jac_mf != nullptr) MatDestroy(&jac_mf);
             return k;
         }
 
@@ -354,6 +648,16 @@ namespace iceicle::solvers {
     PetscNewton(FESpace<T, IDX, ndim> &, disc_class &,
         const ConvergenceCriteria<T, IDX> &) -> PetscNewton<T, IDX, ndim, disc_class, no_linesearch<T, IDX>>;
 
+    template<class T, class IDX, int ndim, class disc_class, class pc_disc_class, class ls_type>
+    PetscNewton(FESpace<T, IDX, ndim> &, disc_class &, pc_disc_class &,
+        const ConvergenceCriteria<T, IDX> &, const ls_type&) 
+        -> PetscNewton<T, IDX, ndim, disc_class, ls_type, pc_disc_class>;
+
+    template<class T, class IDX, int ndim, class disc_class, class pc_disc_class>
+    PetscNewton(FESpace<T, IDX, ndim> &, disc_class &, pc_disc_class &,
+        const ConvergenceCriteria<T, IDX> &) 
+        -> PetscNewton<T, IDX, ndim, disc_class, no_linesearch<T, IDX>, pc_disc_class>;
+
     template<class T, class IDX, int ndim, class disc_class>
     PetscNewton(FESpace<T, IDX, ndim> &, disc_class &,
         const ConvergenceCriteria<T, IDX> &, Mat) -> PetscNewton<T, IDX, ndim, disc_class, no_linesearch<T, IDX>>;
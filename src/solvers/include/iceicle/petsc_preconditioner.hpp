@@ -0,0 +1,246 @@
+/**
+ * @brief configuration of the petsc preconditioner for the DG jacobian
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/element_line_implicit.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include <petscerror.h>
+#include <petscksp.h>
+#include <petscmat.h>
+#include <petscpc.h>
+#include <petscvec.h>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace iceicle::solvers {
+
+    /// @brief the preconditioners for the linear solves of the petsc nonlinear solvers
+    enum class PRECONDITIONER_TYPE {
+        SOR,                  /// @brief successive over-relaxation (the petsc default of the newton solvers)
+        ELEMENT_BLOCK_JACOBI, /// @brief invert the dense diagonal block of each element (PCVPBJACOBI)
+        BLOCK_JACOBI,         /// @brief one block per process with ILU(k) (PCBJACOBI)
+        ASM,                  /// @brief additive Schwarz with overlap and ILU(k) subdomain solves (PCASM)
+        GAMG,                 /// @brief algebraic multigrid with the vector components as the near null space (PCGAMG)
+        LINE_IMPLICIT,        /// @brief block tridiagonal solves along strongly coupled element lines (ElementLineImplicit)
+        DIRECT,               /// @brief sparse direct LU factorization (PCLU with MUMPS, SuperLU_dist, or petsc)
+        NONE                  /// @brief no preconditioner
+    };
+
+    /**
+     * @brief set up the preconditioner of a ksp for the DG jacobian
+     *
+     * The DG jacobian has one dense diagonal block per element
+     * and the off diagonal blocks couple the face neighbors (elsuel)
+     * - ELEMENT_BLOCK_JACOBI uses the element dof counts as variable block sizes of the matrix
+     * - ASM grows the subdomain of each process by overlap layers of the matrix graph
+     *   (one layer is the face neighbors of the elements on the process boundary)
+     * - GAMG uses one constant vector for each vector component as the near null space
+     * - LINE_IMPLICIT is a PCSHELL around ElementLineImplicit,
+     *   the lines and their factorization are rebuilt from the matrix whenever it changes
+     * - DIRECT factors the matrix with direct_package and solves with KSPPREONLY.
+     *   The nonzero structure of the jacobian is fixed by the DG connectivity
+     *   so petsc only repeats the numeric factorization when the values change
+     *   and the fill reducing ordering is kept even if the structure changes
+     *
+     * The petsc options database (i.e -pc_type) is applied after and overrides this configuration
+     */
+    struct PetscPreconditioner {
+
+        /// @brief the preconditioner type
+        PRECONDITIONER_TYPE type = PRECONDITIONER_TYPE::SOR;
+
+        /// @brief the fill level k of the ILU(k) sub solves of BLOCK_JACOBI and ASM
+        PetscInt ilu_levels = 0;
+
+        /// @brief the number of overlap layers for ASM
+        PetscInt overlap = 1;
+
+        /// @brief the coupling ratio for the line detection of LINE_IMPLICIT (see ElementLineImplicit)
+        PetscReal line_coupling_ratio = 4.0;
+
+        /// @brief the maximum number of elements in a line for LINE_IMPLICIT
+        PetscInt max_line_length = std::numeric_limits<PetscInt>::max();
+
+        /// @brief the factorization package of DIRECT: MATSOLVERMUMPS, MATSOLVERSUPERLU_DIST, or MATSOLVERPETSC
+        /// (the external packages need petsc configured with them)
+        std::string direct_package = MATSOLVERMUMPS;
+
+        /// @brief the percent increase of the estimated working space of the MUMPS factorization (ICNTL(14))
+        /// raise this if the factorization fails with a workspace error (negative keeps the MUMPS default)
+        PetscInt direct_memory_relaxation = -1;
+
+        /// @brief the maximum memory in MB per process for the MUMPS factorization (ICNTL(23), 0 is unlimited)
+        PetscInt direct_max_memory = 0;
+
+        /**
+         * @brief set the preconditioner type and the matrix information it uses
+         * call before the ksp is set up (after the matrix is created)
+         *
+         * @param ksp the linear solver
+         * @param jac the jacobian matrix (preallocated with block size neq)
+         * @param fespace the finite element space
+         * @param neq the number of vector components per dof
+         */
+        template<class T, class IDX, int ndim>
+        auto setup(KSP ksp, Mat jac, FESpace<T, IDX, ndim>& fespace, IDX neq) -> void {
+            PC pc;
+            PetscCallAbort(PETSC_COMM_WORLD, KSPGetPC(ksp, &pc));
+            sub_solvers_set = false;
+            switch(type){
+                case PRECONDITIONER_TYPE::SOR:
+                    PetscCallAbort(PETSC_COMM_WORLD, PCSetType(pc, PCSOR));
+                    break;
+                case PRECONDITIONER_TYPE::ELEMENT_BLOCK_JACOBI:
+                {
+                    std::vector<PetscInt> block_sizes(fespace.elements.size());
+                    for(std::size_t iel = 0; iel < block_sizes.size(); ++iel)
+                        { block_sizes[iel] = fespace.dg_map.ndof_el(iel) * neq; }
+                    PetscCallAbort(PETSC_COMM_WORLD,
+                            MatSetVariableBlockSizes(jac, block_sizes.size(), block_sizes.data()));
+                    PetscCallAbort(PETSC_COMM_WORLD, PCSetType(pc, PCVPBJACOBI));
+                    break;
+                }
+                case PRECONDITIONER_TYPE::BLOCK_JACOBI:
+                    PetscCallAbort(PETSC_COMM_WORLD, PCSetType(pc, PCBJACOBI));
+                    break;
+                case PRECONDITIONER_TYPE::ASM:
+                    PetscCallAbort(PETSC_COMM_WORLD, PCSetType(pc, PCASM));
+                    PetscCallAbort(PETSC_COMM_WORLD, PCASMSetOverlap(pc, overlap));
+                    break;
+                case PRECONDITIONER_TYPE::GAMG:
+                {
+                    // dofs are vector component fastest
+                    // the constant of each component is an orthonormal near null space vector
+                    PetscInt local_size, start;
+                    PetscCallAbort(PETSC_COMM_WORLD, MatGetLocalSize(jac, &local_size, nullptr));
+                    PetscCallAbort(PETSC_COMM_WORLD, MatGetOwnershipRange(jac, &start, nullptr));
+                    std::vector<Vec> modes(neq);
+                    for(IDX ieq = 0; ieq < neq; ++ieq){
+                        PetscCallAbort(PETSC_COMM_WORLD, MatCreateVecs(jac, &modes[ieq], nullptr));
+                        PetscScalar* data;
+                        PetscCallAbort(PETSC_COMM_WORLD, VecGetArray(modes[ieq], &data));
+                        for(PetscInt i = 0; i < local_size; ++i)
+                            { data[i] = ((start + i) % neq == ieq) ? 1.0 : 0.0; }
+                        PetscCallAbort(PETSC_COMM_WORLD, VecRestoreArray(modes[ieq], &data));
+                        PetscCallAbort(PETSC_COMM_WORLD, VecNormalize(modes[ieq], nullptr));
+                    }
+                    MatNullSpace near_null_space;
+                    PetscCallAbort(PETSC_COMM_WORLD, MatNullSpaceCreate(PETSC_COMM_WORLD,
+                                PETSC_FALSE, neq, modes.data(), &near_null_space));
+                    PetscCallAbort(PETSC_COMM_WORLD, MatSetNearNullSpace(jac, near_null_space));
+                    PetscCallAbort(PETSC_COMM_WORLD, MatNullSpaceDestroy(&near_null_space));
+                    for(Vec& mode : modes) PetscCallAbort(PETSC_COMM_WORLD, VecDestroy(&mode));
+                    PetscCallAbort(PETSC_COMM_WORLD, PCSetType(pc, PCGAMG));
+                    break;
+                }
+                case PRECONDITIONER_TYPE::LINE_IMPLICIT:
+                {
+                    line_pc = std::make_shared<ElementLineImplicit<PetscScalar, PetscInt>>();
+                    line_pc->coupling_ratio = line_coupling_ratio;
+                    line_pc->max_line_length = max_line_length;
+                    line_pc->set_structure(fespace, neq);
+                    PetscCallAbort(PETSC_COMM_WORLD, PCSetType(pc, PCSHELL));
+                    PetscCallAbort(PETSC_COMM_WORLD, PCShellSetContext(pc, (void *) line_pc.get()));
+                    PetscCallAbort(PETSC_COMM_WORLD, PCShellSetSetUp(pc,
+                                impl::line_implicit_pc_setup<PetscScalar, PetscInt>));
+                    PetscCallAbort(PETSC_COMM_WORLD, PCShellSetApply(pc,
+                                impl::line_implicit_pc_apply<PetscScalar, PetscInt>));
+                    PetscCallAbort(PETSC_COMM_WORLD, PCShellSetName(pc, "element line implicit"));
+                    break;
+                }
+                case PRECONDITIONER_TYPE::DIRECT:
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSetType(ksp, KSPPREONLY));
+                    PetscCallAbort(PETSC_COMM_WORLD, PCSetType(pc, PCLU));
+                    PetscCallAbort(PETSC_COMM_WORLD, PCFactorSetMatSolverType(pc, direct_package.c_str()));
+                    PetscCallAbort(PETSC_COMM_WORLD, PCFactorSetReuseOrdering(pc, PETSC_TRUE));
+                    PetscCallAbort(PETSC_COMM_WORLD, PCFactorSetReuseFill(pc, PETSC_TRUE));
+                    break;
+                case PRECONDITIONER_TYPE::NONE:
+                    PetscCallAbort(PETSC_COMM_WORLD, PCSetType(pc, PCNONE));
+                    break;
+            }
+        }
+
+        /**
+         * @brief set the ILU(k) sub solves of BLOCK_JACOBI and ASM 
+         * and the memory controls of the DIRECT factorization
+         * the sub solvers only exist after the preconditioner is set up
+         * so this sets up the ksp (call after KSPSetOperators)
+         * this only acts on the first call after setup()
+         *
+         * @param ksp the linear solver
+         */
+        auto setup_sub_solvers(KSP ksp) -> void {
+            if(sub_solvers_set) return;
+            sub_solvers_set = true;
+            if(type == PRECONDITIONER_TYPE::DIRECT) {
+                setup_direct_factorization(ksp);
+                return;
+            }
+            if(type != PRECONDITIONER_TYPE::BLOCK_JACOBI && type != PRECONDITIONER_TYPE::ASM) return;
+
+            PC pc;
+            PetscCallAbort(PETSC_COMM_WORLD, KSPGetPC(ksp, &pc));
+            PCType pc_type;
+            PetscCallAbort(PETSC_COMM_WORLD, PCGetType(pc, &pc_type));
+            PetscBool is_bjacobi, is_asm;
+            PetscCallAbort(PETSC_COMM_WORLD, PetscStrcmp(pc_type, PCBJACOBI, &is_bjacobi));
+            PetscCallAbort(PETSC_COMM_WORLD, PetscStrcmp(pc_type, PCASM, &is_asm));
+            // the options database changed the type
+            if(!is_bjacobi && !is_asm) return;
+
+            PetscCallAbort(PETSC_COMM_WORLD, KSPSetUp(ksp));
+            PetscInt nlocal;
+            KSP* sub_ksps;
+            if(is_bjacobi) PetscCallAbort(PETSC_COMM_WORLD, PCBJacobiGetSubKSP(pc, &nlocal, nullptr, &sub_ksps));
+            else PetscCallAbort(PETSC_COMM_WORLD, PCASMGetSubKSP(pc, &nlocal, nullptr, &sub_ksps));
+            for(PetscInt iblock = 0; iblock < nlocal; ++iblock){
+                PC sub_pc;
+                PetscCallAbort(PETSC_COMM_WORLD, KSPGetPC(sub_ksps[iblock], &sub_pc));
+                PetscCallAbort(PETSC_COMM_WORLD, PCSetType(sub_pc, PCILU));
+                PetscCallAbort(PETSC_COMM_WORLD, PCFactorSetLevels(sub_pc, ilu_levels));
+                // the sub solver options (i.e -sub_pc_type) override
+                PetscCallAbort(PETSC_COMM_WORLD, KSPSetFromOptions(sub_ksps[iblock]));
+            }
+        }
+
+        private:
+
+        /// @brief create the factor matrix of DIRECT and apply the MUMPS memory controls
+        /// (before the first factorization)
+        auto setup_direct_factorization(KSP ksp) -> void {
+            PC pc;
+            PetscCallAbort(PETSC_COMM_WORLD, KSPGetPC(ksp, &pc));
+            PCType pc_type;
+            PetscCallAbort(PETSC_COMM_WORLD, PCGetType(pc, &pc_type));
+            PetscBool is_lu;
+            PetscCallAbort(PETSC_COMM_WORLD, PetscStrcmp(pc_type, PCLU, &is_lu));
+            // the options database changed the type
+            if(!is_lu) return;
+
+            MatSolverType solver_type;
+            PetscCallAbort(PETSC_COMM_WORLD, PCFactorGetMatSolverType(pc, &solver_type));
+            PetscBool is_mumps;
+            PetscCallAbort(PETSC_COMM_WORLD, PetscStrcmp(solver_type, MATSOLVERMUMPS, &is_mumps));
+            if(!is_mumps) return;
+
+            PetscCallAbort(PETSC_COMM_WORLD, PCFactorSetUpMatSolverType(pc));
+            Mat factor;
+            PetscCallAbort(PETSC_COMM_WORLD, PCFactorGetMatrix(pc, &factor));
+            if(direct_memory_relaxation >= 0)
+                PetscCallAbort(PETSC_COMM_WORLD, MatMumpsSetIcntl(factor, 14, direct_memory_relaxation));
+            if(direct_max_memory > 0)
+                PetscCallAbort(PETSC_COMM_WORLD, MatMumpsSetIcntl(factor, 23, direct_max_memory));
+            // the mumps options (i.e -mat_mumps_icntl_14) are read at the factorization and override
+        }
+
+        /// @brief if the sub solvers have been configured since setup()
+        bool sub_solvers_set = false;
+
+        /// @brief the shell context of LINE_IMPLICIT (shared by copies so the ksp context stays valid)
+        std::shared_ptr<ElementLineImplicit<PetscScalar, PetscInt>> line_pc{};
+    };
+}
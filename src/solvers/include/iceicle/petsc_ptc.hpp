@@ -0,0 +1,443 @@
+/**
+ * @brief pseudo-transient continuation solver that uses petsc as a backend
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/element/finite_element.hpp"
+#include "iceicle/explicit_utils.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/form_petsc_jacobian.hpp"
+#include "iceicle/form_residual.hpp"
+#include "iceicle/krylov_method.hpp"
+#include "iceicle/krylov_recycling.hpp"
+#include "iceicle/nonlinear_solver_utils.hpp"
+#include "iceicle/petsc_interface.hpp"
+#include "iceicle/petsc_preconditioner.hpp"
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <petscerror.h>
+#include <petscksp.h>
+#include <petscmat.h>
+#include <petscpc.h>
+#include <petscsys.h>
+#include <petscvec.h>
+
+namespace iceicle::solvers {
+
+    /**
+     * @brief Pseudo-transient continuation (PTC) solver for steady problems
+     *
+     * Each iteration takes a backward Euler step in pseudo-time with a local timestep per element
+     * (M / dt_el - dR/du) du = R(u)
+     * where the residual convention is M du/dt = R(u) (same as the explicit solvers)
+     *
+     * The local timesteps are from CFLTimestep::local_timesteps
+     * and the CFL is grown by switched evolution relaxation (SER)
+     * cfl_{k+1} = cfl_k (||R_{k-1}|| / ||R_k||)^ser_exponent
+     * so the iteration approaches Newton's method as the residual converges
+     *
+     * @tparam T the floating point type
+     * @tparam IDX the index type
+     * @tparam ndim the number of dimensions
+     * @tparam disc_class the discretization
+     * @tparam ls_type the linesearch type to use
+     */
+    template<class T, class IDX, int ndim, class disc_class, class ls_type = no_linesearch<T, IDX>>
+    class PetscPTC {
+
+        // ================
+        // = Data Members =
+        // ================
+        private:
+        /// @brief the Jacobian Matrix
+        Mat jac;
+
+        /// @brief the storage for the residual vector
+        Vec res_data;
+
+        /// @brief storage for the solution update vector
+        Vec du_data;
+
+        /// @brief the linear solver
+        KSP ksp;
+
+        /// @brief the preconditioner
+        PC pc;
+
+        /// @brief the element coloring for colored finite differences (built on first use)
+        util::crs<IDX, IDX> el_colors;
+
+        /// @brief the preconditioner configuration
+        PetscPreconditioner preconditioner{};
+
+        public:
+
+        // ============
+        // = Typedefs =
+        // ============
+        using value_type = T;
+        using index_type = IDX;
+
+        /// @brief store a reference to the fespace being used
+        FESpace<T, IDX, ndim> &fespace;
+
+        /// @brief store a reference to the discretization being solved
+        disc_class &disc;
+
+        /// @brief the linesearch strategy
+        const ls_type& linesearch;
+
+        /// @brief the convergence Criteria
+        /// determines whether the solver should terminate
+        ConvergenceCriteria<T, IDX> conv_criteria;
+
+        /// @brief persistent storage for residual evaluation
+        ResidualWorkspace<T, IDX> workspace;
+
+        /// @brief the initial CFL number
+        T cfl0 = 1.0;
+
+        /// @brief the maximum CFL number
+        T cfl_max = 1e8;
+
+        /// @brief the exponent for the switched evolution relaxation CFL update
+        T ser_exponent = 1.0;
+
+        /// @brief the current CFL number
+        T cfl = cfl0;
+
+        /// @brief if true, form the finite difference jacobian by perturbing
+        /// all the elements of a distance-2 element coloring at once
+        /// (see form_petsc_jacobian_fd_colored)
+        bool fd_coloring = false;
+
+        /// @brief adaptive relative tolerance for the linear solves
+        /// (disabled by default: the KSP tolerances are used)
+        EisenstatWalkerForcing<T> forcing{};
+
+        /// @brief if this is a positive integer
+        /// Then the diagnostics callback will be called every idiag timesteps
+        /// (k % idiag == 0)
+        IDX idiag = -1;
+
+        /// @brief set the verbosity level to print out different diagnostic information
+        ///
+        /// Level 0: no extra output
+        /// Level 1:
+        ///   - linesearch iterations and multiplier
+        ///   - the CFL number of each iteration
+        IDX verbosity = 0;
+
+        /// @brief diagnostics function
+        /// Passes the current iteration number, the residual vector, and the du vector
+        std::function<void(IDX, Vec, Vec)> diag_callback = []
+            (IDX k, Vec res_data, Vec du_data)
+        {
+            int iproc;
+            MPI_Comm_rank(PETSC_COMM_WORLD, &iproc);
+            if(iproc == 0){
+                std::cout << "Diagnostics for iteration: " << k << std::endl;
+            }
+            if(iproc == 0) std::cout << "Residual: " << std::endl;
+            PetscCallAbort(PETSC_COMM_WORLD, VecView(res_data, PETSC_VIEWER_STDOUT_WORLD));
+            if(iproc == 0) std::cout << std::endl << "du: " << std::endl;
+            PetscCallAbort(PETSC_COMM_WORLD, VecView(du_data, PETSC_VIEWER_STDOUT_WORLD));
+            if(iproc == 0) std::cout << "------------------------------------------" << std::endl << std::endl;
+        };
+
+        /// @brief if this is a positive integer
+        /// Then the diagnostics callback will be called every ivis timesteps
+        /// (k % ivis == 0)
+        IDX ivis = -1;
+
+        /// @brief the callback function for visualization during solve()
+        /// Passes the current iteration number, the residual vector, and the du vector
+        std::function<void(IDX, Vec, Vec)> vis_callback = []
+            (IDX k, Vec res_data, Vec du_data)
+        {
+            T res_norm;
+            PetscCallAbort(PETSC_COMM_WORLD, VecNorm(res_data, NORM_2, &res_norm));
+            std::cout << std::setprecision(8);
+            std::cout << "itime: " << std::setw(6) << k
+                << " | residual l2: " << std::setw(14) << res_norm
+                << std::endl;
+        };
+
+        // ================
+        // = Constructors =
+        // ================
+
+        /**
+         * @brief Construct the PTC Solver
+         * @param fespace the finite element space
+         * @param disc the discretization
+         * @param conv_criteria the convergence criteria for terminating the solve
+         * @param linesearch the linesearch strategy
+         */
+        PetscPTC(
+            FESpace<T, IDX, ndim> &fespace,
+            disc_class &disc,
+            const ConvergenceCriteria<T, IDX> &conv_criteria,
+            const ls_type& linesearch
+        ) : fespace(fespace), disc(disc), linesearch{linesearch},
+            conv_criteria{conv_criteria}, workspace{fespace, disc_class::dnv_comp}
+        {
+            PetscInt local_size = fespace.dg_map.calculate_size_requirement(disc_class::dnv_comp);
+
+            // Create and set up the matrix
+            MatCreate(PETSC_COMM_WORLD, &jac);
+            MatSetSizes(jac, local_size, local_size, PETSC_DETERMINE, PETSC_DETERMINE);
+            MatSetBlockSize(jac, disc_class::dnv_comp);
+            MatSetFromOptions(jac);
+            preallocate_petsc_jacobian(fespace, disc_class::dnv_comp, jac);
+
+            // Create and set up the vectors
+            VecCreate(PETSC_COMM_WORLD, &res_data);
+            VecSetSizes(res_data, local_size, PETSC_DETERMINE);
+            VecSetFromOptions(res_data);
+
+            VecCreate(PETSC_COMM_WORLD, &du_data);
+            VecSetSizes(du_data, local_size, PETSC_DETERMINE);
+            VecSetFromOptions(du_data);
+
+            // Create the linear solver and preconditioner
+            PetscCallAbort(PETSC_COMM_WORLD, KSPCreate(PETSC_COMM_WORLD, &ksp));
+
+            // default to sor preconditioner (see set_preconditioner)
+            PetscCallAbort(PETSC_COMM_WORLD, KSPGetPC(ksp, &pc));
+            preconditioner.setup(ksp, jac, fespace, (IDX) disc_class::dnv_comp);
+
+            // Get user input (can override defaults set above)
+            PetscCallAbort(PETSC_COMM_WORLD, KSPSetFromOptions(ksp));
+        }
+
+        PetscPTC(
+            FESpace<T, IDX, ndim> &fespace,
+            disc_class &disc,
+            const ConvergenceCriteria<T, IDX> &conv_criteria
+        ) : PetscPTC(fespace, disc, conv_criteria, no_linesearch<T, IDX>{}) {}
+
+        // ====================
+        // = Member Functions =
+        // ====================
+
+        /**
+         * @brief replace the preconditioner of the linear solves
+         * the petsc options database is applied again after and takes precedence
+         * @param config the preconditioner configuration
+         */
+        auto set_preconditioner(const PetscPreconditioner& config) -> void {
+            preconditioner = config;
+            preconditioner.setup(ksp, jac, fespace, (IDX) disc_class::dnv_comp);
+            PetscCallAbort(PETSC_COMM_WORLD, KSPSetFromOptions(ksp));
+        }
+
+        /**
+         * @brief set the Krylov method of the linear solves
+         * the petsc options database is applied again after and takes precedence
+         * @param config the Krylov method configuration
+         */
+        auto set_krylov_method(const KrylovMethod& config) -> void {
+            config.setup(ksp);
+            PetscCallAbort(PETSC_COMM_WORLD, KSPSetFromOptions(ksp));
+        }
+
+        /**
+         * @brief reuse a Krylov subspace across the linear solves
+         * the petsc options database is applied again after and takes precedence
+         * @param config the recycling configuration
+         */
+        auto set_krylov_recycling(const KrylovRecycling& config) -> void {
+            config.setup(ksp);
+            PetscCallAbort(PETSC_COMM_WORLD, KSPSetFromOptions(ksp));
+        }
+
+        /**
+         * @brief form the residual and the pseudo-transient system matrix dR/du - M / dt
+         * @param [in] u the current solution
+         * @param [out] res the residual
+         */
+        template<class uLayoutPolicy, class resLayoutPolicy>
+        auto form_system(fespan<T, uLayoutPolicy> u, fespan<T, resLayoutPolicy> res) -> void {
+            using namespace std::experimental;
+            MatZeroEntries(jac);
+            if(fd_coloring){
+                if(el_colors.nrow() == 0) el_colors = color_elements_distance2(fespace);
+                form_petsc_jacobian_fd_colored(fespace, disc, u, res, jac, el_colors, workspace);
+            } else {
+                form_petsc_jacobian_fd(fespace, disc, u, res, jac);
+            }
+
+            PetscInt proc_range_beg, proc_range_end;
+            PetscCallAbort(PETSC_COMM_WORLD, MatGetOwnershipRange(jac, &proc_range_beg, &proc_range_end));
+
+            // subtract the mass matrix scaled by the local timestep from the diagonal blocks
+            // (the step is subtracted: u -= du)
+            const std::size_t nv = disc_class::dnv_comp;
+            std::vector<T> dt_el = CFLTimestep<T, IDX>{cfl}.local_timesteps(fespace, disc, u);
+            std::vector<T> block_data{};
+            for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+                MATH::MATRIX::DenseMatrix<T> mass = calculate_mass_matrix(el);
+                const std::size_t n = el.nbasis() * nv;
+                block_data.assign(n * n, 0.0);
+                mdspan block{block_data.data(), extents{n, n}};
+                for(std::size_t idof = 0; idof < el.nbasis(); ++idof){
+                    for(std::size_t jdof = 0; jdof < el.nbasis(); ++jdof){
+                        for(std::size_t iv = 0; iv < nv; ++iv)
+                            { block[idof * nv + iv, jdof * nv + iv] = -mass[idof][jdof] / dt_el[el.elidx]; }
+                    }
+                }
+                std::size_t glob_index_el = u.get_layout()[el.elidx, 0, 0];
+                petsc::add_to_petsc_mat(jac, proc_range_beg + glob_index_el,
+                        proc_range_beg + glob_index_el, block);
+            }
+            MatAssemblyBegin(jac, MAT_FINAL_ASSEMBLY);
+            MatAssemblyEnd(jac, MAT_FINAL_ASSEMBLY);
+        }
+
+        /**
+         * @brief solve the steady nonlinear pde defined by disc and fespace
+         * @tparam uLayoutPolicy the layout of the input solution
+         * NOTE: since u is modified it must use the default accessor policy
+         *
+         * @param [in/out] u the discretized solution coefficients.
+         * The given values are used as the initial guess.
+         * After this function, this holds the solution
+         * @return the number of iterations performed (can discard)
+         */
+        template<class uLayoutPolicy>
+        auto solve(fespan<T, uLayoutPolicy> u) -> IDX {
+
+            // get the initial residual
+            update_cached_state(fespace, disc, u);
+            {
+                petsc::VecSpan res_view{res_data};
+                fespan res{res_view.data(), u.get_layout()};
+                form_residual(fespace, disc, u, res, workspace);
+            }
+            PetscCallAbort(PETSC_COMM_WORLD, VecNorm(res_data, NORM_2, &(conv_criteria.r0)));
+            T r_cur = conv_criteria.r0, r_prev = 0, lin_rnorm = 0;
+            cfl = cfl0;
+
+            IDX k;
+            for(k = 0; k < conv_criteria.kmax; ++k){
+
+                // form the pseudo-transient system at the current CFL
+                {
+                    petsc::VecSpan res_view{res_data};
+                    fespan res{res_view.data(), u.get_layout()};
+                    form_system(u, res);
+                }
+                if(verbosity >= 1) std::cout << "ptc: cfl = " << cfl << std::endl;
+
+                // solve for du
+                if(forcing.choice != 0){
+                    T tau = conv_criteria.tau_abs + conv_criteria.tau_rel * conv_criteria.r0;
+                    T eta = forcing.forcing_term(k, r_cur, r_prev, lin_rnorm, tau);
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSetTolerances(ksp, eta, PETSC_DEFAULT, PETSC_DEFAULT, PETSC_DEFAULT));
+                }
+                PetscCallAbort(PETSC_COMM_WORLD, KSPSetOperators(ksp, jac, jac));
+                preconditioner.setup_sub_solvers(ksp);
+                {
+                    ICEICLE_PROFILE_REGION("ksp_solve");
+                    PetscCallAbort(PETSC_COMM_WORLD, KSPSolve(ksp, res_data, du_data));
+                }
+                PetscCallAbort(PETSC_COMM_WORLD, KSPGetResidualNorm(ksp, &lin_rnorm));
+
+                // update u
+                bool residual_current = false;
+                {
+                    petsc::VecSpan du_view{du_data};
+                    fespan du{du_view.data(), u.get_layout()};
+                    if constexpr (std::is_same_v<ls_type, no_linesearch<T, IDX>>){
+                        axpy(-1.0, du, u);
+                    } else {
+                        // u step and working residual for linesearch
+                        std::vector<T> u_step_storage(u.size());
+                        fespan u_step{u_step_storage.data(), u.get_layout()};
+                        std::vector<T> r_work_storage(u.size());
+                        fespan res_work{r_work_storage.data(), u.get_layout()};
+
+                        // the alpha that res_work holds the residual for
+                        T alpha_evaluated = std::numeric_limits<T>::quiet_NaN();
+
+                        T alpha = linesearch([&](T alpha_arg){
+                            static constexpr T BIG_RESIDUAL = 1e9;
+                            copy_fespan(u, u_step);
+                            axpy(-alpha_arg, du, u_step);
+                            form_residual(fespace, disc, u_step, res_work, workspace);
+                            alpha_evaluated = alpha_arg;
+                            T rnorm = res_work.vector_norm();
+                            if(verbosity >= 1){
+                                std::cout << "linesearch: alpha = " << alpha_arg << " | linesearch residual = " << rnorm << std::endl;
+                            }
+                            return std::isfinite(rnorm) ? rnorm : BIG_RESIDUAL;
+                        });
+                        if(verbosity >= 1) std::cout << "linesearch: selected alpha = " << alpha << std::endl;
+                        axpy(-alpha, du, u);
+
+                        // the last trial was the accepted step so its residual is the new residual
+                        if(alpha == alpha_evaluated){
+                            petsc::VecSpan res_view{res_data};
+                            std::ranges::copy(r_work_storage, res_view.data());
+                            residual_current = true;
+                        }
+                    }
+                }
+
+                // update the data cached by the discretization for the new iterate
+                // (an accepted trial residual was evaluated with the old data)
+                if(update_cached_state(fespace, disc, u)) residual_current = false;
+
+                // Get the new residual
+                if(!residual_current) {
+                    petsc::VecSpan res_view{res_data};
+                    fespan res{res_view.data(), u.get_layout()};
+                    form_residual(fespace, disc, u, res, workspace);
+                }
+                T rk;
+                PetscCallAbort(PETSC_COMM_WORLD, VecNorm(res_data, NORM_2, &rk));
+
+                // switched evolution relaxation
+                if(std::isfinite(rk) && rk > 0)
+                    cfl = std::min(cfl_max, cfl * std::pow(r_cur / rk, ser_exponent));
+                r_prev = r_cur;
+                r_cur = rk;
+
+                // Diagnostics
+                if(idiag > 0 && k % idiag == 0) {
+                    diag_callback(k, res_data, du_data);
+                }
+
+                // visualization
+                if(ivis > 0 && k % ivis == 0) {
+                    vis_callback(k, res_data, du_data);
+                }
+
+                // test convergence
+                if(conv_criteria.done_callback(rk)) break;
+            }
+            return k;
+        }
+
+        ~PetscPTC(){
+            VecDestroy(&res_data);
+            VecDestroy(&du_data);
+            MatDestroy(&jac);
+            KSPDestroy(&ksp);
+        }
+    };
+
+    /// Deduction guides
+    template<class T, class IDX, int ndim, class disc_class, class ls_type>
+    PetscPTC(FESpace<T, IDX, ndim> &, disc_class &,
+        const ConvergenceCriteria<T, IDX> &, const ls_type&) -> PetscPTC<T, IDX, ndim, disc_class, ls_type>;
+
+    template<class T, class IDX, int ndim, class disc_class>
+    PetscPTC(FESpace<T, IDX, ndim> &, disc_class &,
+        const ConvergenceCriteria<T, IDX> &) -> PetscPTC<T, IDX, ndim, disc_class, no_linesearch<T, IDX>>;
+}
@@ -0,0 +1,168 @@
+/**
+ * @brief per-component residual norms accumulated during residual evaluation
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/reproducible_sum.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace iceicle::solvers {
+
+    /**
+     * @brief accumulates the L2 and Linf norm of each vector component of the residual
+     * while form_residual scatters, so the norms cost no extra pass over the residual
+     *
+     * Each element is accumulated once its residual is complete
+     * (after its domain integral, or after the parallel communication traces for elements on a process boundary).
+     * The norms are reduced over processes with nonblocking reductions started at the end of form_residual
+     * that overlap whatever the solver does next (i.e the inverse mass application);
+     * finish() waits for them.
+     * The sums of squares are util::reduction_sum accumulators so the norms do not depend
+     * on the number of threads or processes (see ICEICLE_REPRODUCIBLE_REDUCTIONS).
+     *
+     * @tparam T the floating point type
+     */
+    template<class T>
+    class ResidualNormMonitor {
+
+        /// @brief the number of vector components (0 when disabled)
+        std::size_t nv = 0;
+
+        /// @brief the per-thread sums of squares of each component [nthread x nv]
+        std::vector<util::reduction_sum<T>> thread_sums{};
+
+        /// @brief the per-thread maximum magnitude of each component [nthread x nv]
+        std::vector<T> thread_max{};
+
+        /// @brief the sums of squares being reduced or reduced
+        std::vector<util::reduction_sum<T>> sums{};
+
+        /// @brief the maximum magnitudes being reduced or reduced
+        std::vector<T> maxima{};
+
+        /// @brief the squared L2 norm of each component from the reduced sums
+        std::vector<T> l2_sq{};
+
+        mpi::reduction_request sum_request{}, max_request{};
+        bool pending = false;
+
+        public:
+
+#ifdef ICEICLE_USE_MPI
+        /// @brief the communicator the norms are reduced over
+        MPI_Comm comm = MPI_COMM_WORLD;
+#endif
+
+        ResidualNormMonitor() = default;
+        ResidualNormMonitor(const ResidualNormMonitor&) = default;
+        ResidualNormMonitor& operator=(const ResidualNormMonitor&) = default;
+        ~ResidualNormMonitor() { finish(); }
+
+        /**
+         * @brief start monitoring the residual norms
+         * @param ncomp the number of vector components of the residual
+         * @param nthread the number of threads that accumulate concurrently
+         */
+        void enable(std::size_t ncomp, int nthread = 1) {
+            finish();
+            nv = ncomp;
+            thread_sums.assign(nv * std::max(nthread, 1), util::reduction_sum<T>{});
+            thread_max.assign(nv * std::max(nthread, 1), 0.0);
+            sums.assign(nv, util::reduction_sum<T>{});
+            maxima.assign(nv, 0.0);
+            l2_sq.assign(nv, 0.0);
+        }
+
+        /// @brief if the norms are being monitored
+        [[nodiscard]] auto enabled() const noexcept -> bool { return nv > 0; }
+
+        /// @brief the number of vector components
+        [[nodiscard]] auto ncomp() const noexcept -> std::size_t { return nv; }
+
+        /// @brief zero the accumulators for a new residual evaluation
+        void begin_accumulate() {
+            for(auto& sum : thread_sums) sum.reset();
+            std::ranges::fill(thread_max, 0.0);
+        }
+
+        /**
+         * @brief accumulate the complete residual of an element
+         * @param ithread the thread index (threads must use distinct indices)
+         * @param iel the element index
+         * @param ndof the number of degrees of freedom of the element
+         * @param res the global residual view
+         */
+        template<class resSpan>
+        void accumulate(int ithread, std::size_t iel, std::size_t ndof, const resSpan& res) {
+            util::reduction_sum<T>* thread_sum = thread_sums.data() + nv * ithread;
+            T* thread_maxval = thread_max.data() + nv * ithread;
+            for(std::size_t idof = 0; idof < ndof; ++idof){
+                for(std::size_t iv = 0; iv < nv; ++iv){
+                    T r = res[iel, idof, iv];
+                    thread_sum[iv] += r * r;
+                    thread_maxval[iv] = std::max(thread_maxval[iv], std::abs(r));
+                }
+            }
+        }
+
+        /// @brief combine the thread accumulators and start the reduction over processes
+        void begin_reduction() {
+            finish();
+            for(auto& sum : sums) sum.reset();
+            std::ranges::fill(maxima, 0.0);
+            std::size_t nthread = thread_max.size() / std::max<std::size_t>(nv, 1);
+            for(std::size_t ithread = 0; ithread < nthread; ++ithread){
+                for(std::size_t iv = 0; iv < nv; ++iv){
+                    sums[iv] += thread_sums[nv * ithread + iv];
+                    maxima[iv] = std::max(maxima[iv], thread_max[nv * ithread + iv]);
+                }
+            }
+#ifdef ICEICLE_USE_MPI
+            sum_request = mpi::iallreduce_sums(std::span{sums}, comm);
+            max_request = mpi::iallreduce_max(std::span<T>{maxima}, comm);
+#else
+            sum_request = mpi::iallreduce_sums(std::span{sums});
+            max_request = mpi::iallreduce_max(std::span<T>{maxima});
+#endif
+            pending = true;
+        }
+
+        /// @brief wait for the reduction of the last residual (no-op if already done)
+        void finish() {
+            if(pending) {
+                sum_request.wait();
+                max_request.wait();
+                for(std::size_t iv = 0; iv < nv; ++iv) l2_sq[iv] = sums[iv].value();
+            }
+            pending = false;
+        }
+
+        /// @brief the L2 norm of component iv of the last residual
+        [[nodiscard]] auto l2(std::size_t iv) -> T { finish(); return std::sqrt(l2_sq[iv]); }
+
+        /// @brief the Linf norm of component iv of the last residual
+        [[nodiscard]] auto linf(std::size_t iv) -> T { finish(); return maxima[iv]; }
+
+        /// @brief the L2 norm of the last residual
+        [[nodiscard]] auto l2() -> T {
+            finish();
+            T sum = 0;
+            for(std::size_t iv = 0; iv < nv; ++iv) sum += l2_sq[iv];
+            return std::sqrt(sum);
+        }
+
+        /// @brief the Linf norm of the last residual
+        [[nodiscard]] auto linf() -> T {
+            finish();
+            T norm = 0;
+            for(std::size_t iv = 0; iv < nv; ++iv) norm = std::max(norm, maxima[iv]);
+            return norm;
+        }
+    };
+}
@@ -0,0 +1,379 @@
+/**
+ * @brief persistent storage for repeated residual evaluations
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/crs.hpp"
+#include "iceicle/disc/kernel_work.hpp"
+#include "iceicle/element_activity.hpp"
+#include "iceicle/element_cost.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/geometry/face.hpp"
+#include "iceicle/halo_exchange.hpp"
+#include "iceicle/residual_monitor.hpp"
+#include "iceicle/thread_utils.hpp"
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#ifdef ICEICLE_USE_TASK_POOL
+#include "iceicle/task_pool.hpp"
+#endif
+
+namespace iceicle::solvers {
+
+    /**
+     * @brief Workspace for form_residual that persists across calls
+     * Holds the element-local scratch storage (one set per thread),
+     * the halo exchange buffers, and the boundary trace orderings
+     * (with the ghost element and owning side of each parallel trace resolved up front)
+     * so that repeated residual evaluations do not allocate
+     *
+     * The workspace is valid as long as the connectivity of the FESpace
+     * it was constructed from does not change
+     *
+     * NOTE: for a distributed mesh the construction is collective over the ranks of each node
+     * when the halo exchange uses shared memory (see HaloExchange):
+     * every rank must construct the workspace, never inside rank dependent branches.
+     * Workspaces constructed per call (i.e the convenience form_residual) pass shared_memory = false
+     * so their construction makes no MPI calls.
+     *
+     * @tparam T the floating point type
+     * @tparam IDX the index type
+     */
+    template<class T, class IDX>
+    struct ResidualWorkspace {
+
+        /// @brief the number of scratch buffers per thread
+        static constexpr int nbuffer = 4;
+
+        /// @brief the size of each scratch buffer (largest element-local data size)
+        std::size_t max_local_size = 0;
+
+        /// @brief the number of threads scratch storage is allocated for
+        int nthread = 1;
+
+        /// @brief the scratch storage
+        /// nbuffer buffers of max_local_size for each thread
+        std::vector<T> scratch;
+
+        /// @brief the exchange of element data across process boundaries
+        HaloExchange<T, IDX> halo;
+
+        /// @brief the indices (into fespace.traces) of boundary traces
+        /// that are not parallel communication boundaries
+        /// sorted by boundary condition type then flag
+        std::vector<IDX> physical_bdy_traces;
+
+        /// @brief a contiguous range of physical_bdy_traces with the same boundary condition type
+        struct bdy_group {
+            BOUNDARY_CONDITIONS bctype;
+            std::size_t begin;
+            std::size_t end;
+        };
+
+        /// @brief the groups of physical_bdy_traces by boundary condition type
+        std::vector<bdy_group> physical_bdy_groups;
+
+        /// @brief the indices (into fespace.traces) of parallel communication traces
+        std::vector<IDX> parallel_com_traces;
+
+        /// @brief the ghost element index (see HaloExchange::ghost_index) 
+        /// of the remote side of each trace in parallel_com_traces
+        std::vector<IDX> parallel_com_ghosts;
+
+        /// @brief for each trace in parallel_com_traces
+        /// true if the left element is owned by this process
+        std::vector<char> parallel_com_imleft;
+
+        /// @brief the local elements adjacent to parallel communication traces (sorted, unique)
+        std::vector<IDX> parallel_com_elements;
+
+        /// @brief for each element true if it is in parallel_com_elements
+        std::vector<char> is_parallel_com_element;
+
+        /// @brief the number of traces ahead of the current interior trace 
+        /// whose element solution and residual data are prefetched in form_residual (0 disables)
+        int trace_prefetch_distance = 4;
+
+        /// @brief form_residual integrates the interior traces and domain element by element
+        /// instead of sweeping the traces then the elements (see enable_element_centric)
+        bool element_centric = false;
+
+        /// @brief for each element the interior traces (indices into fespace.traces) it is the left element of
+        /// these are integrated with the element domain integral
+        util::crs<IDX, IDX> el_owned_traces;
+
+        /// @brief for each element the interior traces it is the right element of
+        /// the residual of these is read from trace_res_cache
+        util::crs<IDX, IDX> el_received_traces;
+
+        /// @brief the offset of the right element residual of each interior trace in trace_res_cache
+        /// indexed from fespace.interior_trace_start
+        std::vector<std::size_t> trace_res_offsets;
+
+        /// @brief the right element residual of each interior trace (written once by the left element)
+        std::vector<T> trace_res_cache;
+
+        /// @brief the offset value of the interior traces without an interface conservation residual
+        static constexpr std::size_t no_ic_trace = std::numeric_limits<std::size_t>::max();
+
+        /// @brief form_residual also forms the interface conservation residual of the selected interior traces
+        /// into ic_res_cache with the combined trace kernel (see form_dg_mdg_residual)
+        bool collect_interface_conservation = false;
+
+        /// @brief the offset of the interface conservation residual of each interior trace in ic_res_cache
+        /// (no_ic_trace if the trace is not selected) indexed from fespace.interior_trace_start
+        std::vector<std::size_t> ic_res_offsets;
+
+        /// @brief the interface conservation residual of each selected interior trace
+        std::vector<T> ic_res_cache;
+
+        /// @brief optional per-component residual norms accumulated by form_residual
+        /// (disabled by default, see ResidualNormMonitor::enable)
+        ResidualNormMonitor<T> monitor;
+
+        /// @brief optional tracking of the elements whose residual is skipped
+        /// (disabled by default, see enable_activity_tracking)
+        ElementActivity<T, IDX> activity;
+
+        /// @brief optional sampled wall time of each element in form_residual
+        /// (disabled by default, see enable_cost_sampling)
+        ElementCost<T, IDX> cost;
+
+        /// @brief the analytic work of the boundary trace, interior and domain, and parallel trace phases
+        /// of form_residual for the profiler (computed on the first profiled evaluation)
+        std::optional<std::array<kernel_work, 3>> phase_work{};
+
+#ifdef ICEICLE_USE_TASK_POOL
+        /// @brief the number of tasks to aim for per thread in each task pool loop
+        /// (more tasks than threads lets work stealing even out uneven costs)
+        static constexpr int tasks_per_thread = 8;
+
+        /// @brief for each interior trace color the task ranges (indices into the color)
+        std::vector<std::vector<std::size_t>> color_task_bounds;
+
+        /// @brief for each element batch the task ranges (indices into the batch)
+        std::vector<std::vector<std::size_t>> batch_task_bounds;
+#endif
+
+        /// @brief default constructor: an empty workspace
+        ResidualWorkspace() = default;
+
+        /**
+         * @brief construct the workspace for a given finite element space
+         * @param fespace the finite element space
+         * @param nv the number of vector components per degree of freedom
+         * @param shared_memory exchange with neighbors on the same node through shared memory
+         * (the construction is then collective over the node for a distributed mesh)
+         */
+        template<int ndim>
+        ResidualWorkspace(FESpace<T, IDX, ndim>& fespace, std::size_t nv, bool shared_memory = true)
+        : max_local_size{fespace.dg_map.max_el_size_reqirement(nv)}, halo{fespace, nv, shared_memory}
+        {
+#ifdef ICEICLE_USE_TASK_POOL
+            nthread = util::global_task_pool().nthread();
+#else
+            nthread = util::max_threads();
+#endif
+            scratch.resize(nthread * nbuffer * max_local_size);
+
+            for(IDX itrace = fespace.bdy_trace_start; itrace < fespace.bdy_trace_end; ++itrace){
+                if(fespace.traces[itrace].face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM){
+                    parallel_com_traces.push_back(itrace);
+#ifdef ICEICLE_USE_MPI
+                    const auto& face = *(fespace.traces[itrace].face);
+                    auto [jrank, imleft] = decode_mpi_bcflag(face.bcflag);
+                    parallel_com_ghosts.push_back(halo.ghost_index(jrank, (imleft) ? face.elemR : face.elemL));
+                    parallel_com_imleft.push_back(imleft);
+                    parallel_com_elements.push_back((imleft) ? face.elemL : face.elemR);
+#endif
+                } else {
+                    physical_bdy_traces.push_back(itrace);
+                }
+            }
+
+            std::ranges::sort(parallel_com_elements);
+            auto [dup_begin, dup_end] = std::ranges::unique(parallel_com_elements);
+            parallel_com_elements.erase(dup_begin, dup_end);
+            is_parallel_com_element.assign(fespace.elements.size(), 0);
+            for(IDX iel : parallel_com_elements) is_parallel_com_element[iel] = 1;
+
+            // sort so the boundary condition is resolved once per group instead of once per trace
+            // stable to keep the mesh order within a boundary
+            auto bc_key = [&](IDX itrace){
+                const auto& face = *(fespace.traces[itrace].face);
+                return std::pair{face.bctype, face.bcflag};
+            };
+            std::ranges::stable_sort(physical_bdy_traces, {}, bc_key);
+            for(std::size_t i = 0; i < physical_bdy_traces.size(); ++i){
+                BOUNDARY_CONDITIONS bctype = fespace.traces[physical_bdy_traces[i]].face->bctype;
+                if(physical_bdy_groups.empty() || physical_bdy_groups.back().bctype != bctype)
+                    physical_bdy_groups.push_back(bdy_group{bctype, i, i});
+                physical_bdy_groups.back().end = i + 1;
+            }
+#ifdef ICEICLE_USE_TASK_POOL
+            build_task_bounds(fespace);
+#endif
+        }
+
+#ifdef ICEICLE_USE_TASK_POOL
+        private:
+        /**
+         * @brief split the element batches and interior trace colors into task ranges of similar cost
+         *
+         * The cost model is the number of basis functions times the number of quadrature points
+         * which is shared by all elements of the same FETypeKey (so is evaluated once per batch)
+         * and for traces uses the larger of the two neighboring elements
+         */
+        template<int ndim>
+        auto build_task_bounds(FESpace<T, IDX, ndim>& fespace) -> void {
+            std::vector<double> costs{};
+            double total_cost = 0;
+
+            std::vector<double> batch_costs(fespace.element_batches.nrow());
+            for(IDX ibatch = 0; ibatch < fespace.element_batches.nrow(); ++ibatch){
+                std::span<const IDX> elidxs = fespace.element_batches.rowspan(ibatch);
+                if(elidxs.size() == 0) continue;
+                const auto& el = fespace.elements[elidxs[0]];
+                batch_costs[ibatch] = (double) el.nbasis() * el.nQP();
+                total_cost += batch_costs[ibatch] * elidxs.size();
+            }
+            for(IDX icolor = 0; icolor < fespace.interior_trace_colors.nrow(); ++icolor){
+                for(IDX itrace : fespace.interior_trace_colors.rowspan(icolor)){
+                    const auto& trace = fespace.traces[itrace];
+                    total_cost += (double) std::max(trace.elL.nbasis(), trace.elR.nbasis()) * trace.nQP();
+                }
+            }
+            double target_cost = total_cost / (tasks_per_thread * nthread);
+
+            for(IDX ibatch = 0; ibatch < fespace.element_batches.nrow(); ++ibatch){
+                costs.assign(fespace.element_batches.rowspan(ibatch).size(), batch_costs[ibatch]);
+                batch_task_bounds.push_back(util::cost_balanced_bounds(std::span<const double>{costs}, target_cost));
+            }
+            for(IDX icolor = 0; icolor < fespace.interior_trace_colors.nrow(); ++icolor){
+                costs.clear();
+                for(IDX itrace : fespace.interior_trace_colors.rowspan(icolor)){
+                    const auto& trace = fespace.traces[itrace];
+                    costs.push_back((double) std::max(trace.elL.nbasis(), trace.elR.nbasis()) * trace.nQP());
+                }
+                color_task_bounds.push_back(util::cost_balanced_bounds(std::span<const double>{costs}, target_cost));
+            }
+        }
+        public:
+#endif
+
+        /**
+         * @brief use the element-centric traversal in form_residual
+         *
+         * Each element extracts its solution once, integrates its domain and the interior traces it is the left element of,
+         * and scatters once. The right element residual of those traces goes to a per-trace cache
+         * that the right element adds after all elements are done.
+         * Every write is to the residual of the element being processed so no trace coloring is needed.
+         *
+         * Call again if the basis orders of the fespace change (the cache is sized by the element sizes)
+         *
+         * @param fespace the finite element space
+         * @param nv the number of vector components per degree of freedom
+         */
+        template<int ndim>
+        void enable_element_centric(FESpace<T, IDX, ndim>& fespace, std::size_t nv) {
+            element_centric = true;
+            std::vector<std::vector<IDX>> owned(fespace.elements.size()), received(fespace.elements.size());
+            trace_res_offsets.resize(fespace.interior_trace_end - fespace.interior_trace_start);
+            std::size_t cache_size = 0;
+            for(std::size_t itrace = fespace.interior_trace_start; itrace < fespace.interior_trace_end; ++itrace){
+                const auto& trace = fespace.traces[itrace];
+                owned[trace.elL.elidx].push_back(itrace);
+                received[trace.elR.elidx].push_back(itrace);
+                trace_res_offsets[itrace - fespace.interior_trace_start] = cache_size;
+                cache_size += trace.elR.nbasis() * nv;
+            }
+            el_owned_traces = util::crs<IDX, IDX>{owned};
+            el_received_traces = util::crs<IDX, IDX>{received};
+            trace_res_cache.resize(cache_size);
+        }
+
+        /**
+         * @brief set the traces to collect the interface conservation residual of
+         * only the interior traces are collected (boundary traces are left to form_mdg_residual)
+         *
+         * @param fespace the finite element space
+         * @param selected_traces the indices of the traces (into fespace.traces) of the interface conservation
+         * @param nv the number of vector components of the interface conservation residual
+         */
+        template<int ndim>
+        void set_interface_conservation_traces(FESpace<T, IDX, ndim>& fespace,
+                std::span<const IDX> selected_traces, std::size_t nv) {
+            ic_res_offsets.assign(fespace.interior_trace_end - fespace.interior_trace_start, no_ic_trace);
+            std::size_t cache_size = 0;
+            for(IDX itrace : selected_traces){
+                if(itrace < (IDX) fespace.interior_trace_start || itrace >= (IDX) fespace.interior_trace_end) continue;
+                ic_res_offsets[itrace - fespace.interior_trace_start] = cache_size;
+                cache_size += fespace.traces[itrace].nbasis_trace() * nv;
+            }
+            ic_res_cache.resize(cache_size);
+        }
+
+        /// @brief the offset of the interface conservation residual of an interior trace (or no_ic_trace)
+        template<int ndim>
+        [[nodiscard]] auto ic_res_offset(const FESpace<T, IDX, ndim>& fespace, IDX itrace) const noexcept -> std::size_t {
+            if(itrace < (IDX) fespace.interior_trace_start || itrace >= (IDX) fespace.interior_trace_end) return no_ic_trace;
+            return ic_res_offsets[itrace - fespace.interior_trace_start];
+        }
+
+        /**
+         * @brief accumulate the per-component residual norms in every form_residual with this workspace
+         * @param nv the number of vector components of the residual
+         */
+        void enable_norm_monitor(std::size_t nv) { monitor.enable(nv, nthread); }
+
+        /**
+         * @brief skip the residual of elements whose state and residual stay within tolerance of their neighbors
+         * (see ElementActivity), rechecked every recheck_interval form_residual calls with this workspace
+         *
+         * @param fespace the finite element space
+         * @param nv the number of vector components per degree of freedom
+         * @param residual_tol the largest residual coefficient magnitude of an element to deactivate
+         * @param state_tol the largest difference of the element average states of neighboring inactive elements
+         * @param recheck_interval the number of residual evaluations between rechecks
+         * @param pin_sources if the discretization has a source term (then no element is deactivated)
+         */
+        template<int ndim>
+        void enable_activity_tracking(FESpace<T, IDX, ndim>& fespace, std::size_t nv,
+                T residual_tol, T state_tol, std::size_t recheck_interval, bool pin_sources = false) {
+            activity.residual_tol = residual_tol;
+            activity.state_tol = state_tol;
+            activity.recheck_interval = recheck_interval;
+            activity.enable(fespace, nv, is_parallel_com_element, pin_sources);
+        }
+
+        /**
+         * @brief measure the wall time form_residual spends on each element and phase
+         * every sample_interval calls with this workspace (see ElementCost)
+         *
+         * @param fespace the finite element space
+         * @param sample_interval the number of residual evaluations between timed evaluations
+         */
+        template<int ndim>
+        void enable_cost_sampling(FESpace<T, IDX, ndim>& fespace, std::size_t sample_interval) {
+            cost.sample_interval = sample_interval;
+            cost.enable(fespace.elements.size());
+        }
+
+        /**
+         * @brief get a scratch buffer
+         * @param ithread the thread index
+         * @param ibuffer the buffer index (0 <= ibuffer < nbuffer)
+         * @return pointer to the start of the scratch buffer of size max_local_size
+         */
+        auto scratch_data(int ithread, int ibuffer) -> T* {
+            return scratch.data() + (ithread * nbuffer + ibuffer) * max_local_size;
+        }
+    };
+}
@@ -0,0 +1,267 @@
+/**
+ * @file solution_transfer.hpp
+ * @brief L2 projection of a solution between non-matching finite element spaces
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/element/finite_element.hpp"
+#include "iceicle/element_linear_solve.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/fespace/point_location.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/thread_utils.hpp"
+#include <Numtool/fixed_size_tensor.hpp>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+#ifdef ICEICLE_USE_MPI
+#include "iceicle/mpi_type.hpp"
+#include <mpi.h>
+#endif
+
+namespace iceicle::solvers {
+
+    /**
+     * @brief transfers solutions from a source finite element space to a target space
+     * on a different (non-matching, refined, coarsened, or differently partitioned) mesh
+     * or with a different polynomial order, by L2 projection:
+     *
+     * (u_target, v) = (u_source, v) for all v in the target space
+     *
+     * The source solution is evaluated at the target quadrature points,
+     * which are located in the source mesh with an ElementBVH.
+     * Under MPI the points not found on this process are looked up on the other processes.
+     * The target inverse mass matrices are cached (and only rebuilt when the target mesh moves)
+     * so repeated transfers (i.e between space-time slabs) only cost the point location and quadrature.
+     *
+     * The projection is conservative up to quadrature error:
+     * the integral of the solution over each target element is preserved
+     * when the source solution is integrated exactly by the target quadrature
+     *
+     * @tparam T the real value type
+     * @tparam IDX the index type
+     * @tparam ndim the number of dimensions
+     */
+    template<class T, class IDX, int ndim>
+    class SolutionTransfer {
+        using Point = MATH::GEOMETRY::Point<T, ndim>;
+
+        FESpace<T, IDX, ndim>* source_ptr;
+        FESpace<T, IDX, ndim>* target_ptr;
+
+        /// @brief point location in the source mesh
+        ElementBVH<T, IDX, ndim> bvh;
+
+        /// @brief the cached target inverse mass matrices
+        InverseMassOperator<T, IDX> minv;
+
+        /// @brief the target quadrature points and the offset of each target element (size = nelem + 1)
+        std::vector<Point> qp_points{};
+        std::vector<std::size_t> qp_offsets{};
+
+        /// @brief the source location of each target quadrature point
+        std::vector<std::optional<element_point<T, IDX, ndim>>> locations{};
+
+        /// @brief the source coordinate version the locations were computed for
+        std::size_t source_version = 0;
+
+        /// @brief the target coordinate version the quadrature points were computed for
+        std::size_t target_version = 0;
+
+        /// @brief if the quadrature points have been located
+        bool located = false;
+
+        /// @brief locate the target quadrature points in the source mesh
+        auto locate() -> void {
+            FESpace<T, IDX, ndim>& target = *target_ptr;
+            qp_offsets.assign(target.elements.size() + 1, 0);
+            for(const FiniteElement<T, IDX, ndim>& el : target.elements)
+                { qp_offsets[el.elidx + 1] = qp_offsets[el.elidx] + el.nQP(); }
+            qp_points.resize(qp_offsets.back());
+            util::parallel_for(target.elements.size(), [&](std::size_t iel){
+                const FiniteElement<T, IDX, ndim>& el = target.elements[iel];
+                for(int iqp = 0; iqp < el.nQP(); ++iqp)
+                    { qp_points[qp_offsets[iel] + iqp] = el.transform(el.getQP(iqp).abscisse); }
+            });
+            if(!located || source_version != source_ptr->meshptr->coord_version)
+                bvh = ElementBVH<T, IDX, ndim>{*source_ptr};
+            locations = find_elements(*source_ptr, bvh, std::span<const Point>{qp_points});
+            source_version = source_ptr->meshptr->coord_version;
+            target_version = target.meshptr->coord_version;
+            located = true;
+        }
+
+        /**
+         * @brief evaluate the source solution at the target quadrature points
+         * @param u_source the source solution
+         * @param [out] values the values at each quadrature point (npoint x nv)
+         */
+        template<class LayoutPolicy, class AccessorPolicy>
+        auto evaluate_source(fespan<T, LayoutPolicy, AccessorPolicy> u_source, std::vector<T>& values) const -> void {
+            const std::size_t nv = u_source.nv();
+            values.assign(qp_points.size() * nv, 0.0);
+            util::parallel_for(qp_points.size(), [&](std::size_t ipoint){
+                if(!locations[ipoint]) return;
+                const FiniteElement<T, IDX, ndim>& el = source_ptr->elements[locations[ipoint]->iel];
+                std::vector<T> basis(el.nbasis());
+                el.eval_basis(locations[ipoint]->xi, basis.data());
+                for(std::size_t iv = 0; iv < nv; ++iv){
+                    T value = 0.0;
+                    for(std::size_t idof = 0; idof < el.nbasis(); ++idof)
+                        { value += u_source[el.elidx, idof, iv] * basis[idof]; }
+                    values[ipoint * nv + iv] = value;
+                }
+            });
+
+#ifdef ICEICLE_USE_MPI
+            if(mpi::mpi_world_size() > 1) {
+                // share the points that are not in the source mesh partition on this process
+                std::vector<Point> missing{};
+                std::vector<std::size_t> missing_idx{};
+                for(std::size_t ipoint = 0; ipoint < qp_points.size(); ++ipoint){
+                    if(!locations[ipoint]) {
+                        missing.push_back(qp_points[ipoint]);
+                        missing_idx.push_back(ipoint);
+                    }
+                }
+                int nrank = mpi::mpi_world_size(), myrank = mpi::mpi_world_rank();
+                std::vector<int> counts(nrank), displs(nrank + 1, 0);
+                int nmissing = missing.size() * ndim;
+                MPI_Allgather(&nmissing, 1, MPI_INT, counts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+                for(int irank = 0; irank < nrank; ++irank) displs[irank + 1] = displs[irank] + counts[irank];
+                std::vector<T> all_missing(displs[nrank]);
+                MPI_Allgatherv(missing.data(), nmissing, mpi_get_type<T>(), all_missing.data(),
+                        counts.data(), displs.data(), mpi_get_type<T>(), MPI_COMM_WORLD);
+                std::size_t nall = all_missing.size() / ndim;
+                if(nall == 0) return;
+
+                // evaluate the points found on this process: the lowest rank that finds a point provides it
+                std::vector<int> owner(nall, std::numeric_limits<int>::max());
+                std::vector<std::optional<element_point<T, IDX, ndim>>> found(nall);
+                for(std::size_t ipoint = 0; ipoint < nall; ++ipoint){
+                    Point x;
+                    for(int idim = 0; idim < ndim; ++idim) x[idim] = all_missing[ipoint * ndim + idim];
+                    found[ipoint] = find_element(*source_ptr, bvh, x);
+                    if(found[ipoint]) owner[ipoint] = myrank;
+                }
+                MPI_Allreduce(MPI_IN_PLACE, owner.data(), nall, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+                std::vector<T> remote_values(nall * nv, 0.0);
+                for(std::size_t ipoint = 0; ipoint < nall; ++ipoint){
+                    if(owner[ipoint] != myrank) continue;
+                    const FiniteElement<T, IDX, ndim>& el = source_ptr->elements[found[ipoint]->iel];
+                    std::vector<T> basis(el.nbasis());
+                    el.eval_basis(found[ipoint]->xi, basis.data());
+                    for(std::size_t iv = 0; iv < nv; ++iv){
+                        for(std::size_t idof = 0; idof < el.nbasis(); ++idof)
+                            { remote_values[ipoint * nv + iv] += u_source[el.elidx, idof, iv] * basis[idof]; }
+                    }
+                }
+                MPI_Allreduce(MPI_IN_PLACE, remote_values.data(), remote_values.size(), mpi_get_type<T>(),
+                        MPI_SUM, MPI_COMM_WORLD);
+
+                std::size_t first = displs[myrank] / ndim;
+                for(std::size_t i = 0; i < missing_idx.size(); ++i){
+                    if(owner[first + i] == std::numeric_limits<int>::max()) {
+                        util::AnomalyLog::log_anomaly(util::Anomaly{"target quadrature point outside of the source mesh",
+                                util::general_anomaly_tag{}});
+                        continue;
+                    }
+                    for(std::size_t iv = 0; iv < nv; ++iv)
+                        { values[missing_idx[i] * nv + iv] = remote_values[(first + i) * nv + iv]; }
+                }
+                return;
+            }
+#endif
+            for(std::size_t ipoint = 0; ipoint < qp_points.size(); ++ipoint){
+                if(!locations[ipoint]) {
+                    util::AnomalyLog::log_anomaly(util::Anomaly{"target quadrature point outside of the source mesh",
+                            util::general_anomaly_tag{}});
+                    return;
+                }
+            }
+        }
+
+        public:
+
+        /**
+         * @brief set up the transfer
+         * @param source the finite element space the solution is transferred from
+         * @param target the finite element space the solution is transferred to
+         */
+        SolutionTransfer(FESpace<T, IDX, ndim>& source, FESpace<T, IDX, ndim>& target)
+        : source_ptr{&source}, target_ptr{&target}, bvh{}, minv{target} {}
+
+        /**
+         * @brief project the source solution onto the target space
+         * target quadrature points outside of the source mesh get zero and log an anomaly
+         *
+         * NOTE: collective under MPI
+         *
+         * @param u_source the solution on the source space
+         * @param [out] u_target the solution on the target space (same number of vector components)
+         */
+        template<class srcLayoutPolicy, class srcAccessorPolicy, class tgtLayoutPolicy, class tgtAccessorPolicy>
+        auto transfer(
+            fespan<T, srcLayoutPolicy, srcAccessorPolicy> u_source,
+            fespan<T, tgtLayoutPolicy, tgtAccessorPolicy> u_target
+        ) -> void {
+            FESpace<T, IDX, ndim>& target = *target_ptr;
+            if(u_source.nv() != u_target.nv()){
+                util::AnomalyLog::log_anomaly(util::Anomaly{"number of vector components does not match for solution transfer",
+                        util::general_anomaly_tag{}});
+                return;
+            }
+            if(!located || source_version != source_ptr->meshptr->coord_version
+                    || target_version != target.meshptr->coord_version) locate();
+            minv.update(target);
+
+            std::vector<T> values{};
+            evaluate_source(u_source, values);
+
+            // form the right hand side (u_source, v)
+            const std::size_t nv = u_target.nv();
+            std::vector<T> rhs_data(u_target.size());
+            fespan rhs{rhs_data.data(), u_target.get_layout()};
+            util::parallel_for(target.elements.size(), [&](std::size_t iel){
+                const FiniteElement<T, IDX, ndim>& el = target.elements[iel];
+                for(std::size_t idof = 0; idof < el.nbasis(); ++idof){
+                    for(std::size_t iv = 0; iv < nv; ++iv) rhs[iel, idof, iv] = 0.0;
+                }
+                for(int iqp = 0; iqp < el.nQP(); ++iqp){
+                    const QuadraturePoint<T, ndim> quadpt = el.getQP(iqp);
+                    T detJ = NUMTOOL::TENSOR::FIXED_SIZE::determinant(el.jacobian(quadpt.abscisse));
+                    const T* value = values.data() + (qp_offsets[iel] + iqp) * nv;
+                    for(std::size_t idof = 0; idof < el.nbasis(); ++idof){
+                        for(std::size_t iv = 0; iv < nv; ++iv)
+                            { rhs[iel, idof, iv] += value[iv] * quadpt.weight * el.basis_qp(iqp, idof) * detJ; }
+                    }
+                }
+            });
+            minv.apply(1.0, rhs, 0.0, u_target);
+        }
+    };
+
+    /**
+     * @brief project a solution onto a finite element space on a different mesh or polynomial order
+     * (i.e to warm start a high order solve with a p = 1 solution or a refined mesh)
+     * \see SolutionTransfer
+     * @param source the finite element space the solution is transferred from
+     * @param u_source the solution on the source space
+     * @param target the finite element space the solution is transferred to
+     * @param [out] u_target the solution on the target space
+     */
+    template<class T, class IDX, int ndim, class srcLayoutPolicy, class srcAccessorPolicy,
+        class tgtLayoutPolicy, class tgtAccessorPolicy>
+    auto transfer_solution(
+        FESpace<T, IDX, ndim>& source,
+        fespan<T, srcLayoutPolicy, srcAccessorPolicy> u_source,
+        FESpace<T, IDX, ndim>& target,
+        fespan<T, tgtLayoutPolicy, tgtAccessorPolicy> u_target
+    ) -> void {
+        SolutionTransfer<T, IDX, ndim> transfer{source, target};
+        transfer.transfer(u_source, u_target);
+    }
+}
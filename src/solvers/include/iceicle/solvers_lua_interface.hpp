@@ -3,12 +3,20 @@
 
 #pragma once
 #include "iceicle/disc/projection.hpp"
+#include "iceicle/disc/positivity_limiter.hpp"
 #include "iceicle/fe_function/geo_layouts.hpp"
+#include "iceicle/disc/error_norms.hpp"
 #include "iceicle/disc/l2_error.hpp"
+#include "iceicle/disc/surface_functionals.hpp"
 #include "iceicle/geometry/face.hpp"
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include "iceicle/reproducible_sum.hpp"
+#include "iceicle/lua_utils.hpp"
 #include "iceicle/string_utils.hpp"
 #include "iceicle/writer.hpp"
 #include <array>
+#include <concepts>
+#include <optional>
 #include <iceicle/fespace/fespace.hpp>
 #include <iceicle/explicit_utils.hpp>
 #include <iceicle/anomaly_log.hpp>
@@ -16,16 +24,30 @@
 #include <iceicle/explicit_euler.hpp>
 #include <iceicle/ssp_rk3.hpp>
 #include <iceicle/tvd_rk3.hpp>
+#include <iceicle/low_storage_rk.hpp>
+#include <iceicle/multirate_euler.hpp>
+#include <iceicle/anderson_acceleration.hpp>
+#include <iceicle/p_multigrid.hpp>
+#include <iceicle/p_adaptivity.hpp>
+#include <iceicle/parareal.hpp>
+#include <iceicle/spacetime_slab_solver.hpp>
 #include <iceicle/dat_writer.hpp>
 #include <iceicle/pvd_writer.hpp>
 #include <iceicle/fe_function/restart.hpp>
 #include <iceicle/writer.hpp>
+#include <iceicle/async_writer.hpp>
+#include <iceicle/extraction_writer.hpp>
+#include <iceicle/functional_writer.hpp>
+#include <iceicle/coefficient_writer.hpp>
+#include <iceicle/output_scheduler.hpp>
 #include <sol/sol.hpp>
 #include <utility>
 
 #ifdef ICEICLE_USE_PETSC
 #include <iceicle/corrigan_lm.hpp>
 #include <iceicle/petsc_newton.hpp>
+#include <iceicle/petsc_ptc.hpp>
+#include <iceicle/petsc_implicit_time.hpp>
 #include <iceicle/matrix_free_newton_krylov.hpp>
 #endif
 
@@ -63,6 +85,13 @@ namespace iceicle::solvers {
             static constexpr int ndim = Disc_Type::dimensionality;
             static constexpr int neq = Disc_Type::nv_comp;
             sol::table cons_law_tbl = config_tbl["conservation_law"];
+
+            // compiled expressions of the coordinates
+            if(auto expr_func = util::lua_get_expression_function<value_type>(cons_law_tbl["source"], neq, ndim)){
+                disc.user_source = expr_func;
+                return;
+            }
+
             sol::optional<sol::function> source_opt = cons_law_tbl["source"];
             if(source_opt){
                 sol::function source_f = source_opt.value();
@@ -83,9 +112,114 @@ namespace iceicle::solvers {
         }
     }
 
+    /// @brief get the vtu data encoding from the output table
+    /// @param output_tbl the output table of the user configuration
+    inline auto lua_get_vtu_format(sol::table output_tbl) -> io::vtu_format {
+        using namespace iceicle::util;
+        std::string format = output_tbl.get_or("format", std::string{"ascii"});
+        if(eq_icase(format, "ascii")) return io::vtu_format::ascii;
+        else if(eq_icase(format, "base64")) return io::vtu_format::base64;
+        else if(eq_icase(format, "raw")) return io::vtu_format::raw;
+        else if(eq_icase(format, "binary")) return io::vtu_format::binary;
+        AnomalyLog::log_anomaly(Anomaly{"Unrecognized vtu format: " + format, general_anomaly_tag{}});
+        return io::vtu_format::ascii;
+    }
+
+    /// @brief set the vtu data encoding of a writer from the output table 
+    /// @param output_tbl the output table of the user configuration
+    /// @param pvd_writer the writer to configure
+    template<class T, class IDX, int ndim>
+    auto lua_set_vtu_format(sol::table output_tbl, io::PVDWriter<T, IDX, ndim>& pvd_writer) -> void {
+        pvd_writer.format = lua_get_vtu_format(output_tbl);
+        pvd_writer.compress = output_tbl.get_or("compress", false);
+        pvd_writer.naggregate = output_tbl.get_or("naggregate", 0);
+        pvd_writer.max_order = output_tbl.get_or("max_order", std::numeric_limits<int>::max());
+    }
+
+#ifdef ICEICLE_USE_PETSC
+    /// @brief get the Krylov method configuration from the solver table
+    /// given as a name or a table with the type and options
+    /// @param solver_params the solver table of the user configuration
+    inline auto lua_get_krylov_method(sol::table solver_params) -> KrylovMethod {
+        using namespace iceicle::util;
+        KrylovMethod method{};
+        std::string name = "default";
+        sol::optional<std::string> name_opt = solver_params["krylov_method"];
+        sol::optional<sol::table> tbl_opt = solver_params["krylov_method"];
+        if(name_opt){
+            name = name_opt.value();
+        } else if(tbl_opt){
+            sol::table tbl = tbl_opt.value();
+            name = tbl.get_or("type", name);
+            method.restart = tbl.get_or("restart", method.restart);
+            method.pipeline_shift = tbl.get_or("shift", method.pipeline_shift);
+        }
+        if(eq_icase(name, "default")) method.type = KRYLOV_METHOD::DEFAULT;
+        else if(eq_icase(name, "gmres")) method.type = KRYLOV_METHOD::GMRES;
+        else if(eq_icase(name, "fgmres")) method.type = KRYLOV_METHOD::FGMRES;
+        else if(eq_icase(name, "pgmres")) method.type = KRYLOV_METHOD::PGMRES;
+        else if(eq_icase(name, "pipefgmres")) method.type = KRYLOV_METHOD::PIPEFGMRES;
+        else if(eq_icase(name, "pipegcr")) method.type = KRYLOV_METHOD::PIPEGCR;
+        else if(eq_icase(name, "pipecg")) method.type = KRYLOV_METHOD::PIPECG;
+        else AnomalyLog::log_anomaly(Anomaly{"unrecognized krylov_method: " + name, general_anomaly_tag{}});
+        return method;
+    }
+
+    /// @brief get the Krylov subspace recycling configuration from the solver table
+    /// given as a name or a table with the type and the number of recycled vectors
+    /// @param solver_params the solver table of the user configuration
+    inline auto lua_get_krylov_recycling(sol::table solver_params) -> KrylovRecycling {
+        using namespace iceicle::util;
+        KrylovRecycling recycling{};
+        std::string name = "none";
+        sol::optional<std::string> name_opt = solver_params["krylov_recycling"];
+        sol::optional<sol::table> tbl_opt = solver_params["krylov_recycling"];
+        if(name_opt){
+            name = name_opt.value();
+        } else if(tbl_opt){
+            sol::table tbl = tbl_opt.value();
+            name = tbl.get_or("type", name);
+            recycling.nrecycle = tbl.get_or("nrecycle", recycling.nrecycle);
+        }
+        if(eq_icase(name, "none")) recycling.type = KRYLOV_RECYCLING::NONE;
+        else if(eq_icase_any(name, "gcrodr", "gcro-dr")) recycling.type = KRYLOV_RECYCLING::GCRODR;
+        else if(eq_icase(name, "projection")) recycling.type = KRYLOV_RECYCLING::PROJECTION;
+        else AnomalyLog::log_anomaly(Anomaly{"unrecognized krylov_recycling: " + name, general_anomaly_tag{}});
+        return recycling;
+    }
+
+    /// @brief a copy of the discretization with the cheaper options in solver.preconditioner_disc 
+    /// to assemble the jacobian (or build the preconditioner) from
+    /// @param solver_params the solver table of the user configuration
+    /// @param disc the discretization being solved
+    /// @return the copy or an empty optional if there is no preconditioner_disc table
+    template<class DiscType>
+    auto lua_get_preconditioner_disc(sol::table solver_params, const DiscType& disc) -> std::optional<DiscType> {
+        using namespace iceicle::util;
+        sol::optional<sol::table> tbl_opt = solver_params["preconditioner_disc"];
+        if(!tbl_opt) return std::nullopt;
+        sol::table tbl = tbl_opt.value();
+        if constexpr (std::copy_constructible<DiscType>) {
+            DiscType pc_disc{disc};
+            if constexpr (requires { pc_disc.interior_penalty; })
+                pc_disc.interior_penalty = tbl.get_or("interior_penalty", pc_disc.interior_penalty);
+            if constexpr (requires { pc_disc.sigma_ic; })
+                pc_disc.sigma_ic = tbl.get_or("sigma_ic", pc_disc.sigma_ic);
+            if constexpr (requires { pc_disc.flux_differencing; })
+                pc_disc.flux_differencing = tbl.get_or("flux_differencing", pc_disc.flux_differencing);
+            return std::optional{std::move(pc_disc)};
+        } else {
+            AnomalyLog::log_anomaly(Anomaly{"preconditioner_disc requires a copyable discretization",
+                    general_anomaly_tag{}});
+            return std::nullopt;
+        }
+    }
+#endif
+
     /// @brief Create a writer for output files 
     /// given the user configuration
     ///
+    /// if output.async is true the writer writes snapshots of u on a background thread
     ///
     /// @param config_tbl the user configuration lua table 
     /// @param fespace the finite element space 
@@ -106,24 +240,155 @@ namespace iceicle::solvers {
             sol::table output_tbl = output_tbl_opt.value();
             sol::optional<std::string> writer_name = output_tbl["writer"];
 
-            // .dat file writer
-            // NOTE: short circuiting &&
-            if(writer_name && eq_icase(writer_name.value(), "dat")){
-                if constexpr (ndim == 1){
-                    io::DatWriter<T, IDX, ndim> dat_writer{fespace};
-                    dat_writer.register_fields(u, disc.field_names);
-                    writer = io::Writer{dat_writer};
-                } else {
-                    AnomalyLog::log_anomaly(Anomaly{"dat writer not defined for greater than 1D", general_anomaly_tag{}});
+            // create the writer for the given view of the solution
+            auto create_writer = [&](fespan<T, LayoutPolicy> u_view) -> io::Writer {
+                io::Writer writer;
+
+                // .dat file writer
+                // NOTE: short circuiting &&
+                if(writer_name && eq_icase(writer_name.value(), "dat")){
+                    if constexpr (ndim == 1){
+                        io::DatWriter<T, IDX, ndim> dat_writer{fespace};
+                        std::string format = output_tbl.get_or("format", std::string{"ascii"});
+                        if(eq_icase(format, "binary")) dat_writer.format = io::dat_format::binary;
+                        else if(!eq_icase(format, "ascii"))
+                            AnomalyLog::log_anomaly(Anomaly{"Unrecognized dat format: " + format, general_anomaly_tag{}});
+                        dat_writer.append = output_tbl.get_or("append", false);
+                        dat_writer.register_fields(u_view, disc.field_names);
+                        writer = io::Writer{dat_writer};
+                    } else {
+                        AnomalyLog::log_anomaly(Anomaly{"dat writer not defined for greater than 1D", general_anomaly_tag{}});
+                    }
                 }
-            }
 
-            // .vtu writer 
-            if(writer_name && eq_icase(writer_name.value(), "vtu")){
-                io::PVDWriter<T, IDX, ndim> pvd_writer{};
-                pvd_writer.register_fespace(fespace);
-                pvd_writer.register_fields(u, disc.field_names);
-                writer = pvd_writer;
+                // .vtu writer 
+                if(writer_name && eq_icase(writer_name.value(), "vtu")){
+                    io::PVDWriter<T, IDX, ndim> pvd_writer{};
+                    lua_set_vtu_format(output_tbl, pvd_writer);
+                    pvd_writer.register_fespace(fespace);
+                    pvd_writer.register_fields(u_view, disc.field_names);
+                    writer = pvd_writer;
+                }
+
+                // raw coefficients (expanded offline with coefficient_convert)
+                if(writer_name && eq_icase(writer_name.value(), "coefficients")){
+                    io::CoefficientWriter<T, IDX, ndim> coefficient_writer{};
+                    coefficient_writer.register_fespace(fespace);
+                    coefficient_writer.register_fields(u_view, disc.field_names);
+                    writer = coefficient_writer;
+                }
+
+                // collective hdf5 writer with xdmf metadata
+                if(writer_name && eq_icase(writer_name.value(), "xdmf")){
+#ifdef ICEICLE_USE_HDF5
+                    io::XDMFWriter<T, IDX, ndim> xdmf_writer{};
+                    sol::optional<T> error_bound = output_tbl["error_bound"];
+                    if(error_bound) xdmf_writer.error_bound = error_bound.value();
+                    xdmf_writer.write_sampled_fields = output_tbl.get_or("sampled_fields", true);
+                    xdmf_writer.register_fespace(fespace);
+                    xdmf_writer.register_fields(u_view, disc.field_names);
+                    writer = xdmf_writer;
+#else
+                    AnomalyLog::log_anomaly(Anomaly{"xdmf writer requires building with ICEICLE_USE_HDF5", general_anomaly_tag{}});
+#endif
+                }
+                // in-situ extraction writers
+                if constexpr (ndim >= 2) {
+                    auto read_point = [](sol::table point_tbl){
+                        MATH::GEOMETRY::Point<T, ndim> x{};
+                        for(int idim = 0; idim < ndim; ++idim) x[idim] = point_tbl[idim + 1]; // NOTE: Lua is 1-indexed
+                        return x;
+                    };
+
+                    // solution at probe points
+                    if(writer_name && eq_icase(writer_name.value(), "probe")){
+                        io::ProbeWriter<T, IDX, ndim> probe_writer{};
+                        sol::table probes_tbl = output_tbl["probes"];
+                        for(std::size_t iprobe = 1; iprobe <= probes_tbl.size(); ++iprobe)
+                            { probe_writer.probes.push_back(read_point(probes_tbl[iprobe])); }
+                        probe_writer.relocate = output_tbl.get_or("relocate", false);
+                        probe_writer.register_fespace(fespace);
+                        probe_writer.register_fields(u_view, disc.field_names);
+                        writer = probe_writer;
+                    }
+
+                    // solution on a plane slice
+                    if(writer_name && eq_icase(writer_name.value(), "slice")){
+                        io::SliceWriter<T, IDX, ndim> slice_writer{};
+                        sol::table slice_tbl = output_tbl["slice"];
+                        slice_writer.origin = read_point(slice_tbl["origin"]);
+                        slice_writer.u = read_point(slice_tbl["u"]);
+                        if constexpr (ndim == 3) slice_writer.v = read_point(slice_tbl["v"]);
+                        sol::optional<sol::table> n_tbl = slice_tbl["n"];
+                        if(n_tbl) for(int i = 0; i < ndim - 1; ++i) slice_writer.n[i] = n_tbl.value()[i + 1];
+                        slice_writer.format = lua_get_vtu_format(output_tbl);
+                        slice_writer.compress = output_tbl.get_or("compress", false);
+                        slice_writer.register_fespace(fespace);
+                        slice_writer.register_fields(u_view, disc.field_names);
+                        writer = slice_writer;
+                    }
+
+                    // solution on the selected boundaries
+                    if(writer_name && eq_icase(writer_name.value(), "surface")){
+                        io::SurfaceWriter<T, IDX, ndim> surface_writer{};
+                        sol::optional<sol::table> bcflags_tbl = output_tbl["bcflags"];
+                        if(bcflags_tbl) for(std::size_t i = 1; i <= bcflags_tbl.value().size(); ++i)
+                            { surface_writer.bcflags.push_back(bcflags_tbl.value()[i]); }
+                        surface_writer.nsample = output_tbl.get_or("nsample", 4);
+                        surface_writer.format = lua_get_vtu_format(output_tbl);
+                        surface_writer.compress = output_tbl.get_or("compress", false);
+                        surface_writer.register_fespace(fespace);
+                        surface_writer.register_fields(u_view, disc.field_names);
+                        writer = surface_writer;
+                    }
+
+                    // frames in shared memory for a viewer attached to the running simulation
+                    if(writer_name && eq_icase(writer_name.value(), "live")){
+                        io::LiveWriter<T, IDX, ndim> live_writer{};
+                        live_writer.shm_name = output_tbl.get_or("shm_name", live_writer.shm_name);
+                        live_writer.nslot = output_tbl.get_or("nslot", 3);
+                        live_writer.register_fespace(fespace);
+                        live_writer.register_fields(u_view, disc.field_names);
+                        writer = live_writer;
+                    }
+                }
+
+                // time history of the forces and heat flux on the selected boundaries
+                if(writer_name && eq_icase(writer_name.value(), "functionals")){
+                    if constexpr (requires { disc.phys_flux.physics; disc.phys_flux.full_ns_arg; }) {
+                        io::FunctionalWriter<T> functional_writer{};
+                        std::vector<int> bcflags{};
+                        sol::optional<sol::table> bcflags_tbl = output_tbl["bcflags"];
+                        if(bcflags_tbl) for(std::size_t i = 1; i <= bcflags_tbl.value().size(); ++i)
+                            { bcflags.push_back(bcflags_tbl.value()[i]); }
+                        for(int bcflag : bcflags){
+                            for(const std::string& name : navier_stokes::SurfaceFunctionals<T, ndim>::value_names())
+                                { functional_writer.names.push_back(name + "[" + std::to_string(bcflag) + "]"); }
+                        }
+                        functional_writer.evaluate = [&fespace, &disc, u_view, bcflags]{
+                            std::vector<T> values{};
+                            for(int bcflag : bcflags){
+                                auto surface_vals = navier_stokes::integrate_surface_functionals(
+                                        fespace, disc.phys_flux, u_view, bcflag).values();
+                                values.insert(values.end(), surface_vals.begin(), surface_vals.end());
+                            }
+                            return values;
+                        };
+                        writer = functional_writer;
+                    } else {
+                        AnomalyLog::log_anomaly(Anomaly{"functionals writer requires the Navier-Stokes equations", general_anomaly_tag{}});
+                    }
+                }
+                return writer;
+            };
+
+            if(writer_name && output_tbl.get_or("async", false)){
+                std::size_t nbuffer = output_tbl.get_or("async_nbuffer", 2);
+                writer = io::AsyncWriter<T>{std::span<const T>{u.data(), u.size()},
+                    [&](std::span<T> staging){ return create_writer(fespan{staging.data(), u.get_layout()}); },
+                    nbuffer};
+            } else {
+                writer = create_writer(u);
             }
         }
         return writer;
@@ -153,6 +418,7 @@ namespace iceicle::solvers {
             if(writer_name && eq_icase(writer_name.value(), "vtu")){
                 io::PVDWriter<T, IDX, ndim> pvd_writer{};
                 pvd_writer.collection_name = "residuals";
+                lua_set_vtu_format(output_tbl, pvd_writer);
                 pvd_writer.register_fespace(fespace);
                 pvd_writer.register_residuals(u, disc.residual_names, disc);
                 writer = pvd_writer;
@@ -413,7 +679,8 @@ namespace iceicle::solvers {
         sol::table solver_params = config_tbl["solver"];
         std::string solver_type = solver_params["type"];
         // check for explicit solvers 
-        if(eq_icase_any(solver_type, "explicit_euler", "rk3-ssp", "rk3-tvd")){
+        if(eq_icase_any(solver_type, "explicit_euler", "rk3-ssp", "rk3-tvd", "lsrk3", "lsrk4",
+                    "multirate_euler", "bdf1", "bdf2", "sdirk2", "sdirk3")){
 
             // ========================================
             // = determine the timestepping criterion =
@@ -476,35 +743,140 @@ namespace iceicle::solvers {
                 sol::optional<sol::table> output_tbl_opt = config_tbl["output"];
                 io::Writer writer{lua_get_writer(config_tbl, fespace, disc, u)};
                 io::Writer residuals_writer{lua_get_residuals_writer(config_tbl, fespace, disc, u)};
+                // lookahead of the element data prefetch in the interior trace loop and the element-centric traversal
+                // lookahead of the element data prefetch in the interior trace loop
+                if constexpr (requires { solver.workspace.trace_prefetch_distance; }) {
+                    sol::optional<int> trace_prefetch = solver_params["trace_prefetch"];
+                    if(trace_prefetch) solver.workspace.trace_prefetch_distance = trace_prefetch.value();
+                    if(solver_params.get_or("element_centric", false))
+                        solver.workspace.enable_element_centric(fespace, DiscType::dnv_comp);
+                    // skip the residual of elements that stay at the state of their neighbors
+                    if(sol::optional<sol::table> activity_tbl_opt = solver_params["activity"]; activity_tbl_opt) {
+                        sol::table activity_tbl = activity_tbl_opt.value();
+                        bool has_source = false;
+                        if constexpr (requires { disc.user_source.has_value(); })
+                            has_source = disc.user_source.has_value();
+                        solver.workspace.enable_activity_tracking(fespace, DiscType::dnv_comp,
+                            activity_tbl.get_or("residual_tol", (T) 1e-10),
+                            activity_tbl.get_or("state_tol", (T) 1e-10),
+                            activity_tbl.get_or("recheck_interval", (std::size_t) 10), has_source);
+                        if(has_source && mpi::mpi_world_rank() == 0)
+                            std::cout << "activity: the source term keeps every element active" << std::endl;
+                    }
+                }
 
-                solver.vis_callback = [&](ExplicitSolverType& solver) mutable {
-                    T sum = 0.0;
-                    for(int i = 0; i < solver.res_data.size(); ++i){
-                        sum += SQUARED(solver.res_data[i]);
+                // sampled wall time of each element for load imbalance diagnosis
+                std::optional<std::string> cost_output{};
+                if constexpr (requires { solver.workspace.cost; }) {
+                    if(sol::optional<sol::table> cost_tbl_opt = solver_params["cost_sampling"]; cost_tbl_opt) {
+                        sol::table cost_tbl = cost_tbl_opt.value();
+                        solver.workspace.enable_cost_sampling(fespace, cost_tbl.get_or("interval", (std::size_t) 10));
+                        sol::optional<std::string> output = cost_tbl["output"];
+                        if(output) cost_output = output.value();
                     }
+                }
 
-#ifdef ICEICLE_USE_MPI
-                    T sum_reduce;
-                    MPI_Allreduce(&sum, &sum_reduce, 1, mpi_get_type<T>(), MPI_SUM, MPI_COMM_WORLD);
-                    int myrank;
-                    MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
-                    if(myrank == 0){
+                // positivity preserving limiter after every stage (conservative Navier-Stokes solutions)
+                std::optional<navier_stokes::PositivityLimiter<T, IDX, ndim>> positivity_limiter{};
+                if constexpr (requires { solver.stage_limiter; disc.phys_flux.physics.eos.gamma; }) {
+                    using physics_t = std::remove_cvref_t<decltype(disc.phys_flux.physics)>;
+                    if constexpr (physics_t::variable_set == navier_stokes::VARSET::CONSERVATIVE) {
+                        if(solver_params.get_or("positivity_limiter", false)) {
+                            positivity_limiter.emplace(fespace, disc.phys_flux.physics.eos.gamma,
+                                    disc.phys_flux.physics.nondim);
+                            solver.stage_limiter = [&positivity_limiter](std::span<T> u_stage)
+                                { positivity_limiter->limit(u_stage); };
+                        }
+                    }
+                }
+
+                // per-component norms of the residual (reported with the field names)
+                bool component_norms = solver_params.get_or("component_norms", false);
+
+                // output schedule (replaces ivis): step, simulation time, wall clock, and job walltime triggers
+                // the scheduler is polled every step and checkpoints are written as restart files
+                std::optional<util::OutputScheduler<T, IDX>> schedule{};
+                std::string restart_format = solver_params.get_or("restart_format", std::string{"ascii"});
+                if(sol::optional<sol::table> schedule_tbl_opt = solver_params["schedule"]; schedule_tbl_opt) {
+                    sol::table schedule_tbl = schedule_tbl_opt.value();
+                    schedule.emplace();
+                    schedule->every = schedule_tbl.get_or("every", (IDX) 0);
+                    schedule->time_interval = schedule_tbl.get_or("time_interval", (T) 0);
+                    schedule->wall_interval = schedule_tbl.get_or("wall_interval", 0.0);
+                    schedule->walltime_margin = schedule_tbl.get_or("walltime_margin", schedule->walltime_margin);
+                    schedule->min_separation = schedule_tbl.get_or("min_separation", (IDX) 0);
+                    schedule->checkpoint_every = schedule_tbl.get_or("checkpoint_every", (IDX) 0);
+                    sol::object walltime = schedule_tbl["walltime"];
+                    if(walltime.is<std::string>()) {
+                        std::string walltime_src = walltime.as<std::string>();
+                        if(eq_icase(walltime_src, "slurm")) {
+                            if(!schedule->walltime_from_env("SLURM_JOB_END_TIME") && mpi::mpi_world_rank() == 0)
+                                std::cout << "schedule: SLURM_JOB_END_TIME is not set, no walltime checkpoint" << std::endl;
+                        } else {
+                            AnomalyLog::log_anomaly(Anomaly{"unrecognized schedule walltime: " + walltime_src, general_anomaly_tag{}});
+                        }
+                    } else if(walltime.is<double>()) {
+                        schedule->walltime = walltime.as<double>();
+                    }
+                    solver.ivis = 1;
+                }
+
+                solver.vis_callback = [&, component_norms](ExplicitSolverType& solver) mutable {
+                    util::output_event event{.output = true};
+                    if(schedule) {
+                        event = schedule->poll(solver.itime, solver.time);
+                        if(!event) return;
+                    }
+
+                    // the norms accumulated in the residual evaluation
+                    // (the reduction overlaps the update after the last residual)
+                    T l2, linf;
+                    std::vector<T> comp_l2{}, comp_linf{};
+                    if constexpr (requires { solver.workspace.monitor; }) {
+                        auto& monitor = solver.workspace.monitor;
+                        l2 = monitor.l2();
+                        linf = monitor.linf();
+                        for(std::size_t iv = 0; iv < monitor.ncomp(); ++iv){
+                            comp_l2.push_back(monitor.l2(iv));
+                            comp_linf.push_back(monitor.linf(iv));
+                        }
+                    } else {
+                        std::array<util::reduction_sum<T>, 1> sum{};
+                        linf = 0.0;
+                        for(int i = 0; i < solver.res_data.size(); ++i){
+                            sum[0] += SQUARED(solver.res_data[i]);
+                            linf = std::max(linf, std::abs(solver.res_data[i]));
+                        }
+                        mpi::allreduce_sums(std::span{sum});
+                        std::array<T, 2> linf_record{0.0, linf};
+                        mpi::allreduce_sum_max_records<1, 1>(std::span<T>{linf_record});
+                        l2 = std::sqrt(sum[0].value());
+                        linf = linf_record[1];
+                    }
+
+                    if(mpi::mpi_world_rank() == 0){
                         std::cout << std::setprecision(8);
                         std::cout << "itime: " << std::setw(6) << solver.itime 
                             << " | t: " << std::setw(14) << solver.time
-                            << " | residual l2: " << std::setw(14) << std::sqrt(sum_reduce) 
-                            << std::endl;
-
+                            << " | residual l2: " << std::setw(14) << l2
+                            << " | linf: " << std::setw(14) << linf;
+                        if(component_norms){
+                            for(std::size_t iv = 0; iv < comp_l2.size(); ++iv){
+                                std::string name = (iv < disc.field_names.size()) ? disc.field_names[iv] : std::to_string(iv);
+                                std::cout << " | " << name << " l2: " << std::setw(14) << comp_l2[iv]
+                                    << " linf: " << std::setw(14) << comp_linf[iv];
+                            }
+                        }
+                        std::cout << std::endl;
                     }
-#else
-                    std::cout << std::setprecision(8);
-                    std::cout << "itime: " << std::setw(6) << solver.itime 
-                        << " | t: " << std::setw(14) << solver.time
-                        << " | residual l2: " << std::setw(14) << std::sqrt(sum) 
-                        << std::endl;
-#endif
                     if(writer) writer.write(solver.itime, solver.time);
                     if(residuals_writer) residuals_writer.write(solver.itime, solver.time);
+                    if(event.checkpoint) {
+                        if(eq_icase(restart_format, "binary")) write_restart_binary(fespace, u, solver.itime);
+                        else write_restart(fespace, u, solver.itime);
+                        if(event.walltime && mpi::mpi_world_rank() == 0)
+                            std::cout << "schedule: wrote the walltime checkpoint at itime " << solver.itime << std::endl;
+                    }
                 };
 
                 // === Check for invalid state ===
@@ -517,6 +889,90 @@ namespace iceicle::solvers {
                 // = Perform the solve =
                 // =====================
                 solver.solve(fespace, disc, u);
+
+                // report the measured element costs
+                if constexpr (requires { solver.workspace.cost; }) {
+                    const ElementCost<T, IDX>& cost = solver.workspace.cost;
+                    if(cost.enabled()) {
+                        cost.print_imbalance_summary(std::cout);
+                        if(cost_output) {
+                            fe_layout_right cost_layout{fespace.dg_map, tmp::to_size<1>{}};
+                            std::vector<T> cost_data(cost_layout.size());
+                            fespan cost_field{cost_data.data(), cost_layout};
+                            cost.fill_field(cost_field);
+                            io::PVDWriter<T, IDX, ndim> cost_writer{};
+                            cost_writer.collection_name = cost_output.value();
+                            cost_writer.register_fespace(fespace);
+                            cost_writer.register_fields(cost_field, std::vector<std::string>{"element_cost"});
+                            cost_writer.write_vtu(solver.itime, solver.time);
+                        }
+                    }
+                }
+            };
+
+            // solve with the explicit solver as the fine propagator of parareal
+            auto parareal_solve = [&]<class ExplicitSolverType>(ExplicitSolverType& solver, sol::table parareal_tbl){
+                if constexpr (requires { solver.stop_condition.tfinal; }) {
+                    // the coarse propagator takes coarsening times larger timesteps
+                    T coarsening = parareal_tbl.get_or("coarsening", 10.0);
+                    auto coarse_timestep = solver.timestep;
+                    if constexpr (requires { coarse_timestep.cfl; }) coarse_timestep.cfl *= coarsening;
+                    else coarse_timestep.dt *= coarsening;
+
+                    auto run = [&]<class CoarseSolverType>(CoarseSolverType& coarse){
+                        Parareal parareal{coarse, solver, solver.stop_condition.tfinal,
+                            parareal_tbl.get_or("nslice", (IDX) mpi::mpi_world_size()),
+                            parareal_tbl.get_or("kmax", (IDX) 3)};
+                        parareal.tol = parareal_tbl.get_or("tol", parareal.tol);
+
+                        io::Writer writer{lua_get_writer(config_tbl, fespace, disc, u)};
+
+                        // === Check for invalid state ===
+                        if(AnomalyLog::size() > 0){
+                            AnomalyLog::handle_anomalies();
+                            return;
+                        }
+
+                        if(writer) writer.write(0, parareal.t0);
+                        parareal.solve(fespace, disc, u);
+                        if(writer) writer.write(parareal.iteration, parareal.tfinal);
+                    };
+
+                    std::string coarse_name = parareal_tbl.get_or("coarse", std::string{"explicit_euler"});
+                    if(eq_icase(coarse_name, "explicit_euler")){
+                        ExplicitEuler coarse{fespace, disc, coarse_timestep, solver.stop_condition};
+                        run(coarse);
+                    } else if(eq_icase(coarse_name, "rk3-ssp")){
+                        RK3SSP coarse{fespace, disc, coarse_timestep, solver.stop_condition};
+                        run(coarse);
+                    } else {
+                        AnomalyLog::log_anomaly(Anomaly{"unrecognized parareal coarse propagator: " + coarse_name,
+                                general_anomaly_tag{}});
+                        AnomalyLog::handle_anomalies();
+                    }
+                } else {
+                    AnomalyLog::log_anomaly(Anomaly{"parareal requires tfinal and an explicit solver", general_anomaly_tag{}});
+                    AnomalyLog::handle_anomalies();
+                }
+            };
+
+            // optionally wrap the explicit solver in Anderson accelerated fixed point iterations
+            auto accelerate_and_solve = [&]<class ExplicitSolverType>(ExplicitSolverType& solver){
+                sol::optional<sol::table> anderson_opt = solver_params["anderson"];
+                if(anderson_opt){
+                    sol::table anderson_tbl = anderson_opt.value();
+                    AndersonAcceleration accel{solver};
+                    accel.window = anderson_tbl.get_or("window", accel.window);
+                    accel.beta = anderson_tbl.get_or("beta", accel.beta);
+                    accel.tol = anderson_tbl.get_or("tol", accel.tol);
+                    if(accel.window < 0) AnomalyLog::log_anomaly(Anomaly{
+                            "anderson window must be non-negative", general_anomaly_tag{}});
+                    setup_and_solve(accel);
+                } else if(sol::optional<sol::table> parareal_opt = solver_params["parareal"]){
+                    parareal_solve(solver, parareal_opt.value());
+                } else {
+                    setup_and_solve(solver);
+                }
             };
 
             // by solver type and the timestep and termination variants 
@@ -529,21 +985,143 @@ namespace iceicle::solvers {
                         T t_final;
                         if(eq_icase(solver_type, "explicit_euler")){
                             ExplicitEuler solver{fespace, disc, ts, sc};
-                            setup_and_solve(solver);
+                            accelerate_and_solve(solver);
                             t_final = solver.time;
                         } else if(eq_icase(solver_type, "rk3-ssp")){
                             RK3SSP solver{fespace, disc, ts, sc};
-                            setup_and_solve(solver);
+                            accelerate_and_solve(solver);
                             t_final = solver.time;
                         } else if(eq_icase(solver_type, "rk3-tvd")){
                             RK3TVD solver{fespace, disc, ts, sc};
+                            accelerate_and_solve(solver);
+                            t_final = solver.time;
+                        } else if(eq_icase_any(solver_type, "lsrk3", "lsrk4")){
+                            int order = eq_icase(solver_type, "lsrk3") ? 3 : 4;
+                            LowStorageRK solver{fespace, disc, ts, sc, order};
+                            accelerate_and_solve(solver);
+                            t_final = solver.time;
+                        } else if(eq_icase(solver_type, "multirate_euler")){
+                            if constexpr (requires { ts.local_timesteps(fespace, disc, u); }) {
+                                MultirateEuler solver{fespace, disc, ts, sc};
+                                solver.max_level = solver_params.get_or("max_level", solver.max_level);
+                                accelerate_and_solve(solver);
+                                t_final = solver.time;
+                            } else {
+                                AnomalyLog::log_anomaly(Anomaly{"multirate_euler requires a cfl timestep criterion", general_anomaly_tag{}});
+                            }
+                        } else {
+#ifdef ICEICLE_USE_PETSC
+                            IMPLICIT_SCHEME scheme = IMPLICIT_SCHEME::BDF1;
+                            if(eq_icase(solver_type, "bdf2")) scheme = IMPLICIT_SCHEME::BDF2;
+                            if(eq_icase(solver_type, "sdirk2")) scheme = IMPLICIT_SCHEME::SDIRK2;
+                            if(eq_icase(solver_type, "sdirk3")) scheme = IMPLICIT_SCHEME::SDIRK3;
+                            ImplicitTimeIntegrator solver{fespace, disc, ts, sc, scheme};
+                            solver.newton_kmax = solver_params.get_or("newton_kmax", solver.newton_kmax);
+                            solver.newton_rtol = solver_params.get_or("newton_rtol", solver.newton_rtol);
+                            solver.newton_atol = solver_params.get_or("newton_atol", solver.newton_atol);
+                            solver.tol = solver_params.get_or("tol", solver.tol);
+                            solver.set_krylov_recycling(lua_get_krylov_recycling(solver_params));
                             setup_and_solve(solver);
                             t_final = solver.time;
+#else
+                            AnomalyLog::log_anomaly(Anomaly{"implicit time integrators require PETSc", general_anomaly_tag{}});
+#endif
                         }
                     }
                 };
             }
-        } else if(eq_icase_any(solver_type, "newton", "lm", "gauss-newton", "mfnk", "matrix-free-newton")) {
+        } else if(eq_icase_any(solver_type, "pmg", "p-multigrid")) {
+            // p-multigrid (FAS) for steady problems
+            // default is a maximum of 100 cycles to machine zero
+            ConvergenceCriteria<T, IDX> conv_criteria{
+                .tau_abs = solver_params.get_or("tau_abs", std::numeric_limits<T>::epsilon()),
+                .tau_rel = solver_params.get_or("tau_rel", 0.0),
+                .kmax = solver_params.get_or("kmax", 100)
+            };
+            PMultigrid solver{fespace, disc, conv_criteria, solver_params.get_or("pmin", 0)};
+            solver.nu1 = solver_params.get_or("nu1", solver.nu1);
+            solver.nu2 = solver_params.get_or("nu2", solver.nu2);
+            solver.ncoarse = solver_params.get_or("ncoarse", solver.ncoarse);
+            solver.cfl = solver_params.get_or("cfl", solver.cfl);
+            solver.omega = solver_params.get_or("omega", solver.omega);
+            std::string smoother_name = solver_params.get_or("smoother", std::string{"rk3"});
+            if(eq_icase(smoother_name, "rk3")){
+                solver.smoother = PMG_SMOOTHER::RK3;
+            } else if(eq_icase_any(smoother_name, "block-jacobi", "block_jacobi")){
+                solver.smoother = PMG_SMOOTHER::BLOCK_JACOBI;
+            } else if(eq_icase_any(smoother_name, "block-gauss-seidel", "block_gauss_seidel")){
+                solver.smoother = PMG_SMOOTHER::BLOCK_GAUSS_SEIDEL;
+                std::string ordering_name = solver_params.get_or("sweep_ordering", std::string{"morton"});
+                if(eq_icase(ordering_name, "natural")) solver.sweep_ordering = SWEEP_ORDERING::NATURAL;
+                else if(eq_icase(ordering_name, "morton")) solver.sweep_ordering = SWEEP_ORDERING::MORTON;
+                else if(eq_icase(ordering_name, "lines")) solver.sweep_ordering = SWEEP_ORDERING::LINES;
+                else AnomalyLog::log_anomaly(Anomaly{"unrecognized sweep ordering: " + ordering_name, general_anomaly_tag{}});
+                sol::optional<sol::table> direction_tbl = solver_params["sweep_direction"];
+                if(direction_tbl) for(int i = 0; i < ndim; ++i) solver.sweep_direction[i] = direction_tbl.value()[i + 1];
+                solver.symmetric_sweeps = solver_params.get_or("symmetric_sweeps", solver.symmetric_sweeps);
+            } else {
+                AnomalyLog::log_anomaly(Anomaly{"unrecognized p-multigrid smoother: " + smoother_name, general_anomaly_tag{}});
+            }
+
+            // ==============================
+            // = During solve visualization =
+            // ==============================
+            solver.ivis = solver_params.get_or("ivis", 1);
+            io::Writer writer{lua_get_writer(config_tbl, fespace, disc, u)};
+            solver.vis_callback = [&](decltype(solver)& pmg, IDX k){
+                int myrank = 0;
+#ifdef ICEICLE_USE_MPI
+                MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
+#endif
+                if(myrank == 0){
+                    std::cout << std::setprecision(8);
+                    std::cout << "itime: " << std::setw(6) << k
+                        << " | levels: " << pmg.nlevel()
+                        << " | residual l2: " << std::setw(14) << pmg.res_norm
+                        << std::endl;
+                }
+                if(writer) writer.write(k, (T) k);
+            };
+
+            // === Check for invalid state ===
+            if(AnomalyLog::size() > 0){
+                AnomalyLog::handle_anomalies();
+                return;
+            }
+
+            IDX kfinal = solver.solve(u);
+            std::cout << "itime: " << std::setw(6) << kfinal
+                << " | Termination Criteria Reached"
+                << std::endl << std::endl;
+            if(writer) writer.write(kfinal, (T) kfinal);
+        } else if(eq_icase_any(solver_type, "spacetime-slab", "slab")) {
+            // Newton solves one time layer of a spacetime mesh at a time
+            // default is a maximum of 10 Newton iterations per layer to machine zero
+            ConvergenceCriteria<T, IDX> conv_criteria{
+                .tau_abs = solver_params.get_or("tau_abs", std::numeric_limits<T>::epsilon()),
+                .tau_rel = solver_params.get_or("tau_rel", 0.0),
+                .kmax = solver_params.get_or("kmax", 10)
+            };
+            SpacetimeSlabSolver solver{fespace, disc, conv_criteria, solver_params.get_or("time_tol", (T) 1e-8)};
+            solver.max_sweeps = solver_params.get_or("max_sweeps", solver.max_sweeps);
+            solver.linear_kmax = solver_params.get_or("linear_kmax", solver.linear_kmax);
+            solver.linear_rtol = solver_params.get_or("linear_rtol", solver.linear_rtol);
+            solver.verbosity = solver_params.get_or("verbosity", solver.verbosity);
+            io::Writer writer{lua_get_writer(config_tbl, fespace, disc, u)};
+
+            // === Check for invalid state ===
+            if(AnomalyLog::size() > 0){
+                AnomalyLog::handle_anomalies();
+                return;
+            }
+
+            IDX kfinal = solver.solve(u);
+            std::cout << "layers: " << solver.layers.nrow()
+                << " | newton iterations: " << kfinal
+                << " | Termination Criteria Reached"
+                << std::endl << std::endl;
+            if(writer) writer.write(0, (T) 0);
+        } else if(eq_icase_any(solver_type, "newton", "lm", "gauss-newton", "mfnk", "matrix-free-newton", "ptc")) {
             // Newton Solvers
 #ifdef ICEICLE_USE_PETSC
             
@@ -555,6 +1133,40 @@ namespace iceicle::solvers {
                 .kmax = solver_params.get_or("kmax", 5)
             };
 
+            // select the preconditioner for the linear solves
+            // given as a name or a table with the type and options
+            PetscPreconditioner preconditioner{};
+            {
+                std::string pc_name = "sor";
+                sol::optional<std::string> pc_name_opt = solver_params["preconditioner"];
+                sol::optional<sol::table> pc_tbl_opt = solver_params["preconditioner"];
+                if(pc_name_opt){
+                    pc_name = pc_name_opt.value();
+                } else if(pc_tbl_opt){
+                    sol::table pc_tbl = pc_tbl_opt.value();
+                    pc_name = pc_tbl.get_or("type", pc_name);
+                    preconditioner.ilu_levels = pc_tbl.get_or("ilu_levels", preconditioner.ilu_levels);
+                    preconditioner.overlap = pc_tbl.get_or("overlap", preconditioner.overlap);
+                    preconditioner.line_coupling_ratio = pc_tbl.get_or("coupling_ratio", preconditioner.line_coupling_ratio);
+                    preconditioner.max_line_length = pc_tbl.get_or("max_line_length", preconditioner.max_line_length);
+                    preconditioner.direct_package = pc_tbl.get_or("package", preconditioner.direct_package);
+                    preconditioner.direct_memory_relaxation = pc_tbl.get_or("memory_relaxation", preconditioner.direct_memory_relaxation);
+                    preconditioner.direct_max_memory = pc_tbl.get_or("max_memory", preconditioner.direct_max_memory);
+                }
+                if(eq_icase(pc_name, "sor")) preconditioner.type = PRECONDITIONER_TYPE::SOR;
+                else if(eq_icase_any(pc_name, "element-block-jacobi", "element_block_jacobi"))
+                    preconditioner.type = PRECONDITIONER_TYPE::ELEMENT_BLOCK_JACOBI;
+                else if(eq_icase_any(pc_name, "block-jacobi", "block_jacobi", "bjacobi"))
+                    preconditioner.type = PRECONDITIONER_TYPE::BLOCK_JACOBI;
+                else if(eq_icase(pc_name, "asm")) preconditioner.type = PRECONDITIONER_TYPE::ASM;
+                else if(eq_icase(pc_name, "gamg")) preconditioner.type = PRECONDITIONER_TYPE::GAMG;
+                else if(eq_icase_any(pc_name, "line-implicit", "line_implicit"))
+                    preconditioner.type = PRECONDITIONER_TYPE::LINE_IMPLICIT;
+                else if(eq_icase_any(pc_name, "direct", "lu")) preconditioner.type = PRECONDITIONER_TYPE::DIRECT;
+                else if(eq_icase(pc_name, "none")) preconditioner.type = PRECONDITIONER_TYPE::NONE;
+                else AnomalyLog::log_anomaly(Anomaly{"unrecognized preconditioner: " + pc_name, general_anomaly_tag{}});
+            }
+
             // select the linesearch type
             LinesearchVariant<T, IDX> linesearch;
             sol::optional<sol::table> ls_arg_opt = solver_params["linesearch"];
@@ -582,6 +1194,12 @@ namespace iceicle::solvers {
                 linesearch = no_linesearch<T, IDX>{};
             };
 
+            // the discretization to assemble the jacobian from
+            std::optional<DiscType> pc_disc_copy = lua_get_preconditioner_disc(solver_params, disc);
+            DiscType& pc_disc = pc_disc_copy ? pc_disc_copy.value() : disc;
+            sol::optional<sol::table> pc_disc_tbl = solver_params["preconditioner_disc"];
+            bool freeze_pc_disc_state = pc_disc_tbl ? pc_disc_tbl.value().get_or("freeze_state", false) : false;
+
             // create writers
             io::Writer writer{lua_get_writer(config_tbl, fespace, disc, u)};
             io::Writer residuals_writer{lua_get_residuals_writer(config_tbl, fespace, disc, u)};
@@ -610,6 +1228,38 @@ namespace iceicle::solvers {
                         sol::optional<T> verbosity = solver_params["verbosity"];
                         if(verbosity) solver.verbosity = verbosity.value();
 
+                        // adaptive linear solve tolerances
+                        if constexpr (requires { solver.forcing; }) {
+                            sol::optional<sol::table> forcing_opt = solver_params["forcing"];
+                            if(forcing_opt){
+                                sol::table forcing_tbl = forcing_opt.value();
+                                std::string forcing_type = forcing_tbl.get_or("type", std::string{"ew2"});
+                                if(eq_icase(forcing_type, "ew1")) solver.forcing.choice = 1;
+                                else if(eq_icase(forcing_type, "ew2")) solver.forcing.choice = 2;
+                                else AnomalyLog::log_anomaly(Anomaly{"Unrecognized forcing type: " + forcing_type, general_anomaly_tag{}});
+                                solver.forcing.eta0 = forcing_tbl.get_or("eta0", solver.forcing.eta0);
+                                solver.forcing.eta_max = forcing_tbl.get_or("eta_max", solver.forcing.eta_max);
+                                solver.forcing.gamma = forcing_tbl.get_or("gamma", solver.forcing.gamma);
+                                solver.forcing.alpha = forcing_tbl.get_or("alpha", solver.forcing.alpha);
+                            }
+                        }
+
+                        // iterative refinement of the linear solves
+                        if constexpr (requires { solver.linear_refinement; }) {
+                            solver.linear_refinement = solver_params.get_or("linear_refinement", solver.linear_refinement);
+                            solver.linear_refinement_rtol = solver_params.get_or("linear_refinement_rtol", solver.linear_refinement_rtol);
+                        }
+
+                        // restart files in binary (single shared file), incremental binary
+                        // (only the selected mdg nodes between full checkpoints), or ascii (one file per rank)
+                        std::string restart_format = solver_params.get_or("restart_format", std::string{"ascii"});
+                        IncrementalRestart<T, IDX, ndim> incremental_restart{solver_params.get_or("restart_nfull", (IDX) 10)};
+                        auto restart = [&](IDX k){
+                            if(eq_icase(restart_format, "binary")) write_restart_binary(fespace, u, k);
+                            else if(eq_icase(restart_format, "incremental")) incremental_restart.write(fespace, u, geo_map, k);
+                            else write_restart(fespace, u, k);
+                        };
+
                         // visualization callback
                         solver.vis_callback = [&](IDX k, Vec res_data, Vec du_data){
                                  T res_norm;
@@ -622,7 +1272,7 @@ namespace iceicle::solvers {
                                 // offset by initial solution iteration
                                 writer.write(k, (T) k);
 
-                                write_restart(fespace, u, k);
+                                restart(k);
                         };
 
                         // diagnostics callback views the residuals
@@ -652,13 +1302,21 @@ namespace iceicle::solvers {
                             << std::endl << std::endl;
                         writer.write(kfinal, (T) kfinal);
                         if(residuals_writer) residuals_writer.write(kfinal, (T) kfinal);
-                        write_restart(fespace, u, kfinal);
+                        restart(kfinal);
                     };
 
                     if(eq_icase_any(solver_type, "lm", "gauss-newton")){
                         bool form_subproblem = solver_params.get_or("form_subproblem_mat", false); 
                         bool sparse_jacobian = solver_params.get_or("sparse_jacobian_calculation", true);
-                        CorriganLM solver{fespace, disc, conv_criteria, ls, geo_map, form_subproblem, sparse_jacobian};
+                        bool least_squares = solver_params.get_or("least_squares_subproblem", false);
+                        if(form_subproblem && least_squares){
+                            AnomalyLog::log_anomaly(Anomaly{"form_subproblem_mat and least_squares_subproblem "
+                                    "are mutually exclusive", general_anomaly_tag{}});
+                        }
+                        CorriganLM solver{fespace, disc, pc_disc, conv_criteria, ls, geo_map, form_subproblem,
+                            sparse_jacobian, least_squares};
+                        solver.set_krylov_method(lua_get_krylov_method(solver_params));
+                        solver.freeze_pc_disc_state = freeze_pc_disc_state;
 
                         // set options for the solver 
                         sol::optional<T> lambda_u = solver_params["lambda_u"];
@@ -676,12 +1334,58 @@ namespace iceicle::solvers {
                         sol::optional<T> J_min = solver_params["J_min"];
                         if(J_min) solver.J_min = J_min.value();
 
+                        // incremental assembly of the geometry columns of the jacobian
+                        solver.incremental_mdg_jacobian = solver_params.get_or("incremental_mdg_jacobian", false);
+                        solver.mdg_cache.move_tolerance = solver_params.get_or("mdg_move_tolerance", (T) 0.0);
+                        solver.mdg_cache.refresh_interval = solver_params.get_or("mdg_refresh_interval", (IDX) 0);
+
                         setup_and_solve(solver);
                     } else if(eq_icase_any(solver_type, "newton")) {
-                        PetscNewton solver{fespace, disc, conv_criteria, ls};
+                        PetscNewton solver{fespace, disc, pc_disc, conv_criteria, ls};
+                        solver.fd_coloring = solver_params.get_or("fd_coloring", false);
+                        solver.freeze_pc_disc_state = freeze_pc_disc_state;
+                        if(pc_disc_tbl) solver.pc_disc_matrix_free = pc_disc_tbl.value().get_or("matrix_free", true);
+                        solver.set_preconditioner(preconditioner);
+                        solver.set_krylov_method(lua_get_krylov_method(solver_params));
+                        solver.set_krylov_recycling(lua_get_krylov_recycling(solver_params));
+
+                        // jacobian lagging
+                        sol::optional<sol::table> lag_opt = solver_params["jacobian_lag"];
+                        if(lag_opt){
+                            sol::table lag_tbl = lag_opt.value();
+                            solver.jacobian_lag.refresh_interval = lag_tbl.get_or("interval", 1);
+                            solver.jacobian_lag.stall_ratio = lag_tbl.get_or("stall_ratio", 0.5);
+                            solver.jacobian_lag.alpha_min = lag_tbl.get_or("alpha_min", 0.1);
+                        }
+                        setup_and_solve(solver);
+                    } else if(eq_icase_any(solver_type, "ptc")) {
+                        PetscPTC solver{fespace, disc, conv_criteria, ls};
+                        solver.fd_coloring = solver_params.get_or("fd_coloring", false);
+                        solver.set_preconditioner(preconditioner);
+                        solver.set_krylov_method(lua_get_krylov_method(solver_params));
+                        solver.set_krylov_recycling(lua_get_krylov_recycling(solver_params));
+                        solver.cfl0 = solver_params.get_or("cfl0", solver.cfl0);
+                        solver.cfl_max = solver_params.get_or("cfl_max", solver.cfl_max);
+                        solver.ser_exponent = solver_params.get_or("ser_exponent", solver.ser_exponent);
                         setup_and_solve(solver);
                     } else if(eq_icase_any(solver_type, "mfnk", "matrix-free-newton")) {
-                        MFNK solver{fespace, disc, conv_criteria, ls, geo_map};
+                        MFNK solver{fespace, disc, pc_disc, conv_criteria, ls, geo_map};
+                        solver.freeze_pc_disc_state = freeze_pc_disc_state;
+                        solver.block_jacobi.single_precision = solver_params.get_or("pc_single_precision", false);
+                        solver.krylov_method = lua_get_krylov_method(solver_params);
+                        solver.krylov_recycling = lua_get_krylov_recycling(solver_params);
+                        // the matrix free solver only has the element preconditioners
+                        solver.use_line_implicit = (preconditioner.type == PRECONDITIONER_TYPE::LINE_IMPLICIT);
+                        solver.line_implicit.coupling_ratio = preconditioner.line_coupling_ratio;
+                        solver.line_implicit.max_line_length = preconditioner.max_line_length;
+                        std::string mf_difference_name = solver_params.get_or("mf_difference", std::string{"forward"});
+                        if(eq_icase(mf_difference_name, "central")) solver.difference = mf_difference::central;
+                        else if(!eq_icase(mf_difference_name, "forward"))
+                            AnomalyLog::log_anomaly(Anomaly{"Unrecognized mf_difference: " + mf_difference_name, general_anomaly_tag{}});
+                        std::string mf_step_name = solver_params.get_or("mf_step", std::string{"fixed"});
+                        if(eq_icase(mf_step_name, "scaled")) solver.step = mf_step::scaled;
+                        else if(!eq_icase(mf_step_name, "fixed"))
+                            AnomalyLog::log_anomaly(Anomaly{"Unrecognized mf_step: " + mf_step_name, general_anomaly_tag{}});
                         setup_and_solve(solver);
                     }
                 }
@@ -694,6 +1398,51 @@ namespace iceicle::solvers {
     }
 
 
+    /// @brief the number of p-adaptation cycles from the user configuration (p_adapt.ncycles)
+    /// 1 if there is no p_adapt table (a single solve)
+    inline auto lua_p_adapt_ncycles(sol::table config_tbl) -> int {
+        sol::optional<sol::table> p_adapt_opt = config_tbl["p_adapt"];
+        return (p_adapt_opt) ? p_adapt_opt.value().get_or("ncycles", 2) : 1;
+    }
+
+    /**
+     * @brief adapt the element orders from the modal decay indicator of the solution
+     * and transfer the solution to the new space (see p_adaptivity.hpp)
+     * does nothing if there is no p_adapt table in the configuration
+     *
+     * @param config_tbl the user configuration lua table
+     * @param fespace the finite element space (Legendre basis)
+     * @param disc the discretization
+     * @param u_data the solution data (resized for the new space)
+     */
+    template<class T, class IDX, int ndim, class DiscType, class DataT>
+    auto lua_p_adapt(
+        sol::table config_tbl,
+        FESpace<T, IDX, ndim>& fespace,
+        DiscType& disc,
+        DataT& u_data
+    ) -> void {
+        sol::optional<sol::table> p_adapt_opt = config_tbl["p_adapt"];
+        if(!p_adapt_opt) return;
+        sol::table p_adapt_tbl = p_adapt_opt.value();
+        PAdaptation<T> adaptation{};
+        adaptation.refine_threshold = p_adapt_tbl.get_or("refine", adaptation.refine_threshold);
+        adaptation.coarsen_threshold = p_adapt_tbl.get_or("coarsen", adaptation.coarsen_threshold);
+        adaptation.pmin = p_adapt_tbl.get_or("pmin", adaptation.pmin);
+        adaptation.pmax = std::min(p_adapt_tbl.get_or("pmax", adaptation.pmax), build_config::FESPACE_BUILD_PN);
+
+        static constexpr int neq = DiscType::nv_comp;
+        fespan u{u_data.data(), fe_layout_right{fespace.dg_map, tmp::to_size<neq>{}}};
+        std::vector<T> indicator = modal_decay_indicator(fespace, u);
+        std::vector<int> orders = adaptation.select_orders(fespace, std::span<const T>{indicator});
+        IDX ndof_old = fespace.dg_map.calculate_size_requirement(1);
+        p_adapt<neq>(fespace, std::span<const int>{orders}, u_data);
+        IDX ndof_new = fespace.dg_map.calculate_size_requirement(1);
+        mpi::execute_on_rank(0, [&]{
+            std::cout << "p-adaptation: " << ndof_old << " -> " << ndof_new << " local dofs on rank 0" << std::endl;
+        });
+    }
+
     template<class T, class IDX, int ndim, class DiscType, class LayoutPolicy>
     auto lua_error_analysis(
         sol::table config_tbl,
@@ -746,7 +1495,7 @@ namespace iceicle::solvers {
 
                             std::vector<T> projected_data(u.size());
                             fespan u_proj{projected_data, u.get_layout()};
-                            projection_initialization(fespace, exactfunc, tmp::compile_int<DiscType::nv_comp>{}, u_proj);
+                            projection_initialization(fespace, exactfunc, tmp::compile_int<DiscType::nv_comp>{}, u_proj, false);
 
                             // get the writer and write out
                             io::Writer writer{lua_get_writer(config_tbl, fespace, disc, u_proj)};
@@ -778,19 +1527,10 @@ namespace iceicle::solvers {
                                 }
                             };
 
+                            // summed over all processes
                             T error = l2_error(exactfunc, fespace, u);
-#ifdef ICEICLE_USE_MPI
-                            error = error * error; // un-sqrt it before we sum :3
-                            T error_reduce;
-                            MPI_Allreduce(&error, &error_reduce, 1, mpi_get_type<T>(), MPI_SUM, MPI_COMM_WORLD);
-
-                            int myrank;
-                            MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
-                            if(myrank == 0)
-                                std::cout << "L2 error: " << std::setprecision(12) << std::sqrt(error_reduce) << std::endl;
-#else
-                            std::cout << "L2 error: " << std::setprecision(12) << error << std::endl;
-#endif
+                            if(mpi::mpi_world_rank() == 0)
+                                std::cout << "L2 error: " << std::setprecision(12) << error << std::endl;
                         } 
 
                         if(eq_icase(task_name, "l1_error")){
@@ -879,6 +1619,52 @@ namespace iceicle::solvers {
 #endif
                         }
 
+                        if(eq_icase(task_name, "error_norms")){
+                            // ====================
+                            // = Error Norms Task =
+                            // ====================
+                            // L2, L infinity, and (if post.exact_gradient is given) H1 seminorm errors
+                            // of every component in one pass
+                            sol::optional<sol::function> grad_opt = post_config["exact_gradient"];
+                            batched_exact_solution<T> exactfunc = [exact, grad_opt]
+                                (int npoin, const T* x, T* u_exact, T* grad_exact)
+                            {
+                                std::integer_sequence x_idx_seq = std::make_integer_sequence<int, ndim>();
+                                auto helper = [&]<int... Indices>(const T* xpt, T* upt, T* gradpt, std::integer_sequence<int, Indices...>){
+                                    if constexpr(DiscType::nv_comp == 1){
+                                        upt[0] = exact(xpt[Indices]...);
+                                    } else {
+                                        sol::table fout = exact(xpt[Indices]...);
+                                        for(int i = 0; i < DiscType::nv_comp; ++i)
+                                            upt[i] = fout[i + 1]; // lua 1-index
+                                    }
+                                    if(gradpt != nullptr){
+                                        // component major: du_i/dx_j at [i * ndim + j]
+                                        sol::table gout = grad_opt.value()(xpt[Indices]...);
+                                        for(int i = 0; i < DiscType::nv_comp * ndim; ++i)
+                                            gradpt[i] = gout[i + 1];
+                                    }
+                                };
+                                for(int ipoin = 0; ipoin < npoin; ++ipoin){
+                                    helper(x + ipoin * ndim, u_exact + ipoin * DiscType::nv_comp,
+                                        (grad_exact == nullptr) ? nullptr : grad_exact + ipoin * DiscType::nv_comp * ndim,
+                                        x_idx_seq);
+                                }
+                            };
+
+                            ErrorNorms<T> norms = error_norms(exactfunc, fespace, u, grad_opt.has_value());
+                            mpi::execute_on_rank(0, [&]{
+                                auto print_norm = [](const char* name, const std::vector<T>& errors, T total){
+                                    std::cout << name << std::setprecision(12);
+                                    for(T e : errors) std::cout << e << " ";
+                                    std::cout << "(total: " << total << ")" << std::endl;
+                                };
+                                print_norm("L2 error: ", norms.l2, norms.l2_total());
+                                print_norm("L_infty error: ", norms.linf, norms.linf_total());
+                                if(grad_opt) print_norm("H1 seminorm error: ", norms.h1_semi, norms.h1_semi_total());
+                            });
+                        }
+
                         if(eq_icase(task_name, "ic_residual")){
                             // ====================
                             // = ic residual Task =
@@ -0,0 +1,543 @@
+/**
+ * @brief solve a spacetime mesh one time layer (slab) of elements at a time
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/anomaly_log.hpp"
+#include "iceicle/crs.hpp"
+#include "iceicle/fd_utils.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/form_residual.hpp"
+#include "iceicle/geometry/face.hpp"
+#include "iceicle/linalg/small_dense.hpp"
+#include "iceicle/nonlinear_solver_utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <vector>
+
+namespace iceicle::solvers {
+
+    /**
+     * @brief group the elements of a spacetime mesh (time is the last dimension) into time layers
+     *
+     * An interior face couples a layer to a later layer when the centroid time of the element
+     * across the face is later by more than the tolerance.
+     * Each element is put in the layer one past the latest layer that it is coupled to in the past
+     * so for an extruded mesh every row of elements in time is a layer
+     *
+     * @param fespace the finite element space
+     * @param time_tol the tolerance for equal centroid times relative to the time extent of the mesh
+     * @return the element indices of each layer (rows in causal order)
+     */
+    template<class T, class IDX, int ndim>
+    auto compute_time_layers(
+        FESpace<T, IDX, ndim>& fespace,
+        T time_tol = 1e-8
+    ) -> util::crs<IDX, IDX> {
+        static constexpr int idim_time = ndim - 1;
+        const std::size_t nelem = fespace.elements.size();
+        if(nelem == 0) return util::crs<IDX, IDX>{};
+
+        std::vector<T> tcent(nelem);
+        for(std::size_t iel = 0; iel < nelem; ++iel)
+            { tcent[iel] = fespace.elements[iel].centroid()[idim_time]; }
+        auto [tmin, tmax] = std::ranges::minmax(tcent);
+        T tol = time_tol * std::max(tmax - tmin, std::numeric_limits<T>::min());
+
+        // every element in the past of an element has a smaller centroid time
+        // so visiting in order of time finalizes the layer of each element before it is used
+        std::vector<IDX> order(nelem);
+        std::iota(order.begin(), order.end(), 0);
+        std::ranges::sort(order, [&](IDX a, IDX b){ return tcent[a] < tcent[b]; });
+
+        const util::crs<IDX>& fac_surr_el = fespace.fac_surr_el();
+        std::vector<IDX> layer(nelem, 0);
+        IDX nlayer = 1;
+        for(IDX iel : order){
+            for(IDX itrace : fac_surr_el.rowspan(iel)){
+                if(itrace < (IDX) fespace.interior_trace_start || itrace >= (IDX) fespace.interior_trace_end) continue;
+                const TraceSpace<T, IDX, ndim>& trace = fespace.traces[itrace];
+                IDX jel = (trace.elL.elidx == iel) ? trace.elR.elidx : trace.elL.elidx;
+                if(tcent[jel] > tcent[iel] + tol){
+                    layer[jel] = std::max(layer[jel], layer[iel] + 1);
+                    nlayer = std::max(nlayer, layer[jel] + 1);
+                }
+            }
+        }
+
+        std::vector<std::vector<IDX>> layer_elements(nlayer);
+        for(IDX iel = 0; iel < (IDX) nelem; ++iel) layer_elements[layer[iel]].push_back(iel);
+        return util::crs<IDX, IDX>{layer_elements};
+    }
+
+    /**
+     * @brief Newton solver for spacetime discretizations that solves one time layer of elements at a time
+     *
+     * With upwinding in time the residual of a layer only depends on that layer and the layers before it,
+     * so the spacetime jacobian is block lower triangular in the layers.
+     * A sweep solves each layer in causal order with the earlier layers fixed,
+     * turning one large spacetime solve into a sequence of small solves.
+     *
+     * Each layer is solved with Newton's method. The layer jacobian is formed by element local finite differences
+     * and stored as element blocks (the diagonal blocks and the couplings across the interior faces of the layer)
+     * then solved with symmetric block Gauss-Seidel iterations.
+     * All the working storage is sized to the largest layer.
+     *
+     * When the layers are not exactly causal (i.e tilted faces between elements that should share a layer)
+     * set max_sweeps > 1 to repeat the sweep until the residual of all the layers converges
+     *
+     * NOTE: the solution dependent data cached by the discretization (see update_cached_state)
+     * is updated at the start of every sweep
+     * NOTE: operates on the process local mesh, parallel communication traces are not supported
+     *
+     * @tparam T the floating point type
+     * @tparam IDX the index type
+     * @tparam ndim the number of dimensions (including time as the last dimension)
+     * @tparam disc_class the discretization type
+     */
+    template<class T, class IDX, int ndim, class disc_class>
+    class SpacetimeSlabSolver {
+        public:
+
+        using Element = FiniteElement<T, IDX, ndim>;
+        using Trace = TraceSpace<T, IDX, ndim>;
+
+        // ================
+        // = Data Members =
+        // ================
+
+        /// @brief the finite element space
+        FESpace<T, IDX, ndim>& fespace;
+
+        /// @brief the discretization
+        disc_class& disc;
+
+        /// @brief the convergence criteria for the Newton iterations of each layer
+        ConvergenceCriteria<T, IDX> conv_criteria;
+
+        /// @brief the element indices of each time layer in causal order
+        util::crs<IDX, IDX> layers;
+
+        /// @brief the maximum number of sweeps over all the layers
+        IDX max_sweeps = 1;
+
+        /// @brief the maximum number of block Gauss-Seidel iterations per linear solve
+        IDX linear_kmax = 50;
+
+        /// @brief the relative tolerance of the linear solves
+        T linear_rtol = 1e-10;
+
+        /// @brief the epsilon for the finite difference jacobian
+        /// NOTE: this gets scaled by the norm of the compact residual vector
+        T epsilon = std::sqrt(std::numeric_limits<T>::epsilon());
+
+        /// @brief print the convergence of every layer if > 0
+        int verbosity = 0;
+
+        /// @brief the residual norm over all the layers after the last sweep
+        /// (only computed when max_sweeps > 1)
+        T res_norm = 0;
+
+        private:
+
+        static constexpr std::size_t ncomp = disc_class::dnv_comp;
+
+        /// @brief the coupling of the row element to the element jlocal in the layer jacobian
+        struct coupling {
+            /// @brief the layer local index of the column element
+            IDX jlocal;
+            /// @brief the offset of the block in offdiag_data
+            std::size_t offset;
+        };
+
+        // === per layer working storage (reused for every layer) ===
+
+        /// @brief the layer local index of each element (-1 if not in the current layer)
+        std::vector<IDX> local_index;
+
+        /// @brief the traces touching the elements of the layer
+        std::vector<IDX> layer_traces{};
+
+        /// @brief the offset of each local element in the residual and update vectors
+        std::vector<std::size_t> el_offsets{};
+
+        /// @brief the offset of each local element diagonal block
+        std::vector<std::size_t> diag_offsets{};
+
+        std::vector<T> res{};
+        std::vector<T> du{};
+        std::vector<T> du_relax{};
+        std::vector<T> diag_data{};
+        std::vector<linalg::pivot_index> piv{};
+        std::vector<T> offdiag_data{};
+        std::vector<std::vector<coupling>> row_couplings{};
+
+        // compact element scratch storage
+        std::vector<T> uL_data, uR_data, resL_data, resR_data, resLp_data, resRp_data;
+
+        /// @brief the number of unknowns of an element
+        auto el_size(IDX iel) const -> std::size_t { return fespace.elements[iel].nbasis() * ncomp; }
+
+        /// @brief set up the indexing and storage for a layer
+        auto setup_layer(std::span<const IDX> elidxs) -> void {
+            el_offsets.assign(elidxs.size() + 1, 0);
+            diag_offsets.assign(elidxs.size() + 1, 0);
+            layer_traces.clear();
+            for(std::size_t ilocal = 0; ilocal < elidxs.size(); ++ilocal){
+                IDX iel = elidxs[ilocal];
+                local_index[iel] = ilocal;
+                std::size_t n = el_size(iel);
+                el_offsets[ilocal + 1] = el_offsets[ilocal] + n;
+                diag_offsets[ilocal + 1] = diag_offsets[ilocal] + n * n;
+                for(IDX itrace : fespace.fac_surr_el().rowspan(iel)) layer_traces.push_back(itrace);
+            }
+            std::ranges::sort(layer_traces);
+            auto [first, last] = std::ranges::unique(layer_traces);
+            layer_traces.erase(first, last);
+
+            res.resize(el_offsets.back());
+            du.resize(el_offsets.back());
+            du_relax.resize(el_offsets.back());
+            diag_data.resize(diag_offsets.back());
+            piv.resize(el_offsets.back());
+            row_couplings.resize(elidxs.size());
+        }
+
+        /// @brief reset the local indices of a layer
+        auto release_layer(std::span<const IDX> elidxs) -> void {
+            for(IDX iel : elidxs) local_index[iel] = -1;
+        }
+
+        auto is_boundary(IDX itrace) const -> bool
+        { return itrace >= (IDX) fespace.bdy_trace_start && itrace < (IDX) fespace.bdy_trace_end; }
+
+        /// @brief the residual of the layer elements at u
+        /// @return the l2 norm of the layer residual
+        template<class uLayoutPolicy, class uAccessorPolicy>
+        auto layer_residual(std::span<const IDX> elidxs, fespan<T, uLayoutPolicy, uAccessorPolicy> u) -> T {
+            std::ranges::fill(res, 0.0);
+            auto add_local = [&](IDX iel, auto res_el){
+                T* res_local = res.data() + el_offsets[local_index[iel]];
+                for(std::size_t i = 0; i < res_el.size(); ++i) res_local[i] += res_el.data()[i];
+            };
+
+            for(IDX itrace : layer_traces){
+                const Trace& trace = fespace.traces[itrace];
+                if(trace.face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) continue;
+                dofspan uL{uL_data.data(), u.create_element_layout(trace.elL.elidx)};
+                dofspan uR{uR_data.data(), u.create_element_layout(trace.elR.elidx)};
+                dofspan resL{resL_data.data(), u.create_element_layout(trace.elL.elidx)};
+                dofspan resR{resR_data.data(), u.create_element_layout(trace.elR.elidx)};
+                extract_elspan(trace.elL.elidx, u, uL);
+                extract_elspan(trace.elR.elidx, u, uR);
+                resL = 0;
+                if(is_boundary(itrace)){
+                    disc.boundaryIntegral(trace, fespace.meshptr->coord, uL, uR, resL);
+                    add_local(trace.elL.elidx, resL);
+                } else {
+                    resR = 0;
+                    disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, resL, resR);
+                    if(local_index[trace.elL.elidx] >= 0) add_local(trace.elL.elidx, resL);
+                    if(local_index[trace.elR.elidx] >= 0) add_local(trace.elR.elidx, resR);
+                }
+            }
+
+            for(IDX iel : elidxs){
+                const Element& el = fespace.elements[iel];
+                dofspan u_el{uL_data.data(), u.create_element_layout(iel)};
+                dofspan res_el{resL_data.data(), u.create_element_layout(iel)};
+                extract_elspan(iel, u, u_el);
+                res_el = 0;
+                disc.domain_integral(el, u_el, res_el);
+                add_local(iel, res_el);
+            }
+
+            T sum = 0;
+            for(T r : res) sum += r * r;
+            return std::sqrt(sum);
+        }
+
+        /// @brief the jacobian block of the residual of element irow wrt the solution on element jcol
+        /// NOTE: the coupling block must have been created with coupling_block_for()
+        auto block(IDX irow, IDX jcol) -> T* {
+            IDX ilocal = local_index[irow], jlocal = local_index[jcol];
+            if(ilocal == jlocal) return diag_data.data() + diag_offsets[ilocal];
+            for(const coupling& c : row_couplings[ilocal])
+                if(c.jlocal == jlocal) return offdiag_data.data() + c.offset;
+            return nullptr;
+        }
+
+        /// @brief create the coupling block of the residual of irow wrt the solution of jcol if it does not exist
+        auto coupling_block_for(IDX irow, IDX jcol) -> void {
+            IDX ilocal = local_index[irow], jlocal = local_index[jcol];
+            for(const coupling& c : row_couplings[ilocal]) if(c.jlocal == jlocal) return;
+            row_couplings[ilocal].push_back(coupling{jlocal, offdiag_data.size()});
+            offdiag_data.resize(offdiag_data.size() + el_size(irow) * el_size(jcol), 0.0);
+        }
+
+        /**
+         * @brief finite difference of the compact residuals wrt ujac added to the jacobian blocks
+         * @param res_op res_op(resLp, resRp) evaluates the perturbed residuals
+         * @param jcol the element of the solution ujac
+         * @param rows the elements, base residuals, and perturbed residuals of each row
+         */
+        template<class ResOp, class uSpan, class Rows>
+        auto fd_columns(ResOp&& res_op, IDX jcol, uSpan ujac, T scale, Rows&& rows) -> void {
+            T eps_scaled = scale_fd_epsilon(epsilon, scale);
+            const std::size_t ncol = ujac.size();
+            for(IDX idofu = 0; idofu < ujac.ndof(); ++idofu){
+                for(IDX iequ = 0; iequ < (IDX) ncomp; ++iequ){
+                    IDX jdof = ujac.get_layout()[idofu, iequ];
+                    T old_val = ujac[idofu, iequ];
+                    ujac[idofu, iequ] += eps_scaled;
+                    res_op();
+                    for(auto& [irow, resbase, resp] : rows){
+                        if(irow < 0) continue;
+                        T* blk = block(irow, jcol);
+                        for(std::size_t idof = 0; idof < resbase.size(); ++idof)
+                            { blk[idof * ncol + jdof] += (resp.data()[idof] - resbase.data()[idof]) / eps_scaled; }
+                    }
+                    ujac[idofu, iequ] = old_val;
+                }
+            }
+        }
+
+        /// @brief form the layer jacobian blocks at u and factor the diagonal blocks
+        template<class uLayoutPolicy, class uAccessorPolicy>
+        auto layer_jacobian(std::span<const IDX> elidxs, fespan<T, uLayoutPolicy, uAccessorPolicy> u) -> void {
+            std::ranges::fill(diag_data, 0.0);
+            offdiag_data.clear();
+            for(std::vector<coupling>& row : row_couplings) row.clear();
+
+            for(IDX itrace : layer_traces){
+                const Trace& trace = fespace.traces[itrace];
+                if(trace.face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) continue;
+                const IDX iell = trace.elL.elidx, ielr = trace.elR.elidx;
+                dofspan uL{uL_data.data(), u.create_element_layout(iell)};
+                dofspan uR{uR_data.data(), u.create_element_layout(ielr)};
+                dofspan resL{resL_data.data(), u.create_element_layout(iell)};
+                dofspan resR{resR_data.data(), u.create_element_layout(ielr)};
+                dofspan resLp{resLp_data.data(), u.create_element_layout(iell)};
+                dofspan resRp{resRp_data.data(), u.create_element_layout(ielr)};
+                extract_elspan(iell, u, uL);
+                extract_elspan(ielr, u, uR);
+                resL = 0;
+
+                if(is_boundary(itrace)){
+                    disc.boundaryIntegral(trace, fespace.meshptr->coord, uL, uR, resL);
+                    std::array rows{std::tuple{iell, resL, resLp}};
+                    fd_columns([&]{
+                        resLp = 0;
+                        disc.boundaryIntegral(trace, fespace.meshptr->coord, uL, uR, resLp);
+                    }, iell, uL, resL.vector_norm(), rows);
+                } else {
+                    resR = 0;
+                    disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, resL, resR);
+                    bool left_in = local_index[iell] >= 0, right_in = local_index[ielr] >= 0;
+                    if(left_in && right_in){
+                        coupling_block_for(iell, ielr);
+                        coupling_block_for(ielr, iell);
+                    }
+                    // rows outside the layer are skipped
+                    std::array rows{std::tuple{left_in ? iell : (IDX) -1, resL, resLp},
+                        std::tuple{right_in ? ielr : (IDX) -1, resR, resRp}};
+                    auto perturbed = [&]{
+                        resLp = 0;
+                        resRp = 0;
+                        disc.trace_integral(trace, fespace.meshptr->coord, uL, uR, resLp, resRp);
+                    };
+                    T scale = std::hypot(resL.vector_norm(), resR.vector_norm());
+                    if(left_in) fd_columns(perturbed, iell, uL, scale, rows);
+                    if(right_in) fd_columns(perturbed, ielr, uR, scale, rows);
+                }
+            }
+
+            for(IDX iel : elidxs){
+                const Element& el = fespace.elements[iel];
+                dofspan u_el{uL_data.data(), u.create_element_layout(iel)};
+                dofspan res_el{resL_data.data(), u.create_element_layout(iel)};
+                dofspan resp_el{resLp_data.data(), u.create_element_layout(iel)};
+                extract_elspan(iel, u, u_el);
+                res_el = 0;
+                disc.domain_integral(el, u_el, res_el);
+                std::array rows{std::tuple{iel, res_el, resp_el}};
+                fd_columns([&]{
+                    resp_el = 0;
+                    disc.domain_integral(el, u_el, resp_el);
+                }, iel, u_el, res_el.vector_norm(), rows);
+            }
+
+            // factor the diagonal blocks in place
+            for(std::size_t ilocal = 0; ilocal < elidxs.size(); ++ilocal){
+                const std::size_t n = el_offsets[ilocal + 1] - el_offsets[ilocal];
+                T* d = diag_data.data() + diag_offsets[ilocal];
+                linalg::pivot_index* p = piv.data() + el_offsets[ilocal];
+                bool factored = linalg::dispatch_basis_size(n, [&](auto N) -> bool {
+                    return linalg::lu_factor<decltype(N)::value>(d, p, n);
+                });
+                if(!factored){
+                    // set to Identity on failure and log anomaly
+                    std::fill_n(d, n * n, 0.0);
+                    for(std::size_t i = 0; i < n; ++i){
+                        d[i * n + i] = 1.0;
+                        p[i] = static_cast<linalg::pivot_index>(i);
+                    }
+                    util::AnomalyLog::log_record("Singular jacobian block encountered on element ", elidxs[ilocal]);
+                }
+            }
+        }
+
+        /// @brief rhs - sum over the couplings of row ilocal of A_ij du_j into out
+        auto subtract_couplings(std::size_t ilocal, const T* rhs, T* out) const -> void {
+            const std::size_t n = el_offsets[ilocal + 1] - el_offsets[ilocal];
+            std::copy_n(rhs, n, out);
+            for(const coupling& c : row_couplings[ilocal]){
+                const T* blk = offdiag_data.data() + c.offset;
+                const T* du_j = du.data() + el_offsets[c.jlocal];
+                const std::size_t m = el_offsets[c.jlocal + 1] - el_offsets[c.jlocal];
+                for(std::size_t i = 0; i < n; ++i){
+                    T sum = 0;
+                    for(std::size_t j = 0; j < m; ++j) sum += blk[i * m + j] * du_j[j];
+                    out[i] -= sum;
+                }
+            }
+        }
+
+        /**
+         * @brief solve J du = -res with symmetric block Gauss-Seidel iterations
+         * until the relative change in du over an iteration is below linear_rtol
+         */
+        auto layer_linear_solve() -> void {
+            const std::size_t nlocal = el_offsets.size() - 1;
+            std::ranges::fill(du, 0.0);
+            for(T& r : res) r = -r;
+
+            // relax the row ilocal and return the squared change in du
+            auto relax = [&](std::size_t ilocal) -> T {
+                const std::size_t n = el_offsets[ilocal + 1] - el_offsets[ilocal];
+                T* du_i = du.data() + el_offsets[ilocal];
+                T* du_new = du_relax.data() + el_offsets[ilocal];
+                subtract_couplings(ilocal, res.data() + el_offsets[ilocal], du_new);
+                const T* d = diag_data.data() + diag_offsets[ilocal];
+                const linalg::pivot_index* p = piv.data() + el_offsets[ilocal];
+                linalg::dispatch_basis_size(n, [&](auto N){
+                    linalg::lu_solve<decltype(N)::value>(d, p, du_new, n);
+                });
+                T change = 0;
+                for(std::size_t i = 0; i < n; ++i){
+                    change += (du_new[i] - du_i[i]) * (du_new[i] - du_i[i]);
+                    du_i[i] = du_new[i];
+                }
+                return change;
+            };
+
+            for(IDX k = 0; k < linear_kmax; ++k){
+                T change = 0;
+                for(std::size_t ilocal = 0; ilocal < nlocal; ++ilocal) change += relax(ilocal);
+                for(std::size_t ilocal = nlocal; ilocal-- > 0;) change += relax(ilocal);
+
+                // a single element has no couplings so one relaxation is exact
+                if(nlocal == 1) break;
+                T du_norm = 0;
+                for(T d : du) du_norm += d * d;
+                if(change <= linear_rtol * linear_rtol * du_norm) break;
+            }
+        }
+
+        public:
+
+        /**
+         * @brief constructor
+         * @param fespace the finite element space
+         * @param disc the discretization
+         * @param conv_criteria the convergence criteria for the Newton iterations of each layer
+         * @param time_tol the tolerance for equal centroid times (see compute_time_layers)
+         */
+        SpacetimeSlabSolver(
+            FESpace<T, IDX, ndim>& fespace,
+            disc_class& disc,
+            const ConvergenceCriteria<T, IDX>& conv_criteria,
+            T time_tol = 1e-8
+        ) : fespace{fespace}, disc{disc}, conv_criteria{conv_criteria},
+            layers{compute_time_layers(fespace, time_tol)}, local_index(fespace.elements.size(), -1)
+        {
+            const std::size_t max_local_size = fespace.dg_map.max_el_size_reqirement(ncomp);
+            for(std::vector<T>* scratch : {&uL_data, &uR_data, &resL_data, &resR_data, &resLp_data, &resRp_data})
+                scratch->resize(max_local_size);
+            for(const Trace& trace : fespace.get_boundary_traces()){
+                if(trace.face->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM){
+                    util::AnomalyLog::log_anomaly(util::Anomaly{"SpacetimeSlabSolver does not support "
+                            "parallel communication traces", util::general_anomaly_tag{}});
+                    break;
+                }
+            }
+        }
+
+        /**
+         * @brief solve the discretization by sweeping over the time layers
+         * @param u the initial guess and the solution on return
+         * @return the total number of Newton iterations over all the layers
+         */
+        template<class uLayoutPolicy, class uAccessorPolicy>
+        auto solve(fespan<T, uLayoutPolicy, uAccessorPolicy> u) -> IDX {
+            IDX ktotal = 0;
+            T res_norm0 = 0;
+            for(IDX isweep = 0; isweep < max_sweeps; ++isweep){
+                update_cached_state(fespace, disc, u);
+                for(IDX ilayer = 0; ilayer < (IDX) layers.nrow(); ++ilayer){
+                    std::span<const IDX> elidxs = layers.rowspan(ilayer);
+                    setup_layer(elidxs);
+
+                    T rnorm = layer_residual(elidxs, u);
+                    conv_criteria.r0 = rnorm;
+                    T tau = conv_criteria.tau_abs + conv_criteria.tau_rel * conv_criteria.r0;
+                    IDX k = 0;
+                    for(; k < conv_criteria.kmax && rnorm > tau; ++k){
+                        layer_jacobian(elidxs, u);
+                        layer_linear_solve();
+                        for(std::size_t ilocal = 0; ilocal < elidxs.size(); ++ilocal){
+                            dofspan du_el{du.data() + el_offsets[ilocal], u.create_element_layout(elidxs[ilocal])};
+                            scatter_elspan(elidxs[ilocal], 1.0, du_el, 1.0, u);
+                        }
+                        rnorm = layer_residual(elidxs, u);
+                    }
+                    ktotal += k;
+                    if(verbosity > 0){
+                        std::cout << std::setprecision(8)
+                            << "sweep: " << std::setw(4) << isweep
+                            << " | layer: " << std::setw(6) << ilayer
+                            << " | newton iterations: " << std::setw(4) << k
+                            << " | residual l2: " << std::setw(14) << rnorm << std::endl;
+                    }
+                    release_layer(elidxs);
+                }
+
+                if(max_sweeps == 1) break;
+
+                // the residual of every layer with the final solution of the sweep
+                T sum = 0;
+                for(IDX ilayer = 0; ilayer < (IDX) layers.nrow(); ++ilayer){
+                    std::span<const IDX> elidxs = layers.rowspan(ilayer);
+                    setup_layer(elidxs);
+                    T layer_norm = layer_residual(elidxs, u);
+                    sum += layer_norm * layer_norm;
+                    release_layer(elidxs);
+                }
+                res_norm = std::sqrt(sum);
+                if(isweep == 0) res_norm0 = res_norm;
+                if(res_norm <= conv_criteria.tau_abs + conv_criteria.tau_rel * res_norm0) break;
+            }
+            return ktotal;
+        }
+    };
+
+    template<class T, class IDX, int ndim, class disc_class>
+    SpacetimeSlabSolver(FESpace<T, IDX, ndim>&, disc_class&, const ConvergenceCriteria<T, IDX>&)
+        -> SpacetimeSlabSolver<T, IDX, ndim, disc_class>;
+}
@@ -11,9 +11,13 @@
 #include "iceicle/fe_function/fespan.hpp"
 #include "iceicle/fespace/fespace.hpp"
 #include "iceicle/form_residual.hpp"
+#include "iceicle/cg_assembly.hpp"
+#include "iceicle/element_linear_solve.hpp"
 #include "iceicle/explicit_utils.hpp"
+#include "iceicle/coroutine_executor.hpp"
 
 #include <iostream>
+#include <span>
 #include <iomanip>
 namespace iceicle::solvers {
 
@@ -27,6 +31,10 @@ namespace iceicle::solvers {
  * 1/2 | 1/4  1/4  0
  * ----+---------------
  *     | 1/6  1/6  2/3
+ *
+ * Each stage is evaluated in the equivalent Shu-Osher form 
+ * with the residual, inverse mass matrix, and stage update fused per element (see FusedRKStage)
+ * so only two stage solutions are stored in addition to u and the residual
  */
 template< class T, class IDX, class TimestepClass, class StopCondition>
 class RK3SSP {
@@ -42,8 +50,23 @@ public:
     /// @brief the residual data array
     std::vector<T> res_data;
 
-    /// @brief intermediate step data arrays
-    std::vector<T> res1_data, res2_data, res3_data, u_stage_data;
+    /// @brief the stage solution buffers
+    std::vector<T> u_stage_data, u_next_data;
+
+    /// @brief the stage derivative for continuous (cg layout) solutions
+    std::vector<T> k_data;
+
+    /// @brief persistent storage for residual evaluation
+    ResidualWorkspace<T, IDX> workspace;
+
+    /// @brief the cached inverse mass operator (matrix free for tensor product elements)
+    TensorProductInverseMassOperator<T, IDX> inv_mass;
+
+    /// @brief the residual and global mass matrix for continuous (cg layout) solutions
+    CGExplicitRhs<T, IDX> cg_rhs;
+
+    /// @brief the fused residual, inverse mass, and stage update kernel
+    FusedRKStage<T, IDX> fused_stage;
 
     /// @brief the current timestep 
     IDX itime = 0;
@@ -51,18 +74,19 @@ public:
     /// @brief the current time 
     T time = 0.0;
 
+#ifdef ICEICLE_USE_MPI
+    /// @brief the communicator the processes agree on the timestep over
+    MPI_Comm comm = MPI_COMM_WORLD;
+#endif
+
     /// @brief the callback function for visualization during solve()
     /// is given a reference to this when called 
-    /// default is to print out a l2 norm of the residual data array
+    /// default is to print out the l2 norm of the residual (see ResidualWorkspace::monitor)
     std::function<void(RK3SSP &)> vis_callback = [](RK3SSP &disc){
-        T sum = 0.0;
-        for(int i = 0; i < disc.res_data.size(); ++i){
-            sum += SQUARED(disc.res_data[i]);
-        }
         std::cout << std::setprecision(8);
         std::cout << "itime: " << std::setw(6) << disc.itime 
             << " | t: " << std::setw(14) << disc.time
-            << " | residual l2: " << std::setw(14) << std::sqrt(sum) 
+            << " | residual l2: " << std::setw(14) << disc.workspace.monitor.l2() 
             << std::endl;
     };
 
@@ -71,6 +95,15 @@ public:
     /// (itime % ivis == 0)
     IDX ivis = -1;
 
+    /// @brief the side tasks of the time loop (i.e asynchronous writes or reductions spawned by vis_callback)
+    /// these are polled after every step so their waits overlap the next step 
+    /// and are finished at the end of solve()
+    util::coroutine_executor side_tasks;
+
+    /// @brief applied to the solution after every stage when set (dg layout only)
+    /// (i.e navier_stokes::PositivityLimiter::limit)
+    std::function<void(std::span<T>)> stage_limiter{};
+
     /**
      * @brief create a RK3SSP solver 
      * initializes the residual data vector
@@ -88,12 +121,11 @@ public:
     )
     requires specifies_ncomp<disc_class> && TerminationCondition<StopCondition>
     : res_data(fespace.dg_map.calculate_size_requirement(disc_class::nv_comp)),
-      res1_data(fespace.dg_map.calculate_size_requirement(disc_class::nv_comp)),
-      res2_data(fespace.dg_map.calculate_size_requirement(disc_class::nv_comp)),
-      res3_data(fespace.dg_map.calculate_size_requirement(disc_class::nv_comp)),
       u_stage_data(fespace.dg_map.calculate_size_requirement(disc_class::nv_comp)),
-      timestep{timestep}, stop_condition{stop_condition}
-    {}
+      u_next_data(fespace.dg_map.calculate_size_requirement(disc_class::nv_comp)),
+      timestep{timestep}, stop_condition{stop_condition},
+      workspace{fespace, disc_class::dnv_comp}, inv_mass{fespace}
+    { workspace.enable_norm_monitor(disc_class::dnv_comp); }
 
     /**
      * @brief perform a single timestep 
@@ -108,86 +140,66 @@ public:
     requires TimestepT<TimestepClass, T, IDX, ndim, disc_class, LayoutPolicy, uAccessorPolicy>
     {
        
+        // update the solution dependent data cached by the discretization (once per step)
+        update_cached_state(fespace, disc, u);
+
         // calculate the timestep 
         T dt = timestep(fespace, disc, u);
 
         // Termination Condiditon restrictions on dt 
         dt = stop_condition.limit_dt(dt, time);
 
-        // sync dt between processes
+        // start syncing dt between processes
+        // the first stage residual does not depend on dt so is formed while the reduction is in flight
+        // dt must not be read until dt_request is waited on
+        mpi::reduction_request dt_request{};
 #ifdef ICEICLE_USE_MPI 
         T dt_individual = dt;
-        MPI_Allreduce(&dt_individual, &dt, 1, mpi_get_type<T>(), MPI_MAX, MPI_COMM_WORLD);
+        int comm_size = 1;
+        if(mpi::mpi_initialized()) MPI_Comm_size(comm, &comm_size);
+        if(comm_size > 1)
+            MPI_Iallreduce(&dt_individual, &dt, 1, mpi_get_type<T>(), MPI_MAX, comm, &dt_request.request);
 #endif
 
         // create view of the residual using the same Layout as u 
         fespan res{res_data.data(), u.get_layout()};
 
-        // storage for rhs of mass matrix equation
-        int max_ndof = fespace.dg_map.max_el_size_reqirement(1);
-        std::vector<T> b(max_ndof);
-        std::vector<T> du(max_ndof);
-
-        // function to get the residual for a single stage
-        auto stage_residual = [&](fespan<T, LayoutPolicy> u_stage, fespan<T, LayoutPolicy> res_stage){
-            // zero out
-            res_stage = 0;
-
-            // get the rhs
-            form_residual(fespace, disc, u, res);
-
-            // invert mass matrices
-            // TODO: prestore mass matrix with the reference element 
-            // TODO: need to build a global mass matrix if doing CG (but not for DG)
-            for(const FiniteElement<T, IDX, ndim> &el : fespace.elements){
-                using namespace MATH::MATRIX;
-                using namespace MATH::MATRIX::SOLVERS;
-                DenseMatrix<T> mass = calculate_mass_matrix(el);
-                PermutationMatrix<unsigned int> pi = decompose_lu(mass);
-
-                const std::size_t ndof = el.nbasis();
-                for(IDX ieqn = 0; ieqn < disc_class::nv_comp; ++ieqn){
-
-                    // copy the residual for each degree of freedom to the rhs 
-                    for(IDX idof = 0; idof < ndof; ++idof){
-                        b[idof] = res[el.elidx, idof, ieqn];
-                    }
-
-                    // solve the matrix equation 
-                    sub_lu(mass, pi, b.data(), du.data());
-
-                    for(IDX idof = 0; idof < ndof; ++idof){
-                        res_stage[el.elidx, idof, ieqn] += du[idof];
-                    }
-                }
+        // make sure the inverse mass matrices are up to date with the mesh
+        inv_mass.update(fespace);
+
+        // a single stage in the Shu-Osher form
+        // y = alpha * u + beta * w + gamma * dt * M^{-1} R(w)
+        auto stage = [&](auto w, T alpha, T beta, T gamma, auto y){
+            if constexpr (cg_layout<LayoutPolicy>) {
+                // global mass matrix solve
+                if(k_data.size() < u.size()) k_data.resize(u.size());
+                fespan k{k_data.data(), u.get_layout()};
+                cg_rhs(fespace, disc, w, res, 1.0, 0.0, k);
+                dt_request.wait();
+                rk_stage_update(alpha, u, beta, w, gamma * dt, k, y);
+            } else if(dt_request.pending()) {
+                // M^{-1} R(w) into y while dt is reduced, then the update
+                fused_stage(fespace, disc, workspace, inv_mass, w, res, 0.0, u, 0.0, 1.0, y);
+                dt_request.wait();
+                rk_stage_update(alpha, u, beta, w, gamma * dt, y, y);
+            } else {
+                // residual, inverse mass, and update per element
+                fused_stage(fespace, disc, workspace, inv_mass, w, res, alpha, u, beta, gamma * dt, y);
+            }
+            if constexpr (!cg_layout<LayoutPolicy>) {
+                if(stage_limiter) stage_limiter(std::span<T>{y.data(), (std::size_t) y.size()});
             }
         };
 
-        // describe fespans for intermediate states 
-        fespan res1{res1_data.data(), u.get_layout()};
-        fespan res2{res2_data.data(), u.get_layout()};
-        fespan res3{res3_data.data(), u.get_layout()};
-        fespan u_stage{u_stage_data.data(), u.get_layout()};
-
-
-        // stage 1 
-        stage_residual(u, res1);
-
-        // stage 2 
-        copy_fespan(u, u_stage);
-        axpy(dt, res1, u_stage);
-        stage_residual(u_stage, res2);
+        // stage 1: u1 = u + dt * M^{-1} R(u)
+        stage(u, 0.0, 1.0, 1.0, fespan{u_stage_data.data(), u.get_layout()});
 
-        // stage 3
-        copy_fespan(u, u_stage);
-        axpy(0.25 * dt, res1, u_stage);
-        axpy(0.25 * dt, res2, u_stage);
-        stage_residual(u_stage, res3);
+        // stage 2: u2 = 3/4 u + 1/4 (u1 + dt * M^{-1} R(u1))
+        stage(fespan{u_stage_data.data(), u.get_layout()}, 0.75, 0.25, 0.25,
+                fespan{u_next_data.data(), u.get_layout()});
 
-        // update u 
-        axpy(1.0 / 6.0 * dt, res1, u);
-        axpy(1.0 / 6.0 * dt, res2, u);
-        axpy(2.0 / 3.0 * dt, res3, u);
+        // stage 3: u = 1/3 u + 2/3 (u2 + dt * M^{-1} R(u2))
+        stage(fespan{u_next_data.data(), u.get_layout()}, 1.0 / 3.0, 2.0 / 3.0, 2.0 / 3.0, u);
 
         // update the timestep and time
         itime++;
@@ -214,7 +226,7 @@ public:
             fespan res{res_data.data(), u.get_layout()};
 
             // get the rhs
-            form_residual(fespace, disc, u, res);
+            form_residual(fespace, disc, u, res, workspace);
         }
 
         // visualization callback on initial state (0 % anything == 0) 
@@ -223,6 +235,7 @@ public:
         // timestep loop
         while(!stop_condition(itime, time)){
             step(fespace, disc, u);
+            side_tasks.poll();
             if(itime % ivis == 0){
                 vis_callback(*this);
             }
@@ -230,6 +243,7 @@ public:
 
         // output the final timestep
         vis_callback(*this);
+        side_tasks.wait_all();
     }
 };
 
@@ -8,9 +8,13 @@
  */
 #pragma once
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <limits>
+#include <mutex>
 #include <vector>
 #include <memory>
 #include <ostream>
@@ -173,12 +177,135 @@ namespace iceicle::util {
         handle_anomaly(*this, log_out);
     }
 
+    /**
+     * @brief a lightweight anomaly for hot paths (i.e threaded assembly kernels)
+     * that can be logged without allocating
+     */
+    struct anomaly_record {
+        /// @brief no index to report
+        static constexpr std::int64_t no_index = std::numeric_limits<std::int64_t>::min();
+
+        /// @brief the description (must be a string with static storage duration, i.e a literal)
+        const char* desc;
+
+        /// @brief an index to append to the description (i.e the element index) or no_index
+        std::int64_t index;
+
+        /// @brief if this is a warning instead of an error
+        bool warning;
+
+        source_location loc;
+    };
+
+    /**
+     * @brief lock-free single producer single consumer ring of anomaly records 
+     * the owning thread pushes and AnomalyLog drains them
+     */
+    struct anomaly_ring {
+        static constexpr std::size_t capacity = 256;
+
+        std::array<anomaly_record, capacity> records;
+
+        /// @brief the total number of pushed records (only written by the owning thread)
+        std::atomic<std::size_t> head{0};
+
+        /// @brief the total number of drained records (only written by the consumer)
+        std::atomic<std::size_t> tail{0};
+
+        /// @brief the number of records that were dropped because the ring was full
+        std::atomic<std::size_t> ndropped{0};
+
+        /// @brief if a thread owns this ring
+        std::atomic<bool> in_use{false};
+
+        /// @brief add a record (called by the owning thread)
+        auto push(const anomaly_record& record) noexcept -> void {
+            std::size_t h = head.load(std::memory_order_relaxed);
+            if(h - tail.load(std::memory_order_acquire) == capacity) {
+                ndropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            records[h % capacity] = record;
+            head.store(h + 1, std::memory_order_release);
+        }
+
+        /// @brief call f(record) for the records in the order they were pushed and remove them
+        template<class F>
+        auto drain(F&& f) -> void {
+            std::size_t t = tail.load(std::memory_order_relaxed);
+            std::size_t h = head.load(std::memory_order_acquire);
+            for(; t < h; ++t) f(records[t % capacity]);
+            tail.store(h, std::memory_order_release);
+        }
+    };
+
+    /**
+     * @brief the global log of anomalies 
+     *
+     * log_anomaly() is thread safe and stores the full anomaly (the log is locked, so 
+     * this is intended for setup and rare failures).
+     * log_record() is for hot paths: each thread pushes lightweight records into its own lock-free ring 
+     * which are merged into the log lazily in handle_anomalies() and size()
+     */
     class AnomalyLog {
         private: 
             inline static std::vector<std::unique_ptr<AbstractAnomaly>> anomalies;
+
+            /// @brief the rings for log_record (kept for reuse by new threads when a thread exits)
+            inline static std::vector<std::unique_ptr<anomaly_ring>> rings;
+
+            /// @brief guards anomalies and rings
+            inline static std::mutex log_mutex;
+
             AnomalyLog() = default;
             AnomalyLog(const AnomalyLog&) = delete;
             AnomalyLog& operator=(const AnomalyLog&) = delete;
+
+            /// @brief claim a free ring or create one (locks the log)
+            static auto acquire_ring() -> anomaly_ring* {
+                std::lock_guard lock{log_mutex};
+                for(auto& ring : rings){
+                    bool expected = false;
+                    if(ring->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) 
+                        return ring.get();
+                }
+                rings.push_back(std::make_unique<anomaly_ring>());
+                rings.back()->in_use.store(true, std::memory_order_relaxed);
+                return rings.back().get();
+            }
+
+            /// @brief the ring owned by the calling thread
+            static auto thread_ring() -> anomaly_ring& {
+                struct ring_handle {
+                    anomaly_ring* ring;
+                    ~ring_handle() { ring->in_use.store(false, std::memory_order_release); }
+                };
+                thread_local ring_handle handle{acquire_ring()};
+                return *handle.ring;
+            }
+
+            /// @brief move the records of all the rings into the log (log_mutex must be held)
+            static void merge_records(){
+                for(auto& ring : rings){
+                    ring->drain([](const anomaly_record& record){
+                        std::string desc{record.desc};
+                        if(record.index != anomaly_record::no_index) desc += std::to_string(record.index);
+                        if(record.warning) {
+                            anomalies.push_back(std::make_unique<Anomaly<warning_anomaly_tag>>(
+                                        desc, warning_anomaly_tag{}, record.loc));
+                        } else {
+                            anomalies.push_back(std::make_unique<Anomaly<general_anomaly_tag>>(
+                                        desc, general_anomaly_tag{}, record.loc));
+                        }
+                    });
+                    std::size_t ndropped = ring->ndropped.exchange(0, std::memory_order_relaxed);
+                    if(ndropped > 0){
+                        anomalies.push_back(std::make_unique<Anomaly<warning_anomaly_tag>>(
+                            std::to_string(ndropped) + " anomaly records were dropped because a thread ring was full",
+                            warning_anomaly_tag{}));
+                    }
+                }
+            }
         public:
 
             /**
@@ -191,7 +318,21 @@ namespace iceicle::util {
 
             template<class Data>
             static void log_anomaly(Anomaly<Data> anomaly){
-                anomalies.push_back(std::make_unique<Anomaly<Data>>(std::move(anomaly)));
+                auto anomalyptr = std::make_unique<Anomaly<Data>>(std::move(anomaly));
+                std::lock_guard lock{log_mutex};
+                anomalies.push_back(std::move(anomalyptr));
+            }
+
+            /**
+             * @brief log a lightweight anomaly without locking or allocating 
+             * (for threaded hot paths)
+             * @param desc the description (must be a string literal or have static storage duration)
+             * @param index an index to append to the description (i.e the element index)
+             * @param warning if this is a warning instead of an error
+             */
+            static void log_record(const char* desc, std::int64_t index = anomaly_record::no_index,
+                    bool warning = false, const source_location& loc = source_location::current()){
+                thread_ring().push(anomaly_record{desc, index, warning, loc});
             }
 
             static void log_anomaly(std::string_view message, 
@@ -214,6 +355,8 @@ namespace iceicle::util {
 //            }
 
             static void handle_anomalies(std::ostream &os = std::cerr){
+                std::lock_guard lock{log_mutex};
+                merge_records();
                 for(auto &anomaly : anomalies){
                     anomaly->handle_self(os);
                 }
@@ -222,16 +365,33 @@ namespace iceicle::util {
 
             ~AnomalyLog(){
                 // Log any remaining anommalies in the error stream
+                std::lock_guard lock{log_mutex};
+                merge_records();
                 for(auto &anomaly : anomalies){
                     anomaly->handle_self(std::cerr);
                 }
                 anomalies.clear();
             }
 
-            static auto size() -> std::size_t 
-            { return anomalies.size(); }
+            static auto size() -> std::size_t {
+                std::lock_guard lock{log_mutex};
+                merge_records();
+                return anomalies.size();
+            }
     };
 
+    /**
+     * @brief check a condition in a hot path and log a record if it fails (see AnomalyLog::log_record)
+     * compiled out (including the condition) when ICEICLE_DISABLE_HOT_CHECKS is defined
+     * so release builds do not pay for the checks
+     */
+#ifdef ICEICLE_DISABLE_HOT_CHECKS
+#define ICEICLE_HOT_CHECK(condition, desc, index) ((void) 0)
+#else
+#define ICEICLE_HOT_CHECK(condition, desc, index) \
+    do { if(!(condition)) ::iceicle::util::AnomalyLog::log_record(desc, index); } while(0)
+#endif
+
 
     /**
      * @brief expect an expression to be true 
@@ -22,12 +22,22 @@ namespace iceicle::build_config {
     using T = double;
     #endif
 
-    #ifdef IDX_64_bit
-    using IDX = long
+    #if defined(IDX_64_BIT)
+    using IDX = long;
+    #elif defined(IDX_32_BIT)
+    using IDX = int;
     #endif
 
-    #ifdef IDX_32_BIT
-    using IDX = int;
+    /**
+     * The integer type for indices over the whole (unpartitioned) problem:
+     * the global node and element ids used only for partitioning, restart, and output.
+     * Everything on a rank (connectivity, layouts, traces) is indexed with IDX,
+     * so IDX only needs to hold the size of a partition.
+     */
+    #ifdef GIDX_32_BIT
+    using GIDX = int;
+    #else
+    using GIDX = long long;
     #endif
 
     /** 
@@ -47,5 +57,14 @@ namespace iceicle::build_config {
     static constexpr int FESPACE_BUILD_GEO_PN = MAX_GEO_ORDER
 #else
     static constexpr int FESPACE_BUILD_GEO_PN = 3;
+#endif
+    /** 
+     * The maximum polynomial order of basis functions that gets element kernels 
+     * specialized on the number of basis functions and quadrature points (see kernel_registry.hpp)
+     */
+#ifdef MAX_SPECIALIZED_KERNEL_ORDER
+    static constexpr int SPECIALIZED_KERNEL_PN = MAX_SPECIALIZED_KERNEL_ORDER;
+#else
+    static constexpr int SPECIALIZED_KERNEL_PN = 4;
 #endif
 }
@@ -0,0 +1,298 @@
+/**
+ * @brief read only compressed row storage with delta + varint encoded values
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/crs.hpp"
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace iceicle::util {
+
+    namespace impl::compressed_crs {
+
+        /// @brief append the LEB128 varint encoding of x
+        inline auto write_varint(std::vector<std::uint8_t>& bytes, std::uint64_t x) -> void {
+            while(x >= 0x80) {
+                bytes.push_back((std::uint8_t) (x | 0x80));
+                x >>= 7;
+            }
+            bytes.push_back((std::uint8_t) x);
+        }
+
+        /// @brief decode a varint and advance the pointer past it
+        inline auto read_varint(const std::uint8_t*& ptr) noexcept -> std::uint64_t {
+            std::uint64_t x = 0;
+            int shift = 0;
+            while(*ptr & 0x80) {
+                x |= (std::uint64_t) (*ptr++ & 0x7f) << shift;
+                shift += 7;
+            }
+            x |= (std::uint64_t) (*ptr++) << shift;
+            return x;
+        }
+
+        /// @brief advance the pointer past n varints
+        inline auto skip_varints(const std::uint8_t*& ptr, std::size_t n) noexcept -> void {
+            for(; n > 0; --n) { while(*ptr++ & 0x80) {} }
+        }
+
+        /// @brief map signed differences to unsigned so small magnitudes are short
+        inline constexpr auto zigzag(std::int64_t d) noexcept -> std::uint64_t
+        { return ((std::uint64_t) d << 1) ^ (std::uint64_t) (d >> 63); }
+
+        inline constexpr auto unzigzag(std::uint64_t z) noexcept -> std::int64_t
+        { return (std::int64_t) (z >> 1) ^ -(std::int64_t) (z & 1); }
+    }
+
+    /**
+     * @brief read only compressed row storage of integer values (i.e connectivity)
+     *
+     * Each row is stored as varint(row size) followed by the zigzag varint of
+     * the difference of the first value to the first value of the previous row (zero at the start of a block),
+     * then the difference of each value to the previous value in the row.
+     * Connectivity of a mesh ordered along a space filling curve has small differences
+     * so most values take 1 or 2 bytes instead of sizeof(T).
+     *
+     * Only the byte offset of every rows_per_block-th row is stored:
+     * rowspan(irow) decodes forward from the start of the block (at most rows_per_block - 1 rows are skipped)
+     * and rows() traverses all the rows in one sequential pass.
+     * The rows are forward ranges so they are a drop in for range based for loops over crs::rowspan()
+     *
+     * @tparam T the integral value type
+     * @tparam IDX the index type
+     */
+    template<std::integral T, class IDX = std::size_t>
+    class compressed_crs {
+        public:
+
+        // ============
+        // = Typedefs =
+        // ============
+        using value_type = T;
+        using index_type = IDX;
+        using size_type = std::make_unsigned_t<index_type>;
+
+        /// @brief the number of rows between stored byte offsets
+        static constexpr size_type rows_per_block = 16;
+
+        /**
+         * @brief a forward range that decodes the values of a row
+         */
+        class row_view {
+            const std::uint8_t* _ptr = nullptr; // the first value difference
+            size_type _size = 0;
+            T _prev_first = 0;
+
+            public:
+
+            class iterator {
+                const std::uint8_t* ptr = nullptr; // the next undecoded value
+                size_type remaining = 0; // the number of values including the current one
+                T value = 0;
+
+                public:
+                using iterator_concept = std::forward_iterator_tag;
+                using value_type = T;
+                using difference_type = std::ptrdiff_t;
+
+                iterator() = default;
+                iterator(const std::uint8_t* ptr, size_type size, T prev_first) noexcept
+                : ptr{ptr}, remaining{size}, value{prev_first}
+                { if(remaining > 0) value += (T) impl::compressed_crs::unzigzag(impl::compressed_crs::read_varint(this->ptr)); }
+
+                auto operator*() const noexcept -> T { return value; }
+
+                auto operator++() noexcept -> iterator& {
+                    if(--remaining > 0) value += (T) impl::compressed_crs::unzigzag(impl::compressed_crs::read_varint(ptr));
+                    return *this;
+                }
+
+                auto operator++(int) noexcept -> iterator { iterator tmp = *this; ++(*this); return tmp; }
+
+                friend auto operator==(const iterator& a, const iterator& b) noexcept -> bool
+                { return a.remaining == b.remaining && (a.remaining == 0 || a.ptr == b.ptr); }
+
+                friend auto operator==(const iterator& a, std::default_sentinel_t) noexcept -> bool
+                { return a.remaining == 0; }
+            };
+
+            row_view() = default;
+            row_view(const std::uint8_t* ptr, size_type size, T prev_first) noexcept
+            : _ptr{ptr}, _size{size}, _prev_first{prev_first} {}
+
+            auto begin() const noexcept -> iterator { return iterator{_ptr, _size, _prev_first}; }
+            auto end() const noexcept -> std::default_sentinel_t { return std::default_sentinel; }
+            auto size() const noexcept -> size_type { return _size; }
+            auto empty() const noexcept -> bool { return _size == 0; }
+
+            /// @brief the first value of the row (the row must not be empty)
+            auto front() const noexcept -> T { return *begin(); }
+
+            /// @brief the value the next row in the same block is differenced against
+            auto next_prev_first() const noexcept -> T { return (_size > 0) ? front() : _prev_first; }
+
+            /// @brief the encoding of the next row
+            auto next_ptr() const noexcept -> const std::uint8_t* {
+                const std::uint8_t* ptr = _ptr;
+                impl::compressed_crs::skip_varints(ptr, _size);
+                return ptr;
+            }
+        };
+
+        private:
+
+        /// @brief read the row starting at ptr
+        static auto read_row(const std::uint8_t* ptr, T prev_first) noexcept -> row_view {
+            size_type size = (size_type) impl::compressed_crs::read_varint(ptr);
+            return row_view{ptr, size, prev_first};
+        }
+
+        /**
+         * @brief a forward iterator over all the rows in order
+         */
+        class rows_iterator {
+            row_view row{};
+            size_type irow = 0;
+            size_type nrow = 0;
+
+            public:
+            using iterator_concept = std::forward_iterator_tag;
+            using value_type = row_view;
+            using difference_type = std::ptrdiff_t;
+
+            rows_iterator() = default;
+            rows_iterator(const std::uint8_t* ptr, size_type nrow) noexcept
+            : nrow{nrow} { if(nrow > 0) row = read_row(ptr, 0); }
+
+            auto operator*() const noexcept -> row_view { return row; }
+
+            auto operator++() noexcept -> rows_iterator& {
+                if(++irow < nrow) {
+                    // the first row of a block is differenced against zero
+                    row = read_row(row.next_ptr(), (irow % rows_per_block == 0) ? 0 : row.next_prev_first());
+                }
+                return *this;
+            }
+
+            auto operator++(int) noexcept -> rows_iterator { rows_iterator tmp = *this; ++(*this); return tmp; }
+
+            friend auto operator==(const rows_iterator& a, const rows_iterator& b) noexcept -> bool
+            { return a.irow == b.irow; }
+
+            friend auto operator==(const rows_iterator& a, std::default_sentinel_t) noexcept -> bool
+            { return a.irow >= a.nrow; }
+        };
+
+        /// @brief the encoded rows
+        std::vector<std::uint8_t> _bytes{};
+
+        /// @brief the byte offset of the start of every rows_per_block-th row
+        std::vector<std::size_t> _block_offsets{};
+
+        size_type _nnz = 0;
+        size_type _nrow = 0;
+
+        public:
+
+        // ================
+        // = Constructors =
+        // ================
+
+        compressed_crs() = default;
+
+        /// @brief encode a crs (the crs can be released afterwards)
+        template<class IDX2>
+        explicit compressed_crs(const crs<T, IDX2>& a)
+        : _nnz{(size_type) a.nnz()}, _nrow{(size_type) a.nrow()}
+        {
+            using namespace impl::compressed_crs;
+            _bytes.reserve(a.nnz() + a.nrow());
+            _block_offsets.reserve(_nrow / rows_per_block + 1);
+            std::int64_t prev_first = 0;
+            for(size_type irow = 0; irow < _nrow; ++irow){
+                if(irow % rows_per_block == 0) {
+                    _block_offsets.push_back(_bytes.size());
+                    prev_first = 0;
+                }
+                auto row = a.rowspan(irow);
+                write_varint(_bytes, row.size());
+                std::int64_t prev = prev_first;
+                for(std::size_t j = 0; j < row.size(); ++j){
+                    write_varint(_bytes, zigzag((std::int64_t) row[j] - prev));
+                    prev = row[j];
+                }
+                if(row.size() > 0) prev_first = row[0];
+            }
+            _bytes.shrink_to_fit();
+        }
+
+        // =========
+        // = Sizes =
+        // =========
+
+        /// @brief the total number of values stored
+        auto nnz() const noexcept -> size_type { return _nnz; }
+
+        /// @brief the number of rows
+        auto nrow() const noexcept -> size_type { return _nrow; }
+
+        /// @brief the number of values in the given row
+        auto rowsize(index_type irow) const noexcept -> size_type { return rowspan(irow).size(); }
+
+        /// @brief the bytes allocated
+        auto memory_bytes() const noexcept -> std::size_t
+        { return _bytes.capacity() + _block_offsets.capacity() * sizeof(std::size_t); }
+
+        // ============
+        // = Indexing =
+        // ============
+
+        /**
+         * @brief get the values of a row
+         * @param irow the index of the row
+         * @return a forward range that decodes the values of the row
+         */
+        auto rowspan(index_type irow) const noexcept -> row_view {
+            size_type iblock = (size_type) irow / rows_per_block;
+            row_view row = read_row(_bytes.data() + _block_offsets[iblock], 0);
+            for(size_type jrow = iblock * rows_per_block; jrow < (size_type) irow; ++jrow)
+                { row = read_row(row.next_ptr(), row.next_prev_first()); }
+            return row;
+        }
+
+        /// @brief the value at the location of the index pair (irow, jcol)
+        auto operator[](index_type irow, index_type jcol) const noexcept -> T
+        { return *std::next(rowspan(irow).begin(), jcol); }
+
+        /// @brief a range over all the rows in order (sequential decode)
+        auto rows() const noexcept {
+            struct rows_range {
+                const compressed_crs* a;
+                auto begin() const noexcept -> rows_iterator
+                { return (a->_nrow > 0) ? rows_iterator{a->_bytes.data(), a->_nrow} : rows_iterator{}; }
+                auto end() const noexcept -> std::default_sentinel_t { return std::default_sentinel; }
+                auto size() const noexcept -> size_type { return a->_nrow; }
+            };
+            return rows_range{this};
+        }
+
+        /// @brief decode into an uncompressed crs
+        auto to_crs() const -> crs<T, IDX> {
+            std::vector<IDX> cols(_nrow + 1, 0);
+            size_type irow = 0;
+            for(row_view row : rows()) { cols[irow + 1] = cols[irow] + row.size(); ++irow; }
+            crs<T, IDX> result{std::span<const IDX>{cols}};
+            irow = 0;
+            for(row_view row : rows()) { std::ranges::copy(row, result.rowspan(irow).begin()); ++irow; }
+            return result;
+        }
+    };
+
+    template<std::integral T, class IDX>
+    compressed_crs(const crs<T, IDX>&) -> compressed_crs<T, IDX>;
+}
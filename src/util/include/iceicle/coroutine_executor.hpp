@@ -0,0 +1,293 @@
+/**
+ * @brief a single threaded executor of C++20 coroutines for the side tasks of a time step
+ * (nonblocking reductions, asynchronous writes, communication waits)
+ * that are resumed between steps once what they wait on is ready
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace iceicle::util {
+
+    class coroutine_executor;
+
+    template<class T> class side_task;
+
+    namespace impl {
+        template<class T> struct side_task_awaiter;
+
+        /// @brief the promise data shared by every side_task
+        struct side_task_promise_base {
+            /// @brief the executor the task runs on (set when spawned)
+            coroutine_executor* executor = nullptr;
+
+            /// @brief the exception that escaped the coroutine
+            std::exception_ptr exception{};
+
+            /// @brief tasks are started by coroutine_executor::spawn (or when first awaited)
+            auto initial_suspend() const noexcept -> std::suspend_always { return {}; }
+
+            /// @brief stay suspended at the end so the result can be read
+            auto final_suspend() const noexcept -> std::suspend_always { return {}; }
+
+            void unhandled_exception() noexcept { exception = std::current_exception(); }
+        };
+
+        /// @brief the result storage of a side_task returning T
+        template<class T>
+        struct side_task_promise_result : side_task_promise_base {
+            std::optional<T> value{};
+
+            template<class U>
+            void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+        };
+
+        template<>
+        struct side_task_promise_result<void> : side_task_promise_base {
+            void return_void() const noexcept {}
+        };
+    }
+
+    /**
+     * @brief a side task: a coroutine run by a coroutine_executor
+     *
+     * Inside the task, co_await an awaitable (ready_when, request_ready, future_ready, yield_step,
+     * or another side_task) to pause until the condition is met.
+     * The executor checks the condition on each poll() so the task never blocks the caller.
+     *
+     * The task object owns the coroutine; destroying it before completion drops it from the executor
+     *
+     * @tparam T the result type
+     */
+    template<class T = void>
+    class side_task {
+        public:
+
+        struct promise_type : impl::side_task_promise_result<T> {
+            auto get_return_object() -> side_task
+            { return side_task{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        };
+
+        private:
+        std::coroutine_handle<promise_type> handle{};
+
+        explicit side_task(std::coroutine_handle<promise_type> handle) noexcept : handle{handle} {}
+
+        friend class coroutine_executor;
+
+        public:
+
+        side_task() = default;
+        side_task(const side_task&) = delete;
+        side_task& operator=(const side_task&) = delete;
+        side_task(side_task&& other) noexcept : handle{std::exchange(other.handle, {})} {}
+        side_task& operator=(side_task&& other) noexcept {
+            if(this != &other){
+                destroy();
+                handle = std::exchange(other.handle, {});
+            }
+            return *this;
+        }
+        ~side_task() { destroy(); }
+
+        /// @brief if this holds a coroutine
+        [[nodiscard]] auto valid() const noexcept -> bool { return (bool) handle; }
+
+        /// @brief if the coroutine has been spawned on an executor
+        [[nodiscard]] auto started() const noexcept -> bool { return handle && handle.promise().executor != nullptr; }
+
+        /// @brief if the coroutine has run to completion
+        [[nodiscard]] auto done() const noexcept -> bool { return handle && handle.done(); }
+
+        /**
+         * @brief the result of a completed task (rethrows an exception that escaped the coroutine)
+         * see coroutine_executor::wait() to drive the task to completion first
+         */
+        auto get() -> T {
+            if(handle.promise().exception) std::rethrow_exception(handle.promise().exception);
+            if constexpr (!std::is_void_v<T>) return std::move(*(handle.promise().value));
+        }
+
+        /// @brief await another task from a task: spawns it on the same executor if it has not started
+        auto operator co_await() & noexcept -> impl::side_task_awaiter<T>;
+
+        private:
+        void destroy() noexcept;
+    };
+
+    /**
+     * @brief runs side tasks on the thread that polls it
+     *
+     * Tasks run eagerly from spawn() up to their first co_await of something that is not ready,
+     * then are parked with the condition they wait on.
+     * poll() resumes every parked task whose condition is ready (i.e between time steps)
+     * and wait() polls until a given task completes,
+     * so the latency of the waits hides behind whatever the caller does between polls.
+     *
+     * The conditions should be cheap nonblocking checks (i.e MPI_Test) as they are evaluated each poll.
+     * poll() and wait() must not be called from inside a task.
+     */
+    class coroutine_executor {
+        struct parked_task {
+            std::coroutine_handle<> handle;
+            std::function<bool()> ready;
+        };
+
+        /// @brief the suspended tasks and the conditions they wait on
+        std::vector<parked_task> parked{};
+
+        /// @brief the tasks being checked by poll()
+        std::vector<parked_task> polling{};
+
+        public:
+
+        coroutine_executor() = default;
+        coroutine_executor(const coroutine_executor&) = delete;
+        coroutine_executor& operator=(const coroutine_executor&) = delete;
+
+        /// @brief finish every task before the executor goes away
+        ~coroutine_executor() { wait_all(); }
+
+        /**
+         * @brief start a task: runs it until it first waits on something that is not ready
+         * (no-op if already started)
+         */
+        template<class T>
+        void spawn(side_task<T>& task) {
+            if(!task.valid() || task.started()) return;
+            task.handle.promise().executor = this;
+            task.handle.resume();
+        }
+
+        /// @brief park a suspended coroutine until ready() is true (called by the awaitables)
+        void park(std::coroutine_handle<> handle, std::function<bool()> ready)
+        { parked.push_back(parked_task{handle, std::move(ready)}); }
+
+        /// @brief drop a parked coroutine (called when a task is destroyed before completion)
+        void forget(std::coroutine_handle<> handle) noexcept {
+            std::erase_if(parked, [handle](const parked_task& task){ return task.handle == handle; });
+            for(parked_task& task : polling) if(task.handle == handle) task.handle = nullptr;
+        }
+
+        /**
+         * @brief resume each parked task whose condition is ready
+         * (tasks parked while polling are checked on the next poll)
+         * @return the number of tasks still parked
+         */
+        auto poll() -> std::size_t {
+            std::swap(polling, parked);
+            for(std::size_t i = 0; i < polling.size(); ++i){
+                // skip tasks destroyed by a task resumed earlier in this poll
+                if(!polling[i].handle) continue;
+                if(polling[i].ready()) {
+                    std::coroutine_handle<> handle = std::exchange(polling[i].handle, nullptr);
+                    handle.resume();
+                } else {
+                    parked.push_back(std::move(polling[i]));
+                }
+            }
+            polling.clear();
+            return parked.size();
+        }
+
+        /// @brief the number of tasks that are parked
+        [[nodiscard]] auto npending() const noexcept -> std::size_t { return parked.size(); }
+
+        /**
+         * @brief run the task to completion (spawning it if needed), polling the other tasks meanwhile
+         * @return the result of the task
+         */
+        template<class T>
+        auto wait(side_task<T>& task) -> T {
+            spawn(task);
+            while(!task.done()) poll();
+            return task.get();
+        }
+
+        /// @brief poll until no tasks are parked
+        void wait_all() { while(!parked.empty()) poll(); }
+    };
+
+    // ==============
+    // = Awaitables =
+    // ==============
+
+    /// @brief suspend the task until the predicate is true (checked each poll)
+    struct ready_when {
+        std::function<bool()> ready;
+
+        auto await_ready() -> bool { return ready(); }
+
+        template<class Promise>
+        void await_suspend(std::coroutine_handle<Promise> handle)
+        { handle.promise().executor->park(handle, std::move(ready)); }
+
+        void await_resume() const noexcept {}
+    };
+
+    /// @brief suspend the task until the next poll
+    inline auto yield_step() -> ready_when {
+        return ready_when{[polled = false]() mutable { return std::exchange(polled, true); }};
+    }
+
+    /**
+     * @brief suspend the task until a nonblocking request completes
+     * @param request has a nonblocking test() -> bool (i.e mpi::reduction_request)
+     * (must outlive the wait)
+     */
+    template<class Request>
+    auto request_ready(Request& request) -> ready_when
+    { return ready_when{[&request]{ return request.test(); }}; }
+
+    /// @brief suspend the task until a future has its result (i.e an asynchronous write)
+    template<class R>
+    auto future_ready(std::future<R>& future) -> ready_when {
+        return ready_when{[&future]{
+            return future.wait_for(std::chrono::seconds{0}) == std::future_status::ready;
+        }};
+    }
+
+    namespace impl {
+        /// @brief awaits a side_task from another task
+        template<class T>
+        struct side_task_awaiter {
+            side_task<T>& task;
+
+            auto await_ready() const noexcept -> bool { return task.done(); }
+
+            template<class Promise>
+            auto await_suspend(std::coroutine_handle<Promise> handle) -> bool {
+                coroutine_executor* executor = handle.promise().executor;
+                executor->spawn(task);
+                if(task.done()) return false;
+                executor->park(handle, [&task = task]{ return task.done(); });
+                return true;
+            }
+
+            auto await_resume() -> T { return task.get(); }
+        };
+    }
+
+    template<class T>
+    auto side_task<T>::operator co_await() & noexcept -> impl::side_task_awaiter<T>
+    { return impl::side_task_awaiter<T>{*this}; }
+
+    template<class T>
+    void side_task<T>::destroy() noexcept {
+        if(!handle) return;
+        if(handle.promise().executor != nullptr && !handle.done())
+            { handle.promise().executor->forget(handle); }
+        handle.destroy();
+        handle = {};
+    }
+}
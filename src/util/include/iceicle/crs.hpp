@@ -10,6 +10,8 @@
 #include <vector>
 #include <span>
 #include <algorithm>
+#include <numeric>
+#include <iceicle/thread_utils.hpp>
 namespace iceicle::util {
 
     /**
@@ -251,6 +253,37 @@ namespace iceicle::util {
             };
         }
 
+        // ============
+        // = Mutation =
+        // ============
+
+        /**
+         * @brief replace the values of a row 
+         * If the row size changes the storage is reallocated and the rows after irow are shifted 
+         * (invalidating any pointers or spans into the data)
+         * @param irow the index of the row 
+         * @param values the new values of the row
+         */
+        constexpr
+        auto replace_row(index_type irow, std::span<const value_type> values) -> void {
+            if(values.size() == rowsize(irow)) {
+                std::ranges::copy(values, _data + _cols[irow]);
+                return;
+            }
+            size_type nnz_new = _nnz - rowsize(irow) + values.size();
+            value_type* data_new = new value_type[nnz_new];
+            std::copy_n(_data, _cols[irow], data_new);
+            std::ranges::copy(values, data_new + _cols[irow]);
+            std::copy(_data + _cols[irow + 1], _data + _nnz, data_new + _cols[irow] + values.size());
+
+            index_type shift = (index_type) values.size() - (index_type) rowsize(irow);
+            for(size_type jrow = irow + 1; jrow <= _nrow; ++jrow) _cols[jrow] += shift;
+
+            if(_data != nullptr) delete[] _data;
+            _data = data_new;
+            _nnz = nnz_new;
+        }
+
         /// @brief get the raw data pointer
         inline constexpr 
         auto data() noexcept
@@ -279,14 +312,96 @@ namespace iceicle::util {
     template<class T>
     crs(const std::vector<std::vector<T>>&) -> crs<T>;
 
+    /**
+     * @brief convert a crs to different value and index types
+     * the row offsets and values are copied in parallel
+     */
     template<class Tnew, class IDXnew, class T, class IDX>
-    constexpr
     auto convert_crs(const crs<T, IDX>& crs_old)
     -> crs<Tnew, IDXnew>{
         std::vector<IDXnew> colsnew(crs_old.nrow() + 1);
-        std::copy_n(crs_old.cols(), crs_old.nrow() + 1, colsnew.begin());
+        parallel_for(colsnew.size(), [&](std::size_t i){ colsnew[i] = (IDXnew) crs_old.cols()[i]; });
         crs<Tnew, IDXnew> crs_new{colsnew};
-        std::copy_n(crs_old.data(), crs_old.nnz(), crs_new.data());
+        parallel_for(crs_old.nnz(), [&](std::size_t i){ crs_new.data()[i] = (Tnew) crs_old.data()[i]; });
         return crs_new;
     }
+
+    /**
+     * @brief build a crs in parallel with two passes over the rows
+     * (count the row sizes, prefix sum into the row offsets, then fill each row)
+     * instead of going through a ragged std::vector<std::vector<T>>
+     *
+     * @param nrow the number of rows
+     * @param row_size row_size(irow) -> the number of entries in row irow
+     * @param fill_row fill_row(irow, std::span<T> row) writes the entries of row irow
+     *        must be safe to call concurrently for distinct rows
+     */
+    template<class T, class IDX = std::size_t, class CountF, class FillF>
+    auto make_crs(std::make_unsigned_t<IDX> nrow, CountF&& row_size, FillF&& fill_row)
+    -> crs<T, IDX> {
+        std::vector<IDX> cols(nrow + 1);
+        cols[0] = 0;
+        parallel_for(nrow, [&](std::size_t irow){ cols[irow + 1] = (IDX) row_size((IDX) irow); });
+        std::inclusive_scan(cols.begin(), cols.end(), cols.begin());
+        crs<T, IDX> result{std::span<const IDX>{cols}};
+        parallel_for(nrow, [&](std::size_t irow){ fill_row((IDX) irow, result.rowspan((IDX) irow)); });
+        return result;
+    }
+
+    /**
+     * @brief the transpose of a crs of column indices 
+     * row j of the result holds the indices of the rows of a that contain j 
+     * in increasing order (a row of a that contains j more than once appears more than once)
+     * i.e elements surrounding points from the element connectivity in one call
+     *
+     * The rows of a are split into contiguous chunks with a set of column counters per chunk,
+     * so the fill is parallel without atomics and the result does not depend on the number of threads.
+     * The number of chunks is limited so the counters take no more storage than the result
+     *
+     * @param a the crs to transpose, the values are column indices in [0, ncol)
+     * @param ncol the number of columns (rows of the result)
+     */
+    template<class T, class IDX>
+    auto transpose_crs(const crs<T, IDX>& a, std::size_t ncol)
+    -> crs<T, IDX> {
+        const std::size_t nrow = a.nrow();
+        const std::size_t nchunk = std::clamp<std::size_t>(
+                std::min<std::size_t>(max_threads(), a.nnz() / std::max<std::size_t>(ncol, 1)),
+                1, std::max<std::size_t>(nrow, 1));
+        auto chunk_begin = [&](std::size_t ichunk){ return ichunk * nrow / nchunk; };
+
+        // count the entries of each column in each chunk
+        std::vector<IDX> offsets(nchunk * ncol, 0);
+        parallel_for(nchunk, [&](std::size_t ichunk){
+            IDX* counts = offsets.data() + ichunk * ncol;
+            for(std::size_t irow = chunk_begin(ichunk); irow < chunk_begin(ichunk + 1); ++irow)
+                for(const T& jcol : a.rowspan(irow)) ++counts[jcol];
+        });
+
+        // prefix sum over the columns then the chunks within each column
+        std::vector<IDX> cols(ncol + 1, 0);
+        parallel_for(ncol, [&](std::size_t jcol){
+            IDX total = 0;
+            for(std::size_t ichunk = 0; ichunk < nchunk; ++ichunk) total += offsets[ichunk * ncol + jcol];
+            cols[jcol + 1] = total;
+        });
+        std::inclusive_scan(cols.begin(), cols.end(), cols.begin());
+        parallel_for(ncol, [&](std::size_t jcol){
+            IDX offset = cols[jcol];
+            for(std::size_t ichunk = 0; ichunk < nchunk; ++ichunk){
+                IDX count = offsets[ichunk * ncol + jcol];
+                offsets[ichunk * ncol + jcol] = offset;
+                offset += count;
+            }
+        });
+
+        // fill 
+        crs<T, IDX> result{std::span<const IDX>{cols}};
+        parallel_for(nchunk, [&](std::size_t ichunk){
+            IDX* next = offsets.data() + ichunk * ncol;
+            for(std::size_t irow = chunk_begin(ichunk); irow < chunk_begin(ichunk + 1); ++irow)
+                for(const T& jcol : a.rowspan(irow)) result.data()[next[jcol]++] = (T) irow;
+        });
+        return result;
+    }
 }
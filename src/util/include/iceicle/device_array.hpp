@@ -0,0 +1,143 @@
+/**
+ * @brief an owning array with a host mirror that is resident on the offload device
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace iceicle::util {
+
+    /**
+     * @brief an array that is allocated on the OpenMP offload device for its whole lifetime
+     * along with a host mirror of the same size
+     *
+     * data() is the host address; inside an OpenMP target region it is translated to the device copy
+     * (a pointer that is not listed in a map clause is mapped as a zero length array section)
+     * so kernels capture data() in a local pointer and index it as usual.
+     * The copies between the host mirror and the device are explicit (update_device() and update_host()).
+     *
+     * Without ICEICLE_USE_DEVICE (or when the device is the host) the mirror is the only copy
+     * and the updates do nothing.
+     *
+     * @tparam T the value type (trivially copyable)
+     */
+    template<class T>
+    class device_array {
+        /// @brief the host mirror (its buffer is the address mapped to the device)
+        std::vector<T> host_data{};
+
+        /// @brief allocate the device copy of the host mirror
+        auto map_device() -> void {
+#ifdef ICEICLE_USE_DEVICE
+            T* ptr = host_data.data();
+            std::size_t n = host_data.size();
+            if(n > 0) {
+#pragma omp target enter data map(alloc: ptr[0:n])
+            }
+#endif
+        }
+
+        /// @brief free the device copy of the host mirror
+        auto unmap_device() -> void {
+#ifdef ICEICLE_USE_DEVICE
+            T* ptr = host_data.data();
+            std::size_t n = host_data.size();
+            if(n > 0) {
+#pragma omp target exit data map(delete: ptr[0:n])
+            }
+#endif
+        }
+
+        public:
+        using value_type = T;
+
+        device_array() = default;
+
+        /**
+         * @brief allocate n values on the host and the device filled with value
+         * @param n the number of values
+         * @param value the value to fill both copies with
+         */
+        explicit device_array(std::size_t n, const T& value = T{})
+        : host_data(n, value) { map_device(); update_device(); }
+
+        /**
+         * @brief allocate and copy the given host values to the device
+         * @param values the values
+         */
+        explicit device_array(std::span<const T> values)
+        : host_data(values.begin(), values.end()) { map_device(); update_device(); }
+
+        device_array(const device_array&) = delete;
+        device_array& operator=(const device_array&) = delete;
+
+        /// @brief moving keeps the host buffer so the device mapping moves with it
+        device_array(device_array&& other) noexcept
+        : host_data{std::move(other.host_data)} { other.host_data.clear(); }
+
+        device_array& operator=(device_array&& other) noexcept {
+            if(this != &other){
+                unmap_device();
+                host_data = std::move(other.host_data);
+                other.host_data.clear();
+            }
+            return *this;
+        }
+
+        ~device_array() { unmap_device(); }
+
+        /// @brief replace the contents (on both copies) with the given host values
+        auto assign(std::span<const T> values) -> void {
+            unmap_device();
+            host_data.assign(values.begin(), values.end());
+            map_device();
+            update_device();
+        }
+
+        /// @brief the number of values
+        [[nodiscard]] auto size() const noexcept -> std::size_t { return host_data.size(); }
+
+        /// @brief the address to capture in kernels (the host mirror outside of target regions)
+        [[nodiscard]] auto data() noexcept -> T* { return host_data.data(); }
+
+        /// @brief the address to capture in kernels (the host mirror outside of target regions)
+        [[nodiscard]] auto data() const noexcept -> const T* { return host_data.data(); }
+
+        /// @brief the host mirror (only up to date after update_host())
+        [[nodiscard]] auto host() noexcept -> std::span<T> { return host_data; }
+
+        /// @brief the host mirror (only up to date after update_host())
+        [[nodiscard]] auto host() const noexcept -> std::span<const T> { return host_data; }
+
+        /// @brief copy the values [begin, begin + count) of the host mirror to the device
+        auto update_device([[maybe_unused]] std::size_t begin, [[maybe_unused]] std::size_t count) -> void {
+#ifdef ICEICLE_USE_DEVICE
+            T* ptr = host_data.data();
+            if(count > 0) {
+#pragma omp target update to(ptr[begin:count])
+            }
+#endif
+        }
+
+        /// @brief copy the host mirror to the device
+        auto update_device() -> void { update_device(0, size()); }
+
+        /// @brief copy the values [begin, begin + count) on the device to the host mirror
+        auto update_host([[maybe_unused]] std::size_t begin, [[maybe_unused]] std::size_t count) -> void {
+#ifdef ICEICLE_USE_DEVICE
+            T* ptr = host_data.data();
+            if(count > 0) {
+#pragma omp target update from(ptr[begin:count])
+            }
+#endif
+        }
+
+        /// @brief copy the device values to the host mirror
+        auto update_host() -> void { update_host(0, size()); }
+    };
+}
@@ -0,0 +1,244 @@
+/**
+ * @brief forward mode automatic differentiation with dual numbers
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <type_traits>
+
+namespace iceicle::util {
+
+    /**
+     * @brief a dual number with multiple derivative lanes
+     * represents x + sum_i dx_i * e_i where e_i * e_j = 0
+     *
+     * Evaluating a function templated on the real number type with Dual inputs
+     * gives the value and the derivatives with respect to all of the seeded inputs
+     * in a single evaluation
+     *
+     * Functions should call math functions unqualified (i.e using std::sqrt; sqrt(x);)
+     * so that the overloads in this namespace are found by argument dependent lookup
+     *
+     * @tparam T the floating point type
+     * @tparam nlane the number of derivative lanes
+     */
+    template<class T, int nlane>
+    struct Dual {
+        using value_type = T;
+
+        /// @brief the number of derivative lanes
+        static constexpr int nderiv = nlane;
+
+        /// @brief the primal value
+        T val = 0;
+
+        /// @brief the derivatives wrt each lane
+        std::array<T, nlane> grad{};
+
+        /// @brief default constructor: zero value and derivatives
+        constexpr Dual() noexcept = default;
+
+        /// @brief construct a constant (zero derivatives)
+        template<class S> requires std::is_arithmetic_v<S>
+        constexpr Dual(S value) noexcept : val{static_cast<T>(value)}, grad{} {}
+
+        /**
+         * @brief construct a seeded independent variable
+         * @param value the primal value
+         * @param ilane the lane to set the derivative to 1 for
+         */
+        constexpr Dual(T value, int ilane) noexcept : val{value}, grad{}
+        { grad[ilane] = 1; }
+
+        constexpr auto operator+=(const Dual& other) noexcept -> Dual& {
+            val += other.val;
+            for(int i = 0; i < nlane; ++i) grad[i] += other.grad[i];
+            return *this;
+        }
+
+        constexpr auto operator-=(const Dual& other) noexcept -> Dual& {
+            val -= other.val;
+            for(int i = 0; i < nlane; ++i) grad[i] -= other.grad[i];
+            return *this;
+        }
+
+        constexpr auto operator*=(const Dual& other) noexcept -> Dual& {
+            for(int i = 0; i < nlane; ++i) grad[i] = grad[i] * other.val + val * other.grad[i];
+            val *= other.val;
+            return *this;
+        }
+
+        constexpr auto operator/=(const Dual& other) noexcept -> Dual& {
+            T inv = 1 / other.val;
+            val *= inv;
+            for(int i = 0; i < nlane; ++i) grad[i] = (grad[i] - val * other.grad[i]) * inv;
+            return *this;
+        }
+    };
+
+    /// @brief true if T is a Dual number type
+    template<class T>
+    struct is_dual : std::false_type {};
+
+    template<class T, int nlane>
+    struct is_dual<Dual<T, nlane>> : std::true_type {};
+
+    template<class T>
+    inline constexpr bool is_dual_v = is_dual<std::remove_cvref_t<T>>::value;
+
+    /// @brief get the primal value of a real or dual number
+    template<class T>
+    constexpr auto primal(const T& x) noexcept {
+        if constexpr (is_dual_v<T>) return x.val;
+        else return x;
+    }
+
+    // ========================
+    // = Arithmetic Operators =
+    // ========================
+
+    template<class T, int n>
+    constexpr auto operator-(Dual<T, n> a) noexcept -> Dual<T, n> {
+        a.val = -a.val;
+        for(int i = 0; i < n; ++i) a.grad[i] = -a.grad[i];
+        return a;
+    }
+
+    template<class T, int n>
+    constexpr auto operator+(const Dual<T, n>& a) noexcept -> Dual<T, n> { return a; }
+
+    template<class T, int n>
+    constexpr auto operator+(Dual<T, n> a, const Dual<T, n>& b) noexcept -> Dual<T, n> { return a += b; }
+    template<class T, int n>
+    constexpr auto operator-(Dual<T, n> a, const Dual<T, n>& b) noexcept -> Dual<T, n> { return a -= b; }
+    template<class T, int n>
+    constexpr auto operator*(Dual<T, n> a, const Dual<T, n>& b) noexcept -> Dual<T, n> { return a *= b; }
+    template<class T, int n>
+    constexpr auto operator/(Dual<T, n> a, const Dual<T, n>& b) noexcept -> Dual<T, n> { return a /= b; }
+
+    // mixed operations with real numbers avoid forming a dual for the constant
+    template<class T, int n, class S> requires std::is_arithmetic_v<S>
+    constexpr auto operator+(Dual<T, n> a, S b) noexcept -> Dual<T, n> { a.val += b; return a; }
+    template<class T, int n, class S> requires std::is_arithmetic_v<S>
+    constexpr auto operator+(S b, Dual<T, n> a) noexcept -> Dual<T, n> { a.val += b; return a; }
+    template<class T, int n, class S> requires std::is_arithmetic_v<S>
+    constexpr auto operator-(Dual<T, n> a, S b) noexcept -> Dual<T, n> { a.val -= b; return a; }
+    template<class T, int n, class S> requires std::is_arithmetic_v<S>
+    constexpr auto operator-(S b, const Dual<T, n>& a) noexcept -> Dual<T, n> { return -a + b; }
+
+    template<class T, int n, class S> requires std::is_arithmetic_v<S>
+    constexpr auto operator*(Dual<T, n> a, S b) noexcept -> Dual<T, n> {
+        a.val *= b;
+        for(int i = 0; i < n; ++i) a.grad[i] *= b;
+        return a;
+    }
+    template<class T, int n, class S> requires std::is_arithmetic_v<S>
+    constexpr auto operator*(S b, Dual<T, n> a) noexcept -> Dual<T, n> { return a * b; }
+    template<class T, int n, class S> requires std::is_arithmetic_v<S>
+    constexpr auto operator/(Dual<T, n> a, S b) noexcept -> Dual<T, n> { return a * (1 / static_cast<T>(b)); }
+    template<class T, int n, class S> requires std::is_arithmetic_v<S>
+    constexpr auto operator/(S b, const Dual<T, n>& a) noexcept -> Dual<T, n> {
+        Dual<T, n> out;
+        out.val = b / a.val;
+        T dinv = -out.val / a.val;
+        for(int i = 0; i < n; ++i) out.grad[i] = dinv * a.grad[i];
+        return out;
+    }
+
+    // ===============
+    // = Comparisons =
+    // ===============
+    // compare primal values only
+
+    template<class A, class B> requires (is_dual_v<A> || is_dual_v<B>)
+    constexpr auto operator==(const A& a, const B& b) noexcept -> bool { return primal(a) == primal(b); }
+    template<class A, class B> requires (is_dual_v<A> || is_dual_v<B>)
+    constexpr auto operator<(const A& a, const B& b) noexcept -> bool { return primal(a) < primal(b); }
+    template<class A, class B> requires (is_dual_v<A> || is_dual_v<B>)
+    constexpr auto operator>(const A& a, const B& b) noexcept -> bool { return primal(a) > primal(b); }
+    template<class A, class B> requires (is_dual_v<A> || is_dual_v<B>)
+    constexpr auto operator<=(const A& a, const B& b) noexcept -> bool { return primal(a) <= primal(b); }
+    template<class A, class B> requires (is_dual_v<A> || is_dual_v<B>)
+    constexpr auto operator>=(const A& a, const B& b) noexcept -> bool { return primal(a) >= primal(b); }
+
+    // ==================
+    // = Math Functions =
+    // ==================
+
+    /// @brief apply the chain rule given f(a.val) and f'(a.val)
+    template<class T, int n>
+    constexpr auto chain(const Dual<T, n>& a, T fval, T dfval) noexcept -> Dual<T, n> {
+        Dual<T, n> out;
+        out.val = fval;
+        for(int i = 0; i < n; ++i) out.grad[i] = dfval * a.grad[i];
+        return out;
+    }
+
+    template<class T, int n>
+    auto sqrt(const Dual<T, n>& a) noexcept -> Dual<T, n> {
+        T s = std::sqrt(a.val);
+        return chain(a, s, (T) 0.5 / s);
+    }
+
+    template<class T, int n>
+    auto abs(const Dual<T, n>& a) noexcept -> Dual<T, n> {
+        return (a.val < 0) ? -a : a;
+    }
+
+    template<class T, int n>
+    auto exp(const Dual<T, n>& a) noexcept -> Dual<T, n> {
+        T e = std::exp(a.val);
+        return chain(a, e, e);
+    }
+
+    template<class T, int n>
+    auto log(const Dual<T, n>& a) noexcept -> Dual<T, n> {
+        return chain(a, std::log(a.val), 1 / a.val);
+    }
+
+    template<class T, int n>
+    auto sin(const Dual<T, n>& a) noexcept -> Dual<T, n> {
+        return chain(a, std::sin(a.val), std::cos(a.val));
+    }
+
+    template<class T, int n>
+    auto cos(const Dual<T, n>& a) noexcept -> Dual<T, n> {
+        return chain(a, std::cos(a.val), -std::sin(a.val));
+    }
+
+    template<class T, int n, class S> requires std::is_arithmetic_v<S>
+    auto pow(const Dual<T, n>& a, S p) noexcept -> Dual<T, n> {
+        return chain(a, (T) std::pow(a.val, p), (T) (p * std::pow(a.val, p - 1)));
+    }
+
+    template<class T, int n, class S> requires std::is_arithmetic_v<S>
+    auto pow(S b, const Dual<T, n>& p) noexcept -> Dual<T, n> {
+        T bp = std::pow(b, p.val);
+        return chain(p, bp, bp * std::log((T) b));
+    }
+
+    template<class T, int n>
+    auto pow(const Dual<T, n>& a, const Dual<T, n>& p) noexcept -> Dual<T, n> {
+        return exp(p * log(a));
+    }
+
+    template<class A, class B> requires (is_dual_v<A> || is_dual_v<B>)
+    auto max(const A& a, const B& b) noexcept {
+        using dual_t = std::conditional_t<is_dual_v<A>, A, B>;
+        return (primal(a) < primal(b)) ? dual_t{b} : dual_t{a};
+    }
+
+    template<class A, class B> requires (is_dual_v<A> || is_dual_v<B>)
+    auto min(const A& a, const B& b) noexcept {
+        using dual_t = std::conditional_t<is_dual_v<A>, A, B>;
+        return (primal(b) < primal(a)) ? dual_t{b} : dual_t{a};
+    }
+
+    template<class T, int n, class S>
+    auto copysign(const Dual<T, n>& a, const S& sgn) noexcept -> Dual<T, n> {
+        return (std::signbit(a.val) == std::signbit(primal(sgn))) ? a : -a;
+    }
+}
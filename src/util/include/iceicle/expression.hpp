@@ -0,0 +1,372 @@
+/**
+ * @brief compiled mathematical expressions for user defined functions
+ * (initial conditions, boundary conditions, source terms) given as strings
+ *
+ * Expressions are parsed once to a stack bytecode that is evaluated in blocks of points,
+ * so the inner loop of each instruction runs over the block and vectorizes
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/anomaly_log.hpp"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <optional>
+#include <stdexcept>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace iceicle::util {
+
+    /**
+     * @brief a compiled expression of a fixed list of variables
+     *
+     * Syntax: numbers, variables, the constants pi and e,
+     * + - * / ^ (right associative power), unary -, parentheses,
+     * and the functions sin cos tan asin acos atan sinh cosh tanh exp log log10 sqrt abs floor ceil
+     * atan2(y, x) pow(a, b) min(a, b) max(a, b)
+     *
+     * @tparam T the real value type
+     */
+    template<class T>
+    class Expression {
+        public:
+        enum class opcode : unsigned char {
+            constant, variable,
+            add, sub, mul, div, pow, neg,
+            sin, cos, tan, asin, acos, atan, sinh, cosh, tanh, exp, log, log10, sqrt, abs, floor, ceil,
+            atan2, min, max
+        };
+
+        private:
+        struct instruction {
+            opcode op;
+            /// @brief the constant or variable index
+            std::size_t arg = 0;
+        };
+
+        std::vector<instruction> code{};
+        std::vector<T> constants{};
+        std::size_t nvar = 0;
+        std::size_t max_depth = 0;
+
+        /// @brief the number of points evaluated together
+        static constexpr std::size_t block_size = 64;
+
+        struct function_entry { std::string_view name; opcode op; int nargs; };
+        static constexpr std::array<function_entry, 21> functions{{
+            {"sin", opcode::sin, 1}, {"cos", opcode::cos, 1}, {"tan", opcode::tan, 1},
+            {"asin", opcode::asin, 1}, {"acos", opcode::acos, 1}, {"atan", opcode::atan, 1},
+            {"sinh", opcode::sinh, 1}, {"cosh", opcode::cosh, 1}, {"tanh", opcode::tanh, 1},
+            {"exp", opcode::exp, 1}, {"log", opcode::log, 1}, {"log10", opcode::log10, 1},
+            {"sqrt", opcode::sqrt, 1}, {"abs", opcode::abs, 1}, {"floor", opcode::floor, 1},
+            {"ceil", opcode::ceil, 1}, {"atan2", opcode::atan2, 2}, {"pow", opcode::pow, 2},
+            {"min", opcode::min, 2}, {"max", opcode::max, 2}, {"ln", opcode::log, 1}
+        }};
+
+        /// @brief recursive descent parser that emits the bytecode
+        struct parser {
+            std::string_view src;
+            std::span<const std::string> variables;
+            Expression& expr;
+            std::size_t pos = 0;
+            std::size_t depth = 0;
+            std::optional<std::string> error = std::nullopt;
+
+            void fail(std::string message) {
+                if(!error) error = message + " at position " + std::to_string(pos) + " in \"" + std::string{src} + "\"";
+            }
+
+            void skip_space() { while(pos < src.size() && std::isspace((unsigned char) src[pos])) ++pos; }
+
+            auto accept(char c) -> bool {
+                skip_space();
+                if(pos < src.size() && src[pos] == c) { ++pos; return true; }
+                return false;
+            }
+
+            void emit(opcode op, std::size_t arg = 0) {
+                expr.code.push_back(instruction{op, arg});
+                switch(op) {
+                    case opcode::constant: case opcode::variable: ++depth; break;
+                    case opcode::add: case opcode::sub: case opcode::mul: case opcode::div: case opcode::pow:
+                    case opcode::atan2: case opcode::min: case opcode::max: --depth; break;
+                    default: break;
+                }
+                expr.max_depth = std::max(expr.max_depth, depth);
+            }
+
+            void emit_constant(T value) {
+                expr.constants.push_back(value);
+                emit(opcode::constant, expr.constants.size() - 1);
+            }
+
+            void parse_expression() {
+                parse_term();
+                while(!error) {
+                    if(accept('+')) { parse_term(); emit(opcode::add); }
+                    else if(accept('-')) { parse_term(); emit(opcode::sub); }
+                    else break;
+                }
+            }
+
+            void parse_term() {
+                parse_unary();
+                while(!error) {
+                    if(accept('*')) { parse_unary(); emit(opcode::mul); }
+                    else if(accept('/')) { parse_unary(); emit(opcode::div); }
+                    else break;
+                }
+            }
+
+            void parse_unary() {
+                if(accept('-')) { parse_unary(); emit(opcode::neg); }
+                else if(accept('+')) { parse_unary(); }
+                else parse_power();
+            }
+
+            void parse_power() {
+                parse_primary();
+                if(!error && accept('^')) { parse_unary(); emit(opcode::pow); }
+            }
+
+            void parse_primary() {
+                skip_space();
+                if(pos >= src.size()) { fail("unexpected end of expression"); return; }
+                char c = src[pos];
+                if(std::isdigit((unsigned char) c) || c == '.') {
+                    std::size_t start = pos;
+                    while(pos < src.size() && (std::isdigit((unsigned char) src[pos]) || src[pos] == '.')) ++pos;
+                    if(pos < src.size() && (src[pos] == 'e' || src[pos] == 'E')) {
+                        std::size_t exp_pos = pos + 1;
+                        if(exp_pos < src.size() && (src[exp_pos] == '+' || src[exp_pos] == '-')) ++exp_pos;
+                        if(exp_pos < src.size() && std::isdigit((unsigned char) src[exp_pos])) {
+                            pos = exp_pos;
+                            while(pos < src.size() && std::isdigit((unsigned char) src[pos])) ++pos;
+                        }
+                    }
+                    try {
+                        emit_constant((T) std::stod(std::string{src.substr(start, pos - start)}));
+                    } catch(const std::exception&) {
+                        fail("invalid number");
+                    }
+                    return;
+                }
+                if(std::isalpha((unsigned char) c) || c == '_') {
+                    std::size_t start = pos;
+                    while(pos < src.size() && (std::isalnum((unsigned char) src[pos]) || src[pos] == '_')) ++pos;
+                    std::string_view name = src.substr(start, pos - start);
+                    if(accept('(')) {
+                        auto fcn = std::ranges::find(functions, name, &function_entry::name);
+                        if(fcn == functions.end()) { fail("unknown function " + std::string{name}); return; }
+                        for(int iarg = 0; iarg < fcn->nargs; ++iarg) {
+                            if(iarg > 0 && !accept(',')) { fail("expected , in the arguments of " + std::string{name}); return; }
+                            parse_expression();
+                            if(error) return;
+                        }
+                        if(!accept(')')) { fail("expected ) after the arguments of " + std::string{name}); return; }
+                        emit(fcn->op);
+                        return;
+                    }
+                    auto var = std::ranges::find(variables, name);
+                    if(var != variables.end()) { emit(opcode::variable, var - variables.begin()); return; }
+                    if(name == "pi") { emit_constant(std::numbers::pi_v<T>); return; }
+                    if(name == "e") { emit_constant(std::numbers::e_v<T>); return; }
+                    fail("unknown variable " + std::string{name});
+                    return;
+                }
+                if(accept('(')) {
+                    parse_expression();
+                    if(!error && !accept(')')) fail("expected )");
+                    return;
+                }
+                fail(std::string{"unexpected character "} + c);
+            }
+        };
+
+        /// @brief evaluate n <= block_size points with the given stack storage (max_depth x block_size)
+        void eval_block(std::size_t n, const T* points, std::size_t stride, T* out, T* stack) const {
+            std::size_t depth = 0; // the number of values on the stack
+            for(const instruction& inst : code) {
+                T* top = stack + (depth > 0 ? depth - 1 : 0) * block_size;
+                switch(inst.op) {
+                    case opcode::constant:
+                        top = stack + (depth++) * block_size;
+                        for(std::size_t i = 0; i < n; ++i) top[i] = constants[inst.arg];
+                        break;
+                    case opcode::variable:
+                        top = stack + (depth++) * block_size;
+                        for(std::size_t i = 0; i < n; ++i) top[i] = points[i * stride + inst.arg];
+                        break;
+#define ICEICLE_EXPRESSION_BINARY(OP, EXPR) \
+                    case opcode::OP: { \
+                        T* a = top - block_size; \
+                        const T* b = top; \
+                        for(std::size_t i = 0; i < n; ++i) a[i] = EXPR; \
+                        --depth; \
+                        break; \
+                    }
+#define ICEICLE_EXPRESSION_UNARY(OP, EXPR) \
+                    case opcode::OP: \
+                        for(std::size_t i = 0; i < n; ++i) top[i] = EXPR; \
+                        break;
+                    ICEICLE_EXPRESSION_BINARY(add, a[i] + b[i])
+                    ICEICLE_EXPRESSION_BINARY(sub, a[i] - b[i])
+                    ICEICLE_EXPRESSION_BINARY(mul, a[i] * b[i])
+                    ICEICLE_EXPRESSION_BINARY(div, a[i] / b[i])
+                    ICEICLE_EXPRESSION_BINARY(pow, std::pow(a[i], b[i]))
+                    ICEICLE_EXPRESSION_BINARY(atan2, std::atan2(a[i], b[i]))
+                    ICEICLE_EXPRESSION_BINARY(min, std::min(a[i], b[i]))
+                    ICEICLE_EXPRESSION_BINARY(max, std::max(a[i], b[i]))
+                    ICEICLE_EXPRESSION_UNARY(neg, -top[i])
+                    ICEICLE_EXPRESSION_UNARY(sin, std::sin(top[i]))
+                    ICEICLE_EXPRESSION_UNARY(cos, std::cos(top[i]))
+                    ICEICLE_EXPRESSION_UNARY(tan, std::tan(top[i]))
+                    ICEICLE_EXPRESSION_UNARY(asin, std::asin(top[i]))
+                    ICEICLE_EXPRESSION_UNARY(acos, std::acos(top[i]))
+                    ICEICLE_EXPRESSION_UNARY(atan, std::atan(top[i]))
+                    ICEICLE_EXPRESSION_UNARY(sinh, std::sinh(top[i]))
+                    ICEICLE_EXPRESSION_UNARY(cosh, std::cosh(top[i]))
+                    ICEICLE_EXPRESSION_UNARY(tanh, std::tanh(top[i]))
+                    ICEICLE_EXPRESSION_UNARY(exp, std::exp(top[i]))
+                    ICEICLE_EXPRESSION_UNARY(log, std::log(top[i]))
+                    ICEICLE_EXPRESSION_UNARY(log10, std::log10(top[i]))
+                    ICEICLE_EXPRESSION_UNARY(sqrt, std::sqrt(top[i]))
+                    ICEICLE_EXPRESSION_UNARY(abs, std::abs(top[i]))
+                    ICEICLE_EXPRESSION_UNARY(floor, std::floor(top[i]))
+                    ICEICLE_EXPRESSION_UNARY(ceil, std::ceil(top[i]))
+#undef ICEICLE_EXPRESSION_BINARY
+#undef ICEICLE_EXPRESSION_UNARY
+                }
+            }
+            std::copy_n(stack, n, out);
+        }
+
+        public:
+
+        /**
+         * @brief compile an expression
+         * logs an anomaly and returns nullopt on a syntax error or unknown name
+         * @param src the expression, i.e "sin(pi * x) * exp(-y^2)"
+         * @param variables the names of the variables in the order they are given to eval
+         */
+        static auto parse(std::string_view src, std::span<const std::string> variables) -> std::optional<Expression> {
+            Expression expr{};
+            expr.nvar = variables.size();
+            parser p{src, variables, expr};
+            p.parse_expression();
+            p.skip_space();
+            if(!p.error && p.pos < src.size()) p.fail("unexpected trailing input");
+            if(p.error) {
+                AnomalyLog::log_anomaly(Anomaly{"Expression parse error: " + p.error.value(),
+                        text_not_found_tag{std::string{src}}});
+                return std::nullopt;
+            }
+            return expr;
+        }
+
+        /// @brief the number of variables
+        [[nodiscard]] auto nvariables() const noexcept -> std::size_t { return nvar; }
+
+        /**
+         * @brief evaluate the expression at a batch of points
+         * @param npoint the number of points
+         * @param points the variable values for each point (point i starts at points + i * stride)
+         * @param stride the distance between points (at least nvariables())
+         * @param [out] out the value at each point (size = npoint)
+         */
+        void eval(std::size_t npoint, const T* points, std::size_t stride, T* out) const {
+            std::vector<T> stack(std::max(max_depth, (std::size_t) 1) * block_size);
+            for(std::size_t start = 0; start < npoint; start += block_size) {
+                std::size_t n = std::min(block_size, npoint - start);
+                eval_block(n, points + start * stride, stride, out + start, stack.data());
+            }
+        }
+
+        /// @brief evaluate the expression at a batch of points \overload contiguous points of nvariables() values
+        void eval(std::span<const T> points, std::span<T> out) const {
+            eval(out.size(), points.data(), std::max(nvar, (std::size_t) 1), out.data());
+        }
+
+        /// @brief evaluate the expression at a single point
+        /// @param vars the variable values (size = nvariables())
+        auto operator()(const T* vars) const -> T {
+            T out;
+            if(max_depth <= 4) {
+                std::array<T, 4 * block_size> stack;
+                eval_block(1, vars, nvar, &out, stack.data());
+            } else {
+                eval(1, vars, nvar, &out);
+            }
+            return out;
+        }
+    };
+
+    /**
+     * @brief a vector valued function given by one compiled expression per output
+     * @tparam T the real value type
+     */
+    template<class T>
+    class ExpressionFunction {
+        std::vector<Expression<T>> components{};
+
+        public:
+
+        /**
+         * @brief compile the expression for each output
+         * logs an anomaly and returns nullopt if any expression fails to compile
+         * @param srcs the expression for each output
+         * @param variables the names of the variables in the order they are given to eval
+         */
+        static auto parse(std::span<const std::string> srcs, std::span<const std::string> variables)
+        -> std::optional<ExpressionFunction> {
+            ExpressionFunction fcn{};
+            for(const std::string& src : srcs) {
+                std::optional<Expression<T>> expr = Expression<T>::parse(src, variables);
+                if(!expr) return std::nullopt;
+                fcn.components.push_back(std::move(expr.value()));
+            }
+            return fcn;
+        }
+
+        /// @brief the number of outputs
+        [[nodiscard]] auto noutput() const noexcept -> std::size_t { return components.size(); }
+
+        /// @brief evaluate at a single point
+        /// @param x the variable values
+        /// @param [out] out the output values (size = noutput())
+        void operator()(const T* x, T* out) const {
+            for(std::size_t i = 0; i < components.size(); ++i) out[i] = components[i](x);
+        }
+
+        /**
+         * @brief evaluate at a batch of points
+         * @param npoint the number of points
+         * @param points the variable values for each point (point i starts at points + i * stride)
+         * @param stride the distance between points
+         * @param [out] out the outputs (npoint x noutput())
+         */
+        void eval(std::size_t npoint, const T* points, std::size_t stride, T* out) const {
+            std::vector<T> values(npoint);
+            for(std::size_t icomp = 0; icomp < components.size(); ++icomp) {
+                components[icomp].eval(npoint, points, stride, values.data());
+                for(std::size_t ipoint = 0; ipoint < npoint; ++ipoint)
+                    { out[ipoint * components.size() + icomp] = values[ipoint]; }
+            }
+        }
+    };
+
+    /// @brief the default variable names for coordinates in ndim dimensions: x, y, z (then x3, x4, ...)
+    inline auto coordinate_names(int ndim) -> std::vector<std::string> {
+        std::vector<std::string> names{};
+        for(int idim = 0; idim < ndim; ++idim)
+            names.push_back((idim < 3) ? std::string(1, "xyz"[idim]) : "x" + std::to_string(idim));
+        return names;
+    }
+}
@@ -0,0 +1,91 @@
+/**
+ * @brief a map for a small number of keys with a linear search over flat arrays
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace iceicle::util {
+
+    /**
+     * @brief map for a small number of keys (i.e the few dozen element or trace types of a mesh)
+     * stored as a flat array of keys that is searched linearly
+     *
+     * The values are individually allocated so references to values stay valid
+     * when keys are added (i.e finite elements point into their reference element)
+     *
+     * @tparam Key the key type (equality comparable)
+     * @tparam Value the mapped type
+     */
+    template<class Key, class Value>
+    class small_flat_map {
+        /// @brief the keys in insertion order
+        std::vector<Key> _keys{};
+
+        /// @brief the value for each key
+        std::vector<std::unique_ptr<Value>> _values{};
+
+        public:
+
+        /// @brief the number of keys
+        [[nodiscard]] inline
+        auto size() const noexcept -> std::size_t { return _keys.size(); }
+
+        /// @brief the index of the key in insertion order or size() if it is not in the map
+        [[nodiscard]] inline
+        auto index_of(const Key& key) const noexcept -> std::size_t
+        { return std::distance(_keys.begin(), std::ranges::find(_keys, key)); }
+
+        /// @brief if the key is in the map
+        [[nodiscard]] inline
+        auto contains(const Key& key) const noexcept -> bool { return index_of(key) < size(); }
+
+        /// @brief the value for a key or nullptr if the key is not in the map
+        [[nodiscard]] inline
+        auto find(const Key& key) noexcept -> Value* {
+            std::size_t i = index_of(key);
+            return (i < size()) ? _values[i].get() : nullptr;
+        }
+
+        /// @brief the key at the given index (in insertion order)
+        [[nodiscard]] inline
+        auto key_at(std::size_t i) const noexcept -> const Key& { return _keys[i]; }
+
+        /// @brief the value at the given index (in insertion order)
+        [[nodiscard]] inline
+        auto value_at(std::size_t i) noexcept -> Value& { return *_values[i]; }
+
+        /// @brief the value at the given index (in insertion order)
+        [[nodiscard]] inline
+        auto value_at(std::size_t i) const noexcept -> const Value& { return *_values[i]; }
+
+        /**
+         * @brief get the value for a key, creating it with make() if the key is not in the map
+         * @param key the key
+         * @param make make() -> Value only called if the key is not in the map
+         */
+        template<class F>
+        auto get_or_emplace(const Key& key, F&& make) -> Value& {
+            std::size_t i = index_of(key);
+            if(i == size()){
+                _keys.push_back(key);
+                _values.push_back(std::make_unique<Value>(make()));
+            }
+            return *_values[i];
+        }
+
+        /// @brief get the value for a key (default constructed if the key is not in the map)
+        auto operator[](const Key& key) -> Value&
+        { return get_or_emplace(key, []{ return Value{}; }); }
+
+        /// @brief remove all the keys
+        auto clear() noexcept -> void {
+            _keys.clear();
+            _values.clear();
+        }
+    };
+}
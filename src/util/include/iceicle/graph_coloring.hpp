@@ -0,0 +1,59 @@
+/**
+ * @brief graph coloring utilities for conflict-free parallel loops
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/crs.hpp"
+#include <ranges>
+#include <vector>
+
+namespace iceicle::util {
+
+    /**
+     * @brief greedy coloring of a set of items that each write to a set of vertices
+     * Two items conflict if they share any vertex
+     * (e.g items are traces and vertices are the elements on either side)
+     *
+     * Each item is assigned the lowest color not already used by an item that
+     * touches one of its vertices, so items of the same color can be processed concurrently
+     *
+     * @param nitem the number of items to color
+     * @param nvertex the number of vertices
+     * @param vertices_of callable that takes an item index and returns
+     *        a range of the vertex indices that item touches
+     * @return compressed row storage where each row is a color
+     *         and the row entries are the item indices of that color (in ascending order)
+     */
+    template<class IDX, class VertexFunc>
+    auto greedy_coloring(IDX nitem, IDX nvertex, VertexFunc&& vertices_of)
+    -> crs<IDX, IDX>
+    {
+        // the colors already used by items touching each vertex
+        std::vector<std::vector<IDX>> vertex_colors(nvertex);
+
+        // forbidden[icolor] == iitem if icolor is forbidden for iitem
+        std::vector<IDX> forbidden{};
+
+        std::vector<std::vector<IDX>> colors{};
+        for(IDX iitem = 0; iitem < nitem; ++iitem){
+            for(IDX ivert : vertices_of(iitem)){
+                for(IDX icolor : vertex_colors[ivert]){
+                    forbidden[icolor] = iitem;
+                }
+            }
+
+            // select the lowest non-forbidden color
+            IDX icolor = 0;
+            while(icolor < (IDX) colors.size() && forbidden[icolor] == iitem) ++icolor;
+            if(icolor == (IDX) colors.size()){
+                colors.emplace_back();
+                forbidden.push_back(nitem);
+            }
+            colors[icolor].push_back(iitem);
+            for(IDX ivert : vertices_of(iitem)){
+                vertex_colors[ivert].push_back(icolor);
+            }
+        }
+        return crs<IDX, IDX>{colors};
+    }
+}
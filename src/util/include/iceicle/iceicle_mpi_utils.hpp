@@ -2,8 +2,14 @@
 #pragma once
 #ifdef ICEICLE_USE_MPI
 #include <mpi.h>
+#include "iceicle/mpi_type.hpp"
 #endif
+#include <array>
+#include <cstddef>
+#include <iostream>
+#include <span>
 #include <utility>
+#include <vector>
 namespace iceicle {
     namespace mpi {
 
@@ -20,6 +26,75 @@ namespace iceicle {
 #endif
         }
 
+#ifdef ICEICLE_USE_MPI
+        /// @brief the ranks of MPI_COMM_WORLD that share memory with this rank (MPI_COMM_TYPE_SHARED)
+        struct node_topology {
+            /// @brief the communicator over the ranks of this node
+            MPI_Comm comm = MPI_COMM_NULL;
+
+            /// @brief the rank in comm of each world rank (MPI_UNDEFINED if on another node)
+            std::vector<int> node_rank{};
+
+            /// @brief if world rank irank is on this node
+            [[nodiscard]] auto on_node(int irank) const -> bool { return node_rank[irank] != MPI_UNDEFINED; }
+        };
+
+        /**
+         * @brief the node topology of this rank
+         * created once by the first call (collective over MPI_COMM_WORLD) and live until MPI_Finalize
+         * init_funneled() makes the first call so later calls make no MPI calls
+         */
+        inline
+        auto get_node_topology() -> const node_topology& {
+            static node_topology topology = []{
+                node_topology topo{};
+                int nrank;
+                MPI_Comm_size(MPI_COMM_WORLD, &nrank);
+                MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &topo.comm);
+                MPI_Group world_group, node_group;
+                MPI_Comm_group(MPI_COMM_WORLD, &world_group);
+                MPI_Comm_group(topo.comm, &node_group);
+                std::vector<int> world_ranks(nrank);
+                for(int irank = 0; irank < nrank; ++irank) world_ranks[irank] = irank;
+                topo.node_rank.assign(nrank, MPI_UNDEFINED);
+                MPI_Group_translate_ranks(world_group, nrank, world_ranks.data(), node_group, topo.node_rank.data());
+                MPI_Group_free(&world_group);
+                MPI_Group_free(&node_group);
+                return topo;
+            }();
+            return topology;
+        }
+#endif
+
+        /**
+         * @brief initialize mpi for the hybrid execution model
+         * threads may be used inside each rank but only the main thread makes mpi calls
+         * (MPI_THREAD_FUNNELED)
+         *
+         * This must be called before PetscInitialize so that PETSc uses this initialization
+         * (mpi must then be finalized after PetscFinalize)
+         *
+         * @param argc pointer to the argc from main
+         * @param argv pointer to the argv from main
+         */
+        inline
+        auto init_funneled(int* argc, char*** argv) -> void 
+        {
+#ifdef ICEICLE_USE_MPI
+            int provided;
+            MPI_Init_thread(argc, argv, MPI_THREAD_FUNNELED, &provided);
+            if(provided < MPI_THREAD_FUNNELED){
+                int myrank;
+                MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
+                if(myrank == 0) std::cerr << "Warning: the MPI implementation does not support "
+                    "MPI_THREAD_FUNNELED, threads within a rank may not be safe" << std::endl;
+            }
+
+            // split the node communicator while every rank is here
+            get_node_topology();
+#endif
+        }
+
         /// @brief execute the function fcn with arguments args only on rank irank
         template<class F, class... ArgsT>
         inline constexpr
@@ -61,6 +136,134 @@ namespace iceicle {
 #endif
         }
 
+        /**
+         * @brief sum several quantities over all ranks with a single allreduce
+         * (i.e the partial dot products and norms of a solver iteration)
+         * @param local the quantities on this rank
+         * @return the sums over all ranks
+         */
+        template<class T, std::size_t N>
+        inline
+        auto allreduce_sums(std::array<T, N> local) -> std::array<T, N>
+        {
+#ifdef ICEICLE_USE_MPI
+            if(mpi_initialized())
+                MPI_Allreduce(MPI_IN_PLACE, local.data(), (int) N, mpi_get_type<T>(), MPI_SUM, MPI_COMM_WORLD);
+#endif
+            return local;
+        }
+
+#ifdef ICEICLE_USE_MPI
+        namespace impl {
+            /// @brief MPI_Op that sums the first nsum and takes the maximum of the last nmax entries of each record
+            template<class T, std::size_t nsum, std::size_t nmax>
+            void sum_max_records_op(void* in, void* inout, int* len, MPI_Datatype*){
+                const T* a = static_cast<const T*>(in);
+                T* b = static_cast<T*>(inout);
+                for(int irec = 0; irec < *len; ++irec, a += nsum + nmax, b += nsum + nmax){
+                    for(std::size_t k = 0; k < nsum; ++k) b[k] += a[k];
+                    for(std::size_t k = nsum; k < nsum + nmax; ++k) b[k] = (a[k] > b[k]) ? a[k] : b[k];
+                }
+            }
+
+            /// @brief the record type and operation for sum_max_records_op
+            /// created once and live until MPI_Finalize
+            template<class T, std::size_t nsum, std::size_t nmax>
+            auto sum_max_record_type() -> std::pair<MPI_Datatype, MPI_Op> {
+                static MPI_Datatype rec_type = []{
+                    MPI_Datatype type;
+                    MPI_Type_contiguous((int) (nsum + nmax), mpi_get_type<T>(), &type);
+                    MPI_Type_commit(&type);
+                    return type;
+                }();
+                static MPI_Op rec_op = []{
+                    MPI_Op op;
+                    MPI_Op_create(&impl::sum_max_records_op<T, nsum, nmax>, 1, &op);
+                    return op;
+                }();
+                return {rec_type, rec_op};
+            }
+        }
+#endif
+
+        /**
+         * @brief reduce records of nsum sums followed by nmax maxima over all ranks 
+         * in place with a single allreduce
+         * (i.e the squared L2 error and maximum error of each solution component)
+         *
+         * @tparam nsum the number of quantities to sum in each record
+         * @tparam nmax the number of quantities to take the maximum of in each record
+         * @param data the records [size = nrecord * (nsum + nmax)]
+         */
+        template<std::size_t nsum, std::size_t nmax, class T>
+        inline
+        auto allreduce_sum_max_records(std::span<T> data) -> void
+        {
+#ifdef ICEICLE_USE_MPI
+            if(!mpi_initialized()) return;
+            auto [rec_type, rec_op] = impl::sum_max_record_type<T, nsum, nmax>();
+            MPI_Allreduce(MPI_IN_PLACE, data.data(), (int) (data.size() / (nsum + nmax)),
+                    rec_type, rec_op, MPI_COMM_WORLD);
+#endif
+        }
+
+        /// @brief a nonblocking reduction in flight (always complete without mpi)
+        struct reduction_request {
+#ifdef ICEICLE_USE_MPI
+            MPI_Request request = MPI_REQUEST_NULL;
+#endif
+
+            /// @brief wait for the reduction to complete (no-op if complete)
+            void wait() {
+#ifdef ICEICLE_USE_MPI
+                if(request != MPI_REQUEST_NULL) MPI_Wait(&request, MPI_STATUS_IGNORE);
+#endif
+            }
+
+            /// @brief if the reduction was started and has not been waited on (always false without mpi)
+            [[nodiscard]] auto pending() const noexcept -> bool {
+#ifdef ICEICLE_USE_MPI
+                return request != MPI_REQUEST_NULL;
+#else
+                return false;
+#endif
+            }
+
+            /// @brief check if the reduction is complete without blocking (progresses the reduction)
+            auto test() -> bool {
+#ifdef ICEICLE_USE_MPI
+                if(request == MPI_REQUEST_NULL) return true;
+                int flag = 0;
+                MPI_Test(&request, &flag, MPI_STATUS_IGNORE);
+                return flag != 0;
+#else
+                return true;
+#endif
+            }
+        };
+
+        /**
+         * @brief start reducing records of nsum sums followed by nmax maxima over all ranks in place
+         * the data must not be accessed until the request is waited on
+         *
+         * @tparam nsum the number of quantities to sum in each record
+         * @tparam nmax the number of quantities to take the maximum of in each record
+         * @param data the records [size = nrecord * (nsum + nmax)]
+         * @return the request to wait on
+         */
+        template<std::size_t nsum, std::size_t nmax, class T>
+        inline
+        auto iallreduce_sum_max_records(std::span<T> data) -> reduction_request
+        {
+            reduction_request req{};
+#ifdef ICEICLE_USE_MPI
+            if(!mpi_initialized()) return req;
+            auto [rec_type, rec_op] = impl::sum_max_record_type<T, nsum, nmax>();
+            MPI_Iallreduce(MPI_IN_PLACE, data.data(), (int) (data.size() / (nsum + nmax)),
+                    rec_type, rec_op, MPI_COMM_WORLD, &req.request);
+#endif
+            return req;
+        }
     }
 }
 
@@ -0,0 +1,466 @@
+/**
+ * @brief dense factorizations for small square matrices (element mass matrices, jacobian blocks, geometric factors)
+ *
+ * All matrices are contiguous and row major (a[i * n + j])
+ * The size is a template parameter N so the loops fully unroll for common small sizes;
+ * N = dynamic_size takes the size at runtime.
+ *
+ * When ICEICLE_USE_LAPACKE is defined, dynamic size float and double factorizations above
+ * lapack_min_size go through LAPACKE instead
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include <iceicle/thread_utils.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef ICEICLE_USE_LAPACKE
+#include <lapacke.h>
+#endif
+
+namespace iceicle::linalg {
+
+    /// @brief the size template argument for matrices with size only known at runtime
+    inline constexpr std::size_t dynamic_size = std::dynamic_extent;
+
+#ifdef ICEICLE_USE_LAPACKE
+    /// @brief the pivot index type (matches LAPACKE)
+    using pivot_index = lapack_int;
+
+    /// @brief the smallest dynamic size that is handed to LAPACKE
+    /// (below this the call overhead dominates the unrolled loops)
+    inline constexpr std::size_t lapack_min_size = 16;
+#else
+    /// @brief the pivot index type
+    using pivot_index = int;
+#endif
+
+    namespace impl {
+        /// @brief the size to loop to: N if it is known at compile time else n
+        template<std::size_t N>
+        inline constexpr
+        auto block_size(std::size_t n) noexcept -> std::size_t {
+            if constexpr (N == dynamic_size) return n;
+            else return N;
+        }
+
+#ifdef ICEICLE_USE_LAPACKE
+        /// @brief if a factorization of size n with value type T should go through LAPACKE
+        template<std::size_t N, class T>
+        inline constexpr
+        auto use_lapacke(std::size_t n) noexcept -> bool {
+            return N == dynamic_size && n >= lapack_min_size
+                && (std::is_same_v<T, double> || std::is_same_v<T, float>);
+        }
+#endif
+    }
+
+    // ==========================
+    // = Fixed Size Determinant =
+    // ==========================
+
+    /// @brief the determinant of a 1x1, 2x2 or 3x3 row major matrix
+    template<std::size_t N, class T>
+    requires(N >= 1 && N <= 3)
+    [[nodiscard]] inline constexpr
+    auto det(const T* a) noexcept -> T {
+        if constexpr (N == 1) {
+            return a[0];
+        } else if constexpr (N == 2) {
+            return a[0] * a[3] - a[1] * a[2];
+        } else {
+            return a[0] * (a[4] * a[8] - a[5] * a[7])
+                 - a[1] * (a[3] * a[8] - a[5] * a[6])
+                 + a[2] * (a[3] * a[7] - a[4] * a[6]);
+        }
+    }
+
+    /**
+     * @brief the inverse of a 1x1, 2x2 or 3x3 row major matrix by the adjugate
+     * @param [in] a the matrix
+     * @param [out] ainv the inverse (must not overlap a), untouched if the matrix is singular
+     * @return the determinant of a
+     */
+    template<std::size_t N, class T>
+    requires(N >= 1 && N <= 3)
+    inline constexpr
+    auto inv(const T* a, T* ainv) noexcept -> T {
+        T d = det<N>(a);
+        if(d == 0) return d;
+        T r = 1 / d;
+        if constexpr (N == 1) {
+            ainv[0] = r;
+        } else if constexpr (N == 2) {
+            ainv[0] =  a[3] * r; ainv[1] = -a[1] * r;
+            ainv[2] = -a[2] * r; ainv[3] =  a[0] * r;
+        } else {
+            ainv[0] = (a[4] * a[8] - a[5] * a[7]) * r;
+            ainv[1] = (a[2] * a[7] - a[1] * a[8]) * r;
+            ainv[2] = (a[1] * a[5] - a[2] * a[4]) * r;
+            ainv[3] = (a[5] * a[6] - a[3] * a[8]) * r;
+            ainv[4] = (a[0] * a[8] - a[2] * a[6]) * r;
+            ainv[5] = (a[2] * a[3] - a[0] * a[5]) * r;
+            ainv[6] = (a[3] * a[7] - a[4] * a[6]) * r;
+            ainv[7] = (a[1] * a[6] - a[0] * a[7]) * r;
+            ainv[8] = (a[0] * a[4] - a[1] * a[3]) * r;
+        }
+        return d;
+    }
+
+    // ============
+    // = Cholesky =
+    // ============
+
+    /**
+     * @brief in place Cholesky factorization A = L L^T of a symmetric positive definite matrix
+     * Only the lower triangle of a is read and it is overwritten with L
+     * @param [in/out] a the n x n matrix
+     * @param [in] n the size (ignored if N is not dynamic_size)
+     * @return false if the matrix is not positive definite
+     */
+    template<std::size_t N = dynamic_size, class T>
+    inline constexpr
+    auto cholesky_factor(T* a, std::size_t n = N) -> bool {
+        const std::size_t m = impl::block_size<N>(n);
+#ifdef ICEICLE_USE_LAPACKE
+        if(impl::use_lapacke<N, T>(m)) {
+            if constexpr (std::is_same_v<T, double>)
+                return LAPACKE_dpotrf(LAPACK_ROW_MAJOR, 'L', m, a, m) == 0;
+            else if constexpr (std::is_same_v<T, float>)
+                return LAPACKE_spotrf(LAPACK_ROW_MAJOR, 'L', m, a, m) == 0;
+        }
+#endif
+        for(std::size_t j = 0; j < m; ++j){
+            T djj = a[j * m + j];
+            for(std::size_t k = 0; k < j; ++k)
+                djj -= a[j * m + k] * a[j * m + k];
+            if(!(djj > 0)) return false;
+            djj = std::sqrt(djj);
+            a[j * m + j] = djj;
+            for(std::size_t i = j + 1; i < m; ++i){
+                T lij = a[i * m + j];
+                for(std::size_t k = 0; k < j; ++k)
+                    lij -= a[i * m + k] * a[j * m + k];
+                a[i * m + j] = lij / djj;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief solve A x = b in place given the Cholesky factor L from cholesky_factor
+     * @param [in] l the factored matrix (lower triangle)
+     * @param [in/out] b the right hand side, overwritten with x
+     * @param [in] n the size (ignored if N is not dynamic_size)
+     */
+    template<std::size_t N = dynamic_size, class T>
+    inline constexpr
+    auto cholesky_solve(const T* l, T* b, std::size_t n = N) noexcept -> void {
+        const std::size_t m = impl::block_size<N>(n);
+        // L y = b
+        for(std::size_t i = 0; i < m; ++i){
+            T yi = b[i];
+            for(std::size_t k = 0; k < i; ++k)
+                yi -= l[i * m + k] * b[k];
+            b[i] = yi / l[i * m + i];
+        }
+        // L^T x = y
+        for(std::size_t i = m; i-- > 0;){
+            T xi = b[i];
+            for(std::size_t k = i + 1; k < m; ++k)
+                xi -= l[k * m + i] * b[k];
+            b[i] = xi / l[i * m + i];
+        }
+    }
+
+    /**
+     * @brief in place inverse of a symmetric positive definite matrix by Cholesky factorization
+     * Only the lower triangle is read, the full (symmetric) inverse is written
+     * @param [in/out] a the n x n matrix, overwritten with its inverse
+     *                 (contents are unspecified if the matrix is not positive definite)
+     * @param [in] n the size (ignored if N is not dynamic_size)
+     * @return false if the matrix is not positive definite
+     */
+    template<std::size_t N = dynamic_size, class T>
+    inline constexpr
+    auto cholesky_invert(T* a, std::size_t n = N) -> bool {
+        const std::size_t m = impl::block_size<N>(n);
+        if(!cholesky_factor<N>(a, m)) return false;
+        bool lower_done = false;
+#ifdef ICEICLE_USE_LAPACKE
+        if(impl::use_lapacke<N, T>(m)) {
+            if constexpr (std::is_same_v<T, double>)
+                lower_done = LAPACKE_dpotri(LAPACK_ROW_MAJOR, 'L', m, a, m) == 0;
+            else if constexpr (std::is_same_v<T, float>)
+                lower_done = LAPACKE_spotri(LAPACK_ROW_MAJOR, 'L', m, a, m) == 0;
+        }
+#endif
+        if(!lower_done) {
+            // L := L^{-1} (lower triangular, column by column from the right)
+            for(std::size_t j = 0; j < m; ++j){
+                a[j * m + j] = 1 / a[j * m + j];
+                for(std::size_t i = j + 1; i < m; ++i){
+                    T sum = 0;
+                    for(std::size_t k = j; k < i; ++k)
+                        sum += a[i * m + k] * a[k * m + j];
+                    a[i * m + j] = -sum / a[i * m + i];
+                }
+            }
+
+            // lower triangle of A^{-1} = L^{-T} L^{-1}
+            // row i only reads rows k >= i of L^{-1} so ascending rows can be overwritten
+            // the diagonal is written last since every entry of the row uses it
+            for(std::size_t i = 0; i < m; ++i){
+                for(std::size_t j = 0; j <= i; ++j){
+                    T sum = 0;
+                    for(std::size_t k = i; k < m; ++k)
+                        sum += a[k * m + i] * a[k * m + j];
+                    if(j < i) a[i * m + j] = sum;
+                    else a[i * m + i] = sum;
+                }
+            }
+        }
+
+        // mirror to the upper triangle
+        for(std::size_t i = 0; i < m; ++i){
+            for(std::size_t j = i + 1; j < m; ++j)
+                a[i * m + j] = a[j * m + i];
+        }
+        return true;
+    }
+
+    // ======
+    // = LU =
+    // ======
+
+    /**
+     * @brief in place LU factorization with partial pivoting P A = L U
+     * L (unit diagonal) and U overwrite a
+     * @param [in/out] a the n x n matrix
+     * @param [out] piv the pivots: row i was swapped with row piv[i] (size n)
+     * @param [in] n the size (ignored if N is not dynamic_size)
+     * @return false if the matrix is singular
+     */
+    template<std::size_t N = dynamic_size, class T>
+    inline constexpr
+    auto lu_factor(T* a, pivot_index* piv, std::size_t n = N) -> bool {
+        using std::abs;
+        const std::size_t m = impl::block_size<N>(n);
+        for(std::size_t k = 0; k < m; ++k){
+            // find the pivot
+            std::size_t p = k;
+            T amax = abs(a[k * m + k]);
+            for(std::size_t i = k + 1; i < m; ++i){
+                if(abs(a[i * m + k]) > amax){
+                    amax = abs(a[i * m + k]);
+                    p = i;
+                }
+            }
+            piv[k] = static_cast<pivot_index>(p);
+            if(amax == 0) return false;
+            if(p != k){
+                for(std::size_t j = 0; j < m; ++j)
+                    std::swap(a[k * m + j], a[p * m + j]);
+            }
+
+            // eliminate below the pivot
+            T rpiv = 1 / a[k * m + k];
+            for(std::size_t i = k + 1; i < m; ++i){
+                T lik = a[i * m + k] * rpiv;
+                a[i * m + k] = lik;
+                for(std::size_t j = k + 1; j < m; ++j)
+                    a[i * m + j] -= lik * a[k * m + j];
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief solve A x = b in place given the factorization from lu_factor
+     * @param [in] lu the factored matrix
+     * @param [in] piv the pivots from lu_factor
+     * @param [in/out] b the right hand side, overwritten with x
+     * @param [in] n the size (ignored if N is not dynamic_size)
+     */
+    template<std::size_t N = dynamic_size, class T>
+    inline constexpr
+    auto lu_solve(const T* lu, const pivot_index* piv, T* b, std::size_t n = N) noexcept -> void {
+        const std::size_t m = impl::block_size<N>(n);
+        for(std::size_t k = 0; k < m; ++k){
+            if(static_cast<std::size_t>(piv[k]) != k) std::swap(b[k], b[piv[k]]);
+        }
+        // L y = P b
+        for(std::size_t i = 1; i < m; ++i){
+            T yi = b[i];
+            for(std::size_t k = 0; k < i; ++k)
+                yi -= lu[i * m + k] * b[k];
+            b[i] = yi;
+        }
+        // U x = y
+        for(std::size_t i = m; i-- > 0;){
+            T xi = b[i];
+            for(std::size_t k = i + 1; k < m; ++k)
+                xi -= lu[i * m + k] * b[k];
+            b[i] = xi / lu[i * m + i];
+        }
+    }
+
+    /**
+     * @brief in place inverse of a general matrix by LU factorization with partial pivoting
+     * @param [in/out] a the n x n matrix, overwritten with its inverse
+     *                 (contents are unspecified if the matrix is singular)
+     * @param [out] piv pivot storage (size n)
+     * @param [out] work workspace (size n * n)
+     * @param [in] n the size (ignored if N is not dynamic_size)
+     * @return false if the matrix is singular
+     */
+    template<std::size_t N = dynamic_size, class T>
+    inline constexpr
+    auto lu_invert(T* a, pivot_index* piv, T* work, std::size_t n = N) -> bool {
+        const std::size_t m = impl::block_size<N>(n);
+        if constexpr (N != dynamic_size && N <= 3) {
+            std::copy_n(a, m * m, work);
+            return inv<N>(work, a) != 0;
+        }
+#ifdef ICEICLE_USE_LAPACKE
+        if(impl::use_lapacke<N, T>(m)) {
+            if constexpr (std::is_same_v<T, double>) {
+                return LAPACKE_dgetrf(LAPACK_ROW_MAJOR, m, m, a, m, piv) == 0
+                    && LAPACKE_dgetri(LAPACK_ROW_MAJOR, m, a, m, piv) == 0;
+            } else if constexpr (std::is_same_v<T, float>) {
+                return LAPACKE_sgetrf(LAPACK_ROW_MAJOR, m, m, a, m, piv) == 0
+                    && LAPACKE_sgetri(LAPACK_ROW_MAJOR, m, a, m, piv) == 0;
+            }
+        }
+#endif
+        if(!lu_factor<N>(a, piv, m)) return false;
+
+        // solve for the columns of the inverse into the rows of work (transposed)
+        for(std::size_t j = 0; j < m; ++j){
+            T* col = work + j * m;
+            std::fill_n(col, m, T{0});
+            col[j] = 1;
+            lu_solve<N>(a, piv, col, m);
+        }
+        for(std::size_t i = 0; i < m; ++i){
+            for(std::size_t j = 0; j < m; ++j)
+                a[i * m + j] = work[j * m + i];
+        }
+        return true;
+    }
+
+    // ===========
+    // = Batched =
+    // ===========
+
+    /**
+     * @brief call f with std::integral_constant<std::size_t, N> for the first of Sizes equal to n
+     * or with std::integral_constant<std::size_t, dynamic_size> if none match
+     * Used to pick the compile time specialization of the kernels above for a runtime size
+     */
+    template<std::size_t... Sizes, class F>
+    inline constexpr
+    auto dispatch_size(std::size_t n, F&& f) -> decltype(auto) {
+        using result_t = decltype(f(std::integral_constant<std::size_t, dynamic_size>{}));
+        if constexpr (std::is_void_v<result_t>) {
+            bool found = ((n == Sizes && (f(std::integral_constant<std::size_t, Sizes>{}), true)) || ...);
+            if(!found) f(std::integral_constant<std::size_t, dynamic_size>{});
+        } else {
+            result_t result{};
+            bool found = ((n == Sizes && (result = f(std::integral_constant<std::size_t, Sizes>{}), true)) || ...);
+            if(!found) result = f(std::integral_constant<std::size_t, dynamic_size>{});
+            return result;
+        }
+    }
+
+    /// @brief call f with the compile time size for the common element basis sizes
+    /// (linear and quadratic simplices, tensor product up to cubic in 2D and quadratic in 3D)
+    template<class F>
+    inline constexpr
+    auto dispatch_basis_size(std::size_t n, F&& f) -> decltype(auto) {
+        return dispatch_size<1, 2, 3, 4, 6, 8, 9, 10, 16, 27>(n, std::forward<F>(f));
+    }
+
+    /**
+     * @brief invert nblock contiguous n x n symmetric positive definite blocks in place (threaded)
+     * @param [in] nblock the number of blocks
+     * @param [in/out] blocks the row major blocks one after the other
+     * @param [in] on_fail on_fail(iblock) called for blocks that are not positive definite
+     *             (may be called concurrently)
+     * @param [in] n the block size (ignored if N is not dynamic_size)
+     */
+    template<std::size_t N = dynamic_size, class T, class F>
+    inline
+    auto batched_cholesky_invert(std::size_t nblock, T* blocks, F&& on_fail, std::size_t n = N) -> void {
+        const std::size_t m = impl::block_size<N>(n);
+        util::parallel_for(nblock, [&](std::size_t ib){
+            if(!cholesky_invert<N>(blocks + ib * m * m, m)) on_fail(ib);
+        });
+    }
+
+    /**
+     * @brief invert nblock contiguous n x n blocks in place by LU factorization (threaded)
+     * @param [in] nblock the number of blocks
+     * @param [in/out] blocks the row major blocks one after the other
+     * @param [in] on_fail on_fail(iblock) called for singular blocks (may be called concurrently)
+     * @param [in] n the block size (ignored if N is not dynamic_size)
+     */
+    template<std::size_t N = dynamic_size, class T, class F>
+    inline
+    auto batched_lu_invert(std::size_t nblock, T* blocks, F&& on_fail, std::size_t n = N) -> void {
+        const std::size_t m = impl::block_size<N>(n);
+        std::vector<pivot_index> piv(m * util::max_threads());
+        std::vector<T> work(m * m * util::max_threads());
+        util::parallel_for(nblock, [&](std::size_t ib){
+            const std::size_t ithread = util::thread_num();
+            if(!lu_invert<N>(blocks + ib * m * m, piv.data() + ithread * m,
+                        work.data() + ithread * m * m, m))
+                on_fail(ib);
+        });
+    }
+
+    /**
+     * @brief solve nblock independent systems A_i x_i = b_i for contiguous n x n blocks (threaded)
+     * @param [in] nblock the number of blocks
+     * @param [in/out] blocks the row major blocks, overwritten with their LU factorizations
+     * @param [in/out] rhs the right hand sides (n per block), overwritten with the solutions
+     * @param [in] on_fail on_fail(iblock) called for singular blocks
+     *             (the right hand side is left untouched, may be called concurrently)
+     * @param [in] n the block size (ignored if N is not dynamic_size)
+     */
+    template<std::size_t N = dynamic_size, class T, class F>
+    inline
+    auto batched_lu_solve(std::size_t nblock, T* blocks, T* rhs, F&& on_fail, std::size_t n = N) -> void {
+        const std::size_t m = impl::block_size<N>(n);
+        std::vector<pivot_index> piv(m * util::max_threads());
+        util::parallel_for(nblock, [&](std::size_t ib){
+            pivot_index* piv_thread = piv.data() + util::thread_num() * m;
+            T* a = blocks + ib * m * m;
+            if(lu_factor<N>(a, piv_thread, m)) lu_solve<N>(a, piv_thread, rhs + ib * m, m);
+            else on_fail(ib);
+        });
+    }
+
+    /**
+     * @brief invert nblock contiguous 1x1, 2x2 or 3x3 matrices (i.e jacobians of the geometric mapping) (threaded)
+     * @param [in] nblock the number of matrices
+     * @param [in] a the row major matrices one after the other
+     * @param [out] ainv the inverses (must not overlap a)
+     * @param [out] dets the determinant of each matrix (size nblock),
+     *              for a zero determinant the inverse is left untouched
+     */
+    template<std::size_t N, class T>
+    requires(N >= 1 && N <= 3)
+    inline
+    auto batched_inv(std::size_t nblock, const T* a, T* ainv, T* dets) -> void {
+        util::parallel_for(nblock, [&](std::size_t ib){
+            dets[ib] = inv<N>(a + ib * N * N, ainv + ib * N * N);
+        });
+    }
+}
@@ -0,0 +1,99 @@
+/**
+ * @brief error bounded lossy compression of floating point coefficients
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/compressed_crs.hpp"
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+namespace iceicle::util {
+
+    namespace impl::lossy {
+        /// @brief the token for a run of zero quantized values (followed by the varint run length)
+        inline constexpr std::uint64_t zero_run = 0;
+
+        /// @brief the token for a value stored exactly (followed by the raw bytes)
+        inline constexpr std::uint64_t raw_value = 1;
+
+        /// @brief the offset of the zigzag quantization index in the token of any other value
+        inline constexpr std::uint64_t quantized_offset = 1;
+    }
+
+    /**
+     * @brief compress values with an absolute error bound and append them to bytes
+     *
+     * Every value is quantized to the nearest multiple of 2 * error_bound (so |v - v_decoded| <= error_bound)
+     * and the quantization indices are stored as zigzag varints with runs of zeros collapsed.
+     * Values that cannot be quantized within the bound (non-finite, too large, or a non-positive error_bound)
+     * are stored exactly.
+     *
+     * This pays off for the modal coefficients of an element (i.e a HypercubeLegendreBasis)
+     * where the high order coefficients of a resolved solution fall below the bound
+     * and cost a fraction of a byte each.
+     *
+     * @param values the values to compress
+     * @param error_bound the maximum absolute error of each value
+     * @param [out] bytes the encoded values are appended
+     */
+    template<std::floating_point T>
+    auto lossy_compress(std::span<const T> values, T error_bound, std::vector<std::uint8_t>& bytes) -> void {
+        using namespace impl::compressed_crs;
+        using namespace impl::lossy;
+        const T step = 2 * error_bound;
+        std::uint64_t nzero = 0;
+        auto flush_zeros = [&]{
+            if(nzero > 0) {
+                write_varint(bytes, zero_run);
+                write_varint(bytes, nzero);
+                nzero = 0;
+            }
+        };
+        for(T v : values){
+            bool quantizable = error_bound > 0 && std::isfinite(v) && std::abs(v) < step * (T) 0x1p62;
+            std::int64_t q = quantizable ? std::llround(v / step) : 0;
+            // the decoded value must be within the bound after rounding of q * step
+            if(quantizable && std::abs(v - (T) q * step) <= error_bound) {
+                if(q == 0) { ++nzero; continue; }
+                flush_zeros();
+                write_varint(bytes, zigzag(q) + quantized_offset);
+            } else {
+                flush_zeros();
+                write_varint(bytes, raw_value);
+                const std::uint8_t* value_bytes = reinterpret_cast<const std::uint8_t*>(&v);
+                bytes.insert(bytes.end(), value_bytes, value_bytes + sizeof(T));
+            }
+        }
+        flush_zeros();
+    }
+
+    /**
+     * @brief decode values written by lossy_compress and advance the pointer past them
+     * @param ptr the pointer to the encoded values
+     * @param [out] values the decoded values (the same number as were compressed)
+     * @param error_bound the error bound the values were compressed with
+     */
+    template<std::floating_point T>
+    auto lossy_decompress(const std::uint8_t*& ptr, std::span<T> values, T error_bound) -> void {
+        using namespace impl::compressed_crs;
+        using namespace impl::lossy;
+        const T step = 2 * error_bound;
+        for(std::size_t i = 0; i < values.size();){
+            std::uint64_t token = read_varint(ptr);
+            if(token == zero_run) {
+                std::uint64_t nzero = read_varint(ptr);
+                for(; nzero > 0 && i < values.size(); --nzero) values[i++] = 0;
+            } else if(token == raw_value) {
+                std::memcpy(&values[i++], ptr, sizeof(T));
+                ptr += sizeof(T);
+            } else {
+                values[i++] = (T) unzigzag(token - quantized_offset) * step;
+            }
+        }
+    }
+}
@@ -1,6 +1,202 @@
 #pragma once
 #include <sol/sol.hpp>
+#include <iceicle/anomaly_log.hpp>
+#include <iceicle/expression.hpp>
+#include <iceicle/profiler.hpp>
 #include <iceicle/string_utils.hpp>
+#include <iceicle/thread_utils.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
 namespace iceicle::util {
 
+    /**
+     * @brief compile the expression strings in a lua config (see lua_get_expression_function)
+     * @return the compiled expressions or nullopt
+     */
+    template<class T>
+    auto lua_get_expression(sol::object obj, int nout, int ndim)
+    -> std::optional<ExpressionFunction<T>> {
+        std::vector<std::string> srcs{};
+        if(obj.get_type() == sol::type::string) {
+            srcs.assign(nout, obj.as<std::string>());
+        } else if(obj.get_type() == sol::type::table) {
+            sol::table tbl = obj.as<sol::table>();
+            bool any_string = false;
+            for(std::size_t i = 1; i <= tbl.size(); ++i) {
+                sol::object entry = tbl[i];
+                if(entry.get_type() == sol::type::string) {
+                    srcs.push_back(entry.as<std::string>());
+                    any_string = true;
+                } else if(entry.get_type() == sol::type::number) {
+                    srcs.push_back(fmt::format("{}", entry.as<T>()));
+                } else {
+                    return std::nullopt;
+                }
+            }
+            if(!any_string) return std::nullopt;
+            if(srcs.size() != (std::size_t) nout) {
+                AnomalyLog::log_anomaly(Anomaly{"Number of expressions doesn't match the number of outputs", 
+                        general_anomaly_tag{}});
+                return std::nullopt;
+            }
+        } else {
+            return std::nullopt;
+        }
+        std::vector<std::string> variables = coordinate_names(ndim);
+        return ExpressionFunction<T>::parse(srcs, variables);
+    }
+
+    /**
+     * @brief compile a function of the coordinates given as expression strings in a lua config 
+     * i.e "sin(pi * x) * exp(-y^2)" in terms of the coordinates x, y, z
+     *
+     * @param obj either a string (used for every output) or a table of nout strings or numbers
+     * @param nout the number of outputs
+     * @param ndim the number of coordinates
+     * @return the compiled function f(x, out), or nullopt if obj is not a string 
+     *         or a table with at least one string (so the caller can handle lua functions and values), 
+     *         or if an expression fails to compile (an anomaly is logged)
+     */
+    template<class T>
+    auto lua_get_expression_function(sol::object obj, int nout, int ndim)
+    -> std::optional<std::function<void(const T*, T*)>> {
+        std::optional<ExpressionFunction<T>> fcn = lua_get_expression<T>(obj, nout, ndim);
+        if(!fcn) return std::nullopt;
+        return std::function<void(const T*, T*)>{fcn.value()};
+    }
+
+    /**
+     * @brief compile a function of the coordinates given as expression strings in a lua config 
+     * that is evaluated at a batch of points f(npoint, x, out)
+     * with x [npoint x ndim] and out [npoint x nout]
+     * (blocks of points are distributed over threads)
+     *
+     * @param obj either a string (used for every output) or a table of nout strings or numbers
+     * @param nout the number of outputs
+     * @param ndim the number of coordinates
+     * @return the compiled function, or nullopt (see lua_get_expression_function)
+     */
+    template<class T>
+    auto lua_get_expression_batch_function(sol::object obj, int nout, int ndim)
+    -> std::optional<std::function<void(std::size_t, const T*, T*)>> {
+        std::optional<ExpressionFunction<T>> fcn = lua_get_expression<T>(obj, nout, ndim);
+        if(!fcn) return std::nullopt;
+        return std::function<void(std::size_t, const T*, T*)>{
+            [fcn = std::move(fcn.value()), nout, ndim](std::size_t npoint, const T* x, T* out){
+                static constexpr std::size_t block = 1024;
+                parallel_for((npoint + block - 1) / block, [&](std::size_t iblock){
+                    std::size_t start = iblock * block;
+                    fcn.eval(std::min(block, npoint - start), x + start * ndim, ndim, out + start * nout);
+                });
+            }
+        };
+    }
+
+    /**
+     * @brief enable the region profiler from the "profile" table of a lua config
+     * profile = { enabled = true, counters = "perf", file = "profile.json" }
+     * (the profiler is also enabled by force_enable, i.e from a command line flag)
+     *
+     * @param config the lua config
+     * @param force_enable enable the profiler even without a "profile" table
+     * @return the filename to write the json statistics to (empty for none)
+     */
+    inline auto lua_setup_profiler(sol::table config, bool force_enable = false) -> std::string {
+        sol::optional<sol::table> profile_tbl_opt = config["profile"];
+        bool enable = force_enable;
+        std::string json_filename{};
+        if(profile_tbl_opt) {
+            sol::table profile_tbl = profile_tbl_opt.value();
+            enable = enable || profile_tbl.get_or("enabled", true);
+            json_filename = profile_tbl.get_or("file", std::string{"profile.json"});
+            sol::optional<std::string> counters = profile_tbl["counters"];
+            if(enable && counters) {
+                if(eq_icase(counters.value(), "perf")) {
+                    counter_hooks hooks = perf_counter_hooks();
+                    if(hooks.names.empty()) {
+                        AnomalyLog::log_anomaly(Anomaly{"perf_event counters are unavailable "
+                                "(check /proc/sys/kernel/perf_event_paranoid)", general_anomaly_tag{}});
+                    }
+                    Profiler::set_counter_hooks(std::move(hooks));
+                } else if(!eq_icase(counters.value(), "none")) {
+                    AnomalyLog::log_anomaly(Anomaly{"unrecognized profiler counters", 
+                            text_not_found_tag{counters.value()}});
+                }
+            }
+        }
+        if(enable) Profiler::enable();
+        return (enable) ? json_filename : std::string{};
+    }
+
+    /**
+     * @brief a copy of a lua table with the entries of overrides applied recursively
+     * Tables in both are merged key by key unless the override is a sequence (i.e a_adv = {1.0, 0.0})
+     * which replaces the base entry. Neither table is modified
+     *
+     * @param base the table to copy
+     * @param overrides the entries to add or replace
+     * @return the merged table
+     */
+    inline auto lua_merge_tables(sol::table base, sol::table overrides) -> sol::table {
+        sol::state_view lua{base.lua_state()};
+        sol::table merged = lua.create_table();
+        for(const auto& [key, value] : base) merged.set(key, value);
+        for(const auto& [key, value] : overrides) {
+            sol::object base_value = merged.get<sol::object>(key);
+            if(value.get_type() == sol::type::table && base_value.get_type() == sol::type::table
+                    && value.as<sol::table>().size() == 0) {
+                merged.set(key, lua_merge_tables(base_value.as<sol::table>(), value.as<sol::table>()));
+            } else {
+                merged.set(key, value);
+            }
+        }
+        return merged;
+    }
+
+    /**
+     * @brief the configuration of each run of an ensemble from the "ensemble" table of a lua config
+     * given as a list of cases or a function of the 1-based case index:
+     * ensemble = { { conservation_law = { mu = 0.1 } }, { conservation_law = { mu = 0.2 } } }
+     * ensemble = { ncase = 10, case = function(i) return { conservation_law = { mu = 0.1 * i } } end }
+     * Each case overrides the entries of the config (see lua_merge_tables)
+     *
+     * @param config the lua config
+     * @return the config of each case (just the config if there is no ensemble table)
+     */
+    inline auto lua_ensemble_cases(sol::table config) -> std::vector<sol::table> {
+        sol::optional<sol::table> ensemble_opt = config["ensemble"];
+        if(!ensemble_opt) return std::vector<sol::table>{config};
+        sol::table ensemble = ensemble_opt.value();
+
+        std::vector<sol::table> cases{};
+        sol::optional<sol::protected_function> case_fcn = ensemble["case"];
+        if(case_fcn) {
+            int ncase = ensemble.get_or("ncase", 0);
+            for(int icase = 1; icase <= ncase; ++icase) {
+                sol::protected_function_result result = case_fcn.value()(icase);
+                if(!result.valid() || result.get_type() != sol::type::table) {
+                    AnomalyLog::log_anomaly(Anomaly{fmt::format("ensemble case {} did not return a table", icase),
+                            general_anomaly_tag{}});
+                    continue;
+                }
+                cases.push_back(lua_merge_tables(config, result.get<sol::table>()));
+            }
+        } else {
+            for(std::size_t icase = 1; icase <= ensemble.size(); ++icase) {
+                sol::optional<sol::table> case_tbl = ensemble[icase];
+                if(!case_tbl) {
+                    AnomalyLog::log_anomaly(Anomaly{fmt::format("ensemble case {} is not a table", icase),
+                            general_anomaly_tag{}});
+                    continue;
+                }
+                cases.push_back(lua_merge_tables(config, case_tbl.value()));
+            }
+        }
+        return cases;
+    }
 }
@@ -0,0 +1,86 @@
+/**
+ * @brief read only memory mapped view of a file
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace iceicle::util {
+
+    /// @brief read only view of the bytes of a file
+    /// the file is memory mapped when available so that large files are not copied into memory
+    /// (pages are read from disk when first touched)
+    class mapped_file {
+        const char* _data = nullptr;
+        std::size_t _size = 0;
+        bool _mapped = false;
+
+        /// @brief fallback storage when the file cannot be memory mapped
+        std::vector<char> _buffer{};
+
+        public:
+
+        /// @brief open and map the file for reading
+        /// @param filename the name of the file
+        /// @param sequential hint to the kernel that the file will be read front to back (read ahead)
+        /// @param read_fallback read the whole file into memory if it cannot be mapped
+        /// (otherwise the view is empty)
+        mapped_file(const std::string& filename, bool sequential = true, bool read_fallback = true) {
+#if __has_include(<sys/mman.h>)
+            int fd = ::open(filename.c_str(), O_RDONLY);
+            if(fd >= 0){
+                struct stat st;
+                if(::fstat(fd, &st) == 0 && st.st_size > 0){
+                    void* map = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if(map != MAP_FAILED){
+                        if(sequential) ::madvise(map, st.st_size, MADV_SEQUENTIAL);
+                        _data = static_cast<const char*>(map);
+                        _size = st.st_size;
+                        _mapped = true;
+                    }
+                }
+                ::close(fd);
+            }
+#endif
+            if(!_mapped && read_fallback){
+                std::ifstream infile{filename, std::ios::binary};
+                if(infile){
+                    _buffer.assign(std::istreambuf_iterator<char>{infile}, std::istreambuf_iterator<char>{});
+                    _data = _buffer.data();
+                    _size = _buffer.size();
+                }
+            }
+        }
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        ~mapped_file() {
+#if __has_include(<sys/mman.h>)
+            if(_mapped) ::munmap(const_cast<char*>(_data), _size);
+#endif
+        }
+
+        /// @brief the bytes of the file
+        [[nodiscard]] inline auto data() const noexcept -> const char* { return _data; }
+
+        /// @brief the size of the file in bytes
+        [[nodiscard]] inline auto size() const noexcept -> std::size_t { return _size; }
+
+        /// @brief true if the file is memory mapped (rather than read into memory)
+        [[nodiscard]] inline auto mapped() const noexcept -> bool { return _mapped; }
+
+        /// @brief true if the file was opened
+        explicit operator bool() const noexcept { return _data != nullptr; }
+    };
+}
@@ -0,0 +1,178 @@
+/**
+ * @brief aligned allocation and a reusable arena of solution sized work arrays
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <vector>
+
+namespace iceicle::util {
+
+    /// @brief the alignment in bytes of solution sized arrays (cache line and AVX-512 vector width)
+    inline constexpr std::size_t simd_alignment = 64;
+
+    /**
+     * @brief allocator that aligns storage to simd_alignment bytes
+     * so that vectorized kernels may assume aligned loads at the start of the array
+     * @tparam T the value type
+     */
+    template<class T>
+    struct aligned_allocator {
+        using value_type = T;
+
+        template<class U>
+        struct rebind { using other = aligned_allocator<U>; };
+
+        aligned_allocator() noexcept = default;
+
+        template<class U>
+        aligned_allocator(const aligned_allocator<U>&) noexcept {}
+
+        [[nodiscard]] auto allocate(std::size_t n) -> T* {
+            return static_cast<T*>(::operator new(n * sizeof(T),
+                        std::align_val_t{std::max(simd_alignment, alignof(T))}));
+        }
+
+        auto deallocate(T* ptr, std::size_t) noexcept -> void {
+            ::operator delete(ptr, std::align_val_t{std::max(simd_alignment, alignof(T))});
+        }
+
+        template<class U>
+        friend auto operator==(const aligned_allocator<T>&, const aligned_allocator<U>&) noexcept
+        -> bool { return true; }
+    };
+
+    /// @brief a vector with storage aligned to simd_alignment bytes
+    template<class T>
+    using aligned_vector = std::vector<T, aligned_allocator<T>>;
+
+    template<class T>
+    class vector_arena;
+
+    /**
+     * @brief a scoped checkout of a buffer from a vector_arena
+     * the buffer is returned to the arena when this goes out of scope
+     *
+     * This is a contiguous range so it can be used directly to construct
+     * fespan, dofspan, and component_span views
+     */
+    template<class T>
+    class arena_checkout {
+        vector_arena<T>* arena;
+        aligned_vector<T>* buffer;
+        std::size_t n;
+
+        public:
+        arena_checkout(vector_arena<T>& arena, aligned_vector<T>& buffer, std::size_t n) noexcept
+        : arena{&arena}, buffer{&buffer}, n{n} {}
+
+        arena_checkout(const arena_checkout&) = delete;
+        arena_checkout& operator=(const arena_checkout&) = delete;
+
+        arena_checkout(arena_checkout&& other) noexcept
+        : arena{other.arena}, buffer{other.buffer}, n{other.n}
+        { other.arena = nullptr; }
+
+        arena_checkout& operator=(arena_checkout&&) = delete;
+
+        ~arena_checkout() { if(arena) arena->release(*buffer); }
+
+        [[nodiscard]] auto data() noexcept -> T* { return buffer->data(); }
+        [[nodiscard]] auto data() const noexcept -> const T* { return buffer->data(); }
+        [[nodiscard]] auto size() const noexcept -> std::size_t { return n; }
+        [[nodiscard]] auto begin() noexcept -> T* { return data(); }
+        [[nodiscard]] auto end() noexcept -> T* { return data() + n; }
+        [[nodiscard]] auto begin() const noexcept -> const T* { return data(); }
+        [[nodiscard]] auto end() const noexcept -> const T* { return data() + n; }
+        [[nodiscard]] auto operator[](std::size_t i) noexcept -> T& { return buffer->data()[i]; }
+        [[nodiscard]] auto operator[](std::size_t i) const noexcept -> const T& { return buffer->data()[i]; }
+
+        /// @brief a span over the checked out range
+        [[nodiscard]] auto span() noexcept -> std::span<T> { return std::span<T>{data(), n}; }
+    };
+
+    /**
+     * @brief a pool of aligned work arrays that are reused across solver iterations
+     *
+     * checkout(n) hands out a free buffer with capacity for at least n values
+     * (allocating one only when none is free) so that repeated solver operations
+     * (i.e every Krylov iteration of a matrix-free jacobian product) do not allocate
+     * once the arena is warmed up.
+     *
+     * The checked out values are not initialized.
+     *
+     * NOTE: not thread safe, each thread should use its own arena
+     *
+     * @tparam T the value type
+     */
+    template<class T>
+    class vector_arena {
+        /// @brief the buffers (unique_ptr for stable addresses while checked out)
+        std::vector<std::unique_ptr<aligned_vector<T>>> buffers{};
+
+        /// @brief if the buffer at the same index is checked out
+        std::vector<bool> in_use{};
+
+        friend class arena_checkout<T>;
+
+        auto release(aligned_vector<T>& buffer) noexcept -> void {
+            for(std::size_t ibuf = 0; ibuf < buffers.size(); ++ibuf){
+                if(buffers[ibuf].get() == &buffer) in_use[ibuf] = false;
+            }
+        }
+
+        public:
+
+        vector_arena() = default;
+        vector_arena(const vector_arena&) = delete;
+        vector_arena& operator=(const vector_arena&) = delete;
+
+        /**
+         * @brief check out a buffer of at least n values
+         * prefers the smallest free buffer that is large enough
+         * @param n the number of values
+         * @return the scoped checkout
+         */
+        [[nodiscard]] auto checkout(std::size_t n) -> arena_checkout<T> {
+            std::size_t ibest = buffers.size();
+            std::size_t ilargest = buffers.size();
+            for(std::size_t ibuf = 0; ibuf < buffers.size(); ++ibuf){
+                if(in_use[ibuf]) continue;
+                std::size_t cap = buffers[ibuf]->size();
+                if(cap >= n && (ibest == buffers.size() || cap < buffers[ibest]->size())) ibest = ibuf;
+                if(ilargest == buffers.size() || cap > buffers[ilargest]->size()) ilargest = ibuf;
+            }
+            if(ibest == buffers.size()){
+                if(ilargest != buffers.size()){
+                    // grow the largest free buffer instead of adding another
+                    ibest = ilargest;
+                    buffers[ibest]->resize(n);
+                } else {
+                    buffers.push_back(std::make_unique<aligned_vector<T>>(n));
+                    in_use.push_back(false);
+                }
+            }
+            in_use[ibest] = true;
+            return arena_checkout<T>{*this, *buffers[ibest], n};
+        }
+
+        /// @brief the number of buffers owned by the arena
+        [[nodiscard]] auto nbuffer() const noexcept -> std::size_t { return buffers.size(); }
+
+        /// @brief the number of buffers currently checked out
+        [[nodiscard]] auto nin_use() const noexcept -> std::size_t
+        { return std::ranges::count(in_use, true); }
+
+        /// @brief free all buffers that are not checked out
+        auto trim() -> void {
+            for(std::size_t ibuf = 0; ibuf < buffers.size(); ++ibuf){
+                if(!in_use[ibuf]) { buffers[ibuf]->clear(); buffers[ibuf]->shrink_to_fit(); }
+            }
+        }
+    };
+}
@@ -0,0 +1,96 @@
+/// @brief accounting of the memory held by data structures
+/// @author Gianni Absillis (gabsill@ncsu.edu)
+#pragma once
+#include "iceicle/crs.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fmt/format.h>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#ifdef ICEICLE_USE_MPI
+#include <mpi.h>
+#endif
+
+namespace iceicle::util {
+
+    /// @brief the bytes allocated by a vector (capacity, not size)
+    template<class V, class Alloc>
+    auto vector_bytes(const std::vector<V, Alloc>& v) noexcept -> std::size_t
+    { return v.capacity() * sizeof(V); }
+
+    /// @brief the bytes allocated by a crs matrix
+    template<class V, class IDX>
+    auto crs_bytes(const crs<V, IDX>& a) noexcept -> std::size_t
+    { return a.nnz() * sizeof(V) + (a.nrow() + 1) * sizeof(IDX); }
+
+    /**
+     * @brief a list of named memory allocations with the number of items in each
+     * (i.e elements, traces, cached geometric factors)
+     */
+    struct MemoryReport {
+        struct entry {
+            /// @brief the name of the data structure
+            std::string name;
+
+            /// @brief the number of items (i.e elements)
+            std::size_t count;
+
+            /// @brief the bytes held
+            std::size_t bytes;
+        };
+
+        std::vector<entry> entries{};
+
+        /// @brief add an entry
+        void add(std::string_view name, std::size_t count, std::size_t bytes)
+        { entries.push_back(entry{std::string{name}, count, bytes}); }
+
+        /// @brief the bytes of the entry with the given name (0 if there is none)
+        [[nodiscard]] auto bytes(std::string_view name) const noexcept -> std::size_t {
+            for(const entry& e : entries) if(e.name == name) return e.bytes;
+            return 0;
+        }
+
+        /// @brief the total bytes of all entries
+        [[nodiscard]] auto total() const noexcept -> std::size_t {
+            std::size_t sum = 0;
+            for(const entry& e : entries) sum += e.bytes;
+            return sum;
+        }
+
+        /**
+         * @brief sum the counts and bytes over all processes (collective)
+         * every process must have the same entries in the same order
+         * @return the summed report
+         */
+        [[nodiscard]] auto reduce_sums() const -> MemoryReport {
+            MemoryReport global = *this;
+#ifdef ICEICLE_USE_MPI
+            int initialized;
+            MPI_Initialized(&initialized);
+            if(initialized){
+                std::vector<std::uint64_t> values{};
+                for(const entry& e : entries) { values.push_back(e.count); values.push_back(e.bytes); }
+                MPI_Allreduce(MPI_IN_PLACE, values.data(), (int) values.size(), MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+                for(std::size_t i = 0; i < entries.size(); ++i){
+                    global.entries[i].count = values[2 * i];
+                    global.entries[i].bytes = values[2 * i + 1];
+                }
+            }
+#endif
+            return global;
+        }
+
+        /// @brief print a table of the entries in KiB with the bytes per item and the total
+        void print(std::ostream& out) const {
+            out << fmt::format("{:<28} {:>12} {:>14} {:>12}\n", "", "count", "KiB", "bytes/item");
+            for(const entry& e : entries){
+                out << fmt::format("{:<28} {:>12} {:>14.1f} {:>12.1f}\n", e.name, e.count, e.bytes / 1024.0,
+                        (e.count > 0) ? (double) e.bytes / e.count : 0.0);
+            }
+            out << fmt::format("{:<28} {:>12} {:>14.1f}\n", "total", "", total() / 1024.0);
+        }
+    };
+}
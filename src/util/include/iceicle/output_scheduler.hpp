@@ -0,0 +1,187 @@
+/**
+ * @brief decide when to write outputs and checkpoints during a time integration
+ * from step, simulation time, wall clock, and job walltime triggers
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#ifdef ICEICLE_USE_MPI
+#include <mpi.h>
+#endif
+
+namespace iceicle::util {
+
+    /// @brief what to write at a step
+    struct output_event {
+        /// @brief write the outputs (writers and residual report)
+        bool output = false;
+
+        /// @brief also write a checkpoint (restart file)
+        bool checkpoint = false;
+
+        /// @brief this is the last checkpoint before the job walltime expires
+        bool walltime = false;
+
+        explicit operator bool() const noexcept { return output || checkpoint; }
+    };
+
+    /**
+     * @brief schedules outputs and checkpoints of a time integration
+     *
+     * An output is due when any of the enabled triggers fires:
+     * - every: every this many steps (itime % every == 0)
+     * - time_interval: every this much simulation time (the first step at or past each multiple)
+     * - wall_interval: every this many seconds of wall clock time since the last output
+     *
+     * Outputs that become due within min_separation steps of the last output are deferred
+     * (not dropped) until the separation is reached, so triggers that fire close together
+     * coalesce into one output instead of landing on consecutive steps.
+     * Every checkpoint_every-th output also writes a checkpoint.
+     *
+     * With a job walltime, one final output and checkpoint is forced (regardless of min_separation)
+     * when the remaining time is less than walltime_margin plus two of the slowest steps seen.
+     *
+     * poll() must be called on every rank at every step. The wall clock is the maximum over ranks
+     * so every rank makes the same decision; the reduction is only done if a wall clock trigger is enabled.
+     */
+    template<class T, class IDX = int>
+    class OutputScheduler {
+        using clock = std::chrono::steady_clock;
+
+        clock::time_point start = clock::now();
+
+        /// @brief the elapsed seconds and step of the last output
+        double last_output_wall = 0.0;
+        std::optional<IDX> last_output_step{};
+
+        /// @brief the elapsed seconds and step of the last poll (to estimate the step cost)
+        double last_poll_wall = 0.0;
+        std::optional<IDX> last_poll_step{};
+
+        /// @brief the most seconds a step has taken
+        double max_step_seconds = 0.0;
+
+        /// @brief the next simulation time for the time interval trigger
+        std::optional<T> next_time{};
+
+        /// @brief a trigger fired but the output was deferred by min_separation
+        bool pending = false;
+
+        /// @brief the walltime checkpoint was written
+        bool walltime_done = false;
+
+        /// @brief the number of outputs written
+        IDX noutput = 0;
+
+        /// @brief the elapsed wall clock seconds (the maximum over ranks)
+        auto elapsed() const -> double {
+            double seconds = std::chrono::duration<double>(clock::now() - start).count();
+#ifdef ICEICLE_USE_MPI
+            if(mpi::mpi_initialized()) {
+                double local = seconds;
+                MPI_Allreduce(&local, &seconds, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+            }
+#endif
+            return seconds;
+        }
+
+        public:
+
+        /// @brief the number of steps between outputs (0 disables)
+        IDX every = 0;
+
+        /// @brief the simulation time between outputs (0 disables)
+        T time_interval = 0;
+
+        /// @brief the wall clock seconds between outputs (0 disables)
+        double wall_interval = 0.0;
+
+        /// @brief the wall clock seconds the job may run from the construction of the scheduler (0 disables)
+        double walltime = 0.0;
+
+        /// @brief the seconds reserved to write the final checkpoint before the walltime
+        double walltime_margin = 60.0;
+
+        /// @brief the minimum number of steps between outputs
+        IDX min_separation = 0;
+
+        /// @brief the number of outputs between checkpoints (0 only checkpoints at the walltime)
+        IDX checkpoint_every = 0;
+
+        /// @brief restart the wall clock (i.e at the start of the time integration)
+        void reset_clock() { start = clock::now(); }
+
+        /**
+         * @brief set the walltime from the end time (seconds since the epoch) in an environment variable
+         * i.e SLURM_JOB_END_TIME
+         * @return true if the variable was set
+         */
+        auto walltime_from_env(const char* name) -> bool {
+            const char* value = std::getenv(name);
+            if(value == nullptr) return false;
+            double end = std::strtod(value, nullptr);
+            double now = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+            walltime = std::max(end - now, 0.0) + std::chrono::duration<double>(clock::now() - start).count();
+            return end > 0.0;
+        }
+
+        /// @brief the wall clock triggers need the elapsed time
+        [[nodiscard]] auto uses_wall_clock() const noexcept -> bool { return wall_interval > 0.0 || walltime > 0.0; }
+
+        /// @brief the number of outputs written
+        [[nodiscard]] auto outputs() const noexcept -> IDX { return noutput; }
+
+        /**
+         * @brief decide what to write at this step (collective when a wall clock trigger is enabled)
+         * @param itime the time step index
+         * @param time the simulation time
+         * @param wall the elapsed wall clock seconds (defaults to the time since construction)
+         * @return the outputs to write
+         */
+        auto poll(IDX itime, T time, std::optional<double> wall = std::nullopt) -> output_event {
+            double seconds = 0.0;
+            if(uses_wall_clock()) seconds = wall.has_value() ? wall.value() : elapsed();
+
+            // the slowest step so far (for the walltime margin)
+            if(last_poll_step && itime > last_poll_step.value())
+                max_step_seconds = std::max(max_step_seconds, (seconds - last_poll_wall) / (itime - last_poll_step.value()));
+            last_poll_step = itime;
+            last_poll_wall = seconds;
+
+            // the triggers
+            if(every > 0 && itime % every == 0) pending = true;
+            if(time_interval > 0) {
+                if(!next_time) next_time = time;
+                if(time >= next_time.value()) {
+                    pending = true;
+                    while(next_time.value() <= time) next_time = next_time.value() + time_interval;
+                }
+            }
+            if(wall_interval > 0.0 && seconds - last_output_wall >= wall_interval) pending = true;
+
+            output_event event{};
+            if(walltime > 0.0 && !walltime_done
+                    && seconds + walltime_margin + 2.0 * max_step_seconds >= walltime) {
+                event = output_event{.output = true, .checkpoint = true, .walltime = true};
+                walltime_done = true;
+            } else if(pending && (!last_output_step || itime - last_output_step.value() >= min_separation)) {
+                event.output = true;
+            }
+
+            if(event.output) {
+                pending = false;
+                last_output_step = itime;
+                last_output_wall = seconds;
+                ++noutput;
+                if(checkpoint_every > 0 && noutput % checkpoint_every == 0) event.checkpoint = true;
+            }
+            return event;
+        }
+    };
+}
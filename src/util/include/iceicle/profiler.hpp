@@ -0,0 +1,521 @@
+/// @brief hierarchical region timers with optional hardware counters
+/// @author Gianni Absillis (gabsill@ncsu.edu)
+#pragma once
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fmt/format.h>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#ifdef ICEICLE_USE_MPI
+#include <mpi.h>
+#endif
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace iceicle::util {
+
+    /// @brief hooks to read hardware performance counters (i.e PAPI or perf_event)
+    struct counter_hooks {
+        /// @brief the name of each counter
+        std::vector<std::string> names{};
+
+        /// @brief read the current value of each counter (size = names.size())
+        std::function<void(std::uint64_t*)> read{};
+
+        /// @brief release the counters
+        std::function<void()> close{};
+    };
+
+    /// @brief the statistics of a region aggregated over the ranks
+    struct profile_region_stats {
+        /// @brief the region name
+        std::string name;
+
+        /// @brief the names of the enclosing regions and this region separated by '/'
+        std::string path;
+
+        /// @brief the nesting depth (the "total" region is depth 0)
+        int depth;
+
+        /// @brief the number of times the region was entered summed over the ranks
+        std::uint64_t count;
+
+        /// @brief the number of ranks that entered the region
+        int nrank;
+
+        /// @brief the minimum, maximum, and average inclusive time in seconds over the ranks
+        double time_min, time_max, time_avg;
+
+        /// @brief the average time in seconds not spent in nested regions
+        double self_avg;
+
+        /// @brief the counter values summed over the ranks
+        std::vector<std::uint64_t> counters;
+
+        /// @brief the analytic floating point operations and bytes moved (see Profiler::add_work)
+        /// summed over the ranks including the nested regions
+        double flops = 0.0, bytes = 0.0;
+
+        /// @brief the achieved GFLOP/s over all ranks (limited by the slowest rank)
+        [[nodiscard]] auto gflops_per_second() const noexcept -> double
+        { return (time_max > 0.0) ? flops / time_max * 1e-9 : 0.0; }
+
+        /// @brief the achieved GB/s over all ranks (limited by the slowest rank)
+        [[nodiscard]] auto gbytes_per_second() const noexcept -> double
+        { return (time_max > 0.0) ? bytes / time_max * 1e-9 : 0.0; }
+    };
+
+    /**
+     * @brief the region profiler singleton
+     *
+     * Regions are timed with ProfileRegion (or ICEICLE_PROFILE_REGION)
+     * and nest into a tree by the order they are entered.
+     * While the profiler is disabled entering a region is a single flag check.
+     *
+     * Only the thread that called enable() records regions,
+     * regions entered from worker threads are ignored.
+     */
+    class Profiler {
+        using clock = std::chrono::steady_clock;
+
+        /// @brief the maximum number of hardware counters
+        static constexpr std::size_t max_counters = 8;
+
+        struct region {
+            std::string name;
+            int parent;
+            std::vector<int> children{};
+            std::uint64_t count = 0;
+            double seconds = 0.0;
+            std::array<std::uint64_t, max_counters> counters{};
+            double flops = 0.0;
+            double bytes = 0.0;
+        };
+
+        inline static bool active = false;
+        inline static std::thread::id owner{};
+        inline static std::vector<region> regions{};
+        inline static int current = 0;
+        inline static clock::time_point start_time{};
+        inline static counter_hooks hooks{};
+
+        friend class ProfileRegion;
+
+        /// @brief enter the child region of the current region with the given name
+        /// @return the region index or -1 if this thread does not record
+        static auto enter(std::string_view name) -> int {
+            if(!active || std::this_thread::get_id() != owner) return -1;
+            for(int ichild : regions[current].children) {
+                if(regions[ichild].name == name) return current = ichild;
+            }
+            int iregion = regions.size();
+            regions.push_back(region{std::string{name}, current});
+            regions[current].children.push_back(iregion);
+            return current = iregion;
+        }
+
+        /// @brief read the hardware counters (if any) into out
+        static void read_counters(std::uint64_t* out) {
+            if(hooks.read) hooks.read(out);
+        }
+
+        /// @brief leave the region entered at start with the counter values counters_start
+        static void leave(int iregion, clock::time_point start, const std::uint64_t* counters_start) {
+            region& reg = regions[iregion];
+            reg.seconds += std::chrono::duration<double>(clock::now() - start).count();
+            ++reg.count;
+            if(hooks.read) {
+                std::array<std::uint64_t, max_counters> counters_end{};
+                hooks.read(counters_end.data());
+                for(std::size_t i = 0; i < hooks.names.size(); ++i)
+                    reg.counters[i] += counters_end[i] - counters_start[i];
+            }
+            current = reg.parent;
+        }
+
+        /// @brief construct the union of the region trees over all ranks
+        /// @param names the region names of each rank
+        /// @param parents the region parents of each rank
+        /// @param [out] merged the merged tree (only names and parents are set)
+        /// @return the merged index of each region of each rank
+        static auto merge_trees(
+            const std::vector<std::vector<std::string>>& names,
+            const std::vector<std::vector<int>>& parents,
+            std::vector<region>& merged
+        ) -> std::vector<std::vector<int>> {
+            merged.assign(1, region{"total", -1});
+            std::vector<std::vector<int>> merged_index(names.size());
+            for(std::size_t irank = 0; irank < names.size(); ++irank) {
+                merged_index[irank].assign(names[irank].size(), 0);
+                // the parent of a region is always created before it
+                for(std::size_t ireg = 1; ireg < names[irank].size(); ++ireg) {
+                    int parent = merged_index[irank][parents[irank][ireg]];
+                    auto& children = merged[parent].children;
+                    auto it = std::ranges::find(children, std::string_view{names[irank][ireg]},
+                            [&](int ichild){ return std::string_view{merged[ichild].name}; });
+                    if(it != children.end()) {
+                        merged_index[irank][ireg] = *it;
+                    } else {
+                        int inew = merged.size();
+                        merged.push_back(region{names[irank][ireg], parent});
+                        merged[parent].children.push_back(inew);
+                        merged_index[irank][ireg] = inew;
+                    }
+                }
+            }
+            return merged_index;
+        }
+
+        /// @brief escape a string for json output
+        static auto json_escape(std::string_view str) -> std::string {
+            std::string out{};
+            for(char c : str) {
+                if(c == '"' || c == '\\') out.push_back('\\');
+                out.push_back(c);
+            }
+            return out;
+        }
+
+        public:
+
+        /// @brief if regions are being recorded
+        [[nodiscard]] static auto enabled() noexcept -> bool { return active; }
+
+        /// @brief start recording regions on the calling thread (clears any previous data)
+        static void enable() {
+            regions.assign(1, region{"total", -1});
+            current = 0;
+            owner = std::this_thread::get_id();
+            start_time = clock::now();
+            active = true;
+        }
+
+        /// @brief stop recording regions (the recorded data is kept for report())
+        static void disable() { active = false; }
+
+        /**
+         * @brief add analytic work (i.e from the kernel_work models) to the innermost open region
+         * so the report gives the achieved GFLOP/s and GB/s
+         * does nothing unless this thread is recording
+         * @param flops the floating point operations
+         * @param bytes the bytes read and written
+         */
+        static void add_work(double flops, double bytes) {
+            if(!active || std::this_thread::get_id() != owner) return;
+            regions[current].flops += flops;
+            regions[current].bytes += bytes;
+        }
+
+        /**
+         * @brief set the hardware counters to record for each region
+         * at most 8 counters are recorded, the rest are ignored
+         * @param new_hooks the counter hooks (i.e from perf_counter_hooks() or a PAPI event set)
+         */
+        static void set_counter_hooks(counter_hooks new_hooks) {
+            if(hooks.close) hooks.close();
+            hooks = std::move(new_hooks);
+            if(hooks.names.size() > max_counters) hooks.names.resize(max_counters);
+        }
+
+        /**
+         * @brief aggregate the region statistics over the ranks
+         * collective over MPI_COMM_WORLD when MPI is initialized
+         * @return the statistics of each region in tree order (only complete on rank 0)
+         */
+        static auto aggregate() -> std::vector<profile_region_stats> {
+            if(regions.empty()) return {};
+            // the root spans the whole recording
+            regions[0].seconds = std::chrono::duration<double>(clock::now() - start_time).count();
+            regions[0].count = 1;
+            std::size_t ncounter = hooks.names.size();
+
+            std::vector<std::vector<std::string>> names(1);
+            std::vector<std::vector<int>> parents(1);
+            for(const region& reg : regions) {
+                names[0].push_back(reg.name);
+                parents[0].push_back(reg.parent);
+            }
+            int myrank = 0, nrank = 1;
+#ifdef ICEICLE_USE_MPI
+            if(mpi::mpi_initialized()) {
+                MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
+                MPI_Comm_size(MPI_COMM_WORLD, &nrank);
+            }
+            if(nrank > 1) {
+                // share the region trees as newline separated names and the parent indices
+                std::string local_names{};
+                for(const region& reg : regions) { local_names += reg.name; local_names.push_back('\n'); }
+                int nreg = regions.size(), nchar = local_names.size();
+                std::vector<int> nregs(nrank), nchars(nrank);
+                MPI_Allgather(&nreg, 1, MPI_INT, nregs.data(), 1, MPI_INT, MPI_COMM_WORLD);
+                MPI_Allgather(&nchar, 1, MPI_INT, nchars.data(), 1, MPI_INT, MPI_COMM_WORLD);
+                std::vector<int> reg_displs(nrank + 1, 0), char_displs(nrank + 1, 0);
+                for(int irank = 0; irank < nrank; ++irank) {
+                    reg_displs[irank + 1] = reg_displs[irank] + nregs[irank];
+                    char_displs[irank + 1] = char_displs[irank] + nchars[irank];
+                }
+                std::vector<int> all_parents(reg_displs[nrank]);
+                std::vector<char> all_names(char_displs[nrank]);
+                MPI_Allgatherv(parents[0].data(), nreg, MPI_INT, all_parents.data(),
+                        nregs.data(), reg_displs.data(), MPI_INT, MPI_COMM_WORLD);
+                MPI_Allgatherv(local_names.data(), nchar, MPI_CHAR, all_names.data(),
+                        nchars.data(), char_displs.data(), MPI_CHAR, MPI_COMM_WORLD);
+                names.assign(nrank, {});
+                parents.assign(nrank, {});
+                for(int irank = 0; irank < nrank; ++irank) {
+                    parents[irank].assign(all_parents.begin() + reg_displs[irank],
+                            all_parents.begin() + reg_displs[irank + 1]);
+                    std::string name{};
+                    for(int ichar = char_displs[irank]; ichar < char_displs[irank + 1]; ++ichar) {
+                        if(all_names[ichar] == '\n') { names[irank].push_back(name); name.clear(); }
+                        else name.push_back(all_names[ichar]);
+                    }
+                }
+            }
+#endif
+            std::vector<region> merged{};
+            std::vector<int> local_index = merge_trees(names, parents, merged)[myrank];
+            std::size_t nmerged = merged.size();
+
+            // this rank's values in the merged tree
+            std::vector<double> tmin(nmerged, std::numeric_limits<double>::max());
+            std::vector<double> tmax(nmerged, 0.0), tsum(nmerged, 0.0), self_sum(nmerged, 0.0);
+            std::vector<double> flops(nmerged, 0.0), bytes(nmerged, 0.0);
+            std::vector<std::uint64_t> count(nmerged, 0), counters(nmerged * std::max(ncounter, (std::size_t) 1), 0);
+            std::vector<int> present(nmerged, 0);
+            for(std::size_t ireg = 0; ireg < regions.size(); ++ireg) {
+                const region& reg = regions[ireg];
+                int imerged = local_index[ireg];
+                double self = reg.seconds;
+                for(int ichild : reg.children) self -= regions[ichild].seconds;
+                tmin[imerged] = tmax[imerged] = tsum[imerged] = reg.seconds;
+                self_sum[imerged] = self;
+                count[imerged] = reg.count;
+                flops[imerged] = reg.flops;
+                bytes[imerged] = reg.bytes;
+                present[imerged] = 1;
+                for(std::size_t ic = 0; ic < ncounter; ++ic) counters[imerged * ncounter + ic] = reg.counters[ic];
+            }
+#ifdef ICEICLE_USE_MPI
+            if(nrank > 1) {
+                auto reduce = [&](auto& values, MPI_Datatype type, MPI_Op op) {
+                    auto result = values;
+                    MPI_Reduce(values.data(), result.data(), values.size(), type, op, 0, MPI_COMM_WORLD);
+                    values = std::move(result);
+                };
+                reduce(tmin, MPI_DOUBLE, MPI_MIN);
+                reduce(tmax, MPI_DOUBLE, MPI_MAX);
+                reduce(tsum, MPI_DOUBLE, MPI_SUM);
+                reduce(self_sum, MPI_DOUBLE, MPI_SUM);
+                reduce(count, MPI_UINT64_T, MPI_SUM);
+                reduce(present, MPI_INT, MPI_SUM);
+                reduce(counters, MPI_UINT64_T, MPI_SUM);
+                reduce(flops, MPI_DOUBLE, MPI_SUM);
+                reduce(bytes, MPI_DOUBLE, MPI_SUM);
+            }
+#endif
+            // the work is inclusive like the times (parents always precede their children)
+            for(std::size_t ireg = nmerged - 1; ireg > 0; --ireg) {
+                flops[merged[ireg].parent] += flops[ireg];
+                bytes[merged[ireg].parent] += bytes[ireg];
+            }
+            // flatten the merged tree depth first
+            std::vector<profile_region_stats> stats{};
+            auto visit = [&](auto&& visit, int ireg, int depth, const std::string& parent_path) -> void {
+                const region& reg = merged[ireg];
+                std::string path = (parent_path.empty()) ? reg.name : parent_path + "/" + reg.name;
+                int nrank_present = std::max(present[ireg], 1);
+                stats.push_back(profile_region_stats{
+                    .name = reg.name,
+                    .path = path,
+                    .depth = depth,
+                    .count = count[ireg],
+                    .nrank = present[ireg],
+                    .time_min = (present[ireg] > 0) ? tmin[ireg] : 0.0,
+                    .time_max = tmax[ireg],
+                    .time_avg = tsum[ireg] / nrank_present,
+                    .self_avg = self_sum[ireg] / nrank_present,
+                    .counters = std::vector<std::uint64_t>(counters.begin() + ireg * ncounter,
+                            counters.begin() + (ireg + 1) * ncounter),
+                    .flops = flops[ireg],
+                    .bytes = bytes[ireg]
+                });
+                for(int ichild : reg.children) visit(visit, ichild, depth + 1, path);
+            };
+            visit(visit, 0, 0, "");
+            return stats;
+        }
+
+        /// @brief write the region statistics as json
+        static void write_json(std::ostream& out, const std::vector<profile_region_stats>& stats) {
+            out << "{\n  \"nrank\": " << mpi::mpi_world_size() << ",\n  \"counters\": [";
+            for(std::size_t ic = 0; ic < hooks.names.size(); ++ic)
+                out << ((ic > 0) ? ", " : "") << "\"" << json_escape(hooks.names[ic]) << "\"";
+            out << "],\n  \"regions\": [";
+            for(std::size_t ireg = 0; ireg < stats.size(); ++ireg) {
+                const profile_region_stats& s = stats[ireg];
+                out << ((ireg > 0) ? "," : "") << "\n    {"
+                    << fmt::format("\"name\": \"{}\", \"path\": \"{}\", \"depth\": {}, \"count\": {}, "
+                            "\"nrank\": {}, \"time_min\": {}, \"time_max\": {}, \"time_avg\": {}, \"self_avg\": {}",
+                            json_escape(s.name), json_escape(s.path), s.depth, s.count, s.nrank,
+                            s.time_min, s.time_max, s.time_avg, s.self_avg)
+                    << ", \"counters\": [";
+                for(std::size_t ic = 0; ic < s.counters.size(); ++ic)
+                    out << ((ic > 0) ? ", " : "") << s.counters[ic];
+                out << fmt::format("], \"flops\": {}, \"bytes\": {}}}", s.flops, s.bytes);
+            }
+            out << "\n  ]\n}\n";
+        }
+
+        /// @brief write the region statistics as a human readable table
+        static void write_summary(std::ostream& out, const std::vector<profile_region_stats>& stats) {
+            if(stats.empty()) return;
+            double total = std::max(stats[0].time_avg, std::numeric_limits<double>::min());
+            std::size_t name_width = 6;
+            for(const profile_region_stats& s : stats)
+                name_width = std::max(name_width, 2 * s.depth + s.name.size());
+            // the achieved rates are only shown if any work was recorded
+            bool have_work = std::ranges::any_of(stats,
+                    [](const profile_region_stats& s){ return s.flops > 0.0 || s.bytes > 0.0; });
+            out << fmt::format("{:<{}}  {:>10}  {:>12}  {:>12}  {:>12}  {:>12}  {:>6}",
+                    "Region", name_width, "Calls", "Avg (s)", "Min (s)", "Max (s)", "Self (s)", "%");
+            for(const std::string& name : hooks.names) out << fmt::format("  {:>14}", name);
+            if(have_work) out << fmt::format("  {:>10}  {:>10}", "GFLOP/s", "GB/s");
+            out << "\n" << std::string(name_width + 82 + 16 * hooks.names.size() + 24 * have_work, '-') << "\n";
+            for(const profile_region_stats& s : stats) {
+                out << fmt::format("{:<{}}  {:>10}  {:>12.6f}  {:>12.6f}  {:>12.6f}  {:>12.6f}  {:>6.2f}",
+                        std::string(2 * s.depth, ' ') + s.name, name_width, s.count,
+                        s.time_avg, s.time_min, s.time_max, s.self_avg, 100.0 * s.time_avg / total);
+                for(std::uint64_t c : s.counters) out << fmt::format("  {:>14}", c);
+                if(have_work) {
+                    if(s.flops > 0.0 || s.bytes > 0.0)
+                        out << fmt::format("  {:>10.3f}  {:>10.3f}", s.gflops_per_second(), s.gbytes_per_second());
+                    else out << fmt::format("  {:>10}  {:>10}", "", "");
+                }
+                out << "\n";
+            }
+        }
+
+        /**
+         * @brief aggregate the statistics and output them on rank 0
+         * does nothing if the profiler was never enabled
+         * collective over MPI_COMM_WORLD when MPI is initialized
+         *
+         * @param out the stream to write the summary table to
+         * @param json_filename the file to write the json statistics to (empty for none)
+         */
+        static void report(std::ostream& out, std::string_view json_filename = "") {
+            if(regions.empty()) return;
+            active = false;
+            std::vector<profile_region_stats> stats = aggregate();
+            if(mpi::mpi_world_rank() == 0) {
+                write_summary(out, stats);
+                if(!json_filename.empty()) {
+                    std::ofstream json_out{std::string{json_filename}};
+                    write_json(json_out, stats);
+                }
+            }
+        }
+    };
+
+    /**
+     * @brief time the enclosing scope as a region of the Profiler
+     * nested regions are the children of the innermost enclosing region
+     */
+    class ProfileRegion {
+        int iregion;
+        Profiler::clock::time_point start{};
+        std::array<std::uint64_t, Profiler::max_counters> counters_start{};
+
+        public:
+
+        /// @param name the region name (should not contain '/')
+        explicit ProfileRegion(std::string_view name) : iregion{Profiler::enter(name)} {
+            if(iregion >= 0) {
+                Profiler::read_counters(counters_start.data());
+                start = Profiler::clock::now();
+            }
+        }
+
+        ProfileRegion(const ProfileRegion&) = delete;
+        ProfileRegion& operator=(const ProfileRegion&) = delete;
+
+        ~ProfileRegion() {
+            if(iregion >= 0) Profiler::leave(iregion, start, counters_start.data());
+        }
+    };
+
+    /**
+     * @brief open the cycle and instruction counters of the calling thread with perf_event
+     * @return the counter hooks or an empty set of hooks if perf_event is unavailable
+     * (i.e restricted by perf_event_paranoid)
+     */
+    inline auto perf_counter_hooks() -> counter_hooks {
+#ifdef __linux__
+        auto open_counter = [](std::uint64_t config, int group_fd) -> int {
+            perf_event_attr attr{};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(perf_event_attr);
+            attr.config = config;
+            attr.disabled = (group_fd == -1);
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            return syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+        };
+        int leader = open_counter(PERF_COUNT_HW_CPU_CYCLES, -1);
+        if(leader < 0) return counter_hooks{};
+        int instructions = open_counter(PERF_COUNT_HW_INSTRUCTIONS, leader);
+        if(instructions < 0) { ::close(leader); return counter_hooks{}; }
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        return counter_hooks{
+            .names = {"cycles", "instructions"},
+            .read = [leader](std::uint64_t* out) {
+                // group read format: the number of counters followed by each value
+                std::array<std::uint64_t, 3> values{};
+                if(::read(leader, values.data(), sizeof(values)) == (ssize_t) sizeof(values)) {
+                    out[0] = values[1];
+                    out[1] = values[2];
+                }
+            },
+            .close = [leader, instructions]() { ::close(instructions); ::close(leader); }
+        };
+#else
+        return counter_hooks{};
+#endif
+    }
+}
+
+#define ICEICLE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ICEICLE_PROFILE_CONCAT(a, b) ICEICLE_PROFILE_CONCAT_IMPL(a, b)
+
+/// @brief time the enclosing scope as a profiler region with the given name
+/// compiles to nothing unless built with ICEICLE_USE_PROFILER
+#ifdef ICEICLE_USE_PROFILER
+#define ICEICLE_PROFILE_REGION(name) \
+    ::iceicle::util::ProfileRegion ICEICLE_PROFILE_CONCAT(iceicle_profile_region_, __LINE__){name}
+#else
+#define ICEICLE_PROFILE_REGION(name)
+#endif
+
+/// @brief add analytic work to the innermost profiler region (see Profiler::add_work)
+/// compiles to nothing unless built with ICEICLE_USE_PROFILER
+#ifdef ICEICLE_USE_PROFILER
+#define ICEICLE_PROFILE_WORK(flops, bytes) ::iceicle::util::Profiler::add_work(flops, bytes)
+#else
+#define ICEICLE_PROFILE_WORK(flops, bytes)
+#endif
@@ -0,0 +1,375 @@
+/**
+ * @brief floating point sums that do not depend on the order of the additions
+ * (the number of threads, the thread schedule, or the number of processes)
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/iceicle_mpi_utils.hpp"
+#include <array>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
+
+#ifdef ICEICLE_USE_MPI
+#include <mpi.h>
+#endif
+
+namespace iceicle::util {
+
+    /// @brief floating point types that ReproducibleSum can accumulate exactly
+    /// (the significand fits in the 64 bit splitting and the exponent range is at most that of double)
+    template<class T>
+    concept reproducible_sum_type = std::floating_point<T>
+        && std::numeric_limits<T>::digits <= 53
+        && std::numeric_limits<T>::max_exponent <= 1024;
+
+    /**
+     * @brief an exact accumulator for the sum of floating point values
+     *
+     * Every value is added exactly into a fixed point representation of the whole exponent range
+     * (32 bit limbs held in 64 bit integers, a superaccumulator)
+     * so the sum is identical for any order of additions and any grouping of partial sums.
+     * value() rounds the exact sum once.
+     *
+     * An addition splits the significand into three limbs with integer operations,
+     * partial sums are combined limb by limb and reduced over processes with an integer MPI_SUM
+     * (see mpi::allreduce_sums(std::span<ReproducibleSum<T>>)).
+     *
+     * Infinities and NaNs are counted so they propagate the same way as in a floating point sum.
+     *
+     * @tparam T the floating point type
+     */
+    template<reproducible_sum_type T>
+    class ReproducibleSum {
+        public:
+
+        /// @brief the number of bits in each limb
+        static constexpr int limb_bits = 32;
+
+        /// @brief the position of the lowest bit of limb 0
+        /// (below the lowest bit of the smallest subnormal significand)
+        static constexpr int pmin = ((std::numeric_limits<T>::min_exponent - 2 * std::numeric_limits<T>::digits)
+                / limb_bits - 1) * limb_bits;
+
+        /// @brief the number of limbs (headroom above the largest value for sums that overflow T)
+        static constexpr int nlimb = (std::numeric_limits<T>::max_exponent + 2 * limb_bits - pmin) / limb_bits + 1;
+
+        /// @brief the slots after the limbs: the number of +inf, -inf, and NaN values, and the additions since normalize()
+        static constexpr int ipos_inf = nlimb, ineg_inf = nlimb + 1, inan = nlimb + 2, inadd = nlimb + 3;
+
+        /// @brief the total number of slots
+        static constexpr int nslot = nlimb + 4;
+
+        /// @brief the additions before the limbs are normalized
+        /// each addition adds less than 2^32 to a limb so this keeps the limbs far from overflow
+        static constexpr std::int64_t max_add = std::int64_t{1} << 30;
+
+        /// @brief the limbs followed by the special value counts
+        /// integers so partial sums add exactly
+        std::array<std::int64_t, nslot> slots{};
+
+        ReproducibleSum() = default;
+
+        /// @brief start the sum from a value
+        explicit ReproducibleSum(T x) { add(x); }
+
+        /// @brief reset the sum to zero
+        void reset() noexcept { slots.fill(0); }
+
+        /// @brief add a value to the sum (exactly)
+        void add(T x) noexcept {
+            if(!std::isfinite(x)) {
+                if(std::isnan(x)) ++slots[inan];
+                else if(x > 0) ++slots[ipos_inf];
+                else ++slots[ineg_inf];
+                return;
+            }
+            if(x == 0) return;
+
+            // x = sign * M * 2^p with the integer significand M
+            std::int64_t sign;
+            std::uint64_t a;
+            int p;
+            if constexpr (std::numeric_limits<T>::is_iec559 && (sizeof(T) == 8 || sizeof(T) == 4)) {
+                // read the fields directly
+                using bits_t = std::conditional_t<sizeof(T) == 8, std::uint64_t, std::uint32_t>;
+                constexpr int mant_bits = std::numeric_limits<T>::digits - 1;
+                constexpr int bias = std::numeric_limits<T>::max_exponent - 1;
+                bits_t bits = std::bit_cast<bits_t>(x);
+                sign = (bits >> (8 * sizeof(T) - 1)) ? -1 : 1;
+                int biased_exp = static_cast<int>((bits >> mant_bits) & ((bits_t{1} << (8 * sizeof(T) - 1 - mant_bits)) - 1));
+                a = bits & ((bits_t{1} << mant_bits) - 1);
+                if(biased_exp == 0) { // subnormal
+                    p = 1 - bias - mant_bits;
+                } else {
+                    a |= std::uint64_t{1} << mant_bits;
+                    p = biased_exp - bias - mant_bits;
+                }
+            } else {
+                int e;
+                T f = std::frexp(x, &e);
+                sign = (f < 0) ? -1 : 1;
+                a = static_cast<std::uint64_t>(std::ldexp(std::abs(f), std::numeric_limits<T>::digits));
+                p = e - std::numeric_limits<T>::digits;
+            }
+
+            // split M into the limbs that p falls on
+            int k0 = (p - pmin) / limb_bits;
+            int r = (p - pmin) - k0 * limb_bits;
+            constexpr std::uint64_t mask = (std::uint64_t{1} << limb_bits) - 1;
+            std::uint64_t c0 = (a & ((std::uint64_t{1} << (limb_bits - r)) - 1)) << r;
+            a >>= (limb_bits - r);
+            std::uint64_t c1 = a & mask;
+            std::uint64_t c2 = a >> limb_bits;
+            slots[k0] += sign * static_cast<std::int64_t>(c0);
+            slots[k0 + 1] += sign * static_cast<std::int64_t>(c1);
+            slots[k0 + 2] += sign * static_cast<std::int64_t>(c2);
+
+            if(++slots[inadd] >= max_add) normalize();
+        }
+
+        auto operator+=(T x) noexcept -> ReproducibleSum& {
+            add(x);
+            return *this;
+        }
+
+        auto operator-=(T x) noexcept -> ReproducibleSum& {
+            add(-x);
+            return *this;
+        }
+
+        /// @brief add another (partial) sum
+        auto operator+=(const ReproducibleSum& other) noexcept -> ReproducibleSum& {
+            normalize();
+            ReproducibleSum b = other;
+            b.normalize();
+            for(int islot = 0; islot < nslot; ++islot) slots[islot] += b.slots[islot];
+            return *this;
+        }
+
+        /// @brief carry between the limbs so all but the top limb are in [0, 2^32)
+        /// (does not change the value)
+        void normalize() noexcept {
+            for(int k = 0; k < nlimb - 1; ++k){
+                // arithmetic shift: floor division by 2^32
+                std::int64_t carry = slots[k] >> limb_bits;
+                slots[k] -= carry * (std::int64_t{1} << limb_bits);
+                slots[k + 1] += carry;
+            }
+            slots[inadd] = 0;
+        }
+
+        /// @brief the sum rounded to T
+        /// (a function of the exact sum only so it is reproducible)
+        [[nodiscard]] auto value() const noexcept -> T {
+            if(slots[inan] > 0 || (slots[ipos_inf] > 0 && slots[ineg_inf] > 0))
+                return std::numeric_limits<T>::quiet_NaN();
+            if(slots[ipos_inf] > 0) return std::numeric_limits<T>::infinity();
+            if(slots[ineg_inf] > 0) return -std::numeric_limits<T>::infinity();
+
+            ReproducibleSum norm = *this;
+            norm.normalize();
+
+            // a negative sum has the sign in the top limb (the lower limbs are non-negative)
+            // so convert the magnitude to avoid overflowing the top limbs
+            bool negative = norm.slots[nlimb - 1] < 0;
+            if(negative){
+                for(int k = 0; k < nlimb; ++k) norm.slots[k] = -norm.slots[k];
+                norm.normalize();
+            }
+
+            // from the most significant limb down with compensation
+            // in a type where each limb times its scale is exact
+            using acc_t = std::conditional_t<(std::numeric_limits<T>::digits < 53), double, T>;
+            acc_t sum = 0, comp = 0;
+            for(int k = nlimb - 1; k >= 0; --k){
+                if(norm.slots[k] == 0) continue;
+                acc_t term = std::ldexp(static_cast<acc_t>(norm.slots[k]), pmin + k * limb_bits);
+                acc_t t = sum + term;
+                if(std::abs(sum) >= std::abs(term)) comp += (sum - t) + term;
+                else comp += (term - t) + sum;
+                sum = t;
+            }
+            return static_cast<T>(negative ? -(sum + comp) : sum + comp);
+        }
+    };
+
+    /**
+     * @brief an ordinary floating point sum with the interface of ReproducibleSum
+     * (types ReproducibleSum can not represent, or reproducible reductions turned off)
+     * @tparam T the floating point type
+     */
+    template<class T>
+    class PlainSum {
+        public:
+        T sum = 0;
+
+        PlainSum() = default;
+        explicit PlainSum(T x) : sum{x} {}
+
+        void reset() noexcept { sum = 0; }
+        void add(T x) noexcept { sum += x; }
+
+        auto operator+=(T x) noexcept -> PlainSum& {
+            sum += x;
+            return *this;
+        }
+
+        auto operator-=(T x) noexcept -> PlainSum& {
+            sum -= x;
+            return *this;
+        }
+
+        auto operator+=(const PlainSum& other) noexcept -> PlainSum& {
+            sum += other.sum;
+            return *this;
+        }
+
+        [[nodiscard]] auto value() const noexcept -> T { return sum; }
+    };
+
+    /**
+     * @brief the accumulator for reductions of norms, errors, and functionals
+     * ReproducibleSum unless reproducible reductions are turned off
+     * (ICEICLE_REPRODUCIBLE_REDUCTIONS=OFF) or T has a wider range than double
+     */
+#ifndef ICEICLE_DISABLE_REPRODUCIBLE_REDUCTIONS
+    template<class T>
+    using reduction_sum = std::conditional_t<reproducible_sum_type<T>, ReproducibleSum<T>, PlainSum<T>>;
+#else
+    template<class T>
+    using reduction_sum = PlainSum<T>;
+#endif
+}
+
+namespace iceicle::mpi {
+
+    /**
+     * @brief sum accumulators over all ranks in place
+     * the result is the same on every rank and does not depend on the number of ranks
+     * @param sums the accumulators (reduced element-wise)
+     */
+    template<class T>
+    inline
+    auto allreduce_sums(std::span<util::ReproducibleSum<T>> sums) -> void
+    {
+#ifdef ICEICLE_USE_MPI
+        if(!mpi_initialized()) return;
+        for(auto& acc : sums) acc.normalize();
+        static_assert(sizeof(util::ReproducibleSum<T>) == util::ReproducibleSum<T>::nslot * sizeof(std::int64_t));
+        MPI_Allreduce(MPI_IN_PLACE, reinterpret_cast<std::int64_t*>(sums.data()),
+                (int) (sums.size() * util::ReproducibleSum<T>::nslot), MPI_INT64_T, MPI_SUM, MPI_COMM_WORLD);
+#endif
+    }
+
+    /// @brief sum accumulators over all ranks in place
+    template<class T>
+    inline
+    auto allreduce_sums(std::span<util::PlainSum<T>> sums) -> void
+    {
+#ifdef ICEICLE_USE_MPI
+        if(!mpi_initialized()) return;
+        static_assert(sizeof(util::PlainSum<T>) == sizeof(T));
+        MPI_Allreduce(MPI_IN_PLACE, reinterpret_cast<T*>(sums.data()),
+                (int) sums.size(), mpi_get_type<T>(), MPI_SUM, MPI_COMM_WORLD);
+#endif
+    }
+
+#ifdef ICEICLE_USE_MPI
+    /**
+     * @brief start summing accumulators over the ranks of a communicator in place
+     * the accumulators must not be accessed until the request is waited on
+     * @param sums the accumulators (reduced element-wise)
+     * @param comm the communicator to reduce over
+     * @return the request to wait on
+     */
+    template<class T>
+    inline
+    auto iallreduce_sums(std::span<util::ReproducibleSum<T>> sums, MPI_Comm comm) -> reduction_request
+    {
+        reduction_request req{};
+        if(!mpi_initialized()) return req;
+        for(auto& acc : sums) acc.normalize();
+        MPI_Iallreduce(MPI_IN_PLACE, reinterpret_cast<std::int64_t*>(sums.data()),
+                (int) (sums.size() * util::ReproducibleSum<T>::nslot), MPI_INT64_T, MPI_SUM,
+                comm, &req.request);
+        return req;
+    }
+
+    /// @brief start summing accumulators over the ranks of a communicator in place
+    template<class T>
+    inline
+    auto iallreduce_sums(std::span<util::PlainSum<T>> sums, MPI_Comm comm) -> reduction_request
+    {
+        reduction_request req{};
+        if(!mpi_initialized()) return req;
+        MPI_Iallreduce(MPI_IN_PLACE, reinterpret_cast<T*>(sums.data()),
+                (int) sums.size(), mpi_get_type<T>(), MPI_SUM, comm, &req.request);
+        return req;
+    }
+
+    /// @brief start taking the maximum of values over the ranks of a communicator in place
+    template<class T>
+    inline
+    auto iallreduce_max(std::span<T> data, MPI_Comm comm) -> reduction_request
+    {
+        reduction_request req{};
+        if(!mpi_initialized()) return req;
+        MPI_Iallreduce(MPI_IN_PLACE, data.data(), (int) data.size(), mpi_get_type<T>(), MPI_MAX,
+                comm, &req.request);
+        return req;
+    }
+#endif
+
+    /**
+     * @brief start summing accumulators over all ranks in place
+     * the accumulators must not be accessed until the request is waited on
+     * @param sums the accumulators (reduced element-wise)
+     * @return the request to wait on
+     */
+    template<class T>
+    inline
+    auto iallreduce_sums(std::span<util::ReproducibleSum<T>> sums) -> reduction_request
+    {
+#ifdef ICEICLE_USE_MPI
+        return iallreduce_sums(sums, MPI_COMM_WORLD);
+#else
+        return reduction_request{};
+#endif
+    }
+
+    /// @brief start summing accumulators over all ranks in place
+    template<class T>
+    inline
+    auto iallreduce_sums(std::span<util::PlainSum<T>> sums) -> reduction_request
+    {
+#ifdef ICEICLE_USE_MPI
+        return iallreduce_sums(sums, MPI_COMM_WORLD);
+#else
+        return reduction_request{};
+#endif
+    }
+
+    /**
+     * @brief start taking the maximum of values over all ranks in place
+     * (maxima are already independent of the order)
+     * @param data the values (reduced element-wise)
+     * @return the request to wait on
+     */
+    template<class T>
+    inline
+    auto iallreduce_max(std::span<T> data) -> reduction_request
+    {
+#ifdef ICEICLE_USE_MPI
+        return iallreduce_max(data, MPI_COMM_WORLD);
+#else
+        return reduction_request{};
+#endif
+    }
+}
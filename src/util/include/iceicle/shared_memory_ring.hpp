@@ -0,0 +1,259 @@
+/**
+ * @brief a single writer ring of frames in POSIX shared memory
+ * for publishing data from a running process to readers in other processes
+ *
+ * The writer never waits on readers: each slot is guarded by a sequence lock
+ * and readers retry when the writer overwrites the slot during a read.
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include "iceicle/anomaly_log.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace iceicle::util {
+
+    /**
+     * @brief a ring of nslot frames of at most slot_bytes each in a named shared memory segment
+     *
+     * Layout of the segment:
+     * [ring header][slot header 0][slot data 0][slot header 1][slot data 1]...
+     * Frame i is written to slot i % nslot.
+     * The sequence of a slot is odd while the writer is in the slot
+     * and 2 * (frame index + 1) once the frame is complete
+     */
+    class shared_memory_ring {
+        public:
+
+        /// @brief identifies an iceicle ring segment
+        static constexpr std::uint64_t magic = 0x474e4952454c4349; // "ICELRING"
+
+        /// @brief the layout version of the segment
+        static constexpr std::uint32_t version = 1;
+
+        private:
+
+        struct ring_header {
+            std::uint64_t magic;
+            std::uint32_t version;
+            std::uint32_t nslot;
+            std::uint64_t slot_bytes;
+
+            /// @brief the number of frames published
+            std::atomic<std::uint64_t> nframe;
+
+            /// @brief set when the writer closes the ring (readers should reattach)
+            std::atomic<std::uint32_t> closed;
+        };
+
+        struct alignas(64) slot_header {
+            std::atomic<std::uint64_t> seq;
+            std::uint64_t nbytes;
+        };
+
+        static constexpr std::size_t header_bytes = (sizeof(ring_header) + 63) / 64 * 64;
+
+        std::string _name{};
+        void* _map = nullptr;
+        std::size_t _map_bytes = 0;
+        bool _owner = false;
+
+        /// @brief the index of the last frame read + 1
+        std::uint64_t _nread = 0;
+
+        shared_memory_ring(std::string name, void* map, std::size_t map_bytes, bool owner)
+        : _name{std::move(name)}, _map{map}, _map_bytes{map_bytes}, _owner{owner} {}
+
+        [[nodiscard]] auto header() const noexcept -> ring_header*
+        { return static_cast<ring_header*>(_map); }
+
+        [[nodiscard]] auto slot(std::uint64_t islot) const noexcept -> slot_header* {
+            std::size_t stride = (sizeof(slot_header) + header()->slot_bytes + 63) / 64 * 64;
+            return reinterpret_cast<slot_header*>(static_cast<std::byte*>(_map) + header_bytes + islot * stride);
+        }
+
+        [[nodiscard]] static auto slot_data(slot_header* s) noexcept -> std::byte*
+        { return reinterpret_cast<std::byte*>(s + 1); }
+
+        [[nodiscard]] static auto segment_bytes(std::uint32_t nslot, std::uint64_t slot_bytes) noexcept -> std::size_t {
+            std::size_t stride = (sizeof(slot_header) + slot_bytes + 63) / 64 * 64;
+            return header_bytes + nslot * stride;
+        }
+
+        public:
+
+        /**
+         * @brief create (or replace) the named ring as the writer
+         * @param name the shared memory name (i.e "/iceicle_solution")
+         * @param slot_bytes the largest frame in bytes
+         * @param nslot the number of frames kept (at least 2 so readers rarely have to retry)
+         * @return the ring or nullopt (with an anomaly logged) if shared memory is unavailable
+         */
+        static auto create(std::string name, std::size_t slot_bytes, std::uint32_t nslot = 3)
+        -> std::optional<shared_memory_ring> {
+#if __has_include(<sys/mman.h>)
+            nslot = std::max(nslot, 1u);
+            std::size_t nbytes = segment_bytes(nslot, slot_bytes);
+            ::shm_unlink(name.c_str());
+            int fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR | O_EXCL, 0644);
+            if(fd < 0 || ::ftruncate(fd, nbytes) != 0){
+                if(fd >= 0) ::close(fd);
+                AnomalyLog::log_anomaly(Anomaly{"Could not create shared memory " + name, general_anomaly_tag{}});
+                return std::nullopt;
+            }
+            void* map = ::mmap(nullptr, nbytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if(map == MAP_FAILED){
+                ::shm_unlink(name.c_str());
+                AnomalyLog::log_anomaly(Anomaly{"Could not map shared memory " + name, general_anomaly_tag{}});
+                return std::nullopt;
+            }
+
+            // every slot sequence starts at 0 (empty)
+            new (map) ring_header{magic, version, nslot, slot_bytes, {0}, {0}};
+            std::size_t stride = (sizeof(slot_header) + slot_bytes + 63) / 64 * 64;
+            for(std::uint32_t islot = 0; islot < nslot; ++islot)
+                { new (static_cast<std::byte*>(map) + header_bytes + islot * stride) slot_header{{0}, 0}; }
+            std::atomic_thread_fence(std::memory_order_release);
+            return shared_memory_ring{std::move(name), map, nbytes, true};
+#else
+            AnomalyLog::log_anomaly(Anomaly{"shared memory is not available on this platform", general_anomaly_tag{}});
+            return std::nullopt;
+#endif
+        }
+
+        /**
+         * @brief attach to the named ring as a reader
+         * @param name the shared memory name given to create
+         * @return the ring or nullopt if there is no valid ring with this name (no anomaly logged,
+         * the writer may not have started yet)
+         */
+        static auto attach(std::string name) -> std::optional<shared_memory_ring> {
+#if __has_include(<sys/mman.h>)
+            int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+            if(fd < 0) return std::nullopt;
+            struct stat st;
+            if(::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < header_bytes){
+                ::close(fd);
+                return std::nullopt;
+            }
+            std::size_t nbytes = st.st_size;
+            void* map = ::mmap(nullptr, nbytes, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if(map == MAP_FAILED) return std::nullopt;
+            const ring_header* h = static_cast<const ring_header*>(map);
+            if(h->magic != magic || h->version != version || segment_bytes(h->nslot, h->slot_bytes) > nbytes){
+                ::munmap(map, nbytes);
+                return std::nullopt;
+            }
+            return shared_memory_ring{std::move(name), map, nbytes, false};
+#else
+            return std::nullopt;
+#endif
+        }
+
+        shared_memory_ring(const shared_memory_ring&) = delete;
+        shared_memory_ring& operator=(const shared_memory_ring&) = delete;
+
+        shared_memory_ring(shared_memory_ring&& other) noexcept
+        : _name{std::move(other._name)}, _map{std::exchange(other._map, nullptr)},
+          _map_bytes{std::exchange(other._map_bytes, 0)}, _owner{std::exchange(other._owner, false)},
+          _nread{other._nread} {}
+
+        shared_memory_ring& operator=(shared_memory_ring&& other) noexcept {
+            std::swap(_name, other._name);
+            std::swap(_map, other._map);
+            std::swap(_map_bytes, other._map_bytes);
+            std::swap(_owner, other._owner);
+            std::swap(_nread, other._nread);
+            return *this;
+        }
+
+        /// @brief the writer marks the ring closed and removes the name
+        ~shared_memory_ring() {
+#if __has_include(<sys/mman.h>)
+            if(_map == nullptr) return;
+            if(_owner){
+                header()->closed.store(1, std::memory_order_release);
+                ::shm_unlink(_name.c_str());
+            }
+            ::munmap(_map, _map_bytes);
+#endif
+        }
+
+        /// @brief the largest frame in bytes
+        [[nodiscard]] auto slot_bytes() const noexcept -> std::size_t { return header()->slot_bytes; }
+
+        /// @brief the number of frames published so far
+        [[nodiscard]] auto nframe() const noexcept -> std::uint64_t
+        { return header()->nframe.load(std::memory_order_acquire); }
+
+        /// @brief true if the writer closed the ring (a new ring may be under the same name)
+        [[nodiscard]] auto closed() const noexcept -> bool
+        { return header()->closed.load(std::memory_order_acquire) != 0; }
+
+        /**
+         * @brief publish a frame (writer only)
+         * @param frame the bytes of the frame
+         * @return false if the frame does not fit in a slot
+         */
+        auto publish(std::span<const std::byte> frame) -> bool {
+            if(!_owner || frame.size() > slot_bytes()) return false;
+            ring_header* h = header();
+            std::uint64_t iframe = h->nframe.load(std::memory_order_relaxed);
+            slot_header* s = slot(iframe % h->nslot);
+
+            // odd sequence: readers of this slot will retry
+            s->seq.store(2 * iframe + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            s->nbytes = frame.size();
+            std::memcpy(slot_data(s), frame.data(), frame.size());
+            s->seq.store(2 * (iframe + 1), std::memory_order_release);
+            h->nframe.store(iframe + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief read the latest frame if it has not been read yet (reader)
+         * @param [out] frame resized and filled with the bytes of the frame
+         * @param max_retry the number of attempts when the writer overwrites the slot during the read
+         * @return the index of the frame read or nullopt if there is no new frame
+         */
+        auto read_latest(std::vector<std::byte>& frame, int max_retry = 16) -> std::optional<std::uint64_t> {
+            const ring_header* h = header();
+            for(int itry = 0; itry < max_retry; ++itry){
+                std::uint64_t nframe = h->nframe.load(std::memory_order_acquire);
+                if(nframe == 0 || nframe == _nread) return std::nullopt;
+                std::uint64_t iframe = nframe - 1;
+                slot_header* s = slot(iframe % h->nslot);
+                std::uint64_t seq_begin = s->seq.load(std::memory_order_acquire);
+                if(seq_begin != 2 * (iframe + 1)) continue;
+                std::size_t nbytes = std::min<std::size_t>(s->nbytes, h->slot_bytes);
+                frame.resize(nbytes);
+                std::memcpy(frame.data(), slot_data(s), nbytes);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if(s->seq.load(std::memory_order_relaxed) == seq_begin){
+                    _nread = nframe;
+                    return iframe;
+                }
+            }
+            return std::nullopt;
+        }
+    };
+}
@@ -0,0 +1,306 @@
+/**
+ * @brief a lightweight work-stealing task pool with task dependencies
+ * for element and trace workloads of uneven cost
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace iceicle::util {
+
+    /**
+     * @brief split [0, costs.size()) into contiguous ranges of roughly equal total cost
+     * @param costs the cost of each item
+     * @param target_cost the desired cost of each range (every range has at least one item)
+     * @return the range boundaries: range i is [bounds[i], bounds[i + 1])
+     */
+    template<class T>
+    inline
+    auto cost_balanced_bounds(std::span<const T> costs, T target_cost) -> std::vector<std::size_t> {
+        std::vector<std::size_t> bounds{0};
+        T range_cost = 0;
+        for(std::size_t i = 0; i < costs.size(); ++i){
+            range_cost += costs[i];
+            if(range_cost >= target_cost){
+                bounds.push_back(i + 1);
+                range_cost = 0;
+            }
+        }
+        if(bounds.back() != costs.size()) bounds.push_back(costs.size());
+        return bounds;
+    }
+
+    /**
+     * @brief a pool of worker threads that execute a graph of tasks
+     *
+     * Each worker owns a queue of ready tasks: it takes the newest task from its own queue
+     * and when that is empty steals the oldest task from another worker
+     * so threads do not idle when the task costs are uneven.
+     *
+     * Tasks may depend on previously submitted tasks and become ready when all their
+     * dependencies have completed. The thread that calls wait_all() helps execute tasks
+     * and may do other work (i.e communication) between submitting and waiting.
+     *
+     * Task ids are the submission order and restart from 0 after wait_all()
+     *
+     * NOTE: only one thread may submit tasks and wait
+     */
+    class task_pool {
+        public:
+        using task_id = std::size_t;
+
+        private:
+
+        struct task_node {
+            std::function<void()> fcn;
+
+            /// @brief the number of dependencies that have not completed (+1 while being submitted)
+            std::atomic<int> npending{1};
+
+            /// @brief the tasks that depend on this one
+            std::vector<task_node*> dependents{};
+
+            /// @brief if this task has completed
+            bool done = false;
+        };
+
+        struct ready_queue {
+            std::mutex mutex;
+            std::deque<task_node*> tasks;
+        };
+
+        /// @brief all the tasks submitted since the last wait_all() (deque for pointer stability)
+        std::deque<task_node> tasks{};
+
+        /// @brief guards tasks, the dependency lists, and the done flags
+        std::mutex graph_mutex;
+
+        /// @brief the ready queue for each worker
+        std::vector<std::unique_ptr<ready_queue>> queues;
+
+        /// @brief the worker threads
+        std::vector<std::thread> workers;
+
+        /// @brief the number of tasks in the ready queues
+        std::atomic<std::size_t> nready{0};
+
+        /// @brief the number of tasks that have completed since the last wait_all()
+        std::atomic<std::size_t> ncompleted{0};
+
+        /// @brief the queue that tasks made ready by the submitting thread are pushed to
+        std::size_t next_queue = 0;
+
+        /// @brief sleeping workers wait for ready tasks
+        std::mutex sleep_mutex;
+        std::condition_variable sleep_cv;
+
+        /// @brief the waiting thread waits for completed tasks
+        std::condition_variable done_cv;
+
+        bool stop = false;
+
+        /// @brief the pool and index of the calling thread if it is a worker
+        static auto current_worker() -> std::pair<const task_pool*, int>& {
+            thread_local std::pair<const task_pool*, int> worker{nullptr, 0};
+            return worker;
+        }
+
+        auto push_ready(task_node* task) -> void {
+            auto [pool, iworker] = current_worker();
+            std::size_t iqueue = (pool == this) ? iworker : (next_queue++ % queues.size());
+            {
+                std::lock_guard lock{queues[iqueue]->mutex};
+                queues[iqueue]->tasks.push_back(task);
+            }
+            nready.fetch_add(1);
+            { std::lock_guard lock{sleep_mutex}; }
+            sleep_cv.notify_one();
+            done_cv.notify_one();
+        }
+
+        /// @brief take a ready task, first from the given queue (newest first), then steal (oldest first)
+        auto pop_ready(std::size_t iqueue) -> task_node* {
+            if(nready.load() == 0) return nullptr;
+            {
+                ready_queue& own = *queues[iqueue];
+                std::lock_guard lock{own.mutex};
+                if(!own.tasks.empty()){
+                    task_node* task = own.tasks.back();
+                    own.tasks.pop_back();
+                    nready.fetch_sub(1);
+                    return task;
+                }
+            }
+            for(std::size_t ioffset = 1; ioffset < queues.size(); ++ioffset){
+                ready_queue& victim = *queues[(iqueue + ioffset) % queues.size()];
+                std::lock_guard lock{victim.mutex};
+                if(!victim.tasks.empty()){
+                    task_node* task = victim.tasks.front();
+                    victim.tasks.pop_front();
+                    nready.fetch_sub(1);
+                    return task;
+                }
+            }
+            return nullptr;
+        }
+
+        auto run(task_node* task) -> void {
+            task->fcn();
+            std::vector<task_node*> dependents;
+            {
+                std::lock_guard lock{graph_mutex};
+                task->done = true;
+                dependents.swap(task->dependents);
+            }
+            for(task_node* dependent : dependents){
+                if(dependent->npending.fetch_sub(1) == 1) push_ready(dependent);
+            }
+            ncompleted.fetch_add(1);
+            { std::lock_guard lock{sleep_mutex}; }
+            done_cv.notify_all();
+        }
+
+        auto worker_loop(int iworker) -> void {
+            current_worker() = {this, iworker};
+            while(true) {
+                if(task_node* task = pop_ready(iworker)){
+                    run(task);
+                } else {
+                    std::unique_lock lock{sleep_mutex};
+                    sleep_cv.wait(lock, [&]{ return stop || nready.load() > 0; });
+                    if(stop && nready.load() == 0) return;
+                }
+            }
+        }
+
+        public:
+
+        /**
+         * @brief start the worker threads
+         * @param nworker the number of worker threads
+         *        (the thread that waits on the pool also executes tasks)
+         */
+        explicit task_pool(int nworker)
+        {
+            nworker = std::max(nworker, 0);
+            // the waiting thread gets a queue as well
+            for(int iqueue = 0; iqueue < nworker + 1; ++iqueue)
+                queues.push_back(std::make_unique<ready_queue>());
+            for(int iworker = 0; iworker < nworker; ++iworker)
+                workers.emplace_back([this, iworker]{ worker_loop(iworker); });
+        }
+
+        task_pool(const task_pool&) = delete;
+        task_pool& operator=(const task_pool&) = delete;
+
+        ~task_pool() {
+            {
+                std::lock_guard lock{sleep_mutex};
+                stop = true;
+            }
+            sleep_cv.notify_all();
+            for(std::thread& worker : workers) worker.join();
+        }
+
+        /// @brief the number of threads that execute tasks (the workers and the waiting thread)
+        [[nodiscard]] auto nthread() const noexcept -> int { return workers.size() + 1; }
+
+        /// @brief the index of the calling thread in [0, nthread())
+        /// workers are [0, nthread() - 1) and any other thread is nthread() - 1
+        [[nodiscard]] auto thread_index() const noexcept -> int {
+            auto [pool, iworker] = current_worker();
+            return (pool == this) ? iworker : workers.size();
+        }
+
+        /**
+         * @brief submit a task
+         * @param fcn the work to do
+         * @param deps the tasks that must complete before this task starts
+         * @return the id of the task
+         */
+        auto submit(std::function<void()> fcn, std::span<const task_id> deps = {}) -> task_id {
+            task_node* task;
+            task_id id;
+            {
+                std::lock_guard lock{graph_mutex};
+                id = tasks.size();
+                task = &tasks.emplace_back();
+                task->fcn = std::move(fcn);
+                for(task_id dep : deps){
+                    task_node& dep_task = tasks[dep];
+                    if(!dep_task.done){
+                        dep_task.dependents.push_back(task);
+                        task->npending.fetch_add(1);
+                    }
+                }
+            }
+            // release the submission guard
+            if(task->npending.fetch_sub(1) == 1) push_ready(task);
+            return id;
+        }
+
+        /**
+         * @brief submit a task for each range of [bounds.front(), bounds.back())
+         * and a join task that completes when all the ranges are done
+         * @param bounds the range boundaries: range i is [bounds[i], bounds[i + 1])
+         *        (i.e from cost_balanced_bounds)
+         * @param fcn the work for a range fcn(begin, end)
+         * @param deps the tasks that must complete before any range starts
+         * @return the id of the join task
+         */
+        template<class F>
+        auto submit_ranges(std::span<const std::size_t> bounds, F&& fcn, std::span<const task_id> deps = {})
+        -> task_id {
+            std::vector<task_id> range_tasks{};
+            for(std::size_t irange = 0; irange + 1 < bounds.size(); ++irange){
+                std::size_t begin = bounds[irange], end = bounds[irange + 1];
+                range_tasks.push_back(submit([fcn, begin, end]{ fcn(begin, end); }, deps));
+            }
+            if(range_tasks.empty()) return submit([]{}, deps);
+            return submit([]{}, range_tasks);
+        }
+
+        /// @brief execute tasks until all submitted tasks have completed, then reset the task ids
+        auto wait_all() -> void {
+            std::size_t iqueue = queues.size() - 1;
+            while(ncompleted.load() < tasks.size()){
+                if(task_node* task = pop_ready(iqueue)){
+                    run(task);
+                } else {
+                    std::unique_lock lock{sleep_mutex};
+                    done_cv.wait(lock, [&]{ return nready.load() > 0 || ncompleted.load() == tasks.size(); });
+                }
+            }
+            std::lock_guard lock{graph_mutex};
+            tasks.clear();
+            ncompleted.store(0);
+        }
+    };
+
+    /**
+     * @brief the task pool shared by the assembly loops
+     * the number of threads is ICEICLE_NUM_THREADS if set in the environment
+     * otherwise the hardware concurrency
+     */
+    inline
+    auto global_task_pool() -> task_pool& {
+        static task_pool pool{[]{
+            if(const char* nthread_env = std::getenv("ICEICLE_NUM_THREADS"))
+                return std::max(std::atoi(nthread_env), 1) - 1;
+            return std::max(1, (int) std::thread::hardware_concurrency()) - 1;
+        }()};
+        return pool;
+    }
+}
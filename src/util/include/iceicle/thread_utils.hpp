@@ -0,0 +1,200 @@
+/**
+ * @brief compile macro protected shared memory threading utilities
+ * for the hybrid execution model (one MPI rank per NUMA domain with threads inside)
+ *
+ * @author Gianni Absillis (gabsill@ncsu.edu)
+ */
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#ifdef ICEICLE_USE_OPENMP
+#include <omp.h>
+#endif
+
+namespace iceicle::util {
+
+    /// @brief the maximum number of threads a parallel region will use (1 without OpenMP)
+    inline
+    auto max_threads() -> int {
+#ifdef ICEICLE_USE_OPENMP
+        return omp_get_max_threads();
+#else
+        return 1;
+#endif
+    }
+
+    /// @brief the index of the calling thread in the current parallel region (0 without OpenMP)
+    inline
+    auto thread_num() -> int {
+#ifdef ICEICLE_USE_OPENMP
+        return omp_get_thread_num();
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * @brief execute f(i) for i in [0, n) distributed over threads
+     * with a static schedule
+     *
+     * The static schedule gives each thread the same contiguous chunk of [0, n)
+     * on every call, so data first touched with parallel_for
+     * stays local to the NUMA domain of the thread that later works on it
+     *
+     * @param n the number of iterations
+     * @param f the loop body, must be safe to call concurrently for distinct i
+     */
+    template<class IDX, class F>
+    inline
+    auto parallel_for(IDX n, F&& f) -> void {
+#ifdef ICEICLE_USE_OPENMP
+#pragma omp parallel for schedule(static)
+        for(IDX i = 0; i < n; ++i) f(i);
+#else
+        for(IDX i = 0; i < n; ++i) f(i);
+#endif
+    }
+
+    /**
+     * @brief sum N quantities over i in [0, n) distributed over threads
+     * f(i, sums) adds the contributions of iteration i to sums
+     *
+     * Each thread accumulates its static chunk and the partial sums are added in thread order
+     * so the result is deterministic for a given number of threads
+     *
+     * @tparam N the number of quantities to sum
+     * @param n the number of iterations
+     * @param f the loop body, must be safe to call concurrently for distinct i
+     * @return the sums
+     */
+    template<std::size_t N, class T, class IDX, class F>
+    inline
+    auto parallel_sums(IDX n, F&& f) -> std::array<T, N> {
+        std::array<T, N> sums{};
+#ifdef ICEICLE_USE_OPENMP
+        std::vector<std::array<T, N>> partial(max_threads(), std::array<T, N>{});
+#pragma omp parallel
+        {
+            std::array<T, N> local{};
+#pragma omp for schedule(static)
+            for(IDX i = 0; i < n; ++i) f(i, local);
+            partial[thread_num()] = local;
+        }
+        for(const std::array<T, N>& local : partial){
+            for(std::size_t k = 0; k < N; ++k) sums[k] += local[k];
+        }
+#else
+        for(IDX i = 0; i < n; ++i) f(i, sums);
+#endif
+        return sums;
+    }
+
+    /**
+     * @brief allocator that places storage with NUMA-aware first touch
+     *
+     * Memory pages are mapped to the NUMA domain of the thread that first writes to them
+     * so allocate() value initializes trivial types with parallel_for
+     * (matching the static schedule of the threaded element loops).
+     * The later serial construction by std::vector writes to pages that are already placed
+     *
+     * @tparam T the value type
+     */
+    template<class T>
+    struct first_touch_allocator {
+        using value_type = T;
+
+        first_touch_allocator() noexcept = default;
+
+        template<class U>
+        first_touch_allocator(const first_touch_allocator<U>&) noexcept {}
+
+        [[nodiscard]] auto allocate(std::size_t n) -> T* {
+            T* ptr = std::allocator<T>{}.allocate(n);
+            if constexpr (std::is_trivially_default_constructible_v<T>) {
+                parallel_for(n, [ptr](std::size_t i){ std::construct_at(ptr + i); });
+            }
+            return ptr;
+        }
+
+        auto deallocate(T* ptr, std::size_t n) noexcept -> void {
+            std::allocator<T>{}.deallocate(ptr, n);
+        }
+
+        template<class U>
+        friend auto operator==(const first_touch_allocator<T>&, const first_touch_allocator<U>&) noexcept
+        -> bool { return true; }
+    };
+
+    /// @brief a vector of storage with NUMA-aware first touch (i.e for fespan data)
+    template<class T>
+    using first_touch_vector = std::vector<T, first_touch_allocator<T>>;
+
+    /**
+     * @brief a value that is only built the first time it is used
+     *
+     * get() is safe to call concurrently: the first callers race for a lock
+     * and exactly one builds the value, later calls only load a pointer.
+     * reset() and moves are not thread safe and must not overlap with get()
+     *
+     * @tparam T the value type
+     */
+    template<class T>
+    class lazy_value {
+        /// @brief the value or nullptr if it is not built
+        mutable std::atomic<T*> _ptr{nullptr};
+
+        /// @brief guards building the value
+        mutable std::mutex _mutex{};
+
+        public:
+
+        lazy_value() noexcept = default;
+
+        lazy_value(const lazy_value&) = delete;
+        auto operator=(const lazy_value&) -> lazy_value& = delete;
+
+        lazy_value(lazy_value&& other) noexcept 
+        : _ptr{other._ptr.exchange(nullptr)} {}
+
+        auto operator=(lazy_value&& other) noexcept -> lazy_value& {
+            if(this != &other){
+                reset();
+                _ptr.store(other._ptr.exchange(nullptr));
+            }
+            return *this;
+        }
+
+        ~lazy_value() { reset(); }
+
+        /**
+         * @brief get the value, building it with make() if it is not built yet
+         * @param make make() -> T only called by one thread on the first use
+         */
+        template<class F>
+        auto get(F&& make) const -> T& {
+            T* ptr = _ptr.load(std::memory_order_acquire);
+            if(ptr == nullptr){
+                std::lock_guard lock{_mutex};
+                ptr = _ptr.load(std::memory_order_relaxed);
+                if(ptr == nullptr){
+                    ptr = new T(make());
+                    _ptr.store(ptr, std::memory_order_release);
+                }
+            }
+            return *ptr;
+        }
+
+        /// @brief the value if it is built or nullptr otherwise
+        [[nodiscard]] auto get_if() const noexcept -> T* 
+        { return _ptr.load(std::memory_order_acquire); }
+
+        /// @brief free the value (the next get() builds it again)
+        auto reset() noexcept -> void { delete _ptr.exchange(nullptr); }
+    };
+}
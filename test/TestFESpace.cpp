@@ -1,3 +1,10 @@
+#include "iceicle/disc/artificial_viscosity.hpp"
+#include "iceicle/disc/burgers.hpp"
+#include "iceicle/disc/conservation_law.hpp"
+#include "iceicle/disc/ensemble_flux.hpp"
+#include "iceicle/disc/error_norms.hpp"
+#include "iceicle/disc/hdg_diffusion.hpp"
+#include "iceicle/disc/positivity_limiter.hpp"
 #include "iceicle/disc/projection.hpp"
 #include "iceicle/element/finite_element.hpp"
 #include "iceicle/element/reference_element.hpp"
@@ -9,15 +16,45 @@
 #include "iceicle/geometry/geo_element.hpp"
 #include "iceicle/mesh/mesh.hpp"
 #include "iceicle/mesh/mesh_utils.hpp"
+#include "iceicle/element_gauss_seidel.hpp"
 #include "iceicle/element_linear_solve.hpp"
+#include "iceicle/anderson_acceleration.hpp"
+#include "iceicle/cg_assembly.hpp"
+#include "iceicle/explicit_euler.hpp"
+#include "iceicle/explicit_utils.hpp"
+#include "iceicle/form_residual.hpp"
+#include "iceicle/hdg_solver.hpp"
+#include "iceicle/linear_form_solver.hpp"
+#include "iceicle/low_storage_rk.hpp"
+#include "iceicle/p_adaptivity.hpp"
+#include "iceicle/p_multigrid.hpp"
+#include "iceicle/parareal.hpp"
+#include "iceicle/solution_transfer.hpp"
+#include "iceicle/ssp_rk3.hpp"
 #include "iceicle/tmp_utils.hpp"
 #include <iceicle/fespace/fespace.hpp>
+#include <iceicle/fespace/repartition.hpp>
+#include <iceicle/fespace/point_location.hpp>
 #include <iceicle/fe_utils.hpp>
+#include <iceicle/fe_function/restart.hpp>
+#include <iceicle/coefficient_writer.hpp>
+#include "test_fixtures.hpp"
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
 #include <memory>
+#include <numbers>
+#include <set>
+#include <sstream>
+#include <type_traits>
 
 using namespace iceicle;
+using iceicle::test::Box2dLagrangeP2;
+using iceicle::test::Box2dP2GeoLagrangeP1;
+using iceicle::test::Box2d4x3P2GeoLagrangeP1;
+using iceicle::test::Box2dLagrangeP3;
+using iceicle::test::Box2dLobattoP3;
 
 TEST(test_fespace, test_element_construction){
     using T = double;
@@ -197,6 +234,35 @@ public:
 
 };
 
+TEST(test_fespace, test_periodic_join_before_fespace){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+
+    // the FESpace does not modify the mesh: periodic faces stay boundary traces until they are joined
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {4, 3}, 1);
+    std::size_t nfaces = mesh.faces.size();
+    std::size_t nbdy = mesh.bdyFaceEnd - mesh.bdyFaceStart;
+    {
+        FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LEGENDRE,
+            std::integral_constant<int, 1>{}};
+        ASSERT_EQ(mesh.faces.size(), nfaces);
+        ASSERT_TRUE(mesh.periodic_faces.empty());
+        ASSERT_EQ(fespace.bdy_trace_end - fespace.bdy_trace_start, nbdy);
+    }
+
+    IDX npair = mesh.make_periodic_faces_interior();
+    ASSERT_EQ(npair, nbdy / 2);
+    FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LEGENDRE,
+        std::integral_constant<int, 1>{}};
+    ASSERT_EQ(fespace.bdy_trace_end - fespace.bdy_trace_start, 0);
+    for(IDX ifac : mesh.periodic_faces) {
+        ASSERT_GE((std::size_t) ifac, fespace.interior_trace_start);
+        ASSERT_LT((std::size_t) ifac, fespace.interior_trace_end);
+        ASSERT_NE(fespace.traces[ifac].elL.elidx, fespace.traces[ifac].elR.elidx);
+    }
+}
+
 TEST(test_fespace, test_dg_projection){
 
     using T = double;
@@ -540,3 +606,2142 @@ TEST(test_fespace, test_dg_projection_tri){
 
     delete[] u;
 }
+
+TEST(test_fespace, test_geometric_factors){
+    using T = double;
+    using IDX = int;
+
+    static constexpr int ndim = 2;
+    static constexpr int pn_geo = 1;
+    static constexpr int pn_basis = 2;
+
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {3, 3}, pn_geo);
+    FESpace<T, IDX, ndim> fespace{
+        &mesh, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, 
+        tmp::compile_int<pn_basis>()
+    };
+    fespace.enable_geometric_factors();
+
+    // compare the cached factors against direct computation
+    auto check_elements = [&](){
+        T area = 0;
+        for(const auto& el : fespace.elements){
+            ASSERT_TRUE(el.has_geometric_factors());
+            for(int iqp = 0; iqp < el.nQP(); ++iqp){
+                auto quadpt = el.getQP(iqp);
+                auto J = el.jacobian(quadpt.abscisse);
+                auto Jinv = FiniteElement<T, IDX, ndim>::inverse_jacobian(J);
+                auto phys_pt = el.transform(quadpt.abscisse);
+                const auto& Jinv_cached = fespace.geo_factors->inverse_jacobian(el.elidx, iqp);
+                for(int i = 0; i < ndim; ++i){
+                    for(int j = 0; j < ndim; ++j)
+                        { ASSERT_NEAR(Jinv[i][j], Jinv_cached[i][j], 1e-14); }
+                    ASSERT_NEAR(phys_pt[i], (fespace.geo_factors->element_phys_pt(el.elidx, iqp)[i]), 1e-14);
+                }
+                area += fespace.geo_factors->dvol(el.elidx, iqp);
+            }
+        }
+        ASSERT_NEAR(area, 4.0, 1e-12);
+    };
+    check_elements();
+
+    for(const auto& trace : fespace.traces){
+        ASSERT_TRUE(trace.has_geometric_factors());
+        for(int iqp = 0; iqp < trace.nQP(); ++iqp){
+            auto quadpt = trace.getQP(iqp);
+            auto Jfac = trace.face->Jacobian(mesh.coord, quadpt.abscisse);
+            T sqrtg = trace.face->rootRiemannMetric(Jfac, quadpt.abscisse);
+            auto unit_normal = NUMTOOL::TENSOR::FIXED_SIZE::normalize(
+                    NUMTOOL::TENSOR::FIXED_SIZE::calc_ortho(Jfac));
+            ASSERT_NEAR(sqrtg * quadpt.weight, fespace.geo_factors->dsurf(trace.facidx, iqp), 1e-14);
+            for(int i = 0; i < ndim; ++i)
+                { ASSERT_NEAR(unit_normal[i], (fespace.geo_factors->unit_normal(trace.facidx, iqp)[i]), 1e-14); }
+        }
+    }
+
+    // move an interior node: only the surrounding elements are invalidated
+    IDX inode = -1;
+    for(IDX jnode = 0; jnode < mesh.n_nodes(); ++jnode){
+        if(std::abs(mesh.coord[jnode][0]) < 0.5 && std::abs(mesh.coord[jnode][1]) < 0.5)
+            { inode = jnode; break; }
+    }
+    ASSERT_GE(inode, 0);
+    mesh.coord[inode][0] += 0.05;
+    mesh.coord[inode][1] -= 0.02;
+    mesh.update_node(inode);
+
+    std::span<IDX> moved_els = mesh.elsup.rowspan(inode);
+    for(const auto& el : fespace.elements){
+        bool moved = std::ranges::find(moved_els, el.elidx) != moved_els.end();
+        ASSERT_EQ(el.has_geometric_factors(), !moved);
+    }
+
+    fespace.update_geometric_factors();
+    check_elements();
+}
+
+TEST(test_fespace, test_ddg_trace_factors){
+    using T = double;
+    using IDX = int;
+
+    static constexpr int ndim = 2;
+    static constexpr int pn_basis = 2;
+
+    // curved elements so the transformation hessians contribute
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {3, 3}, 2);
+    FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LEGENDRE,
+        tmp::compile_int<pn_basis>()};
+    FESpace<T, IDX, ndim> fespace_ref{&mesh, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LEGENDRE,
+        tmp::compile_int<pn_basis>()};
+    fespace.enable_ddg_factors();
+    ASSERT_GT(fespace.memory_report().bytes("ddg trace factors"), 0);
+
+    BurgersCoefficients<T, ndim> coeffs{};
+    coeffs.mu = 0.1;
+    coeffs.a[0] = 1.0;
+    coeffs.b[1] = 0.5;
+    ConservationLawDDG disc{BurgersFlux{coeffs}, BurgersUpwind{coeffs}, BurgersDiffusionFlux{coeffs}};
+
+    fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    std::vector<T> u_data(u_layout.size());
+    for(std::size_t i = 0; i < u_data.size(); ++i) u_data[i] = std::sin(0.7 * i) + 0.1 * (i % 5);
+    fespan u{u_data.data(), u_layout};
+
+    // the interior trace integrals match the direct computation
+    auto check_traces = [&](){
+        for(std::size_t itrace = fespace.interior_trace_start; itrace < fespace.interior_trace_end; ++itrace){
+            std::array<std::vector<T>, 2> res_data{};
+            for(int ispace = 0; ispace < 2; ++ispace){
+                const auto& trace = (ispace == 0) ? fespace.traces[itrace] : fespace_ref.traces[itrace];
+                ASSERT_EQ(trace.has_ddg_factors(), ispace == 0);
+                std::vector<T> uL_data(trace.elL.nbasis()), uR_data(trace.elR.nbasis());
+                res_data[ispace].assign(trace.elL.nbasis() + trace.elR.nbasis(), 0.0);
+                auto uL_layout = u.create_element_layout(trace.elL.elidx);
+                auto uR_layout = u.create_element_layout(trace.elR.elidx);
+                dofspan uL{uL_data.data(), uL_layout};
+                dofspan uR{uR_data.data(), uR_layout};
+                dofspan resL{res_data[ispace].data(), uL_layout};
+                dofspan resR{res_data[ispace].data() + trace.elL.nbasis(), uR_layout};
+                extract_elspan(trace.elL.elidx, u, uL);
+                extract_elspan(trace.elR.elidx, u, uR);
+                disc.trace_integral(trace, mesh.coord, uL, uR, resL, resR);
+            }
+            for(std::size_t i = 0; i < res_data[0].size(); ++i)
+                { ASSERT_NEAR(res_data[0][i], res_data[1][i], 1e-12); }
+        }
+    };
+    check_traces();
+
+    // move an interior node: only the traces of the surrounding elements are invalidated
+    IDX inode = -1;
+    for(IDX jnode = 0; jnode < mesh.n_nodes(); ++jnode){
+        if(std::abs(mesh.coord[jnode][0]) < 0.5 && std::abs(mesh.coord[jnode][1]) < 0.5)
+            { inode = jnode; break; }
+    }
+    ASSERT_GE(inode, 0);
+    mesh.coord[inode][0] += 0.05;
+    mesh.coord[inode][1] -= 0.02;
+    mesh.update_node(inode);
+    std::span<IDX> moved_els = mesh.elsup.rowspan(inode);
+    for(std::size_t itrace = fespace.interior_trace_start; itrace < fespace.interior_trace_end; ++itrace){
+        const auto& trace = fespace.traces[itrace];
+        bool moved = std::ranges::find(moved_els, trace.elL.elidx) != moved_els.end()
+            || std::ranges::find(moved_els, trace.elR.elidx) != moved_els.end();
+        ASSERT_EQ(trace.has_ddg_factors(), !moved);
+    }
+    fespace.update_geometric_factors();
+    check_traces();
+}
+
+TEST(test_fespace, test_tabulated_geometry){
+    using T = double;
+    using IDX = int;
+
+    static constexpr int ndim = 2;
+    static constexpr int pn_geo = 3;
+    static constexpr int pn_basis = 2;
+
+    // curve every node of a high order mesh
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {2, 2}, pn_geo);
+    for(IDX inode = 0; inode < mesh.n_nodes(); ++inode){
+        T x = mesh.coord[inode][0], y = mesh.coord[inode][1];
+        mesh.coord[inode][0] += 0.05 * std::sin(std::numbers::pi * y);
+        mesh.coord[inode][1] += 0.05 * std::sin(std::numbers::pi * x);
+        mesh.update_node(inode);
+    }
+    FESpace<T, IDX, ndim> fespace{
+        &mesh, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, 
+        tmp::compile_int<pn_basis>()
+    };
+
+    // the tabulated transformation matches direct evaluation
+    for(const auto& el : fespace.elements){
+        ASSERT_EQ(el.geo_qp_evals.size(), el.nQP());
+        for(int iqp = 0; iqp < el.nQP(); ++iqp){
+            auto xi = el.getQP(iqp).abscisse;
+            auto J = el.jacobian(xi);
+            auto J_qp = el.jacobian_qp(iqp);
+            auto H = el.hessian(xi);
+            auto H_qp = el.hessian_qp(iqp);
+            auto x = el.transform(xi);
+            auto x_qp = el.transform_qp(iqp);
+            for(int i = 0; i < ndim; ++i){
+                ASSERT_NEAR(x[i], x_qp[i], 1e-14);
+                for(int j = 0; j < ndim; ++j){
+                    ASSERT_NEAR(J[i][j], J_qp[i][j], 1e-13);
+                    for(int k = 0; k < ndim; ++k) { ASSERT_NEAR(H[i][j][k], H_qp[i][j][k], 1e-12); }
+                }
+            }
+        }
+    }
+
+    for(const auto& trace : fespace.get_interior_traces()){
+        ASSERT_EQ(trace.geo_evals_l.size(), trace.nQP());
+        ASSERT_EQ(trace.geo_evals_r.size(), trace.nQP());
+        for(int iqp = 0; iqp < trace.nQP(); ++iqp){
+            auto JL = trace.elL.jacobian(trace.xiL_qp(iqp));
+            auto JR = trace.elR.jacobian(trace.xiR_qp(iqp));
+            auto HL = trace.elL.hessian(trace.xiL_qp(iqp));
+            auto JL_qp = trace.jacobian_l_qp(iqp);
+            auto JR_qp = trace.jacobian_r_qp(iqp);
+            auto HL_qp = trace.hessian_l_qp(iqp);
+            for(int i = 0; i < ndim; ++i){
+                for(int j = 0; j < ndim; ++j){
+                    ASSERT_NEAR(JL[i][j], JL_qp[i][j], 1e-13);
+                    ASSERT_NEAR(JR[i][j], JR_qp[i][j], 1e-13);
+                    for(int k = 0; k < ndim; ++k) { ASSERT_NEAR(HL[i][j][k], HL_qp[i][j][k], 1e-12); }
+                }
+            }
+        }
+    }
+}
+
+TEST(test_fespace, test_shared_trace_points){
+    using T = double;
+    using IDX = int;
+
+    static constexpr int ndim = 2;
+    static constexpr int pn_basis = 2;
+
+    std::vector<IDX> nelem{4, 3};
+    std::vector<T> xmin{-1, -1};
+    std::vector<T> xmax{1, 1};
+    std::vector<T> quad_ratio{0.5, 0.5};
+    std::vector<BOUNDARY_CONDITIONS> bcs{BOUNDARY_CONDITIONS::DIRICHLET,
+        BOUNDARY_CONDITIONS::DIRICHLET, BOUNDARY_CONDITIONS::DIRICHLET,
+        BOUNDARY_CONDITIONS::DIRICHLET};
+    std::vector<int> bcflags{0, 0, 0, 0};
+    AbstractMesh<T, IDX, ndim> mesh = mixed_uniform_mesh<T, IDX>(nelem, xmin, xmax, quad_ratio, bcs, bcflags).value();
+    FESpace<T, IDX, ndim> fespace{
+        &mesh, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE,
+        tmp::compile_int<pn_basis>()
+    };
+
+    // the mapped quadrature points are a shared table that matches the face transformation
+    std::set<const MATH::GEOMETRY::Point<T, ndim>*> tables{};
+    for(const auto& trace : fespace.traces){
+        tables.insert(trace.qp_xi_l.data());
+        ASSERT_EQ(trace.qp_xi_l.size(), (std::size_t) trace.nQP());
+        ASSERT_EQ(trace.qp_xi_r.size(), (std::size_t) trace.nQP());
+        for(int iqp = 0; iqp < trace.nQP(); ++iqp){
+            auto xiL = trace.transform_xiL(trace.getQP(iqp).abscisse);
+            auto xiR = trace.transform_xiR(trace.getQP(iqp).abscisse);
+            for(int idim = 0; idim < ndim; ++idim){
+                ASSERT_DOUBLE_EQ(trace.xiL_qp(iqp)[idim], xiL[idim]);
+                ASSERT_DOUBLE_EQ(trace.xiR_qp(iqp)[idim], xiR[idim]);
+            }
+        }
+    }
+    ASSERT_LT(tables.size(), fespace.traces.size());
+}
+
+TEST(test_fespace, test_lazy_connectivity){
+    using T = double;
+    using IDX = int;
+
+    static constexpr int ndim = 2;
+    static constexpr int pn_basis = 1;
+
+    std::vector<IDX> nelem{3, 2};
+    std::vector<T> xmin{-1, -1};
+    std::vector<T> xmax{1, 1};
+    std::vector<T> quad_ratio{0.5, 0.5};
+    std::vector<BOUNDARY_CONDITIONS> bcs{BOUNDARY_CONDITIONS::DIRICHLET,
+        BOUNDARY_CONDITIONS::DIRICHLET, BOUNDARY_CONDITIONS::DIRICHLET,
+        BOUNDARY_CONDITIONS::DIRICHLET};
+    std::vector<int> bcflags{0, 0, 0, 0};
+    AbstractMesh<T, IDX, ndim> mesh = mixed_uniform_mesh<T, IDX>(nelem, xmin, xmax, quad_ratio, bcs, bcflags).value();
+    FESpace<T, IDX, ndim> fespace{
+        &mesh, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE,
+        tmp::compile_int<pn_basis>()
+    };
+
+    // every face is in the rows of its elements and nodes
+    for(IDX itrace = 0; itrace < (IDX) fespace.traces.size(); ++itrace){
+        const auto& trace = fespace.traces[itrace];
+        for(IDX iel : {trace.elL.elidx, trace.elR.elidx}){
+            ASSERT_NE(std::ranges::find(fespace.fac_surr_el().rowspan(iel), itrace),
+                    fespace.fac_surr_el().rowspan(iel).end());
+        }
+        for(IDX inode : trace.face->nodes_span()){
+            ASSERT_NE(std::ranges::find(fespace.fac_surr_nodes().rowspan(inode), itrace),
+                    fespace.fac_surr_nodes().rowspan(inode).end());
+        }
+    }
+
+    // released connectivity is the same when built again
+    std::vector<IDX> fac_surr_el_data{fespace.fac_surr_el().data(), 
+        fespace.fac_surr_el().data() + fespace.fac_surr_el().nnz()};
+    fespace.release_connectivity();
+    ASSERT_TRUE(std::ranges::equal(std::span{fespace.fac_surr_el().data(), fespace.fac_surr_el().nnz()}, 
+                fac_surr_el_data));
+    ASSERT_EQ(fespace.el_surr_nodes().nrow(), mesh.n_nodes());
+}
+
+TEST(test_fespace, test_affine_elements){
+    using T = double;
+    using IDX = int;
+
+    static constexpr int ndim = 2;
+    static constexpr int pn_basis = 2;
+
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {3, 3}, 1);
+
+    // shear the mesh so the elements are parallelograms
+    for(IDX inode = 0; inode < mesh.n_nodes(); ++inode)
+        { mesh.coord[inode][0] += 0.3 * mesh.coord[inode][1]; }
+    mesh.update_coord_els();
+
+    FESpace<T, IDX, ndim> fespace{
+        &mesh, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, 
+        tmp::compile_int<pn_basis>()
+    };
+
+    for(const auto& el : fespace.elements){
+        ASSERT_TRUE(el.is_affine());
+
+        // reference mass scaling matches the quadrature mass matrix
+        auto el_general = el;
+        el_general.affine = false;
+        auto mass_affine = calculate_mass_matrix(el);
+        auto mass = calculate_mass_matrix(el_general);
+        for(int i = 0; i < el.nbasis(); ++i){
+            for(int j = 0; j < el.nbasis(); ++j)
+                { ASSERT_NEAR(mass_affine[i][j], mass[i][j], 1e-14); }
+        }
+    }
+
+    // moving a node breaks the parallelogram for the surrounding elements
+    IDX inode = -1;
+    for(IDX jnode = 0; jnode < mesh.n_nodes(); ++jnode){
+        if(std::abs(mesh.coord[jnode][1]) < 0.5 && std::abs(mesh.coord[jnode][0] - 0.3 * mesh.coord[jnode][1]) < 0.5)
+            { inode = jnode; break; }
+    }
+    ASSERT_GE(inode, 0);
+    mesh.coord[inode][0] += 0.05;
+    mesh.update_node(inode);
+    std::span<IDX> moved_els = mesh.elsup.rowspan(inode);
+    for(const auto& el : fespace.elements){
+        bool moved = std::ranges::find(moved_els, el.elidx) != moved_els.end();
+        ASSERT_EQ(el.is_affine(), !moved);
+    }
+}
+
+TEST(test_fespace, test_memory_report){
+    using T = double;
+    using IDX = int;
+
+    static constexpr int ndim = 2;
+    static constexpr int pn_basis = 2;
+
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {4, 4}, 1);
+    FESpace<T, IDX, ndim> fespace{
+        &mesh, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, 
+        tmp::compile_int<pn_basis>()
+    };
+    fespace.enable_geometric_factors();
+    (void) fespace.fac_surr_nodes();
+
+    util::MemoryReport report = fespace.memory_report();
+    ASSERT_GT(report.total(), 0);
+    for(const auto& entry : report.entries){
+        if(entry.name == "elements") { ASSERT_EQ(entry.count, fespace.elements.size()); }
+    }
+    std::size_t geo_bytes = report.bytes("geometric factors (elements)");
+    std::size_t lazy_bytes = report.bytes("lazy connectivity");
+    ASSERT_GT(lazy_bytes, 0);
+
+    std::vector<std::array<std::array<T, ndim>, ndim>> jinv{};
+    auto save_jinv = [&](){
+        jinv.clear();
+        for(const auto& el : fespace.elements) for(int iqp = 0; iqp < el.nQP(); ++iqp){
+            const auto& Jinv = fespace.geo_factors->inverse_jacobian(el.elidx, iqp);
+            jinv.push_back({std::array<T, ndim>{Jinv[0][0], Jinv[0][1]}, std::array<T, ndim>{Jinv[1][0], Jinv[1][1]}});
+        }
+    };
+    save_jinv();
+
+    // compact mode gives the same geometric factors with less memory
+    fespace.compact();
+    ASSERT_TRUE(fespace.is_compact());
+    ASSERT_TRUE(fespace.geo_factors->is_compact());
+    util::MemoryReport compact_report = fespace.memory_report();
+    ASSERT_LT(compact_report.bytes("geometric factors (elements)"), geo_bytes);
+    ASSERT_LT(compact_report.bytes("lazy connectivity"), lazy_bytes);
+    std::size_t k = 0;
+    for(const auto& el : fespace.elements) for(int iqp = 0; iqp < el.nQP(); ++iqp, ++k){
+        const auto& Jinv = fespace.geo_factors->inverse_jacobian(el.elidx, iqp);
+        for(int i = 0; i < ndim; ++i) for(int j = 0; j < ndim; ++j)
+            { ASSERT_NEAR(Jinv[i][j], jinv[k][i][j], 1e-14); }
+    }
+
+    // elements that are no longer affine store the inverse jacobian at every quadrature point
+    IDX inode = -1;
+    for(IDX jnode = 0; jnode < mesh.n_nodes(); ++jnode){
+        if(std::abs(mesh.coord[jnode][0]) < 0.6 && std::abs(mesh.coord[jnode][1]) < 0.6)
+            { inode = jnode; break; }
+    }
+    ASSERT_GE(inode, 0);
+    mesh.coord[inode][0] += 0.05;
+    mesh.update_node(inode);
+    fespace.update_geometric_factors();
+    k = 0;
+    for(const auto& el : fespace.elements) for(int iqp = 0; iqp < el.nQP(); ++iqp){
+        auto Jinv = FiniteElement<T, IDX, ndim>::inverse_jacobian(el.jacobian(el.getQP(iqp).abscisse));
+        const auto& Jinv_cached = fespace.geo_factors->inverse_jacobian(el.elidx, iqp);
+        for(int i = 0; i < ndim; ++i) for(int j = 0; j < ndim; ++j)
+            { ASSERT_NEAR(Jinv[i][j], Jinv_cached[i][j], 1e-14); }
+    }
+}
+
+TEST_F(Box2dP2GeoLagrangeP1, test_element_batches){
+    static constexpr int pn_geo = 2;
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+
+    ASSERT_EQ(fespace.element_batches.nrow(), fespace.element_batch_keys.size());
+
+    // every element appears in exactly one batch with the matching type
+    std::vector<int> count(fespace.elements.size(), 0);
+    for(IDX ibatch = 0; ibatch < fespace.element_batches.nrow(); ++ibatch){
+        fespace.dispatch_element_batch(ibatch, [&]<class TransT>(std::type_identity<TransT>, std::span<const IDX> elidxs){
+            bool is_concrete = std::is_same_v<TransT, transformations::hypercube<T, IDX, ndim, pn_geo>>;
+            ASSERT_TRUE(is_concrete);
+            for(IDX iel : elidxs){
+                ++count[iel];
+                ASSERT_EQ(fespace.elements[iel].trans->order, fespace.element_batch_keys[ibatch].geometry_order);
+            }
+        });
+    }
+    for(int c : count) ASSERT_EQ(c, 1);
+
+    // the inlined transformation gives the same geometry
+    fespace.dispatch_element_batch(0, [&]<class TransT>(std::type_identity<TransT>, std::span<const IDX> elidxs){
+        for(IDX iel : elidxs){
+            const auto& el = fespace.elements[iel];
+            QPGeometry<T, IDX, ndim, TransT> geo_inlined{el};
+            QPGeometry geo{el};
+            for(int iqp = 0; iqp < el.nQP(); ++iqp){
+                auto [Jinv1, dvol1] = geo_inlined[iqp];
+                auto [Jinv2, dvol2] = geo[iqp];
+                ASSERT_NEAR(dvol1, dvol2, 1e-14);
+                for(int i = 0; i < ndim; ++i){
+                    for(int j = 0; j < ndim; ++j) ASSERT_NEAR(Jinv1[i][j], Jinv2[i][j], 1e-14);
+                }
+            }
+        }
+    });
+}
+
+TEST(test_fespace, test_quadrature_shifts){
+    using T = double;
+    using IDX = int;
+
+    static constexpr int ndim = 2;
+    static constexpr int pn_geo = 2;
+    static constexpr int pn_basis = 2;
+
+    // the exact rule has geometry order + basis order points, reduced rules keep basis order + 1 points
+    ASSERT_EQ(quadrature_npoints_1d(FESPACE_ENUMS::GAUSS_LEGENDRE, pn_basis, pn_geo), 4);
+    ASSERT_EQ(quadrature_npoints_1d(FESPACE_ENUMS::GAUSS_LEGENDRE, pn_basis, pn_geo, 1), 5);
+    ASSERT_EQ(quadrature_npoints_1d(FESPACE_ENUMS::GAUSS_LEGENDRE, pn_basis, pn_geo, -5), 3);
+    ASSERT_EQ(quadrature_npoints_1d(FESPACE_ENUMS::GAUSS_LOBATTO, pn_basis, pn_geo, 2), 3);
+    ASSERT_EQ(effective_quadrature_shift(FESPACE_ENUMS::GAUSS_LEGENDRE, pn_basis, pn_geo, -5), -1);
+
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, pn_geo);
+    FESpace<T, IDX, ndim> fespace{
+        &mesh, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, 
+        tmp::compile_int<pn_basis>()
+    };
+    std::size_t ndof = fespace.dg_map.calculate_size_requirement(1);
+    ASSERT_EQ(fespace.elements[0].nQP(), 16);
+    ASSERT_EQ(fespace.traces[0].nQP(), 4);
+
+    // over-integrate the elements and reduce the traces (independently)
+    fespace.set_quadrature_shifts(1, -5);
+    for(const auto& el : fespace.elements){
+        ASSERT_EQ(el.nQP(), 25);
+        T weight_sum = 0;
+        for(int iqp = 0; iqp < el.nQP(); ++iqp) weight_sum += el.quadrule->getPoint(iqp).weight;
+        ASSERT_NEAR(weight_sum, 4.0, 1e-12);
+    }
+    for(const auto& trace : fespace.traces) ASSERT_EQ(trace.nQP(), 3);
+    for(const FETypeKey& key : fespace.element_batch_keys) ASSERT_EQ(key.quadrature_shift, 1);
+    ASSERT_EQ(fespace.dg_map.calculate_size_requirement(1), ndof);
+
+    // back to the exact rules
+    fespace.set_quadrature_shifts(0, 0);
+    for(const auto& el : fespace.elements) ASSERT_EQ(el.nQP(), 16);
+    for(const auto& trace : fespace.traces) ASSERT_EQ(trace.nQP(), 4);
+}
+
+TEST(test_fespace, test_repartition){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 1);
+    FESpace<T, IDX, ndim> fespace{
+        &mesh, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, 
+        tmp::compile_int<2>()
+    };
+    fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, 2>{}};
+    std::vector<T> u_data(u_layout.size());
+    for(std::size_t i = 0; i < u_data.size(); ++i) u_data[i] = 0.5 * i;
+    fespan u{u_data.data(), u_layout};
+
+    // on a single process the partition and solution are unchanged
+    std::vector<T> u_new_data = repartition(fespace, u);
+    ASSERT_EQ(fespace.elements.size(), mesh.nelem());
+    ASSERT_EQ(u_new_data, u_data);
+}
+
+TEST(test_fespace, test_binary_restart){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 1);
+    FESpace<T, IDX, ndim> fespace{
+        &mesh, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, 
+        tmp::compile_int<2>()
+    };
+    fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, 2>{}};
+    std::vector<T> u_data(u_layout.size());
+    for(std::size_t i = 0; i < u_data.size(); ++i) u_data[i] = 0.5 * i + 1.0 / 3.0;
+    fespan u{u_data.data(), u_layout};
+    auto coord_saved = mesh.coord;
+
+    write_restart_binary(fespace, u, 9973);
+    ASSERT_EQ(util::AnomalyLog::size(), 0);
+
+    // perturb the mesh and solution then read back the exact values
+    for(auto& node : mesh.coord) node[0] += 0.1;
+    std::ranges::fill(u_data, 0.0);
+    read_restart_binary(fespace, u, "restart9973.bin");
+    ASSERT_EQ(util::AnomalyLog::size(), 0);
+    for(std::size_t i = 0; i < u_data.size(); ++i) ASSERT_EQ(u_data[i], 0.5 * i + 1.0 / 3.0);
+    for(IDX inode = 0; inode < mesh.n_nodes(); ++inode){
+        for(int idim = 0; idim < ndim; ++idim) ASSERT_EQ(mesh.coord[inode][idim], coord_saved[inode][idim]);
+    }
+
+    // a corrupted coefficient fails the block checksum
+    std::filesystem::path restart_path = std::filesystem::current_path() / "RESTART" / "restart9973.bin";
+    {
+        std::fstream file{restart_path, std::ios::in | std::ios::out | std::ios::binary};
+        file.seekp(-(std::streamoff) (sizeof(std::uint64_t) + sizeof(T)), std::ios::end);
+        T corrupted = -1.0;
+        file.write(reinterpret_cast<const char*>(&corrupted), sizeof(T));
+    }
+    read_restart_binary(fespace, u, "restart9973.bin");
+    ASSERT_GT(util::AnomalyLog::size(), 0);
+    std::ostringstream anomaly_out{};
+    util::AnomalyLog::handle_anomalies(anomaly_out);
+
+    // a truncated file is rejected instead of read past the end
+    std::filesystem::resize_file(restart_path, std::filesystem::file_size(restart_path) / 2);
+    read_restart_binary(fespace, u, "restart9973.bin");
+    ASSERT_GT(util::AnomalyLog::size(), 0);
+    util::AnomalyLog::handle_anomalies(anomaly_out);
+    std::filesystem::remove(restart_path);
+}
+
+TEST(test_fespace, test_incremental_restart){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 1);
+    FESpace<T, IDX, ndim> fespace{
+        &mesh, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, 
+        tmp::compile_int<1>()
+    };
+    fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    std::vector<T> u_data(u_layout.size(), 1.0);
+    fespan u{u_data.data(), u_layout};
+    geo_dof_map<T, IDX, ndim> geo_map{};
+    geo_map.selected_nodes = {4};
+
+    IncrementalRestart<T, IDX, ndim> restart{2};
+    restart.write(fespace, u, geo_map, 9971);
+    auto coord_full = mesh.coord;
+
+    // move a selected node and a node that is not selected
+    mesh.coord[4][0] += 0.05;
+    mesh.coord[0][0] += 0.05;
+    auto coord_delta = mesh.coord;
+    std::ranges::fill(u_data, 2.0);
+    restart.write(fespace, u, geo_map, 9972);
+    ASSERT_EQ(util::AnomalyLog::size(), 0);
+
+    // the delta only has the selected node on top of the full checkpoint
+    for(auto& node : mesh.coord) node[1] += 0.1;
+    std::ranges::fill(u_data, 0.0);
+    read_restart_binary(fespace, u, "restart9972.delta.bin");
+    ASSERT_EQ(util::AnomalyLog::size(), 0);
+    for(T value : u_data) ASSERT_EQ(value, 2.0);
+    for(IDX inode = 0; inode < mesh.n_nodes(); ++inode){
+        const auto& expected = (inode == 4) ? coord_delta[inode] : coord_full[inode];
+        for(int idim = 0; idim < ndim; ++idim) ASSERT_EQ(mesh.coord[inode][idim], expected[idim]);
+    }
+    std::filesystem::remove(std::filesystem::current_path() / "RESTART" / "restart9971.bin");
+    std::filesystem::remove(std::filesystem::current_path() / "RESTART" / "restart9972.delta.bin");
+}
+
+TEST(test_fespace, test_coefficient_output){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 1);
+    FESpace<T, IDX, ndim> fespace{
+        &mesh, FESPACE_ENUMS::LEGENDRE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, 
+        tmp::compile_int<2>()
+    };
+
+    // mixed basis orders (p-adaptivity) are recorded by the element type keys
+    std::vector<int> el_orders{2, 1, 2, 0, 2, 1};
+    fespace.set_element_orders(el_orders);
+    fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, 2>{}};
+    std::vector<T> u_data(u_layout.size());
+    for(std::size_t i = 0; i < u_data.size(); ++i) u_data[i] = 0.25 * i - 1.0 / 3.0;
+    fespan u{u_data.data(), u_layout};
+    mesh.coord[5][0] += 0.05;
+    auto coord_saved = mesh.coord;
+    mesh.update_coord_els();
+
+    io::CoefficientWriter<T, IDX, ndim> writer{};
+    writer.data_directory = std::filesystem::current_path() / "coefficient_test";
+    writer.register_fespace(fespace);
+    writer.register_fields(u, std::vector<std::string>{"u", "v"});
+    io::write_file(writer, 9970, 1.5);
+    ASSERT_EQ(util::AnomalyLog::size(), 0);
+
+    std::filesystem::path path = writer.data_directory / "coefficients9970_rank0.coef";
+    std::vector<io::CoefficientSnapshot<T>> pieces{io::read_coefficient_file<T>(path)};
+    ASSERT_EQ(util::AnomalyLog::size(), 0);
+    const io::CoefficientSnapshot<T>& snapshot = pieces[0];
+    ASSERT_EQ(snapshot.itime, 9970);
+    ASSERT_EQ(snapshot.time, 1.5);
+    ASSERT_EQ(snapshot.keys.size(), 3);
+    ASSERT_EQ(snapshot.el_ndofs.size(), fespace.elements.size());
+    for(IDX iel = 0; iel < (IDX) fespace.elements.size(); ++iel){
+        ASSERT_EQ(snapshot.keys[snapshot.el_keys[iel]].basis_order, el_orders[iel]);
+        ASSERT_EQ(snapshot.el_ndofs[iel], fespace.elements[iel].nbasis());
+    }
+    ASSERT_EQ(snapshot.fields.size(), 1);
+    ASSERT_EQ(snapshot.fields[0].names, (std::vector<std::string>{"u", "v"}));
+    ASSERT_EQ(snapshot.fields[0].coefficients, u_data);
+
+    // load into a fresh space of uniform order on the unperturbed mesh
+    AbstractMesh<T, IDX, ndim> mesh2({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 1);
+    FESpace<T, IDX, ndim> fespace2{
+        &mesh2, FESPACE_ENUMS::LEGENDRE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, 
+        tmp::compile_int<2>()
+    };
+    ASSERT_TRUE(io::load_coefficient_snapshot(fespace2, std::span<const io::CoefficientSnapshot<T>>{pieces}));
+    for(IDX iel = 0; iel < (IDX) fespace2.elements.size(); ++iel)
+        ASSERT_EQ(fespace2.elements[iel].basis->getPolynomialOrder(), el_orders[iel]);
+    for(IDX inode = 0; inode < mesh2.n_nodes(); ++inode){
+        for(int idim = 0; idim < ndim; ++idim) ASSERT_EQ(mesh2.coord[inode][idim], coord_saved[inode][idim]);
+    }
+    fe_layout_right u2_layout{fespace2.dg_map, std::integral_constant<std::size_t, 2>{}};
+    std::vector<T> u2_data(u2_layout.size(), 0.0);
+    fespan u2{u2_data.data(), u2_layout};
+    io::load_coefficient_fields(fespace2, std::span<const io::CoefficientSnapshot<T>>{pieces}, 0, u2);
+    ASSERT_EQ(u2_data, u_data);
+
+    // a lagrange space does not match the basis type
+    AbstractMesh<T, IDX, ndim> mesh3({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 1);
+    FESpace<T, IDX, ndim> fespace3{
+        &mesh3, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, 
+        tmp::compile_int<2>()
+    };
+    ASSERT_FALSE(io::load_coefficient_snapshot(fespace3, std::span<const io::CoefficientSnapshot<T>>{pieces}));
+    ASSERT_GT(util::AnomalyLog::size(), 0);
+    std::ostringstream anomaly_out{};
+    util::AnomalyLog::handle_anomalies(anomaly_out);
+    std::filesystem::remove_all(writer.data_directory);
+}
+
+TEST_F(Box2d4x3P2GeoLagrangeP1, test_find_element){
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+
+    std::vector<BoundingBox<T, ndim>> bboxes = element_bounding_boxes(fespace);
+    for(const MATH::GEOMETRY::Point<T, ndim>& x : {
+        MATH::GEOMETRY::Point<T, ndim>{0.1, 0.2},
+        MATH::GEOMETRY::Point<T, ndim>{-0.9, 0.95},
+        MATH::GEOMETRY::Point<T, ndim>{0.73, -0.41}
+    }) {
+        auto loc = find_element(fespace, std::span<const BoundingBox<T, ndim>>{bboxes}, x);
+        ASSERT_TRUE(loc.has_value());
+        MATH::GEOMETRY::Point<T, ndim> x_found = fespace.elements[loc->iel].transform(loc->xi);
+        for(int idim = 0; idim < ndim; ++idim) ASSERT_NEAR(x_found[idim], x[idim], 1e-10);
+    }
+
+    // points outside the domain are not found
+    ASSERT_FALSE(find_element(fespace, MATH::GEOMETRY::Point<T, ndim>{1.5, 0.0}).has_value());
+
+    // the bounding volume hierarchy finds the same elements as the linear scan
+    ElementBVH<T, IDX, ndim> bvh{fespace, 2};
+    std::vector<MATH::GEOMETRY::Point<T, ndim>> points{};
+    for(int i = 0; i < 11; ++i){
+        for(int j = 0; j < 11; ++j) points.push_back(MATH::GEOMETRY::Point<T, ndim>{-1.1 + 0.22 * i, -1.1 + 0.21 * j});
+    }
+    auto found = find_elements(fespace, bvh, std::span<const MATH::GEOMETRY::Point<T, ndim>>{points});
+    for(std::size_t ipoint = 0; ipoint < points.size(); ++ipoint){
+        auto expected = find_element(fespace, std::span<const BoundingBox<T, ndim>>{bboxes}, points[ipoint]);
+        ASSERT_EQ(found[ipoint].has_value(), expected.has_value());
+        if(expected){
+            MATH::GEOMETRY::Point<T, ndim> x_found = fespace.elements[found[ipoint]->iel].transform(found[ipoint]->xi);
+            for(int idim = 0; idim < ndim; ++idim) ASSERT_NEAR(x_found[idim], points[ipoint][idim], 1e-10);
+        }
+    }
+}
+
+TEST(test_fespace, test_solution_transfer){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+
+    // a p = 1 source on a coarse mesh
+    AbstractMesh<T, IDX, ndim> mesh_src({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 1);
+    FESpace<T, IDX, ndim> space_src{
+        &mesh_src, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, 
+        tmp::compile_int<1>()
+    };
+    auto linear_func = [](const T* x, T* out){ out[0] = 1.0 + 2.0 * x[0] - x[1]; };
+    fe_layout_right src_layout{space_src.dg_map, std::integral_constant<std::size_t, 1>{}};
+    std::vector<T> src_data(src_layout.size());
+    fespan u_src{src_data.data(), src_layout};
+    Projection<T, IDX, ndim, 1> projection{linear_func};
+    solvers::LinearFormSolver{space_src, projection}.solve(u_src);
+
+    // a p = 3 target on a finer non-matching mesh
+    AbstractMesh<T, IDX, ndim> mesh_tgt({-1.0, -1.0}, {1.0, 1.0}, {5, 4}, 1);
+    FESpace<T, IDX, ndim> space_tgt{
+        &mesh_tgt, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, 
+        tmp::compile_int<3>()
+    };
+    fe_layout_right tgt_layout{space_tgt.dg_map, std::integral_constant<std::size_t, 1>{}};
+    std::vector<T> tgt_data(tgt_layout.size());
+    fespan u_tgt{tgt_data.data(), tgt_layout};
+    solvers::transfer_solution(space_src, u_src, space_tgt, u_tgt);
+    ASSERT_EQ(util::AnomalyLog::size(), 0);
+
+    // the linear function is represented exactly in both spaces
+    for(const FiniteElement<T, IDX, ndim>& el : space_tgt.elements){
+        for(int k = 0; k < 5; ++k){
+            MATH::GEOMETRY::Point<T, ndim> ref_pt = random_domain_point(el.trans);
+            MATH::GEOMETRY::Point<T, ndim> phys_pt = el.transform(ref_pt);
+            T expected;
+            linear_func(phys_pt, &expected);
+            std::vector<T> basis(el.nbasis());
+            el.eval_basis(ref_pt, basis.data());
+            T value = 0.0;
+            for(std::size_t idof = 0; idof < el.nbasis(); ++idof) value += u_tgt[el.elidx, idof, 0] * basis[idof];
+            ASSERT_NEAR(value, expected, 1e-10);
+        }
+    }
+}
+
+TEST_F(Box2dLagrangeP3, test_artificial_viscosity){
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+    fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    std::vector<T> u_data(u_layout.size());
+    fespan u{u_data.data(), u_layout};
+
+    ArtificialViscosity<T, ndim> av{};
+    av.eps0 = 1.0;
+
+    // a linear function has no energy in the highest modes
+    auto linear_func = [](const T* x, T* out){ out[0] = 1.0 + 2.0 * x[0] - x[1]; };
+    Projection<T, IDX, ndim, 1> linear_projection{linear_func};
+    solvers::LinearFormSolver{fespace, linear_projection}.solve(u);
+    av.update(fespace, u);
+    ASSERT_TRUE(av.active());
+    for(IDX iel = 0; iel < fespace.elements.size(); ++iel){
+        ASSERT_LT(av.sensor[iel], -8.0);
+        ASSERT_EQ(av.el_viscosity[iel], 0.0);
+    }
+
+    // a step inside the elements in 0 < x < 0.5 is detected
+    auto step_func = [](const T* x, T* out){ out[0] = (x[0] > 0.25) ? 2.0 : 1.0; };
+    Projection<T, IDX, ndim, 1> step_projection{step_func};
+    solvers::LinearFormSolver{fespace, step_projection}.solve(u);
+    av.update(fespace, u);
+    T eps_max = 0.0;
+    for(IDX iel = 0; iel < fespace.elements.size(); ++iel){
+        const FiniteElement<T, IDX, ndim>& el = fespace.elements[iel];
+        T xc = el.centroid()[0];
+        if(xc > 0.0 && xc < 0.5) ASSERT_GT(av.el_viscosity[iel], 0.0);
+        eps_max = std::max(eps_max, av.el_viscosity[iel]);
+    }
+    // eps0 * h / p with h = sqrt(0.5 * 1.0)
+    ASSERT_LE(eps_max, std::sqrt(0.5) / 3.0 + 1e-12);
+
+    // the continuous field is bounded by the element values
+    for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+        for(int iqp = 0; iqp < el.nQP(); ++iqp){
+            ASSERT_GE(av.element_qp(el.elidx, iqp), -1e-12);
+            ASSERT_LE(av.element_qp(el.elidx, iqp), eps_max + 1e-12);
+        }
+    }
+}
+
+TEST_F(Box2dLobattoP3, test_flux_differencing){
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+    fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    std::vector<T> u_data(u_layout.size());
+    fespan u{u_data.data(), u_layout};
+    auto func = [](const T* x, T* out){ out[0] = std::sin(x[0]) * std::cos(2.0 * x[1]) + 1.0; };
+    Projection<T, IDX, ndim, 1> projection{func};
+    solvers::LinearFormSolver{fespace, projection}.solve(u);
+
+    // linear advection: the entropy conservative flux is the central flux
+    // so on affine elements flux differencing is the standard domain integral
+    BurgersCoefficients<T, ndim> burgers_coeffs{};
+    burgers_coeffs.mu = 0.01;
+    burgers_coeffs.a[0] = 1.0;
+    burgers_coeffs.a[1] = -0.5;
+    ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                          BurgersUpwind{burgers_coeffs},
+                          BurgersDiffusionFlux{burgers_coeffs}};
+
+    for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+        // the Lagrange basis is collocated on the Gauss-Lobatto points
+        ASSERT_NE(el.sum_fact, nullptr);
+        ASSERT_TRUE(el.sum_fact->collocated());
+
+        auto el_layout = u.create_element_layout(el.elidx);
+        std::vector<T> uel_data(el_layout.size()), weak_data(el_layout.size()), fd_data(el_layout.size());
+        dofspan u_el{uel_data.data(), el_layout};
+        dofspan res_weak{weak_data.data(), el_layout};
+        dofspan res_fd{fd_data.data(), el_layout};
+        extract_elspan(el.elidx, u, u_el);
+
+        disc.flux_differencing = false;
+        res_weak = 0;
+        disc.domain_integral(el, u_el, res_weak);
+        disc.flux_differencing = true;
+        res_fd = 0;
+        disc.domain_integral(el, u_el, res_fd);
+        for(int idof = 0; idof < el.nbasis(); ++idof)
+            ASSERT_NEAR((res_weak[idof, 0]), (res_fd[idof, 0]), 1e-12);
+    }
+}
+
+TEST(test_fespace, test_specialized_kernels){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+
+    BurgersCoefficients<T, ndim> burgers_coeffs{};
+    burgers_coeffs.mu = 0.01;
+    burgers_coeffs.a[0] = 1.0;
+    burgers_coeffs.a[1] = -0.5;
+    burgers_coeffs.b[0] = 0.5;
+    ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                          BurgersUpwind{burgers_coeffs},
+                          BurgersDiffusionFlux{burgers_coeffs}};
+    disc.user_source = [](const T* x, T* out){ out[0] = x[0] * x[1]; };
+
+    AbstractMesh<T, IDX, ndim> quad_mesh({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 1);
+    std::vector<IDX> nelem{3, 2};
+    std::vector<T> xmin{-1.0, -1.0}, xmax{1.0, 1.0}, quad_ratio{0.0, 0.0};
+    std::vector<BOUNDARY_CONDITIONS> bcs(4, BOUNDARY_CONDITIONS::DIRICHLET);
+    std::vector<int> bcflags{0, 0, 0, 0};
+    AbstractMesh<T, IDX, ndim> tri_mesh = mixed_uniform_mesh<T, IDX>(nelem, xmin, xmax, quad_ratio, bcs, bcflags).value();
+
+    auto test_mesh = [&]<int pn_basis>(AbstractMesh<T, IDX, ndim>& mesh, FESPACE_ENUMS::FESPACE_BASIS_TYPE btype){
+        FESpace<T, IDX, ndim> fespace{&mesh, btype, FESPACE_ENUMS::GAUSS_LEGENDRE, tmp::compile_int<pn_basis>()};
+        fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+        std::vector<T> u_data(u_layout.size());
+        fespan u{u_data.data(), u_layout};
+        auto func = [](const T* x, T* out){ out[0] = std::sin(x[0]) * std::cos(2.0 * x[1]) + 1.0; };
+        Projection<T, IDX, ndim, 1> projection{func};
+        solvers::LinearFormSolver{fespace, projection}.solve(u);
+
+        for(IDX ibatch = 0; ibatch < fespace.element_batches.nrow(); ++ibatch){
+            fespace.dispatch_element_kernel(ibatch, 
+                [&]<class TransT, class SizesT>(std::type_identity<TransT> trans_tag, 
+                    std::type_identity<SizesT> sizes_tag, std::span<const IDX> elidxs)
+            {
+                // every configuration here is in the registry
+                ASSERT_FALSE(std::is_void_v<SizesT>);
+                if constexpr (!std::is_void_v<SizesT>) {
+                    for(IDX iel : elidxs){
+                        const FiniteElement<T, IDX, ndim>& el = fespace.elements[iel];
+                        ASSERT_EQ(el.nbasis(), SizesT::nbasis);
+                        ASSERT_EQ(el.nQP(), SizesT::nqp);
+
+                        auto el_layout = u.create_element_layout(el.elidx);
+                        std::vector<T> uel_data(el_layout.size()), generic_data(el_layout.size()), 
+                            fixed_data(el_layout.size());
+                        dofspan u_el{uel_data.data(), el_layout};
+                        dofspan res_generic{generic_data.data(), el_layout};
+                        dofspan res_fixed{fixed_data.data(), el_layout};
+                        extract_elspan(el.elidx, u, u_el);
+
+                        res_generic = 0;
+                        disc.domain_integral(el, u_el, res_generic);
+                        res_fixed = 0;
+                        disc.domain_integral(el, u_el, res_fixed, trans_tag, sizes_tag);
+                        for(int idof = 0; idof < el.nbasis(); ++idof)
+                            ASSERT_NEAR((res_generic[idof, 0]), (res_fixed[idof, 0]), 1e-12);
+                    }
+                }
+            });
+        }
+    };
+
+    NUMTOOL::TMP::constexpr_for_range<1, 5>([&]<int pn_basis>{
+        test_mesh.template operator()<pn_basis>(quad_mesh, FESPACE_ENUMS::LAGRANGE);
+        test_mesh.template operator()<pn_basis>(quad_mesh, FESPACE_ENUMS::LEGENDRE);
+        test_mesh.template operator()<pn_basis>(tri_mesh, FESPACE_ENUMS::LAGRANGE);
+    });
+}
+
+TEST(test_fespace, test_tensor_product_inverse_mass){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+    static constexpr int pn_basis = 2;
+
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {3, 3}, 1);
+
+    // shear the mesh so the elements are parallelograms, then move a node to make some elements bilinear
+    for(IDX inode = 0; inode < mesh.n_nodes(); ++inode)
+        { mesh.coord[inode][0] += 0.3 * mesh.coord[inode][1]; }
+    mesh.update_coord_els();
+    IDX inode = -1;
+    for(IDX jnode = 0; jnode < mesh.n_nodes(); ++jnode){
+        if(std::abs(mesh.coord[jnode][1]) < 0.5 && std::abs(mesh.coord[jnode][0] - 0.3 * mesh.coord[jnode][1]) < 0.5)
+            { inode = jnode; break; }
+    }
+    ASSERT_GE(inode, 0);
+    mesh.coord[inode][0] += 0.05;
+    mesh.update_node(inode);
+
+    for(auto quadrature_type : {FESPACE_ENUMS::GAUSS_LOBATTO, FESPACE_ENUMS::GAUSS_LEGENDRE}){
+        FESpace<T, IDX, ndim> fespace{
+            &mesh, FESPACE_ENUMS::LAGRANGE, quadrature_type,
+            tmp::compile_int<pn_basis>()
+        };
+        fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 2>{}};
+        std::vector<T> res_data(layout.size()), exact_data(layout.size()), tp_data(layout.size());
+        for(std::size_t i = 0; i < res_data.size(); ++i) res_data[i] = std::sin(0.3 * i + 1.0);
+        fespan res{res_data.data(), layout};
+        fespan exact{exact_data.data(), layout};
+        fespan tp{tp_data.data(), layout};
+
+        solvers::InverseMassOperator<T, IDX> minv{fespace};
+        minv.apply(1.0, res, 0.0, exact);
+
+        // exact on affine elements and collocated bases (dense fallback for the curved elements otherwise)
+        solvers::TensorProductInverseMassOperator<T, IDX> minv_tp{fespace};
+        std::ranges::fill(tp_data, 1.0);
+        minv_tp.apply(2.0, res, -1.0, tp);
+        for(std::size_t i = 0; i < tp_data.size(); ++i)
+            ASSERT_NEAR(tp_data[i], 2.0 * exact_data[i] - 1.0, 1e-10);
+
+        // the weight adjusted inverse is close on the curved elements
+        solvers::TensorProductInverseMassOperator<T, IDX> minv_wadg{fespace, true};
+        minv_wadg.apply(1.0, res, 0.0, tp);
+        for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+            for(int idof = 0; idof < el.nbasis(); ++idof){
+                for(int iv = 0; iv < 2; ++iv){
+                    T scale = std::max(std::abs(exact[el.elidx, idof, iv]), 1.0);
+                    if(el.is_affine() || quadrature_type == FESPACE_ENUMS::GAUSS_LOBATTO)
+                        { ASSERT_NEAR((tp[el.elidx, idof, iv]), (exact[el.elidx, idof, iv]), 1e-10 * scale); }
+                    else
+                        { ASSERT_NEAR((tp[el.elidx, idof, iv]), (exact[el.elidx, idof, iv]), 1e-2 * scale); }
+                }
+            }
+        }
+
+        // the block application to all the components matches the per component application
+        for(const solvers::TensorProductInverseMassOperator<T, IDX>* op : {&minv_tp, &minv_wadg}){
+            std::vector<T> scratch(op->scratch_size());
+            for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+                const std::size_t ndof = el.nbasis();
+                std::vector<T> b_block(2 * ndof), x_block(2 * ndof), b(ndof), x(ndof);
+                for(std::size_t idof = 0; idof < ndof; ++idof){
+                    for(int iv = 0; iv < 2; ++iv) b_block[idof * 2 + iv] = res[el.elidx, idof, iv];
+                }
+                op->element_apply_block(el.elidx, ndof, 2, b_block.data(), x_block.data(), scratch.data());
+                for(int iv = 0; iv < 2; ++iv){
+                    for(std::size_t idof = 0; idof < ndof; ++idof) b[idof] = b_block[idof * 2 + iv];
+                    op->element_apply(el.elidx, ndof, b.data(), x.data(), scratch.data());
+                    for(std::size_t idof = 0; idof < ndof; ++idof)
+                        { ASSERT_NEAR(x_block[idof * 2 + iv], x[idof], 1e-12 * std::max(std::abs(x[idof]), 1.0)); }
+                }
+            }
+        }
+    }
+}
+
+TEST(test_fespace, test_orthonormal_inverse_mass){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+    static constexpr int pn_basis = 3;
+
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 1);
+    for(IDX inode = 0; inode < mesh.n_nodes(); ++inode)
+        { mesh.coord[inode][0] += 0.3 * mesh.coord[inode][1]; }
+    mesh.update_coord_els();
+
+    FESpace<T, IDX, ndim> fespace{
+        &mesh, FESPACE_ENUMS::LEGENDRE, FESPACE_ENUMS::GAUSS_LEGENDRE,
+        tmp::compile_int<pn_basis>()
+    };
+
+    fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    std::vector<T> res_data(layout.size()), u_data(layout.size()), u_tp_data(layout.size());
+    for(std::size_t i = 0; i < res_data.size(); ++i) res_data[i] = std::cos(0.7 * i);
+    fespan res{res_data.data(), layout};
+    fespan u{u_data.data(), layout};
+    fespan u_tp{u_tp_data.data(), layout};
+    solvers::InverseMassOperator<T, IDX> minv{fespace};
+    solvers::TensorProductInverseMassOperator<T, IDX> minv_tp{fespace};
+    minv.apply(1.0, res, 0.0, u);
+    minv_tp.apply(1.0, res, 0.0, u_tp);
+
+    for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+        ASSERT_TRUE(has_diagonal_mass(el));
+
+        // the diagonal inverse satisfies M u = res with the full mass matrix
+        auto mass = calculate_mass_matrix(el);
+        for(int idof = 0; idof < el.nbasis(); ++idof){
+            T mu = 0.0;
+            for(int jdof = 0; jdof < el.nbasis(); ++jdof) mu += mass[idof][jdof] * u[el.elidx, jdof, 0];
+            ASSERT_NEAR(mu, (res[el.elidx, idof, 0]), 1e-12);
+            ASSERT_NEAR((u_tp[el.elidx, idof, 0]), (u[el.elidx, idof, 0]), 1e-12);
+        }
+    }
+
+    // projection of a polynomial in the space is exact
+    auto func = [](const T* x, T* out){ out[0] = 1.0 + x[0] * x[1] - 0.5 * x[1] * x[1] * x[1]; };
+    Projection<T, IDX, ndim, 1> projection{func};
+    solvers::LinearFormSolver{fespace, projection}.solve(u);
+    for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+        for(int iqp = 0; iqp < el.nQP(); ++iqp){
+            std::vector<T> bi(el.nbasis());
+            el.eval_basis(el.getQP(iqp).abscisse, bi.data());
+            T uqp = 0.0;
+            for(int idof = 0; idof < el.nbasis(); ++idof) uqp += bi[idof] * u[el.elidx, idof, 0];
+            auto x = el.transform(el.getQP(iqp).abscisse);
+            T fx;
+            func(x, &fx);
+            ASSERT_NEAR(uqp, fx, 1e-12);
+        }
+    }
+}
+
+TEST(test_fespace, test_cg_mass_matrix){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {4, 3}, 2);
+    for(IDX inode = 0; inode < mesh.n_nodes(); ++inode)
+        { mesh.coord[inode][0] += 0.2 * mesh.coord[inode][1]; }
+    mesh.update_coord_els();
+    FESpace<T, IDX, ndim> fespace{&mesh};
+
+    // elements of a color do not share dofs
+    solvers::CGWorkspace<T, IDX> workspace{fespace, 1};
+    std::vector<int> touched(fespace.cg_map.size(), -1);
+    IDX ncolored = 0;
+    for(IDX icolor = 0; icolor < workspace.element_colors.nrow(); ++icolor){
+        for(IDX iel : workspace.element_colors.rowspan(icolor)){
+            ++ncolored;
+            for(IDX idof : mesh.conn_el.rowspan(iel)){
+                ASSERT_NE(touched[idof], icolor);
+                touched[idof] = icolor;
+            }
+        }
+    }
+    ASSERT_EQ(ncolored, mesh.nelem());
+
+    fe_layout_right layout{fespace.cg_map, std::integral_constant<std::size_t, 2>{}};
+    std::vector<T> u_data(layout.size()), b_data(layout.size()), x_data(layout.size());
+    fespan b{b_data.data(), layout};
+    fespan x{x_data.data(), layout};
+
+    // 1^T M 1 is the area of the domain (sheared square)
+    solvers::CGMassMatrix<T, IDX> mass{fespace};
+    std::ranges::fill(u_data, 1.0);
+    mass.multiply(u_data.data(), b_data.data(), 2, 1);
+    T area = 0.0;
+    for(IDX idof = 0; idof < fespace.cg_map.size(); ++idof) area += b_data[idof * 2 + 1];
+    ASSERT_NEAR(area, 4.0, 1e-12);
+
+    // the conjugate gradient solve inverts the consistent mass matrix
+    for(std::size_t i = 0; i < u_data.size(); ++i) u_data[i] = std::sin(0.7 * i + 0.2);
+    for(int iv = 0; iv < 2; ++iv) mass.multiply(u_data.data(), b_data.data(), 2, iv);
+    std::ranges::fill(x_data, 1.0);
+    mass.apply_inverse(2.0, b, -1.0, x);
+    for(std::size_t i = 0; i < u_data.size(); ++i)
+        ASSERT_NEAR(x_data[i], 2.0 * u_data[i] - 1.0, 1e-9);
+    ASSERT_GT(mass.last_nit, 0);
+
+    // the lumped mass matrix preserves the area
+    solvers::CGMassMatrix<T, IDX> lumped_mass{fespace, true};
+    std::ranges::fill(u_data, 1.0);
+    lumped_mass.multiply(u_data.data(), b_data.data(), 2, 0);
+    area = 0.0;
+    for(IDX idof = 0; idof < fespace.cg_map.size(); ++idof) area += b_data[idof * 2];
+    ASSERT_NEAR(area, 4.0, 1e-12);
+    lumped_mass.apply_inverse(1.0, b, 0.0, x);
+    for(IDX idof = 0; idof < fespace.cg_map.size(); ++idof) ASSERT_NEAR(x_data[idof * 2], 1.0, 1e-12);
+}
+
+TEST(test_fespace, test_hdg_static_condensation){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+
+    // dirichlet everywhere except the right face
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 1,
+        {BOUNDARY_CONDITIONS::DIRICHLET, BOUNDARY_CONDITIONS::DIRICHLET,
+         BOUNDARY_CONDITIONS::NEUMANN, BOUNDARY_CONDITIONS::DIRICHLET}, {0, 0, 0, 0});
+    FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, tmp::compile_int<2>()};
+
+    // the solution is in the space so HDG reproduces it
+    auto exact = [](const T* x){ return x[0] * x[0] + x[0] * x[1] + 0.5 * x[1]; };
+    HDGDiffusion<T, ndim> disc{};
+    disc.source = [](const T*, T* f){ f[0] = -2.0; };
+    disc.dirichlet_callbacks.push_back([&](const T* x, T* out){ out[0] = exact(x); });
+    disc.neumann_callbacks.push_back([](const T* x, T* out){ out[0] = 2.0 * x[0] + x[1]; });
+
+    solvers::HDGSolver<T, IDX, ndim, HDGDiffusion<T, ndim>> solver{fespace, disc};
+
+    // 3 trace unknowns on each of the 7 interior faces and 2 neumann faces
+    ASSERT_EQ(solver.nsystem(), 27);
+    ASSERT_LT(solver.nsystem(), fespace.ndof_dg());
+
+    std::vector<T> u_data(fespace.ndof_dg());
+    fe_layout_right layout{fespace.dg_map, tmp::to_size<1>{}};
+    fespan u{u_data.data(), layout};
+    ASSERT_TRUE(solver.solve(u));
+    ASSERT_GT(solver.last_nit, 0);
+
+    for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+        for(int ig = 0; ig < el.nQP(); ++ig){
+            MATH::GEOMETRY::Point<T, ndim> x = el.transform(el.getQP(ig).abscisse);
+            T uh = 0.0;
+            for(int ibasis = 0; ibasis < el.nbasis(); ++ibasis) uh += u[el.elidx, ibasis, 0] * el.basis_qp(ig, ibasis);
+            ASSERT_NEAR(uh, exact(x), 1e-9);
+        }
+    }
+}
+
+TEST(test_fespace, test_element_cfl){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+    static constexpr int pn_basis = 2;
+
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {4, 2}, 1);
+    FESpace<T, IDX, ndim> fespace{
+        &mesh, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LEGENDRE,
+        tmp::compile_int<pn_basis>()
+    };
+    fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    std::vector<T> u_data(u_layout.size());
+    fespan u{u_data.data(), u_layout};
+    auto func = [](const T* x, T* out){ out[0] = 2.0 + x[0]; };
+    Projection<T, IDX, ndim, 1> projection{func};
+    solvers::LinearFormSolver{fespace, projection}.solve(u);
+
+    BurgersCoefficients<T, ndim> burgers_coeffs{};
+    burgers_coeffs.mu = 0.01;
+    burgers_coeffs.b[0] = 1.0;
+    ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                          BurgersUpwind{burgers_coeffs},
+                          BurgersDiffusionFlux{burgers_coeffs}};
+
+    auto domain_integrals = [&]{
+        for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+            auto el_layout = u.create_element_layout(el.elidx);
+            std::vector<T> uel_data(el_layout.size()), res_data(el_layout.size());
+            dofspan u_el{uel_data.data(), el_layout};
+            dofspan res_el{res_data.data(), el_layout};
+            extract_elspan(el.elidx, u, u_el);
+            res_el = 0;
+            disc.domain_integral(el, u_el, res_el);
+        }
+    };
+
+    // no element wavespeeds yet: global timestep for every element
+    solvers::CFLTimestep<T, IDX> timestep{0.3};
+    domain_integrals();
+    T dt_global = timestep(fespace, disc, u);
+    ASSERT_TRUE(disc.track_element_wavespeeds);
+    ASSERT_EQ(timestep.element_timesteps().size(), fespace.elements.size());
+    for(T dt_el : timestep.element_timesteps()) ASSERT_EQ(dt_el, dt_global);
+
+    // element local wavespeeds: 0.5 * u = 1 + x / 2 grows to the right
+    domain_integrals();
+    T dt = timestep(fespace, disc, u);
+    std::span<const T> dt_el = timestep.element_timesteps();
+    ASSERT_EQ(dt, *std::ranges::min_element(dt_el));
+    // the global timestep uses the maximum wavespeed over all elements
+    ASSERT_GE(dt, dt_global * (1.0 - 1e-12));
+    for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+        T xmax = -1.0;
+        for(int iqp = 0; iqp < el.nQP(); ++iqp)
+            xmax = std::max(xmax, el.transform(el.getQP(iqp).abscisse)[0]);
+        T lambda = 1.0 + 0.5 * xmax;
+        ASSERT_NEAR(disc.element_wavespeeds[el.elidx], lambda, 1e-12);
+        // reference length: sqrt of the jacobian determinant for 0.5 x 1.0 elements
+        T reflen = std::sqrt(0.25 * 0.5);
+        ASSERT_NEAR(dt_el[el.elidx], 0.3 * reflen / (0.01 / reflen + lambda) / 5.0, 1e-12);
+    }
+
+    // local timesteps are the element timesteps
+    std::vector<T> dt_local = timestep.local_timesteps(fespace, disc, u);
+    for(std::size_t iel = 0; iel < dt_local.size(); ++iel) ASSERT_EQ(dt_local[iel], dt_el[iel]);
+}
+
+TEST_F(Box2dLagrangeP2, test_error_norms){
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+    fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, 2>{}};
+    std::vector<T> u_data(u_layout.size(), 0.0);
+    fespan u{u_data.data(), u_layout};
+
+    // components: (x, 1 + y^2)
+    batched_exact_solution<T> exact = [](int npoin, const T* x, T* uex, T* gradex){
+        for(int ipoin = 0; ipoin < npoin; ++ipoin){
+            const T* xpt = x + ipoin * ndim;
+            uex[2 * ipoin] = xpt[0];
+            uex[2 * ipoin + 1] = 1.0 + xpt[1] * xpt[1];
+            if(gradex != nullptr){
+                T* gpt = gradex + ipoin * 2 * ndim;
+                gpt[0] = 1.0; gpt[1] = 0.0;
+                gpt[2] = 0.0; gpt[3] = 2.0 * xpt[1];
+            }
+        }
+    };
+
+    // error of the zero solution is the norm of the exact solution
+    ErrorNorms<T> norms = error_norms(exact, fespace, u);
+    ASSERT_NEAR(norms.l2[0], std::sqrt(4.0 / 3.0), 1e-12);
+    ASSERT_NEAR(norms.l2[1], std::sqrt(2.0 * (2.0 + 4.0 / 3.0 + 2.0 / 5.0)), 1e-12);
+    ASSERT_NEAR(norms.h1_semi[0], 2.0, 1e-12);
+    ASSERT_NEAR(norms.h1_semi[1], std::sqrt(2.0 * 8.0 / 3.0), 1e-12);
+    ASSERT_NEAR(norms.l2_total(), std::sqrt(4.0 / 3.0 + 2.0 * (2.0 + 4.0 / 3.0 + 2.0 / 5.0)), 1e-12);
+    // maximum at the quadrature points is within the domain bounds
+    ASSERT_GT(norms.linf[0], 0.5);
+    ASSERT_LT(norms.linf[0], 1.0);
+    ASSERT_EQ(norms.linf_total(), std::max(norms.linf[0], norms.linf[1]));
+
+    // without the gradients the H1 seminorm is not computed
+    ErrorNorms<T> norms_l2 = error_norms(exact, fespace, u, false);
+    ASSERT_EQ(norms_l2.h1_semi[0], 0.0);
+    ASSERT_EQ(norms_l2.l2[1], norms.l2[1]);
+
+    // the projection of the exact solution is exact in the p = 2 space
+    auto func = [](const T* x, T* out){ out[0] = x[0]; out[1] = 1.0 + x[1] * x[1]; };
+    Projection<T, IDX, ndim, 2> projection{func};
+    solvers::LinearFormSolver{fespace, projection}.solve(u);
+    norms = error_norms(exact, fespace, u, true, true);
+    for(int iv = 0; iv < 2; ++iv){
+        ASSERT_NEAR(norms.l2[iv], 0.0, 1e-12);
+        ASSERT_NEAR(norms.linf[iv], 0.0, 1e-12);
+        ASSERT_NEAR(norms.h1_semi[iv], 0.0, 1e-10);
+    }
+}
+
+TEST_F(Box2dLagrangeP2, test_batched_projection){
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+    fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, 2>{}};
+    std::vector<T> u_data(u_layout.size(), 0.0), u_batch_data(u_layout.size(), 0.0),
+        u_serial_data(u_layout.size(), 0.0);
+    fespan u{u_data.data(), u_layout};
+    fespan u_batch{u_batch_data.data(), u_layout};
+    fespan u_serial{u_serial_data.data(), u_layout};
+
+    auto func = [](const T* x, T* out){ out[0] = std::sin(x[0]) * x[1]; out[1] = std::exp(x[0] - x[1]); };
+    Projection<T, IDX, ndim, 2> projection{func};
+    solvers::LinearFormSolver{fespace, projection}.solve(u);
+
+    // one call over many points gives the same projection (including over several chunks)
+    ProjectionBatchFunction<T> batch_func = [&func](std::size_t npoint, const T* x, T* out){
+        for(std::size_t ipoint = 0; ipoint < npoint; ++ipoint) func(x + ipoint * ndim, out + ipoint * 2);
+    };
+    Projection<T, IDX, ndim, 2> batch_projection{batch_func};
+    solvers::LinearFormSolver batch_solver{fespace, batch_projection};
+    batch_solver.batch_size = 4;
+    batch_solver.solve(u_batch);
+
+    // functions that are not thread safe are evaluated serially
+    Projection<T, IDX, ndim, 2> serial_projection{func};
+    serial_projection.thread_safe = false;
+    solvers::LinearFormSolver{fespace, serial_projection}.solve(u_serial);
+
+    for(std::size_t i = 0; i < u_data.size(); ++i){
+        ASSERT_NEAR(u_batch_data[i], u_data[i], 1e-13);
+        ASSERT_NEAR(u_serial_data[i], u_data[i], 1e-13);
+    }
+}
+
+TEST(test_fespace, test_ensemble_residual){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+    static constexpr int nens = 2;
+
+    std::vector<IDX> nelem{3, 2};
+    std::vector<T> xmin{-1.0, -1.0}, xmax{1.0, 1.0}, quad_ratio{0.5, 0.5};
+    std::vector<BOUNDARY_CONDITIONS> bcs(4, BOUNDARY_CONDITIONS::DIRICHLET);
+    std::vector<int> bcflags{0, 0, 0, 0};
+    AbstractMesh<T, IDX, ndim> mesh = mixed_uniform_mesh<T, IDX>(nelem, xmin, xmax, quad_ratio, bcs, bcflags).value();
+    FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LEGENDRE,
+        tmp::compile_int<2>()};
+
+    // members with different physical parameters and boundary conditions
+    std::array<BurgersCoefficients<T, ndim>, nens> coeffs{};
+    coeffs[0].mu = 0.01;
+    coeffs[0].a[0] = 1.0;
+    coeffs[0].a[1] = -0.5;
+    coeffs[1].mu = 0.1;
+    coeffs[1].b[0] = 0.5;
+    coeffs[1].b[1] = 0.25;
+    std::array<std::function<void(const T*, T*)>, nens> dirichlet_values{
+        [](const T* x, T* out){ out[0] = x[0]; },
+        [](const T* x, T* out){ out[0] = 1.0 + x[1]; }
+    };
+    std::array<std::function<void(const T*, T*)>, nens> ics{
+        [](const T* x, T* out){ out[0] = std::sin(x[0]) * std::cos(2.0 * x[1]) + 1.0; },
+        [](const T* x, T* out){ out[0] = x[0] * x[1] + 0.5; }
+    };
+
+    using PFlux = BurgersFlux<T, ndim>;
+    using CFlux = BurgersUpwind<T, ndim>;
+    using DFlux = BurgersDiffusionFlux<T, ndim>;
+    ConservationLawDDG ensemble_disc{
+        EnsemblePhysicalFlux<PFlux, nens>{{PFlux{coeffs[0]}, PFlux{coeffs[1]}}},
+        EnsembleConvectiveFlux<CFlux, nens>{{CFlux{coeffs[0]}, CFlux{coeffs[1]}}},
+        EnsembleDiffusiveFlux<DFlux, nens>{{DFlux{coeffs[0]}, DFlux{coeffs[1]}}}
+    };
+    ensemble_disc.dirichlet_callbacks.push_back(interleave_member_functions<1>(dirichlet_values));
+
+    fe_layout_right ens_layout{fespace.dg_map, std::integral_constant<std::size_t, nens>{}};
+    std::vector<T> u_data(ens_layout.size()), res_data(ens_layout.size());
+    fespan u{u_data.data(), ens_layout};
+    fespan res{res_data.data(), ens_layout};
+    Projection<T, IDX, ndim, nens> projection{interleave_member_functions<1>(ics)};
+    solvers::LinearFormSolver{fespace, projection}.solve(u);
+    solvers::form_residual(fespace, ensemble_disc, u, res);
+
+    // the per-component norms accumulated during the residual evaluation
+    solvers::ResidualWorkspace<T, IDX> workspace{fespace, nens};
+    workspace.enable_norm_monitor(nens);
+    solvers::form_residual(fespace, ensemble_disc, u, res, workspace);
+    std::array<T, nens> sumsq{}, maxabs{};
+    for(std::size_t i = 0; i < res_data.size(); ++i){
+        sumsq[i % nens] += res_data[i] * res_data[i];
+        maxabs[i % nens] = std::max(maxabs[i % nens], std::abs(res_data[i]));
+    }
+    for(int iv = 0; iv < nens; ++iv){
+        ASSERT_NEAR(workspace.monitor.l2(iv), std::sqrt(sumsq[iv]), 1e-12);
+        ASSERT_DOUBLE_EQ(workspace.monitor.linf(iv), maxabs[iv]);
+    }
+    ASSERT_NEAR(workspace.monitor.l2(), res.vector_norm(), 1e-12);
+
+    // the element-centric traversal forms the same residual (up to the summation order) and norms
+    solvers::ResidualWorkspace<T, IDX> fused_workspace{fespace, nens};
+    fused_workspace.enable_norm_monitor(nens);
+    fused_workspace.enable_element_centric(fespace, nens);
+    ASSERT_EQ(fused_workspace.trace_res_offsets.size(), fespace.interior_trace_end - fespace.interior_trace_start);
+    std::vector<T> fused_res_data(ens_layout.size(), 1.0);
+    fespan fused_res{fused_res_data.data(), ens_layout};
+    solvers::form_residual(fespace, ensemble_disc, u, fused_res, fused_workspace);
+    for(std::size_t i = 0; i < res_data.size(); ++i)
+        ASSERT_NEAR(fused_res_data[i], res_data[i], 1e-12);
+    for(int iv = 0; iv < nens; ++iv)
+        ASSERT_NEAR(fused_workspace.monitor.l2(iv), workspace.monitor.l2(iv), 1e-12);
+
+    // each member of the ensemble residual is the residual of that member alone
+    fe_layout_right member_layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    std::vector<T> umember_data(member_layout.size()), resmember_data(member_layout.size()),
+        resens_data(member_layout.size());
+    fespan u_member{umember_data.data(), member_layout};
+    fespan res_member{resmember_data.data(), member_layout};
+    fespan res_ensemble_member{resens_data.data(), member_layout};
+    for(int imember = 0; imember < nens; ++imember){
+        ConservationLawDDG disc{PFlux{coeffs[imember]}, CFlux{coeffs[imember]}, DFlux{coeffs[imember]}};
+        disc.dirichlet_callbacks.push_back(dirichlet_values[imember]);
+        extract_ensemble_member(u, nens, imember, u_member);
+        solvers::form_residual(fespace, disc, u_member, res_member);
+        extract_ensemble_member(res, nens, imember, res_ensemble_member);
+        ASSERT_GT(res_member.vector_norm(), 1e-8);
+        for(std::size_t i = 0; i < member_layout.size(); ++i)
+            ASSERT_NEAR(resmember_data[i], resens_data[i], 1e-12);
+
+        // inserting the member back leaves the ensemble unchanged
+        std::vector<T> u_copy = u_data;
+        insert_ensemble_member(u_member, nens, imember, u);
+        ASSERT_EQ(u_copy, u_data);
+    }
+}
+
+TEST_F(Box2dLagrangeP2, test_fused_rk_stage){
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+    fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    std::vector<T> u_data(layout.size()), w_data(layout.size()), res_data(layout.size()),
+        k_data(layout.size()), y_data(layout.size()), fused_data(layout.size(), 1.0);
+    fespan u{u_data.data(), layout};
+    fespan w{w_data.data(), layout};
+    fespan res{res_data.data(), layout};
+    fespan k{k_data.data(), layout};
+    fespan y{y_data.data(), layout};
+    fespan fused{fused_data.data(), layout};
+
+    Projection<T, IDX, ndim, 1> projection{[](const T* x, T* out){ out[0] = std::sin(x[0]) * std::cos(x[1]); }};
+    solvers::LinearFormSolver{fespace, projection}.solve(u);
+    for(std::size_t i = 0; i < w_data.size(); ++i) w_data[i] = u_data[i] + 0.01 * std::cos(0.7 * i);
+
+    BurgersCoefficients<T, ndim> burgers_coeffs{};
+    burgers_coeffs.mu = 0.01;
+    burgers_coeffs.a[0] = 1.0;
+    burgers_coeffs.a[1] = -0.5;
+    burgers_coeffs.b[0] = 0.5;
+    ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                          BurgersUpwind{burgers_coeffs},
+                          BurgersDiffusionFlux{burgers_coeffs}};
+
+    // the separate passes: y = alpha * u + beta * w + gamma * M^{-1} R(w)
+    const T alpha = 0.75, beta = 0.25, gamma = 0.01;
+    solvers::TensorProductInverseMassOperator<T, IDX> inv_mass{fespace};
+    solvers::form_residual(fespace, disc, w, res);
+    inv_mass.apply(1.0, res, 0.0, k);
+    rk_stage_update(alpha, u, beta, w, gamma, k, y);
+
+    // fused per element, for both traversals
+    for(bool element_centric : {false, true}){
+        solvers::ResidualWorkspace<T, IDX> workspace{fespace, 1};
+        if(element_centric) workspace.enable_element_centric(fespace, 1);
+        solvers::FusedRKStage<T, IDX> stage{};
+        stage(fespace, disc, workspace, inv_mass, w, res, alpha, u, beta, gamma, fused);
+        for(std::size_t i = 0; i < y_data.size(); ++i)
+            ASSERT_NEAR(fused_data[i], y_data[i], 1e-12);
+
+        // the output may be the solution at the start of the step
+        std::vector<T> u_copy = u_data;
+        fespan u_inplace{u_copy.data(), layout};
+        stage(fespace, disc, workspace, inv_mass, w, res, alpha, u_inplace, beta, gamma, u_inplace);
+        for(std::size_t i = 0; i < y_data.size(); ++i)
+            ASSERT_NEAR(u_copy[i], y_data[i], 1e-12);
+    }
+}
+
+TEST_F(Box2dLagrangeP2, test_low_storage_rk_order){
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+    fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+
+    // smooth periodic advection diffusion
+    BurgersCoefficients<T, ndim> burgers_coeffs{};
+    burgers_coeffs.mu = 0.05;
+    burgers_coeffs.a[0] = 1.0;
+    burgers_coeffs.a[1] = 0.5;
+    ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                          BurgersUpwind{burgers_coeffs},
+                          BurgersDiffusionFlux{burgers_coeffs}};
+    Projection<T, IDX, ndim, 1> projection{[](const T* x, T* out){
+        out[0] = std::sin(std::numbers::pi * x[0]) * std::cos(std::numbers::pi * x[1]);
+    }};
+
+    const T tfinal = 0.2;
+    auto integrate = [&](int order, T dt) -> std::vector<T> {
+        std::vector<T> u_data(layout.size());
+        fespan u{u_data.data(), layout};
+        solvers::LinearFormSolver{fespace, projection}.solve(u);
+        solvers::LowStorageRK solver{fespace, disc, solvers::FixedTimestep<T, IDX>{dt},
+            solvers::TfinalTermination<T, IDX>{tfinal}, order};
+        solver.vis_callback = [](auto&){};
+        solver.solve(fespace, disc, u);
+        EXPECT_NEAR(solver.time, tfinal, 1e-12);
+        return u_data;
+    };
+    auto l2_diff = [](const std::vector<T>& a, const std::vector<T>& b){
+        T sum = 0;
+        for(std::size_t i = 0; i < a.size(); ++i) sum += (a[i] - b[i]) * (a[i] - b[i]);
+        return std::sqrt(sum);
+    };
+
+    // self convergence in time against a fine reference (the spatial error is the same for every dt)
+    std::vector<T> uref = integrate(4, tfinal / 400);
+    for(int order : {3, 4}){
+        T err_coarse = l2_diff(integrate(order, tfinal / 10), uref);
+        T err_fine = l2_diff(integrate(order, tfinal / 20), uref);
+        T rate = std::log2(err_coarse / err_fine);
+        ASSERT_GT(rate, order - 0.3);
+        ASSERT_LT(rate, order + 0.5);
+    }
+}
+
+TEST_F(Box2dLagrangeP2, test_anderson_acceleration){
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+    fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+
+    // pure diffusion on the periodic box: the fixed point of explicit euler is the mean value 1
+    BurgersCoefficients<T, ndim> burgers_coeffs{};
+    burgers_coeffs.mu = 0.2;
+    ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                          BurgersUpwind{burgers_coeffs},
+                          BurgersDiffusionFlux{burgers_coeffs}};
+    Projection<T, IDX, ndim, 1> projection{[](const T* x, T* out){
+        out[0] = 1.0 + std::sin(std::numbers::pi * x[0]) * std::cos(std::numbers::pi * x[1]);
+    }};
+
+    // the number of fixed point iterations to converge with the given window (0 is the plain iteration)
+    auto iterations = [&](IDX window) -> IDX {
+        std::vector<T> u_data(layout.size());
+        fespan u{u_data.data(), layout};
+        solvers::LinearFormSolver{fespace, projection}.solve(u);
+        solvers::ExplicitEuler solver{fespace, disc, solvers::FixedTimestep<T, IDX>{0.005},
+            solvers::TimestepTermination<T, IDX>{5000}};
+        solver.vis_callback = [](auto&){};
+        solvers::AndersonAcceleration accel{solver};
+        accel.vis_callback = [](auto&){};
+        accel.window = window;
+        accel.tol = 1e-10;
+        accel.solve(fespace, disc, u);
+        EXPECT_LE(accel.fixed_point_residual, accel.tol);
+        for(T value : u_data) EXPECT_NEAR(value, 1.0, 1e-6);
+        return accel.itime;
+    };
+
+    IDX plain = iterations(0);
+    IDX accelerated = iterations(5);
+    ASSERT_LT(plain, 5000);
+    ASSERT_LT(2 * accelerated, plain);
+}
+
+TEST_F(Box2dLagrangeP2, test_parareal){
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+    fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+
+    BurgersCoefficients<T, ndim> burgers_coeffs{};
+    burgers_coeffs.mu = 0.02;
+    burgers_coeffs.a[0] = 1.0;
+    burgers_coeffs.a[1] = -0.5;
+    burgers_coeffs.b[0] = 0.5;
+    ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                          BurgersUpwind{burgers_coeffs},
+                          BurgersDiffusionFlux{burgers_coeffs}};
+    Projection<T, IDX, ndim, 1> projection{[](const T* x, T* out){
+        out[0] = 1.0 + 0.5 * std::sin(std::numbers::pi * x[0]) * std::cos(std::numbers::pi * x[1]);
+    }};
+    auto initial_condition = [&]{
+        std::vector<T> u_data(layout.size());
+        solvers::LinearFormSolver{fespace, projection}.solve(fespan{u_data.data(), layout});
+        return u_data;
+    };
+
+    // 5 slices is not a multiple of the rank count for 2, 3, or 4 ranks
+    const T tfinal = 0.2;
+    const IDX nslice = 5;
+    solvers::ExplicitEuler coarse{fespace, disc, solvers::FixedTimestep<T, IDX>{0.02},
+        solvers::TfinalTermination<T, IDX>{tfinal}};
+    solvers::RK3SSP fine{fespace, disc, solvers::FixedTimestep<T, IDX>{0.0025},
+        solvers::TfinalTermination<T, IDX>{tfinal}};
+
+    // the sequential fine propagation over the same slices
+    std::vector<T> uref_data = initial_condition();
+    fespan uref{uref_data.data(), layout};
+    for(IDX islice = 0; islice < nslice; ++islice){
+        fine.itime = 0;
+        fine.time = tfinal * islice / nslice;
+        fine.stop_condition.tfinal = (islice == nslice - 1) ? tfinal : tfinal * (islice + 1) / nslice;
+        while(!fine.stop_condition(fine.itime, fine.time)) fine.step(fespace, disc, uref);
+    }
+
+    auto max_diff = [&](const std::vector<T>& a){
+        T diff = 0;
+        for(std::size_t i = 0; i < a.size(); ++i) diff = std::max(diff, std::abs(a[i] - uref_data[i]));
+        return diff;
+    };
+
+    // one iteration only corrects the first slice
+    std::vector<T> u1_data = initial_condition();
+    solvers::Parareal parareal_1{coarse, fine, tfinal, nslice, 1};
+    parareal_1.vis_callback = [](auto&){};
+    parareal_1.solve(fespace, disc, fespan{u1_data.data(), layout});
+    ASSERT_EQ(parareal_1.iteration, 1);
+    ASSERT_GT(max_diff(u1_data), 1e-6);
+
+    // after nslice iterations every slice is the fine solution
+    std::vector<T> u_data = initial_condition();
+    solvers::Parareal parareal{coarse, fine, tfinal, nslice, nslice};
+    parareal.vis_callback = [](auto&){};
+    parareal.solve(fespace, disc, fespan{u_data.data(), layout});
+    ASSERT_LE(parareal.iteration, nslice);
+    ASSERT_NEAR(fine.time, tfinal, 1e-14);
+    ASSERT_LT(max_diff(u_data), 1e-12);
+}
+
+TEST(test_fespace, test_p_multigrid){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {4, 4}, 1,
+        {BOUNDARY_CONDITIONS::DIRICHLET, BOUNDARY_CONDITIONS::DIRICHLET,
+         BOUNDARY_CONDITIONS::DIRICHLET, BOUNDARY_CONDITIONS::DIRICHLET}, {0, 0, 0, 0});
+    FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LEGENDRE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, tmp::compile_int<2>()};
+
+    // steady advection diffusion with a zero solution
+    BurgersCoefficients<T, ndim> burgers_coeffs{};
+    burgers_coeffs.mu = 0.05;
+    burgers_coeffs.a[0] = 1.0;
+    burgers_coeffs.a[1] = 0.5;
+    ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                          BurgersUpwind{burgers_coeffs},
+                          BurgersDiffusionFlux{burgers_coeffs}};
+    disc.dirichlet_callbacks.push_back([](const T*, T* out){ out[0] = 0.0; });
+
+    solvers::ConvergenceCriteria<T, IDX> conv_criteria{};
+    conv_criteria.tau_abs = 0.0;
+    conv_criteria.tau_rel = 0.0;
+    conv_criteria.kmax = 10;
+    solvers::PMultigrid pmg{fespace, disc, conv_criteria, 0};
+    pmg.vis_callback = [](auto&, IDX){};
+    ASSERT_EQ(pmg.nlevel(), (std::size_t) 3);
+    ASSERT_EQ(pmg.level_order(1), 1);
+
+    // on affine elements the truncation of the modes is the L2 projection onto the coarse space
+    FESpace<T, IDX, ndim>& coarse_space = pmg.level_space(1);
+    fe_layout_right fine_layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    fe_layout_right coarse_layout{coarse_space.dg_map, std::integral_constant<std::size_t, 1>{}};
+    std::vector<T> fine_data(fine_layout.size()), prolonged_data(fine_layout.size(), 0.0),
+        coarse_data(coarse_layout.size()), coarse_proj_data(coarse_layout.size()),
+        roundtrip_data(coarse_layout.size());
+    fespan u_fine{fine_data.data(), fine_layout};
+    fespan u_prolonged{prolonged_data.data(), fine_layout};
+    fespan u_coarse{coarse_data.data(), coarse_layout};
+    fespan u_coarse_proj{coarse_proj_data.data(), coarse_layout};
+    fespan u_roundtrip{roundtrip_data.data(), coarse_layout};
+    // (quadratic so both quadrature rules integrate the projections exactly)
+    Projection<T, IDX, ndim, 1> projection{[](const T* x, T* out){
+        out[0] = x[0] * x[0] * x[1] - 0.5 * x[1] * x[1] + x[0];
+    }};
+    solvers::LinearFormSolver{fespace, projection}.solve(u_fine);
+    solvers::LinearFormSolver{coarse_space, projection}.solve(u_coarse_proj);
+    pmg.restrict_modes(1, u_fine, u_coarse);
+    for(std::size_t i = 0; i < coarse_data.size(); ++i) ASSERT_NEAR(coarse_data[i], coarse_proj_data[i], 1e-12);
+
+    // the prolongation of the low modes restricts back to the same modes
+    pmg.prolong_add(1, u_coarse, u_prolonged);
+    pmg.restrict_modes(1, u_prolonged, u_roundtrip);
+    ASSERT_EQ(roundtrip_data, coarse_data);
+
+    // and a function in the coarse space is unchanged by the round trip
+    Projection<T, IDX, ndim, 1> bilinear{[](const T* x, T* out){ out[0] = 1.0 + x[0] - 2.0 * x[1] + x[0] * x[1]; }};
+    solvers::LinearFormSolver{fespace, bilinear}.solve(u_fine);
+    std::ranges::fill(prolonged_data, 0.0);
+    pmg.restrict_modes(1, u_fine, u_coarse);
+    pmg.prolong_add(1, u_coarse, u_prolonged);
+    for(std::size_t i = 0; i < fine_data.size(); ++i) ASSERT_NEAR(prolonged_data[i], fine_data[i], 1e-12);
+
+    // V-cycles reduce the residual faster than the same number of smoothing iterations on the finest level alone
+    Projection<T, IDX, ndim, 1> ic{[](const T* x, T* out){
+        out[0] = std::cos(0.5 * std::numbers::pi * x[0]) * std::cos(0.5 * std::numbers::pi * x[1]);
+    }};
+    std::vector<T> u_mg_data(fine_layout.size()), u_smooth_data(fine_layout.size());
+    fespan u_mg{u_mg_data.data(), fine_layout};
+    fespan u_smooth{u_smooth_data.data(), fine_layout};
+    solvers::LinearFormSolver{fespace, ic}.solve(u_mg);
+    copy_fespan(u_mg, u_smooth);
+
+    solvers::PMultigrid smoother_only{fespace, disc, conv_criteria, 2};
+    smoother_only.vis_callback = [](auto&, IDX){};
+    ASSERT_EQ(smoother_only.nlevel(), (std::size_t) 1);
+    smoother_only.ncoarse = pmg.nu1 + pmg.nu2;
+
+    pmg.solve(u_mg);
+    smoother_only.solve(u_smooth);
+    ASSERT_TRUE(std::isfinite(pmg.res_norm));
+    ASSERT_LT(pmg.res_norm, smoother_only.res_norm);
+}
+
+TEST(test_fespace, test_p_adaptivity){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+    static constexpr int pn_basis = 2;
+
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 1);
+    FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LEGENDRE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, tmp::compile_int<pn_basis>()};
+    fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    std::vector<T> u_data(layout.size());
+    fespan u{u_data.data(), layout};
+
+    // modal coefficients decaying by a factor of 10 per order in each direction
+    for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+        for(int idof = 0; idof < el.nbasis(); ++idof){
+            int ijk[ndim];
+            solvers::impl::tensor_mode_ijk(idof, pn_basis + 1, ijk);
+            u[el.elidx, idof, 0] = (1.0 + 0.1 * el.elidx) * std::pow(10.0, -(ijk[0] + ijk[1]));
+        }
+    }
+
+    // the indicator is the fraction of the L2 energy in the highest modes (the Legendre modes are orthogonal)
+    std::vector<T> indicator = solvers::modal_decay_indicator(fespace, u);
+    for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+        T e_top = 0, e_total = 0;
+        for(int iqp = 0; iqp < el.nQP(); ++iqp){
+            auto bi = el.eval_basis_qp(iqp);
+            T u_top = 0, u_qp = 0;
+            for(int idof = 0; idof < el.nbasis(); ++idof){
+                int ijk[ndim];
+                solvers::impl::tensor_mode_ijk(idof, pn_basis + 1, ijk);
+                u_qp += u[el.elidx, idof, 0] * bi[idof];
+                if(std::max(ijk[0], ijk[1]) == pn_basis) u_top += u[el.elidx, idof, 0] * bi[idof];
+            }
+            T weight = el.getQP(iqp).weight;
+            e_top += u_top * u_top * weight;
+            e_total += u_qp * u_qp * weight;
+        }
+        ASSERT_NEAR(indicator[el.elidx], std::log10(e_top / e_total), 1e-10);
+    }
+
+    // the orders change by one across the thresholds and stay in [pmin, pmax]
+    solvers::PAdaptation<T> adaptation{};
+    adaptation.pmax = 3;
+    std::vector<T> synthetic{-2.0, -6.0, -10.0, -2.0, -6.0, -10.0};
+    std::vector<int> selected = adaptation.select_orders(fespace, std::span<const T>{synthetic});
+    ASSERT_EQ(selected, (std::vector<int>{3, 2, 1, 3, 2, 1}));
+    adaptation.pmax = 2;
+    adaptation.pmin = 2;
+    selected = adaptation.select_orders(fespace, std::span<const T>{synthetic});
+    for(int order : selected) ASSERT_EQ(order, pn_basis);
+
+    // raising then lowering the orders gives back the same coefficients
+    std::vector<T> u_saved = u_data;
+    std::vector<int> orders_raised(fespace.elements.size()), orders_initial(fespace.elements.size(), pn_basis);
+    for(IDX iel = 0; iel < (IDX) orders_raised.size(); ++iel) orders_raised[iel] = pn_basis + 1 + iel % 2;
+    solvers::p_adapt<1>(fespace, std::span<const int>{orders_raised}, u_data);
+    ASSERT_EQ(u_data.size(), fespace.dg_map.calculate_size_requirement(1));
+    for(IDX iel = 0; iel < (IDX) orders_raised.size(); ++iel)
+        ASSERT_EQ(fespace.elements[iel].basis->getPolynomialOrder(), orders_raised[iel]);
+    solvers::p_adapt<1>(fespace, std::span<const int>{orders_initial}, u_data);
+    ASSERT_EQ(u_data, u_saved);
+
+    // the elements, traces, and dof map match a space built with the new order
+    auto check_matches_fresh = [&]<int order>(tmp::compile_int<order>){
+        FESpace<T, IDX, ndim> fresh{&mesh, FESPACE_ENUMS::LEGENDRE,
+            FESPACE_ENUMS::GAUSS_LEGENDRE, tmp::compile_int<order>()};
+        ASSERT_EQ(fespace.dg_map.calculate_size_requirement(1), fresh.dg_map.calculate_size_requirement(1));
+        ASSERT_EQ(fespace.dg_map.max_el_size_reqirement(1), fresh.dg_map.max_el_size_reqirement(1));
+        ASSERT_EQ(fespace.elements.size(), fresh.elements.size());
+        for(IDX iel = 0; iel < (IDX) fresh.elements.size(); ++iel){
+            ASSERT_EQ(fespace.dg_map.ndof_el(iel), fresh.dg_map.ndof_el(iel));
+            ASSERT_EQ((fespace.dg_map[iel, 0]), (fresh.dg_map[iel, 0]));
+            ASSERT_EQ(fespace.elements[iel].nQP(), fresh.elements[iel].nQP());
+        }
+        ASSERT_EQ(fespace.element_batch_keys.size(), fresh.element_batch_keys.size());
+        for(std::size_t ibatch = 0; ibatch < fresh.element_batch_keys.size(); ++ibatch) 
+            ASSERT_EQ(fespace.element_batch_keys[ibatch].basis_order, fresh.element_batch_keys[ibatch].basis_order);
+
+        ASSERT_EQ(fespace.traces.size(), fresh.traces.size());
+        for(std::size_t itrace = 0; itrace < fresh.traces.size(); ++itrace){
+            const TraceSpace<T, IDX, ndim>& trace = fespace.traces[itrace];
+            const TraceSpace<T, IDX, ndim>& trace_fresh = fresh.traces[itrace];
+            ASSERT_EQ(trace.elL.elidx, trace_fresh.elL.elidx);
+            ASSERT_EQ(trace.elR.elidx, trace_fresh.elR.elidx);
+            ASSERT_EQ(trace.nbasisL(), trace_fresh.nbasisL());
+            ASSERT_EQ(trace.nbasisR(), trace_fresh.nbasisR());
+            ASSERT_EQ(trace.nbasis_trace(), trace_fresh.nbasis_trace());
+            ASSERT_EQ(trace.nQP(), trace_fresh.nQP());
+            for(int iqp = 0; iqp < trace.nQP(); ++iqp){
+                ASSERT_DOUBLE_EQ(trace.getQP(iqp).weight, trace_fresh.getQP(iqp).weight);
+                auto bi_l = trace.eval_basis_l_qp(iqp), bi_l_fresh = trace_fresh.eval_basis_l_qp(iqp);
+                auto bi_r = trace.eval_basis_r_qp(iqp), bi_r_fresh = trace_fresh.eval_basis_r_qp(iqp);
+                for(int ibasis = 0; ibasis < trace.nbasisL(); ++ibasis) ASSERT_NEAR(bi_l[ibasis], bi_l_fresh[ibasis], 1e-14);
+                for(int ibasis = 0; ibasis < trace.nbasisR(); ++ibasis) ASSERT_NEAR(bi_r[ibasis], bi_r_fresh[ibasis], 1e-14);
+            }
+        }
+    };
+    std::vector<int> orders_p3(fespace.elements.size(), pn_basis + 1);
+    fespace.set_element_orders(orders_p3);
+    check_matches_fresh(tmp::compile_int<pn_basis + 1>());
+    fespace.set_element_orders(orders_initial);
+    check_matches_fresh(tmp::compile_int<pn_basis>());
+}
+
+TEST(test_fespace, test_element_gauss_seidel){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+    static constexpr int nx = 4, ny = 3;
+
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {nx, ny}, 1,
+        {BOUNDARY_CONDITIONS::DIRICHLET, BOUNDARY_CONDITIONS::DIRICHLET,
+         BOUNDARY_CONDITIONS::DIRICHLET, BOUNDARY_CONDITIONS::DIRICHLET}, {0, 0, 0, 0});
+    FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, tmp::compile_int<1>()};
+
+    // the lines ordering follows the face neighbors along the direction one row of elements at a time
+    solvers::ElementGaussSeidel<T, IDX> gs{};
+    gs.set_ordering(fespace, solvers::SWEEP_ORDERING::LINES, {1.0, 0.0});
+    ASSERT_EQ(gs.order.size(), (std::size_t) (nx * ny));
+    std::vector<char> seen(nx * ny, 0);
+    for(IDX iline = 0; iline < ny; ++iline){
+        auto centroid = [&](IDX i){ return fespace.elements[gs.order[iline * nx + i]].centroid(); };
+        ASSERT_NEAR(centroid(0)[0], -1.0 + 1.0 / nx, 1e-12);
+        for(IDX i = 1; i < nx; ++i){
+            ASSERT_NEAR(centroid(i)[1], centroid(0)[1], 1e-12);
+            ASSERT_NEAR(centroid(i)[0] - centroid(i - 1)[0], 2.0 / nx, 1e-12);
+        }
+        for(IDX i = 0; i < nx; ++i) seen[gs.order[iline * nx + i]] = 1;
+    }
+    ASSERT_EQ(std::ranges::count(seen, 1), nx * ny);
+
+    // steady advection diffusion with a zero solution
+    BurgersCoefficients<T, ndim> burgers_coeffs{};
+    burgers_coeffs.mu = 0.05;
+    burgers_coeffs.a[0] = 1.0;
+    burgers_coeffs.a[1] = 0.5;
+    ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                          BurgersUpwind{burgers_coeffs},
+                          BurgersDiffusionFlux{burgers_coeffs}};
+    disc.dirichlet_callbacks.push_back([](const T*, T* out){ out[0] = 0.0; });
+
+    fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    std::vector<T> u_data(layout.size()), res_data(layout.size());
+    fespan u{u_data.data(), layout};
+    fespan res{res_data.data(), layout};
+    Projection<T, IDX, ndim, 1> projection{[](const T* x, T* out){
+        out[0] = std::cos(0.5 * std::numbers::pi * x[0]) * std::cos(0.5 * std::numbers::pi * x[1]);
+    }};
+    solvers::LinearFormSolver{fespace, projection}.solve(u);
+    std::vector<T> u0_data = u_data;
+    solvers::form_residual(fespace, disc, u, res);
+    T r0 = res.vector_norm();
+    ASSERT_GT(r0, 1e-3);
+
+    // one sweep lowers the residual for every ordering
+    for(solvers::SWEEP_ORDERING ordering : {solvers::SWEEP_ORDERING::NATURAL,
+            solvers::SWEEP_ORDERING::MORTON, solvers::SWEEP_ORDERING::LINES}){
+        u_data = u0_data;
+        gs.set_ordering(fespace, ordering, {1.0, 0.5});
+        gs.sweep(fespace, disc, u);
+        solvers::form_residual(fespace, disc, u, res);
+        ASSERT_LT(res.vector_norm(), r0);
+    }
+
+    // and the sweeps converge the linear problem
+    u_data = u0_data;
+    gs.symmetric = true;
+    solvers::ConvergenceCriteria<T, IDX> conv_criteria{};
+    conv_criteria.tau_abs = 1e-10;
+    conv_criteria.tau_rel = 0.0;
+    conv_criteria.kmax = 200;
+    gs.solve(fespace, disc, u, conv_criteria);
+    ASSERT_LE(gs.res_norm, 1e-10);
+}
+
+TEST_F(Box2dLagrangeP2, test_element_activity){
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+    fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    std::vector<T> u_data(layout.size(), 1.0), res_data(layout.size()), tracked_data(layout.size());
+    fespan u{u_data.data(), layout};
+    fespan res{res_data.data(), layout};
+    fespan tracked{tracked_data.data(), layout};
+
+    BurgersCoefficients<T, ndim> burgers_coeffs{};
+    burgers_coeffs.mu = 0.01;
+    burgers_coeffs.a[0] = 1.0;
+    burgers_coeffs.a[1] = -0.5;
+    ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                          BurgersUpwind{burgers_coeffs},
+                          BurgersDiffusionFlux{burgers_coeffs}};
+
+    for(bool element_centric : {false, true}){
+        // a uniform state with a disturbance in the first element
+        std::ranges::fill(u_data, 1.0);
+        for(std::size_t idof = 0; idof < u.ndof(0); ++idof) u[0, idof, 0] += 0.1 * (idof + 1);
+        solvers::form_residual(fespace, disc, u, res);
+
+        solvers::ResidualWorkspace<T, IDX> workspace{fespace, 1};
+        if(element_centric) workspace.enable_element_centric(fespace, 1);
+        workspace.enable_activity_tracking(fespace, 1, 1e-10, 1e-10, 10);
+
+        // the first evaluation forms every element then deactivates the ones away from the disturbance
+        solvers::form_residual(fespace, disc, u, tracked, workspace);
+        for(std::size_t i = 0; i < res_data.size(); ++i) ASSERT_NEAR(tracked_data[i], res_data[i], 1e-12);
+        ASSERT_GT(workspace.activity.ninactive, 0);
+        ASSERT_LT(workspace.activity.ninactive, (IDX) fespace.elements.size());
+        ASSERT_TRUE(workspace.activity.active(0));
+
+        // skipping the inactive elements forms the same residual
+        std::ranges::fill(tracked_data, 1.0);
+        solvers::form_residual(fespace, disc, u, tracked, workspace);
+        for(std::size_t i = 0; i < res_data.size(); ++i) ASSERT_NEAR(tracked_data[i], res_data[i], 1e-12);
+
+        // change the neighbor of an inactive element: it is reactivated on the next recheck
+        IDX iel_inactive = -1, iel_neighbor = -1;
+        for(const auto& trace : fespace.get_interior_traces()){
+            if(!workspace.activity.active(trace.elL.elidx)){
+                iel_inactive = trace.elL.elidx;
+                iel_neighbor = trace.elR.elidx;
+                break;
+            }
+        }
+        ASSERT_GE(iel_inactive, 0);
+        for(std::size_t idof = 0; idof < u.ndof(iel_neighbor); ++idof) u[iel_neighbor, idof, 0] = 2.0;
+        workspace.activity.recheck_interval = 1;
+        solvers::form_residual(fespace, disc, u, tracked, workspace);
+        ASSERT_TRUE(workspace.activity.active(iel_inactive));
+        solvers::form_residual(fespace, disc, u, res);
+        solvers::form_residual(fespace, disc, u, tracked, workspace);
+        for(IDX iel = 0; iel < (IDX) fespace.elements.size(); ++iel){
+            if(!workspace.activity.active(iel)) continue;
+            for(std::size_t idof = 0; idof < res.ndof(iel); ++idof)
+                { ASSERT_NEAR((tracked[iel, idof, 0]), (res[iel, idof, 0]), 1e-12); }
+        }
+    }
+}
+
+TEST(test_fespace, test_element_activity_pins_boundaries){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+
+    // a dirichlet face on one side, extrapolation elsewhere
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {4, 3}, 1,
+        {BOUNDARY_CONDITIONS::DIRICHLET, BOUNDARY_CONDITIONS::EXTRAPOLATION,
+         BOUNDARY_CONDITIONS::EXTRAPOLATION, BOUNDARY_CONDITIONS::EXTRAPOLATION}, {0, 0, 0, 0});
+    FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, tmp::compile_int<1>()};
+    fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    std::vector<T> u_data(layout.size(), 1.0), res_data(layout.size()), tracked_data(layout.size());
+    fespan u{u_data.data(), layout};
+    fespan res{res_data.data(), layout};
+    fespan tracked{tracked_data.data(), layout};
+
+    BurgersCoefficients<T, ndim> burgers_coeffs{};
+    burgers_coeffs.mu = 0.01;
+    burgers_coeffs.a[0] = 1.0;
+    burgers_coeffs.a[1] = -0.5;
+    ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                          BurgersUpwind{burgers_coeffs},
+                          BurgersDiffusionFlux{burgers_coeffs}};
+    T boundary_value = 1.0;
+    disc.dirichlet_callbacks.push_back([&](const T*, T* out){ out[0] = boundary_value; });
+
+    std::vector<char> on_dirichlet(fespace.elements.size(), 0);
+    for(const auto& trace : fespace.get_boundary_traces()){
+        if(trace.face->bctype == BOUNDARY_CONDITIONS::DIRICHLET) on_dirichlet[trace.elL.elidx] = 1;
+    }
+    ASSERT_GT(std::ranges::count(on_dirichlet, 1), 0);
+
+    // the uniform state matches the boundary value so only the pinned elements stay active
+    solvers::ResidualWorkspace<T, IDX> workspace{fespace, 1};
+    workspace.enable_activity_tracking(fespace, 1, 1e-10, 1e-10, 1);
+    solvers::form_residual(fespace, disc, u, tracked, workspace);
+    ASSERT_EQ(workspace.activity.ninactive, (IDX) std::ranges::count(on_dirichlet, 0));
+
+    // a change of the boundary value is seen by the elements on the boundary
+    boundary_value = 2.0;
+    solvers::form_residual(fespace, disc, u, res);
+    solvers::form_residual(fespace, disc, u, tracked, workspace);
+    T res_change = 0;
+    for(IDX iel = 0; iel < (IDX) fespace.elements.size(); ++iel){
+        if(!on_dirichlet[iel]) continue;
+        ASSERT_TRUE(workspace.activity.active(iel));
+        for(std::size_t idof = 0; idof < res.ndof(iel); ++idof){
+            ASSERT_NEAR((tracked[iel, idof, 0]), (res[iel, idof, 0]), 1e-12);
+            res_change = std::max(res_change, std::abs(res[iel, idof, 0]));
+        }
+    }
+    ASSERT_GT(res_change, 1e-6);
+
+    // a source term keeps every element active
+    workspace.enable_activity_tracking(fespace, 1, 1e-10, 1e-10, 1, true);
+    boundary_value = 1.0;
+    solvers::form_residual(fespace, disc, u, tracked, workspace);
+    ASSERT_EQ(workspace.activity.ninactive, 0);
+}
+
+TEST_F(Box2dLagrangeP2, test_element_cost){
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+    fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    std::vector<T> u_data(layout.size()), res_data(layout.size()), sampled_data(layout.size());
+    fespan u{u_data.data(), layout};
+    fespan res{res_data.data(), layout};
+    fespan sampled{sampled_data.data(), layout};
+    for(std::size_t i = 0; i < u_data.size(); ++i) u_data[i] = std::sin(0.3 * i);
+
+    BurgersCoefficients<T, ndim> burgers_coeffs{};
+    burgers_coeffs.mu = 0.01;
+    burgers_coeffs.a[0] = 1.0;
+    burgers_coeffs.a[1] = -0.5;
+    ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                          BurgersUpwind{burgers_coeffs},
+                          BurgersDiffusionFlux{burgers_coeffs}};
+    solvers::form_residual(fespace, disc, u, res);
+
+    for(bool element_centric : {false, true}){
+        solvers::ResidualWorkspace<T, IDX> workspace{fespace, 1};
+        if(element_centric) workspace.enable_element_centric(fespace, 1);
+        workspace.enable_cost_sampling(fespace, 3);
+
+        // every third evaluation is timed and the residual is unchanged
+        for(int icall = 0; icall < 7; ++icall){
+            solvers::form_residual(fespace, disc, u, sampled, workspace);
+            for(std::size_t i = 0; i < res_data.size(); ++i) ASSERT_NEAR(sampled_data[i], res_data[i], 1e-12);
+        }
+        const solvers::ElementCost<T, IDX>& cost = workspace.cost;
+        ASSERT_EQ(cost.nsample, (std::size_t) 3);
+
+        // every element is charged and on one thread the element costs fit in the timed phases
+        double total = 0;
+        for(IDX iel = 0; iel < (IDX) fespace.elements.size(); ++iel){
+            ASSERT_GT(cost.seconds(iel), 0.0);
+            total += cost.seconds(iel);
+        }
+        if(workspace.nthread == 1) ASSERT_LE(total, cost.phase(0) + cost.phase(1) + cost.phase(2));
+
+        // the field holds the element cost at every degree of freedom
+        std::vector<T> field_data(layout.size());
+        fespan field{field_data.data(), layout};
+        cost.fill_field(field);
+        for(IDX iel = 0; iel < (IDX) fespace.elements.size(); ++iel){
+            for(std::size_t idof = 0; idof < field.ndof(iel); ++idof)
+                { ASSERT_DOUBLE_EQ((field[iel, idof, 0]), cost.seconds(iel)); }
+        }
+
+        // the partition weights scale the most expensive element to the maximum weight
+        std::vector<IDX> weights = cost.partition_weights(100);
+        ASSERT_EQ(weights.size(), fespace.elements.size());
+        ASSERT_EQ(std::ranges::max(weights), 100);
+        ASSERT_GE(std::ranges::min(weights), 1);
+    }
+}
+
+TEST_F(Box2dLagrangeP2, test_positivity_limiter){
+    using namespace navier_stokes;
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+    static constexpr int nv = ndim + 2;
+    fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, nv>{}};
+    std::vector<T> u_data(layout.size());
+    fespan u{u_data.data(), layout};
+
+    // a uniform state with a negative density and a negative pressure at nodes of the first element
+    const T gamma = 1.4;
+    Nondimensionalization<T> nondim{1.0, 1.0, 1.0, 1.0};
+    const T p_coeff = (gamma - 1) / (nondim.e_coeff * nondim.Eu);
+    for(IDX iel = 0; iel < (IDX) fespace.elements.size(); ++iel){
+        for(std::size_t idof = 0; idof < u.ndof(iel); ++idof){
+            u[iel, idof, 0] = 1.0;
+            u[iel, idof, 1] = 0.3;
+            u[iel, idof, 2] = 0.1;
+            u[iel, idof, 3] = 2.5;
+        }
+    }
+    u[0, 0, 0] = -5.0;
+    u[0, 4, 3] = 0.01;
+    std::vector<T> u_orig = u_data;
+
+    auto qp_state = [&](const FiniteElement<T, IDX, ndim>& el, int iqp){
+        std::array<T, nv> uq{};
+        for(int ibasis = 0; ibasis < el.nbasis(); ++ibasis){
+            for(int iv = 0; iv < nv; ++iv) uq[iv] += el.basis_qp(iqp, ibasis) * u[el.elidx, ibasis, iv];
+        }
+        return uq;
+    };
+    auto pressure = [&](const std::array<T, nv>& uq){
+        return p_coeff * (uq[3] - 0.5 * nondim.e_coeff * (uq[1] * uq[1] + uq[2] * uq[2]) / uq[0]);
+    };
+    auto average = [&](const FiniteElement<T, IDX, ndim>& el){
+        QPGeometry geo{el};
+        std::array<T, nv> ubar{};
+        T vol = 0;
+        for(int iqp = 0; iqp < el.nQP(); ++iqp){
+            std::array<T, nv> uq = qp_state(el, iqp);
+            T dvol = geo[iqp].dvol;
+            vol += dvol;
+            for(int iv = 0; iv < nv; ++iv) ubar[iv] += dvol * uq[iv];
+        }
+        for(int iv = 0; iv < nv; ++iv) ubar[iv] /= vol;
+        return ubar;
+    };
+
+    const FiniteElement<T, IDX, ndim>& el0 = fespace.elements[0];
+    bool negative = false;
+    for(int iqp = 0; iqp < el0.nQP(); ++iqp){
+        std::array<T, nv> uq = qp_state(el0, iqp);
+        negative = negative || uq[0] <= 0 || pressure(uq) <= 0;
+    }
+    ASSERT_TRUE(negative);
+    std::array<T, nv> ubar_orig = average(el0);
+
+    PositivityLimiter limiter{fespace, gamma, nondim};
+    limiter.eps = 1e-3;
+    ASSERT_EQ(limiter.limit(u_data), 1);
+    ASSERT_EQ(limiter.nfailed, 0);
+
+    // the density and pressure are at least eps at the quadrature points
+    for(int iqp = 0; iqp < el0.nQP(); ++iqp){
+        std::array<T, nv> uq = qp_state(el0, iqp);
+        ASSERT_GE(uq[0], limiter.eps * (1 - 1e-8));
+        ASSERT_GE(pressure(uq), limiter.eps * (1 - 1e-8));
+    }
+
+    // the element average is conserved
+    std::array<T, nv> ubar = average(el0);
+    for(int iv = 0; iv < nv; ++iv) ASSERT_NEAR(ubar[iv], ubar_orig[iv], 1e-12);
+
+    // the other elements are untouched
+    for(IDX iel = 1; iel < (IDX) fespace.elements.size(); ++iel){
+        for(std::size_t idof = 0; idof < u.ndof(iel); ++idof){
+            for(int iv = 0; iv < nv; ++iv){
+                std::size_t i = layout[iel, idof, iv];
+                ASSERT_EQ(u_data[i], u_orig[i]);
+            }
+        }
+    }
+}
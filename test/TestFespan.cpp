@@ -2,17 +2,22 @@
 #include "iceicle/element/reference_element.hpp"
 #include "iceicle/fe_function/component_span.hpp"
 #include "iceicle/fe_function/geo_layouts.hpp"
+#include "iceicle/fe_function/node_selection.hpp"
 #include "iceicle/geometry/hypercube_element.hpp"
 #include "iceicle/geometry/transformations_table.hpp"
 #include "iceicle/mesh/mesh.hpp"
 #include "iceicle/tmp_utils.hpp"
 #include <iceicle/quadrature/HypercubeGaussLegendre.hpp>
 #include <iceicle/fe_function/fespan.hpp>
+#include <iceicle/fe_function/solution_version.hpp>
 #include <iceicle/fe_function/dglayout.hpp>
 #include <iceicle/fe_function/layout_right.hpp>
+#include <iceicle/fe_function/aosoa_layout.hpp>
+#include <iceicle/crs.hpp>
 #include <iceicle/element/finite_element.hpp>
 
 #include <gtest/gtest.h>
+#include <limits>
 
 using namespace iceicle;
 TEST(test_fespan, test_dglayout){
@@ -95,6 +100,246 @@ TEST(test_fespan, test_dglayout){
     //TODO: add more tests
 }
 
+TEST(test_fespan, test_aosoa_layout){
+
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+    static constexpr int Pn = 1;
+    static constexpr int nlane = 4;
+    static constexpr int nv = 2;
+    using BasisType = HypercubeLagrangeBasis<T, IDX, ndim, Pn>;
+    using QuadratureType = HypercubeGaussLegendre<T, IDX, ndim, Pn>;
+    using FiniteElement = FiniteElement<T, IDX, ndim>;
+
+    BasisType basis{};
+    QuadratureType quadrule{};
+    auto evals = quadrature_point_evaluations(basis, quadrule);
+    ElementTransformation<T, IDX, ndim> *trans = transformation_table<T, IDX, ndim>.get_transform(DOMAIN_TYPE::HYPERCUBE, Pn);
+    std::vector<int> inodes(trans->nnode);
+    std::iota(inodes.begin(), inodes.end(), 0);
+    std::vector<MATH::GEOMETRY::Point<T, ndim>> coord_el(trans->nnode);
+
+    // 5 elements of the same type in one batch: one full block and one padded block
+    static constexpr int nelem = 5;
+    std::vector<FiniteElement> elements;
+    for(int iel = 0; iel < nelem; ++iel)
+        elements.push_back(FiniteElement{trans, &basis, &quadrule, evals, inodes, coord_el, iel});
+    std::vector<std::vector<IDX>> batches_ragged{{0, 1, 2, 3, 4}};
+    util::crs<IDX, IDX> batches{batches_ragged};
+
+    dg_aosoa_map<IDX, nlane> map{elements, batches};
+    ASSERT_EQ(map.nblock(), 2);
+    ASSERT_EQ(map.block(4), 1);
+    ASSERT_EQ(map.lane(4), 0);
+    ASSERT_EQ(map.block_elements(1)[1], (dg_aosoa_map<IDX, nlane>::unused_lane));
+    int ndof = basis.nbasis();
+    ASSERT_EQ(map.calculate_size_requirement(nv), 2 * nlane * ndof * nv);
+
+    std::vector<T> data(map.calculate_size_requirement(nv), 0.0);
+    fe_layout_aosoa<IDX, nv, nlane> layout{map};
+    fespan u{data.data(), layout};
+
+    // the same dof and component of the elements in a block are contiguous
+    for(int iel = 0; iel < nlane; ++iel)
+        ASSERT_EQ(&(u[iel, 1, 1]), &(u[0, 1, 1]) + iel);
+    ASSERT_EQ(&(u[4, 0, 0]), data.data() + ndof * nv * nlane);
+
+    // extract and scatter round trip
+    for(int iel = 0; iel < nelem; ++iel){
+        for(int idof = 0; idof < ndof; ++idof){
+            for(int iv = 0; iv < nv; ++iv)
+                u[iel, idof, iv] = 100 * iel + 10 * idof + iv;
+        }
+    }
+    auto local_layout = u.create_element_layout(2);
+    std::vector<T> el_memory(local_layout.size());
+    dofspan u_el{el_memory.data(), local_layout};
+    extract_elspan(2, u, u_el);
+    for(int idof = 0; idof < ndof; ++idof){
+        for(int iv = 0; iv < nv; ++iv)
+            ASSERT_DOUBLE_EQ((u_el[idof, iv]), 200 + 10 * idof + iv);
+    }
+    scatter_elspan(2, 1.0, u_el, 1.0, u);
+    ASSERT_DOUBLE_EQ((u[2, 3, 1]), 2.0 * 231);
+    ASSERT_DOUBLE_EQ((u[1, 3, 1]), 131);
+    ASSERT_DOUBLE_EQ((u[3, 3, 1]), 331);
+}
+
+TEST(test_fespan, test_elspan_block){
+
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+    static constexpr int Pn = 1;
+    static constexpr int nlane = 4;
+    static constexpr int nv = 2;
+    using BasisType = HypercubeLagrangeBasis<T, IDX, ndim, Pn>;
+    using QuadratureType = HypercubeGaussLegendre<T, IDX, ndim, Pn>;
+    using FiniteElement = FiniteElement<T, IDX, ndim>;
+
+    BasisType basis{};
+    QuadratureType quadrule{};
+    auto evals = quadrature_point_evaluations(basis, quadrule);
+    ElementTransformation<T, IDX, ndim> *trans = transformation_table<T, IDX, ndim>.get_transform(DOMAIN_TYPE::HYPERCUBE, Pn);
+    std::vector<int> inodes(trans->nnode);
+    std::iota(inodes.begin(), inodes.end(), 0);
+    std::vector<MATH::GEOMETRY::Point<T, ndim>> coord_el(trans->nnode);
+
+    static constexpr int nelem = 5;
+    std::vector<FiniteElement> elements;
+    for(int iel = 0; iel < nelem; ++iel)
+        elements.push_back(FiniteElement{trans, &basis, &quadrule, evals, inodes, coord_el, iel});
+    dg_dof_map offsets{elements};
+    std::vector<T> data(offsets.calculate_size_requirement(nv));
+    fe_layout_right<IDX, decltype(offsets), nv> layout(offsets);
+    fespan u{data.data(), layout};
+    int ndof = basis.nbasis();
+    for(int iel = 0; iel < nelem; ++iel){
+        for(int idof = 0; idof < ndof; ++idof){
+            for(int iv = 0; iv < nv; ++iv)
+                u[iel, idof, iv] = 100 * iel + 10 * idof + iv;
+        }
+    }
+
+    // elements are block copied for the dg layout
+    static_assert(has_equivalent_el_layout<
+        decltype(dofspan{data.data(), u.create_element_layout(0)}), decltype(u)>::value);
+    auto local_layout = u.create_element_layout(3);
+    std::vector<T> el_memory(local_layout.size());
+    dofspan u_el{el_memory.data(), local_layout};
+    extract_elspan(3, u, u_el);
+    ASSERT_DOUBLE_EQ((u_el[2, 1]), 321);
+    scatter_elspan(3, 2.0, u_el, 0.0, u);
+    ASSERT_DOUBLE_EQ((u[3, 2, 1]), 642);
+    scatter_elspan(3, -1.0, u_el, 1.0, u);
+    ASSERT_DOUBLE_EQ((u[3, 2, 1]), 321);
+
+    // gather a block with an unused lane into [dof][vector component][lane]
+    std::array<IDX, nlane> iels{4, 0, -1, 2};
+    std::vector<T> block(ndof * nv * nlane, -1.0);
+    extract_elspan_block(std::span<const IDX, nlane>{iels}, u, ndof, std::span<T>{block});
+    for(int idof = 0; idof < ndof; ++idof){
+        for(int iv = 0; iv < nv; ++iv){
+            for(int ilane = 0; ilane < nlane; ++ilane){
+                T expected = (iels[ilane] < 0) ? 0.0 : 100 * iels[ilane] + 10 * idof + iv;
+                ASSERT_DOUBLE_EQ(block[(idof * nv + iv) * nlane + ilane], expected);
+            }
+        }
+    }
+
+    // scatter back only touches the used lanes
+    scatter_elspan_block(std::span<const IDX, nlane>{iels}, 1.0, std::span<const T>{block}, 1.0, u);
+    ASSERT_DOUBLE_EQ((u[4, 3, 1]), 2.0 * 431);
+    ASSERT_DOUBLE_EQ((u[2, 0, 0]), 2.0 * 200);
+    ASSERT_DOUBLE_EQ((u[1, 3, 1]), 131);
+}
+
+TEST(test_fespan, test_fused_vector_ops){
+
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+    static constexpr int Pn = 1;
+    static constexpr int nv = 2;
+    using BasisType = HypercubeLagrangeBasis<T, IDX, ndim, Pn>;
+    using QuadratureType = HypercubeGaussLegendre<T, IDX, ndim, Pn>;
+    using FiniteElement = FiniteElement<T, IDX, ndim>;
+
+    BasisType basis{};
+    QuadratureType quadrule{};
+    auto evals = quadrature_point_evaluations(basis, quadrule);
+    ElementTransformation<T, IDX, ndim> *trans = transformation_table<T, IDX, ndim>.get_transform(DOMAIN_TYPE::HYPERCUBE, Pn);
+    std::vector<int> inodes(trans->nnode);
+    std::iota(inodes.begin(), inodes.end(), 0);
+    std::vector<MATH::GEOMETRY::Point<T, ndim>> coord_el(trans->nnode);
+    std::vector<FiniteElement> elements;
+    for(int iel = 0; iel < 3; ++iel)
+        elements.push_back(FiniteElement{trans, &basis, &quadrule, evals, inodes, coord_el, iel});
+    dg_dof_map offsets{elements};
+    fe_layout_right<IDX, decltype(offsets), nv> layout(offsets);
+
+    std::size_t n = offsets.calculate_size_requirement(nv);
+    std::vector<T> xdata(n), ydata(n), rdata(n);
+    for(std::size_t i = 0; i < n; ++i){
+        xdata[i] = 1.0 + i;
+        ydata[i] = 2.0;
+        rdata[i] = 0.5 * i;
+    }
+    fespan x{xdata.data(), layout}, y{ydata.data(), layout}, r{rdata.data(), layout};
+
+    T x_dot_y = 0, x_norm_sq = 0, r_norm_sq = 0;
+    for(std::size_t i = 0; i < n; ++i){
+        x_dot_y += xdata[i] * ydata[i];
+        x_norm_sq += xdata[i] * xdata[i];
+        r_norm_sq += rdata[i] * rdata[i];
+    }
+    ASSERT_NEAR(dot(x, y), x_dot_y, 1e-10);
+    ASSERT_NEAR(norm_sq(x), x_norm_sq, 1e-10);
+    std::array<T, 3> sums = dot_and_norms_sq(x, y);
+    ASSERT_NEAR(sums[0], x_dot_y, 1e-10);
+    ASSERT_NEAR(sums[1], x_norm_sq, 1e-10);
+    ASSERT_NEAR(sums[2], 4.0 * n, 1e-10);
+
+    // y = 2 x + 3 y + 0.1 r
+    ASSERT_NEAR(rk_stage_update(2.0, x, 3.0, 0.1, r, y), r_norm_sq, 1e-10);
+    for(std::size_t i = 0; i < n; ++i) ASSERT_DOUBLE_EQ(ydata[i], 2.0 * (1.0 + i) + 6.0 + 0.05 * i);
+
+    // beta = 0 does not read y
+    std::fill(ydata.begin(), ydata.end(), std::numeric_limits<T>::quiet_NaN());
+    T y_norm_sq = axpby_and_norm_sq(-1.0, x, 0.0, y);
+    ASSERT_NEAR(y_norm_sq, x_norm_sq, 1e-10);
+    for(std::size_t i = 0; i < n; ++i) ASSERT_DOUBLE_EQ(ydata[i], -xdata[i]);
+}
+
+TEST(test_fespan, test_solution_version){
+
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+    static constexpr int Pn = 1;
+    static constexpr int nv = 2;
+    using BasisType = HypercubeLagrangeBasis<T, IDX, ndim, Pn>;
+    using QuadratureType = HypercubeGaussLegendre<T, IDX, ndim, Pn>;
+    using FiniteElement = FiniteElement<T, IDX, ndim>;
+
+    BasisType basis{};
+    QuadratureType quadrule{};
+    auto evals = quadrature_point_evaluations(basis, quadrule);
+    ElementTransformation<T, IDX, ndim> *trans = transformation_table<T, IDX, ndim>.get_transform(DOMAIN_TYPE::HYPERCUBE, Pn);
+    std::vector<int> inodes(trans->nnode);
+    std::iota(inodes.begin(), inodes.end(), 0);
+    std::vector<MATH::GEOMETRY::Point<T, ndim>> coord_el(trans->nnode);
+    std::vector<FiniteElement> elements;
+    for(int iel = 0; iel < 3; ++iel)
+        elements.push_back(FiniteElement{trans, &basis, &quadrule, evals, inodes, coord_el, iel});
+    dg_dof_map offsets{elements};
+    fe_layout_right<IDX, decltype(offsets), nv> layout(offsets);
+
+    std::size_t n = offsets.calculate_size_requirement(nv);
+    std::vector<T> udata(n), vdata(n);
+    for(std::size_t i = 0; i < n; ++i) udata[i] = vdata[i] = 0.1 * i;
+    fespan u{udata.data(), layout}, v{vdata.data(), layout};
+
+    solution_version v0 = get_solution_version(u, 0);
+    ASSERT_TRUE(v0.versioned());
+    ASSERT_TRUE(v0 == get_solution_version(u, 0));
+
+    // a change to the mesh or any coefficient changes the version
+    ASSERT_FALSE(v0 == get_solution_version(u, 1));
+    udata[n / 2] += 1e-14;
+    ASSERT_FALSE(v0 == get_solution_version(u, 0));
+    udata[n / 2] = 0.1 * (n / 2);
+    ASSERT_TRUE(v0 == get_solution_version(u, 0));
+
+    // the same values in different storage are a different solution
+    ASSERT_EQ(v0.u_generation, get_solution_version(v, 0).u_generation);
+    ASSERT_FALSE(v0 == get_solution_version(v, 0));
+
+    // unversioned never matches
+    ASSERT_FALSE(solution_version{} == solution_version{});
+}
+
 TEST(test_dofspan, test_node_set_layout){
     using T = double;
     using IDX = int;
@@ -338,6 +583,38 @@ TEST(test_dofspan, test_node_set_layout){
 }
 
 
+TEST(test_dofspan, test_node_selection){
+    // span several words and more than one gather block
+    static constexpr int nnode = 70000;
+    node_selection<int> select(nnode);
+    node_selection<int> remove(nnode);
+    std::vector<int> expected{};
+    for(int inode = 0; inode < nnode; ++inode){
+        if(inode % 7 == 0 || inode % 64 == 63) select.set(inode);
+        if(inode % 5 == 0) remove.set(inode);
+    }
+    select -= remove;
+    for(int inode = 0; inode < nnode; ++inode){
+        bool selected = (inode % 7 == 0 || inode % 64 == 63) && inode % 5 != 0;
+        ASSERT_EQ(select.test(inode), selected);
+        if(selected) expected.push_back(inode);
+    }
+    ASSERT_EQ(select.count(), expected.size());
+
+    std::vector<int> list = select.to_list();
+    ASSERT_EQ(list, expected);
+
+    std::vector<int> inv = inverse_node_list(list, nnode);
+    for(int inode = 0; inode < nnode; ++inode){
+        if(select.test(inode)) ASSERT_EQ(list[inv[inode]], inode);
+        else ASSERT_EQ(inv[inode], (int) list.size());
+    }
+
+    select.reset(list[0]);
+    ASSERT_FALSE(select.test(list[0]));
+    ASSERT_EQ(select.to_list().size(), list.size() - 1);
+}
+
 TEST(test_dofspan, test_geo_dof_map){
     using T = double;
     using IDX = int;
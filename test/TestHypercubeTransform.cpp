@@ -6,6 +6,7 @@
 #include <Numtool/matrixT.hpp>
 #include <iceicle/transformations/HypercubeTransformations.hpp>
 #include <iceicle/geometry/transformations_table.hpp>
+#include <iceicle/transformations/transformation_utils.hpp>
 #include "gtest/gtest.h"
 #include <random>
 
@@ -78,6 +79,78 @@ TEST(test_transformation_table, test_hypercube) {
   
 }
 
+TEST(test_transformation_table, test_inverse_map) {
+  std::default_random_engine engine{42};
+  std::uniform_real_distribution<double> dist{-0.15, 0.15};
+  std::uniform_real_distribution<double> domain_dist{-0.95, 0.95};
+
+  using T = double;
+  using IDX = int;
+
+  NUMTOOL::TMP::constexpr_for_range<2, 4>([&]<int ndim>(){
+    ElementTransformationTable<T, IDX, ndim> trans_table{};
+    using Point = MATH::GEOMETRY::Point<T, ndim>;
+
+    NUMTOOL::TMP::constexpr_for_range<1, build_config::FESPACE_BUILD_GEO_PN + 1>([&]<int Pn>(){
+      HypercubeElementTransformation<T, IDX, ndim, Pn> trans1{};
+      ElementTransformation<T, IDX, ndim>* trans{trans_table.get_transform(DOMAIN_TYPE::HYPERCUBE, Pn)};
+      std::vector<IDX> node_indices(trans1.n_nodes());
+      NodeArray<T, ndim> node_coords(trans1.n_nodes());
+      for(int inode = 0; inode < trans1.n_nodes(); ++inode){
+        node_indices[inode] = inode;
+        for(int idim = 0; idim < ndim; ++idim)
+          { node_coords[inode][idim] = 2.0 * trans1.reference_nodes()[inode][idim] + dist(engine); }
+      }
+      auto el_coord = trans->get_el_coord(node_coords, node_indices.data());
+      std::span<Point> el_coord_span{el_coord};
+
+      std::vector<Point> xi_true(20), x(20);
+      for(std::size_t ipoin = 0; ipoin < x.size(); ++ipoin){
+        for(int idim = 0; idim < ndim; ++idim) xi_true[ipoin][idim] = domain_dist(engine);
+        x[ipoin] = trans->transform(el_coord_span, xi_true[ipoin]);
+        auto result = inverse_map(*trans, el_coord_span, x[ipoin]);
+        ASSERT_TRUE(result.converged);
+        for(int idim = 0; idim < ndim; ++idim) { ASSERT_NEAR(result.xi[idim], xi_true[ipoin][idim], 1e-8); }
+      }
+
+      // the batch gives the same points
+      std::vector<inverse_map_result<T, ndim>> results(x.size());
+      std::size_t nconverged = inverse_map_batch(*trans, el_coord_span, std::span<const Point>{x},
+          std::span<inverse_map_result<T, ndim>>{results});
+      ASSERT_EQ(nconverged, x.size());
+      for(std::size_t ipoin = 0; ipoin < x.size(); ++ipoin){
+        for(int idim = 0; idim < ndim; ++idim) { ASSERT_NEAR(results[ipoin].xi[idim], xi_true[ipoin][idim], 1e-8); }
+      }
+
+      // the affine guess is exact for a parallelepiped
+      if constexpr (Pn == 1) {
+        NodeArray<T, ndim> box_coords(trans1.n_nodes());
+        for(int inode = 0; inode < trans1.n_nodes(); ++inode){
+          for(int idim = 0; idim < ndim; ++idim) { box_coords[inode][idim] = 3.0 * trans1.reference_nodes()[inode][idim]; }
+        }
+        auto box_coord = trans->get_el_coord(box_coords, node_indices.data());
+        auto result = inverse_map(*trans, std::span<Point>{box_coord}, trans->transform(box_coord, xi_true[0]));
+        ASSERT_TRUE(result.converged);
+        ASSERT_EQ(result.iterations, 0);
+      }
+    });
+  });
+
+  // triangle (affine so no Newton iterations are needed)
+  ElementTransformationTable<T, IDX, 2> trans_table{};
+  ElementTransformation<T, IDX, 2>* tri{trans_table.get_transform(DOMAIN_TYPE::SIMPLEX, 1)};
+  NodeArray<T, 2> tri_coords{{0.1, 0.2}, {1.3, 0.1}, {0.4, 1.1}};
+  std::vector<IDX> tri_nodes{0, 1, 2};
+  auto tri_coord = tri->get_el_coord(tri_coords, tri_nodes.data());
+  MATH::GEOMETRY::Point<T, 2> xi_tri{0.2, 0.3};
+  auto result = inverse_map(*tri, std::span<MATH::GEOMETRY::Point<T, 2>>{tri_coord},
+      tri->transform(tri_coord, xi_tri));
+  ASSERT_TRUE(result.converged);
+  ASSERT_EQ(result.iterations, 0);
+  ASSERT_NEAR(result.xi[0], 0.2, 1e-12);
+  ASSERT_NEAR(result.xi[1], 0.3, 1e-12);
+}
+
 TEST(test_hypercube_transform, test_get_face_nodes){
   { // Linear 2D element
     HypercubeElementTransformation<double, int, 2, 1> trans2dp1{};
@@ -1249,3 +1322,46 @@ TEST(test_hypercube_transform, test_get_face_number){
   ASSERT_EQ(4, trans.get_face_nr(gnodes, facevert4));
   ASSERT_EQ(5, trans.get_face_nr(gnodes, facevert5));
 }
+
+TEST( test_hypercube_transform, test_regularization_stencil ){
+  std::random_device rdev{};
+  std::default_random_engine engine{rdev()};
+  std::uniform_real_distribution<double> dist{-0.2, 0.2};
+  auto rand_doub = [&]() -> double { return dist(engine); };
+
+  NUMTOOL::TMP::constexpr_for_range<2, 4>([&]<int ndim>(){
+    static constexpr int Pn = 3;
+    HypercubeElementTransformation<double, int, ndim, Pn> trans{};
+    std::span<const interior_node_weight<double>> stencil = hypercube<double, int, ndim, Pn>::regularization_stencil();
+    ASSERT_EQ(stencil.size(), 2 * ndim * MATH::power_T<Pn - 1, ndim>::value);
+
+    // a random multilinear transformation of the reference nodes
+    std::array<double, ndim> shift, scale, cross;
+    for(int idim = 0; idim < ndim; ++idim){
+      shift[idim] = rand_doub();
+      scale[idim] = 1.0 + rand_doub();
+      cross[idim] = rand_doub();
+    }
+    int node_indices[trans.n_nodes()];
+    NodeArray<double, ndim> node_coords(trans.n_nodes());
+    for(int inode = 0; inode < trans.n_nodes(); ++inode){
+      node_indices[inode] = inode;
+      const MATH::GEOMETRY::Point<double, ndim>& xi = trans.reference_nodes()[inode];
+      double prod = 1.0;
+      for(int idim = 0; idim < ndim; ++idim) prod *= xi[idim];
+      for(int idim = 0; idim < ndim; ++idim)
+        { node_coords[inode][idim] = shift[idim] + scale[idim] * xi[idim] + cross[idim] * prod; }
+    }
+    NodeArray<double, ndim> node_coords_act = node_coords;
+
+    // move the interior nodes and recover them from the facet nodes
+    for(const interior_node_weight<double>& entry : stencil){
+      for(int idim = 0; idim < ndim; ++idim) node_coords[entry.inode][idim] += rand_doub();
+    }
+    trans.regularize_nodes(node_indices, node_coords);
+    for(int inode = 0; inode < trans.n_nodes(); ++inode){
+      for(int idim = 0; idim < ndim; ++idim)
+        { ASSERT_NEAR(node_coords_act[inode][idim], node_coords[inode][idim], 1e-14); }
+    }
+  });
+}
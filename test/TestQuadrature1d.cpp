@@ -2,6 +2,7 @@
 #include "gtest/gtest.h"
 
 #include <iostream>
+#include <cmath>
 #include <iomanip>
 
 using namespace iceicle;
@@ -25,3 +26,22 @@ TEST(test_quadrature_1d, print_gauss_legendre){
         std::cout << "===================================================" << std::endl << std::endl;
     });
 }
+
+TEST(test_quadrature_1d, test_gauss_lobatto){
+    NUMTOOL::TMP::constexpr_for_range<2,10>([]<int npoin>(){
+        GaussLobattoQuadrature<double, int, npoin> quadrule{};
+        ASSERT_DOUBLE_EQ(quadrule[0].abscisse[0], -1.0);
+        ASSERT_DOUBLE_EQ(quadrule[npoin - 1].abscisse[0], 1.0);
+
+        // ordered and exact for x^k up to k = 2 npoin - 3
+        for(int ipoin = 1; ipoin < npoin; ++ipoin)
+            ASSERT_LT(quadrule[ipoin - 1].abscisse[0], quadrule[ipoin].abscisse[0]);
+        for(int k = 0; k <= 2 * npoin - 3; ++k){
+            double integral = 0.0;
+            for(int ipoin = 0; ipoin < npoin; ++ipoin)
+                integral += quadrule[ipoin].weight * std::pow(quadrule[ipoin].abscisse[0], k);
+            double exact = (k % 2 == 0) ? 2.0 / (k + 1) : 0.0;
+            ASSERT_NEAR(integral, exact, 1e-13);
+        }
+    });
+}
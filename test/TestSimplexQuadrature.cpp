@@ -4,6 +4,7 @@
 #include <iostream>
 #include <iomanip>
 #include <sstream>
+#include <utility>
 #include <iceicle/quadrature/SimplexQuadrature.hpp>
 #include <iceicle/transformations/SimplexElementTransformation.hpp>
 
@@ -117,3 +118,68 @@ TEST(test_simplex_quadrature, test_grundmann_moller_triangle){
     }
     ASSERT_NEAR(integral, 17.7857142867, 1e-6);
 }
+
+/// check a tabulated symmetric rule integrates the monomials up to its degree exactly 
+/// with positive weights and points inside the reference simplex
+template<int ndim, int degree>
+void check_symmetric_rule(){
+    if constexpr (symmetric_simplex_rule_exists<ndim, degree>) {
+        SymmetricSimplexQuadrature<double, int, ndim, degree> quadrule{};
+        for(int igauss = 0; igauss < quadrule.npoints(); ++igauss){
+            const QuadraturePoint<double, ndim> &quadpt = quadrule[igauss];
+            ASSERT_GT(quadpt.weight, 0.0);
+            double sum = 0;
+            for(int idim = 0; idim < ndim; ++idim){
+                ASSERT_GT(quadpt.abscisse[idim], 0.0);
+                sum += quadpt.abscisse[idim];
+            }
+            ASSERT_LT(sum, 1.0);
+        }
+
+        // integral of x^a y^b z^c on the reference simplex is a! b! c! / (a + b + c + ndim)!
+        for(int a = 0; a <= degree; ++a) for(int b = 0; a + b <= degree; ++b) 
+        for(int c = 0; a + b + c <= degree; ++c) {
+            if(ndim == 2 && c > 0) continue;
+            int exponents[3] = {a, b, c};
+            double exact = std::tgamma(a + 1) * std::tgamma(b + 1) * std::tgamma(c + 1) 
+                / std::tgamma(a + b + c + ndim + 1);
+            double integral = 0;
+            for(int igauss = 0; igauss < quadrule.npoints(); ++igauss){
+                double f = 1.0;
+                for(int idim = 0; idim < ndim; ++idim)
+                    f *= std::pow(quadrule[igauss].abscisse[idim], exponents[idim]);
+                integral += f * quadrule[igauss].weight;
+            }
+            ASSERT_NEAR(integral, exact, 1e-12 * exact) << "degree " << degree 
+                << " monomial " << a << " " << b << " " << c;
+        }
+    }
+}
+
+TEST(test_simplex_quadrature, test_symmetric_rules){
+    []<int... degrees>(std::integer_sequence<int, degrees...>){
+        (check_symmetric_rule<2, degrees + 1>(), ...);
+        (check_symmetric_rule<3, degrees + 1>(), ...);
+    }(std::make_integer_sequence<int, 20>{});
+
+    // far fewer points than Grundmann Moller of the same degree
+    SymmetricSimplexQuadrature<double, int, 3, 4> symmetric{};
+    GrundmannMollerSimplexQuadrature<double, int, 3, 2> grundmann_moller{};
+    ASSERT_EQ(symmetric.npoints(), 14);
+    ASSERT_LT(symmetric.npoints(), grundmann_moller.npoints());
+}
+
+TEST(test_simplex_quadrature, test_symmetric_degree_selection){
+    // the p = 4 tetrahedron (5 gauss points) uses the degree 9 rule instead of Grundmann Moller
+    static_assert(symmetric_simplex_degree<3, 9> == 9);
+    static_assert(symmetric_simplex_degree<2, 18> == 18);
+    static_assert(symmetric_simplex_degree<2, 19> == -1);
+    static_assert(symmetric_simplex_degree<3, 11> == -1);
+    static_assert(symmetric_simplex_degree<3, impl::symmetric_simplex_max_degree<3>> 
+            == impl::symmetric_simplex_max_degree<3>);
+
+    SymmetricSimplexQuadrature<double, int, 3, 9> symmetric{};
+    GrundmannMollerSimplexQuadrature<double, int, 3, 5> grundmann_moller{};
+    ASSERT_EQ(symmetric.npoints(), 59);
+    ASSERT_LT(symmetric.npoints(), grundmann_moller.npoints());
+}
@@ -0,0 +1,257 @@
+#include "iceicle/device_residual.hpp"
+#include "iceicle/device_rk3.hpp"
+#include "iceicle/disc/burgers.hpp"
+#include "iceicle/disc/conservation_law.hpp"
+#include "iceicle/disc/navier_stokes.hpp"
+#include "iceicle/disc/projection.hpp"
+#include "iceicle/explicit_utils.hpp"
+#include "iceicle/fe_function/device_fespan.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fe_function/layout_right.hpp"
+#include "iceicle/form_residual.hpp"
+#include "iceicle/linear_form_solver.hpp"
+#include "iceicle/residual_workspace.hpp"
+#include "iceicle/ssp_rk3.hpp"
+#include "iceicle/tvd_rk3.hpp"
+#include "test_fixtures.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <numbers>
+#include <vector>
+
+using namespace iceicle;
+using namespace iceicle::solvers;
+using iceicle::test::Box2dLagrangeP2;
+
+namespace {
+
+    /// @brief the smooth periodic initial condition projected onto the space
+    auto initial_condition(FESpace<double, int, 2>& fespace) -> std::vector<double> {
+        using T = double;
+        using IDX = int;
+        fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+        std::vector<T> u_data(layout.size());
+        fespan u{u_data.data(), layout};
+        Projection<T, IDX, 2, 1> projection{[](const T* x, T* out){
+            out[0] = 1.0 + 0.5 * std::sin(std::numbers::pi * x[0]) * std::cos(std::numbers::pi * x[1]);
+        }};
+        LinearFormSolver{fespace, projection}.solve(u);
+        return u_data;
+    }
+
+    /// @brief the largest difference relative to the largest magnitude of the reference
+    auto max_rel_diff(const std::vector<double>& a, const std::vector<double>& ref) -> double {
+        double diff = 0, scale = 0;
+        for(std::size_t i = 0; i < ref.size(); ++i){
+            diff = std::max(diff, std::abs(a[i] - ref[i]));
+            scale = std::max(scale, std::abs(ref[i]));
+        }
+        return diff / scale;
+    }
+}
+
+TEST_F(Box2dLagrangeP2, test_device_residual){
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+    BurgersCoefficients<T, 2> coeffs{};
+    coeffs.mu = 0.05;
+    coeffs.a[0] = 1.0;
+    coeffs.a[1] = -0.25;
+    coeffs.b[0] = 0.5;
+    coeffs.b[1] = 1.0;
+    ConservationLawDDG disc{BurgersFlux{coeffs}, BurgersUpwind{coeffs}, BurgersDiffusionFlux{coeffs}};
+
+    std::vector<T> u_data = initial_condition(fespace);
+    fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    fespan u{u_data.data(), layout};
+
+    DeviceResidual device_residual{fespace, disc};
+    device_fespan<T, IDX, 1> u_device{fespace.dg_map}, res_device{fespace.dg_map};
+    u_device.copy_from_host(u);
+
+    // standard DDG and DDGIC
+    for(T sigma_ic : {0.0, 1.0}){
+        disc.sigma_ic = sigma_ic;
+        std::vector<T> res_host_data(layout.size());
+        fespan res_host{res_host_data.data(), layout};
+        ResidualWorkspace<T, IDX> workspace{fespace, 1};
+        form_residual(fespace, disc, u, res_host, workspace);
+        T lambda_host = disc.phys_flux.lambda_max;
+
+        disc.phys_flux.lambda_max = 0;
+        device_residual(fespace, disc, u_device, res_device);
+        std::vector<T> res_data(layout.size());
+        res_device.copy_to_host(fespan{res_data.data(), layout});
+        ASSERT_LT(max_rel_diff(res_data, res_host_data), 1e-12);
+        ASSERT_NEAR(disc.phys_flux.lambda_max, lambda_host, 1e-12 * lambda_host);
+    }
+}
+
+TEST(test_device_residual, test_burgers_boundary_traces){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 1,
+        {BOUNDARY_CONDITIONS::DIRICHLET, BOUNDARY_CONDITIONS::NEUMANN,
+         BOUNDARY_CONDITIONS::EXTRAPOLATION, BOUNDARY_CONDITIONS::DIRICHLET}, {0, 0, 0, 1});
+    FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LEGENDRE,
+        std::integral_constant<int, 2>{}};
+    BurgersCoefficients<T, 2> coeffs{};
+    coeffs.mu = 0.05;
+    coeffs.a[0] = 1.0;
+    coeffs.a[1] = -0.25;
+    coeffs.b[0] = 0.5;
+    coeffs.b[1] = 1.0;
+    ConservationLawDDG disc{BurgersFlux{coeffs}, BurgersUpwind{coeffs}, BurgersDiffusionFlux{coeffs}};
+    disc.dirichlet_callbacks.push_back([](const T* x, T* out){ out[0] = 1.0 + 0.25 * x[1]; });
+    disc.dirichlet_callbacks.push_back([](const T* x, T* out){ out[0] = 0.5 * x[0]; });
+    disc.neumann_callbacks.push_back([](const T* x, T* out){ out[0] = 0.3 + x[0]; });
+
+    std::vector<T> u_data = initial_condition(fespace);
+    fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    fespan u{u_data.data(), layout};
+
+    DeviceResidual device_residual{fespace, disc};
+    device_fespan<T, IDX, 1> u_device{fespace.dg_map}, res_device{fespace.dg_map};
+    u_device.copy_from_host(u);
+
+    // the boundary conditions with and without the interface correction
+    for(T sigma_ic : {0.0, 1.0}){
+        disc.sigma_ic = sigma_ic;
+        std::vector<T> res_host_data(layout.size());
+        fespan res_host{res_host_data.data(), layout};
+        ResidualWorkspace<T, IDX> workspace{fespace, 1};
+        form_residual(fespace, disc, u, res_host, workspace);
+
+        device_residual(fespace, disc, u_device, res_device);
+        std::vector<T> res_data(layout.size());
+        res_device.copy_to_host(fespan{res_data.data(), layout});
+        ASSERT_LT(max_rel_diff(res_data, res_host_data), 1e-12);
+    }
+
+    // the element timesteps of the host CFLTimestep
+    disc.track_element_wavespeeds = true;
+    disc.element_wavespeeds.assign(fespace.elements.size(), 0.0);
+    std::vector<T> res_host_data(layout.size());
+    ResidualWorkspace<T, IDX> workspace{fespace, 1};
+    form_residual(fespace, disc, u, fespan{res_host_data.data(), layout}, workspace);
+    CFLTimestep<T, IDX> cfl_timestep{};
+    T dt_host = cfl_timestep(fespace, disc, u);
+    ASSERT_TRUE(device_residual.has_wavespeeds());
+    T dt_device = device_residual.cfl_timestep(fespace, disc, cfl_timestep.cfl);
+    ASSERT_NEAR(dt_device, dt_host, 1e-12 * dt_host);
+}
+
+TEST(test_device_residual, test_navier_stokes){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+    static constexpr int neq = ndim + 2;
+    using namespace navier_stokes;
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 1,
+        {BOUNDARY_CONDITIONS::DIRICHLET, BOUNDARY_CONDITIONS::SLIP_WALL,
+         BOUNDARY_CONDITIONS::RIEMANN, BOUNDARY_CONDITIONS::NO_SLIP_ISOTHERMAL}, {0, 0, 0, 0});
+    FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LEGENDRE,
+        std::integral_constant<int, 2>{}};
+
+    // non unit Euler number and energy coefficient, temperature dependent viscosity
+    ReferenceParameters<T> ref{.rho = 1.225, .u = 2.0, .p = 10, .T = 273.15};
+    CaloricallyPerfectEoS<T, ndim> eos{};
+    DimensionlessSutherlands<T> visc{ref};
+    Physics physics{ref, eos, visc};
+    auto state = [](const T* x, T* out){
+        out[0] = 1.0 + 0.1 * std::sin(x[0] + 2.0 * x[1]);
+        out[1] = 0.3 * out[0];
+        out[2] = 0.1 * out[0] * (1.0 + x[0]);
+        out[3] = 2.5 + 0.2 * x[1];
+    };
+    std::array<T, neq> u_wall;
+    T x_wall[ndim] = {0.0, 1.0};
+    state(x_wall, u_wall.data());
+    physics.isothermal_temperatures = {1.1 * physics.calc_thermo_state(u_wall).T};
+    physics.free_stream.rho_inf = 1.05;
+    physics.free_stream.u_inf = 0.4;
+    physics.free_stream.u_direction = {0.8, 0.6};
+    physics.free_stream.temp_inf = physics.calc_thermo_state(u_wall).T;
+    ConservationLawDDG disc{Flux{physics, std::true_type{}}, VanLeer{physics},
+        DiffusionFlux{physics, std::true_type{}}};
+    disc.dirichlet_callbacks.push_back(state);
+
+    fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, neq>{}};
+    std::vector<T> u_data(layout.size());
+    fespan u{u_data.data(), layout};
+    Projection<T, IDX, ndim, neq> projection{state};
+    LinearFormSolver{fespace, projection}.solve(u);
+
+    std::vector<T> res_host_data(layout.size());
+    fespan res_host{res_host_data.data(), layout};
+    ResidualWorkspace<T, IDX> workspace{fespace, neq};
+    form_residual(fespace, disc, u, res_host, workspace);
+    T lambda_host = disc.phys_flux.lambda_max;
+    T visc_host = disc.phys_flux.visc_max;
+
+    // every boundary condition is on the device
+    disc.phys_flux.lambda_max = 0;
+    disc.phys_flux.visc_max = 0;
+    DeviceResidual device_residual{fespace, disc};
+    device_fespan<T, IDX, neq> u_device{fespace.dg_map}, res_device{fespace.dg_map};
+    u_device.copy_from_host(u);
+    device_residual(fespace, disc, u_device, res_device);
+    std::vector<T> res_data(layout.size());
+    res_device.copy_to_host(fespan{res_data.data(), layout});
+    ASSERT_LT(max_rel_diff(res_data, res_host_data), 1e-10);
+    ASSERT_NEAR(disc.phys_flux.lambda_max, lambda_host, 1e-12 * lambda_host);
+    ASSERT_NEAR(disc.phys_flux.visc_max, visc_host, 1e-12 * visc_host);
+}
+
+TEST_F(Box2dLagrangeP2, test_device_rk3){
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+    BurgersCoefficients<T, 2> coeffs{};
+    coeffs.mu = 0.01;
+    coeffs.a[0] = 0.5;
+    coeffs.b[0] = 1.0;
+    coeffs.b[1] = 0.5;
+    ConservationLawDDG disc{BurgersFlux{coeffs}, BurgersUpwind{coeffs}, BurgersDiffusionFlux{coeffs}};
+    fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    FixedTimestep<T, IDX> timestep{0.01};
+    TimestepTermination<T, IDX> stop{10};
+
+    // SSP: the host and device schemes take the same steps
+    {
+        std::vector<T> u_host_data = initial_condition(fespace);
+        RK3SSP host_solver{fespace, disc, timestep, stop};
+        host_solver.vis_callback = [](auto&){};
+        host_solver.solve(fespace, disc, fespan{u_host_data.data(), layout});
+
+        std::vector<T> u_data = initial_condition(fespace);
+        device_fespan<T, IDX, 1> u_device{fespace.dg_map};
+        u_device.copy_from_host(fespan{u_data.data(), layout});
+        DeviceRK3SSP device_solver{fespace, disc, timestep, stop};
+        device_solver.vis_callback = [](auto&, auto&){};
+        device_solver.solve(fespace, disc, u_device);
+        u_device.copy_to_host(fespan{u_data.data(), layout});
+
+        ASSERT_EQ(device_solver.itime, host_solver.itime);
+        ASSERT_NEAR(device_solver.time, host_solver.time, 1e-14);
+        ASSERT_LT(max_rel_diff(u_data, u_host_data), 1e-11);
+    }
+
+    // TVD
+    {
+        std::vector<T> u_host_data = initial_condition(fespace);
+        RK3TVD host_solver{fespace, disc, timestep, stop};
+        host_solver.vis_callback = [](auto&){};
+        host_solver.solve(fespace, disc, fespan{u_host_data.data(), layout});
+
+        std::vector<T> u_data = initial_condition(fespace);
+        device_fespan<T, IDX, 1> u_device{fespace.dg_map};
+        u_device.copy_from_host(fespan{u_data.data(), layout});
+        DeviceRK3TVD device_solver{fespace, disc, timestep, stop};
+        device_solver.vis_callback = [](auto&, auto&){};
+        device_solver.solve(fespace, disc, u_device);
+        u_device.copy_to_host(fespan{u_data.data(), layout});
+
+        ASSERT_LT(max_rel_diff(u_data, u_host_data), 1e-11);
+    }
+}
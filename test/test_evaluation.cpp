@@ -1,9 +1,15 @@
 #include "iceicle/fe_utils.hpp"
 #include "iceicle/geometry/transformations_table.hpp"
 #include "iceicle/basis/lagrange.hpp"
+#include "iceicle/basis/legendre.hpp"
+#include "iceicle/basis/sum_factorization.hpp"
 #include "iceicle/quadrature/HypercubeGaussLegendre.hpp"
+#include "iceicle/quadrature/quadrules_1d.hpp"
 #include "iceicle/element/finite_element.hpp"
 #include <gtest/gtest.h>
+#include <cstdint>
+#include <numbers>
+#include <span>
 #include <iceicle/element/evaluation.hpp>
 #include <iceicle/disc/projection.hpp>
 
@@ -58,3 +64,172 @@ TEST(test_evaluation, test_2d_quad) {
         ASSERT_NEAR(eval.bi_span[3], (xi + 1) * (eta + 1) / 4 , std::numeric_limits<double>::epsilon());
     }
 }
+
+TEST(test_evaluation, test_sum_factorization) {
+    static constexpr int ndim = 3;
+    static constexpr int order = 3;
+    static constexpr int nqp_1d = order + 2;
+
+    HypercubeLagrangeBasis<double, int, ndim, order> basis{};
+    HypercubeGaussLegendre<double, int, ndim, nqp_1d> quadrule{};
+    SumFactorization<double, ndim> sf{UniformLagrangeInterpolation<double, order>{},
+        GaussLegendreQuadrature<double, int, nqp_1d>{}};
+
+    ASSERT_EQ(sf.nbasis(), basis.nbasis());
+    ASSERT_EQ(sf.nqp(), quadrule.npoints());
+
+    std::vector<double> coeff(sf.nbasis());
+    for(int ibasis = 0; ibasis < sf.nbasis(); ++ibasis) coeff[ibasis] = std::sin(0.7 * ibasis + 0.1);
+
+    std::vector<double> scratch(sf.scratch_size() + sf.nbasis());
+    std::vector<double> vals(sf.nqp());
+    std::vector<std::vector<double>> grads(ndim, std::vector<double>(sf.nqp()));
+    sf.apply(-1, coeff.data(), vals.data(), scratch.data());
+    for(int idim = 0; idim < ndim; ++idim) sf.apply(idim, coeff.data(), grads[idim].data(), scratch.data());
+
+    // compare against the full tables
+    std::vector<double> bi(basis.nbasis());
+    std::vector<double> dbi(basis.nbasis() * ndim);
+    std::vector<double> qpvals(sf.nqp());
+    std::vector<double> integral_full(sf.nbasis(), 0.0);
+    std::vector<double> dintegral_full(sf.nbasis(), 0.0);
+    for(int iqp = 0; iqp < quadrule.npoints(); ++iqp){
+        const auto& quadpt = quadrule.getPoint(iqp);
+        basis.evalBasis(quadpt.abscisse, bi.data());
+        basis.evalGradBasis(quadpt.abscisse, dbi.data());
+        double u = 0.0;
+        std::array<double, ndim> du{};
+        for(int ibasis = 0; ibasis < basis.nbasis(); ++ibasis){
+            u += coeff[ibasis] * bi[ibasis];
+            for(int idim = 0; idim < ndim; ++idim) du[idim] += coeff[ibasis] * dbi[ibasis * ndim + idim];
+        }
+        ASSERT_NEAR(vals[iqp], u, 1e-12);
+        for(int idim = 0; idim < ndim; ++idim) ASSERT_NEAR(grads[idim][iqp], du[idim], 1e-11);
+
+        // integrate a function of the quadrature point against the test functions and derivatives
+        qpvals[iqp] = std::cos(0.3 * iqp) * quadpt.weight;
+        for(int ibasis = 0; ibasis < basis.nbasis(); ++ibasis){
+            integral_full[ibasis] += qpvals[iqp] * bi[ibasis];
+            dintegral_full[ibasis] += qpvals[iqp] * dbi[ibasis * ndim + 1];
+        }
+    }
+
+    std::vector<double> integral(sf.nbasis(), 0.0);
+    std::vector<double> dintegral(sf.nbasis(), 0.0);
+    sf.apply_transpose(-1, qpvals.data(), integral.data(), scratch.data());
+    sf.apply_transpose(1, qpvals.data(), dintegral.data(), scratch.data());
+    for(int ibasis = 0; ibasis < sf.nbasis(); ++ibasis){
+        ASSERT_NEAR(integral[ibasis], integral_full[ibasis], 1e-12);
+        ASSERT_NEAR(dintegral[ibasis], dintegral_full[ibasis], 1e-11);
+    }
+}
+
+TEST(test_evaluation, test_constexpr_sum_factorization_tables) {
+    static constexpr int ndim = 2;
+    static constexpr int order = 3;
+    static constexpr int nqp_1d = order + 2;
+    using Basis1D = UniformLagrangeInterpolation<double, order>;
+
+    // the tables are computed at compile time
+    static constexpr auto tables = gauss_legendre_sum_factorization_tables<Basis1D, nqp_1d>;
+    static constexpr double gl2_error = gauss_legendre_table<double, 2>.points[0] - 1.0 / std::numbers::sqrt3;
+    static_assert(gl2_error < 1e-15 && gl2_error > -1e-15);
+    static constexpr double gll_colloc_error = gauss_lobatto_sum_factorization_tables<
+        GaussLobattoLagrangeInterpolation<double, 2>, 3>.interp_1d[4] - 1.0;
+    static_assert(gll_colloc_error < 1e-15 && gll_colloc_error > -1e-15);
+
+    // compare against the runtime construction
+    SumFactorization<double, ndim> sf{Basis1D{}, GaussLegendreQuadrature<double, int, nqp_1d>{}};
+    SumFactorization<double, ndim> sf_tables{tables};
+    ASSERT_EQ(sf_tables.nbasis_1d, sf.nbasis_1d);
+    ASSERT_EQ(sf_tables.nqp_1d, sf.nqp_1d);
+    for(int i = 0; i < nqp_1d * (order + 1); ++i){
+        ASSERT_NEAR(sf_tables.interp_1d[i], sf.interp_1d[i], 1e-14);
+        ASSERT_NEAR(sf_tables.deriv_1d[i], sf.deriv_1d[i], 1e-13);
+    }
+    for(int iqp = 0; iqp < nqp_1d; ++iqp) ASSERT_NEAR(sf_tables.weights_1d[iqp], sf.weights_1d[iqp], 1e-15);
+
+    // the fixed extent kernels match the runtime kernels
+    std::vector<double> coeff(sf.nbasis());
+    for(int ibasis = 0; ibasis < sf.nbasis(); ++ibasis) coeff[ibasis] = std::sin(0.7 * ibasis + 0.1);
+    std::vector<double> scratch(sf.scratch_size() + sf.nbasis());
+    for(int ideriv = -1; ideriv < ndim; ++ideriv){
+        std::vector<double> vals(sf.nqp()), vals_fixed(sf.nqp());
+        sf.apply(ideriv, coeff.data(), vals.data(), scratch.data());
+        tables.apply<ndim>(ideriv, coeff.data(), vals_fixed.data());
+        for(int iqp = 0; iqp < sf.nqp(); ++iqp) ASSERT_NEAR(vals_fixed[iqp], vals[iqp], 1e-12);
+
+        std::vector<double> integral(sf.nbasis(), 0.0), integral_fixed(sf.nbasis(), 0.0);
+        sf.apply_transpose(ideriv, vals.data(), integral.data(), scratch.data());
+        tables.apply_transpose<ndim>(ideriv, vals.data(), integral_fixed.data());
+        for(int ibasis = 0; ibasis < sf.nbasis(); ++ibasis) ASSERT_NEAR(integral_fixed[ibasis], integral[ibasis], 1e-12);
+    }
+}
+
+TEST(test_evaluation, test_basis_evaluation_table) {
+    static constexpr int ndim = 2;
+    static constexpr int order = 2;
+
+    HypercubeLagrangeBasis<double, int, ndim, order> basis{};
+    HypercubeGaussLegendre<double, int, ndim, order + 1> quadrule{};
+
+    BasisEvaluationTable<double, ndim> table{basis, quadrule};
+    ASSERT_EQ(table.size(), quadrule.npoints());
+
+    // the span conversion used by FESpace
+    std::span<const BasisEvaluation<double, ndim>> evals{table};
+
+    for(int iqp = 0; iqp < quadrule.npoints(); ++iqp){
+        BasisEvaluation eval{basis, quadrule.getPoint(iqp).abscisse};
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(evals[iqp].grad_bi_span.data_handle())
+                % BasisEvaluationTable<double, ndim>::alignment, 0);
+        for(int ibasis = 0; ibasis < basis.nbasis(); ++ibasis){
+            ASSERT_DOUBLE_EQ(evals[iqp].bi_span[ibasis], eval.bi_span[ibasis]);
+            for(int idim = 0; idim < ndim; ++idim){
+                ASSERT_DOUBLE_EQ((evals[iqp].grad_bi_span[ibasis, idim]), (eval.grad_bi_span[ibasis, idim]));
+                for(int jdim = 0; jdim < ndim; ++jdim)
+                    ASSERT_DOUBLE_EQ((evals[iqp].hess_bi_span[ibasis, idim, jdim]),
+                            (eval.hess_bi_span[ibasis, idim, jdim]));
+            }
+        }
+    }
+}
+
+TEST(test_evaluation, test_batched_basis_evaluation) {
+    static constexpr int ndim = 3;
+    static constexpr int order = 2;
+
+    HypercubeLagrangeBasis<double, int, ndim, order> lagrange{};
+    HypercubeLegendreBasis<double, int, ndim, order> legendre{};
+    SimplexLagrangeBasis<double, int, ndim, order> simplex{};
+    std::vector<const Basis<double, ndim>*> bases{&lagrange, &legendre, &simplex};
+
+    // points in the reference domain [npts][ndim]
+    static constexpr int npts = 7;
+    std::vector<double> xi(npts * ndim);
+    for(int ipt = 0; ipt < npts; ++ipt){
+        for(int idim = 0; idim < ndim; ++idim)
+            xi[ipt * ndim + idim] = 0.1 * (ipt + 1) * (idim + 1) - 0.45;
+    }
+
+    for(const Basis<double, ndim>* basis : bases){
+        const int nb = basis->nbasis();
+        std::vector<double> B(npts * nb), dB(npts * nb * ndim), H(npts * nb * ndim * ndim);
+        basis->evalBasisBatch(npts, xi.data(), B.data());
+        basis->evalGradBasisBatch(npts, xi.data(), dB.data());
+        basis->evalHessBasisBatch(npts, xi.data(), H.data());
+
+        std::vector<double> Bpt(nb), dBpt(nb * ndim), Hpt(nb * ndim * ndim);
+        for(int ipt = 0; ipt < npts; ++ipt){
+            basis->evalBasis(xi.data() + ipt * ndim, Bpt.data());
+            basis->evalGradBasis(xi.data() + ipt * ndim, dBpt.data());
+            basis->evalHessBasis(xi.data() + ipt * ndim, Hpt.data());
+            for(int i = 0; i < nb; ++i)
+                ASSERT_NEAR(B[ipt * nb + i], Bpt[i], 1e-14);
+            for(int i = 0; i < nb * ndim; ++i)
+                ASSERT_NEAR(dB[ipt * nb * ndim + i], dBpt[i], 1e-13);
+            for(int i = 0; i < nb * ndim * ndim; ++i)
+                ASSERT_NEAR(H[ipt * nb * ndim * ndim + i], Hpt[i], 1e-12);
+        }
+    }
+}
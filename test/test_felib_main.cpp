@@ -1,13 +1,12 @@
 
 #include <gtest/gtest.h>
+#include <iceicle/iceicle_mpi_utils.hpp>
 #ifdef ICEICLE_USE_MPI
 #include <mpi.h>
 #endif
 
 int main(int argc, char **argv){
-#ifdef ICEICLE_USE_MPI
-    MPI_Init(&argc, &argv);
-#endif
+    iceicle::mpi::init_funneled(&argc, &argv);
     ::testing::InitGoogleTest(&argc, argv);
     int result = RUN_ALL_TESTS();
 #ifdef ICEICLE_USE_MPI
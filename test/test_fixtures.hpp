@@ -0,0 +1,112 @@
+/// @brief shared gtest fixtures with meshes and finite element spaces built once per test suite
+/// @author Gianni Absillis (gabsill@ncsu.edu)
+#pragma once
+#include "iceicle/element/reference_element.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/mesh/mesh.hpp"
+#include "iceicle/mesh/mesh_cache.hpp"
+#include "iceicle/tmp_utils.hpp"
+#include <concepts>
+#include <gtest/gtest.h>
+#include <memory>
+
+namespace iceicle::test {
+
+    /// @brief the periodic [-1, 1]^2 box with 3 x 2 elements
+    struct box2d_3x2 {
+        static auto desc() { return uniform_mesh_desc<double, int, 2>::box({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 1); }
+    };
+
+    /// @brief the periodic [-1, 1]^2 box with 3 x 2 elements of geometry order 2
+    struct box2d_3x2_p2 {
+        static auto desc() { return uniform_mesh_desc<double, int, 2>::box({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 2); }
+    };
+
+    /// @brief the periodic [-1, 1]^2 box with 4 x 2 elements
+    struct box2d_4x2 {
+        static auto desc() { return uniform_mesh_desc<double, int, 2>::box({-1.0, -1.0}, {1.0, 1.0}, {4, 2}, 1); }
+    };
+
+    /// @brief the periodic [-1, 1]^2 box with 4 x 3 elements of geometry order 2
+    struct box2d_4x3_p2 {
+        static auto desc() { return uniform_mesh_desc<double, int, 2>::box({-1.0, -1.0}, {1.0, 1.0}, {4, 3}, 2); }
+    };
+
+    /// @brief [-1, 1]^2 with 3 x 2 elements and dirichlet boundaries
+    /// flags: 1 left, 2 bottom, 3 right, 4 top
+    struct box2d_3x2_dirichlet {
+        static auto desc() {
+            auto desc = uniform_mesh_desc<double, int, 2>::box({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 1);
+            desc.bctypes.fill(BOUNDARY_CONDITIONS::DIRICHLET);
+            desc.bcflags = {1, 2, 3, 4};
+            return desc;
+        }
+    };
+
+    /// @brief the periodic [-1, 1]^3 box with 3 x 2 x 2 elements
+    struct box3d_3x2x2 {
+        static auto desc() { 
+            return uniform_mesh_desc<double, int, 3>::box({-1.0, -1.0, -1.0}, {1.0, 1.0, 1.0}, {3, 2, 2}, 1); 
+        }
+    };
+
+    /**
+     * @brief a test suite sharing one mesh and finite element space
+     *
+     * The mesh comes from the MeshCache (so it is only built once per process,
+     * or read from ICEICLE_MESH_CACHE) and the fespace is built in SetUpTestSuite.
+     * Tests must not modify the mesh or fespace: they are shared by every test in the suite.
+     *
+     * @tparam ndim_arg the number of dimensions
+     * @tparam MeshDesc provides the static desc() of the uniform mesh
+     * @tparam Pn the basis polynomial order
+     * @tparam basis the basis type
+     * @tparam quadrature the quadrature type
+     */
+    template<int ndim_arg, class MeshDesc, int Pn,
+        FESPACE_ENUMS::FESPACE_BASIS_TYPE basis = FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::FESPACE_QUADRATURE quadrature = FESPACE_ENUMS::GAUSS_LEGENDRE>
+    class SharedFESpaceTest : public ::testing::Test {
+        public:
+        using T = double;
+        using IDX = int;
+        static constexpr int ndim = ndim_arg;
+        static_assert(std::same_as<decltype(MeshDesc::desc()), uniform_mesh_desc<T, IDX, ndim>>,
+                "the mesh description must match the dimensionality of the fixture");
+
+        protected:
+        inline static AbstractMesh<T, IDX, ndim>* mesh = nullptr;
+        inline static std::unique_ptr<FESpace<T, IDX, ndim>> fespace{};
+
+        static void SetUpTestSuite() {
+            mesh = &MeshCache<T, IDX, ndim>::instance().get(MeshDesc::desc());
+            fespace = std::make_unique<FESpace<T, IDX, ndim>>(mesh, basis, quadrature, tmp::compile_int<Pn>{});
+        }
+
+        static void TearDownTestSuite() {
+            fespace.reset();
+            mesh = nullptr;
+        }
+    };
+
+    /// @brief p = 2 Lagrange basis with Gauss Legendre quadrature on the 3 x 2 box
+    using Box2dLagrangeP2 = SharedFESpaceTest<2, box2d_3x2, 2>;
+
+    /// @brief p = 1 Lagrange basis on the 3 x 2 box with geometry order 2
+    using Box2dP2GeoLagrangeP1 = SharedFESpaceTest<2, box2d_3x2_p2, 1>;
+
+    /// @brief p = 1 Lagrange basis on the 4 x 3 box with geometry order 2
+    using Box2d4x3P2GeoLagrangeP1 = SharedFESpaceTest<2, box2d_4x3_p2, 1>;
+
+    /// @brief p = 3 Lagrange basis on the 4 x 2 box
+    using Box2dLagrangeP3 = SharedFESpaceTest<2, box2d_4x2, 3>;
+
+    /// @brief p = 3 Lagrange basis with Gauss Lobatto quadrature (collocated) on the 3 x 2 box
+    using Box2dLobattoP3 = SharedFESpaceTest<2, box2d_3x2, 3, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LOBATTO>;
+
+    /// @brief p = 2 Lagrange basis on the 3 x 2 box with dirichlet boundaries
+    using Box2dDirichletLagrangeP2 = SharedFESpaceTest<2, box2d_3x2_dirichlet, 2>;
+
+    /// @brief p = 1 Lagrange basis on the 3 x 2 x 2 box
+    using Box3dLagrangeP1 = SharedFESpaceTest<3, box3d_3x2x2, 1>;
+}
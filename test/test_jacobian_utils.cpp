@@ -114,6 +114,74 @@ TEST(test_jacobian_utils, test_fd_trace_operator){
     }
 }
 
+TEST(test_jacobian_utils, test_dual_trace_operator){
+
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+    static constexpr int pn_geo = 2;
+    static constexpr int pn_basis = 3;
+    static constexpr int neq = 2;
+
+    AbstractMesh<T, IDX, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {2, 1}, pn_geo);
+
+    FESpace<T, IDX, ndim> fespace{
+        &mesh, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, 
+        tmp::compile_int<pn_basis>()
+    };
+
+    const TraceSpace<T, IDX, ndim>& trace = fespace.get_interior_traces()[0];
+
+    compact_layout_right<IDX, neq> uL_layout{trace.elL};
+    compact_layout_right<IDX, neq> uR_layout{trace.elR};
+    trace_layout_right<IDX, neq> res_layout{trace, neq_struct<neq>{}};
+
+    std::vector<T> uL_data(uL_layout.size());
+    std::vector<T> uR_data(uR_layout.size());
+    for(std::size_t i = 0; i < uL_data.size(); ++i) uL_data[i] = 0.1 * (i + 1);
+    for(std::size_t i = 0; i < uR_data.size(); ++i) uR_data[i] = 1.0 - 0.05 * i;
+    dofspan uL{uL_data, uL_layout};
+    dofspan uR{uR_data, uR_layout};
+
+    std::vector<T> res_fd_data(res_layout.size()), res_dual_data(res_layout.size());
+    dofspan res_fd{res_fd_data, res_layout};
+    dofspan res_dual{res_dual_data, res_layout};
+
+    std::vector<T> jdatauL_fd(compute_jacobian_storage_requirement(uL, res_fd)), jdatauL_dual(jdatauL_fd.size());
+    std::vector<T> jdatauR_fd(compute_jacobian_storage_requirement(uR, res_fd)), jdatauR_dual(jdatauR_fd.size());
+    auto jac_wrt_uL_fd{create_jacobian_mdspan(uL, res_fd, jdatauL_fd)};
+    auto jac_wrt_uR_fd{create_jacobian_mdspan(uR, res_fd, jdatauR_fd)};
+    auto jac_wrt_uL_dual{create_jacobian_mdspan(uL, res_dual, jdatauL_dual)};
+    auto jac_wrt_uR_dual{create_jacobian_mdspan(uR, res_dual, jdatauR_dual)};
+    std::ranges::fill(jdatauL_dual, 1.23423402343290);
+    std::ranges::fill(jdatauR_dual, 1.23423402343290);
+
+    // a nonlinear coupling of the left and right states (templated on the value type of the spans)
+    auto func = [](const TraceSpace<T, IDX, ndim> &trace, NodeArray<T, ndim>& coord, elspan auto uL, elspan auto uR, facspan auto res)
+    {
+        for(int ibasis_face = 0; ibasis_face < trace.nbasis_trace(); ++ibasis_face){
+            for(int ibasis_uL = ibasis_face; ibasis_uL < trace.elL.nbasis(); ++ibasis_uL){
+                res[ibasis_face, 0] += uL[ibasis_uL, 0] * uL[ibasis_uL, 1] + uR[ibasis_face, 0] * uL[ibasis_uL, 0];
+            }
+            for(int ibasis_uR = ibasis_face; ibasis_uR < trace.elR.nbasis(); ++ibasis_uR){
+                res[ibasis_face, 1] += uR[ibasis_uR, 0] * uR[ibasis_uR, 0] / (1.0 + uL[ibasis_face, 1] * uL[ibasis_face, 1]);
+            }
+        }
+    };
+
+    FiniteDifference<T, IDX, ndim> fd;
+    fd.eval_res_and_jac(func, trace, mesh, uL, uR, 1e-8, res_fd, jac_wrt_uL_fd, jac_wrt_uR_fd, linalg::empty_matrix{});
+    // fewer lanes than columns so the columns are seeded over several sweeps
+    fd.eval_res_and_jac_dual<5>(func, trace, mesh, uL, uR, res_dual, jac_wrt_uL_dual, jac_wrt_uR_dual, linalg::empty_matrix{});
+
+    for(std::size_t i = 0; i < res_fd_data.size(); ++i) ASSERT_NEAR(res_dual_data[i], res_fd_data[i], 1e-12);
+    for(std::size_t i = 0; i < jdatauL_fd.size(); ++i)
+        ASSERT_NEAR(jdatauL_dual[i], jdatauL_fd[i], 1e-5 * std::max(1.0, std::abs(jdatauL_fd[i]))) << "uL entry: " << i;
+    for(std::size_t i = 0; i < jdatauR_fd.size(); ++i)
+        ASSERT_NEAR(jdatauR_dual[i], jdatauR_fd[i], 1e-5 * std::max(1.0, std::abs(jdatauR_fd[i]))) << "uR entry: " << i;
+}
+
 TEST(test_jacobian_utils, test_scatter){
     using T = double;
     using IDX = int;
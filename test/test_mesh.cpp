@@ -3,12 +3,24 @@
 #include <gtest/gtest.h>
 #include "iceicle/fespace/fespace.hpp"
 #include "iceicle/geometry/face.hpp"
+#include "iceicle/mesh/distributed_uniform_mesh.hpp"
 #include "iceicle/mesh/mesh_utils.hpp"
 #include "iceicle/disc/projection.hpp"
 #include "iceicle/element_linear_solve.hpp"
 #include "iceicle/fe_utils.hpp"
+#include "iceicle/geometry/face_table.hpp"
+#include "iceicle/mesh/gmsh_utils.hpp"
+#include "iceicle/mesh/mesh_cache.hpp"
+#include "iceicle/mesh/native_mesh.hpp"
+#include "iceicle/mesh/mesh_partition.hpp"
+#include "test_fixtures.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
 
 using namespace iceicle;
+using iceicle::test::Box3dLagrangeP1;
 
 TEST(test_mesh, test_mixed_uniform_faces){
 
@@ -162,3 +174,673 @@ TEST(test_mesh, test_mixed_uniform_faces){
         }
     }
 }
+
+TEST(test_mesh, test_face_table){
+    using namespace MATH::GEOMETRY;
+    static constexpr int ndim = 2;
+    AbstractMesh<double, int, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {3, 4}, 2);
+    mesh.update_face_table();
+    const FaceTable<double, int, ndim>& table = mesh.face_table;
+    ASSERT_EQ(table.nfac(), mesh.faces.size());
+
+    // every face of a hypercube mesh is one concrete type
+    ASSERT_EQ(table.face_groups.nrow(), 1);
+    ASSERT_EQ(table.face_groups.rowspan(0).size(), mesh.faces.size());
+    ASSERT_NE(table.group_transforms[0], nullptr);
+
+    std::random_device rdev{};
+    std::default_random_engine engine{rdev()};
+    std::uniform_real_distribution<double> domain_dist{-1.0, 1.0};
+    for(std::size_t ifac = 0; ifac < mesh.faces.size(); ++ifac){
+        const Face<double, int, ndim> &face = *(mesh.faces[ifac]);
+        ASSERT_EQ(table.elemL[ifac], face.elemL);
+        ASSERT_EQ(table.elemR[ifac], face.elemR);
+        ASSERT_EQ(table.face_nr_l[ifac], face.face_nr_l());
+        ASSERT_EQ(table.face_nr_r[ifac], face.face_nr_r());
+        ASSERT_EQ(table.orientation_r[ifac], face.orientation_r());
+        ASSERT_EQ(table.bctype[ifac], face.bctype);
+        ASSERT_EQ(table.bcflag[ifac], face.bcflag);
+        ASSERT_TRUE(std::ranges::equal(table.nodes(ifac), face.nodes_span()));
+
+        // the type specific transformations match the virtual interface
+        Point<double, 1> s{domain_dist(engine)};
+        Point<double, ndim> x_face, x_table;
+        face.transform(s, mesh.coord, x_face);
+        table.transform(ifac, s, mesh.coord, x_table);
+        auto J_face = face.Jacobian(mesh.coord, s);
+        auto J_table = table.jacobian(ifac, mesh.coord, s);
+        for(int idim = 0; idim < ndim; ++idim){
+            ASSERT_DOUBLE_EQ(x_face[idim], x_table[idim]);
+            ASSERT_DOUBLE_EQ(J_face[idim][0], J_table[idim][0]);
+        }
+    }
+}
+
+TEST(test_mesh, test_edge_swap_patch){
+    using namespace MATH::GEOMETRY;
+    static constexpr int ndim = 2;
+    std::vector<int> nelem{4, 3};
+    std::vector<double> xmin{0.0, 0.0};
+    std::vector<double> xmax{1.0, 1.0};
+    std::vector<double> quad_ratio{0.0, 0.0};
+    std::vector<BOUNDARY_CONDITIONS> bcs{
+        BOUNDARY_CONDITIONS::DIRICHLET,
+        BOUNDARY_CONDITIONS::DIRICHLET,
+        BOUNDARY_CONDITIONS::DIRICHLET,
+        BOUNDARY_CONDITIONS::DIRICHLET
+    };
+    std::vector<int> bcflags{0, 0, 0, 0};
+    AbstractMesh<double, int, ndim> mesh =
+        mixed_uniform_mesh<double, int>(nelem, xmin, xmax, quad_ratio, bcs, bcflags).value();
+    FESpace<double, int, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, tmp::compile_int<1>{}};
+
+    // swap the diagonals of a few squares (always valid) and patch the space in place
+    std::vector<int> diagonals{};
+    for(int ifac = mesh.interiorFaceStart; ifac < mesh.interiorFaceEnd; ++ifac){
+        std::span<const int> fac_nodes = mesh.faces[ifac]->nodes_span();
+        const auto& x0 = mesh.coord[fac_nodes[0]];
+        const auto& x1 = mesh.coord[fac_nodes[1]];
+        if(std::abs(x0[0] - x1[0]) > 1e-8 && std::abs(x0[1] - x1[1]) > 1e-8) diagonals.push_back(ifac);
+    }
+    ASSERT_GE(diagonals.size(), 3);
+    for(int ifac : {diagonals[0], diagonals[diagonals.size() / 2], diagonals.back()}){
+        topology_edit<int> edit = edge_swap(mesh, ifac);
+        ASSERT_EQ(util::AnomalyLog::size(), 0);
+        ASSERT_FALSE(edit.faces.empty());
+        fespace.apply_topology_edit(edit);
+    }
+    std::vector<int> invalid_faces;
+    ASSERT_TRUE(validate_normals(mesh, invalid_faces));
+
+    // the patched connectivity matches the connectivity built from scratch
+    util::crs<int, int> elsup = to_elsup(mesh.conn_el, mesh.n_nodes());
+    for(int inode = 0; inode < mesh.n_nodes(); ++inode){
+        std::vector<int> expected{elsup.rowspan(inode).begin(), elsup.rowspan(inode).end()};
+        std::ranges::sort(expected);
+        ASSERT_TRUE(std::ranges::equal(mesh.elsup.rowspan(inode), expected));
+        ASSERT_TRUE(std::ranges::equal(fespace.el_surr_nodes().rowspan(inode), expected));
+    }
+    FaceTable<double, int, ndim> table{mesh.faces};
+    for(std::size_t ifac = 0; ifac < mesh.faces.size(); ++ifac){
+        ASSERT_EQ(mesh.face_table.elemL[ifac], table.elemL[ifac]);
+        ASSERT_EQ(mesh.face_table.elemR[ifac], table.elemR[ifac]);
+        ASSERT_EQ(mesh.face_table.face_nr_l[ifac], table.face_nr_l[ifac]);
+        ASSERT_EQ(mesh.face_table.face_nr_r[ifac], table.face_nr_r[ifac]);
+        ASSERT_TRUE(std::ranges::equal(mesh.face_table.nodes(ifac), table.nodes(ifac)));
+    }
+
+    FESpace<double, int, ndim> fespace_rebuilt{&mesh, FESPACE_ENUMS::LAGRANGE,
+        FESPACE_ENUMS::GAUSS_LEGENDRE, tmp::compile_int<1>{}};
+    for(std::size_t itrace = 0; itrace < fespace.traces.size(); ++itrace){
+        ASSERT_EQ(fespace.traces[itrace].face, mesh.faces[itrace].get());
+        ASSERT_EQ(fespace.traces[itrace].elL.elidx, fespace_rebuilt.traces[itrace].elL.elidx);
+        ASSERT_EQ(fespace.traces[itrace].elR.elidx, fespace_rebuilt.traces[itrace].elR.elidx);
+        ASSERT_EQ(fespace.traces[itrace].nQP(), fespace_rebuilt.traces[itrace].nQP());
+    }
+    for(int inode = 0; inode < mesh.n_nodes(); ++inode){
+        ASSERT_TRUE(std::ranges::equal(fespace.fac_surr_nodes().rowspan(inode),
+                    fespace_rebuilt.fac_surr_nodes().rowspan(inode)));
+    }
+    for(int iel = 0; iel < mesh.nelem(); ++iel){
+        std::vector<int> patched{fespace.fac_surr_el().rowspan(iel).begin(), fespace.fac_surr_el().rowspan(iel).end()};
+        std::vector<int> rebuilt{fespace_rebuilt.fac_surr_el().rowspan(iel).begin(), 
+            fespace_rebuilt.fac_surr_el().rowspan(iel).end()};
+        std::ranges::sort(patched);
+        std::ranges::sort(rebuilt);
+        ASSERT_EQ(patched, rebuilt);
+    }
+
+    // every interior trace has exactly one color and no two traces of a color share an element
+    std::vector<int> ncolored(fespace.traces.size(), 0);
+    for(std::size_t icolor = 0; icolor < fespace.interior_trace_colors.nrow(); ++icolor){
+        std::vector<int> color_elements{};
+        for(int itrace : fespace.interior_trace_colors.rowspan(icolor)){
+            ++ncolored[itrace];
+            color_elements.push_back(fespace.traces[itrace].elL.elidx);
+            color_elements.push_back(fespace.traces[itrace].elR.elidx);
+        }
+        std::ranges::sort(color_elements);
+        ASSERT_EQ(std::ranges::adjacent_find(color_elements), color_elements.end());
+    }
+    for(int itrace = mesh.interiorFaceStart; itrace < mesh.interiorFaceEnd; ++itrace)
+        { ASSERT_EQ(ncolored[itrace], 1); }
+}
+
+TEST(test_mesh, test_reorder_mesh){
+    using namespace MATH::GEOMETRY;
+    static constexpr int ndim = 2;
+    std::vector<int> nelem{5, 7};
+    std::vector<double> xmin{0.0, 0.0};
+    std::vector<double> xmax{1.0, 1.0};
+    std::vector<double> quad_ratio{0.5, 0.5};
+    std::vector<BOUNDARY_CONDITIONS> bcs{
+        BOUNDARY_CONDITIONS::DIRICHLET,
+        BOUNDARY_CONDITIONS::DIRICHLET,
+        BOUNDARY_CONDITIONS::DIRICHLET,
+        BOUNDARY_CONDITIONS::DIRICHLET
+    };
+    std::vector<int> bcflags{0, 0, 0, 0};
+    AbstractMesh<double, int, ndim> mesh =
+        mixed_uniform_mesh<double, int>(nelem, xmin, xmax, quad_ratio, bcs, bcflags).value();
+
+    // element node coordinates before reordering
+    std::vector<std::vector<Point<double, ndim>>> el_coord_old;
+    for(int iel = 0; iel < mesh.nelem(); ++iel){
+        auto coord_el = mesh.get_el_coord(iel);
+        el_coord_old.emplace_back(coord_el.begin(), coord_el.end());
+    }
+    std::size_t nfac = mesh.faces.size();
+
+    std::vector<int> new_el = reorder_mesh(mesh);
+    ASSERT_EQ(util::AnomalyLog::size(), 0);
+    ASSERT_EQ(new_el.size(), el_coord_old.size());
+    ASSERT_EQ(mesh.faces.size(), nfac);
+
+    // the same elements exist at the new indices
+    for(int iel = 0; iel < el_coord_old.size(); ++iel){
+        auto coord_el = mesh.get_el_coord(new_el[iel]);
+        ASSERT_EQ(coord_el.size(), el_coord_old[iel].size());
+        for(int inode = 0; inode < coord_el.size(); ++inode){
+            ASSERT_DOUBLE_EQ(coord_el[inode][0], el_coord_old[iel][inode][0]);
+            ASSERT_DOUBLE_EQ(coord_el[inode][1], el_coord_old[iel][inode][1]);
+        }
+    }
+
+    // faces are consistent with the renumbered elements
+    std::random_device rdev{};
+    std::default_random_engine engine{rdev()};
+    std::uniform_real_distribution<double> domain_dist{-1.0, 1.0};
+    for(int iface = mesh.interiorFaceStart; iface < mesh.interiorFaceEnd; ++iface){
+        Point<double, 1> s{domain_dist(engine)};
+
+        const Face<double, int, ndim> &face = *(mesh.faces[iface]);
+        ElementTransformation<double, int, ndim>* transL = mesh.el_transformations[face.elemL];
+        ElementTransformation<double, int, ndim>* transR = mesh.el_transformations[face.elemR];
+
+        Point<double, ndim> x_face, xiL, xiR, xL, xR;
+        face.transform(s, mesh.coord, x_face);
+        face.transform_xiL(s, xiL);
+        face.transform_xiR(s, xiR);
+        xL = transL->transform(mesh.get_el_coord(face.elemL), xiL);
+        xR = transR->transform(mesh.get_el_coord(face.elemR), xiR);
+
+        ASSERT_NEAR(x_face[0], xL[0], 1e-12);
+        ASSERT_NEAR(x_face[1], xL[1], 1e-12);
+        ASSERT_NEAR(x_face[0], xR[0], 1e-12);
+        ASSERT_NEAR(x_face[1], xR[1], 1e-12);
+        ASSERT_EQ((mesh.facsuel[face.elemL, face.face_nr_l()]), iface);
+        ASSERT_EQ((mesh.facsuel[face.elemR, face.face_nr_r()]), iface);
+    }
+    for(int iface = mesh.bdyFaceStart; iface < mesh.bdyFaceEnd; ++iface){
+        const Face<double, int, ndim> &face = *(mesh.faces[iface]);
+        ASSERT_EQ((mesh.facsuel[face.elemL, face.face_nr_l()]), iface);
+    }
+
+    // the reordered mesh still has valid normals
+    std::vector<int> invalid_faces;
+    ASSERT_TRUE(validate_normals(mesh, invalid_faces));
+}
+
+TEST(test_mesh, test_reorder_faces){
+    static constexpr int ndim = 2;
+    AbstractMesh<double, int, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {4, 3}, 1);
+    std::size_t nfac = mesh.faces.size();
+    reorder_mesh(mesh);
+    reorder_faces(mesh);
+    ASSERT_EQ(mesh.faces.size(), nfac);
+
+    auto key = [&mesh](int ifac){
+        const Face<double, int, ndim>& fac = *(mesh.faces[ifac]);
+        return std::pair{std::min(fac.elemL, fac.elemR), std::max(fac.elemL, fac.elemR)};
+    };
+    for(int ifac = mesh.interiorFaceStart; ifac < mesh.interiorFaceEnd; ++ifac){
+        ASSERT_EQ(mesh.faces[ifac]->bctype, BOUNDARY_CONDITIONS::INTERIOR);
+        if(ifac > mesh.interiorFaceStart) ASSERT_LE(key(ifac - 1), key(ifac));
+        const Face<double, int, ndim>& fac = *(mesh.faces[ifac]);
+        ASSERT_EQ((mesh.facsuel[fac.elemL, fac.face_nr_l()]), ifac);
+        ASSERT_EQ((mesh.facsuel[fac.elemR, fac.face_nr_r()]), ifac);
+    }
+    for(int ifac = mesh.bdyFaceStart; ifac < mesh.bdyFaceEnd; ++ifac){
+        const Face<double, int, ndim>& fac = *(mesh.faces[ifac]);
+        ASSERT_NE(fac.bctype, BOUNDARY_CONDITIONS::INTERIOR);
+        if(ifac > mesh.bdyFaceStart) ASSERT_LE(mesh.faces[ifac - 1]->elemL, fac.elemL);
+        ASSERT_EQ((mesh.facsuel[fac.elemL, fac.face_nr_l()]), ifac);
+    }
+
+    // the face table follows the new ordering
+    ASSERT_EQ(mesh.face_table.nfac(), nfac);
+    for(int ifac = 0; ifac < nfac; ++ifac)
+        ASSERT_EQ(mesh.face_table.elemL[ifac], mesh.faces[ifac]->elemL);
+}
+
+TEST_F(Box3dLagrangeP1, test_hash_interior_faces){
+    using namespace MATH::GEOMETRY;
+    AbstractMesh<double, int, ndim>& mesh = *(this->mesh);
+
+    auto hashed_faces = hash_interior_faces<double, int, ndim>(mesh.conn_el, mesh.el_transformations);
+    ASSERT_EQ(util::AnomalyLog::size(), 0);
+
+    // same element pairs as the interior faces of the uniform mesh (the joined periodic faces share no nodes)
+    std::vector<std::pair<int, int>> mesh_pairs, hashed_pairs;
+    for(int ifac = mesh.interiorFaceStart; ifac < mesh.interiorFaceEnd; ++ifac){
+        const Face<double, int, ndim>& fac = *(mesh.faces[ifac]);
+        if(fac.bctype == BOUNDARY_CONDITIONS::INTERIOR && !std::ranges::binary_search(mesh.periodic_faces, ifac))
+            mesh_pairs.emplace_back(std::min(fac.elemL, fac.elemR), std::max(fac.elemL, fac.elemR));
+    }
+    for(const auto& facptr : hashed_faces){
+        ASSERT_LT(facptr->elemL, facptr->elemR);
+        hashed_pairs.emplace_back(facptr->elemL, facptr->elemR);
+    }
+    std::ranges::sort(mesh_pairs);
+    std::ranges::sort(hashed_pairs);
+    ASSERT_EQ(mesh_pairs, hashed_pairs);
+
+    // the faces are consistent with both elements
+    std::random_device rdev{};
+    std::default_random_engine engine{rdev()};
+    std::uniform_real_distribution<double> domain_dist{-1.0, 1.0};
+    for(const auto& facptr : hashed_faces){
+        const Face<double, int, ndim>& face = *facptr;
+        Point<double, ndim - 1> s{domain_dist(engine), domain_dist(engine)};
+        ElementTransformation<double, int, ndim>* transL = mesh.el_transformations[face.elemL];
+        ElementTransformation<double, int, ndim>* transR = mesh.el_transformations[face.elemR];
+
+        Point<double, ndim> x_face, xiL, xiR, xL, xR;
+        face.transform(s, mesh.coord, x_face);
+        face.transform_xiL(s, xiL);
+        face.transform_xiR(s, xiR);
+        xL = transL->transform(mesh.get_el_coord(face.elemL), xiL);
+        xR = transR->transform(mesh.get_el_coord(face.elemR), xiR);
+        for(int idim = 0; idim < ndim; ++idim){
+            ASSERT_NEAR(x_face[idim], xL[idim], 1e-12);
+            ASSERT_NEAR(x_face[idim], xR[idim], 1e-12);
+        }
+    }
+}
+
+TEST(test_mesh, test_read_binary_gmsh){
+    static constexpr int ndim = 2;
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "iceicle_test_binary.msh";
+    {
+        // two quads on [0, 2] x [0, 1] with all boundary edges on physical tag 1
+        std::ofstream out{path, std::ios::binary};
+        auto write = [&out]<class V>(V value){ out.write(reinterpret_cast<const char*>(&value), sizeof(V)); };
+        out << "$MeshFormat\n4.1 1 " << sizeof(std::size_t) << "\n";
+        write(1);
+        out << "\n$EndMeshFormat\n";
+
+        out << "$Entities\n";
+        write(std::size_t{0}); write(std::size_t{1}); write(std::size_t{1}); write(std::size_t{0});
+        // curve 1 with physical tag 1
+        write(1);
+        for(int i = 0; i < 6; ++i) write(0.0);
+        write(std::size_t{1}); write(1);
+        write(std::size_t{0});
+        // surface 1 with no physical tags
+        write(1);
+        for(int i = 0; i < 6; ++i) write(0.0);
+        write(std::size_t{0});
+        write(std::size_t{0});
+        out << "\n$EndEntities\n";
+
+        out << "$Nodes\n";
+        write(std::size_t{1}); write(std::size_t{6}); write(std::size_t{1}); write(std::size_t{6});
+        write(2); write(1); write(0); write(std::size_t{6});
+        for(std::size_t tag = 1; tag <= 6; ++tag) write(tag);
+        double xy[6][2] = {{0, 0}, {1, 0}, {2, 0}, {0, 1}, {1, 1}, {2, 1}};
+        for(int inode = 0; inode < 6; ++inode){
+            write(xy[inode][0]); write(xy[inode][1]); write(0.0);
+        }
+        out << "\n$EndNodes\n";
+
+        out << "$Elements\n";
+        write(std::size_t{2}); write(std::size_t{8}); write(std::size_t{1}); write(std::size_t{8});
+        // boundary lines
+        std::size_t lines[6][2] = {{1, 2}, {2, 3}, {3, 6}, {6, 5}, {5, 4}, {4, 1}};
+        write(1); write(1); write(1); write(std::size_t{6});
+        for(std::size_t iline = 0; iline < 6; ++iline){
+            write(iline + 1); write(lines[iline][0]); write(lines[iline][1]);
+        }
+        // quads
+        std::size_t quads[2][4] = {{1, 2, 5, 4}, {2, 3, 6, 5}};
+        write(2); write(1); write(3); write(std::size_t{2});
+        for(std::size_t iquad = 0; iquad < 2; ++iquad){
+            write(iquad + 7);
+            for(int inode = 0; inode < 4; ++inode) write(quads[iquad][inode]);
+        }
+        out << "\n$EndElements\n";
+    }
+
+    std::map<int, std::tuple<BOUNDARY_CONDITIONS, int>> bcmap{{1, std::tuple{BOUNDARY_CONDITIONS::DIRICHLET, 0}}};
+    auto mesh_opt = read_gmsh<double, int, ndim>(path.string(), bcmap);
+    std::filesystem::remove(path);
+    ASSERT_TRUE(mesh_opt.has_value());
+    ASSERT_EQ(util::AnomalyLog::size(), 0);
+    AbstractMesh<double, int, ndim>& mesh = mesh_opt.value();
+
+    ASSERT_EQ(mesh.nelem(), 2);
+    ASSERT_EQ(mesh.interiorFaceEnd - mesh.interiorFaceStart, 1);
+    ASSERT_EQ(mesh.bdyFaceEnd - mesh.bdyFaceStart, 6);
+    // node tags are used as indices
+    ASSERT_DOUBLE_EQ(mesh.coord[5][0], 1.0);
+    ASSERT_DOUBLE_EQ(mesh.coord[5][1], 1.0);
+    ASSERT_DOUBLE_EQ(mesh.coord[3][0], 2.0);
+    // tensor product ordering of the quad nodes
+    ASSERT_EQ((mesh.conn_el[0, 0]), 1);
+    ASSERT_EQ((mesh.conn_el[0, 1]), 4);
+    ASSERT_EQ((mesh.conn_el[0, 2]), 2);
+    ASSERT_EQ((mesh.conn_el[0, 3]), 5);
+    for(int ifac = mesh.bdyFaceStart; ifac < mesh.bdyFaceEnd; ++ifac)
+        ASSERT_EQ(mesh.faces[ifac]->bctype, BOUNDARY_CONDITIONS::DIRICHLET);
+}
+
+TEST(test_mesh, test_native_mesh){
+    static constexpr int ndim = 2;
+    AbstractMesh<double, int, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 2);
+    mesh.coord[4][0] += 0.05;
+    mesh.update_coord_els();
+
+    std::string basename = (std::filesystem::temp_directory_path() / "iceicle_test_native_mesh").string();
+    write_native_mesh(mesh, basename);
+    auto mesh_opt = read_native_mesh<double, int, ndim>(basename);
+    std::filesystem::remove(impl::native_mesh::rank_filename(basename, 0));
+    ASSERT_EQ(util::AnomalyLog::size(), 0);
+    ASSERT_TRUE(mesh_opt.has_value());
+    AbstractMesh<double, int, ndim>& read_mesh = mesh_opt.value();
+
+    ASSERT_EQ(read_mesh.n_nodes(), mesh.n_nodes());
+    for(int inode = 0; inode < mesh.n_nodes(); ++inode)
+        for(int idim = 0; idim < ndim; ++idim)
+            ASSERT_EQ(read_mesh.coord[inode][idim], mesh.coord[inode][idim]);
+
+    ASSERT_EQ(read_mesh.nelem(), mesh.nelem());
+    for(int iel = 0; iel < mesh.nelem(); ++iel){
+        ASSERT_EQ(read_mesh.el_transformations[iel], mesh.el_transformations[iel]);
+        ASSERT_TRUE(std::ranges::equal(read_mesh.conn_el.rowspan(iel), mesh.conn_el.rowspan(iel)));
+        ASSERT_TRUE(std::ranges::equal(read_mesh.facsuel.rowspan(iel), mesh.facsuel.rowspan(iel)));
+    }
+
+    ASSERT_EQ(read_mesh.faces.size(), mesh.faces.size());
+    ASSERT_EQ(read_mesh.interiorFaceStart, mesh.interiorFaceStart);
+    ASSERT_EQ(read_mesh.interiorFaceEnd, mesh.interiorFaceEnd);
+    ASSERT_EQ(read_mesh.bdyFaceStart, mesh.bdyFaceStart);
+    ASSERT_EQ(read_mesh.bdyFaceEnd, mesh.bdyFaceEnd);
+    for(std::size_t ifac = 0; ifac < mesh.faces.size(); ++ifac){
+        const Face<double, int, ndim>& face = *mesh.faces[ifac];
+        const Face<double, int, ndim>& read_face = *read_mesh.faces[ifac];
+        ASSERT_EQ(read_face.elemL, face.elemL);
+        ASSERT_EQ(read_face.elemR, face.elemR);
+        ASSERT_EQ(read_face.face_nr_l(), face.face_nr_l());
+        ASSERT_EQ(read_face.face_nr_r(), face.face_nr_r());
+        ASSERT_EQ(read_face.orientation_r(), face.orientation_r());
+        ASSERT_EQ(read_face.bctype, face.bctype);
+        ASSERT_EQ(read_face.bcflag, face.bcflag);
+        ASSERT_EQ(read_face.geometry_order(), face.geometry_order());
+        ASSERT_TRUE(std::ranges::equal(read_face.nodes_span(), face.nodes_span()));
+    }
+    ASSERT_EQ(read_mesh.face_table.nfac(), mesh.faces.size());
+
+    // a missing file is not an error, the mesh just needs to be built
+    ASSERT_FALSE((read_native_mesh<double, int, ndim>(basename).has_value()));
+    ASSERT_EQ(util::AnomalyLog::size(), 0);
+}
+
+TEST(test_mesh, test_mesh_cache){
+    static constexpr int ndim = 2;
+    using desc_t = uniform_mesh_desc<double, int, ndim>;
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "iceicle_test_mesh_cache";
+    std::filesystem::remove_all(directory);
+
+    desc_t desc = desc_t::box({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 2);
+    AbstractMesh<double, int, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 2);
+    // the cached meshes have the periodic faces joined
+    ASSERT_EQ(mesh.make_periodic_faces_interior(), 5);
+
+    // the first request builds and serializes the mesh, the second is the same mesh
+    MeshCache<double, int, ndim> cache{directory};
+    AbstractMesh<double, int, ndim>& cached = cache.get(desc);
+    ASSERT_EQ(&cache.get(desc), &cached);
+    ASSERT_EQ(cache.size(), 1);
+    ASSERT_TRUE(std::filesystem::exists(impl::native_mesh::rank_filename((directory / desc.name()).string(), 0)));
+    ASSERT_NE(desc.name(), desc_t::box({-1.0, -1.0}, {1.0, 1.0}, {3, 2}, 1).name());
+
+    // a new cache reads the serialized mesh
+    MeshCache<double, int, ndim> cache2{directory};
+    AbstractMesh<double, int, ndim>& read_mesh = cache2.get(desc);
+    ASSERT_EQ(util::AnomalyLog::size(), 0);
+    for(const AbstractMesh<double, int, ndim>* m : {&cached, &read_mesh}){
+        ASSERT_EQ(m->n_nodes(), mesh.n_nodes());
+        for(int inode = 0; inode < mesh.n_nodes(); ++inode)
+            for(int idim = 0; idim < ndim; ++idim)
+                ASSERT_EQ(m->coord[inode][idim], mesh.coord[inode][idim]);
+        ASSERT_EQ(m->faces.size(), mesh.faces.size());
+        ASSERT_EQ(m->interiorFaceStart, mesh.interiorFaceStart);
+        ASSERT_EQ(m->interiorFaceEnd, mesh.interiorFaceEnd);
+        ASSERT_EQ(m->bdyFaceStart, mesh.bdyFaceStart);
+        ASSERT_EQ(m->bdyFaceEnd, mesh.bdyFaceEnd);
+        ASSERT_EQ(m->periodic_faces, mesh.periodic_faces);
+    }
+
+    // copies can be modified without changing the cached mesh
+    AbstractMesh<double, int, ndim> copy = cache2.copy(desc);
+    copy.coord[4][0] += 0.05;
+    ASSERT_EQ(read_mesh.coord[4][0], mesh.coord[4][0]);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(test_mesh, test_partition_weights){
+    ASSERT_EQ(estimate_nbasis(DOMAIN_TYPE::HYPERCUBE, 3, 2), 27);
+    ASSERT_EQ(estimate_nbasis(DOMAIN_TYPE::SIMPLEX, 2, 2), 6);
+    ASSERT_EQ(estimate_nbasis(DOMAIN_TYPE::SIMPLEX, 3, 1), 4);
+    ASSERT_EQ(estimate_nbasis(DOMAIN_TYPE::HYPERCUBE, 1, 0), 1);
+
+    std::vector<int> nelem{2, 2};
+    std::vector<double> xmin{0.0, 0.0};
+    std::vector<double> xmax{1.0, 1.0};
+    std::vector<double> quad_ratio{0.5, 0.5};
+    std::vector<BOUNDARY_CONDITIONS> bcs(4, BOUNDARY_CONDITIONS::DIRICHLET);
+    std::vector<int> bcflags{0, 0, 0, 0};
+    AbstractMesh<double, int, 2> mesh =
+        mixed_uniform_mesh<double, int>(nelem, xmin, xmax, quad_ratio, bcs, bcflags).value();
+
+    // p = 1: quads are 4 basis x 9 quadrature points, triangles are 3 x 3
+    partition_weights<int> weights = estimate_partition_weights(mesh, 1);
+    ASSERT_EQ(weights.el_weights.size(), mesh.nelem());
+    ASSERT_EQ(weights.face_weights.size(), mesh.faces.size());
+    for(int iel = 0; iel < mesh.nelem(); ++iel){
+        int expected = (mesh.el_transformations[iel]->domain_type == DOMAIN_TYPE::HYPERCUBE) ? 36 : 9;
+        ASSERT_EQ(weights.el_weights[iel], expected);
+    }
+    for(int ifac = mesh.interiorFaceStart; ifac < mesh.interiorFaceEnd; ++ifac)
+        ASSERT_EQ(weights.face_weights[ifac], 2);
+
+    // the higher order side determines the trace cost
+    std::vector<int> el_order(mesh.nelem(), 1);
+    el_order[0] = 3;
+    weights = estimate_partition_weights(mesh, std::span<const int>{el_order});
+    for(int ifac = mesh.interiorFaceStart; ifac < mesh.interiorFaceEnd; ++ifac){
+        const Face<double, int, 2>& fac = *mesh.faces[ifac];
+        ASSERT_EQ(weights.face_weights[ifac], (fac.elemL == 0 || fac.elemR == 0) ? 4 : 2);
+    }
+}
+
+TEST(test_mesh, test_update_nodes){
+    static constexpr int ndim = 2;
+    AbstractMesh<double, int, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {4, 3}, 2);
+
+    // move a few nodes and only update the surrounding element rows
+    std::vector<int> moved{5, 17};
+    for(int inode : moved){
+        mesh.coord[inode][0] += 0.01;
+        mesh.coord[inode][1] -= 0.02;
+    }
+    std::size_t version_before = mesh.coord_version;
+    mesh.update_nodes(moved);
+
+    for(int iel = 0; iel < mesh.nelem(); ++iel){
+        bool touched = false;
+        for(int ilocal = 0; ilocal < mesh.conn_el.rowsize(iel); ++ilocal){
+            int inode = mesh.conn_el[iel, ilocal];
+            touched = touched || std::ranges::find(moved, inode) != moved.end();
+            for(int idim = 0; idim < ndim; ++idim)
+                ASSERT_EQ((mesh.coord_els[iel, ilocal][idim]), mesh.coord[inode][idim]);
+        }
+        ASSERT_EQ(mesh.element_coord_version(iel) > version_before, touched);
+    }
+}
+
+TEST(test_mesh, test_periodic_faces_interior){
+    using namespace MATH::GEOMETRY;
+    static constexpr int ndim = 2;
+    AbstractMesh<double, int, ndim> mesh({-1.0, -1.0}, {1.0, 1.0}, {4, 3}, 2);
+    int ninterior = mesh.interiorFaceEnd - mesh.interiorFaceStart;
+    int nbdy = mesh.bdyFaceEnd - mesh.bdyFaceStart;
+
+    int npair = mesh.make_periodic_faces_interior();
+    ASSERT_EQ(util::AnomalyLog::size(), 0);
+    ASSERT_EQ(npair, nbdy / 2);
+    ASSERT_EQ(mesh.interiorFaceEnd - mesh.interiorFaceStart, ninterior + npair);
+    ASSERT_EQ(mesh.bdyFaceEnd - mesh.bdyFaceStart, 0);
+    ASSERT_EQ(mesh.periodic_faces.size(), npair);
+    ASSERT_EQ(mesh.face_table.nfac(), mesh.faces.size());
+
+    // both elements see the same point on the face up to the periodic offset
+    std::random_device rdev{};
+    std::default_random_engine engine{rdev()};
+    std::uniform_real_distribution<double> domain_dist{-1.0, 1.0};
+    for(int ifac = mesh.interiorFaceStart; ifac < mesh.interiorFaceEnd; ++ifac){
+        const Face<double, int, ndim> &face = *(mesh.faces[ifac]);
+        ASSERT_EQ(face.bctype, BOUNDARY_CONDITIONS::INTERIOR);
+        ASSERT_EQ((mesh.facsuel[face.elemL, face.face_nr_l()]), ifac);
+        ASSERT_EQ((mesh.facsuel[face.elemR, face.face_nr_r()]), ifac);
+
+        Point<double, 1> s{domain_dist(engine)};
+        Point<double, ndim> x_face, xiL, xiR, xL, xR;
+        face.transform(s, mesh.coord, x_face);
+        face.transform_xiL(s, xiL);
+        face.transform_xiR(s, xiR);
+        xL = mesh.el_transformations[face.elemL]->transform(mesh.get_el_coord(face.elemL), xiL);
+        xR = mesh.el_transformations[face.elemR]->transform(mesh.get_el_coord(face.elemR), xiR);
+        Point<double, ndim> offset = mesh.periodic_offset(ifac);
+        bool periodic = std::ranges::binary_search(mesh.periodic_faces, ifac);
+        for(int idim = 0; idim < ndim; ++idim){
+            ASSERT_NEAR(x_face[idim], xL[idim], 1e-12);
+            ASSERT_NEAR(x_face[idim], xR[idim] + offset[idim], 1e-12);
+            if(!periodic) ASSERT_EQ(offset[idim], 0.0);
+        }
+        if(periodic) ASSERT_NEAR(std::abs(offset[0]) + std::abs(offset[1]), 2.0, 1e-12);
+    }
+    std::vector<int> invalid_faces;
+    ASSERT_TRUE(validate_normals(mesh, invalid_faces));
+
+    // nothing left to convert
+    ASSERT_EQ(mesh.make_periodic_faces_interior(), 0);
+}
+
+TEST(test_mesh, test_distributed_uniform_mesh){
+    static constexpr int ndim = 2;
+    std::array<double, ndim> xmin{0.0, 0.0}, xmax{1.0, 0.75};
+    std::array<int, ndim> nelem{8, 6};
+    std::array<std::vector<double>, ndim> nodes_1d = generate_directional_nodes<ndim>(xmin, xmax, nelem, 1);
+    std::array<BOUNDARY_CONDITIONS, 2 * ndim> bctypes{BOUNDARY_CONDITIONS::PERIODIC, BOUNDARY_CONDITIONS::DIRICHLET,
+        BOUNDARY_CONDITIONS::PERIODIC, BOUNDARY_CONDITIONS::NEUMANN};
+    std::array<int, 2 * ndim> bcflags{0, 1, 0, 2};
+
+    // a single block is the uniform mesh
+    AbstractMesh<double, int, ndim> serial{nodes_1d, 1, bctypes, bcflags};
+    auto single = distributed_uniform_mesh<double, int, ndim>(nodes_1d, bctypes, bcflags, 0, 1);
+    ASSERT_TRUE(single.has_value());
+    ASSERT_EQ(single->nelem(), serial.nelem());
+    ASSERT_EQ(single->n_nodes(), serial.n_nodes());
+    ASSERT_EQ(single->faces.size(), serial.faces.size());
+    for(int iel = 0; iel < serial.nelem(); ++iel){
+        for(std::size_t inode = 0; inode < serial.conn_el.rowsize(iel); ++inode)
+            ASSERT_EQ((single->conn_el[iel, inode]), (serial.conn_el[iel, inode]));
+    }
+
+    // split into 2 x 2 blocks (the fewest faces between blocks)
+    static constexpr int nrank = 4;
+    auto grid = uniform_rank_grid<int, ndim>(nelem, {true, false}, nrank);
+    ASSERT_TRUE(grid.has_value());
+    ASSERT_EQ(grid.value()[0], 2);
+    ASSERT_EQ(grid.value()[1], 2);
+    ASSERT_FALSE((uniform_rank_grid<int, ndim>(nelem, {true, false}, 7).has_value()));
+
+    std::vector<AbstractMesh<double, int, ndim>> blocks{};
+    for(int irank = 0; irank < nrank; ++irank){
+        auto block = distributed_uniform_mesh<double, int, ndim>(nodes_1d, bctypes, bcflags, irank, nrank);
+        ASSERT_TRUE(block.has_value());
+        blocks.push_back(std::move(block.value()));
+    }
+    ASSERT_EQ(util::AnomalyLog::size(), 0);
+
+    // every element is generated once
+    std::vector<int> gel_count(serial.nelem(), 0);
+    for(auto& block : blocks){
+        ASSERT_EQ(block.nelem(), 12);
+        for(auto iel_global : block.gel_idxs) ++gel_count[iel_global];
+
+        // 4 x 3 elements with periodic neighbors on both sides in x and a neighbor on one side in y
+        int nparallel = 0, nphysical = 0;
+        for(int ifac = block.bdyFaceStart; ifac < block.bdyFaceEnd; ++ifac){
+            if(block.faces[ifac]->bctype == BOUNDARY_CONDITIONS::PARALLEL_COM) {
+                ASSERT_EQ(nphysical, 0); // parallel faces come first
+                ++nparallel;
+            } else {
+                ++nphysical;
+            }
+        }
+        ASSERT_EQ(nparallel, 2 * 3 + 4);
+        ASSERT_EQ(nphysical, 4);
+        ASSERT_EQ(block.interiorFaceEnd, 3 * 3 + 4 * 2);
+    }
+    for(int count : gel_count) ASSERT_EQ(count, 1);
+
+    // the communication lists match and the halo elements are the elements of the sending block
+    // (translated by the period across the periodic boundary)
+    for(int irank = 0; irank < nrank; ++irank){
+        for(int jrank = 0; jrank < nrank; ++jrank){
+            ASSERT_EQ(blocks[irank].el_recv_list[jrank], blocks[jrank].el_send_list[irank]);
+            ASSERT_EQ(blocks[irank].communicated_elements[jrank].size(), blocks[irank].el_recv_list[jrank].size());
+            for(std::size_t k = 0; k < blocks[irank].el_recv_list[jrank].size(); ++k){
+                int jel = blocks[irank].el_recv_list[jrank][k];
+                const auto& comm_el = blocks[irank].communicated_elements[jrank][k];
+                ASSERT_EQ(comm_el.coord_el.size(), blocks[jrank].conn_el.rowsize(jel));
+                for(std::size_t inode = 0; inode < comm_el.coord_el.size(); ++inode){
+                    double dx = comm_el.coord_el[inode][0] - blocks[jrank].coord_els[jel, inode][0];
+                    ASSERT_NEAR(dx, std::round(dx), 1e-12);
+                    ASSERT_NEAR(comm_el.coord_el[inode][1], (blocks[jrank].coord_els[jel, inode][1]), 1e-12);
+                    ASSERT_EQ(blocks[irank].coord[comm_el.conn_el[inode]][0], comm_el.coord_el[inode][0]);
+                }
+            }
+        }
+    }
+}
+
+TEST(test_mesh, test_perturb_nodes_batched){
+    static constexpr int ndim = 2;
+    AbstractMesh<double, int, ndim> mesh({0.0, 0.0}, {1.0, 1.0}, {5, 4}, 1);
+    AbstractMesh<double, int, ndim> mesh_batched = mesh;
+
+    PERTURBATION_FUNCTIONS::ZigZag<double, ndim> perturb_fcn{};
+    std::vector<bool> fixed_nodes = flag_boundary_nodes(mesh);
+    perturb_nodes(mesh, perturb_fcn, fixed_nodes);
+
+    // batches that do not divide the number of nodes
+    perturb_nodes_batched(mesh_batched, [&](std::size_t npoint, const double* x, double* xout){
+        for(std::size_t ipoint = 0; ipoint < npoint; ++ipoint){
+            std::array<double, ndim> xin{x[ipoint * ndim], x[ipoint * ndim + 1]};
+            perturb_fcn(std::span<double, ndim>{xin}, std::span<double, ndim>{xout + ipoint * ndim, ndim});
+        }
+    }, 7);
+    for(int inode = 0; inode < mesh.n_nodes(); ++inode){
+        for(int idim = 0; idim < ndim; ++idim)
+            ASSERT_DOUBLE_EQ(mesh_batched.coord[inode][idim], mesh.coord[inode][idim]);
+    }
+    for(int iel = 0; iel < mesh.nelem(); ++iel){
+        for(std::size_t inode = 0; inode < mesh.conn_el.rowsize(iel); ++inode)
+            ASSERT_DOUBLE_EQ((mesh_batched.coord_els[iel, inode][1]), (mesh.coord_els[iel, inode][1]));
+    }
+}
@@ -0,0 +1,193 @@
+#include "iceicle/disc/burgers.hpp"
+#include "iceicle/disc/conservation_law.hpp"
+#include "iceicle/disc/projection.hpp"
+#include "iceicle/explicit_euler.hpp"
+#include "iceicle/explicit_utils.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fe_function/layout_right.hpp"
+#include "iceicle/linear_form_solver.hpp"
+#include "iceicle/multirate_euler.hpp"
+#include "iceicle/ssp_rk3.hpp"
+#include "test_fixtures.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <numbers>
+#include <vector>
+
+using namespace iceicle;
+using iceicle::test::Box2dLagrangeP2;
+
+namespace {
+
+    /// @brief prescribed element timesteps (the cluster levels do not depend on the solution)
+    template<class T, class IDX>
+    struct PrescribedTimesteps {
+        std::vector<T> dt_el;
+
+        template<int ndim, class disc_T, class LayoutPolicy, class AccessorPolicy>
+        auto local_timesteps(FESpace<T, IDX, ndim>&, disc_T&, fespan<T, LayoutPolicy, AccessorPolicy>) const
+        -> std::vector<T> { return dt_el; }
+    };
+
+    /// @brief the integral of the solution over the domain
+    template<class T, class IDX, int ndim, class LayoutPolicy>
+    auto total_mass(FESpace<T, IDX, ndim>& fespace, fespan<T, LayoutPolicy> u) -> T {
+        T mass = 0;
+        for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+            QPGeometry<T, IDX, ndim> qp_geo{el};
+            for(int iqp = 0; iqp < el.nQP(); ++iqp){
+                auto bi = el.eval_basis_qp(iqp);
+                T dvol = qp_geo[iqp].dvol;
+                for(int ibasis = 0; ibasis < el.nbasis(); ++ibasis) mass += u[el.elidx, ibasis, 0] * bi[ibasis] * dvol;
+            }
+        }
+        return mass;
+    }
+
+    /// @brief the largest absolute difference
+    auto max_diff(const std::vector<double>& a, const std::vector<double>& b) -> double {
+        double diff = 0;
+        for(std::size_t i = 0; i < a.size(); ++i) diff = std::max(diff, std::abs(a[i] - b[i]));
+        return diff;
+    }
+}
+
+TEST_F(Box2dLagrangeP2, test_multirate_euler_single_level){
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+    fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    BurgersCoefficients<T, ndim> coeffs{};
+    coeffs.mu = 0.02;
+    coeffs.a[0] = 1.0;
+    coeffs.a[1] = -0.5;
+    coeffs.b[0] = 0.5;
+    ConservationLawDDG disc{BurgersFlux{coeffs}, BurgersUpwind{coeffs}, BurgersDiffusionFlux{coeffs}};
+    Projection<T, IDX, ndim, 1> projection{[](const T* x, T* out){
+        out[0] = 1.0 + 0.5 * std::sin(std::numbers::pi * x[0]) * std::cos(std::numbers::pi * x[1]);
+    }};
+    std::vector<T> u_ref_data(layout.size()), u_data(layout.size());
+    solvers::LinearFormSolver{fespace, projection}.solve(fespan{u_ref_data.data(), layout});
+    u_data = u_ref_data;
+
+    // every element at level 0 is explicit Euler
+    const T dt = 0.01;
+    solvers::ExplicitEuler euler{fespace, disc, solvers::FixedTimestep<T, IDX>{dt},
+        solvers::TimestepTermination<T, IDX>{10}};
+    euler.vis_callback = [](auto&){};
+    euler.solve(fespace, disc, fespan{u_ref_data.data(), layout});
+
+    solvers::MultirateEuler multirate{fespace, disc,
+        PrescribedTimesteps<T, IDX>{std::vector<T>(fespace.elements.size(), dt)},
+        solvers::TimestepTermination<T, IDX>{10}};
+    multirate.vis_callback = [](auto&){};
+    multirate.solve(fespace, disc, fespan{u_data.data(), layout});
+
+    ASSERT_EQ(multirate.itime, euler.itime);
+    ASSERT_NEAR(multirate.time, euler.time, 1e-14);
+    for(int level : multirate.element_level) ASSERT_EQ(level, 0);
+    ASSERT_LT(max_diff(u_data, u_ref_data), 1e-12);
+}
+
+TEST_F(Box2dLagrangeP2, test_multirate_euler_conservation){
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+    fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    BurgersCoefficients<T, ndim> coeffs{};
+    coeffs.mu = 0.02;
+    coeffs.a[0] = 1.0;
+    coeffs.a[1] = -0.5;
+    coeffs.b[0] = 0.5;
+    coeffs.b[1] = 0.25;
+    ConservationLawDDG disc{BurgersFlux{coeffs}, BurgersUpwind{coeffs}, BurgersDiffusionFlux{coeffs}};
+    Projection<T, IDX, ndim, 1> projection{[](const T* x, T* out){
+        out[0] = 1.0 + 0.5 * std::sin(std::numbers::pi * x[0]) * std::cos(std::numbers::pi * x[1]);
+    }};
+    std::vector<T> u_data(layout.size());
+    fespan u{u_data.data(), layout};
+    solvers::LinearFormSolver{fespace, projection}.solve(u);
+    T mass0 = total_mass(fespace, u);
+
+    // three cluster levels with interfaces between every pair of levels on the periodic box
+    std::vector<T> dt_el(fespace.elements.size());
+    for(IDX iel = 0; iel < (IDX) dt_el.size(); ++iel) dt_el[iel] = 0.005 * (1 << (iel % 3));
+    solvers::MultirateEuler multirate{fespace, disc, PrescribedTimesteps<T, IDX>{dt_el},
+        solvers::TimestepTermination<T, IDX>{5}};
+    multirate.vis_callback = [](auto&){};
+    multirate.solve(fespace, disc, u);
+
+    ASSERT_EQ(*std::ranges::max_element(multirate.element_level), 2);
+    ASSERT_NEAR(multirate.time, 5 * 0.02, 1e-14);
+    ASSERT_NEAR(total_mass(fespace, u), mass0, 1e-12 * std::abs(mass0));
+}
+
+TEST(test_multirate_euler, test_graded_mesh_convergence){
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+
+    // element widths in x from 0.1 to 0.4 (three cluster levels)
+    std::array<std::vector<T>, ndim> nodes_1d{
+        std::vector<T>{-1.0, -0.6, -0.2, 0.0, 0.1, 0.2, 0.4, 0.6, 1.0},
+        std::vector<T>{-1.0, 0.0, 1.0}};
+    std::array<BOUNDARY_CONDITIONS, 2 * ndim> bctypes;
+    bctypes.fill(BOUNDARY_CONDITIONS::PERIODIC);
+    std::array<int, 2 * ndim> bcflags{};
+    AbstractMesh<T, IDX, ndim> mesh{nodes_1d, 1, bctypes, bcflags};
+    mesh.make_periodic_faces_interior();
+    FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LEGENDRE,
+        std::integral_constant<int, 1>{}};
+    fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+
+    BurgersCoefficients<T, ndim> coeffs{};
+    coeffs.mu = 0.01;
+    coeffs.a[0] = 1.0;
+    ConservationLawDDG disc{BurgersFlux{coeffs}, BurgersUpwind{coeffs}, BurgersDiffusionFlux{coeffs}};
+    Projection<T, IDX, ndim, 1> projection{[](const T* x, T* out){
+        out[0] = 1.0 + 0.5 * std::sin(std::numbers::pi * x[0]);
+    }};
+    auto initial_condition = [&]{
+        std::vector<T> u_data(layout.size());
+        solvers::LinearFormSolver{fespace, projection}.solve(fespan{u_data.data(), layout});
+        return u_data;
+    };
+    const T tfinal = 0.2;
+
+    // the time integration error is measured against a converged RK3 solution of the same semi-discretization
+    std::vector<T> u_ref = initial_condition();
+    solvers::RK3SSP rk3{fespace, disc, solvers::FixedTimestep<T, IDX>{1e-4},
+        solvers::TfinalTermination<T, IDX>{tfinal}};
+    rk3.vis_callback = [](auto&){};
+    rk3.solve(fespace, disc, fespan{u_ref.data(), layout});
+
+    // the element timestep is proportional to the element width
+    std::vector<T> width(fespace.elements.size());
+    for(const FiniteElement<T, IDX, ndim>& el : fespace.elements){
+        T xmin = 1e8, xmax = -1e8;
+        for(const auto& pt : el.coord_el){
+            xmin = std::min(xmin, pt[0]);
+            xmax = std::max(xmax, pt[0]);
+        }
+        width[el.elidx] = xmax - xmin;
+    }
+    auto error = [&](T cfl) -> T {
+        std::vector<T> dt_el(width.size());
+        for(std::size_t iel = 0; iel < width.size(); ++iel) dt_el[iel] = cfl * width[iel];
+        std::vector<T> u_data = initial_condition();
+        solvers::MultirateEuler multirate{fespace, disc, PrescribedTimesteps<T, IDX>{dt_el},
+            solvers::TfinalTermination<T, IDX>{tfinal}};
+        multirate.vis_callback = [](auto&){};
+        multirate.solve(fespace, disc, fespan{u_data.data(), layout});
+        EXPECT_EQ(*std::ranges::max_element(multirate.element_level), 2);
+        EXPECT_NEAR(multirate.time, tfinal, 1e-12);
+        return max_diff(u_data, u_ref);
+    };
+
+    T err_coarse = error(0.1);
+    for(T cfl : {0.05, 0.025}){
+        T err_fine = error(cfl);
+        T rate = std::log2(err_coarse / err_fine);
+        ASSERT_GT(rate, 0.8);
+        ASSERT_LT(rate, 1.3);
+        err_coarse = err_fine;
+    }
+}
@@ -1,8 +1,17 @@
 #include <gtest/gtest.h>
+#include <iceicle/disc/conservation_law.hpp>
 #include <iceicle/disc/navier_stokes.hpp>
+#include <iceicle/disc/surface_functionals.hpp>
+#include <iceicle/fe_function/layout_right.hpp>
+#include <iceicle/mesh/mesh.hpp>
+#include "test_fixtures.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 using namespace iceicle;
 using namespace navier_stokes;
+using iceicle::test::Box2dDirichletLagrangeP2;
 template<class T2, std::size_t... sizes>
 using Tensor = NUMTOOL::TENSOR::FIXED_SIZE::Tensor<T2, sizes...>;
 
@@ -105,3 +114,452 @@ TEST(test_ns, test_flux_consistency_vanleer){
         }
     }
 }
+
+TEST(test_ns, test_batched_vanleer){
+    static constexpr int ndim = 2;
+    static constexpr int neq = ndim + 2;
+    ReferenceParameters<double> ref{};
+    CaloricallyPerfectEoS<double, ndim> eos{};
+    DimensionlessSutherlands<double> visc{ref};
+    Physics physics{ref, eos, visc};
+    VanLeer numflux{physics};
+
+    // normal velocities that span supersonic left to supersonic right 
+    static constexpr std::array vels = {-3.0, -1.0, -0.2, 0.0, 0.5, 1.0, 3.0};
+    static constexpr int npoint = vels.size();
+
+    std::array<double, neq * npoint> uL_data, uR_data, fadvn_data;
+    std::array<double, ndim * npoint> normal_data;
+    std::mdspan uL{uL_data.data(), std::extents<int, neq, std::dynamic_extent>{npoint}};
+    std::mdspan uR{uR_data.data(), std::extents<int, neq, std::dynamic_extent>{npoint}};
+    std::mdspan normals{normal_data.data(), std::extents<int, ndim, std::dynamic_extent>{npoint}};
+    std::mdspan fadvn{fadvn_data.data(), std::extents<int, neq, std::dynamic_extent>{npoint}};
+    for(int ipoint = 0; ipoint < npoint; ++ipoint){
+        double theta = 0.3 * ipoint;
+        normals[0, ipoint] = std::cos(theta);
+        normals[1, ipoint] = std::sin(theta);
+        std::array<double, neq> uLpt{1.0, vels[ipoint] * std::cos(theta), vels[ipoint] * std::sin(theta), 2.5};
+        std::array<double, neq> uRpt{0.8, 0.9 * vels[ipoint] * std::cos(theta), 0.9 * vels[ipoint] * std::sin(theta), 2.0};
+        for(int ieq = 0; ieq < neq; ++ieq){
+            uL[ieq, ipoint] = uLpt[ieq];
+            uR[ieq, ipoint] = uRpt[ieq];
+        }
+    }
+
+    numflux.batch(
+        std::mdspan<const double, std::extents<int, neq, std::dynamic_extent>>{uL_data.data(), npoint},
+        std::mdspan<const double, std::extents<int, neq, std::dynamic_extent>>{uR_data.data(), npoint},
+        std::mdspan<const double, std::extents<int, ndim, std::dynamic_extent>>{normal_data.data(), npoint},
+        fadvn);
+
+    for(int ipoint = 0; ipoint < npoint; ++ipoint){
+        std::array<double, neq> uLpt, uRpt;
+        for(int ieq = 0; ieq < neq; ++ieq){
+            uLpt[ieq] = uL[ieq, ipoint];
+            uRpt[ieq] = uR[ieq, ipoint];
+        }
+        Tensor<double, ndim> normal{normals[0, ipoint], normals[1, ipoint]};
+        std::array<double, neq> f_pt = numflux(uLpt, uRpt, normal);
+        for(int ieq = 0; ieq < neq; ++ieq)
+            ASSERT_NEAR(f_pt[ieq], (fadvn[ieq, ipoint]), 1e-12);
+    }
+}
+
+TEST(test_ns, test_two_point_flux){
+    static constexpr int ndim = 2;
+    static constexpr int neq = ndim + 2;
+    ReferenceParameters<double> ref{};
+    CaloricallyPerfectEoS<double, ndim> eos{};
+    DimensionlessSutherlands<double> visc{ref};
+    Physics physics{ref, eos, visc};
+    Flux pflux{physics};
+
+    std::array<double, neq> uL{1.0, 0.3, -0.2, 2.5};
+    std::array<double, neq> uR{0.8, -0.1, 0.4, 2.0};
+    Tensor<double, ndim> n{0.6, -1.3};
+
+    std::array<double, neq * ndim> ugrad_data;
+    std::ranges::fill(ugrad_data, 0.0);
+    std::mdspan ugrad{ugrad_data.data(), std::extents{neq, ndim}};
+    Tensor<double, neq, ndim> f_phys = pflux(uL, ugrad);
+
+    for(TWO_POINT_FLUX type : {TWO_POINT_FLUX::ISMAIL_ROE, TWO_POINT_FLUX::CHANDRASHEKAR}){
+        pflux.two_point_type = type;
+
+        // consistent with the inviscid flux
+        std::array<double, neq> f_same = pflux.two_point_flux(uL, uL, n);
+        for(int ieq = 0; ieq < neq; ++ieq)
+            ASSERT_NEAR(f_phys[ieq][0] * n[0] + f_phys[ieq][1] * n[1], f_same[ieq], 1e-10);
+
+        // symmetric
+        std::array<double, neq> f_LR = pflux.two_point_flux(uL, uR, n);
+        std::array<double, neq> f_RL = pflux.two_point_flux(uR, uL, n);
+        for(int ieq = 0; ieq < neq; ++ieq)
+            ASSERT_NEAR(f_LR[ieq], f_RL[ieq], 1e-12);
+    }
+}
+
+TEST(test_ns, test_thermo_state_block){
+    static constexpr int ndim = 2;
+    static constexpr int neq = ndim + 2;
+    ReferenceParameters<double> ref{.rho = 1.225, .p = 10, .T = 273.15};
+    Nondimensionalization<double> nondim{create_nondim(ref)};
+    CaloricallyPerfectEoS<double, ndim> eos{};
+
+    // more points than the block capacity 
+    static constexpr int npoint = 40;
+    std::array<double, neq * npoint> u_data;
+    std::mdspan<const double, std::extents<int, neq, std::dynamic_extent>> u{u_data.data(), npoint};
+    for(int ipoint = 0; ipoint < npoint; ++ipoint){
+        u_data[0 * npoint + ipoint] = 0.5 + 0.02 * ipoint;
+        u_data[1 * npoint + ipoint] = 0.3 - 0.01 * ipoint;
+        u_data[2 * npoint + ipoint] = 0.1 * std::sin(ipoint);
+        u_data[3 * npoint + ipoint] = 2.0 + 0.05 * ipoint;
+    }
+
+    auto check_varset = [&]<VARSET varset>(std::integral_constant<VARSET, varset>){
+        ThermodynamicStateBlock<double, ndim> block;
+        for(int iblock = 0; iblock < npoint; iblock += block.capacity){
+            eos.template calc_thermo_state_block<varset>(u, iblock, ref, nondim, block);
+            ASSERT_EQ(block.npoint, std::min(block.capacity, npoint - iblock));
+            for(int i = 0; i < block.npoint; ++i){
+                std::array<double, neq> upt;
+                for(int ieq = 0; ieq < neq; ++ieq) upt[ieq] = u[ieq, iblock + i];
+                ThermodynamicState<double, ndim> expected = eos.template calc_thermo_state<varset>(upt, ref, nondim);
+                ThermodynamicState<double, ndim> actual = block.state(i);
+                // relative tolerance (the reference parameters give large dimensionless energies)
+                auto tol = [](double val){ return 1e-12 * std::max(1.0, std::abs(val)); };
+                ASSERT_NEAR(actual.rho, expected.rho, tol(expected.rho));
+                ASSERT_NEAR(actual.rhoE, expected.rhoE, tol(expected.rhoE));
+                ASSERT_NEAR(actual.T, expected.T, tol(expected.T));
+                ASSERT_NEAR(actual.vv, expected.vv, tol(expected.vv));
+                ASSERT_NEAR(actual.p, expected.p, tol(expected.p));
+                ASSERT_NEAR(actual.csound, expected.csound, tol(expected.csound));
+                ASSERT_NEAR(actual.e, expected.e, tol(expected.e));
+                ASSERT_NEAR(actual.E, expected.E, tol(expected.E));
+                ASSERT_NEAR(actual.H, expected.H, tol(expected.H));
+                for(int idim = 0; idim < ndim; ++idim){
+                    ASSERT_NEAR(actual.momentum[idim], expected.momentum[idim], tol(expected.momentum[idim]));
+                    ASSERT_NEAR(actual.velocity[idim], expected.velocity[idim], tol(expected.velocity[idim]));
+                }
+            }
+        }
+    };
+    check_varset(std::integral_constant<VARSET, VARSET::CONSERVATIVE>{});
+    check_varset(std::integral_constant<VARSET, VARSET::RHO_U_T>{});
+    check_varset(std::integral_constant<VARSET, VARSET::RHO_U_P>{});
+}
+
+TEST(test_ns, test_batched_physical_flux){
+    static constexpr int ndim = 2;
+    static constexpr int neq = ndim + 2;
+    ReferenceParameters<double> ref{};
+    CaloricallyPerfectEoS<double, ndim> eos{};
+    DimensionlessSutherlands<double> visc{ref};
+    Physics physics{ref, eos, visc};
+    Flux pflux{physics};
+
+    static constexpr int npoint = 40;
+    std::vector<double> u_data(neq * npoint), gradu_data(neq * ndim * npoint), flux_data(neq * ndim * npoint);
+    for(int ipoint = 0; ipoint < npoint; ++ipoint){
+        u_data[0 * npoint + ipoint] = 1.0 + 0.01 * ipoint;
+        u_data[1 * npoint + ipoint] = 0.4 * std::cos(ipoint);
+        u_data[2 * npoint + ipoint] = -0.2 + 0.01 * ipoint;
+        u_data[3 * npoint + ipoint] = 2.5;
+        for(int k = 0; k < neq * ndim; ++k)
+            gradu_data[k * npoint + ipoint] = 0.1 * std::sin(k + 0.3 * ipoint);
+    }
+
+    double lambda = pflux.batch(
+        std::mdspan<const double, std::extents<int, neq, std::dynamic_extent>>{u_data.data(), npoint},
+        std::mdspan<const double, std::extents<int, neq * ndim, std::dynamic_extent>>{gradu_data.data(), npoint},
+        std::mdspan<double, std::extents<int, neq * ndim, std::dynamic_extent>>{flux_data.data(), npoint});
+
+    double lambda_expected = 0;
+    for(int ipoint = 0; ipoint < npoint; ++ipoint){
+        std::array<double, neq> upt;
+        std::array<double, neq * ndim> gradu_pt;
+        for(int ieq = 0; ieq < neq; ++ieq) upt[ieq] = u_data[ieq * npoint + ipoint];
+        for(int k = 0; k < neq * ndim; ++k) gradu_pt[k] = gradu_data[k * npoint + ipoint];
+        std::mdspan ugrad{gradu_pt.data(), std::extents{neq, ndim}};
+        Tensor<double, neq, ndim> f_pt = pflux(upt, ugrad);
+        for(int ieq = 0; ieq < neq; ++ieq){
+            for(int jdim = 0; jdim < ndim; ++jdim)
+                ASSERT_NEAR(f_pt[ieq][jdim], flux_data[(ieq * ndim + jdim) * npoint + ipoint], 1e-12);
+        }
+        lambda_expected = std::max(lambda_expected, pflux.wavespeed(upt));
+    }
+    ASSERT_NEAR(lambda, lambda_expected, 1e-12);
+}
+
+TEST(test_ns, test_component_coupling){
+    static constexpr int ndim = 2;
+    static constexpr int neq = ndim + 2;
+    ReferenceParameters<double> ref{};
+    CaloricallyPerfectEoS<double, ndim> eos{};
+    DimensionlessSutherlands<double> visc{ref};
+    Physics physics{ref, eos, visc};
+    Flux pflux{physics};
+    using flux_t = decltype(pflux);
+
+    // the mass flux is the momentum
+    static_assert(!flux_t::component_coupling[flux_t::irho][flux_t::irho]);
+    static_assert(!flux_t::component_coupling[flux_t::irho][flux_t::irhoe]);
+    static_assert(flux_t::component_coupling[flux_t::irho][flux_t::irhou]);
+    static_assert(flux_t::component_coupling[flux_t::irhoe].all());
+
+    // perturbing a component (or its gradient) outside the coupling leaves the flux of the equation unchanged
+    std::array<double, neq> u{1.1, 0.3, -0.2, 2.5};
+    std::array<double, neq * ndim> gradu_data;
+    for(int k = 0; k < neq * ndim; ++k) gradu_data[k] = 0.1 * std::sin(k + 0.4);
+    std::mdspan gradu{gradu_data.data(), std::extents{neq, ndim}};
+    Tensor<double, neq, ndim> flux = pflux(u, gradu);
+    for(int jeq = 0; jeq < neq; ++jeq){
+        std::array<double, neq> up = u;
+        std::array<double, neq * ndim> gradup_data = gradu_data;
+        up[jeq] += 0.1;
+        for(int jdim = 0; jdim < ndim; ++jdim) gradup_data[jeq * ndim + jdim] += 0.1;
+        std::mdspan gradup{gradup_data.data(), std::extents{neq, ndim}};
+        Tensor<double, neq, ndim> fluxp = pflux(up, gradup);
+        for(int ieq = 0; ieq < neq; ++ieq){
+            if(flux_t::component_coupling[ieq][jeq]) continue;
+            for(int idim = 0; idim < ndim; ++idim) ASSERT_EQ(fluxp[ieq][idim], flux[ieq][idim]);
+        }
+    }
+}
+
+TEST(test_ns, test_tabulated_viscosity){
+    Sutherlands<double> sutherlands{};
+    static_assert(batched_viscosity_fcn<Sutherlands<double>>);
+    static_assert(batched_viscosity_fcn<TabulatedViscosity<double>>);
+
+    TabulatedViscosity<double> tabulated{sutherlands, 100.0, 3000.0, 1e-10};
+    ASSERT_LE(tabulated.max_rel_error, 1e-10);
+
+    // the bound holds between the check points and the law is used out of range
+    std::vector<double> temps{}, mus{};
+    for(int i = 0; i <= 10000; ++i) temps.push_back(50.0 + 3500.0 * i / 10000.0);
+    mus.resize(temps.size());
+    tabulated.batch(temps, mus);
+    for(std::size_t i = 0; i < temps.size(); ++i){
+        double mu_exact = sutherlands(temps[i]);
+        ASSERT_NEAR(tabulated(temps[i]), mu_exact, 1e-10 * mu_exact);
+        ASSERT_DOUBLE_EQ(mus[i], tabulated(temps[i]));
+        if(temps[i] < 100.0 || temps[i] > 3000.0) ASSERT_EQ(mus[i], mu_exact);
+    }
+
+    // dimensionless law through the physics
+    ReferenceParameters<double> ref{.rho = 1.225, .u = 50.0, .p = 101325.0, .T = 300.0, .mu = 1.8e-5};
+    DimensionlessSutherlands<double> visc{ref};
+    Physics physics{ref, CaloricallyPerfectEoS<double, 2>{}, TabulatedViscosity<double>{visc, 0.1, 10.0}};
+    std::array<double, 3> That{0.5, 1.0, 4.0};
+    std::array<double, 3> mu_batch;
+    physics.viscosity_batch(That, mu_batch);
+    for(int i = 0; i < 3; ++i){
+        ASSERT_NEAR(physics.viscosity(That[i]), visc(That[i]), 1e-10 * visc(That[i]));
+        ASSERT_DOUBLE_EQ(mu_batch[i], physics.viscosity(That[i]));
+    }
+}
+
+TEST(test_ns, test_hllc_roe){
+    static constexpr int ndim = 2;
+    static constexpr int neq = ndim + 2;
+    // non unit Euler number and energy coefficient
+    ReferenceParameters<double> ref{.rho = 1.225, .u = 2.0, .p = 10, .T = 273.15};
+    CaloricallyPerfectEoS<double, ndim> eos{};
+    DimensionlessSutherlands<double> visc{ref};
+    Physics physics{ref, eos, visc};
+    Flux pflux{physics};
+    HLLC hllc{physics};
+    Roe roe{physics};
+    const double Eu = physics.nondim.Eu;
+    const double e_coeff = physics.nondim.e_coeff;
+
+    auto check_fluxes = [&](auto numflux){
+        Tensor<double, ndim> n{0.6, 0.8}, minus_n{-0.6, -0.8};
+        std::array<double, neq * ndim> ugrad_data;
+        std::ranges::fill(ugrad_data, 0.0);
+        std::mdspan ugrad{ugrad_data.data(), std::extents{neq, ndim}};
+
+        // states from (rho, v, p)
+        auto cons = [&](double rho, double vx, double vy, double p){
+            double e = p * e_coeff * Eu / (eos.gamma - 1) / rho;
+            return std::array<double, neq>{rho, rho * vx, rho * vy, rho * (e + 0.5 * e_coeff * (vx * vx + vy * vy))};
+        };
+        std::array<double, neq> uL = cons(1.0, 0.3, -0.2, 1.0);
+        std::array<double, neq> uR = cons(0.5, -0.1, 0.4, 0.4);
+
+        // consistency
+        Tensor<double, neq, ndim> fphys = pflux(uL, ugrad);
+        std::array<double, neq> fsame = numflux(uL, uL, n);
+        for(int ieq = 0; ieq < neq; ++ieq)
+            ASSERT_NEAR(fsame[ieq], fphys[ieq][0] * n[0] + fphys[ieq][1] * n[1], 1e-10 * std::max(1.0, std::abs(fsame[ieq])));
+
+        // conservation
+        std::array<double, neq> fLR = numflux(uL, uR, n);
+        std::array<double, neq> fRL = numflux(uR, uL, minus_n);
+        for(int ieq = 0; ieq < neq; ++ieq)
+            ASSERT_NEAR(fLR[ieq], -fRL[ieq], 1e-10 * std::max(1.0, std::abs(fLR[ieq])));
+
+        // upwind for supersonic normal velocity
+        double csound = physics.calc_thermo_state(uL).csound;
+        std::array<double, neq> uL_sup = cons(1.0, 3.0 * csound * n[0], 3.0 * csound * n[1], 1.0);
+        std::array<double, neq> uR_sup = cons(0.8, 2.5 * csound * n[0], 2.5 * csound * n[1], 0.9);
+        Tensor<double, neq, ndim> fsup = pflux(uL_sup, ugrad);
+        std::array<double, neq> fnum_sup = numflux(uL_sup, uR_sup, n);
+        for(int ieq = 0; ieq < neq; ++ieq)
+            ASSERT_NEAR(fnum_sup[ieq], fsup[ieq][0] * n[0] + fsup[ieq][1] * n[1], 1e-10 * std::max(1.0, std::abs(fnum_sup[ieq])));
+
+        // stationary contact is exactly resolved: pressure flux only
+        std::array<double, neq> fcontact = numflux(cons(1.0, -0.8 * 0.5, 0.6 * 0.5, 1.0), cons(0.25, -0.8 * 0.5, 0.6 * 0.5, 1.0), n);
+        ASSERT_NEAR(fcontact[0], 0.0, 1e-12);
+        ASSERT_NEAR(fcontact[1], Eu * 1.0 * n[0], 1e-10);
+        ASSERT_NEAR(fcontact[2], Eu * 1.0 * n[1], 1e-10);
+        ASSERT_NEAR(fcontact[3], 0.0, 1e-10);
+
+        // batched interface matches the pointwise flux
+        static constexpr int npoint = 37;
+        std::vector<double> uLb(neq * npoint), uRb(neq * npoint), nb(ndim * npoint), fb(neq * npoint);
+        for(int ipoint = 0; ipoint < npoint; ++ipoint){
+            double theta = 0.2 * ipoint;
+            double speed = -3.0 + 6.0 * ipoint / (npoint - 1);
+            std::array<double, neq> uLpt = cons(1.0, speed * std::cos(theta), speed * std::sin(theta), 1.0);
+            std::array<double, neq> uRpt = cons(0.7, 0.8 * speed * std::cos(theta), 0.8 * speed * std::sin(theta), 0.6);
+            for(int ieq = 0; ieq < neq; ++ieq){
+                uLb[ieq * npoint + ipoint] = uLpt[ieq];
+                uRb[ieq * npoint + ipoint] = uRpt[ieq];
+            }
+            nb[ipoint] = std::cos(theta + 0.1);
+            nb[npoint + ipoint] = std::sin(theta + 0.1);
+        }
+        numflux.batch(
+            std::mdspan<const double, std::extents<int, neq, std::dynamic_extent>>{uLb.data(), npoint},
+            std::mdspan<const double, std::extents<int, neq, std::dynamic_extent>>{uRb.data(), npoint},
+            std::mdspan<const double, std::extents<int, ndim, std::dynamic_extent>>{nb.data(), npoint},
+            std::mdspan<double, std::extents<int, neq, std::dynamic_extent>>{fb.data(), npoint});
+        for(int ipoint = 0; ipoint < npoint; ++ipoint){
+            std::array<double, neq> uLpt, uRpt;
+            for(int ieq = 0; ieq < neq; ++ieq){
+                uLpt[ieq] = uLb[ieq * npoint + ipoint];
+                uRpt[ieq] = uRb[ieq * npoint + ipoint];
+            }
+            std::array<double, neq> fpt = numflux(uLpt, uRpt, Tensor<double, ndim>{nb[ipoint], nb[npoint + ipoint]});
+            for(int ieq = 0; ieq < neq; ++ieq)
+                ASSERT_NEAR(fpt[ieq], fb[ieq * npoint + ipoint], 1e-12 * std::max(1.0, std::abs(fpt[ieq])));
+        }
+    };
+    check_fluxes(hllc);
+    check_fluxes(roe);
+}
+
+TEST_F(Box2dDirichletLagrangeP2, test_surface_functionals){
+    static constexpr int neq = ndim + 2;
+    ReferenceParameters<double> ref{};
+    CaloricallyPerfectEoS<double, ndim> eos{};
+    DimensionlessSutherlands<double> visc{ref};
+    Physics physics{ref, eos, visc};
+    Flux pflux{physics};
+
+    // fluid at rest with uniform pressure in [-1, 1]^2
+    // flags: 1 left, 2 bottom, 3 right, 4 top
+    FESpace<double, int, ndim>& fespace = *(this->fespace);
+
+    std::array<double, neq> ustate{1.0, 0.0, 0.0, 2.0};
+    std::vector<double> u(fespace.ndof_dg() * neq);
+    fe_layout_right u_layout{fespace.dg_map, tmp::to_size<neq>{}};
+    fespan u_span{u.data(), u_layout};
+    for(const auto& el : fespace.elements) for(int idof = 0; idof < el.nbasis(); ++idof)
+        for(int ieq = 0; ieq < neq; ++ieq) u_span[el.elidx, idof, ieq] = ustate[ieq];
+    double p = physics.calc_thermo_state(ustate).p;
+    double Eu = physics.nondim.Eu;
+
+    for(int bcflag = 1; bcflag <= 4; ++bcflag){
+        auto vals = integrate_surface_functionals(fespace, pflux, u_span, bcflag);
+        int idir = (bcflag - 1) % ndim;
+        double sign = (bcflag <= ndim) ? -1.0 : 1.0;
+        ASSERT_NEAR(vals.area, 2.0, 1e-12);
+        ASSERT_NEAR(vals.pressure_force[idir], sign * Eu * p * 2.0, 1e-12);
+        ASSERT_NEAR(vals.pressure_force[1 - idir], 0.0, 1e-12);
+        for(int idim = 0; idim < ndim; ++idim) ASSERT_NEAR(vals.viscous_force[idim], 0.0, 1e-12);
+        ASSERT_NEAR(vals.heat_flux, 0.0, 1e-12);
+    }
+}
+
+TEST(test_ns, test_dual_flux_jacobians){
+    static constexpr int ndim = 2;
+    static constexpr int neq = ndim + 2;
+    // non unit Euler number and energy coefficient, temperature dependent viscosity
+    ReferenceParameters<double> ref{.rho = 1.225, .u = 2.0, .p = 10, .T = 273.15};
+    CaloricallyPerfectEoS<double, ndim> eos{};
+    DimensionlessSutherlands<double> visc{ref};
+    Physics physics{ref, eos, visc};
+    ConservationLawDDG disc{Flux{physics, std::true_type{}}, VanLeer{physics},
+        DiffusionFlux{physics, std::true_type{}}};
+
+    // the fluxes take the dual number path
+    static_assert(dual_physical_flux<decltype(disc.phys_flux), neq * (ndim + 1)>);
+    static_assert(dual_convective_numerical_flux<decltype(disc.conv_nflux), 2 * neq>);
+    static_assert(dual_diffusion_flux<decltype(disc.diff_flux), neq * (ndim + 1)>);
+
+    Tensor<double, ndim> n{0.6, 0.8};
+    std::array<double, neq * ndim> gradu_data;
+    for(int k = 0; k < neq * ndim; ++k) gradu_data[k] = 0.1 * std::sin(k + 0.4);
+    std::mdspan gradu{gradu_data.data(), std::extents{neq, ndim}};
+
+    // central differences of the real valued fluxes
+    static constexpr double h = 1e-6;
+    static constexpr double tol = 1e-6;
+    auto perturbed = [&](std::array<double, neq> u, int k, double eps){
+        std::array<double, neq * ndim> data = gradu_data;
+        if(k < neq) u[k] += eps; else data[k - neq] += eps;
+        return std::pair{u, data};
+    };
+
+    // subsonic, and supersonic along n
+    for(std::array<double, neq> u : {std::array<double, neq>{1.1, 0.3, -0.2, 2.5},
+            std::array<double, neq>{1.0, 3.0, 0.5, 30.0}}){
+        Tensor<double, neq, ndim, neq> dflux_du;
+        Tensor<double, neq, ndim, neq, ndim> dflux_dgradu;
+        disc.phys_flux_jacobian(u, gradu, dflux_du, dflux_dgradu);
+        Tensor<double, neq, neq> dfvisc_du;
+        Tensor<double, neq, neq, ndim> dfvisc_dgrad;
+        disc.diff_flux_jacobian(u, gradu, n, dfvisc_du, dfvisc_dgrad);
+
+        for(int k = 0; k < neq * (ndim + 1); ++k){
+            auto [up, gradp_data] = perturbed(u, k, h);
+            auto [um, gradm_data] = perturbed(u, k, -h);
+            std::mdspan gradp{gradp_data.data(), std::extents{neq, ndim}};
+            std::mdspan gradm{gradm_data.data(), std::extents{neq, ndim}};
+            Tensor<double, neq, ndim> fp = disc.phys_flux(up, gradp), fm = disc.phys_flux(um, gradm);
+            std::array<double, neq> fviscp = disc.diff_flux(up, gradp, n),
+                fviscm = disc.diff_flux(um, gradm, n);
+            for(int ieq = 0; ieq < neq; ++ieq){
+                for(int idim = 0; idim < ndim; ++idim){
+                    double fd = (fp[ieq][idim] - fm[ieq][idim]) / (2 * h);
+                    double dual = (k < neq) ? dflux_du[ieq, idim, k]
+                        : dflux_dgradu[ieq, idim, (k - neq) / ndim, (k - neq) % ndim];
+                    ASSERT_NEAR(dual, fd, tol * std::max(1.0, std::abs(fd)));
+                }
+                double fd = (fviscp[ieq] - fviscm[ieq]) / (2 * h);
+                double dual = (k < neq) ? dfvisc_du[ieq, k]
+                    : dfvisc_dgrad[ieq, (k - neq) / ndim, (k - neq) % ndim];
+                ASSERT_NEAR(dual, fd, tol * std::max(1.0, std::abs(fd)));
+            }
+        }
+
+        std::array<double, neq> uR{1.0, 0.2, 0.1, 2.4};
+        Tensor<double, neq, neq> dfadv_duL, dfadv_duR;
+        disc.conv_nflux_jacobian(u, uR, n, dfadv_duL, dfadv_duR);
+        for(int jeq = 0; jeq < neq; ++jeq){
+            std::array<double, neq> uLp = u, uLm = u, uRp = uR, uRm = uR;
+            uLp[jeq] += h; uLm[jeq] -= h; uRp[jeq] += h; uRm[jeq] -= h;
+            std::array<double, neq> fLp = disc.conv_nflux(uLp, uR, n), fLm = disc.conv_nflux(uLm, uR, n),
+                fRp = disc.conv_nflux(u, uRp, n), fRm = disc.conv_nflux(u, uRm, n);
+            for(int ieq = 0; ieq < neq; ++ieq){
+                double fdL = (fLp[ieq] - fLm[ieq]) / (2 * h), fdR = (fRp[ieq] - fRm[ieq]) / (2 * h);
+                ASSERT_NEAR(dfadv_duL[ieq, jeq], fdL, tol * std::max(1.0, std::abs(fdL)));
+                ASSERT_NEAR(dfadv_duR[ieq, jeq], fdR, tol * std::max(1.0, std::abs(fdR)));
+            }
+        }
+    }
+}
@@ -0,0 +1,89 @@
+#include "iceicle/build_config.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/mesh/mesh.hpp"
+#include "iceicle/petsc_dmplex.hpp"
+#include <gtest/gtest.h>
+#include <petscdmplex.h>
+#include <petscsys.h>
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+using namespace iceicle;
+using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+
+TEST(test_petsc_dmplex, test_roundtrip){
+    static constexpr int ndim = 2;
+    using T = build_config::T;
+    using IDX = build_config::IDX;
+
+    for(int geo_order : {1, 2}){
+        AbstractMesh<T, IDX, ndim> mesh{
+            Tensor<T, ndim>{{0.0, 0.0}},
+            Tensor<T, ndim>{{1.0, 0.5}},
+            Tensor<IDX, ndim>{{3, 2}},
+            geo_order,
+            Tensor<BOUNDARY_CONDITIONS, 4>{
+                BOUNDARY_CONDITIONS::DIRICHLET,
+                BOUNDARY_CONDITIONS::NEUMANN,
+                BOUNDARY_CONDITIONS::DIRICHLET,
+                BOUNDARY_CONDITIONS::NEUMANN,
+            },
+            Tensor<int, 4>{0, 0, 1, 0}
+        };
+
+        // === mesh to DMPlex ===
+        DM dm = petsc::dmplex_from_mesh(mesh, PETSC_COMM_SELF);
+        PetscInt cstart, cend, vstart, vend;
+        DMPlexGetHeightStratum(dm, 0, &cstart, &cend);
+        DMPlexGetDepthStratum(dm, 0, &vstart, &vend);
+        ASSERT_EQ(cend - cstart, mesh.nelem());
+        ASSERT_EQ(vend - vstart, 12);
+
+        IDX nflag1 = 0;
+        for(IDX ifac = mesh.bdyFaceStart; ifac < mesh.bdyFaceEnd; ++ifac)
+            if(mesh.faces[ifac]->bcflag == 1) ++nflag1;
+        PetscInt nlabeled;
+        DMGetStratumSize(dm, petsc::face_sets_label_name, 1, &nlabeled);
+        ASSERT_EQ(nlabeled, nflag1);
+
+        // the dg section has the layout of the iceicle dg storage
+        FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LEGENDRE,
+            std::integral_constant<int, 1>{}};
+        fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 2>{}};
+        petsc::dmplex_set_dg_section(dm, fespace, 2);
+        Vec u;
+        DMCreateGlobalVector(dm, &u);
+        PetscInt usize;
+        VecGetLocalSize(u, &usize);
+        ASSERT_EQ(usize, layout.size());
+        VecDestroy(&u);
+
+        // === DMPlex to mesh ===
+        // the elements come back in the same order as linear elements
+        AbstractMesh<T, IDX, ndim> mesh_dm = petsc::mesh_from_dmplex<T, IDX, ndim>(dm);
+        ASSERT_EQ(mesh_dm.nelem(), mesh.nelem());
+        for(IDX iel = 0; iel < mesh.nelem(); ++iel){
+            std::vector<IDX> vertices = petsc::impl::dmplex_cell_vertices(mesh, iel);
+            std::vector<IDX> vertices_dm = petsc::impl::dmplex_cell_vertices(mesh_dm, iel);
+            ASSERT_EQ(vertices_dm.size(), vertices.size());
+            for(std::size_t ivert = 0; ivert < vertices.size(); ++ivert){
+                for(int idim = 0; idim < ndim; ++idim)
+                    { ASSERT_DOUBLE_EQ(mesh_dm.coord[vertices_dm[ivert]][idim], mesh.coord[vertices[ivert]][idim]); }
+            }
+        }
+
+        // same boundary conditions (the faces are sorted by element and condition)
+        auto boundary_faces = [](AbstractMesh<T, IDX, ndim>& m){
+            std::vector<std::tuple<IDX, int, IDX>> bfaces{};
+            for(IDX ifac = m.bdyFaceStart; ifac < m.bdyFaceEnd; ++ifac){
+                bfaces.emplace_back(m.faces[ifac]->elemL, (int) m.faces[ifac]->bctype, m.faces[ifac]->bcflag);
+            }
+            std::ranges::sort(bfaces);
+            return bfaces;
+        };
+        ASSERT_EQ(boundary_faces(mesh_dm), boundary_faces(mesh));
+
+        DMDestroy(&dm);
+    }
+}
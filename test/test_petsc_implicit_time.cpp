@@ -0,0 +1,109 @@
+#include "iceicle/disc/burgers.hpp"
+#include "iceicle/disc/conservation_law.hpp"
+#include "iceicle/disc/projection.hpp"
+#include "iceicle/explicit_utils.hpp"
+#include "iceicle/fe_function/fespan.hpp"
+#include "iceicle/fe_function/layout_right.hpp"
+#include "iceicle/linear_form_solver.hpp"
+#include "iceicle/petsc_implicit_time.hpp"
+#include "test_fixtures.hpp"
+#include <cmath>
+#include <gtest/gtest.h>
+#include <numbers>
+#include <vector>
+
+using namespace iceicle;
+using namespace iceicle::solvers;
+using iceicle::test::Box2dLagrangeP2;
+
+namespace {
+
+    /// @brief linear advection diffusion (burgers without the nonlinear term)
+    auto linear_advection_diffusion() {
+        using T = double;
+        BurgersCoefficients<T, 2> coeffs{};
+        coeffs.mu = 0.05;
+        coeffs.a[0] = 1.0;
+        coeffs.a[1] = 0.5;
+        return ConservationLawDDG{BurgersFlux{coeffs}, BurgersUpwind{coeffs}, BurgersDiffusionFlux{coeffs}};
+    }
+
+    /**
+     * @brief integrate the smooth periodic initial condition to tfinal
+     * @param dt the (initial if tol > 0) timestep
+     * @param tol the adaptive error tolerance
+     * @param [out] nstep the number of accepted steps
+     * @param [out] nreject the number of rejected steps
+     * @return the solution data at tfinal
+     */
+    auto integrate(FESpace<double, int, 2>& fespace, IMPLICIT_SCHEME scheme, double dt, double tfinal,
+            double tol, int& nstep, int& nreject) -> std::vector<double> {
+        using T = double;
+        using IDX = int;
+        auto disc = linear_advection_diffusion();
+        fe_layout_right layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+        std::vector<T> u_data(layout.size());
+        fespan u{u_data.data(), layout};
+        Projection<T, IDX, 2, 1> projection{[](const T* x, T* out){
+            out[0] = std::sin(std::numbers::pi * x[0]) * std::cos(std::numbers::pi * x[1]);
+        }};
+        LinearFormSolver{fespace, projection}.solve(u);
+
+        ImplicitTimeIntegrator solver{fespace, disc, FixedTimestep<T, IDX>{dt},
+            TfinalTermination<T, IDX>{tfinal}, scheme};
+        solver.vis_callback = [](auto&){};
+        solver.newton_kmax = 20;
+        solver.newton_rtol = 1e-13;
+        solver.newton_atol = 1e-14;
+        solver.tol = tol;
+        solver.solve(fespace, disc, u);
+        nstep = solver.itime;
+        nreject = solver.nreject;
+        return u_data;
+    }
+
+    auto l2_diff(const std::vector<double>& a, const std::vector<double>& b) -> double {
+        double sum = 0;
+        for(std::size_t i = 0; i < a.size(); ++i) sum += (a[i] - b[i]) * (a[i] - b[i]);
+        return std::sqrt(sum);
+    }
+}
+
+TEST_F(Box2dLagrangeP2, test_implicit_convergence_order){
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+    const T tfinal = 0.2;
+    int nstep, nreject;
+
+    // self convergence against a fine reference in time (the spatial error is the same for every dt)
+    std::vector<T> uref = integrate(fespace, IMPLICIT_SCHEME::SDIRK3, tfinal / 400, tfinal, 0, nstep, nreject);
+
+    struct order_case { IMPLICIT_SCHEME scheme; T expected_order; };
+    for(order_case c : {order_case{IMPLICIT_SCHEME::BDF1, 1.0}, order_case{IMPLICIT_SCHEME::BDF2, 2.0},
+            order_case{IMPLICIT_SCHEME::SDIRK2, 2.0}, order_case{IMPLICIT_SCHEME::SDIRK3, 3.0}}){
+        T err_coarse = l2_diff(integrate(fespace, c.scheme, tfinal / 8, tfinal, 0, nstep, nreject), uref);
+        T err_fine = l2_diff(integrate(fespace, c.scheme, tfinal / 16, tfinal, 0, nstep, nreject), uref);
+        ASSERT_EQ(nreject, 0);
+        T order = std::log2(err_coarse / err_fine);
+        ASSERT_GT(order, c.expected_order - 0.3);
+        ASSERT_LT(order, c.expected_order + 0.5);
+    }
+}
+
+TEST_F(Box2dLagrangeP2, test_implicit_adaptive_timestep){
+    FESpace<T, IDX, ndim>& fespace = *(this->fespace);
+    const T tfinal = 0.4;
+    int nstep_loose, nreject_loose, nstep_tight, nreject_tight, nstep_ref, nreject_ref;
+
+    // start with a timestep that is too large for the tolerance so the first step is rejected
+    std::vector<T> uref = integrate(fespace, IMPLICIT_SCHEME::SDIRK3, tfinal / 400, tfinal, 0, nstep_ref, nreject_ref);
+    for(IMPLICIT_SCHEME scheme : {IMPLICIT_SCHEME::SDIRK2, IMPLICIT_SCHEME::SDIRK3}){
+        std::vector<T> u_loose = integrate(fespace, scheme, tfinal, tfinal, 1e-2, nstep_loose, nreject_loose);
+        std::vector<T> u_tight = integrate(fespace, scheme, tfinal, tfinal, 1e-6, nstep_tight, nreject_tight);
+        ASSERT_GT(nreject_loose, 0);
+        ASSERT_GT(nreject_tight, 0);
+
+        // the tight tolerance takes smaller timesteps and is more accurate
+        ASSERT_GT(nstep_tight, nstep_loose);
+        ASSERT_LT(l2_diff(u_tight, uref), l2_diff(u_loose, uref));
+    }
+}
@@ -1,19 +1,27 @@
 #include "iceicle/build_config.hpp"
 #include "iceicle/disc/conservation_law.hpp"
 #include "iceicle/disc/burgers.hpp"
+#include "iceicle/disc/navier_stokes.hpp"
+#include "iceicle/disc/projection.hpp"
 #include "iceicle/fe_function/component_span.hpp"
 #include "iceicle/fe_function/fespan.hpp"
 #include "iceicle/fe_function/geo_layouts.hpp"
 #include "iceicle/fespace/fespace.hpp"
 #include "iceicle/fe_function/layout_right.hpp"
 #include "iceicle/form_dense_jacobian.hpp"
+#include "iceicle/linear_form_solver.hpp"
 #include "iceicle/petsc_newton.hpp"
+#include "iceicle/element_line_implicit.hpp"
 #include "iceicle/form_petsc_jacobian.hpp"
 #include "mdspan/mdspan.hpp"
+#include <algorithm>
+#include <cmath>
 #include <gtest/gtest.h>
+#include <numbers>
 #include <petscmat.h>
 #include <petscsys.h>
 #include <ranges>
+#include <set>
 
 using namespace iceicle;
 using namespace iceicle::util;
@@ -164,3 +172,691 @@ TEST(test_petsc_jacobian, test_mdg_bl){
     }
 
 }
+
+TEST(test_petsc_jacobian, test_preconditioner_disc){
+
+    using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+    static constexpr int ndim = 2;
+    static constexpr int pn_order = 2;
+    static constexpr int neq = 1;
+    using T = build_config::T;
+    using IDX = build_config::IDX;
+
+    AbstractMesh<T, IDX, ndim> mesh{
+        Tensor<T, ndim>{{0.0, 0.0}},
+        Tensor<T, ndim>{{1.0, 1.0}},
+        Tensor<IDX, ndim>{{4, 4}},
+        1,
+        Tensor<BOUNDARY_CONDITIONS, 4>{
+            BOUNDARY_CONDITIONS::DIRICHLET,
+            BOUNDARY_CONDITIONS::NEUMANN,
+            BOUNDARY_CONDITIONS::DIRICHLET,
+            BOUNDARY_CONDITIONS::NEUMANN,
+        },
+        Tensor<int, 4>{0, 0, 1, 0}
+    };
+    FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LEGENDRE, std::integral_constant<int, pn_order>{}};
+
+    BurgersCoefficients<T, ndim> burgers_coeffs{};
+    burgers_coeffs.mu = 0.01;
+    burgers_coeffs.a = 1.0;
+    ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                          BurgersUpwind{burgers_coeffs},
+                          BurgersDiffusionFlux{burgers_coeffs}};
+    disc.field_names = std::vector<std::string>{"u"};
+    disc.dirichlet_callbacks.push_back([](const T *x, T *out){ out[0] = 0.0; });
+    disc.dirichlet_callbacks.push_back([](const T *x, T *out){ out[0] = 1.0; });
+    disc.neumann_callbacks.push_back([](const T *x, T *out){ out[0] = 1.0; });
+
+    // the cheaper jacobian: interior penalty instead of ddg
+    auto pc_disc = disc;
+    pc_disc.interior_penalty = true;
+
+    fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, neq>{}};
+    ConvergenceCriteria<T, IDX> conv_criteria{
+        .tau_abs = 1e-11,
+        .tau_rel = 0.0,
+        .kmax = 40
+    };
+
+    // the reference solve
+    std::vector<T> u_ref_storage(u_layout.size(), 0.0);
+    fespan u_ref{u_ref_storage.data(), u_layout};
+    PetscNewton ref_solver{fespace, disc, conv_criteria};
+    ref_solver.solve(u_ref);
+
+    // the residual of disc with the jacobian of pc_disc, matrix-free and as a defect correction
+    for(bool matrix_free : {true, false}){
+        SCOPED_TRACE("matrix_free = " + std::to_string(matrix_free));
+        std::vector<T> u_storage(u_layout.size(), 0.0);
+        fespan u{u_storage.data(), u_layout};
+        PetscNewton solver{fespace, disc, pc_disc, conv_criteria};
+        ASSERT_TRUE(solver.separate_pc_disc());
+        solver.pc_disc_matrix_free = matrix_free;
+        solver.solve(u);
+
+        std::vector<T> res_storage(u_layout.size());
+        fespan res{res_storage.data(), u_layout};
+        form_residual(fespace, disc, u, res);
+        ASSERT_LT(std::sqrt(norm_sq(res)), 1e-9);
+        for(std::size_t i = 0; i < u_storage.size(); ++i)
+            ASSERT_NEAR(u_storage[i], u_ref_storage[i], 1e-8);
+    }
+}
+
+TEST(test_petsc_jacobian, test_mdg_incremental){
+
+    using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+    static constexpr int ndim = 2;
+    static constexpr int pn_order = 1;
+    static constexpr int neq = 1;
+    using T = build_config::T;
+    using IDX = build_config::IDX;
+    int nelemx = 6;
+    int nelemy = 6;
+
+    // set up mesh and fespace
+    AbstractMesh<T, IDX, ndim> mesh{
+        Tensor<T, ndim>{{0.0, 0.0}},
+        Tensor<T, ndim>{{1.0, 1.0}},
+        Tensor<IDX, ndim>{{nelemx, nelemy}},
+        1,
+        Tensor<BOUNDARY_CONDITIONS, 4>{
+            BOUNDARY_CONDITIONS::DIRICHLET,
+            BOUNDARY_CONDITIONS::NEUMANN,
+            BOUNDARY_CONDITIONS::DIRICHLET,
+            BOUNDARY_CONDITIONS::NEUMANN,
+        },
+        Tensor<int, 4>{0, 0, 1, 0}
+    };
+
+    FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LEGENDRE, std::integral_constant<int, pn_order>{}};
+
+    // set up discretization
+    BurgersCoefficients<T, ndim> burgers_coeffs{};
+    burgers_coeffs.mu = 0.01;
+    burgers_coeffs.a = 1.0;
+    ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                          BurgersUpwind{burgers_coeffs},
+                          BurgersDiffusionFlux{burgers_coeffs}};
+    disc.field_names = std::vector<std::string>{"u"};
+    disc.dirichlet_callbacks.push_back( 
+        [](const T *x, T *out){
+            out[0] = 0.0;
+    });
+    disc.dirichlet_callbacks.push_back( 
+        [](const T *x, T *out){
+            out[0] = 1.0;
+    });
+    disc.neumann_callbacks.push_back( 
+        [](const T *x, T *out){
+            out[0] = 1.0;
+    });
+
+    // a nonuniform solution so the geometry columns are nonzero
+    fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, neq>{}};
+    std::vector<T> u_storage(u_layout.size());
+    for(std::size_t i = 0; i < u_storage.size(); ++i) u_storage[i] = 0.1 * (i % 7);
+    fespan u{u_storage.data(), u_layout};
+
+    // select all the nodes
+    auto all_traces = std::views::iota( (std::size_t) 0 , fespace.traces.size());
+    geo_dof_map geo_map{all_traces, fespace};
+    mesh_parameterizations::hyper_rectangle(
+            std::array{nelemx, nelemy}, std::array{0.0, 0.0},
+            std::array{1.0, 1.0}, geo_map );
+
+    ic_residual_layout<T, IDX, ndim, 1> mdg_layout{geo_map};
+    geo_data_layout<T, IDX, ndim> geo_layout{geo_map};
+    PetscInt local_res_size = u_layout.size() + mdg_layout.size();
+    PetscInt local_u_size = u_layout.size() + geo_layout.size();
+
+    std::vector<T> res_storage(local_res_size);
+    std::vector<T> coord_data(geo_layout.size());
+    fespan res{res_storage.data(), u_layout};
+    dofspan mdg_res{res_storage.data() + res.size(), mdg_layout};
+    component_span coord{coord_data, geo_layout};
+    extract_geospan(*(fespace.meshptr), coord);
+
+    auto create_jac = [&]{
+        Mat jac;
+        MatCreate(PETSC_COMM_WORLD, &jac);
+        MatSetSizes(jac, local_res_size, local_u_size, PETSC_DETERMINE, PETSC_DETERMINE);
+        MatSetFromOptions(jac);
+        preallocate_petsc_jacobian(fespace, neq, jac, geo_map);
+        return jac;
+    };
+    auto assemble = [&](Mat jac, mdg_jacobian_cache<T, IDX, ndim>* cache){
+        MatZeroEntries(jac);
+        form_petsc_mdg_jacobian_fd(fespace, disc, u, coord, mdg_res, jac, cache);
+        MatAssemblyBegin(jac, MAT_FINAL_ASSEMBLY);
+        MatAssemblyEnd(jac, MAT_FINAL_ASSEMBLY);
+    };
+
+    mdg_jacobian_cache<T, IDX, ndim> cache{};
+    cache.move_tolerance = 1e-8;
+    Mat jac_incremental = create_jac();
+    Mat jac_full = create_jac();
+
+    // the first assembly computes all the columns
+    assemble(jac_incremental, &cache);
+    ASSERT_EQ(cache.nrecomputed, (IDX) mdg_layout.ndof());
+
+    // nothing moved: all columns are reused
+    assemble(jac_incremental, &cache);
+    ASSERT_EQ(cache.nrecomputed, 0);
+
+    // move an interior node: only the columns around it are recomputed
+    IDX jmove = 0;
+    for(IDX jmdg = 0; jmdg < (IDX) mdg_layout.ndof(); ++jmdg)
+        { if(coord.nv(jmdg) == ndim) { jmove = jmdg; break; } }
+    coord[jmove, 0] += 0.02;
+    coord[jmove, 1] -= 0.01;
+    assemble(jac_incremental, &cache);
+    ASSERT_GT(cache.nrecomputed, 0);
+    ASSERT_LT(cache.nrecomputed, (IDX) mdg_layout.ndof());
+
+    // compare to a full assembly
+    assemble(jac_full, nullptr);
+    for(PetscInt i = 0; i < local_res_size; ++i){
+        SCOPED_TRACE("irow = " + std::to_string(i));
+        for(PetscInt j = 0; j < local_u_size; ++j){
+            SCOPED_TRACE("jcol = " + std::to_string(j));
+            T full_val, incremental_val;
+            MatGetValue(jac_full, i, j, &full_val);
+            MatGetValue(jac_incremental, i, j, &incremental_val);
+            ASSERT_NEAR(incremental_val, full_val, 1e-10);
+        }
+    }
+
+    MatDestroy(&jac_incremental);
+    MatDestroy(&jac_full);
+}
+
+TEST(test_petsc_jacobian, test_ic_shape_jacobian){
+
+    using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+    static constexpr int ndim = 2;
+    static constexpr int pn_order = 2;
+    static constexpr int neq = 1;
+    using T = build_config::T;
+    using IDX = build_config::IDX;
+
+    // set up mesh and fespace
+    AbstractMesh<T, IDX, ndim> mesh{
+        Tensor<T, ndim>{{0.0, 0.0}},
+        Tensor<T, ndim>{{1.0, 1.0}},
+        Tensor<IDX, ndim>{{3, 3}},
+        1,
+        Tensor<BOUNDARY_CONDITIONS, 4>{
+            BOUNDARY_CONDITIONS::DIRICHLET,
+            BOUNDARY_CONDITIONS::NEUMANN,
+            BOUNDARY_CONDITIONS::DIRICHLET,
+            BOUNDARY_CONDITIONS::NEUMANN,
+        },
+        Tensor<int, 4>{0, 0, 1, 0}
+    };
+
+    // distort the mesh so the transformations are not affine
+    for(IDX inode = 0; inode < mesh.coord.size(); ++inode){
+        T x = mesh.coord[inode][0], y = mesh.coord[inode][1];
+        mesh.coord[inode][0] += 0.05 * std::sin(3.0 * y) * x * (1 - x);
+        mesh.coord[inode][1] += 0.04 * std::sin(2.0 * x) * y * (1 - y);
+        mesh.update_node(inode);
+    }
+
+    FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LEGENDRE, std::integral_constant<int, pn_order>{}};
+
+    // viscous burgers so the solution gradients contribute
+    BurgersCoefficients<T, ndim> burgers_coeffs{};
+    burgers_coeffs.mu = 0.1;
+    burgers_coeffs.a = 1.0;
+    burgers_coeffs.b = 0.5;
+    ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                          BurgersUpwind{burgers_coeffs},
+                          BurgersDiffusionFlux{burgers_coeffs}};
+    disc.field_names = std::vector<std::string>{"u"};
+
+    fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, neq>{}};
+    std::vector<T> u_storage(u_layout.size());
+    for(std::size_t i = 0; i < u_storage.size(); ++i) u_storage[i] = 0.5 + 0.1 * (i % 5);
+    fespan u{u_storage.data(), u_layout};
+
+    std::vector<T> uL_storage(fespace.dg_map.max_el_size_reqirement(neq));
+    std::vector<T> uR_storage(fespace.dg_map.max_el_size_reqirement(neq));
+    for(IDX itrace = fespace.interior_trace_start; itrace < fespace.interior_trace_end; ++itrace){
+        const TraceSpace<T, IDX, ndim>& trace = fespace.traces[itrace];
+        dofspan uL{uL_storage, u.create_element_layout(trace.elL.elidx)};
+        dofspan uR{uR_storage, u.create_element_layout(trace.elR.elidx)};
+        extract_elspan(trace.elL.elidx, u, uL);
+        extract_elspan(trace.elR.elidx, u, uR);
+
+        trace_layout_right res_layout{trace, disc};
+        std::vector<T> resp_storage(res_layout.size()), resm_storage(res_layout.size());
+        dofspan resp{resp_storage, res_layout};
+        dofspan resm{resm_storage, res_layout};
+        std::vector<T> dres_dx_storage(res_layout.size() * ndim);
+        std::mdspan dres_dx{dres_dx_storage.data(), std::extents{res_layout.size(), (std::size_t) ndim}};
+
+        // every node of the left and right element
+        std::set<IDX> nodes{};
+        for(IDX inode : trace.elL.inodes) nodes.insert(inode);
+        for(IDX inode : trace.elR.inodes) nodes.insert(inode);
+        for(IDX inode : nodes){
+            ASSERT_TRUE(disc.interface_conservation_shape_jacobian(trace, mesh.coord, uL, uR, inode, dres_dx));
+            for(int idim = 0; idim < ndim; ++idim){
+                SCOPED_TRACE("itrace = " + std::to_string(itrace) + ", inode = " + std::to_string(inode)
+                        + ", idim = " + std::to_string(idim));
+                // central difference
+                T h = 1e-6;
+                T old_val = mesh.coord[inode][idim];
+                mesh.coord[inode][idim] = old_val + h;
+                mesh.update_node(inode);
+                resp = 0;
+                disc.interface_conservation(trace, mesh.coord, uL, uR, resp);
+                mesh.coord[inode][idim] = old_val - h;
+                mesh.update_node(inode);
+                resm = 0;
+                disc.interface_conservation(trace, mesh.coord, uL, uR, resm);
+                mesh.coord[inode][idim] = old_val;
+                mesh.update_node(inode);
+
+                for(std::size_t irow = 0; irow < res_layout.size(); ++irow){
+                    T fd = (resp_storage[irow] - resm_storage[irow]) / (2 * h);
+                    ASSERT_NEAR(dres_dx[irow, idim], fd, 1e-6 * std::max(1.0, std::abs(fd)));
+                }
+            }
+        }
+    }
+}
+
+TEST(test_petsc_jacobian, test_trace_interface_conservation){
+
+    using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+    static constexpr int ndim = 2;
+    static constexpr int pn_order = 2;
+    static constexpr int neq = 1;
+    using T = build_config::T;
+    using IDX = build_config::IDX;
+    int nelemx = 3;
+    int nelemy = 3;
+
+    // set up mesh and fespace
+    AbstractMesh<T, IDX, ndim> mesh{
+        Tensor<T, ndim>{{0.0, 0.0}},
+        Tensor<T, ndim>{{1.0, 1.0}},
+        Tensor<IDX, ndim>{{nelemx, nelemy}},
+        1,
+        Tensor<BOUNDARY_CONDITIONS, 4>{
+            BOUNDARY_CONDITIONS::DIRICHLET,
+            BOUNDARY_CONDITIONS::NEUMANN,
+            BOUNDARY_CONDITIONS::DIRICHLET,
+            BOUNDARY_CONDITIONS::NEUMANN,
+        },
+        Tensor<int, 4>{0, 0, 1, 0}
+    };
+
+    FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LEGENDRE, std::integral_constant<int, pn_order>{}};
+
+    // viscous burgers so the solution gradients contribute
+    BurgersCoefficients<T, ndim> burgers_coeffs{};
+    burgers_coeffs.mu = 0.1;
+    burgers_coeffs.a = 1.0;
+    burgers_coeffs.b = 0.5;
+    ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                          BurgersUpwind{burgers_coeffs},
+                          BurgersDiffusionFlux{burgers_coeffs}};
+    disc.field_names = std::vector<std::string>{"u"};
+    disc.dirichlet_callbacks.push_back( 
+        [](const T *x, T *out){
+            out[0] = 0.0;
+    });
+    disc.dirichlet_callbacks.push_back( 
+        [](const T *x, T *out){
+            out[0] = 1.0;
+    });
+    disc.neumann_callbacks.push_back( 
+        [](const T *x, T *out){
+            out[0] = 1.0;
+    });
+
+    fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, neq>{}};
+    std::vector<T> u_storage(u_layout.size());
+    for(std::size_t i = 0; i < u_storage.size(); ++i) u_storage[i] = 0.5 + 0.1 * (i % 5);
+    fespan u{u_storage.data(), u_layout};
+
+    // the combined kernel matches the separate calls on every interior trace
+    std::vector<T> uL_storage(fespace.dg_map.max_el_size_reqirement(neq));
+    std::vector<T> uR_storage(fespace.dg_map.max_el_size_reqirement(neq));
+    std::vector<T> resL_storage(fespace.dg_map.max_el_size_reqirement(neq));
+    std::vector<T> resR_storage(fespace.dg_map.max_el_size_reqirement(neq));
+    std::vector<T> resL_fused_storage(fespace.dg_map.max_el_size_reqirement(neq));
+    std::vector<T> resR_fused_storage(fespace.dg_map.max_el_size_reqirement(neq));
+    for(IDX itrace = fespace.interior_trace_start; itrace < fespace.interior_trace_end; ++itrace){
+        SCOPED_TRACE("itrace = " + std::to_string(itrace));
+        const TraceSpace<T, IDX, ndim>& trace = fespace.traces[itrace];
+        dofspan uL{uL_storage, u.create_element_layout(trace.elL.elidx)};
+        dofspan uR{uR_storage, u.create_element_layout(trace.elR.elidx)};
+        extract_elspan(trace.elL.elidx, u, uL);
+        extract_elspan(trace.elR.elidx, u, uR);
+        dofspan resL{resL_storage, u.create_element_layout(trace.elL.elidx)};
+        dofspan resR{resR_storage, u.create_element_layout(trace.elR.elidx)};
+        dofspan resL_fused{resL_fused_storage, u.create_element_layout(trace.elL.elidx)};
+        dofspan resR_fused{resR_fused_storage, u.create_element_layout(trace.elR.elidx)};
+
+        trace_layout_right ic_layout{trace, disc};
+        std::vector<T> ic_storage(ic_layout.size()), ic_fused_storage(ic_layout.size());
+        dofspan ic_res{ic_storage, ic_layout};
+        dofspan ic_res_fused{ic_fused_storage, ic_layout};
+
+        resL = 0; resR = 0; ic_res = 0;
+        disc.trace_integral(trace, mesh.coord, uL, uR, resL, resR);
+        disc.interface_conservation(trace, mesh.coord, uL, uR, ic_res);
+        resL_fused = 0; resR_fused = 0; ic_res_fused = 0;
+        disc.trace_integral_interface_conservation(trace, mesh.coord, uL, uR, resL_fused, resR_fused, ic_res_fused);
+
+        for(std::size_t i = 0; i < resL.size(); ++i) ASSERT_NEAR(resL_fused_storage[i], resL_storage[i], 1e-12);
+        for(std::size_t i = 0; i < resR.size(); ++i) ASSERT_NEAR(resR_fused_storage[i], resR_storage[i], 1e-12);
+        for(std::size_t i = 0; i < ic_res.size(); ++i) ASSERT_NEAR(ic_fused_storage[i], ic_storage[i], 1e-12);
+    }
+
+    // the residuals formed together match the residuals formed separately
+    auto all_traces = std::views::iota( (std::size_t) 0 , fespace.traces.size());
+    geo_dof_map geo_map{all_traces, fespace};
+    ic_residual_layout<T, IDX, ndim, 1> mdg_layout{geo_map};
+    std::vector<T> res_storage(u_layout.size() + mdg_layout.size());
+    std::vector<T> res_fused_storage(u_layout.size() + mdg_layout.size());
+    fespan res{res_storage.data(), u_layout};
+    dofspan mdg_res{res_storage.data() + res.size(), mdg_layout};
+    fespan res_fused{res_fused_storage.data(), u_layout};
+    dofspan mdg_res_fused{res_fused_storage.data() + res.size(), mdg_layout};
+
+    ResidualWorkspace<T, IDX> workspace{fespace, neq};
+    form_residual(fespace, disc, u, res, workspace);
+    form_mdg_residual(fespace, disc, u, geo_map, mdg_res);
+    form_dg_mdg_residual(fespace, disc, u, res_fused, geo_map, mdg_res_fused, workspace);
+    ASSERT_FALSE(workspace.collect_interface_conservation);
+    for(std::size_t i = 0; i < res_storage.size(); ++i){
+        SCOPED_TRACE("i = " + std::to_string(i));
+        ASSERT_NEAR(res_fused_storage[i], res_storage[i], 1e-12);
+    }
+}
+
+TEST(test_petsc_jacobian, test_line_implicit){
+    static constexpr int ndim = 2;
+    using T = build_config::T;
+    using IDX = build_config::IDX;
+
+    // pure diffusion: the coupling across the thin direction of stretched elements dominates
+    BurgersCoefficients<T, ndim> burgers_coeffs{};
+    burgers_coeffs.mu = 0.01;
+    ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                          BurgersUpwind{burgers_coeffs},
+                          BurgersDiffusionFlux{burgers_coeffs}};
+    disc.dirichlet_callbacks.push_back([](const T*, T* out){ out[0] = 0.0; });
+
+    // the stretched structured mesh and its jacobian
+    auto make_mesh = [](IDX nx, IDX ny){
+        return AbstractMesh<T, IDX, ndim>({0.0, 0.0}, {1.0, 0.02}, {nx, ny}, 1,
+            {BOUNDARY_CONDITIONS::DIRICHLET, BOUNDARY_CONDITIONS::DIRICHLET,
+             BOUNDARY_CONDITIONS::DIRICHLET, BOUNDARY_CONDITIONS::DIRICHLET}, {0, 0, 0, 0});
+    };
+    auto form_jacobian = [&](FESpace<T, IDX, ndim>& fespace, std::vector<T>& u_storage, Mat& jac){
+        fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+        u_storage.assign(u_layout.size(), 0.0);
+        std::vector<T> res_storage(u_layout.size());
+        fespan u{u_storage.data(), u_layout};
+        fespan res{res_storage.data(), u_layout};
+        MatCreate(PETSC_COMM_WORLD, &jac);
+        MatSetSizes(jac, u_layout.size(), u_layout.size(), PETSC_DETERMINE, PETSC_DETERMINE);
+        MatSetFromOptions(jac);
+        preallocate_petsc_jacobian(fespace, 1, jac);
+        form_petsc_jacobian_fd(fespace, disc, u, res, jac);
+        MatAssemblyBegin(jac, MAT_FINAL_ASSEMBLY);
+        MatAssemblyEnd(jac, MAT_FINAL_ASSEMBLY);
+    };
+
+    {
+        // the lines are the columns of elements across the thin direction
+        static constexpr IDX nx = 3, ny = 5;
+        AbstractMesh<T, IDX, ndim> mesh = make_mesh(nx, ny);
+        FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LEGENDRE,
+            std::integral_constant<int, 1>{}};
+        std::vector<T> u_storage;
+        Mat jac;
+        form_jacobian(fespace, u_storage, jac);
+        fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+        fespan u{u_storage.data(), u_layout};
+
+        util::crs<IDX> elsuel = to_elsuel<T, IDX, ndim>(fespace.elements.size(), mesh.faces);
+
+        ElementLineImplicit<T, IDX> from_disc{}, from_matrix{};
+        from_disc.build(fespace, disc, u);
+        from_matrix.set_structure(fespace, 1);
+        from_matrix.build_from_matrix(jac);
+        for(const ElementLineImplicit<T, IDX>* line_pc : {&from_disc, &from_matrix}){
+            const util::crs<IDX, IDX>& lines = line_pc->get_lines();
+            ASSERT_EQ(lines.nrow(), (std::size_t) nx);
+            std::set<IDX> seen{};
+            for(IDX iline = 0; iline < nx; ++iline){
+                auto line = lines.rowspan(iline);
+                ASSERT_EQ(line.size(), (std::size_t) ny);
+                T dy = fespace.elements[line[1]].centroid()[1] - fespace.elements[line[0]].centroid()[1];
+                ASSERT_NEAR(std::abs(dy), 0.02 / ny, 1e-12);
+
+                // consecutive face neighbors in the same column
+                for(std::size_t i = 0; i < line.size(); ++i){
+                    seen.insert(line[i]);
+                    auto centroid = fespace.elements[line[i]].centroid();
+                    ASSERT_NEAR(centroid[0], fespace.elements[line[0]].centroid()[0], 1e-12);
+                    ASSERT_NEAR(centroid[1] - fespace.elements[line[0]].centroid()[1], i * dy, 1e-12);
+                    if(i > 0){
+                        auto neighbors = elsuel.rowspan(line[i]);
+                        ASSERT_NE(std::ranges::find(neighbors, line[i - 1]), neighbors.end());
+                    }
+                }
+            }
+            ASSERT_EQ(seen.size(), (std::size_t) (nx * ny));
+        }
+        MatDestroy(&jac);
+    }
+
+    {
+        // on a single column the line is the whole jacobian so the block tridiagonal solve is exact
+        static constexpr IDX ny = 6;
+        AbstractMesh<T, IDX, ndim> mesh = make_mesh(1, ny);
+        FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LEGENDRE,
+            std::integral_constant<int, 2>{}};
+        std::vector<T> u_storage;
+        Mat jac;
+        form_jacobian(fespace, u_storage, jac);
+        const std::size_t n = u_storage.size();
+
+        ElementLineImplicit<T, IDX> line_pc{};
+        line_pc.set_structure(fespace, 1);
+        line_pc.build_from_matrix(jac);
+        ASSERT_EQ(line_pc.get_lines().nrow(), (std::size_t) 1);
+
+        std::vector<T> rhs(n), out(n);
+        for(std::size_t i = 0; i < n; ++i) rhs[i] = std::sin(0.7 * i) + 0.1;
+        line_pc.apply(rhs.data(), out.data());
+
+        // dense gaussian elimination with partial pivoting
+        std::vector<T> A(n * n), x = rhs;
+        for(std::size_t i = 0; i < n; ++i){
+            for(std::size_t j = 0; j < n; ++j) MatGetValue(jac, i, j, &A[i * n + j]);
+        }
+        for(std::size_t k = 0; k < n; ++k){
+            std::size_t ipiv = k;
+            for(std::size_t i = k + 1; i < n; ++i) if(std::abs(A[i * n + k]) > std::abs(A[ipiv * n + k])) ipiv = i;
+            for(std::size_t j = 0; j < n; ++j) std::swap(A[k * n + j], A[ipiv * n + j]);
+            std::swap(x[k], x[ipiv]);
+            for(std::size_t i = k + 1; i < n; ++i){
+                T factor = A[i * n + k] / A[k * n + k];
+                for(std::size_t j = k; j < n; ++j) A[i * n + j] -= factor * A[k * n + j];
+                x[i] -= factor * x[k];
+            }
+        }
+        for(std::size_t i = n; i-- > 0;){
+            for(std::size_t j = i + 1; j < n; ++j) x[i] -= A[i * n + j] * x[j];
+            x[i] /= A[i * n + i];
+        }
+
+        T xnorm = 0;
+        for(T xi : x) xnorm = std::max(xnorm, std::abs(xi));
+        for(std::size_t i = 0; i < n; ++i) ASSERT_NEAR(out[i], x[i], 1e-10 * xnorm);
+        MatDestroy(&jac);
+    }
+}
+
+/**
+ * @brief the jacobian assembled with the element, trace, and boundary jacobians of the discretization
+ * matches the colored finite differences of the whole residual
+ */
+template<class T, class IDX, int ndim, class disc_class, class uLayoutPolicy>
+static void check_analytic_jacobian_blocks(FESpace<T, IDX, ndim>& fespace, disc_class& disc,
+        fespan<T, uLayoutPolicy> u, T tol)
+{
+    const std::size_t n = u.size();
+    std::vector<T> res_storage(n), res_fd_storage(n);
+    fespan res{res_storage.data(), u.get_layout()};
+    fespan res_fd{res_fd_storage.data(), u.get_layout()};
+    std::array<Mat, 2> jacs;
+    for(Mat& jac : jacs){
+        MatCreate(PETSC_COMM_WORLD, &jac);
+        MatSetSizes(jac, n, n, PETSC_DETERMINE, PETSC_DETERMINE);
+        MatSetFromOptions(jac);
+        preallocate_petsc_jacobian(fespace, disc_class::dnv_comp, jac);
+    }
+    form_petsc_jacobian_fd(fespace, disc, u, res, jacs[0]);
+    ResidualWorkspace<T, IDX> workspace{fespace, disc_class::dnv_comp};
+    form_petsc_jacobian_fd_colored(fespace, disc, u, res_fd, jacs[1], color_elements_distance2(fespace), workspace);
+    for(Mat jac : jacs){
+        MatAssemblyBegin(jac, MAT_FINAL_ASSEMBLY);
+        MatAssemblyEnd(jac, MAT_FINAL_ASSEMBLY);
+    }
+    for(std::size_t i = 0; i < n; ++i) ASSERT_NEAR(res_storage[i], res_fd_storage[i], 1e-10);
+
+    // compare every entry relative to the largest entry
+    T scale = 0;
+    std::vector<T> analytic(n * n), fd(n * n);
+    for(std::size_t i = 0; i < n; ++i){
+        for(std::size_t j = 0; j < n; ++j){
+            MatGetValue(jacs[0], i, j, &analytic[i * n + j]);
+            MatGetValue(jacs[1], i, j, &fd[i * n + j]);
+            scale = std::max(scale, std::abs(fd[i * n + j]));
+        }
+    }
+    ASSERT_GT(scale, 0.0);
+    for(std::size_t i = 0; i < n; ++i){
+        SCOPED_TRACE("irow = " + std::to_string(i));
+        for(std::size_t j = 0; j < n; ++j){
+            SCOPED_TRACE("jcol = " + std::to_string(j));
+            ASSERT_NEAR(analytic[i * n + j], fd[i * n + j], tol * scale);
+        }
+    }
+    for(Mat& jac : jacs) MatDestroy(&jac);
+}
+
+TEST(test_petsc_jacobian, test_analytic_jacobian_blocks){
+    static constexpr int ndim = 2;
+    using T = build_config::T;
+    using IDX = build_config::IDX;
+
+    // dirichlet and neumann boundaries use the boundary jacobians, extrapolation the finite difference fallback
+    AbstractMesh<T, IDX, ndim> mesh({0.0, 0.0}, {1.0, 1.0}, {3, 3}, 1,
+        {BOUNDARY_CONDITIONS::DIRICHLET, BOUNDARY_CONDITIONS::NEUMANN,
+         BOUNDARY_CONDITIONS::DIRICHLET, BOUNDARY_CONDITIONS::EXTRAPOLATION}, {0, 0, 0, 0});
+    FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LEGENDRE,
+        std::integral_constant<int, 1>{}};
+
+    {
+        SCOPED_TRACE("burgers");
+        BurgersCoefficients<T, ndim> burgers_coeffs{};
+        burgers_coeffs.mu = 0.01;
+        burgers_coeffs.a[0] = 1.0;
+        burgers_coeffs.a[1] = -0.5;
+        burgers_coeffs.b[0] = 0.5;
+        burgers_coeffs.b[1] = 0.25;
+        ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                              BurgersUpwind{burgers_coeffs},
+                              BurgersDiffusionFlux{burgers_coeffs}};
+        disc.dirichlet_callbacks.push_back([](const T* x, T* out){ out[0] = 1.0 + x[0]; });
+        disc.neumann_callbacks.push_back([](const T* x, T* out){ out[0] = 0.5; });
+
+        fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+        std::vector<T> u_storage(u_layout.size());
+        fespan u{u_storage.data(), u_layout};
+        Projection<T, IDX, ndim, 1> projection{[](const T* x, T* out){ out[0] = 1.0 + std::sin(2.0 * x[0]) * x[1]; }};
+        LinearFormSolver{fespace, projection}.solve(u);
+        check_analytic_jacobian_blocks(fespace, disc, u, 1e-5);
+    }
+
+    {
+        SCOPED_TRACE("navier_stokes");
+        navier_stokes::ReferenceParameters<T> ref{};
+        navier_stokes::CaloricallyPerfectEoS<T, ndim> eos{};
+        navier_stokes::constant_viscosity<T> mu{0.1};
+        navier_stokes::Physics physics{ref, eos, mu};
+        ConservationLawDDG disc{navier_stokes::Flux{physics, std::true_type{}},
+                              navier_stokes::VanLeer{physics},
+                              navier_stokes::DiffusionFlux{physics, std::true_type{}}};
+        static constexpr int neq = decltype(disc)::nv_comp;
+        auto state = [](const T* x, T* out){
+            out[0] = 1.0 + 0.1 * std::sin(x[0] + 2.0 * x[1]);
+            out[1] = 0.3 * out[0];
+            out[2] = 0.1 * out[0] * (1.0 + x[0]);
+            out[3] = 2.5 + 0.2 * x[1];
+        };
+        disc.dirichlet_callbacks.push_back(state);
+        disc.neumann_callbacks.push_back([](const T*, T* out){ for(int ieq = 0; ieq < neq; ++ieq) out[ieq] = 0.0; });
+
+        fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, neq>{}};
+        std::vector<T> u_storage(u_layout.size());
+        fespan u{u_storage.data(), u_layout};
+        Projection<T, IDX, ndim, neq> projection{state};
+        LinearFormSolver{fespace, projection}.solve(u);
+        check_analytic_jacobian_blocks(fespace, disc, u, 1e-5);
+    }
+
+    {
+        // three elements across the periodic direction so the wrap around neighbors share a color neighborhood
+        SCOPED_TRACE("periodic");
+        AbstractMesh<T, IDX, ndim> periodic_mesh({0.0, 0.0}, {1.0, 1.0}, {3, 3}, 1,
+            {BOUNDARY_CONDITIONS::PERIODIC, BOUNDARY_CONDITIONS::DIRICHLET,
+             BOUNDARY_CONDITIONS::PERIODIC, BOUNDARY_CONDITIONS::NEUMANN}, {0, 0, 0, 0});
+        periodic_mesh.make_periodic_faces_interior();
+        FESpace<T, IDX, ndim> periodic_fespace{&periodic_mesh, FESPACE_ENUMS::LAGRANGE, 
+            FESPACE_ENUMS::GAUSS_LEGENDRE, std::integral_constant<int, 1>{}};
+
+        // every element couples to its left and right neighbors across the periodic boundary
+        for(IDX iel = 0; iel < (IDX) periodic_fespace.elements.size(); ++iel){
+            std::vector<IDX> neighbors = element_face_neighbors(periodic_fespace, iel);
+            int nx_neighbors = 0;
+            for(IDX jel : neighbors){
+                T dy = periodic_fespace.elements[jel].centroid()[1] - periodic_fespace.elements[iel].centroid()[1];
+                if(jel != iel && std::abs(dy) < 1e-12) ++nx_neighbors;
+            }
+            ASSERT_EQ(nx_neighbors, 2);
+        }
+
+        BurgersCoefficients<T, ndim> burgers_coeffs{};
+        burgers_coeffs.mu = 0.01;
+        burgers_coeffs.a[0] = 1.0;
+        burgers_coeffs.a[1] = -0.5;
+        burgers_coeffs.b[0] = 0.5;
+        ConservationLawDDG disc{BurgersFlux{burgers_coeffs},
+                              BurgersUpwind{burgers_coeffs},
+                              BurgersDiffusionFlux{burgers_coeffs}};
+        disc.dirichlet_callbacks.push_back([](const T* x, T* out){ out[0] = 1.0; });
+        disc.neumann_callbacks.push_back([](const T* x, T* out){ out[0] = 0.0; });
+
+        fe_layout_right u_layout{periodic_fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+        std::vector<T> u_storage(u_layout.size());
+        fespan u{u_storage.data(), u_layout};
+        Projection<T, IDX, ndim, 1> projection{[](const T* x, T* out){ 
+            out[0] = 1.0 + 0.5 * std::sin(2.0 * std::numbers::pi * x[0]) * x[1]; }};
+        LinearFormSolver{periodic_fespace, projection}.solve(u);
+        check_analytic_jacobian_blocks(periodic_fespace, disc, u, 1e-5);
+    }
+}
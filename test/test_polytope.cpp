@@ -1,6 +1,8 @@
 #include "gtest/gtest.h"
 #include "iceicle/basis/lagrange_1d.hpp"
 #include "iceicle/transformations/polytope_transformations.hpp"
+#include <span>
+#include <vector>
 
 using namespace iceicle;
 using namespace polytope;
@@ -157,3 +159,105 @@ TEST(test_polytope, test_extrusion_parities) {
     }
 }
 
+
+TEST(test_polytope, test_faces) {
+    static_assert(faces<segment_t>.size() == 2);
+    static_assert(faces<tri_a_t>.size() == 3);
+    static_assert(faces<quad_a_t>.size() == 4);
+    static_assert(faces<tet_a_t>.size() == 4);
+    static_assert(faces<pyra_a_t>.size() == 5);
+    static_assert(faces<prism_a_t>.size() == 5);
+    static_assert(faces<hexa_a_t>.size() == 6);
+
+    { // triangle: x = 0, x + y = 1, y = 0
+        std::array<std::vector<std::size_t>, 3> expected{
+            std::vector<std::size_t>{0, 2}, std::vector<std::size_t>{1, 2}, std::vector<std::size_t>{0, 1}};
+        for(int iface = 0; iface < 3; ++iface){
+            auto face_vert = faces<tri_a_t>[iface].indices();
+            ASSERT_EQ(std::vector<std::size_t>(face_vert.begin(), face_vert.end()), expected[iface]);
+        }
+    }
+
+    { // pyramid: the base is the quad, the rest are triangles
+        auto base = faces<pyra_a_t>[4].indices();
+        ASSERT_EQ(std::vector<std::size_t>(base.begin(), base.end()), (std::vector<std::size_t>{0, 1, 2, 3}));
+        for(int iface = 0; iface < 4; ++iface) ASSERT_EQ(faces<pyra_a_t>[iface].nvert, 3);
+    }
+
+    { // every hexahedron face has a constant coordinate
+        for(const auto& face : faces<hexa_a_t>){
+            ASSERT_EQ(face.nvert, 4);
+            int nconst = 0;
+            for(int idim = 0; idim < 3; ++idim){
+                bool constant = true;
+                for(std::size_t ivert : face.indices())
+                    constant = constant && (vertices<hexa_a_t>[ivert][idim] == vertices<hexa_a_t>[face.vertices[0]][idim]);
+                if(constant) ++nconst;
+            }
+            ASSERT_EQ(nconst, 1);
+        }
+    }
+}
+
+TEST(test_polytope, test_shape_functions) {
+    auto test_topology = []<geo_code auto t>(){
+        static constexpr int ndim = get_ndim(t);
+        using Point = MATH::GEOMETRY::Point<double, ndim>;
+        const auto& vcoord = vertex_coordinates<double, t>;
+
+        // kronecker property at the vertices
+        for(std::size_t ivert = 0; ivert < n_vert(t); ++ivert){
+            auto N = shp<double, t>(vcoord[ivert]);
+            for(std::size_t jvert = 0; jvert < n_vert(t); ++jvert)
+                ASSERT_NEAR(N[jvert], (ivert == jvert) ? 1.0 : 0.0, 1e-14);
+        }
+
+        // interior point
+        Point xi;
+        for(int idim = 0; idim < ndim; ++idim) xi[idim] = 0.1 + 0.07 * idim;
+
+        // partition of unity
+        auto N = shp<double, t>(xi);
+        double sum = 0.0;
+        for(double Ni : N) sum += Ni;
+        ASSERT_NEAR(sum, 1.0, 1e-14);
+
+        // gradients against finite differences
+        auto dN = shp_deriv<double, t>(xi);
+        static constexpr double epsilon = 1e-7;
+        for(int jdim = 0; jdim < ndim; ++jdim){
+            Point xi_p = xi;
+            xi_p[jdim] += epsilon;
+            auto N_p = shp<double, t>(xi_p);
+            for(std::size_t ivert = 0; ivert < n_vert(t); ++ivert)
+                ASSERT_NEAR(dN[ivert][jdim], (N_p[ivert] - N[ivert]) / epsilon, 1e-6);
+        }
+
+        // the shape functions reproduce linear fields (identity map and affine map)
+        std::array<Point, n_vert(t)> x_vert;
+        for(std::size_t ivert = 0; ivert < n_vert(t); ++ivert){
+            for(int idim = 0; idim < ndim; ++idim){
+                x_vert[ivert][idim] = 0.5 + 2.0 * vcoord[ivert][idim];
+                if(idim > 0) x_vert[ivert][idim] += 0.3 * vcoord[ivert][0];
+            }
+        }
+        Point x = transform<double, t>(std::span<const Point>{x_vert}, xi);
+        auto J = jacobian<double, t>(std::span<const Point>{x_vert}, xi);
+        for(int idim = 0; idim < ndim; ++idim){
+            double x_expected = 0.5 + 2.0 * xi[idim] + ((idim > 0) ? 0.3 * xi[0] : 0.0);
+            ASSERT_NEAR(x[idim], x_expected, 1e-14);
+            for(int jdim = 0; jdim < ndim; ++jdim){
+                double J_expected = ((idim == jdim) ? 2.0 : 0.0) + ((idim > 0 && jdim == 0) ? 0.3 : 0.0);
+                ASSERT_NEAR(J[idim][jdim], J_expected, 1e-14);
+            }
+        }
+    };
+
+    test_topology.template operator()<segment_t>();
+    test_topology.template operator()<tri_a_t>();
+    test_topology.template operator()<quad_b_t>();
+    test_topology.template operator()<tet_a_t>();
+    test_topology.template operator()<pyra_a_t>();
+    test_topology.template operator()<prism_a_t>();
+    test_topology.template operator()<hexa_b_t>();
+}
@@ -1,7 +1,13 @@
 #include "iceicle/disc/SpacetimeConnection.hpp"
+#include "iceicle/disc/burgers.hpp"
+#include "iceicle/disc/conservation_law.hpp"
+#include "iceicle/fespace/fespace.hpp"
+#include "iceicle/form_residual.hpp"
 #include "iceicle/geometry/face.hpp"
 #include "iceicle/mesh/mesh.hpp"
+#include "iceicle/spacetime_slab_solver.hpp"
 #include "gtest/gtest.h"
+#include <cmath>
 
 using namespace iceicle;
 
@@ -31,3 +37,57 @@ TEST(test_spacetime_utils, test_node_connectivity){
 
     
 }
+
+TEST(test_spacetime_utils, test_slab_solver){
+    using namespace NUMTOOL::TENSOR::FIXED_SIZE;
+    using T = double;
+    using IDX = int;
+    static constexpr int ndim = 2;
+    static constexpr int nelem_x = 4, nelem_t = 5;
+    AbstractMesh<T, IDX, ndim> mesh {
+        Tensor<T, ndim>{{0.0, 0.0}},
+        Tensor<T, ndim>{{1.0, 1.0}},
+        Tensor<IDX, ndim>{{nelem_x, nelem_t}},
+        1,
+        Tensor<BOUNDARY_CONDITIONS, 4>{
+            BOUNDARY_CONDITIONS::DIRICHLET,
+            BOUNDARY_CONDITIONS::DIRICHLET,
+            BOUNDARY_CONDITIONS::EXTRAPOLATION,
+            BOUNDARY_CONDITIONS::SPACETIME_FUTURE
+        },
+        Tensor<int, 4>{0, 1, 0, 0}
+    };
+    FESpace<T, IDX, ndim> fespace{&mesh, FESPACE_ENUMS::LAGRANGE, FESPACE_ENUMS::GAUSS_LEGENDRE,
+        std::integral_constant<int, 1>{}};
+
+    // every row of elements in time is a layer
+    util::crs<IDX, IDX> layers = solvers::compute_time_layers(fespace);
+    ASSERT_EQ(layers.nrow(), nelem_t);
+    for(IDX ilayer = 0; ilayer < nelem_t; ++ilayer){
+        ASSERT_EQ(layers.rowsize(ilayer), nelem_x);
+        for(IDX iel : layers.rowspan(ilayer))
+            ASSERT_NEAR(fespace.elements[iel].centroid()[1], (ilayer + 0.5) / nelem_t, 1e-12);
+    }
+
+    // spacetime linear advection
+    BurgersCoefficients<T, ndim - 1> burgers_coeffs{};
+    burgers_coeffs.mu = 0.0;
+    burgers_coeffs.a[0] = 0.5;
+    ConservationLawDDG disc{SpacetimeBurgersFlux{burgers_coeffs},
+        SpacetimeBurgersUpwind{burgers_coeffs}, SpacetimeBurgersDiffusion{burgers_coeffs}};
+    disc.dirichlet_callbacks.push_back([](const T* x, T* out){ out[0] = 1.0 + x[1]; });
+    disc.dirichlet_callbacks.push_back([](const T* x, T* out){ out[0] = 1.0 + std::sin(M_PI * x[0]); });
+
+    fe_layout_right u_layout{fespace.dg_map, std::integral_constant<std::size_t, 1>{}};
+    std::vector<T> u_data(u_layout.size(), 0.0), res_data(u_layout.size());
+    fespan u{u_data.data(), u_layout};
+    fespan res{res_data.data(), u_layout};
+
+    solvers::ConvergenceCriteria<T, IDX> conv_criteria{.tau_abs = 1e-12, .tau_rel = 0.0, .kmax = 5};
+    solvers::SpacetimeSlabSolver solver{fespace, disc, conv_criteria};
+    solver.solve(u);
+
+    // a single causal sweep solves the whole spacetime problem
+    solvers::form_residual(fespace, disc, u, res);
+    ASSERT_LT(res.vector_norm(), 1e-9);
+}
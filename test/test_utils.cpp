@@ -1,6 +1,43 @@
 #include "gtest/gtest.h"
 #include "iceicle/algo.hpp"
+#include "iceicle/anomaly_log.hpp"
 #include "iceicle/bitset.hpp"
+#include "iceicle/compressed_crs.hpp"
+#include "iceicle/coroutine_executor.hpp"
+#include "iceicle/disc/callback_table.hpp"
+#include "iceicle/dual_number.hpp"
+#include "iceicle/expression.hpp"
+#include "iceicle/flat_map.hpp"
+#include "iceicle/graph_coloring.hpp"
+#include "iceicle/linalg/small_dense.hpp"
+#include "iceicle/mapped_file.hpp"
+#include "iceicle/lossy_compression.hpp"
+#include "iceicle/memory_arena.hpp"
+#include "iceicle/nonlinear_solver_utils.hpp"
+#include "iceicle/output_scheduler.hpp"
+#include "iceicle/profiler.hpp"
+#include "iceicle/reproducible_sum.hpp"
+#include "iceicle/shared_memory_ring.hpp"
+#include "iceicle/task_pool.hpp"
+#include "iceicle/thread_utils.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <numbers>
+#include <optional>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
 
 using namespace iceicle::util;
 
@@ -135,3 +172,896 @@ TEST(test_util, test_bitset){
     ASSERT_EQ(bitset<6>{"011010"}.to_ulong(), 0b011010);
     ASSERT_EQ(bitset<6>{"011010"}.to_ullong(), 0b011010);
 }
+
+TEST(test_util, test_greedy_coloring){
+    // a 1D chain of 5 vertices with 4 edges and a wraparound edge
+    std::vector<std::array<int, 2>> edges{{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 0}};
+    crs<int, int> colors = greedy_coloring(5, 5, [&](int iedge){ return edges[iedge]; });
+
+    // odd cycle needs 3 colors
+    ASSERT_EQ(colors.nrow(), 3);
+    ASSERT_EQ(colors.nnz(), 5);
+    ASSERT_EQ((colors[0, 0]), 0);
+    ASSERT_EQ((colors[0, 1]), 2);
+    ASSERT_EQ((colors[1, 0]), 1);
+    ASSERT_EQ((colors[1, 1]), 3);
+    ASSERT_EQ((colors[2, 0]), 4);
+
+    // no two items in a color share a vertex
+    for(int icolor = 0; icolor < colors.nrow(); ++icolor){
+        std::vector<int> touched(5, 0);
+        for(int iedge : colors.rowspan(icolor)){
+            for(int ivert : edges[iedge]) ++touched[ivert];
+        }
+        for(int count : touched) ASSERT_LE(count, 1);
+    }
+}
+
+TEST(test_util, test_crs_builders){
+    // element connectivity of a strip of 3 quads over 8 nodes
+    std::vector<std::vector<int>> conn{{0, 1, 4, 5}, {1, 2, 5, 6}, {2, 3, 6, 7}};
+    crs<int, int> conn_el = make_crs<int, int>(3,
+        [&](int iel){ return conn[iel].size(); },
+        [&](int iel, std::span<int> row){ std::ranges::copy(conn[iel], row.begin()); });
+    crs<int, int> conn_ragged{conn};
+    ASSERT_EQ(conn_el.nnz(), 12);
+    for(int i = 0; i < 12; ++i) ASSERT_EQ(conn_el.data()[i], conn_ragged.data()[i]);
+    for(int i = 0; i < 4; ++i) ASSERT_EQ(conn_el.cols()[i], conn_ragged.cols()[i]);
+
+    // elements surrounding points
+    crs<int, int> elsup = transpose_crs(conn_el, 8);
+    ASSERT_EQ(elsup.nrow(), 8);
+    ASSERT_EQ(elsup.nnz(), 12);
+    std::vector<std::vector<int>> expected{{0}, {0, 1}, {1, 2}, {2}, {0}, {0, 1}, {1, 2}, {2}};
+    for(int inode = 0; inode < 8; ++inode)
+        ASSERT_TRUE(std::ranges::equal(elsup.rowspan(inode), expected[inode]));
+
+    // transposing twice recovers the rows (entries in sorted order)
+    crs<int, int> conn_tt = transpose_crs(elsup, 3);
+    for(int iel = 0; iel < 3; ++iel)
+        ASSERT_TRUE(std::ranges::equal(conn_tt.rowspan(iel), conn[iel]));
+
+    // empty rows and columns
+    crs<int, int> empty = transpose_crs(crs<int, int>{std::vector<std::vector<int>>{{}, {}}}, 3);
+    ASSERT_EQ(empty.nrow(), 3);
+    ASSERT_EQ(empty.nnz(), 0);
+
+    crs<long, std::size_t> converted = convert_crs<long, std::size_t>(elsup);
+    ASSERT_EQ(converted.nnz(), elsup.nnz());
+    for(int inode = 0; inode < 8; ++inode)
+        ASSERT_TRUE(std::ranges::equal(converted.rowspan(inode), elsup.rowspan(inode)));
+}
+
+TEST(test_util, test_compressed_crs){
+    // structured quad connectivity over more than one block of rows
+    int nx = 20, ny = 3;
+    std::vector<std::vector<int>> conn{};
+    for(int j = 0; j < ny; ++j) for(int i = 0; i < nx; ++i){
+        int n0 = j * (nx + 1) + i;
+        conn.push_back({n0, n0 + 1, n0 + nx + 1, n0 + nx + 2});
+    }
+    conn.push_back({}); // an empty row
+    conn.push_back({100000, 3, 70000});
+    crs<int, int> conn_el{conn};
+    compressed_crs<int, int> compressed{conn_el};
+    ASSERT_EQ(compressed.nrow(), conn_el.nrow());
+    ASSERT_EQ(compressed.nnz(), conn_el.nnz());
+    ASSERT_LT(compressed.memory_bytes(), conn_el.nnz() * sizeof(int));
+
+    // random access
+    for(int irow = 0; irow < (int) conn.size(); ++irow){
+        ASSERT_EQ(compressed.rowsize(irow), conn[irow].size());
+        ASSERT_TRUE(std::ranges::equal(compressed.rowspan(irow), conn[irow]));
+    }
+    ASSERT_EQ((compressed[nx + 1, 2]), conn[nx + 1][2]);
+
+    // sequential traversal
+    int irow = 0;
+    for(auto row : compressed.rows()){
+        std::vector<int> values{};
+        for(int v : row) values.push_back(v);
+        ASSERT_EQ(values, conn[irow]);
+        ++irow;
+    }
+    ASSERT_EQ(irow, (int) conn.size());
+
+    crs<int, int> decoded = compressed.to_crs();
+    ASSERT_EQ(decoded.nnz(), conn_el.nnz());
+    for(int i = 0; i < (int) conn_el.nnz(); ++i) ASSERT_EQ(decoded.data()[i], conn_el.data()[i]);
+}
+
+TEST(test_util, test_small_flat_map){
+    util::small_flat_map<std::array<int, 2>, std::vector<int>> map{};
+    ASSERT_EQ(map.size(), 0);
+    ASSERT_EQ(map.find({0, 1}), nullptr);
+
+    int ncalls = 0;
+    std::vector<int>& a = map.get_or_emplace({0, 1}, [&]{ ++ncalls; return std::vector<int>{1, 2}; });
+    map[{2, 3}].push_back(3);
+    ASSERT_EQ(map.size(), 2);
+    ASSERT_TRUE(map.contains({2, 3}));
+    ASSERT_FALSE(map.contains({3, 2}));
+
+    // existing keys are not created again
+    std::vector<int>& b = map.get_or_emplace({0, 1}, [&]{ ++ncalls; return std::vector<int>{}; });
+    ASSERT_EQ(ncalls, 1);
+    ASSERT_EQ(&a, &b);
+
+    // adding keys keeps the values in place
+    for(int i = 0; i < 100; ++i) map[{i, -i}];
+    ASSERT_EQ(map.find({0, 1}), &a);
+    ASSERT_EQ(a.size(), 2);
+    ASSERT_EQ(map.index_of({2, 3}), 1);
+    ASSERT_EQ(map.key_at(1), (std::array<int, 2>{2, 3}));
+    ASSERT_EQ(map.value_at(1)[0], 3);
+    ASSERT_EQ(map.index_of({-1, -1}), map.size());
+}
+
+TEST(test_util, test_dual_number){
+    using Dual2 = Dual<double, 2>;
+
+    // f(x, y) = x * y + sqrt(x) / y - pow(y, 3)
+    auto f = [](auto x, auto y){
+        using std::sqrt;
+        using std::pow;
+        return x * y + sqrt(x) / y - pow(y, 3);
+    };
+    double x = 4.0, y = 0.5;
+    Dual2 fd = f(Dual2{x, 0}, Dual2{y, 1});
+    ASSERT_DOUBLE_EQ(fd.val, f(x, y));
+    ASSERT_DOUBLE_EQ(fd.grad[0], y + 0.5 / (std::sqrt(x) * y));
+    ASSERT_DOUBLE_EQ(fd.grad[1], x - std::sqrt(x) / (y * y) - 3 * y * y);
+
+    // comparisons and branches use the primal value
+    Dual2 a{-2.0, 0};
+    ASSERT_TRUE(a < 0);
+    ASSERT_DOUBLE_EQ(abs(a).grad[0], -1.0);
+    ASSERT_DOUBLE_EQ(max(a, 1.0).val, 1.0);
+    ASSERT_DOUBLE_EQ(max(a, 1.0).grad[0], 0.0);
+    ASSERT_DOUBLE_EQ(primal(2.0 - a), 4.0);
+    ASSERT_DOUBLE_EQ((1.0 / a).grad[0], -0.25);
+}
+
+TEST(test_util, test_thread_utils){
+    ASSERT_GE(max_threads(), 1);
+
+    // first touch storage is value initialized
+    first_touch_vector<double> data(1000);
+    for(double v : data) ASSERT_EQ(v, 0.0);
+
+    // every iteration is visited exactly once
+    std::vector<int> visits(1000, 0);
+    parallel_for(visits.size(), [&](std::size_t i){ visits[i] += 1; data[i] = 2.0 * i; });
+    for(std::size_t i = 0; i < visits.size(); ++i){
+        ASSERT_EQ(visits[i], 1);
+        ASSERT_DOUBLE_EQ(data[i], 2.0 * i);
+    }
+
+    // several sums in one pass
+    std::array<double, 2> sums = parallel_sums<2, double>(data.size(), [&](std::size_t i, std::array<double, 2>& s){
+        s[0] += data[i];
+        s[1] += 1.0;
+    });
+    ASSERT_DOUBLE_EQ(sums[0], 999.0 * 1000.0);
+    ASSERT_DOUBLE_EQ(sums[1], 1000.0);
+}
+
+TEST(test_util, test_lazy_value){
+    lazy_value<std::vector<int>> value{};
+    ASSERT_EQ(value.get_if(), nullptr);
+
+    // concurrent first uses build the value exactly once
+    std::atomic<int> nbuilds{0};
+    std::vector<const std::vector<int>*> ptrs(100);
+    parallel_for(ptrs.size(), [&](std::size_t i){
+        ptrs[i] = &value.get([&]{ ++nbuilds; return std::vector<int>{1, 2, 3}; });
+    });
+    ASSERT_EQ(nbuilds.load(), 1);
+    for(const std::vector<int>* ptr : ptrs) ASSERT_EQ(ptr, value.get_if());
+    ASSERT_EQ(value.get_if()->size(), 3);
+
+    // moves take the value
+    lazy_value<std::vector<int>> moved{std::move(value)};
+    ASSERT_EQ(value.get_if(), nullptr);
+    ASSERT_EQ(moved.get_if(), ptrs[0]);
+
+    // reset frees the value so it is built again
+    moved.reset();
+    ASSERT_EQ(moved.get_if(), nullptr);
+    ASSERT_EQ(moved.get([]{ return std::vector<int>{4}; })[0], 4);
+}
+
+TEST(test_util, test_task_pool){
+    // ranges of similar cost
+    std::vector<double> costs{1, 1, 4, 1, 1, 1, 1};
+    std::vector<std::size_t> bounds = cost_balanced_bounds(std::span<const double>{costs}, 2.0);
+    ASSERT_EQ(bounds, (std::vector<std::size_t>{0, 2, 3, 5, 7}));
+
+    task_pool pool{3};
+    ASSERT_EQ(pool.nthread(), 4);
+    ASSERT_EQ(pool.thread_index(), 3);
+
+    // each range task visits its items once
+    std::vector<int> visits(100, 0);
+    std::vector<std::size_t> range_bounds{0, 10, 50, 51, 100};
+    pool.submit_ranges(std::span<const std::size_t>{range_bounds}, [&](std::size_t begin, std::size_t end){
+        for(std::size_t i = begin; i < end; ++i) visits[i] += 1;
+    });
+    pool.wait_all();
+    for(int v : visits) ASSERT_EQ(v, 1);
+
+    // dependencies are respected
+    for(int irepeat = 0; irepeat < 10; ++irepeat){
+        std::atomic<int> stage{0};
+        std::atomic<bool> ordered{true};
+        std::vector<task_pool::task_id> first{};
+        for(int i = 0; i < 8; ++i) first.push_back(pool.submit([&]{ stage.fetch_add(1); }));
+        task_pool::task_id second = pool.submit([&]{ if(stage.load() != 8) ordered = false; stage.fetch_add(1); }, first);
+        std::vector<task_pool::task_id> second_dep{second};
+        for(int i = 0; i < 8; ++i)
+            pool.submit([&]{ if(stage.load() < 9) ordered = false; }, second_dep);
+        pool.wait_all();
+        ASSERT_TRUE(ordered.load());
+    }
+}
+
+TEST(test_util, test_memory_arena){
+    aligned_vector<double> aligned(37);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(aligned.data()) % simd_alignment, 0);
+
+    vector_arena<double> arena{};
+    double* first_ptr;
+    {
+        auto a = arena.checkout(100);
+        auto b = arena.checkout(50);
+        ASSERT_EQ(a.size(), 100);
+        ASSERT_EQ(b.size(), 50);
+        ASSERT_NE(a.data(), b.data());
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(a.data()) % simd_alignment, 0);
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(b.data()) % simd_alignment, 0);
+        ASSERT_EQ(arena.nin_use(), 2);
+        first_ptr = a.data();
+    }
+    ASSERT_EQ(arena.nin_use(), 0);
+
+    // buffers are reused once returned (the smallest large enough buffer is chosen)
+    {
+        auto a = arena.checkout(80);
+        ASSERT_EQ(a.data(), first_ptr);
+        auto b = arena.checkout(20);
+        auto c = arena.checkout(10);
+        ASSERT_EQ(arena.nbuffer(), 3);
+    }
+    ASSERT_EQ(arena.nbuffer(), 3);
+    ASSERT_EQ(arena.nin_use(), 0);
+}
+
+TEST(test_util, test_callback_table){
+    int ncall = 0;
+    auto f = [&ncall](const double* x, double* out){
+        ++ncall;
+        out[0] = x[0] + x[1];
+        out[1] = x[0] * x[1];
+    };
+    iceicle::callback_table<double, 2, 2> table{};
+    std::array<int, 3> nqp{2, 0, 1};
+    table.resize(nqp);
+
+    std::array<double, 2> x{1.0, 2.0};
+    std::array<double, 2> out;
+    table.eval(f, 0, 1, x.data(), out.data());
+    table.eval(f, 0, 1, x.data(), out.data());
+    ASSERT_EQ(ncall, 1);
+    ASSERT_DOUBLE_EQ(out[0], 3.0);
+    ASSERT_DOUBLE_EQ(out[1], 2.0);
+
+    // a moved point is evaluated again
+    x[0] = 3.0;
+    table.eval(f, 0, 1, x.data(), out.data());
+    ASSERT_EQ(ncall, 2);
+    ASSERT_DOUBLE_EQ(out[1], 6.0);
+
+    // entries outside the table call through
+    table.eval(f, 1, 0, x.data(), out.data());
+    table.eval(f, 1, 0, x.data(), out.data());
+    ASSERT_EQ(ncall, 4);
+}
+
+TEST(test_util, test_expression){
+    std::vector<std::string> variables{"x", "y"};
+    auto expr = Expression<double>::parse("(1 + x) * sin(pi * y) - 2^3^0.5 / max(x, 2) + -x^2 + 1.5e-1",
+            std::span<const std::string>{variables});
+    ASSERT_TRUE(expr.has_value());
+    auto exact = [](double x, double y){
+        return (1 + x) * std::sin(std::numbers::pi * y) - std::pow(2.0, std::pow(3.0, 0.5)) / std::max(x, 2.0)
+            - x * x + 0.15;
+    };
+
+    // single point and batched evaluations over more than one block
+    std::array<double, 2> pt{0.3, 0.7};
+    ASSERT_NEAR((*expr)(pt.data()), exact(0.3, 0.7), 1e-14);
+    std::size_t npoint = 150;
+    std::vector<double> points(2 * npoint), out(npoint);
+    for(std::size_t i = 0; i < npoint; ++i){
+        points[2 * i] = 0.01 * i;
+        points[2 * i + 1] = -0.02 * i;
+    }
+    expr->eval(std::span<const double>{points}, std::span<double>{out});
+    for(std::size_t i = 0; i < npoint; ++i) ASSERT_NEAR(out[i], exact(points[2 * i], points[2 * i + 1]), 1e-12);
+
+    // syntax errors and unknown names are anomalies
+    ASSERT_FALSE(Expression<double>::parse("x + ", std::span<const std::string>{variables}).has_value());
+    ASSERT_FALSE(Expression<double>::parse("z * 2", std::span<const std::string>{variables}).has_value());
+    ASSERT_EQ(AnomalyLog::size(), 2);
+    std::ostringstream anomaly_out{};
+    AnomalyLog::handle_anomalies(anomaly_out);
+}
+
+TEST(test_util, test_anomaly_records){
+    std::ostringstream anomaly_out{};
+    AnomalyLog::handle_anomalies(anomaly_out);
+
+    // records from several threads (including exited threads) are merged into the log
+    parallel_for(8, [](int i){ AnomalyLog::log_record("threaded record ", i); });
+    for(int i = 0; i < 2; ++i){
+        std::thread worker{[i]{ AnomalyLog::log_record("worker record ", i, true); }};
+        worker.join();
+    }
+    AnomalyLog::log_anomaly("full anomaly");
+    ICEICLE_HOT_CHECK(1 + 1 == 3, "failed hot check ", 3);
+#ifdef ICEICLE_DISABLE_HOT_CHECKS
+    ASSERT_EQ(AnomalyLog::size(), 11);
+#else
+    ASSERT_EQ(AnomalyLog::size(), 12);
+#endif
+
+    anomaly_out.str("");
+    AnomalyLog::handle_anomalies(anomaly_out);
+    ASSERT_EQ(AnomalyLog::size(), 0);
+    std::string out = anomaly_out.str();
+    for(int i = 0; i < 8; ++i) ASSERT_NE(out.find("Error: threaded record " + std::to_string(i)), std::string::npos);
+    ASSERT_NE(out.find("Warning: worker record 1"), std::string::npos);
+
+    // a full ring drops records and reports how many
+    for(std::size_t i = 0; i < anomaly_ring::capacity + 5; ++i) AnomalyLog::log_record("overflow");
+    ASSERT_EQ(AnomalyLog::size(), anomaly_ring::capacity + 1);
+    anomaly_out.str("");
+    AnomalyLog::handle_anomalies(anomaly_out);
+    ASSERT_NE(anomaly_out.str().find("5 anomaly records were dropped"), std::string::npos);
+}
+
+TEST(test_util, test_profiler){
+    Profiler::enable();
+    for(int i = 0; i < 3; ++i){
+        ProfileRegion outer{"outer"};
+        Profiler::add_work(1.0, 2.0);
+        { ProfileRegion inner{"inner"}; Profiler::add_work(10.0, 20.0); }
+        { ProfileRegion inner{"inner"}; Profiler::add_work(10.0, 20.0); }
+    }
+    {
+        ProfileRegion other{"other"};
+        // regions on other threads are not recorded
+        std::thread worker{[]{ ProfileRegion ignored{"ignored"}; }};
+        worker.join();
+    }
+    Profiler::disable();
+    { ProfileRegion after{"after_disable"}; }
+
+    std::vector<profile_region_stats> stats = Profiler::aggregate();
+    ASSERT_EQ(stats.size(), 4);
+    ASSERT_EQ(stats[0].path, "total");
+    ASSERT_EQ(stats[1].path, "total/outer");
+    ASSERT_EQ(stats[1].count, 3);
+    ASSERT_EQ(stats[2].path, "total/outer/inner");
+    ASSERT_EQ(stats[2].depth, 2);
+    ASSERT_EQ(stats[2].count, 6);
+    ASSERT_EQ(stats[3].path, "total/other");
+    ASSERT_GE(stats[0].time_avg, stats[1].time_avg + stats[3].time_avg);
+    ASSERT_GE(stats[1].time_avg, stats[2].time_avg);
+    ASSERT_NEAR(stats[1].self_avg, stats[1].time_avg - stats[2].time_avg, 1e-12);
+
+    // the work is inclusive of the nested regions
+    ASSERT_DOUBLE_EQ(stats[2].flops, 60.0);
+    ASSERT_DOUBLE_EQ(stats[2].bytes, 120.0);
+    ASSERT_DOUBLE_EQ(stats[1].flops, 63.0);
+    ASSERT_DOUBLE_EQ(stats[0].bytes, 126.0);
+    ASSERT_DOUBLE_EQ(stats[3].flops, 0.0);
+
+    std::ostringstream summary{}, json{};
+    Profiler::write_summary(summary, stats);
+    Profiler::write_json(json, stats);
+    ASSERT_NE(summary.str().find("inner"), std::string::npos);
+    ASSERT_NE(json.str().find("\"path\": \"total/outer/inner\""), std::string::npos);
+    ASSERT_NE(summary.str().find("GFLOP/s"), std::string::npos);
+    ASSERT_NE(json.str().find("\"flops\": 60"), std::string::npos);
+}
+
+TEST(test_util, test_linesearch_cache){
+    using namespace iceicle::solvers;
+
+    // count the calls and the distinct arguments of the underlying function
+    int ncall = 0;
+    std::set<double> args{};
+    function1d<double> phi = [&](double alpha){
+        ++ncall;
+        args.insert(alpha);
+        return (alpha - 0.3) * (alpha - 0.3) + 0.1;
+    };
+
+    cached_function1d<double> cached_phi{phi, 0.19};
+    ASSERT_EQ(cached_phi(0.0), 0.19);
+    ASSERT_EQ(ncall, 0);
+    ASSERT_EQ(cached_phi(0.5), phi(0.5));
+    ASSERT_EQ(cached_phi(0.5), phi(0.5));
+    ASSERT_EQ(cached_phi.nevals(), 1);
+
+    // every distinct alpha is evaluated once
+    ncall = 0;
+    args.clear();
+    corrigan_linesearch<double, int> corrigan{};
+    corrigan.alpha_max = 1.0;
+    double alpha = corrigan(phi);
+    ASSERT_EQ(ncall, args.size());
+    ASSERT_NEAR(alpha, 0.6, 1e-3); // bisects to where phi(alpha) = phi(0)
+
+    ncall = 0;
+    args.clear();
+    wolfe_linesearch<double, int> wolfe{};
+    wolfe.alpha_max = 1.0;
+    wolfe.alpha_initial = 0.1;
+    alpha = wolfe(phi, phi(0.0));
+    ASSERT_EQ(ncall, args.size()); // including the seeded phi(0)
+    ASSERT_LT(phi(alpha), phi(0.0));
+}
+
+TEST(test_util, test_mapped_file){
+    std::filesystem::path path = std::filesystem::temp_directory_path() 
+        / ("iceicle_mapped_file_test_" + std::to_string(::getpid()));
+    std::string contents(10000, 'a');
+    for(std::size_t i = 0; i < contents.size(); ++i) contents[i] = 'a' + (i % 26);
+    {
+        std::ofstream out{path, std::ios::binary};
+        out << contents;
+    }
+
+    for(bool sequential : {true, false}){
+        util::mapped_file file{path.string(), sequential};
+        ASSERT_TRUE((bool) file);
+        ASSERT_EQ(file.size(), contents.size());
+        ASSERT_EQ(std::string_view(file.data(), file.size()), contents);
+    }
+
+    // a missing file is an empty view with or without the fallback read
+    std::filesystem::remove(path);
+    util::mapped_file missing{path.string()};
+    ASSERT_FALSE((bool) missing);
+    ASSERT_FALSE(missing.mapped());
+    ASSERT_EQ(missing.size(), 0);
+    util::mapped_file missing_no_fallback{path.string(), true, false};
+    ASSERT_FALSE((bool) missing_no_fallback);
+}
+
+TEST(test_util, test_small_dense){
+    using namespace iceicle::linalg;
+
+    // a symmetric positive definite matrix A = B B^T + n I 
+    auto make_spd = [](std::size_t n, std::size_t seed){
+        std::vector<double> b(n * n), a(n * n, 0.0);
+        for(std::size_t i = 0; i < n * n; ++i) b[i] = std::sin(1.0 + i + 7.0 * seed);
+        for(std::size_t i = 0; i < n; ++i){
+            for(std::size_t j = 0; j < n; ++j){
+                for(std::size_t k = 0; k < n; ++k) a[i * n + j] += b[i * n + k] * b[j * n + k];
+            }
+            a[i * n + i] += n;
+        }
+        return a;
+    };
+
+    // check A * Ainv = I
+    auto check_inverse = [](std::size_t n, const double* a, const double* ainv){
+        for(std::size_t i = 0; i < n; ++i){
+            for(std::size_t j = 0; j < n; ++j){
+                double sum = 0.0;
+                for(std::size_t k = 0; k < n; ++k) sum += a[i * n + k] * ainv[k * n + j];
+                ASSERT_NEAR(sum, (i == j) ? 1.0 : 0.0, 1e-10);
+            }
+        }
+    };
+
+    // fixed size determinant and inverse
+    std::array<double, 4> a2{2.0, 1.0, 1.0, 3.0}, a2inv;
+    ASSERT_DOUBLE_EQ(inv<2>(a2.data(), a2inv.data()), 5.0);
+    check_inverse(2, a2.data(), a2inv.data());
+    std::array<double, 9> a3{2.0, 0.5, 1.0, -1.0, 3.0, 0.0, 0.25, 1.0, 4.0}, a3inv;
+    ASSERT_DOUBLE_EQ(det<3>(a3.data()), 2.0 * 12.0 - 0.5 * (-4.0) + 1.0 * (-1.75));
+    inv<3>(a3.data(), a3inv.data());
+    check_inverse(3, a3.data(), a3inv.data());
+    std::array<double, 4> sing{1.0, 2.0, 2.0, 4.0};
+    ASSERT_EQ(inv<2>(sing.data(), a2inv.data()), 0.0);
+
+    for(std::size_t n : {1, 3, 6, 11}){
+        std::vector<double> a = make_spd(n, n);
+
+        // cholesky solve matches the system
+        std::vector<double> l = a, x(n);
+        ASSERT_TRUE(cholesky_factor(l.data(), n));
+        for(std::size_t i = 0; i < n; ++i) x[i] = 1.0 + i;
+        cholesky_solve(l.data(), x.data(), n);
+        for(std::size_t i = 0; i < n; ++i){
+            double sum = 0.0;
+            for(std::size_t k = 0; k < n; ++k) sum += a[i * n + k] * x[k];
+            ASSERT_NEAR(sum, 1.0 + i, 1e-10);
+        }
+
+        // compile time and runtime sizes agree
+        std::vector<double> ainv = a, ainv_static = a;
+        ASSERT_TRUE(cholesky_invert(ainv.data(), n));
+        dispatch_basis_size(n, [&](auto N){ cholesky_invert<decltype(N)::value>(ainv_static.data(), n); });
+        check_inverse(n, a.data(), ainv.data());
+        for(std::size_t i = 0; i < n * n; ++i) ASSERT_NEAR(ainv[i], ainv_static[i], 1e-12);
+
+        // lu on a nonsymmetric matrix that needs pivoting
+        std::vector<double> g = a;
+        for(std::size_t i = 0; i < n; ++i) g[i * n + i] = 0.0;
+        g[n - 1] += 1.0;
+        std::vector<double> ginv = g, work(n * n);
+        std::vector<pivot_index> piv(n);
+        ASSERT_TRUE(lu_invert(ginv.data(), piv.data(), work.data(), n));
+        check_inverse(n, g.data(), ginv.data());
+    }
+
+    // not positive definite
+    std::array<double, 4> indef{1.0, 2.0, 2.0, 1.0};
+    ASSERT_FALSE(cholesky_factor<2>(indef.data()));
+
+    // batched over same size blocks, the third block is singular
+    constexpr std::size_t n = 4, nblock = 5;
+    std::vector<double> blocks{}, rhs{};
+    for(std::size_t ib = 0; ib < nblock; ++ib){
+        std::vector<double> a = make_spd(n, ib);
+        if(ib == 2) std::fill(a.begin(), a.end(), 1.0);
+        blocks.insert(blocks.end(), a.begin(), a.end());
+        for(std::size_t i = 0; i < n; ++i) rhs.push_back(1.0);
+    }
+    std::vector<double> chol_blocks = blocks, lu_blocks = blocks, solve_blocks = blocks, x = rhs;
+    std::atomic<int> nfail = 0;
+    auto on_fail = [&](std::size_t ib){ ASSERT_EQ(ib, 2); ++nfail; };
+    batched_cholesky_invert<n>(nblock, chol_blocks.data(), on_fail);
+    batched_lu_invert(nblock, lu_blocks.data(), on_fail, n);
+    batched_lu_solve<n>(nblock, solve_blocks.data(), x.data(), on_fail);
+    ASSERT_EQ(nfail, 3);
+    for(std::size_t ib = 0; ib < nblock; ++ib){
+        if(ib == 2) continue;
+        const double* a = blocks.data() + ib * n * n;
+        check_inverse(n, a, chol_blocks.data() + ib * n * n);
+        check_inverse(n, a, lu_blocks.data() + ib * n * n);
+        for(std::size_t i = 0; i < n; ++i){
+            double xi = 0.0;
+            for(std::size_t k = 0; k < n; ++k) xi += lu_blocks[ib * n * n + i * n + k];
+            ASSERT_NEAR(x[ib * n + i], xi, 1e-10);
+        }
+    }
+
+    // batched 3x3 inverse
+    std::vector<double> jac{}, jacinv(9 * nblock), dets(nblock);
+    for(std::size_t ib = 0; ib < nblock; ++ib){
+        for(double v : a3) jac.push_back(v * (1.0 + ib));
+    }
+    batched_inv<3>(nblock, jac.data(), jacinv.data(), dets.data());
+    for(std::size_t ib = 0; ib < nblock; ++ib){
+        ASSERT_NEAR(dets[ib], det<3>(a3.data()) * std::pow(1.0 + ib, 3), 1e-10);
+        check_inverse(3, jac.data() + 9 * ib, jacinv.data() + 9 * ib);
+    }
+}
+
+TEST(test_util, test_reproducible_sum){
+    // exact sums
+    {
+        ReproducibleSum<double> sum{};
+        sum += 1e300;
+        sum += 1.0;
+        sum -= 1e300;
+        ASSERT_EQ(sum.value(), 1.0);
+
+        ReproducibleSum<double> small{};
+        small += 0.1;
+        small += 0.2;
+        small -= 0.3;
+        ASSERT_EQ(small.value(), std::ldexp(1.0, -55)); // the exact sum of the three doubles
+
+        ReproducibleSum<double> neg{};
+        neg += -2.5;
+        neg += std::numeric_limits<double>::denorm_min();
+        ASSERT_EQ(neg.value(), -2.5);
+
+        ReproducibleSum<float> fsum{};
+        fsum += 3.0f;
+        fsum += 1e-3f;
+        fsum -= 3.0f;
+        ASSERT_EQ(fsum.value(), 1e-3f);
+    }
+
+    // the sum does not depend on the order or the grouping of partial sums
+    {
+        std::mt19937 engine{7};
+        std::uniform_real_distribution<double> dist{-1.0, 1.0};
+        std::vector<double> values(10000);
+        for(double& v : values) v = dist(engine) * std::pow(10.0, std::round(12.0 * dist(engine)));
+
+        ReproducibleSum<double> sum_in_order{};
+        for(double v : values) sum_in_order += v;
+
+        std::shuffle(values.begin(), values.end(), engine);
+        std::array<ReproducibleSum<double>, 7> partial{};
+        for(std::size_t i = 0; i < values.size(); ++i) partial[i % partial.size()] += values[i];
+        ReproducibleSum<double> sum_grouped{};
+        for(const auto& p : partial) sum_grouped += p;
+
+        ASSERT_EQ(sum_in_order.value(), sum_grouped.value());
+
+        // close to a compensated sum in sorted order
+        std::ranges::sort(values, {}, [](double v){ return std::abs(v); });
+        long double ref = 0;
+        for(double v : values) ref += v;
+        ASSERT_NEAR(sum_in_order.value(), (double) ref, 1e-12 * std::abs((double) ref));
+    }
+
+    // special values propagate like floating point sums
+    {
+        ReproducibleSum<double> pinf{};
+        pinf += 1.0;
+        pinf += std::numeric_limits<double>::infinity();
+        ASSERT_EQ(pinf.value(), std::numeric_limits<double>::infinity());
+        pinf += -std::numeric_limits<double>::infinity();
+        ASSERT_TRUE(std::isnan(pinf.value()));
+
+        ReproducibleSum<double> nan{};
+        nan += std::numeric_limits<double>::quiet_NaN();
+        ASSERT_TRUE(std::isnan(nan.value()));
+        nan.reset();
+        ASSERT_EQ(nan.value(), 0.0);
+    }
+}
+
+TEST(test_util, test_lossy_compression){
+    // decaying modal coefficients of a few elements and some values that must be stored exactly
+    std::vector<double> values{};
+    for(int iel = 0; iel < 4; ++iel){
+        for(int imode = 0; imode < 27; ++imode) values.push_back((iel + 1) * std::pow(0.1, imode) * ((imode % 2) ? -1.0 : 1.0));
+    }
+    values.push_back(1e300);
+    values.push_back(std::numeric_limits<double>::infinity());
+    values.push_back(-3.0e-9);
+
+    for(double eb : {1e-3, 1e-6, 1e-12}){
+        std::vector<std::uint8_t> bytes{};
+        lossy_compress(std::span<const double>{values}, eb, bytes);
+        ASSERT_LT(bytes.size(), values.size() * sizeof(double) / 2);
+
+        std::vector<double> decoded(values.size());
+        const std::uint8_t* ptr = bytes.data();
+        lossy_decompress(ptr, std::span<double>{decoded}, eb);
+        ASSERT_EQ(ptr, bytes.data() + bytes.size());
+        for(std::size_t i = 0; i < values.size(); ++i){
+            if(std::isfinite(values[i])) ASSERT_LE(std::abs(decoded[i] - values[i]), eb);
+            else ASSERT_EQ(decoded[i], values[i]);
+        }
+        ASSERT_EQ(decoded[values.size() - 3], 1e300);
+    }
+
+    // a non-positive bound is lossless and consecutive compressed ranges decode in sequence
+    std::vector<std::uint8_t> bytes{};
+    lossy_compress(std::span<const double>{values}, 0.0, bytes);
+    std::vector<float> fvalues{1.5f, 0.0f, 0.0f, -2.25f};
+    lossy_compress(std::span<const float>{fvalues}, 0.01f, bytes);
+    std::vector<double> decoded(values.size());
+    std::vector<float> fdecoded(fvalues.size());
+    const std::uint8_t* ptr = bytes.data();
+    lossy_decompress(ptr, std::span<double>{decoded}, 0.0);
+    lossy_decompress(ptr, std::span<float>{fdecoded}, 0.01f);
+    ASSERT_EQ(ptr, bytes.data() + bytes.size());
+    ASSERT_EQ(decoded, values);
+    for(std::size_t i = 0; i < fvalues.size(); ++i) ASSERT_LE(std::abs(fdecoded[i] - fvalues[i]), 0.01f);
+}
+
+TEST(test_util, test_output_scheduler){
+    // the steps that output (and checkpoint) for dt = 0.125 and 5 seconds per step
+    auto run = [](OutputScheduler<double, int>& schedule, int nstep){
+        std::vector<int> outputs{}, checkpoints{}, walltime{};
+        for(int itime = 0; itime < nstep; ++itime){
+            output_event event = schedule.poll(itime, 0.125 * itime, 5.0 * itime);
+            if(event.output) outputs.push_back(itime);
+            if(event.checkpoint) checkpoints.push_back(itime);
+            if(event.walltime) walltime.push_back(itime);
+        }
+        return std::array{outputs, checkpoints, walltime};
+    };
+
+    {  // steps
+        OutputScheduler<double, int> schedule{};
+        schedule.every = 5;
+        auto [outputs, checkpoints, walltime] = run(schedule, 12);
+        ASSERT_EQ(outputs, (std::vector<int>{0, 5, 10}));
+        ASSERT_TRUE(checkpoints.empty());
+        ASSERT_EQ(schedule.outputs(), 3);
+    }
+
+    {  // simulation time: the first step at or past each multiple of the interval
+        OutputScheduler<double, int> schedule{};
+        schedule.time_interval = 0.3;
+        auto [outputs, checkpoints, walltime] = run(schedule, 9);
+        ASSERT_EQ(outputs, (std::vector<int>{0, 3, 5, 8}));
+    }
+
+    {  // triggers within min_separation coalesce and every other output checkpoints
+        OutputScheduler<double, int> schedule{};
+        schedule.every = 1;
+        schedule.time_interval = 0.25;
+        schedule.min_separation = 3;
+        schedule.checkpoint_every = 2;
+        auto [outputs, checkpoints, walltime] = run(schedule, 10);
+        ASSERT_EQ(outputs, (std::vector<int>{0, 3, 6, 9}));
+        ASSERT_EQ(checkpoints, (std::vector<int>{3, 9}));
+    }
+
+    {  // wall clock
+        OutputScheduler<double, int> schedule{};
+        schedule.wall_interval = 30.0;
+        auto [outputs, checkpoints, walltime] = run(schedule, 13);
+        ASSERT_EQ(outputs, (std::vector<int>{6, 12}));
+    }
+
+    {  // one forced checkpoint before the walltime: 5 * itime + 10 + 2 * 5 >= 100
+        OutputScheduler<double, int> schedule{};
+        schedule.every = 1;
+        schedule.min_separation = 100;
+        schedule.walltime = 100.0;
+        schedule.walltime_margin = 10.0;
+        auto [outputs, checkpoints, walltime] = run(schedule, 20);
+        ASSERT_EQ(outputs, (std::vector<int>{0, 16}));
+        ASSERT_EQ(checkpoints, (std::vector<int>{16}));
+        ASSERT_EQ(walltime, (std::vector<int>{16}));
+    }
+}
+
+TEST(test_util, test_shared_memory_ring){
+    std::string name = "/iceicle_test_ring_" + std::to_string(::getpid());
+    std::optional<shared_memory_ring> writer = shared_memory_ring::create(name, 64, 2);
+    ASSERT_TRUE(writer.has_value());
+    std::optional<shared_memory_ring> reader = shared_memory_ring::attach(name);
+    ASSERT_TRUE(reader.has_value());
+    ASSERT_EQ(reader->slot_bytes(), 64);
+
+    std::vector<std::byte> frame;
+    ASSERT_FALSE(reader->read_latest(frame).has_value());
+
+    auto make_frame = [](int iframe, std::size_t nbytes){
+        std::vector<std::byte> bytes(nbytes);
+        for(std::size_t i = 0; i < nbytes; ++i) bytes[i] = static_cast<std::byte>(iframe + i);
+        return bytes;
+    };
+
+    // only the latest frame is read and each frame is read once
+    for(int iframe = 0; iframe < 5; ++iframe)
+        ASSERT_TRUE(writer->publish(make_frame(iframe, 10 + iframe)));
+    std::optional<std::uint64_t> iread = reader->read_latest(frame);
+    ASSERT_TRUE(iread.has_value());
+    ASSERT_EQ(iread.value(), 4);
+    ASSERT_EQ(frame, make_frame(4, 14));
+    ASSERT_FALSE(reader->read_latest(frame).has_value());
+
+    // frames larger than a slot are rejected
+    ASSERT_FALSE(writer->publish(make_frame(0, 65)));
+
+    // readers may not publish
+    ASSERT_FALSE(reader->publish(make_frame(0, 4)));
+
+    // concurrent reads see complete frames
+    std::atomic<bool> done = false;
+    std::thread write_thread{[&]{
+        for(int iframe = 0; iframe < 2000; ++iframe)
+            { writer->publish(make_frame(writer->nframe(), 64)); }
+        done = true;
+    }};
+    int nmismatch = 0;
+    while(!done){
+        if(std::optional<std::uint64_t> i = reader->read_latest(frame)) {
+            if(frame != make_frame(i.value(), 64)) ++nmismatch;
+        }
+    }
+    write_thread.join();
+    ASSERT_EQ(nmismatch, 0);
+
+    // closing the writer is visible to the reader
+    writer.reset();
+    ASSERT_TRUE(reader->closed());
+    ASSERT_FALSE(shared_memory_ring::attach(name).has_value());
+}
+
+namespace {
+    side_task<int> wait_for_flag(const bool& flag, int value, std::vector<int>& order){
+        co_await ready_when{[&flag]{ return flag; }};
+        order.push_back(value);
+        co_return value;
+    }
+
+    side_task<int> sum_of_tasks(side_task<int>& a, side_task<int>& b){
+        int sum = co_await a;
+        sum += co_await b;
+        co_return sum;
+    }
+
+    side_task<> throws_after_yield(){
+        co_await yield_step();
+        throw std::runtime_error{"side task error"};
+    }
+}
+
+TEST(test_util, test_coroutine_executor){
+    coroutine_executor executor{};
+    std::vector<int> order{};
+
+    // tasks run until they wait and resume once ready in any order
+    bool flag1 = false, flag2 = false;
+    side_task<int> t1 = wait_for_flag(flag1, 1, order);
+    side_task<int> t2 = wait_for_flag(flag2, 2, order);
+    ASSERT_FALSE(t1.started());
+    executor.spawn(t1);
+    executor.spawn(t2);
+    ASSERT_EQ(executor.npending(), 2);
+    ASSERT_EQ(executor.poll(), 2);
+    flag2 = true;
+    ASSERT_EQ(executor.poll(), 1);
+    ASSERT_TRUE(t2.done());
+    ASSERT_FALSE(t1.done());
+    flag1 = true;
+    ASSERT_EQ(executor.wait(t1), 1);
+    ASSERT_EQ(order, (std::vector<int>{2, 1}));
+
+    // a task that is ready does not suspend
+    side_task<int> t3 = wait_for_flag(flag1, 3, order);
+    executor.spawn(t3);
+    ASSERT_TRUE(t3.done());
+    ASSERT_EQ(t3.get(), 3);
+
+    // awaiting tasks from a task starts them on the same executor
+    bool flag4 = false;
+    side_task<int> t4 = wait_for_flag(flag4, 4, order);
+    side_task<int> t5 = wait_for_flag(flag1, 5, order);
+    side_task<int> sum = sum_of_tasks(t4, t5);
+    executor.spawn(sum);
+    ASSERT_TRUE(t4.started());
+    ASSERT_FALSE(t5.started());
+    flag4 = true;
+    ASSERT_EQ(executor.wait(sum), 9);
+
+    // waiting on an asynchronous result
+    std::promise<double> promise{};
+    std::future<double> future = promise.get_future();
+    auto await_future = [](std::future<double>& future) -> side_task<double> {
+        co_await future_ready(future);
+        co_return future.get();
+    };
+    side_task<double> t6 = await_future(future);
+    executor.spawn(t6);
+    executor.poll();
+    ASSERT_FALSE(t6.done());
+    std::thread writer{[&promise]{ promise.set_value(2.5); }};
+    ASSERT_EQ(executor.wait(t6), 2.5);
+    writer.join();
+
+    // exceptions are rethrown when the result is read
+    side_task<> t7 = throws_after_yield();
+    executor.spawn(t7);
+    ASSERT_THROW(executor.wait(t7), std::runtime_error);
+
+    // destroying a parked task drops it from the executor
+    {
+        bool never = false;
+        side_task<int> t8 = wait_for_flag(never, 8, order);
+        executor.spawn(t8);
+        ASSERT_EQ(executor.npending(), 1);
+    }
+    ASSERT_EQ(executor.npending(), 0);
+    executor.wait_all();
+}